@@ -16,9 +16,13 @@
 #ifdef NVTX
 #include <nvtx3/nvToolsExt.h>
 #endif
+#include <fcntl.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
 #include <cstdint>
 #include <fstream>
@@ -26,11 +30,14 @@
 #include <limits>
 #include <memory>
 #include <numeric>
+#include <random>
 #include <string>
+#include <thread>
 #include <unordered_set>
 #include <vector>
 
 #include "benchmark_util.hpp"
+#include "build_phases.hpp"
 #include "conf.h"
 #include "dataset.h"
 #include "util.h"
@@ -109,7 +116,8 @@ inline bool mkdir(const std::vector<std::string>& dirs)
 
 inline bool check(const std::vector<Configuration::Index>& indices,
                   bool build_mode,
-                  bool force_overwrite)
+                  bool force_overwrite,
+                  bool load_mode = false)
 {
   std::vector<std::string> files_should_exist;
   std::vector<std::string> dirs_should_exist;
@@ -118,9 +126,18 @@ inline bool check(const std::vector<Configuration::Index>& indices,
     if (build_mode) {
       output_files.push_back(index.file);
       output_files.push_back(index.file + ".txt");
+      output_files.push_back(index.file + ".build.json");
 
       auto pos = index.file.rfind('/');
       if (pos != std::string::npos) { dirs_should_exist.push_back(index.file.substr(0, pos)); }
+    } else if (load_mode) {
+      files_should_exist.push_back(index.file);
+      output_files.push_back(index.search_result_file + ".load.json");
+
+      auto pos = index.search_result_file.rfind('/');
+      if (pos != std::string::npos) {
+        dirs_should_exist.push_back(index.search_result_file.substr(0, pos));
+      }
     } else {
       files_should_exist.push_back(index.file);
       files_should_exist.push_back(index.file + ".txt");
@@ -169,6 +186,7 @@ void build(const Dataset<T>* dataset, const std::vector<Configuration::Index>& i
 {
   cudaStream_t stream;
   RAFT_CUDA_TRY(cudaStreamCreate(&stream));
+  phase_memory_tracker memory_tracker;
 
   log_info(
     "base set from dataset '%s', #vector = %zu", dataset->name().c_str(), dataset->base_set_size());
@@ -197,6 +215,10 @@ void build(const Dataset<T>* dataset, const std::vector<Configuration::Index>& i
 
     log_info("building index '%s'", index.name.c_str());
     RAFT_CUDA_TRY(cudaStreamSynchronize(stream));
+    // the phases of the library are recorded only during the build
+    memory_tracker.reset();
+    raft::metrics::reset();
+    raft::metrics::set_enabled(true);
 #ifdef NVTX
     nvtxRangePush("build");
 #endif
@@ -207,9 +229,16 @@ void build(const Dataset<T>* dataset, const std::vector<Configuration::Index>& i
 #ifdef NVTX
     nvtxRangePop();
 #endif
+    raft::metrics::set_enabled(false);
     log_info("built index in %.2f seconds", elapsed_ms / 1000.0f);
     RAFT_CUDA_TRY(cudaDeviceSynchronize());
     RAFT_CUDA_TRY(cudaPeekAtLastError());
+    write_build_phases(index.file + ".build.json",
+                       index.name,
+                       index.algo,
+                       elapsed_ms / 1000.0f,
+                       raft::metrics::snapshot(),
+                       memory_tracker.peaks());
 
     algo->save(index.file);
     write_build_info(index.file,
@@ -270,8 +299,234 @@ inline void write_search_result(const std::string& file_prefix,
   neighbors_file.write(neighbors, query_set_size, k);
 }
 
+/** The result of a run with concurrent clients. */
+struct concurrent_run_result {
+  // the time from the arrival of the first batch to the completion of the last one, in seconds
+  float wall_time;
+  // latency of each full batch in seconds: from its arrival to its completion
+  std::vector<float> latencies;
+};
+
+/**
+ * Search the query set once, with the batches shared by the concurrent clients.
+ *
+ * Each client runs in its own thread with its own stream and its own instance of the algo (hence
+ * its own handle). The batches are taken in order from a shared counter. In the open loop mode
+ * (`arrival_rate > 0`), the batches arrive as a Poisson process regardless of the progress of the
+ * clients, and the latency of a batch includes its waiting for a free client; in the closed loop
+ * mode, a batch arrives when a client takes it.
+ */
+template <typename T>
+concurrent_run_result search_concurrent(const std::vector<ANN<T>*>& clients,
+                                        const T* queries,
+                                        size_t query_set_size,
+                                        int dim,
+                                        int batch_size,
+                                        int k,
+                                        std::size_t* neighbors,
+                                        float* distances,
+                                        float arrival_rate,
+                                        uint64_t seed)
+{
+  using clock              = std::chrono::steady_clock;
+  const size_t num_batches = (query_set_size - 1) / batch_size + 1;
+
+  std::vector<double> arrival_offsets(num_batches, 0.0);
+  if (arrival_rate > 0.0f) {
+    std::mt19937_64 gen(seed);
+    std::exponential_distribution<double> inter_arrival(arrival_rate);
+    for (size_t i = 1; i < num_batches; i++) {
+      arrival_offsets[i] = arrival_offsets[i - 1] + inter_arrival(gen);
+    }
+  }
+
+  int device;
+  RAFT_CUDA_TRY(cudaGetDevice(&device));
+  std::atomic<size_t> next_batch{0};
+  std::vector<std::vector<float>> latencies(clients.size());
+  std::vector<clock::time_point> finish_times(clients.size());
+  const auto start = clock::now();
+
+  auto client_loop = [&](size_t client_id) {
+    RAFT_CUDA_TRY(cudaSetDevice(device));
+    cudaStream_t stream;
+    RAFT_CUDA_TRY(cudaStreamCreate(&stream));
+    auto* algo = clients[client_id];
+    while (true) {
+      const size_t batch_id = next_batch.fetch_add(1);
+      if (batch_id >= num_batches) { break; }
+      std::size_t row       = batch_id * batch_size;
+      int actual_batch_size = (batch_id == num_batches - 1) ? query_set_size - row : batch_size;
+      auto arrival          = clock::now();
+      if (arrival_rate > 0.0f) {
+        arrival = start + std::chrono::duration_cast<clock::duration>(
+                            std::chrono::duration<double>(arrival_offsets[batch_id]));
+        std::this_thread::sleep_until(arrival);
+      }
+      algo->search(queries + row * dim,
+                   actual_batch_size,
+                   k,
+                   neighbors + row * k,
+                   distances + row * k,
+                   stream);
+      RAFT_CUDA_TRY(cudaStreamSynchronize(stream));
+      // As in the sequential mode, the last partial batch is not counted for the latency.
+      if (actual_batch_size == batch_size) {
+        latencies[client_id].push_back(
+          std::chrono::duration<float>(clock::now() - arrival).count());
+      }
+    }
+    finish_times[client_id] = clock::now();
+    RAFT_CUDA_TRY(cudaStreamDestroy(stream));
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < clients.size(); i++) {
+    threads.emplace_back(client_loop, i);
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  concurrent_run_result result;
+  result.wall_time =
+    std::chrono::duration<float>(*std::max_element(finish_times.begin(), finish_times.end()) -
+                                 start)
+      .count();
+  for (const auto& l : latencies) {
+    result.latencies.insert(result.latencies.end(), l.begin(), l.end());
+  }
+  return result;
+}
+
+/**
+ * Append the throughput and the latency distribution of a run with concurrent clients to the
+ * search result file.
+ *
+ * The histogram buckets are powers of two in microseconds, i.e. [2^(i-1), 2^i) us.
+ */
+inline void write_concurrent_result(const std::string& file_prefix,
+                                    int num_threads,
+                                    float arrival_rate,
+                                    float latency_slo,
+                                    size_t query_set_size,
+                                    const concurrent_run_result& run)
+{
+  std::vector<float> latencies = run.latencies;
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&latencies](double p) {
+    if (latencies.empty()) { return 0.0f; }
+    auto pos = static_cast<size_t>(std::ceil(p / 100.0 * latencies.size()));
+    return latencies[std::max<size_t>(pos, 1) - 1];
+  };
+
+  std::ofstream ofs(file_prefix + ".txt", std::ios::app);
+  if (!ofs) { throw std::runtime_error("can't open search result file: " + file_prefix + ".txt"); }
+  ofs << "\n"
+      << "num_threads: " << num_threads << "\n"
+      << "arrival_rate: " << arrival_rate << "\n"
+      << "qps: " << query_set_size / run.wall_time << "\n"
+      << "p50_latency: " << percentile(50) << "\n"
+      << "p90_latency: " << percentile(90) << "\n"
+      << "p99_latency: " << percentile(99) << "\n"
+      << "p999_latency: " << percentile(99.9) << "\n";
+  if (latency_slo > 0.0f) {
+    auto slo_end = std::upper_bound(latencies.begin(), latencies.end(), latency_slo / 1000.0f);
+    auto within  = slo_end - latencies.begin();
+    ofs << "latency_slo: " << latency_slo << "\n"
+        << "within_slo: " << (latencies.empty() ? 0.0 : double(within) / latencies.size()) << "\n";
+  }
+
+  std::vector<size_t> histogram;
+  for (float latency : latencies) {
+    auto us     = static_cast<uint64_t>(latency * 1e6f);
+    size_t slot = 0;
+    while (us > 0) {
+      us >>= 1;
+      slot++;
+    }
+    if (histogram.size() <= slot) { histogram.resize(slot + 1, 0); }
+    histogram[slot]++;
+  }
+  ofs << "latency_histogram_us:\n";
+  for (size_t i = 0; i < histogram.size(); i++) {
+    if (histogram[i] == 0) { continue; }
+    ofs << "  [" << (i == 0 ? 0 : uint64_t{1} << (i - 1)) << ", " << (uint64_t{1} << i)
+        << "): " << histogram[i] << "\n";
+  }
+  ofs.close();
+  if (!ofs) {
+    throw std::runtime_error("can't write to search result file: " + file_prefix + ".txt");
+  }
+}
+
+/** Recall of the first `k` neighbors of each query against the ground truth. */
+inline float calc_recall(const int* neighbors,
+                         const std::vector<int>& groundtruth,
+                         int groundtruth_dim,
+                         size_t query_set_size,
+                         int k)
+{
+  size_t num_matches = 0;
+  std::vector<int> truth(k);
+  for (size_t i = 0; i < query_set_size; i++) {
+    std::copy_n(groundtruth.begin() + i * groundtruth_dim, k, truth.begin());
+    std::sort(truth.begin(), truth.end());
+    for (int j = 0; j < k; j++) {
+      if (std::binary_search(truth.begin(), truth.end(), neighbors[i * k + j])) { num_matches++; }
+    }
+  }
+  return static_cast<float>(num_matches) / (query_set_size * k);
+}
+
+/** A point of a search param sweep. */
+struct sweep_point {
+  std::string search_param;
+  float recall;
+  float qps;
+  float search_time_average;
+  float search_time_p99;
+};
+
+/**
+ * Write the points of a sweep as CSV, with those on the recall-vs-QPS Pareto frontier marked.
+ *
+ * A point is on the frontier if no other point has both higher (or equal) recall and QPS.
+ */
+inline void write_sweep_result(const std::string& file, const std::vector<sweep_point>& points)
+{
+  std::ofstream ofs(file);
+  if (!ofs) { throw std::runtime_error("can't open sweep result file: " + file); }
+  ofs << "search_param,recall,qps,avg_latency(ms),p99_latency(ms),pareto\n";
+  for (const auto& p : points) {
+    bool dominated = std::any_of(points.begin(), points.end(), [&p](const sweep_point& q) {
+      return q.recall >= p.recall && q.qps >= p.qps && (q.recall > p.recall || q.qps > p.qps);
+    });
+    // CSV escapes the quotes of the JSON by doubling them
+    std::string param;
+    for (char c : p.search_param) {
+      param += c;
+      if (c == '"') { param += c; }
+    }
+    ofs << '"' << param << "\"," << p.recall << "," << p.qps << "," << p.search_time_average * 1000
+        << ",";
+    if (p.search_time_p99 != std::numeric_limits<float>::max()) {
+      ofs << p.search_time_p99 * 1000;
+    }
+    ofs << "," << (dominated ? 0 : 1) << "\n";
+    if (!dominated) {
+      log_info(
+        "pareto: recall = %f, qps = %f, param = %s", p.recall, p.qps, p.search_param.c_str());
+    }
+  }
+  ofs.close();
+  if (!ofs) { throw std::runtime_error("can't write to sweep result file: " + file); }
+}
+
 template <typename T>
-inline void search(const Dataset<T>* dataset, const std::vector<Configuration::Index>& indices)
+inline void search(const Dataset<T>* dataset,
+                   const std::vector<Configuration::Index>& indices,
+                   const std::string& groundtruth_neighbors_file)
 {
   if (indices.empty()) { return; }
   cudaStream_t stream;
@@ -308,6 +563,20 @@ inline void search(const Dataset<T>* dataset, const std::vector<Configuration::I
   RAFT_CUDA_TRY(cudaMalloc((void**)&d_neighbors, query_set_size * k * sizeof(*d_neighbors)));
   RAFT_CUDA_TRY(cudaMalloc((void**)&d_distances, query_set_size * k * sizeof(*d_distances)));
 
+  std::vector<int> groundtruth;
+  int groundtruth_dim = 0;
+  if (!groundtruth_neighbors_file.empty()) {
+    BinFile<int> groundtruth_file(groundtruth_neighbors_file, "r");
+    size_t groundtruth_rows;
+    groundtruth_file.get_shape(&groundtruth_rows, &groundtruth_dim);
+    if (groundtruth_rows < query_set_size || groundtruth_dim < k) {
+      throw std::runtime_error("groundtruth '" + groundtruth_neighbors_file +
+                               "' doesn't cover the query set and k");
+    }
+    groundtruth.resize(groundtruth_rows * groundtruth_dim);
+    groundtruth_file.read(groundtruth.data());
+  }
+
   for (const auto& index : indices) {
     log_info("creating algo '%s', param=%s", index.algo.c_str(), index.build_param.dump().c_str());
     auto algo          = create_algo<T>(index.algo,
@@ -330,11 +599,11 @@ inline void search(const Dataset<T>* dataset, const std::vector<Configuration::I
       this_distances = d_distances;
     }
 
+    const T* base_set_ptr = nullptr;
     if (algo_property.need_dataset_when_search) {
       log_info("loading base set from dataset '%s', #vector = %zu",
                dataset->name().c_str(),
                dataset->base_set_size());
-      const T* base_set_ptr = nullptr;
       if (algo_property.dataset_memory_type == MemoryType::Host) {
         log_info("%s", "loading base set to memory");
         base_set_ptr = dataset->base_set();
@@ -348,9 +617,36 @@ inline void search(const Dataset<T>* dataset, const std::vector<Configuration::I
       algo->set_search_dataset(base_set_ptr, dataset->base_set_size());
     }
 
+    // The concurrent clients have their own instances of the algo, because the algos are not
+    // thread-safe.
+    const bool concurrent = index.num_threads > 1 || index.arrival_rate > 0.0f;
+    std::vector<std::unique_ptr<ANN<T>>> extra_clients;
+    std::vector<ANN<T>*> clients{algo.get()};
+    if (concurrent) {
+      log_info("creating %d concurrent clients, arrival rate = %f batches/s",
+               index.num_threads,
+               index.arrival_rate);
+      for (int c = 1; c < index.num_threads; c++) {
+        extra_clients.push_back(create_algo<T>(index.algo,
+                                               dataset->distance(),
+                                               dataset->dim(),
+                                               index.refine_ratio,
+                                               index.build_param,
+                                               index.dev_list));
+        extra_clients.back()->load(index.file);
+        if (algo_property.need_dataset_when_search) {
+          extra_clients.back()->set_search_dataset(base_set_ptr, dataset->base_set_size());
+        }
+        clients.push_back(extra_clients.back().get());
+      }
+    }
+
+    std::vector<sweep_point> sweep;
     for (int i = 0, end_i = index.search_params.size(); i != end_i; ++i) {
       auto p_param = create_search_param<T>(index.algo, index.search_params[i]);
-      algo->set_search_param(*p_param);
+      for (auto* client : clients) {
+        client->set_search_param(*p_param);
+      }
       log_info("search with param: %s", index.search_params[i].dump().c_str());
 
       if (algo_property.query_memory_type == MemoryType::Device) {
@@ -364,7 +660,40 @@ inline void search(const Dataset<T>* dataset, const std::vector<Configuration::I
       float best_search_time_average = std::numeric_limits<float>::max();
       float best_search_time_p99     = std::numeric_limits<float>::max();
       float best_search_time_p999    = std::numeric_limits<float>::max();
-      for (int run = 0; run < run_count; ++run) {
+      concurrent_run_result best_concurrent_run{std::numeric_limits<float>::max(), {}};
+      for (int run = 0; run < run_count && concurrent; ++run) {
+        log_info("run %d / %d", run + 1, run_count);
+        auto run_result = search_concurrent<T>(clients,
+                                               this_query_set,
+                                               query_set_size,
+                                               dataset->dim(),
+                                               batch_size,
+                                               k,
+                                               this_neighbors,
+                                               this_distances,
+                                               index.arrival_rate,
+                                               run);
+        if (run_result.wall_time < best_concurrent_run.wall_time) {
+          best_concurrent_run = std::move(run_result);
+        }
+      }
+      if (concurrent) {
+        // Report the latency of the best run in the same fields as the sequential mode.
+        search_times = best_concurrent_run.latencies;
+        std::sort(search_times.begin(), search_times.end());
+        if (!search_times.empty()) {
+          best_search_time_average =
+            std::accumulate(search_times.cbegin(), search_times.cend(), 0.0f) / search_times.size();
+        }
+        if (search_times.size() >= 100) {
+          best_search_time_p99 = search_times[size_t(std::ceil(0.99 * search_times.size())) - 1];
+        }
+        if (search_times.size() >= 1000) {
+          best_search_time_p999 = search_times[size_t(std::ceil(0.999 * search_times.size())) - 1];
+        }
+        search_times.clear();
+      }
+      for (int run = 0; run < run_count && !concurrent; ++run) {
         log_info("run %d / %d", run + 1, run_count);
         for (std::size_t batch_id = 0; batch_id < num_batches; ++batch_id) {
           std::size_t row       = batch_id * batch_size;
@@ -454,7 +783,26 @@ inline void search(const Dataset<T>* dataset, const std::vector<Configuration::I
                           best_search_time_p999,
                           neighbors_buf,
                           query_set_size);
+      if (concurrent) {
+        write_concurrent_result(index.search_result_file + "." + to_string(i),
+                                index.num_threads,
+                                index.arrival_rate,
+                                index.latency_slo,
+                                query_set_size,
+                                best_concurrent_run);
+      }
+      if (!groundtruth.empty()) {
+        float qps    = concurrent ? query_set_size / best_concurrent_run.wall_time
+                                  : batch_size / best_search_time_average;
+        float recall = calc_recall(neighbors_buf, groundtruth, groundtruth_dim, query_set_size, k);
+        sweep.push_back({index.search_params[i].dump(),
+                         recall,
+                         qps,
+                         best_search_time_average,
+                         best_search_time_p99});
+      }
     }
+    if (!sweep.empty()) { write_sweep_result(index.search_result_file + ".sweep.csv", sweep); }
 
     log_info("finish searching for index '%s'", index.name.c_str());
   }
@@ -467,12 +815,166 @@ inline void search(const Dataset<T>* dataset, const std::vector<Configuration::I
   RAFT_CUDA_TRY(cudaStreamDestroy(stream));
 }
 
+/**
+ * Drop the (clean) pages of a file from the page cache, so that the next read comes from the
+ * storage.
+ */
+inline bool evict_from_page_cache(const std::string& file)
+{
+  int fd = open(file.c_str(), O_RDONLY);
+  if (fd < 0) { return false; }
+  bool evicted = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+  close(fd);
+  return evicted;
+}
+
+inline size_t file_size(const std::string& file)
+{
+  struct stat statbuf;
+  if (stat(file.c_str(), &statbuf) != 0) { throw std::runtime_error("stat() failed: " + file); }
+  return statbuf.st_size;
+}
+
+/**
+ * Measure how fast the indices are ready to serve after a restart.
+ *
+ * For each index:
+ *   - the cold load: `load()` right after the index file is evicted from the page cache;
+ *   - the time to the first query: the cold load and the search of the first batch (with the first
+ *     search param), which includes the lazy initialization of the algo;
+ *   - the time to steady state: from the beginning of the cold load until the QPS of a window of
+ *     batches is within 5% of the previous window, and that QPS;
+ *   - the warm load: `load()` of the file from the page cache, into a new instance of the algo.
+ *
+ * The results are written to `<search_result_file>.load.json`.
+ */
+template <typename T>
+inline void load(const Dataset<T>* dataset, const std::vector<Configuration::Index>& indices)
+{
+  if (indices.empty()) { return; }
+  constexpr int kWindow       = 10;
+  constexpr int kMaxBatches   = 1000;
+  constexpr double kSteadyTol = 0.05;
+
+  cudaStream_t stream;
+  RAFT_CUDA_TRY(cudaStreamCreate(&stream));
+  const int batch_size  = indices[0].batch_size;
+  const int k           = indices[0].k;
+  const size_t nbatches = std::max<size_t>(1, dataset->query_set_size() / batch_size);
+  std::vector<std::size_t> neighbors(size_t(batch_size) * k);
+  std::vector<float> distances(size_t(batch_size) * k);
+  std::size_t* d_neighbors;
+  float* d_distances;
+  RAFT_CUDA_TRY(cudaMalloc((void**)&d_neighbors, neighbors.size() * sizeof(*d_neighbors)));
+  RAFT_CUDA_TRY(cudaMalloc((void**)&d_distances, distances.size() * sizeof(*d_distances)));
+
+  for (const auto& index : indices) {
+    auto make_algo = [&]() {
+      return create_algo<T>(index.algo,
+                            dataset->distance(),
+                            dataset->dim(),
+                            index.refine_ratio,
+                            index.build_param,
+                            index.dev_list);
+    };
+    auto algo          = make_algo();
+    auto algo_property = algo->get_property();
+    const size_t bytes = file_size(index.file);
+    const bool evicted = evict_from_page_cache(index.file);
+    if (!evicted) { log_warn("could not evict '%s' from the page cache", index.file.c_str()); }
+
+    log_info("loading index '%s' from file '%s' (cold)", index.name.c_str(), index.file.c_str());
+    RAFT_CUDA_TRY(cudaDeviceSynchronize());
+    Timer total_timer;
+    algo->load(index.file);
+    RAFT_CUDA_TRY(cudaDeviceSynchronize());
+    float cold_load_ms = total_timer.elapsed_ms();
+
+    if (algo_property.need_dataset_when_search) {
+      const T* base_set_ptr = algo_property.dataset_memory_type == MemoryType::Device
+                                ? dataset->base_set_on_gpu()
+                                : dataset->mapped_base_set();
+      algo->set_search_dataset(base_set_ptr, dataset->base_set_size());
+    }
+    auto p_param = create_search_param<T>(index.algo, index.search_params[0]);
+    algo->set_search_param(*p_param);
+    const bool on_device    = algo_property.query_memory_type == MemoryType::Device;
+    const T* queries        = on_device ? dataset->query_set_on_gpu() : dataset->query_set();
+    std::size_t* neighbors_ = on_device ? d_neighbors : neighbors.data();
+    float* distances_       = on_device ? d_distances : distances.data();
+
+    float first_query_ms = 0;
+    float steady_ms      = 0;
+    double steady_qps    = 0;
+    double window_qps    = 0;
+    Timer window_timer;
+    for (int batch = 0; batch < kMaxBatches; batch++) {
+      const size_t row = (batch % nbatches) * batch_size;
+      algo->search(queries + row * dataset->dim(), batch_size, k, neighbors_, distances_, stream);
+      RAFT_CUDA_TRY(cudaStreamSynchronize(stream));
+      if (batch == 0) {
+        first_query_ms = total_timer.elapsed_ms();
+        window_timer.reset();
+        continue;
+      }
+      if (batch % kWindow != 0) { continue; }
+      double qps = kWindow * batch_size / (window_timer.elapsed_ms() / 1000.0);
+      window_timer.reset();
+      steady_ms  = total_timer.elapsed_ms();
+      steady_qps = qps;
+      if (window_qps > 0 && std::abs(qps - window_qps) <= kSteadyTol * window_qps) { break; }
+      window_qps = qps;
+    }
+
+    // A new instance reads the file again, now from the page cache.
+    algo.reset();
+    algo = make_algo();
+    RAFT_CUDA_TRY(cudaDeviceSynchronize());
+    Timer warm_timer;
+    algo->load(index.file);
+    RAFT_CUDA_TRY(cudaDeviceSynchronize());
+    float warm_load_ms = warm_timer.elapsed_ms();
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+    log_info("'%s': cold load %.3f s (%.1f MB/s), warm load %.3f s (%.1f MB/s)",
+             index.name.c_str(),
+             cold_load_ms / 1000.0f,
+             bytes / 1e3 / cold_load_ms,
+             warm_load_ms / 1000.0f,
+             bytes / 1e3 / warm_load_ms);
+    nlohmann::json out;
+    out["name"]                    = index.name;
+    out["algo"]                    = index.algo;
+    out["search_param"]            = index.search_params[0];
+    out["file_bytes"]              = bytes;
+    out["evicted_from_page_cache"] = evicted;
+    out["cold_load_time"]          = cold_load_ms / 1000.0;
+    out["cold_load_bytes_per_s"]   = bytes / (cold_load_ms / 1000.0);
+    out["warm_load_time"]          = warm_load_ms / 1000.0;
+    out["warm_load_bytes_per_s"]   = bytes / (warm_load_ms / 1000.0);
+    out["time_to_first_query"]     = first_query_ms / 1000.0;
+    out["time_to_steady_state"]    = steady_ms / 1000.0;
+    out["steady_state_qps"]        = steady_qps;
+    const std::string result_file  = index.search_result_file + ".load.json";
+    std::ofstream ofs(result_file);
+    if (!ofs) { throw std::runtime_error("can't open load result file: " + result_file); }
+    ofs << out.dump(2) << endl;
+    if (!ofs) { throw std::runtime_error("can't write to load result file: " + result_file); }
+  }
+
+  RAFT_CUDA_TRY(cudaFree(d_neighbors));
+  RAFT_CUDA_TRY(cudaFree(d_distances));
+  RAFT_CUDA_TRY(cudaStreamDestroy(stream));
+}
+
 inline const std::string usage(const string& argv0)
 {
-  return "usage: " + argv0 + " -b|s [-c] [-f] [-i index_names] conf.json\n" +
+  return "usage: " + argv0 + " -b|s|l [-c] [-f] [-i index_names] conf.json\n" +
          "   -b: build mode, will build index\n" +
          "   -s: search mode, will search using built index\n" +
-         "       one and only one of -b and -s should be specified\n" +
+         "   -l: load mode, will measure the cold/warm load time of built index,\n" +
+         "       and the time to the first query and to the steady state\n" +
+         "       one and only one of -b, -s and -l should be specified\n" +
          "   -c: just check command line options and conf.json are sensible\n" +
          "       won't build or search\n" + "   -f: force overwriting existing output files\n" +
          "   -i: by default will build/search all the indices found in conf.json\n" +
@@ -488,7 +990,8 @@ inline int dispatch_benchmark(Configuration& conf,
                               bool force_overwrite,
                               bool only_check,
                               bool build_mode,
-                              bool search_mode)
+                              bool search_mode,
+                              bool load_mode)
 {
   try {
     auto dataset_conf = conf.get_dataset_conf();
@@ -498,13 +1001,14 @@ inline int dispatch_benchmark(Configuration& conf,
                           dataset_conf.subset_first_row,
                           dataset_conf.subset_size,
                           dataset_conf.query_file,
-                          dataset_conf.distance);
+                          dataset_conf.distance,
+                          dataset_conf.host_register);
 
     vector<Configuration::Index> indices = conf.get_indices(index_patterns);
-    if (!check(indices, build_mode, force_overwrite)) { return -1; }
+    if (!check(indices, build_mode, force_overwrite, load_mode)) { return -1; }
 
     std::string message = "will ";
-    message += build_mode ? "build:" : "search:";
+    message += build_mode ? "build:" : (load_mode ? "load:" : "search:");
     for (const auto& index : indices) {
       message += "\n  " + index.name;
     }
@@ -518,7 +1022,9 @@ inline int dispatch_benchmark(Configuration& conf,
     if (build_mode) {
       build(&dataset, indices);
     } else if (search_mode) {
-      search(&dataset, indices);
+      search(&dataset, indices, dataset_conf.groundtruth_neighbors_file);
+    } else if (load_mode) {
+      load(&dataset, indices);
     }
   } catch (const std::exception& e) {
     log_error("exception occurred: %s", e.what());
@@ -533,14 +1039,16 @@ inline int run_main(int argc, char** argv)
   bool force_overwrite = false;
   bool build_mode      = false;
   bool search_mode     = false;
+  bool load_mode       = false;
   bool only_check      = false;
   std::string index_patterns("*");
 
   int opt;
-  while ((opt = getopt(argc, argv, "bscfi:h")) != -1) {
+  while ((opt = getopt(argc, argv, "bslcfi:h")) != -1) {
     switch (opt) {
       case 'b': build_mode = true; break;
       case 's': search_mode = true; break;
+      case 'l': load_mode = true; break;
       case 'c': only_check = true; break;
       case 'f': force_overwrite = true; break;
       case 'i': index_patterns = optarg; break;
@@ -548,8 +1056,9 @@ inline int run_main(int argc, char** argv)
       default: cerr << "\n" << usage(argv[0]) << endl; return -1;
     }
   }
-  if (build_mode == search_mode) {
-    std::cerr << "one and only one of -b and -s should be specified\n\n" << usage(argv[0]) << endl;
+  if (int(build_mode) + int(search_mode) + int(load_mode) != 1) {
+    std::cerr << "one and only one of -b, -s and -l should be specified\n\n"
+              << usage(argv[0]) << endl;
     return -1;
   }
   if (argc - optind != 1) {
@@ -570,13 +1079,13 @@ inline int run_main(int argc, char** argv)
 
     if (dtype == "float") {
       return dispatch_benchmark<float>(
-        conf, index_patterns, force_overwrite, only_check, build_mode, search_mode);
+        conf, index_patterns, force_overwrite, only_check, build_mode, search_mode, load_mode);
     } else if (dtype == "uint8") {
       return dispatch_benchmark<std::uint8_t>(
-        conf, index_patterns, force_overwrite, only_check, build_mode, search_mode);
+        conf, index_patterns, force_overwrite, only_check, build_mode, search_mode, load_mode);
     } else if (dtype == "int8") {
       return dispatch_benchmark<std::int8_t>(
-        conf, index_patterns, force_overwrite, only_check, build_mode, search_mode);
+        conf, index_patterns, force_overwrite, only_check, build_mode, search_mode, load_mode);
     } else {
       log_error("datatype %s not supported", dtype);
     }
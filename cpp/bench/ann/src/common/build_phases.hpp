@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/core/metrics.hpp>
+
+#include <rmm/mr/device/device_memory_resource.hpp>
+#include <rmm/mr/device/per_device_resource.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define JSON_DIAGNOSTICS 1
+#include <nlohmann/json.hpp>
+
+namespace raft::bench::ann {
+
+/**
+ * Tracks the peak memory usage within each phase the library marks with `raft::metrics::phase`
+ * (e.g. `ivf_pq::build::kmeans`). It installs itself as the current device memory resource for its
+ * lifetime, so it must outlive the allocations made through it.
+ *
+ * The device usage counts the allocations through the current device memory resource (for a pool,
+ * its reservations). The host usage is the resident set size: the kernel's high-water mark is reset
+ * at the phase boundaries (/proc/self/clear_refs); where that is not permitted, it is the peak of
+ * the process so far.
+ * The peak of a phase includes its nested phases; a phase run several times reports the maximum.
+ */
+class phase_memory_tracker final : public rmm::mr::device_memory_resource {
+ public:
+  struct peak {
+    size_t device_bytes = 0;
+    size_t host_bytes   = 0;
+  };
+
+  phase_memory_tracker() : upstream_(rmm::mr::get_current_device_resource())
+  {
+    rmm::mr::set_current_device_resource(this);
+    instance() = this;
+    raft::metrics::set_phase_callback(&phase_memory_tracker::on_phase);
+  }
+  ~phase_memory_tracker() override
+  {
+    raft::metrics::set_phase_callback(nullptr);
+    instance() = nullptr;
+    rmm::mr::set_current_device_resource(upstream_);
+  }
+  phase_memory_tracker(const phase_memory_tracker&)            = delete;
+  phase_memory_tracker& operator=(const phase_memory_tracker&) = delete;
+
+  [[nodiscard]] bool supports_streams() const noexcept override
+  {
+    return upstream_->supports_streams();
+  }
+  [[nodiscard]] bool supports_get_mem_info() const noexcept override
+  {
+    return upstream_->supports_get_mem_info();
+  }
+
+  /** The peaks of the phases completed since the last `reset()`. */
+  std::map<std::string, peak> peaks() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return peaks_;
+  }
+
+  void reset()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    peaks_.clear();
+  }
+
+ private:
+  struct frame {
+    const char* name;
+    peak value;
+  };
+
+  static phase_memory_tracker*& instance()
+  {
+    static phase_memory_tracker* tracker = nullptr;
+    return tracker;
+  }
+
+  static void on_phase(const char* name, bool begin)
+  {
+    auto* tracker = instance();
+    if (tracker == nullptr) { return; }
+    std::lock_guard<std::mutex> lock(tracker->mutex_);
+    // the high-water mark since the last reset belongs to the innermost running phase
+    if (!tracker->stack_.empty()) {
+      auto& top      = tracker->stack_.back().value;
+      top.host_bytes = std::max(top.host_bytes, host_peak_bytes());
+    }
+    if (begin) {
+      tracker->stack_.push_back({name, {tracker->current_, 0}});
+    } else if (!tracker->stack_.empty()) {
+      auto done = tracker->stack_.back();
+      tracker->stack_.pop_back();
+      auto& p        = tracker->peaks_[done.name];
+      p.device_bytes = std::max(p.device_bytes, done.value.device_bytes);
+      p.host_bytes   = std::max(p.host_bytes, done.value.host_bytes);
+      if (!tracker->stack_.empty()) {
+        auto& parent        = tracker->stack_.back().value;
+        parent.device_bytes = std::max(parent.device_bytes, done.value.device_bytes);
+        parent.host_bytes   = std::max(parent.host_bytes, done.value.host_bytes);
+      }
+    }
+    reset_host_peak();
+  }
+
+  /** VmHWM of the process in bytes. */
+  static size_t host_peak_bytes()
+  {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+      if (line.compare(0, 6, "VmHWM:") == 0) { return std::stoull(line.substr(6)) * 1024; }
+    }
+    return 0;
+  }
+
+  static void reset_host_peak()
+  {
+    if (FILE* f = std::fopen("/proc/self/clear_refs", "w"); f != nullptr) {
+      std::fputs("5", f);
+      std::fclose(f);
+    }
+  }
+
+  void* do_allocate(size_t bytes, rmm::cuda_stream_view stream) override
+  {
+    void* ptr = upstream_->allocate(bytes, stream);
+    std::lock_guard<std::mutex> lock(mutex_);
+    current_ += bytes;
+    for (auto& f : stack_) {
+      f.value.device_bytes = std::max(f.value.device_bytes, current_);
+    }
+    return ptr;
+  }
+
+  void do_deallocate(void* ptr, size_t bytes, rmm::cuda_stream_view stream) override
+  {
+    upstream_->deallocate(ptr, bytes, stream);
+    std::lock_guard<std::mutex> lock(mutex_);
+    current_ -= bytes;
+  }
+
+  [[nodiscard]] bool do_is_equal(const device_memory_resource& other) const noexcept override
+  {
+    return this == &other;
+  }
+
+  [[nodiscard]] std::pair<size_t, size_t> do_get_mem_info(
+    rmm::cuda_stream_view stream) const override
+  {
+    return upstream_->get_mem_info(stream);
+  }
+
+  rmm::mr::device_memory_resource* upstream_;
+  mutable std::mutex mutex_;
+  size_t current_ = 0;
+  std::vector<frame> stack_;
+  std::map<std::string, peak> peaks_;
+};
+
+/**
+ * Write the phases of a build to `file` as JSON: the device time of each `raft::metrics::phase`,
+ * the host time of the NVTX ranges of the library, and the peak memory of each phase.
+ */
+inline void write_build_phases(const std::string& file,
+                               const std::string& name,
+                               const std::string& algo,
+                               float build_time,
+                               const std::vector<raft::metrics::metric_summary>& metrics,
+                               const std::map<std::string, phase_memory_tracker::peak>& peaks)
+{
+  nlohmann::json out;
+  out["name"]       = name;
+  out["algo"]       = algo;
+  out["build_time"] = build_time;
+  out["phases"]     = nlohmann::json::object();
+  out["ranges"]     = nlohmann::json::object();
+  for (const auto& m : metrics) {
+    if (m.kind == raft::metrics::metric_kind::device_time && peaks.count(m.name) > 0) {
+      auto& phase                = out["phases"][m.name];
+      phase["count"]             = m.count;
+      phase["device_time"]       = m.sum / 1e6;
+      phase["peak_device_bytes"] = peaks.at(m.name).device_bytes;
+      phase["peak_host_bytes"]   = peaks.at(m.name).host_bytes;
+    } else if (m.kind == raft::metrics::metric_kind::host_time) {
+      out["ranges"][m.name] = {{"count", m.count}, {"host_time", m.sum / 1e6}};
+    }
+  }
+  std::ofstream ofs(file);
+  if (!ofs) { throw std::runtime_error("can't open build phases file: " + file); }
+  ofs << out.dump(2) << std::endl;
+  if (!ofs) { throw std::runtime_error("can't write to build phases file: " + file); }
+}
+
+}  // namespace raft::bench::ann
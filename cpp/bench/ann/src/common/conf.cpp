@@ -66,6 +66,10 @@ void Configuration::parse_dataset_(const nlohmann::json& conf)
     dataset_conf_.subset_first_row = conf.at("subset_first_row");
   }
   if (conf.contains("subset_size")) { dataset_conf_.subset_size = conf.at("subset_size"); }
+  if (conf.contains("host_register")) { dataset_conf_.host_register = conf.at("host_register"); }
+  if (conf.contains("groundtruth_neighbors_file")) {
+    dataset_conf_.groundtruth_neighbors_file = conf.at("groundtruth_neighbors_file");
+  }
 
   if (conf.contains("dtype")) {
     dataset_conf_.dtype = conf.at("dtype");
@@ -90,6 +94,21 @@ void Configuration::parse_index_(const nlohmann::json& index_conf,
   const int k          = search_basic_conf.at("k");
   const int run_count  = search_basic_conf.at("run_count");
 
+  int num_threads    = 1;
+  float arrival_rate = 0.0f;
+  float latency_slo  = 0.0f;
+  if (search_basic_conf.contains("num_threads")) {
+    num_threads = search_basic_conf.at("num_threads");
+    if (num_threads < 1) { throw runtime_error("num_threads should >= 1"); }
+  }
+  if (search_basic_conf.contains("arrival_rate")) {
+    arrival_rate = search_basic_conf.at("arrival_rate");
+    if (arrival_rate < 0.0f) { throw runtime_error("arrival_rate should >= 0"); }
+  }
+  if (search_basic_conf.contains("latency_slo")) {
+    latency_slo = search_basic_conf.at("latency_slo");
+  }
+
   for (const auto& conf : index_conf) {
     Index index;
     index.name        = conf.at("name");
@@ -100,6 +119,10 @@ void Configuration::parse_index_(const nlohmann::json& index_conf,
     index.k           = k;
     index.run_count   = run_count;
 
+    index.num_threads  = num_threads;
+    index.arrival_rate = arrival_rate;
+    index.latency_slo  = latency_slo;
+
     if (conf.contains("multigpu")) {
       for (auto it : conf.at("multigpu")) {
         index.dev_list.push_back(it);
@@ -117,8 +140,33 @@ void Configuration::parse_index_(const nlohmann::json& index_conf,
       index.refine_ratio = refine_ratio;
     }
 
-    for (const auto& param : conf.at("search_params")) {
-      index.search_params.push_back(param);
+    if (conf.contains("search_params")) {
+      for (const auto& param : conf.at("search_params")) {
+        index.search_params.push_back(param);
+      }
+    }
+    // every combination of the values of the grid is added to the search params
+    if (conf.contains("search_param_grid")) {
+      vector<nlohmann::json> grid{nlohmann::json::object()};
+      for (const auto& [key, values] : conf.at("search_param_grid").items()) {
+        if (!values.is_array() || values.empty()) {
+          throw runtime_error("'" + index.name + "': search_param_grid." + key +
+                              " should be a non-empty array");
+        }
+        vector<nlohmann::json> expanded;
+        for (const auto& param : grid) {
+          for (const auto& value : values) {
+            expanded.push_back(param);
+            expanded.back()[key] = value;
+          }
+        }
+        grid = std::move(expanded);
+      }
+      index.search_params.insert(index.search_params.end(), grid.begin(), grid.end());
+    }
+    if (index.search_params.empty()) {
+      throw runtime_error("'" + index.name +
+                          "': either search_params or search_param_grid should be given");
     }
     index.search_result_file = conf.at("search_result_file");
 
@@ -36,6 +36,13 @@ class Configuration {
     int batch_size;
     int k;
     int run_count;
+    // the number of concurrent client threads; each has its own instance of the algo
+    int num_threads{1};
+    // the mean rate (batches per second) of the Poisson arrival of the batches to all the threads;
+    // 0 means closed loop, i.e. a thread submits the next batch as soon as its previous one is done
+    float arrival_rate{0.0f};
+    // the latency target (ms) of a batch; the fraction of the batches within it is reported
+    float latency_slo{0.0f};
     std::vector<nlohmann::json> search_params;
     std::string search_result_file;
     float refine_ratio{0.0f};
@@ -52,9 +59,15 @@ class Configuration {
     size_t subset_size{0};
     std::string query_file;
     std::string distance;
+    // optional; if set, the recall of each search param is computed and written with the
+    // recall-vs-QPS Pareto frontier to `<search_result_file>.sweep.csv`
+    std::string groundtruth_neighbors_file;
 
     // data type of input dataset, possible values ["float", "int8", "uint8"]
     std::string dtype;
+
+    // page-lock the memory mapping of the base set with cudaHostRegister
+    bool host_register{false};
   };
 
   Configuration(std::istream& conf_stream);
@@ -19,9 +19,11 @@
 #include <sys/mman.h>
 #include <sys/stat.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
 #include <stdexcept>
 #include <string>
 #include <type_traits>
@@ -243,6 +245,8 @@ class Dataset {
     return query_set_;
   }
 
+  // Unless the base set is already in host memory, it is copied to the GPU from its memory
+  // mapping in chunks, so that the whole base set is never read into host memory.
   const T* base_set_on_gpu() const;
   const T* query_set_on_gpu() const;
   const T* mapped_base_set() const;
@@ -252,6 +256,9 @@ class Dataset {
   virtual void load_query_set_() const = 0;
   virtual void map_base_set_() const   = 0;
 
+  // whether the memory mapping of the base set is registered (page-locked) with CUDA
+  mutable bool mapped_base_set_registered_ = false;
+
   std::string name_;
   std::string distance_;
   int dim_;
@@ -278,10 +285,42 @@ template <typename T>
 const T* Dataset<T>::base_set_on_gpu() const
 {
   if (!d_base_set_) {
-    base_set();
-    RAFT_CUDA_TRY(cudaMalloc((void**)&d_base_set_, base_set_size_ * dim_ * sizeof(T)));
-    RAFT_CUDA_TRY(cudaMemcpy(
-      d_base_set_, base_set_, base_set_size_ * dim_ * sizeof(T), cudaMemcpyHostToDevice));
+    const size_t bytes = base_set_size_ * dim_ * sizeof(T);
+    RAFT_CUDA_TRY(cudaMalloc((void**)&d_base_set_, bytes));
+    if (base_set_ || mapped_base_set_registered_) {
+      const T* src = base_set_ ? base_set_ : mapped_base_set_;
+      RAFT_CUDA_TRY(cudaMemcpy(d_base_set_, src, bytes, cudaMemcpyHostToDevice));
+      return d_base_set_;
+    }
+
+    // Page in the next chunk of the mapping while the previous one is being copied.
+    constexpr size_t kChunkBytes = size_t{256} << 20;
+    const char* src              = reinterpret_cast<const char*>(mapped_base_set());
+    char* staging[2];
+    cudaEvent_t copied[2];
+    cudaStream_t stream;
+    RAFT_CUDA_TRY(cudaStreamCreate(&stream));
+    for (int i = 0; i < 2; i++) {
+      RAFT_CUDA_TRY(cudaMallocHost((void**)&staging[i], kChunkBytes));
+      RAFT_CUDA_TRY(cudaEventCreateWithFlags(&copied[i], cudaEventDisableTiming));
+    }
+    for (size_t offset = 0, i = 0; offset < bytes; offset += kChunkBytes, i ^= 1) {
+      const size_t chunk = std::min(kChunkBytes, bytes - offset);
+      RAFT_CUDA_TRY(cudaEventSynchronize(copied[i]));
+      std::memcpy(staging[i], src + offset, chunk);
+      RAFT_CUDA_TRY(cudaMemcpyAsync(reinterpret_cast<char*>(d_base_set_) + offset,
+                                    staging[i],
+                                    chunk,
+                                    cudaMemcpyHostToDevice,
+                                    stream));
+      RAFT_CUDA_TRY(cudaEventRecord(copied[i], stream));
+    }
+    RAFT_CUDA_TRY(cudaStreamSynchronize(stream));
+    for (int i = 0; i < 2; i++) {
+      RAFT_CUDA_TRY(cudaEventDestroy(copied[i]));
+      RAFT_CUDA_TRY(cudaFreeHost(staging[i]));
+    }
+    RAFT_CUDA_TRY(cudaStreamDestroy(stream));
   }
   return d_base_set_;
 }
@@ -313,10 +352,14 @@ class BinDataset : public Dataset<T> {
              size_t subset_first_row,
              size_t subset_size,
              const std::string& query_file,
-             const std::string& distance);
+             const std::string& distance,
+             bool host_register = false);
   ~BinDataset()
   {
     if (this->mapped_base_set_) {
+      if (this->mapped_base_set_registered_) {
+        RAFT_CUDA_TRY_NO_THROW(cudaHostUnregister(this->mapped_base_set_));
+      }
       base_file_.unmap(reinterpret_cast<char*>(this->mapped_base_set_) - subset_offset_);
     }
   }
@@ -334,6 +377,7 @@ class BinDataset : public Dataset<T> {
   BinFile<T> query_file_;
 
   size_t subset_offset_;
+  bool host_register_;
 };
 
 template <typename T>
@@ -342,13 +386,15 @@ BinDataset<T>::BinDataset(const std::string& name,
                           size_t subset_first_row,
                           size_t subset_size,
                           const std::string& query_file,
-                          const std::string& distance)
+                          const std::string& distance,
+                          bool host_register)
   : Dataset<T>(name, distance),
     base_file_(base_file, "r", subset_first_row, subset_size),
     query_file_(query_file, "r"),
-    subset_offset_(2 * sizeof(uint32_t) + subset_first_row * dim_ * sizeof(T))
+    host_register_(host_register)
 {
   base_file_.get_shape(&base_set_size_, &dim_);
+  subset_offset_ = 2 * sizeof(uint32_t) + subset_first_row * dim_ * sizeof(T);
   int query_dim;
   query_file_.get_shape(&query_set_size_, &query_dim);
   if (query_dim != dim_) {
@@ -376,6 +422,13 @@ void BinDataset<T>::map_base_set_() const
 {
   char* original_map_ptr = static_cast<char*>(base_file_.map());
   this->mapped_base_set_ = reinterpret_cast<T*>(original_map_ptr + subset_offset_);
+  if (host_register_) {
+    // Page-locks the mapping (and reads it in), so that the GPU can copy from it directly.
+    RAFT_CUDA_TRY(cudaHostRegister(this->mapped_base_set_,
+                                   base_set_size_ * dim_ * sizeof(T),
+                                   cudaHostRegisterReadOnly));
+    this->mapped_base_set_registered_ = true;
+  }
 }
 
 }  // namespace  raft::bench::ann
@@ -40,6 +40,12 @@ extern template class raft::bench::ann::RaftIvfPQ<float, int64_t>;
 extern template class raft::bench::ann::RaftIvfPQ<uint8_t, int64_t>;
 extern template class raft::bench::ann::RaftIvfPQ<int8_t, int64_t>;
 #endif
+#ifdef RAFT_ANN_BENCH_USE_RAFT_CAGRA
+#include "raft_cagra_wrapper.h"
+extern template class raft::bench::ann::RaftCagra<float, uint32_t>;
+extern template class raft::bench::ann::RaftCagra<uint8_t, uint32_t>;
+extern template class raft::bench::ann::RaftCagra<int8_t, uint32_t>;
+#endif
 #define JSON_DIAGNOSTICS 1
 #include <nlohmann/json.hpp>
 
@@ -117,6 +123,76 @@ void parse_search_param(const nlohmann::json& conf,
 }
 #endif
 
+#ifdef RAFT_ANN_BENCH_USE_RAFT_CAGRA
+template <typename T, typename IdxT>
+void parse_build_param(const nlohmann::json& conf,
+                       typename raft::bench::ann::RaftCagra<T, IdxT>::BuildParam& param)
+{
+  namespace cagra = raft::neighbors::experimental::cagra;
+  if (conf.contains("index_dim")) {
+    param.graph_degree              = conf.at("index_dim");
+    param.intermediate_graph_degree = param.graph_degree * 2;
+  }
+  if (conf.contains("intermediate_graph_degree")) {
+    param.intermediate_graph_degree = conf.at("intermediate_graph_degree");
+  }
+  if (conf.contains("graph_build_algo")) {
+    std::string algo = conf.at("graph_build_algo");
+    if (algo == "IVF_PQ") {
+      param.build_algo = cagra::graph_build_algo::IVF_PQ;
+    } else if (algo == "NN_DESCENT") {
+      param.build_algo = cagra::graph_build_algo::NN_DESCENT;
+    } else {
+      throw std::runtime_error("graph_build_algo: '" + algo +
+                               "', should be either 'IVF_PQ' or 'NN_DESCENT'");
+    }
+  }
+  if (conf.contains("nn_descent_niter")) { param.nn_descent_niter = conf.at("nn_descent_niter"); }
+  if (conf.contains("compression")) {
+    std::string type = conf.at("compression");
+    if (type == "none") {
+      param.compression = cagra::dataset_compression::NONE;
+    } else if (type == "fp16") {
+      param.compression = cagra::dataset_compression::FP16;
+    } else if (type == "int8") {
+      param.compression = cagra::dataset_compression::INT8;
+    } else {
+      throw std::runtime_error("compression: '" + type +
+                               "', should be either 'none', 'fp16' or 'int8'");
+    }
+  }
+}
+
+template <typename T, typename IdxT>
+void parse_search_param(const nlohmann::json& conf,
+                        typename raft::bench::ann::RaftCagra<T, IdxT>::SearchParam& param)
+{
+  namespace cagra = raft::neighbors::experimental::cagra;
+  param.p.itopk_size = conf.at("itopk");
+  if (conf.contains("search_width")) { param.p.num_parents = conf.at("search_width"); }
+  if (conf.contains("max_iterations")) { param.p.max_iterations = conf.at("max_iterations"); }
+  if (conf.contains("team_size")) { param.p.team_size = conf.at("team_size"); }
+  if (conf.contains("max_queries")) { param.p.max_queries = conf.at("max_queries"); }
+  if (conf.contains("persistent")) { param.p.persistent = conf.at("persistent"); }
+  if (conf.contains("algo")) {
+    std::string algo = conf.at("algo");
+    if (algo == "single_cta") {
+      param.p.algo = cagra::search_algo::SINGLE_CTA;
+    } else if (algo == "multi_cta") {
+      param.p.algo = cagra::search_algo::MULTI_CTA;
+    } else if (algo == "multi_kernel") {
+      param.p.algo = cagra::search_algo::MULTI_KERNEL;
+    } else if (algo == "auto") {
+      param.p.algo = cagra::search_algo::AUTO;
+    } else {
+      throw std::runtime_error("algo: '" + algo +
+                               "', should be either 'single_cta', 'multi_cta', 'multi_kernel' or "
+                               "'auto'");
+    }
+  }
+}
+#endif
+
 template <typename T, template <typename> class Algo>
 std::unique_ptr<raft::bench::ann::ANN<T>> make_algo(raft::bench::ann::Metric metric,
                                                     int dim,
@@ -176,6 +252,13 @@ std::unique_ptr<raft::bench::ann::ANN<T>> create_algo(const std::string& algo,
     ann =
       std::make_unique<raft::bench::ann::RaftIvfPQ<T, int64_t>>(metric, dim, param, refine_ratio);
   }
+#endif
+#ifdef RAFT_ANN_BENCH_USE_RAFT_CAGRA
+  if (algo == "raft_cagra") {
+    typename raft::bench::ann::RaftCagra<T, uint32_t>::BuildParam param;
+    parse_build_param<T, uint32_t>(conf, param);
+    ann = std::make_unique<raft::bench::ann::RaftCagra<T, uint32_t>>(metric, dim, param);
+  }
 #endif
   if (!ann) { throw std::runtime_error("invalid algo: '" + algo + "'"); }
 
@@ -207,6 +290,13 @@ std::unique_ptr<typename raft::bench::ann::ANN<T>::AnnSearchParam> create_search
     parse_search_param<T, int64_t>(conf, *param);
     return param;
   }
+#endif
+#ifdef RAFT_ANN_BENCH_USE_RAFT_CAGRA
+  if (algo == "raft_cagra") {
+    auto param = std::make_unique<typename raft::bench::ann::RaftCagra<T, uint32_t>::SearchParam>();
+    parse_search_param<T, uint32_t>(conf, *param);
+    return param;
+  }
 #endif
   // else
   throw std::runtime_error("invalid algo: '" + algo + "'");
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cassert>
+#include <optional>
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/device_resources.hpp>
+#include <raft/core/host_mdspan.hpp>
+#include <raft/core/logger.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/linalg/unary_op.cuh>
+#include <raft/neighbors/cagra.cuh>
+#include <raft/neighbors/cagra_serialize.cuh>
+#include <raft/neighbors/cagra_types.hpp>
+#include <raft/util/cudart_utils.hpp>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "../common/ann_types.hpp"
+#include "raft_ann_bench_utils.h"
+
+namespace raft::bench::ann {
+
+template <typename T, typename IdxT>
+class RaftCagra : public ANN<T> {
+ public:
+  using typename ANN<T>::AnnSearchParam;
+  using ANN<T>::dim_;
+
+  struct SearchParam : public AnnSearchParam {
+    raft::neighbors::experimental::cagra::search_params p;
+  };
+
+  using BuildParam = raft::neighbors::experimental::cagra::index_params;
+
+  RaftCagra(Metric metric, int dim, const BuildParam& param);
+
+  void build(const T* dataset, size_t nrow, cudaStream_t stream) final;
+
+  void set_search_param(const AnnSearchParam& param) override;
+
+  // TODO: if the number of results is less than k, the remaining elements of 'neighbors'
+  // will be filled with (size_t)-1
+  void search(const T* queries,
+              int batch_size,
+              int k,
+              size_t* neighbors,
+              float* distances,
+              cudaStream_t stream = 0) const override;
+
+  // the dataset is copied to the device by the build and stored with the index
+  AlgoProperty get_property() const override
+  {
+    AlgoProperty property;
+    property.dataset_memory_type      = MemoryType::Host;
+    property.query_memory_type        = MemoryType::Device;
+    property.need_dataset_when_search = false;
+    return property;
+  }
+  void save(const std::string& file) const override;
+  void load(const std::string&) override;
+
+ private:
+  raft::device_resources handle_;
+  BuildParam index_params_;
+  raft::neighbors::experimental::cagra::search_params search_params_;
+  std::optional<raft::neighbors::experimental::cagra::index<T, IdxT>> index_;
+  int device_;
+};
+
+template <typename T, typename IdxT>
+RaftCagra<T, IdxT>::RaftCagra(Metric metric, int dim, const BuildParam& param)
+  : ANN<T>(metric, dim), index_params_(param)
+{
+  index_params_.metric = parse_metric_type(metric);
+  RAFT_CUDA_TRY(cudaGetDevice(&device_));
+}
+
+template <typename T, typename IdxT>
+void RaftCagra<T, IdxT>::build(const T* dataset, size_t nrow, cudaStream_t)
+{
+  auto dataset_v = raft::make_host_matrix_view<const T, IdxT>(dataset, IdxT(nrow), dim_);
+  index_.emplace(raft::neighbors::experimental::cagra::build(handle_, index_params_, dataset_v));
+  return;
+}
+
+template <typename T, typename IdxT>
+void RaftCagra<T, IdxT>::set_search_param(const AnnSearchParam& param)
+{
+  auto search_param = dynamic_cast<const SearchParam&>(param);
+  search_params_    = search_param.p;
+  return;
+}
+
+template <typename T, typename IdxT>
+void RaftCagra<T, IdxT>::save(const std::string& file) const
+{
+  raft::neighbors::experimental::cagra::serialize(handle_, file, *index_);
+  return;
+}
+
+template <typename T, typename IdxT>
+void RaftCagra<T, IdxT>::load(const std::string& file)
+{
+  index_ = raft::neighbors::experimental::cagra::deserialize<T, IdxT>(handle_, file);
+  return;
+}
+
+template <typename T, typename IdxT>
+void RaftCagra<T, IdxT>::search(
+  const T* queries, int batch_size, int k, size_t* neighbors, float* distances, cudaStream_t) const
+{
+  auto stream = resource::get_cuda_stream(handle_);
+  // The whole batch is searched at once, unless the conf limits the number of queries.
+  auto params = search_params_;
+  if (params.max_queries <= 1) { params.max_queries = batch_size; }
+
+  auto queries_v   = raft::make_device_matrix_view<const T, IdxT>(queries, batch_size, dim_);
+  auto distances_v = raft::make_device_matrix_view<float, IdxT>(distances, batch_size, k);
+  // The index type of CAGRA is narrower than that of the benchmark.
+  auto neighbors_tmp = raft::make_device_matrix<IdxT, IdxT>(handle_, batch_size, k);
+
+  raft::neighbors::experimental::cagra::search(
+    handle_, params, *index_, queries_v, neighbors_tmp.view(), distances_v);
+  raft::linalg::unaryOp(neighbors,
+                        neighbors_tmp.data_handle(),
+                        neighbors_tmp.size(),
+                        raft::cast_op<size_t>{},
+                        stream);
+  resource::sync_stream(handle_);
+  return;
+}
+}  // namespace raft::bench::ann
@@ -16,8 +16,14 @@
 
 #pragma once
 
+#include <cctype>
 #include <memory>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_properties.hpp>
 
 #include <raft/core/detail/macros.hpp>
 #include <raft/core/device_mdarray.hpp>
@@ -105,6 +111,36 @@ struct cuda_event_timer {
   }
 };
 
+/** The theoretical peak throughput of a device. */
+struct device_peaks {
+  /** DRAM bandwidth [bytes/s]. */
+  double bytes_per_s;
+  /** FP32 and FP64 arithmetic (an FMA counts as two operations) [FLOP/s]. */
+  double fp32_flops, fp64_flops;
+
+  explicit device_peaks(const cudaDeviceProp& prop)
+  {
+    // The number of the FP32 / FP64 units per SM is not queryable.
+    std::pair<int, int> units_per_sm{128, 2};
+    switch (prop.major * 10 + prop.minor) {
+      case 60: units_per_sm = {64, 32}; break;
+      case 61:
+      case 62: units_per_sm = {128, 4}; break;
+      case 70:
+      case 72: units_per_sm = {64, 32}; break;
+      case 75: units_per_sm = {64, 2}; break;
+      case 80: units_per_sm = {64, 32}; break;
+      case 90: units_per_sm = {128, 64}; break;
+      default: break;
+    }
+    // the clock rates are in kHz; the memory is double data rate
+    double sm_clock = 1e3 * prop.clockRate * prop.multiProcessorCount * 2;
+    bytes_per_s     = 2e3 * prop.memoryClockRate * (prop.memoryBusWidth / 8);
+    fp32_flops      = sm_clock * units_per_sm.first;
+    fp64_flops      = sm_clock * units_per_sm.second;
+  }
+};
+
 /** Main fixture to be inherited and used by all other c++ benchmarks */
 class fixture {
  private:
@@ -149,6 +185,38 @@ class fixture {
     RAFT_CUDA_TRY(cudaMemsetAsync(scratch_buf_.data(), 0, scratch_buf_.size(), stream));
   }
 
+  /**
+   * Report where a benchmark is on the roofline of the device: its achieved bandwidth and FLOP/s,
+   * their percentage of the theoretical peak of the device, and the arithmetic intensity.
+   *
+   * To be called in `run_benchmark` with the work done by one iteration.
+   *
+   * @param state
+   * @param bytes_read the bytes read from the global memory by one iteration
+   * @param bytes_written the bytes written to the global memory by one iteration
+   * @param flops the floating point operations done by one iteration (zero, if not relevant)
+   * @param fp64 whether the operations are in double precision
+   */
+  void report_roofline(::benchmark::State& state,
+                       double bytes_read,
+                       double bytes_written,
+                       double flops = 0,
+                       bool fp64    = false)
+  {
+    using benchmark::Counter;
+    device_peaks peaks(resource::get_device_properties(handle));
+    double bytes = bytes_read + bytes_written;
+    auto rate    = Counter::kIsIterationInvariantRate;
+
+    state.counters["BW"]       = Counter(bytes, rate, Counter::kIs1000);
+    state.counters["BW %peak"] = Counter(100.0 * bytes / peaks.bytes_per_s, rate);
+    if (flops <= 0) { return; }
+    double peak_flops              = fp64 ? peaks.fp64_flops : peaks.fp32_flops;
+    state.counters["FLOP/s"]       = Counter(flops, rate, Counter::kIs1000);
+    state.counters["FLOP/s %peak"] = Counter(100.0 * flops / peak_flops, rate);
+    state.counters["FLOP/byte"]    = Counter(flops / bytes);
+  }
+
   /**
    * The helper to be used inside `run_benchmark`, to loop over the state and record time using the
    * cuda_event_timer.
@@ -264,6 +332,46 @@ class Fixture : public ::benchmark::Fixture {
   }
 };  // class Fixture
 
+template <typename T, typename = void>
+struct is_streamable : std::false_type {};
+
+template <typename T>
+struct is_streamable<T, std::void_t<decltype(std::declval<std::ostream&>() << std::declval<T>())>>
+  : std::true_type {};
+
+/**
+ * The name of a parameter in the benchmark name: its `operator<<` representation (the field list,
+ * if it is of the form `name{fields...}`), without the whitespace and with ',' replaced by '#'.
+ * The position of the parameter in its input vector is used for the types not printable.
+ *
+ * Encoding the values rather than the positions keeps the names stable when the input vectors
+ * change, which is what the comparison of the results across runs relies on.
+ */
+template <typename Param>
+auto param_name(const Param& param, int position) -> std::string
+{
+  if constexpr (is_streamable<const Param&>::value) {
+    std::ostringstream stream;
+    stream << param;
+    auto repr  = stream.str();
+    auto begin = repr.find('{');
+    auto end   = repr.rfind('}');
+    if (begin != std::string::npos && end != std::string::npos && begin < end) {
+      repr = repr.substr(begin + 1, end - begin - 1);
+    }
+    std::string name;
+    for (char c : repr) {
+      if (c == ',') {
+        name += '#';
+      } else if (!std::isspace(static_cast<unsigned char>(c))) {
+        name += c;
+      }
+    }
+    if (!name.empty()) { return name; }
+  }
+  return std::to_string(position);
+}
+
 /**
  * A helper struct to create a fixture for every combination of input vectors.
  * Use with care, this can blow up quickly!
@@ -299,7 +407,7 @@ struct cartesian_registrar<Class, Param, Params...> {
     int param_len = param.size();
     for (int i = 0; i < param_len; i++) {
       cartesian_registrar<Class, Params...>::run(
-        case_name + "/" + std::to_string(i), params..., fixed..., param[i]);
+        case_name + "/" + param_name(param[i], i), params..., fixed..., param[i]);
     }
   }
 };
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <benchmark/benchmark.h>  // NOLINT
+#include <cuda_runtime_api.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace raft::bench {
+
+/**
+ * Record the environment of a run in the context of the results (the RAFT version, the device, the
+ * CUDA driver and runtime), so that the results of different runs can be told apart.
+ */
+inline void add_benchmark_context()
+{
+#ifdef RAFT_BENCH_VERSION
+  ::benchmark::AddCustomContext("raft_version", RAFT_BENCH_VERSION);
+#endif
+  int dev_id = 0;
+  cudaDeviceProp prop;
+  if (cudaGetDevice(&dev_id) == cudaSuccess &&
+      cudaGetDeviceProperties(&prop, dev_id) == cudaSuccess) {
+    ::benchmark::AddCustomContext("gpu_name", prop.name);
+    ::benchmark::AddCustomContext("gpu_compute_capability",
+                                  std::to_string(prop.major) + "." + std::to_string(prop.minor));
+    ::benchmark::AddCustomContext("gpu_memory_bytes", std::to_string(prop.totalGlobalMem));
+  }
+  int driver_version  = 0;
+  int runtime_version = 0;
+  if (cudaDriverGetVersion(&driver_version) == cudaSuccess) {
+    ::benchmark::AddCustomContext("cuda_driver_version", std::to_string(driver_version));
+  }
+  if (cudaRuntimeGetVersion(&runtime_version) == cudaSuccess) {
+    ::benchmark::AddCustomContext("cuda_runtime_version", std::to_string(runtime_version));
+  }
+}
+
+/**
+ * The command line arguments with the JSON output made the default: unless `--benchmark_out` is
+ * given, the results are also written to `<executable name>.json` in the working directory.
+ *
+ * The returned pointers refer to `argv` and to static storage; the list is null-terminated.
+ */
+inline auto with_default_output(int argc, char** argv) -> std::vector<char*>
+{
+  std::vector<char*> args(argv, argv + argc);
+  for (int i = 1; i < argc; i++) {
+    if (std::strncmp(argv[i], "--benchmark_out=", 16) == 0) {
+      args.push_back(nullptr);
+      return args;
+    }
+  }
+  std::string exe_name(argv[0]);
+  auto pos = exe_name.rfind('/');
+  if (pos != std::string::npos) { exe_name = exe_name.substr(pos + 1); }
+  static std::string out_arg    = "--benchmark_out=" + exe_name + ".json";
+  static std::string format_arg = "--benchmark_out_format=json";
+  args.push_back(out_arg.data());
+  args.push_back(format_arg.data());
+  args.push_back(nullptr);
+  return args;
+}
+
+/** The common `main` of the benchmarks. */
+inline auto run_main(int argc, char** argv) -> int
+{
+  auto args  = with_default_output(argc, argv);
+  int n_args = int(args.size()) - 1;
+  ::benchmark::Initialize(&n_args, args.data());
+  if (::benchmark::ReportUnrecognizedArguments(n_args, args.data())) { return 1; }
+  add_benchmark_context();
+  ::benchmark::RunSpecifiedBenchmarks();
+  ::benchmark::Shutdown();
+  return 0;
+}
+
+}  // namespace raft::bench
@@ -57,6 +57,14 @@ struct distance : public fixture {
                                                worksize,
                                                params.isRowMajor);
     });
+
+    // all the metrics are counted as an FMA per pair of the elements
+    int64_t m = params.m, n = params.n, k = params.k;
+    report_roofline(state,
+                    (m + n) * k * sizeof(T),
+                    m * n * sizeof(T),
+                    2.0 * m * n * k,
+                    std::is_same_v<T, double>);
   }
 
  private:
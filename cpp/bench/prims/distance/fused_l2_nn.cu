@@ -106,18 +106,15 @@ struct fusedl2nn : public fixture {
 
     int64_t num_flops = 2 * params.m * params.n * params.k;
 
-    int64_t read_elts  = params.n * params.k + params.m * params.k;
+    // the data and the norms
+    int64_t read_elts  = params.n * params.k + params.m * params.k + params.m + params.n;
     int64_t write_elts = params.m;
 
-    state.counters["FLOP/s"] = benchmark::Counter(
-      num_flops, benchmark::Counter::kIsIterationInvariantRate, benchmark::Counter::OneK::kIs1000);
-
-    state.counters["BW Wr"] = benchmark::Counter(write_elts * sizeof(OutT),
-                                                 benchmark::Counter::kIsIterationInvariantRate,
-                                                 benchmark::Counter::OneK::kIs1000);
-    state.counters["BW Rd"] = benchmark::Counter(read_elts * sizeof(DataT),
-                                                 benchmark::Counter::kIsIterationInvariantRate,
-                                                 benchmark::Counter::OneK::kIs1000);
+    report_roofline(state,
+                    read_elts * sizeof(DataT),
+                    write_elts * sizeof(OutT),
+                    num_flops,
+                    std::is_same_v<DataT, double>);
   }
 
  private:
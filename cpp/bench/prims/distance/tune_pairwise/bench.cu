@@ -35,8 +35,11 @@
 // recompiled.
 //
 // RE 2, benchmarks with intent: this file contains a benchmark to check the
-// maximal throughput of a kernel. Measuring other things, like performance on
-// skinny or wide matrices is not yet implemented.
+// maximal throughput of a kernel and a benchmark that measures every tile
+// configuration on a set of shapes, including skinny and wide matrices. The
+// latter produces the per-architecture tile tables that pairwise_matrix
+// dispatches on, see
+// cpp/scripts/heuristics/pairwise_distance/generate_tile_table.py.
 
 #include "kernel.cuh"                                       // launch_kernel
 #include <algorithm>                                        // std::min
@@ -71,21 +74,27 @@ const std::vector<throughput_param> throughput_params{
   {32, 4, 32},
 };
 
+const std::vector<tile_config> tile_configs{
+  tile_config::kPolicy4x4,
+  tile_config::kPolicy4x4Skinny,
+};
+
 struct throughput_bench : public fixture {
   const throughput_param p;
+  const tile_config tile;
 
-  throughput_bench(const throughput_param& p_) : p(p_) {}
+  throughput_bench(const throughput_param& p_, const tile_config& tile_) : p(p_), tile(tile_) {}
 
   void run_benchmark(::benchmark::State& state) override
   {
     // Get block size:
     int block_m, block_n, block_k;
-    get_block_size(block_m, block_n, block_k);
+    get_block_size(tile, block_m, block_n, block_k);
 
     // Determine number of blocks that will be launched. This informs the size
     // of the inputs as well as the grid size.
     const int num_sms       = raft::getMultiProcessorCount();
-    const int max_occupancy = get_max_occupancy();
+    const int max_occupancy = get_max_occupancy(tile);
     const int occupancy     = std::min(p.occupancy, max_occupancy);
     const int num_blocks    = occupancy * num_sms;
     dim3 grid(num_blocks);
@@ -119,7 +128,7 @@ struct throughput_bench : public fixture {
       IdxT(m), IdxT(n), IdxT(k), ldx, ldy, ld_out, x, y, x_norm, y_norm, out, fin_op, row_major};
 
     // Run benchmark
-    loop_on_state(state, [&]() { launch_kernel(kparams, grid, stream); });
+    loop_on_state(state, [&]() { launch_kernel(tile, kparams, grid, stream); });
 
     // Report metrics. We don't report flop/s because we do not know for each
     // distance operation how many flops it costs. For L2_unexp and l1, we can
@@ -135,6 +144,7 @@ struct throughput_bench : public fixture {
     state.counters["occupancy"] = benchmark::Counter(occupancy);
     state.counters["# waves"]   = benchmark::Counter(p.num_waves);
     state.counters["# k iters"] = benchmark::Counter(p.num_k_iters);
+    state.counters["tile"]      = benchmark::Counter(static_cast<int>(tile));
 
     state.counters["core_ops/s"] = benchmark::Counter(num_core_ops,
                                                       benchmark::Counter::kIsIterationInvariantRate,
@@ -146,6 +156,85 @@ struct throughput_bench : public fixture {
   }
 };
 
-RAFT_BENCH_REGISTER(throughput_bench, "", throughput_params);
+RAFT_BENCH_REGISTER(throughput_bench, "", throughput_params, tile_configs);
+
+// Shape benchmark.
+//
+// Goal: Measure the time of every tile configuration on the shapes the
+// dispatch has to serve, as launched by pairwise_matrix (i.e. with the grid of
+// launchConfigGenerator). Besides square-ish shapes, this includes single and
+// few rows (m = 1, 16) against a huge n, and thin k = 2..16.
+//
+// The fastest tile configuration per shape makes up the tile table of the
+// architecture the benchmark was run on.
+struct shape_param {
+  size_t m;
+  size_t n;
+  size_t k;
+};
+
+std::vector<shape_param> make_shape_params()
+{
+  std::vector<shape_param> params;
+  for (size_t m : {1, 16, 256, 4096}) {
+    for (size_t n : {1024, 65536, 1048576}) {
+      for (size_t k : {2, 4, 8, 16, 32, 128, 512}) {
+        // Keep the output below 1 GiB
+        if (m * n <= (size_t{1} << 28)) { params.push_back({m, n, k}); }
+      }
+    }
+  }
+  return params;
+}
+
+const std::vector<shape_param> shape_params = make_shape_params();
+
+struct shape_bench : public fixture {
+  const shape_param p;
+  const tile_config tile;
+
+  shape_bench(const shape_param& p_, const tile_config& tile_) : p(p_), tile(tile_) {}
+
+  void run_benchmark(::benchmark::State& state) override
+  {
+    rmm::device_uvector<DataT> x_vec(p.m * p.k, stream);
+    rmm::device_uvector<DataT> y_vec(p.n * p.k, stream);
+    rmm::device_uvector<DataT> x_norm_vec(p.m, stream);
+    rmm::device_uvector<DataT> y_norm_vec(p.n, stream);
+    rmm::device_uvector<OutT> out_vec(p.m * p.n, stream);
+
+    IdxT ldx    = row_major ? p.k : p.m;
+    IdxT ldy    = row_major ? p.k : p.n;
+    IdxT ld_out = row_major ? p.n : p.m;
+
+    pairwise_matrix_params kparams{IdxT(p.m),
+                                   IdxT(p.n),
+                                   IdxT(p.k),
+                                   ldx,
+                                   ldy,
+                                   ld_out,
+                                   x_vec.data(),
+                                   y_vec.data(),
+                                   x_norm_vec.data(),
+                                   y_norm_vec.data(),
+                                   out_vec.data(),
+                                   FinOpT{},
+                                   row_major};
+    dim3 grid = get_grid(tile, kparams);
+
+    loop_on_state(state, [&]() { launch_kernel(tile, kparams, grid, stream); });
+
+    state.counters["m"]    = benchmark::Counter(p.m);
+    state.counters["n"]    = benchmark::Counter(p.n);
+    state.counters["k"]    = benchmark::Counter(p.k);
+    state.counters["tile"] = benchmark::Counter(static_cast<int>(tile));
+    state.counters["core_ops/s"] =
+      benchmark::Counter(p.m * p.n * p.k,
+                         benchmark::Counter::kIsIterationInvariantRate,
+                         benchmark::Counter::OneK::kIs1000);
+  }
+};
+
+RAFT_BENCH_REGISTER(shape_bench, "", shape_params, tile_configs);
 
 }  // namespace raft::bench::distance::tune
@@ -26,63 +26,83 @@ using OpT                  = raft::distance::detail::ops::lp_unexp_distance_op<D
 constexpr float metric_arg = 2.0;
 OpT distance_op{metric_arg};
 
-// Kernel policy
+// Kernel policies: one per tile configuration that pairwise_matrix dispatches to
 constexpr int vec_len = 1;
 using Policy          = typename raft::linalg::Policy4x4<DataT, vec_len>::Policy;
+using SkinnyPolicy    = typename raft::linalg::Policy4x4Skinny<DataT, vec_len>::Policy;
 
 // Architecture
 namespace arch                 = raft::util::arch;
 constexpr auto sm_compat_range = arch::SM_range(arch::SM_min(), arch::SM_future());
 
-void launch_kernel(pairwise_matrix_params params, dim3 grid, cudaStream_t stream)
+// Calls f with the policy of the tile configuration
+template <typename F>
+auto dispatch_tile(tile_config tile, F f)
 {
-  dim3 block(Policy::Nthreads);
-  int smem_size = OpT::shared_mem_size<Policy>();
-
-  // Obtain function pointer to kernel
-  auto kernel = raft::distance::detail::pairwise_matrix_kernel<Policy,
-                                                               row_major,
-                                                               decltype(sm_compat_range),
-                                                               OpT,
-                                                               IdxT,
-                                                               DataT,
-                                                               OutT,
-                                                               FinOpT>;
+  if (tile == tile_config::kPolicy4x4Skinny) {
+    return f(SkinnyPolicy{});
+  } else {
+    return f(Policy{});
+  }
+}
 
-  kernel<<<grid, block, smem_size, stream>>>(distance_op, params);
-  RAFT_CUDA_TRY(cudaGetLastError());
+template <typename P>
+auto get_kernel()
+{
+  return raft::distance::detail::pairwise_matrix_kernel<P,
+                                                        row_major,
+                                                        decltype(sm_compat_range),
+                                                        OpT,
+                                                        IdxT,
+                                                        DataT,
+                                                        OutT,
+                                                        FinOpT>;
 }
 
-void get_block_size(int& m, int& n, int& k)
+void launch_kernel(tile_config tile, pairwise_matrix_params params, dim3 grid, cudaStream_t stream)
 {
-  m = Policy::Mblk;
-  n = Policy::Nblk;
-  k = Policy::Kblk;
+  dispatch_tile(tile, [&](auto policy) {
+    using P = decltype(policy);
+    dim3 block(P::Nthreads);
+    int smem_size = OpT::shared_mem_size<P>();
+
+    get_kernel<P>()<<<grid, block, smem_size, stream>>>(distance_op, params);
+    RAFT_CUDA_TRY(cudaGetLastError());
+  });
 }
 
-void* get_kernel_ptr()
+void get_block_size(tile_config tile, int& m, int& n, int& k)
 {
-  auto kernel = raft::distance::detail::pairwise_matrix_kernel<Policy,
-                                                               row_major,
-                                                               decltype(sm_compat_range),
-                                                               OpT,
-                                                               IdxT,
-                                                               DataT,
-                                                               OutT,
-                                                               FinOpT>;
-  return reinterpret_cast<void*>(kernel);
+  dispatch_tile(tile, [&](auto policy) {
+    using P = decltype(policy);
+    m       = P::Mblk;
+    n       = P::Nblk;
+    k       = P::Kblk;
+  });
 }
 
-int get_max_occupancy()
+int get_max_occupancy(tile_config tile)
 {
-  void* kernel_ptr = get_kernel_ptr();
-  int max_occupancy;
-  int smem_size = OpT::shared_mem_size<Policy>();
+  return dispatch_tile(tile, [&](auto policy) {
+    using P = decltype(policy);
+    int max_occupancy;
+    int smem_size = OpT::shared_mem_size<P>();
 
-  RAFT_CUDA_TRY(cudaOccupancyMaxActiveBlocksPerMultiprocessor(
-    &max_occupancy, kernel_ptr, Policy::Nthreads, smem_size));
+    RAFT_CUDA_TRY(cudaOccupancyMaxActiveBlocksPerMultiprocessor(
+      &max_occupancy, get_kernel<P>(), P::Nthreads, smem_size));
 
-  return max_occupancy;
+    return max_occupancy;
+  });
+}
+
+dim3 get_grid(tile_config tile, pairwise_matrix_params params)
+{
+  return dispatch_tile(tile, [&](auto policy) {
+    using P       = decltype(policy);
+    int smem_size = OpT::shared_mem_size<P>();
+    return raft::distance::detail::launchConfigGenerator<P>(
+      params.m, params.n, smem_size, get_kernel<P>());
+  });
 }
 
 }  // namespace raft::bench::distance::tune
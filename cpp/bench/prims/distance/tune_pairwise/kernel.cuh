@@ -16,8 +16,9 @@
 
 #pragma once
 
-#include <raft/distance/detail/distance_ops/all_ops.cuh>    // lp_unexp_distance_op
-#include <raft/distance/detail/pairwise_matrix/params.cuh>  // pairwise_matrix_params
+#include <raft/distance/detail/distance_ops/all_ops.cuh>               // lp_unexp_distance_op
+#include <raft/distance/detail/pairwise_matrix/params.cuh>             // pairwise_matrix_params
+#include <raft/distance/detail/pairwise_matrix/tile_config_types.hpp>  // tile_config
 
 namespace raft::bench::distance::tune {
 
@@ -33,12 +34,17 @@ using FinOpT = raft::identity_op;
 using pairwise_matrix_params =
   raft::distance::detail::pairwise_matrix_params<IdxT, DataT, OutT, FinOpT>;
 
-// Launches kernel
-void launch_kernel(pairwise_matrix_params, dim3, cudaStream_t);
+using tile_config = raft::distance::detail::tile_config;
+
+// Launches kernel compiled for the tile configuration
+void launch_kernel(tile_config, pairwise_matrix_params, dim3, cudaStream_t);
 
 // Describes the block size that is decided by the policy
-void get_block_size(int& m, int& n, int& k);
+void get_block_size(tile_config, int& m, int& n, int& k);
+
+int get_max_occupancy(tile_config);
 
-int get_max_occupancy();
+// The grid that pairwise_matrix launches for the shape of params
+dim3 get_grid(tile_config, pairwise_matrix_params);
 
 }  // namespace raft::bench::distance::tune
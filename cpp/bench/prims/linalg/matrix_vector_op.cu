@@ -76,6 +76,16 @@ struct mat_vec_op : public fixture {
                                      stream);
       }
     });
+
+    // Estimate bandwidth: the matrix is read and written once, the vectors are read once.
+    int64_t vec_len     = params.bcastAlongRows ? params.cols : params.rows;
+    int64_t n_elems     = int64_t(params.rows) * int64_t(params.cols);
+    int64_t bytes_read  = n_elems * sizeof(T) + vec_len * sizeof(T) * (OpT::useTwoVectors ? 2 : 1);
+    int64_t bytes_write = n_elems * sizeof(T);
+    // one operation per matrix element and vector
+    int64_t flops = n_elems * (OpT::useTwoVectors ? 2 : 1);
+
+    report_roofline(state, bytes_read, bytes_write, flops, std::is_same_v<T, double>);
   }
 
  private:
@@ -127,6 +137,23 @@ std::vector<mat_vec_op_inputs<IdxT>> get_mv_inputs()
       }
     }
   }
+
+  // Very narrow and very wide matrices
+  std::vector<std::tuple<IdxT, IdxT>> extreme_rowcols = {
+    {67108864, 2},
+    {33554432, 4},
+    {16777216, 8},
+    {64, 1048576},
+    {16, 4194304},
+    {4, 10000000},
+  };
+  for (bool rowMajor : {true, false}) {
+    for (bool alongRows : {true, false}) {
+      for (auto rc : extreme_rowcols) {
+        out.push_back({std::get<0>(rc), std::get<1>(rc), rowMajor, alongRows, 0, 0});
+      }
+    }
+  }
   return out;
 }
 
@@ -39,6 +39,11 @@ struct reduce : public fixture {
       raft::linalg::reduce(
         out.data(), in.data(), input_size.cols, input_size.rows, T(0.f), true, along_rows, stream);
     });
+
+    int64_t n_elems = int64_t(input_size.rows) * int64_t(input_size.cols);
+    int64_t out_len = along_rows ? input_size.rows : input_size.cols;
+    report_roofline(
+      state, n_elems * sizeof(T), out_len * sizeof(T), n_elems, std::is_same_v<T, double>);
   }
 
  private:
@@ -25,8 +25,16 @@ namespace raft::bench::linalg {
 struct rrbk_params {
   int64_t rows, cols;
   int64_t keys;
+  raft::linalg::ReduceRowsByKeyAlgo algo = raft::linalg::ReduceRowsByKeyAlgo::AUTO;
 };
 
+inline auto operator<<(std::ostream& os, const rrbk_params& p) -> std::ostream&
+{
+  const char* algos[] = {"auto", "atomic", "shared_bins", "sorted"};
+  os << p.rows << "#" << p.cols << "#" << p.keys << "#" << algos[static_cast<int>(p.algo)];
+  return os;
+}
+
 template <typename T, typename KeyT>
 struct reduce_rows_by_key : public fixture {
   reduce_rows_by_key(const rrbk_params& p)
@@ -52,7 +60,8 @@ struct reduce_rows_by_key : public fixture {
                                        params.keys,
                                        out.data(),
                                        stream,
-                                       false);
+                                       false,
+                                       params.algo);
     });
   }
 
@@ -82,7 +91,22 @@ const std::vector<rrbk_params> kInputSizes{
   {10000000, 128, 4096},
 };
 
+// high-cardinality keys, as the per-list sums of the IVF builds
+const std::vector<rrbk_params> kManyKeysInputSizes{
+  {1000000, 16, 100, raft::linalg::ReduceRowsByKeyAlgo::ATOMIC},
+  {1000000, 16, 100, raft::linalg::ReduceRowsByKeyAlgo::SHARED_BINS},
+  {1000000, 16, 100, raft::linalg::ReduceRowsByKeyAlgo::SORTED},
+  {1000000, 128, 100000, raft::linalg::ReduceRowsByKeyAlgo::ATOMIC},
+  {1000000, 128, 100000, raft::linalg::ReduceRowsByKeyAlgo::SORTED},
+  {10000000, 128, 100000, raft::linalg::ReduceRowsByKeyAlgo::ATOMIC},
+  {10000000, 128, 100000, raft::linalg::ReduceRowsByKeyAlgo::SORTED},
+  {10000000, 32, 1000000, raft::linalg::ReduceRowsByKeyAlgo::ATOMIC},
+  {10000000, 32, 1000000, raft::linalg::ReduceRowsByKeyAlgo::SORTED},
+  {10000000, 32, 1000000, raft::linalg::ReduceRowsByKeyAlgo::AUTO},
+};
+
 RAFT_BENCH_REGISTER((reduce_rows_by_key<float, uint32_t>), "", kInputSizes);
 RAFT_BENCH_REGISTER((reduce_rows_by_key<double, uint32_t>), "", kInputSizes);
+RAFT_BENCH_REGISTER((reduce_rows_by_key<float, uint32_t>), "many_keys", kManyKeysInputSizes);
 
 }  // namespace raft::bench::linalg
@@ -14,6 +14,6 @@
  * limitations under the License.
  */
 
-#include <benchmark/benchmark.h>  // NOLINT
+#include <common/main.hpp>
 
-BENCHMARK_MAIN();
+int main(int argc, char** argv) { return raft::bench::run_main(argc, argv); }
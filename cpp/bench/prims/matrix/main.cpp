@@ -14,19 +14,28 @@
  * limitations under the License.
  */
 
+#include <common/main.hpp>
+
 #include <benchmark/benchmark.h>
 #include <cstring>
 
 namespace raft::matrix {
 void add_select_k_dataset_benchmarks();
+void add_select_k_dispatch_benchmarks();
 }
 
 int main(int argc, char** argv)
 {
-  // if we're passed a 'select_k_dataset' flag, add in extra benchmarks
+  // if we're passed a 'select_k_dataset' or 'select_k_dispatch' flag, add in extra benchmarks
   for (int i = 1; i < argc; ++i) {
-    if (strcmp(argv[i], "--select_k_dataset") == 0) {
-      raft::matrix::add_select_k_dataset_benchmarks();
+    bool dataset  = strcmp(argv[i], "--select_k_dataset") == 0;
+    bool dispatch = strcmp(argv[i], "--select_k_dispatch") == 0;
+    if (dataset || dispatch) {
+      if (dataset) {
+        raft::matrix::add_select_k_dataset_benchmarks();
+      } else {
+        raft::matrix::add_select_k_dispatch_benchmarks();
+      }
 
       // pop off the cmdline argument from argc/argv
       for (int j = i; j < argc - 1; ++j)
@@ -35,7 +44,5 @@ int main(int argc, char** argv)
       break;
     }
   }
-  benchmark::Initialize(&argc, argv);
-  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
-  benchmark::RunSpecifiedBenchmarks();
+  return raft::bench::run_main(argc, argv);
 }
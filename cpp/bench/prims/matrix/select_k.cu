@@ -23,6 +23,7 @@
 #include <raft/sparse/detail/utils.h>
 #include <raft/util/cudart_utils.hpp>
 
+#include <raft/matrix/detail/select_packed.cuh>
 #include <raft/matrix/detail/select_radix.cuh>
 #include <raft/matrix/detail/select_warpsort.cuh>
 #include <raft/matrix/select_k.cuh>
@@ -33,7 +34,9 @@
 
 #include <cstdint>
 #include <cstring>
+#include <random>
 #include <type_traits>
+#include <utility>
 
 namespace raft::matrix {
 using namespace raft::bench;  // NOLINT
@@ -88,6 +91,11 @@ struct selection : public fixture {
                                           out_ids_.data(),
                                           params_.select_min);
       });
+      size_t in_bytes  = sizeof(KeyT) + (params_.use_index_input ? sizeof(IdxT) : 0);
+      size_t out_bytes = sizeof(KeyT) + sizeof(IdxT);
+      report_roofline(state,
+                      double(in_bytes) * params_.batch_size * params_.len,
+                      double(out_bytes) * params_.batch_size * params_.k);
     } catch (raft::exception& e) {
       state.SkipWithError(e.what());
     }
@@ -99,6 +107,70 @@ struct selection : public fixture {
   rmm::device_uvector<IdxT> in_ids_, out_ids_;
 };
 
+/** Selection in the rows of different lengths (`select_k_segmented`). */
+template <typename KeyT, typename IdxT>
+struct segmented_selection : public fixture {
+  explicit segmented_selection(const select::params& p)
+    : fixture(p.use_memory_pool),
+      params_(p),
+      in_dists_(0, stream),
+      out_dists_(p.batch_size * p.k, stream),
+      row_offsets_(p.batch_size + 1, stream),
+      out_ids_(p.batch_size * p.k, stream)
+  {
+    // The row lengths are uniform in [len / 2, len].
+    std::default_random_engine rng(42);
+    std::uniform_int_distribution<size_t> row_len(p.len / 2, p.len);
+    std::vector<IdxT> offsets(p.batch_size + 1, 0);
+    for (size_t i = 0; i < p.batch_size; i++) {
+      offsets[i + 1] = offsets[i] + IdxT(row_len(rng));
+    }
+    raft::update_device(row_offsets_.data(), offsets.data(), offsets.size(), stream);
+    in_dists_.resize(offsets.back(), stream);
+    raft::random::RngState state{42};
+    raft::random::uniform(handle, state, in_dists_.data(), in_dists_.size(), KeyT(-1), KeyT(1));
+  }
+
+  void run_benchmark(::benchmark::State& state) override  // NOLINT
+  {
+    try {
+      std::ostringstream label_stream;
+      label_stream << params_.batch_size << "#" << params_.len << "#" << params_.k << "#ragged";
+      state.SetLabel(label_stream.str());
+      auto batch_size = int64_t(params_.batch_size);
+      auto n_values   = int64_t(in_dists_.size());
+      auto n_offsets  = int64_t(row_offsets_.size());
+      auto in_val     = raft::make_device_vector_view<const KeyT>(in_dists_.data(), n_values);
+      auto offsets    = raft::make_device_vector_view<const IdxT>(row_offsets_.data(), n_offsets);
+
+      auto out_val =
+        raft::make_device_matrix_view<KeyT, int64_t>(out_dists_.data(), batch_size, params_.k);
+      auto out_idx =
+        raft::make_device_matrix_view<IdxT, int64_t>(out_ids_.data(), batch_size, params_.k);
+      loop_on_state(state, [&]() {
+        raft::matrix::select_k_segmented<KeyT, IdxT>(handle,
+                                                     in_val,
+                                                     std::nullopt,
+                                                     offsets,
+                                                     int64_t(params_.len),
+                                                     out_val,
+                                                     out_idx,
+                                                     params_.select_min);
+      });
+      report_roofline(state,
+                      double(sizeof(KeyT)) * in_dists_.size() + sizeof(IdxT) * row_offsets_.size(),
+                      double(sizeof(KeyT) + sizeof(IdxT)) * params_.batch_size * params_.k);
+    } catch (raft::exception& e) {
+      state.SkipWithError(e.what());
+    }
+  }
+
+ private:
+  const select::params params_;
+  rmm::device_uvector<KeyT> in_dists_, out_dists_;
+  rmm::device_uvector<IdxT> row_offsets_, out_ids_;
+};
+
 const std::vector<select::params> kInputs{
   {20000, 500, 1, true},
   {20000, 500, 2, true},
@@ -149,6 +221,12 @@ const std::vector<select::params> kInputs{
   {10, 1000000, 64, true, false, true},
   {10, 1000000, 128, true, false, true},
   {10, 1000000, 256, true, false, true},
+
+  {10, 1000000, 1024, true},
+  {10, 1000000, 2048, true},
+  {10, 1000000, 4096, true},
+  {10, 1000000, 10000, true},
+  {10, 1000000, 100000, true},
 };
 
 #define SELECTION_REGISTER(KeyT, IdxT, A)                        \
@@ -166,6 +244,8 @@ SELECTION_REGISTER(float, uint32_t, kWarpImmediate);          // NOLINT
 SELECTION_REGISTER(float, uint32_t, kWarpFiltered);           // NOLINT
 SELECTION_REGISTER(float, uint32_t, kWarpDistributed);        // NOLINT
 SELECTION_REGISTER(float, uint32_t, kWarpDistributedShm);     // NOLINT
+SELECTION_REGISTER(float, uint32_t, kRadixLargeK);            // NOLINT
+SELECTION_REGISTER(float, uint32_t, kWarpPacked);             // NOLINT
 
 SELECTION_REGISTER(double, uint32_t, kRadix8bits);            // NOLINT
 SELECTION_REGISTER(double, uint32_t, kRadix11bits);           // NOLINT
@@ -180,6 +260,43 @@ SELECTION_REGISTER(double, int64_t, kWarpFiltered);           // NOLINT
 SELECTION_REGISTER(double, int64_t, kWarpDistributed);        // NOLINT
 SELECTION_REGISTER(double, int64_t, kWarpDistributedShm);     // NOLINT
 
+// k up to 2048: beyond the capacity of the warp-sort and faiss algorithms.
+const std::vector<select::params> kLargeKInputs{{1000, 100000, 512, true},
+                                                {1000, 100000, 1024, true},
+                                                {1000, 100000, 2048, true},
+                                                {100, 1000000, 512, true},
+                                                {100, 1000000, 1024, true},
+                                                {100, 1000000, 2048, true},
+                                                {10, 10000000, 2048, true}};
+
+#define SELECTION_REGISTER_LARGE_K(KeyT, IdxT, A)                                 \
+  namespace BENCHMARK_PRIVATE_NAME(selection) {                                   \
+  using SelectK = selection<KeyT, IdxT, select::Algo::A>;                         \
+  RAFT_BENCH_REGISTER(SelectK, #KeyT "/" #IdxT "/" #A "/large-k", kLargeKInputs); \
+  }
+
+SELECTION_REGISTER_LARGE_K(float, uint32_t, kPublicApi);             // NOLINT
+SELECTION_REGISTER_LARGE_K(float, uint32_t, kRadix11bits);           // NOLINT
+SELECTION_REGISTER_LARGE_K(float, uint32_t, kRadix11bitsExtraPass);  // NOLINT
+SELECTION_REGISTER_LARGE_K(float, uint32_t, kRadixLargeK);           // NOLINT
+SELECTION_REGISTER_LARGE_K(float, int64_t, kRadix11bits);            // NOLINT
+SELECTION_REGISTER_LARGE_K(float, int64_t, kRadixLargeK);            // NOLINT
+
+// Ragged rows (the lengths are uniform in [len / 2, len]), k up to 2048.
+const std::vector<select::params> kSegmentedInputs = []() {
+  std::vector<select::params> inputs;
+  for (auto [batch_size, len] : {std::pair<size_t, size_t>{10000, 4096}, {1000, 100000}}) {
+    for (int k : {1, 8, 64, 256, 512, 1024, 2048}) {
+      if (size_t(2 * k) <= len) { inputs.push_back({batch_size, len, k, true}); }
+    }
+  }
+  inputs.push_back({100, 1000000, 2048, true});
+  return inputs;
+}();
+
+RAFT_BENCH_REGISTER((segmented_selection<float, uint32_t>), "", kSegmentedInputs);
+RAFT_BENCH_REGISTER((segmented_selection<float, int64_t>), "", kSegmentedInputs);
+
 // For learning a heuristic of which selection algorithm to use, we
 // have a couple of additional constraints when generating the dataset:
 // 1. We want these benchmarks to be optionally enabled from the commandline -
@@ -211,11 +328,15 @@ const static size_t MAX_MEMORY = 16 * 1024 * 1024 * 1024ULL;
       SELECTION_REGISTER_ALGO_INPUT(KeyT, IdxT, kRadix8bits, input)            \
       SELECTION_REGISTER_ALGO_INPUT(KeyT, IdxT, kRadix11bits, input)           \
       SELECTION_REGISTER_ALGO_INPUT(KeyT, IdxT, kRadix11bitsExtraPass, input)  \
+      SELECTION_REGISTER_ALGO_INPUT(KeyT, IdxT, kRadixLargeK, input)           \
       if (input.k <= raft::matrix::detail::select::warpsort::kMaxCapacity) {   \
         SELECTION_REGISTER_ALGO_INPUT(KeyT, IdxT, kWarpImmediate, input)       \
         SELECTION_REGISTER_ALGO_INPUT(KeyT, IdxT, kWarpFiltered, input)        \
         SELECTION_REGISTER_ALGO_INPUT(KeyT, IdxT, kWarpDistributed, input)     \
         SELECTION_REGISTER_ALGO_INPUT(KeyT, IdxT, kWarpDistributedShm, input)  \
+        if (raft::matrix::detail::select::packed::kPackableKey<KeyT>) {        \
+          SELECTION_REGISTER_ALGO_INPUT(KeyT, IdxT, kWarpPacked, input)        \
+        }                                                                      \
       }                                                                        \
       if (input.k <= raft::neighbors::detail::kFaissMaxK<IdxT, KeyT>()) {      \
         SELECTION_REGISTER_ALGO_INPUT(KeyT, IdxT, kFaissBlockSelect, input)    \
@@ -277,4 +398,41 @@ void add_select_k_dataset_benchmarks()
     SELECTION_REGISTER_INPUT(float, uint32_t, input);
   }
 }
+
+// A reduced version of the dataset above for building the per-architecture dispatch tables (see
+// cpp/scripts/heuristics/select_k/generate_dispatch_table.py): only the algorithms the dispatch
+// can choose from, on a power-of-two grid of the problem sizes.
+#define SELECTION_REGISTER_DISPATCH_INPUT(KeyT, IdxT, input)                   \
+  {                                                                            \
+    size_t mem = input.batch_size * input.len * (sizeof(KeyT) + sizeof(IdxT)); \
+    if (mem < MAX_MEMORY) {                                                    \
+      SELECTION_REGISTER_ALGO_INPUT(KeyT, IdxT, kRadix11bits, input)           \
+      SELECTION_REGISTER_ALGO_INPUT(KeyT, IdxT, kRadixLargeK, input)           \
+      if (input.k <= raft::matrix::detail::select::warpsort::kMaxCapacity) {   \
+        SELECTION_REGISTER_ALGO_INPUT(KeyT, IdxT, kWarpDistributedShm, input)  \
+        if (raft::matrix::detail::select::packed::kPackableKey<KeyT>) {        \
+          SELECTION_REGISTER_ALGO_INPUT(KeyT, IdxT, kWarpPacked, input)        \
+        }                                                                      \
+      }                                                                        \
+      if (input.k <= raft::neighbors::detail::kFaissMaxK<IdxT, KeyT>()) {      \
+        SELECTION_REGISTER_ALGO_INPUT(KeyT, IdxT, kFaissBlockSelect, input)    \
+      }                                                                        \
+    }                                                                          \
+  }
+
+void add_select_k_dispatch_benchmarks()
+{
+  const static bool select_min = true;
+  const static bool use_ids    = false;
+
+  for (size_t row = 0; row <= 12; row += 2) {
+    for (size_t col = 10; col <= 26; col += 2) {
+      for (size_t k = 0; k <= 14 && k <= col; k++) {
+        auto input =
+          select::params{size_t(1) << row, size_t(1) << col, 1 << k, select_min, use_ids};
+        SELECTION_REGISTER_DISPATCH_INPUT(float, uint32_t, input);
+      }
+    }
+  }
+}
 }  // namespace raft::matrix
@@ -0,0 +1,345 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <common/benchmark.hpp>
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/device_resources.hpp>
+#include <raft/linalg/init.cuh>
+#include <raft/neighbors/ivf_flat.cuh>
+#include <raft/neighbors/ivf_pq.cuh>
+#include <raft/random/rng.cuh>
+
+#include <rmm/device_uvector.hpp>
+#include <rmm/mr/device/per_device_resource.hpp>
+#include <rmm/mr/device/statistics_resource_adaptor.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <shared_mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace raft::bench::neighbors {
+
+struct extend_params {
+  /** Number of rows in the index before the streaming starts. */
+  size_t n_initial;
+  /** Number of dimensions in the dataset. */
+  size_t n_dims;
+  /** Number of rows inserted during the streaming. */
+  size_t n_extend;
+  /** Number of rows inserted by one `extend` call. */
+  size_t batch_size;
+  /** The target insert rate [rows/s]; zero means as fast as possible. */
+  double insert_rate;
+  /** Number of queries in one search. */
+  size_t n_queries;
+  /** Number of nearest neighbours to find for every query. */
+  size_t k;
+  /** Number of threads running the searches concurrently with the inserts. */
+  int n_search_threads;
+};
+
+inline auto operator<<(std::ostream& os, const extend_params& p) -> std::ostream&
+{
+  os << p.n_initial << "#" << p.n_dims << "#" << p.n_extend << "#" << p.batch_size << "#"
+     << p.insert_rate << "#" << p.n_queries << "#" << p.k << "#" << p.n_search_threads;
+  return os;
+}
+
+template <typename ValT, typename IdxT>
+struct ivf_flat_extend {
+  std::optional<raft::neighbors::ivf_flat::index<ValT, IdxT>> index;
+  raft::neighbors::ivf_flat::index_params index_params;
+  raft::neighbors::ivf_flat::search_params search_params;
+
+  ivf_flat_extend()
+  {
+    index_params.n_lists   = 1024;
+    index_params.metric    = raft::distance::DistanceType::L2Expanded;
+    search_params.n_probes = 20;
+  }
+
+  void build(const raft::device_resources& handle, const ValT* data, IdxT n_rows, uint32_t dim)
+  {
+    index.emplace(raft::neighbors::ivf_flat::build(handle, index_params, data, n_rows, dim));
+  }
+
+  void extend(const raft::device_resources& handle,
+              const ValT* data,
+              const IdxT* indices,
+              IdxT n_rows)
+  {
+    raft::neighbors::ivf_flat::extend(handle, &*index, data, indices, n_rows);
+  }
+
+  void search(const raft::device_resources& handle,
+              const ValT* queries,
+              uint32_t n_queries,
+              uint32_t k,
+              IdxT* out_idxs,
+              float* out_dists)
+  {
+    raft::neighbors::ivf_flat::search(
+      handle, search_params, *index, queries, n_queries, k, out_idxs, out_dists);
+  }
+};
+
+template <typename ValT, typename IdxT>
+struct ivf_pq_extend {
+  std::optional<raft::neighbors::ivf_pq::index<IdxT>> index;
+  raft::neighbors::ivf_pq::index_params index_params;
+  raft::neighbors::ivf_pq::search_params search_params;
+
+  ivf_pq_extend()
+  {
+    index_params.n_lists   = 1024;
+    index_params.metric    = raft::distance::DistanceType::L2Expanded;
+    search_params.n_probes = 20;
+  }
+
+  void build(const raft::device_resources& handle, const ValT* data, IdxT n_rows, uint32_t dim)
+  {
+    auto data_view = raft::make_device_matrix_view<const ValT, IdxT>(data, n_rows, dim);
+    index.emplace(raft::neighbors::ivf_pq::build(handle, index_params, data_view));
+  }
+
+  void extend(const raft::device_resources& handle,
+              const ValT* data,
+              const IdxT* indices,
+              IdxT n_rows)
+  {
+    auto data_view = raft::make_device_matrix_view<const ValT, IdxT>(data, n_rows, index->dim());
+    auto idxs_view = raft::make_device_vector_view<const IdxT, IdxT>(indices, n_rows);
+    raft::neighbors::ivf_pq::extend(handle, data_view, std::make_optional(idxs_view), &*index);
+  }
+
+  void search(const raft::device_resources& handle,
+              const ValT* queries,
+              uint32_t n_queries,
+              uint32_t k,
+              IdxT* out_idxs,
+              float* out_dists)
+  {
+    auto queries_view =
+      raft::make_device_matrix_view<const ValT, uint32_t>(queries, n_queries, index->dim());
+    auto idxs_view  = raft::make_device_matrix_view<IdxT, uint32_t>(out_idxs, n_queries, k);
+    auto dists_view = raft::make_device_matrix_view<float, uint32_t>(out_dists, n_queries, k);
+    raft::neighbors::ivf_pq::search(
+      handle, search_params, *index, queries_view, idxs_view, dists_view);
+  }
+};
+
+/**
+ * Streaming ingestion: the rows are inserted into an IVF index in batches at a given rate, while
+ * a few threads keep searching the index.
+ *
+ * `extend` modifies the index in place, hence it holds an exclusive lock, while the searches share
+ * the lock. The searches thus see both the GPU contention and the blocking by the inserts.
+ *
+ * Every iteration builds the index from the initial rows, measures the search latency without the
+ * inserts (the baseline), and then streams all the rows; the time of an iteration is the time of
+ * the streaming. The counters:
+ *   - insert throughput [rows/s];
+ *   - p50 / p99 search latency, without and with the concurrent inserts [ms];
+ *   - the size of the index after the build and its growth by the streaming [bytes] (the
+ *     allocations through the current device memory resource).
+ */
+template <typename ValT, typename IdxT, typename ImplT>
+class extend_bench : public fixture {
+ public:
+  explicit extend_bench(const extend_params& p)
+    : fixture(true),
+      params_(p),
+      data_((p.n_initial + p.n_extend) * p.n_dims, stream),
+      new_indices_(p.n_extend, stream),
+      queries_(p.n_search_threads * p.n_queries * p.n_dims, stream)
+  {
+    raft::random::RngState state{42};
+    raft::random::uniform(state, data_.data(), data_.size(), ValT(-1), ValT(1), stream);
+    raft::random::uniform(state, queries_.data(), queries_.size(), ValT(-1), ValT(1), stream);
+    raft::linalg::range(
+      new_indices_.data(), int(p.n_initial), int(p.n_initial + p.n_extend), stream);
+  }
+
+  void run_benchmark(::benchmark::State& state) override
+  {
+    std::ostringstream label_stream;
+    label_stream << params_;
+    state.SetLabel(label_stream.str());
+
+    std::vector<double> base_latencies;
+    std::vector<double> latencies;
+    double insert_time  = 0;
+    double index_bytes  = 0;
+    double growth_bytes = 0;
+    try {
+      for (auto _ : state) {
+        stream.synchronize();
+        rmm::mr::statistics_resource_adaptor<rmm::mr::device_memory_resource> stats(
+          rmm::mr::get_current_device_resource());
+        current_resource_guard guard(&stats);
+        {
+          ImplT impl;
+          impl.build(handle, data_.data(), IdxT(params_.n_initial), uint32_t(params_.n_dims));
+          stream.synchronize();
+          auto bytes_before = stats.get_bytes_counter().value;
+
+          auto base = run_searches(impl, [](size_t i) { return i < kBaselineSearches; });
+          base_latencies.insert(base_latencies.end(), base.begin(), base.end());
+
+          std::atomic<bool> done{false};
+          std::vector<double> lat;
+          std::thread searches([&]() {
+            lat = run_searches(impl, [&done](size_t) { return !done.load(); });
+          });
+          auto start = std::chrono::steady_clock::now();
+          for (size_t offset = 0; offset < params_.n_extend; offset += params_.batch_size) {
+            if (params_.insert_rate > 0) {
+              std::this_thread::sleep_until(
+                start + std::chrono::duration<double>(offset / params_.insert_rate));
+            }
+            auto n_rows = std::min(params_.batch_size, params_.n_extend - offset);
+            std::unique_lock<std::shared_mutex> lock(mutex_);
+            impl.extend(handle,
+                        data_.data() + (params_.n_initial + offset) * params_.n_dims,
+                        new_indices_.data() + offset,
+                        IdxT(n_rows));
+            stream.synchronize();
+          }
+          double elapsed =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+          done = true;
+          searches.join();
+          latencies.insert(latencies.end(), lat.begin(), lat.end());
+          state.SetIterationTime(elapsed);
+          insert_time += elapsed;
+          index_bytes = stats.get_bytes_counter().value;
+          growth_bytes += index_bytes - bytes_before;
+        }
+      }
+    } catch (raft::exception& e) {
+      state.SkipWithError(e.what());
+      return;
+    } catch (std::bad_alloc& e) {
+      state.SkipWithError(e.what());
+      return;
+    }
+
+    double n_iters                 = double(state.iterations());
+    state.counters["rows/s"]       = params_.n_extend * n_iters / insert_time;
+    state.counters["p50 base ms"]  = percentile(base_latencies, 0.5);
+    state.counters["p99 base ms"]  = percentile(base_latencies, 0.99);
+    state.counters["p50 ms"]       = percentile(latencies, 0.5);
+    state.counters["p99 ms"]       = percentile(latencies, 0.99);
+    state.counters["index bytes"]  = index_bytes;
+    state.counters["growth bytes"] = growth_bytes / n_iters;
+  }
+
+ private:
+  static constexpr size_t kBaselineSearches = 100;
+
+  /** Sets the current device memory resource for its lifetime. */
+  struct current_resource_guard {
+    explicit current_resource_guard(rmm::mr::device_memory_resource* mr)
+      : orig_(rmm::mr::get_current_device_resource())
+    {
+      rmm::mr::set_current_device_resource(mr);
+    }
+    ~current_resource_guard() { rmm::mr::set_current_device_resource(orig_); }
+
+   private:
+    rmm::mr::device_memory_resource* orig_;
+  };
+
+  /**
+   * Run the searches in `n_search_threads` threads, each with its own stream, while
+   * `go_on(number of the searches done by the thread)` holds, and return their latencies [ms].
+   */
+  template <typename GoOnT>
+  auto run_searches(ImplT& impl, GoOnT go_on) -> std::vector<double>
+  {
+    std::vector<std::vector<double>> thread_latencies(params_.n_search_threads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < params_.n_search_threads; t++) {
+      threads.emplace_back([&, t]() {
+        rmm::cuda_stream thread_stream;
+        raft::device_resources thread_handle(thread_stream.view());
+        rmm::device_uvector<IdxT> out_idxs(params_.n_queries * params_.k, thread_stream.view());
+        rmm::device_uvector<float> out_dists(params_.n_queries * params_.k, thread_stream.view());
+        const ValT* queries = queries_.data() + t * params_.n_queries * params_.n_dims;
+        auto& lat           = thread_latencies[t];
+        while (go_on(lat.size())) {
+          auto start = std::chrono::steady_clock::now();
+          std::shared_lock<std::shared_mutex> lock(mutex_);
+          impl.search(thread_handle,
+                      queries,
+                      uint32_t(params_.n_queries),
+                      uint32_t(params_.k),
+                      out_idxs.data(),
+                      out_dists.data());
+          thread_stream.synchronize();
+          lock.unlock();
+          lat.push_back(
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+              .count());
+        }
+      });
+    }
+    std::vector<double> latencies;
+    for (int t = 0; t < params_.n_search_threads; t++) {
+      threads[t].join();
+      latencies.insert(latencies.end(), thread_latencies[t].begin(), thread_latencies[t].end());
+    }
+    return latencies;
+  }
+
+  static auto percentile(std::vector<double>& values, double q) -> double
+  {
+    if (values.empty()) { return 0; }
+    auto nth = values.begin() + std::min(values.size() - 1, size_t(q * values.size()));
+    std::nth_element(values.begin(), nth, values.end());
+    return *nth;
+  }
+
+  const extend_params params_;
+  std::shared_mutex mutex_;
+  rmm::device_uvector<ValT> data_;
+  rmm::device_uvector<IdxT> new_indices_;
+  rmm::device_uvector<ValT> queries_;
+};
+
+inline const std::vector<extend_params> kExtendInputs{
+  // unlimited insert rate: the insert throughput
+  {1000000, 128, 1000000, 10000, 0, 10, 10, 4},
+  {1000000, 128, 1000000, 100000, 0, 10, 10, 4},
+  // a fixed insert rate: the search latency under a steady ingestion
+  {1000000, 128, 500000, 1000, 100000, 10, 10, 4},
+  {1000000, 128, 500000, 10000, 100000, 10, 10, 4}};
+
+#define EXTEND_REGISTER(ValT, IdxT, ImplT, inputs)                 \
+  namespace BENCHMARK_PRIVATE_NAME(extend) {                       \
+  using EXTEND = extend_bench<ValT, IdxT, ImplT<ValT, IdxT>>;      \
+  RAFT_BENCH_REGISTER(EXTEND, #ValT "/" #IdxT "/" #ImplT, inputs); \
+  }
+
+}  // namespace raft::bench::neighbors
@@ -21,6 +21,7 @@
 
 #include <raft/random/rng.cuh>
 
+#include <raft/neighbors/cagra.cuh>
 #include <raft/neighbors/ivf_flat.cuh>
 #include <raft/neighbors/ivf_pq.cuh>
 #include <raft/spatial/knn/knn.cuh>
@@ -31,6 +32,7 @@
 #include <rmm/mr/host/new_delete_resource.hpp>
 #include <rmm/mr/host/pinned_memory_resource.hpp>
 
+#include <algorithm>
 #include <optional>
 
 namespace raft::bench::spatial {
@@ -190,6 +192,50 @@ struct ivf_pq_knn {
   }
 };
 
+template <typename ValT,
+          typename IdxT,
+          raft::neighbors::experimental::cagra::search_algo Algo =
+            raft::neighbors::experimental::cagra::search_algo::AUTO>
+struct cagra_knn {
+  using dist_t = float;
+
+  std::optional<const raft::neighbors::experimental::cagra::index<ValT, IdxT>> index;
+  raft::neighbors::experimental::cagra::index_params index_params;
+  raft::neighbors::experimental::cagra::search_params search_params;
+  params ps;
+
+  cagra_knn(const raft::device_resources& handle, const params& ps, const ValT* data) : ps(ps)
+  {
+    auto data_view = raft::make_device_matrix_view<const ValT, IdxT>(data, ps.n_samples, ps.n_dims);
+    index.emplace(raft::neighbors::experimental::cagra::build(handle, index_params, data_view));
+  }
+
+  void search(const raft::device_resources& handle,
+              const ValT* search_items,
+              dist_t* out_dists,
+              IdxT* out_idxs)
+  {
+    search_params.algo       = Algo;
+    search_params.itopk_size = std::max<size_t>(search_params.itopk_size, ps.k);
+    auto queries_view =
+      raft::make_device_matrix_view<const ValT, IdxT>(search_items, ps.n_queries, ps.n_dims);
+    auto idxs_view  = raft::make_device_matrix_view<IdxT, IdxT>(out_idxs, ps.n_queries, ps.k);
+    auto dists_view = raft::make_device_matrix_view<dist_t, IdxT>(out_dists, ps.n_queries, ps.k);
+    raft::neighbors::experimental::cagra::search(
+      handle, search_params, *index, queries_view, idxs_view, dists_view);
+  }
+};
+
+template <typename ValT, typename IdxT>
+using cagra_single_cta_knn =
+  cagra_knn<ValT, IdxT, raft::neighbors::experimental::cagra::search_algo::SINGLE_CTA>;
+template <typename ValT, typename IdxT>
+using cagra_multi_cta_knn =
+  cagra_knn<ValT, IdxT, raft::neighbors::experimental::cagra::search_algo::MULTI_CTA>;
+template <typename ValT, typename IdxT>
+using cagra_multi_kernel_knn =
+  cagra_knn<ValT, IdxT, raft::neighbors::experimental::cagra::search_algo::MULTI_KERNEL>;
+
 template <typename ValT, typename IdxT>
 struct brute_force_knn {
   using dist_t = ValT;
@@ -385,6 +431,7 @@ inline const std::vector<TransferStrategy> kAllStrategies{
 inline const std::vector<TransferStrategy> kNoCopyOnly{TransferStrategy::NO_COPY};
 
 inline const std::vector<Scope> kScopeFull{Scope::BUILD_SEARCH};
+inline const std::vector<Scope> kScopeSearch{Scope::SEARCH};
 inline const std::vector<Scope> kAllScopes{Scope::BUILD_SEARCH, Scope::SEARCH, Scope::BUILD};
 
 #define KNN_REGISTER(ValT, IdxT, ImplT, inputs, strats, scope)                 \
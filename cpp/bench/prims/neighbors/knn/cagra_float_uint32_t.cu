@@ -0,0 +1,29 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../knn.cuh"
+
+namespace raft::bench::spatial {
+
+// The index is built once per case; the batch sizes cover both the single- and multi-CTA regimes.
+const std::vector<params> kCagraInputs{
+  {1000000, 128, 1, 32}, {1000000, 128, 100, 32}, {1000000, 128, 10000, 32}};
+
+KNN_REGISTER(float, uint32_t, cagra_single_cta_knn, kCagraInputs, kNoCopyOnly, kScopeSearch);
+KNN_REGISTER(float, uint32_t, cagra_multi_cta_knn, kCagraInputs, kNoCopyOnly, kScopeSearch);
+KNN_REGISTER(float, uint32_t, cagra_multi_kernel_knn, kCagraInputs, kNoCopyOnly, kScopeSearch);
+
+}  // namespace raft::bench::spatial
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <common/benchmark.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/sparse/neighbors/brute_force.cuh>
+#include <raft/util/cudart_utils.hpp>
+#include <rmm/device_uvector.hpp>
+
+#include <algorithm>
+#include <random>
+#include <sstream>
+#include <vector>
+
+namespace raft::bench::sparse {
+
+struct knn_params {
+  int n_index_rows;
+  int n_query_rows;
+  int n_cols;
+  /** The average number of non-zeros in a row; the row lengths are uniform in [nnz/2, 3nnz/2]. */
+  int row_nnz;
+  int k;
+  raft::distance::DistanceType metric;
+};
+
+inline auto operator<<(std::ostream& os, const knn_params& p) -> std::ostream&
+{
+  os << p.n_index_rows << "#" << p.n_query_rows << "#" << p.n_cols << "#" << p.row_nnz << "#"
+     << p.k << "#" << static_cast<int>(p.metric);
+  return os;
+}
+
+/** A random CSR matrix on the device, with sorted and unique column indices in every row. */
+template <typename value_idx, typename value_t>
+struct csr_matrix {
+  rmm::device_uvector<value_idx> indptr, indices;
+  rmm::device_uvector<value_t> data;
+
+  csr_matrix(int n_rows, int n_cols, int row_nnz, uint64_t seed, rmm::cuda_stream_view stream)
+    : indptr(n_rows + 1, stream), indices(0, stream), data(0, stream)
+  {
+    std::default_random_engine rng(seed);
+    std::uniform_int_distribution<int> row_len(std::max(1, row_nnz / 2), row_nnz * 3 / 2);
+    std::uniform_real_distribution<value_t> value(0, 1);
+    std::vector<value_idx> h_indptr(n_rows + 1, 0), h_indices;
+    std::vector<value_t> h_data;
+    for (int i = 0; i < n_rows; i++) {
+      // one column in each of the `len` strides of the row
+      int len    = std::min(row_len(rng), n_cols);
+      int stride = n_cols / len;
+      for (int j = 0; j < len; j++) {
+        h_indices.push_back(j * stride + std::uniform_int_distribution<int>(0, stride - 1)(rng));
+        h_data.push_back(value(rng));
+      }
+      h_indptr[i + 1] = h_indices.size();
+    }
+    indices.resize(h_indices.size(), stream);
+    data.resize(h_data.size(), stream);
+    raft::update_device(indptr.data(), h_indptr.data(), h_indptr.size(), stream);
+    raft::update_device(indices.data(), h_indices.data(), h_indices.size(), stream);
+    raft::update_device(data.data(), h_data.data(), h_data.size(), stream);
+    stream.synchronize();
+  }
+};
+
+template <typename value_idx, typename value_t>
+struct knn : public fixture {
+  explicit knn(const knn_params& p)
+    : params(p),
+      index(p.n_index_rows, p.n_cols, p.row_nnz, 42, stream),
+      queries(p.n_query_rows, p.n_cols, p.row_nnz, 137, stream),
+      out_indices(size_t(p.n_query_rows) * p.k, stream),
+      out_dists(size_t(p.n_query_rows) * p.k, stream)
+  {
+  }
+
+  void run_benchmark(::benchmark::State& state) override
+  {
+    std::ostringstream label_stream;
+    label_stream << params;
+    state.SetLabel(label_stream.str());
+
+    try {
+      loop_on_state(state, [this]() {
+        raft::sparse::neighbors::brute_force::knn<value_idx, value_t>(index.indptr.data(),
+                                                                      index.indices.data(),
+                                                                      index.data.data(),
+                                                                      index.data.size(),
+                                                                      params.n_index_rows,
+                                                                      params.n_cols,
+                                                                      queries.indptr.data(),
+                                                                      queries.indices.data(),
+                                                                      queries.data.data(),
+                                                                      queries.data.size(),
+                                                                      params.n_query_rows,
+                                                                      params.n_cols,
+                                                                      out_indices.data(),
+                                                                      out_dists.data(),
+                                                                      params.k,
+                                                                      handle,
+                                                                      2 << 14,
+                                                                      2 << 14,
+                                                                      params.metric);
+      });
+    } catch (raft::exception& e) {
+      state.SkipWithError(e.what());
+    }
+
+    state.counters["index nnz"] = benchmark::Counter(index.data.size());
+    state.counters["query nnz"] = benchmark::Counter(queries.data.size());
+  }
+
+ private:
+  knn_params params;
+  csr_matrix<value_idx, value_t> index, queries;
+  rmm::device_uvector<value_idx> out_indices;
+  rmm::device_uvector<value_t> out_dists;
+};  // struct knn
+
+// Shapes of the bag-of-words / TF-IDF data: a large vocabulary with ~0.1% of it in a document.
+const std::vector<knn_params> knn_inputs{
+  {100000, 1000, 100000, 100, 10, raft::distance::DistanceType::L2Expanded},
+  {100000, 1000, 100000, 100, 10, raft::distance::DistanceType::CosineExpanded},
+  {100000, 1000, 100000, 100, 10, raft::distance::DistanceType::InnerProduct},
+  {100000, 1000, 100000, 100, 10, raft::distance::DistanceType::JaccardExpanded},
+  {100000, 1000, 100000, 100, 64, raft::distance::DistanceType::L2Expanded},
+  {1000000, 1000, 1000000, 50, 10, raft::distance::DistanceType::CosineExpanded},
+  {100000, 10000, 20000, 500, 10, raft::distance::DistanceType::L2Expanded},
+  {10000, 10000, 1000000, 20, 10, raft::distance::DistanceType::InnerProduct}};
+
+RAFT_BENCH_REGISTER((knn<int, float>), "", knn_inputs);
+
+}  // namespace raft::bench::sparse
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <common/benchmark.hpp>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/fast_int_div.cuh>
+
+#include <rmm/device_uvector.hpp>
+
+#include <sstream>
+#include <type_traits>
+
+namespace raft::bench::util {
+
+struct fast_int_div_inputs {
+  int n_threads;
+  int n_iters;
+  uint64_t divisor;
+};  // struct fast_int_div_inputs
+
+inline auto operator<<(std::ostream& os, const fast_int_div_inputs& p) -> std::ostream&
+{
+  os << p.n_threads << "#" << p.n_iters << "#" << p.divisor;
+  return os;
+}
+
+/** Every thread divides a sequence of pseudo-random numerators by the same divisor. */
+template <typename T, typename DivT>
+__global__ void divide_kernel(T* out, int n_threads, int n_iters, DivT divisor)
+{
+  int i = threadIdx.x + blockIdx.x * blockDim.x;
+  if (i >= n_threads) { return; }
+  T x   = T(i) * T(2654435761u) + T(1);
+  T acc = 0;
+  for (int k = 0; k < n_iters; k++) {
+    x = x * T(1664525u) + T(1013904223u);
+    acc += x / divisor;
+    acc ^= x % divisor;
+  }
+  out[i] = acc;
+}
+
+/**
+ * Compare the division and modulo by a divisor known at runtime only: the native operators
+ * (`Fast = false`) against `raft::util::FastUIntDiv` (`Fast = true`).
+ */
+template <typename T, bool Fast>
+struct fast_int_div : public fixture {
+  explicit fast_int_div(const fast_int_div_inputs& p) : params(p), out(p.n_threads, stream) {}
+
+  void run_benchmark(::benchmark::State& state) override
+  {
+    std::ostringstream label_stream;
+    label_stream << params;
+    state.SetLabel(label_stream.str());
+    using divisor_t = std::conditional_t<Fast, raft::util::FastUIntDiv<T>, T>;
+    divisor_t divisor(T(params.divisor));
+    loop_on_state(state, [this, divisor]() {
+      divide_kernel<T, divisor_t><<<raft::ceildiv(params.n_threads, 256), 256, 0, stream>>>(
+        out.data(), params.n_threads, params.n_iters, divisor);
+    });
+    // a division and a modulo per iteration of every thread
+    state.counters["ops/s"] = benchmark::Counter(double(params.n_threads) * params.n_iters * 2,
+                                                 benchmark::Counter::kIsIterationInvariantRate);
+  }
+
+ private:
+  fast_int_div_inputs params;
+  rmm::device_uvector<T> out;
+};  // struct fast_int_div
+
+const std::vector<fast_int_div_inputs> fast_int_div_input_vecs{
+  {1024 * 1024, 256, 7}, {1024 * 1024, 256, 96}, {1024 * 1024, 256, 1000003}};
+
+RAFT_BENCH_REGISTER((fast_int_div<uint32_t, false>), "", fast_int_div_input_vecs);
+RAFT_BENCH_REGISTER((fast_int_div<uint32_t, true>), "", fast_int_div_input_vecs);
+RAFT_BENCH_REGISTER((fast_int_div<uint64_t, false>), "", fast_int_div_input_vecs);
+RAFT_BENCH_REGISTER((fast_int_div<uint64_t, true>), "", fast_int_div_input_vecs);
+
+}  // namespace raft::bench::util
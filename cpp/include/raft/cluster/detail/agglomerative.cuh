@@ -21,6 +21,7 @@
 #include <raft/core/resources.hpp>
 #include <raft/util/cuda_utils.cuh>
 #include <raft/util/cudart_utils.hpp>
+#include <raft/util/device_atomics.cuh>
 
 #include <rmm/device_uvector.hpp>
 
@@ -32,6 +33,8 @@
 #include <thrust/functional.h>
 #include <thrust/iterator/counting_iterator.h>
 #include <thrust/iterator/zip_iterator.h>
+#include <thrust/remove.h>
+#include <thrust/sequence.h>
 #include <thrust/sort.h>
 #include <thrust/tuple.h>
 
@@ -80,15 +83,8 @@ class UnionFind {
 };
 
 /**
- * Agglomerative labeling on host. This has not been found to be a bottleneck
- * in the algorithm. A parallel version of this can be done using a parallel
- * variant of Kruskal's MST algorithm
- * (ref http://cucis.ece.northwestern.edu/publications/pdf/HenPat12.pdf),
- * which breaks apart the sorted MST results into overlapping subsets and
- * independently runs Kruskal's algorithm on each subset, merging them back
- * together into a single hierarchy when complete. Unfortunately,
- * this is nontrivial and the speedup wouldn't be useful until this
- * becomes a bottleneck.
+ * Agglomerative labeling on host. This is the reference for `build_dendrogram_device`, which
+ * produces the same output without copying the MST to the host.
  *
  * @tparam value_idx
  * @tparam value_t
@@ -154,6 +150,260 @@ void build_dendrogram_host(raft::resources const& handle,
   raft::update_device(out_delta, out_delta_h.data(), n_edges, stream);
 }
 
+/**
+ * The device dendrogram falls back to a sequential Kruskal pass once a round contracts less than
+ * 1 / kDendrogramMinContraction of the remaining edges (e.g. for the chains or the stars, where
+ * only a few edges are local minima at a time).
+ */
+constexpr int kDendrogramMinContraction = 32;
+
+template <typename value_idx>
+__global__ void reset_min_edge_kernel(const value_idx* edges,
+                                      value_idx n_edges,
+                                      const value_idx* src,
+                                      const value_idx* dst,
+                                      value_idx* min_edge,
+                                      value_idx sentinel)
+{
+  value_idx tid = blockDim.x * blockIdx.x + threadIdx.x;
+  if (tid < n_edges) {
+    value_idx e      = edges[tid];
+    min_edge[src[e]] = sentinel;
+    min_edge[dst[e]] = sentinel;
+  }
+}
+
+template <typename value_idx>
+__global__ void min_incident_edge_kernel(const value_idx* edges,
+                                         value_idx n_edges,
+                                         const value_idx* src,
+                                         const value_idx* dst,
+                                         value_idx* min_edge)
+{
+  value_idx tid = blockDim.x * blockIdx.x + threadIdx.x;
+  if (tid < n_edges) {
+    value_idx e = edges[tid];
+    atomicMin(min_edge + src[e], e);
+    atomicMin(min_edge + dst[e], e);
+  }
+}
+
+/**
+ * Merges the two clusters of every remaining edge that is the smallest edge at both of its
+ * endpoints. All the smaller edges touching these clusters have been merged already and all the
+ * other edges touching them are larger, so the clusters are exactly those Kruskal's algorithm
+ * would merge for this edge. Two such edges never share an endpoint, so each cluster is updated by
+ * at most one thread.
+ */
+template <typename value_idx, typename value_t>
+__global__ void contract_min_edges_kernel(const value_idx* edges,
+                                          value_idx n_edges,
+                                          const value_idx* src,
+                                          const value_idx* dst,
+                                          const value_idx* min_edge,
+                                          const value_t* data,
+                                          value_idx n_leaves,
+                                          value_idx* parent,
+                                          value_idx* node,
+                                          value_idx* size,
+                                          value_idx* children,
+                                          value_t* out_delta,
+                                          value_idx* out_size,
+                                          value_idx* done)
+{
+  value_idx tid = blockDim.x * blockIdx.x + threadIdx.x;
+  if (tid >= n_edges) return;
+  value_idx e = edges[tid];
+  value_idx a = src[e];
+  value_idx b = dst[e];
+  if (min_edge[a] != e || min_edge[b] != e) return;
+
+  children[2 * e]     = node[a];
+  children[2 * e + 1] = node[b];
+  out_delta[e]        = data[e];
+  out_size[e]         = size[a] + size[b];
+
+  size[a]   = out_size[e];
+  node[a]   = n_leaves + e;
+  parent[b] = a;
+  done[tid] = 1;
+}
+
+/** Points the endpoints of the remaining edges to the roots of their merged clusters. */
+template <typename value_idx>
+__global__ void relabel_edges_kernel(const value_idx* edges,
+                                     value_idx n_edges,
+                                     value_idx* src,
+                                     value_idx* dst,
+                                     const value_idx* parent)
+{
+  value_idx tid = blockDim.x * blockIdx.x + threadIdx.x;
+  if (tid < n_edges) {
+    value_idx e = edges[tid];
+    src[e]      = parent[src[e]];
+    dst[e]      = parent[dst[e]];
+  }
+}
+
+template <typename value_idx>
+__device__ value_idx find_root(value_idx* parent, value_idx v)
+{
+  while (parent[v] != v) {
+    parent[v] = parent[parent[v]];
+    v         = parent[v];
+  }
+  return v;
+}
+
+/** Kruskal's algorithm over the remaining (sorted) edges in a single thread. */
+template <typename value_idx, typename value_t>
+__global__ void merge_remaining_edges_kernel(const value_idx* edges,
+                                             value_idx n_edges,
+                                             const value_idx* src,
+                                             const value_idx* dst,
+                                             const value_t* data,
+                                             value_idx n_leaves,
+                                             value_idx* parent,
+                                             value_idx* node,
+                                             value_idx* size,
+                                             value_idx* children,
+                                             value_t* out_delta,
+                                             value_idx* out_size)
+{
+  for (value_idx i = 0; i < n_edges; i++) {
+    value_idx e = edges[i];
+    value_idx a = find_root(parent, src[e]);
+    value_idx b = find_root(parent, dst[e]);
+
+    children[2 * e]     = node[a];
+    children[2 * e + 1] = node[b];
+    out_delta[e]        = data[e];
+    out_size[e]         = size[a] + size[b];
+
+    // union by size keeps the trees shallow
+    if (size[a] < size[b]) {
+      value_idx t = a;
+      a           = b;
+      b           = t;
+    }
+    size[a]   = out_size[e];
+    node[a]   = n_leaves + e;
+    parent[b] = a;
+  }
+}
+
+/**
+ * Agglomerative labeling on device, with the same output as `build_dendrogram_host`.
+ *
+ * Every round merges, in parallel, the clusters of the MST edges that are smaller than all the
+ * other remaining edges touching their clusters; these merges are exactly those of Kruskal's
+ * algorithm, so the remaining edges keep their order. The rounds shrink the tree quickly when the
+ * edge weights are not correlated with the tree structure. If a round makes little progress, the
+ * rest of the edges is merged sequentially on the device.
+ *
+ * @tparam value_idx
+ * @tparam value_t
+ * @param[in] handle the raft handle
+ * @param[in] rows src edges of the sorted MST
+ * @param[in] cols dst edges of the sorted MST
+ * @param[in] data weights of the sorted MST
+ * @param[in] nnz the number of edges in the sorted MST
+ * @param[out] children children of output
+ * @param[out] out_delta distances of output
+ * @param[out] out_size cluster sizes of output
+ */
+template <typename value_idx, typename value_t, int tpb = 256>
+void build_dendrogram_device(raft::resources const& handle,
+                             const value_idx* rows,
+                             const value_idx* cols,
+                             const value_t* data,
+                             size_t nnz,
+                             value_idx* children,
+                             value_t* out_delta,
+                             value_idx* out_size)
+{
+  auto stream        = resource::get_cuda_stream(handle);
+  auto thrust_policy = resource::get_thrust_policy(handle);
+
+  value_idx n_edges  = nnz;
+  value_idx n_leaves = n_edges + 1;
+
+  // endpoints of the edges, as the roots of their current clusters
+  rmm::device_uvector<value_idx> src(n_edges, stream);
+  rmm::device_uvector<value_idx> dst(n_edges, stream);
+  raft::copy_async(src.data(), rows, n_edges, stream);
+  raft::copy_async(dst.data(), cols, n_edges, stream);
+
+  // clusters: the parent of each vertex, and the dendrogram node and size of each root
+  rmm::device_uvector<value_idx> parent(n_leaves, stream);
+  rmm::device_uvector<value_idx> node(n_leaves, stream);
+  rmm::device_uvector<value_idx> size(n_leaves, stream);
+  rmm::device_uvector<value_idx> min_edge(n_leaves, stream);
+  thrust::sequence(thrust_policy, parent.data(), parent.data() + n_leaves);
+  thrust::sequence(thrust_policy, node.data(), node.data() + n_leaves);
+  thrust::fill(thrust_policy, size.data(), size.data() + n_leaves, 1);
+
+  // ids of the remaining edges, in ascending order
+  rmm::device_uvector<value_idx> edges(n_edges, stream);
+  rmm::device_uvector<value_idx> done(n_edges, stream);
+  thrust::sequence(thrust_policy, edges.data(), edges.data() + n_edges);
+
+  value_idx n_remaining = n_edges;
+  while (n_remaining > 0) {
+    value_idx n_blocks = ceildiv(n_remaining, (value_idx)tpb);
+    reset_min_edge_kernel<<<n_blocks, tpb, 0, stream>>>(
+      edges.data(), n_remaining, src.data(), dst.data(), min_edge.data(), n_edges);
+    min_incident_edge_kernel<<<n_blocks, tpb, 0, stream>>>(
+      edges.data(), n_remaining, src.data(), dst.data(), min_edge.data());
+    thrust::fill(thrust_policy, done.data(), done.data() + n_remaining, 0);
+    contract_min_edges_kernel<<<n_blocks, tpb, 0, stream>>>(edges.data(),
+                                                            n_remaining,
+                                                            src.data(),
+                                                            dst.data(),
+                                                            min_edge.data(),
+                                                            data,
+                                                            n_leaves,
+                                                            parent.data(),
+                                                            node.data(),
+                                                            size.data(),
+                                                            children,
+                                                            out_delta,
+                                                            out_size,
+                                                            done.data());
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+    auto edges_end   = thrust::remove_if(thrust_policy,
+                                         edges.data(),
+                                         edges.data() + n_remaining,
+                                         done.data(),
+                                         thrust::identity<value_idx>());
+    value_idx n_left = edges_end - edges.data();
+    if (n_left == 0) { break; }
+    relabel_edges_kernel<<<ceildiv(n_left, (value_idx)tpb), tpb, 0, stream>>>(
+      edges.data(), n_left, src.data(), dst.data(), parent.data());
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+    bool slow   = (n_remaining - n_left) * kDendrogramMinContraction < n_remaining;
+    n_remaining = n_left;
+    if (slow) {
+      merge_remaining_edges_kernel<<<1, 1, 0, stream>>>(edges.data(),
+                                                        n_remaining,
+                                                        src.data(),
+                                                        dst.data(),
+                                                        data,
+                                                        n_leaves,
+                                                        parent.data(),
+                                                        node.data(),
+                                                        size.data(),
+                                                        children,
+                                                        out_delta,
+                                                        out_size);
+      RAFT_CUDA_TRY(cudaPeekAtLastError());
+      break;
+    }
+  }
+}
+
 template <typename value_idx>
 __global__ void write_levels_kernel(const value_idx* children,
                                     value_idx* parents,
@@ -28,6 +28,7 @@
 #include <thrust/fill.h>
 #include <thrust/transform.h>
 
+#include <raft/cluster/detail/kmeans_bounds.cuh>
 #include <raft/cluster/detail/kmeans_common.cuh>
 #include <raft/cluster/kmeans_types.hpp>
 #include <raft/common/nvtx.hpp>
@@ -40,11 +41,13 @@
 #include <raft/core/operators.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/distance/distance_types.hpp>
+#include <raft/linalg/binary_op.cuh>
 #include <raft/linalg/map_then_reduce.cuh>
 #include <raft/linalg/matrix_vector_op.cuh>
 #include <raft/linalg/norm.cuh>
 #include <raft/linalg/reduce_cols_by_key.cuh>
 #include <raft/linalg/reduce_rows_by_key.cuh>
+#include <raft/matrix/argmin.cuh>
 #include <raft/matrix/gather.cuh>
 #include <raft/random/rng.cuh>
 #include <raft/util/cuda_utils.cuh>
@@ -269,6 +272,182 @@ void kmeansPlusPlus(raft::resources const& handle,
   }  /// <<<< Step-5 >>>
 }
 
+/*
+ * @brief Selects 'n_clusters' samples from the input X using a batched greedy k-means++.
+ *
+ * Every round picks `params.init_batch_size` centroids at once: it draws `n_trials` candidates per
+ * new centroid with probability d^2(x, C) / phi_X(C) (an inclusive scan of the distances and a
+ * binary search per draw, on the device), evaluates the cost of adding each candidate alone in a
+ * single pass over the data and keeps the best candidate of every group of `n_trials`. The min
+ * distances to the chosen centroids are then updated for the next round. The candidates of a round
+ * do not see each other, so the seeding is slightly worse than the sequential k-means++, but the
+ * number of rounds (and of passes over the data) is divided by the batch size.
+ */
+template <typename DataT, typename IndexT>
+void kmeansPlusPlusBatched(raft::resources const& handle,
+                           const KMeansParams& params,
+                           raft::device_matrix_view<const DataT, IndexT> X,
+                           raft::device_matrix_view<DataT, IndexT> centroidsRawData,
+                           rmm::device_uvector<char>& workspace)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope("kmeansPlusPlusBatched");
+  cudaStream_t stream = resource::get_cuda_stream(handle);
+  auto n_samples      = X.extent(0);
+  auto n_features     = X.extent(1);
+  auto n_clusters     = params.n_clusters;
+  auto metric         = params.metric;
+
+  // number of seeding trials for each center (except the first)
+  IndexT n_trials   = 2 + static_cast<int>(std::ceil(log(n_clusters)));
+  IndexT batch_size = std::max<IndexT>(1, std::min<IndexT>(params.init_batch_size, n_clusters));
+  IndexT max_cands  = batch_size * n_trials;
+
+  RAFT_LOG_DEBUG(
+    "Run batched k-means++ to select %d centroids from %d input samples "
+    "(%d centroids and %d seeding trials per centroid per iteration)",
+    n_clusters,
+    n_samples,
+    batch_size,
+    n_trials);
+
+  auto dataBatchSize = getDataBatchSize(params.batch_samples, n_samples);
+
+  // temporary buffers
+  auto indices            = raft::make_device_vector<IndexT, IndexT>(handle, max_cands);
+  auto centroidCandidates = raft::make_device_matrix<DataT, IndexT>(handle, max_cands, n_features);
+  auto costPerCandidate   = raft::make_device_vector<DataT, IndexT>(handle, max_cands);
+  auto bestTrial          = raft::make_device_vector<IndexT, IndexT>(handle, batch_size);
+  auto minClusterDistance = raft::make_device_vector<DataT, IndexT>(handle, n_samples);
+  auto newClusterDistance = raft::make_device_vector<DataT, IndexT>(handle, n_samples);
+  auto distBuffer = raft::make_device_matrix<DataT, IndexT>(handle, max_cands, dataBatchSize);
+
+  rmm::device_uvector<DataT> L2NormBuf_OR_DistBuf(0, stream);
+
+  auto const_weights_view =
+    raft::make_device_vector_view<const DataT, IndexT>(minClusterDistance.data_handle(), n_samples);
+
+  // L2 norm of X: ||c||^2
+  auto L2NormX = raft::make_device_vector<DataT, IndexT>(handle, n_samples);
+
+  if (metric == raft::distance::DistanceType::L2Expanded ||
+      metric == raft::distance::DistanceType::L2SqrtExpanded) {
+    raft::linalg::rowNorm(L2NormX.data_handle(),
+                          X.data_handle(),
+                          X.extent(1),
+                          X.extent(0),
+                          raft::linalg::L2Norm,
+                          true,
+                          stream);
+  }
+
+  raft::random::RngState rng(params.rng_state.seed, params.rng_state.type);
+  std::mt19937 gen(params.rng_state.seed);
+  std::uniform_int_distribution<> dis(0, n_samples - 1);
+
+  // C <-- sample a point uniformly at random from X
+  raft::copy(centroidsRawData.data_handle(),
+             X.data_handle() + dis(gen) * n_features,
+             n_features,
+             stream);
+  IndexT n_clusters_picked = 1;
+
+  // d^2(x, C) for all the points x in X
+  detail::minClusterDistanceCompute<DataT, IndexT>(
+    handle,
+    X,
+    raft::make_device_matrix_view<DataT, IndexT>(centroidsRawData.data_handle(), 1, n_features),
+    minClusterDistance.view(),
+    L2NormX.view(),
+    L2NormBuf_OR_DistBuf,
+    params.metric,
+    params.batch_samples,
+    params.batch_centroids,
+    workspace);
+
+  while (n_clusters_picked < n_clusters) {
+    IndexT n_batch = std::min<IndexT>(batch_size, n_clusters - n_clusters_picked);
+    IndexT n_cands = n_batch * n_trials;
+
+    // Draw the candidates of all the new centroids of the round at once
+    auto indices_view =
+      raft::make_device_vector_view<IndexT, IndexT>(indices.data_handle(), n_cands);
+    auto candidates_view = raft::make_device_matrix_view<DataT, IndexT>(
+      centroidCandidates.data_handle(), n_cands, n_features);
+    raft::random::discrete(handle, rng, indices_view, const_weights_view);
+    raft::matrix::gather(handle, X, raft::make_const_mdspan(indices_view), candidates_view);
+
+    // costPerCandidate[i] = sum_x min(d^2(x, C), d^2(x, candidate-i)); the min and the sum are
+    // fused in the reduction of each batch of pairwise distances.
+    thrust::fill(resource::get_thrust_policy(handle),
+                 costPerCandidate.data_handle(),
+                 costPerCandidate.data_handle() + n_cands,
+                 DataT(0));
+    for (IndexT offset = 0; offset < n_samples; offset += dataBatchSize) {
+      IndexT ns = std::min<IndexT>(dataBatchSize, n_samples - offset);
+      auto pwd =
+        raft::make_device_matrix_view<DataT, IndexT>(distBuffer.data_handle(), n_cands, ns);
+      auto batch = raft::make_device_matrix_view<const DataT, IndexT>(
+        X.data_handle() + offset * n_features, ns, n_features);
+      detail::pairwise_distance_kmeans<DataT, IndexT>(
+        handle, raft::make_const_mdspan(candidates_view), batch, pwd, workspace, metric);
+      const DataT* minDist = minClusterDistance.data_handle() + offset;
+      raft::linalg::reduce(
+        costPerCandidate.data_handle(),
+        pwd.data_handle(),
+        ns,
+        n_cands,
+        DataT(0),
+        true,
+        true,
+        stream,
+        true,
+        [minDist] __device__(DataT d, IndexT j) { return raft::min(d, minDist[j]); });
+    }
+
+    // Greedy choice: the candidate of minimum cost within the trials of every new centroid
+    raft::matrix::argmin(
+      handle,
+      raft::make_device_matrix_view<const DataT, IndexT>(
+        costPerCandidate.data_handle(), n_batch, n_trials),
+      raft::make_device_vector_view<IndexT, IndexT>(bestTrial.data_handle(), n_batch));
+    auto chosen_view =
+      raft::make_device_vector_view<IndexT, IndexT>(indices.data_handle(), n_batch);
+    raft::linalg::map_offset(
+      handle,
+      chosen_view,
+      [best = bestTrial.data_handle(), n_trials] __device__(IndexT j) {
+        return j * n_trials + best[j];
+      });
+    auto newCentroids = raft::make_device_matrix_view<DataT, IndexT>(
+      centroidsRawData.data_handle() + n_clusters_picked * n_features, n_batch, n_features);
+    raft::matrix::gather(handle,
+                         raft::make_const_mdspan(candidates_view),
+                         raft::make_const_mdspan(chosen_view),
+                         newCentroids);
+
+    // d^2(x, C U {new centroids})
+    detail::minClusterDistanceCompute<DataT, IndexT>(handle,
+                                                     X,
+                                                     newCentroids,
+                                                     newClusterDistance.view(),
+                                                     L2NormX.view(),
+                                                     L2NormBuf_OR_DistBuf,
+                                                     params.metric,
+                                                     params.batch_samples,
+                                                     params.batch_centroids,
+                                                     workspace);
+    raft::linalg::binaryOp(minClusterDistance.data_handle(),
+                           minClusterDistance.data_handle(),
+                           newClusterDistance.data_handle(),
+                           n_samples,
+                           raft::min_op{},
+                           stream);
+
+    n_clusters_picked += n_batch;
+    RAFT_LOG_DEBUG(" k-means++ - Sampled %d/%d centroids", n_clusters_picked, n_clusters);
+  }
+}
+
 /**
  *
  * @tparam DataT
@@ -411,6 +590,12 @@ void kmeans_fit_main(raft::resources const& handle,
                           stream);
   }
 
+  // the bounds of the distances for the pruned iterations
+  std::optional<kmeans_bounds<DataT, IndexT>> bounds;
+  if (params.bound_pruning) {
+    bounds.emplace(handle, n_samples, n_features, n_clusters, params.batch_samples);
+  }
+
   RAFT_LOG_DEBUG(
     "Calling KMeans.fit with %d samples of input data and the initialized "
     "cluster centers",
@@ -430,17 +615,37 @@ void kmeans_fit_main(raft::resources const& handle,
     // minClusterAndDistance[i] is a <key, value> pair where
     //   'key' is index to a sample in 'centroids' (index of the nearest
     //   centroid) and 'value' is the distance between the sample 'X[i]' and the
-    //   'centroid[key]'
-    detail::minClusterAndDistanceCompute<DataT, IndexT>(handle,
-                                                        X,
-                                                        centroids,
-                                                        minClusterAndDistance.view(),
-                                                        l2normx_view,
-                                                        L2NormBuf_OR_DistBuf,
-                                                        params.metric,
-                                                        params.batch_samples,
-                                                        params.batch_centroids,
-                                                        workspace);
+    //   'centroid[key]' (an upper bound of the Euclidean distance with bound_pruning)
+    if (!bounds.has_value()) {
+      detail::minClusterAndDistanceCompute<DataT, IndexT>(handle,
+                                                          X,
+                                                          centroids,
+                                                          minClusterAndDistance.view(),
+                                                          l2normx_view,
+                                                          L2NormBuf_OR_DistBuf,
+                                                          params.metric,
+                                                          params.batch_samples,
+                                                          params.batch_centroids,
+                                                          workspace);
+    } else if (n_iter[0] == 1) {
+      detail::bounds_assign_all<DataT, IndexT>(handle,
+                                               X,
+                                               raft::make_const_mdspan(centroids),
+                                               minClusterAndDistance.view(),
+                                               *bounds,
+                                               workspace);
+    } else {
+      auto n_computed = detail::bounds_assign<DataT, IndexT>(handle,
+                                                             X,
+                                                             raft::make_const_mdspan(centroids),
+                                                             minClusterAndDistance.view(),
+                                                             *bounds,
+                                                             workspace);
+      RAFT_LOG_DEBUG("KMeans.fit: Iteration-%d: computed the distances of %d out of %d samples",
+                     n_iter[0],
+                     n_computed,
+                     n_samples);
+    }
 
     // Using TransformInputIteratorT to dereference an array of
     // raft::KeyValuePair and converting them to just return the Key to be used
@@ -474,6 +679,14 @@ void kmeans_fit_main(raft::resources const& handle,
     DataT sqrdNormError = 0;
     raft::copy(&sqrdNormError, sqrdNorm.data_handle(), sqrdNorm.size(), stream);
 
+    if (bounds.has_value()) {
+      detail::bounds_update_centroids<DataT, IndexT>(handle,
+                                                     raft::make_const_mdspan(centroids),
+                                                     raft::make_const_mdspan(newCentroids.view()),
+                                                     *bounds,
+                                                     workspace);
+    }
+
     raft::copy(
       centroidsRawData.data_handle(), newCentroids.data_handle(), newCentroids.size(), stream);
 
@@ -793,6 +1006,66 @@ void initScalableKMeansPlusPlus(raft::resources const& handle,
   }
 }
 
+/**
+ * @brief Estimate the peak device memory of the temporary buffers of `kmeans_fit`.
+ *
+ * The estimate counts the buffers proportional to the problem sizes: the sample weights and the
+ * working copy of the centroids, the buffers of the selected initialization and those of the
+ * Lloyd iterations (including the distance tile and the pruning bounds).
+ */
+template <typename DataT, typename IndexT>
+auto estimate_fit_workspace(const KMeansParams& params, IndexT n_samples, IndexT n_features)
+  -> size_t
+{
+  const size_t n      = n_samples;
+  const size_t f      = n_features;
+  const size_t k      = params.n_clusters;
+  const size_t d_size = sizeof(DataT);
+  const size_t i_size = sizeof(IndexT);
+  const bool is_fused = params.metric == raft::distance::DistanceType::L2Expanded ||
+                        params.metric == raft::distance::DistanceType::L2SqrtExpanded;
+  const size_t data_batch = getDataBatchSize(params.batch_samples, n_samples);
+  const size_t centroids_batch =
+    getCentroidsBatchSize(params.batch_centroids, static_cast<IndexT>(params.n_clusters));
+  // the tiles of the distances to the nearest centroid
+  auto min_distance_bytes = [&](size_t n_centroids) -> size_t {
+    if (is_fused) { return n_centroids * d_size + n * sizeof(int); }
+    return data_batch * std::min(centroids_batch, n_centroids) * d_size;
+  };
+
+  // the sample weights and the working copy of the centroids
+  size_t base = n * d_size + k * f * d_size;
+
+  size_t init = 0;
+  if (params.init == KMeansParams::InitMethod::KMeansPlusPlus) {
+    const size_t n_trials = 2 + static_cast<size_t>(std::ceil(log(params.n_clusters)));
+    if (params.oversampling_factor == 0) {
+      const size_t batch_size =
+        std::max<size_t>(1, std::min<size_t>(std::max(params.init_batch_size, 1), k));
+      const bool batched  = params.init_batch_size > 1;
+      const size_t n_cand = batched ? batch_size * n_trials : n_trials;
+      // candidates, their costs, the min and the new distances, the norms of the samples
+      init = n_cand * (i_size + f * d_size + d_size) + (batched ? 3 : 2) * n * d_size;
+      // distances of the candidates to the (batch of) samples
+      init += n_cand * (batched ? data_batch : n) * d_size;
+    } else {
+      // k-means||: the potential centroids of up to 8 rounds of oversampling
+      const size_t n_potential = std::min<size_t>(
+        n, 1 + 8 * static_cast<size_t>(std::ceil(params.oversampling_factor * params.n_clusters)));
+      init = n * (1 + 3 * d_size) + 2 * n_potential * f * d_size + n_potential * d_size +
+             min_distance_bytes(n_potential);
+    }
+  }
+
+  // the Lloyd iterations: nearest centroids, new centroids and weights, norms of the samples
+  size_t main = n * (sizeof(raft::KeyValuePair<IndexT, DataT>) + d_size) + k * (f + 1) * d_size +
+                min_distance_bytes(k);
+  if (params.bound_pruning) {
+    main += n * (d_size + 1 + i_size) + k * (f + k + 2) * d_size + data_batch * (f + k) * d_size;
+  }
+  return base + std::max(init, main);
+}
+
 /**
  * @brief Find clusters with k-means algorithm.
  *   Initial centroids are chosen with k-means++ algorithm. Empty
@@ -842,6 +1115,11 @@ void kmeans_fit(raft::resources const& handle,
                "invalid parameter (centroids.extent(0) != n_clusters)");
   RAFT_EXPECTS(centroids.extent(1) == n_features,
                "invalid parameter (centroids.extent(1) != n_features)");
+  RAFT_EXPECTS(!params.bound_pruning || params.metric == raft::distance::DistanceType::L2Expanded ||
+                 params.metric == raft::distance::DistanceType::L2SqrtExpanded,
+               "invalid parameter (bound_pruning requires an L2 metric)");
+  RAFT_EXPECTS(!(params.bound_pruning && params.inertia_check),
+               "invalid parameter (bound_pruning and inertia_check are exclusive)");
 
   // Display a message if the batch size is smaller than n_samples but will be ignored
   if (params.batch_samples < (int)n_samples &&
@@ -916,7 +1194,10 @@ void kmeans_fit(raft::resources const& handle,
         "k-means++ algorithm.",
         seed_iter + 1,
         n_init);
-      if (iter_params.oversampling_factor == 0)
+      if (iter_params.oversampling_factor == 0 && iter_params.init_batch_size > 1)
+        detail::kmeansPlusPlusBatched<DataT, IndexT>(
+          handle, iter_params, X, centroidsRawData.view(), workspace);
+      else if (iter_params.oversampling_factor == 0)
         detail::kmeansPlusPlus<DataT, IndexT>(
           handle, iter_params, X, centroidsRawData.view(), workspace);
       else
@@ -18,6 +18,8 @@
 #include <raft/core/device_mdspan.hpp>
 #include <raft/core/host_mdarray.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/cuda_stream_pool.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
 #include <thrust/host_vector.h>
 
 #include <raft/core/logger.hpp>
@@ -29,6 +31,11 @@
 #include <raft/core/resources.hpp>
 #include <raft/stats/dispersion.cuh>
 
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <vector>
+
 namespace raft::cluster::detail {
 
 template <typename value_t, typename idx_t>
@@ -66,6 +73,83 @@ void compute_dispersion(raft::resources const& handle,
     handle, centroids_const_view, cluster_sizes_view, std::nullopt, n);
 }
 
+/**
+ * Fit the candidates `ks` and record their inertia, dispersion and number of iterations. When the
+ * handle has a stream pool, the candidates are fitted concurrently, each on a stream of the pool
+ * driven by its own host thread (the fits synchronize with the host between the iterations).
+ */
+template <typename value_t, typename idx_t>
+void compute_dispersions(raft::resources const& handle,
+                         raft::device_matrix_view<const value_t, idx_t> X,
+                         const KMeansParams& params,
+                         const std::vector<idx_t>& ks,
+                         raft::host_vector_view<value_t> clusterDispertionView,
+                         raft::host_vector_view<value_t> resultsView,
+                         raft::host_vector_view<idx_t> nIterView)
+{
+  const idx_t n          = X.extent(0);
+  const idx_t d          = X.extent(1);
+  const size_t n_fits    = ks.size();
+  const size_t n_streams = std::min<size_t>(resource::get_stream_pool_size(handle), n_fits);
+
+  auto fit_one = [&](raft::resources const& res, idx_t k) {
+    auto stream        = resource::get_cuda_stream(res);
+    auto centroids     = raft::make_device_matrix<value_t, idx_t>(res, k, d);
+    auto cluster_sizes = raft::make_device_vector<idx_t>(res, k);
+    auto labels        = raft::make_device_vector<idx_t>(res, n);
+    rmm::device_uvector<char> workspace(0, stream);
+    KMeansParams fit_params = params;
+    value_t residual        = 0;
+    idx_t n_iter            = 0;
+    compute_dispersion<value_t, idx_t>(res,
+                                       X,
+                                       fit_params,
+                                       centroids.view(),
+                                       labels.view(),
+                                       cluster_sizes.view(),
+                                       workspace,
+                                       clusterDispertionView,
+                                       resultsView,
+                                       raft::make_host_scalar_view(&residual),
+                                       raft::make_host_scalar_view(&n_iter),
+                                       k,
+                                       n,
+                                       d);
+    nIterView[k] = n_iter;
+  };
+
+  if (n_streams <= 1) {
+    for (auto k : ks) {
+      fit_one(handle, k);
+    }
+    return;
+  }
+
+  // The input is ready in the main stream
+  resource::wait_stream_pool_on_stream(handle);
+  std::vector<std::unique_ptr<raft::resources>> stream_res;
+  for (size_t i = 0; i < n_streams; i++) {
+    stream_res.push_back(std::make_unique<raft::resources>(handle));
+    auto stream = resource::get_stream_from_stream_pool(handle, i);
+    resource::set_cuda_stream(*stream_res[i], stream);
+    stream_res[i]->add_resource_factory(
+      std::make_shared<resource::thrust_policy_resource_factory>(stream));
+  }
+  std::vector<std::exception_ptr> errors(n_fits);
+#pragma omp parallel for num_threads(n_streams) schedule(static, 1)
+  for (size_t i = 0; i < n_fits; i++) {
+    try {
+      fit_one(*stream_res[i % n_streams], ks[i]);
+    } catch (...) {
+      errors[i] = std::current_exception();
+    }
+  }
+  resource::sync_stream_pool(handle);
+  for (auto& e : errors) {
+    if (e) { std::rethrow_exception(e); }
+  }
+}
+
 template <typename idx_t, typename value_t>
 void find_k(raft::resources const& handle,
             raft::device_matrix_view<const value_t, idx_t> X,
@@ -86,23 +170,33 @@ void find_k(raft::resources const& handle,
   RAFT_EXPECTS(kmax <= n, "kmax must be <= number of data samples in X");
   RAFT_EXPECTS(tol >= 0, "tolerance must be >= 0");
   RAFT_EXPECTS(maxiter >= 0, "maxiter must be >= 0");
-  // Allocate memory
-  // Device memory
-
-  auto centroids    = raft::make_device_matrix<value_t, idx_t>(handle, kmax, X.extent(1));
-  auto clusterSizes = raft::make_device_vector<idx_t>(handle, kmax);
-  auto labels       = raft::make_device_vector<idx_t>(handle, n);
-
-  rmm::device_uvector<char> workspace(0, resource::get_cuda_stream(handle));
-
-  idx_t* clusterSizes_ptr = clusterSizes.data_handle();
 
   // Host memory
   auto results           = raft::make_host_vector<value_t>(kmax + 1);
   auto clusterDispersion = raft::make_host_vector<value_t>(kmax + 1);
+  auto nIters            = raft::make_host_vector<idx_t>(kmax + 1);
 
   auto clusterDispertionView = clusterDispersion.view();
   auto resultsView           = results.view();
+  auto nIterView             = nIters.view();
+
+  // The fits are deterministic: a candidate evaluated once (possibly speculatively) is not refit.
+  std::vector<bool> evaluated(kmax + 1, false);
+
+  KMeansParams params;
+  params.max_iter = maxiter;
+  params.tol      = tol;
+
+  auto evaluate = [&](std::vector<idx_t> ks) {
+    ks.erase(std::remove_if(ks.begin(), ks.end(), [&](idx_t k) { return evaluated[k]; }),
+             ks.end());
+    if (ks.empty()) { return; }
+    compute_dispersions<value_t, idx_t>(
+      handle, X, params, ks, clusterDispertionView, resultsView, nIterView);
+    for (auto k : ks) {
+      evaluated[k] = true;
+    }
+  };
 
   // Loop to find *best* k
   // Perform k-means in binary search
@@ -114,79 +208,35 @@ void find_k(raft::resources const& handle,
   double objective[3];      // 0= left of mid, 1= right of mid
   if (left == 1) left = 2;  // at least do 2 clusters
 
-  KMeansParams params;
-  params.max_iter = maxiter;
-  params.tol      = tol;
-
-  auto centroids_view =
-    raft::make_device_matrix_view<value_t, idx_t>(centroids.data_handle(), left, d);
-  compute_dispersion<value_t, idx_t>(handle,
-                                     X,
-                                     params,
-                                     centroids_view,
-                                     labels.view(),
-                                     clusterSizes.view(),
-                                     workspace,
-                                     clusterDispertionView,
-                                     resultsView,
-                                     residual,
-                                     n_iter,
-                                     left,
-                                     n,
-                                     d);
-
-  // eval right edge0
-  resultsView[right] = 1e20;
-  while (resultsView[right] > resultsView[left] && tests < 3) {
-    centroids_view =
-      raft::make_device_matrix_view<value_t, idx_t>(centroids.data_handle(), right, d);
-    compute_dispersion<value_t, idx_t>(handle,
-                                       X,
-                                       params,
-                                       centroids_view,
-                                       labels.view(),
-                                       clusterSizes.view(),
-                                       workspace,
-                                       clusterDispertionView,
-                                       resultsView,
-                                       residual,
-                                       n_iter,
-                                       right,
-                                       n,
-                                       d);
+  // the edges are independent of each other
+  evaluate({idx_t(left), idx_t(right)});
 
-    tests += 1;
-  }
+  // To fit several candidates at once, the bisection speculatively evaluates the midpoints of both
+  // halves along with the midpoint of the current range when the stream pool has room for them.
+  const bool speculate = resource::get_stream_pool_size(handle) >= 3;
 
   objective[0] = (n - left) / (left - 1) * clusterDispertionView[left] / resultsView[left];
   objective[1] = (n - right) / (right - 1) * clusterDispertionView[right] / resultsView[right];
   while (left < right - 1) {
-    resultsView[mid] = 1e20;
-    tests            = 0;
+    std::vector<idx_t> candidates{idx_t(mid)};
+    if (speculate) {
+      int next_left  = ((unsigned int)left + (unsigned int)mid) >> 1;
+      int next_right = ((unsigned int)mid + (unsigned int)right) >> 1;
+      if (next_left > left && next_left < mid) { candidates.push_back(next_left); }
+      if (next_right > mid && next_right < right) { candidates.push_back(next_right); }
+    }
+    evaluate(candidates);
+
+    tests = 0;
     while (resultsView[mid] > resultsView[left] && tests < 3) {
-      centroids_view =
-        raft::make_device_matrix_view<value_t, idx_t>(centroids.data_handle(), mid, d);
-      compute_dispersion<value_t, idx_t>(handle,
-                                         X,
-                                         params,
-                                         centroids_view,
-                                         labels.view(),
-                                         clusterSizes.view(),
-                                         workspace,
-                                         clusterDispertionView,
-                                         resultsView,
-                                         residual,
-                                         n_iter,
-                                         mid,
-                                         n,
-                                         d);
+      evaluate({idx_t(mid)});
 
       if (resultsView[mid] > resultsView[left] && (mid + 1) < right) {
         mid += 1;
-        resultsView[mid] = 1e20;
+        if (!evaluated[mid]) { resultsView[mid] = 1e20; }
       } else if (resultsView[mid] > resultsView[left] && (mid - 1) > left) {
         mid -= 1;
-        resultsView[mid] = 1e20;
+        if (!evaluated[mid]) { resultsView[mid] = 1e20; }
       }
       tests += 1;
     }
@@ -213,21 +263,9 @@ void find_k(raft::resources const& handle,
   objective[1] = (n - oldmid) / (oldmid - 1) * clusterDispertionView[oldmid] / resultsView[oldmid];
   if (objective[1] < objective[0]) { best_k[0] = left; }
 
-  // if best_k isn't what we just ran, re-run to get correct centroids and dist data on return->
-  // this saves memory
-  if (best_k[0] != oldmid) {
-    auto centroids_view =
-      raft::make_device_matrix_view<value_t, idx_t>(centroids.data_handle(), best_k[0], d);
-
-    params.n_clusters = best_k[0];
-    raft::cluster::detail::kmeans_fit_predict<value_t, idx_t>(handle,
-                                                              params,
-                                                              X,
-                                                              std::nullopt,
-                                                              std::make_optional(centroids_view),
-                                                              labels.view(),
-                                                              residual,
-                                                              n_iter);
-  }
+  // the residual and the iterations of every evaluated candidate are kept on the host
+  evaluate({best_k[0]});
+  residual[0] = resultsView[best_k[0]];
+  n_iter[0]   = nIterView[best_k[0]];
 }
-}  // namespace raft::cluster::detail
\ No newline at end of file
+}  // namespace raft::cluster::detail
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <cmath>
 #include <limits>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resource/device_memory_resource.hpp>
@@ -28,11 +29,12 @@
 #include <raft/core/cudart_utils.hpp>
 #include <raft/core/logger.hpp>
 #include <raft/core/operators.hpp>
+#include <raft/distance/detail/pairwise_distance_half.cuh>
 #include <raft/distance/distance.cuh>
 #include <raft/distance/distance_types.hpp>
+#include <raft/distance/fused_distance_nn.cuh>
 #include <raft/distance/fused_l2_nn.cuh>
 #include <raft/linalg/add.cuh>
-#include <raft/linalg/gemm.cuh>
 #include <raft/linalg/map.cuh>
 #include <raft/linalg/matrix_vector_op.cuh>
 #include <raft/linalg/norm.cuh>
@@ -48,9 +50,12 @@
 #include <rmm/device_scalar.hpp>
 #include <rmm/device_vector.hpp>
 #include <rmm/mr/device/device_memory_resource.hpp>
-#include <rmm/mr/device/managed_memory_resource.hpp>
 #include <rmm/mr/device/per_device_resource.hpp>
 
+#include <cub/cub.cuh>
+
+#include <cuda_fp16.h>
+
 #include <thrust/gather.h>
 #include <thrust/transform.h>
 
@@ -138,32 +143,37 @@ inline std::enable_if_t<std::is_floating_point_v<MathT>> predict_core(
       break;
     }
     case raft::distance::DistanceType::InnerProduct: {
-      // TODO: pass buffer
-      rmm::device_uvector<MathT> distances(n_rows * n_clusters, stream, mr);
+      auto workspace = raft::make_device_mdarray<char, IdxT>(
+        handle, mr, make_extents<IdxT>((sizeof(int)) * n_rows));
 
-      MathT alpha = -1.0;
-      MathT beta  = 0.0;
+      auto minClusterAndDistance = raft::make_device_mdarray<raft::KeyValuePair<IdxT, MathT>, IdxT>(
+        handle, mr, make_extents<IdxT>(n_rows));
+      raft::KeyValuePair<IdxT, MathT> initial_value(0, std::numeric_limits<MathT>::max());
+      thrust::fill(resource::get_thrust_policy(handle),
+                   minClusterAndDistance.data_handle(),
+                   minClusterAndDistance.data_handle() + minClusterAndDistance.size(),
+                   initial_value);
 
-      linalg::gemm(handle,
-                   true,
-                   false,
-                   n_clusters,
-                   n_rows,
-                   dim,
-                   &alpha,
-                   centers,
-                   dim,
-                   dataset,
-                   dim,
-                   &beta,
-                   distances.data(),
-                   n_clusters,
-                   stream);
+      // The fused kernel minimizes the negated inner product; no norms are needed.
+      raft::distance::fusedDistanceNNMinReduce<MathT, raft::KeyValuePair<IdxT, MathT>, IdxT>(
+        minClusterAndDistance.data_handle(),
+        dataset,
+        centers,
+        nullptr,
+        nullptr,
+        n_rows,
+        n_clusters,
+        dim,
+        (void*)workspace.data_handle(),
+        params.metric,
+        false,
+        stream);
 
-      auto distances_const_view = raft::make_device_matrix_view<const MathT, IdxT, row_major>(
-        distances.data(), n_rows, n_clusters);
-      auto labels_view = raft::make_device_vector_view<LabelT, IdxT>(labels, n_rows);
-      raft::matrix::argmin(handle, distances_const_view, labels_view);
+      thrust::transform(resource::get_thrust_policy(handle),
+                        minClusterAndDistance.data_handle(),
+                        minClusterAndDistance.data_handle() + n_rows,
+                        labels,
+                        raft::compose_op<raft::cast_op<LabelT>, raft::key_op>());
       break;
     }
     default: {
@@ -172,6 +182,74 @@ inline std::enable_if_t<std::is_floating_point_v<MathT>> predict_core(
   }
 }
 
+/**
+ * Whether the assignment of the fp16 data runs the fp16 GEMM of `predict_core_half`: the data is
+ * used as is when the mapping is a plain conversion to the fp32 math type.
+ */
+template <typename T, typename MathT, typename MappingOpT>
+constexpr bool kHalfGemm = std::is_same_v<T, half> && std::is_same_v<MathT, float> &&
+                           (std::is_same_v<MappingOpT, raft::identity_op> ||
+                            std::is_same_v<MappingOpT, raft::cast_op<float>>);
+
+/** Turns the inner products of the rows and the centers into distances up to a per-row term. */
+template <typename IdxT>
+struct half_gemm_distance_op {
+  const float* dots;
+  const float* centers_norm;
+  IdxT n_clusters;
+
+  RAFT_INLINE_FUNCTION auto operator()(IdxT i) const -> float
+  {
+    return centers_norm == nullptr ? -dots[i] : centers_norm[i % n_clusters] - 2.0f * dots[i];
+  }
+};
+
+/**
+ * @brief Predict labels for the fp16 dataset using the fp16 GEMM with fp32 accumulation.
+ *
+ * The inner products of the rows and the centers are computed on the tensor cores; the L2 metrics
+ * then add the fp32 norms of the centers. The norms of the rows do not change the labels, so they
+ * are not needed. Requires the temporary memory for the distance matrix
+ * (n_rows * n_cluster * sizeof(float)).
+ *
+ * @param[in] handle The raft handle.
+ * @param[in] params Structure containing the hyper-parameters
+ * @param[in] centers_half Pointer to the fp16 copy of the cluster centers [n_clusters, dim]
+ * @param[in] centers_norm Pointer to the fp32 squared L2 norms of the centers [n_clusters], or
+ *                         nullptr for the inner product
+ * @param[in] n_clusters Number of clusters/centers
+ * @param[in] dim Dimensionality of the data
+ * @param[in] dataset Pointer to the data [n_rows, dim]
+ * @param[in] n_rows Number samples in the `dataset`
+ * @param[out] labels Output predictions [n_rows]
+ * @param[inout] mr Memory resource to use for temporary allocations
+ */
+template <typename IdxT, typename LabelT>
+void predict_core_half(const raft::resources& handle,
+                       const kmeans_balanced_params& params,
+                       const half* centers_half,
+                       const float* centers_norm,
+                       IdxT n_clusters,
+                       IdxT dim,
+                       const half* dataset,
+                       IdxT n_rows,
+                       LabelT* labels,
+                       rmm::mr::device_memory_resource* mr)
+{
+  auto stream = resource::get_cuda_stream(handle);
+  rmm::device_uvector<float> distances(n_rows * n_clusters, stream, mr);
+  raft::distance::detail::pairwise_half_gemm(
+    handle, dataset, centers_half, distances.data(), n_rows, n_clusters, dim);
+  linalg::map_offset(
+    handle,
+    raft::make_device_vector_view<float, IdxT>(distances.data(), n_rows * n_clusters),
+    half_gemm_distance_op<IdxT>{distances.data(), centers_norm, n_clusters});
+  raft::matrix::argmin(
+    handle,
+    raft::make_device_matrix_view<const float, IdxT>(distances.data(), n_rows, n_clusters),
+    raft::make_device_vector_view<LabelT, IdxT>(labels, n_rows));
+}
+
 /**
  * @brief Suggest a minibatch size for kmeans prediction.
  *
@@ -186,6 +264,7 @@ inline std::enable_if_t<std::is_floating_point_v<MathT>> predict_core(
  * @param[in] dim Number of features in the dataset
  * @param[in] metric Distance metric
  * @param[in] needs_conversion Whether the data needs to be converted to MathT
+ * @param[in] half_gemm Whether the fp16 data is assigned by `predict_core_half`
  * @return A suggested minibatch size and the expected memory cost per-row (in bytes)
  */
 template <typename MathT, typename IdxT>
@@ -193,27 +272,34 @@ constexpr auto calc_minibatch_size(IdxT n_clusters,
                                    IdxT n_rows,
                                    IdxT dim,
                                    raft::distance::DistanceType metric,
-                                   bool needs_conversion) -> std::tuple<IdxT, size_t>
+                                   bool needs_conversion,
+                                   bool half_gemm = false) -> std::tuple<IdxT, size_t>
 {
   n_clusters = std::max<IdxT>(1, n_clusters);
 
   // Estimate memory needs per row (i.e element of the batch).
   size_t mem_per_row = 0;
-  switch (metric) {
-    // fusedL2NN needs a mutex and a key-value pair for each row.
-    case distance::DistanceType::L2Expanded:
-    case distance::DistanceType::L2SqrtExpanded: {
-      mem_per_row += sizeof(int);
-      mem_per_row += sizeof(raft::KeyValuePair<IdxT, MathT>);
-    } break;
-    // Other metrics require storing a distance matrix.
-    default: {
-      mem_per_row += sizeof(MathT) * n_clusters;
+  if (half_gemm) {
+    // The fp16 GEMM stores the full fp32 distance matrix; the data is used without conversion.
+    mem_per_row += sizeof(float) * n_clusters;
+  } else {
+    switch (metric) {
+      // fusedL2NN and fusedDistanceNN need a mutex and a key-value pair for each row.
+      case distance::DistanceType::L2Expanded:
+      case distance::DistanceType::L2SqrtExpanded:
+      case distance::DistanceType::InnerProduct: {
+        mem_per_row += sizeof(int);
+        mem_per_row += sizeof(raft::KeyValuePair<IdxT, MathT>);
+      } break;
+      // Other metrics require storing a distance matrix.
+      default: {
+        mem_per_row += sizeof(MathT) * n_clusters;
+      }
     }
   }
 
   // If we need to convert to MathT, space required for the converted batch.
-  if (!needs_conversion) { mem_per_row += sizeof(MathT) * dim; }
+  if (!needs_conversion && !half_gemm) { mem_per_row += sizeof(MathT) * dim; }
 
   // Heuristic: calculate the minibatch size in order to use at most 1GB of memory.
   IdxT minibatch_size = (1 << 30) / mem_per_row;
@@ -222,6 +308,50 @@ constexpr auto calc_minibatch_size(IdxT n_clusters,
   return std::make_tuple(minibatch_size, mem_per_row);
 }
 
+/**
+ * @brief Estimate the peak device memory of the temporary buffers of `build_hierarchical`.
+ *
+ * The estimate counts the minibatch buffers of the predictions (see `calc_minibatch_size`), the
+ * norms of the dataset and the buffers of the first (largest) level of the hierarchy: the labels
+ * and the grouped ids of all the rows, and the copy of the largest mesocluster the fine clusters
+ * are trained on.
+ */
+template <typename T, typename MathT, typename IdxT, typename MappingOpT>
+auto estimate_build_hierarchical_workspace(const kmeans_balanced_params& params,
+                                           IdxT n_rows,
+                                           IdxT dim,
+                                           IdxT n_clusters) -> size_t
+{
+  auto [max_minibatch_size, mem_per_row] =
+    calc_minibatch_size<MathT>(n_clusters,
+                               n_rows,
+                               dim,
+                               params.metric,
+                               std::is_same_v<T, MathT>,
+                               kHalfGemm<T, MathT, MappingOpT>);
+  const bool need_norm = params.metric == raft::distance::DistanceType::L2Expanded ||
+                         params.metric == raft::distance::DistanceType::L2SqrtExpanded;
+  const auto depth = std::max<uint32_t>(params.hierarchy_depth, 1);
+  IdxT n_mesoclusters =
+    std::min(n_clusters,
+             std::max<IdxT>(
+               static_cast<IdxT>(std::pow(double(n_clusters), 1.0 / double(depth)) + 0.5), 1));
+  // The fine clusters of a mesocluster are trained on at most twice the balanced mesocluster size.
+  const size_t mesocluster_size_max =
+    div_rounding_up_safe<size_t>(2lu * size_t(n_rows), std::max<size_t>(n_mesoclusters, 1lu));
+
+  size_t bytes = mem_per_row * size_t(max_minibatch_size);
+  if (need_norm) { bytes += sizeof(MathT) * size_t(n_rows); }
+  // labels and grouped ids of the rows
+  bytes += (sizeof(uint32_t) + sizeof(IdxT)) * size_t(n_rows);
+  bytes += sizeof(MathT) * size_t(n_mesoclusters) * size_t(dim);
+  // the trainset of the fine clusters: ids, rows, norms and labels
+  bytes += mesocluster_size_max *
+           (sizeof(IdxT) + sizeof(T) * size_t(dim) + (need_norm ? sizeof(MathT) : 0) +
+            sizeof(uint32_t));
+  return bytes;
+}
+
 /**
  * @brief Given the data and labels, calculate cluster centers and sizes in one sweep.
  *
@@ -385,7 +515,42 @@ void predict(const raft::resources& handle,
     "predict(%zu, %u)", static_cast<size_t>(n_rows), n_clusters);
   if (mr == nullptr) { mr = resource::get_workspace_resource(handle); }
   auto [max_minibatch_size, _mem_per_row] =
-    calc_minibatch_size<MathT>(n_clusters, n_rows, dim, params.metric, std::is_same_v<T, MathT>);
+    calc_minibatch_size<MathT>(n_clusters,
+                               n_rows,
+                               dim,
+                               params.metric,
+                               std::is_same_v<T, MathT>,
+                               kHalfGemm<T, MathT, MappingOpT>);
+  if constexpr (kHalfGemm<T, MathT, MappingOpT>) {
+    // The fp32 centers are rounded to fp16 for the GEMM only; their norms are kept in fp32.
+    rmm::device_uvector<half> centers_half(n_clusters * dim, stream, mr);
+    linalg::unaryOp(centers_half.data(), centers, n_clusters * dim, raft::cast_op<half>{}, stream);
+    rmm::device_uvector<float> centers_norm(0, stream, mr);
+    switch (params.metric) {
+      case raft::distance::DistanceType::L2Expanded:
+      case raft::distance::DistanceType::L2SqrtExpanded:
+        centers_norm.resize(n_clusters, stream);
+        raft::linalg::rowNorm<float, IdxT>(
+          centers_norm.data(), centers, dim, n_clusters, raft::linalg::L2Norm, true, stream);
+        break;
+      case raft::distance::DistanceType::InnerProduct: break;
+      default: RAFT_FAIL("The chosen distance metric is not supported (%d)", int(params.metric));
+    }
+    for (IdxT offset = 0; offset < n_rows; offset += max_minibatch_size) {
+      IdxT minibatch_size = std::min<IdxT>(max_minibatch_size, n_rows - offset);
+      predict_core_half(handle,
+                        params,
+                        centers_half.data(),
+                        centers_norm.size() > 0 ? centers_norm.data() : nullptr,
+                        n_clusters,
+                        dim,
+                        dataset + offset * dim,
+                        minibatch_size,
+                        labels + offset,
+                        mr);
+    }
+    return;
+  }
   rmm::device_uvector<MathT> cur_dataset(
     std::is_same_v<T, MathT> ? 0 : max_minibatch_size * dim, stream, mr);
   bool need_compute_norm =
@@ -816,77 +981,140 @@ inline auto arrange_fine_clusters(IdxT n_clusters,
                          std::move(fine_clusters_csum));
 }
 
+/** Picks `n_samples` of the `n_ids` row ids at evenly spaced positions. */
+template <typename IdxT>
+struct strided_subsample_op {
+  const IdxT* ids;
+  IdxT n_ids;
+  IdxT n_samples;
+
+  RAFT_INLINE_FUNCTION auto operator()(IdxT i) const -> IdxT
+  {
+    return ids[static_cast<uint64_t>(i) * static_cast<uint64_t>(n_ids) /
+               static_cast<uint64_t>(n_samples)];
+  }
+};
+
+/**
+ * Group the row ids of the trainset by their mesocluster labels on the device.
+ *
+ * On return, the ids of the rows of the i-th mesocluster are stored in ascending order in
+ * `grouped_ids[offset_i, offset_i + size_i)`, where `offset_i` is the exclusive prefix sum of the
+ * mesocluster sizes.
+ */
+template <typename IdxT, typename LabelT>
+void group_by_mesocluster(const raft::resources& handle,
+                          const LabelT* labels,
+                          IdxT n_mesoclusters,
+                          IdxT n_rows,
+                          IdxT* grouped_ids,
+                          rmm::mr::device_memory_resource* device_memory)
+{
+  auto stream = resource::get_cuda_stream(handle);
+  rmm::device_uvector<IdxT> row_ids(n_rows, stream, device_memory);
+  rmm::device_uvector<LabelT> sorted_labels(n_rows, stream, device_memory);
+  linalg::map_offset(handle,
+                     raft::make_device_vector_view<IdxT, IdxT>(row_ids.data(), n_rows),
+                     raft::identity_op{});
+
+  // The labels are smaller than the number of mesoclusters: sort only the bits in use.
+  int end_bit = 1;
+  while (end_bit < int(sizeof(LabelT) * 8) && (uint64_t{1} << end_bit) < uint64_t(n_mesoclusters)) {
+    end_bit++;
+  }
+  size_t sort_bytes = 0;
+  RAFT_CUDA_TRY(cub::DeviceRadixSort::SortPairs(nullptr,
+                                                sort_bytes,
+                                                labels,
+                                                sorted_labels.data(),
+                                                row_ids.data(),
+                                                grouped_ids,
+                                                n_rows,
+                                                0,
+                                                end_bit,
+                                                stream));
+  rmm::device_uvector<char> sort_buf(sort_bytes, stream, device_memory);
+  RAFT_CUDA_TRY(cub::DeviceRadixSort::SortPairs(sort_buf.data(),
+                                                sort_bytes,
+                                                labels,
+                                                sorted_labels.data(),
+                                                row_ids.data(),
+                                                grouped_ids,
+                                                n_rows,
+                                                0,
+                                                end_bit,
+                                                stream));
+}
+
+template <typename T, typename MathT, typename IdxT, typename MappingOpT>
+void build_hierarchical_level(const raft::resources& handle,
+                              const kmeans_balanced_params& params,
+                              uint32_t depth,
+                              IdxT dim,
+                              const T* dataset,
+                              const MathT* dataset_norm,
+                              IdxT n_rows,
+                              MathT* cluster_centers,
+                              IdxT n_clusters,
+                              MappingOpT mapping_op,
+                              rmm::mr::device_memory_resource* device_memory);
+
 /**
  *  Given the (coarse) mesoclusters and the distribution of fine clusters within them,
  *  build the fine clusters.
  *
  *  Processing one mesocluster at a time:
- *   1. Copy mesocluster data into a separate buffer
- *   2. Predict fine cluster
- *   3. Refince the fine cluster centers
+ *   1. Gather (a subsample of) the mesocluster data into a separate buffer, keeping the input type
+ *      (e.g. the fp16 data is not expanded to fp32)
+ *   2. Build the fine clusters of the mesocluster, hierarchically if `depth > 1`
  *
  *  As a result, the fine clusters are what is returned by `build_hierarchical`;
  *  this function returns the total number of fine clusters, which can be checked to be
  *  the same as the requested number of clusters.
  *
- *  Note: this function uses at most `fine_clusters_nums_max` points per mesocluster for training;
- *  if one of the clusters is larger than that (as given by `mesocluster_sizes`), the extra data
- *  is ignored and a warning is reported.
+ *  Note: this function uses at most `mesocluster_size_max` points per mesocluster (and at most
+ *  `params.max_train_points_per_cluster` points per fine cluster) for training; the larger
+ *  mesoclusters are subsampled evenly on the device.
  */
-template <typename T,
-          typename MathT,
-          typename IdxT,
-          typename LabelT,
-          typename CounterT,
-          typename MappingOpT>
+template <typename T, typename MathT, typename IdxT, typename CounterT, typename MappingOpT>
 auto build_fine_clusters(const raft::resources& handle,
                          const kmeans_balanced_params& params,
+                         uint32_t depth,
                          IdxT dim,
-                         const T* dataset_mptr,
-                         const MathT* dataset_norm_mptr,
-                         const LabelT* labels_mptr,
+                         const T* dataset,
+                         const MathT* dataset_norm,
+                         const IdxT* grouped_ids,
                          IdxT n_rows,
                          const IdxT* fine_clusters_nums,
                          const IdxT* fine_clusters_csum,
                          const CounterT* mesocluster_sizes,
                          IdxT n_mesoclusters,
                          IdxT mesocluster_size_max,
-                         IdxT fine_clusters_nums_max,
                          MathT* cluster_centers,
                          MappingOpT mapping_op,
-                         rmm::mr::device_memory_resource* managed_memory,
                          rmm::mr::device_memory_resource* device_memory) -> IdxT
 {
   auto stream = resource::get_cuda_stream(handle);
-  rmm::device_uvector<IdxT> mc_trainset_ids_buf(mesocluster_size_max, stream, managed_memory);
-  rmm::device_uvector<MathT> mc_trainset_buf(mesocluster_size_max * dim, stream, device_memory);
-  rmm::device_uvector<MathT> mc_trainset_norm_buf(mesocluster_size_max, stream, device_memory);
-  auto mc_trainset_ids  = mc_trainset_ids_buf.data();
-  auto mc_trainset      = mc_trainset_buf.data();
-  auto mc_trainset_norm = mc_trainset_norm_buf.data();
-
-  // label (cluster ID) of each vector
-  rmm::device_uvector<LabelT> mc_trainset_labels(mesocluster_size_max, stream, device_memory);
-
-  rmm::device_uvector<MathT> mc_trainset_ccenters(
-    fine_clusters_nums_max * dim, stream, device_memory);
-  // number of vectors in each cluster
-  rmm::device_uvector<CounterT> mc_trainset_csizes_tmp(
-    fine_clusters_nums_max, stream, device_memory);
+  rmm::device_uvector<IdxT> mc_trainset_ids_buf(mesocluster_size_max, stream, device_memory);
+  rmm::device_uvector<T> mc_trainset_buf(mesocluster_size_max * dim, stream, device_memory);
+  rmm::device_uvector<MathT> mc_trainset_norm_buf(0, stream, device_memory);
+  auto mc_trainset_ids = mc_trainset_ids_buf.data();
+  auto mc_trainset     = mc_trainset_buf.data();
+
+  const MathT* mc_trainset_norm = nullptr;
+  if (dataset_norm != nullptr) {
+    mc_trainset_norm_buf.resize(mesocluster_size_max, stream);
+    mc_trainset_norm = mc_trainset_norm_buf.data();
+  }
 
   // Training clusters in each meso-cluster
   IdxT n_clusters_done = 0;
+  IdxT mc_offset       = 0;
   for (IdxT i = 0; i < n_mesoclusters; i++) {
-    IdxT k = 0;
-    for (IdxT j = 0; j < n_rows && k < mesocluster_size_max; j++) {
-      if (labels_mptr[j] == LabelT(i)) { mc_trainset_ids[k++] = j; }
-    }
-    if (k != static_cast<IdxT>(mesocluster_sizes[i]))
-      RAFT_LOG_WARN("Incorrect mesocluster size at %d. %zu vs %zu",
-                    static_cast<int>(i),
-                    static_cast<size_t>(k),
-                    static_cast<size_t>(mesocluster_sizes[i]));
-    if (k == 0) {
+    auto mc_size = static_cast<IdxT>(mesocluster_sizes[i]);
+    auto mc_ids  = grouped_ids + mc_offset;
+    mc_offset += mc_size;
+    if (mc_size == 0) {
       RAFT_LOG_DEBUG("Empty cluster %d", i);
       RAFT_EXPECTS(fine_clusters_nums[i] == 0,
                    "Number of fine clusters must be zero for the empty mesocluster (got %d)",
@@ -897,47 +1125,214 @@ auto build_fine_clusters(const raft::resources& handle,
                    "Number of fine clusters must be non-zero for a non-empty mesocluster");
     }
 
-    cub::TransformInputIterator<MathT, MappingOpT, const T*> mapping_itr(dataset_mptr, mapping_op);
-    raft::matrix::gather(mapping_itr, dim, n_rows, mc_trainset_ids, k, mc_trainset, stream);
-    if (params.metric == raft::distance::DistanceType::L2Expanded ||
-        params.metric == raft::distance::DistanceType::L2SqrtExpanded) {
+    IdxT k = std::min(mc_size, mesocluster_size_max);
+    if (params.max_train_points_per_cluster > 0) {
+      k = std::min<IdxT>(
+        k, std::max<IdxT>(fine_clusters_nums[i] * params.max_train_points_per_cluster, 1));
+    }
+    k = std::max(k, fine_clusters_nums[i]);
+    linalg::map_offset(handle,
+                       raft::make_device_vector_view<IdxT, IdxT>(mc_trainset_ids, k),
+                       strided_subsample_op<IdxT>{mc_ids, mc_size, k});
+
+    raft::matrix::gather(dataset, dim, n_rows, mc_trainset_ids, k, mc_trainset, stream);
+    if (mc_trainset_norm != nullptr) {
       thrust::gather(resource::get_thrust_policy(handle),
                      mc_trainset_ids,
                      mc_trainset_ids + k,
-                     dataset_norm_mptr,
-                     mc_trainset_norm);
+                     dataset_norm,
+                     mc_trainset_norm_buf.data());
     }
 
+    build_hierarchical_level(handle,
+                             params,
+                             depth,
+                             dim,
+                             static_cast<const T*>(mc_trainset),
+                             mc_trainset_norm,
+                             k,
+                             cluster_centers + (dim * fine_clusters_csum[i]),
+                             fine_clusters_nums[i],
+                             mapping_op,
+                             device_memory);
+    n_clusters_done += fine_clusters_nums[i];
+  }
+  return n_clusters_done;
+}
+
+/**
+ * @brief One level of the hierarchical balanced k-means.
+ *
+ * Splits the data into about `n_clusters^(1 / depth)` mesoclusters, builds the fine clusters of
+ * every mesocluster with the remaining `depth - 1` levels, and fine-tunes all the clusters
+ * together on the level's data. A level of depth one builds the clusters directly.
+ *
+ * All the buffers are allocated from `device_memory`; the memory of a level is released before
+ * the next mesocluster is processed, so the peak footprint is dominated by the top level.
+ *
+ * @param[in] handle The raft handle.
+ * @param[in] params Structure containing the hyper-parameters
+ * @param depth number of levels of the hierarchy below and including this one
+ * @param dim number of columns in `centers` and `dataset`
+ * @param[in] dataset a device pointer to the source dataset [n_rows, dim]
+ * @param[in] dataset_norm a device pointer to the L2 norm of the mapped dataset [n_rows], or
+ *                         nullptr if the metric does not require it
+ * @param n_rows number of rows in the input
+ * @param[out] cluster_centers a device pointer to the found cluster centers [n_cluster, dim]
+ * @param n_clusters number of clusters to build
+ * @param mapping_op Mapping operation from T to MathT
+ * @param device_memory memory resource for all the temporary buffers
+ */
+template <typename T, typename MathT, typename IdxT, typename MappingOpT>
+void build_hierarchical_level(const raft::resources& handle,
+                              const kmeans_balanced_params& params,
+                              uint32_t depth,
+                              IdxT dim,
+                              const T* dataset,
+                              const MathT* dataset_norm,
+                              IdxT n_rows,
+                              MathT* cluster_centers,
+                              IdxT n_clusters,
+                              MappingOpT mapping_op,
+                              rmm::mr::device_memory_resource* device_memory)
+{
+  auto stream  = resource::get_cuda_stream(handle);
+  using LabelT = uint32_t;
+
+  /* Temporary workaround to cub::DeviceHistogram not supporting any type that isn't natively
+   * supported by atomicAdd: find a supported CounterT based on the IdxT. */
+  typedef typename std::conditional_t<sizeof(IdxT) == 8, unsigned long long int, unsigned int>
+    CounterT;
+
+  rmm::device_uvector<LabelT> labels(n_rows, stream, device_memory);
+  if (depth <= 1) {
+    rmm::device_uvector<CounterT> cluster_sizes(n_clusters, stream, device_memory);
     build_clusters(handle,
                    params,
                    dim,
-                   mc_trainset,
-                   k,
-                   fine_clusters_nums[i],
-                   mc_trainset_ccenters.data(),
-                   mc_trainset_labels.data(),
-                   mc_trainset_csizes_tmp.data(),
+                   dataset,
+                   n_rows,
+                   n_clusters,
+                   cluster_centers,
+                   labels.data(),
+                   cluster_sizes.data(),
                    mapping_op,
                    device_memory,
-                   mc_trainset_norm);
+                   dataset_norm);
+    return;
+  }
+
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "build_hierarchical_level(%zu, %u, depth = %u)",
+    static_cast<size_t>(n_rows),
+    n_clusters,
+    depth);
+
+  IdxT n_mesoclusters = std::min(
+    n_clusters,
+    std::max<IdxT>(static_cast<IdxT>(std::pow(double(n_clusters), 1.0 / double(depth)) + 0.5), 1));
+  RAFT_LOG_DEBUG("build_hierarchical: depth: %u, n_mesoclusters: %u", depth, n_mesoclusters);
+
+  {
+    // build coarse clusters (mesoclusters)
+    rmm::device_uvector<CounterT> mesocluster_sizes_buf(n_mesoclusters, stream, device_memory);
+    {
+      rmm::device_uvector<MathT> mesocluster_centers_buf(
+        n_mesoclusters * dim, stream, device_memory);
+      build_clusters(handle,
+                     params,
+                     dim,
+                     dataset,
+                     n_rows,
+                     n_mesoclusters,
+                     mesocluster_centers_buf.data(),
+                     labels.data(),
+                     mesocluster_sizes_buf.data(),
+                     mapping_op,
+                     device_memory,
+                     dataset_norm);
+    }
+    std::vector<CounterT> mesocluster_sizes(n_mesoclusters);
+    raft::copy(mesocluster_sizes.data(), mesocluster_sizes_buf.data(), n_mesoclusters, stream);
 
-    raft::copy(cluster_centers + (dim * fine_clusters_csum[i]),
-               mc_trainset_ccenters.data(),
-               fine_clusters_nums[i] * dim,
-               stream);
+    rmm::device_uvector<IdxT> grouped_ids(n_rows, stream, device_memory);
+    group_by_mesocluster(
+      handle, labels.data(), n_mesoclusters, n_rows, grouped_ids.data(), device_memory);
     resource::sync_stream(handle, stream);
-    n_clusters_done += fine_clusters_nums[i];
+
+    // build fine clusters
+    auto [mesocluster_size_max, fine_clusters_nums_max, fine_clusters_nums, fine_clusters_csum] =
+      arrange_fine_clusters(n_clusters, n_mesoclusters, n_rows, mesocluster_sizes.data());
+
+    const IdxT mesocluster_size_max_balanced = div_rounding_up_safe<size_t>(
+      2lu * size_t(n_rows), std::max<size_t>(size_t(n_mesoclusters), 1lu));
+    if (mesocluster_size_max > mesocluster_size_max_balanced) {
+      RAFT_LOG_WARN(
+        "build_hierarchical: built unbalanced mesoclusters (max_mesocluster_size == %u > %u). "
+        "At most %u points will be used for training within each mesocluster. "
+        "Consider increasing the number of training iterations `n_iters`.",
+        mesocluster_size_max,
+        mesocluster_size_max_balanced,
+        mesocluster_size_max_balanced);
+      RAFT_LOG_TRACE_VEC(mesocluster_sizes.data(), n_mesoclusters);
+      RAFT_LOG_TRACE_VEC(fine_clusters_nums.data(), n_mesoclusters);
+      mesocluster_size_max = mesocluster_size_max_balanced;
+    }
+    mesocluster_size_max = std::max(mesocluster_size_max, fine_clusters_nums_max);
+
+    auto n_clusters_done = build_fine_clusters(handle,
+                                               params,
+                                               depth - 1,
+                                               dim,
+                                               dataset,
+                                               dataset_norm,
+                                               grouped_ids.data(),
+                                               n_rows,
+                                               fine_clusters_nums.data(),
+                                               fine_clusters_csum.data(),
+                                               mesocluster_sizes.data(),
+                                               n_mesoclusters,
+                                               mesocluster_size_max,
+                                               cluster_centers,
+                                               mapping_op,
+                                               device_memory);
+    RAFT_EXPECTS(n_clusters_done == n_clusters, "Didn't process all clusters.");
   }
-  return n_clusters_done;
+
+  rmm::device_uvector<CounterT> cluster_sizes(n_clusters, stream, device_memory);
+
+  // Fine-tuning k-means for all clusters
+  //
+  // (*) Since the likely cluster centroids have been calculated hierarchically already, the number
+  // of iterations for fine-tuning kmeans for whole clusters should be reduced. However, there is a
+  // possibility that the clusters could be unbalanced here, in which case the actual number of
+  // iterations would be increased.
+  //
+  balancing_em_iters(handle,
+                     params,
+                     std::max<uint32_t>(params.n_iters / 10, 2),
+                     dim,
+                     dataset,
+                     dataset_norm,
+                     n_rows,
+                     n_clusters,
+                     cluster_centers,
+                     labels.data(),
+                     cluster_sizes.data(),
+                     5,
+                     MathT{0.2},
+                     mapping_op,
+                     device_memory);
 }
 
 /**
  * @brief Hierarchical balanced k-means
  *
+ * The clusters are built in `params.hierarchy_depth` levels (see `build_hierarchical_level`).
+ *
  * @tparam T      element type
  * @tparam MathT  type of the centroids and mapped data
  * @tparam IdxT   index type
- * @tparam LabelT label type
  * @tparam MappingOpT type of the mapping operation
  *
  * @param[in] handle The raft handle.
@@ -947,9 +1342,7 @@ auto build_fine_clusters(const raft::resources& handle,
  * @param n_rows number of rows in the input
  * @param[out] cluster_centers a device pointer to the found cluster centers [n_cluster, dim]
  * @param n_cluster
- * @param metric the distance type
  * @param mapping_op Mapping operation from T to MathT
- * @param stream
  */
 template <typename T, typename MathT, typename IdxT, typename MappingOpT>
 void build_hierarchical(const raft::resources& handle,
@@ -961,19 +1354,20 @@ void build_hierarchical(const raft::resources& handle,
                         IdxT n_clusters,
                         MappingOpT mapping_op)
 {
-  auto stream  = resource::get_cuda_stream(handle);
-  using LabelT = uint32_t;
+  auto stream = resource::get_cuda_stream(handle);
+  RAFT_EXPECTS(params.hierarchy_depth > 0, "The hierarchy depth must be positive.");
 
   common::nvtx::range<common::nvtx::domain::raft> fun_scope(
     "build_hierarchical(%zu, %u)", static_cast<size_t>(n_rows), n_clusters);
 
-  IdxT n_mesoclusters = std::min(n_clusters, static_cast<IdxT>(std::sqrt(n_clusters) + 0.5));
-  RAFT_LOG_DEBUG("build_hierarchical: n_mesoclusters: %u", n_mesoclusters);
-
-  rmm::mr::managed_memory_resource managed_memory;
   rmm::mr::device_memory_resource* device_memory = resource::get_workspace_resource(handle);
   auto [max_minibatch_size, mem_per_row] =
-    calc_minibatch_size<MathT>(n_clusters, n_rows, dim, params.metric, std::is_same_v<T, MathT>);
+    calc_minibatch_size<MathT>(n_clusters,
+                               n_rows,
+                               dim,
+                               params.metric,
+                               std::is_same_v<T, MathT>,
+                               kHalfGemm<T, MathT, MappingOpT>);
   auto pool_guard =
     raft::get_pool_memory_resource(device_memory, mem_per_row * size_t(max_minibatch_size));
   if (pool_guard) {
@@ -1000,98 +1394,17 @@ void build_hierarchical(const raft::resources& handle,
     dataset_norm = (const MathT*)dataset_norm_buf.data();
   }
 
-  /* Temporary workaround to cub::DeviceHistogram not supporting any type that isn't natively
-   * supported by atomicAdd: find a supported CounterT based on the IdxT. */
-  typedef typename std::conditional_t<sizeof(IdxT) == 8, unsigned long long int, unsigned int>
-    CounterT;
-
-  // build coarse clusters (mesoclusters)
-  rmm::device_uvector<LabelT> mesocluster_labels_buf(n_rows, stream, &managed_memory);
-  rmm::device_uvector<CounterT> mesocluster_sizes_buf(n_mesoclusters, stream, &managed_memory);
-  {
-    rmm::device_uvector<MathT> mesocluster_centers_buf(n_mesoclusters * dim, stream, device_memory);
-    build_clusters(handle,
-                   params,
-                   dim,
-                   dataset,
-                   n_rows,
-                   n_mesoclusters,
-                   mesocluster_centers_buf.data(),
-                   mesocluster_labels_buf.data(),
-                   mesocluster_sizes_buf.data(),
-                   mapping_op,
-                   device_memory,
-                   dataset_norm);
-  }
-
-  auto mesocluster_sizes  = mesocluster_sizes_buf.data();
-  auto mesocluster_labels = mesocluster_labels_buf.data();
-
-  resource::sync_stream(handle, stream);
-
-  // build fine clusters
-  auto [mesocluster_size_max, fine_clusters_nums_max, fine_clusters_nums, fine_clusters_csum] =
-    arrange_fine_clusters(n_clusters, n_mesoclusters, n_rows, mesocluster_sizes);
-
-  const IdxT mesocluster_size_max_balanced = div_rounding_up_safe<size_t>(
-    2lu * size_t(n_rows), std::max<size_t>(size_t(n_mesoclusters), 1lu));
-  if (mesocluster_size_max > mesocluster_size_max_balanced) {
-    RAFT_LOG_WARN(
-      "build_hierarchical: built unbalanced mesoclusters (max_mesocluster_size == %u > %u). "
-      "At most %u points will be used for training within each mesocluster. "
-      "Consider increasing the number of training iterations `n_iters`.",
-      mesocluster_size_max,
-      mesocluster_size_max_balanced,
-      mesocluster_size_max_balanced);
-    RAFT_LOG_TRACE_VEC(mesocluster_sizes, n_mesoclusters);
-    RAFT_LOG_TRACE_VEC(fine_clusters_nums.data(), n_mesoclusters);
-    mesocluster_size_max = mesocluster_size_max_balanced;
-  }
-
-  auto n_clusters_done = build_fine_clusters(handle,
-                                             params,
-                                             dim,
-                                             dataset,
-                                             dataset_norm,
-                                             mesocluster_labels,
-                                             n_rows,
-                                             fine_clusters_nums.data(),
-                                             fine_clusters_csum.data(),
-                                             mesocluster_sizes,
-                                             n_mesoclusters,
-                                             mesocluster_size_max,
-                                             fine_clusters_nums_max,
-                                             cluster_centers,
-                                             mapping_op,
-                                             &managed_memory,
-                                             device_memory);
-  RAFT_EXPECTS(n_clusters_done == n_clusters, "Didn't process all clusters.");
-
-  rmm::device_uvector<CounterT> cluster_sizes(n_clusters, stream, device_memory);
-  rmm::device_uvector<LabelT> labels(n_rows, stream, device_memory);
-
-  // Fine-tuning k-means for all clusters
-  //
-  // (*) Since the likely cluster centroids have been calculated hierarchically already, the number
-  // of iterations for fine-tuning kmeans for whole clusters should be reduced. However, there is a
-  // possibility that the clusters could be unbalanced here, in which case the actual number of
-  // iterations would be increased.
-  //
-  balancing_em_iters(handle,
-                     params,
-                     std::max<uint32_t>(params.n_iters / 10, 2),
-                     dim,
-                     dataset,
-                     dataset_norm,
-                     n_rows,
-                     n_clusters,
-                     cluster_centers,
-                     labels.data(),
-                     cluster_sizes.data(),
-                     5,
-                     MathT{0.2},
-                     mapping_op,
-                     device_memory);
+  build_hierarchical_level(handle,
+                           params,
+                           params.hierarchy_depth,
+                           dim,
+                           dataset,
+                           dataset_norm,
+                           n_rows,
+                           cluster_centers,
+                           n_clusters,
+                           mapping_op,
+                           device_memory);
 }
 
 }  // namespace raft::cluster::detail
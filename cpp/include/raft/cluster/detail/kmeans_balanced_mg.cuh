@@ -0,0 +1,269 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/cluster/detail/kmeans_balanced.cuh>
+#include <raft/core/comms.hpp>
+#include <raft/core/resource/comms.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+
+#include <rmm/device_scalar.hpp>
+#include <rmm/device_uvector.hpp>
+
+#include <type_traits>
+
+namespace raft::cluster::detail {
+
+/**
+ * @brief Sum the per-rank cluster centers weighted by the per-rank cluster sizes.
+ *
+ * On entry, `centers` and `cluster_sizes` describe the local part of the dataset; on exit, they
+ * describe the whole distributed dataset and are the same on all ranks.
+ */
+template <typename MathT, typename IdxT, typename CounterT>
+void allreduce_centers_and_sizes(const raft::resources& handle,
+                                 MathT* centers,
+                                 CounterT* cluster_sizes,
+                                 IdxT n_clusters,
+                                 IdxT dim)
+{
+  // NB: the counter types supported by atomicAdd coincide in size with the fixed-width ones.
+  using CommCounterT = std::conditional_t<sizeof(CounterT) == 8, uint64_t, uint32_t>;
+  static_assert(sizeof(CommCounterT) == sizeof(CounterT));
+  const auto& comms = resource::get_comms(handle);
+  auto stream       = resource::get_cuda_stream(handle);
+  auto sizes        = reinterpret_cast<CommCounterT*>(cluster_sizes);
+
+  raft::linalg::matrixVectorOp(
+    centers, centers, cluster_sizes, dim, n_clusters, true, false, raft::mul_op(), stream);
+  comms.allreduce(centers, centers, size_t(n_clusters) * size_t(dim), comms::op_t::SUM, stream);
+  comms.allreduce(sizes, sizes, size_t(n_clusters), comms::op_t::SUM, stream);
+  RAFT_EXPECTS(comms.sync_stream(stream) == comms::status_t::SUCCESS,
+               "kmeans_balanced: allreduce of the cluster centers failed");
+  raft::linalg::matrixVectorOp(centers,
+                               centers,
+                               cluster_sizes,
+                               dim,
+                               n_clusters,
+                               true,
+                               false,
+                               raft::div_checkzero_op(),
+                               stream);
+}
+
+/**
+ * @brief Expectation-maximization-balancing over a dataset distributed across the ranks of the
+ * communicator attached to the handle.
+ *
+ * The same as `balancing_em_iters`, but the centers are computed from the data of all ranks. The
+ * balancing step is done on the root rank using its local data and the global cluster sizes, and
+ * its outcome is broadcast to the other ranks.
+ *
+ * Note, the `cluster_centers` is assumed to be already initialized and equal on all ranks.
+ */
+template <typename T,
+          typename MathT,
+          typename IdxT,
+          typename LabelT,
+          typename CounterT,
+          typename MappingOpT>
+void balancing_em_iters_mg(const raft::resources& handle,
+                           const kmeans_balanced_params& params,
+                           uint32_t n_iters,
+                           IdxT dim,
+                           const T* dataset,
+                           const MathT* dataset_norm,
+                           IdxT n_rows,
+                           IdxT n_clusters,
+                           MathT* cluster_centers,
+                           LabelT* cluster_labels,
+                           CounterT* cluster_sizes,
+                           uint32_t balancing_pullback,
+                           MathT balancing_threshold,
+                           MappingOpT mapping_op,
+                           rmm::mr::device_memory_resource* device_memory)
+{
+  const auto& comms = resource::get_comms(handle);
+  const int rank    = comms.get_rank();
+  auto stream       = resource::get_cuda_stream(handle);
+  rmm::device_scalar<int> adjusted(0, stream, device_memory);
+
+  uint32_t balancing_counter = balancing_pullback;
+  for (uint32_t iter = 0; iter < n_iters; iter++) {
+    // Balancing step - done on the root rank; all ranks take the same decision
+    if (iter > 0) {
+      if (rank == 0) {
+        adjusted.set_value_async(adjust_centers(cluster_centers,
+                                                n_clusters,
+                                                dim,
+                                                dataset,
+                                                n_rows,
+                                                cluster_labels,
+                                                cluster_sizes,
+                                                balancing_threshold,
+                                                mapping_op,
+                                                stream,
+                                                device_memory)
+                                   ? 1
+                                   : 0,
+                                 stream);
+      }
+      comms.bcast(adjusted.data(), 1, 0, stream);
+      comms.bcast(cluster_centers, size_t(n_clusters) * size_t(dim), 0, stream);
+      if (adjusted.value(stream) != 0 && balancing_counter++ >= balancing_pullback) {
+        balancing_counter -= balancing_pullback;
+        n_iters++;
+      }
+    }
+    switch (params.metric) {
+      // For some metrics, cluster calculation and adjustment tends to favor zero center vectors.
+      // To avoid converging to zero, we normalize the center vectors on every iteration.
+      case raft::distance::DistanceType::InnerProduct:
+      case raft::distance::DistanceType::CosineExpanded:
+      case raft::distance::DistanceType::CorrelationExpanded: {
+        auto clusters_in_view = raft::make_device_matrix_view<const MathT, IdxT, raft::row_major>(
+          cluster_centers, n_clusters, dim);
+        auto clusters_out_view = raft::make_device_matrix_view<MathT, IdxT, raft::row_major>(
+          cluster_centers, n_clusters, dim);
+        raft::linalg::row_normalize(
+          handle, clusters_in_view, clusters_out_view, raft::linalg::L2Norm);
+        break;
+      }
+      default: break;
+    }
+    // E: Expectation step - predict the labels of the local data
+    predict(handle,
+            params,
+            cluster_centers,
+            n_clusters,
+            dim,
+            dataset,
+            n_rows,
+            cluster_labels,
+            mapping_op,
+            device_memory,
+            dataset_norm);
+    // M: Maximization step - calculate optimal cluster centers over all ranks
+    calc_centers_and_sizes(handle,
+                           cluster_centers,
+                           cluster_sizes,
+                           n_clusters,
+                           dim,
+                           dataset,
+                           n_rows,
+                           cluster_labels,
+                           true,
+                           mapping_op,
+                           device_memory);
+    allreduce_centers_and_sizes(handle, cluster_centers, cluster_sizes, n_clusters, dim);
+  }
+}
+
+/**
+ * @brief Hierarchical balanced k-means over a dataset distributed across the ranks of the
+ * communicator attached to the handle.
+ *
+ * The initial centers are found by `build_hierarchical` on the local data of the root rank and
+ * broadcast; they are then refined by the data-parallel EM iterations over the data of all ranks.
+ * The resulting centers are the same on all ranks.
+ *
+ * @param[in] handle The raft handle with an initialized communicator.
+ * @param[in] params Structure containing the hyper-parameters
+ * @param dim number of columns in `centers` and `dataset`
+ * @param[in] dataset a device pointer to the local part of the dataset [n_rows, dim]
+ * @param n_rows number of rows in the local part of the dataset
+ * @param[out] cluster_centers a device pointer to the found cluster centers [n_cluster, dim]
+ * @param n_clusters
+ * @param mapping_op Mapping operation from T to MathT
+ */
+template <typename T, typename MathT, typename IdxT, typename MappingOpT>
+void build_hierarchical_mg(const raft::resources& handle,
+                           const kmeans_balanced_params& params,
+                           IdxT dim,
+                           const T* dataset,
+                           IdxT n_rows,
+                           MathT* cluster_centers,
+                           IdxT n_clusters,
+                           MappingOpT mapping_op)
+{
+  using LabelT      = uint32_t;
+  using CounterT    = std::conditional_t<sizeof(IdxT) == 8, unsigned long long int, unsigned int>;
+  const auto& comms = resource::get_comms(handle);
+  auto stream       = resource::get_cuda_stream(handle);
+
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "build_hierarchical_mg(%zu, %u, rank = %d)",
+    static_cast<size_t>(n_rows),
+    n_clusters,
+    comms.get_rank());
+
+  if (comms.get_rank() == 0) {
+    build_hierarchical(
+      handle, params, dim, dataset, n_rows, cluster_centers, n_clusters, mapping_op);
+  }
+  comms.bcast(cluster_centers, size_t(n_clusters) * size_t(dim), 0, stream);
+
+  rmm::mr::device_memory_resource* device_memory = resource::get_workspace_resource(handle);
+  auto [max_minibatch_size, mem_per_row] =
+    calc_minibatch_size<MathT>(n_clusters,
+                               n_rows,
+                               dim,
+                               params.metric,
+                               std::is_same_v<T, MathT>,
+                               kHalfGemm<T, MathT, MappingOpT>);
+  auto pool_guard =
+    raft::get_pool_memory_resource(device_memory, mem_per_row * size_t(max_minibatch_size));
+
+  const MathT* dataset_norm = nullptr;
+  rmm::device_uvector<MathT> dataset_norm_buf(0, stream, device_memory);
+  if (params.metric == raft::distance::DistanceType::L2Expanded ||
+      params.metric == raft::distance::DistanceType::L2SqrtExpanded) {
+    dataset_norm_buf.resize(n_rows, stream);
+    for (IdxT offset = 0; offset < n_rows; offset += max_minibatch_size) {
+      IdxT minibatch_size = std::min<IdxT>(max_minibatch_size, n_rows - offset);
+      compute_norm(handle,
+                   dataset_norm_buf.data() + offset,
+                   dataset + dim * offset,
+                   dim,
+                   minibatch_size,
+                   mapping_op,
+                   device_memory);
+    }
+    dataset_norm = dataset_norm_buf.data();
+  }
+
+  rmm::device_uvector<CounterT> cluster_sizes(n_clusters, stream, device_memory);
+  rmm::device_uvector<LabelT> labels(n_rows, stream, device_memory);
+  balancing_em_iters_mg(handle,
+                        params,
+                        std::max<uint32_t>(params.n_iters / 10, 2),
+                        dim,
+                        dataset,
+                        dataset_norm,
+                        n_rows,
+                        n_clusters,
+                        cluster_centers,
+                        labels.data(),
+                        cluster_sizes.data(),
+                        5,
+                        MathT{0.2},
+                        mapping_op,
+                        device_memory);
+}
+
+}  // namespace raft::cluster::detail
@@ -0,0 +1,387 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/cluster/detail/kmeans_common.cuh>
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/kvp.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/linalg/norm.cuh>
+#include <raft/linalg/subtract.cuh>
+#include <raft/matrix/gather.cuh>
+#include <raft/util/cuda_utils.cuh>
+#include <rmm/device_uvector.hpp>
+
+#include <thrust/copy.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/reduce.h>
+#include <thrust/remove.h>
+#include <thrust/sequence.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace raft::cluster::detail {
+
+// =========================================================
+// Bound-based pruning of the k-means iterations, as described in
+// "Making k-means even faster", 2010, G. Hamerly, SDM.
+//
+// For every sample x, the algorithm keeps an upper bound u(x) of the distance to its centroid a(x)
+// (stored as the value of its minClusterAndDistance pair) and a lower bound l(x) of the distance
+// to the second closest centroid. After the centroids move, u(x) grows by the move of a(x) and
+// l(x) shrinks by the largest move. The sample keeps its centroid, without computing any
+// distance, when u(x) <= max(l(x), s(a(x))), where s(c) is half the distance from c to the closest
+// other centroid. The bounds are Euclidean (not squared) distances.
+// =========================================================
+
+/**
+ * The index and value of the smallest entry and the value of the second smallest entry of every
+ * row of the `n_rows x n_cols` row-major matrix `dist`, one warp per row. The results of row `r`
+ * are written at the position `rows[r]` (`r` when `rows` is nullptr); `min` may be nullptr.
+ */
+template <typename DataT, typename IndexT>
+__global__ void top2_kernel(const DataT* dist,
+                            IndexT n_rows,
+                            IndexT n_cols,
+                            const IndexT* rows,
+                            raft::KeyValuePair<IndexT, DataT>* min,
+                            DataT* second)
+{
+  const IndexT r = (IndexT(blockIdx.x) * blockDim.x + threadIdx.x) / WarpSize;
+  const int lane = threadIdx.x % WarpSize;
+  if (r >= n_rows) { return; }
+
+  DataT best      = std::numeric_limits<DataT>::max();
+  DataT next      = std::numeric_limits<DataT>::max();
+  IndexT best_idx = 0;
+  for (IndexT j = lane; j < n_cols; j += WarpSize) {
+    const DataT v = dist[size_t(r) * n_cols + j];
+    if (v < best) {
+      next     = best;
+      best     = v;
+      best_idx = j;
+    } else if (v < next) {
+      next = v;
+    }
+  }
+  for (int offset = WarpSize / 2; offset > 0; offset /= 2) {
+    const DataT other_best = shfl_xor(best, offset);
+    const DataT other_next = shfl_xor(next, offset);
+    const IndexT other_idx = shfl_xor(best_idx, offset);
+    if (other_best < best || (other_best == best && other_idx < best_idx)) {
+      next     = raft::min(best, other_next);
+      best     = other_best;
+      best_idx = other_idx;
+    } else {
+      next = raft::min(next, other_best);
+    }
+  }
+  if (lane == 0) {
+    const IndexT out = rows == nullptr ? r : rows[r];
+    if (min != nullptr) {
+      min[out].key   = best_idx;
+      min[out].value = best;
+    }
+    second[out] = next;
+  }
+}
+
+/** Loosen the bounds by the moves of the centroids and flag the samples that may change cluster. */
+template <typename DataT, typename IndexT>
+__global__ void bounds_update_kernel(IndexT n_samples,
+                                     raft::KeyValuePair<IndexT, DataT>* min_cluster_and_bound,
+                                     DataT* lower,
+                                     const DataT* centroid_shift,
+                                     DataT max_shift,
+                                     const DataT* neighbor_dist,
+                                     uint8_t* flags)
+{
+  const IndexT i = IndexT(blockIdx.x) * blockDim.x + threadIdx.x;
+  if (i >= n_samples) { return; }
+  auto kvp                       = min_cluster_and_bound[i];
+  const DataT u                  = kvp.value + centroid_shift[kvp.key];
+  const DataT l                  = lower[i] - max_shift;
+  min_cluster_and_bound[i].value = u;
+  lower[i]                       = l;
+  flags[i]                       = u > raft::max(l, DataT(0.5) * neighbor_dist[kvp.key]);
+}
+
+/**
+ * Tighten the upper bounds of the flagged samples to the exact distances to their centroids, one
+ * warp per sample, and clear the flags of the samples that keep their cluster.
+ */
+template <typename DataT, typename IndexT>
+__global__ void bounds_tighten_kernel(const DataT* X,
+                                      const DataT* centroids,
+                                      IndexT n_features,
+                                      const IndexT* candidates,
+                                      IndexT n_candidates,
+                                      raft::KeyValuePair<IndexT, DataT>* min_cluster_and_bound,
+                                      const DataT* lower,
+                                      const DataT* neighbor_dist,
+                                      uint8_t* flags)
+{
+  const IndexT r = (IndexT(blockIdx.x) * blockDim.x + threadIdx.x) / WarpSize;
+  const int lane = threadIdx.x % WarpSize;
+  if (r >= n_candidates) { return; }
+  const IndexT i = candidates[r];
+  const IndexT a = min_cluster_and_bound[i].key;
+
+  DataT acc = 0;
+  for (IndexT j = lane; j < n_features; j += WarpSize) {
+    const DataT diff = X[size_t(i) * n_features + j] - centroids[size_t(a) * n_features + j];
+    acc += diff * diff;
+  }
+  for (int offset = WarpSize / 2; offset > 0; offset /= 2) {
+    acc += shfl_xor(acc, offset);
+  }
+  if (lane == 0) {
+    const DataT u                  = raft::sqrt(acc);
+    min_cluster_and_bound[i].value = u;
+    flags[i]                       = u > raft::max(lower[i], DataT(0.5) * neighbor_dist[a]);
+  }
+}
+
+/** The bounds and the buffers of the pruned k-means iterations. */
+template <typename DataT, typename IndexT>
+struct kmeans_bounds {
+  kmeans_bounds(raft::resources const& handle,
+                IndexT n_samples,
+                IndexT n_features,
+                IndexT n_clusters,
+                int batch_samples)
+    : batch_size(getDataBatchSize(batch_samples, n_samples)),
+      lower(raft::make_device_vector<DataT, IndexT>(handle, n_samples)),
+      flags(raft::make_device_vector<uint8_t, IndexT>(handle, n_samples)),
+      candidates(raft::make_device_vector<IndexT, IndexT>(handle, n_samples)),
+      centroid_shift(raft::make_device_vector<DataT, IndexT>(handle, n_clusters)),
+      neighbor_dist(raft::make_device_vector<DataT, IndexT>(handle, n_clusters)),
+      centroid_diff(raft::make_device_matrix<DataT, IndexT>(handle, n_clusters, n_features)),
+      centroid_dist(raft::make_device_matrix<DataT, IndexT>(handle, n_clusters, n_clusters)),
+      batch_x(raft::make_device_matrix<DataT, IndexT>(handle, batch_size, n_features)),
+      batch_dist(raft::make_device_matrix<DataT, IndexT>(handle, batch_size, n_clusters))
+  {
+  }
+
+  IndexT batch_size;
+  /** The lower bounds of the distances to the second closest centroids. */
+  raft::device_vector<DataT, IndexT> lower;
+  raft::device_vector<uint8_t, IndexT> flags;
+  /** The samples whose distances have to be computed. */
+  raft::device_vector<IndexT, IndexT> candidates;
+  /** The distances the centroids moved during the last update. */
+  raft::device_vector<DataT, IndexT> centroid_shift;
+  DataT max_shift = 0;
+  /** The distances from the centroids to the closest other centroids. */
+  raft::device_vector<DataT, IndexT> neighbor_dist;
+  raft::device_matrix<DataT, IndexT> centroid_diff;
+  raft::device_matrix<DataT, IndexT> centroid_dist;
+  raft::device_matrix<DataT, IndexT> batch_x;
+  raft::device_matrix<DataT, IndexT> batch_dist;
+};
+
+/**
+ * Compute the closest centroids and the bounds of the first `n_candidates` samples of
+ * `bounds.candidates` from the distances to all the centroids.
+ */
+template <typename DataT, typename IndexT>
+void bounds_assign_candidates(
+  raft::resources const& handle,
+  raft::device_matrix_view<const DataT, IndexT> X,
+  raft::device_matrix_view<const DataT, IndexT> centroids,
+  raft::device_vector_view<raft::KeyValuePair<IndexT, DataT>, IndexT> minClusterAndDistance,
+  kmeans_bounds<DataT, IndexT>& bounds,
+  IndexT n_candidates,
+  rmm::device_uvector<char>& workspace)
+{
+  cudaStream_t stream         = resource::get_cuda_stream(handle);
+  auto n_features             = X.extent(1);
+  auto n_clusters             = centroids.extent(0);
+  constexpr int kBlockSize    = 256;
+  constexpr int kRowsPerBlock = kBlockSize / WarpSize;
+
+  for (IndexT offset = 0; offset < n_candidates; offset += bounds.batch_size) {
+    IndexT n_rows      = std::min<IndexT>(bounds.batch_size, n_candidates - offset);
+    const IndexT* rows = bounds.candidates.data_handle() + offset;
+    raft::matrix::gather((DataT*)X.data_handle(),
+                         n_features,
+                         X.extent(0),
+                         rows,
+                         n_rows,
+                         bounds.batch_x.data_handle(),
+                         stream);
+    auto batch_dist = raft::make_device_matrix_view<DataT, IndexT>(
+      bounds.batch_dist.data_handle(), n_rows, n_clusters);
+    pairwise_distance_kmeans<DataT, IndexT>(
+      handle,
+      raft::make_device_matrix_view<const DataT, IndexT>(
+        bounds.batch_x.data_handle(), n_rows, n_features),
+      centroids,
+      batch_dist,
+      workspace,
+      raft::distance::DistanceType::L2SqrtExpanded);
+    top2_kernel<<<raft::ceildiv<IndexT>(n_rows, kRowsPerBlock), kBlockSize, 0, stream>>>(
+      batch_dist.data_handle(),
+      n_rows,
+      n_clusters,
+      rows,
+      minClusterAndDistance.data_handle(),
+      bounds.lower.data_handle());
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+  }
+}
+
+/** Compute the closest centroids and the bounds of all the samples. */
+template <typename DataT, typename IndexT>
+void bounds_assign_all(
+  raft::resources const& handle,
+  raft::device_matrix_view<const DataT, IndexT> X,
+  raft::device_matrix_view<const DataT, IndexT> centroids,
+  raft::device_vector_view<raft::KeyValuePair<IndexT, DataT>, IndexT> minClusterAndDistance,
+  kmeans_bounds<DataT, IndexT>& bounds,
+  rmm::device_uvector<char>& workspace)
+{
+  thrust::sequence(resource::get_thrust_policy(handle),
+                   bounds.candidates.data_handle(),
+                   bounds.candidates.data_handle() + X.extent(0));
+  bounds_assign_candidates(
+    handle, X, centroids, minClusterAndDistance, bounds, X.extent(0), workspace);
+}
+
+/**
+ * Update the closest centroids of the samples after the centroids moved, computing the distances
+ * of only the samples whose bounds do not prove that they keep their centroid.
+ *
+ * @return the number of samples whose distances to all the centroids were computed
+ */
+template <typename DataT, typename IndexT>
+auto bounds_assign(
+  raft::resources const& handle,
+  raft::device_matrix_view<const DataT, IndexT> X,
+  raft::device_matrix_view<const DataT, IndexT> centroids,
+  raft::device_vector_view<raft::KeyValuePair<IndexT, DataT>, IndexT> minClusterAndDistance,
+  kmeans_bounds<DataT, IndexT>& bounds,
+  rmm::device_uvector<char>& workspace) -> IndexT
+{
+  cudaStream_t stream         = resource::get_cuda_stream(handle);
+  auto n_samples              = X.extent(0);
+  constexpr int kBlockSize    = 256;
+  constexpr int kRowsPerBlock = kBlockSize / WarpSize;
+
+  bounds_update_kernel<<<raft::ceildiv<IndexT>(n_samples, kBlockSize), kBlockSize, 0, stream>>>(
+    n_samples,
+    minClusterAndDistance.data_handle(),
+    bounds.lower.data_handle(),
+    bounds.centroid_shift.data_handle(),
+    bounds.max_shift,
+    bounds.neighbor_dist.data_handle(),
+    bounds.flags.data_handle());
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+  auto policy      = resource::get_thrust_policy(handle);
+  IndexT* cand     = bounds.candidates.data_handle();
+  IndexT n_flagged = thrust::copy_if(policy,
+                                     thrust::make_counting_iterator<IndexT>(0),
+                                     thrust::make_counting_iterator<IndexT>(n_samples),
+                                     bounds.flags.data_handle(),
+                                     cand,
+                                     raft::identity_op{}) -
+                     cand;
+  if (n_flagged == 0) { return 0; }
+
+  auto n_blocks = raft::ceildiv<IndexT>(n_flagged, kRowsPerBlock);
+  bounds_tighten_kernel<<<n_blocks, kBlockSize, 0, stream>>>(X.data_handle(),
+                                                             centroids.data_handle(),
+                                                             X.extent(1),
+                                                             cand,
+                                                             n_flagged,
+                                                             minClusterAndDistance.data_handle(),
+                                                             bounds.lower.data_handle(),
+                                                             bounds.neighbor_dist.data_handle(),
+                                                             bounds.flags.data_handle());
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+  const uint8_t* flags = bounds.flags.data_handle();
+  IndexT n_candidates =
+    thrust::remove_if(
+      policy, cand, cand + n_flagged, [flags] __device__(IndexT i) { return flags[i] == 0; }) -
+    cand;
+
+  bounds_assign_candidates(
+    handle, X, centroids, minClusterAndDistance, bounds, n_candidates, workspace);
+  return n_candidates;
+}
+
+/**
+ * Record the moves of the centroids from `old_centroids` to `new_centroids` and the distances
+ * between the new centroids, for the next call of bounds_assign.
+ */
+template <typename DataT, typename IndexT>
+void bounds_update_centroids(raft::resources const& handle,
+                             raft::device_matrix_view<const DataT, IndexT> old_centroids,
+                             raft::device_matrix_view<const DataT, IndexT> new_centroids,
+                             kmeans_bounds<DataT, IndexT>& bounds,
+                             rmm::device_uvector<char>& workspace)
+{
+  cudaStream_t stream         = resource::get_cuda_stream(handle);
+  auto n_clusters             = new_centroids.extent(0);
+  auto n_features             = new_centroids.extent(1);
+  constexpr int kBlockSize    = 256;
+  constexpr int kRowsPerBlock = kBlockSize / WarpSize;
+
+  raft::linalg::subtract(bounds.centroid_diff.data_handle(),
+                         new_centroids.data_handle(),
+                         old_centroids.data_handle(),
+                         new_centroids.size(),
+                         stream);
+  raft::linalg::rowNorm(bounds.centroid_shift.data_handle(),
+                        bounds.centroid_diff.data_handle(),
+                        n_features,
+                        n_clusters,
+                        raft::linalg::L2Norm,
+                        true,
+                        stream,
+                        raft::sqrt_op{});
+  bounds.max_shift = thrust::reduce(resource::get_thrust_policy(handle),
+                                    bounds.centroid_shift.data_handle(),
+                                    bounds.centroid_shift.data_handle() + n_clusters,
+                                    DataT(0),
+                                    raft::max_op{});
+
+  // the closest other centroid is the second closest one, the closest being the centroid itself
+  pairwise_distance_kmeans<DataT, IndexT>(handle,
+                                          new_centroids,
+                                          new_centroids,
+                                          bounds.centroid_dist.view(),
+                                          workspace,
+                                          raft::distance::DistanceType::L2SqrtExpanded);
+  top2_kernel<<<raft::ceildiv<IndexT>(n_clusters, kRowsPerBlock), kBlockSize, 0, stream>>>(
+    bounds.centroid_dist.data_handle(),
+    n_clusters,
+    n_clusters,
+    static_cast<const IndexT*>(nullptr),
+    static_cast<raft::KeyValuePair<IndexT, DataT>*>(nullptr),
+    bounds.neighbor_dist.data_handle());
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+}  // namespace raft::cluster::detail
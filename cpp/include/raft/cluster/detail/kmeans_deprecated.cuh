@@ -206,7 +206,7 @@ static __global__ void minDistances(index_type_t n,
     codes[i] = code_min;
 
     // Increment cluster sizes
-    atomicAdd(clusterSizes + code_min, 1);
+    atomicAddWarp(clusterSizes + code_min, index_type_t{1});
 
     // Move to another row
     i += blockDim.x * gridDim.x;
@@ -281,7 +281,7 @@ static __global__ void computeClusterSizes(index_type_t n,
 {
   index_type_t i = threadIdx.x + blockIdx.x * blockDim.x;
   while (i < n) {
-    atomicAdd(clusterSizes + codes[i], 1);
+    atomicAddWarp(clusterSizes + codes[i], index_type_t{1});
     i += blockDim.x * gridDim.x;
   }
 }
@@ -0,0 +1,765 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/cluster/detail/kmeans.cuh>
+#include <raft/cluster/detail/kmeans_common.cuh>
+#include <raft/cluster/kmeans_types.hpp>
+#include <raft/common/nvtx.hpp>
+#include <raft/core/comms.hpp>
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/host_mdspan.hpp>
+#include <raft/core/kvp.hpp>
+#include <raft/core/logger.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/comms.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/linalg/map.cuh>
+#include <raft/linalg/map_then_reduce.cuh>
+#include <raft/linalg/matrix_vector_op.cuh>
+#include <raft/linalg/norm.cuh>
+#include <raft/linalg/unary_op.cuh>
+#include <raft/random/rng.cuh>
+#include <raft/util/cudart_utils.hpp>
+#include <rmm/device_scalar.hpp>
+#include <rmm/device_uvector.hpp>
+
+#include <thrust/fill.h>
+#include <thrust/transform.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace raft::cluster::detail {
+
+// =========================================================
+// Multi-GPU k-means: every rank of the communicator attached to the handle holds a part of the
+// dataset. The ranks agree on all the random choices by drawing them from generators seeded
+// identically, and on all the centroids by combining the per-rank contributions with allreduce.
+// =========================================================
+
+/** Sum `buf` over all the ranks, in place. */
+template <typename T>
+void allreduce_sum_mg(raft::resources const& handle, T* buf, size_t count)
+{
+  const auto& comms = resource::get_comms(handle);
+  auto stream       = resource::get_cuda_stream(handle);
+  comms.allreduce(buf, buf, count, comms::op_t::SUM, stream);
+  RAFT_EXPECTS(comms.sync_stream(stream) == comms::status_t::SUCCESS,
+               "KMeans.fit_mg: allreduce failed");
+}
+
+/**
+ * The offsets of the local parts of the dataset in the global one: the rows of rank `r` are the
+ * global rows `[offsets[r], offsets[r + 1])`.
+ */
+template <typename IndexT>
+auto local_offsets_mg(raft::resources const& handle, IndexT n_local_samples)
+  -> std::vector<int64_t>
+{
+  const auto& comms = resource::get_comms(handle);
+  auto stream       = resource::get_cuda_stream(handle);
+  const int n_ranks = comms.get_size();
+
+  auto n_local = raft::make_device_scalar<int64_t>(handle, n_local_samples);
+  auto sizes   = raft::make_device_vector<int64_t, int>(handle, n_ranks);
+  comms.allgather(n_local.data_handle(), sizes.data_handle(), 1, stream);
+  RAFT_EXPECTS(comms.sync_stream(stream) == comms::status_t::SUCCESS,
+               "KMeans.fit_mg: allgather of the sizes of the local datasets failed");
+
+  std::vector<int64_t> offsets(n_ranks + 1, 0);
+  raft::copy(offsets.data() + 1, sizes.data_handle(), n_ranks, stream);
+  resource::sync_stream(handle, stream);
+  for (int r = 0; r < n_ranks; r++) {
+    offsets[r + 1] += offsets[r];
+  }
+  return offsets;
+}
+
+/**
+ * Copy the global rows `rows` of the distributed dataset into `out` (`rows.size() x n_features`)
+ * on all ranks: every rank fills the rows it holds, zeroes the others, and the results are summed.
+ */
+template <typename DataT, typename IndexT>
+void gather_rows_mg(raft::resources const& handle,
+                    raft::device_matrix_view<const DataT, IndexT> X,
+                    const std::vector<int64_t>& offsets,
+                    const std::vector<int64_t>& rows,
+                    raft::device_matrix_view<DataT, IndexT> out)
+{
+  auto stream        = resource::get_cuda_stream(handle);
+  const int rank     = resource::get_comms(handle).get_rank();
+  const IndexT dim   = X.extent(1);
+  const IndexT n_out = rows.size();
+  RAFT_EXPECTS(out.extent(0) == n_out && out.extent(1) == dim, "Incompatible output shape");
+
+  std::vector<IndexT> h_local_rows(n_out);
+  for (IndexT i = 0; i < n_out; i++) {
+    const bool is_local = offsets[rank] <= rows[i] && rows[i] < offsets[rank + 1];
+    h_local_rows[i]     = is_local ? IndexT(rows[i] - offsets[rank]) : IndexT(-1);
+  }
+  auto local_rows = raft::make_device_vector<IndexT, IndexT>(handle, n_out);
+  raft::copy(local_rows.data_handle(), h_local_rows.data(), n_out, stream);
+
+  const DataT* x      = X.data_handle();
+  const IndexT* local = local_rows.data_handle();
+  raft::linalg::map_offset(
+    handle,
+    raft::make_device_vector_view<DataT, IndexT>(out.data_handle(), n_out * dim),
+    [=] __device__(IndexT i) {
+      const IndexT row = local[i / dim];
+      return row < 0 ? DataT(0) : x[size_t(row) * dim + i % dim];
+    });
+  allreduce_sum_mg(handle, out.data_handle(), out.size());
+}
+
+/** Draw `n` distinct global rows uniformly at random; the same on all ranks with the same `gen`. */
+inline auto sample_rows_mg(std::mt19937& gen, int64_t n_global_samples, int64_t n)
+  -> std::vector<int64_t>
+{
+  std::uniform_int_distribution<int64_t> dis(0, n_global_samples - 1);
+  std::set<int64_t> chosen;
+  std::vector<int64_t> rows;
+  rows.reserve(n);
+  while (int64_t(rows.size()) < n) {
+    auto row = dis(gen);
+    if (chosen.insert(row).second) { rows.push_back(row); }
+  }
+  return rows;
+}
+
+/** Normalize the weights so that they sum up to the number of samples of the whole dataset. */
+template <typename DataT, typename IndexT>
+void checkWeight_mg(raft::resources const& handle,
+                    raft::device_vector_view<DataT, IndexT> weight,
+                    int64_t n_global_samples)
+{
+  cudaStream_t stream = resource::get_cuda_stream(handle);
+  auto wt_aggr        = raft::make_device_scalar<DataT>(handle, 0);
+  raft::linalg::mapThenSumReduce(
+    wt_aggr.data_handle(), weight.extent(0), raft::identity_op{}, stream, weight.data_handle());
+  allreduce_sum_mg(handle, wt_aggr.data_handle(), 1);
+
+  DataT wt_sum = 0;
+  raft::copy(&wt_sum, wt_aggr.data_handle(), 1, stream);
+  resource::sync_stream(handle, stream);
+
+  if (wt_sum != DataT(n_global_samples)) {
+    RAFT_LOG_DEBUG(
+      "[Warning!] KMeans: normalizing the user provided sample weight to "
+      "sum up to %zu samples",
+      size_t(n_global_samples));
+
+    auto scale = static_cast<DataT>(n_global_samples) / wt_sum;
+    raft::linalg::unaryOp(weight.data_handle(),
+                          weight.data_handle(),
+                          weight.extent(0),
+                          raft::mul_const_op<DataT>{scale},
+                          stream);
+  }
+}
+
+/** Select `n_clusters` samples of the distributed dataset randomly. */
+template <typename DataT, typename IndexT>
+void initRandom_mg(raft::resources const& handle,
+                   const KMeansParams& params,
+                   raft::device_matrix_view<const DataT, IndexT> X,
+                   const std::vector<int64_t>& offsets,
+                   raft::device_matrix_view<DataT, IndexT> centroids)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope("initRandom_mg");
+  std::mt19937 gen(params.rng_state.seed);
+  auto rows = sample_rows_mg(gen, offsets.back(), params.n_clusters);
+  gather_rows_mg(handle, X, offsets, rows, centroids);
+}
+
+/*
+ * @brief Selects 'n_clusters' samples from the distributed dataset using the scalable kmeans++
+ *        algorithm.
+ *
+ * The same as initScalableKMeansPlusPlus, but the cluster cost phi_X(C) is the sum of the costs
+ * of the local parts of the dataset, every rank samples the potential centroids C' from its part
+ * of X, and the samples of all ranks are gathered on all ranks. The potential centroids C are
+ * reclustered on the root rank, where their weights are the numbers of the closest points of the
+ * whole dataset, and the result is broadcast to the other ranks.
+ */
+template <typename DataT, typename IndexT>
+void initScalableKMeansPlusPlus_mg(raft::resources const& handle,
+                                   const KMeansParams& params,
+                                   raft::device_matrix_view<const DataT, IndexT> X,
+                                   const std::vector<int64_t>& offsets,
+                                   raft::device_matrix_view<DataT, IndexT> centroidsRawData,
+                                   rmm::device_uvector<char>& workspace)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope("initScalableKMeansPlusPlus_mg");
+  const auto& comms   = resource::get_comms(handle);
+  const int rank      = comms.get_rank();
+  const int n_ranks   = comms.get_size();
+  cudaStream_t stream = resource::get_cuda_stream(handle);
+  auto n_samples      = X.extent(0);
+  auto n_features     = X.extent(1);
+  auto n_clusters     = params.n_clusters;
+  auto metric         = params.metric;
+
+  // the uniform numbers deciding the sampling of the local points must differ between the ranks
+  raft::random::RngState rng(params.rng_state.seed + rank, params.rng_state.type);
+
+  // <<<< Step-1 >>> : C <- sample a point uniformly at random from X
+  std::mt19937 gen(params.rng_state.seed);
+  auto cIdx = sample_rows_mg(gen, offsets.back(), 1);
+
+  rmm::device_uvector<DataT> centroidsBuf(n_features, stream);
+  auto potentialCentroids =
+    raft::make_device_matrix_view<DataT, IndexT>(centroidsBuf.data(), 1, n_features);
+  gather_rows_mg(handle, X, offsets, cIdx, potentialCentroids);
+
+  // flag the sample that is chosen as initial centroid
+  auto isSampleCentroid = raft::make_device_vector<uint8_t, IndexT>(handle, n_samples);
+  thrust::fill(resource::get_thrust_policy(handle),
+               isSampleCentroid.data_handle(),
+               isSampleCentroid.data_handle() + n_samples,
+               0);
+  if (offsets[rank] <= cIdx[0] && cIdx[0] < offsets[rank + 1]) {
+    RAFT_CUDA_TRY(cudaMemsetAsync(
+      isSampleCentroid.data_handle() + (cIdx[0] - offsets[rank]), 1, sizeof(uint8_t), stream));
+  }
+  // <<< End of Step-1 >>>
+
+  // temporary buffer to store L2 norm of centroids or distance matrix,
+  // destructor releases the resource
+  rmm::device_uvector<DataT> L2NormBuf_OR_DistBuf(0, stream);
+
+  // L2 norm of X: ||x||^2
+  auto L2NormX = raft::make_device_vector<DataT, IndexT>(handle, n_samples);
+  if (metric == raft::distance::DistanceType::L2Expanded ||
+      metric == raft::distance::DistanceType::L2SqrtExpanded) {
+    raft::linalg::rowNorm(L2NormX.data_handle(),
+                          X.data_handle(),
+                          X.extent(1),
+                          X.extent(0),
+                          raft::linalg::L2Norm,
+                          true,
+                          stream);
+  }
+
+  auto minClusterDistanceVec = raft::make_device_vector<DataT, IndexT>(handle, n_samples);
+  auto uniformRands          = raft::make_device_vector<DataT, IndexT>(handle, n_samples);
+  rmm::device_scalar<DataT> clusterCost(stream);
+
+  // psi <- phi_X (C), summed over the ranks
+  auto global_cluster_cost = [&]() {
+    detail::minClusterDistanceCompute<DataT, IndexT>(handle,
+                                                     X,
+                                                     potentialCentroids,
+                                                     minClusterDistanceVec.view(),
+                                                     L2NormX.view(),
+                                                     L2NormBuf_OR_DistBuf,
+                                                     params.metric,
+                                                     params.batch_samples,
+                                                     params.batch_centroids,
+                                                     workspace);
+    detail::computeClusterCost(handle,
+                               minClusterDistanceVec.view(),
+                               workspace,
+                               raft::make_device_scalar_view(clusterCost.data()),
+                               raft::identity_op{},
+                               raft::add_op{});
+    allreduce_sum_mg(handle, clusterCost.data(), 1);
+    return clusterCost.value(stream);
+  };
+
+  // <<< Step-2 >>>: psi <- phi_X (C)
+  auto psi = global_cluster_cost();
+  // <<< End of Step-2 >>>
+
+  // Scalable kmeans++ paper claims 8 rounds is sufficient
+  int niter = std::min(8, (int)ceil(log(psi)));
+  RAFT_LOG_DEBUG("KMeans||: psi = %g, log(psi) = %g, niter = %d ", psi, log(psi), niter);
+
+  std::vector<int64_t> h_counts(n_ranks);
+  std::vector<size_t> recvcounts(n_ranks);
+  std::vector<size_t> displs(n_ranks);
+  auto counts = raft::make_device_vector<int64_t, int>(handle, n_ranks);
+
+  // <<<< Step-3 >>> : for O( log(psi) ) times do
+  for (int iter = 0; iter < niter; ++iter) {
+    RAFT_LOG_DEBUG("KMeans|| - Iteration %d: # potential centroids sampled - %d",
+                   iter,
+                   potentialCentroids.extent(0));
+
+    psi = global_cluster_cost();
+
+    // <<<< Step-4 >>> : Sample each point x in X independently and identify new
+    // potentialCentroids
+    raft::random::uniform(
+      handle, rng, uniformRands.data_handle(), uniformRands.extent(0), (DataT)0, (DataT)1);
+
+    detail::SamplingOp<DataT, IndexT> select_op(psi,
+                                                params.oversampling_factor,
+                                                n_clusters,
+                                                uniformRands.data_handle(),
+                                                isSampleCentroid.data_handle());
+
+    rmm::device_uvector<DataT> inRankCp(0, stream);
+    detail::sampleCentroids<DataT, IndexT>(handle,
+                                           X,
+                                           minClusterDistanceVec.view(),
+                                           isSampleCentroid.view(),
+                                           select_op,
+                                           inRankCp,
+                                           workspace);
+    /// <<<< End of Step-4 >>>>
+
+    /// <<<< Step-5 >>> : C = C U C', where C' are the samples of all ranks
+    // the counts are the numbers of the elements of the sampled rows
+    auto n_local_sampled = raft::make_device_scalar<int64_t>(handle, int64_t(inRankCp.size()));
+    comms.allgather(n_local_sampled.data_handle(), counts.data_handle(), 1, stream);
+    RAFT_EXPECTS(comms.sync_stream(stream) == comms::status_t::SUCCESS,
+                 "KMeans.fit_mg: allgather of the numbers of the sampled points failed");
+    raft::copy(h_counts.data(), counts.data_handle(), n_ranks, stream);
+    resource::sync_stream(handle, stream);
+
+    size_t n_total = 0;
+    for (int r = 0; r < n_ranks; r++) {
+      recvcounts[r] = h_counts[r];
+      displs[r]     = n_total;
+      n_total += h_counts[r];
+    }
+
+    auto old_size = centroidsBuf.size();
+    centroidsBuf.resize(old_size + n_total, stream);
+    comms.allgatherv(
+      inRankCp.data(), centroidsBuf.data() + old_size, recvcounts.data(), displs.data(), stream);
+    RAFT_EXPECTS(comms.sync_stream(stream) == comms::status_t::SUCCESS,
+                 "KMeans.fit_mg: allgather of the sampled points failed");
+
+    IndexT tot_centroids = centroidsBuf.size() / n_features;
+    potentialCentroids =
+      raft::make_device_matrix_view<DataT, IndexT>(centroidsBuf.data(), tot_centroids, n_features);
+    /// <<<< End of Step-5 >>>
+  }  /// <<<< Step-6 >>>
+
+  RAFT_LOG_DEBUG("KMeans||: total # potential centroids sampled - %d",
+                 potentialCentroids.extent(0));
+
+  if ((int)potentialCentroids.extent(0) > n_clusters) {
+    // <<< Step-7 >>>: For x in C, set w_x to be the number of pts closest to X
+    auto weight = raft::make_device_vector<DataT, IndexT>(handle, potentialCentroids.extent(0));
+
+    detail::countSamplesInCluster<DataT, IndexT>(
+      handle, params, X, L2NormX.view(), potentialCentroids, workspace, weight.view());
+    allreduce_sum_mg(handle, weight.data_handle(), weight.size());
+    // <<< end of Step-7 >>>
+
+    // Step-8: Recluster the weighted points in C into k clusters, on the root rank
+    if (rank == 0) {
+      detail::kmeansPlusPlus<DataT, IndexT>(
+        handle, params, potentialCentroids, centroidsRawData, workspace);
+
+      auto inertia = make_host_scalar<DataT>(0);
+      auto n_iter  = make_host_scalar<IndexT>(0);
+      KMeansParams default_params;
+      default_params.n_clusters = params.n_clusters;
+
+      detail::kmeans_fit_main<DataT, IndexT>(handle,
+                                             default_params,
+                                             potentialCentroids,
+                                             weight.view(),
+                                             centroidsRawData,
+                                             inertia.view(),
+                                             n_iter.view(),
+                                             workspace);
+    }
+    comms.bcast(centroidsRawData.data_handle(), centroidsRawData.size(), 0, stream);
+    RAFT_EXPECTS(comms.sync_stream(stream) == comms::status_t::SUCCESS,
+                 "KMeans.fit_mg: broadcast of the initial centroids failed");
+
+  } else if ((int)potentialCentroids.extent(0) < n_clusters) {
+    // supplement with random
+    auto n_random_clusters = n_clusters - potentialCentroids.extent(0);
+
+    RAFT_LOG_DEBUG(
+      "[Warning!] KMeans||: found fewer than %d centroids during "
+      "initialization (found %d centroids, remaining %d centroids will be "
+      "chosen randomly from input samples)",
+      n_clusters,
+      potentialCentroids.extent(0),
+      n_random_clusters);
+
+    // generate `n_random_clusters` centroids
+    auto rows = sample_rows_mg(gen, offsets.back(), n_random_clusters);
+    gather_rows_mg(handle,
+                   X,
+                   offsets,
+                   rows,
+                   raft::make_device_matrix_view<DataT, IndexT>(
+                     centroidsRawData.data_handle(), n_random_clusters, n_features));
+
+    // copy centroids generated during kmeans|| iteration to the buffer
+    raft::copy(centroidsRawData.data_handle() + n_random_clusters * n_features,
+               potentialCentroids.data_handle(),
+               potentialCentroids.size(),
+               stream);
+  } else {
+    // found the required n_clusters
+    raft::copy(centroidsRawData.data_handle(),
+               potentialCentroids.data_handle(),
+               potentialCentroids.size(),
+               stream);
+  }
+}
+
+/**
+ * The k-means iterations over the distributed dataset: the same as kmeans_fit_main, but the
+ * per-cluster weighted sums of the local samples and the weights of the clusters are summed over
+ * the ranks before the centroids are updated.
+ */
+template <typename DataT, typename IndexT>
+void kmeans_fit_main_mg(raft::resources const& handle,
+                        const KMeansParams& params,
+                        raft::device_matrix_view<const DataT, IndexT> X,
+                        raft::device_vector_view<const DataT, IndexT> weight,
+                        raft::device_matrix_view<DataT, IndexT> centroidsRawData,
+                        raft::host_scalar_view<DataT> inertia,
+                        raft::host_scalar_view<IndexT> n_iter,
+                        rmm::device_uvector<char>& workspace)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope("kmeans_fit_main_mg");
+  logger::get(RAFT_NAME).set_level(params.verbosity);
+  const auto& comms   = resource::get_comms(handle);
+  cudaStream_t stream = resource::get_cuda_stream(handle);
+  auto n_samples      = X.extent(0);
+  auto n_features     = X.extent(1);
+  auto n_clusters     = params.n_clusters;
+  auto metric         = params.metric;
+
+  auto minClusterAndDistance =
+    raft::make_device_vector<raft::KeyValuePair<IndexT, DataT>, IndexT>(handle, n_samples);
+  rmm::device_uvector<DataT> L2NormBuf_OR_DistBuf(0, stream);
+  auto newCentroids = raft::make_device_matrix<DataT, IndexT>(handle, n_clusters, n_features);
+  auto wtInCluster  = raft::make_device_vector<DataT, IndexT>(handle, n_clusters);
+  rmm::device_scalar<DataT> clusterCostD(stream);
+
+  // L2 norm of X: ||x||^2
+  auto L2NormX = raft::make_device_vector<DataT, IndexT>(handle, n_samples);
+  auto l2normx_view =
+    raft::make_device_vector_view<const DataT, IndexT>(L2NormX.data_handle(), n_samples);
+
+  if (metric == raft::distance::DistanceType::L2Expanded ||
+      metric == raft::distance::DistanceType::L2SqrtExpanded) {
+    raft::linalg::rowNorm(L2NormX.data_handle(),
+                          X.data_handle(),
+                          X.extent(1),
+                          X.extent(0),
+                          raft::linalg::L2Norm,
+                          true,
+                          stream);
+  }
+
+  auto centroids = raft::make_device_matrix_view<DataT, IndexT>(
+    centroidsRawData.data_handle(), n_clusters, n_features);
+
+  DataT priorClusteringCost = 0;
+  for (n_iter[0] = 1; n_iter[0] <= params.max_iter; ++n_iter[0]) {
+    RAFT_LOG_DEBUG(
+      "KMeans.fit_mg: Iteration-%d: fitting the model using the initialized "
+      "cluster centers",
+      n_iter[0]);
+
+    detail::minClusterAndDistanceCompute<DataT, IndexT>(handle,
+                                                        X,
+                                                        centroids,
+                                                        minClusterAndDistance.view(),
+                                                        l2normx_view,
+                                                        L2NormBuf_OR_DistBuf,
+                                                        params.metric,
+                                                        params.batch_samples,
+                                                        params.batch_centroids,
+                                                        workspace);
+
+    detail::KeyValueIndexOp<IndexT, DataT> conversion_op;
+    cub::TransformInputIterator<IndexT,
+                                detail::KeyValueIndexOp<IndexT, DataT>,
+                                raft::KeyValuePair<IndexT, DataT>*>
+      itr(minClusterAndDistance.data_handle(), conversion_op);
+
+    // the local means and weights of the clusters
+    update_centroids(handle,
+                     X,
+                     weight,
+                     raft::make_const_mdspan(centroids),
+                     itr,
+                     wtInCluster.view(),
+                     newCentroids.view(),
+                     workspace);
+
+    // the global means: sum the local weighted sums and the weights over the ranks
+    raft::linalg::matrixVectorOp(newCentroids.data_handle(),
+                                 newCentroids.data_handle(),
+                                 wtInCluster.data_handle(),
+                                 n_features,
+                                 n_clusters,
+                                 true,
+                                 false,
+                                 raft::mul_op{},
+                                 stream);
+    allreduce_sum_mg(handle, newCentroids.data_handle(), newCentroids.size());
+    allreduce_sum_mg(handle, wtInCluster.data_handle(), wtInCluster.size());
+    const DataT* cluster_wt = wtInCluster.data_handle();
+    const DataT* old        = centroids.data_handle();
+    DataT* sums             = newCentroids.data_handle();
+    raft::linalg::map_offset(handle,
+                             raft::make_device_vector_view<DataT, IndexT>(
+                               newCentroids.data_handle(), newCentroids.size()),
+                             [=] __device__(IndexT i) {
+                               // keep the centroids of the empty clusters in place
+                               const DataT w = cluster_wt[i / n_features];
+                               return w == DataT(0) ? old[i] : sums[i] / w;
+                             });
+
+    // the squared norm between the newCentroids and the original centroids; the root decides on
+    // the convergence, so that all ranks stop at the same iteration
+    auto sqrdNorm = raft::make_device_scalar(handle, DataT(0));
+    raft::linalg::mapThenSumReduce(sqrdNorm.data_handle(),
+                                   newCentroids.size(),
+                                   raft::sqdiff_op{},
+                                   stream,
+                                   centroids.data_handle(),
+                                   newCentroids.data_handle());
+    comms.bcast(sqrdNorm.data_handle(), 1, 0, stream);
+    RAFT_EXPECTS(comms.sync_stream(stream) == comms::status_t::SUCCESS,
+                 "KMeans.fit_mg: broadcast of the change of the centroids failed");
+
+    DataT sqrdNormError = 0;
+    raft::copy(&sqrdNormError, sqrdNorm.data_handle(), sqrdNorm.size(), stream);
+
+    raft::copy(
+      centroidsRawData.data_handle(), newCentroids.data_handle(), newCentroids.size(), stream);
+
+    bool done = false;
+    if (params.inertia_check) {
+      detail::computeClusterCost(handle,
+                                 minClusterAndDistance.view(),
+                                 workspace,
+                                 raft::make_device_scalar_view(clusterCostD.data()),
+                                 raft::value_op{},
+                                 raft::add_op{});
+      allreduce_sum_mg(handle, clusterCostD.data(), 1);
+
+      DataT curClusteringCost = clusterCostD.value(stream);
+
+      ASSERT(curClusteringCost != (DataT)0.0,
+             "Too few points and centroids being found is getting 0 cost from "
+             "centers");
+
+      if (n_iter[0] > 1) {
+        DataT delta = curClusteringCost / priorClusteringCost;
+        if (delta > 1 - params.tol) done = true;
+      }
+      priorClusteringCost = curClusteringCost;
+    }
+
+    resource::sync_stream(handle, stream);
+    if (sqrdNormError < params.tol) done = true;
+
+    if (done) {
+      RAFT_LOG_DEBUG("Threshold triggered after %d iterations. Terminating early.", n_iter[0]);
+      break;
+    }
+  }
+
+  detail::minClusterAndDistanceCompute<DataT, IndexT>(handle,
+                                                      X,
+                                                      centroids,
+                                                      minClusterAndDistance.view(),
+                                                      l2normx_view,
+                                                      L2NormBuf_OR_DistBuf,
+                                                      params.metric,
+                                                      params.batch_samples,
+                                                      params.batch_centroids,
+                                                      workspace);
+
+  thrust::transform(resource::get_thrust_policy(handle),
+                    minClusterAndDistance.data_handle(),
+                    minClusterAndDistance.data_handle() + minClusterAndDistance.size(),
+                    weight.data_handle(),
+                    minClusterAndDistance.data_handle(),
+                    [=] __device__(const raft::KeyValuePair<IndexT, DataT> kvp, DataT wt) {
+                      raft::KeyValuePair<IndexT, DataT> res;
+                      res.value = kvp.value * wt;
+                      res.key   = kvp.key;
+                      return res;
+                    });
+
+  // calculate cluster cost phi_x(C) of the whole dataset
+  detail::computeClusterCost(handle,
+                             minClusterAndDistance.view(),
+                             workspace,
+                             raft::make_device_scalar_view(clusterCostD.data()),
+                             raft::value_op{},
+                             raft::add_op{});
+  allreduce_sum_mg(handle, clusterCostD.data(), 1);
+
+  inertia[0] = clusterCostD.value(stream);
+  n_iter[0]  = std::min<IndexT>(n_iter[0], params.max_iter);
+
+  RAFT_LOG_DEBUG("KMeans.fit_mg: completed after %d iterations with %f inertia[0] ",
+                 n_iter[0],
+                 inertia[0]);
+}
+
+/**
+ * @brief Find clusters with k-means algorithm in a dataset distributed across the ranks of the
+ *        communicator attached to the handle.
+ *
+ * The initialization methods and the parameters are the same as in kmeans_fit, except that
+ * InitMethod::KMeansPlusPlus always uses the scalable kmeans++ (with the oversampling factor of
+ * 2 if `params.oversampling_factor` is 0), because the sequential kmeans++ does not distribute.
+ * With InitMethod::Array, the centroids of the root rank are used.
+ */
+template <typename DataT, typename IndexT>
+void kmeans_fit_mg(raft::resources const& handle,
+                   const KMeansParams& params,
+                   raft::device_matrix_view<const DataT, IndexT> X,
+                   std::optional<raft::device_vector_view<const DataT, IndexT>> sample_weight,
+                   raft::device_matrix_view<DataT, IndexT> centroids,
+                   raft::host_scalar_view<DataT> inertia,
+                   raft::host_scalar_view<IndexT> n_iter)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope("kmeans_fit_mg");
+  const auto& comms   = resource::get_comms(handle);
+  auto n_samples      = X.extent(0);
+  auto n_features     = X.extent(1);
+  auto n_clusters     = params.n_clusters;
+  cudaStream_t stream = resource::get_cuda_stream(handle);
+  // Check that parameters are valid
+  if (sample_weight.has_value())
+    RAFT_EXPECTS(sample_weight.value().extent(0) == n_samples,
+                 "invalid parameter (sample_weight!=n_samples)");
+  RAFT_EXPECTS(n_clusters > 0, "invalid parameter (n_clusters<=0)");
+  RAFT_EXPECTS(params.tol > 0, "invalid parameter (tol<=0)");
+  RAFT_EXPECTS(params.oversampling_factor >= 0, "invalid parameter (oversampling_factor<0)");
+  RAFT_EXPECTS((int)centroids.extent(0) == params.n_clusters,
+               "invalid parameter (centroids.extent(0) != n_clusters)");
+  RAFT_EXPECTS(centroids.extent(1) == n_features,
+               "invalid parameter (centroids.extent(1) != n_features)");
+
+  logger::get(RAFT_NAME).set_level(params.verbosity);
+
+  auto offsets = local_offsets_mg(handle, n_samples);
+  RAFT_EXPECTS(offsets.back() >= n_clusters,
+               "invalid parameter (n_clusters > the number of samples of all ranks)");
+
+  // Allocate memory
+  rmm::device_uvector<char> workspace(0, stream);
+  auto weight = raft::make_device_vector<DataT, IndexT>(handle, n_samples);
+  if (sample_weight.has_value())
+    raft::copy(weight.data_handle(), sample_weight.value().data_handle(), n_samples, stream);
+  else
+    thrust::fill(resource::get_thrust_policy(handle),
+                 weight.data_handle(),
+                 weight.data_handle() + weight.size(),
+                 1);
+
+  // check if weights sum up to the global number of samples
+  checkWeight_mg(handle, weight.view(), offsets.back());
+
+  auto centroidsRawData = raft::make_device_matrix<DataT, IndexT>(handle, n_clusters, n_features);
+
+  auto n_init = params.n_init;
+  if (params.init == KMeansParams::InitMethod::Array && n_init != 1) {
+    RAFT_LOG_DEBUG(
+      "Explicit initial center position passed: performing only one init in "
+      "k-means instead of n_init=%d",
+      n_init);
+    n_init = 1;
+  }
+
+  // all ranks draw the same seeds
+  std::mt19937 gen(params.rng_state.seed);
+  inertia[0] = std::numeric_limits<DataT>::max();
+
+  for (auto seed_iter = 0; seed_iter < n_init; ++seed_iter) {
+    KMeansParams iter_params   = params;
+    iter_params.rng_state.seed = gen();
+
+    DataT iter_inertia    = std::numeric_limits<DataT>::max();
+    IndexT n_current_iter = 0;
+    if (iter_params.init == KMeansParams::InitMethod::Random) {
+      RAFT_LOG_DEBUG(
+        "KMeans.fit_mg (Iteration-%d/%d): initialize cluster centers by "
+        "randomly choosing from the input data.",
+        seed_iter + 1,
+        n_init);
+      initRandom_mg<DataT, IndexT>(handle, iter_params, X, offsets, centroidsRawData.view());
+    } else if (iter_params.init == KMeansParams::InitMethod::KMeansPlusPlus) {
+      RAFT_LOG_DEBUG(
+        "KMeans.fit_mg (Iteration-%d/%d): initialize cluster centers using "
+        "scalable k-means++ algorithm.",
+        seed_iter + 1,
+        n_init);
+      if (iter_params.oversampling_factor == 0) { iter_params.oversampling_factor = 2.0; }
+      initScalableKMeansPlusPlus_mg<DataT, IndexT>(
+        handle, iter_params, X, offsets, centroidsRawData.view(), workspace);
+    } else if (iter_params.init == KMeansParams::InitMethod::Array) {
+      RAFT_LOG_DEBUG(
+        "KMeans.fit_mg (Iteration-%d/%d): initialize cluster centers from "
+        "the ndarray array input passed to init argument.",
+        seed_iter + 1,
+        n_init);
+      raft::copy(
+        centroidsRawData.data_handle(), centroids.data_handle(), n_clusters * n_features, stream);
+      comms.bcast(centroidsRawData.data_handle(), centroidsRawData.size(), 0, stream);
+      RAFT_EXPECTS(comms.sync_stream(stream) == comms::status_t::SUCCESS,
+                   "KMeans.fit_mg: broadcast of the initial centroids failed");
+    } else {
+      THROW("unknown initialization method to select initial centers");
+    }
+
+    detail::kmeans_fit_main_mg<DataT, IndexT>(handle,
+                                              iter_params,
+                                              X,
+                                              raft::make_const_mdspan(weight.view()),
+                                              centroidsRawData.view(),
+                                              raft::make_host_scalar_view<DataT>(&iter_inertia),
+                                              raft::make_host_scalar_view<IndexT>(&n_current_iter),
+                                              workspace);
+    // the inertia is the same on all ranks, so are the chosen centroids
+    if (iter_inertia < inertia[0]) {
+      inertia[0] = iter_inertia;
+      n_iter[0]  = n_current_iter;
+      raft::copy(
+        centroids.data_handle(), centroidsRawData.data_handle(), n_clusters * n_features, stream);
+    }
+    RAFT_LOG_DEBUG("KMeans.fit_mg after iteration-%d/%d: inertia - %f, n_iter[0] - %d",
+                   seed_iter + 1,
+                   n_init,
+                   inertia[0],
+                   n_iter[0]);
+  }
+  resource::sync_stream(handle, stream);
+}
+
+}  // namespace raft::cluster::detail
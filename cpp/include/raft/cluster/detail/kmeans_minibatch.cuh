@@ -0,0 +1,359 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/cluster/detail/kmeans.cuh>
+#include <raft/cluster/detail/kmeans_common.cuh>
+#include <raft/cluster/kmeans_types.hpp>
+#include <raft/common/nvtx.hpp>
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/host_mdspan.hpp>
+#include <raft/core/kvp.hpp>
+#include <raft/core/logger.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/cuda_stream_pool.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/linalg/add.cuh>
+#include <raft/linalg/map.cuh>
+#include <raft/linalg/map_then_reduce.cuh>
+#include <raft/linalg/norm.cuh>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_scalar.hpp>
+#include <rmm/device_uvector.hpp>
+
+#include <thrust/fill.h>
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace raft::cluster::detail {
+
+/**
+ * Loads the batches of the rows of a host matrix to the device through a pair of pinned buffers.
+ *
+ * The host copies a batch into a pinned buffer while the device works on the previous one; the
+ * copy to the device runs on a stream of the stream pool (if any), so that it overlaps the work on
+ * the main stream too. A batch stays valid on the device until the next but one call of `load`.
+ */
+template <typename DataT, typename IndexT>
+class host_batch_loader {
+ public:
+  host_batch_loader(raft::resources const& handle,
+                    raft::host_matrix_view<const DataT, IndexT> X,
+                    IndexT batch_size)
+    : X_(X),
+      batch_size_(batch_size),
+      stream_(resource::get_cuda_stream(handle)),
+      copy_stream_(resource::get_next_usable_stream(handle)),
+      device_{raft::make_device_matrix<DataT, IndexT>(handle, batch_size, X.extent(1)),
+              raft::make_device_matrix<DataT, IndexT>(handle, batch_size, X.extent(1))}
+  {
+    for (int i = 0; i < 2; i++) {
+      RAFT_CUDA_TRY(cudaMallocHost(&pinned_[i], batch_bytes()));
+      RAFT_CUDA_TRY(cudaEventCreateWithFlags(&copied_[i], cudaEventDisableTiming));
+      RAFT_CUDA_TRY(cudaEventCreateWithFlags(&consumed_[i], cudaEventDisableTiming));
+    }
+  }
+  ~host_batch_loader() noexcept
+  {
+    for (int i = 0; i < 2; i++) {
+      // the pending copies must not read the memory after it is freed
+      RAFT_CUDA_TRY_NO_THROW(cudaEventSynchronize(copied_[i]));
+      RAFT_CUDA_TRY_NO_THROW(cudaEventDestroy(copied_[i]));
+      RAFT_CUDA_TRY_NO_THROW(cudaEventDestroy(consumed_[i]));
+      RAFT_CUDA_TRY_NO_THROW(cudaFreeHost(pinned_[i]));
+    }
+  }
+  host_batch_loader(const host_batch_loader&)                    = delete;
+  host_batch_loader(host_batch_loader&&)                         = delete;
+  auto operator=(const host_batch_loader&) -> host_batch_loader& = delete;
+  auto operator=(host_batch_loader&&) -> host_batch_loader&      = delete;
+
+  /**
+   * Enqueue the copy of the rows [row, row + rows) to the device; the work using the returned batch
+   * must be enqueued on the main stream.
+   */
+  auto load(IndexT row, IndexT rows) -> raft::device_matrix_view<const DataT, IndexT>
+  {
+    RAFT_EXPECTS(rows <= batch_size_, "The batch is larger than the buffers");
+    // all the work on the previous batch is enqueued by now
+    if (n_loaded_ > 0) { RAFT_CUDA_TRY(cudaEventRecord(consumed_[slot_], stream_)); }
+    slot_ = n_loaded_++ % 2;
+
+    // the copy of the batch before the previous one from the pinned buffer is done
+    RAFT_CUDA_TRY(cudaEventSynchronize(copied_[slot_]));
+    const size_t n_elems = size_t(rows) * X_.extent(1);
+    std::memcpy(
+      pinned_[slot_], X_.data_handle() + size_t(row) * X_.extent(1), n_elems * sizeof(DataT));
+    // the work on the batch before the previous one in the device buffer is done
+    RAFT_CUDA_TRY(cudaStreamWaitEvent(copy_stream_, consumed_[slot_]));
+    raft::copy(device_[slot_].data_handle(), pinned_[slot_], n_elems, copy_stream_);
+    RAFT_CUDA_TRY(cudaEventRecord(copied_[slot_], copy_stream_));
+    RAFT_CUDA_TRY(cudaStreamWaitEvent(stream_, copied_[slot_]));
+    return raft::make_device_matrix_view<const DataT, IndexT>(
+      device_[slot_].data_handle(), rows, X_.extent(1));
+  }
+
+ private:
+  [[nodiscard]] auto batch_bytes() const -> size_t
+  {
+    return size_t(batch_size_) * X_.extent(1) * sizeof(DataT);
+  }
+
+  raft::host_matrix_view<const DataT, IndexT> X_;
+  IndexT batch_size_;
+  rmm::cuda_stream_view stream_;
+  rmm::cuda_stream_view copy_stream_;
+  raft::device_matrix<DataT, IndexT> device_[2];
+  DataT* pinned_[2] = {nullptr, nullptr};
+  cudaEvent_t copied_[2];
+  cudaEvent_t consumed_[2];
+  int slot_          = 0;
+  uint64_t n_loaded_ = 0;
+};
+
+/**
+ * The state of the mini-batch k-means across the batches: the per-batch buffers and the number of
+ * samples assigned to every center so far (the inverses of the per-center learning rates).
+ */
+template <typename DataT, typename IndexT>
+struct minibatch_state {
+  minibatch_state(raft::resources const& handle, IndexT batch_size, IndexT n_clusters, IndexT dim)
+    : min_cluster_and_distance(
+        raft::make_device_vector<raft::KeyValuePair<IndexT, DataT>, IndexT>(handle, batch_size)),
+      l2_norm_x(raft::make_device_vector<DataT, IndexT>(handle, batch_size)),
+      weight(raft::make_device_vector<DataT, IndexT>(handle, batch_size)),
+      batch_centroids(raft::make_device_matrix<DataT, IndexT>(handle, n_clusters, dim)),
+      batch_weight(raft::make_device_vector<DataT, IndexT>(handle, n_clusters)),
+      counts(raft::make_device_vector<DataT, IndexT>(handle, n_clusters)),
+      l2_norm_buf_or_dist_buf(0, resource::get_cuda_stream(handle)),
+      workspace(0, resource::get_cuda_stream(handle))
+  {
+    thrust::fill(resource::get_thrust_policy(handle),
+                 weight.data_handle(),
+                 weight.data_handle() + weight.size(),
+                 DataT(1));
+    thrust::fill(resource::get_thrust_policy(handle),
+                 counts.data_handle(),
+                 counts.data_handle() + counts.size(),
+                 DataT(0));
+  }
+
+  raft::device_vector<raft::KeyValuePair<IndexT, DataT>, IndexT> min_cluster_and_distance;
+  raft::device_vector<DataT, IndexT> l2_norm_x;
+  raft::device_vector<DataT, IndexT> weight;
+  raft::device_matrix<DataT, IndexT> batch_centroids;
+  raft::device_vector<DataT, IndexT> batch_weight;
+  raft::device_vector<DataT, IndexT> counts;
+  rmm::device_uvector<DataT> l2_norm_buf_or_dist_buf;
+  rmm::device_uvector<char> workspace;
+};
+
+/** Assign the samples of the batch to their nearest centroids (fused_l2_nn for the L2 metrics). */
+template <typename DataT, typename IndexT>
+void minibatch_assign(raft::resources const& handle,
+                      const KMeansMiniBatchParams& params,
+                      raft::device_matrix_view<const DataT, IndexT> batch,
+                      raft::device_matrix_view<const DataT, IndexT> centroids,
+                      minibatch_state<DataT, IndexT>& state)
+{
+  const IndexT rows = batch.extent(0);
+  if (params.metric == raft::distance::DistanceType::L2Expanded ||
+      params.metric == raft::distance::DistanceType::L2SqrtExpanded) {
+    raft::linalg::rowNorm(state.l2_norm_x.data_handle(),
+                          batch.data_handle(),
+                          batch.extent(1),
+                          rows,
+                          raft::linalg::L2Norm,
+                          true,
+                          resource::get_cuda_stream(handle));
+  }
+  minClusterAndDistanceCompute<DataT, IndexT>(
+    handle,
+    batch,
+    centroids,
+    raft::make_device_vector_view(state.min_cluster_and_distance.data_handle(), rows),
+    raft::make_device_vector_view<const DataT, IndexT>(state.l2_norm_x.data_handle(), rows),
+    state.l2_norm_buf_or_dist_buf,
+    params.metric,
+    params.batch_samples,
+    params.batch_centroids,
+    state.workspace);
+}
+
+/**
+ * One step of the mini-batch k-means: with `n_c` the number of the samples of the batch assigned
+ * to the center c and `m_c` their mean, `v_c += n_c` then `c += (n_c / v_c) * (m_c - c)`. This is
+ * the per-sample update of Sculley, with all the samples of a center in a batch applied at once.
+ */
+template <typename DataT, typename IndexT>
+void minibatch_step(raft::resources const& handle,
+                    const KMeansMiniBatchParams& params,
+                    raft::device_matrix_view<const DataT, IndexT> batch,
+                    raft::device_matrix_view<DataT, IndexT> centroids,
+                    minibatch_state<DataT, IndexT>& state)
+{
+  const IndexT rows       = batch.extent(0);
+  const IndexT n_clusters = centroids.extent(0);
+  const IndexT dim        = centroids.extent(1);
+  auto stream             = resource::get_cuda_stream(handle);
+  minibatch_assign(handle, params, batch, raft::make_const_mdspan(centroids), state);
+
+  KeyValueIndexOp<IndexT, DataT> conversion_op;
+  cub::TransformInputIterator<IndexT,
+                              KeyValueIndexOp<IndexT, DataT>,
+                              raft::KeyValuePair<IndexT, DataT>*>
+    itr(state.min_cluster_and_distance.data_handle(), conversion_op);
+  auto weight =
+    raft::make_device_vector_view<const DataT, IndexT>(state.weight.data_handle(), rows);
+  update_centroids(handle,
+                   batch,
+                   weight,
+                   raft::make_const_mdspan(centroids),
+                   itr,
+                   state.batch_weight.view(),
+                   state.batch_centroids.view(),
+                   state.workspace);
+
+  raft::linalg::add(state.counts.data_handle(),
+                    state.counts.data_handle(),
+                    state.batch_weight.data_handle(),
+                    n_clusters,
+                    stream);
+  const DataT* batch_weight = state.batch_weight.data_handle();
+  const DataT* counts       = state.counts.data_handle();
+  const DataT* means        = state.batch_centroids.data_handle();
+  DataT* c                  = centroids.data_handle();
+  raft::linalg::map_offset(handle,
+                           raft::make_device_vector_view<DataT, IndexT>(c, n_clusters * dim),
+                           [=] __device__(IndexT i) {
+                             const IndexT k = i / dim;
+                             const DataT n  = batch_weight[k];
+                             return n == DataT(0) ? c[i] : c[i] + n / counts[k] * (means[i] - c[i]);
+                           });
+}
+
+template <typename DataT, typename IndexT>
+void kmeans_fit_minibatch(raft::resources const& handle,
+                          const KMeansMiniBatchParams& params,
+                          raft::host_matrix_view<const DataT, IndexT> X,
+                          raft::device_matrix_view<DataT, IndexT> centroids,
+                          raft::host_scalar_view<DataT> inertia,
+                          raft::host_scalar_view<IndexT> n_iter)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope("kmeans_fit_minibatch");
+  logger::get(RAFT_NAME).set_level(params.verbosity);
+  cudaStream_t stream     = resource::get_cuda_stream(handle);
+  const IndexT n_samples  = X.extent(0);
+  const IndexT n_features = X.extent(1);
+  const IndexT n_clusters = params.n_clusters;
+  RAFT_EXPECTS(n_clusters > 0, "invalid parameter (n_clusters<=0)");
+  RAFT_EXPECTS(params.tol > 0, "invalid parameter (tol<=0)");
+  RAFT_EXPECTS(params.minibatch_size > 0, "invalid parameter (minibatch_size<=0)");
+  RAFT_EXPECTS(centroids.extent(0) == n_clusters,
+               "invalid parameter (centroids.extent(0) != n_clusters)");
+  RAFT_EXPECTS(centroids.extent(1) == n_features,
+               "invalid parameter (centroids.extent(1) != n_features)");
+
+  const IndexT batch_size = std::min<int64_t>(params.minibatch_size, n_samples);
+  const IndexT n_batches  = raft::ceildiv<IndexT>(n_samples, batch_size);
+  RAFT_EXPECTS(batch_size >= n_clusters, "invalid parameter (minibatch_size<n_clusters)");
+  host_batch_loader<DataT, IndexT> loader(handle, X, batch_size);
+  minibatch_state<DataT, IndexT> state(handle, batch_size, n_clusters, n_features);
+
+  // The batches are visited in a new random order in every pass
+  std::mt19937 gen(params.rng_state.seed);
+  std::vector<IndexT> order(n_batches);
+  std::iota(order.begin(), order.end(), IndexT(0));
+  auto batch_rows = [&](IndexT b) { return std::min(batch_size, n_samples - b * batch_size); };
+
+  std::shuffle(order.begin(), order.end(), gen);
+  if (params.init != KMeansParams::InitMethod::Array) {
+    // initialize from the first batch
+    auto sample = loader.load(order[0] * batch_size, batch_rows(order[0]));
+    RAFT_EXPECTS(sample.extent(0) >= n_clusters, "Too few samples in the batch to initialize");
+    if (params.init == KMeansParams::InitMethod::Random) {
+      initRandom<DataT, IndexT>(handle, params, sample, centroids);
+    } else if (params.init == KMeansParams::InitMethod::KMeansPlusPlus) {
+      if (params.oversampling_factor == 0) {
+        kmeansPlusPlus<DataT, IndexT>(handle, params, sample, centroids, state.workspace);
+      } else {
+        initScalableKMeansPlusPlus<DataT, IndexT>(
+          handle, params, sample, centroids, state.workspace);
+      }
+    } else {
+      THROW("unknown initialization method to select initial centers");
+    }
+  }
+
+  auto prev_centroids = raft::make_device_matrix<DataT, IndexT>(handle, n_clusters, n_features);
+  auto sqrd_norm      = raft::make_device_scalar(handle, DataT(0));
+  for (n_iter[0] = 1; n_iter[0] <= params.max_iter; ++n_iter[0]) {
+    raft::copy(prev_centroids.data_handle(), centroids.data_handle(), centroids.size(), stream);
+    for (auto b : order) {
+      minibatch_step(handle, params, loader.load(b * batch_size, batch_rows(b)), centroids, state);
+    }
+    std::shuffle(order.begin(), order.end(), gen);
+
+    // the squared distance the centroids moved during the pass
+    raft::linalg::mapThenSumReduce(sqrd_norm.data_handle(),
+                                   centroids.size(),
+                                   raft::sqdiff_op{},
+                                   stream,
+                                   prev_centroids.data_handle(),
+                                   centroids.data_handle());
+    DataT sqrd_norm_error = 0;
+    raft::copy(&sqrd_norm_error, sqrd_norm.data_handle(), 1, stream);
+    resource::sync_stream(handle, stream);
+    RAFT_LOG_DEBUG(
+      "KMeans.fit_minibatch: pass-%d: the centroids moved by %f", n_iter[0], sqrd_norm_error);
+    if (sqrd_norm_error < params.tol) { break; }
+  }
+  n_iter[0] = std::min<IndexT>(n_iter[0], params.max_iter);
+
+  // The inertia of the final centroids: one more pass over the data
+  rmm::device_scalar<DataT> batch_cost(stream);
+  auto total_cost      = raft::make_device_scalar(handle, DataT(0));
+  auto centroids_const = raft::make_const_mdspan(centroids);
+  for (IndexT b = 0; b < n_batches; b++) {
+    auto batch = loader.load(b * batch_size, batch_rows(b));
+    minibatch_assign(handle, params, batch, centroids_const, state);
+    computeClusterCost(
+      handle,
+      raft::make_device_vector_view(state.min_cluster_and_distance.data_handle(), batch.extent(0)),
+      state.workspace,
+      raft::make_device_scalar_view(batch_cost.data()),
+      raft::value_op{},
+      raft::add_op{});
+    raft::linalg::add(
+      total_cost.data_handle(), total_cost.data_handle(), batch_cost.data(), 1, stream);
+  }
+  raft::copy(inertia.data_handle(), total_cost.data_handle(), 1, stream);
+  resource::sync_stream(handle, stream);
+  RAFT_LOG_DEBUG("KMeans.fit_minibatch: completed after %d passes with %f inertia",
+                 n_iter[0],
+                 inertia[0]);
+}
+
+}  // namespace raft::cluster::detail
@@ -0,0 +1,655 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/cluster/detail/kmeans_common.cuh>
+#include <raft/cluster/kmeans_types.hpp>
+#include <raft/common/nvtx.hpp>
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/host_mdspan.hpp>
+#include <raft/core/kvp.hpp>
+#include <raft/core/logger.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/linalg/map.cuh>
+#include <raft/linalg/map_then_reduce.cuh>
+#include <raft/linalg/norm.cuh>
+#include <raft/sparse/linalg/norm.cuh>
+#include <raft/sparse/linalg/spmm.cuh>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <thrust/binary_search.h>
+#include <thrust/fill.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/scan.h>
+#include <thrust/transform_reduce.h>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <vector>
+
+namespace raft::cluster::detail {
+
+/**
+ * Splits the rows of a CSR matrix into the batches of `batch_size` rows, each viewed as a CSR
+ * matrix of its own: the row offsets of a batch are rebased to zero in a buffer of the class, the
+ * column indices and the values are the ones of the matrix. A view stays valid until the next call
+ * of `view` (all the work is ordered on the stream of the handle).
+ */
+template <typename DataT, typename IndexT, typename NZT>
+class csr_row_batches {
+ public:
+  using csr_view = raft::device_csr_matrix_view<const DataT, int, int, NZT>;
+
+  csr_row_batches(raft::resources const& handle, csr_view X, IndexT batch_size)
+    : handle_(handle),
+      X_(X),
+      n_rows_(X.structure_view().get_n_rows()),
+      batch_size_(std::max<IndexT>(std::min<IndexT>(batch_size, n_rows_), 1)),
+      offsets_(raft::ceildiv<IndexT>(n_rows_, batch_size_) + 1),
+      indptr_(batch_size_ + 1, resource::get_cuda_stream(handle))
+  {
+    auto stream       = resource::get_cuda_stream(handle);
+    const int* indptr = X.structure_view().get_indptr().data();
+    for (size_t b = 0; b < offsets_.size(); b++) {
+      const IndexT row = std::min<IndexT>(IndexT(b) * batch_size_, n_rows_);
+      raft::copy(&offsets_[b], indptr + row, 1, stream);
+    }
+    resource::sync_stream(handle, stream);
+  }
+
+  [[nodiscard]] auto n_batches() const -> IndexT { return offsets_.size() - 1; }
+  [[nodiscard]] auto batch_size() const -> IndexT { return batch_size_; }
+  [[nodiscard]] auto first_row(IndexT b) const -> IndexT { return b * batch_size_; }
+  [[nodiscard]] auto rows(IndexT b) const -> IndexT
+  {
+    return std::min(batch_size_, n_rows_ - b * batch_size_);
+  }
+
+  /** View the batch `b` as a CSR matrix. */
+  auto view(IndexT b) -> csr_view
+  {
+    auto structure    = X_.structure_view();
+    const IndexT rows = this->rows(b);
+    const int base    = offsets_[b];
+    const int nnz     = offsets_[b + 1] - base;
+    const int* indptr = structure.get_indptr().data() + first_row(b);
+    raft::linalg::map_offset(handle_,
+                             raft::make_device_vector_view<int, IndexT>(indptr_.data(), rows + 1),
+                             [=] __device__(IndexT i) { return indptr[i] - base; });
+    auto batch_structure = raft::make_device_compressed_structure_view<int, int, NZT>(
+      indptr_.data(),
+      const_cast<int*>(structure.get_indices().data()) + base,
+      int(rows),
+      structure.get_n_cols(),
+      NZT(nnz));
+    return csr_view(raft::device_span<const DataT>(X_.get_elements().data() + base, nnz),
+                    batch_structure);
+  }
+
+ private:
+  raft::resources const& handle_;
+  csr_view X_;
+  IndexT n_rows_;
+  IndexT batch_size_;
+  std::vector<int> offsets_;
+  rmm::device_uvector<int> indptr_;
+};
+
+/**
+ * The nearest of the centers for every row of a batch, given the products of the rows and the
+ * centers `dots` [rows, n_clusters] (column-major) and the squared norms of both. With
+ * `accumulate`, the output is only replaced by the nearer centers.
+ */
+template <typename DataT, typename IndexT>
+__global__ void sparse_nearest_center_kernel(const DataT* dots,
+                                             const DataT* x_norms,
+                                             const DataT* c_norms,
+                                             IndexT rows,
+                                             IndexT n_clusters,
+                                             bool accumulate,
+                                             raft::KeyValuePair<IndexT, DataT>* out)
+{
+  const IndexT i = IndexT(blockIdx.x) * IndexT(blockDim.x) + IndexT(threadIdx.x);
+  if (i >= rows) { return; }
+  raft::KeyValuePair<IndexT, DataT> best{IndexT(0), std::numeric_limits<DataT>::max()};
+  if (accumulate) { best = out[i]; }
+  const DataT x_norm = x_norms[i];
+  for (IndexT c = 0; c < n_clusters; c++) {
+    const DataT d = raft::max<DataT>(x_norm + c_norms[c] - 2 * dots[i + size_t(c) * rows], 0);
+    if (d < best.value) {
+      best.key   = c;
+      best.value = d;
+    }
+  }
+  out[i] = best;
+}
+
+/**
+ * Add the weighted rows of the CSR matrix to the sums of their clusters (one warp per row), and
+ * their weights to the weights of the clusters.
+ */
+template <typename DataT, typename IndexT>
+__global__ void sparse_sum_by_cluster_kernel(const int* indptr,
+                                             const int* indices,
+                                             const DataT* values,
+                                             const DataT* weight,
+                                             const raft::KeyValuePair<IndexT, DataT>* labels,
+                                             IndexT n_rows,
+                                             IndexT n_features,
+                                             DataT* sums,
+                                             DataT* cluster_weight)
+{
+  const IndexT row = (IndexT(blockIdx.x) * IndexT(blockDim.x) + IndexT(threadIdx.x)) / WarpSize;
+  const int lane   = threadIdx.x % WarpSize;
+  if (row >= n_rows) { return; }
+  const IndexT label = labels[row].key;
+  const DataT w      = weight[row];
+  DataT* sum         = sums + size_t(label) * n_features;
+  for (int j = indptr[row] + lane; j < indptr[row + 1]; j += WarpSize) {
+    atomicAdd(sum + indices[j], w * values[j]);
+  }
+  if (lane == 0) { atomicAdd(cluster_weight + label, w); }
+}
+
+/** Scatter the rows `ids` of the CSR matrix into the (zero-initialized) dense rows of `out`. */
+template <typename DataT, typename IndexT>
+__global__ void sparse_gather_rows_kernel(const int* indptr,
+                                          const int* indices,
+                                          const DataT* values,
+                                          const IndexT* ids,
+                                          IndexT n_features,
+                                          DataT* out)
+{
+  const IndexT row = ids[blockIdx.x];
+  DataT* out_row   = out + size_t(blockIdx.x) * n_features;
+  for (int j = indptr[row] + threadIdx.x; j < indptr[row + 1]; j += blockDim.x) {
+    out_row[indices[j]] = values[j];
+  }
+}
+
+/** Densify the rows `ids` (on the host) of the CSR matrix into the rows of `out`. */
+template <typename DataT, typename IndexT, typename NZT>
+void sparse_gather_rows(raft::resources const& handle,
+                        raft::device_csr_matrix_view<const DataT, int, int, NZT> X,
+                        const std::vector<IndexT>& ids,
+                        raft::device_matrix_view<DataT, IndexT> out)
+{
+  auto stream = resource::get_cuda_stream(handle);
+  auto d_ids  = raft::make_device_vector<IndexT, IndexT>(handle, ids.size());
+  raft::copy(d_ids.data_handle(), ids.data(), ids.size(), stream);
+  RAFT_CUDA_TRY(
+    cudaMemsetAsync(out.data_handle(), 0, sizeof(DataT) * ids.size() * out.extent(1), stream));
+  auto structure = X.structure_view();
+  sparse_gather_rows_kernel<DataT, IndexT>
+    <<<ids.size(), WarpSize, 0, stream>>>(structure.get_indptr().data(),
+                                          structure.get_indices().data(),
+                                          X.get_elements().data(),
+                                          d_ids.data_handle(),
+                                          out.extent(1),
+                                          out.data_handle());
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+/**
+ * The nearest centers of all the rows and the squared L2 distances to them, through the products
+ * of the batches of rows and the centers (cuSPARSE SpMM) and the precomputed squared norms.
+ * The row-major centers [n_clusters, n_features] are read as the column-major [n_features,
+ * n_clusters] matrix of the SpMM, so that they are not transposed.
+ */
+template <typename DataT, typename IndexT, typename NZT>
+void sparse_min_cluster_and_distance(
+  raft::resources const& handle,
+  csr_row_batches<DataT, IndexT, NZT>& batches,
+  const DataT* x_norms,
+  raft::device_matrix_view<const DataT, IndexT> centroids,
+  const DataT* c_norms,
+  raft::device_vector_view<raft::KeyValuePair<IndexT, DataT>, IndexT> min_cluster_and_distance,
+  rmm::device_uvector<DataT>& dots,
+  bool accumulate = false)
+{
+  auto stream             = resource::get_cuda_stream(handle);
+  const IndexT n_clusters = centroids.extent(0);
+  const IndexT n_features = centroids.extent(1);
+  dots.resize(size_t(batches.batch_size()) * n_clusters, stream);
+  auto centers_t = raft::make_device_matrix_view<const DataT, IndexT, raft::col_major>(
+    centroids.data_handle(), n_features, n_clusters);
+  const DataT alpha = 1;
+  const DataT beta  = 0;
+  for (IndexT b = 0; b < batches.n_batches(); b++) {
+    const IndexT rows = batches.rows(b);
+    const IndexT row0 = batches.first_row(b);
+    raft::sparse::linalg::spmm(
+      handle,
+      false,
+      false,
+      &alpha,
+      batches.view(b),
+      centers_t,
+      &beta,
+      raft::make_device_matrix_view<DataT, IndexT, raft::col_major>(dots.data(), rows, n_clusters));
+    constexpr int kBlockSize = 256;
+    sparse_nearest_center_kernel<DataT, IndexT>
+      <<<raft::ceildiv<IndexT>(rows, kBlockSize), kBlockSize, 0, stream>>>(
+        dots.data(),
+        x_norms + row0,
+        c_norms,
+        rows,
+        n_clusters,
+        accumulate,
+        min_cluster_and_distance.data_handle() + row0);
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+  }
+}
+
+/** The squared L2 norms of the rows of a dense row-major matrix. */
+template <typename DataT, typename IndexT>
+void sparse_center_norms(raft::resources const& handle,
+                         raft::device_matrix_view<const DataT, IndexT> centroids,
+                         DataT* out)
+{
+  raft::linalg::rowNorm(out,
+                        centroids.data_handle(),
+                        centroids.extent(1),
+                        centroids.extent(0),
+                        raft::linalg::L2Norm,
+                        true,
+                        resource::get_cuda_stream(handle));
+}
+
+/**
+ * The sequential greedy k-means++: every next center is a row drawn with the probability
+ * proportional to its weighted squared distance to the nearest of the centers picked so far.
+ * Every pick is one pass over the data (a CSR x dense-vector product); the picked rows are
+ * densified into the centers.
+ */
+template <typename DataT, typename IndexT, typename NZT>
+void sparse_kmeans_plus_plus(raft::resources const& handle,
+                             const KMeansParams& params,
+                             raft::device_csr_matrix_view<const DataT, int, int, NZT> X,
+                             csr_row_batches<DataT, IndexT, NZT>& batches,
+                             const DataT* x_norms,
+                             const DataT* weight,
+                             raft::device_matrix_view<DataT, IndexT> centroids,
+                             rmm::device_uvector<DataT>& dots)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope("sparse_kmeans_plus_plus");
+  auto stream             = resource::get_cuda_stream(handle);
+  const IndexT n_samples  = X.structure_view().get_n_rows();
+  const IndexT n_clusters = centroids.extent(0);
+  const IndexT n_features = centroids.extent(1);
+  std::mt19937 gen(params.rng_state.seed);
+
+  auto min_dist = raft::make_device_vector<raft::KeyValuePair<IndexT, DataT>, IndexT>(
+    handle, n_samples);
+  auto cum_dist = raft::make_device_vector<DataT, IndexT>(handle, n_samples);
+  auto c_norm   = raft::make_device_scalar(handle, DataT(0));
+  std::vector<IndexT> pick{std::uniform_int_distribution<IndexT>(0, n_samples - 1)(gen)};
+  for (IndexT c = 0; c < n_clusters; c++) {
+    auto center = raft::make_device_matrix_view<DataT, IndexT>(
+      centroids.data_handle() + size_t(c) * n_features, 1, n_features);
+    sparse_gather_rows<DataT, IndexT, NZT>(handle, X, pick, center);
+    if (c + 1 == n_clusters) { break; }
+    sparse_center_norms<DataT, IndexT>(
+      handle, raft::make_const_mdspan(center), c_norm.data_handle());
+    sparse_min_cluster_and_distance<DataT, IndexT, NZT>(handle,
+                                                        batches,
+                                                        x_norms,
+                                                        raft::make_const_mdspan(center),
+                                                        c_norm.data_handle(),
+                                                        min_dist.view(),
+                                                        dots,
+                                                        c > 0);
+
+    // draw the next center
+    const auto* d = min_dist.data_handle();
+    thrust::transform_inclusive_scan(
+      resource::get_thrust_policy(handle),
+      thrust::make_counting_iterator<IndexT>(0),
+      thrust::make_counting_iterator<IndexT>(n_samples),
+      cum_dist.data_handle(),
+      [=] __device__(IndexT i) { return d[i].value * weight[i]; },
+      thrust::plus<DataT>{});
+    DataT total = 0;
+    raft::copy(&total, cum_dist.data_handle() + n_samples - 1, 1, stream);
+    resource::sync_stream(handle, stream);
+    if (total <= DataT(0)) {
+      // all the rows coincide with the centers
+      pick[0] = std::uniform_int_distribution<IndexT>(0, n_samples - 1)(gen);
+      continue;
+    }
+    const DataT threshold = std::uniform_real_distribution<DataT>(0, total)(gen);
+    auto* found           = thrust::upper_bound(resource::get_thrust_policy(handle),
+                                      cum_dist.data_handle(),
+                                      cum_dist.data_handle() + n_samples,
+                                      threshold);
+    pick[0]               = std::min<IndexT>(found - cum_dist.data_handle(), n_samples - 1);
+  }
+}
+
+/**
+ * The weighted sum of the distances of the rows to their nearest centers (the square roots of the
+ * squared distances for `L2SqrtExpanded`).
+ */
+template <typename DataT, typename IndexT>
+auto sparse_cluster_cost(
+  raft::resources const& handle,
+  const KMeansParams& params,
+  raft::device_vector_view<const raft::KeyValuePair<IndexT, DataT>, IndexT> nearest,
+  const DataT* weight) -> DataT
+{
+  const bool sqrt_dist = params.metric == raft::distance::DistanceType::L2SqrtExpanded;
+  const auto* d        = nearest.data_handle();
+  return thrust::transform_reduce(
+    resource::get_thrust_policy(handle),
+    thrust::make_counting_iterator<IndexT>(0),
+    thrust::make_counting_iterator<IndexT>(nearest.extent(0)),
+    [=] __device__(IndexT i) {
+      return weight[i] * (sqrt_dist ? raft::sqrt(d[i].value) : d[i].value);
+    },
+    DataT(0),
+    thrust::plus<DataT>{});
+}
+
+/** Lloyd's iterations from the given centers, and the inertia of the final centers. */
+template <typename DataT, typename IndexT, typename NZT>
+void sparse_kmeans_fit_main(raft::resources const& handle,
+                            const KMeansParams& params,
+                            raft::device_csr_matrix_view<const DataT, int, int, NZT> X,
+                            csr_row_batches<DataT, IndexT, NZT>& batches,
+                            const DataT* x_norms,
+                            const DataT* weight,
+                            raft::device_matrix_view<DataT, IndexT> centroids,
+                            raft::host_scalar_view<DataT> inertia,
+                            raft::host_scalar_view<IndexT> n_iter,
+                            rmm::device_uvector<DataT>& dots)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope("sparse_kmeans_fit_main");
+  auto stream             = resource::get_cuda_stream(handle);
+  const IndexT n_samples  = X.structure_view().get_n_rows();
+  const IndexT n_clusters = centroids.extent(0);
+  const IndexT n_features = centroids.extent(1);
+  auto structure          = X.structure_view();
+
+  auto min_cluster_and_distance =
+    raft::make_device_vector<raft::KeyValuePair<IndexT, DataT>, IndexT>(handle, n_samples);
+  auto c_norms        = raft::make_device_vector<DataT, IndexT>(handle, n_clusters);
+  auto sums           = raft::make_device_matrix<DataT, IndexT>(handle, n_clusters, n_features);
+  auto cluster_weight = raft::make_device_vector<DataT, IndexT>(handle, n_clusters);
+  auto sqrd_norm      = raft::make_device_scalar(handle, DataT(0));
+  auto assign         = [&]() {
+    sparse_center_norms<DataT, IndexT>(
+      handle, raft::make_const_mdspan(centroids), c_norms.data_handle());
+    sparse_min_cluster_and_distance<DataT, IndexT, NZT>(handle,
+                                                        batches,
+                                                        x_norms,
+                                                        raft::make_const_mdspan(centroids),
+                                                        c_norms.data_handle(),
+                                                        min_cluster_and_distance.view(),
+                                                        dots);
+  };
+
+  for (n_iter[0] = 1; n_iter[0] <= params.max_iter; ++n_iter[0]) {
+    assign();
+
+    // The sums of the rows of every cluster: the sparse rows are reduced by their labels straight
+    // into the dense sums
+    RAFT_CUDA_TRY(cudaMemsetAsync(sums.data_handle(), 0, sums.size() * sizeof(DataT), stream));
+    RAFT_CUDA_TRY(cudaMemsetAsync(
+      cluster_weight.data_handle(), 0, cluster_weight.size() * sizeof(DataT), stream));
+    constexpr int kBlockSize = 256;
+    sparse_sum_by_cluster_kernel<DataT, IndexT>
+      <<<raft::ceildiv<size_t>(size_t(n_samples) * WarpSize, kBlockSize), kBlockSize, 0, stream>>>(
+        structure.get_indptr().data(),
+        structure.get_indices().data(),
+        X.get_elements().data(),
+        weight,
+        min_cluster_and_distance.data_handle(),
+        n_samples,
+        n_features,
+        sums.data_handle(),
+        cluster_weight.data_handle());
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+    // The new centers are the means; the empty clusters keep their centers. The squared distance
+    // the centers move decides the convergence.
+    const DataT* cw = cluster_weight.data_handle();
+    const DataT* c  = centroids.data_handle();
+    const DataT* s  = sums.data_handle();
+    raft::linalg::map_offset(handle, sums.view(), [=] __device__(IndexT i) {
+      const DataT w = cw[i / n_features];
+      return w == DataT(0) ? c[i] : s[i] / w;
+    });
+    raft::linalg::mapThenSumReduce(sqrd_norm.data_handle(),
+                                   centroids.size(),
+                                   raft::sqdiff_op{},
+                                   stream,
+                                   centroids.data_handle(),
+                                   sums.data_handle());
+    raft::copy(centroids.data_handle(), sums.data_handle(), sums.size(), stream);
+    DataT sqrd_norm_error = 0;
+    raft::copy(&sqrd_norm_error, sqrd_norm.data_handle(), 1, stream);
+    resource::sync_stream(handle, stream);
+    RAFT_LOG_DEBUG(
+      "KMeans.fit(sparse): iteration-%d: the centroids moved by %f", n_iter[0], sqrd_norm_error);
+    if (sqrd_norm_error < params.tol) { break; }
+  }
+  n_iter[0] = std::min<IndexT>(n_iter[0], params.max_iter);
+
+  // The inertia of the final centers
+  assign();
+  inertia[0] = sparse_cluster_cost<DataT, IndexT>(
+    handle, params, raft::make_const_mdspan(min_cluster_and_distance.view()), weight);
+}
+
+
+/** Check the parameters and the shapes shared by the sparse fit and predict. */
+template <typename DataT, typename IndexT, typename NZT>
+void sparse_kmeans_check(const KMeansParams& params,
+                         raft::device_csr_matrix_view<const DataT, int, int, NZT> X,
+                         std::optional<raft::device_vector_view<const DataT, IndexT>> sample_weight,
+                         raft::device_matrix_view<const DataT, IndexT> centroids)
+{
+  auto structure = X.structure_view();
+  RAFT_EXPECTS(params.n_clusters > 0, "invalid parameter (n_clusters<=0)");
+  RAFT_EXPECTS(centroids.extent(0) == params.n_clusters,
+               "invalid parameter (centroids.extent(0) != n_clusters)");
+  RAFT_EXPECTS(centroids.extent(1) == structure.get_n_cols(),
+               "invalid parameter (centroids.extent(1) != n_features)");
+  RAFT_EXPECTS(params.metric == raft::distance::DistanceType::L2Expanded ||
+                 params.metric == raft::distance::DistanceType::L2SqrtExpanded,
+               "invalid parameter (the sparse k-means supports only the L2 metrics)");
+  if (sample_weight.has_value())
+    RAFT_EXPECTS(sample_weight.value().extent(0) == structure.get_n_rows(),
+                 "invalid parameter (sample_weight!=n_samples)");
+}
+
+/** The weights of the samples (ones by default), optionally normalized to sum up to n_samples. */
+template <typename DataT, typename IndexT>
+auto sparse_kmeans_weight(
+  raft::resources const& handle,
+  IndexT n_samples,
+  std::optional<raft::device_vector_view<const DataT, IndexT>> sample_weight,
+  bool normalize_weight,
+  rmm::device_uvector<char>& workspace)
+{
+  auto stream = resource::get_cuda_stream(handle);
+  auto weight = raft::make_device_vector<DataT, IndexT>(handle, n_samples);
+  if (sample_weight.has_value()) {
+    raft::copy(weight.data_handle(), sample_weight.value().data_handle(), n_samples, stream);
+  } else {
+    thrust::fill(resource::get_thrust_policy(handle),
+                 weight.data_handle(),
+                 weight.data_handle() + weight.size(),
+                 DataT(1));
+  }
+  if (normalize_weight) { checkWeight<DataT>(handle, weight.view(), workspace); }
+  return weight;
+}
+
+/** The squared L2 norms of the rows of the CSR matrix. */
+template <typename DataT, typename IndexT, typename NZT>
+auto sparse_row_norms(raft::resources const& handle,
+                      raft::device_csr_matrix_view<const DataT, int, int, NZT> X)
+{
+  auto structure = X.structure_view();
+  auto norms     = raft::make_device_vector<DataT, IndexT>(handle, structure.get_n_rows());
+  raft::sparse::linalg::rowNormCsr(handle,
+                                   structure.get_indptr().data(),
+                                   X.get_elements().data(),
+                                   int(structure.get_nnz()),
+                                   int(structure.get_n_rows()),
+                                   norms.data_handle(),
+                                   raft::linalg::L2Norm);
+  return norms;
+}
+
+template <typename DataT, typename IndexT, typename NZT>
+void kmeans_fit_sparse(raft::resources const& handle,
+                       const KMeansParams& params,
+                       raft::device_csr_matrix_view<const DataT, int, int, NZT> X,
+                       std::optional<raft::device_vector_view<const DataT, IndexT>> sample_weight,
+                       raft::device_matrix_view<DataT, IndexT> centroids,
+                       raft::host_scalar_view<DataT> inertia,
+                       raft::host_scalar_view<IndexT> n_iter)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope("kmeans_fit_sparse");
+  logger::get(RAFT_NAME).set_level(params.verbosity);
+  auto stream             = resource::get_cuda_stream(handle);
+  const IndexT n_samples  = X.structure_view().get_n_rows();
+  const IndexT n_clusters = params.n_clusters;
+  sparse_kmeans_check<DataT, IndexT, NZT>(
+    params, X, sample_weight, raft::make_const_mdspan(centroids));
+  RAFT_EXPECTS(params.tol > 0, "invalid parameter (tol<=0)");
+  RAFT_EXPECTS(n_samples >= n_clusters, "invalid parameter (n_samples<n_clusters)");
+
+  rmm::device_uvector<char> workspace(0, stream);
+  rmm::device_uvector<DataT> dots(0, stream);
+  auto weight =
+    sparse_kmeans_weight<DataT, IndexT>(handle, n_samples, sample_weight, true, workspace);
+  auto x_norms = sparse_row_norms<DataT, IndexT, NZT>(handle, X);
+  csr_row_batches<DataT, IndexT, NZT> batches(handle, X, params.batch_samples);
+  auto centroids_tmp =
+    raft::make_device_matrix<DataT, IndexT>(handle, n_clusters, centroids.extent(1));
+
+  auto n_init = params.init == KMeansParams::InitMethod::Array ? 1 : params.n_init;
+  std::mt19937 gen(params.rng_state.seed);
+  inertia[0] = std::numeric_limits<DataT>::max();
+  for (auto seed_iter = 0; seed_iter < n_init; ++seed_iter) {
+    KMeansParams iter_params   = params;
+    iter_params.rng_state.seed = gen();
+
+    if (iter_params.init == KMeansParams::InitMethod::Random) {
+      // a partial Fisher-Yates shuffle of the row ids
+      std::mt19937 init_gen(iter_params.rng_state.seed);
+      std::vector<IndexT> ids(n_samples);
+      std::iota(ids.begin(), ids.end(), IndexT(0));
+      for (IndexT i = 0; i < n_clusters; i++) {
+        std::swap(ids[i], ids[std::uniform_int_distribution<IndexT>(i, n_samples - 1)(init_gen)]);
+      }
+      ids.resize(n_clusters);
+      sparse_gather_rows<DataT, IndexT, NZT>(handle, X, ids, centroids_tmp.view());
+    } else if (iter_params.init == KMeansParams::InitMethod::KMeansPlusPlus) {
+      sparse_kmeans_plus_plus<DataT, IndexT, NZT>(handle,
+                                                  iter_params,
+                                                  X,
+                                                  batches,
+                                                  x_norms.data_handle(),
+                                                  weight.data_handle(),
+                                                  centroids_tmp.view(),
+                                                  dots);
+    } else if (iter_params.init == KMeansParams::InitMethod::Array) {
+      raft::copy(centroids_tmp.data_handle(), centroids.data_handle(), centroids.size(), stream);
+    } else {
+      THROW("unknown initialization method to select initial centers");
+    }
+
+    DataT iter_inertia    = std::numeric_limits<DataT>::max();
+    IndexT n_current_iter = 0;
+    sparse_kmeans_fit_main<DataT, IndexT, NZT>(handle,
+                                               iter_params,
+                                               X,
+                                               batches,
+                                               x_norms.data_handle(),
+                                               weight.data_handle(),
+                                               centroids_tmp.view(),
+                                               raft::make_host_scalar_view(&iter_inertia),
+                                               raft::make_host_scalar_view(&n_current_iter),
+                                               dots);
+    if (iter_inertia < inertia[0]) {
+      inertia[0] = iter_inertia;
+      n_iter[0]  = n_current_iter;
+      raft::copy(centroids.data_handle(), centroids_tmp.data_handle(), centroids.size(), stream);
+    }
+    RAFT_LOG_DEBUG("KMeans.fit(sparse) after iteration-%d/%d: inertia - %f, n_iter[0] - %d",
+                   seed_iter + 1,
+                   n_init,
+                   inertia[0],
+                   n_iter[0]);
+  }
+}
+
+template <typename DataT, typename IndexT, typename NZT>
+void kmeans_predict_sparse(
+  raft::resources const& handle,
+  const KMeansParams& params,
+  raft::device_csr_matrix_view<const DataT, int, int, NZT> X,
+  std::optional<raft::device_vector_view<const DataT, IndexT>> sample_weight,
+  raft::device_matrix_view<const DataT, IndexT> centroids,
+  raft::device_vector_view<IndexT, IndexT> labels,
+  bool normalize_weight,
+  raft::host_scalar_view<DataT> inertia)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope("kmeans_predict_sparse");
+  auto stream            = resource::get_cuda_stream(handle);
+  const IndexT n_samples = X.structure_view().get_n_rows();
+  sparse_kmeans_check<DataT, IndexT, NZT>(params, X, sample_weight, centroids);
+  RAFT_EXPECTS(labels.extent(0) == n_samples, "invalid parameter (labels!=n_samples)");
+
+  rmm::device_uvector<char> workspace(0, stream);
+  rmm::device_uvector<DataT> dots(0, stream);
+  auto weight  = sparse_kmeans_weight<DataT, IndexT>(
+    handle, n_samples, sample_weight, normalize_weight, workspace);
+  auto x_norms = sparse_row_norms<DataT, IndexT, NZT>(handle, X);
+  auto c_norms = raft::make_device_vector<DataT, IndexT>(handle, centroids.extent(0));
+  csr_row_batches<DataT, IndexT, NZT> batches(handle, X, params.batch_samples);
+  auto nearest =
+    raft::make_device_vector<raft::KeyValuePair<IndexT, DataT>, IndexT>(handle, n_samples);
+  sparse_center_norms<DataT, IndexT>(handle, centroids, c_norms.data_handle());
+  sparse_min_cluster_and_distance<DataT, IndexT, NZT>(handle,
+                                                      batches,
+                                                      x_norms.data_handle(),
+                                                      centroids,
+                                                      c_norms.data_handle(),
+                                                      nearest.view(),
+                                                      dots);
+  const auto* d = nearest.data_handle();
+  raft::linalg::map_offset(handle, labels, [=] __device__(IndexT i) { return d[i].key; });
+  inertia[0] = sparse_cluster_cost<DataT, IndexT>(
+    handle, params, raft::make_const_mdspan(nearest.view()), weight.data_handle());
+}
+
+}  // namespace raft::cluster::detail
@@ -18,8 +18,14 @@
 #include <optional>
 #include <raft/cluster/detail/kmeans.cuh>
 #include <raft/cluster/detail/kmeans_auto_find_k.cuh>
+#include <raft/cluster/detail/kmeans_mg.cuh>
+#include <raft/cluster/detail/kmeans_minibatch.cuh>
+#include <raft/cluster/detail/kmeans_sparse.cuh>
+#include <raft/cluster/kmeans_predictor.cuh>
 #include <raft/cluster/kmeans_types.hpp>
+#include <raft/core/device_csr_matrix.hpp>
 #include <raft/core/kvp.hpp>
+#include <raft/core/memory_estimate.hpp>
 #include <raft/core/mdarray.hpp>
 #include <raft/core/operators.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
@@ -96,6 +102,264 @@ void fit(raft::resources const& handle,
   detail::kmeans_fit<DataT, IndexT>(handle, params, X, sample_weight, centroids, inertia, n_iter);
 }
 
+/**
+ * @brief Estimate the memory `kmeans::fit` needs for the given problem sizes.
+ *
+ * The estimate is the peak of the temporary device buffers of the initialization and the
+ * iterations; the centroids are the output of the caller and are not counted. Only the buffers
+ * proportional to the problem sizes are counted, so the estimate is a little below the actual
+ * peak; it is meant for choosing the sizes (or `params.batch_samples`) before allocating anything.
+ *
+ * @code{.cpp}
+ *   auto est = raft::cluster::kmeans::estimate_fit_memory<float, int>(params, n_samples, dim);
+ *   if (est.device_peak() > free_bytes) { params.batch_samples /= 4; }
+ * @endcode
+ *
+ * @tparam DataT the type of data used for weights, distances.
+ * @tparam IndexT the type of data used for indexing.
+ * @param[in] params Parameters for KMeans model.
+ * @param[in] n_samples the number of training instances
+ * @param[in] n_features the dimensionality of the training instances
+ * @return the estimated memory, in bytes
+ */
+template <typename DataT, typename IndexT>
+auto estimate_fit_memory(const KMeansParams& params, IndexT n_samples, IndexT n_features)
+  -> raft::memory_estimate
+{
+  raft::memory_estimate estimate;
+  estimate.device_workspace =
+    detail::estimate_fit_workspace<DataT, IndexT>(params, n_samples, n_features);
+  return estimate;
+}
+
+/**
+ * @brief Find clusters with the mini-batch k-means algorithm, streaming the data from host memory.
+ *
+ * The centroids are updated after every mini-batch of `params.minibatch_size` samples with the
+ * per-center learning rates of "Web-Scale K-Means Clustering", 2010, D. Sculley, so that only two
+ * mini-batches are resident in the device memory at a time: the training set may be much larger
+ * than the device memory. The mini-batches are copied to the device through a pair of pinned
+ * buffers, overlapping the copies with the computation (on a stream of the stream pool of the
+ * handle, when it has one). Every pass visits the mini-batches in a new random order; the samples
+ * of X should not be sorted by cluster.
+ *
+ * @code{.cpp}
+ *   #include <raft/core/resources.hpp>
+ *   #include <raft/cluster/kmeans.cuh>
+ *   #include <raft/cluster/kmeans_types.hpp>
+ *   using namespace raft::cluster;
+ *   ...
+ *   raft::raft::resources handle;
+ *   raft::cluster::KMeansMiniBatchParams params;
+ *   params.minibatch_size = 1 << 20;
+ *   float inertia;
+ *   int n_iter;
+ *   auto centroids = raft::make_device_matrix<float, int>(handle, params.n_clusters, n_features);
+ *
+ *   kmeans::fit_minibatch(handle,
+ *                         params,
+ *                         X_host,
+ *                         centroids.view(),
+ *                         raft::make_host_scalar_view(&inertia),
+ *                         raft::make_host_scalar_view(&n_iter));
+ * @endcode
+ *
+ * @tparam DataT the type of data used for weights, distances.
+ * @tparam IndexT the type of data used for indexing.
+ * @param[in]     handle        The raft handle.
+ * @param[in]     params        Parameters for the mini-batch KMeans model.
+ * @param[in]     X             Training instances to cluster in host memory. The data must
+ *                              be in row-major format.
+ *                              [dim = n_samples x n_features]
+ * @param[inout]  centroids     [in] When init is InitMethod::Array, use
+ *                              centroids as the initial cluster centers.
+ *                              [out] The generated centroids.
+ *                              [dim = n_clusters x n_features]
+ * @param[out]    inertia       Sum of squared distances of samples to their
+ *                              closest cluster center.
+ * @param[out]    n_iter        Number of passes over the data.
+ */
+template <typename DataT, typename IndexT>
+void fit_minibatch(raft::resources const& handle,
+                   const KMeansMiniBatchParams& params,
+                   raft::host_matrix_view<const DataT, IndexT> X,
+                   raft::device_matrix_view<DataT, IndexT> centroids,
+                   raft::host_scalar_view<DataT> inertia,
+                   raft::host_scalar_view<IndexT> n_iter)
+{
+  detail::kmeans_fit_minibatch<DataT, IndexT>(handle, params, X, centroids, inertia, n_iter);
+}
+
+/**
+ * @brief Find clusters with the k-means algorithm on sparse (CSR) input, without densifying it.
+ *
+ * The distances of the samples to the (dense) centroids are computed from the products of the
+ * batches of `params.batch_samples` rows and the centroids (cuSPARSE SpMM) and the precomputed
+ * squared norms, and the centroids are updated by reducing the nonzeros of the samples by their
+ * labels; hence, the memory scales with the number of nonzeros and the size of the centroids,
+ * not with `n_samples x n_features`. Only the L2 metrics (`L2Expanded`, `L2SqrtExpanded`) are
+ * supported. With `InitMethod::KMeansPlusPlus`, the centroids are picked by the sequential greedy
+ * k-means++ (`oversampling_factor` and `init_batch_size` are ignored).
+ *
+ * @code{.cpp}
+ *   #include <raft/core/resources.hpp>
+ *   #include <raft/cluster/kmeans.cuh>
+ *   #include <raft/cluster/kmeans_types.hpp>
+ *   using namespace raft::cluster;
+ *   ...
+ *   raft::raft::resources handle;
+ *   raft::cluster::KMeansParams params;
+ *   float inertia;
+ *   int n_iter;
+ *   auto X = raft::make_device_csr_matrix_view<const float, int, int, int>(
+ *     values.data(), raft::make_device_compressed_structure_view<int, int, int>(
+ *       indptr.data(), indices.data(), n_samples, n_features, nnz));
+ *   auto centroids = raft::make_device_matrix<float, int>(handle, params.n_clusters, n_features);
+ *
+ *   kmeans::fit(handle,
+ *               params,
+ *               X,
+ *               std::nullopt,
+ *               centroids.view(),
+ *               raft::make_host_scalar_view(&inertia),
+ *               raft::make_host_scalar_view(&n_iter));
+ * @endcode
+ *
+ * @tparam DataT the type of data used for weights, distances.
+ * @tparam IndexT the type of data used for indexing.
+ * @tparam NZT the type of the number of nonzeros of X.
+ * @param[in]     handle        The raft handle.
+ * @param[in]     params        Parameters for KMeans model.
+ * @param[in]     X             Training instances to cluster, a CSR matrix.
+ *                              [dim = n_samples x n_features]
+ * @param[in]     sample_weight Optional weights for each observation in X.
+ *                              [len = n_samples]
+ * @param[inout]  centroids     [in] When init is InitMethod::Array, use
+ *                              centroids as the initial cluster centers.
+ *                              [out] The generated centroids from the
+ *                              kmeans algorithm are stored at the address
+ *                              pointed by 'centroids'.
+ *                              [dim = n_clusters x n_features]
+ * @param[out]    inertia       Sum of squared distances of samples to their
+ *                              closest cluster center.
+ * @param[out]    n_iter        Number of iterations run.
+ */
+template <typename DataT, typename IndexT, typename NZT>
+void fit(raft::resources const& handle,
+         const KMeansParams& params,
+         raft::device_csr_matrix_view<const DataT, int, int, NZT> X,
+         std::optional<raft::device_vector_view<const DataT, IndexT>> sample_weight,
+         raft::device_matrix_view<DataT, IndexT> centroids,
+         raft::host_scalar_view<DataT> inertia,
+         raft::host_scalar_view<IndexT> n_iter)
+{
+  detail::kmeans_fit_sparse<DataT, IndexT, NZT>(
+    handle, params, X, sample_weight, centroids, inertia, n_iter);
+}
+
+/**
+ * @brief Predict the closest cluster each sample of the sparse (CSR) input belongs to.
+ *
+ * See the sparse `fit` for the computation of the distances.
+ *
+ * @tparam DataT the type of data used for weights, distances.
+ * @tparam IndexT the type of data used for indexing.
+ * @tparam NZT the type of the number of nonzeros of X.
+ * @param[in]     handle           The raft handle.
+ * @param[in]     params           Parameters for KMeans model.
+ * @param[in]     X                New data to predict, a CSR matrix.
+ *                                 [dim = n_samples x n_features]
+ * @param[in]     sample_weight    Optional weights for each observation in X.
+ *                                 [len = n_samples]
+ * @param[in]     centroids        Cluster centroids. The data must be in
+ *                                 row-major format.
+ *                                 [dim = n_clusters x n_features]
+ * @param[out]    labels           Index of the cluster each sample in X
+ *                                 belongs to.
+ *                                 [len = n_samples]
+ * @param[in]     normalize_weight True if the weights should be normalized
+ * @param[out]    inertia          Sum of squared distances of samples to
+ *                                 their closest cluster center.
+ */
+template <typename DataT, typename IndexT, typename NZT>
+void predict(raft::resources const& handle,
+             const KMeansParams& params,
+             raft::device_csr_matrix_view<const DataT, int, int, NZT> X,
+             std::optional<raft::device_vector_view<const DataT, IndexT>> sample_weight,
+             raft::device_matrix_view<const DataT, IndexT> centroids,
+             raft::device_vector_view<IndexT, IndexT> labels,
+             bool normalize_weight,
+             raft::host_scalar_view<DataT> inertia)
+{
+  detail::kmeans_predict_sparse<DataT, IndexT, NZT>(
+    handle, params, X, sample_weight, centroids, labels, normalize_weight, inertia);
+}
+
+/**
+ * @brief Find clusters with k-means algorithm in a dataset distributed across multiple GPUs.
+ *
+ * Every rank of the communicator attached to the handle passes its own part of the dataset. In
+ * every iteration, each rank assigns its local samples to the closest centroids and computes the
+ * per-cluster sums and weights of them; these are combined with an allreduce, so that all ranks
+ * obtain the same centroids. The initialization methods are the ones of `fit`, except that
+ * InitMethod::KMeansPlusPlus always uses the distributed scalable k-means++ (with the
+ * oversampling factor of 2 when `params.oversampling_factor` is 0). With InitMethod::Array, the
+ * centroids passed on the root rank are used.
+ *
+ * The closest centroids of the local samples can then be found on every rank with `predict`.
+ *
+ * @code{.cpp}
+ *   #include <raft/cluster/kmeans.cuh>
+ *   #include <raft/comms/std_comms.hpp>
+ *   using namespace raft::cluster;
+ *   ...
+ *   raft::resources handle;
+ *   raft::comms::build_comms_nccl_only(&handle, nccl_comm, n_ranks, rank);
+ *   raft::cluster::KMeansParams params;
+ *   float inertia;
+ *   int n_iter;
+ *   auto centroids = raft::make_device_matrix<float, int>(handle, params.n_clusters, n_features);
+ *
+ *   kmeans::fit_mg(handle,
+ *                  params,
+ *                  local_X,
+ *                  std::nullopt,
+ *                  centroids.view(),
+ *                  raft::make_host_scalar_view(&inertia),
+ *                  raft::make_host_scalar_view(&n_iter));
+ * @endcode
+ *
+ * @tparam DataT the type of data used for weights, distances.
+ * @tparam IndexT the type of data used for indexing.
+ * @param[in]     handle        The raft handle with an initialized communicator.
+ * @param[in]     params        Parameters for KMeans model.
+ * @param[in]     X             The local part of the training instances. It must be noted
+ *                              that the data must be in row-major format and stored in device
+ *                              accessible location.
+ *                              [dim = n_local_samples x n_features]
+ * @param[in]     sample_weight Optional weights for each local observation in X.
+ *                              [len = n_local_samples]
+ * @param[inout]  centroids     [in] When init is InitMethod::Array, use
+ *                              centroids as the initial cluster centers.
+ *                              [out] The generated centroids, the same on all ranks.
+ *                              [dim = n_clusters x n_features]
+ * @param[out]    inertia       Sum of squared distances of all samples to their
+ *                              closest cluster center.
+ * @param[out]    n_iter        Number of iterations run.
+ */
+template <typename DataT, typename IndexT>
+void fit_mg(raft::resources const& handle,
+            const KMeansParams& params,
+            raft::device_matrix_view<const DataT, IndexT> X,
+            std::optional<raft::device_vector_view<const DataT, IndexT>> sample_weight,
+            raft::device_matrix_view<DataT, IndexT> centroids,
+            raft::host_scalar_view<DataT> inertia,
+            raft::host_scalar_view<IndexT> n_iter)
+{
+  detail::kmeans_fit_mg<DataT, IndexT>(
+    handle, params, X, sample_weight, centroids, inertia, n_iter);
+}
+
 /**
  * @brief Predict the closest cluster each sample in X belongs to.
  *
@@ -266,6 +530,9 @@ void transform(raft::resources const& handle,
 /**
  * Automatically find the optimal value of k using a binary search.
  * This method maximizes the Calinski-Harabasz Index while minimizing the per-cluster inertia.
+ * When the handle has a stream pool, the independent candidates are fitted concurrently on its
+ * streams, and with three or more streams the bisection also evaluates the midpoints of both
+ * halves of the current range in advance.
  *
  *  @code{.cpp}
  *   #include <raft/core/handle.hpp>
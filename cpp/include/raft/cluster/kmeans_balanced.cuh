@@ -20,7 +20,9 @@
 #include <utility>
 
 #include <raft/cluster/detail/kmeans_balanced.cuh>
+#include <raft/cluster/detail/kmeans_balanced_mg.cuh>
 #include <raft/core/mdarray.hpp>
+#include <raft/core/memory_estimate.hpp>
 #include <raft/util/cuda_utils.cuh>
 
 namespace raft::cluster::kmeans_balanced {
@@ -47,7 +49,9 @@ namespace raft::cluster::kmeans_balanced {
  *
  * Additionally, this algorithm supports quantized datasets in arbitrary types but the core part of
  * the algorithm will work with a floating-point type, hence a conversion function can be provided
- * to map the data type to the math type.
+ * to map the data type to the math type. For the fp16 (`half`) data with the fp32 math type and a
+ * plain conversion (`raft::identity_op` or `raft::cast_op<float>`), the assignment step runs an
+ * fp16 GEMM with fp32 accumulation on the tensor cores instead, and the data stays in fp16.
  *
  * @code{.cpp}
  *   #include <raft/core/handle.hpp>
@@ -98,6 +102,61 @@ void fit(const raft::resources& handle,
                              mapping_op);
 }
 
+/**
+ * @brief Find clusters of balanced sizes in a dataset distributed across multiple GPUs.
+ *
+ * Every rank of the communicator attached to the handle passes its own part of the dataset. The
+ * initial centroids are found by the hierarchical k-means (see `fit`) on the part of the root
+ * rank; they are then refined by k-means iterations over the whole dataset, in which every rank
+ * processes its local part and the centroids are combined with an allreduce of the per-cluster
+ * sums and sizes. All ranks obtain the same centroids.
+ *
+ * @code{.cpp}
+ *   // the handle is initialized with the communicator, e.g. via raft::comms::build_comms_nccl_only
+ *   raft::cluster::kmeans_balanced_params params;
+ *   auto centroids = raft::make_device_matrix<float, int>(handle, n_clusters, n_features);
+ *   raft::cluster::kmeans_balanced::fit_mg(handle, params, local_X, centroids.view());
+ * @endcode
+ *
+ * @tparam DataT Type of the input data.
+ * @tparam MathT Type of the centroids and mapped data.
+ * @tparam IndexT Type used for indexing.
+ * @tparam MappingOpT Type of the mapping function.
+ * @param[in]  handle     The raft resources with an initialized communicator
+ * @param[in]  params     Structure containing the hyper-parameters
+ * @param[in]  X          The local part of the training instances. The data must be in row-major
+ *                        format. [dim = n_local_samples x n_features]
+ * @param[out] centroids  The generated centroids [dim = n_clusters x n_features]
+ * @param[in]  mapping_op (optional) Functor to convert from the input datatype to the arithmetic
+ *                        datatype. If DataT == MathT, this must be the identity.
+ */
+template <typename DataT, typename MathT, typename IndexT, typename MappingOpT = raft::identity_op>
+void fit_mg(const raft::resources& handle,
+            kmeans_balanced_params const& params,
+            raft::device_matrix_view<const DataT, IndexT> X,
+            raft::device_matrix_view<MathT, IndexT> centroids,
+            MappingOpT mapping_op = raft::identity_op())
+{
+  RAFT_EXPECTS(X.extent(1) == centroids.extent(1),
+               "Number of features in dataset and centroids are different");
+  RAFT_EXPECTS(static_cast<uint64_t>(X.extent(0)) * static_cast<uint64_t>(X.extent(1)) <=
+                 static_cast<uint64_t>(std::numeric_limits<IndexT>::max()),
+               "The chosen index type cannot represent all indices for the given dataset");
+  const bool is_root = resource::get_comms(handle).get_rank() == 0;
+  RAFT_EXPECTS(centroids.extent(0) > IndexT{0} && (!is_root || centroids.extent(0) <= X.extent(0)),
+               "The number of centroids must be strictly positive and cannot exceed the number of "
+               "points in the training dataset of the root rank.");
+
+  detail::build_hierarchical_mg(handle,
+                                params,
+                                X.extent(1),
+                                X.data_handle(),
+                                X.extent(0),
+                                centroids.data_handle(),
+                                centroids.extent(0),
+                                mapping_op);
+}
+
 /**
  * @brief Predict the closest cluster each sample in X belongs to.
  *
@@ -361,6 +420,42 @@ void calc_centers_and_sizes(const raft::resources& handle,
                                  mapping_op);
 }
 
+/**
+ * @brief Estimate the memory used by `kmeans_balanced::fit`.
+ *
+ * The estimate follows the minibatch heuristic of the training (`calc_minibatch_size`); the
+ * centroids are the output of the caller and are not counted.
+ *
+ * @code{.cpp}
+ *   raft::cluster::kmeans_balanced_params params;
+ *   auto est = raft::cluster::kmeans_balanced::helpers::estimate_fit_memory<float, float>(
+ *     params, n_samples, n_features, n_clusters);
+ *   if (est.device_peak() > budget) { ... }
+ * @endcode
+ *
+ * @tparam DataT Type of the input data.
+ * @tparam MathT Type of the centroids and mapped data.
+ * @tparam IndexT Type used for indexing.
+ * @tparam MappingOpT Type of the mapping function.
+ * @param[in] params     Structure containing the hyper-parameters
+ * @param[in] n_samples  Number of the training instances
+ * @param[in] n_features Number of the features of the training instances
+ * @param[in] n_clusters Number of the clusters
+ * @return the estimated memory, in bytes
+ */
+template <typename DataT, typename MathT, typename IndexT, typename MappingOpT = raft::identity_op>
+auto estimate_fit_memory(const kmeans_balanced_params& params,
+                         IndexT n_samples,
+                         IndexT n_features,
+                         IndexT n_clusters) -> raft::memory_estimate
+{
+  raft::memory_estimate estimate;
+  estimate.device_workspace =
+    detail::estimate_build_hierarchical_workspace<DataT, MathT, IndexT, MappingOpT>(
+      params, n_samples, n_features, n_clusters);
+  return estimate;
+}
+
 }  // namespace helpers
 
 }  // namespace raft::cluster::kmeans_balanced
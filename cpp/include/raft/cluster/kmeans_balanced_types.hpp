@@ -36,6 +36,20 @@ struct kmeans_balanced_params : kmeans_base_params {
    * Number of training iterations
    */
   uint32_t n_iters = 20;
+  /**
+   * Number of levels of the cluster hierarchy built by `fit`.
+   *
+   * Every level splits its data into about `n_clusters^(1 / hierarchy_depth)` parts; the default
+   * builds `sqrt(n_clusters)` mesoclusters and then the fine clusters within each of them. Deeper
+   * hierarchies keep the per-level problems small when training a very large number of clusters
+   * (e.g. `2^20` IVF lists). A depth of one builds all the clusters at once.
+   */
+  uint32_t hierarchy_depth = 2;
+  /**
+   * The maximum number of training points per cluster used below the top level of the hierarchy.
+   * Larger mesoclusters are evenly subsampled on the device. Zero means no limit.
+   */
+  uint32_t max_train_points_per_cluster = 0;
 };
 
 }  // namespace raft::cluster::kmeans_balanced
@@ -0,0 +1,278 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/cluster/detail/kmeans_common.cuh>
+#include <raft/cluster/kmeans_types.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/error.hpp>
+#include <raft/core/kvp.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/distance/fused_l2_nn.cuh>
+#include <raft/linalg/map.cuh>
+#include <raft/linalg/norm.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <cuda_runtime_api.h>
+
+#include <memory>
+#include <type_traits>
+
+namespace raft::cluster::kmeans {
+
+/**
+ * @defgroup kmeans_predictor k-means assignment of streamed batches
+ * @{
+ */
+
+/**
+ * @brief Assigns batches of samples to a fixed set of k-means centroids.
+ *
+ * The predictor keeps a copy of the centroids, their norms and all the temporary buffers of the
+ * assignment of up to `max_batch_size` samples. For the L2 metrics, `predict` then neither
+ * allocates memory nor recomputes anything that depends on the centroids only; the other metrics
+ * grow the workspace on the first call only.
+ *
+ * With `use_cuda_graph` (L2 metrics only), the kernels of a `predict` call are captured into a
+ * CUDA graph, which is replayed by the following calls as long as they pass the same input and
+ * output buffers with the same number of samples; otherwise the graph is captured again. The
+ * capture requires the stream of the handle not to be the legacy default stream.
+ *
+ * @code{.cpp}
+ *   #include <raft/cluster/kmeans.cuh>
+ *   ...
+ *   raft::cluster::kmeans::predictor<float, int> pred(
+ *     handle, params, raft::make_const_mdspan(centroids.view()), batch_size, true);
+ *   while (...) {
+ *     // fill `batch`
+ *     pred.predict(handle, raft::make_const_mdspan(batch.view()), labels.view());
+ *   }
+ * @endcode
+ *
+ * @tparam DataT the type of data used for weights, distances.
+ * @tparam IndexT the type of data used for indexing.
+ */
+template <typename DataT, typename IndexT = int>
+class predictor {
+ public:
+  /**
+   * @param[in] handle         The raft handle.
+   * @param[in] params         Parameters for KMeans model; `metric`, `batch_samples` and
+   *                           `batch_centroids` are used.
+   * @param[in] centroids      Cluster centroids, copied by the predictor.
+   *                           [dim = n_clusters x n_features]
+   * @param[in] max_batch_size The largest number of samples passed to `predict`.
+   * @param[in] use_cuda_graph Replay the assignment kernels from a CUDA graph.
+   */
+  predictor(raft::resources const& handle,
+            const KMeansParams& params,
+            raft::device_matrix_view<const DataT, IndexT> centroids,
+            IndexT max_batch_size,
+            bool use_cuda_graph = false)
+    : params_(params),
+      n_clusters_(centroids.extent(0)),
+      n_features_(centroids.extent(1)),
+      max_batch_size_(max_batch_size),
+      use_cuda_graph_(use_cuda_graph),
+      centroids_(0, resource::get_cuda_stream(handle)),
+      centroids_norm_(0, resource::get_cuda_stream(handle)),
+      x_norm_(0, resource::get_cuda_stream(handle)),
+      min_cluster_and_distance_(0, resource::get_cuda_stream(handle)),
+      dist_buf_(0, resource::get_cuda_stream(handle)),
+      workspace_(0, resource::get_cuda_stream(handle))
+  {
+    RAFT_EXPECTS(n_clusters_ > 0, "invalid parameter (n_clusters<=0)");
+    RAFT_EXPECTS(max_batch_size_ > 0, "invalid parameter (max_batch_size<=0)");
+    RAFT_EXPECTS(!use_cuda_graph_ || is_fused(),
+                 "The CUDA graph capture of predict is supported for the L2 metrics only.");
+    auto stream = resource::get_cuda_stream(handle);
+
+    centroids_.resize(centroids.size(), stream);
+    raft::copy(centroids_.data(), centroids.data_handle(), centroids.size(), stream);
+    x_norm_.resize(max_batch_size_, stream);
+    min_cluster_and_distance_.resize(max_batch_size_, stream);
+    if (is_fused()) {
+      centroids_norm_.resize(n_clusters_, stream);
+      raft::linalg::rowNorm(centroids_norm_.data(),
+                            centroids_.data(),
+                            n_features_,
+                            n_clusters_,
+                            raft::linalg::L2Norm,
+                            true,
+                            stream);
+      workspace_.resize(sizeof(int) * max_batch_size_, stream);
+    } else {
+      dist_buf_.resize(detail::getDataBatchSize(params_.batch_samples, max_batch_size_) *
+                         detail::getCentroidsBatchSize(params_.batch_centroids, n_clusters_),
+                       stream);
+    }
+  }
+
+  /**
+   * @brief Assign the samples of the batch to their nearest centroid.
+   *
+   * @param[in]  handle The raft handle.
+   * @param[in]  X      The samples, at most `max_batch_size` of them.
+   *                    [dim = n_samples x n_features]
+   * @param[out] labels Index of the nearest centroid of each sample. [len = n_samples]
+   */
+  void predict(raft::resources const& handle,
+               raft::device_matrix_view<const DataT, IndexT> X,
+               raft::device_vector_view<IndexT, IndexT> labels)
+  {
+    RAFT_EXPECTS(X.extent(1) == n_features_,
+                 "invalid parameter (X.extent(1) != n_features of the centroids)");
+    RAFT_EXPECTS(X.extent(0) <= max_batch_size_, "invalid parameter (n_samples > max_batch_size)");
+    RAFT_EXPECTS(labels.extent(0) == X.extent(0),
+                 "invalid parameter (labels.extent(0) != n_samples)");
+    if (X.extent(0) == 0) { return; }
+    if (!use_cuda_graph_) {
+      assign(handle, X, labels);
+      return;
+    }
+
+    auto stream = resource::get_cuda_stream(handle);
+    if (!graph_ || graph_x_ != X.data_handle() || graph_labels_ != labels.data_handle() ||
+        graph_n_samples_ != X.extent(0)) {
+      capture(handle, X, labels);
+    }
+    RAFT_CUDA_TRY(cudaGraphLaunch(graph_.get(), stream));
+  }
+
+  /** The copy of the centroids. [dim = n_clusters x n_features] */
+  [[nodiscard]] auto centroids() const -> raft::device_matrix_view<const DataT, IndexT>
+  {
+    return raft::make_device_matrix_view<const DataT, IndexT>(
+      centroids_.data(), n_clusters_, n_features_);
+  }
+  [[nodiscard]] auto n_clusters() const -> IndexT { return n_clusters_; }
+  [[nodiscard]] auto n_features() const -> IndexT { return n_features_; }
+  [[nodiscard]] auto max_batch_size() const -> IndexT { return max_batch_size_; }
+
+ private:
+  struct graph_exec_deleter {
+    void operator()(cudaGraphExec_t exec) const { cudaGraphExecDestroy(exec); }
+  };
+
+  using kvp_t = raft::KeyValuePair<IndexT, DataT>;
+
+  KMeansParams params_;
+  IndexT n_clusters_;
+  IndexT n_features_;
+  IndexT max_batch_size_;
+  bool use_cuda_graph_;
+  rmm::device_uvector<DataT> centroids_;
+  rmm::device_uvector<DataT> centroids_norm_;
+  rmm::device_uvector<DataT> x_norm_;
+  rmm::device_uvector<kvp_t> min_cluster_and_distance_;
+  rmm::device_uvector<DataT> dist_buf_;
+  rmm::device_uvector<char> workspace_;
+
+  std::unique_ptr<std::remove_pointer_t<cudaGraphExec_t>, graph_exec_deleter> graph_;
+  const DataT* graph_x_   = nullptr;
+  IndexT* graph_labels_   = nullptr;
+  IndexT graph_n_samples_ = 0;
+
+  [[nodiscard]] auto is_fused() const -> bool
+  {
+    return params_.metric == raft::distance::DistanceType::L2Expanded ||
+           params_.metric == raft::distance::DistanceType::L2SqrtExpanded;
+  }
+
+  void assign(raft::resources const& handle,
+              raft::device_matrix_view<const DataT, IndexT> X,
+              raft::device_vector_view<IndexT, IndexT> labels)
+  {
+    auto stream    = resource::get_cuda_stream(handle);
+    auto n_samples = X.extent(0);
+    auto min_cluster_and_distance =
+      raft::make_device_vector_view<kvp_t, IndexT>(min_cluster_and_distance_.data(), n_samples);
+
+    if (is_fused()) {
+      raft::linalg::rowNorm(x_norm_.data(),
+                            X.data_handle(),
+                            n_features_,
+                            n_samples,
+                            raft::linalg::L2Norm,
+                            true,
+                            stream);
+      raft::distance::fusedL2NNMinReduce<DataT, kvp_t, IndexT>(
+        min_cluster_and_distance.data_handle(),
+        X.data_handle(),
+        centroids_.data(),
+        x_norm_.data(),
+        centroids_norm_.data(),
+        n_samples,
+        n_clusters_,
+        n_features_,
+        static_cast<void*>(workspace_.data()),
+        params_.metric != raft::distance::DistanceType::L2Expanded,
+        true,
+        stream);
+    } else {
+      detail::minClusterAndDistanceCompute<DataT, IndexT>(
+        handle,
+        X,
+        centroids(),
+        min_cluster_and_distance,
+        raft::make_device_vector_view<const DataT, IndexT>(x_norm_.data(), n_samples),
+        dist_buf_,
+        params_.metric,
+        params_.batch_samples,
+        params_.batch_centroids,
+        workspace_);
+    }
+    raft::linalg::map(
+      handle, labels, raft::key_op{}, raft::make_const_mdspan(min_cluster_and_distance));
+  }
+
+  void capture(raft::resources const& handle,
+               raft::device_matrix_view<const DataT, IndexT> X,
+               raft::device_vector_view<IndexT, IndexT> labels)
+  {
+    auto stream = resource::get_cuda_stream(handle);
+    graph_.reset();
+
+    cudaGraph_t graph;
+    RAFT_CUDA_TRY(cudaStreamBeginCapture(stream, cudaStreamCaptureModeThreadLocal));
+    try {
+      assign(handle, X, labels);
+    } catch (...) {
+      // leave the stream usable for the caller
+      if (cudaStreamEndCapture(stream, &graph) == cudaSuccess) { cudaGraphDestroy(graph); }
+      throw;
+    }
+    RAFT_CUDA_TRY(cudaStreamEndCapture(stream, &graph));
+    cudaGraphExec_t exec;
+    auto status = cudaGraphInstantiateWithFlags(&exec, graph, 0);
+    RAFT_CUDA_TRY(cudaGraphDestroy(graph));
+    RAFT_CUDA_TRY(status);
+    graph_.reset(exec);
+
+    graph_x_         = X.data_handle();
+    graph_labels_    = labels.data_handle();
+    graph_n_samples_ = X.extent(0);
+  }
+};
+
+/** @} */  // end group kmeans_predictor
+
+}  // namespace raft::cluster::kmeans
@@ -18,6 +18,8 @@
 #include <raft/distance/distance_types.hpp>
 #include <raft/random/rng_state.hpp>
 
+#include <cstdint>
+
 namespace raft::cluster {
 
 /** Base structure for parameters that are common to all k-means algorithms */
@@ -99,6 +101,14 @@ struct KMeansParams : kmeans_base_params {
    */
   double oversampling_factor = 2.0;
 
+  /**
+   * Number of centroids the k-means++ initialization picks per round when `oversampling_factor`
+   * is zero. The default picks one centroid at a time (the sequential greedy k-means++); larger
+   * values draw and evaluate the candidates for this many centroids together, which divides the
+   * number of passes over the data. Useful for a large number of clusters.
+   */
+  int init_batch_size = 1;
+
   // batch_samples and batch_centroids are used to tile 1NN computation which is
   // useful to optimize/control the memory footprint
   // Default tile is [batch_samples x n_clusters] i.e. when batch_centroids is 0
@@ -111,12 +121,40 @@ struct KMeansParams : kmeans_base_params {
   int batch_centroids = 0;  //
 
   bool inertia_check = false;
+
+  /**
+   * Skip the distance computations of the samples that provably keep their cluster between two
+   * iterations, using the triangle-inequality bounds of "Making k-means even faster", 2010,
+   * G. Hamerly. This keeps two bounds per sample and pays off when most of the samples keep their
+   * cluster, i.e. after the first few iterations. Only the L2 metrics are supported, and not
+   * together with `inertia_check`. Used by `fit` only.
+   */
+  bool bound_pruning = false;
+};
+
+/**
+ * Parameters of the mini-batch k-means (see raft::cluster::kmeans::fit_minibatch).
+ *
+ * The centroids are updated after every mini-batch, with the per-center learning rates of
+ * "Web-Scale K-Means Clustering", 2010, D. Sculley. `max_iter` is the maximum number of passes over
+ * the data, `tol` the squared distance the centroids may move during a pass to declare convergence.
+ * The other parameters are the ones of KMeansParams; the initialization uses a single mini-batch.
+ */
+struct KMeansMiniBatchParams : KMeansParams {
+  KMeansMiniBatchParams() { max_iter = 10; }
+
+  /**
+   * The number of samples of every mini-batch, which is also the number of samples resident in the
+   * device memory at a time (twice, to overlap the copies with the computation).
+   */
+  int64_t minibatch_size = 1 << 16;
 };
 
 }  // namespace raft::cluster::kmeans
 
 namespace raft::cluster {
 
+using kmeans::KMeansMiniBatchParams;
 using kmeans::KMeansParams;
 
 }  // namespace raft::cluster
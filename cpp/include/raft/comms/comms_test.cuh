@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/comms/detail/test.cuh>
+
+#include <raft/core/resources.hpp>
+
+namespace raft {
+namespace comms {
+
+/*
+ * The definitions of the checks declared at the end of raft/comms/comms_test.hpp, which run device
+ * code. This header is meant for the one CUDA translation unit of the program which provides them.
+ */
+
+/**
+ * A check of the hierarchical allreduce, allgather and allgather_topk against their expected
+ * results
+ *
+ * @param h the raft handle to use. This is expected to already have an
+ *        initialized comms instance.
+ * @param ranks_per_node if positive, the ranks are grouped in nodes of that many consecutive ranks
+ *        instead of by their host names
+ */
+bool test_hierarchical_comms(raft::resources const& h, int ranks_per_node)
+{
+  return detail::test_hierarchical_comms(h, ranks_per_node);
+}
+
+/**
+ * A check of topk_allreduce against select_k over the gathered lists of all the ranks
+ *
+ * @param h the raft handle to use. This is expected to already have an
+ *        initialized comms instance.
+ * @param n_ranks if positive and less than the number of ranks, the check runs on a communicator
+ *        split from the n_ranks first ranks
+ * @param ties whether the candidates share their distances
+ */
+bool test_topk_allreduce(raft::resources const& h, int n_ranks, bool ties)
+{
+  return detail::test_topk_allreduce(h, n_ranks, ties);
+}
+
+}  // namespace comms
+};  // namespace raft
@@ -120,6 +120,18 @@ bool test_pointToPoint_simple_send_recv(raft::resources const& h, int numTrials)
   return detail::test_pointToPoint_simple_send_recv(h, numTrials);
 }
 
+/**
+ * A sanity check of the stream-ordered isend/irecv/waitall between all ranks
+ *
+ * @param[in] h the raft handle to use. This is expected to already have an
+ *        initialized comms instance.
+ * @param[in] numTrials number of iterations of all-to-all messaging to perform
+ */
+bool test_pointToPoint_stream_send_recv(raft::resources const& h, int numTrials)
+{
+  return detail::test_pointToPoint_stream_send_recv(h, numTrials);
+}
+
 /**
  * A simple sanity check that device is able to send OR receive.
  *
@@ -167,5 +179,32 @@ bool test_commsplit(raft::resources const& h, int n_colors)
 {
   return detail::test_commsplit(h, n_colors);
 }
+
+/*
+ * The checks below run device code: they are defined in raft/comms/comms_test.cuh, which one CUDA
+ * translation unit of the program must include.
+ */
+
+/**
+ * A check of the hierarchical allreduce, allgather and allgather_topk against their expected
+ * results
+ *
+ * @param h the raft handle to use. This is expected to already have an
+ *        initialized comms instance.
+ * @param ranks_per_node if positive, the ranks are grouped in nodes of that many consecutive ranks
+ *        instead of by their host names
+ */
+bool test_hierarchical_comms(raft::resources const& h, int ranks_per_node);
+
+/**
+ * A check of topk_allreduce against select_k over the gathered lists of all the ranks
+ *
+ * @param h the raft handle to use. This is expected to already have an
+ *        initialized comms instance.
+ * @param n_ranks if positive and less than the number of ranks, the check runs on a communicator
+ *        split from the n_ranks first ranks
+ * @param ties whether the candidates share their distances
+ */
+bool test_topk_allreduce(raft::resources const& h, int n_ranks, bool ties);
 }  // namespace comms
 };  // namespace raft
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/comms/detail/compressed_comms.cuh>
+#include <raft/core/comms.hpp>
+
+#include <cuda_bf16.h>
+#include <cuda_fp16.h>
+
+#include <cstdint>
+
+namespace raft {
+namespace comms {
+
+/**
+ * @defgroup compressed_comms Collectives with compressed transfers
+ * @{
+ */
+
+/** Encoding of the float values on the wire */
+enum class compression_t {
+  /** raw fp32 */
+  NONE,
+  /** fp16: half the traffic, 11 bits of mantissa, values beyond 65504 overflow */
+  FP16,
+  /** bf16: half the traffic, 8 bits of mantissa, the fp32 range */
+  BF16
+};
+
+/**
+ * @brief Broadcast float values (e.g. centroids) encoded on 16 bits on the wire.
+ *
+ * All the ranks, the root included, end up with the values rounded to the encoding, so that
+ * they all hold the same values.
+ *
+ * @param[in] comm the communicator; the call is collective
+ * @param[inout] buff the values to send on the root, the received values on the other ranks
+ * @param[in] count number of values
+ * @param[in] root the rank sending the values
+ * @param[in] compression encoding of the values on the wire
+ * @param[in] stream cuda stream
+ */
+inline void bcast(const comms_t& comm,
+                  float* buff,
+                  size_t count,
+                  int root,
+                  compression_t compression,
+                  cudaStream_t stream)
+{
+  switch (compression) {
+    case compression_t::FP16: detail::bcast_narrow<half>(comm, buff, count, root, stream); break;
+    case compression_t::BF16:
+      detail::bcast_narrow<__nv_bfloat16>(comm, buff, count, root, stream);
+      break;
+    default: comm.bcast(buff, count, root, stream);
+  }
+}
+
+/**
+ * @brief Allgather float values (e.g. distances) encoded on 16 bits on the wire.
+ *
+ * @param[in] comm the communicator; the call is collective
+ * @param[in] sendbuff the local values [sendcount]
+ * @param[out] recvbuff the values of all the ranks, in rank order [size * sendcount]
+ * @param[in] sendcount number of values of every rank
+ * @param[in] compression encoding of the values on the wire
+ * @param[in] stream cuda stream
+ */
+inline void allgather(const comms_t& comm,
+                      const float* sendbuff,
+                      float* recvbuff,
+                      size_t sendcount,
+                      compression_t compression,
+                      cudaStream_t stream)
+{
+  switch (compression) {
+    case compression_t::FP16:
+      detail::allgather_narrow<half>(comm, sendbuff, recvbuff, sendcount, stream);
+      break;
+    case compression_t::BF16:
+      detail::allgather_narrow<__nv_bfloat16>(comm, sendbuff, recvbuff, sendcount, stream);
+      break;
+    default: comm.allgather(sendbuff, recvbuff, sendcount, stream);
+  }
+}
+
+/**
+ * @brief Allgatherv of float values encoded on 16 bits on the wire.
+ *
+ * @param[in] comm the communicator; the call is collective
+ * @param[in] sendbuf the local values [recvcounts[rank]]
+ * @param[out] recvbuf the values of all the ranks
+ * @param[in] recvcounts host array of the number of values of every rank
+ * @param[in] displs host array of the offsets of the values of every rank in recvbuf
+ * @param[in] compression encoding of the values on the wire
+ * @param[in] stream cuda stream
+ */
+inline void allgatherv(const comms_t& comm,
+                       const float* sendbuf,
+                       float* recvbuf,
+                       const size_t* recvcounts,
+                       const size_t* displs,
+                       compression_t compression,
+                       cudaStream_t stream)
+{
+  switch (compression) {
+    case compression_t::FP16:
+      detail::allgatherv_narrow<half>(comm, sendbuf, recvbuf, recvcounts, displs, stream);
+      break;
+    case compression_t::BF16:
+      detail::allgatherv_narrow<__nv_bfloat16>(comm, sendbuf, recvbuf, recvcounts, displs, stream);
+      break;
+    default: comm.allgatherv(sendbuf, recvbuf, recvcounts, displs, stream);
+  }
+}
+
+/**
+ * @brief Lossless allgatherv of (mostly) sorted 64-bit indices, delta-encoded on 32 bits.
+ *
+ * The indices of every rank go on the wire as their first value and the 32-bit differences of
+ * the consecutive values, which halves the traffic of sorted or clustered ids (e.g. the
+ * neighbor lists of a partition). When a difference does not fit on 32 bits on any rank, the
+ * call falls back to the plain allgatherv. It synchronizes the stream once, to agree on that.
+ *
+ * @param[in] comm the communicator; the call is collective
+ * @param[in] sendbuf the local indices [recvcounts[rank]]
+ * @param[out] recvbuf the indices of all the ranks
+ * @param[in] recvcounts host array of the number of indices of every rank
+ * @param[in] displs host array of the offsets of the indices of every rank in recvbuf
+ * @param[in] stream cuda stream
+ */
+inline void allgatherv_delta(const comms_t& comm,
+                             const int64_t* sendbuf,
+                             int64_t* recvbuf,
+                             const size_t* recvcounts,
+                             const size_t* displs,
+                             cudaStream_t stream)
+{
+  detail::allgatherv_delta(comm, sendbuf, recvbuf, recvcounts, displs, stream);
+}
+
+/** @} */  // end group compressed_comms
+
+};  // namespace comms
+};  // end namespace raft
@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/comms.hpp>
+#include <raft/core/error.hpp>
+#include <raft/linalg/unary_op.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_scalar.hpp>
+#include <rmm/device_uvector.hpp>
+#include <rmm/exec_policy.hpp>
+
+#include <thrust/functional.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/scan.h>
+#include <thrust/transform.h>
+#include <thrust/transform_reduce.h>
+
+#include <cuda_bf16.h>
+#include <cuda_fp16.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace raft {
+namespace comms {
+namespace detail {
+
+template <typename NarrowT>
+struct narrow_encode_op {
+  __device__ NarrowT operator()(float x) const { return NarrowT(x); }
+};
+
+template <typename NarrowT>
+struct narrow_decode_op {
+  __device__ float operator()(NarrowT x) const { return float(x); }
+};
+
+/** The narrow buffers go over the wire as bytes, whatever the types the communicator knows. */
+template <typename NarrowT>
+uint8_t* as_bytes(NarrowT* ptr)
+{
+  return reinterpret_cast<uint8_t*>(ptr);
+}
+
+template <typename NarrowT>
+void bcast_narrow(const comms_t& comm, float* buff, size_t count, int root, cudaStream_t stream)
+{
+  rmm::device_uvector<NarrowT> narrow(count, stream);
+  if (comm.get_rank() == root) {
+    raft::linalg::unaryOp(narrow.data(), buff, count, narrow_encode_op<NarrowT>{}, stream);
+  }
+  comm.bcast(as_bytes(narrow.data()), count * sizeof(NarrowT), root, stream);
+  // the root decodes its own values too, so that all the ranks hold the same values
+  raft::linalg::unaryOp(buff, narrow.data(), count, narrow_decode_op<NarrowT>{}, stream);
+}
+
+template <typename NarrowT>
+void allgather_narrow(const comms_t& comm,
+                      const float* sendbuff,
+                      float* recvbuff,
+                      size_t sendcount,
+                      cudaStream_t stream)
+{
+  size_t total = sendcount * comm.get_size();
+  rmm::device_uvector<NarrowT> narrow_send(sendcount, stream);
+  rmm::device_uvector<NarrowT> narrow_recv(total, stream);
+  raft::linalg::unaryOp(
+    narrow_send.data(), sendbuff, sendcount, narrow_encode_op<NarrowT>{}, stream);
+  comm.allgather(as_bytes(narrow_send.data()),
+                 as_bytes(narrow_recv.data()),
+                 sendcount * sizeof(NarrowT),
+                 stream);
+  raft::linalg::unaryOp(recvbuff, narrow_recv.data(), total, narrow_decode_op<NarrowT>{}, stream);
+}
+
+template <typename NarrowT>
+void allgatherv_narrow(const comms_t& comm,
+                       const float* sendbuf,
+                       float* recvbuf,
+                       const size_t* recvcounts,
+                       const size_t* displs,
+                       cudaStream_t stream)
+{
+  int size = comm.get_size();
+  std::vector<size_t> byte_counts(size), byte_displs(size);
+  size_t total = 0;
+  for (int r = 0; r < size; r++) {
+    byte_counts[r] = recvcounts[r] * sizeof(NarrowT);
+    byte_displs[r] = displs[r] * sizeof(NarrowT);
+    total          = std::max(total, displs[r] + recvcounts[r]);
+  }
+  size_t sendcount = recvcounts[comm.get_rank()];
+  rmm::device_uvector<NarrowT> narrow_send(sendcount, stream);
+  rmm::device_uvector<NarrowT> narrow_recv(total, stream);
+  raft::linalg::unaryOp(
+    narrow_send.data(), sendbuf, sendcount, narrow_encode_op<NarrowT>{}, stream);
+  comm.allgatherv(as_bytes(narrow_send.data()),
+                  as_bytes(narrow_recv.data()),
+                  byte_counts.data(),
+                  byte_displs.data(),
+                  stream);
+  for (int r = 0; r < size; r++) {
+    raft::linalg::unaryOp(recvbuf + displs[r],
+                          narrow_recv.data() + displs[r],
+                          recvcounts[r],
+                          narrow_decode_op<NarrowT>{},
+                          stream);
+  }
+}
+
+struct delta_overflow_op {
+  const int64_t* x;
+
+  __device__ int operator()(size_t i) const
+  {
+    int64_t d = i == 0 ? 0 : x[i] - x[i - 1];
+    return d < std::numeric_limits<int32_t>::min() || d > std::numeric_limits<int32_t>::max();
+  }
+};
+
+struct delta_encode_op {
+  const int64_t* x;
+
+  __device__ int32_t operator()(size_t i) const
+  {
+    return i == 0 ? 0 : static_cast<int32_t>(x[i] - x[i - 1]);
+  }
+};
+
+struct delta_widen_op {
+  __device__ int64_t operator()(int32_t d) const { return d; }
+};
+
+struct delta_add_base_op {
+  const int64_t* base;
+
+  __device__ int64_t operator()(int64_t x) const { return x + *base; }
+};
+
+/**
+ * Every rank sends the first of its indices in full and the differences between the consecutive
+ * ones on 32 bits; the receivers rebuild the segments with a scan. When a difference does not
+ * fit on any rank, all the ranks fall back to the plain allgatherv.
+ */
+inline void allgatherv_delta(const comms_t& comm,
+                             const int64_t* sendbuf,
+                             int64_t* recvbuf,
+                             const size_t* recvcounts,
+                             const size_t* displs,
+                             cudaStream_t stream)
+{
+  int size     = comm.get_size();
+  size_t count = recvcounts[comm.get_rank()];
+  auto first   = thrust::make_counting_iterator<size_t>(0);
+  int overflow = thrust::transform_reduce(rmm::exec_policy(stream),
+                                          first,
+                                          first + count,
+                                          delta_overflow_op{sendbuf},
+                                          0,
+                                          thrust::maximum<int>());
+  rmm::device_scalar<int> any_overflow(overflow, stream);
+  comm.allreduce(any_overflow.data(), any_overflow.data(), 1, op_t::MAX, stream);
+  if (any_overflow.value(stream) != 0) {
+    comm.allgatherv(sendbuf, recvbuf, recvcounts, displs, stream);
+    return;
+  }
+
+  size_t total = 0;
+  for (int r = 0; r < size; r++) {
+    total = std::max(total, displs[r] + recvcounts[r]);
+  }
+  rmm::device_uvector<int64_t> bases(size, stream);
+  rmm::device_uvector<int32_t> deltas(count, stream);
+  rmm::device_uvector<int32_t> all_deltas(total, stream);
+  RAFT_CUDA_TRY(cudaMemsetAsync(bases.data(), 0, size * sizeof(int64_t), stream));
+  if (count > 0) { raft::copy(bases.data() + comm.get_rank(), sendbuf, 1, stream); }
+  thrust::transform(
+    rmm::exec_policy(stream), first, first + count, deltas.data(), delta_encode_op{sendbuf});
+  comm.allgather(bases.data() + comm.get_rank(), bases.data(), 1, stream);
+  comm.allgatherv(deltas.data(), all_deltas.data(), recvcounts, displs, stream);
+
+  for (int r = 0; r < size; r++) {
+    if (recvcounts[r] == 0) { continue; }
+    auto* segment = all_deltas.data() + displs[r];
+    thrust::transform_inclusive_scan(rmm::exec_policy(stream),
+                                     segment,
+                                     segment + recvcounts[r],
+                                     recvbuf + displs[r],
+                                     delta_widen_op{},
+                                     thrust::plus<int64_t>());
+    thrust::transform(rmm::exec_policy(stream),
+                      recvbuf + displs[r],
+                      recvbuf + displs[r] + recvcounts[r],
+                      recvbuf + displs[r],
+                      delta_add_base_op{bases.data() + r});
+  }
+}
+
+}  // namespace detail
+}  // namespace comms
+}  // namespace raft
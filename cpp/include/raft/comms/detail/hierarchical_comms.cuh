@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/comms/detail/topk_allreduce.cuh>
+#include <raft/core/comms.hpp>
+#include <raft/core/error.hpp>
+#include <raft/neighbors/detail/knn_merge_parts.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace raft {
+namespace comms {
+namespace detail {
+
+/**
+ * A communicator split by the nodes of the cluster: `intra` holds the ranks of the node and
+ * `inter` holds the ranks of the same local rank on every node (a "rail"). See
+ * raft::comms::hierarchical_comms for docs.
+ */
+class hierarchical_comms {
+ public:
+  static constexpr size_t kMaxHostName = 256;
+
+  hierarchical_comms(const comms_t& comm, cudaStream_t stream)
+    : hierarchical_comms(comm, stream, get_host_name())
+  {
+  }
+
+  hierarchical_comms(const comms_t& comm, cudaStream_t stream, const std::string& node_name)
+    : comm_(comm)
+  {
+    int size = comm.get_size();
+    int rank = comm.get_rank();
+
+    // the nodes are told apart by their names
+    RAFT_EXPECTS(node_name.size() < kMaxHostName, "The node name is too long");
+    std::vector<char> host(kMaxHostName, 0);
+    std::copy(node_name.begin(), node_name.end(), host.begin());
+    rmm::device_uvector<char> hosts_d(size * kMaxHostName, stream);
+    raft::update_device(hosts_d.data() + rank * kMaxHostName, host.data(), kMaxHostName, stream);
+    comm.allgather(hosts_d.data() + rank * kMaxHostName, hosts_d.data(), kMaxHostName, stream);
+    std::vector<char> hosts(size * kMaxHostName);
+    raft::update_host(hosts.data(), hosts_d.data(), hosts.size(), stream);
+    RAFT_EXPECTS(comm.sync_stream(stream) == status_t::SUCCESS, "allgather of host names failed");
+
+    // first rank of the node of every rank
+    std::vector<int> node_first(size);
+    for (int r = 0; r < size; r++) {
+      node_first[r] = r;
+      for (int q = 0; q < r; q++) {
+        if (std::strncmp(&hosts[r * kMaxHostName], &hosts[q * kMaxHostName], kMaxHostName) == 0) {
+          node_first[r] = q;
+          break;
+        }
+      }
+    }
+
+    // the stages are only exchanged in rank order when every node holds the same number of
+    // consecutive ranks, which is how the launchers place them
+    local_size_ = int(std::count(node_first.begin(), node_first.end(), 0));
+    uniform_    = size % local_size_ == 0;
+    for (int r = 0; uniform_ && r < size; r++) {
+      uniform_ = node_first[r] == (r / local_size_) * local_size_;
+    }
+    hierarchical_ = uniform_ && local_size_ > 1 && local_size_ < size;
+    if (!uniform_) { local_size_ = 1; }
+    local_rank_ = rank % local_size_;
+    node_rank_  = rank / local_size_;
+    n_nodes_    = size / local_size_;
+
+    if (hierarchical_) {
+      intra_ = std::make_shared<comms_t>(comm.comm_split(node_rank_, local_rank_));
+      inter_ = std::make_shared<comms_t>(comm.comm_split(local_rank_, node_rank_));
+    }
+  }
+
+  const comms_t& comm() const { return comm_; }
+  const comms_t& intra() const
+  {
+    RAFT_EXPECTS(hierarchical_, "The communicator is not split by nodes");
+    return *intra_;
+  }
+  const comms_t& inter() const
+  {
+    RAFT_EXPECTS(hierarchical_, "The communicator is not split by nodes");
+    return *inter_;
+  }
+
+  bool is_hierarchical() const { return hierarchical_; }
+  int get_n_nodes() const { return n_nodes_; }
+  int get_node_rank() const { return node_rank_; }
+  int get_local_size() const { return local_size_; }
+  int get_local_rank() const { return local_rank_; }
+
+  template <typename value_t>
+  void allreduce(
+    const value_t* sendbuff, value_t* recvbuff, size_t count, op_t op, cudaStream_t stream) const
+  {
+    if (!hierarchical_) { return comm_.allreduce(sendbuff, recvbuff, count, op, stream); }
+    if (count % local_size_ == 0) {
+      // every rank of the node reduces a share of the buffer over its rail
+      size_t share = count / local_size_;
+      value_t* own = recvbuff + local_rank_ * share;
+      intra_->reducescatter(sendbuff, own, share, op, stream);
+      inter_->allreduce(own, own, share, op, stream);
+      intra_->allgather(own, recvbuff, share, stream);
+    } else {
+      intra_->reduce(sendbuff, recvbuff, count, op, 0, stream);
+      if (local_rank_ == 0) { inter_->allreduce(recvbuff, recvbuff, count, op, stream); }
+      intra_->bcast(recvbuff, count, 0, stream);
+    }
+  }
+
+  template <typename value_t>
+  void allgather(const value_t* sendbuff,
+                 value_t* recvbuff,
+                 size_t sendcount,
+                 cudaStream_t stream) const
+  {
+    if (!hierarchical_) { return comm_.allgather(sendbuff, recvbuff, sendcount, stream); }
+    // every rank sends its own buffer once over its rail, then the rails are exchanged in the
+    // node and put back in rank order: [local][node] -> [node][local]
+    rmm::device_uvector<value_t> rail(n_nodes_ * sendcount, stream);
+    rmm::device_uvector<value_t> rails(size_t(local_size_) * n_nodes_ * sendcount, stream);
+    inter_->allgather(sendbuff, rail.data(), sendcount, stream);
+    intra_->allgather(rail.data(), rails.data(), n_nodes_ * sendcount, stream);
+    for (int l = 0; l < local_size_; l++) {
+      RAFT_CUDA_TRY(cudaMemcpy2DAsync(recvbuff + l * sendcount,
+                                      local_size_ * sendcount * sizeof(value_t),
+                                      rails.data() + l * n_nodes_ * sendcount,
+                                      sendcount * sizeof(value_t),
+                                      sendcount * sizeof(value_t),
+                                      n_nodes_,
+                                      cudaMemcpyDeviceToDevice,
+                                      stream));
+    }
+  }
+
+  template <typename value_t, typename value_idx>
+  void allgather_topk(const value_t* distances,
+                      const value_idx* indices,
+                      size_t n_queries,
+                      int k,
+                      value_t* out_distances,
+                      value_idx* out_indices,
+                      cudaStream_t stream) const
+  {
+    RAFT_EXPECTS(k > 0 && k <= 1024, "k should be in [1, 1024]");
+    size_t part = n_queries * k;
+    if (!hierarchical_) {
+      topk_allreduce(comm_, distances, indices, n_queries, k, out_distances, out_indices, stream);
+      return;
+    }
+    // merge the parts of the node first, so that only k neighbors per query and per node cross
+    // the nodes, over the rail of the first ranks of the nodes
+    merge_gathered(
+      *intra_, distances, indices, part, n_queries, k, out_distances, out_indices, stream);
+    if (local_rank_ == 0) {
+      topk_allreduce(
+        *inter_, out_distances, out_indices, n_queries, k, out_distances, out_indices, stream);
+    }
+    intra_->bcast(out_distances, part, 0, stream);
+    intra_->bcast(out_indices, part, 0, stream);
+  }
+
+ private:
+  static std::string get_host_name()
+  {
+    std::vector<char> host(kMaxHostName, 0);
+    RAFT_EXPECTS(gethostname(host.data(), kMaxHostName - 1) == 0, "gethostname failed");
+    return std::string(host.data());
+  }
+
+  template <typename value_t, typename value_idx>
+  static void merge_gathered(const comms_t& comm,
+                             const value_t* distances,
+                             const value_idx* indices,
+                             size_t part,
+                             size_t n_queries,
+                             int k,
+                             value_t* out_distances,
+                             value_idx* out_indices,
+                             cudaStream_t stream)
+  {
+    int n_parts = comm.get_size();
+    rmm::device_uvector<value_t> all_distances(n_parts * part, stream);
+    rmm::device_uvector<value_idx> all_indices(n_parts * part, stream);
+    rmm::device_uvector<value_idx> translations(n_parts, stream);
+    RAFT_CUDA_TRY(cudaMemsetAsync(translations.data(), 0, n_parts * sizeof(value_idx), stream));
+    comm.allgather(distances, all_distances.data(), part, stream);
+    comm.allgather(indices, all_indices.data(), part, stream);
+    raft::neighbors::detail::knn_merge_parts(all_distances.data(),
+                                             all_indices.data(),
+                                             out_distances,
+                                             out_indices,
+                                             n_queries,
+                                             n_parts,
+                                             k,
+                                             stream,
+                                             translations.data());
+  }
+
+  const comms_t& comm_;
+  std::shared_ptr<comms_t> intra_;
+  std::shared_ptr<comms_t> inter_;
+  bool uniform_;
+  bool hierarchical_;
+  int n_nodes_;
+  int node_rank_;
+  int local_size_;
+  int local_rank_;
+};
+
+}  // namespace detail
+}  // namespace comms
+}  // namespace raft
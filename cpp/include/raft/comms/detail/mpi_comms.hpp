@@ -19,12 +19,14 @@
 #include <cstdio>
 #include <memory>
 
-#include <unordered_map>
-#include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include <mpi.h>
 #include <nccl.h>
+#if __has_include(<mpi-ext.h>)
+#include <mpi-ext.h>
+#endif
 
 #include <raft/comms/comms.hpp>
 #include <raft/comms/detail/util.hpp>
@@ -104,6 +106,16 @@ constexpr MPI_Op get_mpi_op(const op_t op)
   }
 }
 
+/** Whether the MPI library is CUDA-aware, when it can tell (e.g. Open MPI and MVAPICH2) */
+inline bool query_cuda_aware()
+{
+#if defined(MPIX_CUDA_AWARE_SUPPORT) && MPIX_CUDA_AWARE_SUPPORT
+  return MPIX_Query_cuda_support() == 1;
+#else
+  return false;
+#endif
+}
+
 class mpi_comms : public comms_iface {
  public:
   mpi_comms(MPI_Comm comm, const bool owns_mpi_comm, rmm::cuda_stream_view stream)
@@ -112,8 +124,8 @@ class mpi_comms : public comms_iface {
       size_(0),
       rank_(1),
       status_(stream),
-      next_request_id_(0),
-      stream_(stream)
+      stream_(stream),
+      cuda_aware_(query_cuda_aware())
   {
     int mpi_is_initialized = 0;
     RAFT_MPI_TRY(MPI_Initialized(&mpi_is_initialized));
@@ -163,53 +175,124 @@ class mpi_comms : public comms_iface {
            "ERROR: syncStream failed. This can be caused by a failed rank_.");
   }
 
+  /**
+   * Whether the MPI library can read and write device buffers. Then `isend`/`irecv`, the
+   * persistent requests and `iallreduce` take device pointers directly, without staging
+   * through the host.
+   */
+  bool is_cuda_aware() const { return cuda_aware_; }
+
   void isend(const void* buf, size_t size, int dest, int tag, request_t* request) const
   {
-    MPI_Request mpi_req;
-    request_t req_id;
-    if (free_requests_.empty()) {
-      req_id = next_request_id_++;
-    } else {
-      auto it = free_requests_.begin();
-      req_id  = *it;
-      free_requests_.erase(it);
-    }
-    RAFT_MPI_TRY(MPI_Isend(buf, size, MPI_BYTE, dest, tag, mpi_comm_, &mpi_req));
-    requests_in_flight_.insert(std::make_pair(req_id, mpi_req));
-    *request = req_id;
+    MPI_Request* mpi_req = get_request(request);
+    RAFT_MPI_TRY(MPI_Isend(buf, size, MPI_BYTE, dest, tag, mpi_comm_, mpi_req));
   }
 
   void irecv(void* buf, size_t size, int source, int tag, request_t* request) const
   {
-    MPI_Request mpi_req;
-    request_t req_id;
-    if (free_requests_.empty()) {
-      req_id = next_request_id_++;
-    } else {
-      auto it = free_requests_.begin();
-      req_id  = *it;
-      free_requests_.erase(it);
+    MPI_Request* mpi_req = get_request(request);
+    RAFT_MPI_TRY(MPI_Irecv(buf, size, MPI_BYTE, source, tag, mpi_comm_, mpi_req));
+  }
+
+  void waitall(int count, request_t array_of_requests[]) const
+  {
+    std::vector<MPI_Request> requests;
+    requests.reserve(count);
+    for (int i = 0; i < count; ++i) {
+      auto& slot = get_slot(array_of_requests[i]);
+      RAFT_EXPECTS(slot.in_flight, "ERROR: waitall on invalid request: %d", array_of_requests[i]);
+      requests.push_back(slot.req);
     }
+    RAFT_MPI_TRY(MPI_Waitall(requests.size(), requests.data(), MPI_STATUSES_IGNORE));
+    for (int i = 0; i < count; ++i) {
+      auto& slot = request_pool_[array_of_requests[i]];
+      // a completed persistent request stays allocated, inactive until started again
+      slot.in_flight = false;
+      if (slot.persistent) {
+        slot.req = requests[i];
+      } else {
+        free_requests_.push_back(array_of_requests[i]);
+      }
+    }
+  }
 
-    RAFT_MPI_TRY(MPI_Irecv(buf, size, MPI_BYTE, source, tag, mpi_comm_, &mpi_req));
-    requests_in_flight_.insert(std::make_pair(req_id, mpi_req));
-    *request = req_id;
+  /**
+   * @brief Create a persistent send request, for a message repeated at every iteration of an
+   * algorithm: the request is set up once, then started with `start` and completed with
+   * `waitall` at every iteration, until freed with `request_free`.
+   */
+  void send_init(const void* buf, size_t size, int dest, int tag, request_t* request) const
+  {
+    MPI_Request* mpi_req = get_request(request, true);
+    RAFT_MPI_TRY(MPI_Send_init(buf, size, MPI_BYTE, dest, tag, mpi_comm_, mpi_req));
   }
 
-  void waitall(int count, request_t array_of_requests[]) const
+  /** @brief Create a persistent receive request; see `send_init`. */
+  void recv_init(void* buf, size_t size, int source, int tag, request_t* request) const
+  {
+    MPI_Request* mpi_req = get_request(request, true);
+    RAFT_MPI_TRY(MPI_Recv_init(buf, size, MPI_BYTE, source, tag, mpi_comm_, mpi_req));
+  }
+
+  /** @brief Start persistent requests, which are then completed by `waitall`. */
+  void start(int count, request_t array_of_requests[]) const
   {
     std::vector<MPI_Request> requests;
     requests.reserve(count);
     for (int i = 0; i < count; ++i) {
-      auto req_it = requests_in_flight_.find(array_of_requests[i]);
-      RAFT_EXPECTS(requests_in_flight_.end() != req_it,
-                   "ERROR: waitall on invalid request: %d",
+      auto& slot = get_slot(array_of_requests[i]);
+      RAFT_EXPECTS(slot.persistent && !slot.in_flight,
+                   "ERROR: start on a request which is not an inactive persistent request: %d",
                    array_of_requests[i]);
-      requests.push_back(req_it->second);
-      free_requests_.insert(req_it->first);
-      requests_in_flight_.erase(req_it);
+      requests.push_back(slot.req);
     }
-    RAFT_MPI_TRY(MPI_Waitall(requests.size(), requests.data(), MPI_STATUSES_IGNORE));
+    RAFT_MPI_TRY(MPI_Startall(requests.size(), requests.data()));
+    for (int i = 0; i < count; ++i) {
+      auto& slot     = request_pool_[array_of_requests[i]];
+      slot.req       = requests[i];
+      slot.in_flight = true;
+    }
+  }
+
+  /** @brief Free inactive persistent requests. */
+  void request_free(int count, request_t array_of_requests[]) const
+  {
+    for (int i = 0; i < count; ++i) {
+      auto& slot = get_slot(array_of_requests[i]);
+      RAFT_EXPECTS(slot.persistent && !slot.in_flight,
+                   "ERROR: request_free on an active or non-persistent request: %d",
+                   array_of_requests[i]);
+      RAFT_MPI_TRY(MPI_Request_free(&slot.req));
+      slot.persistent = false;
+      free_requests_.push_back(array_of_requests[i]);
+    }
+  }
+
+  /**
+   * @brief Non-blocking allreduce through MPI, completed with `waitall`.
+   *
+   * Unlike `allreduce`, which is enqueued by NCCL on the stream, the reduction progresses
+   * outside of the stream and the calling thread overlaps it with other work until `waitall`.
+   * The work enqueued on the stream before is waited for first, so that the buffers are ready.
+   * Device buffers require a CUDA-aware MPI.
+   */
+  void iallreduce(const void* sendbuff,
+                  void* recvbuff,
+                  size_t count,
+                  datatype_t datatype,
+                  op_t op,
+                  request_t* request,
+                  cudaStream_t stream) const
+  {
+    RAFT_CUDA_TRY(cudaStreamSynchronize(stream));
+    MPI_Request* mpi_req = get_request(request);
+    RAFT_MPI_TRY(MPI_Iallreduce(sendbuff == recvbuff ? MPI_IN_PLACE : sendbuff,
+                                recvbuff,
+                                count,
+                                get_mpi_datatype(datatype),
+                                get_mpi_op(op),
+                                mpi_comm_,
+                                mpi_req));
   }
 
   void allreduce(const void* sendbuff,
@@ -434,9 +517,44 @@ class mpi_comms : public comms_iface {
   ncclComm_t nccl_comm_;
   int size_;
   int rank_;
-  mutable request_t next_request_id_;
-  mutable std::unordered_map<request_t, MPI_Request> requests_in_flight_;
-  mutable std::unordered_set<request_t> free_requests_;
+  bool cuda_aware_;
+
+  struct request_slot {
+    MPI_Request req = MPI_REQUEST_NULL;
+    bool in_flight  = false;
+    bool persistent = false;
+  };
+  mutable std::vector<request_slot> request_pool_;
+  mutable std::vector<request_t> free_requests_;
+
+  /**
+   * The requests are slots of a pool indexed by the request ids, recycled from a free list once
+   * waited for (or freed, for the persistent requests).
+   */
+  MPI_Request* get_request(request_t* request, bool persistent = false) const
+  {
+    request_t req_id;
+    if (free_requests_.empty()) {
+      req_id = request_pool_.size();
+      request_pool_.emplace_back();
+    } else {
+      req_id = free_requests_.back();
+      free_requests_.pop_back();
+    }
+    request_pool_[req_id].in_flight  = !persistent;
+    request_pool_[req_id].persistent = persistent;
+    *request                         = req_id;
+    return &request_pool_[req_id].req;
+  }
+
+  request_slot& get_slot(request_t req_id) const
+  {
+    RAFT_EXPECTS(req_id < request_pool_.size() &&
+                   (request_pool_[req_id].in_flight || request_pool_[req_id].persistent),
+                 "ERROR: invalid request: %d",
+                 req_id);
+    return request_pool_[req_id];
+  }
 };
 
 }  // end namespace detail
@@ -35,16 +35,17 @@
 
 #include <nccl.h>
 
-#include <unordered_map>
-#include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include <algorithm>
 #include <chrono>
 #include <cstdio>
 #include <exception>
 #include <memory>
+#include <mutex>
 #include <stdlib.h>
+#include <string>
 #include <thread>
 #include <time.h>
 
@@ -81,7 +82,7 @@ class std_comms : public comms_iface {
       subcomms_ucp_(subcomms_ucp),
       ucp_worker_(ucp_worker),
       ucp_eps_(eps),
-      next_request_id_(0)
+      ucp_worker_shared_(ucp_worker != nullptr && ucp_worker_allows_threads(ucp_worker))
   {
     initialize();
   };
@@ -99,7 +100,8 @@ class std_comms : public comms_iface {
       status_(stream),
       num_ranks_(num_ranks),
       rank_(rank),
-      subcomms_ucp_(false)
+      subcomms_ucp_(false),
+      ucp_worker_shared_(false)
   {
     initialize();
   };
@@ -112,7 +114,7 @@ class std_comms : public comms_iface {
 
   ~std_comms()
   {
-    requests_in_flight_.clear();
+    request_pool_.clear();
     free_requests_.clear();
   }
 
@@ -192,114 +194,122 @@ class std_comms : public comms_iface {
            "ERROR: syncStream failed. This can be caused by a failed rank_.");
   }
 
-  void get_request_id(request_t* req) const
+  /**
+   * The requests are slots of a pool which grows to the largest number of messages in flight:
+   * a request id is the index of its slot, and the ids of the completed requests are recycled
+   * from a free list, so that a message neither allocates nor hashes once the pool is warm.
+   *
+   * The pool and the free list are shared by the calling threads and the CUDA callback thread of
+   * the stream-ordered messages, so they are only accessed under `ucp_mutex_`, which the caller
+   * must hold. Since the pool may grow (and move) meanwhile, a slot is addressed by its id.
+   */
+  ucp_request* get_request(request_t* req) const
   {
     request_t req_id;
 
-    if (this->free_requests_.empty())
-      req_id = this->next_request_id_++;
-    else {
-      auto it = this->free_requests_.begin();
-      req_id  = *it;
-      this->free_requests_.erase(it);
+    if (this->free_requests_.empty()) {
+      req_id = request_pool_.size();
+      request_pool_.emplace_back();
+    } else {
+      req_id = this->free_requests_.back();
+      this->free_requests_.pop_back();
     }
-    *req = req_id;
+    request_pool_[req_id].in_flight = true;
+    *req                            = req_id;
+    return &request_pool_[req_id].req;
   }
 
   void isend(const void* buf, size_t size, int dest, int tag, request_t* request) const
   {
     ASSERT(ucp_worker_ != nullptr, "ERROR: UCX comms not initialized on communicator.");
 
-    get_request_id(request);
-    ucp_ep_h ep_ptr = (*ucp_eps_)[dest];
-
-    ucp_request* ucp_req = (ucp_request*)malloc(sizeof(ucp_request));
+    std::lock_guard<std::mutex> guard(ucp_mutex_);
+    ucp_request* ucp_req = get_request(request);
+    ucp_ep_h ep_ptr      = (*ucp_eps_)[dest];
 
     this->ucp_handler_.ucp_isend(ucp_req, ep_ptr, buf, size, tag, default_tag_mask, get_rank());
-
-    requests_in_flight_.insert(std::make_pair(*request, ucp_req));
   }
 
   void irecv(void* buf, size_t size, int source, int tag, request_t* request) const
   {
     ASSERT(ucp_worker_ != nullptr, "ERROR: UCX comms not initialized on communicator.");
 
-    get_request_id(request);
+    std::lock_guard<std::mutex> guard(ucp_mutex_);
+    ucp_request* ucp_req = get_request(request);
 
     ucp_ep_h ep_ptr = (*ucp_eps_)[source];
 
     ucp_tag_t tag_mask = default_tag_mask;
 
-    ucp_request* ucp_req = (ucp_request*)malloc(sizeof(ucp_request));
     ucp_handler_.ucp_irecv(ucp_req, ucp_worker_, ep_ptr, buf, size, tag, tag_mask, source);
-
-    requests_in_flight_.insert(std::make_pair(*request, ucp_req));
   }
 
   void waitall(int count, request_t array_of_requests[]) const
   {
     ASSERT(ucp_worker_ != nullptr, "ERROR: UCX comms not initialized on communicator.");
 
-    std::vector<ucp_request*> requests;
+    std::vector<request_t> requests;
     requests.reserve(count);
 
-    time_t start = time(NULL);
-
-    for (int i = 0; i < count; ++i) {
-      auto req_it = requests_in_flight_.find(array_of_requests[i]);
-      ASSERT(requests_in_flight_.end() != req_it,
-             "ERROR: waitall on invalid request: %d",
-             array_of_requests[i]);
-      requests.push_back(req_it->second);
-      free_requests_.insert(req_it->first);
-      requests_in_flight_.erase(req_it);
+    {
+      std::lock_guard<std::mutex> guard(ucp_mutex_);
+      for (int i = 0; i < count; ++i) {
+        request_t req_id = array_of_requests[i];
+        ASSERT(req_id < request_pool_.size() && request_pool_[req_id].in_flight,
+               "ERROR: waitall on invalid request: %d",
+               req_id);
+        requests.push_back(req_id);
+      }
     }
 
-    while (requests.size() > 0) {
-      time_t now = time(NULL);
-
-      // Timeout if we have not gotten progress or completed any requests
-      // in 10 or more seconds.
-      ASSERT(now - start < 10, "Timed out waiting for requests.");
-
-      for (std::vector<ucp_request*>::iterator it = requests.begin(); it != requests.end();) {
-        bool restart = false;  // resets the timeout when any progress was made
-
-        // Causes UCP to progress through the send/recv message queue
-        while (ucp_worker_progress(ucp_worker_) != 0) {
-          restart = true;
-        }
-
-        auto req = *it;
-
-        // If the message needs release, we know it will be sent/received
-        // asynchronously, so we will need to track and verify its state
-        if (req->needs_release) {
-          ASSERT(UCS_PTR_IS_PTR(req->req), "UCX Request Error. Request is not valid UCX pointer");
-          ASSERT(!UCS_PTR_IS_ERR(req->req), "UCX Request Error: %d\n", UCS_PTR_STATUS(req->req));
-          ASSERT(req->req->completed == 1 || req->req->completed == 0,
-                 "request->completed not a valid value: %d\n",
-                 req->req->completed);
-        }
+    wait_requests(requests);
+  }
 
-        // If a message was sent synchronously (eg. completed before
-        // `isend`/`irecv` completed) or an asynchronous message
-        // is complete, we can go ahead and clean it up.
-        if (!req->needs_release || req->req->completed == 1) {
-          restart = true;
+  /**
+   * The stream-ordered variants post the message from a host function enqueued on the stream,
+   * once the work before it in the stream (e.g. the kernel producing the send buffer) is done,
+   * and `stream_waitall` enqueues the progress of the messages, which holds back the work after
+   * it in the stream, but not the calling thread. The ucp worker is then used by the CUDA
+   * callback thread too: the calls to ucp are serialized by a mutex, which requires a worker
+   * created with at least UCS_THREAD_MODE_SERIALIZED. The thread mode of the worker is queried when
+   * the communicator is created, and these calls are rejected on a UCS_THREAD_MODE_SINGLE worker.
+   *
+   * The wait times out like `waitall` when no message makes progress. Since the host functions of
+   * all the streams may share one thread, the matching messages of this process must be posted in
+   * stream order before the wait. An error of the callbacks cannot be thrown, so it is recorded and
+   * surfaces from the next `sync_stream` (as an error status) and the next stream-ordered call (as
+   * an exception); the communicator is not usable for stream-ordered messages afterwards.
+   */
+  void stream_isend(
+    const void* buf, size_t size, int dest, int tag, request_t* request, cudaStream_t stream) const
+  {
+    check_stream_ops();
+    enqueue_stream_op(
+      new stream_op{this, const_cast<void*>(buf), size, dest, tag, true, {}}, request, stream);
+  }
 
-          // perform cleanup
-          ucp_handler_.free_ucp_request(req);
+  void stream_irecv(
+    void* buf, size_t size, int source, int tag, request_t* request, cudaStream_t stream) const
+  {
+    check_stream_ops();
+    enqueue_stream_op(new stream_op{this, buf, size, source, tag, false, {}}, request, stream);
+  }
 
-          // remove from pending requests
-          it = requests.erase(it);
-        } else {
-          ++it;
-        }
-        // if any progress was made, reset the timeout start time
-        if (restart) { start = time(NULL); }
+  void stream_waitall(int count, request_t array_of_requests[], cudaStream_t stream) const
+  {
+    check_stream_ops();
+    std::unique_ptr<stream_op> op(new stream_op{this, nullptr, 0, 0, 0, false, {}});
+    op->requests.assign(array_of_requests, array_of_requests + count);
+    {
+      std::lock_guard<std::mutex> guard(ucp_mutex_);
+      for (request_t req_id : op->requests) {
+        ASSERT(req_id < request_pool_.size() && request_pool_[req_id].in_flight,
+               "ERROR: waitall on invalid request: %d",
+               req_id);
       }
     }
+    RAFT_CUDA_TRY(cudaLaunchHostFunc(stream, stream_wait_callback, op.get()));
+    op.release();
   }
 
   void allreduce(const void* sendbuff,
@@ -449,7 +459,16 @@ class std_comms : public comms_iface {
                                     stream));
   }
 
-  status_t sync_stream(cudaStream_t stream) const { return nccl_sync_stream(nccl_comm_, stream); }
+  /**
+   * A failure of the stream-ordered messages, which cannot be thrown from the CUDA callback thread,
+   * is reported here once the stream is done.
+   */
+  status_t sync_stream(cudaStream_t stream) const
+  {
+    status_t status = nccl_sync_stream(nccl_comm_, stream);
+    if (status == status_t::SUCCESS && !get_stream_error().empty()) { return status_t::ERROR; }
+    return status;
+  }
 
   // if a thread is sending & receiving at the same time, use device_sendrecv to avoid deadlock
   void device_send(const void* buf, size_t size, int dest, cudaStream_t stream) const
@@ -528,9 +547,170 @@ class std_comms : public comms_iface {
   comms_ucp_handler ucp_handler_;
   ucp_worker_h ucp_worker_;
   std::shared_ptr<ucp_ep_h*> ucp_eps_;
-  mutable request_t next_request_id_;
-  mutable std::unordered_map<request_t, struct ucp_request*> requests_in_flight_;
-  mutable std::unordered_set<request_t> free_requests_;
+  // whether the worker may be called from the CUDA callback thread
+  bool ucp_worker_shared_;
+
+  struct request_slot {
+    ucp_request req;
+    bool in_flight = false;
+  };
+  mutable std::vector<request_slot> request_pool_;
+  mutable std::vector<request_t> free_requests_;
+  // serializes the ucp calls and the pool between the caller and the CUDA callback thread
+  mutable std::mutex ucp_mutex_;
+  // the first failure of a CUDA callback, guarded by `ucp_mutex_`
+  mutable std::string stream_error_;
+
+  struct stream_op {
+    const std_comms* comms;
+    void* buf;
+    size_t size;
+    int peer;
+    int tag;
+    bool is_send;
+    std::vector<request_t> requests;
+  };
+
+  std::string get_stream_error() const
+  {
+    std::lock_guard<std::mutex> guard(ucp_mutex_);
+    return stream_error_;
+  }
+
+  void set_stream_error(const char* what) const
+  {
+    std::lock_guard<std::mutex> guard(ucp_mutex_);
+    if (stream_error_.empty()) { stream_error_ = what; }
+  }
+
+  void check_stream_ops() const
+  {
+    ASSERT(ucp_worker_ != nullptr, "ERROR: UCX comms not initialized on communicator.");
+    RAFT_EXPECTS(ucp_worker_shared_,
+                 "The stream-ordered messages need a ucp worker created with "
+                 "UCS_THREAD_MODE_SERIALIZED or UCS_THREAD_MODE_MULTI.");
+    auto error = get_stream_error();
+    RAFT_EXPECTS(error.empty(), "A stream-ordered message failed: %s", error.c_str());
+  }
+
+  void enqueue_stream_op(stream_op* op, request_t* request, cudaStream_t stream) const
+  {
+    std::unique_ptr<stream_op> owned(op);
+    {
+      std::lock_guard<std::mutex> guard(ucp_mutex_);
+      get_request(request);
+    }
+    owned->requests.push_back(*request);
+    RAFT_CUDA_TRY(cudaLaunchHostFunc(stream, stream_post_callback, owned.get()));
+    owned.release();
+  }
+
+  // Nothing can be thrown out of a CUDA host function: the callbacks record their failure instead,
+  // and do nothing once a previous one has failed.
+  static void CUDART_CB stream_post_callback(void* data)
+  {
+    std::unique_ptr<stream_op> op(static_cast<stream_op*>(data));
+    auto* comms = op->comms;
+    try {
+      std::lock_guard<std::mutex> guard(comms->ucp_mutex_);
+      if (!comms->stream_error_.empty()) { return; }
+      ucp_request* ucp_req = &comms->request_pool_[op->requests[0]].req;
+      ucp_ep_h ep_ptr      = (*comms->ucp_eps_)[op->peer];
+      if (op->is_send) {
+        comms->ucp_handler_.ucp_isend(
+          ucp_req, ep_ptr, op->buf, op->size, op->tag, default_tag_mask, comms->get_rank());
+      } else {
+        comms->ucp_handler_.ucp_irecv(ucp_req,
+                                      comms->ucp_worker_,
+                                      ep_ptr,
+                                      op->buf,
+                                      op->size,
+                                      op->tag,
+                                      default_tag_mask,
+                                      op->peer);
+      }
+    } catch (const std::exception& e) {
+      comms->set_stream_error(e.what());
+    }
+  }
+
+  static void CUDART_CB stream_wait_callback(void* data)
+  {
+    std::unique_ptr<stream_op> op(static_cast<stream_op*>(data));
+    auto* comms = op->comms;
+    try {
+      if (comms->get_stream_error().empty()) { comms->wait_requests(op->requests); }
+    } catch (const std::exception& e) {
+      comms->set_stream_error(e.what());
+    }
+  }
+
+  /**
+   * Progress the ucp worker until the given requests complete. The slots are looked up by id
+   * under the lock at every step, since the pool may grow from another thread meanwhile, and the
+   * ids are only recycled once their request is complete, so that `get_request` on another thread
+   * cannot reissue a slot which is still polled here.
+   */
+  void wait_requests(std::vector<request_t>& requests) const
+  {
+    time_t start = time(NULL);
+
+    while (requests.size() > 0) {
+      time_t now = time(NULL);
+
+      // Timeout if we have not gotten progress or completed any requests
+      // in 10 or more seconds.
+      ASSERT(now - start < 10, "Timed out waiting for requests.");
+
+      {
+        std::lock_guard<std::mutex> guard(ucp_mutex_);
+        for (size_t i = 0; i < requests.size();) {
+          bool restart = false;  // resets the timeout when any progress was made
+
+          // Causes UCP to progress through the send/recv message queue
+          while (ucp_worker_progress(ucp_worker_) != 0) {
+            restart = true;
+          }
+
+          auto req = &request_pool_[requests[i]].req;
+
+          // If the message needs release, we know it will be sent/received
+          // asynchronously, so we will need to track and verify its state
+          if (req->needs_release) {
+            ASSERT(UCS_PTR_IS_PTR(req->req),
+                   "UCX Request Error. Request is not valid UCX pointer");
+            ASSERT(
+              !UCS_PTR_IS_ERR(req->req), "UCX Request Error: %d\n", UCS_PTR_STATUS(req->req));
+            ASSERT(req->req->completed == 1 || req->req->completed == 0,
+                   "request->completed not a valid value: %d\n",
+                   req->req->completed);
+          }
+
+          // If a message was sent synchronously (eg. completed before
+          // `isend`/`irecv` completed) or an asynchronous message
+          // is complete, we can go ahead and clean it up.
+          if (!req->needs_release || req->req->completed == 1) {
+            restart = true;
+
+            // perform cleanup
+            ucp_handler_.release_ucp_request(req);
+            request_pool_[requests[i]].in_flight = false;
+            free_requests_.push_back(requests[i]);
+
+            // remove from pending requests, in constant time
+            requests[i] = requests.back();
+            requests.pop_back();
+          } else {
+            ++i;
+          }
+          // if any progress was made, reset the timeout start time
+          if (restart) { start = time(NULL); }
+        }
+      }
+      // let the other thread post its messages
+      std::this_thread::yield();
+    }
+  }
 };
 }  // namespace detail
 }  // end namespace comms
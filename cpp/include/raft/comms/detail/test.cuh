@@ -0,0 +1,307 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/comms/detail/hierarchical_comms.cuh>
+#include <raft/comms/detail/topk_allreduce.cuh>
+#include <raft/core/comms.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resource/comms.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/matrix/select_k.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace raft {
+namespace comms {
+namespace detail {
+
+/**
+ * A check of the hierarchical collectives against their expected results.
+ *
+ * @param[in] h the raft handle to use. This is expected to already have an
+ *        initialized comms instance.
+ * @param[in] ranks_per_node if positive, the ranks are grouped in nodes of that many consecutive
+ *        ranks (the last node holding the remainder) instead of by their host names
+ */
+bool test_hierarchical_comms(raft::resources const& h, int ranks_per_node)
+{
+  comms_t const& communicator = resource::get_comms(h);
+  int const rank              = communicator.get_rank();
+  int const size              = communicator.get_size();
+  cudaStream_t stream         = resource::get_cuda_stream(h);
+
+  std::unique_ptr<hierarchical_comms> h_comm;
+  if (ranks_per_node > 0) {
+    h_comm = std::make_unique<hierarchical_comms>(
+      communicator, stream, "node" + std::to_string(rank / ranks_per_node));
+  } else {
+    h_comm = std::make_unique<hierarchical_comms>(communicator, stream);
+  }
+
+  bool ret = true;
+  if (ranks_per_node > 0) {
+    // the two stages only run on nodes of the same number of ranks, of more than one node
+    bool hierarchical = size % ranks_per_node == 0 && ranks_per_node > 1 && ranks_per_node < size;
+    if (h_comm->is_hierarchical() != hierarchical) { ret = false; }
+    if (hierarchical && (h_comm->get_local_size() != ranks_per_node ||
+                         h_comm->get_n_nodes() != size / ranks_per_node ||
+                         h_comm->get_local_rank() != rank % ranks_per_node ||
+                         h_comm->get_node_rank() != rank / ranks_per_node)) {
+      ret = false;
+    }
+  }
+
+  // allreduce, with a count which splits evenly over the node (reduce-scatter / allreduce /
+  // allgather) and one which does not (reduce / allreduce / bcast)
+  size_t const local_size = h_comm->get_local_size();
+  for (size_t count : {4 * local_size, 4 * local_size + 1}) {
+    std::vector<int> values(count);
+    for (size_t j = 0; j < count; j++) {
+      values[j] = int(rank * count + j);
+    }
+    rmm::device_uvector<int> sum_d(count, stream);
+    raft::update_device(sum_d.data(), values.data(), count, stream);
+    h_comm->allreduce(sum_d.data(), sum_d.data(), count, op_t::SUM, stream);
+    raft::update_host(values.data(), sum_d.data(), count, stream);
+    if (communicator.sync_stream(stream) != status_t::SUCCESS) { return false; }
+    for (size_t j = 0; j < count; j++) {
+      if (values[j] != int(count * size * (size - 1) / 2 + size * j)) { ret = false; }
+    }
+  }
+
+  // allgather, back in rank order
+  {
+    size_t const sendcount = 3;
+    std::vector<int> values(sendcount * size);
+    for (size_t j = 0; j < sendcount; j++) {
+      values[j] = int(rank * sendcount + j);
+    }
+    rmm::device_uvector<int> send_d(sendcount, stream);
+    rmm::device_uvector<int> recv_d(sendcount * size, stream);
+    raft::update_device(send_d.data(), values.data(), sendcount, stream);
+    h_comm->allgather(send_d.data(), recv_d.data(), sendcount, stream);
+    raft::update_host(values.data(), recv_d.data(), values.size(), stream);
+    if (communicator.sync_stream(stream) != status_t::SUCCESS) { return false; }
+    for (size_t i = 0; i < values.size(); i++) {
+      if (values[i] != int(i)) { ret = false; }
+    }
+  }
+
+  // allgather_topk: the j-th neighbor of rank r is at the distance q + j * size + r of the query q,
+  // so the k nearest neighbors of all the ranks are at the distances q + 0, ..., q + k - 1
+  {
+    int const n_queries = 5;
+    int const k         = 4;
+    std::vector<float> distances(n_queries * k);
+    std::vector<int64_t> indices(n_queries * k);
+    for (int q = 0; q < n_queries; q++) {
+      for (int j = 0; j < k; j++) {
+        distances[q * k + j] = float(q + j * size + rank);
+        indices[q * k + j]   = int64_t(rank * k + j);
+      }
+    }
+    rmm::device_uvector<float> distances_d(n_queries * k, stream);
+    rmm::device_uvector<int64_t> indices_d(n_queries * k, stream);
+    rmm::device_uvector<float> out_distances_d(n_queries * k, stream);
+    rmm::device_uvector<int64_t> out_indices_d(n_queries * k, stream);
+    raft::update_device(distances_d.data(), distances.data(), distances.size(), stream);
+    raft::update_device(indices_d.data(), indices.data(), indices.size(), stream);
+    h_comm->allgather_topk(distances_d.data(),
+                           indices_d.data(),
+                           n_queries,
+                           k,
+                           out_distances_d.data(),
+                           out_indices_d.data(),
+                           stream);
+    raft::update_host(distances.data(), out_distances_d.data(), distances.size(), stream);
+    raft::update_host(indices.data(), out_indices_d.data(), indices.size(), stream);
+    if (communicator.sync_stream(stream) != status_t::SUCCESS) { return false; }
+    for (int q = 0; q < n_queries; q++) {
+      for (int v = 0; v < k; v++) {
+        if (distances[q * k + v] != float(q + v) ||
+            indices[q * k + v] != int64_t((v % size) * k + v / size)) {
+          ret = false;
+        }
+      }
+    }
+  }
+
+  if (rank == 0) {
+    std::cout << "hierarchical: " << h_comm->is_hierarchical()
+              << ", nodes: " << h_comm->get_n_nodes()
+              << ", local size: " << h_comm->get_local_size() << std::endl;
+  }
+  return ret;
+}
+
+/**
+ * A check of topk_allreduce against select_k over the gathered lists of all the ranks.
+ *
+ * The candidates of a query are a permutation of 0, ..., size * k - 1 (the same on all the ranks)
+ * dealt k per rank: the index of a candidate is its value, and its distance is the value, or the
+ * value divided by the number of ranks with `ties`, so that every distance is shared by several
+ * candidates. Then the neighbors picked among the ties may differ from select_k, but must be the
+ * same on all the ranks.
+ *
+ * @param[in] h the raft handle to use. This is expected to already have an
+ *        initialized comms instance.
+ * @param[in] n_ranks if positive and less than the number of ranks, the check runs on a
+ *        communicator split from the n_ranks first ranks (the other ranks run it on their own)
+ * @param[in] ties whether the candidates share their distances
+ */
+bool test_topk_allreduce(raft::resources const& h, int n_ranks, bool ties)
+{
+  comms_t const& communicator = resource::get_comms(h);
+  cudaStream_t stream         = resource::get_cuda_stream(h);
+
+  std::shared_ptr<comms_t> split;
+  if (n_ranks > 0 && n_ranks < communicator.get_size()) {
+    int const rank = communicator.get_rank();
+    split = std::make_shared<comms_t>(communicator.comm_split(rank < n_ranks ? 0 : 1, rank));
+  }
+  comms_t const& comm = split ? *split : communicator;
+  int const rank      = comm.get_rank();
+  int const size      = comm.get_size();
+
+  int const n_queries = 7;
+  int const k         = 5;
+  size_t const len    = size_t(n_queries) * k;
+  std::vector<float> distances(len);
+  std::vector<int64_t> indices(len);
+  for (int q = 0; q < n_queries; q++) {
+    std::vector<int64_t> candidates(size * k);
+    std::iota(candidates.begin(), candidates.end(), int64_t{0});
+    std::shuffle(candidates.begin(), candidates.end(), std::mt19937(q));
+    std::sort(candidates.begin() + rank * k, candidates.begin() + (rank + 1) * k);
+    for (int j = 0; j < k; j++) {
+      indices[q * k + j]   = candidates[rank * k + j];
+      distances[q * k + j] = float(ties ? indices[q * k + j] / size : indices[q * k + j]);
+    }
+  }
+  rmm::device_uvector<float> distances_d(len, stream);
+  rmm::device_uvector<int64_t> indices_d(len, stream);
+  raft::update_device(distances_d.data(), distances.data(), len, stream);
+  raft::update_device(indices_d.data(), indices.data(), len, stream);
+
+  // the reference: select_k over the [n_queries, size * k] gathered lists
+  rmm::device_uvector<float> all_distances_d(size * len, stream);
+  rmm::device_uvector<int64_t> all_indices_d(size * len, stream);
+  comm.allgather(distances_d.data(), all_distances_d.data(), len, stream);
+  comm.allgather(indices_d.data(), all_indices_d.data(), len, stream);
+  rmm::device_uvector<float> gathered_distances_d(size * len, stream);
+  rmm::device_uvector<int64_t> gathered_indices_d(size * len, stream);
+  for (int r = 0; r < size; r++) {
+    RAFT_CUDA_TRY(cudaMemcpy2DAsync(gathered_distances_d.data() + r * k,
+                                    size * k * sizeof(float),
+                                    all_distances_d.data() + r * len,
+                                    k * sizeof(float),
+                                    k * sizeof(float),
+                                    n_queries,
+                                    cudaMemcpyDeviceToDevice,
+                                    stream));
+    RAFT_CUDA_TRY(cudaMemcpy2DAsync(gathered_indices_d.data() + r * k,
+                                    size * k * sizeof(int64_t),
+                                    all_indices_d.data() + r * len,
+                                    k * sizeof(int64_t),
+                                    k * sizeof(int64_t),
+                                    n_queries,
+                                    cudaMemcpyDeviceToDevice,
+                                    stream));
+  }
+  rmm::device_uvector<float> ref_distances_d(len, stream);
+  rmm::device_uvector<int64_t> ref_indices_d(len, stream);
+  raft::matrix::select_k<float, int64_t>(
+    h,
+    raft::make_device_matrix_view<const float, int64_t>(
+      gathered_distances_d.data(), n_queries, size * k),
+    raft::make_device_matrix_view<const int64_t, int64_t>(
+      gathered_indices_d.data(), n_queries, size * k),
+    raft::make_device_matrix_view<float, int64_t>(ref_distances_d.data(), n_queries, k),
+    raft::make_device_matrix_view<int64_t, int64_t>(ref_indices_d.data(), n_queries, k),
+    true);
+
+  topk_allreduce(comm,
+                 distances_d.data(),
+                 indices_d.data(),
+                 n_queries,
+                 k,
+                 distances_d.data(),
+                 indices_d.data(),
+                 stream);
+
+  // the results of all the ranks, to check that they agree
+  rmm::device_uvector<int64_t> all_results_d(size * len, stream);
+  comm.allgather(indices_d.data(), all_results_d.data(), len, stream);
+
+  std::vector<float> ref_distances(len);
+  std::vector<int64_t> ref_indices(len);
+  std::vector<int64_t> all_results(size * len);
+  raft::update_host(distances.data(), distances_d.data(), len, stream);
+  raft::update_host(indices.data(), indices_d.data(), len, stream);
+  raft::update_host(ref_distances.data(), ref_distances_d.data(), len, stream);
+  raft::update_host(ref_indices.data(), ref_indices_d.data(), len, stream);
+  raft::update_host(all_results.data(), all_results_d.data(), all_results.size(), stream);
+  if (comm.sync_stream(stream) != status_t::SUCCESS) { return false; }
+
+  bool ret = true;
+  for (int q = 0; q < n_queries; q++) {
+    // select_k does not sort its output
+    std::vector<std::tuple<float, int64_t>> ref(k);
+    for (int j = 0; j < k; j++) {
+      ref[j] = std::make_tuple(ref_distances[q * k + j], ref_indices[q * k + j]);
+    }
+    std::sort(ref.begin(), ref.end());
+    std::vector<int64_t> picked(indices.begin() + q * k, indices.begin() + (q + 1) * k);
+    std::sort(picked.begin(), picked.end());
+    if (std::adjacent_find(picked.begin(), picked.end()) != picked.end()) { ret = false; }
+    for (int j = 0; j < k; j++) {
+      float d   = distances[q * k + j];
+      int64_t i = indices[q * k + j];
+      if (d != std::get<0>(ref[j])) { ret = false; }
+      if (d != float(ties ? i / size : i)) { ret = false; }
+      if (!ties && i != std::get<1>(ref[j])) { ret = false; }
+    }
+  }
+  for (int r = 0; r < size; r++) {
+    if (!std::equal(indices.begin(), indices.end(), all_results.begin() + r * len)) {
+      ret = false;
+    }
+  }
+
+  if (rank == 0) {
+    std::cout << "topk_allreduce over " << size << " ranks" << (ties ? " with ties: " : ": ")
+              << (ret ? "passed" : "failed") << std::endl;
+  }
+  return ret;
+}
+
+}  // namespace detail
+}  // namespace comms
+};  // namespace raft
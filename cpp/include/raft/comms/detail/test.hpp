@@ -17,17 +17,17 @@
 #pragma once
 
 #include <raft/comms/comms.hpp>
+#include <raft/core/pinned_mdarray.hpp>
 #include <raft/core/resource/comms.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resources.hpp>
 #include <rmm/device_scalar.hpp>
 #include <rmm/device_uvector.hpp>
 
+#include <algorithm>
 #include <iostream>
 #include <numeric>
-
-#include <iostream>
-#include <numeric>
+#include <vector>
 
 namespace raft {
 namespace comms {
@@ -304,7 +304,9 @@ bool test_collective_reducescatter(raft::resources const& handle, int root)
 }
 
 /**
- * A simple sanity check that UCX is able to send messages between all ranks
+ * A simple sanity check that UCX is able to send messages between all ranks. Every trial sends a
+ * different value, so that a request id recycled across the trials which completes the wrong
+ * message is caught.
  *
  * @param[in] h the raft handle to use. This is expected to already have an
  *        initialized comms instance.
@@ -317,6 +319,7 @@ bool test_pointToPoint_simple_send_recv(raft::resources const& h, int numTrials)
 
   bool ret = true;
   for (int i = 0; i < numTrials; i++) {
+    int const value = rank + i * communicator.get_size();
     std::vector<int> received_data((communicator.get_size() - 1), -1);
 
     std::vector<request_t> requests;
@@ -333,7 +336,7 @@ bool test_pointToPoint_simple_send_recv(raft::resources const& h, int numTrials)
 
     for (int r = 0; r < communicator.get_size(); ++r) {
       if (r != rank) {
-        communicator.isend(&rank, 1, r, 0, requests.data() + request_idx);
+        communicator.isend(&value, 1, r, 0, requests.data() + request_idx);
         ++request_idx;
       }
     }
@@ -341,6 +344,10 @@ bool test_pointToPoint_simple_send_recv(raft::resources const& h, int numTrials)
     communicator.waitall(requests.size(), requests.data());
     communicator.barrier();
 
+    for (int r = 0, idx = 0; r < communicator.get_size(); ++r) {
+      if (r != rank && received_data[idx++] != r + i * communicator.get_size()) { ret = false; }
+    }
+
     if (communicator.get_rank() == 0) {
       std::cout << "=========================" << std::endl;
       std::cout << "Trial " << i << std::endl;
@@ -368,6 +375,81 @@ bool test_pointToPoint_simple_send_recv(raft::resources const& h, int numTrials)
   return ret;
 }
 
+/**
+ * A sanity check of the stream-ordered isend/irecv/waitall: the send buffer is produced by a copy
+ * enqueued on the stream just before the send, and the received data is consumed by a copy enqueued
+ * just after the wait, so the messages are only correct if they are ordered by the stream.
+ *
+ * @param[in] h the raft handle to use. This is expected to already have an
+ *        initialized comms instance.
+ * @param[in] numTrials number of iterations of all-to-all messaging to perform
+ */
+bool test_pointToPoint_stream_send_recv(raft::resources const& h, int numTrials)
+{
+  comms_t const& communicator = resource::get_comms(h);
+  int const rank              = communicator.get_rank();
+  int const size              = communicator.get_size();
+  cudaStream_t stream         = resource::get_cuda_stream(h);
+
+  bool ret = true;
+  for (int i = 0; i < numTrials; i++) {
+    int const value = rank + i * size;
+    rmm::device_scalar<int> sent_d(value, stream);
+    rmm::device_uvector<int> received_d(size - 1, stream);
+    auto sent_h     = raft::make_pinned_vector<int, int>(h, 1);
+    auto received_h = raft::make_pinned_vector<int, int>(h, size - 1);
+    sent_h(0)       = -1;
+    std::fill(received_h.data_handle(), received_h.data_handle() + received_h.size(), -1);
+
+    RAFT_CUDA_TRY(cudaMemcpyAsync(
+      sent_h.data_handle(), sent_d.data(), sizeof(int), cudaMemcpyDeviceToHost, stream));
+
+    std::vector<request_t> requests(2 * (size - 1));
+    int request_idx = 0;
+    for (int r = 0; r < size; ++r) {
+      if (r != rank) {
+        communicator.irecv(received_h.data_handle() + request_idx,
+                           1,
+                           r,
+                           i,
+                           requests.data() + request_idx,
+                           stream);
+        ++request_idx;
+      }
+    }
+    for (int r = 0; r < size; ++r) {
+      if (r != rank) {
+        communicator.isend(sent_h.data_handle(), 1, r, i, requests.data() + request_idx, stream);
+        ++request_idx;
+      }
+    }
+    communicator.waitall(requests.size(), requests.data(), stream);
+
+    RAFT_CUDA_TRY(cudaMemcpyAsync(received_d.data(),
+                                  received_h.data_handle(),
+                                  received_d.size() * sizeof(int),
+                                  cudaMemcpyHostToDevice,
+                                  stream));
+    if (communicator.sync_stream(stream) != status_t::SUCCESS) { return false; }
+
+    std::vector<int> h_received_data(size - 1);
+    raft::update_host(h_received_data.data(), received_d.data(), received_d.size(), stream);
+    resource::sync_stream(h, stream);
+    int idx = 0;
+    for (int r = 0; r < size; ++r) {
+      if (r != rank && h_received_data[idx++] != r + i * size) { ret = false; }
+    }
+    communicator.barrier();
+
+    if (communicator.get_rank() == 0) {
+      std::cout << "=========================" << std::endl;
+      std::cout << "Trial " << i << (ret ? " passed" : " failed") << std::endl;
+    }
+  }
+
+  return ret;
+}
+
 /**
  * A simple sanity check that device is able to send OR receive.
  *
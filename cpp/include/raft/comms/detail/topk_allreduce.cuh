@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/comms.hpp>
+#include <raft/core/error.hpp>
+#include <raft/neighbors/detail/knn_merge_parts.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+namespace raft {
+namespace comms {
+namespace detail {
+
+/**
+ * Recursive doubling: the ranks beyond the largest power of two p first fold their lists into the
+ * ranks r - p, the p ranks exchange and merge their lists with the partner rank ^ mask for every
+ * bit of p, and the result is sent back to the folded ranks. Every hop moves k neighbors per
+ * query. See raft::comms::topk_allreduce for docs.
+ */
+template <typename value_t, typename value_idx>
+void topk_allreduce(const comms_t& comm,
+                    const value_t* distances,
+                    const value_idx* indices,
+                    size_t n_queries,
+                    int k,
+                    value_t* out_distances,
+                    value_idx* out_indices,
+                    cudaStream_t stream)
+{
+  RAFT_EXPECTS(k > 0 && k <= 1024, "k should be in [1, 1024]");
+  const int size   = comm.get_size();
+  const int rank   = comm.get_rank();
+  const size_t len = n_queries * k;
+
+  if (out_distances != distances) { raft::copy(out_distances, distances, len, stream); }
+  if (out_indices != indices) { raft::copy(out_indices, indices, len, stream); }
+  if (size == 1) { return; }
+
+  int p = 1;
+  while (2 * p <= size) {
+    p *= 2;
+  }
+
+  rmm::device_uvector<value_t> pair_distances(2 * len, stream);
+  rmm::device_uvector<value_idx> pair_indices(2 * len, stream);
+  rmm::device_uvector<value_idx> translations(2, stream);
+  RAFT_CUDA_TRY(cudaMemsetAsync(translations.data(), 0, 2 * sizeof(value_idx), stream));
+
+  // the pair is merged as [lower rank, higher rank] so that both partners of an exchange pick the
+  // same neighbors among ties
+  auto merge_with = [&](int partner, bool exchange) {
+    size_t own   = rank < partner ? 0 : len;
+    size_t other = len - own;
+    raft::copy(pair_distances.data() + own, out_distances, len, stream);
+    raft::copy(pair_indices.data() + own, out_indices, len, stream);
+    if (exchange) {
+      comm.device_sendrecv(
+        out_distances, len, partner, pair_distances.data() + other, len, partner, stream);
+      comm.device_sendrecv(
+        out_indices, len, partner, pair_indices.data() + other, len, partner, stream);
+    } else {
+      comm.device_recv(pair_distances.data() + other, len, partner, stream);
+      comm.device_recv(pair_indices.data() + other, len, partner, stream);
+    }
+    raft::neighbors::detail::knn_merge_parts(pair_distances.data(),
+                                             pair_indices.data(),
+                                             out_distances,
+                                             out_indices,
+                                             n_queries,
+                                             2,
+                                             k,
+                                             stream,
+                                             translations.data());
+  };
+
+  if (rank >= p) {
+    comm.device_send(out_distances, len, rank - p, stream);
+    comm.device_send(out_indices, len, rank - p, stream);
+  } else {
+    if (rank + p < size) { merge_with(rank + p, false); }
+    for (int mask = 1; mask < p; mask *= 2) {
+      merge_with(rank ^ mask, true);
+    }
+  }
+
+  if (rank >= p) {
+    comm.device_recv(out_distances, len, rank - p, stream);
+    comm.device_recv(out_indices, len, rank - p, stream);
+  } else if (rank + p < size) {
+    comm.device_send(out_distances, len, rank + p, stream);
+    comm.device_send(out_indices, len, rank + p, stream);
+  }
+}
+
+}  // namespace detail
+}  // namespace comms
+}  // namespace raft
@@ -71,6 +71,18 @@ static void recv_callback(void* request, ucs_status_t status, ucp_tag_recv_info_
   context->completed          = 1;
 }
 
+/**
+ * @brief Whether the given worker may be called from several threads (serialized by the caller),
+ * i.e. was created with at least UCS_THREAD_MODE_SERIALIZED
+ */
+inline bool ucp_worker_allows_threads(ucp_worker_h worker)
+{
+  ucp_worker_attr_t attr;
+  attr.field_mask = UCP_WORKER_ATTR_FIELD_THREAD_MODE;
+  if (ucp_worker_query(worker, &attr) != UCS_OK) { return false; }
+  return attr.thread_mode != UCS_THREAD_MODE_SINGLE;
+}
+
 /**
  * Helper class for interacting with ucp.
  */
@@ -87,12 +99,22 @@ class comms_ucp_handler {
    * @brief Frees any memory underlying the given ucp request object
    */
   void free_ucp_request(ucp_request* request) const
+  {
+    release_ucp_request(request);
+    free(request);
+  }
+
+  /**
+   * @brief Releases the ucx request held by the given ucp request object, which can then be
+   * reused for another message
+   */
+  void release_ucp_request(ucp_request* request) const
   {
     if (request->needs_release) {
       request->req->completed = 0;
       ucp_request_free(request->req);
     }
-    free(request);
+    request->needs_release = true;
   }
 
   /**
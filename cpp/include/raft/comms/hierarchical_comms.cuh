@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/comms/detail/hierarchical_comms.cuh>
+#include <raft/core/comms.hpp>
+
+namespace raft {
+namespace comms {
+
+/**
+ * @brief Topology-aware collectives over a communicator spanning several nodes.
+ *
+ * The ranks are grouped by their host names and the communicator is split (with `comm_split`,
+ * which is collective) into an intra-node communicator, whose traffic stays on NVLink/PCIe, and
+ * an inter-node communicator per local rank. The collectives then run in two stages:
+ *   - `allreduce`: reduce-scatter in the node, allreduce of every share over the inter-node
+ *     communicators, allgather in the node;
+ *   - `allgather`: allgather over the inter-node communicators, then in the node;
+ *   - `allgather_topk`: the k nearest neighbors (of smallest distances, k <= 1024) of every
+ *     query of all the ranks are merged on device within the node first, so that only k
+ *     neighbors per query and per node cross the nodes (with `topk_allreduce` between the first
+ *     ranks of the nodes), and the merged result is broadcast in the node.
+ * The results are the same as the flat collectives over the communicator. The hierarchical
+ * stages require every node to hold the same number of consecutive ranks; otherwise, and on a
+ * single node, the collectives fall back to the flat communicator.
+ *
+ * The communicator must outlive this object, which is built collectively by all its ranks. The
+ * ranks can also be grouped by a name given to the constructor instead of their host name, e.g. to
+ * run the two stages on a single node.
+ *
+ * @code{.cpp}
+ * #include <raft/comms/hierarchical_comms.cuh>
+ *
+ * const auto& comm = raft::resource::get_comms(handle);
+ * auto stream      = raft::resource::get_cuda_stream(handle);
+ * raft::comms::hierarchical_comms h_comm(comm, stream);
+ * // local top-k of the queries: [n_queries, k], the indices being global ids
+ * h_comm.allgather_topk(distances, indices, n_queries, k, out_distances, out_indices, stream);
+ * comm.sync_stream(stream);
+ * @endcode
+ */
+using hierarchical_comms = detail::hierarchical_comms;
+
+};  // namespace comms
+};  // end namespace raft
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/comms/detail/topk_allreduce.cuh>
+#include <raft/core/comms.hpp>
+
+namespace raft {
+namespace comms {
+
+/**
+ * @brief Allreduce of partial k-nearest-neighbors lists with select_k semantics: every rank gets
+ * the k neighbors of smallest distances of every query among the lists of all the ranks.
+ *
+ * Instead of gathering `size * k` candidates per query on every rank, the lists are merged by
+ * recursive doubling with point-to-point exchanges (`device_sendrecv`): every one of the
+ * ceil(log2(size)) hops moves only k neighbors per query and merges two lists on device with
+ * `knn_merge_parts`. The indices should be global ids (e.g. translated by the offset of the
+ * partition of the rank); the order of the neighbors with equal distances is the same on all the
+ * ranks.
+ *
+ * @code{.cpp}
+ * #include <raft/comms/topk_allreduce.cuh>
+ *
+ * const auto& comm = raft::resource::get_comms(handle);
+ * auto stream      = raft::resource::get_cuda_stream(handle);
+ * raft::comms::topk_allreduce(comm, distances, indices, n_queries, k, distances, indices, stream);
+ * comm.sync_stream(stream);
+ * @endcode
+ *
+ * @tparam value_t type of the distances
+ * @tparam value_idx type of the indices
+ * @param[in] comm the communicator; the call is collective
+ * @param[in] distances the local distances, sorted per query [n_queries, k]
+ * @param[in] indices the local indices [n_queries, k]
+ * @param[in] n_queries number of queries
+ * @param[in] k number of neighbors, at most 1024
+ * @param[out] out_distances the merged distances [n_queries, k]; may be `distances`
+ * @param[out] out_indices the merged indices [n_queries, k]; may be `indices`
+ * @param[in] stream cuda stream
+ */
+template <typename value_t, typename value_idx>
+void topk_allreduce(const comms_t& comm,
+                    const value_t* distances,
+                    const value_idx* indices,
+                    size_t n_queries,
+                    int k,
+                    value_t* out_distances,
+                    value_idx* out_indices,
+                    cudaStream_t stream)
+{
+  detail::topk_allreduce(
+    comm, distances, indices, n_queries, k, out_distances, out_indices, stream);
+}
+
+};  // namespace comms
+};  // end namespace raft
@@ -19,6 +19,7 @@
 #include <cuda_runtime.h>
 #include <memory>
 #include <raft/core/error.hpp>
+#include <raft/util/cuda_rt_essentials.hpp>
 #include <vector>
 
 namespace raft {
@@ -140,6 +141,27 @@ class comms_iface {
 
   virtual void waitall(int count, request_t array_of_requests[]) const = 0;
 
+  // stream-ordered point-to-point. By default, the stream is synchronized before posting and the
+  // requests are waited for on the host.
+  virtual void stream_isend(
+    const void* buf, size_t size, int dest, int tag, request_t* request, cudaStream_t stream) const
+  {
+    RAFT_CUDA_TRY(cudaStreamSynchronize(stream));
+    isend(buf, size, dest, tag, request);
+  }
+
+  virtual void stream_irecv(
+    void* buf, size_t size, int source, int tag, request_t* request, cudaStream_t stream) const
+  {
+    RAFT_CUDA_TRY(cudaStreamSynchronize(stream));
+    irecv(buf, size, source, tag, request);
+  }
+
+  virtual void stream_waitall(int count, request_t array_of_requests[], cudaStream_t stream) const
+  {
+    waitall(count, array_of_requests);
+  }
+
   virtual void allreduce(const void* sendbuff,
                          void* recvbuff,
                          size_t count,
@@ -331,6 +353,62 @@ class comms_t {
     impl_->waitall(count, array_of_requests);
   }
 
+  /**
+   * Performs a stream-ordered point-to-point send: the message is posted once the work enqueued
+   * before in the stream is done, without blocking the calling thread.
+   * @tparam value_t the type of data to send
+   * @param buf pointer to array of data to send
+   * @param size number of elements in buf
+   * @param dest destination rank
+   * @param tag a tag to use for the receiver to filter
+   * @param request pointer to hold returned request_t object.
+   * 		This will be used in `waitall(count, requests, stream)` on the same stream.
+   * @param stream the cuda stream to order the send on
+   */
+  template <typename value_t>
+  void isend(const value_t* buf,
+             size_t size,
+             int dest,
+             int tag,
+             request_t* request,
+             cudaStream_t stream) const
+  {
+    impl_->stream_isend(
+      static_cast<const void*>(buf), size * sizeof(value_t), dest, tag, request, stream);
+  }
+
+  /**
+   * Performs a stream-ordered point-to-point receive
+   * @tparam value_t the type of data to be received
+   * @param buf pointer to (initialized) array that will hold received data
+   * @param size number of elements in buf
+   * @param source source rank
+   * @param tag a tag to use for message filtering
+   * @param request pointer to hold returned request_t object.
+   * 		This will be used in `waitall(count, requests, stream)` on the same stream.
+   * @param stream the cuda stream to order the receive on
+   */
+  template <typename value_t>
+  void irecv(
+    value_t* buf, size_t size, int source, int tag, request_t* request, cudaStream_t stream) const
+  {
+    impl_->stream_irecv(
+      static_cast<void*>(buf), size * sizeof(value_t), source, tag, request, stream);
+  }
+
+  /**
+   * Stream-ordered synchronization on an array of request_t objects returned from the
+   * stream-ordered isend/irecv: the work enqueued after in the stream waits for the messages,
+   * but the calling thread returns immediately (for the communicators which support it).
+   * @param count number of requests to synchronize on
+   * @param array_of_requests an array of request_t objects returned from isend/irecv
+   * @param stream the cuda stream of the isend/irecv
+   */
+  void waitall(int count, request_t array_of_requests[], cudaStream_t stream) const
+  {
+    impl_->stream_waitall(count, array_of_requests, stream);
+  }
+
   /**
    * Perform an allreduce collective
    * @tparam value_t datatype of underlying buffers
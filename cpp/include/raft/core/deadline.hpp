@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/util/cuda_rt_essentials.hpp>
+
+#include <cuda_runtime_api.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+namespace raft {
+
+/**
+ * @brief A time budget of a search.
+ *
+ * When the deadline passes, the searches accepting it stop refining their results and return the
+ * best ones found so far, instead of failing or discarding the work done: the IVF searches probe
+ * fewer clusters for the remaining batches of queries, and the CAGRA searches stop their
+ * iterations.
+ *
+ * The host code observes the deadline by its time point. The kernels observe it through a flag in
+ * the mapped host memory (`device_flag()`), which is raised by `expire()`: by the host code of the
+ * search checking `expired()`, by `interruptible::synchronize(stream, deadline)` waiting for the
+ * search, or by any other thread.
+ *
+ * @code{.cpp}
+ *   cagra::search_params params;
+ *   params.deadline = raft::deadline::after(std::chrono::milliseconds(2));
+ *   cagra::search(res, params, index, queries, neighbors, distances);
+ *   bool complete = raft::interruptible::synchronize(resource::get_cuda_stream(res),
+ *                                                    params.deadline);
+ *   // if !complete, the results of some queries are approximate
+ * @endcode
+ *
+ * The copies of a deadline share its state.
+ */
+class deadline {
+ public:
+  using clock = std::chrono::steady_clock;
+
+  /** No deadline: never expires. */
+  deadline() = default;
+
+  /** A deadline at the given time point. */
+  explicit deadline(clock::time_point time_point) : state_(std::make_shared<state>(time_point)) {}
+
+  /** A deadline after the given budget from now. */
+  template <typename Rep, typename Period>
+  static auto after(std::chrono::duration<Rep, Period> budget) -> deadline
+  {
+    return deadline(clock::now() + std::chrono::duration_cast<clock::duration>(budget));
+  }
+
+  /** Whether there is a deadline at all. */
+  [[nodiscard]] auto is_set() const noexcept -> bool { return state_ != nullptr; }
+
+  /** The time point of the deadline (`clock::time_point::max()` if none). */
+  [[nodiscard]] auto time_point() const noexcept -> clock::time_point
+  {
+    return state_ ? state_->time_point : clock::time_point::max();
+  }
+
+  /** Whether the deadline has passed or was expired explicitly; raises the device flag if so. */
+  [[nodiscard]] auto expired() const noexcept -> bool
+  {
+    if (!state_) { return false; }
+    if (state_->expired.load(std::memory_order_acquire)) { return true; }
+    if (clock::now() < state_->time_point) { return false; }
+    expire();
+    return true;
+  }
+
+  /** Expire the deadline now, so that the running kernels stop at their next check. */
+  void expire() const noexcept
+  {
+    if (!state_) { return; }
+    state_->expired.store(true, std::memory_order_release);
+    if (state_->host_flag != nullptr) {
+      reinterpret_cast<volatile uint32_t*>(state_->host_flag)[0] = 1;
+    }
+  }
+
+  /**
+   * The flag read by the kernels: non-zero once the deadline is expired; nullptr if there is no
+   * deadline.
+   */
+  [[nodiscard]] auto device_flag() const -> const volatile uint32_t*
+  {
+    if (!state_) { return nullptr; }
+    return state_->device_flag;
+  }
+
+ private:
+  struct state {
+    clock::time_point time_point;
+    std::atomic<bool> expired{false};
+    uint32_t* host_flag   = nullptr;
+    uint32_t* device_flag = nullptr;
+
+    explicit state(clock::time_point time_point) : time_point(time_point)
+    {
+      RAFT_CUDA_TRY(cudaHostAlloc(&host_flag, sizeof(uint32_t), cudaHostAllocMapped));
+      host_flag[0] = 0;
+      RAFT_CUDA_TRY(cudaHostGetDevicePointer(&device_flag, host_flag, 0));
+    }
+    ~state() { RAFT_CUDA_TRY_NO_THROW(cudaFreeHost(host_flag)); }
+
+    state(const state&)                    = delete;
+    state(state&&)                         = delete;
+    auto operator=(const state&) -> state& = delete;
+    auto operator=(state&&) -> state&      = delete;
+  };
+
+  std::shared_ptr<state> state_;
+};
+
+}  // namespace raft
@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/error.hpp>
+#include <raft/core/metrics.hpp>
+#include <raft/core/pinned_container_policy.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/util/cuda_rt_essentials.hpp>
+
+#include <rmm/cuda_stream_view.hpp>
+
+#include <cuda_runtime_api.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+namespace raft::detail {
+
+/** Size of each of the pinned host buffers the device arrays are streamed through. */
+constexpr size_t kStagingBufferSize = size_t{32} << 20;
+
+/**
+ * A pair of pinned host buffers to stage the copies between the device and a stream.
+ *
+ * While one buffer is read or written by the host, the device copy of the other one proceeds in
+ * the CUDA stream; an event for every buffer tells when the copy is done.
+ */
+class staging_buffers {
+ public:
+  explicit staging_buffers(size_t bytes)
+    : buffers_{pinned_container<char>(bytes), pinned_container<char>(bytes)}
+  {
+    for (int i = 0; i < 2; i++) {
+      RAFT_CUDA_TRY(cudaEventCreateWithFlags(&events_[i], cudaEventDisableTiming));
+    }
+  }
+  ~staging_buffers() noexcept
+  {
+    for (int i = 0; i < 2; i++) {
+      RAFT_CUDA_TRY_NO_THROW(cudaEventDestroy(events_[i]));
+    }
+  }
+  staging_buffers(const staging_buffers&)                    = delete;
+  staging_buffers(staging_buffers&&)                         = delete;
+  auto operator=(const staging_buffers&) -> staging_buffers& = delete;
+  auto operator=(staging_buffers&&) -> staging_buffers&      = delete;
+
+  [[nodiscard]] auto data(int i) -> char* { return buffers_[i].data(); }
+  /** Mark the end of the device copies of the buffer `i` issued so far. */
+  void record(int i, rmm::cuda_stream_view stream)
+  {
+    RAFT_CUDA_TRY(cudaEventRecord(events_[i], stream));
+  }
+  /** Wait until the buffer `i` can be used by the host. */
+  void wait(int i) { RAFT_CUDA_TRY(cudaEventSynchronize(events_[i])); }
+
+ private:
+  pinned_container<char> buffers_[2];
+  cudaEvent_t events_[2];
+};
+
+/** Copy `n_rows` rows of `row_bytes` bytes, `dst_pitch` and `src_pitch` bytes apart. */
+inline void copy_rows(void* dst,
+                      size_t dst_pitch,
+                      const void* src,
+                      size_t src_pitch,
+                      size_t n_rows,
+                      size_t row_bytes,
+                      rmm::cuda_stream_view stream)
+{
+  if (dst_pitch == row_bytes && src_pitch == row_bytes) {
+    RAFT_CUDA_TRY(cudaMemcpyAsync(dst, src, n_rows * row_bytes, cudaMemcpyDefault, stream));
+  } else {
+    RAFT_CUDA_TRY(cudaMemcpy2DAsync(
+      dst, dst_pitch, src, src_pitch, row_bytes, n_rows, cudaMemcpyDefault, stream));
+  }
+}
+
+/**
+ * Write the content of `n_rows` device rows of `row_bytes` bytes, `pitch` bytes apart.
+ *
+ * The arrays larger than a staging buffer are streamed in chunks through two pinned buffers: the
+ * host writes one chunk while the next one is copied from the device, so that the array is never
+ * copied to the host as a whole. The smaller arrays are copied at once.
+ */
+inline void write_device_rows(raft::resources const& res,
+                              std::ostream& os,
+                              const void* data,
+                              size_t pitch,
+                              size_t n_rows,
+                              size_t row_bytes)
+{
+  const size_t total_bytes = n_rows * row_bytes;
+  if (total_bytes == 0) { return; }
+  raft::metrics::record(
+    "serialize::device_to_host_bytes", raft::metrics::metric_kind::bytes, total_bytes);
+  auto stream     = resource::get_cuda_stream(res);
+  const auto* src = static_cast<const char*>(data);
+  if (total_bytes <= kStagingBufferSize) {
+    std::vector<char> tmp(total_bytes);
+    copy_rows(tmp.data(), row_bytes, src, pitch, n_rows, row_bytes, stream);
+    resource::sync_stream(res);
+    os.write(tmp.data(), total_bytes);
+    RAFT_EXPECTS(os.good(), "Error writing content of mdspan");
+    return;
+  }
+  // The contiguous arrays are cut into chunks of any number of bytes
+  if (pitch == row_bytes) {
+    row_bytes = 1;
+    pitch     = 1;
+    n_rows    = total_bytes;
+  }
+  const size_t chunk_rows = std::max<size_t>(1, kStagingBufferSize / row_bytes);
+  staging_buffers buffers(chunk_rows * row_bytes);
+  auto write_chunk = [&](int b, size_t rows) {
+    buffers.wait(b);
+    os.write(buffers.data(b), rows * row_bytes);
+    RAFT_EXPECTS(os.good(), "Error writing content of mdspan");
+  };
+  size_t prev_rows = 0;
+  for (size_t offset = 0, c = 0; offset < n_rows; offset += chunk_rows, c++) {
+    const int b       = c % 2;
+    const size_t rows = std::min(chunk_rows, n_rows - offset);
+    copy_rows(buffers.data(b), row_bytes, src + offset * pitch, pitch, rows, row_bytes, stream);
+    buffers.record(b, stream);
+    // Write the previous chunk while the current one is copied
+    if (c > 0) { write_chunk(1 - b, prev_rows); }
+    prev_rows = rows;
+  }
+  write_chunk(((n_rows - 1) / chunk_rows) % 2, prev_rows);
+}
+
+/**
+ * Fill `n_rows` device rows of `row_bytes` bytes, `pitch` bytes apart, from a raw source.
+ *
+ * `read(dst, n_bytes)` copies the next `n_bytes` of the source to the host pointer `dst`. As for
+ * `write_device_rows`, the large arrays are read in chunks: reading a chunk into one pinned buffer
+ * overlaps with the device copy of the other buffer.
+ */
+template <typename ReadF>
+void read_device_rows(raft::resources const& res,
+                      void* data,
+                      size_t pitch,
+                      size_t n_rows,
+                      size_t row_bytes,
+                      ReadF read)
+{
+  const size_t total_bytes = n_rows * row_bytes;
+  if (total_bytes == 0) { return; }
+  raft::metrics::record(
+    "serialize::host_to_device_bytes", raft::metrics::metric_kind::bytes, total_bytes);
+  auto stream = resource::get_cuda_stream(res);
+  auto* dst   = static_cast<char*>(data);
+  if (total_bytes <= kStagingBufferSize) {
+    std::vector<char> tmp(total_bytes);
+    read(tmp.data(), total_bytes);
+    copy_rows(dst, pitch, tmp.data(), row_bytes, n_rows, row_bytes, stream);
+    resource::sync_stream(res);
+    return;
+  }
+  if (pitch == row_bytes) {
+    row_bytes = 1;
+    pitch     = 1;
+    n_rows    = total_bytes;
+  }
+  const size_t chunk_rows = std::max<size_t>(1, kStagingBufferSize / row_bytes);
+  staging_buffers buffers(chunk_rows * row_bytes);
+  for (size_t offset = 0, c = 0; offset < n_rows; offset += chunk_rows, c++) {
+    const int b       = c % 2;
+    const size_t rows = std::min(chunk_rows, n_rows - offset);
+    // the buffers start unrecorded: waiting on a fresh event returns at once
+    buffers.wait(b);
+    read(buffers.data(b), rows * row_bytes);
+    copy_rows(dst + offset * pitch, pitch, buffers.data(b), row_bytes, rows, row_bytes, stream);
+    buffers.record(b, stream);
+  }
+  // The buffers are released on return
+  resource::sync_stream(res);
+}
+
+}  // namespace raft::detail
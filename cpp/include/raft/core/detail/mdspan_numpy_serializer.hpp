@@ -20,6 +20,8 @@
 #include <raft/core/host_mdspan.hpp>
 #include <raft/core/resources.hpp>
 
+#include <cuda_fp16.h>
+
 #include <algorithm>
 #include <complex>
 #include <cstdint>
@@ -121,6 +123,12 @@ inline dtype_t get_numpy_dtype()
   return {RAFT_NUMPY_HOST_ENDIAN_CHAR, 'f', sizeof(T)};
 }
 
+template <typename T, typename std::enable_if_t<std::is_same_v<T, half>, bool> = true>
+inline dtype_t get_numpy_dtype()
+{
+  return {RAFT_NUMPY_HOST_ENDIAN_CHAR, 'f', sizeof(T)};
+}
+
 template <typename T,
           typename std::enable_if_t<std::is_integral_v<T> && std::is_signed_v<T>, bool> = true>
 inline dtype_t get_numpy_dtype()
@@ -385,54 +393,30 @@ inline header_t read_header(std::istream& is)
   return {descr, fortran_order, shape};
 }
 
-template <typename ElementType, typename Extents, typename LayoutPolicy, typename AccessorPolicy>
-inline void serialize_host_mdspan(
-  std::ostream& os,
-  const raft::host_mdspan<ElementType, Extents, LayoutPolicy, AccessorPolicy>& obj)
+/** The numpy header of a contiguous array of the given type, layout and shape. */
+template <typename ElementType, typename LayoutPolicy, typename Extents>
+inline header_t make_mdspan_header(const Extents& extents)
 {
   static_assert(std::is_same_v<LayoutPolicy, raft::layout_c_contiguous> ||
                   std::is_same_v<LayoutPolicy, raft::layout_f_contiguous>,
                 "The serializer only supports row-major and column-major layouts");
-
-  using obj_t = raft::host_mdspan<ElementType, Extents, LayoutPolicy, AccessorPolicy>;
-
   const auto dtype         = get_numpy_dtype<ElementType>();
   const bool fortran_order = std::is_same_v<LayoutPolicy, raft::layout_f_contiguous>;
   std::vector<ndarray_len_t> shape;
-  for (typename obj_t::rank_type i = 0; i < obj.rank(); ++i) {
-    shape.push_back(obj.extent(i));
+  for (typename Extents::rank_type i = 0; i < extents.rank(); ++i) {
+    shape.push_back(extents.extent(i));
   }
-  const header_t header = {dtype, fortran_order, shape};
-  write_header(os, header);
-
-  // For contiguous layouts, size() == product of dimensions
-  os.write(reinterpret_cast<const char*>(obj.data_handle()), obj.size() * sizeof(ElementType));
-  RAFT_EXPECTS(os.good(), "Error writing content of mdspan");
+  return {dtype, fortran_order, shape};
 }
 
-template <typename T>
-inline void serialize_scalar(std::ostream& os, const T& value)
-{
-  const auto dtype         = get_numpy_dtype<T>();
-  const bool fortran_order = false;
-  const std::vector<ndarray_len_t> shape{};
-  const header_t header = {dtype, fortran_order, shape};
-  write_header(os, header);
-  os.write(reinterpret_cast<const char*>(&value), sizeof(T));
-  RAFT_EXPECTS(os.good(), "Error serializing a scalar");
-}
-
-template <typename ElementType, typename Extents, typename LayoutPolicy, typename AccessorPolicy>
-inline void deserialize_host_mdspan(
-  std::istream& is,
-  const raft::host_mdspan<ElementType, Extents, LayoutPolicy, AccessorPolicy>& obj)
+/** Read a numpy header and check it matches the type, the layout and the shape of an array. */
+template <typename ElementType, typename LayoutPolicy, typename Extents>
+inline void check_mdspan_header(std::istream& is, const Extents& extents)
 {
   static_assert(std::is_same_v<LayoutPolicy, raft::layout_c_contiguous> ||
                   std::is_same_v<LayoutPolicy, raft::layout_f_contiguous>,
                 "The serializer only supports row-major and column-major layouts");
 
-  using obj_t = raft::host_mdspan<ElementType, Extents, LayoutPolicy, AccessorPolicy>;
-
   // Check if given dtype and fortran_order are compatible with the mdspan
   const auto expected_dtype         = get_numpy_dtype<ElementType>();
   const bool expected_fortran_order = std::is_same_v<LayoutPolicy, raft::layout_f_contiguous>;
@@ -446,16 +430,48 @@ inline void deserialize_host_mdspan(
                (expected_fortran_order ? "Fortran layout" : "C layout"));
 
   // Check if dimensions are correct
-  RAFT_EXPECTS(obj.rank() == header.shape.size(),
+  RAFT_EXPECTS(extents.rank() == header.shape.size(),
                "Incorrect rank: expected %zu but got %zu",
-               obj.rank(),
+               extents.rank(),
                header.shape.size());
-  for (typename obj_t::rank_type i = 0; i < obj.rank(); ++i) {
-    RAFT_EXPECTS(static_cast<ndarray_len_t>(obj.extent(i)) == header.shape[i],
+  for (typename Extents::rank_type i = 0; i < extents.rank(); ++i) {
+    RAFT_EXPECTS(static_cast<ndarray_len_t>(extents.extent(i)) == header.shape[i],
                  "Incorrect dimension: expected %zu but got %zu",
-                 static_cast<ndarray_len_t>(obj.extent(i)),
+                 static_cast<ndarray_len_t>(extents.extent(i)),
                  header.shape[i]);
   }
+}
+
+template <typename ElementType, typename Extents, typename LayoutPolicy, typename AccessorPolicy>
+inline void serialize_host_mdspan(
+  std::ostream& os,
+  const raft::host_mdspan<ElementType, Extents, LayoutPolicy, AccessorPolicy>& obj)
+{
+  write_header(os, make_mdspan_header<ElementType, LayoutPolicy>(obj.extents()));
+
+  // For contiguous layouts, size() == product of dimensions
+  os.write(reinterpret_cast<const char*>(obj.data_handle()), obj.size() * sizeof(ElementType));
+  RAFT_EXPECTS(os.good(), "Error writing content of mdspan");
+}
+
+template <typename T>
+inline void serialize_scalar(std::ostream& os, const T& value)
+{
+  const auto dtype         = get_numpy_dtype<T>();
+  const bool fortran_order = false;
+  const std::vector<ndarray_len_t> shape{};
+  const header_t header = {dtype, fortran_order, shape};
+  write_header(os, header);
+  os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  RAFT_EXPECTS(os.good(), "Error serializing a scalar");
+}
+
+template <typename ElementType, typename Extents, typename LayoutPolicy, typename AccessorPolicy>
+inline void deserialize_host_mdspan(
+  std::istream& is,
+  const raft::host_mdspan<ElementType, Extents, LayoutPolicy, AccessorPolicy>& obj)
+{
+  check_mdspan_header<ElementType, LayoutPolicy>(is, obj.extents());
 
   // For contiguous layouts, size() == product of dimensions
   is.read(reinterpret_cast<char*>(obj.data_handle()), obj.size() * sizeof(ElementType));
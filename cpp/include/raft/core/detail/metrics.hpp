@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuda_runtime_api.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace raft::metrics {
+
+/** The kind of the values of a metric. */
+enum class metric_kind : int {
+  /** A wall-clock duration measured on the host, in microseconds. */
+  host_time = 0,
+  /** A duration of the work of a CUDA stream, in microseconds. */
+  device_time = 1,
+  /** An amount of data, in bytes. */
+  bytes = 2,
+  /** A number of items (e.g. a batch size). */
+  count = 3
+};
+
+/** A function receiving every recorded value: `(name, kind, value)`. */
+typedef void (*metrics_callback)(const char* name, metric_kind kind, double value);
+
+/** A function notified at the beginning (`begin == true`) and at the end of a `phase`. */
+typedef void (*phase_callback)(const char* name, bool begin);
+
+/** The aggregate of the values recorded for a metric. */
+struct metric_summary {
+  std::string name;
+  metric_kind kind = metric_kind::count;
+  uint64_t count   = 0;
+  double sum       = 0.0;
+  double min       = std::numeric_limits<double>::infinity();
+  double max       = -std::numeric_limits<double>::infinity();
+
+  [[nodiscard]] auto mean() const noexcept -> double { return count > 0 ? sum / count : 0.0; }
+};
+
+namespace detail {
+
+/** A device duration waiting for its end event. */
+struct pending_timing {
+  const char* name;
+  cudaEvent_t start;
+  cudaEvent_t stop;
+};
+
+/**
+ * @brief The process-wide state of the metrics.
+ *
+ * The events of the device timings are pooled and never destroyed: destroying them at the exit of
+ * the process could happen after the CUDA context is gone.
+ */
+struct registry_state {
+  static inline std::atomic<bool> enabled_{false};
+  static inline std::atomic<metrics_callback> callback_{nullptr};
+  static inline std::atomic<phase_callback> phase_callback_{nullptr};
+  /** protects the members below */
+  static inline std::mutex mutex_;
+  static inline std::unordered_map<std::string, metric_summary> summaries_;
+  static inline std::deque<pending_timing> pending_;
+  static inline std::vector<cudaEvent_t> free_events_;
+};
+
+inline void record(const char* name, metric_kind kind, double value)
+{
+  {
+    std::lock_guard<std::mutex> lock(registry_state::mutex_);
+    auto& s = registry_state::summaries_[name];
+    if (s.count == 0) {
+      s.name = name;
+      s.kind = kind;
+    }
+    s.count++;
+    s.sum += value;
+    s.min = std::min(s.min, value);
+    s.max = std::max(s.max, value);
+  }
+  auto callback = registry_state::callback_.load(std::memory_order_acquire);
+  if (callback != nullptr) { callback(name, kind, value); }
+}
+
+/** Take an event from the pool; returns nullptr if no event can be created. */
+inline auto acquire_event() -> cudaEvent_t
+{
+  {
+    std::lock_guard<std::mutex> lock(registry_state::mutex_);
+    if (!registry_state::free_events_.empty()) {
+      auto event = registry_state::free_events_.back();
+      registry_state::free_events_.pop_back();
+      return event;
+    }
+  }
+  cudaEvent_t event;
+  if (cudaEventCreateWithFlags(&event, cudaEventDefault) != cudaSuccess) {
+    cudaGetLastError();
+    return nullptr;
+  }
+  return event;
+}
+
+inline void release_event(cudaEvent_t event)
+{
+  std::lock_guard<std::mutex> lock(registry_state::mutex_);
+  registry_state::free_events_.push_back(event);
+}
+
+/**
+ * Record the pending timings whose work is done, in the order they were recorded; with `wait`,
+ * wait for all of them.
+ */
+inline void resolve_pending(bool wait)
+{
+  std::vector<std::pair<const char*, double>> resolved;
+  {
+    std::lock_guard<std::mutex> lock(registry_state::mutex_);
+    auto& pending = registry_state::pending_;
+    while (!pending.empty()) {
+      auto p = pending.front();
+      if (wait) {
+        cudaEventSynchronize(p.stop);
+      } else if (cudaEventQuery(p.stop) != cudaSuccess) {
+        break;
+      }
+      float ms = 0.0f;
+      if (cudaEventElapsedTime(&ms, p.start, p.stop) == cudaSuccess) {
+        resolved.emplace_back(p.name, double(ms) * 1000.0);
+      } else {
+        cudaGetLastError();
+      }
+      pending.pop_front();
+      registry_state::free_events_.push_back(p.start);
+      registry_state::free_events_.push_back(p.stop);
+    }
+  }
+  for (auto& [name, us] : resolved) {
+    record(name, metric_kind::device_time, us);
+  }
+}
+
+inline void add_pending(const char* name, cudaEvent_t start, cudaEvent_t stop)
+{
+  {
+    std::lock_guard<std::mutex> lock(registry_state::mutex_);
+    registry_state::pending_.push_back(pending_timing{name, start, stop});
+  }
+  resolve_pending(false);
+}
+
+}  // namespace detail
+}  // namespace raft::metrics
@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/core/error.hpp>
+#include <raft/core/host_mdarray.hpp>
+#include <raft/core/mdspan_types.hpp>
+#include <raft/core/resources.hpp>
+
+#include <cuda_runtime_api.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+namespace raft {
+
+/** How a file is mapped to the memory by `host_mmap_container_policy`. */
+enum class mmap_mode {
+  /** A shared read-only mapping: writing to the array is an error (it raises SIGSEGV). */
+  read_only,
+  /** A private writable mapping: the writes stay in the memory and never reach the file. */
+  copy_on_write
+};
+
+/** Options of the memory mapping of a file. */
+struct mmap_params {
+  mmap_mode mode = mmap_mode::read_only;
+  /** Read the whole mapped range into the page cache when mapping it (`MAP_POPULATE`). */
+  bool populate = false;
+  /** Ask for transparent huge pages on the mapping (`MADV_HUGEPAGE`); this is a hint only. */
+  bool huge_pages = false;
+  /**
+   * Page-lock the mapping with `cudaHostRegister`, so that the copies between the mapped pages and
+   * the device are direct DMA transfers. The registration is an optimization: if it fails, the
+   * mapping is kept unregistered (see `mmap_container::is_registered`).
+   */
+  bool register_host = false;
+};
+
+/**
+ * @brief A contiguous range of a file mapped to the memory, owning the mapping.
+ *
+ * The container is movable, but not copyable.
+ */
+template <typename ElementType>
+class mmap_container {
+ public:
+  using value_type      = ElementType;
+  using pointer         = value_type*;
+  using const_pointer   = value_type const*;
+  using reference       = value_type&;
+  using const_reference = value_type const&;
+
+  mmap_container() noexcept = default;
+
+  /**
+   * Map `n` elements of the file `path`, starting `offset` bytes into the file.
+   *
+   * The offset needs not be a multiple of the page size, but must be aligned for `ElementType`.
+   */
+  mmap_container(const std::string& path, size_t offset, size_t n, mmap_params params)
+  {
+    if (n == 0) { return; }
+    RAFT_EXPECTS(offset % alignof(ElementType) == 0,
+                 "The offset %zu is not aligned for the element type",
+                 offset);
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) { RAFT_FAIL("Cannot open file %s", path.c_str()); }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      close(fd);
+      RAFT_FAIL("Cannot stat file %s", path.c_str());
+    }
+    const size_t bytes = n * sizeof(ElementType);
+    if (offset + bytes > static_cast<size_t>(st.st_size)) {
+      close(fd);
+      RAFT_FAIL("The file %s is too small: %zu bytes are needed from the offset %zu, got %zu",
+                path.c_str(),
+                bytes,
+                offset,
+                static_cast<size_t>(st.st_size));
+    }
+
+    // mmap takes page-aligned offsets only
+    const auto page_size    = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t map_offset = offset / page_size * page_size;
+    length_                 = bytes + (offset - map_offset);
+
+    const bool read_only = params.mode == mmap_mode::read_only;
+    const int prot       = read_only ? PROT_READ : PROT_READ | PROT_WRITE;
+    int flags            = read_only ? MAP_SHARED : MAP_PRIVATE;
+    if (params.populate) { flags |= MAP_POPULATE; }
+    void* base = mmap(nullptr, length_, prot, flags, fd, static_cast<off_t>(map_offset));
+    close(fd);
+    if (base == MAP_FAILED) { RAFT_FAIL("Cannot map file %s", path.c_str()); }
+    base_ = base;
+    data_ = reinterpret_cast<pointer>(static_cast<char*>(base_) + (offset - map_offset));
+    size_ = n;
+
+    if (params.huge_pages) { madvise(base_, length_, MADV_HUGEPAGE); }
+    if (params.register_host) {
+      unsigned int register_flags =
+        read_only ? cudaHostRegisterReadOnly : static_cast<unsigned int>(cudaHostRegisterDefault);
+      registered_ = cudaHostRegister(base_, length_, register_flags) == cudaSuccess;
+      // clear the error state left by a failed registration
+      if (!registered_) { cudaGetLastError(); }
+    }
+  }
+
+  mmap_container(const mmap_container&)                    = delete;
+  auto operator=(const mmap_container&) -> mmap_container& = delete;
+  mmap_container(mmap_container&& other) noexcept { swap(other); }
+  auto operator=(mmap_container&& other) noexcept -> mmap_container&
+  {
+    if (this != &other) {
+      release();
+      swap(other);
+    }
+    return *this;
+  }
+  ~mmap_container() noexcept { release(); }
+
+  [[nodiscard]] auto data() noexcept -> pointer { return data_; }
+  [[nodiscard]] auto data() const noexcept -> const_pointer { return data_; }
+  [[nodiscard]] auto size() const noexcept -> size_t { return size_; }
+  /** Whether the mapping is page-locked with `cudaHostRegister`. */
+  [[nodiscard]] auto is_registered() const noexcept -> bool { return registered_; }
+
+  auto operator[](size_t i) noexcept -> reference { return data_[i]; }
+  auto operator[](size_t i) const noexcept -> const_reference { return data_[i]; }
+
+ private:
+  void swap(mmap_container& other) noexcept
+  {
+    std::swap(base_, other.base_);
+    std::swap(length_, other.length_);
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+    std::swap(registered_, other.registered_);
+  }
+
+  void release() noexcept
+  {
+    if (base_ == nullptr) { return; }
+    if (registered_) { cudaHostUnregister(base_); }
+    munmap(base_, length_);
+    base_       = nullptr;
+    length_     = 0;
+    data_       = nullptr;
+    size_       = 0;
+    registered_ = false;
+  }
+
+  void* base_      = nullptr;
+  size_t length_   = 0;
+  pointer data_    = nullptr;
+  size_t size_     = 0;
+  bool registered_ = false;
+};
+
+/**
+ * @brief A container policy for host mdarray backed by a memory-mapped file.
+ *
+ * The views of such an mdarray are the ordinary host mdspans (`host_matrix_view` etc.), so the
+ * content of a file can be passed to any host API without reading it first; the pages are read
+ * from the file when accessed.
+ */
+template <typename ElementType>
+class host_mmap_container_policy {
+ public:
+  using element_type          = ElementType;
+  using container_type        = mmap_container<element_type>;
+  using pointer               = typename container_type::pointer;
+  using const_pointer         = typename container_type::const_pointer;
+  using reference             = element_type&;
+  using const_reference       = element_type const&;
+  using accessor_policy       = std::experimental::default_accessor<element_type>;
+  using const_accessor_policy = std::experimental::default_accessor<element_type const>;
+
+ public:
+  host_mmap_container_policy() = default;
+  /** Map the file `path` from `offset` bytes into the file. */
+  explicit host_mmap_container_policy(std::string path, size_t offset = 0, mmap_params params = {})
+    : path_(std::move(path)), offset_(offset), params_(params)
+  {
+  }
+
+  auto create(raft::resources const&, size_t n) -> container_type
+  {
+    return container_type(path_, offset_, n, params_);
+  }
+
+  [[nodiscard]] auto access(container_type& c, size_t n) const noexcept -> reference
+  {
+    return c[n];
+  }
+  [[nodiscard]] auto access(container_type const& c, size_t n) const noexcept
+    -> const_reference
+  {
+    return c[n];
+  }
+
+  [[nodiscard]] auto make_accessor_policy() noexcept { return accessor_policy{}; }
+  [[nodiscard]] auto make_accessor_policy() const noexcept { return const_accessor_policy{}; }
+
+ private:
+  std::string path_;
+  size_t offset_ = 0;
+  mmap_params params_{};
+};
+
+/**
+ * @brief Shorthand for a host matrix backed by a memory-mapped file.
+ * @tparam ElementType the data type of the matrix elements
+ * @tparam IndexType the index type of the extents
+ * @tparam LayoutPolicy policy for strides and layout ordering
+ */
+template <typename ElementType,
+          typename IndexType    = std::uint32_t,
+          typename LayoutPolicy = layout_c_contiguous>
+using host_mmap_matrix = host_mdarray<ElementType,
+                                      matrix_extent<IndexType>,
+                                      LayoutPolicy,
+                                      host_mmap_container_policy<ElementType>>;
+
+/**
+ * @brief Map a matrix stored in a file to the memory.
+ *
+ * The matrix is read as `n_rows * n_cols` elements stored contiguously from `offset` bytes into
+ * the file (e.g. after the header of the file); `.view()` of the result is a `host_matrix_view`.
+ *
+ * @code{.cpp}
+ * // a .fbin file: two int32 (n_rows, n_cols) followed by the float rows
+ * auto dataset = raft::make_host_mmap_matrix<float, int64_t>(res, "base.fbin", n_rows, dim, 8);
+ * raft::neighbors::refine(
+ *   res, raft::make_const_mdspan(dataset.view()), queries, candidates, indices, distances);
+ * @endcode
+ *
+ * @tparam ElementType the data type of the matrix elements
+ * @tparam IndexType the index type of the extents
+ * @tparam LayoutPolicy policy for strides and layout ordering
+ * @param[in] res raft handle for managing expensive resources
+ * @param[in] path the file to map
+ * @param[in] n_rows number of rows of the matrix
+ * @param[in] n_cols number of columns of the matrix
+ * @param[in] offset the position of the first element in the file, in bytes
+ * @param[in] params the mapping options
+ * @return raft::host_mmap_matrix
+ */
+template <typename ElementType,
+          typename IndexType    = std::uint32_t,
+          typename LayoutPolicy = layout_c_contiguous>
+auto make_host_mmap_matrix(raft::resources const& res,
+                           const std::string& path,
+                           IndexType n_rows,
+                           IndexType n_cols,
+                           size_t offset      = 0,
+                           mmap_params params = {})
+  -> host_mmap_matrix<ElementType, IndexType, LayoutPolicy>
+{
+  using mdarray_t = host_mmap_matrix<ElementType, IndexType, LayoutPolicy>;
+
+  matrix_extent<IndexType> exts{n_rows, n_cols};
+  typename mdarray_t::mapping_type layout{exts};
+  host_mmap_container_policy<ElementType> policy(path, offset, params);
+
+  return mdarray_t{res, layout, policy};
+}
+
+}  // namespace raft
@@ -22,6 +22,7 @@
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <raft/core/deadline.hpp>
 #include <raft/core/error.hpp>
 #include <raft/util/cudart_utils.hpp>
 #include <rmm/cuda_stream_view.hpp>
@@ -100,6 +101,27 @@ class interruptible {
     get_token()->synchronize_impl(cudaEventQuery, event);
   }
 
+  /**
+   * @brief Synchronize the CUDA stream, expiring the deadline when it passes.
+   *
+   * Unlike `interruptible::cancel`, the deadline does not drop the work: once it is expired, the
+   * kernels observing it stop early and this call waits for them to finish, so that the stream
+   * work is complete (possibly with approximate results) when it returns.
+   *
+   * @param [in] stream a CUDA stream.
+   * @param [in] deadline the time budget of the work in the stream.
+   *
+   * @return whether the work finished before the deadline expired.
+   *
+   * @throw raft::interrupted_exception if interruptible::cancel() was called on the current CPU
+   * thread before the currently captured work has been finished.
+   * @throw raft::cuda_error if another CUDA error happens.
+   */
+  static inline auto synchronize(rmm::cuda_stream_view stream, const deadline& deadline) -> bool
+  {
+    return get_token()->synchronize_impl(cudaStreamQuery, stream, deadline);
+  }
+
   /**
    * @brief Check the thread state, whether the thread can continue execution or is interrupted by
    * `interruptible::cancel`.
@@ -300,6 +322,22 @@ class interruptible {
     }
     RAFT_CUDA_TRY(query_result);
   }
+
+  template <typename Query, typename Object>
+  inline auto synchronize_impl(Query query, Object object, const deadline& deadline) -> bool
+  {
+    bool in_time = !deadline.expired();
+    cudaError_t query_result;
+    while (true) {
+      yield_impl();
+      query_result = query(object);
+      if (query_result != cudaErrorNotReady) { break; }
+      if (in_time && deadline.expired()) { in_time = false; }
+      std::this_thread::yield();
+    }
+    RAFT_CUDA_TRY(query_result);
+    return in_time;
+  }
 };
 
 /**
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/core/device_container_policy.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+
+#include <rmm/mr/device/managed_memory_resource.hpp>
+
+namespace raft {
+
+/**
+ * @brief A container policy for managed mdarray.
+ *
+ * The memory is allocated with `rmm::mr::managed_memory_resource`, whatever the workspace
+ * resource of the handle, so that the array can be accessed from both the host and the device.
+ */
+template <typename ElementType>
+class managed_uvector_policy {
+ public:
+  using element_type    = ElementType;
+  using container_type  = device_uvector<element_type>;
+  using pointer         = typename container_type::pointer;
+  using const_pointer   = typename container_type::const_pointer;
+  using reference       = device_reference<element_type>;
+  using const_reference = device_reference<element_type const>;
+
+  using accessor_policy       = std::experimental::default_accessor<element_type>;
+  using const_accessor_policy = std::experimental::default_accessor<element_type const>;
+
+ public:
+  auto create(raft::resources const& res, size_t n) -> container_type
+  {
+    return container_type(n, resource::get_cuda_stream(res), memory_resource());
+  }
+
+  managed_uvector_policy() = default;
+
+  [[nodiscard]] constexpr auto access(container_type& c, size_t n) const noexcept -> reference
+  {
+    return c[n];
+  }
+  [[nodiscard]] constexpr auto access(container_type const& c, size_t n) const noexcept
+    -> const_reference
+  {
+    return c[n];
+  }
+
+  [[nodiscard]] auto make_accessor_policy() noexcept { return accessor_policy{}; }
+  [[nodiscard]] auto make_accessor_policy() const noexcept { return const_accessor_policy{}; }
+
+ private:
+  static auto memory_resource() -> rmm::mr::managed_memory_resource*
+  {
+    static rmm::mr::managed_memory_resource mr{};
+    return &mr;
+  }
+};
+
+}  // namespace raft
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+
+namespace raft {
+
+/**
+ * @brief An estimate of the memory used by an algorithm, in bytes.
+ *
+ * The estimate splits the memory allocated by the algorithm into what it returns (e.g. a built
+ * index), which stays allocated after the call, and the peak of its temporary buffers, which are
+ * released on return. The inputs and outputs passed by the caller are not counted.
+ *
+ * The estimates follow the internal batching heuristics of the algorithms and count their large
+ * buffers (proportional to the problem sizes); the small fixed-size allocations and the allocator
+ * overheads (e.g. the granularity of a memory pool) are not counted.
+ */
+struct memory_estimate {
+  /** Device memory held by the result. */
+  size_t device_result = 0;
+  /** Peak device memory of the temporary buffers. */
+  size_t device_workspace = 0;
+  /** Host memory held by the result. */
+  size_t host_result = 0;
+  /** Peak host memory of the temporary buffers. */
+  size_t host_workspace = 0;
+
+  /** The peak device memory used during the call. */
+  [[nodiscard]] constexpr auto device_peak() const noexcept -> size_t
+  {
+    return device_result + device_workspace;
+  }
+  /** The peak host memory used during the call. */
+  [[nodiscard]] constexpr auto host_peak() const noexcept -> size_t
+  {
+    return host_result + host_workspace;
+  }
+};
+
+}  // namespace raft
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2022, NVIDIA CORPORATION.
+ * Copyright (c) 2022-2023, NVIDIA CORPORATION.
  *
  * Licensed under the Apache License, Version 2.0 (the "License");
  * you may not use this file except in compliance with the License.
@@ -15,6 +15,8 @@
  */
 #pragma once
 
+#include <cuda_runtime_api.h>
+
 namespace raft {
 enum class memory_type { host, device, managed, pinned };
 
@@ -32,6 +34,45 @@ auto constexpr is_host_device_accessible(memory_type mem_type)
   return is_device_accessible(mem_type) && is_host_accessible(mem_type);
 }
 
+/**
+ * @brief The type of the memory a pointer points to, as seen by the CUDA runtime.
+ *
+ * The pageable host memory is reported as `memory_type::host` even on the systems where the
+ * devices can access it (e.g. with HMM or ATS), see `device_reads_pageable_memory`.
+ */
+template <typename T>
+auto memory_type_from_pointer(const T* ptr) -> memory_type
+{
+  cudaPointerAttributes attr;
+  if (ptr == nullptr || cudaPointerGetAttributes(&attr, ptr) != cudaSuccess) {
+    // clear the error state of an unregistered pointer
+    cudaGetLastError();
+    return memory_type::host;
+  }
+  switch (attr.type) {
+    case cudaMemoryTypeDevice: return memory_type::device;
+    case cudaMemoryTypeManaged: return memory_type::managed;
+    case cudaMemoryTypeHost: return memory_type::pinned;
+    default: return memory_type::host;
+  }
+}
+
+/**
+ * @brief Whether the device accesses the host memory (pageable or pinned) coherently through the
+ * host page tables, at a bandwidth comparable to a copy (e.g. ATS over NVLink-C2C on
+ * Grace-Hopper).
+ */
+inline auto device_reads_pageable_memory(int device_id) -> bool
+{
+  int value = 0;
+  if (cudaDeviceGetAttribute(
+        &value, cudaDevAttrPageableMemoryAccessUsesHostPageTables, device_id) != cudaSuccess) {
+    cudaGetLastError();
+    return false;
+  }
+  return value != 0;
+}
+
 namespace detail {
 
 template <bool is_host_accessible, bool is_device_accessible>
@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/detail/metrics.hpp>
+
+#include <rmm/cuda_stream_view.hpp>
+
+#include <cuda_runtime_api.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+/**
+ * \section Usage
+ *
+ * The metrics are counters cheap enough to stay enabled in production, unlike the NVTX ranges,
+ * which are visible with Nsight only. When enabled, the library records:
+ *
+ *   - the host duration of every `common::nvtx::range` scope (named by its format string), which
+ *     is the latency of the API calls as seen by the caller;
+ *   - the device duration of the phases of the searches (e.g. `ivf_pq::search::scan`), measured
+ *     with CUDA events without synchronizing the stream;
+ *   - the batch sizes chosen by the searches, the workspace allocations and the bytes copied by
+ *     the serialization of the device arrays.
+ *
+ * Every value is aggregated per name and, optionally, passed to a callback (the sink):
+ * \code{.cpp}
+ * #include <raft/core/metrics.hpp>
+ *
+ * void my_sink(const char* name, raft::metrics::metric_kind kind, double value)
+ * {
+ *   // forward to the monitoring system
+ * }
+ *
+ * raft::metrics::set_callback(my_sink);
+ * raft::metrics::set_enabled(true);
+ * ...
+ * for (auto& s : raft::metrics::snapshot()) {
+ *   std::cout << s.name << ": " << s.mean() << " (" << s.count << " values)\n";
+ * }
+ * \endcode
+ *
+ * The algorithms also mark their main phases (e.g. `ivf_pq::build::kmeans`) with `phase`, which
+ * records the device duration of the phase and notifies the phase callback (`set_phase_callback`)
+ * at its beginning and end, e.g. to attribute the memory usage to the phases.
+ *
+ * When disabled (the default), recording a value costs a relaxed atomic load.
+ */
+namespace raft::metrics {
+
+/** Enable or disable the recording of the metrics (process-wide). */
+inline void set_enabled(bool enabled)
+{
+  detail::registry_state::enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+/** Whether the metrics are recorded. */
+inline auto is_enabled() noexcept -> bool
+{
+  return detail::registry_state::enabled_.load(std::memory_order_relaxed);
+}
+
+/**
+ * Set the function receiving every recorded value, or nullptr to only aggregate them.
+ *
+ * The callback is called from the thread recording the value (the device durations are passed
+ * when their work is found complete, possibly by another thread); it must be thread safe.
+ */
+inline void set_callback(metrics_callback callback)
+{
+  detail::registry_state::callback_.store(callback, std::memory_order_release);
+}
+
+/**
+ * Set the function notified at the beginning and the end of every `phase`, or nullptr.
+ *
+ * The callback is called from the thread running the phase, only when the metrics are enabled.
+ */
+inline void set_phase_callback(phase_callback callback)
+{
+  detail::registry_state::phase_callback_.store(callback, std::memory_order_release);
+}
+
+/**
+ * Record a value of a metric if the metrics are enabled.
+ *
+ * @param name the name of the metric; it must outlive the recording (e.g. a string literal)
+ * @param kind the kind of the value
+ * @param value the value
+ */
+inline void record(const char* name, metric_kind kind, double value)
+{
+  if (is_enabled()) { detail::record(name, kind, value); }
+}
+
+/** Wait for the pending device durations and record them. */
+inline void flush() { detail::resolve_pending(true); }
+
+/** The aggregates of all the metrics recorded so far, after a `flush()`. */
+inline auto snapshot() -> std::vector<metric_summary>
+{
+  flush();
+  std::lock_guard<std::mutex> lock(detail::registry_state::mutex_);
+  std::vector<metric_summary> res;
+  res.reserve(detail::registry_state::summaries_.size());
+  for (const auto& [name, s] : detail::registry_state::summaries_) {
+    res.push_back(s);
+  }
+  return res;
+}
+
+/** Drop the aggregates recorded so far (the pending device durations are recorded first). */
+inline void reset()
+{
+  flush();
+  std::lock_guard<std::mutex> lock(detail::registry_state::mutex_);
+  detail::registry_state::summaries_.clear();
+}
+
+/** Record the host duration of a scope (`metric_kind::host_time`). */
+class scoped_timer {
+ public:
+  /** @param name the name of the metric; it must outlive the timer (e.g. a string literal) */
+  explicit scoped_timer(const char* name) : name_(is_enabled() ? name : nullptr)
+  {
+    if (name_ != nullptr) { start_ = std::chrono::steady_clock::now(); }
+  }
+  ~scoped_timer()
+  {
+    if (name_ == nullptr) { return; }
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start_;
+    detail::record(name_, metric_kind::host_time, elapsed.count());
+  }
+
+  scoped_timer(const scoped_timer&)                    = delete;
+  scoped_timer(scoped_timer&&)                         = delete;
+  auto operator=(const scoped_timer&) -> scoped_timer& = delete;
+  auto operator=(scoped_timer&&) -> scoped_timer&      = delete;
+
+ private:
+  const char* name_;
+  std::chrono::steady_clock::time_point start_{};
+};
+
+/**
+ * Record the device duration of the work issued to a stream within a scope
+ * (`metric_kind::device_time`).
+ *
+ * The duration is measured with a pair of events and recorded once the work is complete, without
+ * synchronizing the stream. Nothing is measured while the stream is captured into a CUDA graph.
+ */
+class stream_timer {
+ public:
+  /**
+   * @param name the name of the metric; it must outlive the timer (e.g. a string literal)
+   * @param stream the stream of the measured work
+   */
+  stream_timer(const char* name, rmm::cuda_stream_view stream) : name_(name), stream_(stream)
+  {
+    if (!is_enabled()) { return; }
+    cudaStreamCaptureStatus status;
+    if (cudaStreamIsCapturing(stream_, &status) != cudaSuccess ||
+        status != cudaStreamCaptureStatusNone) {
+      return;
+    }
+    start_ = detail::acquire_event();
+    if (start_ != nullptr && cudaEventRecord(start_, stream_) != cudaSuccess) {
+      cudaGetLastError();
+      detail::release_event(start_);
+      start_ = nullptr;
+    }
+  }
+  ~stream_timer()
+  {
+    if (start_ == nullptr) { return; }
+    auto stop = detail::acquire_event();
+    if (stop == nullptr || cudaEventRecord(stop, stream_) != cudaSuccess) {
+      cudaGetLastError();
+      detail::release_event(start_);
+      if (stop != nullptr) { detail::release_event(stop); }
+      return;
+    }
+    detail::add_pending(name_, start_, stop);
+  }
+
+  stream_timer(const stream_timer&)                    = delete;
+  stream_timer(stream_timer&&)                         = delete;
+  auto operator=(const stream_timer&) -> stream_timer& = delete;
+  auto operator=(stream_timer&&) -> stream_timer&      = delete;
+
+ private:
+  const char* name_;
+  rmm::cuda_stream_view stream_;
+  cudaEvent_t start_ = nullptr;
+};
+
+/**
+ * A named phase of an algorithm: records the device duration of the work issued to the stream
+ * within the scope (as `stream_timer`) and notifies the phase callback at its beginning and end.
+ */
+class phase {
+ public:
+  /**
+   * @param name the name of the phase; it must outlive the phase (e.g. a string literal)
+   * @param stream the stream of the work of the phase
+   */
+  phase(const char* name, rmm::cuda_stream_view stream)
+    : timer_(name, stream), name_(is_enabled() ? name : nullptr)
+  {
+    if (name_ == nullptr) { return; }
+    auto callback = detail::registry_state::phase_callback_.load(std::memory_order_acquire);
+    if (callback != nullptr) { callback(name_, true); }
+  }
+  ~phase()
+  {
+    if (name_ == nullptr) { return; }
+    auto callback = detail::registry_state::phase_callback_.load(std::memory_order_acquire);
+    if (callback != nullptr) { callback(name_, false); }
+  }
+
+  phase(const phase&)                    = delete;
+  phase(phase&&)                         = delete;
+  auto operator=(const phase&) -> phase& = delete;
+  auto operator=(phase&&) -> phase&      = delete;
+
+ private:
+  stream_timer timer_;
+  const char* name_;
+};
+
+}  // namespace raft::metrics
@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/core/error.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/cuda_stream_pool.hpp>
+#include <raft/core/resource/device_id.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/util/cuda_rt_essentials.hpp>
+
+#include <rmm/cuda_stream.hpp>
+#include <rmm/cuda_stream_pool.hpp>
+
+#include <cuda_runtime_api.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace raft {
+
+namespace detail {
+
+/** Make `device` the current device for the lifetime of the guard. */
+class scoped_device {
+ public:
+  explicit scoped_device(int device)
+  {
+    RAFT_CUDA_TRY(cudaGetDevice(&prev_));
+    RAFT_CUDA_TRY(cudaSetDevice(device));
+  }
+  ~scoped_device() { RAFT_CUDA_TRY_NO_THROW(cudaSetDevice(prev_)); }
+
+  scoped_device(const scoped_device&)                    = delete;
+  scoped_device(scoped_device&&)                         = delete;
+  auto operator=(const scoped_device&) -> scoped_device& = delete;
+  auto operator=(scoped_device&&) -> scoped_device&      = delete;
+
+ private:
+  int prev_ = 0;
+};
+
+/**
+ * Run `f(i)` for every handle `res[i]` concurrently, each in its own host thread with the device of
+ * the handle set as current. The first exception thrown by any of the calls is rethrown.
+ */
+template <typename F>
+void for_each_device(const std::vector<raft::resources>& res, F f)
+{
+  std::vector<std::exception_ptr> errors(res.size());
+  std::vector<std::thread> threads;
+  threads.reserve(res.size());
+  for (size_t i = 0; i < res.size(); i++) {
+    threads.emplace_back([&, i]() {
+      try {
+        RAFT_CUDA_TRY(cudaSetDevice(resource::get_device_id(res[i])));
+        f(i);
+      } catch (...) {
+        errors[i] = std::current_exception();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (auto& error : errors) {
+    if (error) { std::rethrow_exception(error); }
+  }
+}
+
+}  // namespace detail
+
+/**
+ * @brief A set of `raft::resources` handles, one per device, for the multi-GPU algorithms running
+ * in a single process.
+ *
+ * Every handle owns a stream of its device and, optionally, a stream pool and a bounded workspace
+ * arena (`resource::set_workspace_to_arena_resource`) on that device. The peer access is enabled
+ * between all the pairs of devices supporting it, so that the kernels and the copies of one device
+ * can read the memory of the others (it stays enabled after the object is destroyed).
+ *
+ * The handles create the rest of their resources (e.g. the cuBLAS handle) lazily, on the device
+ * current at the first use: use a handle with its device set as current, which `for_each_device`
+ * does.
+ *
+ * @code{.cpp}
+ *   #include <raft/core/multi_device_resources.hpp>
+ *   // all the visible devices, two pool streams and a 1GB workspace per device
+ *   raft::multi_device_resources mres({}, 2, size_t{1} << 30);
+ *   mres.for_each_device([&](size_t i, raft::resources const& res) {
+ *     // runs in its own host thread with the device mres.device_id(i) set as current
+ *     ...
+ *   });
+ *   // the handles themselves, e.g. for raft::neighbors::experimental::cagra::build_sharded
+ *   auto index = cagra::build_sharded(mres.handles(), params, dataset);
+ * @endcode
+ */
+class multi_device_resources {
+ public:
+  /**
+   * @param device_ids the devices, in the order of the handles (all the visible devices if empty);
+   *   a device must not be repeated
+   * @param n_pool_streams the number of streams of the stream pool of every handle (no stream pool
+   *   if zero)
+   * @param workspace_size the capacity of the workspace arena of every handle, in bytes (the
+   *   default workspace resource if zero)
+   */
+  explicit multi_device_resources(std::vector<int> device_ids = {},
+                                  size_t n_pool_streams       = 0,
+                                  size_t workspace_size       = 0)
+    : device_ids_(std::move(device_ids))
+  {
+    if (device_ids_.empty()) {
+      int n_devices = 0;
+      RAFT_CUDA_TRY(cudaGetDeviceCount(&n_devices));
+      for (int d = 0; d < n_devices; d++) {
+        device_ids_.push_back(d);
+      }
+    }
+    RAFT_EXPECTS(!device_ids_.empty(), "At least one device is required");
+    const size_t n = device_ids_.size();
+    streams_.reserve(n);
+    handles_.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+      for (size_t j = 0; j < i; j++) {
+        RAFT_EXPECTS(device_ids_[i] != device_ids_[j], "The device %d is repeated", device_ids_[i]);
+      }
+      detail::scoped_device guard(device_ids_[i]);
+      streams_.emplace_back();
+      handles_.emplace_back();
+      auto& res = handles_.back();
+      // the device of the handle is the current one when it is first queried
+      resource::get_device_id(res);
+      resource::set_cuda_stream(res, streams_.back().view());
+      if (n_pool_streams > 0) {
+        resource::set_cuda_stream_pool(res,
+                                       std::make_shared<rmm::cuda_stream_pool>(n_pool_streams));
+      }
+      if (workspace_size > 0) {
+        resource::set_workspace_to_arena_resource(res, workspace_size);
+      } else {
+        resource::get_workspace_resource(res);
+      }
+    }
+    enable_peer_access();
+  }
+
+  multi_device_resources(const multi_device_resources&)                    = delete;
+  auto operator=(const multi_device_resources&) -> multi_device_resources& = delete;
+  multi_device_resources(multi_device_resources&&)                         = default;
+  auto operator=(multi_device_resources&&) -> multi_device_resources&      = default;
+
+  /** The number of devices (and handles). */
+  [[nodiscard]] auto size() const noexcept -> size_t { return handles_.size(); }
+  /** The device of the handle `i`. */
+  [[nodiscard]] auto device_id(size_t i) const -> int { return device_ids_.at(i); }
+  /** The handle of the device `device_id(i)`. */
+  [[nodiscard]] auto operator[](size_t i) const -> raft::resources const& { return handles_.at(i); }
+  /** All the handles, in the order of `device_id`. */
+  [[nodiscard]] auto handles() const noexcept -> const std::vector<raft::resources>&
+  {
+    return handles_;
+  }
+  /** Whether the device of the handle `i` can access the memory of the device of the handle `j`. */
+  [[nodiscard]] auto can_access_peer(size_t i, size_t j) const -> bool
+  {
+    return i == j || peer_access_.at(i * size() + j) != 0;
+  }
+
+  /**
+   * Run `f(i, handle(i))` for every device concurrently, each in its own host thread with the
+   * device `device_id(i)` set as current. The first exception thrown by any of the calls is
+   * rethrown once all of them are done.
+   */
+  template <typename F>
+  void for_each_device(F f) const
+  {
+    detail::for_each_device(handles_, [&](size_t i) { f(i, handles_[i]); });
+  }
+
+  /** Wait for the work of the streams of all the handles (not of their stream pools). */
+  void sync() const
+  {
+    for (size_t i = 0; i < size(); i++) {
+      detail::scoped_device guard(device_ids_[i]);
+      resource::sync_stream(handles_[i]);
+    }
+  }
+
+ private:
+  std::vector<int> device_ids_;
+  // The streams are declared before the handles using them (the workspace arenas are released in
+  // the streams).
+  std::vector<rmm::cuda_stream> streams_;
+  std::vector<raft::resources> handles_;
+  std::vector<uint8_t> peer_access_;
+
+  void enable_peer_access()
+  {
+    const size_t n = size();
+    peer_access_.assign(n * n, 0);
+    for (size_t i = 0; i < n; i++) {
+      detail::scoped_device guard(device_ids_[i]);
+      for (size_t j = 0; j < n; j++) {
+        if (i == j) { continue; }
+        int can_access = 0;
+        RAFT_CUDA_TRY(cudaDeviceCanAccessPeer(&can_access, device_ids_[i], device_ids_[j]));
+        if (can_access == 0) { continue; }
+        auto status = cudaDeviceEnablePeerAccess(device_ids_[j], 0);
+        if (status == cudaErrorPeerAccessAlreadyEnabled) {
+          // clear the error state; the access is there anyway
+          cudaGetLastError();
+        } else {
+          RAFT_CUDA_TRY(status);
+        }
+        peer_access_[i * n + j] = 1;
+      }
+    }
+  }
+};
+
+}  // namespace raft
@@ -18,6 +18,7 @@
 
 #include <optional>
 #include <raft/core/detail/nvtx.hpp>
+#include <raft/core/metrics.hpp>
 
 /**
  * \section Usage
@@ -119,6 +120,9 @@ inline void pop_range()
  *
  * Refer to \ref Usage for the usage examples.
  *
+ * When the metrics are enabled (`raft::metrics::set_enabled`), the host duration of the range is
+ * also recorded under its format string (see raft/core/metrics.hpp).
+ *
  * @tparam Domain optional struct that defines the NVTX domain message;
  *   You can create a new domain with a custom message as follows:
  *   \code{.cpp}
@@ -136,7 +140,7 @@ class range {
    * @param args the arguments for the printf-style formatting
    */
   template <typename... Args>
-  explicit range(const char* format, Args... args)
+  explicit range(const char* format, Args... args) : timer_(format)
   {
     push_range<Domain, Args...>(format, args...);
   }
@@ -150,6 +154,9 @@ class range {
   auto operator=(range&&) -> range&                = delete;
   static auto operator new(std::size_t) -> void*   = delete;
   static auto operator new[](std::size_t) -> void* = delete;
+
+ private:
+  raft::metrics::scoped_timer timer_;
 };
 
 }  // namespace raft::common::nvtx
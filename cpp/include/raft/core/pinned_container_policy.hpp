@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/core/mdspan_types.hpp>
+#include <raft/core/resources.hpp>
+
+#include <rmm/mr/host/pinned_memory_resource.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+
+namespace raft {
+
+/**
+ * @brief A fixed-size array in pinned (page-locked) host memory.
+ *
+ * The memory is allocated with `rmm::mr::pinned_memory_resource`; the copies between such an array
+ * and the device are direct DMA transfers, which can be asynchronous with respect to the host.
+ * Copying the container copies the elements into a new pinned allocation.
+ */
+template <typename T>
+class pinned_container {
+ public:
+  using value_type = T;
+  using size_type  = std::size_t;
+
+  using reference       = value_type&;
+  using const_reference = value_type const&;
+
+  using pointer       = value_type*;
+  using const_pointer = value_type const*;
+
+  using iterator       = pointer;
+  using const_iterator = const_pointer;
+
+ public:
+  explicit pinned_container(std::size_t size) : size_{size}, data_{allocate(size)} {}
+  pinned_container(pinned_container const& that) : pinned_container(that.size_)
+  {
+    std::copy(that.data_, that.data_ + that.size_, data_);
+  }
+  pinned_container(pinned_container&& that) noexcept
+    : size_{std::exchange(that.size_, 0)}, data_{std::exchange(that.data_, nullptr)}
+  {
+  }
+  auto operator=(pinned_container const& that) -> pinned_container&
+  {
+    if (this != &that) { *this = pinned_container{that}; }
+    return *this;
+  }
+  auto operator=(pinned_container&& that) noexcept -> pinned_container&
+  {
+    std::swap(size_, that.size_);
+    std::swap(data_, that.data_);
+    return *this;
+  }
+  ~pinned_container() noexcept
+  {
+    if (data_ != nullptr) { resource().deallocate(data_, size_ * sizeof(value_type)); }
+  }
+
+  [[nodiscard]] auto data() noexcept -> pointer { return data_; }
+  [[nodiscard]] auto data() const noexcept -> const_pointer { return data_; }
+  [[nodiscard]] auto size() const noexcept -> size_type { return size_; }
+
+  auto operator[](std::size_t i) noexcept -> reference { return data_[i]; }
+  auto operator[](std::size_t i) const noexcept -> const_reference { return data_[i]; }
+
+ private:
+  static auto resource() -> rmm::mr::pinned_memory_resource&
+  {
+    static rmm::mr::pinned_memory_resource mr{};
+    return mr;
+  }
+  static auto allocate(std::size_t size) -> pointer
+  {
+    if (size == 0) { return nullptr; }
+    return static_cast<pointer>(resource().allocate(size * sizeof(value_type)));
+  }
+
+  size_type size_;
+  pointer data_;
+};
+
+/**
+ * @brief A container policy for pinned mdarray.
+ */
+template <typename ElementType>
+class pinned_vector_policy {
+ public:
+  using element_type          = ElementType;
+  using container_type        = pinned_container<element_type>;
+  using pointer               = typename container_type::pointer;
+  using const_pointer         = typename container_type::const_pointer;
+  using reference             = element_type&;
+  using const_reference       = element_type const&;
+  using accessor_policy       = std::experimental::default_accessor<element_type>;
+  using const_accessor_policy = std::experimental::default_accessor<element_type const>;
+
+ public:
+  auto create(raft::resources const&, size_t n) -> container_type { return container_type(n); }
+
+  pinned_vector_policy() = default;
+
+  [[nodiscard]] auto access(container_type& c, size_t n) const noexcept -> reference
+  {
+    return c[n];
+  }
+  [[nodiscard]] auto access(container_type const& c, size_t n) const noexcept -> const_reference
+  {
+    return c[n];
+  }
+
+  [[nodiscard]] auto make_accessor_policy() noexcept { return accessor_policy{}; }
+  [[nodiscard]] auto make_accessor_policy() const noexcept { return const_accessor_policy{}; }
+};
+
+}  // namespace raft
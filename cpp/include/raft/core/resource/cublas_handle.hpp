@@ -18,6 +18,7 @@
 #include <cublas_v2.h>
 #include <raft/core/cublas_macros.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/detail/library_handle_pool.hpp>
 #include <raft/core/resource/resource_types.hpp>
 #include <raft/core/resources.hpp>
 
@@ -26,17 +27,20 @@ namespace raft::resource {
 class cublas_resource : public resource {
  public:
   cublas_resource(rmm::cuda_stream_view stream)
+    : cublas_res_([]() {
+        cublasHandle_t handle;
+        RAFT_CUBLAS_TRY_NO_THROW(cublasCreate(&handle));
+        return handle;
+      },
+      [](cublasHandle_t handle) { RAFT_CUBLAS_TRY_NO_THROW(cublasDestroy(handle)); })
   {
-    RAFT_CUBLAS_TRY_NO_THROW(cublasCreate(&cublas_res));
-    RAFT_CUBLAS_TRY_NO_THROW(cublasSetStream(cublas_res, stream));
+    RAFT_CUBLAS_TRY_NO_THROW(cublasSetStream(cublas_res_.get(), stream));
   }
 
-  ~cublas_resource() override { RAFT_CUBLAS_TRY_NO_THROW(cublasDestroy(cublas_res)); }
-
-  void* get_resource() override { return &cublas_res; }
+  void* get_resource() override { return &cublas_res_.get(); }
 
  private:
-  cublasHandle_t cublas_res;
+  detail::leased_handle<cublasHandle_t> cublas_res_;
 };
 
 /**
@@ -18,6 +18,7 @@
 #include "cuda_stream.hpp"
 #include <cusolverDn.h>
 #include <raft/core/cusolver_macros.hpp>
+#include <raft/core/resource/detail/library_handle_pool.hpp>
 #include <raft/core/resource/resource_types.hpp>
 #include <raft/core/resources.hpp>
 #include <rmm/cuda_stream_view.hpp>
@@ -30,17 +31,20 @@ namespace raft::resource {
 class cusolver_dn_resource : public resource {
  public:
   cusolver_dn_resource(rmm::cuda_stream_view stream)
+    : cusolver_res_([]() {
+        cusolverDnHandle_t handle;
+        RAFT_CUSOLVER_TRY_NO_THROW(cusolverDnCreate(&handle));
+        return handle;
+      },
+      [](cusolverDnHandle_t handle) { RAFT_CUSOLVER_TRY_NO_THROW(cusolverDnDestroy(handle)); })
   {
-    RAFT_CUSOLVER_TRY_NO_THROW(cusolverDnCreate(&cusolver_res));
-    RAFT_CUSOLVER_TRY_NO_THROW(cusolverDnSetStream(cusolver_res, stream));
+    RAFT_CUSOLVER_TRY_NO_THROW(cusolverDnSetStream(cusolver_res_.get(), stream));
   }
 
-  void* get_resource() override { return &cusolver_res; }
-
-  ~cusolver_dn_resource() override { RAFT_CUSOLVER_TRY_NO_THROW(cusolverDnDestroy(cusolver_res)); }
+  void* get_resource() override { return &cusolver_res_.get(); }
 
  private:
-  cusolverDnHandle_t cusolver_res;
+  detail::leased_handle<cusolverDnHandle_t> cusolver_res_;
 };
 
 /**
@@ -18,6 +18,7 @@
 #include <cusolverSp.h>
 #include <raft/core/cusolver_macros.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/detail/library_handle_pool.hpp>
 #include <raft/core/resource/resource_types.hpp>
 #include <raft/core/resources.hpp>
 
@@ -29,17 +30,20 @@ namespace raft::resource {
 class cusolver_sp_resource : public resource {
  public:
   cusolver_sp_resource(rmm::cuda_stream_view stream)
+    : cusolver_res_([]() {
+        cusolverSpHandle_t handle;
+        RAFT_CUSOLVER_TRY_NO_THROW(cusolverSpCreate(&handle));
+        return handle;
+      },
+      [](cusolverSpHandle_t handle) { RAFT_CUSOLVER_TRY_NO_THROW(cusolverSpDestroy(handle)); })
   {
-    RAFT_CUSOLVER_TRY_NO_THROW(cusolverSpCreate(&cusolver_res));
-    RAFT_CUSOLVER_TRY_NO_THROW(cusolverSpSetStream(cusolver_res, stream));
+    RAFT_CUSOLVER_TRY_NO_THROW(cusolverSpSetStream(cusolver_res_.get(), stream));
   }
 
-  void* get_resource() override { return &cusolver_res; }
-
-  ~cusolver_sp_resource() override { RAFT_CUSOLVER_TRY_NO_THROW(cusolverSpDestroy(cusolver_res)); }
+  void* get_resource() override { return &cusolver_res_.get(); }
 
  private:
-  cusolverSpHandle_t cusolver_res;
+  detail::leased_handle<cusolverSpHandle_t> cusolver_res_;
 };
 
 /**
@@ -18,6 +18,7 @@
 #include <cusparse_v2.h>
 #include <raft/core/cusparse_macros.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/detail/library_handle_pool.hpp>
 #include <raft/core/resource/resource_types.hpp>
 #include <raft/core/resources.hpp>
 
@@ -25,16 +26,20 @@ namespace raft::resource {
 class cusparse_resource : public resource {
  public:
   cusparse_resource(rmm::cuda_stream_view stream)
+    : cusparse_res_([]() {
+        cusparseHandle_t handle;
+        RAFT_CUSPARSE_TRY_NO_THROW(cusparseCreate(&handle));
+        return handle;
+      },
+      [](cusparseHandle_t handle) { RAFT_CUSPARSE_TRY_NO_THROW(cusparseDestroy(handle)); })
   {
-    RAFT_CUSPARSE_TRY_NO_THROW(cusparseCreate(&cusparse_res));
-    RAFT_CUSPARSE_TRY_NO_THROW(cusparseSetStream(cusparse_res, stream));
+    RAFT_CUSPARSE_TRY_NO_THROW(cusparseSetStream(cusparse_res_.get(), stream));
   }
 
-  ~cusparse_resource() { RAFT_CUSPARSE_TRY_NO_THROW(cusparseDestroy(cusparse_res)); }
-  void* get_resource() override { return &cusparse_res; }
+  void* get_resource() override { return &cusparse_res_.get(); }
 
  private:
-  cusparseHandle_t cusparse_res;
+  detail::leased_handle<cusparseHandle_t> cusparse_res_;
 };
 
 /**
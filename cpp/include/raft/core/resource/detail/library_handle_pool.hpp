@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cuda_runtime.h>
+#include <raft/util/cudart_utils.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace raft::resource::detail {
+
+/** Whether the library handles are taken from (and returned to) the process-wide pools. */
+struct library_handle_pool_state {
+  static inline std::atomic<bool> enabled_{false};
+};
+
+inline auto current_device() -> int
+{
+  int dev_id = -1;
+  RAFT_CUDA_TRY_NO_THROW(cudaGetDevice(&dev_id));
+  return dev_id;
+}
+
+/**
+ * @brief The process-wide pool of the idle handles of a library (e.g. `cublasHandle_t`), per
+ * device.
+ *
+ * A handle is leased to a single resource at a time, so that the handles are never shared by two
+ * streams concurrently. The pooled handles are never destroyed: destroying them at the exit of the
+ * process could happen after the CUDA context is gone.
+ *
+ * @tparam HandleT the type of the library handle
+ */
+template <typename HandleT>
+class library_handle_pool {
+ public:
+  /** Take an idle handle of the device, or create one with `create()` if there is none. */
+  template <typename CreateF>
+  static auto acquire(int dev_id, CreateF create) -> HandleT
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto& idle = idle_[dev_id];
+      if (!idle.empty()) {
+        auto handle = idle.back();
+        idle.pop_back();
+        return handle;
+      }
+    }
+    return create();
+  }
+
+  /** Return a handle of the device to the pool. */
+  static void release(int dev_id, HandleT handle)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    idle_[dev_id].push_back(handle);
+  }
+
+  /** Create handles of the device with `create()` until the pool has `n_handles` idle ones. */
+  template <typename CreateF>
+  static void reserve(int dev_id, size_t n_handles, CreateF create)
+  {
+    while (n_idle(dev_id) < n_handles) {
+      release(dev_id, create());
+    }
+  }
+
+  /** The number of the idle handles of the device. */
+  static auto n_idle(int dev_id) -> size_t
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return idle_[dev_id].size();
+  }
+
+ private:
+  static inline std::mutex mutex_;
+  static inline std::unordered_map<int, std::vector<HandleT>> idle_;
+};
+
+/**
+ * @brief A library handle owned by a resource: leased from the pool if the pools are enabled when
+ * it is created, otherwise created and destroyed with the resource.
+ */
+template <typename HandleT>
+class leased_handle {
+ public:
+  template <typename CreateF, typename DestroyF>
+  leased_handle(CreateF create, DestroyF destroy) : destroy_(destroy)
+  {
+    if (library_handle_pool_state::enabled_.load(std::memory_order_relaxed)) {
+      dev_id_ = current_device();
+      handle_ = library_handle_pool<HandleT>::acquire(dev_id_, create);
+    } else {
+      handle_ = create();
+    }
+  }
+  ~leased_handle()
+  {
+    if (dev_id_ >= 0) {
+      library_handle_pool<HandleT>::release(dev_id_, handle_);
+    } else {
+      destroy_(handle_);
+    }
+  }
+
+  leased_handle(const leased_handle&)                    = delete;
+  leased_handle(leased_handle&&)                         = delete;
+  auto operator=(const leased_handle&) -> leased_handle& = delete;
+  auto operator=(leased_handle&&) -> leased_handle&      = delete;
+
+  auto get() noexcept -> HandleT& { return handle_; }
+
+ private:
+  HandleT handle_;
+  void (*destroy_)(HandleT);
+  int dev_id_ = -1;  // the device of the pool the handle returns to, or -1 if not pooled
+};
+
+/**
+ * The properties of a device, queried once per process: `cudaGetDeviceProperties` is slow compared
+ * to the construction of a resources instance. A failed query is not cached.
+ */
+inline auto cached_device_properties(int dev_id) -> cudaDeviceProp
+{
+  static std::mutex mutex;
+  static std::unordered_map<int, cudaDeviceProp> props;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = props.find(dev_id);
+  if (it != props.end()) { return it->second; }
+  cudaDeviceProp prop{};
+  auto status = cudaGetDeviceProperties(&prop, dev_id);
+  if (status == cudaSuccess) {
+    props.emplace(dev_id, prop);
+  } else {
+    RAFT_CUDA_TRY_NO_THROW(status);
+  }
+  return prop;
+}
+
+}  // namespace raft::resource::detail
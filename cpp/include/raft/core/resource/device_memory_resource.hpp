@@ -15,11 +15,18 @@
  */
 #pragma once
 
+#include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resource/resource_types.hpp>
 #include <raft/core/resources.hpp>
+#include <raft/core/workspace_arena_resource.hpp>
+#include <raft/util/cuda_rt_essentials.hpp>
 #include <rmm/mr/device/device_memory_resource.hpp>
 #include <rmm/mr/device/per_device_resource.hpp>
 
+#include <cuda_runtime.h>
+
+#include <memory>
+
 namespace raft::resource {
 class device_memory_resource : public resource {
  public:
@@ -27,12 +34,18 @@ class device_memory_resource : public resource {
   {
     if (mr_ == nullptr) { mr = rmm::mr::get_current_device_resource(); }
   }
+  /** Hold the shared ownership of the memory resource (e.g. a workspace arena). */
+  device_memory_resource(std::shared_ptr<rmm::mr::device_memory_resource> owned_mr_)
+    : mr(owned_mr_.get()), owned_mr(std::move(owned_mr_))
+  {
+  }
   void* get_resource() override { return mr; }
 
   ~device_memory_resource() override {}
 
  private:
   rmm::mr::device_memory_resource* mr;
+  std::shared_ptr<rmm::mr::device_memory_resource> owned_mr;
 };
 
 /**
@@ -42,11 +55,20 @@ class device_memory_resource : public resource {
 class workspace_resource_factory : public resource_factory {
  public:
   workspace_resource_factory(rmm::mr::device_memory_resource* mr_ = nullptr) : mr(mr_) {}
+  workspace_resource_factory(std::shared_ptr<rmm::mr::device_memory_resource> owned_mr_)
+    : mr(owned_mr_.get()), owned_mr(std::move(owned_mr_))
+  {
+  }
   resource_type get_resource_type() override { return resource_type::WORKSPACE_RESOURCE; }
-  resource* make_resource() override { return new device_memory_resource(mr); }
+  resource* make_resource() override
+  {
+    if (owned_mr) { return new device_memory_resource(owned_mr); }
+    return new device_memory_resource(mr);
+  }
 
  private:
   rmm::mr::device_memory_resource* mr;
+  std::shared_ptr<rmm::mr::device_memory_resource> owned_mr;
 };
 
 /**
@@ -73,4 +95,67 @@ inline void set_workspace_resource(resources const& res, rmm::mr::device_memory_
 {
   res.add_resource_factory(std::make_shared<workspace_resource_factory>(mr));
 };
+
+/**
+ * Set a bounded workspace arena (`raft::workspace_arena_resource`) of `capacity` bytes as the temp
+ * workspace resource of a resources instance; the arena is owned by the resources instance.
+ *
+ * The allocations of the algorithms' temporaries then cost no call to the upstream resource, and
+ * exceeding the capacity throws `rmm::out_of_memory`. The algorithms read the remaining capacity
+ * with `get_workspace_free_bytes` to choose their batch sizes.
+ *
+ * @param res raft resources object for managing resources
+ * @param capacity the size of the arena, in bytes
+ * @param upstream the resource to take the arena from (the current device resource if null)
+ */
+inline void set_workspace_to_arena_resource(resources const& res,
+                                            size_t capacity,
+                                            rmm::mr::device_memory_resource* upstream = nullptr)
+{
+  auto arena =
+    std::make_shared<raft::workspace_arena_resource>(capacity, get_cuda_stream(res), upstream);
+  res.add_resource_factory(std::make_shared<workspace_resource_factory>(std::move(arena)));
+};
+
+/**
+ * Get the amount of the temp workspace memory available to the algorithms, in bytes.
+ *
+ * This is the remaining capacity of a workspace arena (see `set_workspace_to_arena_resource`);
+ * for any other workspace resource, it is the free memory reported by the resource, or else the
+ * free memory of the device.
+ *
+ * @param res raft resources object for managing resources
+ * @return the number of bytes the algorithms can allocate in the workspace
+ */
+inline auto get_workspace_free_bytes(resources const& res) -> size_t
+{
+  auto* mr = get_workspace_resource(res);
+  if (auto* arena = dynamic_cast<raft::workspace_arena_resource*>(mr)) {
+    return arena->free_bytes();
+  }
+  if (mr->supports_get_mem_info()) { return mr->get_mem_info(get_cuda_stream(res)).first; }
+  size_t free_bytes  = 0;
+  size_t total_bytes = 0;
+  RAFT_CUDA_TRY(cudaMemGetInfo(&free_bytes, &total_bytes));
+  return free_bytes;
+}
+
+/**
+ * Get the limit of the temp workspace memory, in bytes: the capacity of a workspace arena, or
+ * else the total memory reported by the resource or the device.
+ *
+ * @param res raft resources object for managing resources
+ */
+inline auto get_workspace_total_bytes(resources const& res) -> size_t
+{
+  auto* mr = get_workspace_resource(res);
+  if (auto* arena = dynamic_cast<raft::workspace_arena_resource*>(mr)) {
+    return arena->capacity();
+  }
+  if (mr->supports_get_mem_info()) { return mr->get_mem_info(get_cuda_stream(res)).second; }
+  size_t free_bytes  = 0;
+  size_t total_bytes = 0;
+  RAFT_CUDA_TRY(cudaMemGetInfo(&free_bytes, &total_bytes));
+  return total_bytes;
+}
 }  // namespace raft::resource
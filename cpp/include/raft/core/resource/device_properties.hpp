@@ -16,6 +16,7 @@
 #pragma once
 
 #include <cuda_runtime.h>
+#include <raft/core/resource/detail/library_handle_pool.hpp>
 #include <raft/core/resource/device_id.hpp>
 #include <raft/core/resource/resource_types.hpp>
 #include <raft/core/resources.hpp>
@@ -25,10 +26,7 @@ namespace raft::resource {
 
 class device_properties_resource : public resource {
  public:
-  device_properties_resource(int dev_id)
-  {
-    RAFT_CUDA_TRY_NO_THROW(cudaGetDeviceProperties(&prop_, dev_id));
-  }
+  device_properties_resource(int dev_id) : prop_(detail::cached_device_properties(dev_id)) {}
   void* get_resource() override { return &prop_; }
 
   ~device_properties_resource() override {}
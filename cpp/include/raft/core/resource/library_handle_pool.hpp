@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cublas_v2.h>
+#include <cuda_runtime.h>
+#include <cusolverDn.h>
+#include <cusolverSp.h>
+#include <cusparse_v2.h>
+#include <raft/core/cublas_macros.hpp>
+#include <raft/core/cusolver_macros.hpp>
+#include <raft/core/cusparse_macros.hpp>
+#include <raft/core/resource/detail/library_handle_pool.hpp>
+#include <raft/core/resource/device_id.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/util/cudart_utils.hpp>
+
+#include <cstddef>
+
+namespace raft::resource {
+
+/**
+ * @defgroup resource_library_handle_pool Library handle pool functions
+ * @{
+ */
+
+/**
+ * @brief Enable or disable the process-wide pools of the cuBLAS, cuSOLVER and cuSPARSE handles.
+ *
+ * When enabled, a resources instance takes its library handles from the pool of its device on
+ * their first use, instead of creating them (which costs milliseconds per handle), and returns
+ * them to the pool when it is destroyed. Every handle is used by one resources instance (and its
+ * shallow copies) at a time, with the stream of that instance. The pooled handles are kept until
+ * the end of the process.
+ *
+ * The setting applies to the handles created after the call.
+ */
+inline void enable_library_handle_pool(bool enabled = true)
+{
+  detail::library_handle_pool_state::enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+/** Whether the library handles are taken from the process-wide pools. */
+inline auto is_library_handle_pool_enabled() -> bool
+{
+  return detail::library_handle_pool_state::enabled_.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Prepare a device for a fast construction of the resources using it: create its CUDA
+ * context, cache its properties and precreate `n_handles` handles of every library in its pool.
+ *
+ * This enables the library handle pools (`enable_library_handle_pool`). Call it once per device at
+ * the startup of a process creating many resources instances, e.g. with the number of the threads
+ * using the device concurrently.
+ *
+ * @code{.cpp}
+ *   #include <raft/core/resource/library_handle_pool.hpp>
+ *   raft::resource::warm_up_library_handles(0, 4);
+ *   ...
+ *   raft::device_resources res;             // later, in any thread
+ *   auto h = res.get_cublas_handle();       // taken from the pool
+ * @endcode
+ *
+ * @param dev_id the device
+ * @param n_handles the number of idle handles of every library to keep in the pool of the device
+ */
+inline void warm_up_library_handles(int dev_id, size_t n_handles = 1)
+{
+  int prev_dev_id = detail::current_device();
+  RAFT_CUDA_TRY(cudaSetDevice(dev_id));
+  RAFT_CUDA_TRY(cudaFree(nullptr));
+  detail::cached_device_properties(dev_id);
+  detail::library_handle_pool<cublasHandle_t>::reserve(dev_id, n_handles, []() {
+    cublasHandle_t handle;
+    RAFT_CUBLAS_TRY(cublasCreate(&handle));
+    return handle;
+  });
+  detail::library_handle_pool<cusolverDnHandle_t>::reserve(dev_id, n_handles, []() {
+    cusolverDnHandle_t handle;
+    RAFT_CUSOLVER_TRY(cusolverDnCreate(&handle));
+    return handle;
+  });
+  detail::library_handle_pool<cusolverSpHandle_t>::reserve(dev_id, n_handles, []() {
+    cusolverSpHandle_t handle;
+    RAFT_CUSOLVER_TRY(cusolverSpCreate(&handle));
+    return handle;
+  });
+  detail::library_handle_pool<cusparseHandle_t>::reserve(dev_id, n_handles, []() {
+    cusparseHandle_t handle;
+    RAFT_CUSPARSE_TRY(cusparseCreate(&handle));
+    return handle;
+  });
+  enable_library_handle_pool(true);
+  if (prev_dev_id >= 0) { RAFT_CUDA_TRY(cudaSetDevice(prev_dev_id)); }
+}
+
+/** @copydoc warm_up_library_handles(int, size_t) */
+inline void warm_up_library_handles(resources const& res, size_t n_handles = 1)
+{
+  warm_up_library_handles(get_device_id(res), n_handles);
+}
+
+/**
+ * @}
+ */
+
+}  // namespace raft::resource
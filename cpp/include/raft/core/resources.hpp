@@ -53,14 +53,11 @@ class resources {
   using pair_resource    = pair_res<resource::resource>;
 
   resources()
-    : factories_(resource::resource_type::LAST_KEY), resources_(resource::resource_type::LAST_KEY)
+    : factories_(resource::resource_type::LAST_KEY,
+                 std::make_pair(resource::resource_type::LAST_KEY, empty_factory())),
+      resources_(resource::resource_type::LAST_KEY,
+                 std::make_pair(resource::resource_type::LAST_KEY, empty_resource()))
   {
-    for (int i = 0; i < resource::resource_type::LAST_KEY; ++i) {
-      factories_.at(i) = std::make_pair(resource::resource_type::LAST_KEY,
-                                        std::make_shared<resource::empty_resource_factory>());
-      resources_.at(i) = std::make_pair(resource::resource_type::LAST_KEY,
-                                        std::make_shared<resource::empty_resource>());
-    }
   }
 
   /**
@@ -95,6 +92,10 @@ class resources {
     RAFT_EXPECTS(rtype != resource::resource_type::LAST_KEY,
                  "LAST_KEY is a placeholder and not a valid resource factory type.");
     factories_.at(rtype) = std::make_pair(rtype, factory);
+
+    // Drop the resource made by the replaced factory, so that the next `get_resource` uses the new
+    // factory (e.g. the stream set on a shallow copy is not shadowed by the stream of the original)
+    resources_.at(rtype) = std::make_pair(resource::resource_type::LAST_KEY, empty_resource());
   }
 
   /**
@@ -125,6 +126,21 @@ class resources {
   }
 
  protected:
+  // The placeholders of the empty slots are shared by all the instances (they hold no state), so
+  // that constructing a resources instance allocates only its two vectors.
+  static auto empty_factory() -> const std::shared_ptr<resource::resource_factory>&
+  {
+    static const std::shared_ptr<resource::resource_factory> factory =
+      std::make_shared<resource::empty_resource_factory>();
+    return factory;
+  }
+  static auto empty_resource() -> const std::shared_ptr<resource::resource>&
+  {
+    static const std::shared_ptr<resource::resource> res =
+      std::make_shared<resource::empty_resource>();
+    return res;
+  }
+
   mutable std::mutex mutex_;
   mutable std::vector<pair_res_factory> factories_;
   mutable std::vector<pair_resource> resources_;
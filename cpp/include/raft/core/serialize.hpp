@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <raft/core/detail/mdspan_device_serializer.hpp>
 #include <raft/core/detail/mdspan_numpy_serializer.hpp>
 #include <raft/core/device_mdspan.hpp>
 #include <raft/core/host_mdspan.hpp>
@@ -49,19 +50,12 @@ inline void serialize_mdspan(
   static_assert(std::is_same_v<LayoutPolicy, raft::layout_c_contiguous> ||
                   std::is_same_v<LayoutPolicy, raft::layout_f_contiguous>,
                 "The serializer only supports row-major and column-major layouts");
-  using obj_t = raft::device_mdspan<ElementType, Extents, LayoutPolicy, AccessorPolicy>;
-
-  // Copy to host before serializing
-  // For contiguous layouts, size() == product of dimensions
-  std::vector<typename obj_t::value_type> tmp(obj.size());
-  cudaStream_t stream = resource::get_cuda_stream(handle);
-  raft::update_host(tmp.data(), obj.data_handle(), obj.size(), stream);
-  resource::sync_stream(handle);
-  using inner_accessor_type = typename obj_t::accessor_type::accessor_type;
-  auto tmp_mdspan =
-    raft::host_mdspan<ElementType, Extents, LayoutPolicy, raft::host_accessor<inner_accessor_type>>(
-      tmp.data(), obj.extents());
-  detail::numpy_serializer::serialize_host_mdspan(os, tmp_mdspan);
+  detail::numpy_serializer::write_header(
+    os, detail::numpy_serializer::make_mdspan_header<ElementType, LayoutPolicy>(obj.extents()));
+  // Stream the content from the device through pinned buffers, without a host copy of the whole
+  // array. For contiguous layouts, size() == product of dimensions
+  detail::write_device_rows(
+    handle, os, obj.data_handle(), sizeof(ElementType), obj.size(), sizeof(ElementType));
 }
 
 template <typename ElementType, typename Extents, typename LayoutPolicy, typename AccessorPolicy>
@@ -96,20 +90,17 @@ inline void deserialize_mdspan(
   static_assert(std::is_same_v<LayoutPolicy, raft::layout_c_contiguous> ||
                   std::is_same_v<LayoutPolicy, raft::layout_f_contiguous>,
                 "The serializer only supports row-major and column-major layouts");
-  using obj_t = raft::device_mdspan<ElementType, Extents, LayoutPolicy, AccessorPolicy>;
-
-  // Copy to device after serializing
-  // For contiguous layouts, size() == product of dimensions
-  std::vector<typename obj_t::value_type> tmp(obj.size());
-  using inner_accessor_type = typename obj_t::accessor_type::accessor_type;
-  auto tmp_mdspan =
-    raft::host_mdspan<ElementType, Extents, LayoutPolicy, raft::host_accessor<inner_accessor_type>>(
-      tmp.data(), obj.extents());
-  detail::numpy_serializer::deserialize_host_mdspan(is, tmp_mdspan);
-
-  cudaStream_t stream = resource::get_cuda_stream(handle);
-  raft::update_device(obj.data_handle(), tmp.data(), obj.size(), stream);
-  resource::sync_stream(handle);
+  detail::numpy_serializer::check_mdspan_header<ElementType, LayoutPolicy>(is, obj.extents());
+  // Read the content straight into the device memory, chunk by chunk
+  detail::read_device_rows(handle,
+                           obj.data_handle(),
+                           sizeof(ElementType),
+                           obj.size(),
+                           sizeof(ElementType),
+                           [&is](char* dst, size_t n_bytes) {
+                             is.read(dst, n_bytes);
+                             RAFT_EXPECTS(is.good(), "Error while reading mdspan content");
+                           });
 }
 
 template <typename ElementType, typename Extents, typename LayoutPolicy, typename AccessorPolicy>
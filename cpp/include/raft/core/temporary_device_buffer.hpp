@@ -18,7 +18,9 @@
 
 #include "device_mdarray.hpp"
 #include "device_mdspan.hpp"
+#include <raft/core/memory_type.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_id.hpp>
 
 #include <raft/util/cudart_utils.hpp>
 
@@ -36,6 +38,14 @@ namespace raft {
  * pointer. This object provides a `view()` method that will provide a `raft::device_mdspan` that
  * may be read-only depending on const-qualified nature of the input pointer.
  *
+ * The input is used in place (zero-copy) when the device can read it efficiently:
+ *   - device memory;
+ *   - managed memory, which is prefetched to the device in the stream of the handle if it is large
+ *     and the device supports the concurrent managed access;
+ *   - pinned and pageable host memory on the systems where the device accesses the host memory
+ *     through the host page tables (e.g. Grace-Hopper, see `raft::device_reads_pageable_memory`).
+ * Otherwise, the input is copied to a device buffer (and back with `write_back`).
+ *
  * @tparam ElementType type of the input
  * @tparam Extents raft::extents
  * @tparam LayoutPolicy layout of the input
@@ -69,7 +79,7 @@ class temporary_device_buffer {
    * @param data input pointer
    * @param extents dimensions of input array
    * @param write_back if true, any writes to the `view()` of this object will be copid
-   *                   back if the original pointer was in host memory
+   *                   back if the input was copied to the device (`is_copy()`)
    */
   temporary_device_buffer(resources const& handle,
                           ElementType* data,
@@ -86,9 +96,9 @@ class temporary_device_buffer {
         }
         return length;
       }()),
-      device_id_{get_device_for_address(data)}
+      copied_{!is_zero_copy(handle, data)}
   {
-    if (device_id_ == -1) {
+    if (copied_) {
       typename owning_device_buffer::mapping_type layout{extents_};
       typename owning_device_buffer::container_policy_type policy{};
 
@@ -100,13 +110,16 @@ class temporary_device_buffer {
     }
   }
 
+  /** Whether the `view()` refers to a device copy of the input, rather than the input itself. */
+  [[nodiscard]] auto is_copy() const noexcept -> bool { return copied_; }
+
   ~temporary_device_buffer() noexcept(is_const_pointer_)
   {
     // only need to write data back for non const pointers
     // when write_back=true and original pointer is in
     // host memory
     if constexpr (not is_const_pointer_) {
-      if (write_back_ && device_id_ == -1) {
+      if (write_back_ && copied_) {
         raft::copy(original_data_, std::get<1>(data_).data_handle(), length_, stream_);
       }
     }
@@ -119,7 +132,7 @@ class temporary_device_buffer {
    */
   auto view() -> view_type
   {
-    if (device_id_ == -1) {
+    if (copied_) {
       return std::get<1>(data_).view();
     } else {
       return make_mdspan<ElementType, index_type, LayoutPolicy, false, true>(original_data_,
@@ -134,7 +147,29 @@ class temporary_device_buffer {
   Extents extents_;
   bool write_back_;
   std::size_t length_;
-  int device_id_;
+  bool copied_;
+
+  /** The managed inputs at least this large are prefetched to the device. */
+  static constexpr std::size_t kPrefetchMinBytes = std::size_t{1} << 20;
+
+  auto is_zero_copy(resources const& handle, ElementType* data) const -> bool
+  {
+    switch (memory_type_from_pointer(data)) {
+      case memory_type::device: return true;
+      case memory_type::managed: {
+        int device_id        = resource::get_device_id(handle);
+        int concurrent_state = 0;
+        RAFT_CUDA_TRY(
+          cudaDeviceGetAttribute(&concurrent_state, cudaDevAttrConcurrentManagedAccess, device_id));
+        if (concurrent_state != 0 && length_ * sizeof(element_type) >= kPrefetchMinBytes) {
+          RAFT_CUDA_TRY(
+            cudaMemPrefetchAsync(data, length_ * sizeof(element_type), device_id, stream_));
+        }
+        return true;
+      }
+      default: return device_reads_pageable_memory(resource::get_device_id(handle));
+    }
+  }
 };
 
 /**
@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/core/metrics.hpp>
+#include <raft/util/cuda_rt_essentials.hpp>
+
+#include <rmm/cuda_stream_view.hpp>
+#include <rmm/detail/error.hpp>
+#include <rmm/mr/device/device_memory_resource.hpp>
+#include <rmm/mr/device/per_device_resource.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace raft {
+
+/**
+ * @brief A fixed-capacity, stream-ordered stack arena for the temporary workspace of algorithms.
+ *
+ * The arena takes a single block of `capacity` bytes from the upstream resource at construction
+ * and serves the allocations from it by bumping an offset: an allocation is a couple of integer
+ * operations, without any call to the upstream resource. The deallocation pops the allocation
+ * from the top of the stack; an allocation freed out of order is reclaimed when all the
+ * allocations above it are freed. Since the temporaries of an algorithm are usually freed in the
+ * reverse order of their allocation, the whole capacity is available again after every call.
+ *
+ * An allocation exceeding the remaining capacity throws `rmm::out_of_memory`, rather than
+ * silently growing the memory footprint; the algorithms can query `free_bytes()` (see
+ * `raft::resource::get_workspace_free_bytes`) to choose their batch sizes within the limit.
+ *
+ * The memory is reused in the stream order: the memory freed on a stream is reused at once by
+ * the allocations on the same stream, whereas an allocation on another stream first waits for
+ * the work of the freeing stream to finish.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   raft::device_resources res;
+ *   // limit the temporaries of the algorithms called with `res` to 1 GiB
+ *   raft::resource::set_workspace_to_arena_resource(res, size_t{1} << 30);
+ *   raft::neighbors::ivf_pq::search(res, search_params, index, queries, neighbors, distances);
+ * @endcode
+ */
+class workspace_arena_resource final : public rmm::mr::device_memory_resource {
+ public:
+  /** Alignment of the allocations, in bytes (same as the other RMM resources). */
+  static constexpr size_t kAlignment = 256;
+
+  /**
+   * @param capacity the size of the arena, in bytes (rounded up to the alignment)
+   * @param stream the stream on which the arena block is allocated and finally released (the
+   *   default stream if not given)
+   * @param upstream the resource to take the arena block from (the current device resource if
+   *   null); it must outlive the arena
+   */
+  explicit workspace_arena_resource(size_t capacity,
+                                    rmm::cuda_stream_view stream              = {},
+                                    rmm::mr::device_memory_resource* upstream = nullptr)
+    : upstream_(upstream == nullptr ? rmm::mr::get_current_device_resource() : upstream),
+      capacity_(align_up(capacity)),
+      stream_(stream)
+  {
+    if (capacity_ > 0) { base_ = static_cast<char*>(upstream_->allocate(capacity_, stream_)); }
+  }
+
+  workspace_arena_resource(const workspace_arena_resource&)                    = delete;
+  workspace_arena_resource(workspace_arena_resource&&)                         = delete;
+  auto operator=(const workspace_arena_resource&) -> workspace_arena_resource& = delete;
+  auto operator=(workspace_arena_resource&&) -> workspace_arena_resource&      = delete;
+
+  ~workspace_arena_resource() override
+  {
+    if (base_ == nullptr) { return; }
+    // the allocations freed on other streams may still be in use there
+    sync_pending_streams(stream_);
+    upstream_->deallocate(base_, capacity_, stream_);
+  }
+
+  /** The size of the arena, in bytes. */
+  [[nodiscard]] auto capacity() const noexcept -> size_t { return capacity_; }
+  /** The size of the largest allocation the arena can serve now, in bytes. */
+  [[nodiscard]] auto free_bytes() const -> size_t
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return capacity_ - top_;
+  }
+  /** The upper bound of the memory in use reached so far, in bytes. */
+  [[nodiscard]] auto peak_bytes() const -> size_t
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return peak_;
+  }
+
+  [[nodiscard]] auto supports_streams() const noexcept -> bool override { return true; }
+  [[nodiscard]] auto supports_get_mem_info() const noexcept -> bool override { return true; }
+
+ private:
+  struct block {
+    size_t offset;
+    size_t size;
+    bool freed;
+    rmm::cuda_stream_view stream;
+  };
+
+  static constexpr auto align_up(size_t bytes) noexcept -> size_t
+  {
+    return (bytes + kAlignment - 1) / kAlignment * kAlignment;
+  }
+
+  auto do_allocate(size_t bytes, rmm::cuda_stream_view stream) -> void* override
+  {
+    const size_t size = align_up(bytes);
+    if (size == 0) { return nullptr; }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (size > capacity_ - top_) {
+      throw rmm::out_of_memory("raft::workspace_arena_resource: cannot allocate " +
+                               std::to_string(bytes) + " bytes, only " +
+                               std::to_string(capacity_ - top_) + " of " +
+                               std::to_string(capacity_) + " bytes are free");
+    }
+    sync_pending_streams(stream);
+    raft::metrics::record(
+      "workspace_arena::allocated_bytes", raft::metrics::metric_kind::bytes, size);
+    blocks_.push_back(block{top_, size, false, stream});
+    void* ptr = base_ + top_;
+    top_ += size;
+    peak_ = std::max(peak_, top_);
+    return ptr;
+  }
+
+  void do_deallocate(void* ptr, size_t, rmm::cuda_stream_view stream) override
+  {
+    if (ptr == nullptr) { return; }
+    const size_t offset = static_cast<char*>(ptr) - base_;
+    std::lock_guard<std::mutex> lock(mutex_);
+    // the freed block is almost always at (or near) the top of the stack
+    for (auto it = blocks_.rbegin(); it != blocks_.rend(); ++it) {
+      if (it->offset == offset) {
+        it->freed  = true;
+        it->stream = stream;
+        break;
+      }
+    }
+    while (!blocks_.empty() && blocks_.back().freed) {
+      top_ = blocks_.back().offset;
+      add_pending_stream(blocks_.back().stream);
+      blocks_.pop_back();
+    }
+  }
+
+  [[nodiscard]] auto do_get_mem_info(rmm::cuda_stream_view) const
+    -> std::pair<size_t, size_t> override
+  {
+    return {free_bytes(), capacity_};
+  }
+
+  /** Remember a stream whose released memory must not be reused before its work completes. */
+  void add_pending_stream(rmm::cuda_stream_view stream)
+  {
+    for (auto s : pending_streams_) {
+      if (s.value() == stream.value()) { return; }
+    }
+    pending_streams_.push_back(stream);
+  }
+
+  /**
+   * Wait for the pending streams before reusing their memory on `stream`; the work on `stream`
+   * itself is ordered anyway, so this stream stays pending for the other streams.
+   */
+  void sync_pending_streams(rmm::cuda_stream_view stream)
+  {
+    bool keep = false;
+    for (auto s : pending_streams_) {
+      if (s.value() == stream.value()) {
+        keep = true;
+      } else {
+        RAFT_CUDA_TRY(cudaStreamSynchronize(s));
+      }
+    }
+    pending_streams_.clear();
+    if (keep) { pending_streams_.push_back(stream); }
+  }
+
+  rmm::mr::device_memory_resource* upstream_;
+  size_t capacity_;
+  rmm::cuda_stream_view stream_;
+  char* base_ = nullptr;
+
+  mutable std::mutex mutex_;
+  size_t top_  = 0;
+  size_t peak_ = 0;
+  std::vector<block> blocks_;
+  std::vector<rmm::cuda_stream_view> pending_streams_;
+};
+
+}  // namespace raft
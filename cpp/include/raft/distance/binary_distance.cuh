@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/detail/binary_distance.cuh>
+#include <raft/distance/distance_types.hpp>
+
+namespace raft::distance {
+
+/**
+ * @defgroup binary_distance Pairwise distance of bit-packed vectors
+ * @{
+ */
+
+/**
+ * @brief Compute the pairwise distances of binary vectors packed into words
+ *
+ * Every row of x and y is a binary vector (e.g. a hash code) of `n_bits` bits, packed into
+ * `x.extent(1)` words of 32 or 64 bits; the unused bits of the last word must be zero. The
+ * distances are computed with the popcounts of the words, hence the inputs take 32x less memory
+ * than the per-element inputs of raft::distance::pairwise_distance.
+ *
+ * The supported metrics are
+ *  - HammingUnexpanded: the fraction of the bits that differ, `popc(x ^ y) / n_bits`;
+ *  - JaccardExpanded: `1 - popc(x & y) / popc(x | y)`, zero when both vectors are empty.
+ *
+ * The distances can be passed to raft::matrix::select_k to find the nearest neighbors.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   #include <raft/distance/binary_distance.cuh>
+ *
+ *   // 256-bit codes
+ *   auto x    = raft::make_device_matrix<uint64_t, int>(handle, m, 4);
+ *   auto y    = raft::make_device_matrix<uint64_t, int>(handle, n, 4);
+ *   auto dist = raft::make_device_matrix<float, int>(handle, m, n);
+ *   ...
+ *   raft::distance::binary_pairwise_distance(handle,
+ *                                            raft::make_const_mdspan(x.view()),
+ *                                            raft::make_const_mdspan(y.view()),
+ *                                            dist.view(),
+ *                                            raft::distance::DistanceType::HammingUnexpanded);
+ * @endcode
+ *
+ * @tparam BitsT the word type: uint32_t or uint64_t
+ * @tparam IdxT indexing type
+ *
+ * @param[in] handle raft handle for managing expensive resources
+ * @param[in] x first matrix of the packed vectors (size m x n_words)
+ * @param[in] y second matrix of the packed vectors (size n x n_words)
+ * @param[out] dist the distances (size m x n)
+ * @param[in] metric distance metric: HammingUnexpanded or JaccardExpanded
+ * @param[in] n_bits the number of bits of the vectors; zero for all the bits of the words
+ */
+template <typename BitsT, typename IdxT>
+void binary_pairwise_distance(raft::resources const& handle,
+                              device_matrix_view<const BitsT, IdxT, row_major> x,
+                              device_matrix_view<const BitsT, IdxT, row_major> y,
+                              device_matrix_view<float, IdxT, row_major> dist,
+                              raft::distance::DistanceType metric,
+                              IdxT n_bits = 0)
+{
+  detail::binary_pairwise_distance(handle, x, y, dist, metric, n_bits);
+}
+
+/** @} */
+
+}  // namespace raft::distance
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdspan.hpp>         // raft::device_matrix_view
+#include <raft/core/error.hpp>                 // RAFT_EXPECTS
+#include <raft/core/nvtx.hpp>                  // common::nvtx::range
+#include <raft/core/resource/cuda_stream.hpp>  // get_cuda_stream
+#include <raft/core/resources.hpp>             // raft::resources
+#include <raft/distance/distance_types.hpp>    // DistanceType
+#include <raft/util/cuda_dev_essentials.cuh>   // DI
+#include <raft/util/cuda_rt_essentials.hpp>    // RAFT_CUDA_TRY
+#include <raft/util/cuda_utils.cuh>            // raft::ceildiv
+
+#include <cstdint>      // uint32_t, uint64_t
+#include <type_traits>  // std::is_same_v
+
+namespace raft::distance::detail {
+
+DI int popc(uint32_t v) { return __popc(v); }
+DI int popc(uint64_t v) { return __popcll(v); }
+
+/**
+ * The distances of bit-packed vectors: every thread block computes a kTile x kTile tile of the
+ * distance matrix, staging kTile words of kTile rows of x and y in shared memory at a time. Every
+ * thread accumulates the popcounts of kTile / kRowsPerPass rows and one column of the tile.
+ *
+ * For the Hamming distance, `d = popc(x ^ y) / n_bits`; for the Jaccard distance,
+ * `d = 1 - popc(x & y) / popc(x | y)` (zero when both vectors are empty).
+ */
+template <bool Jaccard, typename BitsT, typename IdxT, int kTile, int kRowsPerPass>
+__global__ void __launch_bounds__(kTile* kRowsPerPass)
+  binary_distance_kernel(const BitsT* x,
+                         const BitsT* y,
+                         float* dist,
+                         IdxT m,
+                         IdxT n,
+                         IdxT n_words,
+                         float one_over_bits)
+{
+  constexpr int kRowsPerTh = kTile / kRowsPerPass;
+  // padded to avoid the bank conflicts of reading the columns of the tiles
+  __shared__ BitsT sx[kTile][kTile + 1];
+  __shared__ BitsT sy[kTile][kTile + 1];
+
+  const IdxT row0 = IdxT(blockIdx.y) * kTile;
+  const IdxT col0 = IdxT(blockIdx.x) * kTile;
+  const int tx    = threadIdx.x;
+  const int ty    = threadIdx.y;
+
+  int inter[kRowsPerTh] = {0};
+  int uni[kRowsPerTh]   = {0};
+  for (IdxT w0 = 0; w0 < n_words; w0 += kTile) {
+    const IdxT w    = w0 + tx;
+    const bool w_ok = w < n_words;
+#pragma unroll
+    for (int r = ty; r < kTile; r += kRowsPerPass) {
+      sx[r][tx] = (w_ok && row0 + r < m) ? x[size_t(row0 + r) * n_words + w] : BitsT(0);
+      sy[r][tx] = (w_ok && col0 + r < n) ? y[size_t(col0 + r) * n_words + w] : BitsT(0);
+    }
+    __syncthreads();
+#pragma unroll 8
+    for (int l = 0; l < kTile; l++) {
+      const BitsT b = sy[tx][l];
+#pragma unroll
+      for (int i = 0; i < kRowsPerTh; i++) {
+        const BitsT a = sx[ty + i * kRowsPerPass][l];
+        if constexpr (Jaccard) {
+          inter[i] += popc(BitsT(a & b));
+          uni[i] += popc(BitsT(a | b));
+        } else {
+          inter[i] += popc(BitsT(a ^ b));
+        }
+      }
+    }
+    __syncthreads();
+  }
+
+  const IdxT col = col0 + tx;
+  if (col >= n) { return; }
+#pragma unroll
+  for (int i = 0; i < kRowsPerTh; i++) {
+    const IdxT row = row0 + ty + i * kRowsPerPass;
+    if (row < m) {
+      float d;
+      if constexpr (Jaccard) {
+        d = uni[i] == 0 ? 0.0f : 1.0f - float(inter[i]) / float(uni[i]);
+      } else {
+        d = float(inter[i]) * one_over_bits;
+      }
+      dist[size_t(row) * n + col] = d;
+    }
+  }
+}
+
+template <typename BitsT, typename IdxT>
+void binary_pairwise_distance(raft::resources const& handle,
+                              raft::device_matrix_view<const BitsT, IdxT, row_major> x,
+                              raft::device_matrix_view<const BitsT, IdxT, row_major> y,
+                              raft::device_matrix_view<float, IdxT, row_major> dist,
+                              DistanceType metric,
+                              IdxT n_bits)
+{
+  static_assert(std::is_same_v<BitsT, uint32_t> || std::is_same_v<BitsT, uint64_t>,
+                "The bits must be packed into uint32_t or uint64_t words.");
+  constexpr int kTile        = 32;
+  constexpr int kRowsPerPass = 8;
+
+  const IdxT m       = x.extent(0);
+  const IdxT n       = y.extent(0);
+  const IdxT n_words = x.extent(1);
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "binary_pairwise_distance(%zu, %zu, %zu)", size_t(m), size_t(n), size_t(n_words));
+  RAFT_EXPECTS(y.extent(1) == n_words, "Number of words must be equal.");
+  RAFT_EXPECTS(dist.extent(0) == m && dist.extent(1) == n, "Incompatible output shape");
+  if (n_bits == 0) { n_bits = n_words * IdxT(8 * sizeof(BitsT)); }
+  RAFT_EXPECTS(n_bits > 0 && n_bits <= n_words * IdxT(8 * sizeof(BitsT)),
+               "Number of bits must be positive and fit into the words.");
+  if (m == 0 || n == 0) { return; }
+
+  auto stream = resource::get_cuda_stream(handle);
+  dim3 block(kTile, kRowsPerPass);
+  dim3 grid(raft::ceildiv<IdxT>(n, kTile), raft::ceildiv<IdxT>(m, kTile));
+  const float one_over_bits = 1.0f / float(n_bits);
+  switch (metric) {
+    case DistanceType::HammingUnexpanded:
+      binary_distance_kernel<false, BitsT, IdxT, kTile, kRowsPerPass><<<grid, block, 0, stream>>>(
+        x.data_handle(), y.data_handle(), dist.data_handle(), m, n, n_words, one_over_bits);
+      break;
+    case DistanceType::JaccardExpanded:
+      binary_distance_kernel<true, BitsT, IdxT, kTile, kRowsPerPass><<<grid, block, 0, stream>>>(
+        x.data_handle(), y.data_handle(), dist.data_handle(), m, n, n_words, one_over_bits);
+      break;
+    default: RAFT_FAIL("Unsupported metric for the binary distance: %d", int(metric));
+  }
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+}  // namespace raft::distance::detail
@@ -340,19 +340,53 @@ void distance_impl(raft::resources const& handle,
                    IdxT m,
                    IdxT n,
                    IdxT k,
-                   AccT*,   // workspace unused
-                   size_t,  // worksize unused
+                   AccT* workspace,
+                   size_t worksize,
                    FinOpT fin_op,
                    bool is_row_major,
                    DataT)  // metric_arg unused
 {
-  ops::jensen_shannon_distance_op<DataT, AccT, IdxT> distance_op{};
-
-  const DataT* x_norm = nullptr;
-  const DataT* y_norm = nullptr;
+  ASSERT(!(worksize < (m + n) * sizeof(AccT)), "workspace size error");
+  ASSERT(workspace != nullptr, "workspace is null");
 
   cudaStream_t stream = raft::resource::get_cuda_stream(handle);
 
+  // The norms cancel against the mixture term for x == y, which leaves a rounding error that the
+  // sqrt amplifies. The unexpanded op keeps the self-distances exactly zero.
+  if (x == y) {
+    ops::jensen_shannon_distance_op<DataT, AccT, IdxT> distance_op{};
+    pairwise_matrix_dispatch<decltype(distance_op), DataT, AccT, OutT, FinOpT, IdxT>(
+      distance_op, m, n, k, x, y, nullptr, nullptr, out, fin_op, stream, is_row_major);
+    return;
+  }
+
+  // The norms are the sums of x * log(x) over the rows
+  DataT* x_norm = workspace;
+  DataT* y_norm = workspace + m;
+  raft::linalg::reduce(x_norm,
+                       x,
+                       k,
+                       m,
+                       (AccT)0,
+                       is_row_major,
+                       true,
+                       stream,
+                       false,
+                       ops::x_log_x_op{},
+                       raft::add_op());
+  raft::linalg::reduce(y_norm,
+                       y,
+                       k,
+                       n,
+                       (AccT)0,
+                       is_row_major,
+                       true,
+                       stream,
+                       false,
+                       ops::x_log_x_op{},
+                       raft::add_op());
+
+  ops::jensen_shannon_exp_distance_op<DataT, AccT, IdxT> distance_op{};
   pairwise_matrix_dispatch<decltype(distance_op), DataT, AccT, OutT, FinOpT, IdxT>(
     distance_op, m, n, k, x, y, x_norm, y_norm, out, fin_op, stream, is_row_major);
 }
@@ -366,12 +400,17 @@ void distance_impl(raft::resources const& handle,
                    IdxT m,
                    IdxT n,
                    IdxT k,
-                   AccT*,   // workspace unused
-                   size_t,  // worksize unused
+                   AccT* workspace,
+                   size_t worksize,
                    FinOpT fin_op,
                    bool is_row_major,
                    DataT)  // metric_arg unused
 {
+  // When x equals y, log(y) is written to the workspace rather than over y
+  const size_t log_y_size = x == y ? size_t(n) * size_t(k) : 0;
+  ASSERT(!(worksize < ((m + n) + log_y_size) * sizeof(AccT)), "workspace size error");
+  ASSERT(workspace != nullptr, "workspace is null");
+
   cudaStream_t stream = raft::resource::get_cuda_stream(handle);
 
   auto unaryOp_lambda = [] __device__(DataT input) {
@@ -385,20 +424,37 @@ void distance_impl(raft::resources const& handle,
     return (!x_zero) * raft::exp(input);
   };
 
-  if (x != y) {
+  // The norms of x are the sums of x * log(x) over the rows; the norms of y are not used.
+  DataT* x_norm = workspace;
+  DataT* y_norm = workspace + m;
+  raft::linalg::reduce(x_norm,
+                       x,
+                       k,
+                       m,
+                       (AccT)0,
+                       is_row_major,
+                       true,
+                       stream,
+                       false,
+                       ops::x_log_x_op{},
+                       raft::add_op());
+  RAFT_CUDA_TRY(cudaMemsetAsync(y_norm, 0, n * sizeof(DataT), stream));
+
+  const DataT* log_y = y;
+  if (x == y) {
+    DataT* log_y_buf = workspace + m + n;
+    raft::linalg::unaryOp<DataT, decltype(unaryOp_lambda), IdxT>(
+      log_y_buf, y, n * k, unaryOp_lambda, stream);
+    log_y = log_y_buf;
+  } else {
     raft::linalg::unaryOp<DataT, decltype(unaryOp_lambda), IdxT>(
       (DataT*)y, y, n * k, unaryOp_lambda, stream);
   }
 
-  const DataT* x_norm = nullptr;
-  const DataT* y_norm = nullptr;
-
-  // This op takes some shortcuts when x equals y. So its behavior changes based
-  // on this.
-  ops::kl_divergence_op<DataT, AccT, IdxT> distance_op{is_row_major, x == y};
+  ops::kl_divergence_exp_op<DataT, AccT, IdxT> distance_op{is_row_major};
 
   pairwise_matrix_dispatch<decltype(distance_op), DataT, AccT, OutT, FinOpT, IdxT>(
-    distance_op, m, n, k, x, y, x_norm, y_norm, out, fin_op, stream, is_row_major);
+    distance_op, m, n, k, x, log_y, x_norm, y_norm, out, fin_op, stream, is_row_major);
 
   if (x != y) {
     // Now reverse previous log (x) back to x using (e ^ log(x))
@@ -794,8 +850,11 @@ template <raft::distance::DistanceType distanceType,
 size_t getWorkspaceSize(const InType* x, const InType* y, Index_ m, Index_ n, Index_ k)
 {
   size_t worksize             = 0;
-  constexpr bool is_allocated = (distanceType <= raft::distance::DistanceType::CosineExpanded) ||
-                                (distanceType == raft::distance::DistanceType::CorrelationExpanded);
+  constexpr bool is_allocated =
+    (distanceType <= raft::distance::DistanceType::CosineExpanded) ||
+    (distanceType == raft::distance::DistanceType::CorrelationExpanded) ||
+    (distanceType == raft::distance::DistanceType::JensenShannon) ||
+    (distanceType == raft::distance::DistanceType::KLDivergence);
   constexpr int numOfBuffers =
     (distanceType == raft::distance::DistanceType::CorrelationExpanded) ? 2 : 1;
 
@@ -805,6 +864,10 @@ size_t getWorkspaceSize(const InType* x, const InType* y, Index_ m, Index_ n, In
     worksize += numOfBuffers * m * sizeof(AccType);
     worksize += numOfBuffers * n * sizeof(AccType);
   }
+  // The KL divergence of a matrix to itself keeps log(y) in the workspace
+  if (distanceType == raft::distance::DistanceType::KLDivergence && x == y) {
+    worksize += size_t(n) * size_t(k) * sizeof(AccType);
+  }
 
   return worksize;
 }
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/util/cuda_dev_essentials.cuh>  // DI
+
+namespace raft::distance::detail::ops {
+
+// Epilogue operator for CUTLASS based kernel
+template <typename DataT, typename AccT>
+struct neg_inner_product_cutlass_op {
+  __device__ neg_inner_product_cutlass_op() noexcept {}
+  __device__ AccT operator()(DataT& aNorm, const DataT& bNorm, DataT& accVal) const noexcept
+  {
+    return -static_cast<AccT>(accVal);
+  }
+  __device__ AccT operator()(DataT aData) const noexcept { return aData; }
+};
+
+/**
+ * @brief the negated inner product
+ *
+ * It computes the following equation:
+ *
+ * d(x, y) = - x ⋅ y
+ *
+ * The inner product is a similarity; negating it makes the nearest neighbor (the largest inner
+ * product) the minimum, as expected by the fused nearest neighbor kernels.
+ */
+template <typename DataType, typename AccType, typename IdxType>
+struct neg_inner_product_distance_op {
+  using DataT = DataType;
+  using AccT  = AccType;
+  using IdxT  = IdxType;
+
+  // Load norms of input data
+  static constexpr bool use_norms = false;
+  // Whether the core function requires so many instructions that it makes sense
+  // to reduce loop unrolling, etc. We do this to keep compile times in check.
+  static constexpr bool expensive_inner_loop = false;
+
+  // Size of shared memory. This is normally decided by the kernel policy, but
+  // some ops such as correlation_distance_op use more.
+  template <typename Policy>
+  static constexpr size_t shared_mem_size()
+  {
+    return Policy::SmemSize;
+  }
+
+  DI void core(AccT& acc, DataT& x, DataT& y) const { acc += x * y; };
+
+  template <typename Policy>
+  DI void epilog(AccT acc[Policy::AccRowsPerTh][Policy::AccColsPerTh],
+                 DataT* regxn,
+                 DataT* regyn,
+                 IdxT gridStrideX,
+                 IdxT gridStrideY) const
+  {
+#pragma unroll
+    for (int i = 0; i < Policy::AccRowsPerTh; ++i) {
+#pragma unroll
+      for (int j = 0; j < Policy::AccColsPerTh; ++j) {
+        acc[i][j] = -acc[i][j];
+      }
+    }
+  }
+
+  constexpr neg_inner_product_cutlass_op<DataT, AccT> get_cutlass_op() const
+  {
+    return neg_inner_product_cutlass_op<DataT, AccT>();
+  }
+};
+
+}  // namespace raft::distance::detail::ops
@@ -78,4 +78,62 @@ struct jensen_shannon_distance_op {
   }
 };
 
+/**
+ * @brief the expanded Jensen Shannon distance matrix calculation
+ *
+ * Splitting the logarithms of the ratios, it computes the following equation:
+ *
+ * c_ij = sqrt(0.5 * (sum(x_i * log(x_i)) + sum(y_i * log(y_i))
+ *        - sum((x_i + y_i) * log(0.5 * (x_i + y_i)))))
+ *
+ * The first two terms are the norms of the rows (see `x_log_x_op`), so that the inner loop takes
+ * one logarithm instead of three. The terms cancel when x_i equals y_i, so the distance of a
+ * matrix to itself is computed with `jensen_shannon_distance_op` instead.
+ */
+template <typename DataType, typename AccType, typename IdxType>
+struct jensen_shannon_exp_distance_op {
+  using DataT = DataType;
+  using AccT  = AccType;
+  using IdxT  = IdxType;
+
+  // Load norms of input data
+  static constexpr bool use_norms = true;
+  // Whether the core function requires so many instructions that it makes sense
+  // to reduce loop unrolling, etc. We do this to keep compile times in check.
+  static constexpr bool expensive_inner_loop = true;
+
+  // Size of shared memory. This is normally decided by the kernel policy, but
+  // some ops such as correlation_distance_op use more.
+  template <typename Policy>
+  static constexpr size_t shared_mem_size()
+  {
+    return Policy::SmemSize + ((Policy::Mblk + Policy::Nblk) * sizeof(DataT));
+  }
+
+  DI void core(AccT& acc, DataT& x, DataT& y) const
+  {
+    const DataT s     = x + y;
+    const bool s_zero = (s == 0);
+    acc += s * raft::log(0.5f * s + s_zero);
+  };
+
+  template <typename Policy>
+  DI void epilog(AccT acc[Policy::AccRowsPerTh][Policy::AccColsPerTh],
+                 DataT* regxn,
+                 DataT* regyn,
+                 IdxT gridStrideX,
+                 IdxT gridStrideY) const
+  {
+#pragma unroll
+    for (int i = 0; i < Policy::AccRowsPerTh; ++i) {
+#pragma unroll
+      for (int j = 0; j < Policy::AccColsPerTh; ++j) {
+        // the rounding errors may make the sum slightly negative for the equal rows
+        const AccT d = 0.5 * (regxn[i] + regyn[j] - acc[i][j]);
+        acc[i][j]    = raft::sqrt(d > AccT(0) ? d : AccT(0));
+      }
+    }
+  }
+};
+
 }  // namespace raft::distance::detail::ops
@@ -20,6 +20,16 @@
 
 namespace raft::distance::detail::ops {
 
+/** `x * log(x)`, zero where x is zero; the row sums are the norms of the expanded ops. */
+struct x_log_x_op {
+  template <typename DataT, typename... UnusedArgs>
+  HDI auto operator()(DataT x, UnusedArgs...) const -> DataT
+  {
+    const bool x_zero = (x == 0);
+    return x * raft::log(x + x_zero);
+  }
+};
+
 /**
  * @brief the KL Divergence distance matrix calculation
  *
@@ -96,4 +106,60 @@ struct kl_divergence_op {
     }
   }
 };
+
+/**
+ * @brief the expanded KL Divergence distance matrix calculation
+ *
+ * It computes the following equation:
+ *
+ *   c_ij = 0.5 * (sum(x * log(x)) - sum(x * log(y)))
+ *
+ * The first term is the norm of the x rows (see `x_log_x_op`), and the op expects `log(y)` (zero
+ * where y is zero) in place of y, so that the inner loop takes no logarithm. The norms of y are
+ * not used.
+ */
+template <typename DataType, typename AccType, typename IdxType>
+struct kl_divergence_exp_op {
+  using DataT = DataType;
+  using AccT  = AccType;
+  using IdxT  = IdxType;
+
+  const bool is_row_major;
+
+  kl_divergence_exp_op(bool row_major_) noexcept : is_row_major(row_major_) {}
+
+  // Load norms of input data
+  static constexpr bool use_norms = true;
+  // Whether the core function requires so many instructions that it makes sense
+  // to reduce loop unrolling, etc. We do this to keep compile times in check.
+  static constexpr bool expensive_inner_loop = false;
+
+  // Size of shared memory. This is normally decided by the kernel policy, but
+  // some ops such as correlation_distance_op use more.
+  template <typename Policy>
+  static constexpr size_t shared_mem_size()
+  {
+    return Policy::SmemSize + ((Policy::Mblk + Policy::Nblk) * sizeof(DataT));
+  }
+
+  // x and y are swapped for the column-major inputs; the product is symmetric anyway.
+  DI void core(AccT& acc, DataT& x, DataT& y) const { acc += x * y; };
+
+  template <typename Policy>
+  DI void epilog(AccT acc[Policy::AccRowsPerTh][Policy::AccColsPerTh],
+                 DataT* regxn,
+                 DataT* regyn,
+                 IdxT gridStrideX,
+                 IdxT gridStrideY) const
+  {
+#pragma unroll
+    for (int i = 0; i < Policy::AccRowsPerTh; ++i) {
+#pragma unroll
+      for (int j = 0; j < Policy::AccColsPerTh; ++j) {
+        const DataT x_log_x = is_row_major ? regxn[i] : regyn[j];
+        acc[i][j]           = 0.5f * (x_log_x - acc[i][j]);
+      }
+    }
+  }
+};
 }  // namespace raft::distance::detail::ops
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/error.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/detail/distance_ops/all_ops.cuh>
+#include <raft/distance/detail/pairwise_matrix/dispatch.cuh>
+#include <raft/distance/distance_types.hpp>
+#include <raft/linalg/norm.cuh>
+#include <raft/linalg/reduce.cuh>
+
+namespace raft::distance::detail {
+
+/** Whether the distance metric is computed from the norms of the rows of its inputs. */
+inline bool metric_uses_norms(DistanceType metric)
+{
+  switch (metric) {
+    case DistanceType::L2Expanded:
+    case DistanceType::L2SqrtExpanded:
+    case DistanceType::CosineExpanded:
+    case DistanceType::CorrelationExpanded: return true;
+    default: return false;
+  }
+}
+
+/** Whether the distance metric needs the sums of the rows, in addition to the norms. */
+inline bool metric_uses_sums(DistanceType metric)
+{
+  return metric == DistanceType::CorrelationExpanded;
+}
+
+/**
+ * Whether the norms computed for the metric `a` are the ones used by the metric `b`: the squared
+ * L2 norms are shared by L2Expanded and L2SqrtExpanded.
+ */
+inline bool metric_norms_compatible(DistanceType a, DistanceType b)
+{
+  auto is_l2 = [](DistanceType d) {
+    return d == DistanceType::L2Expanded || d == DistanceType::L2SqrtExpanded;
+  };
+  return a == b || (is_l2(a) && is_l2(b));
+}
+
+/**
+ * Compute the norms of the row-major `m x k` matrix `x` used by the metric: the squared L2 norms
+ * for L2Expanded, L2SqrtExpanded and CorrelationExpanded and the L2 norms for CosineExpanded. For
+ * CorrelationExpanded, `sums` receives the sums of the rows.
+ */
+template <typename DataT, typename IdxT>
+void compute_distance_norms(raft::resources const& handle,
+                            DistanceType metric,
+                            const DataT* x,
+                            IdxT m,
+                            IdxT k,
+                            DataT* norms,
+                            DataT* sums)
+{
+  RAFT_EXPECTS(metric_uses_norms(metric), "The metric does not use the norms of its inputs.");
+  auto stream = resource::get_cuda_stream(handle);
+  if (metric == DistanceType::CosineExpanded) {
+    raft::linalg::rowNorm(norms, x, k, m, raft::linalg::L2Norm, true, stream, raft::sqrt_op{});
+  } else {
+    raft::linalg::rowNorm(norms, x, k, m, raft::linalg::L2Norm, true, stream, raft::identity_op{});
+  }
+  if (metric_uses_sums(metric)) {
+    raft::linalg::reduce(sums,
+                         x,
+                         k,
+                         m,
+                         DataT(0),
+                         true,
+                         true,
+                         stream,
+                         false,
+                         raft::identity_op(),
+                         raft::add_op());
+  }
+}
+
+/**
+ * The pairwise distances of row-major x and y with the norms computed by compute_distance_norms;
+ * the sums are used by CorrelationExpanded only.
+ */
+template <typename DataT, typename IdxT>
+void distance_with_norms(raft::resources const& handle,
+                         DistanceType metric,
+                         const DataT* x,
+                         const DataT* y,
+                         const DataT* x_norm,
+                         const DataT* y_norm,
+                         const DataT* x_sum,
+                         const DataT* y_sum,
+                         DataT* out,
+                         IdxT m,
+                         IdxT n,
+                         IdxT k)
+{
+  auto stream = resource::get_cuda_stream(handle);
+  switch (metric) {
+    case DistanceType::L2Expanded:
+    case DistanceType::L2SqrtExpanded: {
+      const bool perform_sqrt = metric == DistanceType::L2SqrtExpanded;
+      ops::l2_exp_distance_op<DataT, DataT, IdxT> distance_op{perform_sqrt};
+      pairwise_matrix_dispatch<decltype(distance_op), DataT, DataT, DataT, raft::identity_op, IdxT>(
+        distance_op, m, n, k, x, y, x_norm, y_norm, out, raft::identity_op{}, stream, true);
+    } break;
+    case DistanceType::CosineExpanded: {
+      ops::cosine_distance_op<DataT, DataT, IdxT> distance_op{};
+      pairwise_matrix_dispatch<decltype(distance_op), DataT, DataT, DataT, raft::identity_op, IdxT>(
+        distance_op, m, n, k, x, y, x_norm, y_norm, out, raft::identity_op{}, stream, true);
+    } break;
+    case DistanceType::CorrelationExpanded: {
+      RAFT_EXPECTS(x_sum != nullptr && y_sum != nullptr,
+                   "CorrelationExpanded needs the sums of the rows.");
+      // the correlation op takes the squared norms, the kernel loads the sums as the "norms"
+      ops::correlation_distance_op<DataT, DataT, IdxT> distance_op(true, x_norm, y_norm, m, n, k);
+      pairwise_matrix_dispatch<decltype(distance_op), DataT, DataT, DataT, raft::identity_op, IdxT>(
+        distance_op, m, n, k, x, y, x_sum, y_sum, out, raft::identity_op{}, stream, true);
+    } break;
+    default: RAFT_FAIL("The metric %d does not use the norms of its inputs.", int(metric));
+  }
+}
+
+}  // namespace raft::distance::detail
@@ -16,16 +16,24 @@
 
 #pragma once
 
-#include <cstddef>                                          // size_t
-#include <limits>                                           // std::numeric_limits
-#include <raft/core/kvp.hpp>                                // raft::KeyValuePair
-#include <raft/core/operators.hpp>                          // raft::identity_op
-#include <raft/distance/detail/distance_ops/l2_exp.cuh>     // ops::l2_exp_distance_op
+#include <algorithm>                                            // std::max
+#include <cstddef>                                              // size_t
+#include <limits>                                               // std::numeric_limits
+#include <type_traits>                                          // std::bool_constant
+#include <raft/core/error.hpp>                                  // RAFT_FAIL
+#include <raft/core/kvp.hpp>                                    // raft::KeyValuePair
+#include <raft/core/operators.hpp>                              // raft::identity_op
+#include <raft/distance/detail/distance_ops/cosine.cuh>         // ops::cosine_distance_op
+#include <raft/distance/detail/distance_ops/inner_product.cuh>  // ops::neg_inner_product_*
+#include <raft/distance/detail/distance_ops/l2_exp.cuh>         // ops::l2_exp_distance_op
 #include <raft/distance/detail/fused_distance_nn/cutlass_base.cuh>
-#include <raft/distance/detail/pairwise_distance_base.cuh>  // PairwiseDistances
-#include <raft/linalg/contractions.cuh>                     // Policy
-#include <raft/util/arch.cuh>                               // raft::util::arch::SM_*
-#include <raft/util/cuda_utils.cuh>                         // raft::ceildiv, raft::shfl
+#include <raft/distance/detail/pairwise_distance_base.cuh>      // PairwiseDistances
+#include <raft/distance/distance_types.hpp>                     // raft::distance::DistanceType
+#include <raft/linalg/contractions.cuh>                         // Policy
+#include <raft/util/arch.cuh>                                   // raft::util::arch::SM_*
+#include <raft/util/cuda_utils.cuh>                             // raft::ceildiv, raft::shfl
+#include <raft/util/device_atomics.cuh>                         // atomicMinKeyValue
+#include <rmm/device_uvector.hpp>                               // rmm::device_uvector
 
 namespace raft {
 namespace distance {
@@ -100,8 +108,24 @@ void initialize(OutT* min, IdxT m, DataT maxVal, ReduceOpT redOp, cudaStream_t s
   initKernel<DataT, OutT, IdxT><<<blks, 256, 0, stream>>>(min, m, maxVal, redOp);
 }
 
-// TODO: specialize this function for MinAndDistanceReduceOp<int, float>
-// with atomicCAS of 64 bit which will eliminate mutex and shfls
+/**
+ * Whether the reduction `ReduceOpT` of the values `OutT` is a min-reduction done by a single atomic
+ * instruction (see `updateReducedVal`), without the mutex of the row.
+ */
+template <typename ReduceOpT, typename OutT>
+struct is_atomic_min_reduce : std::false_type {};
+
+template <typename LabelT, typename DataT>
+struct is_atomic_min_reduce<MinAndDistanceReduceOpImpl<LabelT, DataT>,
+                            raft::KeyValuePair<LabelT, DataT>>
+  : std::bool_constant<sizeof(raft::KeyValuePair<LabelT, DataT>) == sizeof(uint64_t)> {};
+
+template <typename LabelT, typename DataT>
+struct is_atomic_min_reduce<MinAndDistanceReduceOpImpl<LabelT, DataT>, DataT> : std::true_type {};
+
+template <typename LabelT, typename DataT>
+struct is_atomic_min_reduce<MinReduceOpImpl<LabelT, DataT>, DataT> : std::true_type {};
+
 template <typename P, typename OutT, typename IdxT, typename KVPair, typename ReduceOpT>
 DI void updateReducedVal(
   int* mutex, OutT* min, KVPair* val, ReduceOpT red_op, IdxT m, IdxT gridStrideY)
@@ -109,6 +133,25 @@ DI void updateReducedVal(
   const auto lid      = threadIdx.x % raft::WarpSize;
   const auto accrowid = threadIdx.x / P::AccThCols;
 
+  if constexpr (is_atomic_min_reduce<ReduceOpT, OutT>::value) {
+    // Lock-free: the pair (the key and the value) is updated in one 64-bit CAS, which is skipped
+    // when the value does not improve the output; a plain value is updated by an integer atomic.
+    if (lid % P::AccThCols == 0) {
+#pragma unroll
+      for (int i = 0; i < P::AccRowsPerTh; ++i) {
+        auto rid = gridStrideY + accrowid + i * P::AccThRows;
+        if (rid < m) {
+          if constexpr (std::is_arithmetic_v<OutT>) {
+            atomicMin(min + rid, val[i].value);
+          } else {
+            atomicMinKeyValue(min + rid, OutT{val[i].key, val[i].value});
+          }
+        }
+      }
+    }
+    return;
+  }
+
   // Update each output row in order within a warp. This will resolve hang
   // issues with pre-Volta architectures
 #pragma unroll
@@ -274,26 +317,34 @@ struct kvp_cg_min_reduce_op {
   __host__ __device__ bool isAmin(AccType a, AccType b) const { return a < b ? true : false; }
 };
 
+/**
+ * The fused distance and 1-NN computation for the distance `distance_op`.
+ *
+ * The CUTLASS-based kernel is used on SM_80 and later; it reads the norms `xn` and `yn` through
+ * the epilogue even when `distance_op` does not use them, so these must be valid (e.g. all zeros)
+ * in that case.
+ */
 template <typename DataT,
           typename OutT,
           typename IdxT,
           typename Policy,
           typename ReduceOpT,
-          typename KVPReduceOpT>
-void fusedL2NNImpl(OutT* min,
-                   const DataT* x,
-                   const DataT* y,
-                   const DataT* xn,
-                   const DataT* yn,
-                   IdxT m,
-                   IdxT n,
-                   IdxT k,
-                   int* workspace,
-                   ReduceOpT redOp,
-                   KVPReduceOpT pairRedOp,
-                   bool sqrt,
-                   bool initOutBuffer,
-                   cudaStream_t stream)
+          typename KVPReduceOpT,
+          typename OpT>
+void fusedDistanceNNOpImpl(OutT* min,
+                           const DataT* x,
+                           const DataT* y,
+                           const DataT* xn,
+                           const DataT* yn,
+                           IdxT m,
+                           IdxT n,
+                           IdxT k,
+                           int* workspace,
+                           ReduceOpT redOp,
+                           KVPReduceOpT pairRedOp,
+                           OpT distance_op,
+                           bool initOutBuffer,
+                           cudaStream_t stream)
 {
   // The kernel policy is determined by fusedL2NN.
   typedef Policy P;
@@ -311,8 +362,6 @@ void fusedL2NNImpl(OutT* min,
   }
 
   namespace arch = raft::util::arch;
-  using AccT     = DataT;
-  ops::l2_exp_distance_op<DataT, AccT, IdxT> distance_op{sqrt};
 
   raft::identity_op fin_op{};
 
@@ -336,10 +385,10 @@ void fusedL2NNImpl(OutT* min,
 
   if (cutlass_range.contains(runtime_arch)) {
     // If device is SM_80 or later, use CUTLASS-based kernel.
-    using L2Op                  = raft::distance::detail::ops::l2_exp_cutlass_op<DataT, DataT>;
+    using DistOp                = decltype(distance_op.get_cutlass_op());
     using kvp_cg_min_reduce_op_ = kvp_cg_min_reduce_op<DataT, IdxT, OutT>;
     kvp_cg_min_reduce_op_ cg_reduce_op;
-    L2Op L2_dist_op(sqrt);
+    DistOp cutlass_dist_op = distance_op.get_cutlass_op();
 
     IdxT lda, ldb, ldd;
     lda = k, ldb = k, ldd = n;
@@ -350,7 +399,7 @@ void fusedL2NNImpl(OutT* min,
                            IdxT,
                            P::Veclen,
                            kvp_cg_min_reduce_op_,
-                           L2Op,
+                           DistOp,
                            ReduceOpT,
                            KVPReduceOpT>(x,
                                          y,
@@ -365,13 +414,13 @@ void fusedL2NNImpl(OutT* min,
                                          min,
                                          workspace,
                                          cg_reduce_op,
-                                         L2_dist_op,
+                                         cutlass_dist_op,
                                          redOp,
                                          pairRedOp,
                                          stream);
   } else {
     // If device less than SM_80, use fp32 SIMT kernel.
-    constexpr size_t shmemSize = P::SmemSize + ((P::Mblk + P::Nblk) * sizeof(DataT));
+    constexpr size_t shmemSize = OpT::template shared_mem_size<P>();
     dim3 grid                  = launchConfigGenerator<P>(m, n, shmemSize, kernel);
 
     kernel<<<grid, blk, shmemSize, stream>>>(
@@ -380,6 +429,112 @@ void fusedL2NNImpl(OutT* min,
   }
 }
 
+template <typename DataT,
+          typename OutT,
+          typename IdxT,
+          typename Policy,
+          typename ReduceOpT,
+          typename KVPReduceOpT>
+void fusedL2NNImpl(OutT* min,
+                   const DataT* x,
+                   const DataT* y,
+                   const DataT* xn,
+                   const DataT* yn,
+                   IdxT m,
+                   IdxT n,
+                   IdxT k,
+                   int* workspace,
+                   ReduceOpT redOp,
+                   KVPReduceOpT pairRedOp,
+                   bool sqrt,
+                   bool initOutBuffer,
+                   cudaStream_t stream)
+{
+  ops::l2_exp_distance_op<DataT, DataT, IdxT> distance_op{sqrt};
+  fusedDistanceNNOpImpl<DataT, OutT, IdxT, Policy>(
+    min, x, y, xn, yn, m, n, k, workspace, redOp, pairRedOp, distance_op, initOutBuffer, stream);
+}
+
+/**
+ * See raft::distance::fusedDistanceNN for docs.
+ *
+ * The inner product does not use the norms; when they are not provided, zeros are passed to the
+ * CUTLASS-based kernel instead.
+ */
+template <typename DataT,
+          typename OutT,
+          typename IdxT,
+          typename Policy,
+          typename ReduceOpT,
+          typename KVPReduceOpT>
+void fusedDistanceNNImpl(OutT* min,
+                         const DataT* x,
+                         const DataT* y,
+                         const DataT* xn,
+                         const DataT* yn,
+                         IdxT m,
+                         IdxT n,
+                         IdxT k,
+                         int* workspace,
+                         ReduceOpT redOp,
+                         KVPReduceOpT pairRedOp,
+                         raft::distance::DistanceType metric,
+                         bool initOutBuffer,
+                         cudaStream_t stream)
+{
+  switch (metric) {
+    case raft::distance::DistanceType::L2Expanded:
+    case raft::distance::DistanceType::L2SqrtExpanded: {
+      const bool sqrt = metric == raft::distance::DistanceType::L2SqrtExpanded;
+      fusedL2NNImpl<DataT, OutT, IdxT, Policy>(
+        min, x, y, xn, yn, m, n, k, workspace, redOp, pairRedOp, sqrt, initOutBuffer, stream);
+    } break;
+    case raft::distance::DistanceType::CosineExpanded: {
+      ops::cosine_distance_op<DataT, DataT, IdxT> distance_op{};
+      fusedDistanceNNOpImpl<DataT, OutT, IdxT, Policy>(min,
+                                                       x,
+                                                       y,
+                                                       xn,
+                                                       yn,
+                                                       m,
+                                                       n,
+                                                       k,
+                                                       workspace,
+                                                       redOp,
+                                                       pairRedOp,
+                                                       distance_op,
+                                                       initOutBuffer,
+                                                       stream);
+    } break;
+    case raft::distance::DistanceType::InnerProduct: {
+      rmm::device_uvector<DataT> zero_norms(0, stream);
+      if (xn == nullptr || yn == nullptr) {
+        zero_norms.resize(std::max(m, n), stream);
+        RAFT_CUDA_TRY(
+          cudaMemsetAsync(zero_norms.data(), 0, sizeof(DataT) * zero_norms.size(), stream));
+        xn = zero_norms.data();
+        yn = zero_norms.data();
+      }
+      ops::neg_inner_product_distance_op<DataT, DataT, IdxT> distance_op{};
+      fusedDistanceNNOpImpl<DataT, OutT, IdxT, Policy>(min,
+                                                       x,
+                                                       y,
+                                                       xn,
+                                                       yn,
+                                                       m,
+                                                       n,
+                                                       k,
+                                                       workspace,
+                                                       redOp,
+                                                       pairRedOp,
+                                                       distance_op,
+                                                       initOutBuffer,
+                                                       stream);
+    } break;
+    default: RAFT_FAIL("Unsupported metric for the fused distance 1-NN: %d", int(metric));
+  }
+}
+
 }  // namespace detail
 }  // namespace distance
 }  // namespace raft
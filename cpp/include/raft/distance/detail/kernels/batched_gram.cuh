@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/error.hpp>
+#include <raft/core/resource/cublas_handle.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/detail/kernels/fused_sparse_gram.cuh>
+#include <raft/distance/distance_types.hpp>
+#include <raft/linalg/detail/cublas_wrappers.hpp>
+#include <raft/linalg/norm.cuh>
+#include <raft/util/cuda_utils.cuh>
+
+#include <rmm/device_uvector.hpp>
+
+#include <algorithm>
+#include <cstdint>
+
+namespace raft::distance::kernels::detail {
+
+/** A batch of row-major matrices: `[batch, rows, cols]`. */
+template <typename math_t>
+using batched_matrix_view = raft::device_mdspan<
+  math_t,
+  raft::extents<int, raft::dynamic_extent, raft::dynamic_extent, raft::dynamic_extent>,
+  raft::row_major>;
+
+/**
+ * Apply the epilogue to the inner products of a batch of `n1 x n2` row-major Gram matrices. The
+ * row indices passed to the epilogue are the indices into the batch-wide arrays of the rows of x1
+ * and x2 (`b * n1 + i` and `b * n2 + j`), so that the RBF epilogue reads the norms of its batch.
+ */
+template <typename math_t, typename EpilogueT>
+__global__ void batched_gram_epilogue_kernel(
+  math_t* out, int n1, int n2, int64_t len, EpilogueT epilogue)
+{
+  const int64_t matrix_len = int64_t(n1) * n2;
+  for (int64_t idx = int64_t(blockIdx.x) * blockDim.x + threadIdx.x; idx < len;
+       idx += int64_t(gridDim.x) * blockDim.x) {
+    const int b     = idx / matrix_len;
+    const int64_t r = idx % matrix_len;
+    const int i     = r / n2;
+    const int j     = r % n2;
+    out[idx]        = epilogue(out[idx], b * n1 + i, b * n2 + j);
+  }
+}
+
+template <typename math_t, typename EpilogueT>
+void batched_gram_epilogue(raft::resources const& handle,
+                           batched_matrix_view<math_t> out,
+                           EpilogueT epilogue)
+{
+  constexpr int kBlockSize = 256;
+  const int64_t len        = out.size();
+  if (len == 0) { return; }
+  const int n_blocks =
+    std::min<int64_t>(raft::ceildiv<int64_t>(len, kBlockSize), 32 * raft::getMultiProcessorCount());
+  batched_gram_epilogue_kernel<<<n_blocks, kBlockSize, 0, resource::get_cuda_stream(handle)>>>(
+    out.data_handle(), out.extent(1), out.extent(2), len, epilogue);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+/**
+ * @brief Evaluate a batch of dense Gram matrices in a fixed number of launches.
+ *
+ * `out[b] = K(x1[b], x2[b])` for every matrix b of the batch, where `x1` is `[batch, n1, d]`,
+ * `x2` is `[batch, n2, d]` and `out` is `[batch, n1, n2]`, all row major. The inner products of
+ * the whole batch are computed by a single strided-batched GEMM; a single elementwise pass then
+ * applies the kernel function (for RBF, after a single pass computing the norms of all the rows).
+ * This avoids the per-matrix launches of GramMatrixBase for the many small matrices of e.g.
+ * Gaussian process workloads.
+ *
+ * @param [in] handle raft handle
+ * @param [in] params the kernel function and its parameters
+ * @param [in] x1 the first batch of vectors, size [batch, n1, d]
+ * @param [in] x2 the second batch of vectors, size [batch, n2, d]
+ * @param [out] out the Gram matrices, size [batch, n1, n2]
+ */
+template <typename math_t>
+void batched_gram_matrix(raft::resources const& handle,
+                         const KernelParams& params,
+                         batched_matrix_view<const math_t> x1,
+                         batched_matrix_view<const math_t> x2,
+                         batched_matrix_view<math_t> out)
+{
+  const int batch = x1.extent(0);
+  const int n1    = x1.extent(1);
+  const int n2    = x2.extent(1);
+  const int d     = x1.extent(2);
+  RAFT_EXPECTS(x2.extent(0) == batch && out.extent(0) == batch,
+               "The batch sizes of the inputs and the output must be equal");
+  RAFT_EXPECTS(x2.extent(2) == d, "GramMatrix input matrix dimensions for x1 and x2 do not match");
+  RAFT_EXPECTS(out.extent(1) == n1 && out.extent(2) == n2,
+               "GramMatrix output dimensions do not match the inputs");
+  if (out.size() == 0) { return; }
+
+  auto stream   = resource::get_cuda_stream(handle);
+  auto cublas_h = resource::get_cublas_handle(handle);
+
+  // out[b] = x1[b] * x2[b]^T in row major, i.e. out[b]^T = x2[b]^T * x1[b] in column major
+  math_t alpha = 1;
+  math_t beta  = 0;
+  RAFT_CUBLAS_TRY(raft::linalg::detail::cublasgemmStridedBatched(cublas_h,
+                                                                 CUBLAS_OP_T,
+                                                                 CUBLAS_OP_N,
+                                                                 n2,
+                                                                 n1,
+                                                                 d,
+                                                                 &alpha,
+                                                                 x2.data_handle(),
+                                                                 d,
+                                                                 int64_t(n2) * d,
+                                                                 x1.data_handle(),
+                                                                 d,
+                                                                 int64_t(n1) * d,
+                                                                 &beta,
+                                                                 out.data_handle(),
+                                                                 n2,
+                                                                 int64_t(n1) * n2,
+                                                                 batch,
+                                                                 stream));
+
+  // KernelParams is not templated, we convert the parameters to math_t here:
+  math_t gamma = params.gamma;
+  math_t coef0 = params.coef0;
+  switch (params.kernel) {
+    case LINEAR: break;
+    case POLYNOMIAL: {
+      polynomial_epilogue<math_t, int> epilogue{params.degree, gamma, coef0};
+      batched_gram_epilogue(handle, out, epilogue);
+    } break;
+    case TANH: batched_gram_epilogue(handle, out, tanh_epilogue<math_t>{gamma, coef0}); break;
+    case RBF: {
+      rmm::device_uvector<math_t> norms(
+        size_t(batch) * (n1 + n2), stream, resource::get_workspace_resource(handle));
+      math_t* norm_x1 = norms.data();
+      math_t* norm_x2 = norms.data() + size_t(batch) * n1;
+      raft::linalg::rowNorm(
+        norm_x1, x1.data_handle(), d, batch * n1, raft::linalg::L2Norm, true, stream);
+      raft::linalg::rowNorm(
+        norm_x2, x2.data_handle(), d, batch * n2, raft::linalg::L2Norm, true, stream);
+      batched_gram_epilogue(handle, out, rbf_epilogue<math_t>{gamma, norm_x1, norm_x2});
+    } break;
+    default: throw raft::exception("Kernel not implemented");
+  }
+}
+
+};  // end namespace raft::distance::kernels::detail
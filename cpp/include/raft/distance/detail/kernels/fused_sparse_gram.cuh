@@ -0,0 +1,271 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/error.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+#include <raft/util/reduction.cuh>
+
+#include <algorithm>
+#include <cstdint>
+
+namespace raft::distance::kernels::detail {
+
+/*
+ * Fused sparse Gram matrices: the inner products of the rows of a CSR matrix x1 with the rows of
+ * a dense or CSR matrix x2 are computed by a single kernel, which applies the kernel function
+ * (the epilogue) to every inner product before writing it to the output. This avoids the
+ * cuSPARSE SpMM setup (descriptors, buffer size query and workspace) of every call and the
+ * separate pass of the kernel function over the output.
+ *
+ * The epilogues are device functors `(math_t dot, int i, int j) -> math_t`, where i and j are the
+ * row indices into x1 and x2.
+ */
+
+/** K_ij = <x1_i, x2_j> */
+template <typename math_t>
+struct linear_epilogue {
+  HDI math_t operator()(math_t dot, int, int) const { return dot; }
+};
+
+/** K_ij = (gain * <x1_i, x2_j> + offset)^exponent */
+template <typename math_t, typename exp_t>
+struct polynomial_epilogue {
+  exp_t exponent;
+  math_t gain;
+  math_t offset;
+
+  HDI math_t operator()(math_t dot, int, int) const { return pow(gain * dot + offset, exponent); }
+};
+
+/** K_ij = tanh(gain * <x1_i, x2_j> + offset) */
+template <typename math_t>
+struct tanh_epilogue {
+  math_t gain;
+  math_t offset;
+
+  HDI math_t operator()(math_t dot, int, int) const { return tanh(gain * dot + offset); }
+};
+
+/** K_ij = exp(-gain * (|x1_i|^2 + |x2_j|^2 - 2 <x1_i, x2_j>)), the norms are squared L2 norms */
+template <typename math_t>
+struct rbf_epilogue {
+  math_t gain;
+  const math_t* norm_x1;
+  const math_t* norm_x2;
+
+  HDI math_t operator()(math_t dot, int i, int j) const
+  {
+    return exp(-1.0 * gain * (norm_x1[i] + norm_x2[j] - dot * 2));
+  }
+};
+
+/**
+ * One block per row i of x1 and BlockSize rows of x2: the nonzeros of the row are staged in shared
+ * memory chunk by chunk, every thread accumulates the inner product with one row j of x2.
+ *
+ * The reads of x2 are coalesced when x2 is column major (the layout used by the SVM solvers).
+ */
+template <typename math_t, typename EpilogueT, int BlockSize>
+__global__ void __launch_bounds__(BlockSize)
+  csr_dense_gram_kernel(const int* indptr,
+                        const int* indices,
+                        const math_t* data,
+                        const math_t* x2,
+                        int n2,
+                        int64_t x2_stride_row,
+                        int64_t x2_stride_col,
+                        math_t* out,
+                        int64_t out_stride_row,
+                        int64_t out_stride_col,
+                        EpilogueT epilogue)
+{
+  __shared__ int s_cols[BlockSize];
+  __shared__ math_t s_vals[BlockSize];
+
+  const int i     = blockIdx.x;
+  const int j     = blockIdx.y * BlockSize + threadIdx.x;
+  const int start = indptr[i];
+  const int end   = indptr[i + 1];
+
+  math_t acc = 0;
+  for (int chunk = start; chunk < end; chunk += BlockSize) {
+    const int nz = chunk + threadIdx.x;
+    if (nz < end) {
+      s_cols[threadIdx.x] = indices[nz];
+      s_vals[threadIdx.x] = data[nz];
+    }
+    __syncthreads();
+    const int len = min(BlockSize, end - chunk);
+    if (j < n2) {
+      const math_t* x2_row = x2 + j * x2_stride_row;
+      for (int l = 0; l < len; l++) {
+        acc += s_vals[l] * x2_row[s_cols[l] * x2_stride_col];
+      }
+    }
+    __syncthreads();
+  }
+  if (j < n2) { out[i * out_stride_row + j * out_stride_col] = epilogue(acc, i, j); }
+}
+
+/**
+ * One block per row i of x1 and a range of rows of x2: the row of x1 is scattered into a dense
+ * vector in shared memory, then every warp computes the inner products with its rows j of x2 by
+ * gathering from the dense vector.
+ */
+template <typename math_t, typename EpilogueT, int BlockSize>
+__global__ void __launch_bounds__(BlockSize) csr_csr_gram_kernel(const int* x1_indptr,
+                                                                 const int* x1_indices,
+                                                                 const math_t* x1_data,
+                                                                 const int* x2_indptr,
+                                                                 const int* x2_indices,
+                                                                 const math_t* x2_data,
+                                                                 int n2,
+                                                                 int n_cols,
+                                                                 math_t* out,
+                                                                 int64_t out_stride_row,
+                                                                 int64_t out_stride_col,
+                                                                 EpilogueT epilogue)
+{
+  extern __shared__ char smem[];
+  auto* row = reinterpret_cast<math_t*>(smem);
+  constexpr int kWarps = BlockSize / WarpSize;
+
+  const int i = blockIdx.x;
+  for (int c = threadIdx.x; c < n_cols; c += BlockSize) {
+    row[c] = 0;
+  }
+  __syncthreads();
+  // atomics: duplicate column indices are summed up, like in SpMM
+  for (int nz = x1_indptr[i] + threadIdx.x; nz < x1_indptr[i + 1]; nz += BlockSize) {
+    atomicAdd(row + x1_indices[nz], x1_data[nz]);
+  }
+  __syncthreads();
+
+  const int warp = threadIdx.x / WarpSize;
+  const int lane = threadIdx.x % WarpSize;
+  for (int j = blockIdx.y * kWarps + warp; j < n2; j += gridDim.y * kWarps) {
+    math_t acc = 0;
+    for (int nz = x2_indptr[j] + lane; nz < x2_indptr[j + 1]; nz += WarpSize) {
+      acc += x2_data[nz] * row[x2_indices[nz]];
+    }
+    acc = raft::warpReduce(acc);
+    if (lane == 0) { out[i * out_stride_row + j * out_stride_col] = epilogue(acc, i, j); }
+  }
+}
+
+/**
+ * Evaluate `out(i, j) = epilogue(<x1_i, x2_j>, i, j)` for a CSR matrix x1 and a dense matrix x2
+ * of any strides.
+ */
+template <typename math_t, typename EpilogueT>
+void fused_sparse_gram(raft::resources const& handle,
+                       raft::device_csr_matrix_view<const math_t, int, int, int> x1,
+                       raft::device_matrix_view<const math_t, int, layout_stride> x2,
+                       raft::device_matrix_view<math_t, int, layout_stride> out,
+                       EpilogueT epilogue)
+{
+  constexpr int kBlockSize = 256;
+  auto x1_structure        = x1.structure_view();
+  const int n1             = x1_structure.get_n_rows();
+  const int n2             = x2.extent(0);
+  RAFT_EXPECTS(out.extent(0) == n1 && out.extent(1) == n2,
+               "GramMatrix output dimensions do not match the inputs");
+  RAFT_EXPECTS(x2.extent(1) == x1_structure.get_n_cols(),
+               "GramMatrix input matrix dimensions for x1 and x2 do not match");
+  if (n1 == 0 || n2 == 0) { return; }
+
+  dim3 grid(n1, raft::ceildiv(n2, kBlockSize));
+  csr_dense_gram_kernel<math_t, EpilogueT, kBlockSize>
+    <<<grid, kBlockSize, 0, resource::get_cuda_stream(handle)>>>(
+      x1_structure.get_indptr().data(),
+      x1_structure.get_indices().data(),
+      x1.get_elements().data(),
+      x2.data_handle(),
+      n2,
+      x2.stride(0),
+      x2.stride(1),
+      out.data_handle(),
+      out.stride(0),
+      out.stride(1),
+      epilogue);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+/** Whether fused_sparse_gram supports two CSR matrices of `n_cols` columns. */
+template <typename math_t>
+bool fused_sparse_gram_supported(int n_cols)
+{
+  return size_t(n_cols) * sizeof(math_t) <= size_t(raft::getSharedMemPerBlock());
+}
+
+/**
+ * Evaluate `out(i, j) = epilogue(<x1_i, x2_j>, i, j)` for two CSR matrices x1 and x2.
+ *
+ * A row of x1 is densified in shared memory, hence the number of columns is limited (see
+ * fused_sparse_gram_supported).
+ */
+template <typename math_t, typename EpilogueT>
+void fused_sparse_gram(raft::resources const& handle,
+                       raft::device_csr_matrix_view<const math_t, int, int, int> x1,
+                       raft::device_csr_matrix_view<const math_t, int, int, int> x2,
+                       raft::device_matrix_view<math_t, int, layout_stride> out,
+                       EpilogueT epilogue)
+{
+  constexpr int kBlockSize = 256;
+  constexpr int kWarps     = kBlockSize / WarpSize;
+  // the rows of x2 per warp: amortizes densifying the row of x1 in every block
+  constexpr int kRowsPerWarp = 8;
+
+  auto x1_structure = x1.structure_view();
+  auto x2_structure = x2.structure_view();
+  const int n1      = x1_structure.get_n_rows();
+  const int n2      = x2_structure.get_n_rows();
+  const int n_cols  = x1_structure.get_n_cols();
+  RAFT_EXPECTS(out.extent(0) == n1 && out.extent(1) == n2,
+               "GramMatrix output dimensions do not match the inputs");
+  RAFT_EXPECTS(x2_structure.get_n_cols() == n_cols,
+               "GramMatrix input matrix dimensions for x1 and x2 do not match");
+  RAFT_EXPECTS(fused_sparse_gram_supported<math_t>(n_cols),
+               "Too many columns for the fused sparse Gram matrix");
+  if (n1 == 0 || n2 == 0) { return; }
+
+  dim3 grid(n1, std::min(raft::ceildiv(n2, kWarps * kRowsPerWarp), 65535));
+  size_t smem_size = size_t(n_cols) * sizeof(math_t);
+  csr_csr_gram_kernel<math_t, EpilogueT, kBlockSize>
+    <<<grid, kBlockSize, smem_size, resource::get_cuda_stream(handle)>>>(
+      x1_structure.get_indptr().data(),
+      x1_structure.get_indices().data(),
+      x1.get_elements().data(),
+      x2_structure.get_indptr().data(),
+      x2_structure.get_indices().data(),
+      x2.get_elements().data(),
+      n2,
+      n_cols,
+      out.data_handle(),
+      out.stride(0),
+      out.stride(1),
+      epilogue);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+}  // namespace raft::distance::kernels::detail
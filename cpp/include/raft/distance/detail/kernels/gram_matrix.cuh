@@ -19,11 +19,11 @@
 #include <raft/core/device_csr_matrix.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resources.hpp>
+#include <raft/distance/detail/kernels/fused_sparse_gram.cuh>
 #include <raft/distance/distance.cuh>
 #include <raft/distance/distance_types.hpp>
 // #include <raft/sparse/detail/cusparse_wrappers.h>
 #include <raft/sparse/distance/distance.cuh>
-#include <raft/sparse/linalg/spmm.cuh>
 
 #include <raft/linalg/detail/cublas_wrappers.hpp>
 #include <raft/linalg/gemm.cuh>
@@ -442,10 +442,7 @@ class GramMatrixBase {
     ASSERT(x2.extent(1) == x1_structure.get_n_cols(),
            "GramMatrix input matrix dimensions for x1 and x2 do not match");
 
-    math_t alpha = 1.0;
-    math_t beta  = 0.0;
-
-    raft::sparse::linalg::spmm(handle, false, true, &alpha, x1, x2, &beta, out);
+    fused_sparse_gram<math_t>(handle, x1, x2, out, linear_epilogue<math_t>{});
   }
 
   /** Calculates the Gram matrix using simple dot product between vector sets.
@@ -464,6 +461,11 @@ class GramMatrixBase {
               csr_input_matrix_view_t<math_t> x2,
               dense_output_matrix_view_t<math_t> out)
   {
+    if (fused_sparse_gram_supported<math_t>(x1.structure_view().get_n_cols())) {
+      fused_sparse_gram<math_t>(handle, x1, x2, out, linear_epilogue<math_t>{});
+      return;
+    }
+
     // check layout consistency (w.r.t. strides a matrix might be both row & col major)
     bool is_row_major_nopad = get_is_row_major(out) && out.stride(0) == out.extent(1);
     bool is_col_major_nopad = get_is_col_major(out) && out.stride(1) == out.extent(0);
@@ -235,15 +235,8 @@ class PolynomialKernel : public GramMatrixBase<math_t> {
                 math_t* norm_x1,
                 math_t* norm_x2)
   {
-    bool is_row_major = GramMatrixBase<math_t>::get_is_row_major(out);
-    int ld_out        = is_row_major ? out.stride(0) : out.stride(1);
-    GramMatrixBase<math_t>::linear(handle, x1, x2, out);
-    applyKernel(out.data_handle(),
-                ld_out,
-                out.extent(0),
-                out.extent(1),
-                is_row_major,
-                resource::get_cuda_stream(handle));
+    polynomial_epilogue<math_t, exp_t> epilogue{exponent, gain, offset};
+    fused_sparse_gram<math_t>(handle, x1, x2, out, epilogue);
   }
 
   /** Evaluate kernel matrix using polynomial kernel.
@@ -266,6 +259,12 @@ class PolynomialKernel : public GramMatrixBase<math_t> {
                 math_t* norm_x1,
                 math_t* norm_x2)
   {
+    if (fused_sparse_gram_supported<math_t>(x1.structure_view().get_n_cols())) {
+      polynomial_epilogue<math_t, exp_t> epilogue{exponent, gain, offset};
+      fused_sparse_gram<math_t>(handle, x1, x2, out, epilogue);
+      return;
+    }
+
     bool is_row_major = GramMatrixBase<math_t>::get_is_row_major(out);
     int ld_out        = is_row_major ? out.stride(0) : out.stride(1);
     GramMatrixBase<math_t>::linear(handle, x1, x2, out);
@@ -405,15 +404,7 @@ class TanhKernel : public GramMatrixBase<math_t> {
                 math_t* norm_x1,
                 math_t* norm_x2)
   {
-    bool is_row_major = GramMatrixBase<math_t>::get_is_row_major(out);
-    int ld_out        = is_row_major ? out.stride(0) : out.stride(1);
-    GramMatrixBase<math_t>::linear(handle, x1, x2, out);
-    applyKernel(out.data_handle(),
-                ld_out,
-                out.extent(0),
-                out.extent(1),
-                is_row_major,
-                resource::get_cuda_stream(handle));
+    fused_sparse_gram<math_t>(handle, x1, x2, out, tanh_epilogue<math_t>{gain, offset});
   }
 
   /** Evaluate kernel matrix using tanh kernel.
@@ -436,6 +427,11 @@ class TanhKernel : public GramMatrixBase<math_t> {
                 math_t* norm_x1,
                 math_t* norm_x2)
   {
+    if (fused_sparse_gram_supported<math_t>(x1.structure_view().get_n_cols())) {
+      fused_sparse_gram<math_t>(handle, x1, x2, out, tanh_epilogue<math_t>{gain, offset});
+      return;
+    }
+
     bool is_row_major = GramMatrixBase<math_t>::get_is_row_major(out);
     int ld_out        = is_row_major ? out.stride(0) : out.stride(1);
     GramMatrixBase<math_t>::linear(handle, x1, x2, out);
@@ -641,18 +637,7 @@ class RBFKernel : public GramMatrixBase<math_t> {
       matrixRowNormL2(handle, x2, norm_x2);
     }
 
-    // compute L2expanded
-    bool is_row_major = GramMatrixBase<math_t>::get_is_row_major(out);
-    int ld_out        = is_row_major ? out.stride(0) : out.stride(1);
-    GramMatrixBase<math_t>::linear(handle, x1, x2, out);
-    applyKernel(out.data_handle(),
-                ld_out,
-                out.extent(0),
-                out.extent(1),
-                norm_x1,
-                norm_x2,
-                is_row_major,
-                resource::get_cuda_stream(handle));
+    fused_sparse_gram<math_t>(handle, x1, x2, out, rbf_epilogue<math_t>{gain, norm_x1, norm_x2});
   }
 
   /** Evaluate kernel matrix using RBF kernel.
@@ -691,6 +676,11 @@ class RBFKernel : public GramMatrixBase<math_t> {
       matrixRowNormL2(handle, x2, norm_x2);
     }
 
+    if (fused_sparse_gram_supported<math_t>(x1.structure_view().get_n_cols())) {
+      fused_sparse_gram<math_t>(handle, x1, x2, out, rbf_epilogue<math_t>{gain, norm_x1, norm_x2});
+      return;
+    }
+
     // compute L2expanded
     bool is_row_major = GramMatrixBase<math_t>::get_is_row_major(out);
     int ld_out        = is_row_major ? out.stride(0) : out.stride(1);
@@ -0,0 +1,385 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/error.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cublas_handle.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/detail/distance_ops/all_ops.cuh>
+#include <raft/distance/distance_types.hpp>
+#include <raft/linalg/contractions.cuh>
+#include <raft/linalg/detail/cublas_wrappers.hpp>
+#include <raft/linalg/map.cuh>
+#include <raft/linalg/reduce.cuh>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <cublas_v2.h>
+#include <cuda_bf16.h>
+#include <cuda_fp16.h>
+
+#include <type_traits>
+
+namespace raft::distance::detail {
+
+template <typename DataT>
+constexpr bool is_half_precision_v =
+  std::is_same_v<DataT, half> || std::is_same_v<DataT, nv_bfloat16>;
+
+/** The cuBLAS type of the half-precision inputs. */
+template <typename DataT>
+constexpr cudaDataType_t half_cuda_data_type()
+{
+  return std::is_same_v<DataT, half> ? CUDA_R_16F : CUDA_R_16BF;
+}
+
+/**
+ * A tiled pairwise distance kernel for the half-precision inputs (row-major).
+ *
+ * The tiles of x and y are converted to fp32 (optionally transformed by `load_x` / `load_y`) in
+ * shared memory, so that the existing fp32 distance ops accumulate and finalize the distances
+ * unchanged. The output tile of a block and the mapping of the accumulators to the threads are
+ * those of `Policy`.
+ */
+template <typename Policy,
+          typename OpT,
+          typename DataT,
+          typename IdxT,
+          typename LoadXT,
+          typename LoadYT>
+__launch_bounds__(Policy::Nthreads) __global__ void pairwise_half_kernel(OpT distance_op,
+                                                                        const DataT* x,
+                                                                        const DataT* y,
+                                                                        IdxT m,
+                                                                        IdxT n,
+                                                                        IdxT k,
+                                                                        float* out,
+                                                                        LoadXT load_x,
+                                                                        LoadYT load_y)
+{
+  constexpr int kRows = Policy::AccRowsPerTh;
+  constexpr int kCols = Policy::AccColsPerTh;
+  __shared__ float sx[Policy::Mblk][Policy::Kblk + 1];
+  __shared__ float sy[Policy::Nblk][Policy::Kblk + 1];
+
+  const IdxT row0   = IdxT(blockIdx.y) * Policy::Mblk;
+  const IdxT col0   = IdxT(blockIdx.x) * Policy::Nblk;
+  const int acc_row = threadIdx.x / Policy::AccThCols;
+  const int acc_col = threadIdx.x % Policy::AccThCols;
+
+  float acc[kRows][kCols];
+#pragma unroll
+  for (int i = 0; i < kRows; i++) {
+#pragma unroll
+    for (int j = 0; j < kCols; j++) {
+      acc[i][j] = 0;
+    }
+  }
+
+  for (IdxT k0 = 0; k0 < k; k0 += Policy::Kblk) {
+    for (int i = threadIdx.x; i < Policy::Mblk * Policy::Kblk; i += Policy::Nthreads) {
+      const int r   = i / Policy::Kblk;
+      const int c   = i % Policy::Kblk;
+      const IdxT gr = row0 + r;
+      const IdxT gc = k0 + c;
+      sx[r][c]      = gr < m && gc < k ? load_x(float(x[size_t(gr) * k + gc])) : 0.0f;
+    }
+    for (int i = threadIdx.x; i < Policy::Nblk * Policy::Kblk; i += Policy::Nthreads) {
+      const int r   = i / Policy::Kblk;
+      const int c   = i % Policy::Kblk;
+      const IdxT gr = col0 + r;
+      const IdxT gc = k0 + c;
+      sy[r][c]      = gr < n && gc < k ? load_y(float(y[size_t(gr) * k + gc])) : 0.0f;
+    }
+    __syncthreads();
+    // the padding must not take part in the ops (e.g. hamming counts the zeros)
+    const int k_len = min(IdxT(Policy::Kblk), k - k0);
+    for (int kk = 0; kk < k_len; kk++) {
+      float rx[kRows];
+      float ry[kCols];
+#pragma unroll
+      for (int i = 0; i < kRows; i++) {
+        rx[i] = sx[acc_row + i * Policy::AccThRows][kk];
+      }
+#pragma unroll
+      for (int j = 0; j < kCols; j++) {
+        ry[j] = sy[acc_col + j * Policy::AccThCols][kk];
+      }
+#pragma unroll
+      for (int i = 0; i < kRows; i++) {
+#pragma unroll
+        for (int j = 0; j < kCols; j++) {
+          distance_op.core(acc[i][j], rx[i], ry[j]);
+        }
+      }
+    }
+    __syncthreads();
+  }
+
+  distance_op.template epilog<Policy>(acc, nullptr, nullptr, col0, row0);
+#pragma unroll
+  for (int i = 0; i < kRows; i++) {
+    const IdxT gr = row0 + acc_row + i * Policy::AccThRows;
+    if (gr >= m) { continue; }
+#pragma unroll
+    for (int j = 0; j < kCols; j++) {
+      const IdxT gc = col0 + acc_col + j * Policy::AccThCols;
+      if (gc < n) { out[size_t(gr) * n + gc] = acc[i][j]; }
+    }
+  }
+}
+
+template <typename OpT, typename DataT, typename IdxT, typename LoadXT, typename LoadYT>
+void pairwise_half_elementwise(raft::resources const& handle,
+                               OpT distance_op,
+                               const DataT* x,
+                               const DataT* y,
+                               float* out,
+                               IdxT m,
+                               IdxT n,
+                               IdxT k,
+                               LoadXT load_x,
+                               LoadYT load_y)
+{
+  using Policy = typename raft::linalg::Policy4x4<float, 1>::Policy;
+  dim3 grid(raft::ceildiv<IdxT>(n, Policy::Nblk), raft::ceildiv<IdxT>(m, Policy::Mblk));
+  pairwise_half_kernel<Policy><<<grid, Policy::Nthreads, 0, resource::get_cuda_stream(handle)>>>(
+    distance_op, x, y, m, n, k, out, load_x, load_y);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+/** out[m, n] = x[m, k] * y[n, k]^T in fp32, on the tensor cores. */
+template <typename DataT, typename IdxT>
+void pairwise_half_gemm(
+  raft::resources const& handle, const DataT* x, const DataT* y, float* out, IdxT m, IdxT n, IdxT k)
+{
+  auto cublas_h = resource::get_cublas_handle(handle);
+  RAFT_CUBLAS_TRY(cublasSetStream(cublas_h, resource::get_cuda_stream(handle)));
+  const float alpha = 1.0f;
+  const float beta  = 0.0f;
+  // Column-major view of the row-major output: out^T[n, m] = y[n, k] * x[m, k]^T
+  RAFT_CUBLAS_TRY(cublasGemmEx(cublas_h,
+                               CUBLAS_OP_T,
+                               CUBLAS_OP_N,
+                               int(n),
+                               int(m),
+                               int(k),
+                               &alpha,
+                               y,
+                               half_cuda_data_type<DataT>(),
+                               int(k),
+                               x,
+                               half_cuda_data_type<DataT>(),
+                               int(k),
+                               &beta,
+                               out,
+                               CUDA_R_32F,
+                               int(n),
+                               CUBLAS_COMPUTE_32F,
+                               CUBLAS_GEMM_DEFAULT_TENSOR_OP));
+}
+
+/** Per-row reduction of `main_op(x)` in fp32. */
+template <typename DataT, typename IdxT, typename MainOpT>
+void half_row_reduce(raft::resources const& handle,
+                     const DataT* x,
+                     IdxT n_rows,
+                     IdxT k,
+                     float* out,
+                     MainOpT main_op)
+{
+  raft::linalg::reduce<DataT, float, IdxT>(
+    out,
+    x,
+    k,
+    n_rows,
+    0.0f,
+    true,
+    true,
+    resource::get_cuda_stream(handle),
+    false,
+    [main_op] __device__(DataT v, IdxT) { return main_op(static_cast<float>(v)); });
+}
+
+/**
+ * The pairwise distances of the half-precision (fp16 or bf16) row-major inputs with fp32
+ * accumulation and output.
+ *
+ * The expanded (GEMM-like) metrics compute the inner products with cuBLAS on the tensor cores and
+ * the norms in fp32; the rest run the tiled kernel above with the fp32 distance ops.
+ */
+template <typename DataT, typename IdxT>
+void pairwise_distance_half(raft::resources const& handle,
+                            const DataT* x,
+                            const DataT* y,
+                            float* out,
+                            IdxT m,
+                            IdxT n,
+                            IdxT k,
+                            DistanceType metric,
+                            float metric_arg)
+{
+  static_assert(is_half_precision_v<DataT>, "The inputs must be half or nv_bfloat16");
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "pairwise_distance_half(%zu, %zu, %zu)", size_t(m), size_t(n), size_t(k));
+  auto stream = resource::get_cuda_stream(handle);
+  auto mr     = resource::get_workspace_resource(handle);
+  auto id     = raft::identity_op{};
+  auto sq     = raft::sq_op{};
+
+  switch (metric) {
+    case DistanceType::L2Expanded:
+    case DistanceType::L2SqrtExpanded:
+    case DistanceType::CosineExpanded:
+    case DistanceType::InnerProduct:
+    case DistanceType::CorrelationExpanded: {
+      pairwise_half_gemm(handle, x, y, out, m, n, k);
+      if (metric == DistanceType::InnerProduct) { return; }
+      // x norms in [0, m), y norms in [m, m + n); the squared norms after for correlation
+      const bool corr = metric == DistanceType::CorrelationExpanded;
+      rmm::device_uvector<float> norms(size_t(m + n) * (corr ? 2 : 1), stream, mr);
+      float* xn = norms.data();
+      float* yn = norms.data() + m;
+      if (corr) {
+        half_row_reduce(handle, x, m, k, xn, id);
+        half_row_reduce(handle, y, n, k, yn, id);
+      }
+      float* x2n = corr ? norms.data() + m + n : xn;
+      float* y2n = x2n + m;
+      half_row_reduce(handle, x, m, k, x2n, sq);
+      half_row_reduce(handle, y, n, k, y2n, sq);
+
+      auto out_view       = raft::make_device_vector_view<float, size_t>(out, size_t(m) * n);
+      const size_t n_cols = n;
+      switch (metric) {
+        case DistanceType::L2Expanded:
+        case DistanceType::L2SqrtExpanded: {
+          const bool sqrt = metric == DistanceType::L2SqrtExpanded;
+          raft::linalg::map_offset(
+            handle, out_view, [out, xn, yn, n_cols, sqrt] __device__(size_t i) {
+              float d = xn[i / n_cols] + yn[i % n_cols] - 2.0f * out[i];
+              d       = d * (d > 0.0f);
+              return sqrt ? raft::sqrt(d) : d;
+            });
+        } break;
+        case DistanceType::CosineExpanded:
+          raft::linalg::map_offset(handle, out_view, [out, xn, yn, n_cols] __device__(size_t i) {
+            return 1.0f - out[i] / raft::sqrt(xn[i / n_cols] * yn[i % n_cols]);
+          });
+          break;
+        default: {
+          const auto kf = static_cast<float>(k);
+          raft::linalg::map_offset(
+            handle, out_view, [out, xn, yn, x2n, y2n, n_cols, kf] __device__(size_t i) {
+              const auto r     = i / n_cols;
+              const auto c     = i % n_cols;
+              const auto numer = kf * out[i] - xn[r] * yn[c];
+              const auto q     = kf * x2n[r] - xn[r] * xn[r];
+              const auto s     = kf * y2n[c] - yn[c] * yn[c];
+              return 1.0f - numer / raft::sqrt(q * s);
+            });
+        } break;
+      }
+    } break;
+    case DistanceType::L1:
+      pairwise_half_elementwise(
+        handle, ops::l1_distance_op<float, float, IdxT>{}, x, y, out, m, n, k, id, id);
+      break;
+    case DistanceType::L2Unexpanded:
+    case DistanceType::L2SqrtUnexpanded:
+      pairwise_half_elementwise(
+        handle,
+        ops::l2_unexp_distance_op<float, float, IdxT>{metric == DistanceType::L2SqrtUnexpanded},
+        x,
+        y,
+        out,
+        m,
+        n,
+        k,
+        id,
+        id);
+      break;
+    case DistanceType::Linf:
+      pairwise_half_elementwise(
+        handle, ops::l_inf_distance_op<float, float, IdxT>{}, x, y, out, m, n, k, id, id);
+      break;
+    case DistanceType::Canberra:
+      pairwise_half_elementwise(
+        handle, ops::canberra_distance_op<float, float, IdxT>{}, x, y, out, m, n, k, id, id);
+      break;
+    case DistanceType::LpUnexpanded:
+      pairwise_half_elementwise(handle,
+                                ops::lp_unexp_distance_op<float, float, IdxT>{metric_arg},
+                                x,
+                                y,
+                                out,
+                                m,
+                                n,
+                                k,
+                                id,
+                                id);
+      break;
+    case DistanceType::HammingUnexpanded:
+      pairwise_half_elementwise(
+        handle, ops::hamming_distance_op<float, float, IdxT>{k}, x, y, out, m, n, k, id, id);
+      break;
+    case DistanceType::JensenShannon:
+      pairwise_half_elementwise(
+        handle, ops::jensen_shannon_distance_op<float, float, IdxT>{}, x, y, out, m, n, k, id, id);
+      break;
+    case DistanceType::RusselRaoExpanded:
+      pairwise_half_elementwise(
+        handle, ops::russel_rao_distance_op<float, float, IdxT>{k}, x, y, out, m, n, k, id, id);
+      break;
+    case DistanceType::HellingerExpanded:
+      // the op expects the square roots of the inputs, these are taken on the load
+      pairwise_half_elementwise(handle,
+                                ops::hellinger_distance_op<float, float, IdxT>{},
+                                x,
+                                y,
+                                out,
+                                m,
+                                n,
+                                k,
+                                raft::sqrt_op{},
+                                raft::sqrt_op{});
+      break;
+    case DistanceType::KLDivergence:
+      // the op expects log(y) (zero where y is zero), it is taken on the load
+      pairwise_half_elementwise(
+        handle,
+        ops::kl_divergence_op<float, float, IdxT>{true, false},
+        x,
+        y,
+        out,
+        m,
+        n,
+        k,
+        id,
+        [] __device__(float v) { return (v != 0.0f) * raft::log(v + (v == 0.0f)); });
+      break;
+    default: RAFT_FAIL("Unsupported metric for the half-precision pairwise distance");
+  }
+}
+
+}  // namespace raft::distance::detail
@@ -0,0 +1,278 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/error.hpp>                                       // RAFT_FAIL
+#include <raft/core/nvtx.hpp>                                        // common::nvtx::range
+#include <raft/core/operators.hpp>                                   // raft::identity_op
+#include <raft/core/resource/cuda_stream.hpp>                        // get_cuda_stream
+#include <raft/core/resource/device_memory_resource.hpp>             // get_workspace_resource
+#include <raft/core/resources.hpp>                                   // raft::resources
+#include <raft/distance/detail/distance_ops/all_ops.cuh>             // ops::*
+#include <raft/distance/detail/pairwise_distance_base.cuh>           // PairwiseDistances
+#include <raft/distance/detail/pairwise_matrix/dispatch_layout.cuh>  // dispatch_layout
+#include <raft/distance/detail/pairwise_matrix/params.cuh>           // pairwise_matrix_params
+#include <raft/distance/distance_types.hpp>                          // DistanceType
+#include <raft/linalg/contractions.cuh>                              // raft::linalg::Policy4x4
+#include <raft/linalg/map.cuh>                                       // raft::linalg::map
+#include <raft/linalg/norm.cuh>                                      // raft::linalg::rowNorm
+#include <raft/util/cuda_utils.cuh>                                  // raft::myAtomicReduce
+#include <raft/util/warp_primitives.cuh>                             // raft::shfl_xor
+
+#include <rmm/device_uvector.hpp>  // rmm::device_uvector
+
+#include <algorithm>  // std::min
+#include <utility>    // std::swap
+
+namespace raft::distance::detail {
+
+/** Swaps the row and column indices passed to the map operation. */
+template <typename MapOpT>
+struct transposed_map_op {
+  MapOpT map_op;
+
+  template <typename AccT, typename IdxT>
+  HDI auto operator()(AccT d, IdxT row, IdxT col) const
+  {
+    return map_op(d, col, row);
+  }
+};
+
+/**
+ * Computes the distances tile by tile like `pairwise_matrix_kernel`, but instead of writing them
+ * out, reduces `map_op(d, row, col)` of every row of the distance matrix into `out[row]`.
+ *
+ * Every thread reduces its part of a row in registers over all tiles of the row processed by
+ * the block; on the row epilog, the threads sharing the rows of the tile reduce their values with
+ * warp shuffles, and one thread per row combines them with `out[row]` atomically.
+ */
+template <typename Policy,
+          typename OpT,
+          typename IdxT,
+          typename DataT,
+          typename OutT,
+          typename MapOpT,
+          typename ReduceOpT>
+__global__ __launch_bounds__(Policy::Nthreads, 2) void pairwise_distance_reduce_kernel(
+  OpT distance_op,
+  pairwise_matrix_params<IdxT, DataT, OutT, raft::identity_op> params,
+  OutT init,
+  MapOpT map_op,
+  ReduceOpT reduce_op)
+{
+  extern __shared__ char smem[];
+  static_assert(Policy::AccThCols <= WarpSize && WarpSize % Policy::AccThCols == 0,
+                "The threads sharing a row of the tile must be in the same warp.");
+
+  const int acc_row = threadIdx.x / Policy::AccThCols;
+  const int acc_col = threadIdx.x % Policy::AccThCols;
+  OutT row_acc[Policy::AccRowsPerTh];
+#pragma unroll
+  for (int i = 0; i < Policy::AccRowsPerTh; ++i) {
+    row_acc[i] = init;
+  }
+
+  auto epilog_op = [&](auto& acc, auto, auto, IdxT tile_idx_n, IdxT tile_idx_m) {
+#pragma unroll
+    for (int i = 0; i < Policy::AccRowsPerTh; ++i) {
+      const IdxT row = tile_idx_m + acc_row + i * Policy::AccThRows;
+#pragma unroll
+      for (int j = 0; j < Policy::AccColsPerTh; ++j) {
+        const IdxT col = tile_idx_n + acc_col + j * Policy::AccThCols;
+        if (row < params.m && col < params.n) {
+          row_acc[i] = reduce_op(row_acc[i], map_op(acc[i][j], row, col));
+        }
+      }
+    }
+  };
+
+  auto row_epilog_op = [&](IdxT tile_idx_m) {
+#pragma unroll
+    for (int i = 0; i < Policy::AccRowsPerTh; ++i) {
+      OutT val = row_acc[i];
+#pragma unroll
+      for (int offset = Policy::AccThCols / 2; offset > 0; offset /= 2) {
+        val = reduce_op(val, raft::shfl_xor(val, offset, Policy::AccThCols));
+      }
+      const IdxT row = tile_idx_m + acc_row + i * Policy::AccThRows;
+      if (acc_col == 0 && row < params.m) {
+        raft::myAtomicReduce(params.out + row, val, reduce_op);
+      }
+      row_acc[i] = init;
+    }
+  };
+
+  PairwiseDistances<DataT,
+                    OutT,
+                    IdxT,
+                    Policy,
+                    OpT,
+                    decltype(epilog_op),
+                    raft::identity_op,
+                    decltype(row_epilog_op),
+                    true,
+                    false>
+    obj(params.x,
+        params.y,
+        params.m,
+        params.n,
+        params.k,
+        params.ldx,
+        params.ldy,
+        params.ld_out,
+        params.x_norm,
+        params.y_norm,
+        params.out,
+        smem,
+        distance_op,
+        epilog_op,
+        params.fin_op,
+        row_epilog_op);
+  obj.run();
+}
+
+template <typename OpT,
+          typename IdxT,
+          typename DataT,
+          typename OutT,
+          typename MapOpT,
+          typename ReduceOpT>
+void pairwise_distance_reduce_dispatch(
+  OpT distance_op,
+  pairwise_matrix_params<IdxT, DataT, OutT, raft::identity_op> params,
+  OutT init,
+  MapOpT map_op,
+  ReduceOpT reduce_op,
+  cudaStream_t stream)
+{
+  int vec_len = determine_vec_len(params);
+  auto f      = [&](auto row_major, auto vec_len_aligned) {
+    // Only the row-major layout is supported; the column reductions swap x and y instead.
+    if constexpr (row_major()) {
+      constexpr int vec_len_op = distance_op.expensive_inner_loop ? 1 : vec_len_aligned();
+      constexpr int vec_len    = std::min(vec_len_op, static_cast<int>(16 / sizeof(DataT)));
+      using Policy             = typename raft::linalg::Policy4x4<DataT, vec_len>::Policy;
+
+      int smem_size = OpT::template shared_mem_size<Policy>();
+      auto kernel =
+        pairwise_distance_reduce_kernel<Policy, OpT, IdxT, DataT, OutT, MapOpT, ReduceOpT>;
+      dim3 grid = launchConfigGenerator<Policy>(params.m, params.n, smem_size, kernel);
+      kernel<<<grid, Policy::Nthreads, smem_size, stream>>>(
+        distance_op, params, init, map_op, reduce_op);
+      RAFT_CUDA_TRY(cudaGetLastError());
+    }
+  };
+  dispatch_layout(true, vec_len, f);
+}
+
+/**
+ * See raft::distance::pairwise_distance_reduce for docs.
+ *
+ * When reducing along the columns, the roles of x and y are swapped (all the supported distances
+ * are symmetric), so that the kernel always reduces the rows.
+ */
+template <typename DataT,
+          typename OutT,
+          typename IdxT,
+          typename MapOpT,
+          typename ReduceOpT,
+          typename FinalOpT>
+void pairwise_distance_reduce(raft::resources const& handle,
+                              const DataT* x,
+                              const DataT* y,
+                              OutT* out,
+                              IdxT m,
+                              IdxT n,
+                              IdxT k,
+                              DistanceType metric,
+                              OutT init,
+                              MapOpT map_op,
+                              ReduceOpT reduce_op,
+                              FinalOpT final_op,
+                              bool along_rows,
+                              DataT metric_arg)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "pairwise_distance_reduce(%zu, %zu, %zu)", size_t(m), size_t(n), size_t(k));
+  if (!along_rows) {
+    std::swap(x, y);
+    std::swap(m, n);
+  }
+  auto stream = resource::get_cuda_stream(handle);
+  auto out_v  = raft::make_device_vector_view<OutT, IdxT>(out, m);
+  raft::linalg::map(handle, out_v, raft::const_op<OutT>{init});
+  if (m == 0) { return; }
+
+  pairwise_matrix_params<IdxT, DataT, OutT, raft::identity_op> params{
+    m, n, k, k, k, n, x, y, nullptr, nullptr, out, raft::identity_op{}, true};
+
+  auto run = [&](auto distance_op) {
+    if (n == 0) {
+      return;
+    } else if (along_rows) {
+      pairwise_distance_reduce_dispatch(distance_op, params, init, map_op, reduce_op, stream);
+    } else {
+      pairwise_distance_reduce_dispatch(
+        distance_op, params, init, transposed_map_op<MapOpT>{map_op}, reduce_op, stream);
+    }
+  };
+
+  // The norms of the expanded distances
+  rmm::device_uvector<DataT> norms(0, stream, resource::get_workspace_resource(handle));
+  auto compute_norms = [&](auto fin_op) {
+    norms.resize(size_t(m) + size_t(n), stream);
+    raft::linalg::rowNorm(norms.data(), x, k, m, raft::linalg::L2Norm, true, stream, fin_op);
+    raft::linalg::rowNorm(norms.data() + m, y, k, n, raft::linalg::L2Norm, true, stream, fin_op);
+    params.x_norm = norms.data();
+    params.y_norm = norms.data() + m;
+  };
+
+  switch (metric) {
+    case DistanceType::L2Expanded:
+    case DistanceType::L2SqrtExpanded:
+      compute_norms(raft::identity_op{});
+      run(ops::l2_exp_distance_op<DataT, DataT, IdxT>{metric == DistanceType::L2SqrtExpanded});
+      break;
+    case DistanceType::CosineExpanded:
+      compute_norms(raft::sqrt_op{});
+      run(ops::cosine_distance_op<DataT, DataT, IdxT>{});
+      break;
+    case DistanceType::L2Unexpanded:
+    case DistanceType::L2SqrtUnexpanded:
+      run(ops::l2_unexp_distance_op<DataT, DataT, IdxT>{metric == DistanceType::L2SqrtUnexpanded});
+      break;
+    case DistanceType::L1: run(ops::l1_distance_op<DataT, DataT, IdxT>{}); break;
+    case DistanceType::Linf: run(ops::l_inf_distance_op<DataT, DataT, IdxT>{}); break;
+    case DistanceType::Canberra: run(ops::canberra_distance_op<DataT, DataT, IdxT>{}); break;
+    case DistanceType::LpUnexpanded:
+      run(ops::lp_unexp_distance_op<DataT, DataT, IdxT>{metric_arg});
+      break;
+    case DistanceType::HammingUnexpanded:
+      run(ops::hamming_distance_op<DataT, DataT, IdxT>{k});
+      break;
+    case DistanceType::JensenShannon:
+      run(ops::jensen_shannon_distance_op<DataT, DataT, IdxT>{});
+      break;
+    case DistanceType::RusselRaoExpanded:
+      run(ops::russel_rao_distance_op<DataT, DataT, IdxT>{k});
+      break;
+    default: RAFT_FAIL("Unsupported metric for pairwise_distance_reduce");
+  }
+  raft::linalg::map(handle, out_v, final_op, raft::make_const_mdspan(out_v));
+}
+
+}  // namespace raft::distance::detail
@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdspan.hpp>                    // raft::device_matrix_view
+#include <raft/core/error.hpp>                            // RAFT_EXPECTS
+#include <raft/core/host_mdspan.hpp>                      // raft::host_matrix_view
+#include <raft/core/nvtx.hpp>                             // common::nvtx::range
+#include <raft/core/resource/cuda_stream.hpp>             // get_cuda_stream
+#include <raft/core/resource/device_memory_resource.hpp>  // get_workspace_resource
+#include <raft/core/resources.hpp>                        // raft::resources
+#include <raft/distance/distance.cuh>                     // raft::distance::pairwise_distance
+#include <raft/distance/distance_types.hpp>               // DistanceType
+#include <raft/util/cuda_rt_essentials.hpp>               // RAFT_CUDA_TRY
+
+#include <rmm/device_uvector.hpp>  // rmm::device_uvector
+
+#include <algorithm>  // std::min
+#include <cstring>    // std::memcpy
+#include <limits>     // std::numeric_limits
+
+namespace raft::distance::detail {
+
+/** The upper bound of the size of each of the pinned host buffers of the tiles. */
+constexpr size_t kTiledStagingBufferSize = size_t{256} << 20;
+
+/** The shape of the tiles of the distance matrix. */
+struct distance_tiling {
+  size_t tile_rows;
+  size_t tile_cols;
+};
+
+/**
+ * Choose the largest tiles of at most `max_bytes`: whole rows of the distance matrix when they
+ * fit, otherwise a part of a single row.
+ *
+ * When `max_bytes` is zero, the tiles use at most half of the free device memory.
+ */
+template <typename DataT>
+distance_tiling choose_distance_tiling(size_t m, size_t n, size_t max_bytes)
+{
+  if (max_bytes == 0) {
+    size_t free_bytes, total_bytes;
+    RAFT_CUDA_TRY(cudaMemGetInfo(&free_bytes, &total_bytes));
+    max_bytes = free_bytes / 2;
+  }
+  const size_t max_elems = std::max<size_t>(1, max_bytes / sizeof(DataT));
+  const size_t tile_cols = std::max<size_t>(1, std::min(n, max_elems));
+  const size_t tile_rows = std::max<size_t>(1, std::min(m, max_elems / tile_cols));
+  return {tile_rows, tile_cols};
+}
+
+/**
+ * Compute the distances tile by tile into a single device buffer and pass every tile to tile_op.
+ * See raft::distance::pairwise_distance_tiled for docs.
+ */
+template <typename DataT, typename IdxT, typename TileOpT>
+void pairwise_distance_tiled(raft::resources const& handle,
+                             raft::device_matrix_view<const DataT, IdxT, row_major> x,
+                             raft::device_matrix_view<const DataT, IdxT, row_major> y,
+                             DistanceType metric,
+                             TileOpT tile_op,
+                             size_t max_tile_bytes,
+                             DataT metric_arg)
+{
+  const size_t m = x.extent(0);
+  const size_t n = y.extent(0);
+  const size_t k = x.extent(1);
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "pairwise_distance_tiled(%zu, %zu, %zu)", m, n, k);
+  RAFT_EXPECTS(size_t(y.extent(1)) == k, "Number of columns must be equal.");
+  RAFT_EXPECTS(k <= size_t(std::numeric_limits<int>::max()),
+               "Number of columns must fit into an int.");
+  if (m == 0 || n == 0) { return; }
+
+  auto stream = resource::get_cuda_stream(handle);
+  auto mr     = resource::get_workspace_resource(handle);
+  auto tiling = choose_distance_tiling<DataT>(m, n, max_tile_bytes);
+
+  rmm::device_uvector<DataT> tile(tiling.tile_rows * tiling.tile_cols, stream, mr);
+  rmm::device_uvector<char> workspace(0, stream, mr);
+  for (size_t row = 0; row < m; row += tiling.tile_rows) {
+    const size_t rows = std::min(tiling.tile_rows, m - row);
+    for (size_t col = 0; col < n; col += tiling.tile_cols) {
+      const size_t cols = std::min(tiling.tile_cols, n - col);
+      raft::distance::pairwise_distance<DataT, int>(handle,
+                                                    x.data_handle() + row * k,
+                                                    y.data_handle() + col * k,
+                                                    tile.data(),
+                                                    int(rows),
+                                                    int(cols),
+                                                    int(k),
+                                                    workspace,
+                                                    metric,
+                                                    true,
+                                                    metric_arg);
+      tile_op(raft::make_device_matrix_view<const DataT, IdxT>(tile.data(), rows, cols),
+              IdxT(row),
+              IdxT(col));
+    }
+  }
+}
+
+/**
+ * A pair of pinned host buffers to stage the tiles of the distance matrix.
+ *
+ * While the host scatters one tile into the output, the copy of the next one proceeds in the
+ * stream; an event for every buffer tells when the copy is done.
+ */
+class distance_staging_buffers {
+ public:
+  explicit distance_staging_buffers(size_t bytes)
+  {
+    for (int i = 0; i < 2; i++) {
+      RAFT_CUDA_TRY(cudaMallocHost(&data_[i], bytes));
+      RAFT_CUDA_TRY(cudaEventCreateWithFlags(&events_[i], cudaEventDisableTiming));
+    }
+  }
+  ~distance_staging_buffers() noexcept
+  {
+    for (int i = 0; i < 2; i++) {
+      // the pending copies must not write the memory after it is freed
+      RAFT_CUDA_TRY_NO_THROW(cudaEventSynchronize(events_[i]));
+      RAFT_CUDA_TRY_NO_THROW(cudaEventDestroy(events_[i]));
+      RAFT_CUDA_TRY_NO_THROW(cudaFreeHost(data_[i]));
+    }
+  }
+  distance_staging_buffers(const distance_staging_buffers&)                    = delete;
+  distance_staging_buffers(distance_staging_buffers&&)                         = delete;
+  auto operator=(const distance_staging_buffers&) -> distance_staging_buffers& = delete;
+  auto operator=(distance_staging_buffers&&) -> distance_staging_buffers&      = delete;
+
+  [[nodiscard]] auto data(int i) const -> void* { return data_[i]; }
+  /** Mark the end of the device copies into the buffer `i` issued so far. */
+  void record(int i, rmm::cuda_stream_view stream)
+  {
+    RAFT_CUDA_TRY(cudaEventRecord(events_[i], stream));
+  }
+  /** Wait until the buffer `i` can be used by the host. */
+  void wait(int i) { RAFT_CUDA_TRY(cudaEventSynchronize(events_[i])); }
+
+ private:
+  void* data_[2] = {nullptr, nullptr};
+  cudaEvent_t events_[2];
+};
+
+/**
+ * Compute the distances tile by tile and write them to host memory through a pair of pinned
+ * buffers: the host scatters a tile into the output while the device computes the next one.
+ * See raft::distance::pairwise_distance_tiled for docs.
+ */
+template <typename DataT, typename IdxT>
+void pairwise_distance_tiled(raft::resources const& handle,
+                             raft::device_matrix_view<const DataT, IdxT, row_major> x,
+                             raft::device_matrix_view<const DataT, IdxT, row_major> y,
+                             raft::host_matrix_view<DataT, IdxT, row_major> dist,
+                             DistanceType metric,
+                             size_t max_tile_bytes,
+                             DataT metric_arg)
+{
+  RAFT_EXPECTS(dist.extent(0) == x.extent(0) && dist.extent(1) == y.extent(0),
+               "Incompatible output shape");
+  const size_t n = y.extent(0);
+  auto stream    = resource::get_cuda_stream(handle);
+  auto tiling    = choose_distance_tiling<DataT>(
+    x.extent(0),
+    n,
+    std::min(max_tile_bytes == 0 ? kTiledStagingBufferSize : max_tile_bytes,
+             kTiledStagingBufferSize));
+  distance_staging_buffers staging(tiling.tile_rows * tiling.tile_cols * sizeof(DataT));
+
+  // The tile staged in the buffer of the slot, to be scattered into dist
+  struct staged_tile {
+    size_t row, col, rows, cols;
+  };
+  staged_tile staged[2];
+  auto scatter = [&](int slot) {
+    staging.wait(slot);
+    const auto& t = staged[slot];
+    auto* src     = static_cast<const DataT*>(staging.data(slot));
+#pragma omp parallel for
+    for (int64_t i = 0; i < int64_t(t.rows); i++) {
+      std::memcpy(dist.data_handle() + (t.row + i) * n + t.col,
+                  src + i * t.cols,
+                  t.cols * sizeof(DataT));
+    }
+  };
+
+  int slot       = 0;
+  size_t n_tiles = 0;
+  pairwise_distance_tiled(
+    handle,
+    x,
+    y,
+    metric,
+    [&](raft::device_matrix_view<const DataT, IdxT, row_major> tile, IdxT row, IdxT col) {
+      slot = n_tiles++ % 2;
+      // The buffer of the slot was scattered after the previous tile had been enqueued
+      staged[slot] = {size_t(row), size_t(col), size_t(tile.extent(0)), size_t(tile.extent(1))};
+      RAFT_CUDA_TRY(cudaMemcpyAsync(staging.data(slot),
+                                    tile.data_handle(),
+                                    tile.size() * sizeof(DataT),
+                                    cudaMemcpyDeviceToHost,
+                                    stream));
+      staging.record(slot, stream);
+      // Scatter the previous tile while the device computes this one and the next
+      if (n_tiles > 1) { scatter(1 - slot); }
+    },
+    tiling.tile_rows * tiling.tile_cols * sizeof(DataT),
+    metric_arg);
+  if (n_tiles > 0) { scatter(slot); }
+}
+
+}  // namespace raft::distance::detail
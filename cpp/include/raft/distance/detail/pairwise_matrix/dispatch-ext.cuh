@@ -133,6 +133,20 @@ instantiate_raft_distance_detail_pairwise_matrix_dispatch(
   double,
   raft::identity_op,
   int);
+instantiate_raft_distance_detail_pairwise_matrix_dispatch(
+  raft::distance::detail::ops::jensen_shannon_exp_distance_op,
+  float,
+  float,
+  float,
+  raft::identity_op,
+  int);
+instantiate_raft_distance_detail_pairwise_matrix_dispatch(
+  raft::distance::detail::ops::jensen_shannon_exp_distance_op,
+  double,
+  double,
+  double,
+  raft::identity_op,
+  int);
 instantiate_raft_distance_detail_pairwise_matrix_dispatch(
   raft::distance::detail::ops::jensen_shannon_distance_op,
   float,
@@ -148,9 +162,14 @@ instantiate_raft_distance_detail_pairwise_matrix_dispatch(
   raft::identity_op,
   int);
 instantiate_raft_distance_detail_pairwise_matrix_dispatch(
-  raft::distance::detail::ops::kl_divergence_op, float, float, float, raft::identity_op, int);
+  raft::distance::detail::ops::kl_divergence_exp_op, float, float, float, raft::identity_op, int);
 instantiate_raft_distance_detail_pairwise_matrix_dispatch(
-  raft::distance::detail::ops::kl_divergence_op, double, double, double, raft::identity_op, int);
+  raft::distance::detail::ops::kl_divergence_exp_op,
+  double,
+  double,
+  double,
+  raft::identity_op,
+  int);
 instantiate_raft_distance_detail_pairwise_matrix_dispatch(
   raft::distance::detail::ops::l1_distance_op, float, float, float, raft::identity_op, int);
 instantiate_raft_distance_detail_pairwise_matrix_dispatch(
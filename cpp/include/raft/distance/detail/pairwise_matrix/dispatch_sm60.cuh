@@ -18,6 +18,7 @@
 #include <algorithm>                                                 // std::min
 #include <raft/distance/detail/pairwise_matrix/dispatch_layout.cuh>  // dispatch_layout
 #include <raft/distance/detail/pairwise_matrix/kernel_sm60.cuh>      // pairwise_matrix_sm60_wrapper
+#include <raft/distance/detail/pairwise_matrix/tile_config.hpp>      // select_tile_config
 #include <raft/linalg/contractions.cuh>                              // raft::linalg::Policy4x4
 
 namespace raft::distance::detail {
@@ -34,6 +35,8 @@ pairwise_matrix_sm60_wrapper<OpT, IdxT, DataT, OutT, FinOpT> pairwise_matrix_sm6
   SM_compat_t sm_compat_range)
 {
   int vec_len = determine_vec_len(params);
+  // The tile configuration tuned for the shape on the current architecture (see tile_config.hpp)
+  tile_config tile = select_tile_config<DataT>(params.m, params.n, params.k);
 
   // f takes compile-time constants row_major and vec_len aligned and returns
   // the corresponding kernel wrapper. The wrapper contains the launch
@@ -50,14 +53,23 @@ pairwise_matrix_sm60_wrapper<OpT, IdxT, DataT, OutT, FinOpT> pairwise_matrix_sm6
     // Prevent double, vec_len=4 combination (this is not supported)
     constexpr int vec_len = std::min(vec_len_op, static_cast<int>(16 / sizeof(DataT)));
 
-    using RowPolicy = typename raft::linalg::Policy4x4<DataT, vec_len>::Policy;
-    using ColPolicy = typename raft::linalg::Policy4x4<DataT, vec_len>::ColPolicy;
-    using Policy    = typename std::conditional<row_major(), RowPolicy, ColPolicy>::type;
+    // Every tile configuration is compiled, the runtime value of tile selects
+    // one of them.
+    constexpr bool is_row_major = row_major();
+    auto make_wrapper           = [&](auto policies) {
+      using RowPolicy = typename decltype(policies)::Policy;
+      using ColPolicy = typename decltype(policies)::ColPolicy;
+      using Policy    = typename std::conditional<is_row_major, RowPolicy, ColPolicy>::type;
 
-    auto wrapper =
-      make_pairwise_matrix_sm60_wrapper<Policy, row_major()>(distance_op, params, sm_compat_range);
+      return make_pairwise_matrix_sm60_wrapper<Policy, is_row_major>(
+        distance_op, params, sm_compat_range);
+    };
 
-    return wrapper;
+    if (tile == tile_config::kPolicy4x4Skinny) {
+      return make_wrapper(raft::linalg::Policy4x4Skinny<DataT, vec_len>{});
+    } else {
+      return make_wrapper(raft::linalg::Policy4x4<DataT, vec_len>{});
+    }
   };
 
   // Dispatch_layout calls f with appropriate compile time constants based on
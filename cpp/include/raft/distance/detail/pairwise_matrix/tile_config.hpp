@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/distance/detail/pairwise_matrix/tile_config_tables.hpp>  // embedded_tile_tables
+#include <raft/distance/detail/pairwise_matrix/tile_config_types.hpp>   // tile_config
+#include <raft/util/cuda_rt_essentials.hpp>                              // RAFT_CUDA_TRY
+
+#include <cuda_runtime_api.h>  // cudaGetDevice
+
+#include <algorithm>  // std::max
+#include <cmath>      // std::log2
+#include <cstddef>    // size_t
+#include <limits>     // std::numeric_limits
+#include <vector>     // std::vector
+
+/**
+ * Selection of the tile configuration of the pairwise distance kernels by the problem shape.
+ *
+ * Every distance op is compiled for a small number of tile configurations (see
+ * `pairwise_matrix_sm60_get_wrapper`). The configuration is chosen at runtime by `(m, n, k,
+ * sizeof(DataT))` from the table of the current GPU architecture. The tables are produced from the
+ * `TUNE_DISTANCE` shape benchmarks (see `cpp/bench/prims/distance/tune_pairwise/`) by
+ * `cpp/scripts/heuristics/pairwise_distance/generate_tile_table.py` and embedded at build time in
+ * `tile_config_tables.hpp`. The architectures without a table use `default_tile_config`.
+ */
+namespace raft::distance::detail {
+
+/**
+ * The tile configuration used when the current architecture has no table.
+ *
+ * The 64x64 tiles with a k-block of 32 of Policy4x4 do redundant work when k is smaller than 32,
+ * and when m is not larger than the 32 rows of the skinny tiles, at least half of the threads of
+ * every block would compute padding rows; the skinny tiles also launch twice as many blocks along
+ * n, which keeps the GPU busy for a single (or a few) rows against a huge n.
+ */
+inline auto default_tile_config(size_t m, size_t, size_t k) -> tile_config
+{
+  return (k < 32 || m <= 32) ? tile_config::kPolicy4x4Skinny : tile_config::kPolicy4x4;
+}
+
+/**
+ * Look up the tile configuration of the shape in a tile table: the entry of the same data type
+ * nearest to the shape in the log-space (so that the table does not need to be a full grid).
+ * Returns `default_tile_config` if the table has no entry of the data type.
+ */
+inline auto lookup_tile_config(
+  const std::vector<tile_entry>& table, int dtype_size, size_t m, size_t n, size_t k)
+  -> tile_config
+{
+  auto log_dist = [](size_t a, size_t b) {
+    return std::abs(std::log2(double(std::max<size_t>(a, 1))) -
+                    std::log2(double(std::max<size_t>(b, 1))));
+  };
+  const tile_entry* best = nullptr;
+  double best_dist       = std::numeric_limits<double>::max();
+  for (const auto& e : table) {
+    if (e.dtype_size != dtype_size) { continue; }
+    double d = log_dist(e.m, m) + log_dist(e.n, n) + log_dist(e.k, k);
+    if (d < best_dist) {
+      best      = &e;
+      best_dist = d;
+    }
+  }
+  return best == nullptr ? default_tile_config(m, n, k) : best->tile;
+}
+
+/** The compute capability of the current device as `10 * major + minor`. */
+inline auto tile_config_current_arch() -> int
+{
+  int dev;
+  int major;
+  int minor;
+  RAFT_CUDA_TRY(cudaGetDevice(&dev));
+  RAFT_CUDA_TRY(cudaDeviceGetAttribute(&major, cudaDevAttrComputeCapabilityMajor, dev));
+  RAFT_CUDA_TRY(cudaDeviceGetAttribute(&minor, cudaDevAttrComputeCapabilityMinor, dev));
+  return 10 * major + minor;
+}
+
+/** The tile configuration of the shape `(m, n, k)` on the current device. */
+template <typename DataT>
+auto select_tile_config(size_t m, size_t n, size_t k) -> tile_config
+{
+  static const auto tables = embedded_tile_tables();
+  const int arch           = tile_config_current_arch();
+  for (const auto& [table_arch, table] : tables) {
+    if (table_arch == arch) { return lookup_tile_config(table, sizeof(DataT), m, n, k); }
+  }
+  return default_tile_config(m, n, k);
+}
+
+}  // namespace raft::distance::detail
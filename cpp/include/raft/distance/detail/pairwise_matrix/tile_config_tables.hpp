@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * NOTE: this file is generated by cpp/scripts/heuristics/pairwise_distance/generate_tile_table.py
+ *
+ * Do not edit manually; regenerate it from the benchmark results instead:
+ *
+ *   python generate_tile_table.py \
+ *     --output cpp/include/raft/distance/detail/pairwise_matrix/tile_config_tables.hpp \
+ *     70=tune_distance_v100.json 80=tune_distance_a100.json
+ */
+
+#pragma once
+
+#include <raft/distance/detail/pairwise_matrix/tile_config_types.hpp>  // tile_entry
+
+#include <utility>  // std::pair
+#include <vector>   // std::vector
+
+namespace raft::distance::detail {
+
+/**
+ * The tile tables embedded at build time: pairs of the GPU architecture
+ * (`10 * major + minor` of the compute capability) and the measured entries.
+ *
+ * No tables are embedded yet; `select_tile_config()` falls back to `default_tile_config()` for
+ * the architectures without a table.
+ */
+inline auto embedded_tile_tables() -> std::vector<std::pair<int, std::vector<tile_entry>>>
+{
+  return {};
+}
+
+}  // namespace raft::distance::detail
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/error.hpp>  // RAFT_FAIL
+
+#include <cstddef>  // size_t
+#include <string>   // std::string
+
+namespace raft::distance::detail {
+
+/** The tile configurations the pairwise distance kernels are compiled for. */
+enum class tile_config {
+  /** raft::linalg::Policy4x4: 64x64 output tiles, k-block of 32 (16 for double) */
+  kPolicy4x4,
+  /** raft::linalg::Policy4x4Skinny: 32x32 output tiles, k-block of 8 */
+  kPolicy4x4Skinny,
+};
+
+inline auto tile_config_to_string(tile_config tile) -> const char*
+{
+  switch (tile) {
+    case tile_config::kPolicy4x4: return "kPolicy4x4";
+    case tile_config::kPolicy4x4Skinny: return "kPolicy4x4Skinny";
+    default: return "unknown enum value";
+  }
+}
+
+inline auto tile_config_from_string(const std::string& name) -> tile_config
+{
+  for (auto tile : {tile_config::kPolicy4x4, tile_config::kPolicy4x4Skinny}) {
+    if (name == tile_config_to_string(tile)) { return tile; }
+  }
+  RAFT_FAIL("Unknown pairwise distance tile config '%s'", name.c_str());
+}
+
+/** A measured point of a tile table: the fastest tile configuration for the given shape. */
+struct tile_entry {
+  /** sizeof(DataT) */
+  int dtype_size;
+  size_t m;
+  size_t n;
+  size_t k;
+  tile_config tile;
+};
+
+}  // namespace raft::distance::detail
@@ -23,6 +23,9 @@
 #include <raft/util/raft_explicit.hpp>                  // RAFT_EXPLICIT
 #include <rmm/device_uvector.hpp>                       // rmm::device_uvector
 
+#include <cuda_bf16.h>  // nv_bfloat16
+#include <cuda_fp16.h>  // half
+
 #ifdef RAFT_EXPLICIT_INSTANTIATE_ONLY
 
 namespace raft {
@@ -140,6 +143,14 @@ void pairwise_distance(raft::resources const& handle,
                        raft::distance::DistanceType metric,
                        Type metric_arg = 2.0f) RAFT_EXPLICIT;
 
+template <typename DataT, typename IdxT = int>
+void pairwise_distance(raft::resources const& handle,
+                       device_matrix_view<const DataT, IdxT, row_major> const x,
+                       device_matrix_view<const DataT, IdxT, row_major> const y,
+                       device_matrix_view<float, IdxT, row_major> dist,
+                       raft::distance::DistanceType metric,
+                       float metric_arg = 2.0f) RAFT_EXPLICIT;
+
 };      // namespace distance
 };      // namespace raft
 
@@ -1063,3 +1074,17 @@ instantiate_raft_distance_pairwise_distance(double, raft::layout_c_contiguous, i
 instantiate_raft_distance_pairwise_distance(double, raft::layout_f_contiguous, int);
 
 #undef instantiate_raft_distance_pairwise_distance
+
+#define instantiate_raft_distance_pairwise_distance_half(DataT, IdxT)     \
+  extern template void raft::distance::pairwise_distance(                 \
+    raft::resources const& handle,                                        \
+    raft::device_matrix_view<const DataT, IdxT, raft::row_major> const x, \
+    raft::device_matrix_view<const DataT, IdxT, raft::row_major> const y, \
+    raft::device_matrix_view<float, IdxT, raft::row_major> dist,          \
+    raft::distance::DistanceType metric,                                  \
+    float metric_arg)
+
+instantiate_raft_distance_pairwise_distance_half(half, int);
+instantiate_raft_distance_pairwise_distance_half(nv_bfloat16, int);
+
+#undef instantiate_raft_distance_pairwise_distance_half
@@ -18,6 +18,7 @@
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/distance/detail/distance.cuh>
+#include <raft/distance/detail/pairwise_distance_half.cuh>
 #include <raft/distance/distance_types.hpp>
 #include <rmm/device_uvector.hpp>
 #include <type_traits>
@@ -471,6 +472,71 @@ void pairwise_distance(raft::resources const& handle,
                     metric_arg);
 }
 
+/**
+ * @brief Pairwise distance of the half-precision (fp16 or bf16) inputs
+ *
+ * The distances are accumulated and returned in fp32. The expanded metrics (L2Expanded,
+ * L2SqrtExpanded, CosineExpanded, InnerProduct, CorrelationExpanded) compute the inner products
+ * with cuBLAS on the tensor cores; the other metrics convert the input tiles to fp32 in shared
+ * memory. Unlike the fp32 / fp64 version, the inputs are not modified for KLDivergence and
+ * HellingerExpanded. BrayCurtis, DiceExpanded and JaccardExpanded are not supported.
+ *
+ * Usage example:
+ * @code{.cpp}
+ * #include <raft/core/resources.hpp>
+ * #include <raft/core/device_mdarray.hpp>
+ * #include <raft/distance/distance.cuh>
+ *
+ * raft::resources handle;
+ * int n_samples = 5000;
+ * int n_features = 50;
+ *
+ * auto x = raft::make_device_matrix<half>(handle, n_samples, n_features);
+ * // ... fill x
+ * auto output = raft::make_device_matrix<float>(handle, n_samples, n_samples);
+ *
+ * auto metric = raft::distance::DistanceType::L2SqrtExpanded;
+ * raft::distance::pairwise_distance(
+ *   handle, raft::make_const_mdspan(x.view()), raft::make_const_mdspan(x.view()), output.view(),
+ *   metric);
+ * @endcode
+ *
+ * @tparam DataT input data-type (half or nv_bfloat16)
+ * @tparam IdxT indexing type
+ * @param handle raft handle for managing expensive resources
+ * @param x first matrix of points (size mxk)
+ * @param y second matrix of points (size nxk)
+ * @param dist output distance matrix (size mxn)
+ * @param metric distance metric
+ * @param metric_arg metric argument (used for Minkowski distance)
+ */
+template <typename DataT, typename IdxT = int>
+void pairwise_distance(raft::resources const& handle,
+                       device_matrix_view<const DataT, IdxT, row_major> const x,
+                       device_matrix_view<const DataT, IdxT, row_major> const y,
+                       device_matrix_view<float, IdxT, row_major> dist,
+                       raft::distance::DistanceType metric,
+                       float metric_arg = 2.0f)
+{
+  RAFT_EXPECTS(x.extent(1) == y.extent(1), "Number of columns must be equal.");
+  RAFT_EXPECTS(dist.extent(0) == x.extent(0),
+               "Number of rows in output must be equal to "
+               "number of rows in X");
+  RAFT_EXPECTS(dist.extent(1) == y.extent(0),
+               "Number of columns in output must be equal to "
+               "number of rows in Y");
+
+  detail::pairwise_distance_half(handle,
+                                 x.data_handle(),
+                                 y.data_handle(),
+                                 dist.data_handle(),
+                                 x.extent(0),
+                                 y.extent(0),
+                                 x.extent(1),
+                                 metric,
+                                 metric_arg);
+}
+
 /** @} */
 
 };  // namespace distance
@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/error.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/detail/distance_with_norms.cuh>
+#include <raft/distance/distance_types.hpp>
+
+#include <optional>
+
+namespace raft::distance {
+
+/**
+ * @defgroup distance_operand Pairwise distance with precomputed norms
+ * @{
+ */
+
+/**
+ * @brief An input of the pairwise distance together with the norms of its rows
+ *
+ * The expanded metrics (L2Expanded, L2SqrtExpanded, CosineExpanded and CorrelationExpanded) are
+ * computed from the inner products and the norms of the rows of the inputs. By default,
+ * raft::distance::pairwise_distance computes the norms of both inputs in every call; an operand
+ * computes them once, so that the inputs that do not change between the calls (e.g. the dataset
+ * against which the batches of queries are searched) do not pay for them again.
+ *
+ * The operand refers to the data, which must outlive it, and owns the norms.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   #include <raft/distance/distance_operand.cuh>
+ *
+ *   auto metric = raft::distance::DistanceType::L2SqrtExpanded;
+ *   raft::distance::distance_operand<float, int> dataset_op(handle, dataset, metric);
+ *   for (auto queries : batches) {
+ *     raft::distance::distance_operand<float, int> queries_op(handle, queries, metric);
+ *     raft::distance::pairwise_distance(handle, queries_op, dataset_op, dist, metric);
+ *   }
+ * @endcode
+ *
+ * @tparam DataT input data-type (float or double)
+ * @tparam IdxT indexing type
+ */
+template <typename DataT, typename IdxT>
+class distance_operand {
+ public:
+  /**
+   * @brief Compute the norms of the rows of `data` used by the metric.
+   *
+   * @param[in] handle raft handle for managing expensive resources
+   * @param[in] data a row-major matrix of points
+   * @param[in] metric one of the expanded metrics
+   */
+  distance_operand(raft::resources const& handle,
+                   device_matrix_view<const DataT, IdxT, row_major> data,
+                   raft::distance::DistanceType metric)
+    : data_(data), metric_(metric), norms_(make_device_vector<DataT, IdxT>(handle, data.extent(0)))
+  {
+    RAFT_EXPECTS(detail::metric_uses_norms(metric),
+                 "distance_operand supports the expanded L2, cosine and correlation metrics only.");
+    if (detail::metric_uses_sums(metric)) {
+      sums_.emplace(make_device_vector<DataT, IdxT>(handle, data.extent(0)));
+    }
+    detail::compute_distance_norms(handle,
+                                   metric,
+                                   data.data_handle(),
+                                   data.extent(0),
+                                   data.extent(1),
+                                   norms_.data_handle(),
+                                   sums_.has_value() ? sums_->data_handle() : nullptr);
+  }
+
+  /** The points. */
+  [[nodiscard]] auto data() const -> device_matrix_view<const DataT, IdxT, row_major>
+  {
+    return data_;
+  }
+  /** The metric the norms are computed for. */
+  [[nodiscard]] auto metric() const -> raft::distance::DistanceType { return metric_; }
+  /** The norms of the rows: squared L2 norms, or L2 norms for the cosine distance. */
+  [[nodiscard]] auto norms() const -> device_vector_view<const DataT, IdxT>
+  {
+    return make_const_mdspan(norms_.view());
+  }
+  /** The sums of the rows (nullptr unless the metric is CorrelationExpanded). */
+  [[nodiscard]] auto sums() const -> const DataT*
+  {
+    return sums_.has_value() ? sums_->data_handle() : nullptr;
+  }
+
+ private:
+  device_matrix_view<const DataT, IdxT, row_major> data_;
+  raft::distance::DistanceType metric_;
+  device_vector<DataT, IdxT> norms_;
+  std::optional<device_vector<DataT, IdxT>> sums_;
+};
+
+/**
+ * @brief Compute the pairwise distances of two operands with precomputed norms
+ *
+ * @tparam DataT input data-type (float or double)
+ * @tparam IdxT indexing type
+ *
+ * @param[in] handle raft handle for managing expensive resources
+ * @param[in] x first operand (size m x k)
+ * @param[in] y second operand (size n x k)
+ * @param[out] dist the row-major distance matrix (size m x n)
+ * @param[in] metric distance metric; must use the norms of the operands (L2Expanded and
+ *            L2SqrtExpanded share the norms)
+ */
+template <typename DataT, typename IdxT>
+void pairwise_distance(raft::resources const& handle,
+                       const distance_operand<DataT, IdxT>& x,
+                       const distance_operand<DataT, IdxT>& y,
+                       device_matrix_view<DataT, IdxT, row_major> dist,
+                       raft::distance::DistanceType metric)
+{
+  RAFT_EXPECTS(detail::metric_norms_compatible(x.metric(), metric) &&
+                 detail::metric_norms_compatible(y.metric(), metric),
+               "The norms of the operands are not computed for the metric.");
+  RAFT_EXPECTS(x.data().extent(1) == y.data().extent(1), "Number of columns must be equal.");
+  RAFT_EXPECTS(dist.extent(0) == x.data().extent(0) && dist.extent(1) == y.data().extent(0),
+               "Incompatible output shape");
+  detail::distance_with_norms(handle,
+                              metric,
+                              x.data().data_handle(),
+                              y.data().data_handle(),
+                              x.norms().data_handle(),
+                              y.norms().data_handle(),
+                              x.sums(),
+                              y.sums(),
+                              dist.data_handle(),
+                              x.data().extent(0),
+                              y.data().extent(0),
+                              x.data().extent(1));
+}
+
+/**
+ * @brief Compute the pairwise distances with the norms of the rows provided by the caller
+ *
+ * The norms are the squared L2 norms for L2Expanded and L2SqrtExpanded and the L2 norms for
+ * CosineExpanded (CorrelationExpanded also needs the sums of the rows: use distance_operand).
+ *
+ * @tparam DataT input data-type (float or double)
+ * @tparam IdxT indexing type
+ *
+ * @param[in] handle raft handle for managing expensive resources
+ * @param[in] x first matrix of points (size m x k)
+ * @param[in] y second matrix of points (size n x k)
+ * @param[out] dist the row-major distance matrix (size m x n)
+ * @param[in] x_norm the norms of the rows of x (size m)
+ * @param[in] y_norm the norms of the rows of y (size n)
+ * @param[in] metric distance metric: L2Expanded, L2SqrtExpanded or CosineExpanded
+ */
+template <typename DataT, typename IdxT>
+void pairwise_distance(raft::resources const& handle,
+                       device_matrix_view<const DataT, IdxT, row_major> x,
+                       device_matrix_view<const DataT, IdxT, row_major> y,
+                       device_matrix_view<DataT, IdxT, row_major> dist,
+                       device_vector_view<const DataT, IdxT> x_norm,
+                       device_vector_view<const DataT, IdxT> y_norm,
+                       raft::distance::DistanceType metric)
+{
+  RAFT_EXPECTS(detail::metric_uses_norms(metric) && !detail::metric_uses_sums(metric),
+               "Only the expanded L2 and cosine metrics take the norms.");
+  RAFT_EXPECTS(x.extent(1) == y.extent(1), "Number of columns must be equal.");
+  RAFT_EXPECTS(dist.extent(0) == x.extent(0) && dist.extent(1) == y.extent(0),
+               "Incompatible output shape");
+  RAFT_EXPECTS(x_norm.extent(0) == x.extent(0) && y_norm.extent(0) == y.extent(0),
+               "Size of the norms must be equal to the number of rows");
+  detail::distance_with_norms<DataT, IdxT>(handle,
+                                           metric,
+                                           x.data_handle(),
+                                           y.data_handle(),
+                                           x_norm.data_handle(),
+                                           y_norm.data_handle(),
+                                           nullptr,
+                                           nullptr,
+                                           dist.data_handle(),
+                                           x.extent(0),
+                                           y.extent(0),
+                                           x.extent(1));
+}
+
+/** @} */
+
+}  // namespace raft::distance
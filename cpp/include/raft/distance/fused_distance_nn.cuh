@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/distance/detail/fused_l2_nn.cuh>
+#include <raft/distance/distance_types.hpp>
+#include <raft/distance/fused_l2_nn_helpers.cuh>
+#include <raft/linalg/contractions.cuh>
+#include <stdint.h>
+
+namespace raft {
+namespace distance {
+
+/**
+ * \ingroup fused_l2_nn
+ * @{
+ */
+/**
+ * @brief Fused distance and 1-nearest-neighbor computation in a single call.
+ *
+ * The same as raft::distance::fusedL2NN, for the following metrics:
+ * - L2Expanded, L2SqrtExpanded: `xn` and `yn` are the squared L2 norms
+ * - CosineExpanded: `xn` and `yn` are the L2 norms (not squared)
+ * - InnerProduct: `xn` and `yn` are not used and may be `nullptr`. The reduced distance is the
+ *   negated inner product, so that the nearest neighbor is the one with the largest inner product.
+ *
+ * @tparam DataT     data type
+ * @tparam OutT      output type to either store 1-NN indices and their minimum
+ *                   distances or store only the min distances. Accordingly, one
+ *                   has to pass an appropriate `ReduceOpT`
+ * @tparam IdxT      indexing arithmetic type
+ * @tparam ReduceOpT A struct to perform the final needed reduction operation
+ *                   and also to initialize the output array elements with the
+ *                   appropriate initial value needed for reduction.
+ *
+ * @param[out] min           will contain the reduced output (Length = `m`)
+ *                           (on device)
+ * @param[in]  x             first matrix. Row major. Dim = `m x k`.
+ *                           (on device).
+ * @param[in]  y             second matrix. Row major. Dim = `n x k`.
+ *                           (on device).
+ * @param[in]  xn            norm of `x` (see above). Length = `m`. (on device).
+ * @param[in]  yn            norm of `y` (see above). Length = `n`. (on device)
+ * @param[in]  m             gemm m
+ * @param[in]  n             gemm n
+ * @param[in]  k             gemm k
+ * @param[in]  workspace     temp workspace. Size = sizeof(int)*m. (on device)
+ * @param[in]  redOp         reduction operator in the epilogue
+ * @param[in]  pairRedOp     reduction operation on key value pairs
+ * @param[in]  metric        the distance metric
+ * @param[in]  initOutBuffer whether to initialize the output buffer before the
+ *                           main kernel launch
+ * @param[in]  stream        cuda stream
+ */
+template <typename DataT, typename OutT, typename IdxT, typename ReduceOpT, typename KVPReduceOpT>
+void fusedDistanceNN(OutT* min,
+                     const DataT* x,
+                     const DataT* y,
+                     const DataT* xn,
+                     const DataT* yn,
+                     IdxT m,
+                     IdxT n,
+                     IdxT k,
+                     void* workspace,
+                     ReduceOpT redOp,
+                     KVPReduceOpT pairRedOp,
+                     raft::distance::DistanceType metric,
+                     bool initOutBuffer,
+                     cudaStream_t stream)
+{
+  auto run = [&](auto policy) {
+    using Policy = decltype(policy);
+    detail::fusedDistanceNNImpl<DataT, OutT, IdxT, Policy, ReduceOpT>(min,
+                                                                      x,
+                                                                      y,
+                                                                      xn,
+                                                                      yn,
+                                                                      m,
+                                                                      n,
+                                                                      k,
+                                                                      (int*)workspace,
+                                                                      redOp,
+                                                                      pairRedOp,
+                                                                      metric,
+                                                                      initOutBuffer,
+                                                                      stream);
+  };
+
+  // When k is smaller than 32, the Policy4x4 results in redundant calculations
+  // as it uses tiles that have k=32. Therefore, use a "skinny" policy instead
+  // that uses tiles with a smaller value of k.
+  bool is_skinny = k < 32;
+
+  size_t bytes = sizeof(DataT) * k;
+  auto px      = reinterpret_cast<uintptr_t>(x);
+  auto py      = reinterpret_cast<uintptr_t>(y);
+  if (16 % sizeof(DataT) == 0 && bytes % 16 == 0 && px % 16 == 0 && py % 16 == 0) {
+    if (is_skinny) {
+      run(typename linalg::Policy4x4Skinny<DataT, 16 / sizeof(DataT)>::Policy{});
+    } else {
+      run(typename linalg::Policy4x4<DataT, 16 / sizeof(DataT)>::Policy{});
+    }
+  } else if (8 % sizeof(DataT) == 0 && bytes % 8 == 0 && px % 8 == 0 && py % 8 == 0) {
+    if (is_skinny) {
+      run(typename linalg::Policy4x4Skinny<DataT, 8 / sizeof(DataT)>::Policy{});
+    } else {
+      run(typename linalg::Policy4x4<DataT, 8 / sizeof(DataT)>::Policy{});
+    }
+  } else {
+    if (is_skinny) {
+      run(typename linalg::Policy4x4Skinny<DataT, 1>::Policy{});
+    } else {
+      run(typename linalg::Policy4x4<DataT, 1>::Policy{});
+    }
+  }
+}
+
+/**
+ * @brief Wrapper around fusedDistanceNN with minimum reduction operators.
+ *
+ * @tparam DataT     data type
+ * @tparam OutT      output type to either store 1-NN indices and their minimum
+ *                   distances (e.g. raft::KeyValuePair<int, float>) or store only the min
+ * distances.
+ * @tparam IdxT      indexing arithmetic type
+ * @param[out] min           will contain the reduced output (Length = `m`)
+ *                           (on device)
+ * @param[in]  x             first matrix. Row major. Dim = `m x k`.
+ *                           (on device).
+ * @param[in]  y             second matrix. Row major. Dim = `n x k`.
+ *                           (on device).
+ * @param[in]  xn            norm of `x` (see fusedDistanceNN). Length = `m`. (on device).
+ * @param[in]  yn            norm of `y` (see fusedDistanceNN). Length = `n`. (on device)
+ * @param[in]  m             gemm m
+ * @param[in]  n             gemm n
+ * @param[in]  k             gemm k
+ * @param[in]  workspace     temp workspace. Size = sizeof(int)*m. (on device)
+ * @param[in]  metric        the distance metric
+ * @param[in]  initOutBuffer whether to initialize the output buffer before the
+ *                           main kernel launch
+ * @param[in]  stream        cuda stream
+ */
+template <typename DataT, typename OutT, typename IdxT>
+void fusedDistanceNNMinReduce(OutT* min,
+                              const DataT* x,
+                              const DataT* y,
+                              const DataT* xn,
+                              const DataT* yn,
+                              IdxT m,
+                              IdxT n,
+                              IdxT k,
+                              void* workspace,
+                              raft::distance::DistanceType metric,
+                              bool initOutBuffer,
+                              cudaStream_t stream)
+{
+  MinAndDistanceReduceOp<IdxT, DataT> redOp;
+  KVPMinReduce<IdxT, DataT> pairRedOp;
+
+  fusedDistanceNN<DataT, OutT, IdxT>(
+    min, x, y, xn, yn, m, n, k, workspace, redOp, pairRedOp, metric, initOutBuffer, stream);
+}
+
+/** @} */
+
+}  // namespace distance
+}  // namespace raft
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <raft/distance/detail/kernels/batched_gram.cuh>
 #include <raft/distance/detail/kernels/gram_matrix.cuh>
 #include <raft/distance/detail/kernels/kernel_factory.cuh>
 #include <raft/util/cuda_utils.cuh>
@@ -29,4 +30,7 @@ namespace raft::distance::kernels {
 using raft::distance::kernels::detail::GramMatrixBase;
 using raft::distance::kernels::detail::KernelFactory;
 
+using raft::distance::kernels::detail::batched_gram_matrix;
+using raft::distance::kernels::detail::batched_matrix_view;
+
 };  // end namespace raft::distance::kernels
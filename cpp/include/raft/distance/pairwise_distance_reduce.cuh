@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/error.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/detail/pairwise_distance_reduce.cuh>
+#include <raft/distance/distance_types.hpp>
+
+namespace raft::distance {
+
+/**
+ * @defgroup pairwise_distance_reduce Fused pairwise distance and reduction
+ * @{
+ */
+
+/**
+ * @brief Reduce the rows (or the columns) of a pairwise distance matrix without materializing it
+ *
+ * Computes `out[i] = final_op(reduce_op(init, map_op(d(x_i, y_0), i, 0), ...,
+ * map_op(d(x_i, y_{n-1}), i, n - 1)))` for every row `i` of x when `along_rows` is true, and the
+ * same for every row of y over the rows of x otherwise. The distances are reduced in the epilog of
+ * the tiled distance kernel, so the memory used does not depend on the size of the distance
+ * matrix.
+ *
+ * Examples of the reductions are the number of neighbors within a radius (map: `d <= eps`,
+ * reduce: `raft::add_op`), the row sums of a kernel matrix, or the distance to the nearest
+ * neighbor (map: `raft::identity_op`, reduce: `raft::min_op`).
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   #include <raft/distance/pairwise_distance_reduce.cuh>
+ *
+ *   // the number of the rows of y within the distance eps of every row of x
+ *   auto counts = raft::make_device_vector<int, int>(handle, x.extent(0));
+ *   raft::distance::pairwise_distance_reduce(
+ *     handle,
+ *     x,
+ *     y,
+ *     counts.view(),
+ *     raft::distance::DistanceType::L2SqrtExpanded,
+ *     0,
+ *     [eps] __device__(float d, int, int) { return int(d <= eps); },
+ *     raft::add_op{});
+ * @endcode
+ *
+ * The supported metrics are L2Expanded, L2SqrtExpanded, CosineExpanded, L2Unexpanded,
+ * L2SqrtUnexpanded, L1, Linf, Canberra, LpUnexpanded, HammingUnexpanded, JensenShannon and
+ * RusselRaoExpanded.
+ *
+ * @tparam DataT input data-type (float or double)
+ * @tparam OutT type of the reduced values; one of the types supported by raft::myAtomicReduce
+ * @tparam IdxT indexing type
+ * @tparam MapOpT device operation `(DataT d, IdxT row, IdxT col) -> OutT` applied to the distance
+ *         of x[row] and y[col]
+ * @tparam ReduceOpT commutative and associative device operation `(OutT, OutT) -> OutT`
+ * @tparam FinalOpT device operation `OutT -> OutT` applied to the reduced values
+ *
+ * @param[in] handle raft handle for managing expensive resources
+ * @param[in] x first matrix of points (size m x k)
+ * @param[in] y second matrix of points (size n x k)
+ * @param[out] out the reduced values (size m when `along_rows`, n otherwise)
+ * @param[in] metric distance metric
+ * @param[in] init the identity of the reduction
+ * @param[in] map_op the operation applied to every distance before the reduction
+ * @param[in] reduce_op the reduction operation
+ * @param[in] along_rows whether to reduce every row (true) or every column (false) of the distance
+ *            matrix
+ * @param[in] final_op the operation applied to the reduced values
+ * @param[in] metric_arg metric argument (used for Minkowski distance)
+ */
+template <typename DataT,
+          typename OutT,
+          typename IdxT,
+          typename MapOpT,
+          typename ReduceOpT,
+          typename FinalOpT = raft::identity_op>
+void pairwise_distance_reduce(raft::resources const& handle,
+                              device_matrix_view<const DataT, IdxT, row_major> x,
+                              device_matrix_view<const DataT, IdxT, row_major> y,
+                              device_vector_view<OutT, IdxT> out,
+                              raft::distance::DistanceType metric,
+                              OutT init,
+                              MapOpT map_op,
+                              ReduceOpT reduce_op,
+                              bool along_rows   = true,
+                              FinalOpT final_op = raft::identity_op{},
+                              DataT metric_arg  = 2.0f)
+{
+  RAFT_EXPECTS(x.extent(1) == y.extent(1), "Number of columns must be equal.");
+  RAFT_EXPECTS(out.extent(0) == (along_rows ? x.extent(0) : y.extent(0)),
+               "Size of the output must be equal to the number of rows of the reduced input");
+
+  detail::pairwise_distance_reduce(handle,
+                                   x.data_handle(),
+                                   y.data_handle(),
+                                   out.data_handle(),
+                                   x.extent(0),
+                                   y.extent(0),
+                                   x.extent(1),
+                                   metric,
+                                   init,
+                                   map_op,
+                                   reduce_op,
+                                   final_op,
+                                   along_rows,
+                                   metric_arg);
+}
+
+/** @} */
+
+}  // namespace raft::distance
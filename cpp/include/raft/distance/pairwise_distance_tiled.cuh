@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/host_mdspan.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/detail/pairwise_distance_tiled.cuh>
+#include <raft/distance/distance_types.hpp>
+
+namespace raft::distance {
+
+/**
+ * @defgroup pairwise_distance_tiled Pairwise distance in tiles of bounded size
+ * @{
+ */
+
+/**
+ * @brief Compute the pairwise distance matrix tile by tile, passing every tile to a callback
+ *
+ * The `m x n` distance matrix is never materialized: the distances are computed into a single
+ * device buffer of at most `max_tile_bytes`, one tile of consecutive rows (or of a part of a row,
+ * when a whole row does not fit) at a time. This allows all-pairs computations over inputs whose
+ * distance matrix does not fit into the device memory, without tiling by the caller.
+ *
+ * `tile_op(tile, row_offset, col_offset)` is called on the host for every tile, after the
+ * distances of the tile have been enqueued on the stream of the handle; `tile(i, j)` is the
+ * distance of `x[row_offset + i]` and `y[col_offset + j]`. The work consuming the tile must be
+ * enqueued on the same stream: the buffer is overwritten by the next tile.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   #include <raft/distance/pairwise_distance_tiled.cuh>
+ *
+ *   raft::distance::pairwise_distance_tiled(
+ *     handle,
+ *     x,
+ *     y,
+ *     raft::distance::DistanceType::L2SqrtExpanded,
+ *     [&](raft::device_matrix_view<const float, int> tile, int row_offset, int col_offset) {
+ *       // consume the tile in the stream of the handle
+ *     });
+ * @endcode
+ *
+ * @tparam DataT input data-type (float or double)
+ * @tparam IdxT indexing type
+ * @tparam TileOpT host callable
+ *         `(device_matrix_view<const DataT, IdxT, row_major>, IdxT row_offset, IdxT col_offset)`
+ *
+ * @param[in] handle raft handle for managing expensive resources
+ * @param[in] x first matrix of points (size m x k)
+ * @param[in] y second matrix of points (size n x k)
+ * @param[in] metric distance metric
+ * @param[in] tile_op the consumer of the tiles
+ * @param[in] max_tile_bytes the upper bound of the size of the tile buffer; zero to use at most
+ *            half of the free device memory
+ * @param[in] metric_arg metric argument (used for Minkowski distance)
+ */
+template <typename DataT, typename IdxT, typename TileOpT>
+void pairwise_distance_tiled(raft::resources const& handle,
+                             device_matrix_view<const DataT, IdxT, row_major> x,
+                             device_matrix_view<const DataT, IdxT, row_major> y,
+                             raft::distance::DistanceType metric,
+                             TileOpT tile_op,
+                             size_t max_tile_bytes = 0,
+                             DataT metric_arg      = 2.0f)
+{
+  detail::pairwise_distance_tiled(handle, x, y, metric, tile_op, max_tile_bytes, metric_arg);
+}
+
+/**
+ * @brief Compute the pairwise distance matrix into host memory, tile by tile
+ *
+ * The distances are computed in tiles of at most `max_tile_bytes` (see the callback overload) and
+ * copied to the host through a pair of pinned buffers, so that the host writes one tile into
+ * `dist` while the device computes the next one. The size of the pinned buffers is bounded
+ * independently of `max_tile_bytes`. The function returns when `dist` is complete.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   #include <raft/distance/pairwise_distance_tiled.cuh>
+ *
+ *   auto dist = raft::make_host_matrix<float, int64_t>(x.extent(0), y.extent(0));
+ *   raft::distance::pairwise_distance_tiled(
+ *     handle, x, y, dist.view(), raft::distance::DistanceType::L2Expanded);
+ * @endcode
+ *
+ * @tparam DataT input data-type (float or double)
+ * @tparam IdxT indexing type
+ *
+ * @param[in] handle raft handle for managing expensive resources
+ * @param[in] x first matrix of points (size m x k)
+ * @param[in] y second matrix of points (size n x k)
+ * @param[out] dist host matrix of the distances (size m x n)
+ * @param[in] metric distance metric
+ * @param[in] max_tile_bytes the upper bound of the size of a tile; zero for the default
+ * @param[in] metric_arg metric argument (used for Minkowski distance)
+ */
+template <typename DataT, typename IdxT>
+void pairwise_distance_tiled(raft::resources const& handle,
+                             device_matrix_view<const DataT, IdxT, row_major> x,
+                             device_matrix_view<const DataT, IdxT, row_major> y,
+                             host_matrix_view<DataT, IdxT, row_major> dist,
+                             raft::distance::DistanceType metric,
+                             size_t max_tile_bytes = 0,
+                             DataT metric_arg      = 2.0f)
+{
+  detail::pairwise_distance_tiled(handle, x, y, dist, metric, max_tile_bytes, metric_arg);
+}
+
+/** @} */
+
+}  // namespace raft::distance
@@ -24,13 +24,203 @@
 #include <raft/util/cudart_utils.hpp>
 #include <rmm/device_scalar.hpp>
 #include <rmm/device_uvector.hpp>
+#include <rmm/exec_policy.hpp>
+
+#include <thrust/fill.h>
 
 #include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
 
 namespace raft {
 namespace label {
 namespace detail {
 
+template <typename value_t>
+constexpr bool hashable_labels_v =
+  std::is_integral_v<value_t> && (sizeof(value_t) == 4 || sizeof(value_t) == 8);
+
+/** Sentinel of the empty slots of the label hash table; the label equal to it is tracked aside. */
+template <typename value_t>
+constexpr value_t empty_label_slot()
+{
+  return std::numeric_limits<value_t>::max();
+}
+
+template <typename value_t>
+__device__ __forceinline__ size_t label_slot(value_t label, size_t capacity_mask)
+{
+  // the 64 bit finalizer of MurmurHash3
+  uint64_t bits = static_cast<uint64_t>(label);
+  bits ^= bits >> 33;
+  bits *= 0xff51afd7ed558ccdull;
+  bits ^= bits >> 33;
+  bits *= 0xc4ceb9fe1a85ec53ull;
+  bits ^= bits >> 33;
+  return static_cast<size_t>(bits) & capacity_mask;
+}
+
+template <typename value_t>
+__device__ __forceinline__ value_t cas_label_slot(value_t* address, value_t compare, value_t val)
+{
+  if constexpr (sizeof(value_t) == 4) {
+    return atomicCAS(reinterpret_cast<unsigned int*>(address),
+                     static_cast<unsigned int>(compare),
+                     static_cast<unsigned int>(val));
+  } else {
+    return atomicCAS(reinterpret_cast<unsigned long long int*>(address),
+                     static_cast<unsigned long long int>(compare),
+                     static_cast<unsigned long long int>(val));
+  }
+}
+
+/** Insert every label in the open addressing (linear probing) table of the unique labels. */
+template <typename value_t, int TPB_X>
+__global__ void insert_labels_kernel(
+  const value_t* in, size_t N, value_t* keys, size_t capacity_mask, bool* has_empty_label)
+{
+  size_t tid = threadIdx.x + static_cast<size_t>(blockIdx.x) * TPB_X;
+  if (tid >= N) return;
+  value_t label = in[tid];
+  if (label == empty_label_slot<value_t>()) {
+    *has_empty_label = true;
+    return;
+  }
+  size_t slot = label_slot(label, capacity_mask);
+  while (true) {
+    value_t prev = cas_label_slot(keys + slot, empty_label_slot<value_t>(), label);
+    if (prev == empty_label_slot<value_t>() || prev == label) return;
+    slot = (slot + 1) & capacity_mask;
+  }
+}
+
+template <typename value_t>
+__device__ __forceinline__ size_t find_label_slot(const value_t* keys,
+                                                  size_t capacity_mask,
+                                                  value_t label)
+{
+  size_t slot = label_slot(label, capacity_mask);
+  while (keys[slot] != label) {
+    slot = (slot + 1) & capacity_mask;
+  }
+  return slot;
+}
+
+/** Store the rank of every unique label in its slot of the table. */
+template <typename value_t, int TPB_X>
+__global__ void rank_labels_kernel(const value_t* unique,
+                                   size_t n_unique,
+                                   const value_t* keys,
+                                   size_t capacity_mask,
+                                   value_t* ranks)
+{
+  size_t tid = threadIdx.x + static_cast<size_t>(blockIdx.x) * TPB_X;
+  if (tid >= n_unique || unique[tid] == empty_label_slot<value_t>()) return;
+  ranks[find_label_slot(keys, capacity_mask, unique[tid])] = tid;
+}
+
+template <typename value_t>
+struct occupied_label_slot {
+  __device__ bool operator()(value_t key) const { return key != empty_label_slot<value_t>(); }
+};
+
+/**
+ * The set of the unique labels of an array of integral labels, as an open addressing hash table:
+ * building it is linear in the number of labels, and only the unique labels are sorted, rather
+ * than the whole array.
+ */
+template <typename value_t>
+struct label_hash_table {
+  static constexpr int TPB_X = 256;
+
+  label_hash_table(const value_t* y, size_t n, cudaStream_t stream)
+    : capacity(table_capacity(n)),
+      keys(capacity, stream),
+      ranks(0, stream),
+      unique(0, stream)
+  {
+    rmm::device_scalar<bool> has_empty_label(false, stream);
+    thrust::fill(rmm::exec_policy(stream), keys.begin(), keys.end(), empty_label_slot<value_t>());
+    if (n > 0) {
+      insert_labels_kernel<value_t, TPB_X><<<raft::ceildiv(n, size_t(TPB_X)), TPB_X, 0, stream>>>(
+        y, n, keys.data(), capacity - 1, has_empty_label.data());
+      RAFT_CUDA_TRY(cudaPeekAtLastError());
+    }
+
+    // Select and sort the unique labels; the sentinel, if it is a label, is the largest one
+    rmm::device_scalar<size_t> d_num_selected(stream);
+    rmm::device_uvector<value_t> selected(n, stream);
+    occupied_label_slot<value_t> not_empty;
+    size_t bytes = 0;
+    cub::DeviceSelect::If(nullptr,
+                          bytes,
+                          keys.data(),
+                          selected.data(),
+                          d_num_selected.data(),
+                          capacity,
+                          not_empty,
+                          stream);
+    rmm::device_uvector<char> cub_storage(bytes, stream);
+    cub::DeviceSelect::If(cub_storage.data(),
+                          bytes,
+                          keys.data(),
+                          selected.data(),
+                          d_num_selected.data(),
+                          capacity,
+                          not_empty,
+                          stream);
+    size_t n_selected = d_num_selected.value(stream);
+    n_unique          = n_selected + has_empty_label.value(stream);
+
+    unique.resize(n_unique, stream);
+    bytes = 0;
+    cub::DeviceRadixSort::SortKeys(
+      nullptr, bytes, selected.data(), unique.data(), n_selected, 0, sizeof(value_t) * 8, stream);
+    cub_storage.resize(bytes, stream);
+    cub::DeviceRadixSort::SortKeys(cub_storage.data(),
+                                   bytes,
+                                   selected.data(),
+                                   unique.data(),
+                                   n_selected,
+                                   0,
+                                   sizeof(value_t) * 8,
+                                   stream);
+    if (n_unique > n_selected) {
+      value_t empty = empty_label_slot<value_t>();
+      raft::update_device(unique.data() + n_selected, &empty, 1, stream);
+    }
+  }
+
+  /** A power of two, at least twice the number of labels: the load factor is at most 1/2. */
+  static size_t table_capacity(size_t n)
+  {
+    size_t capacity = 2;
+    while (capacity < 2 * n) {
+      capacity <<= 1;
+    }
+    return capacity;
+  }
+
+  /** Store the rank of every unique label in its slot of the table. */
+  void rank(cudaStream_t stream)
+  {
+    ranks.resize(capacity, stream);
+    if (n_unique == 0) return;
+    rank_labels_kernel<value_t, TPB_X>
+      <<<raft::ceildiv(n_unique, size_t(TPB_X)), TPB_X, 0, stream>>>(
+        unique.data(), n_unique, keys.data(), capacity - 1, ranks.data());
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+  }
+
+  size_t capacity;
+  size_t n_unique;
+  rmm::device_uvector<value_t> keys;
+  rmm::device_uvector<value_t> ranks;
+  /** the unique labels, sorted */
+  rmm::device_uvector<value_t> unique;
+};
+
 /**
  * Get unique class labels.
  *
@@ -48,37 +238,43 @@ namespace detail {
 template <typename value_t>
 int getUniquelabels(rmm::device_uvector<value_t>& unique, value_t* y, size_t n, cudaStream_t stream)
 {
-  rmm::device_scalar<int> d_num_selected(stream);
-  rmm::device_uvector<value_t> workspace(n, stream);
-  size_t bytes  = 0;
-  size_t bytes2 = 0;
-
-  // Query how much temporary storage we will need for cub operations
-  // and allocate it
-  cub::DeviceRadixSort::SortKeys(
-    NULL, bytes, y, workspace.data(), n, 0, sizeof(value_t) * 8, stream);
-  cub::DeviceSelect::Unique(
-    NULL, bytes2, workspace.data(), workspace.data(), d_num_selected.data(), n, stream);
-  bytes = std::max(bytes, bytes2);
-  rmm::device_uvector<char> cub_storage(bytes, stream);
-
-  // Select Unique classes
-  cub::DeviceRadixSort::SortKeys(
-    cub_storage.data(), bytes, y, workspace.data(), n, 0, sizeof(value_t) * 8, stream);
-  cub::DeviceSelect::Unique(cub_storage.data(),
-                            bytes,
-                            workspace.data(),
-                            workspace.data(),
-                            d_num_selected.data(),
-                            n,
-                            stream);
-
-  int n_unique = d_num_selected.value(stream);
-  // Copy unique classes to output
-  unique.resize(n_unique, stream);
-  raft::copy(unique.data(), workspace.data(), n_unique, stream);
-
-  return n_unique;
+  if constexpr (hashable_labels_v<value_t>) {
+    label_hash_table<value_t> table(y, n, stream);
+    unique = std::move(table.unique);
+    return table.n_unique;
+  } else {
+    rmm::device_scalar<int> d_num_selected(stream);
+    rmm::device_uvector<value_t> workspace(n, stream);
+    size_t bytes  = 0;
+    size_t bytes2 = 0;
+
+    // Query how much temporary storage we will need for cub operations
+    // and allocate it
+    cub::DeviceRadixSort::SortKeys(
+      NULL, bytes, y, workspace.data(), n, 0, sizeof(value_t) * 8, stream);
+    cub::DeviceSelect::Unique(
+      NULL, bytes2, workspace.data(), workspace.data(), d_num_selected.data(), n, stream);
+    bytes = std::max(bytes, bytes2);
+    rmm::device_uvector<char> cub_storage(bytes, stream);
+
+    // Select Unique classes
+    cub::DeviceRadixSort::SortKeys(
+      cub_storage.data(), bytes, y, workspace.data(), n, 0, sizeof(value_t) * 8, stream);
+    cub::DeviceSelect::Unique(cub_storage.data(),
+                              bytes,
+                              workspace.data(),
+                              workspace.data(),
+                              d_num_selected.data(),
+                              n,
+                              stream);
+
+    int n_unique = d_num_selected.value(stream);
+    // Copy unique classes to output
+    unique.resize(n_unique, stream);
+    raft::copy(unique.data(), workspace.data(), n_unique, stream);
+
+    return n_unique;
+  }
 }
 
 /**
@@ -159,6 +355,30 @@ __global__ void map_label_kernel(Type* map_ids,
  * @param filter_op an optional function for specifying which values
  * should have monotonically increasing labels applied to them.
  */
+template <typename Type, int TPB_X, typename Lambda>
+__global__ void map_hashed_label_kernel(const Type* keys,
+                                        const Type* ranks,
+                                        size_t capacity_mask,
+                                        Type empty_rank,
+                                        Type* in,
+                                        Type* out,
+                                        size_t N,
+                                        Lambda filter_op,
+                                        bool zero_based)
+{
+  size_t tid = threadIdx.x + static_cast<size_t>(blockIdx.x) * TPB_X;
+  if (tid < N) {
+    Type label = in[tid];
+    if (!filter_op(label)) {
+      Type rank = empty_rank;
+      if (label != empty_label_slot<Type>()) {
+        rank = ranks[find_label_slot(keys, capacity_mask, label)];
+      }
+      out[tid] = rank + !zero_based;
+    }
+  }
+}
+
 template <typename Type, typename Lambda>
 void make_monotonic(
   Type* out, Type* in, size_t N, cudaStream_t stream, Lambda filter_op, bool zero_based = false)
@@ -168,11 +388,28 @@ void make_monotonic(
   dim3 blocks(raft::ceildiv(N, TPB_X));
   dim3 threads(TPB_X);
 
-  rmm::device_uvector<Type> map_ids(0, stream);
-  int num_clusters = getUniquelabels(map_ids, in, N, stream);
+  if constexpr (hashable_labels_v<Type>) {
+    // a hash table lookup per label, instead of a linear search among the unique labels
+    label_hash_table<Type> table(in, N, stream);
+    table.rank(stream);
+    if (N == 0) return;
+    map_hashed_label_kernel<Type, TPB_X><<<blocks, threads, 0, stream>>>(table.keys.data(),
+                                                                         table.ranks.data(),
+                                                                         table.capacity - 1,
+                                                                         Type(table.n_unique - 1),
+                                                                         in,
+                                                                         out,
+                                                                         N,
+                                                                         filter_op,
+                                                                         zero_based);
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+  } else {
+    rmm::device_uvector<Type> map_ids(0, stream);
+    int num_clusters = getUniquelabels(map_ids, in, N, stream);
 
-  map_label_kernel<Type, TPB_X><<<blocks, threads, 0, stream>>>(
-    map_ids.data(), num_clusters, in, out, N, filter_op, zero_based);
+    map_label_kernel<Type, TPB_X><<<blocks, threads, 0, stream>>>(
+      map_ids.data(), num_clusters, in, out, N, filter_op, zero_based);
+  }
 }
 
 /**
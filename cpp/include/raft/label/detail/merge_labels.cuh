@@ -27,40 +27,85 @@ namespace raft {
 namespace label {
 namespace detail {
 
-/** Note: this is one possible implementation where we represent the label
- *  equivalence graph implicitly using labels_a, labels_b and mask.
- *  For an additional cost we can build the graph with edges
- *  E={(A[i], B[i]) | M[i]=1} and make this step faster */
+/** Find the root of the set of x in the union-find forest R, halving the path on the way. The
+ *  concurrent writes only ever replace a parent by one of its ancestors, so they are benign. */
+template <typename value_idx>
+__device__ value_idx find_label_root(value_idx* R, value_idx x)
+{
+  volatile value_idx* vR = R;
+  value_idx parent       = vR[x];
+  while (parent != x) {
+    value_idx grandparent = vR[parent];
+    if (grandparent != parent) { vR[x] = grandparent; }
+    x      = parent;
+    parent = grandparent;
+  }
+  return x;
+}
+
+template <typename value_idx>
+__device__ value_idx cas_label(value_idx* address, value_idx compare, value_idx val)
+{
+  static_assert(sizeof(value_idx) == 4 || sizeof(value_idx) == 8,
+                "The labels must be 32 or 64 bit integers");
+  if constexpr (sizeof(value_idx) == 4) {
+    return atomicCAS(reinterpret_cast<unsigned int*>(address),
+                     static_cast<unsigned int>(compare),
+                     static_cast<unsigned int>(val));
+  } else {
+    return atomicCAS(reinterpret_cast<unsigned long long int*>(address),
+                     static_cast<unsigned long long int>(compare),
+                     static_cast<unsigned long long int>(val));
+  }
+}
+
+/** Note: the label equivalence graph is represented implicitly using labels_a, labels_b and
+ *  mask: each masked point is an edge, and its two labels are united asynchronously in the
+ *  union-find forest R (ECL-CC style). The larger root is always linked under the smaller
+ *  one, so the root of a set is its smallest label and a single pass converges. */
 template <typename value_idx, int TPB_X = 256>
 __global__ void __launch_bounds__(TPB_X)
-  propagate_label_kernel(const value_idx* __restrict__ labels_a,
-                         const value_idx* __restrict__ labels_b,
-                         value_idx* __restrict__ R,
-                         const bool* __restrict__ mask,
-                         bool* __restrict__ m,
-                         value_idx N)
+  union_label_kernel(const value_idx* __restrict__ labels_a,
+                     const value_idx* __restrict__ labels_b,
+                     value_idx* R,
+                     const bool* __restrict__ mask,
+                     value_idx N)
 {
   value_idx tid = threadIdx.x + blockIdx.x * TPB_X;
-  if (tid < N) {
-    if (__ldg((char*)mask + tid)) {
-      // Note: labels are from 1 to N
-      value_idx la = __ldg(labels_a + tid) - 1;
-      value_idx lb = __ldg(labels_b + tid) - 1;
-      value_idx ra = R[la];
-      value_idx rb = R[lb];
-      if (ra != rb) {
-        *m = true;
-        // min(ra, rb) would be sufficient but this speeds up convergence
-        value_idx rmin = R[min(ra, rb)];
-        if (sizeof(value_idx) == 4) {
-          atomicMin((int*)(R + la), rmin);
-          atomicMin((int*)(R + lb), rmin);
-        } else if (sizeof(value_idx) == 8) {
-          atomicMin((long long int*)(R + la), rmin);
-          atomicMin((long long int*)(R + lb), rmin);
-        }
+  if (tid < N && __ldg((char*)mask + tid)) {
+    // Note: labels are from 1 to N
+    value_idx ra = find_label_root(R, __ldg(labels_a + tid) - 1);
+    value_idx rb = find_label_root(R, __ldg(labels_b + tid) - 1);
+    while (ra != rb) {
+      if (ra > rb) {
+        value_idx tmp = ra;
+        ra            = rb;
+        rb            = tmp;
       }
+      // link the root rb under ra, unless another thread has given it a parent meanwhile
+      value_idx old = cas_label(R + rb, rb, ra);
+      if (old == rb) { break; }
+      rb = find_label_root(R, old);
+      ra = find_label_root(R, ra);
+    }
+  }
+}
+
+/** Point every label of R directly to the root of its set. The traversal does not halve the
+ *  paths: it could otherwise overwrite a root already stored by the thread of another label. */
+template <typename value_idx, int TPB_X = 256>
+__global__ void __launch_bounds__(TPB_X) compress_label_kernel(value_idx* R, value_idx N)
+{
+  value_idx tid = threadIdx.x + blockIdx.x * TPB_X;
+  if (tid < N) {
+    volatile value_idx* vR = R;
+    value_idx root         = tid;
+    value_idx parent       = vR[root];
+    while (parent != root) {
+      root   = parent;
+      parent = vR[root];
     }
+    R[tid] = root;
   }
 }
 
@@ -108,7 +153,7 @@ __global__ void __launch_bounds__(TPB_X)
  * @param[in]    labels_b    Second input label array
  * @param[in]    mask        Core point mask
  * @param[out]   R           label equivalence map
- * @param[in]    m           Working flag
+ * @param[in]    m           Unused, kept for compatibility
  * @param[in]    N           Number of points in the dataset
  * @param[in]    stream      CUDA stream
  */
@@ -135,18 +180,13 @@ void merge_labels(value_idx* labels_a,
   // The edges connect groups from the two labellings. Only points with true
   // mask can induce connection between groups.
 
-  // Step 1: compute connected components in the label equivalence graph
-  bool host_m;
-  do {
-    RAFT_CUDA_TRY(cudaMemsetAsync(m, false, sizeof(bool), stream));
-
-    propagate_label_kernel<value_idx, TPB_X>
-      <<<blocks, threads, 0, stream>>>(labels_a, labels_b, R, mask, m, N);
-    RAFT_CUDA_TRY(cudaPeekAtLastError());
-
-    raft::update_host(&host_m, m, 1, stream);
-    RAFT_CUDA_TRY(cudaStreamSynchronize(stream));
-  } while (host_m);
+  // Step 1: compute connected components in the label equivalence graph, with no host
+  // synchronization
+  union_label_kernel<value_idx, TPB_X>
+    <<<blocks, threads, 0, stream>>>(labels_a, labels_b, R, mask, N);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+  compress_label_kernel<value_idx, TPB_X><<<blocks, threads, 0, stream>>>(R, N);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
 
   // Step 2: re-assign minimum equivalent label
   reassign_label_kernel<value_idx, TPB_X>
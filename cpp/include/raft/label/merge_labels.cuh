@@ -45,11 +45,14 @@ namespace label {
  * represent the connected components of graphs G_A and G_B, and the output
  * would be the connected components labels of G_A \union G_B.
  *
+ * The equivalent labels are united in a union-find forest in a single pass, so the merge is
+ * asynchronous with respect to the host.
+ *
  * @param[inout] labels_a    First input, and output label array (in-place)
  * @param[in]    labels_b    Second input label array
  * @param[in]    mask        Core point mask
  * @param[out]   R           label equivalence map
- * @param[in]    m           Working flag
+ * @param[in]    m           Unused, kept for compatibility
  * @param[in]    N           Number of points in the dataset
  * @param[in]    stream      CUDA stream
  */
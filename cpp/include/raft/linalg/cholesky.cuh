@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef __CHOLESKY_H
+#define __CHOLESKY_H
+
+#pragma once
+
+#include "detail/cholesky.cuh"
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/linalg/linalg_types.hpp>
+
+#include <optional>
+
+namespace raft {
+namespace linalg {
+
+/**
+ * @defgroup cholesky Cholesky decomposition
+ * @{
+ */
+
+/**
+ * @brief In-place Cholesky decomposition of a batch of symmetric positive definite matrices
+ *
+ * All the matrices are factorized by a single batched cuSOLVER call. Viewed row-major, the upper
+ * triangle of each matrix is overwritten by the factor U such that A = U^T * U; the strict lower
+ * triangle is left unchanged.
+ *
+ * @tparam ValueType the data-type of input and output
+ * @tparam IndexType Integer used for addressing
+ * @param[in] handle raft::resources
+ * @param[inout] A the matrices, raft::device_batch_matrix_view [batch, n, n]
+ * @param[out] info optional status of each factorization [batch]: 0 on success, i > 0 when the
+ *   leading minor of order i is not positive definite
+ */
+template <typename ValueType, typename IndexType>
+void cholesky_batched(raft::resources const& handle,
+                      device_batch_matrix_view<ValueType, IndexType> A,
+                      std::optional<raft::device_vector_view<int, IndexType>> info = std::nullopt)
+{
+  RAFT_EXPECTS(A.extent(1) == A.extent(2), "The input matrices should be square");
+  int* info_ptr = nullptr;
+  if (info) {
+    RAFT_EXPECTS(info.value().extent(0) == A.extent(0), "info should have one entry per matrix");
+    info_ptr = info.value().data_handle();
+  }
+  detail::choleskyBatched(handle, A.data_handle(), A.extent(0), A.extent(1), info_ptr);
+}
+
+/** @} */  // end of group cholesky
+
+};  // end namespace linalg
+};  // end namespace raft
+
+#endif
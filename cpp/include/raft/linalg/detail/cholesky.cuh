@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "cusolver_wrappers.hpp"
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/cusolver_dn_handle.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/util/cudart_utils.hpp>
+#include <rmm/device_uvector.hpp>
+
+#include <thrust/tabulate.h>
+
+namespace raft {
+namespace linalg {
+namespace detail {
+
+/**
+ * Factorize `batch_size` contiguous column-major [n x n] matrices in place with one call to
+ * potrfBatched; the lower triangles are overwritten by the factors L, A = L * L^T.
+ */
+template <typename math_t, typename idx_t>
+void choleskyBatched(raft::resources const& handle, math_t* A, idx_t batch_size, idx_t n, int* info)
+{
+  auto stream                  = resource::get_cuda_stream(handle);
+  cusolverDnHandle_t cusolverH = resource::get_cusolver_dn_handle(handle);
+
+  size_t stride = static_cast<size_t>(n) * n;
+  rmm::device_uvector<math_t*> ptrs(batch_size, stream);
+  thrust::tabulate(resource::get_thrust_policy(handle),
+                   ptrs.begin(),
+                   ptrs.end(),
+                   [A, stride] __device__(size_t i) { return A + i * stride; });
+
+  rmm::device_uvector<int> dev_info(info == nullptr ? batch_size : 0, stream);
+  // potrfBatched supports the lower fill mode only
+  RAFT_CUSOLVER_TRY(cusolverDnpotrfBatched(cusolverH,
+                                           CUBLAS_FILL_MODE_LOWER,
+                                           n,
+                                           ptrs.data(),
+                                           n,
+                                           info == nullptr ? dev_info.data() : info,
+                                           batch_size,
+                                           stream));
+  RAFT_CUDA_TRY(cudaGetLastError());
+}
+
+}  // namespace detail
+}  // namespace linalg
+}  // namespace raft
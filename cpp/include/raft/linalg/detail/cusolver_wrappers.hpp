@@ -299,6 +299,115 @@ inline cusolverStatus_t cusolverDnsyevj_bufferSize(  // NOLINT
 }
 /** @} */
 
+/**
+ * @defgroup syevjBatched cusolver syevjBatched operations
+ * @{
+ */
+template <typename T>
+cusolverStatus_t cusolverDnsyevjBatched_bufferSize(  // NOLINT
+  cusolverDnHandle_t handle,
+  cusolverEigMode_t jobz,
+  cublasFillMode_t uplo,
+  int n,
+  const T* A,
+  int lda,
+  const T* W,
+  int* lwork,
+  syevjInfo_t params,
+  int batchSize);
+
+template <>
+inline cusolverStatus_t cusolverDnsyevjBatched_bufferSize(  // NOLINT
+  cusolverDnHandle_t handle,
+  cusolverEigMode_t jobz,
+  cublasFillMode_t uplo,
+  int n,
+  const float* A,
+  int lda,
+  const float* W,
+  int* lwork,
+  syevjInfo_t params,
+  int batchSize)
+{
+  return cusolverDnSsyevjBatched_bufferSize(
+    handle, jobz, uplo, n, A, lda, W, lwork, params, batchSize);
+}
+
+template <>
+inline cusolverStatus_t cusolverDnsyevjBatched_bufferSize(  // NOLINT
+  cusolverDnHandle_t handle,
+  cusolverEigMode_t jobz,
+  cublasFillMode_t uplo,
+  int n,
+  const double* A,
+  int lda,
+  const double* W,
+  int* lwork,
+  syevjInfo_t params,
+  int batchSize)
+{
+  return cusolverDnDsyevjBatched_bufferSize(
+    handle, jobz, uplo, n, A, lda, W, lwork, params, batchSize);
+}
+
+template <typename T>
+cusolverStatus_t cusolverDnsyevjBatched(cusolverDnHandle_t handle,  // NOLINT
+                                        cusolverEigMode_t jobz,
+                                        cublasFillMode_t uplo,
+                                        int n,
+                                        T* A,
+                                        int lda,
+                                        T* W,
+                                        T* work,
+                                        int lwork,
+                                        int* info,
+                                        syevjInfo_t params,
+                                        int batchSize,
+                                        cudaStream_t stream);
+
+template <>
+inline cusolverStatus_t cusolverDnsyevjBatched(  // NOLINT
+  cusolverDnHandle_t handle,
+  cusolverEigMode_t jobz,
+  cublasFillMode_t uplo,
+  int n,
+  float* A,
+  int lda,
+  float* W,
+  float* work,
+  int lwork,
+  int* info,
+  syevjInfo_t params,
+  int batchSize,
+  cudaStream_t stream)
+{
+  RAFT_CUSOLVER_TRY(cusolverDnSetStream(handle, stream));
+  return cusolverDnSsyevjBatched(
+    handle, jobz, uplo, n, A, lda, W, work, lwork, info, params, batchSize);
+}
+
+template <>
+inline cusolverStatus_t cusolverDnsyevjBatched(  // NOLINT
+  cusolverDnHandle_t handle,
+  cusolverEigMode_t jobz,
+  cublasFillMode_t uplo,
+  int n,
+  double* A,
+  int lda,
+  double* W,
+  double* work,
+  int lwork,
+  int* info,
+  syevjInfo_t params,
+  int batchSize,
+  cudaStream_t stream)
+{
+  RAFT_CUSOLVER_TRY(cusolverDnSetStream(handle, stream));
+  return cusolverDnDsyevjBatched(
+    handle, jobz, uplo, n, A, lda, W, work, lwork, info, params, batchSize);
+}
+/** @} */
+
 /**
  * @defgroup syevd cusolver syevd operations
  * @{
@@ -694,6 +803,130 @@ inline cusolverStatus_t CUSOLVERAPI cusolverDngesvdj(  // NOLINT
     handle, jobz, econ, m, n, A, lda, S, U, ldu, V, ldv, work, lwork, info, params);
 }
 
+template <typename T>
+inline cusolverStatus_t CUSOLVERAPI cusolverDngesvdjBatched_bufferSize(  // NOLINT
+  cusolverDnHandle_t handle,
+  cusolverEigMode_t jobz,
+  int m,
+  int n,
+  const T* A,
+  int lda,
+  const T* S,
+  const T* U,
+  int ldu,
+  const T* V,
+  int ldv,
+  int* lwork,
+  gesvdjInfo_t params,
+  int batchSize);
+template <>
+inline cusolverStatus_t CUSOLVERAPI cusolverDngesvdjBatched_bufferSize(  // NOLINT
+  cusolverDnHandle_t handle,
+  cusolverEigMode_t jobz,
+  int m,
+  int n,
+  const float* A,
+  int lda,
+  const float* S,
+  const float* U,
+  int ldu,
+  const float* V,
+  int ldv,
+  int* lwork,
+  gesvdjInfo_t params,
+  int batchSize)
+{
+  return cusolverDnSgesvdjBatched_bufferSize(
+    handle, jobz, m, n, A, lda, S, U, ldu, V, ldv, lwork, params, batchSize);
+}
+template <>
+inline cusolverStatus_t CUSOLVERAPI cusolverDngesvdjBatched_bufferSize(  // NOLINT
+  cusolverDnHandle_t handle,
+  cusolverEigMode_t jobz,
+  int m,
+  int n,
+  const double* A,
+  int lda,
+  const double* S,
+  const double* U,
+  int ldu,
+  const double* V,
+  int ldv,
+  int* lwork,
+  gesvdjInfo_t params,
+  int batchSize)
+{
+  return cusolverDnDgesvdjBatched_bufferSize(
+    handle, jobz, m, n, A, lda, S, U, ldu, V, ldv, lwork, params, batchSize);
+}
+template <typename T>
+inline cusolverStatus_t CUSOLVERAPI cusolverDngesvdjBatched(  // NOLINT
+  cusolverDnHandle_t handle,
+  cusolverEigMode_t jobz,
+  int m,
+  int n,
+  T* A,
+  int lda,
+  T* S,
+  T* U,
+  int ldu,
+  T* V,
+  int ldv,
+  T* work,
+  int lwork,
+  int* info,
+  gesvdjInfo_t params,
+  int batchSize,
+  cudaStream_t stream);
+template <>
+inline cusolverStatus_t CUSOLVERAPI cusolverDngesvdjBatched(  // NOLINT
+  cusolverDnHandle_t handle,
+  cusolverEigMode_t jobz,
+  int m,
+  int n,
+  float* A,
+  int lda,
+  float* S,
+  float* U,
+  int ldu,
+  float* V,
+  int ldv,
+  float* work,
+  int lwork,
+  int* info,
+  gesvdjInfo_t params,
+  int batchSize,
+  cudaStream_t stream)
+{
+  RAFT_CUSOLVER_TRY(cusolverDnSetStream(handle, stream));
+  return cusolverDnSgesvdjBatched(
+    handle, jobz, m, n, A, lda, S, U, ldu, V, ldv, work, lwork, info, params, batchSize);
+}
+template <>
+inline cusolverStatus_t CUSOLVERAPI cusolverDngesvdjBatched(  // NOLINT
+  cusolverDnHandle_t handle,
+  cusolverEigMode_t jobz,
+  int m,
+  int n,
+  double* A,
+  int lda,
+  double* S,
+  double* U,
+  int ldu,
+  double* V,
+  int ldv,
+  double* work,
+  int lwork,
+  int* info,
+  gesvdjInfo_t params,
+  int batchSize,
+  cudaStream_t stream)
+{
+  RAFT_CUSOLVER_TRY(cusolverDnSetStream(handle, stream));
+  return cusolverDnDgesvdjBatched(
+    handle, jobz, m, n, A, lda, S, U, ldu, V, ldv, work, lwork, info, params, batchSize);
+}
+
 #if CUDART_VERSION >= 11010
 template <typename T>
 cusolverStatus_t cusolverDnxgesvdr_bufferSize(  // NOLINT
@@ -885,6 +1118,44 @@ inline cusolverStatus_t cusolverDnpotrf(cusolverDnHandle_t handle,  // NOLINT
   RAFT_CUSOLVER_TRY(cusolverDnSetStream(handle, stream));
   return cusolverDnDpotrf(handle, uplo, n, A, lda, Workspace, Lwork, devInfo);
 }
+
+template <typename T>
+inline cusolverStatus_t cusolverDnpotrfBatched(cusolverDnHandle_t handle,  // NOLINT
+                                               cublasFillMode_t uplo,
+                                               int n,
+                                               T* Aarray[],
+                                               int lda,
+                                               int* infoArray,
+                                               int batchSize,
+                                               cudaStream_t stream);
+
+template <>
+inline cusolverStatus_t cusolverDnpotrfBatched(cusolverDnHandle_t handle,  // NOLINT
+                                               cublasFillMode_t uplo,
+                                               int n,
+                                               float* Aarray[],
+                                               int lda,
+                                               int* infoArray,
+                                               int batchSize,
+                                               cudaStream_t stream)
+{
+  RAFT_CUSOLVER_TRY(cusolverDnSetStream(handle, stream));
+  return cusolverDnSpotrfBatched(handle, uplo, n, Aarray, lda, infoArray, batchSize);
+}
+
+template <>
+inline cusolverStatus_t cusolverDnpotrfBatched(cusolverDnHandle_t handle,  // NOLINT
+                                               cublasFillMode_t uplo,
+                                               int n,
+                                               double* Aarray[],
+                                               int lda,
+                                               int* infoArray,
+                                               int batchSize,
+                                               cudaStream_t stream)
+{
+  RAFT_CUSOLVER_TRY(cusolverDnSetStream(handle, stream));
+  return cusolverDnDpotrfBatched(handle, uplo, n, Aarray, lda, infoArray, batchSize);
+}
 /** @} */
 
 /**
@@ -18,6 +18,7 @@
 
 #include "cusolver_wrappers.hpp"
 #include <cuda_runtime_api.h>
+#include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resource/cusolver_dn_handle.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/matrix/copy.cuh>
@@ -29,6 +30,9 @@ namespace raft {
 namespace linalg {
 namespace detail {
 
+/** The largest matrices handled by the batched Jacobi solvers of cuSOLVER. */
+constexpr int kMaxBatchedJacobiSize = 32;
+
 template <typename math_t>
 void eigDC_legacy(raft::resources const& handle,
                   const math_t* in,
@@ -296,6 +300,86 @@ void eigJacobi(raft::resources const& handle,
   RAFT_CUSOLVER_TRY(cusolverDnDestroySyevjInfo(syevj_params));
 }
 
+template <typename math_t, typename idx_t>
+void eigJacobiBatched(raft::resources const& handle,
+                      const math_t* in,
+                      idx_t batch_size,
+                      idx_t n,
+                      math_t* eig_vectors,
+                      math_t* eig_vals,
+                      math_t tol,
+                      int sweeps)
+{
+  auto stream                  = resource::get_cuda_stream(handle);
+  cusolverDnHandle_t cusolverH = resource::get_cusolver_dn_handle(handle);
+
+  syevjInfo_t syevj_params = nullptr;
+  RAFT_CUSOLVER_TRY(cusolverDnCreateSyevjInfo(&syevj_params));
+  RAFT_CUSOLVER_TRY(cusolverDnXsyevjSetTolerance(syevj_params, tol));
+  RAFT_CUSOLVER_TRY(cusolverDnXsyevjSetMaxSweeps(syevj_params, sweeps));
+
+  raft::copy(eig_vectors, in, static_cast<size_t>(batch_size) * n * n, stream);
+  rmm::device_uvector<int> dev_info(batch_size, stream);
+
+  int lwork;
+  if (n <= kMaxBatchedJacobiSize) {
+    // all the matrices are solved together
+    RAFT_CUSOLVER_TRY(cusolverDnsyevjBatched_bufferSize(cusolverH,
+                                                        CUSOLVER_EIG_MODE_VECTOR,
+                                                        CUBLAS_FILL_MODE_UPPER,
+                                                        n,
+                                                        eig_vectors,
+                                                        n,
+                                                        eig_vals,
+                                                        &lwork,
+                                                        syevj_params,
+                                                        batch_size));
+    rmm::device_uvector<math_t> d_work(lwork, stream);
+    RAFT_CUSOLVER_TRY(cusolverDnsyevjBatched(cusolverH,
+                                             CUSOLVER_EIG_MODE_VECTOR,
+                                             CUBLAS_FILL_MODE_UPPER,
+                                             n,
+                                             eig_vectors,
+                                             n,
+                                             eig_vals,
+                                             d_work.data(),
+                                             lwork,
+                                             dev_info.data(),
+                                             syevj_params,
+                                             batch_size,
+                                             stream));
+  } else {
+    // cuSOLVER has no batched Jacobi solver for these sizes; reuse the workspace for every matrix
+    RAFT_CUSOLVER_TRY(cusolverDnsyevj_bufferSize(cusolverH,
+                                                 CUSOLVER_EIG_MODE_VECTOR,
+                                                 CUBLAS_FILL_MODE_UPPER,
+                                                 n,
+                                                 eig_vectors,
+                                                 n,
+                                                 eig_vals,
+                                                 &lwork,
+                                                 syevj_params));
+    rmm::device_uvector<math_t> d_work(lwork, stream);
+    for (idx_t i = 0; i < batch_size; i++) {
+      RAFT_CUSOLVER_TRY(cusolverDnsyevj(cusolverH,
+                                        CUSOLVER_EIG_MODE_VECTOR,
+                                        CUBLAS_FILL_MODE_UPPER,
+                                        n,
+                                        eig_vectors + static_cast<size_t>(i) * n * n,
+                                        n,
+                                        eig_vals + static_cast<size_t>(i) * n,
+                                        d_work.data(),
+                                        lwork,
+                                        dev_info.data() + i,
+                                        syevj_params,
+                                        stream));
+    }
+  }
+
+  RAFT_CUDA_TRY(cudaGetLastError());
+  RAFT_CUSOLVER_TRY(cusolverDnDestroySyevjInfo(syevj_params));
+}
+
 }  // namespace detail
 }  // namespace linalg
 }  // namespace raft
@@ -0,0 +1,322 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/linalg/detail/map.cuh>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/pow2_utils.cuh>
+#include <raft/util/vectorized.cuh>
+
+#include <rmm/device_uvector.hpp>
+
+#include <cub/cub.cuh>
+
+#include <algorithm>
+#include <cstdint>
+
+namespace raft::linalg::detail {
+
+/*
+ * The nodes of a matrix expression. Every node is a functor `(x, i, j) -> y`, where `x` is the
+ * element (i, j) of the source matrix; a node applies its operation on the result of the node
+ * it wraps, so a chain of ops is inlined into the single kernel that evaluates the expression.
+ */
+
+struct expression_source_op {
+  template <typename T, typename IdxT>
+  HDI auto operator()(const T& x, IdxT, IdxT) const
+  {
+    return x;
+  }
+};
+
+template <typename PrevOp, typename Func>
+struct expression_map_op {
+  PrevOp prev;
+  Func f;
+
+  template <typename T, typename IdxT>
+  HDI auto operator()(const T& x, IdxT i, IdxT j) const
+  {
+    return f(prev(x, i, j));
+  }
+};
+
+template <typename PrevOp, typename Func, typename VecT, bool PerRow>
+struct expression_broadcast_op {
+  PrevOp prev;
+  Func f;
+  const VecT* vec;
+
+  template <typename T, typename IdxT>
+  HDI auto operator()(const T& x, IdxT i, IdxT j) const
+  {
+    return f(prev(x, i, j), vec[PerRow ? i : j]);
+  }
+};
+
+template <typename PrevOp, typename Func, typename U, typename LdT>
+struct expression_zip_op {
+  PrevOp prev;
+  Func f;
+  const U* other;
+  LdT ld;
+
+  template <typename T, typename IdxT>
+  HDI auto operator()(const T& x, IdxT i, IdxT j) const
+  {
+    return f(prev(x, i, j), other[static_cast<size_t>(i) * ld + j]);
+  }
+};
+
+/** Adapts an expression node to the flat offset passed by `map_offset`. */
+template <typename Op, typename IdxT>
+struct expression_offset_op {
+  Op op;
+  IdxT n_cols;
+
+  template <typename T>
+  HDI auto operator()(IdxT offset, const T& x) const
+  {
+    return op(x, offset / n_cols, offset % n_cols);
+  }
+};
+
+template <typename OutT, typename T, typename IdxT, typename Op>
+void evaluate(raft::resources const& res,
+              const T* src,
+              IdxT n_rows,
+              IdxT n_cols,
+              Op op,
+              raft::device_matrix_view<OutT, IdxT, raft::row_major> out)
+{
+  raft::linalg::detail::map<true>(
+    res,
+    raft::make_device_vector_view<OutT, IdxT>(out.data_handle(), n_rows * n_cols),
+    expression_offset_op<Op, IdxT>{op, n_cols},
+    raft::make_device_vector_view<const T, IdxT>(src, n_rows * n_cols));
+}
+
+/** One block per row; each thread reads VecLen consecutive elements at a time. */
+template <int TPB,
+          int VecLen,
+          typename OutT,
+          typename T,
+          typename IdxT,
+          typename Op,
+          typename ReduceOp,
+          typename FinalOp>
+__global__ void __launch_bounds__(TPB) expression_reduce_rows_kernel(OutT* dots,
+                                                                     const T* data,
+                                                                     IdxT n_cols,
+                                                                     OutT init,
+                                                                     Op op,
+                                                                     ReduceOp reduce_op,
+                                                                     FinalOp final_op,
+                                                                     bool inplace)
+{
+  using BlockReduce = cub::BlockReduce<OutT, TPB, cub::BLOCK_REDUCE_RAKING>;
+  __shared__ typename BlockReduce::TempStorage temp_storage;
+
+  const IdxT i     = blockIdx.x;
+  const T* row_ptr = data + static_cast<size_t>(i) * n_cols;
+  OutT acc         = init;
+  for (IdxT j = threadIdx.x * VecLen; j < n_cols; j += TPB * VecLen) {
+    if constexpr (VecLen > 1) {
+      TxN_t<T, VecLen> wide;
+      wide.load(row_ptr, j);
+#pragma unroll
+      for (int k = 0; k < VecLen; ++k) {
+        acc = reduce_op(acc, static_cast<OutT>(op(wide.val.data[k], i, j + k)));
+      }
+    } else {
+      acc = reduce_op(acc, static_cast<OutT>(op(row_ptr[j], i, j)));
+    }
+  }
+  acc = BlockReduce(temp_storage).Reduce(acc, reduce_op);
+  if (threadIdx.x == 0) { dots[i] = final_op(inplace ? reduce_op(dots[i], acc) : acc); }
+}
+
+/**
+ * One thread per column and per chunk of `rows_per_chunk` rows. With a single chunk, the
+ * result is final; otherwise the partial results of the chunks are written to `partial`
+ * [n_chunks x n_cols] and folded by `expression_fold_chunks_kernel`.
+ */
+template <int TPB,
+          typename OutT,
+          typename T,
+          typename IdxT,
+          typename Op,
+          typename ReduceOp,
+          typename FinalOp>
+__global__ void __launch_bounds__(TPB) expression_reduce_cols_kernel(OutT* dots,
+                                                                     OutT* partial,
+                                                                     const T* data,
+                                                                     IdxT n_rows,
+                                                                     IdxT n_cols,
+                                                                     IdxT rows_per_chunk,
+                                                                     OutT init,
+                                                                     Op op,
+                                                                     ReduceOp reduce_op,
+                                                                     FinalOp final_op,
+                                                                     bool inplace)
+{
+  const IdxT j = static_cast<IdxT>(blockIdx.x) * TPB + threadIdx.x;
+  if (j >= n_cols) { return; }
+  const IdxT row_start = static_cast<IdxT>(blockIdx.y) * rows_per_chunk;
+  const IdxT row_end   = std::min<IdxT>(row_start + rows_per_chunk, n_rows);
+  OutT acc             = init;
+  for (IdxT i = row_start; i < row_end; i++) {
+    acc = reduce_op(acc, static_cast<OutT>(op(data[static_cast<size_t>(i) * n_cols + j], i, j)));
+  }
+  if (gridDim.y == 1) {
+    dots[j] = final_op(inplace ? reduce_op(dots[j], acc) : acc);
+  } else {
+    partial[static_cast<size_t>(blockIdx.y) * n_cols + j] = acc;
+  }
+}
+
+template <int TPB, typename OutT, typename IdxT, typename ReduceOp, typename FinalOp>
+__global__ void __launch_bounds__(TPB) expression_fold_chunks_kernel(OutT* dots,
+                                                                     const OutT* partial,
+                                                                     IdxT n_chunks,
+                                                                     IdxT n_cols,
+                                                                     ReduceOp reduce_op,
+                                                                     FinalOp final_op,
+                                                                     bool inplace)
+{
+  const IdxT j = static_cast<IdxT>(blockIdx.x) * TPB + threadIdx.x;
+  if (j >= n_cols) { return; }
+  OutT acc = partial[j];
+  for (IdxT c = 1; c < n_chunks; c++) {
+    acc = reduce_op(acc, partial[static_cast<size_t>(c) * n_cols + j]);
+  }
+  dots[j] = final_op(inplace ? reduce_op(dots[j], acc) : acc);
+}
+
+/** The widest vector load that keeps every row of `ptr` aligned. */
+template <typename T, typename IdxT>
+int expression_veclen(const T* ptr, IdxT n_cols)
+{
+  if constexpr (kCoalescedVectorSize % sizeof(T) != 0) {
+    return 1;
+  } else {
+    int veclen = kCoalescedVectorSize / sizeof(T);
+    while (veclen > 1 && (n_cols % veclen != 0 ||
+                          reinterpret_cast<uintptr_t>(ptr) % (veclen * sizeof(T)) != 0)) {
+      veclen /= 2;
+    }
+    return veclen;
+  }
+}
+
+template <int TPB,
+          int VecLen,
+          typename OutT,
+          typename T,
+          typename IdxT,
+          typename Op,
+          typename ReduceOp,
+          typename FinalOp>
+void reduce_rows_launch(OutT* dots,
+                        const T* data,
+                        IdxT n_rows,
+                        IdxT n_cols,
+                        OutT init,
+                        Op op,
+                        ReduceOp reduce_op,
+                        FinalOp final_op,
+                        bool inplace,
+                        cudaStream_t stream)
+{
+  if constexpr (VecLen > 1) {
+    if (expression_veclen(data, n_cols) < VecLen) {
+      return reduce_rows_launch<TPB, VecLen / 2>(
+        dots, data, n_rows, n_cols, init, op, reduce_op, final_op, inplace, stream);
+    }
+  }
+  expression_reduce_rows_kernel<TPB, VecLen><<<n_rows, TPB, 0, stream>>>(
+    dots, data, n_cols, init, op, reduce_op, final_op, inplace);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+template <typename OutT,
+          typename T,
+          typename IdxT,
+          typename Op,
+          typename ReduceOp,
+          typename FinalOp>
+void evaluate_reduce(raft::resources const& res,
+                     const T* src,
+                     IdxT n_rows,
+                     IdxT n_cols,
+                     Op op,
+                     OutT* dots,
+                     OutT init,
+                     bool along_rows,
+                     bool inplace,
+                     ReduceOp reduce_op,
+                     FinalOp final_op)
+{
+  auto stream = resource::get_cuda_stream(res);
+  if (n_rows == 0 || n_cols == 0) { return; }
+
+  if (along_rows) {
+    // the vector width is dispatched at run time, the largest one fitting 16 bytes first
+    constexpr int kMaxVecLen =
+      kCoalescedVectorSize % sizeof(T) == 0 ? int(kCoalescedVectorSize / sizeof(T)) : 1;
+    if (raft::ceildiv<IdxT>(n_cols, kMaxVecLen) <= 64) {
+      reduce_rows_launch<64, kMaxVecLen>(
+        dots, src, n_rows, n_cols, init, op, reduce_op, final_op, inplace, stream);
+    } else {
+      reduce_rows_launch<256, kMaxVecLen>(
+        dots, src, n_rows, n_cols, init, op, reduce_op, final_op, inplace, stream);
+    }
+    return;
+  }
+
+  constexpr int kTpb        = 128;
+  constexpr IdxT kMaxChunks = 65535;
+  IdxT rows_per_chunk       = std::max<IdxT>(64, raft::ceildiv<IdxT>(n_rows, kMaxChunks));
+  IdxT n_chunks             = raft::ceildiv<IdxT>(n_rows, rows_per_chunk);
+  rmm::device_uvector<OutT> partial(
+    n_chunks > 1 ? size_t(n_chunks) * n_cols : 0, stream, resource::get_workspace_resource(res));
+  dim3 blocks(raft::ceildiv<IdxT>(n_cols, kTpb), n_chunks);
+  expression_reduce_cols_kernel<kTpb><<<blocks, kTpb, 0, stream>>>(dots,
+                                                                   partial.data(),
+                                                                   src,
+                                                                   n_rows,
+                                                                   n_cols,
+                                                                   rows_per_chunk,
+                                                                   init,
+                                                                   op,
+                                                                   reduce_op,
+                                                                   final_op,
+                                                                   inplace);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+  if (n_chunks > 1) {
+    expression_fold_chunks_kernel<kTpb><<<raft::ceildiv<IdxT>(n_cols, kTpb), kTpb, 0, stream>>>(
+      dots, partial.data(), n_chunks, n_cols, reduce_op, final_op, inplace);
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+  }
+}
+
+}  // namespace raft::linalg::detail
@@ -20,8 +20,15 @@
 
 #include "cublas_wrappers.hpp"
 
+#include <raft/core/error.hpp>
 #include <raft/core/resource/cublas_handle.hpp>
 #include <raft/core/resources.hpp>
+#include <raft/linalg/linalg_types.hpp>
+
+#include <cuda_bf16.h>
+#include <cuda_fp16.h>
+
+#include <type_traits>
 
 namespace raft {
 namespace linalg {
@@ -238,6 +245,113 @@ void gemm(raft::resources const& handle,
     cublasgemm(cublas_h, trans_a, trans_b, M, N, K, alpha, a, lda, b, ldb, beta, c, ldc, stream));
 }
 
+template <typename T>
+constexpr auto gemm_data_type() -> cudaDataType_t
+{
+  if constexpr (std::is_same_v<T, half>) {
+    return CUDA_R_16F;
+  } else if constexpr (std::is_same_v<T, nv_bfloat16>) {
+    return CUDA_R_16BF;
+  } else if constexpr (std::is_same_v<T, float>) {
+    return CUDA_R_32F;
+  } else {
+    static_assert(std::is_same_v<T, double>, "Unsupported GEMM data type");
+    return CUDA_R_64F;
+  }
+}
+
+/**
+ * @brief cublasGemmEx with the inputs of type InT and the output of type OutT, in the same layout
+ * conventions as the previous overload: Z [M x N] = alpha . X [M x K] * Y [K x N] + beta . Z
+ */
+template <typename InT, typename OutT>
+void gemm_ex(raft::resources const& handle,
+             OutT* z,
+             const InT* x,
+             const InT* y,
+             int _M,
+             int _N,
+             int _K,
+             bool isZColMajor,
+             bool isXColMajor,
+             bool isYColMajor,
+             GemmCompute compute,
+             double alpha,
+             double beta,
+             cudaStream_t stream)
+{
+  cublasComputeType_t compute_type = CUBLAS_COMPUTE_32F;
+  if constexpr (std::is_same_v<OutT, double>) {
+    RAFT_EXPECTS(compute == GemmCompute::DEFAULT, "The double GEMM supports the DEFAULT mode only");
+    compute_type = CUBLAS_COMPUTE_64F;
+  } else if (compute == GemmCompute::TF32) {
+    RAFT_EXPECTS((std::is_same_v<InT, float>), "The TF32 mode requires float inputs");
+    compute_type = CUBLAS_COMPUTE_32F_FAST_TF32;
+  } else if (compute == GemmCompute::FP16) {
+    RAFT_EXPECTS((std::is_same_v<InT, half> && std::is_same_v<OutT, half>),
+                 "The FP16 mode requires half inputs and output");
+    compute_type = CUBLAS_COMPUTE_16F;
+  }
+
+  // the scalars have the type of the accumulation
+  double scalars_64[] = {alpha, beta};
+  float scalars_32[]  = {float(alpha), float(beta)};
+  half scalars_16[]   = {half(float(alpha)), half(float(beta))};
+
+  const void* alpha_ptr = scalars_32;
+  const void* beta_ptr  = scalars_32 + 1;
+  if (compute_type == CUBLAS_COMPUTE_64F) {
+    alpha_ptr = scalars_64;
+    beta_ptr  = scalars_64 + 1;
+  } else if (compute_type == CUBLAS_COMPUTE_16F) {
+    alpha_ptr = scalars_16;
+    beta_ptr  = scalars_16 + 1;
+  }
+
+  // see the previous overload for the mapping of the layouts to the cuBLAS arguments
+  const InT* a = isZColMajor ? x : y;
+  const InT* b = isZColMajor ? y : x;
+  cublasOperation_t trans_a, trans_b;
+  int lda, ldb, M, N;
+  if (isZColMajor) {
+    trans_a = isXColMajor ? CUBLAS_OP_N : CUBLAS_OP_T;
+    lda     = isXColMajor ? _M : _K;
+    trans_b = isYColMajor ? CUBLAS_OP_N : CUBLAS_OP_T;
+    ldb     = isYColMajor ? _K : _N;
+    M       = _M;
+    N       = _N;
+  } else {
+    trans_a = isYColMajor ? CUBLAS_OP_T : CUBLAS_OP_N;
+    lda     = isYColMajor ? _K : _N;
+    trans_b = isXColMajor ? CUBLAS_OP_T : CUBLAS_OP_N;
+    ldb     = isXColMajor ? _M : _K;
+    M       = _N;
+    N       = _M;
+  }
+
+  auto cublas_h = raft::resource::get_cublas_handle(handle);
+  RAFT_CUBLAS_TRY(cublasSetStream(cublas_h, stream));
+  RAFT_CUBLAS_TRY(cublasGemmEx(cublas_h,
+                               trans_a,
+                               trans_b,
+                               M,
+                               N,
+                               _K,
+                               alpha_ptr,
+                               a,
+                               gemm_data_type<InT>(),
+                               lda,
+                               b,
+                               gemm_data_type<InT>(),
+                               ldb,
+                               beta_ptr,
+                               z,
+                               gemm_data_type<OutT>(),
+                               M,
+                               compute_type,
+                               CUBLAS_GEMM_DEFAULT_TENSOR_OP));
+}
+
 }  // namespace detail
 }  // namespace linalg
 }  // namespace raft
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/linalg/map.cuh>
+#include <raft/util/cuda_dev_essentials.cuh>
+
+#include <type_traits>
+
+namespace raft::linalg::detail {
+
+/**
+ * z(i, j) = relu(z(i, j) + row_add[i] + col_add[j]) for the element at the offset `idx` of a
+ * contiguous [n_rows x n_cols] matrix. The sums are computed in fp32 for the half outputs.
+ */
+template <typename OutT, typename IdxT, bool ZColMajor>
+struct gemm_epilogue_op {
+  const OutT* row_add;
+  const OutT* col_add;
+  bool relu;
+  IdxT n_rows;
+  IdxT n_cols;
+
+  HDI auto operator()(IdxT idx, OutT z) const -> OutT
+  {
+    using acc_t = std::conditional_t<std::is_same_v<OutT, double>, double, float>;
+    IdxT i      = ZColMajor ? idx % n_rows : idx / n_cols;
+    IdxT j      = ZColMajor ? idx / n_rows : idx % n_cols;
+    auto acc    = static_cast<acc_t>(z);
+    if (row_add != nullptr) { acc += static_cast<acc_t>(row_add[i]); }
+    if (col_add != nullptr) { acc += static_cast<acc_t>(col_add[j]); }
+    if (relu && acc < acc_t(0)) { acc = acc_t(0); }
+    return static_cast<OutT>(acc);
+  }
+};
+
+template <bool ZColMajor, typename OutT, typename IdxT>
+void gemm_epilogue(raft::resources const& handle,
+                   OutT* z,
+                   IdxT n_rows,
+                   IdxT n_cols,
+                   const OutT* row_add,
+                   const OutT* col_add,
+                   bool relu)
+{
+  if (row_add == nullptr && col_add == nullptr && !relu) { return; }
+  auto len = n_rows * n_cols;
+  raft::linalg::map_offset(
+    handle,
+    raft::make_device_vector_view<OutT, IdxT>(z, len),
+    gemm_epilogue_op<OutT, IdxT, ZColMajor>{row_add, col_add, relu, n_rows, n_cols},
+    raft::make_device_vector_view<const OutT, IdxT>(z, len));
+}
+
+}  // namespace raft::linalg::detail
@@ -16,10 +16,19 @@
 
 #pragma once
 
+#include <raft/linalg/linalg_types.hpp>
 #include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+#include <rmm/exec_policy.hpp>
 
 #include <cub/cub.cuh>
+#include <thrust/binary_search.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/sequence.h>
 
+#include <algorithm>
 #include <limits>
 
 #define MAX_BLOCKS 65535u
@@ -307,6 +316,194 @@ void sum_rows_by_key_large_nkeys_rowmajor(const DataIteratorT d_A,
     d_A, lda, d_weights, d_keys, nrows, ncols, d_sums);
 }
 
+//
+// Reduce by keys - all the [nkeys x ncols] sums fit in shared memory
+// Every block accumulates the sums of its rows in smem and flushes them with global atomics
+//
+
+#define SUM_ROWS_BY_KEY_SHARED_BINS_MAX_BYTES (48 * 1024)
+
+template <typename DataIteratorT,
+          typename KeysIteratorT,
+          typename WeightT,
+          typename SumsT,
+          typename IdxT>
+__global__ void sum_rows_by_key_shared_bins_kernel(const DataIteratorT d_A,
+                                                   IdxT lda,
+                                                   KeysIteratorT d_keys,
+                                                   const WeightT* d_weights,
+                                                   IdxT nrows,
+                                                   IdxT ncols,
+                                                   IdxT nkeys,
+                                                   SumsT* d_sums)
+{
+  extern __shared__ char shared_bins_smem[];
+  auto* bins  = reinterpret_cast<SumsT*>(shared_bins_smem);
+  IdxT nbins = nkeys * ncols;
+  for (IdxT b = threadIdx.x; b < nbins; b += blockDim.x) {
+    bins[b] = SumsT(0);
+  }
+  __syncthreads();
+
+  // consecutive threads read consecutive elements of a row
+  for (IdxT gid = threadIdx.x + blockDim.x * static_cast<IdxT>(blockIdx.x); gid < nrows * ncols;
+       gid += blockDim.x * static_cast<IdxT>(gridDim.x)) {
+    IdxT i    = gid / ncols;
+    IdxT j    = gid % ncols;
+    SumsT val = d_A[j + lda * i];
+    if (d_weights != nullptr) val *= d_weights[i];
+    raft::myAtomicAdd(&bins[j + ncols * static_cast<IdxT>(d_keys[i])], val);
+  }
+  __syncthreads();
+
+  for (IdxT b = threadIdx.x; b < nbins; b += blockDim.x) {
+    SumsT val = bins[b];
+    if (val != SumsT(0)) { raft::myAtomicAdd(&d_sums[b], val); }
+  }
+}
+
+template <typename DataIteratorT,
+          typename KeysIteratorT,
+          typename WeightT,
+          typename SumsT,
+          typename IdxT>
+void sum_rows_by_key_shared_bins(const DataIteratorT d_A,
+                                 IdxT lda,
+                                 const KeysIteratorT d_keys,
+                                 const WeightT* d_weights,
+                                 IdxT nrows,
+                                 IdxT ncols,
+                                 IdxT nkeys,
+                                 SumsT* d_sums,
+                                 cudaStream_t st)
+{
+  uint32_t block_dim = 256;
+  IdxT nbins         = nkeys * ncols;
+  size_t smem_size   = nbins * sizeof(SumsT);
+  // every block reads at least 8 elements per bin, which bounds the cost of the flush
+  auto grid_dim =
+    static_cast<uint32_t>(std::clamp<IdxT>(raft::ceildiv<IdxT>(nrows * ncols, 8 * nbins), 1, 512));
+  sum_rows_by_key_shared_bins_kernel<<<grid_dim, block_dim, smem_size, st>>>(
+    d_A, lda, d_keys, d_weights, nrows, ncols, nkeys, d_sums);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+//
+// Reduce by keys - sort-based segments
+// The rows are sorted by key; the block (key, column chunk) then reduces the segment of the key
+// without atomics
+//
+
+#define SUM_ROWS_BY_KEY_SORTED_DIMX 32
+#define SUM_ROWS_BY_KEY_SORTED_DIMY 8
+#define SUM_ROWS_BY_KEY_SORTED_MIN_K 16384
+
+template <typename DataIteratorT, typename WeightT, typename SumsT, typename IdxT>
+__global__ void sum_rows_by_key_sorted_kernel(const DataIteratorT d_A,
+                                              IdxT lda,
+                                              const IdxT* sorted_rows,
+                                              const IdxT* segment_offsets,
+                                              const WeightT* d_weights,
+                                              IdxT ncols,
+                                              SumsT* d_sums)
+{
+  __shared__ SumsT partial[SUM_ROWS_BY_KEY_SORTED_DIMY][SUM_ROWS_BY_KEY_SORTED_DIMX];
+
+  IdxT key   = blockIdx.x;
+  IdxT j     = static_cast<IdxT>(blockIdx.y) * SUM_ROWS_BY_KEY_SORTED_DIMX + threadIdx.x;
+  IdxT begin = segment_offsets[key];
+  IdxT end   = segment_offsets[key + 1];
+  if (begin == end) return;
+
+  SumsT acc = SumsT(0);
+  if (j < ncols) {
+    for (IdxT s = begin + threadIdx.y; s < end; s += SUM_ROWS_BY_KEY_SORTED_DIMY) {
+      IdxT i    = sorted_rows[s];
+      SumsT val = d_A[j + lda * i];
+      if (d_weights != nullptr) val *= d_weights[i];
+      acc += val;
+    }
+  }
+  partial[threadIdx.y][threadIdx.x] = acc;
+  __syncthreads();
+  if (threadIdx.y == 0 && j < ncols) {
+#pragma unroll
+    for (int y = 1; y < SUM_ROWS_BY_KEY_SORTED_DIMY; y++) {
+      acc += partial[y][threadIdx.x];
+    }
+    d_sums[j + ncols * key] += acc;
+  }
+}
+
+template <typename DataIteratorT,
+          typename KeysIteratorT,
+          typename WeightT,
+          typename SumsT,
+          typename IdxT>
+void sum_rows_by_key_sorted(const DataIteratorT d_A,
+                            IdxT lda,
+                            const KeysIteratorT d_keys,
+                            const WeightT* d_weights,
+                            IdxT nrows,
+                            IdxT ncols,
+                            IdxT nkeys,
+                            SumsT* d_sums,
+                            cudaStream_t st)
+{
+  rmm::device_uvector<IdxT> keys_in(nrows, st);
+  rmm::device_uvector<IdxT> keys_out(nrows, st);
+  rmm::device_uvector<IdxT> rows_in(nrows, st);
+  rmm::device_uvector<IdxT> rows_out(nrows, st);
+  rmm::device_uvector<IdxT> segment_offsets(nkeys + 1, st);
+  auto policy = rmm::exec_policy(st);
+
+  convert_array(keys_in.data(), d_keys, nrows, st);
+  thrust::sequence(policy, rows_in.begin(), rows_in.end());
+
+  // only the bits of the largest key are sorted
+  int end_bit = 1;
+  while (end_bit < int(sizeof(IdxT) * 8) && (IdxT(1) << end_bit) < nkeys) {
+    end_bit++;
+  }
+  size_t temp_bytes = 0;
+  RAFT_CUDA_TRY(cub::DeviceRadixSort::SortPairs(nullptr,
+                                                temp_bytes,
+                                                keys_in.data(),
+                                                keys_out.data(),
+                                                rows_in.data(),
+                                                rows_out.data(),
+                                                nrows,
+                                                0,
+                                                end_bit,
+                                                st));
+  rmm::device_uvector<char> temp(temp_bytes, st);
+  RAFT_CUDA_TRY(cub::DeviceRadixSort::SortPairs(temp.data(),
+                                                temp_bytes,
+                                                keys_in.data(),
+                                                keys_out.data(),
+                                                rows_in.data(),
+                                                rows_out.data(),
+                                                nrows,
+                                                0,
+                                                end_bit,
+                                                st));
+
+  // the segment of the key k is [offsets[k], offsets[k + 1])
+  thrust::lower_bound(policy,
+                      keys_out.begin(),
+                      keys_out.end(),
+                      thrust::make_counting_iterator<IdxT>(0),
+                      thrust::make_counting_iterator<IdxT>(nkeys + 1),
+                      segment_offsets.begin());
+
+  dim3 block(SUM_ROWS_BY_KEY_SORTED_DIMX, SUM_ROWS_BY_KEY_SORTED_DIMY);
+  dim3 grid(nkeys,
+            std::min<IdxT>(raft::ceildiv<IdxT>(ncols, SUM_ROWS_BY_KEY_SORTED_DIMX), MAX_BLOCKS));
+  sum_rows_by_key_sorted_kernel<<<grid, block, 0, st>>>(
+    d_A, lda, rows_out.data(), segment_offsets.data(), d_weights, ncols, d_sums);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
 /**
  * @brief Computes the weighted reduction of matrix rows for each given key
  *
@@ -328,6 +525,7 @@ void sum_rows_by_key_large_nkeys_rowmajor(const DataIteratorT d_A,
  * @param[out] d_sums      Row sums by key (ncols x d_keys)
  * @param[in]  stream      CUDA stream
  * @param[in]  reset_sums  Whether to reset the output sums to zero before reducing
+ * @param[in]  algo        The reduction strategy
  */
 template <typename DataIteratorT,
           typename KeysIteratorT,
@@ -344,22 +542,50 @@ void reduce_rows_by_key(const DataIteratorT d_A,
                         IdxT nkeys,
                         SumsT* d_sums,
                         cudaStream_t stream,
-                        bool reset_sums)
+                        bool reset_sums,
+                        ReduceRowsByKeyAlgo algo = ReduceRowsByKeyAlgo::AUTO)
 {
   typedef typename std::iterator_traits<KeysIteratorT>::value_type KeyType;
 
   // Following kernel needs memset
   if (reset_sums) { cudaMemsetAsync(d_sums, 0, ncols * nkeys * sizeof(SumsT), stream); }
 
-  if (d_keys_char != nullptr && nkeys <= SUM_ROWS_BY_KEY_SMALL_K_MAX_K) {
-    // sum_rows_by_key_small_k is BW bounded. d_keys is loaded ncols time - avoiding wasting BW
-    // with doubles we have ~20% speed up - with floats we can hope something around 2x
-    // Converting d_keys to char
-    convert_array(d_keys_char, d_keys, nrows, stream);
-    sum_rows_by_key_small_nkeys(
-      d_A, lda, d_keys_char, d_weights, nrows, ncols, nkeys, d_sums, stream);
-  } else {
-    sum_rows_by_key_large_nkeys_rowmajor(d_A, lda, d_keys, d_weights, nrows, ncols, d_sums, stream);
+  if (nrows == 0 || ncols == 0 || nkeys == 0) return;
+
+  bool fits_shared_bins =
+    size_t(nkeys) * ncols * sizeof(SumsT) <= SUM_ROWS_BY_KEY_SHARED_BINS_MAX_BYTES;
+  if (algo == ReduceRowsByKeyAlgo::AUTO) {
+    if (d_keys_char != nullptr && nkeys <= SUM_ROWS_BY_KEY_SMALL_K_MAX_K) {
+      // sum_rows_by_key_small_k is BW bounded. d_keys is loaded ncols time - avoiding wasting BW
+      // with doubles we have ~20% speed up - with floats we can hope something around 2x
+      // Converting d_keys to char
+      convert_array(d_keys_char, d_keys, nrows, stream);
+      sum_rows_by_key_small_nkeys(
+        d_A, lda, d_keys_char, d_weights, nrows, ncols, nkeys, d_sums, stream);
+      return;
+    }
+    // with many keys, the global atomics on the scattered sums dominate the cost of the sort
+    if (fits_shared_bins) {
+      algo = ReduceRowsByKeyAlgo::SHARED_BINS;
+    } else if (nkeys >= SUM_ROWS_BY_KEY_SORTED_MIN_K) {
+      algo = ReduceRowsByKeyAlgo::SORTED;
+    } else {
+      algo = ReduceRowsByKeyAlgo::ATOMIC;
+    }
+  }
+
+  switch (algo) {
+    case ReduceRowsByKeyAlgo::SHARED_BINS:
+      RAFT_EXPECTS(fits_shared_bins, "The sums by key do not fit in shared memory");
+      sum_rows_by_key_shared_bins(
+        d_A, lda, d_keys, d_weights, nrows, ncols, nkeys, d_sums, stream);
+      break;
+    case ReduceRowsByKeyAlgo::SORTED:
+      sum_rows_by_key_sorted(d_A, lda, d_keys, d_weights, nrows, ncols, nkeys, d_sums, stream);
+      break;
+    default:
+      sum_rows_by_key_large_nkeys_rowmajor(
+        d_A, lda, d_keys, d_weights, nrows, ncols, d_sums, stream);
   }
 }
 
@@ -380,6 +606,8 @@ void reduce_rows_by_key(const DataIteratorT d_A,
  * @param[in]  nkeys       Number of unique keys in d_keys
  * @param[out] d_sums      Row sums by key (ncols x d_keys)
  * @param[in]  stream      CUDA stream
+ * @param[in]  reset_sums  Whether to reset the output sums to zero before reducing
+ * @param[in]  algo        The reduction strategy
  */
 template <typename DataIteratorT, typename KeysIteratorT, typename SumsT, typename IdxT>
 void reduce_rows_by_key(const DataIteratorT d_A,
@@ -391,7 +619,8 @@ void reduce_rows_by_key(const DataIteratorT d_A,
                         IdxT nkeys,
                         SumsT* d_sums,
                         cudaStream_t stream,
-                        bool reset_sums)
+                        bool reset_sums,
+                        ReduceRowsByKeyAlgo algo = ReduceRowsByKeyAlgo::AUTO)
 {
   typedef typename std::iterator_traits<DataIteratorT>::value_type DataType;
   reduce_rows_by_key(d_A,
@@ -404,7 +633,8 @@ void reduce_rows_by_key(const DataIteratorT d_A,
                      nkeys,
                      d_sums,
                      stream,
-                     reset_sums);
+                     reset_sums,
+                     algo);
 }
 
 };  // end namespace detail
@@ -21,6 +21,7 @@
 #include <raft/core/resource/cusolver_dn_handle.hpp>
 #include <raft/linalg/eig.cuh>
 #include <raft/linalg/gemm.cuh>
+#include <raft/linalg/map.cuh>
 #include <raft/linalg/qr.cuh>
 #include <raft/linalg/svd.cuh>
 #include <raft/linalg/transpose.cuh>
@@ -31,6 +32,9 @@
 #include <raft/matrix/triangular.cuh>
 #include <raft/random/rng.cuh>
 #include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
 
 #include <algorithm>
 
@@ -128,6 +132,142 @@ void randomized_svd(const raft::resources& handle,
   ASSERT(dev_info == 0, "rsvd.cuh: Invalid parameter encountered.");
 }
 
+/**
+ * Y = A^T * A * Q for the row-major host matrix A, streamed by blocks of `batch_rows` rows:
+ * Y += B^T * (B * Q) for every block B. Seen column-major, a row-major block B is B^T.
+ */
+template <typename math_t>
+void streaming_gram_product(const raft::resources& handle,
+                            const math_t* in,
+                            std::size_t n_rows,
+                            int n_cols,
+                            int l,
+                            int batch_rows,
+                            const math_t* Q,
+                            math_t* block,
+                            math_t* BQ,
+                            math_t* Y)
+{
+  cudaStream_t stream = resource::get_cuda_stream(handle);
+  for (std::size_t row = 0; row < n_rows; row += batch_rows) {
+    int b = std::min<std::size_t>(batch_rows, n_rows - row);
+    raft::copy(block, in + row * n_cols, std::size_t(b) * n_cols, stream);
+    raft::linalg::gemm(handle, block, n_cols, b, Q, BQ, b, l, CUBLAS_OP_T, CUBLAS_OP_N, stream);
+    raft::linalg::gemm(handle,
+                       block,
+                       n_cols,
+                       b,
+                       BQ,
+                       Y,
+                       n_cols,
+                       l,
+                       CUBLAS_OP_N,
+                       CUBLAS_OP_N,
+                       math_t(1),
+                       row == 0 ? math_t(0) : math_t(1),
+                       stream);
+  }
+}
+
+/**
+ * Randomized SVD of a row-major host matrix, which is read by blocks of rows; only the
+ * [n_cols x (k + p)] sketches and one block live on the device. The range of A^T is found by
+ * power iterations on A^T * A, and the SVD is recovered from the eigen decomposition of the
+ * small matrix Q^T * A^T * A * Q.
+ */
+template <typename math_t>
+void randomized_svd_streaming(const raft::resources& handle,
+                              const math_t* in,
+                              std::size_t n_rows,
+                              std::size_t n_cols,
+                              std::size_t k,
+                              std::size_t p,
+                              std::size_t niters,
+                              std::size_t batch_rows,
+                              uint64_t seed,
+                              math_t* S,
+                              math_t* U,
+                              math_t* V)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "raft::linalg::randomized_svd_streaming(%d, %d, %d)", n_rows, n_cols, k);
+
+  RAFT_EXPECTS(k > 0, "k must be > 0");
+  RAFT_EXPECTS((k + p) <= std::min(n_rows, n_cols), "k + p must be <= min(n_rows, n_cols)");
+  RAFT_EXPECTS(batch_rows > 0, "batch_rows must be > 0");
+  cudaStream_t stream = resource::get_cuda_stream(handle);
+
+  int n = n_cols;
+  int l = k + p;
+  int b = std::min(batch_rows, n_rows);
+
+  rmm::device_uvector<math_t> block(std::size_t(b) * n, stream);
+  rmm::device_uvector<math_t> BQ(std::size_t(b) * l, stream);
+  rmm::device_uvector<math_t> Q(std::size_t(n) * l, stream);
+  rmm::device_uvector<math_t> Y(std::size_t(n) * l, stream);
+
+  // random start, orthonormalized
+  raft::random::RngState state{seed};
+  raft::random::normal(handle, state, Y.data(), Y.size(), math_t(0), math_t(1));
+  raft::linalg::qrGetQ(handle, Y.data(), Q.data(), n, l, stream);
+  for (std::size_t it = 0; it <= niters; it++) {
+    streaming_gram_product(
+      handle, in, n_rows, n, l, b, Q.data(), block.data(), BQ.data(), Y.data());
+    if (it < niters) { raft::linalg::qrGetQ(handle, Y.data(), Q.data(), n, l, stream); }
+  }
+
+  // Q^T A^T A Q = W diag(sigma^2) W^T, in ascending order of the eigen values
+  rmm::device_uvector<math_t> G(std::size_t(l) * l, stream);
+  rmm::device_uvector<math_t> W(std::size_t(l) * l, stream);
+  rmm::device_uvector<math_t> eig_vals(l, stream);
+  raft::linalg::gemm(
+    handle, Q.data(), n, l, Y.data(), G.data(), l, l, CUBLAS_OP_T, CUBLAS_OP_N, stream);
+  raft::linalg::eigDC(handle, G.data(), l, l, W.data(), eig_vals.data(), stream);
+
+  // the right singular vectors Q W, reordered by descending singular values
+  raft::linalg::gemm(
+    handle, Q.data(), n, l, W.data(), Y.data(), n, l, CUBLAS_OP_N, CUBLAS_OP_N, stream);
+  raft::linalg::map_offset(
+    handle,
+    raft::make_device_vector_view<math_t, std::size_t>(S, k),
+    [l, lambda = eig_vals.data()] __device__(std::size_t i) {
+      return raft::sqrt(raft::max(lambda[l - 1 - i], math_t(0)));
+    });
+  math_t* V_out = V != nullptr ? V : Q.data();
+  raft::linalg::map_offset(handle,
+                           raft::make_device_vector_view<math_t, std::size_t>(V_out, k * n),
+                           [n, l, vecs = Y.data()] __device__(std::size_t idx) {
+                             return vecs[(l - 1 - idx / n) * std::size_t(n) + idx % n];
+                           });
+  if (U == nullptr) { return; }
+
+  // U = A V diag(1 / sigma), one more pass over the row blocks
+  raft::linalg::map_offset(handle,
+                           raft::make_device_vector_view<math_t, std::size_t>(Y.data(), k * n),
+                           [n, S, V_out] __device__(std::size_t idx) {
+                             math_t s = S[idx / n];
+                             return s > math_t(0) ? V_out[idx] / s : math_t(0);
+                           });
+  for (std::size_t row = 0; row < n_rows; row += b) {
+    int rows = std::min<std::size_t>(b, n_rows - row);
+    raft::copy(block.data(), in + row * n, std::size_t(rows) * n, stream);
+    // row-major [rows x k] block of U, computed as its column-major transpose
+    raft::linalg::gemm(handle,
+                       Y.data(),
+                       n,
+                       k,
+                       block.data(),
+                       BQ.data(),
+                       k,
+                       rows,
+                       CUBLAS_OP_T,
+                       CUBLAS_OP_N,
+                       stream);
+    raft::copy(U + row * k, BQ.data(), std::size_t(rows) * k, stream);
+  }
+  resource::sync_stream(handle);
+}
+
 /**
  * @brief randomized singular value decomposition (RSVD) on the column major
  * float type input matrix (Jacobi-based), by specifying no. of PCs and
@@ -36,6 +36,8 @@
 #include <rmm/device_scalar.hpp>
 #include <rmm/device_uvector.hpp>
 
+#include <algorithm>
+
 namespace raft {
 namespace linalg {
 namespace detail {
@@ -332,6 +334,121 @@ bool evaluateSVDByL2Norm(raft::resources const& handle,
   return (percent_error / 100.0 < tol);
 }
 
+/**
+ * The matrices are row-major [n_rows x n_cols], hence seen by cuSOLVER as their column-major
+ * transposes: the left and right singular vectors are swapped, and both come out as the rows of
+ * the row-major outputs.
+ */
+template <typename math_t, typename idx_t>
+void svdJacobiBatched(raft::resources const& handle,
+                      const math_t* in,
+                      idx_t batch_size,
+                      idx_t n_rows,
+                      idx_t n_cols,
+                      math_t* sing_vals,
+                      math_t* left_sing_vecs,
+                      math_t* right_sing_vecs,
+                      math_t tol,
+                      int max_sweeps)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "raft::linalg::svdJacobiBatched(%d, %d, %d)", batch_size, n_rows, n_cols);
+  auto stream                  = resource::get_cuda_stream(handle);
+  cusolverDnHandle_t cusolverH = resource::get_cusolver_dn_handle(handle);
+
+  gesvdjInfo_t gesvdj_params = NULL;
+  RAFT_CUSOLVER_TRY(cusolverDnCreateGesvdjInfo(&gesvdj_params));
+  RAFT_CUSOLVER_TRY(cusolverDnXgesvdjSetTolerance(gesvdj_params, tol));
+  RAFT_CUSOLVER_TRY(cusolverDnXgesvdjSetMaxSweeps(gesvdj_params, max_sweeps));
+
+  // the column-major problem solved by cuSOLVER
+  int m         = n_cols;
+  int n         = n_rows;
+  size_t stride = static_cast<size_t>(m) * n;
+
+  // gesvdj overwrites its input
+  rmm::device_uvector<math_t> work_in(stride * batch_size, stream);
+  raft::copy(work_in.data(), in, work_in.size(), stream);
+  rmm::device_uvector<int> dev_info(batch_size, stream);
+
+  int lwork = 0;
+  if (m <= kMaxBatchedJacobiSize && n <= kMaxBatchedJacobiSize) {
+    RAFT_CUSOLVER_TRY(cusolverDngesvdjBatched_bufferSize(cusolverH,
+                                                         CUSOLVER_EIG_MODE_VECTOR,
+                                                         m,
+                                                         n,
+                                                         work_in.data(),
+                                                         m,
+                                                         sing_vals,
+                                                         right_sing_vecs,
+                                                         m,
+                                                         left_sing_vecs,
+                                                         n,
+                                                         &lwork,
+                                                         gesvdj_params,
+                                                         batch_size));
+    rmm::device_uvector<math_t> d_work(lwork, stream);
+    RAFT_CUSOLVER_TRY(cusolverDngesvdjBatched(cusolverH,
+                                              CUSOLVER_EIG_MODE_VECTOR,
+                                              m,
+                                              n,
+                                              work_in.data(),
+                                              m,
+                                              sing_vals,
+                                              right_sing_vecs,
+                                              m,
+                                              left_sing_vecs,
+                                              n,
+                                              d_work.data(),
+                                              lwork,
+                                              dev_info.data(),
+                                              gesvdj_params,
+                                              batch_size,
+                                              stream));
+  } else {
+    // cuSOLVER has no batched Jacobi solver for these sizes; reuse the workspace for every matrix
+    int econ = 0;
+    RAFT_CUSOLVER_TRY(cusolverDngesvdj_bufferSize(cusolverH,
+                                                  CUSOLVER_EIG_MODE_VECTOR,
+                                                  econ,
+                                                  m,
+                                                  n,
+                                                  work_in.data(),
+                                                  m,
+                                                  sing_vals,
+                                                  right_sing_vecs,
+                                                  m,
+                                                  left_sing_vecs,
+                                                  n,
+                                                  &lwork,
+                                                  gesvdj_params));
+    rmm::device_uvector<math_t> d_work(lwork, stream);
+    size_t k = std::min(m, n);
+    for (idx_t i = 0; i < batch_size; i++) {
+      RAFT_CUSOLVER_TRY(cusolverDngesvdj(cusolverH,
+                                         CUSOLVER_EIG_MODE_VECTOR,
+                                         econ,
+                                         m,
+                                         n,
+                                         work_in.data() + i * stride,
+                                         m,
+                                         sing_vals + i * k,
+                                         right_sing_vecs + i * static_cast<size_t>(m) * m,
+                                         m,
+                                         left_sing_vecs + i * static_cast<size_t>(n) * n,
+                                         n,
+                                         d_work.data(),
+                                         lwork,
+                                         dev_info.data() + i,
+                                         gesvdj_params,
+                                         stream));
+    }
+  }
+
+  RAFT_CUDA_TRY(cudaGetLastError());
+  RAFT_CUSOLVER_TRY(cusolverDnDestroyGesvdjInfo(gesvdj_params));
+}
+
 };  // end namespace detail
 };  // end namespace linalg
 };  // end namespace raft
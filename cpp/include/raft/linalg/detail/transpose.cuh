@@ -22,9 +22,15 @@
 #include <raft/core/resource/cublas_handle.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resources.hpp>
-#include <rmm/exec_policy.hpp>
-#include <thrust/for_each.h>
-#include <thrust/iterator/counting_iterator.h>
+#include <raft/util/cuda_dev_essentials.cuh>
+#include <raft/util/cuda_utils.cuh>
+
+#include <cuda_fp16.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
 
 namespace raft {
 namespace linalg {
@@ -62,32 +68,191 @@ void transpose(raft::resources const& handle,
                              stream));
 }
 
+constexpr int kTransposeTileDim   = 32;
+constexpr int kTransposeBlockRows = 8;
+
+/** Element conversion of the transpose kernels; `half` is converted through `float`. */
+template <typename OutT, typename InT>
+HDI auto transpose_convert(InT x) -> OutT
+{
+  if constexpr (std::is_same_v<InT, OutT>) {
+    return x;
+  } else if constexpr (std::is_same_v<InT, half> || std::is_same_v<OutT, half>) {
+    return static_cast<OutT>(static_cast<float>(x));
+  } else {
+    return static_cast<OutT>(x);
+  }
+}
+
+/**
+ * Transpose the row-major [n_rows x n_cols] matrix `in` (leading dimension `ld_in`) into the
+ * row-major [n_cols x n_rows] matrix `out` (leading dimension `ld_out`). Each block moves one
+ * 32 x 32 tile through shared memory, so that both the loads and the stores are coalesced.
+ */
+template <typename InT, typename OutT, typename IdxT>
+__global__ void transpose_tiled_kernel(
+  OutT* out, IdxT ld_out, const InT* in, IdxT ld_in, IdxT n_rows, IdxT n_cols)
+{
+  // the padding column avoids the shared memory bank conflicts of the column accesses
+  __shared__ OutT tile[kTransposeTileDim][kTransposeTileDim + 1];
+
+  const IdxT n_tile_rows = raft::ceildiv<IdxT>(n_rows, kTransposeTileDim);
+  const IdxT tile_col    = static_cast<IdxT>(blockIdx.x) * kTransposeTileDim;
+  for (IdxT ty = blockIdx.y; ty < n_tile_rows; ty += gridDim.y) {
+    const IdxT tile_row = ty * kTransposeTileDim;
+    for (int r = threadIdx.y; r < kTransposeTileDim; r += kTransposeBlockRows) {
+      IdxT i = tile_row + r;
+      IdxT j = tile_col + threadIdx.x;
+      if (i < n_rows && j < n_cols) {
+        tile[r][threadIdx.x] = transpose_convert<OutT>(in[static_cast<size_t>(i) * ld_in + j]);
+      }
+    }
+    __syncthreads();
+    for (int r = threadIdx.y; r < kTransposeTileDim; r += kTransposeBlockRows) {
+      IdxT i = tile_col + r;
+      IdxT j = tile_row + threadIdx.x;
+      if (i < n_cols && j < n_rows) {
+        out[static_cast<size_t>(i) * ld_out + j] = tile[threadIdx.x][r];
+      }
+    }
+    __syncthreads();
+  }
+}
+
+/**
+ * In-place transpose of the square [n x n] matrix `data` (leading dimension `ld`): the block
+ * (x, y), y <= x, swaps the tile (y, x) with the transpose of the tile (x, y).
+ */
+template <typename T, typename IdxT>
+__global__ void transpose_square_inplace_kernel(T* data, IdxT n, IdxT ld)
+{
+  __shared__ T tile_a[kTransposeTileDim][kTransposeTileDim + 1];
+  __shared__ T tile_b[kTransposeTileDim][kTransposeTileDim + 1];
+
+  if (blockIdx.y > blockIdx.x) { return; }
+  const bool diagonal = blockIdx.x == blockIdx.y;
+  const IdxT a_row    = static_cast<IdxT>(blockIdx.y) * kTransposeTileDim;
+  const IdxT a_col    = static_cast<IdxT>(blockIdx.x) * kTransposeTileDim;
+  for (int r = threadIdx.y; r < kTransposeTileDim; r += kTransposeBlockRows) {
+    IdxT i = a_row + r;
+    IdxT j = a_col + threadIdx.x;
+    if (i < n && j < n) { tile_a[r][threadIdx.x] = data[static_cast<size_t>(i) * ld + j]; }
+    i = a_col + r;
+    j = a_row + threadIdx.x;
+    if (!diagonal && i < n && j < n) {
+      tile_b[r][threadIdx.x] = data[static_cast<size_t>(i) * ld + j];
+    }
+  }
+  __syncthreads();
+  for (int r = threadIdx.y; r < kTransposeTileDim; r += kTransposeBlockRows) {
+    IdxT i = a_row + r;
+    IdxT j = a_col + threadIdx.x;
+    if (i < n && j < n) {
+      data[static_cast<size_t>(i) * ld + j] =
+        diagonal ? tile_a[threadIdx.x][r] : tile_b[threadIdx.x][r];
+    }
+    i = a_col + r;
+    j = a_row + threadIdx.x;
+    if (!diagonal && i < n && j < n) {
+      data[static_cast<size_t>(i) * ld + j] = tile_a[threadIdx.x][r];
+    }
+  }
+}
+
+/**
+ * In-place transpose of the contiguous row-major [n_rows x n_cols] matrix `data` by cycle
+ * following: the element at the offset k moves to the offset (k * n_rows) mod (size - 1). Every
+ * thread walks the cycle of one offset and, when that offset is the smallest one of its cycle,
+ * rotates the elements of the cycle.
+ */
+template <typename T>
+__global__ void transpose_cycles_kernel(T* data, uint64_t n_rows, uint64_t size)
+{
+  const uint64_t modulo = size - 1;
+  for (uint64_t start = static_cast<uint64_t>(blockIdx.x) * blockDim.x + threadIdx.x + 1;
+       start < modulo;
+       start += static_cast<uint64_t>(gridDim.x) * blockDim.x) {
+    uint64_t k = (start * n_rows) % modulo;
+    while (k > start) {
+      k = (k * n_rows) % modulo;
+    }
+    if (k < start) { continue; }
+
+    T val = data[start];
+    k     = start;
+    do {
+      k       = (k * n_rows) % modulo;
+      T tmp   = data[k];
+      data[k] = val;
+      val     = tmp;
+    } while (k != start);
+  }
+}
+
+template <typename InT, typename OutT, typename IdxT>
+void transpose_tiled(raft::resources const& handle,
+                     const InT* in,
+                     IdxT ld_in,
+                     OutT* out,
+                     IdxT ld_out,
+                     IdxT n_rows,
+                     IdxT n_cols)
+{
+  if (n_rows == 0 || n_cols == 0) { return; }
+  constexpr IdxT kMaxGridY = 65535;
+  dim3 threads(kTransposeTileDim, kTransposeBlockRows);
+  dim3 blocks(raft::ceildiv<IdxT>(n_cols, kTransposeTileDim),
+              std::min<IdxT>(raft::ceildiv<IdxT>(n_rows, kTransposeTileDim), kMaxGridY));
+  transpose_tiled_kernel<<<blocks, threads, 0, resource::get_cuda_stream(handle)>>>(
+    out, ld_out, in, ld_in, n_rows, n_cols);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+template <typename T, typename IdxT>
+void transpose_square_inplace(T* inout, IdxT n, IdxT ld, cudaStream_t stream)
+{
+  if (n == 0) { return; }
+  auto n_tiles = raft::ceildiv<IdxT>(n, kTransposeTileDim);
+  dim3 threads(kTransposeTileDim, kTransposeBlockRows);
+  dim3 blocks(n_tiles, n_tiles);
+  transpose_square_inplace_kernel<<<blocks, threads, 0, stream>>>(inout, n, ld);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+template <typename T, typename IdxT>
+void transpose_inplace(raft::resources const& handle, T* inout, IdxT n_rows, IdxT n_cols)
+{
+  auto stream = resource::get_cuda_stream(handle);
+  if (n_rows == n_cols) {
+    transpose_square_inplace(inout, n_rows, n_rows, stream);
+    return;
+  }
+  uint64_t size = static_cast<uint64_t>(n_rows) * n_cols;
+  if (size <= 2) { return; }
+  RAFT_EXPECTS(size <= std::numeric_limits<uint64_t>::max() / static_cast<uint64_t>(n_rows),
+               "The matrix is too large for the in-place transpose");
+  constexpr int kTpb = 256;
+  auto n_blocks      = std::min<uint64_t>(raft::ceildiv<uint64_t>(size, kTpb), 65536);
+  transpose_cycles_kernel<<<n_blocks, kTpb, 0, stream>>>(inout, uint64_t(n_rows), size);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
 template <typename math_t>
 void transpose(math_t* inout, int n, cudaStream_t stream)
 {
-  auto m        = n;
-  auto size     = n * n;
-  auto d_inout  = inout;
-  auto counting = thrust::make_counting_iterator<int>(0);
-
-  thrust::for_each(rmm::exec_policy(stream), counting, counting + size, [=] __device__(int idx) {
-    int s_row = idx % m;
-    int s_col = idx / m;
-    int d_row = s_col;
-    int d_col = s_row;
-    if (s_row < s_col) {
-      auto temp                  = d_inout[d_col * m + d_row];
-      d_inout[d_col * m + d_row] = d_inout[s_col * m + s_row];
-      d_inout[s_col * m + s_row] = temp;
-    }
-  });
+  transpose_square_inplace(inout, n, n, stream);
 }
 
-template <typename T, typename IndexType, typename LayoutPolicy, typename AccessorPolicy>
+template <typename InElementType,
+          typename T,
+          typename IndexType,
+          typename LayoutPolicy,
+          typename InAccessorPolicy,
+          typename OutAccessorPolicy>
 void transpose_row_major_impl(
   raft::resources const& handle,
-  raft::mdspan<T, raft::matrix_extent<IndexType>, LayoutPolicy, AccessorPolicy> in,
-  raft::mdspan<T, raft::matrix_extent<IndexType>, LayoutPolicy, AccessorPolicy> out)
+  raft::mdspan<InElementType, raft::matrix_extent<IndexType>, LayoutPolicy, InAccessorPolicy> in,
+  raft::mdspan<T, raft::matrix_extent<IndexType>, LayoutPolicy, OutAccessorPolicy> out)
 {
   auto out_n_rows   = in.extent(1);
   auto out_n_cols   = in.extent(0);
@@ -110,11 +275,16 @@ void transpose_row_major_impl(
                         resource::get_cuda_stream(handle)));
 }
 
-template <typename T, typename IndexType, typename LayoutPolicy, typename AccessorPolicy>
+template <typename InElementType,
+          typename T,
+          typename IndexType,
+          typename LayoutPolicy,
+          typename InAccessorPolicy,
+          typename OutAccessorPolicy>
 void transpose_col_major_impl(
   raft::resources const& handle,
-  raft::mdspan<T, raft::matrix_extent<IndexType>, LayoutPolicy, AccessorPolicy> in,
-  raft::mdspan<T, raft::matrix_extent<IndexType>, LayoutPolicy, AccessorPolicy> out)
+  raft::mdspan<InElementType, raft::matrix_extent<IndexType>, LayoutPolicy, InAccessorPolicy> in,
+  raft::mdspan<T, raft::matrix_extent<IndexType>, LayoutPolicy, OutAccessorPolicy> out)
 {
   auto out_n_rows   = in.extent(1);
   auto out_n_cols   = in.extent(0);
@@ -22,6 +22,7 @@
 #include <raft/core/resource/cuda_stream.hpp>
 
 #include <raft/core/device_mdspan.hpp>
+#include <raft/linalg/linalg_types.hpp>
 
 namespace raft {
 namespace linalg {
@@ -218,6 +219,47 @@ void eig_jacobi(raft::resources const& handle,
             sweeps);
 }
 
+/**
+ * @brief eig decomp with Jacobi method of a batch of small symmetric matrices
+ *
+ * All the matrices are decomposed by a single batched cuSOLVER call when they are at most 32 x 32,
+ * which saves one launch (and one workspace query) per matrix; larger matrices are decomposed one
+ * after the other, sharing one workspace.
+ *
+ * @tparam ValueType the data-type of input and output
+ * @tparam IndexType Integer used for addressing
+ * @param[in] handle raft::resources
+ * @param[in] in the symmetric matrices, raft::device_batch_matrix_view [batch, n, n]
+ * @param[out] eig_vectors the eigenvectors of each matrix, stored as its rows [batch, n, n]
+ * @param[out] eig_vals the eigenvalues of each matrix in ascending order [batch, n]
+ * @param[in] tol: error tolerance for the jacobi method
+ * @param[in] sweeps: maximum number of sweeps in the Jacobi algorithm
+ */
+template <typename ValueType, typename IndexType>
+void eig_jacobi_batched(raft::resources const& handle,
+                        device_batch_matrix_view<const ValueType, IndexType> in,
+                        device_batch_matrix_view<ValueType, IndexType> eig_vectors,
+                        raft::device_matrix_view<ValueType, IndexType, raft::row_major> eig_vals,
+                        ValueType tol = 1.e-7,
+                        int sweeps    = 15)
+{
+  RAFT_EXPECTS(in.extent(1) == in.extent(2), "The input matrices should be square");
+  RAFT_EXPECTS(eig_vectors.extent(0) == in.extent(0) && eig_vectors.extent(1) == in.extent(1) &&
+                 eig_vectors.extent(2) == in.extent(2),
+               "Size mismatch between Input and Eigen Vectors");
+  RAFT_EXPECTS(eig_vals.extent(0) == in.extent(0) && eig_vals.extent(1) == in.extent(1),
+               "Size mismatch between Input and Eigen Values");
+
+  detail::eigJacobiBatched(handle,
+                           in.data_handle(),
+                           in.extent(0),
+                           in.extent(1),
+                           eig_vectors.data_handle(),
+                           eig_vals.data_handle(),
+                           tol,
+                           sweeps);
+}
+
 /** @} */  // end of eig
 
 };         // end namespace linalg
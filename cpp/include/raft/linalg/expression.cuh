@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "detail/expression.cuh"
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/error.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/linalg/linalg_types.hpp>
+
+namespace raft::linalg {
+
+/**
+ * @defgroup expression Fused chains of elementwise ops and reductions
+ * @{
+ */
+
+/**
+ * @brief A deferred chain of elementwise operations over a row-major matrix.
+ *
+ * Building an expression does not launch any work: every call of `map`, `map_rows`, `map_cols`
+ * or `zip` returns a new expression which applies one more operation on the result of the
+ * previous ones. The whole chain is executed by a single kernel when the expression is passed
+ * to `evaluate` (to materialize it) or to `evaluate_reduce` (to reduce it along the rows or the
+ * columns), so the source matrix is read only once.
+ *
+ * Usage example (standardize the columns and take the squared L2 norm of every row):
+ * @code{.cpp}
+ *  #include <raft/linalg/expression.cuh>
+ *
+ *  auto x_std = raft::linalg::make_expression(x)
+ *                 .map_cols(raft::sub_op{}, mu)
+ *                 .map_cols(raft::div_op{}, sigma);
+ *  raft::linalg::evaluate_reduce(
+ *    res, x_std.map(raft::sq_op{}), norms.view(), 0.0f, raft::linalg::Apply::ALONG_ROWS);
+ * @endcode
+ *
+ * @tparam T type of the elements of the source matrix
+ * @tparam IdxT integer type used for addressing
+ * @tparam Op the composed functor `(T x, IdxT i, IdxT j) -> value`
+ */
+template <typename T, typename IdxT, typename Op>
+class matrix_expression {
+ public:
+  using source_view_type = raft::device_matrix_view<const T, IdxT, raft::row_major>;
+
+  matrix_expression(source_view_type source, Op op) : source_(source), op_(op) {}
+
+  /**
+   * @brief Apply an elementwise operation.
+   * @param f device functor (value) -> value
+   */
+  template <typename Func>
+  auto map(Func f) const
+  {
+    using op_t = detail::expression_map_op<Op, Func>;
+    return matrix_expression<T, IdxT, op_t>(source_, op_t{op_, f});
+  }
+
+  /**
+   * @brief Combine every element with the entry of its row in a vector.
+   * @param f device functor (value, vec[i]) -> value
+   * @param vec vector of the size of the number of rows
+   */
+  template <typename Func, typename VecT>
+  auto map_rows(Func f, raft::device_vector_view<const VecT, IdxT> vec) const
+  {
+    RAFT_EXPECTS(vec.extent(0) == source_.extent(0), "Size mismatch between matrix and vector");
+    using op_t = detail::expression_broadcast_op<Op, Func, VecT, true>;
+    return matrix_expression<T, IdxT, op_t>(source_, op_t{op_, f, vec.data_handle()});
+  }
+
+  /**
+   * @brief Combine every element with the entry of its column in a vector.
+   * @param f device functor (value, vec[j]) -> value
+   * @param vec vector of the size of the number of columns
+   */
+  template <typename Func, typename VecT>
+  auto map_cols(Func f, raft::device_vector_view<const VecT, IdxT> vec) const
+  {
+    RAFT_EXPECTS(vec.extent(0) == source_.extent(1), "Size mismatch between matrix and vector");
+    using op_t = detail::expression_broadcast_op<Op, Func, VecT, false>;
+    return matrix_expression<T, IdxT, op_t>(source_, op_t{op_, f, vec.data_handle()});
+  }
+
+  /**
+   * @brief Combine every element with the element at the same position of another matrix.
+   * @param f device functor (value, other(i, j)) -> value
+   * @param other row-major matrix of the shape of the source
+   */
+  template <typename Func, typename U>
+  auto zip(Func f, raft::device_matrix_view<const U, IdxT, raft::row_major> other) const
+  {
+    RAFT_EXPECTS(other.extent(0) == source_.extent(0) && other.extent(1) == source_.extent(1),
+                 "Shape mismatch between the matrices");
+    using op_t = detail::expression_zip_op<Op, Func, U, IdxT>;
+    return matrix_expression<T, IdxT, op_t>(
+      source_, op_t{op_, f, other.data_handle(), other.extent(1)});
+  }
+
+  [[nodiscard]] auto source() const -> source_view_type { return source_; }
+  [[nodiscard]] auto op() const -> const Op& { return op_; }
+
+ private:
+  source_view_type source_;
+  Op op_;
+};
+
+/**
+ * @brief Start an expression from a row-major matrix.
+ * @param[in] source the matrix read by the expression
+ */
+template <typename T, typename IdxT>
+auto make_expression(raft::device_matrix_view<const T, IdxT, raft::row_major> source)
+{
+  return matrix_expression<T, IdxT, detail::expression_source_op>(source,
+                                                                  detail::expression_source_op{});
+}
+
+/**
+ * @brief Materialize an expression with one kernel.
+ *
+ * The source is loaded and `out` is stored using vectorized instructions when the pointers are
+ * aligned, as in `raft::linalg::map`. `out` may alias the source.
+ *
+ * @param[in] res raft::resources
+ * @param[in] expr the expression
+ * @param[out] out row-major matrix of the shape of the source
+ */
+template <typename T, typename IdxT, typename Op, typename OutT>
+void evaluate(raft::resources const& res,
+              const matrix_expression<T, IdxT, Op>& expr,
+              raft::device_matrix_view<OutT, IdxT, raft::row_major> out)
+{
+  auto src = expr.source();
+  RAFT_EXPECTS(out.extent(0) == src.extent(0) && out.extent(1) == src.extent(1),
+               "Shape mismatch between the expression and the output");
+  detail::evaluate(res, src.data_handle(), src.extent(0), src.extent(1), expr.op(), out);
+}
+
+/**
+ * @brief Reduce an expression along the rows or the columns with one kernel.
+ *
+ * Along the rows, every block reduces one row, reading it with vectorized loads when the rows
+ * are aligned. Along the columns, the rows are split in chunks whose partial results are folded
+ * by a second, small kernel when there is more than one chunk.
+ *
+ * @param[in] res raft::resources
+ * @param[in] expr the expression
+ * @param[out] dots the reduction, one value per row (Apply::ALONG_ROWS) or per column
+ *   (Apply::ALONG_COLUMNS)
+ * @param[in] init the neutral element of `reduce_op`
+ * @param[in] apply whether to reduce each row or each column
+ * @param[in] inplace reduce the result with the current content of `dots`
+ * @param[in] reduce_op binary reduction operation
+ * @param[in] final_op elementwise operation applied before storing the results
+ */
+template <typename T,
+          typename IdxT,
+          typename Op,
+          typename OutT,
+          typename ReduceOp = raft::add_op,
+          typename FinalOp  = raft::identity_op>
+void evaluate_reduce(raft::resources const& res,
+                     const matrix_expression<T, IdxT, Op>& expr,
+                     raft::device_vector_view<OutT, IdxT> dots,
+                     OutT init,
+                     Apply apply,
+                     bool inplace       = false,
+                     ReduceOp reduce_op = raft::add_op(),
+                     FinalOp final_op   = raft::identity_op())
+{
+  auto src        = expr.source();
+  bool along_rows = apply == Apply::ALONG_ROWS;
+  RAFT_EXPECTS(dots.extent(0) == (along_rows ? src.extent(0) : src.extent(1)),
+               "Output size mismatch: one value per row (or per column) is expected");
+  detail::evaluate_reduce(res,
+                          src.data_handle(),
+                          src.extent(0),
+                          src.extent(1),
+                          expr.op(),
+                          dots.data_handle(),
+                          init,
+                          along_rows,
+                          inplace,
+                          reduce_op,
+                          final_op);
+}
+
+/** @} */  // end of group expression
+
+}  // namespace raft::linalg
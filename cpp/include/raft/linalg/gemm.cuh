@@ -19,12 +19,14 @@
 #pragma once
 
 #include "detail/gemm.hpp"
+#include "detail/gemm_epilogue.cuh"
 #include <raft/core/device_mdarray.hpp>
 #include <raft/core/device_mdspan.hpp>
 #include <raft/core/host_mdarray.hpp>
 #include <raft/core/host_mdspan.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resources.hpp>
+#include <raft/linalg/linalg_types.hpp>
 #include <raft/util/input_validation.hpp>
 
 namespace raft {
@@ -271,6 +273,104 @@ void gemm(raft::resources const& handle,
                                        beta.value().data_handle());
 }
 
+/**
+ * @brief Elementwise operations applied to the output of the mixed-precision `gemm`:
+ *   Z(i, j) = relu(Z(i, j) + row_add[i] + col_add[j])
+ *
+ * A bias of a linear layer is a `col_add`; the norms of the rows of X and of the columns of Y
+ * complete an L2 distance computed as -2 . X * Y.
+ */
+template <typename OutT, typename IndexType>
+struct gemm_epilogue {
+  /** one value per row of Z */
+  std::optional<raft::device_vector_view<const OutT, IndexType>> row_add = std::nullopt;
+  /** one value per column of Z */
+  std::optional<raft::device_vector_view<const OutT, IndexType>> col_add = std::nullopt;
+  /** clamp the negative values to zero */
+  bool relu = false;
+};
+
+/**
+ * @brief GEMM with distinct input and output types and a selectable arithmetic, e.g. half
+ * inputs with float output, or float GEMMs on TF32 tensor cores
+ * It computes the following equation: Z = epilogue(alpha . X * Y + beta . Z)
+ *
+ * The product is computed by cublasGemmEx with the tensor core algorithms allowed. The
+ * epilogue, when not empty, is applied by a single elementwise pass over Z.
+ *
+ * @tparam InT Data type of the input matrices (half, nv_bfloat16, float, double)
+ * @tparam OutT Data type of the output matrix (half, float, double)
+ * @tparam IndexType Type of index
+ * @tparam LayoutPolicyX layout of X
+ * @tparam LayoutPolicyY layout of Y
+ * @tparam LayoutPolicyZ layout of Z
+ * @param[in] handle raft handle
+ * @param[in] x input raft::device_matrix_view of size M rows x K columns
+ * @param[in] y input raft::device_matrix_view of size K rows x N columns
+ * @param[inout] z output raft::device_matrix_view of size M rows x N columns
+ * @param[in] compute the arithmetic of the product, see raft::linalg::GemmCompute
+ * @param[in] alpha scalar, converted to the type of the accumulation
+ * @param[in] beta scalar, converted to the type of the accumulation
+ * @param[in] epilogue elementwise operations applied to the result
+ */
+template <typename InT,
+          typename OutT,
+          typename IndexType,
+          typename LayoutPolicyX,
+          typename LayoutPolicyY,
+          typename LayoutPolicyZ>
+void gemm(raft::resources const& handle,
+          raft::device_matrix_view<const InT, IndexType, LayoutPolicyX> x,
+          raft::device_matrix_view<const InT, IndexType, LayoutPolicyY> y,
+          raft::device_matrix_view<OutT, IndexType, LayoutPolicyZ> z,
+          GemmCompute compute,
+          double alpha                                   = 1.0,
+          double beta                                    = 0.0,
+          const gemm_epilogue<OutT, IndexType>& epilogue = {})
+{
+  RAFT_EXPECTS(raft::is_row_or_column_major(x), "X is not contiguous");
+  RAFT_EXPECTS(raft::is_row_or_column_major(y), "Y is not contiguous");
+  RAFT_EXPECTS(raft::is_row_or_column_major(z), "Z is not contiguous");
+
+  RAFT_EXPECTS(x.extent(0) == z.extent(0), "Number of rows of X and Z should be equal");
+  RAFT_EXPECTS(y.extent(1) == z.extent(1), "Number of columns of Y and Z should be equal");
+  RAFT_EXPECTS(x.extent(1) == y.extent(0), "Number of columns of X and rows of Y should be equal");
+  RAFT_EXPECTS(!epilogue.row_add || epilogue.row_add->extent(0) == z.extent(0),
+               "row_add should have one value per row of Z");
+  RAFT_EXPECTS(!epilogue.col_add || epilogue.col_add->extent(0) == z.extent(1),
+               "col_add should have one value per column of Z");
+
+  constexpr auto is_x_col_major =
+    std::is_same_v<typename decltype(x)::layout_type, raft::col_major>;
+  constexpr auto is_y_col_major =
+    std::is_same_v<typename decltype(y)::layout_type, raft::col_major>;
+  constexpr auto is_z_col_major =
+    std::is_same_v<typename decltype(z)::layout_type, raft::col_major>;
+
+  detail::gemm_ex(handle,
+                  z.data_handle(),
+                  x.data_handle(),
+                  y.data_handle(),
+                  x.extent(0),
+                  y.extent(1),
+                  x.extent(1),
+                  is_z_col_major,
+                  is_x_col_major,
+                  is_y_col_major,
+                  compute,
+                  alpha,
+                  beta,
+                  resource::get_cuda_stream(handle));
+  detail::gemm_epilogue<is_z_col_major>(
+    handle,
+    z.data_handle(),
+    z.extent(0),
+    z.extent(1),
+    epilogue.row_add ? epilogue.row_add->data_handle() : nullptr,
+    epilogue.col_add ? epilogue.col_add->data_handle() : nullptr,
+    epilogue.relu);
+}
+
 /** @} */  // end of gemm
 
 }  // end namespace linalg
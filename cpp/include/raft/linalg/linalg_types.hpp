@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <raft/core/device_mdspan.hpp>
+
 namespace raft::linalg {
 
 /**
@@ -32,4 +34,34 @@ enum class Apply { ALONG_ROWS, ALONG_COLUMNS };
  */
 enum class FillMode { UPPER, LOWER };
 
+/**
+ * @brief The arithmetic of the mixed-precision GEMM.
+ *
+ * DEFAULT accumulates in fp32 for the half and float outputs and in fp64 for the double outputs.
+ * TF32 runs the float GEMMs on tensor cores with the inputs rounded to TF32. FP16 accumulates
+ * the half inputs in half precision, for half outputs only.
+ */
+enum class GemmCompute { DEFAULT, TF32, FP16 };
+
+/**
+ * @brief The strategy of `reduce_rows_by_key`.
+ *
+ * ATOMIC adds every element to the output with a global atomic. SHARED_BINS accumulates the sums
+ * of a block of rows in shared memory, when all the [nkeys x ncols] sums fit there. SORTED sorts
+ * the rows by key and reduces every segment of rows without atomics, which suits the large
+ * numbers of keys. AUTO picks the strategy from the number of keys and columns: the shared bins
+ * when they fit, SORTED above 16k keys and ATOMIC in between.
+ */
+enum class ReduceRowsByKeyAlgo { AUTO, ATOMIC, SHARED_BINS, SORTED };
+
+/**
+ * @brief A batch of matrices of the same shape, [batch, n_rows, n_cols], each stored row-major
+ *        and contiguous after the previous one.
+ */
+template <typename ElementType, typename IndexType>
+using device_batch_matrix_view = raft::device_mdspan<
+  ElementType,
+  raft::extents<IndexType, raft::dynamic_extent, raft::dynamic_extent, raft::dynamic_extent>,
+  raft::row_major>;
+
 }  // end namespace raft::linalg
\ No newline at end of file
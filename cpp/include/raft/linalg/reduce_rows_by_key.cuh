@@ -23,6 +23,7 @@
 
 #include <raft/core/device_mdspan.hpp>
 #include <raft/core/resources.hpp>
+#include <raft/linalg/linalg_types.hpp>
 
 namespace raft {
 namespace linalg {
@@ -58,6 +59,7 @@ void convert_array(IteratorT1 dst, IteratorT2 src, int n, cudaStream_t st)
  * @param[out] d_sums      Row sums by key (ncols x d_keys)
  * @param[in]  stream      CUDA stream
  * @param[in]  reset_sums  Whether to reset the output sums to zero before reducing
+ * @param[in]  algo        The reduction strategy, see raft::linalg::ReduceRowsByKeyAlgo
  */
 template <typename DataIteratorT,
           typename KeysIteratorT,
@@ -74,10 +76,21 @@ void reduce_rows_by_key(const DataIteratorT d_A,
                         IdxT nkeys,
                         SumsT* d_sums,
                         cudaStream_t stream,
-                        bool reset_sums = true)
+                        bool reset_sums          = true,
+                        ReduceRowsByKeyAlgo algo                                                       = ReduceRowsByKeyAlgo::AUTO)
 {
-  detail::reduce_rows_by_key(
-    d_A, lda, d_keys, d_weights, d_keys_char, nrows, ncols, nkeys, d_sums, stream, reset_sums);
+  detail::reduce_rows_by_key(d_A,
+                             lda,
+                             d_keys,
+                             d_weights,
+                             d_keys_char,
+                             nrows,
+                             ncols,
+                             nkeys,
+                             d_sums,
+                             stream,
+                             reset_sums,
+                             algo);
 }
 
 /**
@@ -98,6 +111,7 @@ void reduce_rows_by_key(const DataIteratorT d_A,
  * @param[out] d_sums      Row sums by key (ncols x d_keys)
  * @param[in]  stream      CUDA stream
  * @param[in]  reset_sums  Whether to reset the output sums to zero before reducing
+ * @param[in]  algo        The reduction strategy, see raft::linalg::ReduceRowsByKeyAlgo
  */
 template <typename DataIteratorT, typename KeysIteratorT, typename SumsT, typename IdxT>
 void reduce_rows_by_key(const DataIteratorT d_A,
@@ -109,7 +123,8 @@ void reduce_rows_by_key(const DataIteratorT d_A,
                         IdxT nkeys,
                         SumsT* d_sums,
                         cudaStream_t stream,
-                        bool reset_sums = true)
+                        bool reset_sums          = true,
+                        ReduceRowsByKeyAlgo algo                                                       = ReduceRowsByKeyAlgo::AUTO)
 {
   typedef typename std::iterator_traits<DataIteratorT>::value_type DataType;
   reduce_rows_by_key(d_A,
@@ -122,7 +137,8 @@ void reduce_rows_by_key(const DataIteratorT d_A,
                      nkeys,
                      d_sums,
                      stream,
-                     reset_sums);
+                     reset_sums,
+                     algo);
 }
 
 /**
@@ -146,6 +162,7 @@ void reduce_rows_by_key(const DataIteratorT d_A,
  * @param[in]  d_weights   Weights for each observation in d_A raft::device_vector_view optional (1
  * x nrows)
  * @param[in]  reset_sums  Whether to reset the output sums to zero before reducing
+ * @param[in]  algo        The reduction strategy, see raft::linalg::ReduceRowsByKeyAlgo
  */
 template <typename ElementType, typename KeyType, typename WeightType, typename IndexType>
 void reduce_rows_by_key(
@@ -156,7 +173,8 @@ void reduce_rows_by_key(
   IndexType n_unique_keys,
   raft::device_vector_view<char, IndexType> d_keys_char,
   std::optional<raft::device_vector_view<const WeightType, IndexType>> d_weights = std::nullopt,
-  bool reset_sums                                                                = true)
+  bool reset_sums                                                                = true,
+  ReduceRowsByKeyAlgo algo                                                       = ReduceRowsByKeyAlgo::AUTO)
 {
   RAFT_EXPECTS(d_A.extent(0) == d_A.extent(0) && d_sums.extent(1) == n_unique_keys,
                "Output is not of size ncols * n_unique_keys");
@@ -175,7 +193,8 @@ void reduce_rows_by_key(
                        n_unique_keys,
                        d_sums.data_handle(),
                        resource::get_cuda_stream(handle),
-                       reset_sums);
+                       reset_sums,
+                       algo);
   } else {
     reduce_rows_by_key(d_A.data_handle(),
                        d_A.extent(0),
@@ -186,7 +205,8 @@ void reduce_rows_by_key(
                        n_unique_keys,
                        d_sums.data_handle(),
                        resource::get_cuda_stream(handle),
-                       reset_sums);
+                       reset_sums,
+                       algo);
   }
 }
 
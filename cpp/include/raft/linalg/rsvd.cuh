@@ -20,6 +20,7 @@
 
 #include "detail/rsvd.cuh"
 #include <raft/core/device_mdspan.hpp>
+#include <raft/core/host_mdspan.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 
 namespace raft {
@@ -874,6 +875,100 @@ void randomized_svd(const raft::resources& handle,
   randomized_svd(handle, in, S, opt_u, opt_v, p, niters);
 }
 
+/**
+ * @brief randomized singular value decomposition (RSVD) of a row-major matrix residing in host
+ * memory, for matrices too large for the device
+ *
+ * The matrix is copied to the device by blocks of `batch_rows` rows, once per power iteration
+ * (plus once more to compute U): each pass accumulates the sketch A^T * A * Q with two GEMMs per
+ * block. Only one block and a few [n_cols x (k + p)] sketches are kept on the device, so the
+ * number of rows is limited by the host memory only. The host matrix should be in pinned memory
+ * for the copies to reach the full bandwidth.
+ *
+ * Since the singular values are recovered from the eigen values of a small Gram matrix, the
+ * singular values much smaller than the largest one lose accuracy (as with `rsvd_fixed_rank`
+ * using `use_bbt`). This suits PCA, which keeps the leading components.
+ *
+ * @tparam math_t the data type
+ * @tparam idx_t index type
+ * @param[in]  handle:     raft handle
+ * @param[in]  in:         row-major host matrix [dim = n_rows * n_cols]
+ * @param[out] S:          the k largest singular values, in descending order [dim = k]
+ * @param[out] U:          optional row-major host matrix of the left singular vectors, stored as
+ *                         its columns. Use std::nullopt to not generate it (and save one pass
+ *                         over the input). [dim = n_rows * k]
+ * @param[out] V:          optional row-major device matrix of the right singular vectors, stored
+ *                         as its rows. Use std::nullopt to not generate it. [dim = k * n_cols]
+ * @param[in]  p:          Oversampling. The size of the subspace will be (k + p), which must not
+ *                         exceed min(n_rows, n_cols).
+ * @param[in]  niters:     Number of iterations of the power method.
+ * @param[in]  batch_rows: Number of rows copied to the device at once.
+ * @param[in]  seed:       Seed of the random start of the range finder.
+ */
+template <typename math_t, typename idx_t>
+void randomized_svd_streaming(
+  const raft::resources& handle,
+  raft::host_matrix_view<const math_t, idx_t, raft::row_major> in,
+  raft::device_vector_view<math_t, idx_t> S,
+  std::optional<raft::host_matrix_view<math_t, idx_t, raft::row_major>> U,
+  std::optional<raft::device_matrix_view<math_t, idx_t, raft::row_major>> V,
+  std::size_t p,
+  std::size_t niters,
+  std::size_t batch_rows = 65536,
+  uint64_t seed          = 0)
+{
+  auto k        = S.extent(0);
+  math_t* U_ptr = nullptr;
+  math_t* V_ptr = nullptr;
+  if (U) {
+    RAFT_EXPECTS(in.extent(0) == U.value().extent(0) && k == U.value().extent(1),
+                 "U should have dimensions n_rows * k");
+    U_ptr = U.value().data_handle();
+  }
+  if (V) {
+    RAFT_EXPECTS(k == V.value().extent(0) && in.extent(1) == V.value().extent(1),
+                 "V should have dimensions k * n_cols");
+    V_ptr = V.value().data_handle();
+  }
+  detail::randomized_svd_streaming(handle,
+                                   in.data_handle(),
+                                   in.extent(0),
+                                   in.extent(1),
+                                   k,
+                                   p,
+                                   niters,
+                                   batch_rows,
+                                   seed,
+                                   S.data_handle(),
+                                   U_ptr,
+                                   V_ptr);
+}
+
+/**
+ * @brief Overload of `randomized_svd_streaming` to help the
+ *   compiler find the above overload, in case users pass in
+ *   `std::nullopt` for the optional arguments.
+ *
+ * Please see above for documentation of `randomized_svd_streaming`.
+ */
+template <typename math_t, typename idx_t, typename opt_u_vec_t, typename opt_v_vec_t>
+void randomized_svd_streaming(const raft::resources& handle,
+                              raft::host_matrix_view<const math_t, idx_t, raft::row_major> in,
+                              raft::device_vector_view<math_t, idx_t> S,
+                              opt_u_vec_t&& U,
+                              opt_v_vec_t&& V,
+                              std::size_t p,
+                              std::size_t niters,
+                              std::size_t batch_rows = 65536,
+                              uint64_t seed          = 0)
+{
+  std::optional<raft::host_matrix_view<math_t, idx_t, raft::row_major>> opt_u =
+    std::forward<opt_u_vec_t>(U);
+  std::optional<raft::device_matrix_view<math_t, idx_t, raft::row_major>> opt_v =
+    std::forward<opt_v_vec_t>(V);
+  randomized_svd_streaming(handle, in, S, opt_u, opt_v, p, niters, batch_rows, seed);
+}
+
 /** @} */  // end of group rsvd
 
 };         // end namespace linalg
@@ -20,6 +20,7 @@
 
 #include "detail/svd.cuh"
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/linalg/linalg_types.hpp>
 
 #include <optional>
 
@@ -414,6 +415,54 @@ void svd_reconstruction(raft::resources const& handle,
                     resource::get_cuda_stream(handle));
 }
 
+/**
+ * @brief singular value decomposition (SVD) with Jacobi method of a batch of small row-major
+ * matrices
+ *
+ * All the matrices are decomposed by a single batched cuSOLVER call when both their dimensions
+ * are at most 32; larger matrices are decomposed one after the other, sharing one workspace.
+ *
+ * @tparam ValueType the data-type of input and output
+ * @tparam IndexType Integer used for addressing
+ * @param[in] handle raft::resources
+ * @param[in] in the matrices, raft::device_batch_matrix_view [batch, m, n]
+ * @param[out] sing_vals the singular values of each matrix in descending order [batch, min(m, n)]
+ * @param[out] U the left singular vectors of each matrix, stored as its rows [batch, m, m]
+ * @param[out] V the right singular vectors of each matrix, stored as its rows [batch, n, n]
+ * @param[in] tol error tolerance for the jacobi method
+ * @param[in] max_sweeps maximum number of sweeps in the Jacobi algorithm
+ */
+template <typename ValueType, typename IndexType>
+void svd_jacobi_batched(raft::resources const& handle,
+                        device_batch_matrix_view<const ValueType, IndexType> in,
+                        raft::device_matrix_view<ValueType, IndexType, raft::row_major> sing_vals,
+                        device_batch_matrix_view<ValueType, IndexType> U,
+                        device_batch_matrix_view<ValueType, IndexType> V,
+                        ValueType tol  = 1.e-7,
+                        int max_sweeps = 15)
+{
+  auto batch_size = in.extent(0);
+  auto m          = in.extent(1);
+  auto n          = in.extent(2);
+  RAFT_EXPECTS(sing_vals.extent(0) == batch_size && sing_vals.extent(1) == std::min(m, n),
+               "sing_vals should have dimensions batch * min(m, n)");
+  RAFT_EXPECTS(U.extent(0) == batch_size && U.extent(1) == m && U.extent(2) == m,
+               "U should have dimensions batch * m * m");
+  RAFT_EXPECTS(V.extent(0) == batch_size && V.extent(1) == n && V.extent(2) == n,
+               "V should have dimensions batch * n * n");
+
+  detail::svdJacobiBatched(handle,
+                           in.data_handle(),
+                           batch_size,
+                           m,
+                           n,
+                           sing_vals.data_handle(),
+                           U.data_handle(),
+                           V.data_handle(),
+                           tol,
+                           max_sweeps);
+}
+
 /** @} */  // end of group svd
 
 };         // end namespace linalg
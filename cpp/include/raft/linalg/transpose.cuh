@@ -46,7 +46,7 @@ void transpose(raft::resources const& handle,
 }
 
 /**
- * @brief transpose on the column major input matrix using Jacobi method
+ * @brief in-place transpose of the square column major input matrix
  * @param inout: input and output matrix
  * @param n: number of rows and columns of input matrix
  * @param stream: cuda stream
@@ -65,40 +65,106 @@ void transpose(math_t* inout, int n, cudaStream_t stream)
 /**
  * @brief Transpose a matrix. The output has same layout policy as the input.
  *
- * @tparam T Data type of input matrix element.
+ * Floating-point matrices of the same input and output type are transposed by cuBLAS. Otherwise,
+ * a shared memory tiled kernel transposes the matrix and converts its elements in the same pass
+ * (e.g. `float` to `half`, or `uint8_t` to `float`).
+ *
+ * @tparam InElementType Data type of input matrix element.
+ * @tparam OutElementType Data type of output matrix element.
  * @tparam IndexType Index type of matrix extent.
  * @tparam LayoutPolicy Layout type of the input matrix. When layout is strided, it can
  *                      be a submatrix of a larger matrix. Arbitrary stride is not supported.
- * @tparam AccessorPolicy Accessor for the input and output, must be valid accessor on
- *                        device.
+ * @tparam InAccessorPolicy Accessor for the input, must be valid accessor on device.
+ * @tparam OutAccessorPolicy Accessor for the output, must be valid accessor on device.
  *
  * @param[in]  handle raft handle for managing expensive cuda resources.
  * @param[in]  in     Input matrix.
  * @param[out] out    Output matrix, storage is pre-allocated by caller.
  */
-template <typename T, typename IndexType, typename LayoutPolicy, typename AccessorPolicy>
-auto transpose(raft::resources const& handle,
-               raft::mdspan<T, raft::matrix_extent<IndexType>, LayoutPolicy, AccessorPolicy> in,
-               raft::mdspan<T, raft::matrix_extent<IndexType>, LayoutPolicy, AccessorPolicy> out)
-  -> std::enable_if_t<std::is_floating_point_v<T>, void>
+template <typename InElementType,
+          typename OutElementType,
+          typename IndexType,
+          typename LayoutPolicy,
+          typename InAccessorPolicy,
+          typename OutAccessorPolicy>
+void transpose(
+  raft::resources const& handle,
+  raft::mdspan<InElementType, raft::matrix_extent<IndexType>, LayoutPolicy, InAccessorPolicy> in,
+  raft::mdspan<OutElementType, raft::matrix_extent<IndexType>, LayoutPolicy, OutAccessorPolicy>
+    out)
 {
   RAFT_EXPECTS(out.extent(0) == in.extent(1), "Invalid shape for transpose.");
   RAFT_EXPECTS(out.extent(1) == in.extent(0), "Invalid shape for transpose.");
 
-  if constexpr (std::is_same_v<typename decltype(in)::layout_type, layout_c_contiguous>) {
-    detail::transpose_row_major_impl(handle, in, out);
-  } else if (std::is_same_v<typename decltype(in)::layout_type, layout_f_contiguous>) {
-    detail::transpose_col_major_impl(handle, in, out);
-  } else {
+  bool row_major = true;
+  if constexpr (std::is_same_v<LayoutPolicy, layout_f_contiguous>) {
+    row_major = false;
+  } else if constexpr (!std::is_same_v<LayoutPolicy, layout_c_contiguous>) {
     RAFT_EXPECTS(in.stride(0) == 1 || in.stride(1) == 1, "Unsupported matrix layout.");
-    if (in.stride(1) == 1) {
-      // row-major submatrix
+    row_major = in.stride(1) == 1;
+    RAFT_EXPECTS(row_major ? out.stride(1) == 1 : out.stride(0) == 1,
+                 "The input and output should have the same layout.");
+  }
+
+  using in_value_t = std::remove_const_t<InElementType>;
+  if constexpr (std::is_same_v<in_value_t, OutElementType> &&
+                std::is_floating_point_v<OutElementType>) {
+    if (row_major) {
       detail::transpose_row_major_impl(handle, in, out);
     } else {
-      // col-major submatrix
       detail::transpose_col_major_impl(handle, in, out);
     }
+  } else if (row_major) {
+    detail::transpose_tiled<in_value_t, OutElementType, IndexType>(handle,
+                                                                   in.data_handle(),
+                                                                   in.stride(0),
+                                                                   out.data_handle(),
+                                                                   out.stride(0),
+                                                                   in.extent(0),
+                                                                   in.extent(1));
+  } else {
+    // a col-major matrix is the row-major view of its transpose
+    detail::transpose_tiled<in_value_t, OutElementType, IndexType>(handle,
+                                                                   in.data_handle(),
+                                                                   in.stride(1),
+                                                                   out.data_handle(),
+                                                                   out.stride(1),
+                                                                   in.extent(1),
+                                                                   in.extent(0));
+  }
+}
+
+/**
+ * @brief Transpose a contiguous matrix in place.
+ *
+ * Square matrices are transposed by swapping pairs of tiles through shared memory. Other shapes
+ * are transposed by following the cycles of the permutation, which needs no extra memory but is
+ * several times slower than the out-of-place transpose.
+ *
+ * @tparam T Data type of matrix element.
+ * @tparam IndexType Index type of matrix extent.
+ * @tparam LayoutPolicy Either raft::row_major or raft::col_major.
+ *
+ * @param[in]    handle raft handle for managing expensive cuda resources.
+ * @param[inout] inout  The matrix to transpose.
+ *
+ * @return the view of the transposed matrix, over the memory of `inout`.
+ */
+template <typename T, typename IndexType, typename LayoutPolicy>
+auto transpose_inplace(raft::resources const& handle,
+                       raft::device_matrix_view<T, IndexType, LayoutPolicy> inout)
+  -> raft::device_matrix_view<T, IndexType, LayoutPolicy>
+{
+  static_assert(std::is_same_v<LayoutPolicy, layout_c_contiguous> ||
+                  std::is_same_v<LayoutPolicy, layout_f_contiguous>,
+                "The in-place transpose supports contiguous matrices only.");
+  if constexpr (std::is_same_v<LayoutPolicy, layout_c_contiguous>) {
+    detail::transpose_inplace(handle, inout.data_handle(), inout.extent(0), inout.extent(1));
+  } else {
+    detail::transpose_inplace(handle, inout.data_handle(), inout.extent(1), inout.extent(0));
   }
+  return raft::make_device_matrix_view<T, IndexType, LayoutPolicy>(
+    inout.data_handle(), inout.extent(1), inout.extent(0));
 }
 
 /** @} */  // end of group transpose
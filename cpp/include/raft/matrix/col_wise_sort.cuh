@@ -22,6 +22,9 @@
 #include <raft/core/device_mdspan.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/matrix/detail/columnWiseSort.cuh>
+#include <raft/matrix/select_k.cuh>
+
+#include <optional>
 
 namespace raft::matrix {
 
@@ -132,6 +135,74 @@ void sort_cols_per_row(Args... args)
   sort_cols_per_row(std::forward<Args>(args)..., std::nullopt);
 }
 
+/**
+ * @brief sort the columns within each row of a row-major key-value matrix in place
+ *
+ * Unlike `sort_cols_per_row`, the sort does not need a temporary copy of the whole matrix: the
+ * rows are sorted by batches whose temporary buffers fit in `max_workspace_bytes`, allocated from
+ * the workspace resource. Any key type supported by cub radix sort can be used, including `half`.
+ *
+ * @tparam key_t: element type of the keys
+ * @tparam val_t: element type of the values
+ * @tparam matrix_idx_t: integer type for matrix indexing
+ * @param[in] handle: raft handle
+ * @param[inout] keys: keys matrix, sorted within each row
+ * @param[inout] values: values matrix, permuted along with the keys
+ * @param[in] ascending: whether to sort the keys in ascending order
+ * @param[in] max_workspace_bytes: bound of the temporary memory (at least one row is sorted at a
+ *   time)
+ */
+template <typename key_t, typename val_t, typename matrix_idx_t>
+void sort_cols_per_row_inplace(
+  raft::resources const& handle,
+  raft::device_matrix_view<key_t, matrix_idx_t, raft::row_major> keys,
+  raft::device_matrix_view<val_t, matrix_idx_t, raft::row_major> values,
+  bool ascending             = true,
+  size_t max_workspace_bytes = size_t(1) << 28)
+{
+  RAFT_EXPECTS(keys.extent(0) == values.extent(0) && keys.extent(1) == values.extent(1),
+               "Keys and values matrices must have the same shape.");
+  detail::sortColumnsPerRowInplace(handle,
+                                   keys.data_handle(),
+                                   values.data_handle(),
+                                   int64_t(keys.extent(0)),
+                                   int64_t(keys.extent(1)),
+                                   ascending,
+                                   max_workspace_bytes);
+}
+
+/**
+ * @brief partial sort: the first `m` sorted columns of every row of a row-major key-value matrix
+ *
+ * The `m` smallest (or largest) keys of every row are selected with `raft::matrix::select_k`, and
+ * only these are sorted, which is much cheaper than sorting the full rows when `m` is small
+ * compared to the number of columns (e.g. re-ranking the top candidates out of 10k).
+ *
+ * @tparam key_t: element type of the keys (float, double or half)
+ * @tparam val_t: element type of the values (uint32_t or int64_t)
+ * @param[in] handle: raft handle
+ * @param[in] in_keys: keys matrix [n_rows, n_cols]
+ * @param[in] in_values: optional values matrix [n_rows, n_cols]; the column indices when absent
+ * @param[out] out_keys: the first m sorted keys of every row [n_rows, m]
+ * @param[out] out_values: the values of `out_keys` [n_rows, m]
+ * @param[in] ascending: whether to keep the smallest keys, in ascending order
+ */
+template <typename key_t, typename val_t>
+void sort_cols_per_row_top(
+  raft::resources const& handle,
+  raft::device_matrix_view<const key_t, int64_t, raft::row_major> in_keys,
+  std::optional<raft::device_matrix_view<const val_t, int64_t, raft::row_major>> in_values,
+  raft::device_matrix_view<key_t, int64_t, raft::row_major> out_keys,
+  raft::device_matrix_view<val_t, int64_t, raft::row_major> out_values,
+  bool ascending = true)
+{
+  RAFT_EXPECTS(out_keys.extent(1) <= in_keys.extent(1),
+               "Cannot keep more columns than there are in the input.");
+  select_k<key_t, val_t>(handle, in_keys, in_values, out_keys, out_values, ascending);
+  // select_k does not guarantee the order of the selected keys
+  sort_cols_per_row_inplace(handle, out_keys, out_values, ascending);
+}
+
 /** @} */  // end of group col_wise_sort
 
 };         // end namespace raft::matrix
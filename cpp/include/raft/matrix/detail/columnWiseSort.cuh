@@ -16,11 +16,20 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
 #include <cub/cub.cuh>
 #include <limits>
 #include <map>
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resources.hpp>
 #include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+#include <rmm/device_uvector.hpp>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/transform_iterator.h>
 
 #define INST_BLOCK_SORT(keyIn, keyOut, valueInOut, rows, columns, blockSize, elemPT, stream)     \
   devKeyValSortColumnPerRow<InType, OutType, blockSize, elemPT><<<rows, blockSize, 0, stream>>>( \
@@ -341,6 +350,89 @@ void sortColumnsPerRow(const InType* in,
     }
   }
 }
+
+/**
+ * @brief sort the columns within each row of a row-major key-value matrix in place
+ *
+ * The rows are sorted by batches, whose double buffers and cub storage fit in
+ * `max_workspace_bytes` (at least one row per batch). The sorted batch is copied back to the
+ * input buffers when cub leaves it in the alternate buffers.
+ *
+ * @param res: raft resources
+ * @param keys: keys matrix [n_rows, n_cols], sorted in place
+ * @param values: values matrix [n_rows, n_cols], permuted with the keys
+ * @param n_rows: number rows of the matrices
+ * @param n_cols: number columns of the matrices
+ * @param ascending: sort order
+ * @param max_workspace_bytes: bound of the temporary memory
+ */
+template <typename KeyT, typename ValT>
+void sortColumnsPerRowInplace(raft::resources const& res,
+                              KeyT* keys,
+                              ValT* values,
+                              int64_t n_rows,
+                              int64_t n_cols,
+                              bool ascending,
+                              size_t max_workspace_bytes)
+{
+  if (n_rows == 0 || n_cols <= 1) return;
+  auto stream = resource::get_cuda_stream(res);
+  auto mr     = resource::get_workspace_resource(res);
+
+  size_t row_bytes = size_t(n_cols) * (sizeof(KeyT) + sizeof(ValT));
+  int64_t batch_rows =
+    std::clamp<int64_t>(max_workspace_bytes / (row_bytes + 1), 1, std::numeric_limits<int>::max());
+  batch_rows = std::min<int64_t>(batch_rows, n_rows);
+  RAFT_EXPECTS(n_cols <= std::numeric_limits<int>::max(), "The rows are too long for cub");
+  batch_rows = std::min<int64_t>(batch_rows, std::numeric_limits<int>::max() / n_cols);
+
+  rmm::device_uvector<KeyT> keys_alt(batch_rows * n_cols, stream, mr);
+  rmm::device_uvector<ValT> values_alt(batch_rows * n_cols, stream, mr);
+  rmm::device_uvector<char> cub_storage(0, stream, mr);
+
+  auto offsets = thrust::make_transform_iterator(thrust::make_counting_iterator<int>(0),
+                                                 raft::mul_const_op<int>(int(n_cols)));
+  for (int64_t row = 0; row < n_rows; row += batch_rows) {
+    int rows    = int(std::min<int64_t>(batch_rows, n_rows - row));
+    int n_items = rows * int(n_cols);
+    KeyT* k_ptr = keys + row * n_cols;
+    ValT* v_ptr = values + row * n_cols;
+    cub::DoubleBuffer<KeyT> d_keys(k_ptr, keys_alt.data());
+    cub::DoubleBuffer<ValT> d_values(v_ptr, values_alt.data());
+    size_t cub_bytes = 0;
+    for (int pass = 0; pass < 2; pass++) {
+      void* storage = pass == 0 ? nullptr : cub_storage.data();
+      if (ascending) {
+        RAFT_CUDA_TRY(cub::DeviceSegmentedRadixSort::SortPairs(storage,
+                                                               cub_bytes,
+                                                               d_keys,
+                                                               d_values,
+                                                               n_items,
+                                                               rows,
+                                                               offsets,
+                                                               offsets + 1,
+                                                               0,
+                                                               sizeof(KeyT) * 8,
+                                                               stream));
+      } else {
+        RAFT_CUDA_TRY(cub::DeviceSegmentedRadixSort::SortPairsDescending(storage,
+                                                                         cub_bytes,
+                                                                         d_keys,
+                                                                         d_values,
+                                                                         n_items,
+                                                                         rows,
+                                                                         offsets,
+                                                                         offsets + 1,
+                                                                         0,
+                                                                         sizeof(KeyT) * 8,
+                                                                         stream));
+      }
+      if (pass == 0 && cub_bytes > cub_storage.size()) { cub_storage.resize(cub_bytes, stream); }
+    }
+    if (d_keys.Current() != k_ptr) { raft::copy(k_ptr, d_keys.Current(), n_items, stream); }
+    if (d_values.Current() != v_ptr) { raft::copy(v_ptr, d_values.Current(), n_items, stream); }
+  }
+}
 };  // end namespace detail
 };  // end namespace matrix
 };  // end namespace raft
@@ -17,7 +17,12 @@
 #pragma once
 
 #include <raft/core/operators.hpp>
+#include <raft/util/cuda_utils.cuh>
 #include <raft/util/cudart_utils.hpp>
+#include <raft/util/reduction.cuh>
+#include <raft/util/vectorized.cuh>
+
+#include <cstdint>
 
 namespace raft {
 namespace matrix {
@@ -343,6 +348,143 @@ void gather_if(const InputIteratorT in,
   typedef typename std::iterator_traits<MapIteratorT>::value_type MapValueT;
   gatherImpl(in, D, N, map, stencil, map_length, out, pred_op, transform_op, stream);
 }
+
+/** The widest vector of at most 16 bytes that keeps every row of `ptr` aligned. */
+template <typename T, typename IndexT>
+int gather_veclen(const T* ptr, IndexT D)
+{
+  int veclen = 16 % sizeof(T) == 0 ? int(16 / sizeof(T)) : 1;
+  while (veclen > 1 &&
+         (D % veclen != 0 || reinterpret_cast<uintptr_t>(ptr) % (veclen * sizeof(T)) != 0)) {
+    veclen /= 2;
+  }
+  return veclen;
+}
+
+/**
+ * Gathers one row per warp: each lane reads VecLen consecutive input elements at a time, converts
+ * them to the output type, optionally subtracts the center of the row and accumulates the squared
+ * L2 norm of the output row.
+ */
+template <int VecLen,
+          typename InT,
+          typename OutT,
+          typename MapT,
+          typename MapTransformOp,
+          typename LabelT,
+          typename NormT,
+          typename IndexT>
+__global__ void gather_fused_kernel(const InT* in,
+                                    IndexT D,
+                                    const MapT* map,
+                                    IndexT map_length,
+                                    OutT* out,
+                                    MapTransformOp transform_op,
+                                    const OutT* centers,
+                                    const LabelT* center_labels,
+                                    NormT* norms)
+{
+  const IndexT i_dst = (threadIdx.x + static_cast<IndexT>(blockIdx.x) * blockDim.x) / WarpSize;
+  const int lane     = threadIdx.x % WarpSize;
+  if (i_dst >= map_length) return;
+
+  const IndexT i_src = transform_op(map[i_dst]);
+  const InT* src     = in + static_cast<size_t>(i_src) * D;
+  OutT* dst          = out + static_cast<size_t>(i_dst) * D;
+  const OutT* center = nullptr;
+  if (centers != nullptr) { center = centers + static_cast<size_t>(center_labels[i_dst]) * D; }
+
+  NormT acc = 0;
+  for (IndexT j = lane * VecLen; j < D; j += WarpSize * VecLen) {
+    TxN_t<InT, VecLen> wide;
+    wide.load(src, j);
+#pragma unroll
+    for (int k = 0; k < VecLen; k++) {
+      OutT val = static_cast<OutT>(wide.val.data[k]);
+      if (center != nullptr) { val = val - center[j + k]; }
+      dst[j + k] = val;
+      acc += static_cast<NormT>(val) * static_cast<NormT>(val);
+    }
+  }
+  if (norms != nullptr) {
+    acc = raft::warpReduce(acc);
+    if (lane == 0) { norms[i_dst] = acc; }
+  }
+}
+
+template <int VecLen,
+          typename InT,
+          typename OutT,
+          typename MapT,
+          typename MapTransformOp,
+          typename LabelT,
+          typename NormT,
+          typename IndexT>
+void gather_fused_launch(const InT* in,
+                         IndexT D,
+                         const MapT* map,
+                         IndexT map_length,
+                         OutT* out,
+                         MapTransformOp transform_op,
+                         const OutT* centers,
+                         const LabelT* center_labels,
+                         NormT* norms,
+                         cudaStream_t stream)
+{
+  if constexpr (VecLen > 1) {
+    if (gather_veclen(in, D) < VecLen) {
+      return gather_fused_launch<VecLen / 2>(
+        in, D, map, map_length, out, transform_op, centers, center_labels, norms, stream);
+    }
+  }
+  constexpr int TPB     = 256;
+  constexpr int kRowsPB = TPB / WarpSize;
+  auto n_blocks         = raft::ceildiv<IndexT>(map_length, kRowsPB);
+  gather_fused_kernel<VecLen><<<n_blocks, TPB, 0, stream>>>(
+    in, D, map, map_length, out, transform_op, centers, center_labels, norms);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+/**
+ * @brief Gathers rows with a type conversion, an optional subtraction of a center per output row
+ * and optional squared L2 norms of the output rows, in a single pass.
+ *
+ * @param  in            Pointer to the input matrix [N, D] (row-major)
+ * @param  D             Number of columns
+ * @param  N             Number of rows of the input matrix
+ * @param  map           Pointer to the input sequence of gather locations [map_length]
+ * @param  map_length    Number of rows of the output matrix
+ * @param  out           Pointer to the output matrix [map_length, D] (row-major)
+ * @param  transform_op  The transformation operation, transforms the map values to IndexT
+ * @param  centers       Optional (nullptr) pointer to the centers [n_centers, D] (row-major)
+ * @param  center_labels Center to subtract from each output row [map_length]
+ * @param  norms         Optional (nullptr) squared L2 norms of the output rows [map_length]
+ * @param  stream        CUDA stream to launch kernels within
+ */
+template <typename InT,
+          typename OutT,
+          typename MapT,
+          typename MapTransformOp,
+          typename LabelT,
+          typename NormT,
+          typename IndexT>
+void gather_fused(const InT* in,
+                  IndexT D,
+                  IndexT N,
+                  const MapT* map,
+                  IndexT map_length,
+                  OutT* out,
+                  MapTransformOp transform_op,
+                  const OutT* centers,
+                  const LabelT* center_labels,
+                  NormT* norms,
+                  cudaStream_t stream)
+{
+  if (map_length <= 0 || N <= 0 || D <= 0) return;
+  constexpr int kMaxVecLen = 16 % sizeof(InT) == 0 ? int(16 / sizeof(InT)) : 1;
+  gather_fused_launch<kMaxVecLen>(
+    in, D, map, map_length, out, transform_op, centers, center_labels, norms, stream);
+}
 }  // namespace detail
 }  // namespace matrix
 }  // namespace raft
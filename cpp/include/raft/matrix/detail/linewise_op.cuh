@@ -235,6 +235,60 @@ struct Linewise {
       return out;
     }
   }
+
+  /**
+   * The helper for `vectorLinesWide`. Loads the `VecElems` elements of a vector starting at
+   * `offset` into registers; unlike `loadVec`, the chunk does not depend on the block offset and
+   * no shared memory or synchronization is needed.
+   *
+   * @tparam VecT Type of the vector to load
+   * @param [in] p pointer to a vector
+   * @param [in] offset the index of the first element of the chunk
+   * @return a contiguous chunk of a vector, suitable for `vectorLinesWide`.
+   */
+  template <typename VecT>
+  static __device__ __forceinline__ VecArg<VecT, VecElems> loadVecChunk(
+    const VecT* p, const IdxType offset) noexcept
+  {
+    VecArg<VecT, VecElems> out;
+#pragma unroll VecElems
+    for (int i = 0; i < VecElems; i++)
+      out.val[i] = p[offset + i];
+    return out;
+  }
+
+  /**
+   * Compute op(matrix_in, vec_1, vec_2, ...) on one cuda-vector-sized column of a matrix with
+   * very long lines, where vectors are applied along lines.
+   *
+   * Block work arrangement: the blocks along `y` stride over the lines, so the chunks of the
+   * argument vectors are loaded only once per thread and stay in registers during the loop.
+   *
+   * @tparam Args a pack of VecArg<VecT, VecElems>
+   * @param [out] out the output matrix, offset to the column of the thread
+   * @param [in] in the input matrix, offset to the column of the thread
+   * @param [in] ld the length of a line in cuda-vector-sized elements
+   * @param [in] nLines number of lines
+   * @param [in] op the function to apply
+   * @param [in] args the cuda-vector-sized chunks on input vectors
+   */
+  template <typename Lambda, typename... Args>
+  static __device__ __forceinline__ void vectorLinesWide(typename Vec::io_t* out,
+                                                         const typename Vec::io_t* in,
+                                                         const IdxType ld,
+                                                         const IdxType nLines,
+                                                         Lambda op,
+                                                         Args... args) noexcept
+  {
+    Vec v;
+    for (IdxType i = blockIdx.y; i < nLines; i += gridDim.y) {
+      *v.vectorized_data() = __ldcv(in + i * ld);
+#pragma unroll VecElems
+      for (int k = 0; k < VecElems; k++)
+        v.val.data[k] = op(v.val.data[k], args.val[k]...);
+      __stwt(out + i * ld, *v.vectorized_data());
+    }
+  }
 };
 
 /**
@@ -493,6 +547,126 @@ __global__ void __launch_bounds__(MaxOffset, 2)
   }
 }
 
+/**
+ * The kernel for matrices with very short lines (see `LinewiseSkinnyMaxLen`).
+ *
+ * With a few elements per line, one cuda-vector-sized chunk spans several lines and the
+ * `vectorCols`/`vectorRows` arrangements spend most of their time tracking the line boundaries.
+ * Here, the work arrangement is grid-strided over the chunks, so one warp covers many lines
+ * at once; every thread computes the line index of its chunk with one division and the tiny
+ * argument vectors are read through the L1 cache.
+ *
+ * @tparam AlongLines whether vectors are applied along lines (one vector element per element
+ *   of a line) or across lines (one vector element per line)
+ * @param [out] out the output matrix
+ * @param [in] in the input matrix
+ * @param [in] arrOffset such an offset into the matrices that makes them aligned to `VecBytes`
+ * @param [in] lineLen number of elements in a line
+ * @param [in] len the total length of the aligned part of the matrices
+ * @param [in] op the function to apply
+ * @param [in] vecs pointers to the argument vectors
+ */
+template <typename Type,
+          typename IdxType,
+          std::size_t VecBytes,
+          int BlockSize,
+          bool AlongLines,
+          typename Lambda,
+          typename... Vecs>
+__global__ void __launch_bounds__(BlockSize) matrixLinewiseSkinnyKernel(Type* out,
+                                                                        const Type* in,
+                                                                        const IdxType arrOffset,
+                                                                        const IdxType lineLen,
+                                                                        const IdxType len,
+                                                                        Lambda op,
+                                                                        const Vecs*... vecs)
+{
+  typedef Linewise<Type, IdxType, VecBytes, BlockSize> L;
+  typename L::Vec v;
+  const IdxType nChunks = L::AlignElems::div(len);
+  const IdxType stride  = IdxType(BlockSize) * gridDim.x;
+  for (IdxType i = threadIdx.x + IdxType(blockIdx.x) * BlockSize; i < nChunks; i += stride) {
+    const IdxType offset = arrOffset + i * L::VecElems;
+    IdxType line         = offset / lineLen;
+    IdxType pos          = offset - line * lineLen;
+    *v.vectorized_data() = __ldcv(reinterpret_cast<const typename L::Vec::io_t*>(in + offset));
+#pragma unroll L::VecElems
+    for (int k = 0; k < L::VecElems; k++) {
+      v.val.data[k] = op(v.val.data[k], vecs[AlongLines ? pos : line]...);
+      if (++pos == lineLen) {
+        pos = 0;
+        line++;
+      }
+    }
+    __stwt(reinterpret_cast<typename L::Vec::io_t*>(out + offset), *v.vectorized_data());
+  }
+}
+
+/**
+ * The kernel for matrices with very long lines (see `LinewiseWideMinLen`).
+ *
+ * The grid is two-dimensional: the blocks along `x` stride over the cuda-vector-sized columns
+ * and the blocks along `y` stride over the lines. The vector arguments are thus broadcast from
+ * registers: when applied along lines, a thread loads its chunk of the vectors once for all the
+ * lines; when applied across lines, all the threads of a block read the same vector element.
+ * The matrices are expected to be aligned and the line length to be a multiple of the
+ * cuda-vector-size.
+ *
+ * @tparam AlongLines whether vectors are applied along lines or across lines
+ * @param [out] out the output matrix
+ * @param [in] in the input matrix
+ * @param [in] lineLen number of elements in a line
+ * @param [in] nLines number of lines
+ * @param [in] op the function to apply
+ * @param [in] vecs pointers to the argument vectors
+ */
+template <typename Type,
+          typename IdxType,
+          std::size_t VecBytes,
+          int BlockSize,
+          bool AlongLines,
+          typename Lambda,
+          typename... Vecs>
+__global__ void __launch_bounds__(BlockSize) matrixLinewiseWideKernel(Type* out,
+                                                                      const Type* in,
+                                                                      const IdxType lineLen,
+                                                                      const IdxType nLines,
+                                                                      Lambda op,
+                                                                      const Vecs*... vecs)
+{
+  typedef Linewise<Type, IdxType, VecBytes, BlockSize> L;
+  auto* outVec        = reinterpret_cast<typename L::Vec::io_t*>(out);
+  const auto* inVec   = reinterpret_cast<const typename L::Vec::io_t*>(in);
+  const IdxType ld    = L::AlignElems::div(lineLen);
+  const IdxType start = threadIdx.x + IdxType(blockIdx.x) * BlockSize;
+  for (IdxType j = start; j < ld; j += IdxType(BlockSize) * gridDim.x) {
+    if constexpr (AlongLines) {
+      L::vectorLinesWide(
+        outVec + j, inVec + j, ld, nLines, op, L::loadVecChunk(vecs, j * L::VecElems)...);
+    } else {
+      typename L::Vec v;
+      for (IdxType i = blockIdx.y; i < nLines; i += gridDim.y) {
+        *v.vectorized_data() = __ldcv(inVec + i * ld + j);
+#pragma unroll L::VecElems
+        for (int k = 0; k < L::VecElems; k++)
+          v.val.data[k] = op(v.val.data[k], vecs[i]...);
+        __stwt(outVec + i * ld + j, *v.vectorized_data());
+      }
+    }
+  }
+}
+
+/**
+ * Lines not longer than this are processed by `matrixLinewiseSkinnyKernel`: then, a
+ * cuda-vector-sized chunk spans several lines.
+ */
+static inline constexpr uint LinewiseSkinnyMaxLen = 16;
+/**
+ * Lines not shorter than this are processed by `matrixLinewiseWideKernel` (when the matrices are
+ * aligned): then, the grid would load each chunk of the vectors for very few matrix chunks.
+ */
+static inline constexpr uint LinewiseWideMinLen = 1u << 15;
+
 /** Fully occupy GPU this many times for better work balancing. */
 static inline constexpr uint OptimalSmOccupancy = 16;
 
@@ -741,9 +915,83 @@ void matrixLinewiseVecRowsSpan(
   }
 }
 
+template <typename Type,
+          typename IdxType,
+          std::size_t VecBytes,
+          int BlockSize,
+          bool AlongLines,
+          typename Lambda,
+          typename... Vecs>
+void matrixLinewiseSkinny(Type* out,
+                          const Type* in,
+                          const IdxType lineLen,
+                          const IdxType nLines,
+                          Lambda op,
+                          cudaStream_t stream,
+                          const Vecs*... vecs)
+{
+  typedef raft::Pow2<VecBytes> AlignBytes;
+  constexpr std::size_t VecElems = VecBytes / sizeof(Type);
+  const IdxType totalLen         = lineLen * nLines;
+  const IdxType alignedOff       = IdxType(AlignBytes::roundUp(in) - in);
+  const IdxType alignedEnd       = IdxType(AlignBytes::roundDown(in + totalLen) - in);
+  const IdxType alignedLen       = alignedEnd - alignedOff;
+  if (alignedLen > 0) {
+    const IdxType maxBlocks = raft::ceildiv<IdxType>(alignedLen, IdxType(BlockSize * VecElems));
+    const dim3 gs(uint(std::min<IdxType>(maxBlocks, getOptimalGridSize<BlockSize>())), 1, 1);
+    matrixLinewiseSkinnyKernel<Type, IdxType, VecBytes, BlockSize, AlongLines, Lambda, Vecs...>
+      <<<gs, dim3(BlockSize, 1, 1), 0, stream>>>(
+        out, in, alignedOff, lineLen, alignedLen, op, vecs...);
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+  }
+  if (alignedLen < totalLen) {
+    // the unaligned head and tail are as short as in the default arrangements
+    constexpr std::size_t MaxOffset = std::max(std::size_t(raft::WarpSize), VecBytes);
+    if constexpr (AlongLines) {
+      matrixLinewiseVecRowsTailKernel<Type, IdxType, MaxOffset, Lambda, Vecs...>
+        <<<dim3(2, 1, 1), dim3(MaxOffset, 1, 1), 0, stream>>>(
+          out, in, alignedOff, alignedEnd, lineLen, totalLen, op, vecs...);
+    } else {
+      matrixLinewiseVecColsTailKernel<Type, IdxType, MaxOffset, Lambda, Vecs...>
+        <<<dim3(2, 1, 1), dim3(MaxOffset, 1, 1), 0, stream>>>(
+          out, in, alignedOff, alignedEnd, lineLen, totalLen, op, vecs...);
+    }
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+  }
+}
+
+template <typename Type,
+          typename IdxType,
+          std::size_t VecBytes,
+          int BlockSize,
+          bool AlongLines,
+          typename Lambda,
+          typename... Vecs>
+void matrixLinewiseWide(Type* out,
+                        const Type* in,
+                        const IdxType lineLen,
+                        const IdxType nLines,
+                        Lambda op,
+                        cudaStream_t stream,
+                        const Vecs*... vecs)
+{
+  constexpr std::size_t VecElems = VecBytes / sizeof(Type);
+  if (lineLen * nLines == 0) return;
+  const uint occupy = getOptimalGridSize<BlockSize>();
+  // enough blocks along the lines to cover a line, the rest strides over the lines
+  const uint gx =
+    uint(std::min<IdxType>(raft::ceildiv<IdxType>(lineLen, IdxType(BlockSize * VecElems)), occupy));
+  const uint gy = uint(std::min<IdxType>(std::min<IdxType>(nLines, std::max(occupy / gx, 1u)),
+                                         IdxType(65535)));
+  matrixLinewiseWideKernel<Type, IdxType, VecBytes, BlockSize, AlongLines, Lambda, Vecs...>
+    <<<dim3(gx, gy, 1), dim3(BlockSize, 1, 1), 0, stream>>>(out, in, lineLen, nLines, op, vecs...);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
 /**
  * Select one of the implementations:
- *   a. vectors applied along/across lines
+ *   a. vectors applied along/across lines; very short and very long lines get their own
+ *      kernels (`matrixLinewiseSkinnyKernel`, `matrixLinewiseWideKernel`)
  *   b. recursively try different VecBytes, such that alignments of `in` and `out`
  *      are the same.
  *
@@ -767,6 +1015,23 @@ struct MatrixLinewiseOp {
         return MatrixLinewiseOp<std::max((VecBytes >> 1), sizeof(Type)), BlockSize>::run(
           out, in, lineLen, nLines, alongLines, op, stream, vecs...);
     }
+    if (lineLen <= IdxType(LinewiseSkinnyMaxLen)) {
+      if (alongLines)
+        return matrixLinewiseSkinny<Type, IdxType, VecBytes, BlockSize, true, Lambda, Vecs...>(
+          out, in, lineLen, nLines, op, stream, vecs...);
+      else
+        return matrixLinewiseSkinny<Type, IdxType, VecBytes, BlockSize, false, Lambda, Vecs...>(
+          out, in, lineLen, nLines, op, stream, vecs...);
+    }
+    if (lineLen >= IdxType(LinewiseWideMinLen) && raft::Pow2<VecBytes>::isAligned(in) &&
+        lineLen % IdxType(VecBytes / sizeof(Type)) == 0) {
+      if (alongLines)
+        return matrixLinewiseWide<Type, IdxType, VecBytes, BlockSize, true, Lambda, Vecs...>(
+          out, in, lineLen, nLines, op, stream, vecs...);
+      else
+        return matrixLinewiseWide<Type, IdxType, VecBytes, BlockSize, false, Lambda, Vecs...>(
+          out, in, lineLen, nLines, op, stream, vecs...);
+    }
     if (alongLines)
       return matrixLinewiseVecRows<Type, IdxType, VecBytes, BlockSize, Lambda, Vecs...>(
         out, in, lineLen, nLines, op, stream, vecs...);
@@ -37,21 +37,46 @@ void select_k(const T* in_val,
               bool select_min,
               rmm::cuda_stream_view stream,
               rmm::mr::device_memory_resource* mr = nullptr) RAFT_EXPLICIT;
+
+template <typename T, typename IdxT>
+void select_k_segmented(const T* in_val,
+                        const IdxT* in_idx,
+                        const IdxT* row_offsets,
+                        size_t batch_size,
+                        size_t max_len,
+                        int k,
+                        T* out_val,
+                        IdxT* out_idx,
+                        bool select_min,
+                        rmm::cuda_stream_view stream,
+                        rmm::mr::device_memory_resource* mr = nullptr) RAFT_EXPLICIT;
 }  // namespace raft::matrix::detail
 
 #endif  // RAFT_EXPLICIT_INSTANTIATE_ONLY
 
-#define instantiate_raft_matrix_detail_select_k(T, IdxT)                            \
-  extern template void raft::matrix::detail::select_k(const T* in_val,              \
-                                                      const IdxT* in_idx,           \
-                                                      size_t batch_size,            \
-                                                      size_t len,                   \
-                                                      int k,                        \
-                                                      T* out_val,                   \
-                                                      IdxT* out_idx,                \
-                                                      bool select_min,              \
-                                                      rmm::cuda_stream_view stream, \
-                                                      rmm::mr::device_memory_resource* mr)
+#define instantiate_raft_matrix_detail_select_k(T, IdxT)                                    \
+  extern template void raft::matrix::detail::select_k(const T* in_val,                      \
+                                                      const IdxT* in_idx,                   \
+                                                      size_t batch_size,                    \
+                                                      size_t len,                           \
+                                                      int k,                                \
+                                                      T* out_val,                           \
+                                                      IdxT* out_idx,                        \
+                                                      bool select_min,                      \
+                                                      rmm::cuda_stream_view stream,         \
+                                                      rmm::mr::device_memory_resource* mr); \
+  extern template void raft::matrix::detail::select_k_segmented(                            \
+    const T* in_val,                                                                        \
+    const IdxT* in_idx,                                                                     \
+    const IdxT* row_offsets,                                                                \
+    size_t batch_size,                                                                      \
+    size_t max_len,                                                                         \
+    int k,                                                                                  \
+    T* out_val,                                                                             \
+    IdxT* out_idx,                                                                          \
+    bool select_min,                                                                        \
+    rmm::cuda_stream_view stream,                                                           \
+    rmm::mr::device_memory_resource* mr)
 
 instantiate_raft_matrix_detail_select_k(__half, uint32_t);
 instantiate_raft_matrix_detail_select_k(__half, int64_t);
@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include "select_k_dispatch.hpp"
+#include "select_packed.cuh"
 #include "select_radix.cuh"
 #include "select_warpsort.cuh"
 
@@ -27,9 +29,11 @@
 
 namespace raft::matrix::detail {
 
-// this is a subset of algorithms, chosen by running the algorithm_selection
-// notebook in cpp/scripts/heuristics/select_k
-enum class Algo { kRadix11bits, kWarpDistributedShm, kFaissBlockSelect };
+/**
+ * The k starting from which the large-k version of the radix select is used
+ * (see `select::radix::select_large_k`).
+ */
+constexpr int kRadixLargeKThreshold = 2048;
 
 /**
  * Predict the fastest select_k algorithm based on the number of rows/cols/k
@@ -43,8 +47,11 @@ enum class Algo { kRadix11bits, kWarpDistributedShm, kFaissBlockSelect };
  * 'generate_heuristic' notebook there will replace the body of this function
  * with the latest learned heuristic
  */
-inline Algo choose_select_k_algorithm(size_t rows, size_t cols, int k)
+inline Algo learned_select_k_algorithm(size_t rows, size_t cols, int k)
 {
+  // Not covered by the learned heuristic (the trial runs do not go beyond k = 2049);
+  // keep this check when regenerating the body below.
+  if (k > kRadixLargeKThreshold) { return Algo::kRadixLargeK; }
   if (k > 134) {
     if (k > 256) {
       if (k > 809) {
@@ -116,6 +123,25 @@ inline Algo choose_select_k_algorithm(size_t rows, size_t cols, int k)
   }
 }
 
+/**
+ * Choose the select_k algorithm for the number of rows/cols/k.
+ *
+ * The dispatch table of the current GPU architecture is consulted first (see
+ * `select_k_dispatch.hpp` on how the tables are produced and provided); the learned decision tree
+ * is used when there's no table for the architecture or the table does not cover the problem size.
+ */
+inline Algo choose_select_k_algorithm(size_t rows, size_t cols, int k)
+{
+  auto algo = select_k_dispatch::lookup(rows, cols, k);
+  // the warp-sort is limited in k regardless of what has been measured
+  if (algo.has_value() &&
+      !((*algo == Algo::kWarpDistributedShm || *algo == Algo::kWarpPacked) &&
+        k > select::warpsort::kMaxCapacity)) {
+    return *algo;
+  }
+  return learned_select_k_algorithm(rows, cols, k);
+}
+
 /**
  * Select k smallest or largest key/values from each row in the input data.
  *
@@ -169,6 +195,14 @@ void select_k(const T* in_val,
     "matrix::select_k(batch_size = %zu, len = %zu, k = %d)", batch_size, len, k);
 
   auto algo = choose_select_k_algorithm(batch_size, len, k);
+  // the limit of the faiss block select depends on the types
+  if (algo == Algo::kFaissBlockSelect && k > neighbors::detail::kFaissMaxK<IdxT, T>()) {
+    algo = Algo::kRadix11bits;
+  }
+  // the packed mode is limited to the narrow keys and the indices fitting in 32 bits
+  if (algo == Algo::kWarpPacked && !select::packed::is_supported<T, IdxT>(in_idx, len)) {
+    algo = Algo::kWarpDistributedShm;
+  }
   switch (algo) {
     case Algo::kRadix11bits:
       return detail::select::radix::select_k<T, IdxT, 11, 512>(in_val,
@@ -185,9 +219,117 @@ void select_k(const T* in_val,
       return detail::select::warpsort::
         select_k_impl<T, IdxT, detail::select::warpsort::warp_sort_distributed_ext>(
           in_val, in_idx, batch_size, len, k, out_val, out_idx, select_min, stream);
+    case Algo::kWarpPacked:
+      if constexpr (select::packed::kPackableKey<T>) {
+        return detail::select::packed::select_k<T, IdxT>(
+          in_val, in_idx, batch_size, len, k, out_val, out_idx, select_min, stream, mr);
+      }
+      break;
     case Algo::kFaissBlockSelect:
       return neighbors::detail::select_k(
         in_val, in_idx, batch_size, len, out_val, out_idx, select_min, k, stream);
+    case Algo::kRadixLargeK:
+      return detail::select::radix::select_large_k<T, IdxT, 11, 512>(in_val,
+                                                                     in_idx,
+                                                                     batch_size,
+                                                                     len,
+                                                                     k,
+                                                                     out_val,
+                                                                     out_idx,
+                                                                     select_min,
+                                                                     false,  // sorted
+                                                                     stream,
+                                                                     mr);
+  }
+}
+
+/**
+ * Select k smallest or largest key/values from each row of variable length in the input data.
+ *
+ * The input is a CSR-like batch of rows: the row `i` spans the range
+ * `[row_offsets[i], row_offsets[i + 1])` of the arrays `in_val` and `in_idx`. The output rows
+ * shorter than `k` are padded with the dummy values: `upper_bound<T>()` when selecting the
+ * minimum, `lower_bound<T>()` otherwise (the indices of the padded elements are undefined).
+ *
+ * @tparam T
+ *   the type of the keys (what is being compared).
+ * @tparam IdxT
+ *   the index type (what is being selected together with the keys).
+ *
+ * @param[in] in_val
+ *   contiguous device array of inputs of size (row_offsets[batch_size]);
+ *   these are compared and selected.
+ * @param[in] in_idx
+ *   optional contiguous device array of inputs of size (row_offsets[batch_size]);
+ *   typically, these are indices of the corresponding in_val. When `nullptr`, the positions of
+ *   the elements within their rows are selected.
+ * @param[in] row_offsets
+ *   device array of the row offsets of size (batch_size + 1).
+ * @param batch_size
+ *   number of input rows, i.e. the batch size.
+ * @param max_len
+ *   the maximum length of a row.
+ * @param k
+ *   the number of outputs to select in each input row.
+ * @param[out] out_val
+ *   contiguous device array of outputs of size (k * batch_size);
+ *   the k smallest/largest values from each row of the `in_val`.
+ * @param[out] out_idx
+ *   contiguous device array of outputs of size (k * batch_size);
+ *   the payload selected together with `out_val`.
+ * @param select_min
+ *   whether to select k smallest (true) or largest (false) keys.
+ * @param stream
+ * @param mr an optional memory resource to use across the calls (you can provide a large enough
+ *           memory pool here to avoid memory allocations within the call).
+ */
+template <typename T, typename IdxT>
+void select_k_segmented(const T* in_val,
+                        const IdxT* in_idx,
+                        const IdxT* row_offsets,
+                        size_t batch_size,
+                        size_t max_len,
+                        int k,
+                        T* out_val,
+                        IdxT* out_idx,
+                        bool select_min,
+                        rmm::cuda_stream_view stream,
+                        rmm::mr::device_memory_resource* mr = nullptr)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "matrix::select_k_segmented(batch_size = %zu, max_len = %zu, k = %d)",
+    batch_size,
+    max_len,
+    k);
+
+  // The faiss block select does not support the variable-length rows; the warp-sort is used
+  // instead whenever it can handle the given k.
+  auto algo = choose_select_k_algorithm(batch_size, max_len, k);
+  if (algo == Algo::kRadix11bits || k > detail::select::warpsort::kMaxCapacity) {
+    return detail::select::radix::select_k_segmented<T, IdxT, 11, 512>(in_val,
+                                                                        in_idx,
+                                                                        row_offsets,
+                                                                        batch_size,
+                                                                        max_len,
+                                                                        k,
+                                                                        out_val,
+                                                                        out_idx,
+                                                                        select_min,
+                                                                        true,  // fused_last_filter
+                                                                        stream,
+                                                                        mr);
+  } else {
+    return detail::select::warpsort::select_k_segmented<T, IdxT>(in_val,
+                                                                 in_idx,
+                                                                 row_offsets,
+                                                                 batch_size,
+                                                                 max_len,
+                                                                 k,
+                                                                 out_val,
+                                                                 out_idx,
+                                                                 select_min,
+                                                                 stream,
+                                                                 mr);
   }
 }
 }  // namespace raft::matrix::detail
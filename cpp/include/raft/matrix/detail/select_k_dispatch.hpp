@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "select_k_dispatch_tables.hpp"
+#include "select_k_dispatch_types.hpp"
+
+#include <raft/core/error.hpp>
+#include <raft/core/logger.hpp>
+#include <raft/util/cuda_rt_essentials.hpp>
+
+#include <cuda_runtime_api.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * Per-architecture select_k dispatch tables.
+ *
+ * A dispatch table maps the problem size (rows, cols, k) to the fastest select_k algorithm
+ * measured on a given GPU architecture. The tables are produced from the `SelectKDataset`
+ * benchmarks (see `cpp/bench/prims/matrix/select_k.cu`) by
+ * `cpp/scripts/heuristics/select_k/generate_dispatch_table.py` and can be
+ *
+ *   1. embedded at build time (`select_k_dispatch_tables.hpp`),
+ *   2. loaded at runtime from a CSV file, either explicitly via `load_table()` or on the first use
+ *      from the file given by the environment variable `RAFT_SELECT_K_DISPATCH_TABLE`,
+ *   3. set programmatically via `set_table()`.
+ *
+ * The CSV file contains one entry per line: `arch,rows,cols,k,algo`, where `arch` is the compute
+ * capability as `10 * major + minor` and `algo` is a name of the `Algo` enum (e.g.
+ * `89,1024,1048576,64,kWarpDistributedShm`). Empty lines and lines starting with '#' or with a
+ * non-numeric field (a header) are ignored.
+ */
+namespace raft::matrix::detail::select_k_dispatch {
+
+/** The name of the environment variable pointing to a CSV dispatch table to load on first use. */
+constexpr const char* kTableEnvVar = "RAFT_SELECT_K_DISPATCH_TABLE";
+
+/**
+ * A dispatch table of one GPU architecture.
+ *
+ * The table is a grid in the log-space of the problem size: the entries are placed in the cells
+ * `(round(log2(rows)), round(log2(cols)), ceil(log2(k)))`; `k` is rounded up, so that the
+ * algorithm measured at a cell supports all `k` mapped to it. When looked up, `rows` and `cols`
+ * are clamped to the range of the table, whereas `k` beyond the range of the table is not
+ * extrapolated.
+ */
+class table {
+ public:
+  explicit table(const std::vector<entry>& entries)
+  {
+    for (const auto& e : entries) {
+      RAFT_EXPECTS(e.rows > 0 && e.cols > 0 && e.k > 0,
+                   "Dispatch table entries must have positive sizes");
+      auto r = log2_round(e.rows);
+      auto c = log2_round(e.cols);
+      auto k = log2_ceil(e.k);
+      if (algos_.empty()) {
+        min_rows_ = max_rows_ = r;
+        min_cols_ = max_cols_ = c;
+        min_k_    = max_k_ = k;
+      }
+      min_rows_ = std::min(min_rows_, r);
+      max_rows_ = std::max(max_rows_, r);
+      min_cols_ = std::min(min_cols_, c);
+      max_cols_ = std::max(max_cols_, c);
+      min_k_    = std::min(min_k_, k);
+      max_k_    = std::max(max_k_, k);
+
+      algos_[key(r, c, k)] = e.algo;
+    }
+  }
+
+  /** The number of the grid cells covered by the table. */
+  [[nodiscard]] auto size() const noexcept -> size_t { return algos_.size(); }
+
+  /** The fastest algorithm for the problem size, if the table has it. */
+  [[nodiscard]] auto lookup(size_t rows, size_t cols, int k) const -> std::optional<Algo>
+  {
+    if (algos_.empty() || rows == 0 || cols == 0 || k <= 0) { return std::nullopt; }
+    auto kk = std::max(log2_ceil(k), min_k_);
+    if (kk > max_k_) { return std::nullopt; }
+    auto r  = std::clamp(log2_round(rows), min_rows_, max_rows_);
+    auto c  = std::clamp(log2_round(cols), min_cols_, max_cols_);
+    auto it = algos_.find(key(r, c, kk));
+    if (it == algos_.end()) { return std::nullopt; }
+    return it->second;
+  }
+
+ private:
+  std::unordered_map<uint32_t, Algo> algos_;
+  int min_rows_ = 0;
+  int max_rows_ = 0;
+  int min_cols_ = 0;
+  int max_cols_ = 0;
+  int min_k_    = 0;
+  int max_k_    = 0;
+
+  static auto key(int rows_log2, int cols_log2, int k_log2) -> uint32_t
+  {
+    return (uint32_t(rows_log2) << 16) | (uint32_t(cols_log2) << 8) | uint32_t(k_log2);
+  }
+  static auto log2_ceil(size_t x) -> int
+  {
+    int r = 0;
+    while ((size_t{1} << r) < x) {
+      r++;
+    }
+    return r;
+  }
+  static auto log2_round(size_t x) -> int
+  {
+    int r = log2_ceil(x);
+    // pick the nearest power of two (in the log-space: x < 2^(r - 1/2) <=> 2 x^2 < 4^r)
+    if (r > 0 && 2.0 * double(x) * double(x) < double(size_t{1} << r) * double(size_t{1} << r)) {
+      r--;
+    }
+    return r;
+  }
+};
+
+/** Parse a CSV dispatch table (see the format in the description of this namespace). */
+inline auto parse_csv(std::istream& is) -> std::unordered_map<int, std::vector<entry>>
+{
+  std::unordered_map<int, std::vector<entry>> tables;
+  std::string line;
+  while (std::getline(is, line)) {
+    if (line.empty() || line[0] == '#') { continue; }
+    std::replace(line.begin(), line.end(), ',', ' ');
+    std::istringstream ls(line);
+    int arch;
+    entry e;
+    std::string algo;
+    // skip the lines that fail to parse as numbers (e.g. the header)
+    if (!(ls >> arch >> e.rows >> e.cols >> e.k >> algo)) { continue; }
+    e.algo = algo_from_string(algo);
+    tables[arch].push_back(e);
+  }
+  return tables;
+}
+
+/** The compute capability of the current device as `10 * major + minor`. */
+inline auto current_arch() -> int
+{
+  int dev;
+  int major;
+  int minor;
+  RAFT_CUDA_TRY(cudaGetDevice(&dev));
+  RAFT_CUDA_TRY(cudaDeviceGetAttribute(&major, cudaDevAttrComputeCapabilityMajor, dev));
+  RAFT_CUDA_TRY(cudaDeviceGetAttribute(&minor, cudaDevAttrComputeCapabilityMinor, dev));
+  return 10 * major + minor;
+}
+
+/**
+ * The process-wide collection of the dispatch tables by the GPU architecture.
+ *
+ * It's initialized on first use with the embedded tables and then with the tables from the file
+ * given by `RAFT_SELECT_K_DISPATCH_TABLE` (if set); the latter override the former.
+ */
+class registry {
+ public:
+  static auto instance() -> registry&
+  {
+    static registry r;
+    return r;
+  }
+
+  /** Set the table of the architecture (overriding the existing one); empty entries remove it. */
+  void set(int arch, const std::vector<entry>& entries)
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    set_unsafe(arch, entries);
+  }
+
+  /** Load the tables from a CSV file (overriding the existing tables of the same architectures). */
+  void load(const std::string& path)
+  {
+    std::ifstream is(path);
+    RAFT_EXPECTS(is.good(), "Cannot open the select_k dispatch table '%s'", path.c_str());
+    auto tables = parse_csv(is);
+    std::lock_guard<std::mutex> guard(lock_);
+    for (const auto& [arch, entries] : tables) {
+      set_unsafe(arch, entries);
+    }
+  }
+
+  [[nodiscard]] auto lookup(int arch, size_t rows, size_t cols, int k) -> std::optional<Algo>
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    auto it = tables_.find(arch);
+    if (it == tables_.end()) { return std::nullopt; }
+    return it->second.lookup(rows, cols, k);
+  }
+
+ private:
+  std::mutex lock_;
+  std::unordered_map<int, table> tables_;
+
+  registry()
+  {
+    for (const auto& [arch, entries] : embedded_tables()) {
+      set_unsafe(arch, entries);
+    }
+    if (const char* path = std::getenv(kTableEnvVar); path != nullptr && *path != '\0') {
+      std::ifstream is(path);
+      if (is.good()) {
+        for (const auto& [arch, entries] : parse_csv(is)) {
+          set_unsafe(arch, entries);
+        }
+      } else {
+        RAFT_LOG_WARN("Cannot open the select_k dispatch table '%s' (%s); ignoring it.",
+                      path,
+                      kTableEnvVar);
+      }
+    }
+  }
+
+  void set_unsafe(int arch, const std::vector<entry>& entries)
+  {
+    if (entries.empty()) {
+      tables_.erase(arch);
+    } else {
+      tables_.insert_or_assign(arch, table(entries));
+    }
+  }
+};
+
+/** Set the dispatch table of the given architecture (empty entries remove the table). */
+inline void set_table(int arch, const std::vector<entry>& entries)
+{
+  registry::instance().set(arch, entries);
+}
+
+/** Load the dispatch tables from a CSV file. */
+inline void load_table(const std::string& path) { registry::instance().load(path); }
+
+/** Look up the fastest algorithm for the problem size on the current device. */
+inline auto lookup(size_t rows, size_t cols, int k) -> std::optional<Algo>
+{
+  return registry::instance().lookup(current_arch(), rows, cols, k);
+}
+
+}  // namespace raft::matrix::detail::select_k_dispatch
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * NOTE: this file is generated by cpp/scripts/heuristics/select_k/generate_dispatch_table.py
+ *
+ * Do not edit manually; regenerate it from the benchmark results instead:
+ *
+ *   python generate_dispatch_table.py --format cpp \
+ *     --output cpp/include/raft/matrix/detail/select_k_dispatch_tables.hpp \
+ *     89=select_k_times_l4.json 90=select_k_times_h100.json
+ */
+
+#pragma once
+
+#include "select_k_dispatch_types.hpp"
+
+#include <utility>
+#include <vector>
+
+namespace raft::matrix::detail::select_k_dispatch {
+
+/**
+ * The dispatch tables embedded at build time: pairs of the GPU architecture
+ * (`10 * major + minor` of the compute capability) and the measured entries.
+ *
+ * No tables are embedded yet; `choose_select_k_algorithm()` falls back to the learned decision
+ * tree for the architectures without a table.
+ */
+inline auto embedded_tables() -> std::vector<std::pair<int, std::vector<entry>>>
+{
+  return {};
+}
+
+}  // namespace raft::matrix::detail::select_k_dispatch
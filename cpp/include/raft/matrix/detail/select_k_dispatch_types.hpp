@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/error.hpp>
+
+#include <cstddef>
+#include <string>
+
+namespace raft::matrix::detail {
+
+// this is a subset of algorithms, chosen by running the algorithm_selection
+// notebook in cpp/scripts/heuristics/select_k
+enum class Algo { kRadix11bits, kWarpDistributedShm, kFaissBlockSelect, kRadixLargeK, kWarpPacked };
+
+namespace select_k_dispatch {
+
+/** A measured point of a dispatch table: the fastest algorithm for the given problem size. */
+struct entry {
+  size_t rows;
+  size_t cols;
+  int k;
+  Algo algo;
+};
+
+inline auto algo_to_string(Algo algo) -> const char*
+{
+  switch (algo) {
+    case Algo::kRadix11bits: return "kRadix11bits";
+    case Algo::kWarpDistributedShm: return "kWarpDistributedShm";
+    case Algo::kFaissBlockSelect: return "kFaissBlockSelect";
+    case Algo::kRadixLargeK: return "kRadixLargeK";
+    case Algo::kWarpPacked: return "kWarpPacked";
+    default: return "unknown enum value";
+  }
+}
+
+inline auto algo_from_string(const std::string& name) -> Algo
+{
+  for (auto algo : {Algo::kRadix11bits,
+                    Algo::kWarpDistributedShm,
+                    Algo::kFaissBlockSelect,
+                    Algo::kRadixLargeK,
+                    Algo::kWarpPacked}) {
+    if (name == algo_to_string(algo)) { return algo; }
+  }
+  RAFT_FAIL("Unknown select_k algorithm '%s'", name.c_str());
+}
+
+}  // namespace select_k_dispatch
+}  // namespace raft::matrix::detail
@@ -0,0 +1,465 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/matrix/detail/select_warpsort.cuh>
+
+#include <raft/core/detail/macros.hpp>
+#include <raft/core/logger.hpp>
+#include <raft/util/bitonic_sort.cuh>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/integer_utils.hpp>
+#include <raft/util/pow2_utils.cuh>
+
+#include <cub/util_type.cuh>
+
+#include <rmm/device_uvector.hpp>
+#include <rmm/mr/device/device_memory_resource.hpp>
+
+#include <cstdint>
+#include <limits>
+
+/*
+  The warp-sort top-k over the packed key-index pairs.
+
+  An order-preserving transform of a key (of at most 32 bits, e.g. `half` or `float`) and a 32-bit
+  index are packed into one 64-bit word:
+
+     [ twiddled key bits (high 32 bits) | index (low 32 bits) ]
+
+  such that comparing the words as unsigned integers gives the order of the keys (ties are broken
+  by the index). Hence the bitonic networks sort the single array of words, without a payload:
+  every element is loaded, compared, shuffled and stored once rather than as two separate values,
+  and the intermediate results of the multi-block launch are kept in half as many arrays.
+
+  The selection of the largest keys is done by inverting the key bits, so the queue always
+  collects the smallest words.
+ */
+namespace raft::matrix::detail::select::packed {
+
+/** Whether the keys of the type can be packed together with an index into 64 bits. */
+template <typename T>
+constexpr bool kPackableKey = sizeof(T) <= sizeof(uint32_t);
+
+/**
+ * Whether the packed mode can be used for the given input.
+ *
+ * The indices are stored in 32 bits: this is always valid for the index types of up to 32 bits,
+ * and for the wider index types only when the positions in a row are selected (`in_idx == nullptr`)
+ * and the row length fits in 32 bits.
+ */
+template <typename T, typename IdxT>
+constexpr auto is_supported(const IdxT* in_idx, size_t len) -> bool
+{
+  if constexpr (!kPackableKey<T>) { return false; }
+  return sizeof(IdxT) <= sizeof(uint32_t) ||
+         (in_idx == nullptr && len <= size_t(std::numeric_limits<uint32_t>::max()));
+}
+
+/** The packed word that is greater than (or equal to) any other. */
+static constexpr uint64_t kDummy = ~uint64_t{0};
+
+template <typename T, typename IdxT>
+_RAFT_DEVICE _RAFT_FORCEINLINE auto pack(T key, IdxT idx, bool select_min) -> uint64_t
+{
+  using bits_t = typename cub::Traits<T>::UnsignedBits;
+  bits_t bits  = cub::Traits<T>::TwiddleIn(reinterpret_cast<bits_t&>(key));
+  if (!select_min) { bits = ~bits; }
+  return (uint64_t(bits) << 32) | uint64_t(uint32_t(idx));
+}
+
+template <typename T>
+_RAFT_DEVICE _RAFT_FORCEINLINE auto unpack_key(uint64_t packed, bool select_min) -> T
+{
+  using bits_t = typename cub::Traits<T>::UnsignedBits;
+  auto bits    = bits_t(packed >> 32);
+  if (!select_min) { bits = ~bits; }
+  bits = cub::Traits<T>::TwiddleOut(bits);
+  return reinterpret_cast<T&>(bits);
+}
+
+template <typename IdxT>
+_RAFT_DEVICE _RAFT_FORCEINLINE auto unpack_idx(uint64_t packed) -> IdxT
+{
+  return IdxT(uint32_t(packed));
+}
+
+/**
+ * A fixed-size warp-level priority queue of the packed words: the equivalent of
+ * `warpsort::warp_sort_filtered` with the key and the payload fused together.
+ *
+ * @tparam Capacity
+ *   maximum number of elements in the queue.
+ */
+template <int Capacity>
+class warp_sort_filtered {
+  static_assert(is_a_power_of_two(Capacity));
+
+ public:
+  /** Width of the subwarp. */
+  static constexpr int kWarpWidth = std::min<int>(Capacity, WarpSize);
+  /** The number of elements to select. */
+  const int k;
+
+  explicit _RAFT_DEVICE warp_sort_filtered(int k) : k(k), buf_len_(0), k_th_(kDummy)
+  {
+#pragma unroll
+    for (int i = 0; i < kMaxArrLen; i++) {
+      val_arr_[i] = kDummy;
+    }
+#pragma unroll
+    for (int i = 0; i < kMaxBufLen; i++) {
+      val_buf_[i] = kDummy;
+    }
+  }
+
+  _RAFT_DEVICE void add(uint64_t val)
+  {
+    // `false` means the input value is surely not in the top-k values.
+    bool do_add = val < k_th_;
+    // merge the buf if it's full and we cannot add an element anymore.
+    if (any(buf_len_ + do_add > kMaxBufLen)) {
+      // still, add an element before merging if possible for this thread
+      if (do_add && buf_len_ < kMaxBufLen) {
+        add_to_buf_(val);
+        do_add = false;
+      }
+      merge_buf_();
+    }
+    // add an element if necessary and haven't already.
+    if (do_add) { add_to_buf_(val); }
+  }
+
+  _RAFT_DEVICE void done()
+  {
+    if (any(buf_len_ != 0)) { merge_buf_(); }
+  }
+
+  /**
+   * Load k sorted values from the pointer and merge them in the storage
+   * (see `warpsort::warp_sort::load_sorted`).
+   */
+  _RAFT_DEVICE void load_sorted(const uint64_t* in, bool do_merge = true)
+  {
+    if (do_merge) {
+      int idx = Pow2<kWarpWidth>::mod(laneId()) ^ Pow2<kWarpWidth>::Mask;
+#pragma unroll
+      for (int i = kMaxArrLen - 1; i >= 0; --i, idx += kWarpWidth) {
+        if (idx < k) {
+          uint64_t t = in[idx];
+          if (t < val_arr_[i]) { val_arr_[i] = t; }
+        }
+      }
+    }
+    if (kWarpWidth < WarpSize || do_merge) {
+      util::bitonic<kMaxArrLen>(true, kWarpWidth).merge(val_arr_);
+    }
+  }
+
+  /** Save the packed words by the pointer location (unique per-subwarp). */
+  _RAFT_DEVICE void store(uint64_t* out) const
+  {
+    int idx = Pow2<kWarpWidth>::mod(laneId());
+#pragma unroll kMaxArrLen
+    for (int i = 0; i < kMaxArrLen && idx < k; i++, idx += kWarpWidth) {
+      out[idx] = val_arr_[i];
+    }
+  }
+
+  /** Unpack and save the keys and the indices by the pointer locations (unique per-subwarp). */
+  template <typename T, typename IdxT>
+  _RAFT_DEVICE void store(T* out, IdxT* out_idx, bool select_min) const
+  {
+    int idx = Pow2<kWarpWidth>::mod(laneId());
+#pragma unroll kMaxArrLen
+    for (int i = 0; i < kMaxArrLen && idx < k; i++, idx += kWarpWidth) {
+      out[idx]     = unpack_key<T>(val_arr_[i], select_min);
+      out_idx[idx] = unpack_idx<IdxT>(val_arr_[i]);
+    }
+  }
+
+ private:
+  static constexpr int kMaxArrLen = Capacity / kWarpWidth;
+  static constexpr int kMaxBufLen = (Capacity <= 64) ? 2 : 4;
+
+  uint64_t val_arr_[kMaxArrLen];
+  uint64_t val_buf_[kMaxBufLen];
+  int buf_len_;
+  uint64_t k_th_;
+
+  _RAFT_DEVICE _RAFT_FORCEINLINE void merge_buf_()
+  {
+    util::bitonic<kMaxBufLen>(false, kWarpWidth).sort(val_buf_);
+    // the buffer is sorted in the opposite direction, so one merge keeps the queue valid
+#pragma unroll
+    for (int i = std::min(kMaxArrLen, kMaxBufLen); i > 0; i--) {
+      uint64_t& key  = val_arr_[kMaxArrLen - i];
+      uint64_t other = val_buf_[kMaxBufLen - i];
+      if (other < key) { key = other; }
+    }
+    util::bitonic<kMaxArrLen>(true, kWarpWidth).merge(val_arr_);
+    buf_len_ = 0;
+    k_th_    = shfl(val_arr_[kMaxArrLen - 1], k - 1, kWarpWidth);  // contains warp sync
+#pragma unroll
+    for (int i = 0; i < kMaxBufLen; i++) {
+      val_buf_[i] = kDummy;
+    }
+  }
+
+  _RAFT_DEVICE _RAFT_FORCEINLINE void add_to_buf_(uint64_t val)
+  {
+    // NB: the loop is used here to ensure the constant indexing,
+    //     to not force the buffers spill into the local memory.
+#pragma unroll
+    for (int i = 0; i < kMaxBufLen; i++) {
+      if (i == buf_len_) { val_buf_[i] = val; }
+    }
+    buf_len_++;
+  }
+};
+
+inline auto calc_smem_size_for_block_wide(int num_of_warp, int k) -> int
+{
+  return ceildiv(num_of_warp, 2) * sizeof(uint64_t) * k;
+}
+
+/**
+ * The packed analogue of `warpsort::block_kernel`.
+ *
+ * The input is either the keys and the (optional) indices, which are packed on load, or the
+ * packed words produced by a previous pass (`in_packed != nullptr`). Similarly, the output is
+ * either unpacked into `out` and `out_idx`, or stored as is into `out_packed` (if not null).
+ */
+template <int Capacity, typename T, typename IdxT>
+__launch_bounds__(256) __global__ void block_kernel(const T* in,
+                                                    const IdxT* in_idx,
+                                                    const uint64_t* in_packed,
+                                                    IdxT len,
+                                                    int k,
+                                                    bool select_min,
+                                                    T* out,
+                                                    IdxT* out_idx,
+                                                    uint64_t* out_packed)
+{
+  extern __shared__ __align__(256) uint8_t smem_buf_bytes[];
+  using queue_t       = warp_sort_filtered<Capacity>;
+  using subwarp_align = Pow2<queue_t::kWarpWidth>;
+  queue_t queue(k);
+
+  const IdxT stride         = gridDim.x * blockDim.x;
+  const IdxT per_thread_lim = len + laneId();
+  if (in_packed != nullptr) {
+    in_packed += blockIdx.y * len;
+    for (IdxT i = threadIdx.x + blockIdx.x * blockDim.x; i < per_thread_lim; i += stride) {
+      queue.add(i < len ? __ldcs(in_packed + i) : kDummy);
+    }
+  } else {
+    in += blockIdx.y * len;
+    if (in_idx != nullptr) { in_idx += blockIdx.y * len; }
+    for (IdxT i = threadIdx.x + blockIdx.x * blockDim.x; i < per_thread_lim; i += stride) {
+      uint64_t val = kDummy;
+      if (i < len) {
+        val = pack(__ldcs(in + i), in_idx != nullptr ? __ldcs(in_idx + i) : i, select_min);
+      }
+      queue.add(val);
+    }
+  }
+  queue.done();
+
+  // tree-merge the warp queues (see `warpsort::block_sort::done`)
+  auto smem         = reinterpret_cast<uint64_t*>(smem_buf_bytes);
+  int nwarps        = subwarp_align::div(blockDim.x);
+  const int warp_id = subwarp_align::div(threadIdx.x);
+  for (int shift_mask = ~0, split = (nwarps + 1) >> 1; nwarps > 1;
+       nwarps = split, split = (nwarps + 1) >> 1) {
+    if (warp_id < nwarps && warp_id >= split) {
+      queue.store(smem + (warp_id - (split & shift_mask)) * k);
+    }
+    __syncthreads();
+
+    shift_mask = ~shift_mask;  // invert the mask
+    queue.load_sorted(smem + (warp_id + (split & shift_mask)) * k, warp_id < nwarps - split);
+  }
+
+  if (threadIdx.x < subwarp_align::Value) {
+    const int block_id = blockIdx.x + gridDim.x * blockIdx.y;
+    if (out_packed != nullptr) {
+      queue.store(out_packed + block_id * k);
+    } else {
+      queue.store(out + block_id * k, out_idx + block_id * k, select_min);
+    }
+  }
+}
+
+template <typename T, typename IdxT, int Capacity = warpsort::kMaxCapacity>
+struct launch_setup {
+  static void kernel(int k,
+                     bool select_min,
+                     size_t batch_size,
+                     size_t len,
+                     int num_blocks,
+                     int block_dim,
+                     int smem_size,
+                     const T* in_key,
+                     const IdxT* in_idx,
+                     const uint64_t* in_packed,
+                     T* out_key,
+                     IdxT* out_idx,
+                     uint64_t* out_packed,
+                     rmm::cuda_stream_view stream)
+  {
+    const int capacity = bound_by_power_of_two(k);
+    if constexpr (Capacity > 1) {
+      if (capacity < Capacity) {
+        return launch_setup<T, IdxT, Capacity / 2>::kernel(k,
+                                                           select_min,
+                                                           batch_size,
+                                                           len,
+                                                           num_blocks,
+                                                           block_dim,
+                                                           smem_size,
+                                                           in_key,
+                                                           in_idx,
+                                                           in_packed,
+                                                           out_key,
+                                                           out_idx,
+                                                           out_packed,
+                                                           stream);
+      }
+    }
+    ASSERT(capacity <= Capacity, "Requested k is too big (%d)", k);
+
+    // This is less than cuda's max block dim along Y axis (65535), but it's a
+    // power-of-two, which ensures the alignment of batches in memory.
+    constexpr size_t kMaxGridDimY = 32768;
+    for (size_t offset = 0; offset < batch_size; offset += kMaxGridDimY) {
+      size_t batch_chunk = std::min<size_t>(kMaxGridDimY, batch_size - offset);
+      dim3 gs(num_blocks, batch_chunk, 1);
+      block_kernel<Capacity, T, IdxT><<<gs, block_dim, smem_size, stream>>>(
+        in_key, in_idx, in_packed, IdxT(len), k, select_min, out_key, out_idx, out_packed);
+      RAFT_CUDA_TRY(cudaPeekAtLastError());
+      if (in_packed != nullptr) {
+        in_packed += batch_chunk * len;
+      } else {
+        in_key += batch_chunk * len;
+        if (in_idx != nullptr) { in_idx += batch_chunk * len; }
+      }
+      if (out_packed != nullptr) {
+        out_packed += batch_chunk * num_blocks * k;
+      } else {
+        out_key += batch_chunk * num_blocks * k;
+        out_idx += batch_chunk * num_blocks * k;
+      }
+    }
+  }
+};
+
+/**
+ * Select k smallest or largest key/values from each row in the input data using the packed
+ * key-index words (see the description at the top of this file).
+ *
+ * The arguments are the same as of `warpsort::select_k`; the input must satisfy
+ * `is_supported<T, IdxT>(in_idx, len)`. The indices are truncated to 32 bits and restored on
+ * output, hence they must be representable as `uint32_t` (the negative values of the signed 32-bit
+ * index types round-trip as well, but are ordered after the non-negative ones among equal keys).
+ */
+template <typename T, typename IdxT>
+void select_k(const T* in,
+              const IdxT* in_idx,
+              size_t batch_size,
+              size_t len,
+              int k,
+              T* out,
+              IdxT* out_idx,
+              bool select_min,
+              rmm::cuda_stream_view stream,
+              rmm::mr::device_memory_resource* mr = nullptr)
+{
+  static_assert(kPackableKey<T>, "The key type is too wide to be packed with an index");
+  ASSERT(k <= warpsort::kMaxCapacity,
+         "Current max k is %d (requested %d)",
+         warpsort::kMaxCapacity,
+         k);
+  RAFT_EXPECTS((is_supported<T, IdxT>(in_idx, len)),
+               "The indices do not fit in the packed key-index pairs");
+
+  // The packed queue uses fewer registers and less shared memory than the warpsort queue of the
+  // same 64-bit keys and 32-bit payload, so the launch parameters of the latter are safe to use.
+  int num_of_block = 0;
+  int num_of_warp  = 0;
+  warpsort::calc_launch_parameter<warpsort::warp_sort_filtered, uint64_t, uint32_t>(
+    batch_size, len, k, &num_of_block, &num_of_warp);
+
+  int capacity   = bound_by_power_of_two(k);
+  int warp_width = std::min(capacity, WarpSize);
+  int block_dim  = num_of_warp * warp_width;
+  int smem_size  = calc_smem_size_for_block_wide(num_of_warp, k);
+
+  if (num_of_block == 1) {
+    return launch_setup<T, IdxT>::kernel(k,
+                                         select_min,
+                                         batch_size,
+                                         len,
+                                         1,
+                                         block_dim,
+                                         smem_size,
+                                         in,
+                                         in_idx,
+                                         nullptr,
+                                         out,
+                                         out_idx,
+                                         nullptr,
+                                         stream);
+  }
+
+  auto pool_guard =
+    raft::get_pool_memory_resource(mr, num_of_block * k * batch_size * sizeof(uint64_t));
+  if (pool_guard) { RAFT_LOG_DEBUG("packed::select_k: using pool memory resource"); }
+  rmm::device_uvector<uint64_t> tmp(num_of_block * k * batch_size, stream, mr);
+
+  launch_setup<T, IdxT>::kernel(k,
+                                select_min,
+                                batch_size,
+                                len,
+                                num_of_block,
+                                block_dim,
+                                smem_size,
+                                in,
+                                in_idx,
+                                nullptr,
+                                nullptr,
+                                nullptr,
+                                tmp.data(),
+                                stream);
+  // a second pass to merge the results
+  launch_setup<T, IdxT>::kernel(k,
+                                select_min,
+                                batch_size,
+                                k * num_of_block,
+                                1,
+                                block_dim,
+                                smem_size,
+                                nullptr,
+                                nullptr,
+                                tmp.data(),
+                                out,
+                                out_idx,
+                                nullptr,
+                                stream);
+}
+
+}  // namespace raft::matrix::detail::select::packed
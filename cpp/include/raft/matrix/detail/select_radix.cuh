@@ -29,7 +29,9 @@
 #include <cub/block/block_scan.cuh>
 #include <cub/block/block_store.cuh>
 #include <cub/block/radix_rank_sort_operations.cuh>
+#include <cub/device/device_segmented_radix_sort.cuh>
 
+#include <rmm/device_buffer.hpp>
 #include <rmm/device_uvector.hpp>
 #include <rmm/mr/device/device_memory_resource.hpp>
 #include <rmm/mr/device/managed_memory_resource.hpp>
@@ -380,6 +382,26 @@ _RAFT_DEVICE void choose_bucket(Counter<T, IdxT>* counter,
   }
 }
 
+/**
+ * Get the offset and the length of the row `batch_id` of the input.
+ *
+ * When `row_offsets == nullptr`, the input is a dense row-major matrix with `len` columns;
+ * otherwise, the rows are of variable length and `row_offsets` [batch_size + 1] are the offsets of
+ * the rows in the input (CSR-like layout).
+ */
+template <typename IdxT>
+_RAFT_DEVICE inline void get_row_bounds(
+  const IdxT* row_offsets, size_t batch_id, IdxT len, size_t& row_offset, IdxT& row_len)
+{
+  if (row_offsets == nullptr) {
+    row_offset = batch_id * len;
+    row_len    = len;
+  } else {
+    row_offset = row_offsets[batch_id];
+    row_len    = row_offsets[batch_id + 1] - row_offsets[batch_id];
+  }
+}
+
 // For one-block version, last_filter() could be called when pass < num_passes - 1.
 // So `pass` could not be constexpr
 template <typename T, typename IdxT, int BitsPerPass>
@@ -431,7 +453,8 @@ __global__ void last_filter_kernel(const T* in,
                                    IdxT len,
                                    IdxT k,
                                    Counter<T, IdxT>* counters,
-                                   const bool select_min)
+                                   const bool select_min,
+                                   const IdxT* row_offsets)
 {
   const size_t batch_id = blockIdx.y;  // size_t to avoid multiplication overflow
 
@@ -440,9 +463,10 @@ __global__ void last_filter_kernel(const T* in,
   if (previous_len == 0) { return; }
   const IdxT buf_len = calc_buf_len<T>(len);
   if (previous_len > buf_len || in_buf == in) {
-    in_buf       = in + batch_id * len;
-    in_idx_buf   = in_idx ? (in_idx + batch_id * len) : nullptr;
-    previous_len = len;
+    size_t row_offset;
+    get_row_bounds(row_offsets, batch_id, len, row_offset, previous_len);
+    in_buf     = in + row_offset;
+    in_idx_buf = in_idx ? (in_idx + row_offset) : nullptr;
   } else {
     in_buf += batch_id * buf_len;
     in_idx_buf += batch_id * buf_len;
@@ -523,6 +547,10 @@ __global__ void last_filter_kernel(const T* in,
  * bits of input values are almost the same). And then in the next pass, inputs are read from `in`
  * rather than from `in_buf`. The benefit is that we can save the cost of writing candidates and
  * their indices.
+ *
+ * When `row_offsets != nullptr`, the rows are of variable length (see `get_row_bounds()`) and
+ * `len` is the maximum length of a row. The rows not longer than `k` are skipped here; they are
+ * handled by `copy_short_rows_kernel()`.
  */
 template <typename T, typename IdxT, int BitsPerPass, int BlockSize, bool fused_last_filter>
 __global__ void radix_kernel(const T* in,
@@ -538,23 +566,29 @@ __global__ void radix_kernel(const T* in,
                              const IdxT len,
                              const IdxT k,
                              const bool select_min,
-                             const int pass)
+                             const int pass,
+                             const IdxT* row_offsets)
 {
   const size_t batch_id = blockIdx.y;
   auto counter          = counters + batch_id;
+  size_t row_offset;
+  IdxT row_len;
+  get_row_bounds(row_offsets, batch_id, len, row_offset, row_len);
+  // The short rows are copied to the output as a whole; the counter stays zero-length for them.
+  if (row_len <= k) { return; }
   IdxT current_k;
   IdxT previous_len;
   IdxT current_len;
   if (pass == 0) {
     current_k    = k;
-    previous_len = len;
+    previous_len = row_len;
     // Need to do this so setting counter->previous_len for the next pass is correct.
     // This value is meaningless for pass 0, but it's fine because pass 0 won't be the
     // last pass in this implementation so pass 0 won't hit the "if (pass ==
     // num_passes - 1)" branch.
     // Maybe it's better to reload counter->previous_len and use it rather than
     // current_len in last_filter()
-    current_len = len;
+    current_len = row_len;
   } else {
     current_k    = counter->k;
     current_len  = counter->len;
@@ -570,9 +604,9 @@ __global__ void radix_kernel(const T* in,
 
   // "previous_len > buf_len" means previous pass skips writing buffer
   if (pass == 0 || pass == 1 || previous_len > buf_len) {
-    in_buf       = in + batch_id * len;
-    in_idx_buf   = in_idx ? (in_idx + batch_id * len) : nullptr;
-    previous_len = len;
+    in_buf       = in + row_offset;
+    in_idx_buf   = in_idx ? (in_idx + row_offset) : nullptr;
+    previous_len = row_len;
   } else {
     in_buf += batch_id * buf_len;
     in_idx_buf += batch_id * buf_len;
@@ -646,7 +680,7 @@ __global__ void radix_kernel(const T* in,
                                           out_idx_buf ? out_idx_buf : in_idx_buf,
                                           out,
                                           out_idx,
-                                          out_buf ? current_len : len,
+                                          out_buf ? current_len : row_len,
                                           k,
                                           counter,
                                           select_min,
@@ -656,6 +690,38 @@ __global__ void radix_kernel(const T* in,
   }
 }
 
+/**
+ * Copy the rows of variable length not longer than `k` to the output as a whole, padding the rest
+ * of the output row with the dummy values (the largest/smallest values of `T` when selecting the
+ * minimum/maximum respectively). The indices of the padded elements are undefined.
+ */
+template <typename T, typename IdxT>
+__global__ void copy_short_rows_kernel(const T* in,
+                                       const IdxT* in_idx,
+                                       const IdxT* row_offsets,
+                                       const IdxT k,
+                                       T* out,
+                                       IdxT* out_idx,
+                                       const bool select_min)
+{
+  const size_t batch_id  = blockIdx.x;  // size_t to avoid multiplication overflow
+  const size_t row_start = row_offsets[batch_id];
+  const IdxT row_len     = row_offsets[batch_id + 1] - row_offsets[batch_id];
+  if (row_len > k) { return; }
+  const T dummy = select_min ? upper_bound<T>() : lower_bound<T>();
+  out += batch_id * k;
+  out_idx += batch_id * k;
+  for (IdxT i = threadIdx.x; i < k; i += blockDim.x) {
+    if (i < row_len) {
+      out[i]     = in[row_start + i];
+      out_idx[i] = in_idx ? in_idx[row_start + i] : i;
+    } else {
+      out[i]     = dummy;
+      out_idx[i] = i;
+    }
+  }
+}
+
 template <typename T, typename IdxT, int BlockSize, typename Kernel>
 int calc_chunk_size(int batch_size, IdxT len, int sm_cnt, Kernel kernel)
 {
@@ -757,7 +823,8 @@ void radix_topk(const T* in,
                 unsigned grid_dim,
                 int sm_cnt,
                 rmm::cuda_stream_view stream,
-                rmm::mr::device_memory_resource* mr)
+                rmm::mr::device_memory_resource* mr,
+                const IdxT* row_offsets = nullptr)
 {
   // TODO: is it possible to relax this restriction?
   static_assert(calc_num_passes<T, BitsPerPass>() > 1);
@@ -794,10 +861,13 @@ void radix_topk(const T* in,
       cudaMemsetAsync(counters.data(), 0, counters.size() * sizeof(Counter<T, IdxT>), stream));
     RAFT_CUDA_TRY(cudaMemsetAsync(histograms.data(), 0, histograms.size() * sizeof(IdxT), stream));
 
-    const T* chunk_in        = in + offset * len;
-    const IdxT* chunk_in_idx = in_idx ? (in_idx + offset * len) : nullptr;
-    T* chunk_out             = out + offset * k;
-    IdxT* chunk_out_idx      = out_idx + offset * k;
+    // the rows of variable length are addressed via the offsets, hence the input is not shifted
+    const size_t in_offset        = row_offsets ? 0 : offset * len;
+    const T* chunk_in             = in + in_offset;
+    const IdxT* chunk_in_idx      = in_idx ? (in_idx + in_offset) : nullptr;
+    const IdxT* chunk_row_offsets = row_offsets ? (row_offsets + offset) : nullptr;
+    T* chunk_out                  = out + offset * k;
+    IdxT* chunk_out_idx           = out_idx + offset * k;
 
     const T* in_buf        = nullptr;
     const IdxT* in_idx_buf = nullptr;
@@ -837,7 +907,8 @@ void radix_topk(const T* in,
                                                len,
                                                k,
                                                select_min,
-                                               pass);
+                                               pass,
+                                               chunk_row_offsets);
       RAFT_CUDA_TRY(cudaPeekAtLastError());
     }
 
@@ -851,7 +922,8 @@ void radix_topk(const T* in,
                                                                                  len,
                                                                                  k,
                                                                                  counters.data(),
-                                                                                 select_min);
+                                                                                 select_min,
+                                                                                 chunk_row_offsets);
       RAFT_CUDA_TRY(cudaPeekAtLastError());
     }
   }
@@ -930,25 +1002,32 @@ __global__ void radix_topk_one_block_kernel(const T* in,
                                             T* buf1,
                                             IdxT* idx_buf1,
                                             T* buf2,
-                                            IdxT* idx_buf2)
+                                            IdxT* idx_buf2,
+                                            const IdxT* row_offsets)
 {
   constexpr int num_buckets = calc_num_buckets<BitsPerPass>();
   __shared__ Counter<T, IdxT> counter;
   __shared__ IdxT histogram[num_buckets];
 
+  const size_t batch_id = blockIdx.x;  // size_t to avoid multiplication overflow
+  size_t row_offset;
+  IdxT row_len;
+  get_row_bounds(row_offsets, batch_id, len, row_offset, row_len);
+  // The short rows are handled by `copy_short_rows_kernel()`
+  if (row_len <= k) { return; }
+
   if (threadIdx.x == 0) {
     counter.k              = k;
-    counter.len            = len;
-    counter.previous_len   = len;
+    counter.len            = row_len;
+    counter.previous_len   = row_len;
     counter.kth_value_bits = 0;
     counter.out_cnt        = 0;
     counter.out_back_cnt   = 0;
   }
   __syncthreads();
 
-  const size_t batch_id = blockIdx.x;  // size_t to avoid multiplication overflow
-  in += batch_id * len;
-  if (in_idx) { in_idx += batch_id * len; }
+  in += row_offset;
+  if (in_idx) { in_idx += row_offset; }
   out += batch_id * k;
   out_idx += batch_id * k;
   buf1 += batch_id * len;
@@ -1018,7 +1097,8 @@ void radix_topk_one_block(const T* in,
                           bool select_min,
                           int sm_cnt,
                           rmm::cuda_stream_view stream,
-                          rmm::mr::device_memory_resource* mr)
+                          rmm::mr::device_memory_resource* mr,
+                          const IdxT* row_offsets = nullptr)
 {
   static_assert(calc_num_passes<T, BitsPerPass>() > 1);
 
@@ -1040,8 +1120,10 @@ void radix_topk_one_block(const T* in,
 
   for (size_t offset = 0; offset < static_cast<size_t>(batch_size); offset += max_chunk_size) {
     int chunk_size = std::min(max_chunk_size, batch_size - offset);
-    kernel<<<chunk_size, BlockSize, 0, stream>>>(in + offset * len,
-                                                 in_idx ? (in_idx + offset * len) : nullptr,
+    // the rows of variable length are addressed via the offsets, hence the input is not shifted
+    const size_t in_offset = row_offsets ? 0 : offset * len;
+    kernel<<<chunk_size, BlockSize, 0, stream>>>(in + in_offset,
+                                                 in_idx ? (in_idx + in_offset) : nullptr,
                                                  len,
                                                  k,
                                                  out + offset * k,
@@ -1050,7 +1132,385 @@ void radix_topk_one_block(const T* in,
                                                  buf1.data(),
                                                  idx_buf1.data(),
                                                  buf2.data(),
-                                                 idx_buf2.data());
+                                                 idx_buf2.data(),
+                                                 row_offsets ? (row_offsets + offset) : nullptr);
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+  }
+}
+
+// The following a few functions are for the large-k version. When k is large, writing the
+// selected elements in `radix_kernel()` and `last_filter()` is dominated by the contention on the
+// global output counters (one atomicAdd per selected element). Instead, the large-k version
+// finds the k-th value first, by histogramming the unmodified input in every pass, and then
+// writes the output in a single filtering pass, in which the output positions are compacted by a
+// block-wide scan (one atomicAdd per tile of the input).
+
+/**
+ * One pass of the k-th value search of the large-k version: build the histogram of the digit of
+ * the current pass over the elements that match the known bits of the k-th value and, in the last
+ * block of a row, choose the bucket of the k-th value (steps 1-3 in `radix_kernel` description).
+ */
+template <typename T, typename IdxT, int BitsPerPass, int BlockSize>
+__global__ void large_k_histogram_kernel(const T* in,
+                                         const IdxT len,
+                                         const IdxT k,
+                                         Counter<T, IdxT>* counters,
+                                         IdxT* histograms,
+                                         const bool select_min,
+                                         const int pass)
+{
+  constexpr int num_buckets = calc_num_buckets<BitsPerPass>();
+  __shared__ IdxT histogram_smem[num_buckets];
+  for (int i = threadIdx.x; i < num_buckets; i += blockDim.x) {
+    histogram_smem[i] = 0;
+  }
+  __syncthreads();
+
+  const size_t batch_id = blockIdx.y;  // size_t to avoid multiplication overflow
+  auto counter          = counters + batch_id;
+  auto histogram        = histograms + batch_id * num_buckets;
+  in += batch_id * len;
+
+  const IdxT current_k         = pass == 0 ? k : counter->k;
+  const auto kth_value_bits    = counter->kth_value_bits;
+  const int start_bit          = calc_start_bit<T, BitsPerPass>(pass);
+  const unsigned mask          = calc_mask<T, BitsPerPass>(pass);
+  const int previous_start_bit = calc_start_bit<T, BitsPerPass>(pass == 0 ? 0 : pass - 1);
+
+  auto f = [select_min, start_bit, mask, previous_start_bit, kth_value_bits, pass](T value, IdxT) {
+    if (pass > 0) {
+      const auto previous_bits = (twiddle_in(value, select_min) >> previous_start_bit)
+                                 << previous_start_bit;
+      if (previous_bits != kth_value_bits) { return; }
+    }
+    int bucket = calc_bucket<T, BitsPerPass>(value, start_bit, mask, select_min);
+    atomicAdd(histogram_smem + bucket, static_cast<IdxT>(1));
+  };
+  vectorized_process(static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x,
+                     static_cast<size_t>(blockDim.x) * gridDim.x,
+                     in,
+                     len,
+                     f);
+  __syncthreads();
+  for (int i = threadIdx.x; i < num_buckets; i += blockDim.x) {
+    if (histogram_smem[i] != 0) { atomicAdd(histogram + i, histogram_smem[i]); }
+  }
+  __threadfence();
+
+  bool isLastBlock = false;
+  if (threadIdx.x == 0) {
+    unsigned int finished = atomicInc(&counter->finished_block_cnt, gridDim.x - 1);
+    isLastBlock           = (finished == (gridDim.x - 1));
+  }
+
+  if (__syncthreads_or(isLastBlock)) {
+    scan<IdxT, BitsPerPass, BlockSize>(histogram);
+    __syncthreads();
+    choose_bucket<T, IdxT, BitsPerPass>(counter, histogram, current_k, pass);
+    __syncthreads();
+    // reset for next pass
+    for (int i = threadIdx.x; i < num_buckets; i += blockDim.x) {
+      histogram[i] = 0;
+    }
+  }
+}
+
+/**
+ * The single filtering pass of the large-k version. When all passes of
+ * `large_k_histogram_kernel()` are done, `counter->kth_value_bits` holds all bits of the k-th
+ * value and `counter->k` is the number of the elements equal to the k-th value to be selected.
+ * The elements less than the k-th value are written to the front of `out`, the elements equal to
+ * it - to the back of `out`; the positions are compacted within a tile of the input by a
+ * block-wide scan.
+ */
+template <typename T, typename IdxT, int BitsPerPass, int BlockSize>
+__global__ void large_k_filter_kernel(const T* in,
+                                      const IdxT* in_idx,
+                                      const IdxT len,
+                                      const IdxT k,
+                                      T* out,
+                                      IdxT* out_idx,
+                                      Counter<T, IdxT>* counters,
+                                      const bool select_min)
+{
+  constexpr int kItemsPerThread = 4;
+  constexpr IdxT kTileSize      = BlockSize * kItemsPerThread;
+  using BlockScan               = cub::BlockScan<IdxT, BlockSize>;
+  __shared__ typename BlockScan::TempStorage scan_storage;
+  __shared__ IdxT front_offset;
+  __shared__ IdxT back_offset;
+
+  const size_t batch_id = blockIdx.y;  // size_t to avoid multiplication overflow
+  auto counter          = counters + batch_id;
+  in += batch_id * len;
+  if (in_idx) { in_idx += batch_id * len; }
+  out += batch_id * k;
+  out_idx += batch_id * k;
+
+  const auto kth_value_bits    = counter->kth_value_bits;
+  const IdxT needed_num_of_kth = counter->k;
+
+  for (IdxT tile = blockIdx.x * kTileSize; tile < len; tile += gridDim.x * kTileSize) {
+    T values[kItemsPerThread];
+    IdxT front_flags[kItemsPerThread];
+    IdxT back_flags[kItemsPerThread];
+#pragma unroll
+    for (int j = 0; j < kItemsPerThread; j++) {
+      const IdxT i   = tile + j * BlockSize + threadIdx.x;
+      front_flags[j] = 0;
+      back_flags[j]  = 0;
+      if (i < len) {
+        values[j]       = in[i];
+        const auto bits = twiddle_in(values[j], select_min);
+        front_flags[j]  = bits < kth_value_bits;
+        back_flags[j]   = bits == kth_value_bits;
+      }
+    }
+    IdxT front_pos[kItemsPerThread];
+    IdxT back_pos[kItemsPerThread];
+    IdxT front_cnt;
+    IdxT back_cnt;
+    BlockScan(scan_storage).ExclusiveSum(front_flags, front_pos, front_cnt);
+    __syncthreads();
+    BlockScan(scan_storage).ExclusiveSum(back_flags, back_pos, back_cnt);
+    if (threadIdx.x == 0) {
+      front_offset = front_cnt > 0 ? atomicAdd(&counter->out_cnt, front_cnt) : 0;
+      back_offset  = back_cnt > 0 ? atomicAdd(&counter->out_back_cnt, back_cnt) : 0;
+    }
+    __syncthreads();
+#pragma unroll
+    for (int j = 0; j < kItemsPerThread; j++) {
+      const IdxT i = tile + j * BlockSize + threadIdx.x;
+      if (front_flags[j]) {
+        IdxT pos     = front_offset + front_pos[j];
+        out[pos]     = values[j];
+        out_idx[pos] = in_idx ? in_idx[i] : i;
+      } else if (back_flags[j]) {
+        IdxT back_pos_j = back_offset + back_pos[j];
+        if (back_pos_j < needed_num_of_kth) {
+          IdxT pos     = k - 1 - back_pos_j;
+          out[pos]     = values[j];
+          out_idx[pos] = in_idx ? in_idx[i] : i;
+        }
+      }
+    }
+    // `scan_storage`, `front_offset`, and `back_offset` are reused in the next tile
+    __syncthreads();
+  }
+}
+
+template <typename T, typename IdxT, int BitsPerPass, int BlockSize>
+void radix_topk_large_k(const T* in,
+                        const IdxT* in_idx,
+                        int batch_size,
+                        IdxT len,
+                        IdxT k,
+                        T* out,
+                        IdxT* out_idx,
+                        bool select_min,
+                        int sm_cnt,
+                        rmm::cuda_stream_view stream,
+                        rmm::mr::device_memory_resource* mr)
+{
+  constexpr int num_buckets = calc_num_buckets<BitsPerPass>();
+  constexpr int num_passes  = calc_num_passes<T, BitsPerPass>();
+  // The counters and histograms are tiny, the only limit on the chunk size is the grid dim Y
+  constexpr size_t kMaxGridDimY = 32768;
+  const size_t max_chunk_size   = std::min<size_t>(kMaxGridDimY, batch_size);
+  const unsigned grid_dim =
+    calc_grid_dim<T, IdxT, BitsPerPass, BlockSize>(max_chunk_size, len, sm_cnt);
+
+  size_t mem_req  = max_chunk_size * (sizeof(Counter<T, IdxT>) + num_buckets * sizeof(IdxT));
+  auto pool_guard = raft::get_pool_memory_resource(mr, mem_req + 256 * 2);
+  if (pool_guard) { RAFT_LOG_DEBUG("radix::select_large_k: using pool memory resource"); }
+
+  rmm::device_uvector<Counter<T, IdxT>> counters(max_chunk_size, stream, mr);
+  rmm::device_uvector<IdxT> histograms(max_chunk_size * num_buckets, stream, mr);
+
+  for (size_t offset = 0; offset < static_cast<size_t>(batch_size); offset += max_chunk_size) {
+    int chunk_size = std::min(max_chunk_size, batch_size - offset);
+    RAFT_CUDA_TRY(
+      cudaMemsetAsync(counters.data(), 0, counters.size() * sizeof(Counter<T, IdxT>), stream));
+    RAFT_CUDA_TRY(cudaMemsetAsync(histograms.data(), 0, histograms.size() * sizeof(IdxT), stream));
+
+    const T* chunk_in        = in + offset * len;
+    const IdxT* chunk_in_idx = in_idx ? (in_idx + offset * len) : nullptr;
+    dim3 blocks(grid_dim, chunk_size);
+    for (int pass = 0; pass < num_passes; ++pass) {
+      large_k_histogram_kernel<T, IdxT, BitsPerPass, BlockSize><<<blocks, BlockSize, 0, stream>>>(
+        chunk_in, len, k, counters.data(), histograms.data(), select_min, pass);
+      RAFT_CUDA_TRY(cudaPeekAtLastError());
+    }
+    large_k_filter_kernel<T, IdxT, BitsPerPass, BlockSize>
+      <<<blocks, BlockSize, 0, stream>>>(chunk_in,
+                                         chunk_in_idx,
+                                         len,
+                                         k,
+                                         out + offset * k,
+                                         out_idx + offset * k,
+                                         counters.data(),
+                                         select_min);
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+  }
+}
+
+/** Sort the k selected elements of every row of the output (in place). */
+template <typename T, typename IdxT>
+void sort_topk_rows(T* out,
+                    IdxT* out_idx,
+                    size_t batch_size,
+                    IdxT k,
+                    bool select_min,
+                    rmm::cuda_stream_view stream,
+                    rmm::mr::device_memory_resource* mr)
+{
+  // cub takes the number of items as int, hence the rows are sorted by chunks
+  const size_t max_chunk_size =
+    std::min<size_t>(batch_size, std::max<size_t>(1, std::numeric_limits<int>::max() / size_t(k)));
+  const size_t max_chunk_len = max_chunk_size * k;
+
+  rmm::device_uvector<T> keys_in(max_chunk_len, stream, mr);
+  rmm::device_uvector<IdxT> values_in(max_chunk_len, stream, mr);
+  rmm::device_uvector<int> offsets(max_chunk_size + 1, stream, mr);
+  {
+    raft::resources handle;
+    resource::set_cuda_stream(handle, stream);
+    raft::linalg::map_offset(
+      handle,
+      raft::make_device_vector_view<int, size_t>(offsets.data(), max_chunk_size + 1),
+      raft::mul_const_op<int>(k));
+  }
+  for (size_t offset = 0; offset < batch_size; offset += max_chunk_size) {
+    const int chunk_size = std::min(max_chunk_size, batch_size - offset);
+    const int chunk_len  = chunk_size * k;
+    T* chunk_out         = out + offset * k;
+    IdxT* chunk_out_idx  = out_idx + offset * k;
+    RAFT_CUDA_TRY(cudaMemcpyAsync(
+      keys_in.data(), chunk_out, sizeof(T) * chunk_len, cudaMemcpyDeviceToDevice, stream));
+    RAFT_CUDA_TRY(cudaMemcpyAsync(
+      values_in.data(), chunk_out_idx, sizeof(IdxT) * chunk_len, cudaMemcpyDeviceToDevice, stream));
+
+    size_t workspace_size = 0;
+    // The first call (without the workspace) only computes the workspace size
+    auto sort = [&](void* workspace) {
+      if (select_min) {
+        RAFT_CUDA_TRY(cub::DeviceSegmentedRadixSort::SortPairs(workspace,
+                                                               workspace_size,
+                                                               keys_in.data(),
+                                                               chunk_out,
+                                                               values_in.data(),
+                                                               chunk_out_idx,
+                                                               chunk_len,
+                                                               chunk_size,
+                                                               offsets.data(),
+                                                               offsets.data() + 1,
+                                                               0,
+                                                               sizeof(T) * 8,
+                                                               stream));
+      } else {
+        RAFT_CUDA_TRY(cub::DeviceSegmentedRadixSort::SortPairsDescending(workspace,
+                                                                         workspace_size,
+                                                                         keys_in.data(),
+                                                                         chunk_out,
+                                                                         values_in.data(),
+                                                                         chunk_out_idx,
+                                                                         chunk_len,
+                                                                         chunk_size,
+                                                                         offsets.data(),
+                                                                         offsets.data() + 1,
+                                                                         0,
+                                                                         sizeof(T) * 8,
+                                                                         stream));
+      }
+    };
+    sort(nullptr);
+    rmm::device_buffer workspace(workspace_size, stream, mr);
+    sort(workspace.data());
+  }
+}
+
+/** The special case of k == len: the rows are copied to the output as a whole. */
+template <typename T, typename IdxT>
+void select_all(const T* in,
+                const IdxT* in_idx,
+                int batch_size,
+                IdxT len,
+                T* out,
+                IdxT* out_idx,
+                rmm::cuda_stream_view stream)
+{
+  RAFT_CUDA_TRY(
+    cudaMemcpyAsync(out, in, sizeof(T) * batch_size * len, cudaMemcpyDeviceToDevice, stream));
+  if (in_idx) {
+    RAFT_CUDA_TRY(cudaMemcpyAsync(
+      out_idx, in_idx, sizeof(IdxT) * batch_size * len, cudaMemcpyDeviceToDevice, stream));
+  } else {
+    auto out_idx_view =
+      raft::make_device_vector_view(out_idx, static_cast<size_t>(len) * batch_size);
+    raft::resources handle;
+    resource::set_cuda_stream(handle, stream);
+    raft::linalg::map_offset(handle, out_idx_view, raft::mod_const_op<IdxT>(len));
+  }
+}
+
+// TODO: use device_resources::get_device_properties() instead; should change it when we refactor
+// resource management
+inline int get_sm_cnt()
+{
+  int sm_cnt;
+  int dev;
+  RAFT_CUDA_TRY(cudaGetDevice(&dev));
+  RAFT_CUDA_TRY(cudaDeviceGetAttribute(&sm_cnt, cudaDevAttrMultiProcessorCount, dev));
+  return sm_cnt;
+}
+
+/**
+ * The common part of `select_k()` and `select_k_segmented()`: choose between the one-block and
+ * the multi-block versions (`row_offsets == nullptr` selects the dense input, see
+ * `get_row_bounds()`).
+ */
+template <typename T, typename IdxT, int BitsPerPass, int BlockSize>
+void select_k_(const T* in,
+               const IdxT* in_idx,
+               int batch_size,
+               IdxT len,
+               IdxT k,
+               T* out,
+               IdxT* out_idx,
+               bool select_min,
+               bool fused_last_filter,
+               rmm::cuda_stream_view stream,
+               rmm::mr::device_memory_resource* mr,
+               const IdxT* row_offsets = nullptr)
+{
+  const int sm_cnt = get_sm_cnt();
+
+  constexpr int items_per_thread = 32;
+
+  if (len <= BlockSize * items_per_thread) {
+    radix_topk_one_block<T, IdxT, BitsPerPass, BlockSize>(
+      in, in_idx, batch_size, len, k, out, out_idx, select_min, sm_cnt, stream, mr, row_offsets);
+  } else {
+    unsigned grid_dim = calc_grid_dim<T, IdxT, BitsPerPass, BlockSize>(batch_size, len, sm_cnt);
+    if (grid_dim == 1) {
+      radix_topk_one_block<T, IdxT, BitsPerPass, BlockSize>(
+        in, in_idx, batch_size, len, k, out, out_idx, select_min, sm_cnt, stream, mr, row_offsets);
+    } else {
+      radix_topk<T, IdxT, BitsPerPass, BlockSize>(in,
+                                                  in_idx,
+                                                  batch_size,
+                                                  len,
+                                                  k,
+                                                  out,
+                                                  out_idx,
+                                                  select_min,
+                                                  fused_last_filter,
+                                                  grid_dim,
+                                                  sm_cnt,
+                                                  stream,
+                                                  mr,
+                                                  row_offsets);
+    }
   }
 }
 
@@ -1119,58 +1579,164 @@ void select_k(const T* in,
               rmm::cuda_stream_view stream,
               rmm::mr::device_memory_resource* mr = nullptr)
 {
-  if (k == len) {
-    RAFT_CUDA_TRY(
-      cudaMemcpyAsync(out, in, sizeof(T) * batch_size * len, cudaMemcpyDeviceToDevice, stream));
-    if (in_idx) {
-      RAFT_CUDA_TRY(cudaMemcpyAsync(
-        out_idx, in_idx, sizeof(IdxT) * batch_size * len, cudaMemcpyDeviceToDevice, stream));
-    } else {
-      auto out_idx_view =
-        raft::make_device_vector_view(out_idx, static_cast<size_t>(len) * batch_size);
-      raft::resources handle;
-      resource::set_cuda_stream(handle, stream);
-      raft::linalg::map_offset(handle, out_idx_view, raft::mod_const_op<IdxT>(len));
-    }
-    return;
-  }
+  if (k == len) { return impl::select_all(in, in_idx, batch_size, len, out, out_idx, stream); }
+  impl::select_k_<T, IdxT, BitsPerPass, BlockSize>(
+    in, in_idx, batch_size, len, k, out, out_idx, select_min, fused_last_filter, stream, mr);
+}
 
-  // TODO: use device_resources::get_device_properties() instead; should change it when we refactor
-  // resource management
-  int sm_cnt;
-  {
-    int dev;
-    RAFT_CUDA_TRY(cudaGetDevice(&dev));
-    RAFT_CUDA_TRY(cudaDeviceGetAttribute(&sm_cnt, cudaDevAttrMultiProcessorCount, dev));
-  }
+/**
+ * Select k smallest or largest key/values from each row of variable length in the input data.
+ *
+ * The input is a CSR-like batch of rows: the row `i` spans the range
+ * `[row_offsets[i], row_offsets[i + 1])` of the arrays `in` and `in_idx`. The rows not longer
+ * than `k` are copied to the output as a whole, and the rest of such an output row is padded with
+ * the dummy values: `upper_bound<T>()` when selecting the minimum, `lower_bound<T>()` otherwise
+ * (the indices of the padded elements are undefined).
+ *
+ * Note, the output is NOT sorted within the groups of `k` selected elements.
+ *
+ * @tparam T
+ *   the type of the keys (what is being compared).
+ * @tparam IdxT
+ *   the index type (what is being selected together with the keys).
+ * @tparam BitsPerPass
+ *   The size of the radix;
+ *   it affects the number of passes and number of buckets.
+ * @tparam BlockSize
+ *   Number of threads in a kernel thread block.
+ *
+ * @param[in] in
+ *   contiguous device array of inputs of size (row_offsets[batch_size]);
+ *   these are compared and selected.
+ * @param[in] in_idx
+ *   optional contiguous device array of inputs of size (row_offsets[batch_size]);
+ *   typically, these are indices of the corresponding in_keys. When `nullptr`, the positions of
+ *   the elements within their rows are selected.
+ * @param[in] row_offsets
+ *   device array of the row offsets of size (batch_size + 1).
+ * @param batch_size
+ *   number of input rows, i.e. the batch size.
+ * @param max_len
+ *   the maximum length of a row (an upper bound is fine, but it affects the amount of the
+ *   temporary memory and the launch configuration).
+ * @param k
+ *   the number of outputs to select in each input row.
+ * @param[out] out
+ *   contiguous device array of outputs of size (k * batch_size);
+ *   the k smallest/largest values from each row of the `in_keys`.
+ * @param[out] out_idx
+ *   contiguous device array of outputs of size (k * batch_size);
+ *   the payload selected together with `out`.
+ * @param select_min
+ *   whether to select k smallest (true) or largest (false) keys.
+ * @param fused_last_filter
+ *   see `select_k()`.
+ * @param stream
+ * @param mr an optional memory resource to use across the calls (you can provide a large enough
+ *           memory pool here to avoid memory allocations within the call).
+ */
+template <typename T, typename IdxT, int BitsPerPass, int BlockSize>
+void select_k_segmented(const T* in,
+                        const IdxT* in_idx,
+                        const IdxT* row_offsets,
+                        int batch_size,
+                        IdxT max_len,
+                        IdxT k,
+                        T* out,
+                        IdxT* out_idx,
+                        bool select_min,
+                        bool fused_last_filter,
+                        rmm::cuda_stream_view stream,
+                        rmm::mr::device_memory_resource* mr = nullptr)
+{
+  if (batch_size == 0) { return; }
+  impl::copy_short_rows_kernel<T, IdxT><<<batch_size, BlockSize, 0, stream>>>(
+    in, in_idx, row_offsets, k, out, out_idx, select_min);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+  if (max_len <= k) { return; }
+  impl::select_k_<T, IdxT, BitsPerPass, BlockSize>(in,
+                                                   in_idx,
+                                                   batch_size,
+                                                   max_len,
+                                                   k,
+                                                   out,
+                                                   out_idx,
+                                                   select_min,
+                                                   fused_last_filter,
+                                                   stream,
+                                                   mr,
+                                                   row_offsets);
+}
 
-  constexpr int items_per_thread = 32;
 
-  if (len <= BlockSize * items_per_thread) {
-    impl::radix_topk_one_block<T, IdxT, BitsPerPass, BlockSize>(
-      in, in_idx, batch_size, len, k, out, out_idx, select_min, sm_cnt, stream, mr);
+/**
+ * Select k smallest or largest key/values from each row in the input data; a version for large k.
+ *
+ * The semantics is the same as in `select_k()`, but the implementation is tuned for large k
+ * (thousands and more): the k-th value of every row is found first by histogramming the input
+ * in every pass (the input is read `calc_num_passes<T, BitsPerPass>()` times), then the output
+ * is written in a single filtering pass with compacted (block-aggregated) output positions.
+ * Optionally, the selected elements are sorted afterwards.
+ *
+ * @tparam T
+ *   the type of the keys (what is being compared).
+ * @tparam IdxT
+ *   the index type (what is being selected together with the keys).
+ * @tparam BitsPerPass
+ *   The size of the radix;
+ *   it affects the number of passes and number of buckets.
+ * @tparam BlockSize
+ *   Number of threads in a kernel thread block.
+ *
+ * @param[in] in
+ *   contiguous device array of inputs of size (len * batch_size);
+ *   these are compared and selected.
+ * @param[in] in_idx
+ *   contiguous device array of inputs of size (len * batch_size);
+ *   typically, these are indices of the corresponding in_keys.
+ * @param batch_size
+ *   number of input rows, i.e. the batch size.
+ * @param len
+ *   length of a single input array (row); also sometimes referred as n_cols.
+ *   Invariant: len >= k.
+ * @param k
+ *   the number of outputs to select in each input row.
+ * @param[out] out
+ *   contiguous device array of outputs of size (k * batch_size);
+ *   the k smallest/largest values from each row of the `in_keys`.
+ * @param[out] out_idx
+ *   contiguous device array of outputs of size (k * batch_size);
+ *   the payload selected together with `out`.
+ * @param select_min
+ *   whether to select k smallest (true) or largest (false) keys.
+ * @param sorted
+ *   whether to sort the selected elements within every row (ascending if `select_min`,
+ *   descending otherwise).
+ * @param stream
+ * @param mr an optional memory resource to use across the calls (you can provide a large enough
+ *           memory pool here to avoid memory allocations within the call).
+ */
+template <typename T, typename IdxT, int BitsPerPass, int BlockSize>
+void select_large_k(const T* in,
+                    const IdxT* in_idx,
+                    int batch_size,
+                    IdxT len,
+                    IdxT k,
+                    T* out,
+                    IdxT* out_idx,
+                    bool select_min,
+                    bool sorted,
+                    rmm::cuda_stream_view stream,
+                    rmm::mr::device_memory_resource* mr = nullptr)
+{
+  if (batch_size == 0 || k == 0) { return; }
+  if (k == len) {
+    impl::select_all(in, in_idx, batch_size, len, out, out_idx, stream);
   } else {
-    unsigned grid_dim =
-      impl::calc_grid_dim<T, IdxT, BitsPerPass, BlockSize>(batch_size, len, sm_cnt);
-    if (grid_dim == 1) {
-      impl::radix_topk_one_block<T, IdxT, BitsPerPass, BlockSize>(
-        in, in_idx, batch_size, len, k, out, out_idx, select_min, sm_cnt, stream, mr);
-    } else {
-      impl::radix_topk<T, IdxT, BitsPerPass, BlockSize>(in,
-                                                        in_idx,
-                                                        batch_size,
-                                                        len,
-                                                        k,
-                                                        out,
-                                                        out_idx,
-                                                        select_min,
-                                                        fused_last_filter,
-                                                        grid_dim,
-                                                        sm_cnt,
-                                                        stream,
-                                                        mr);
-    }
+    impl::radix_topk_large_k<T, IdxT, BitsPerPass, BlockSize>(
+      in, in_idx, batch_size, len, k, out, out_idx, select_min, impl::get_sm_cnt(), stream, mr);
   }
+  if (sorted) { impl::sort_topk_rows(out, out_idx, batch_size, k, select_min, stream, mr); }
 }
 
 }  // namespace raft::matrix::detail::select::radix
@@ -744,22 +744,38 @@ class block_sort {
  * communication. It can be arranged so, that multiple blocks process one row of input; in this
  * case, they output multiple results of length k each. Then, a second pass is needed to merge
  * those into one final output.
+ *
+ * When `row_offsets != nullptr`, the rows are of variable length: the row `i` spans the range
+ * `[row_offsets[i], row_offsets[i + 1])` of the input; the output rows shorter than `k` are padded
+ * with the dummy values.
  */
 template <template <int, bool, typename, typename> class WarpSortClass,
           int Capacity,
           bool Ascending,
           typename T,
           typename IdxT>
-__launch_bounds__(256) __global__
-  void block_kernel(const T* in, const IdxT* in_idx, IdxT len, int k, T* out, IdxT* out_idx)
+__launch_bounds__(256) __global__ void block_kernel(const T* in,
+                                                    const IdxT* in_idx,
+                                                    IdxT len,
+                                                    int k,
+                                                    T* out,
+                                                    IdxT* out_idx,
+                                                    const IdxT* row_offsets)
 {
   extern __shared__ __align__(256) uint8_t smem_buf_bytes[];
   using bq_t         = block_sort<WarpSortClass, Capacity, Ascending, T, IdxT>;
   uint8_t* warp_smem = bq_t::queue_t::mem_required(blockDim.x) > 0 ? smem_buf_bytes : nullptr;
   bq_t queue(k, warp_smem);
 
-  in += blockIdx.y * len;
-  if (in_idx != nullptr) { in_idx += blockIdx.y * len; }
+  if (row_offsets == nullptr) {
+    in += blockIdx.y * len;
+    if (in_idx != nullptr) { in_idx += blockIdx.y * len; }
+  } else {
+    const IdxT row_start = row_offsets[blockIdx.y];
+    len                  = row_offsets[blockIdx.y + 1] - row_start;
+    in += row_start;
+    if (in_idx != nullptr) { in_idx += row_start; }
+  }
 
   const IdxT stride         = gridDim.x * blockDim.x;
   const IdxT per_thread_lim = len + laneId();
@@ -826,7 +842,8 @@ struct launch_setup {
                      const IdxT* in_idx,
                      T* out_key,
                      IdxT* out_idx,
-                     rmm::cuda_stream_view stream)
+                     rmm::cuda_stream_view stream,
+                     const IdxT* row_offsets = nullptr)
   {
     const int capacity = bound_by_power_of_two(k);
     if constexpr (Capacity > 1) {
@@ -842,7 +859,8 @@ struct launch_setup {
                                                                           in_idx,
                                                                           out_key,
                                                                           out_idx,
-                                                                          stream);
+                                                                          stream,
+                                                                          row_offsets);
       }
     }
     ASSERT(capacity <= Capacity, "Requested k is too big (%d)", k);
@@ -854,17 +872,22 @@ struct launch_setup {
       size_t batch_chunk = std::min<size_t>(kMaxGridDimY, batch_size - offset);
       dim3 gs(num_blocks, batch_chunk, 1);
       if (select_min) {
-        block_kernel<WarpSortClass, Capacity, true, T, IdxT>
-          <<<gs, block_dim, smem_size, stream>>>(in_key, in_idx, IdxT(len), k, out_key, out_idx);
+        block_kernel<WarpSortClass, Capacity, true, T, IdxT><<<gs, block_dim, smem_size, stream>>>(
+          in_key, in_idx, IdxT(len), k, out_key, out_idx, row_offsets);
       } else {
-        block_kernel<WarpSortClass, Capacity, false, T, IdxT>
-          <<<gs, block_dim, smem_size, stream>>>(in_key, in_idx, IdxT(len), k, out_key, out_idx);
+        block_kernel<WarpSortClass, Capacity, false, T, IdxT><<<gs, block_dim, smem_size, stream>>>(
+          in_key, in_idx, IdxT(len), k, out_key, out_idx, row_offsets);
       }
       RAFT_CUDA_TRY(cudaPeekAtLastError());
       out_key += batch_chunk * num_blocks * k;
       out_idx += batch_chunk * num_blocks * k;
-      in_key += batch_chunk * len;
-      if (in_idx != nullptr) { in_idx += batch_chunk * len; }
+      if (row_offsets != nullptr) {
+        // the rows of variable length are addressed via the offsets
+        row_offsets += batch_chunk;
+      } else {
+        in_key += batch_chunk * len;
+        if (in_idx != nullptr) { in_idx += batch_chunk * len; }
+      }
     }
   }
 };
@@ -986,7 +1009,8 @@ void select_k_(int num_of_block,
                IdxT* out_idx,
                bool select_min,
                rmm::cuda_stream_view stream,
-               rmm::mr::device_memory_resource* mr = nullptr)
+               rmm::mr::device_memory_resource* mr = nullptr,
+               const IdxT* row_offsets             = nullptr)
 {
   auto pool_guard = raft::get_pool_memory_resource(
     mr, num_of_block * k * batch_size * 2 * std::max(sizeof(T), sizeof(IdxT)));
@@ -1016,7 +1040,8 @@ void select_k_(int num_of_block,
                                                in_idx,
                                                result_val,
                                                result_idx,
-                                               stream);
+                                               stream,
+                                               row_offsets);
 
   if (num_of_block > 1) {
     // a second pass to merge the results if necessary
@@ -1065,6 +1090,68 @@ void select_k_impl(const T* in,
                                     mr);
 }
 
+/**
+ * Choose between `warp_sort_immediate` and `warp_sort_filtered` depending on the amount of work
+ * per thread (the common part of `select_k()` and `select_k_segmented()`).
+ */
+template <typename T, typename IdxT>
+void select_k_auto(const T* in,
+                   const IdxT* in_idx,
+                   size_t batch_size,
+                   size_t len,
+                   int k,
+                   T* out,
+                   IdxT* out_idx,
+                   bool select_min,
+                   rmm::cuda_stream_view stream,
+                   rmm::mr::device_memory_resource* mr = nullptr,
+                   const IdxT* row_offsets             = nullptr)
+{
+  ASSERT(k <= kMaxCapacity, "Current max k is %d (requested %d)", kMaxCapacity, k);
+  ASSERT(len <= size_t(std::numeric_limits<IdxT>::max()),
+         "The `len` (%zu) does not fit the indexing type",
+         len);
+
+  int capacity     = bound_by_power_of_two(k);
+  int num_of_block = 0;
+  int num_of_warp  = 0;
+  calc_launch_parameter<warp_sort_immediate, T, IdxT>(
+    batch_size, len, k, &num_of_block, &num_of_warp);
+  int len_per_thread = len / (num_of_block * num_of_warp * std::min(capacity, WarpSize));
+
+  if (len_per_thread <= LaunchThreshold<warp_sort_immediate>::len_factor_for_choosing) {
+    select_k_<warp_sort_immediate, T, IdxT>(num_of_block,
+                                            num_of_warp,
+                                            in,
+                                            in_idx,
+                                            batch_size,
+                                            len,
+                                            k,
+                                            out,
+                                            out_idx,
+                                            select_min,
+                                            stream,
+                                            mr,
+                                            row_offsets);
+  } else {
+    calc_launch_parameter<warp_sort_filtered, T, IdxT>(
+      batch_size, len, k, &num_of_block, &num_of_warp);
+    select_k_<warp_sort_filtered, T, IdxT>(num_of_block,
+                                           num_of_warp,
+                                           in,
+                                           in_idx,
+                                           batch_size,
+                                           len,
+                                           k,
+                                           out,
+                                           out_idx,
+                                           select_min,
+                                           stream,
+                                           mr,
+                                           row_offsets);
+  }
+}
+
 /**
  * Select k smallest or largest key/values from each row in the input data.
  *
@@ -1114,47 +1201,65 @@ void select_k(const T* in,
               rmm::cuda_stream_view stream,
               rmm::mr::device_memory_resource* mr = nullptr)
 {
-  ASSERT(k <= kMaxCapacity, "Current max k is %d (requested %d)", kMaxCapacity, k);
-  ASSERT(len <= size_t(std::numeric_limits<IdxT>::max()),
-         "The `len` (%zu) does not fit the indexing type",
-         len);
-
-  int capacity     = bound_by_power_of_two(k);
-  int num_of_block = 0;
-  int num_of_warp  = 0;
-  calc_launch_parameter<warp_sort_immediate, T, IdxT>(
-    batch_size, len, k, &num_of_block, &num_of_warp);
-  int len_per_thread = len / (num_of_block * num_of_warp * std::min(capacity, WarpSize));
+  select_k_auto<T, IdxT>(in, in_idx, batch_size, len, k, out, out_idx, select_min, stream, mr);
+}
 
-  if (len_per_thread <= LaunchThreshold<warp_sort_immediate>::len_factor_for_choosing) {
-    select_k_<warp_sort_immediate, T, IdxT>(num_of_block,
-                                            num_of_warp,
-                                            in,
-                                            in_idx,
-                                            batch_size,
-                                            len,
-                                            k,
-                                            out,
-                                            out_idx,
-                                            select_min,
-                                            stream,
-                                            mr);
-  } else {
-    calc_launch_parameter<warp_sort_filtered, T, IdxT>(
-      batch_size, len, k, &num_of_block, &num_of_warp);
-    select_k_<warp_sort_filtered, T, IdxT>(num_of_block,
-                                           num_of_warp,
-                                           in,
-                                           in_idx,
-                                           batch_size,
-                                           len,
-                                           k,
-                                           out,
-                                           out_idx,
-                                           select_min,
-                                           stream,
-                                           mr);
-  }
+/**
+ * Select k smallest or largest key/values from each row of variable length in the input data.
+ *
+ * The input is a CSR-like batch of rows: the row `i` spans the range
+ * `[row_offsets[i], row_offsets[i + 1])` of the arrays `in` and `in_idx`. The output rows
+ * shorter than `k` are padded with the dummy values: `upper_bound<T>()` when selecting the
+ * minimum, `lower_bound<T>()` otherwise (the indices of the padded elements are undefined).
+ *
+ * @tparam T
+ *   the type of the keys (what is being compared).
+ * @tparam IdxT
+ *   the index type (what is being selected together with the keys).
+ *
+ * @param[in] in
+ *   contiguous device array of inputs of size (row_offsets[batch_size]);
+ *   these are compared and selected.
+ * @param[in] in_idx
+ *   optional contiguous device array of inputs of size (row_offsets[batch_size]);
+ *   typically, these are indices of the corresponding in_keys. When `nullptr`, the positions of
+ *   the elements within their rows are selected.
+ * @param[in] row_offsets
+ *   device array of the row offsets of size (batch_size + 1).
+ * @param batch_size
+ *   number of input rows, i.e. the batch size.
+ * @param max_len
+ *   the maximum length of a row (used to choose the launch configuration).
+ * @param k
+ *   the number of outputs to select in each input row.
+ * @param[out] out
+ *   contiguous device array of outputs of size (k * batch_size);
+ *   the k smallest/largest values from each row of the `in_keys`.
+ * @param[out] out_idx
+ *   contiguous device array of outputs of size (k * batch_size);
+ *   the payload selected together with `out`.
+ * @param select_min
+ *   whether to select k smallest (true) or largest (false) keys.
+ * @param stream
+ * @param mr an optional memory resource to use across the calls (you can provide a large enough
+ *           memory pool here to avoid memory allocations within the call).
+ */
+template <typename T, typename IdxT>
+void select_k_segmented(const T* in,
+                        const IdxT* in_idx,
+                        const IdxT* row_offsets,
+                        size_t batch_size,
+                        size_t max_len,
+                        int k,
+                        T* out,
+                        IdxT* out_idx,
+                        bool select_min,
+                        rmm::cuda_stream_view stream,
+                        rmm::mr::device_memory_resource* mr = nullptr)
+{
+  if (batch_size == 0) { return; }
+  select_k_auto<T, IdxT>(
+    in, in_idx, batch_size, max_len, k, out, out_idx, select_min, stream, mr, row_offsets);
 }
 
 }  // namespace raft::matrix::detail::select::warpsort
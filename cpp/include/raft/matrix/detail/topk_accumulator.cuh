@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/matrix/detail/select_warpsort.cuh>
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/linalg/map.cuh>
+#include <raft/matrix/select_k.cuh>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/pow2_utils.cuh>
+
+#include <rmm/device_uvector.hpp>
+
+#include <algorithm>
+#include <optional>
+
+namespace raft::matrix::detail {
+
+/**
+ * Merge a tile of new candidates into the running top-k in one pass: a thread block per row
+ * feeds both the current `k` values of the row and the `tile_len` values of the tile through the
+ * block-wide warp-sort queue and overwrites the row with the result.
+ *
+ * The payload of the tile element `j` is `idx_offset + (tile_idx != nullptr ? tile_idx[j] : j)`.
+ */
+template <int Capacity, bool Ascending, typename T, typename IdxT>
+__launch_bounds__(256) __global__ void topk_merge_kernel(T* acc_val,
+                                                         IdxT* acc_idx,
+                                                         int k,
+                                                         const T* tile_val,
+                                                         const IdxT* tile_idx,
+                                                         IdxT tile_len,
+                                                         IdxT idx_offset)
+{
+  using namespace select::warpsort;  // NOLINT
+  extern __shared__ __align__(256) uint8_t smem_buf_bytes[];
+  using bq_t = block_sort<warp_sort_filtered, Capacity, Ascending, T, IdxT>;
+  bq_t queue(k);
+
+  const size_t row = blockIdx.x;
+  acc_val += row * k;
+  acc_idx += row * k;
+  tile_val += row * tile_len;
+  if (tile_idx != nullptr) { tile_idx += row * tile_len; }
+
+  const IdxT len            = tile_len + IdxT(k);
+  const IdxT per_thread_lim = len + laneId();
+  for (IdxT i = threadIdx.x; i < per_thread_lim; i += blockDim.x) {
+    T val    = bq_t::queue_t::kDummy;
+    IdxT idx = IdxT{};
+    if (i < IdxT(k)) {
+      val = acc_val[i];
+      idx = acc_idx[i];
+    } else if (i < len) {
+      const IdxT j = i - IdxT(k);
+      val          = __ldcs(tile_val + j);
+      idx          = idx_offset + (tile_idx != nullptr ? __ldcs(tile_idx + j) : j);
+    }
+    queue.add(val, idx);
+  }
+
+  // NB: it's safe to overwrite the row in-place: all warps have read their inputs before they
+  //     are merged together in `done`.
+  queue.done(smem_buf_bytes);
+  queue.store(acc_val, acc_idx);
+}
+
+template <typename T, typename IdxT, int Capacity = select::warpsort::kMaxCapacity>
+void topk_merge(int k,
+                bool select_min,
+                size_t n_rows,
+                int num_of_warp,
+                T* acc_val,
+                IdxT* acc_idx,
+                const T* tile_val,
+                const IdxT* tile_idx,
+                size_t tile_len,
+                IdxT idx_offset,
+                rmm::cuda_stream_view stream)
+{
+  const int capacity = bound_by_power_of_two(k);
+  if constexpr (Capacity > 1) {
+    if (capacity < Capacity) {
+      return topk_merge<T, IdxT, Capacity / 2>(k,
+                                               select_min,
+                                               n_rows,
+                                               num_of_warp,
+                                               acc_val,
+                                               acc_idx,
+                                               tile_val,
+                                               tile_idx,
+                                               tile_len,
+                                               idx_offset,
+                                               stream);
+    }
+  }
+  ASSERT(capacity <= Capacity, "Requested k is too big (%d)", k);
+
+  const int block_dim = num_of_warp * std::min<int>(Capacity, WarpSize);
+  const int smem_size = select::warpsort::calc_smem_size_for_block_wide<T, IdxT>(num_of_warp, k);
+  if (select_min) {
+    topk_merge_kernel<Capacity, true, T, IdxT><<<n_rows, block_dim, smem_size, stream>>>(
+      acc_val, acc_idx, k, tile_val, tile_idx, IdxT(tile_len), idx_offset);
+  } else {
+    topk_merge_kernel<Capacity, false, T, IdxT><<<n_rows, block_dim, smem_size, stream>>>(
+      acc_val, acc_idx, k, tile_val, tile_idx, IdxT(tile_len), idx_offset);
+  }
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+/**
+ * Merge a tile of candidates [n_rows, tile_len] into the running top-k [n_rows, k] in-place.
+ *
+ * When the rows are enough to occupy the GPU with one block per row, this is a single fused pass
+ * over the tile. Otherwise, the top-k of the tile is selected first (using the multi-block
+ * select_k) and then merged into the running top-k.
+ */
+template <typename T, typename IdxT>
+void topk_accumulate(raft::resources const& res,
+                     T* acc_val,
+                     IdxT* acc_idx,
+                     size_t n_rows,
+                     int k,
+                     bool select_min,
+                     const T* tile_val,
+                     const IdxT* tile_idx,
+                     size_t tile_len,
+                     IdxT idx_offset)
+{
+  if (n_rows == 0 || tile_len == 0) { return; }
+  auto stream = resource::get_cuda_stream(res);
+  auto mr     = resource::get_workspace_resource(res);
+
+  if (k <= select::warpsort::kMaxCapacity) {
+    int num_of_block = 0;
+    int num_of_warp  = 0;
+    select::warpsort::calc_launch_parameter<select::warpsort::warp_sort_filtered, T, IdxT>(
+      n_rows, tile_len + k, k, &num_of_block, &num_of_warp);
+    if (num_of_block == 1) {
+      return topk_merge<T, IdxT>(k,
+                                 select_min,
+                                 n_rows,
+                                 num_of_warp,
+                                 acc_val,
+                                 acc_idx,
+                                 tile_val,
+                                 tile_idx,
+                                 tile_len,
+                                 idx_offset,
+                                 stream);
+    }
+  }
+
+  const int tile_k = int(std::min<size_t>(k, tile_len));
+  rmm::device_uvector<T> tmp_val(n_rows * tile_k, stream, mr);
+  rmm::device_uvector<IdxT> tmp_idx(n_rows * tile_k, stream, mr);
+  std::optional<device_matrix_view<const IdxT, int64_t>> tile_idx_view = std::nullopt;
+  if (tile_idx != nullptr) {
+    tile_idx_view = make_device_matrix_view<const IdxT, int64_t>(tile_idx, n_rows, tile_len);
+  }
+  matrix::select_k<T, IdxT>(res,
+                            make_device_matrix_view<const T, int64_t>(tile_val, n_rows, tile_len),
+                            tile_idx_view,
+                            make_device_matrix_view<T, int64_t>(tmp_val.data(), n_rows, tile_k),
+                            make_device_matrix_view<IdxT, int64_t>(tmp_idx.data(), n_rows, tile_k),
+                            select_min);
+
+  if (k <= select::warpsort::kMaxCapacity) {
+    // the merged lists are short: a single warp per row is enough
+    const int num_of_warp = WarpSize / std::min<int>(bound_by_power_of_two(k), WarpSize);
+    return topk_merge<T, IdxT>(k,
+                               select_min,
+                               n_rows,
+                               num_of_warp,
+                               acc_val,
+                               acc_idx,
+                               tmp_val.data(),
+                               tmp_idx.data(),
+                               tile_k,
+                               idx_offset,
+                               stream);
+  }
+
+  // k is too large for the warp-sort: select from the concatenation of the two lists.
+  const size_t cat_len = k + tile_k;
+  rmm::device_uvector<T> cat_val(n_rows * cat_len, stream, mr);
+  rmm::device_uvector<IdxT> cat_idx(n_rows * cat_len, stream, mr);
+  auto tmp_val_ptr = tmp_val.data();
+  auto tmp_idx_ptr = tmp_idx.data();
+  raft::linalg::map_offset(res,
+                           make_device_vector_view(cat_val.data(), n_rows * cat_len),
+                           [=] __device__(size_t i) {
+                             auto row = i / cat_len;
+                             auto col = i % cat_len;
+                             return col < size_t(k) ? acc_val[row * k + col]
+                                                    : tmp_val_ptr[row * tile_k + col - k];
+                           });
+  raft::linalg::map_offset(res,
+                           make_device_vector_view(cat_idx.data(), n_rows * cat_len),
+                           [=] __device__(size_t i) {
+                             auto row = i / cat_len;
+                             auto col = i % cat_len;
+                             return col < size_t(k)
+                                      ? acc_idx[row * k + col]
+                                      : IdxT(idx_offset + tmp_idx_ptr[row * tile_k + col - k]);
+                           });
+  matrix::select_k<T, IdxT>(
+    res,
+    make_device_matrix_view<const T, int64_t>(cat_val.data(), n_rows, cat_len),
+    make_device_matrix_view<const IdxT, int64_t>(cat_idx.data(), n_rows, cat_len),
+    make_device_matrix_view<T, int64_t>(acc_val, n_rows, k),
+    make_device_matrix_view<IdxT, int64_t>(acc_idx, n_rows, k),
+    select_min);
+}
+
+}  // namespace raft::matrix::detail
@@ -22,6 +22,8 @@
 #include <raft/matrix/detail/gather.cuh>
 #include <raft/util/itertools.hpp>
 
+#include <optional>
+
 namespace raft::matrix {
 
 /**
@@ -289,6 +291,95 @@ void gather_if(const raft::resources& handle,
                     resource::get_cuda_stream(handle));
 }
 
+/**
+ * @brief Gathers rows, converting them to the output type, and optionally subtracts a center from
+ * every output row and computes the squared L2 norms of the output rows, in a single pass.
+ *
+ * This replaces a gather followed by a type conversion, a per-row subtraction (e.g. the residuals
+ * of the IVF-PQ build) and a row norm, each reading the gathered rows again. The rows are read with
+ * vectorized loads (up to 16 bytes) when they are aligned, which pays off for `uint8_t`, `int8_t`
+ * or `half` inputs.
+ *
+ * @code{.cpp}
+ *   // residuals of the sampled rows to their cluster centers, with their norms
+ *   raft::matrix::gather_fused(handle,
+ *                              raft::make_const_mdspan(dataset),
+ *                              raft::make_const_mdspan(sample_ids),
+ *                              residuals.view(),
+ *                              std::make_optional(residual_norms.view()),
+ *                              std::make_optional(raft::make_const_mdspan(centers)),
+ *                              std::make_optional(raft::make_const_mdspan(sample_labels)));
+ * @endcode
+ *
+ * @tparam in_t        Input matrix element type
+ * @tparam out_t       Output matrix element type; the subtraction is done in out_t
+ * @tparam map_t       Integer type of map elements
+ * @tparam idx_t       Integer type used for indexing
+ * @tparam norm_t      Type of the norms, also used to accumulate them
+ * @tparam label_t     Integer type of center labels
+ * @tparam map_xform_t Unary lambda expression or operator type. MapTransformOp's result type must
+ *                     be convertible to idx_t.
+ * @param[in]  handle        raft handle for managing resources
+ * @param[in]  in            Input matrix, dim = [N, D] (row-major)
+ * @param[in]  map           Map of row indices to gather, dim = [map_length]
+ * @param[out] out           Output matrix, dim = [map_length, D] (row-major)
+ * @param[out] norms         (optional) Squared L2 norms of the output rows, dim = [map_length]
+ * @param[in]  centers       (optional) Centers to subtract, dim = [n_centers, D] (row-major)
+ * @param[in]  center_labels (optional, required with centers) Center of each output row,
+ *                           dim = [map_length]
+ * @param[in]  transform_op  (optional) Transformation to apply to map values
+ */
+template <typename in_t,
+          typename out_t,
+          typename map_t,
+          typename idx_t,
+          typename norm_t      = float,
+          typename label_t     = uint32_t,
+          typename map_xform_t = raft::identity_op>
+void gather_fused(
+  const raft::resources& handle,
+  raft::device_matrix_view<const in_t, idx_t, row_major> in,
+  raft::device_vector_view<const map_t, idx_t> map,
+  raft::device_matrix_view<out_t, idx_t, row_major> out,
+  std::optional<raft::device_vector_view<norm_t, idx_t>> norms                = std::nullopt,
+  std::optional<raft::device_matrix_view<const out_t, idx_t>> centers         = std::nullopt,
+  std::optional<raft::device_vector_view<const label_t, idx_t>> center_labels = std::nullopt,
+  map_xform_t transform_op                                                    = raft::identity_op())
+{
+  RAFT_EXPECTS(out.extent(0) == map.extent(0),
+               "Number of rows in output matrix must equal the size of the map vector");
+  RAFT_EXPECTS(out.extent(1) == in.extent(1),
+               "Number of columns in input and output matrices must be equal.");
+  norm_t* norms_ptr = nullptr;
+  if (norms) {
+    RAFT_EXPECTS(norms->extent(0) == map.extent(0),
+                 "Size of the norms must equal the size of the map vector");
+    norms_ptr = norms->data_handle();
+  }
+  const out_t* centers_ptr  = nullptr;
+  const label_t* labels_ptr = nullptr;
+  if (centers) {
+    RAFT_EXPECTS(centers->extent(1) == in.extent(1),
+                 "Number of columns in input and centers matrices must be equal.");
+    RAFT_EXPECTS(center_labels.has_value() && center_labels->extent(0) == map.extent(0),
+                 "A center label is required for every output row");
+    centers_ptr = centers->data_handle();
+    labels_ptr  = center_labels->data_handle();
+  }
+
+  detail::gather_fused(in.data_handle(),
+                       in.extent(1),
+                       in.extent(0),
+                       map.data_handle(),
+                       map.extent(0),
+                       out.data_handle(),
+                       transform_op,
+                       centers_ptr,
+                       labels_ptr,
+                       norms_ptr,
+                       resource::get_cuda_stream(handle));
+}
+
 /** @} */  // end of group matrix_gather
 
 }  // namespace raft::matrix
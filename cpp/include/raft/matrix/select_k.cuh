@@ -106,6 +106,97 @@ void select_k(const resources& handle,
                                    resource::get_cuda_stream(handle));
 }
 
+/**
+ * Select k smallest or largest key/values from each row of variable length in the input data.
+ *
+ * The input is a CSR-like batch of rows: the row `i` spans the range
+ * `[row_offsets(i), row_offsets(i + 1))` of the arrays `in_val` and `in_idx`. The output rows
+ * shorter than `k` are padded with the dummy values: `upper_bound<T>()` when selecting the
+ * minimum, `lower_bound<T>()` otherwise (the indices of the padded elements are undefined).
+ *
+ * Example usage
+ * @code{.cpp}
+ *   using namespace raft;
+ *   // get the values and the row offsets of a CSR-like batch of rows
+ *   auto in_values   = {... input device_vector_view<const float, int64_t> ...}
+ *   auto row_offsets = {... input device_vector_view<const int64_t, int64_t> ...}
+ *   // prepare output arrays
+ *   auto out_extents = make_extents<int64_t>(row_offsets.extent(0) - 1, k);
+ *   auto out_values  = make_device_mdarray<float>(handle, out_extents);
+ *   auto out_indices = make_device_mdarray<int64_t>(handle, out_extents);
+ *   // search `k` smallest values in each row
+ *   matrix::select_k_segmented<float, int64_t>(handle,
+ *                                              in_values,
+ *                                              std::nullopt,
+ *                                              row_offsets,
+ *                                              max_row_length,
+ *                                              out_values.view(),
+ *                                              out_indices.view(),
+ *                                              true);
+ * @endcode
+ *
+ * @tparam T
+ *   the type of the keys (what is being compared).
+ * @tparam IdxT
+ *   the index type (what is being selected together with the keys).
+ *
+ * @param[in] handle
+ * @param[in] in_val
+ *   inputs values [row_offsets(batch_size)];
+ *   these are compared and selected.
+ * @param[in] in_idx
+ *   optional input payload [row_offsets(batch_size)];
+ *   typically, these are indices of the corresponding `in_val`.
+ *   If `in_idx` is `std::nullopt`, the positions of the elements within their rows are implied.
+ * @param[in] row_offsets
+ *   offsets of the rows in the input [batch_size + 1].
+ * @param[in] max_len
+ *   the maximum length of a row.
+ * @param[out] out_val
+ *   output values [batch_size, k];
+ *   the k smallest/largest values from each row of the `in_val`.
+ * @param[out] out_idx
+ *   output payload (e.g. indices) [batch_size, k];
+ *   the payload selected together with `out_val`.
+ * @param[in] select_min
+ *   whether to select k smallest (true) or largest (false) keys.
+ */
+template <typename T, typename IdxT>
+void select_k_segmented(const resources& handle,
+                        raft::device_vector_view<const T, int64_t> in_val,
+                        std::optional<raft::device_vector_view<const IdxT, int64_t>> in_idx,
+                        raft::device_vector_view<const IdxT, int64_t> row_offsets,
+                        int64_t max_len,
+                        raft::device_matrix_view<T, int64_t, row_major> out_val,
+                        raft::device_matrix_view<IdxT, int64_t, row_major> out_idx,
+                        bool select_min)
+{
+  RAFT_EXPECTS(out_val.extent(1) <= int64_t(std::numeric_limits<int>::max()),
+               "output k must fit the int type.");
+  RAFT_EXPECTS(row_offsets.extent(0) > 0, "row_offsets must contain at least one element");
+  auto batch_size = row_offsets.extent(0) - 1;
+  auto k          = int(out_val.extent(1));
+  RAFT_EXPECTS(batch_size == out_val.extent(0), "batch sizes must be equal");
+  RAFT_EXPECTS(batch_size == out_idx.extent(0), "batch sizes must be equal");
+  if (in_idx.has_value()) {
+    RAFT_EXPECTS(in_val.extent(0) == in_idx->extent(0),
+                 "value and index input lengths must be equal");
+  }
+  RAFT_EXPECTS(0 <= max_len && max_len <= in_val.extent(0),
+               "max_len must not exceed the total input length");
+  RAFT_EXPECTS(int64_t(k) == out_idx.extent(1), "value and index output lengths must be equal");
+  return detail::select_k_segmented<T, IdxT>(in_val.data_handle(),
+                                             in_idx.has_value() ? in_idx->data_handle() : nullptr,
+                                             row_offsets.data_handle(),
+                                             batch_size,
+                                             max_len,
+                                             k,
+                                             out_val.data_handle(),
+                                             out_idx.data_handle(),
+                                             select_min,
+                                             resource::get_cuda_stream(handle));
+}
+
 /** @} */  // end of group select_k
 
 }  // namespace raft::matrix
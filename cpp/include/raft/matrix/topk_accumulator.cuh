@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/matrix/detail/topk_accumulator.cuh>
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/error.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/matrix/init.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <limits>
+#include <optional>
+
+namespace raft::matrix {
+
+/**
+ * @defgroup topk_accumulator Streaming top-k accumulator
+ * @{
+ */
+
+/**
+ * A running per-row top-k, which accepts the candidates tile by tile.
+ *
+ * It replaces the pattern of selecting the top-k of every tile, concatenating the partial results
+ * and selecting again: each tile is merged into the running top-k with a fused kernel, reading the
+ * tile exactly once.
+ *
+ * Until a row has seen at least `k` candidates, the rest of its slots keep the dummy values:
+ * `upper_bound<T>()` when selecting the minimum, `lower_bound<T>()` otherwise, with the indices
+ * set to `IdxT(-1)`.
+ *
+ * Example usage
+ * @code{.cpp}
+ *   using namespace raft;
+ *   matrix::topk_accumulator<float, int64_t> acc(handle, n_queries, k, true);
+ *   for (int64_t j = 0; j < n_dataset; j += tile_size) {
+ *     auto dists = {... compute a device_matrix_view<const float, int64_t> [n_queries, tile] ...}
+ *     // the column `c` of the tile gets the index `j + c`
+ *     acc.add(handle, dists, std::nullopt, j);
+ *   }
+ *   auto neighbors = acc.indices();
+ *   auto distances = acc.values();
+ * @endcode
+ *
+ * @tparam T
+ *   the type of the keys (what is being compared).
+ * @tparam IdxT
+ *   the index type (what is being selected together with the keys).
+ */
+template <typename T, typename IdxT>
+class topk_accumulator {
+ public:
+  /**
+   * Construct an empty accumulator.
+   *
+   * @param[in] res
+   * @param[in] n_rows the number of rows (e.g. queries)
+   * @param[in] k the number of elements to keep per row
+   * @param[in] select_min whether to keep k smallest (true) or largest (false) keys
+   */
+  topk_accumulator(raft::resources const& res, int64_t n_rows, int k, bool select_min)
+    : select_min_(select_min),
+      values_(make_device_matrix<T, int64_t>(res, n_rows, k)),
+      indices_(make_device_matrix<IdxT, int64_t>(res, n_rows, k))
+  {
+    RAFT_EXPECTS(k > 0, "k must be positive");
+    reset(res);
+  }
+
+  /** Drop all accumulated elements. */
+  void reset(raft::resources const& res)
+  {
+    matrix::fill(res, values_.view(), select_min_ ? upper_bound<T>() : lower_bound<T>());
+    matrix::fill(res, indices_.view(), static_cast<IdxT>(-1));
+  }
+
+  /**
+   * Merge a tile of candidates into the running top-k.
+   *
+   * @param[in] res
+   * @param[in] tile_val the candidate keys [tile_rows, tile_len]; the row `r` of the tile is merged
+   *   into the row `row_offset + r` of the accumulator.
+   * @param[in] tile_idx the optional payload of the candidates [tile_rows, tile_len]; when
+   *   `std::nullopt`, the position of a candidate in its row is implied.
+   * @param[in] idx_offset the value added to the payload of the candidates (e.g. the position of
+   *   the tile in the dataset).
+   * @param[in] row_offset the first row of the accumulator the tile corresponds to.
+   */
+  void add(raft::resources const& res,
+           raft::device_matrix_view<const T, int64_t, row_major> tile_val,
+           std::optional<raft::device_matrix_view<const IdxT, int64_t, row_major>> tile_idx =
+             std::nullopt,
+           IdxT idx_offset    = 0,
+           int64_t row_offset = 0)
+  {
+    auto tile_rows = tile_val.extent(0);
+    RAFT_EXPECTS(row_offset >= 0 && row_offset + tile_rows <= n_rows(),
+                 "The tile rows are out of the accumulator bounds");
+    if (tile_idx.has_value()) {
+      RAFT_EXPECTS(tile_idx->extent(0) == tile_rows && tile_idx->extent(1) == tile_val.extent(1),
+                   "The tile values and indices must have the same shape");
+    }
+    detail::topk_accumulate<T, IdxT>(res,
+                                     values_.data_handle() + row_offset * k(),
+                                     indices_.data_handle() + row_offset * k(),
+                                     tile_rows,
+                                     k(),
+                                     select_min_,
+                                     tile_val.data_handle(),
+                                     tile_idx.has_value() ? tile_idx->data_handle() : nullptr,
+                                     tile_val.extent(1),
+                                     idx_offset);
+  }
+
+  /** The number of rows. */
+  [[nodiscard]] auto n_rows() const noexcept -> int64_t { return values_.extent(0); }
+  /** The number of elements kept per row. */
+  [[nodiscard]] auto k() const noexcept -> int { return int(values_.extent(1)); }
+  /** Whether the smallest (true) or largest (false) keys are kept. */
+  [[nodiscard]] auto select_min() const noexcept -> bool { return select_min_; }
+
+  /** The running top-k keys [n_rows, k] (the order within a row is not specified). */
+  [[nodiscard]] auto values() const noexcept
+    -> raft::device_matrix_view<const T, int64_t, row_major>
+  {
+    return values_.view();
+  }
+  /** The payload of the running top-k [n_rows, k]. */
+  [[nodiscard]] auto indices() const noexcept
+    -> raft::device_matrix_view<const IdxT, int64_t, row_major>
+  {
+    return indices_.view();
+  }
+
+ private:
+  bool select_min_;
+  raft::device_matrix<T, int64_t, row_major> values_;
+  raft::device_matrix<IdxT, int64_t, row_major> indices_;
+};
+
+/** @} */  // end of group topk_accumulator
+
+}  // namespace raft::matrix
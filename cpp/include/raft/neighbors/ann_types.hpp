@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <raft/core/deadline.hpp>
 #include <raft/distance/distance_types.hpp>
 
 namespace raft::neighbors::ann {
@@ -45,7 +46,15 @@ struct index_params {
   bool add_data_on_build = true;
 };
 
-struct search_params {};
+/** The base for KNN search parameters. */
+struct search_params {
+  /**
+   * The time budget of the search (none by default). Once it expires, the search returns the best
+   * results found so far instead of the exact output of the other parameters: see the search
+   * function of the index for how it cuts the work short.
+   */
+  raft::deadline deadline;
+};
 
 /** @} */  // end group ann_types
 
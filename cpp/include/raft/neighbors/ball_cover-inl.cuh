@@ -36,6 +36,12 @@ namespace raft::neighbors::ball_cover {
 /**
  * Builds and populates a previously unbuilt BallCoverIndex
  *
+ * The Haversine distance supports 2d data; the L2 (squared or not, expanded or not), cosine and
+ * inner product distances support any dimensionality. The 2d and 3d Euclidean (L2Sqrt) indexes are
+ * served by the register-resident kernels, all the others - by the tiled GEMM and top-k selection.
+ * NB: the inner product is not a metric; its balls are pruned by the Cauchy-Schwarz bound instead
+ * of the triangle inequality.
+ *
  * Usage example:
  * @code{.cpp}
  *
@@ -63,12 +69,10 @@ template <typename idx_t, typename value_t, typename int_t, typename matrix_idx_
 void build_index(raft::resources const& handle,
                  BallCoverIndex<idx_t, value_t, int_t, matrix_idx_t>& index)
 {
-  ASSERT(index.n <= 3, "only 2d and 3d vectors are supported in current implementation");
   if (index.metric == raft::distance::DistanceType::Haversine) {
     raft::spatial::knn::detail::rbc_build_index(
       handle, index, spatial::knn::detail::HaversineFunc<value_t, int_t>());
-  } else if (index.metric == raft::distance::DistanceType::L2SqrtExpanded ||
-             index.metric == raft::distance::DistanceType::L2SqrtUnexpanded) {
+  } else if (spatial::knn::detail::is_rbc_gemm_metric(index.metric)) {
     raft::spatial::knn::detail::rbc_build_index(
       handle, index, spatial::knn::detail::EuclideanFunc<value_t, int_t>());
   } else {
@@ -78,6 +82,43 @@ void build_index(raft::resources const& handle,
   index.set_index_trained();
 }
 
+/**
+ * Extends a previously built BallCoverIndex with new points without rebuilding it.
+ *
+ * The index does not own the points, so the caller passes the whole extended dataset: its
+ * first `index.m` rows must be the points already in the index, followed by the new ones. The
+ * landmarks are kept and only the new points are assigned to them; the balls get unbalanced as
+ * the index grows, so rebuilding is recommended after it grows by a large factor.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *
+ *  ball_cover::build_index(handle, index);
+ *  ...
+ *  // X_ext holds the rows of X followed by the new rows
+ *  ball_cover::extend(handle, index, X_ext);
+ * @endcode
+ *
+ * @tparam idx_t knn index type
+ * @tparam value_t knn value type
+ * @tparam int_t integral type for knn params
+ * @tparam matrix_idx_t matrix indexing type
+ * @param[in] handle library resource management handle
+ * @param[inout] index a built instance of BallCoverIndex
+ * @param[in] X the extended dataset; it must outlive the index
+ */
+template <typename idx_t, typename value_t, typename int_t, typename matrix_idx_t>
+void extend(raft::resources const& handle,
+            BallCoverIndex<idx_t, value_t, int_t, matrix_idx_t>& index,
+            raft::device_matrix_view<const value_t, matrix_idx_t, row_major> X)
+{
+  RAFT_EXPECTS(index.is_index_trained(), "The index must be built before it is extended");
+  RAFT_EXPECTS(X.extent(1) == index.n, "The extended dataset must have the index dimensionality");
+  RAFT_EXPECTS(X.extent(0) >= index.m, "The extended dataset must contain the points of the index");
+  raft::spatial::knn::detail::rbc_extend_index(
+    handle, index, X.data_handle(), static_cast<int_t>(X.extent(0)));
+}
+
 /** @} */  // end group random_ball_cover
 
 /**
@@ -117,7 +158,6 @@ void all_knn_query(raft::resources const& handle,
                    bool perform_post_filtering = true,
                    float weight                = 1.0)
 {
-  ASSERT(index.n <= 3, "only 2d and 3d vectors are supported in current implementation");
   if (index.metric == raft::distance::DistanceType::Haversine) {
     raft::spatial::knn::detail::rbc_all_knn_query(
       handle,
@@ -128,8 +168,7 @@ void all_knn_query(raft::resources const& handle,
       spatial::knn::detail::HaversineFunc<value_t, int_t>(),
       perform_post_filtering,
       weight);
-  } else if (index.metric == raft::distance::DistanceType::L2SqrtExpanded ||
-             index.metric == raft::distance::DistanceType::L2SqrtUnexpanded) {
+  } else if (spatial::knn::detail::is_rbc_gemm_metric(index.metric)) {
     raft::spatial::knn::detail::rbc_all_knn_query(
       handle,
       index,
@@ -210,7 +249,6 @@ void all_knn_query(raft::resources const& handle,
                    bool perform_post_filtering = true,
                    float weight                = 1.0)
 {
-  RAFT_EXPECTS(index.n <= 3, "only 2d and 3d vectors are supported in current implementation");
   RAFT_EXPECTS(k <= index.m,
                "k must be less than or equal to the number of data points in the index");
   RAFT_EXPECTS(inds.extent(1) == dists.extent(1) && dists.extent(1) == static_cast<matrix_idx_t>(k),
@@ -266,7 +304,6 @@ void knn_query(raft::resources const& handle,
                bool perform_post_filtering = true,
                float weight                = 1.0)
 {
-  ASSERT(index.n <= 3, "only 2d and 3d vectors are supported in current implementation");
   if (index.metric == raft::distance::DistanceType::Haversine) {
     raft::spatial::knn::detail::rbc_knn_query(handle,
                                               index,
@@ -278,8 +315,7 @@ void knn_query(raft::resources const& handle,
                                               spatial::knn::detail::HaversineFunc<value_t, int_t>(),
                                               perform_post_filtering,
                                               weight);
-  } else if (index.metric == raft::distance::DistanceType::L2SqrtExpanded ||
-             index.metric == raft::distance::DistanceType::L2SqrtUnexpanded) {
+  } else if (spatial::knn::detail::is_rbc_gemm_metric(index.metric)) {
     raft::spatial::knn::detail::rbc_knn_query(handle,
                                               index,
                                               k,
@@ -139,6 +139,20 @@ class BallCoverIndex {
   // This should only be set by internal functions
   void set_index_trained() { index_trained = true; }
 
+  /**
+   * Point the index to a dataset extended with new rows and reallocate the storage of the
+   * neighborhoods for it; the landmarks are kept. This should only be called by internal
+   * functions, which rebuild the neighborhoods right after.
+   */
+  void reset_X(raft::device_matrix_view<const value_t, matrix_idx, row_major> X_)
+  {
+    X                        = X_;
+    m                        = X_.extent(0);
+    R_1nn_cols               = raft::make_device_vector<value_idx, matrix_idx>(handle, m);
+    R_1nn_dists              = raft::make_device_vector<value_t, matrix_idx>(handle, m);
+    R_closest_landmark_dists = raft::make_device_vector<value_t, matrix_idx>(handle, m);
+  }
+
   raft::resources const& handle;
 
   value_int m;
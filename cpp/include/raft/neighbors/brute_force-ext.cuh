@@ -18,11 +18,13 @@
 
 #include <optional>
 
-#include <raft/core/device_mdspan.hpp>       // raft::device_matrix_view
-#include <raft/core/operators.hpp>           // raft::identity_op
-#include <raft/core/resources.hpp>           // raft::resources
-#include <raft/distance/distance_types.hpp>  // raft::distance::DistanceType
-#include <raft/util/raft_explicit.hpp>       // RAFT_EXPLICIT
+#include <raft/core/device_csr_matrix.hpp>       // raft::device_csr_matrix
+#include <raft/core/device_mdspan.hpp>           // raft::device_matrix_view
+#include <raft/core/operators.hpp>               // raft::identity_op
+#include <raft/core/resources.hpp>               // raft::resources
+#include <raft/distance/distance_types.hpp>      // raft::distance::DistanceType
+#include <raft/neighbors/brute_force_types.hpp>  // raft::neighbors::brute_force::index
+#include <raft/util/raft_explicit.hpp>           // RAFT_EXPLICIT
 
 #ifdef RAFT_EXPLICIT_INSTANTIATE_ONLY
 
@@ -62,6 +64,35 @@ void fused_l2_knn(raft::resources const& handle,
                   raft::device_matrix_view<value_t, idx_t, row_major> out_dists,
                   raft::distance::DistanceType metric) RAFT_EXPLICIT;
 
+template <typename T>
+auto build(raft::resources const& res,
+           raft::device_matrix_view<const T, int64_t, row_major> dataset,
+           raft::distance::DistanceType metric = distance::DistanceType::L2Unexpanded,
+           T metric_arg                        = 0.0) -> index<T> RAFT_EXPLICIT;
+
+template <typename T, typename IdxT>
+void search(raft::resources const& res,
+            const index<T>& idx,
+            raft::device_matrix_view<const T, int64_t, row_major> queries,
+            raft::device_matrix_view<IdxT, int64_t, row_major> neighbors,
+            raft::device_matrix_view<T, int64_t, row_major> distances) RAFT_EXPLICIT;
+
+template <typename T, typename IdxT>
+void search_with_filtering(raft::resources const& res,
+                           const index<T>& idx,
+                           raft::device_matrix_view<const T, int64_t, row_major> queries,
+                           raft::device_matrix_view<IdxT, int64_t, row_major> neighbors,
+                           raft::device_matrix_view<T, int64_t, row_major> distances,
+                           raft::device_vector_view<const uint32_t, int64_t> filter_bitset)
+  RAFT_EXPLICIT;
+
+template <typename T, typename IdxT>
+void range_search(raft::resources const& res,
+                  const index<T>& idx,
+                  raft::device_matrix_view<const T, int64_t, row_major> queries,
+                  T radius,
+                  raft::device_csr_matrix<T, int64_t, IdxT, int64_t>& out) RAFT_EXPLICIT;
+
 }  // namespace raft::neighbors::brute_force
 
 #endif  // RAFT_EXPLICIT_INSTANTIATE_ONLY
@@ -109,3 +140,37 @@ instantiate_raft_neighbors_brute_force_fused_l2_knn(float,
                                                     raft::row_major)
 
 #undef instantiate_raft_neighbors_brute_force_fused_l2_knn
+
+#define instantiate_raft_neighbors_brute_force_build_search(T, IdxT)                 \
+  extern template auto raft::neighbors::brute_force::build<T>(                       \
+    raft::resources const& res,                                                      \
+    raft::device_matrix_view<const T, int64_t, row_major> dataset,                   \
+    raft::distance::DistanceType metric,                                             \
+    T metric_arg)                                                                    \
+    ->raft::neighbors::brute_force::index<T>;                                        \
+                                                                                     \
+  extern template void raft::neighbors::brute_force::search<T, IdxT>(                \
+    raft::resources const& res,                                                      \
+    const raft::neighbors::brute_force::index<T>& idx,                               \
+    raft::device_matrix_view<const T, int64_t, row_major> queries,                   \
+    raft::device_matrix_view<IdxT, int64_t, row_major> neighbors,                    \
+    raft::device_matrix_view<T, int64_t, row_major> distances);                      \
+                                                                                     \
+  extern template void raft::neighbors::brute_force::search_with_filtering<T, IdxT>( \
+    raft::resources const& res,                                                      \
+    const raft::neighbors::brute_force::index<T>& idx,                               \
+    raft::device_matrix_view<const T, int64_t, row_major> queries,                   \
+    raft::device_matrix_view<IdxT, int64_t, row_major> neighbors,                    \
+    raft::device_matrix_view<T, int64_t, row_major> distances,                       \
+    raft::device_vector_view<const uint32_t, int64_t> filter_bitset);                \
+                                                                                     \
+  extern template void raft::neighbors::brute_force::range_search<T, IdxT>(          \
+    raft::resources const& res,                                                      \
+    const raft::neighbors::brute_force::index<T>& idx,                               \
+    raft::device_matrix_view<const T, int64_t, row_major> queries,                   \
+    T radius,                                                                        \
+    raft::device_csr_matrix<T, int64_t, IdxT, int64_t>& out);
+
+instantiate_raft_neighbors_brute_force_build_search(float, int64_t);
+
+#undef instantiate_raft_neighbors_brute_force_build_search
@@ -16,9 +16,11 @@
 
 #pragma once
 
+#include <raft/core/device_csr_matrix.hpp>
 #include <raft/core/device_mdspan.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/distance/distance_types.hpp>
+#include <raft/neighbors/brute_force_types.hpp>
 #include <raft/neighbors/detail/knn_brute_force.cuh>
 #include <raft/spatial/knn/detail/fused_l2_knn.cuh>
 
@@ -276,6 +278,205 @@ void fused_l2_knn(raft::resources const& handle,
                                          metric);
 }
 
+/**
+ * @brief Build the brute-force index from the dataset for efficient search.
+ *
+ * The index keeps a view of the dataset (which must outlive the index) and precomputes the data
+ * needed by every search, such as the dataset row norms for the L2 expanded and cosine metrics.
+ * This amortizes the cost of preparing the dataset when the same dataset is searched many times
+ * (e.g. with many small batches of queries).
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors;
+ *   // create and fill the index from a [N, D] dataset
+ *   auto index = brute_force::build(handle, dataset, raft::distance::DistanceType::L2Expanded);
+ *   // search K nearest neighbours for each of the N queries
+ *   brute_force::search(handle, index, queries, out_inds, out_dists);
+ * @endcode
+ *
+ * @tparam T data element type
+ *
+ * @param[in] res
+ * @param[in] dataset a matrix view (device) to a row-major matrix [n_rows, dim]
+ * @param[in] metric distance metric to use. Euclidean (L2) is used by default
+ * @param[in] metric_arg the value of `p` for Minkowski (l-p) distances. This
+ *   is ignored if the metric_type is not Minkowski.
+ *
+ * @return the constructed brute-force index
+ */
+template <typename T>
+auto build(raft::resources const& res,
+           raft::device_matrix_view<const T, int64_t, row_major> dataset,
+           raft::distance::DistanceType metric = distance::DistanceType::L2Unexpanded,
+           T metric_arg                        = 0.0) -> index<T>
+{
+  return detail::build(res, dataset, metric, metric_arg);
+}
+
+/**
+ * @brief Search the brute-force index for the k-nearest neighbors of the queries.
+ *
+ * See the `brute_force::build` documentation for a usage example.
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] res
+ * @param[in] idx brute-force index
+ * @param[in] queries a device matrix view to a row-major matrix [n_queries, index->dim()]
+ * @param[out] neighbors a device matrix view to the indices of the neighbors in the source dataset
+ *   [n_queries, k]
+ * @param[out] distances a device matrix view to the distances to the selected neighbors
+ *   [n_queries, k]
+ */
+template <typename T, typename IdxT>
+void search(raft::resources const& res,
+            const index<T>& idx,
+            raft::device_matrix_view<const T, int64_t, row_major> queries,
+            raft::device_matrix_view<IdxT, int64_t, row_major> neighbors,
+            raft::device_matrix_view<T, int64_t, row_major> distances)
+{
+  detail::brute_force_search<T, IdxT>(res, idx, queries, neighbors, distances);
+}
+
+/**
+ * @brief Search the brute-force index for the k-nearest neighbors of the queries among the dataset
+ * rows allowed by a bitset filter.
+ *
+ * The row `i` of the dataset is a candidate if the bit `i % 32` of `filter_bitset[i / 32]` is set
+ * (see `raft::neighbors::filtering::bitset_filter`); the filter is the same for all queries. The
+ * allowed rows need not be copied out of the dataset beforehand:
+ *   - when most of the rows are allowed, the distances to the rejected rows are masked (replaced
+ *     by the worst possible value) before the top-k selection;
+ *   - when few rows are allowed, only their distances are computed: their ids are compacted and
+ *     the rows are gathered in bounded chunks.
+ *
+ * When fewer than k rows are allowed, the tails of the results are padded with the indices `-1`
+ * and the worst distances.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors;
+ *   auto index = brute_force::build(handle, dataset, raft::distance::DistanceType::L2Expanded);
+ *   // one bit per dataset row
+ *   auto bitset = raft::make_device_vector<uint32_t, int64_t>(handle, (n_rows + 31) / 32);
+ *   ... set the bits of the allowed rows ...
+ *   brute_force::search_with_filtering(
+ *     handle, index, queries, out_inds, out_dists, raft::make_const_mdspan(bitset.view()));
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] res
+ * @param[in] idx brute-force index
+ * @param[in] queries a device matrix view to a row-major matrix [n_queries, index->dim()]
+ * @param[out] neighbors a device matrix view to the indices of the neighbors in the source dataset
+ *   [n_queries, k]
+ * @param[out] distances a device matrix view to the distances to the selected neighbors
+ *   [n_queries, k]
+ * @param[in] filter_bitset a device vector view to the bitset of the allowed dataset rows
+ *   [ceildiv(index->size(), 32)]
+ */
+template <typename T, typename IdxT>
+void search_with_filtering(raft::resources const& res,
+                           const index<T>& idx,
+                           raft::device_matrix_view<const T, int64_t, row_major> queries,
+                           raft::device_matrix_view<IdxT, int64_t, row_major> neighbors,
+                           raft::device_matrix_view<T, int64_t, row_major> distances,
+                           raft::device_vector_view<const uint32_t, int64_t> filter_bitset)
+{
+  detail::brute_force_search_filtered<T, IdxT>(
+    res, idx, queries, neighbors, distances, filter_bitset);
+}
+
+/**
+ * @brief Find all the neighbors of the queries within a radius (range search).
+ *
+ * Unlike `search`, the number of neighbors varies per query, hence they are returned as a CSR
+ * matrix [n_queries, idx.size()]: the row `i` holds the dataset indices of the neighbors of the
+ * query `i` and the distances to them, in no particular order. The pairwise distances are computed
+ * tile by tile twice: the first pass counts the neighbors of every query to size the output, the
+ * second one writes them.
+ *
+ * A dataset row is a neighbor of a query if its distance is not greater than `radius` (not less
+ * than `radius` for the similarity metrics, e.g. the inner product). The radius is in the units of
+ * the index metric, e.g. it is the squared distance for `L2Expanded`.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors;
+ *   auto index = brute_force::build(handle, dataset, raft::distance::DistanceType::L2Expanded);
+ *   auto out = raft::make_device_csr_matrix<float, int64_t, int64_t, int64_t>(
+ *     handle, queries.extent(0), index.size());
+ *   brute_force::range_search(handle, index, queries, 0.5f, out);
+ *   auto neighbors = out.structure_view();  // get_indptr(), get_indices()
+ *   auto distances = out.get_elements();
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] res
+ * @param[in] idx brute-force index
+ * @param[in] queries a device matrix view to a row-major matrix [n_queries, index->dim()]
+ * @param[in] radius the maximum distance (the minimum similarity) of the neighbors
+ * @param[out] out a CSR matrix [n_queries, idx.size()] with the sparsity to be initialized; its
+ *   sparsity is initialized with the total number of the neighbors found
+ */
+template <typename T, typename IdxT>
+void range_search(raft::resources const& res,
+                  const index<T>& idx,
+                  raft::device_matrix_view<const T, int64_t, row_major> queries,
+                  T radius,
+                  raft::device_csr_matrix<T, int64_t, IdxT, int64_t>& out)
+{
+  detail::brute_force_range_search<T, IdxT>(res, idx, queries, radius, out);
+}
+
+/**
+ * @brief Search the k-nearest neighbors in a dataset sharded across multiple GPUs.
+ *
+ * Every rank of the communicator attached to the handle holds a brute-force index over its own
+ * shard of the dataset and passes the same queries. Every rank searches its shard (see
+ * `brute_force::search`), then the partial top-k results are exchanged via `allgather` and merged
+ * on device; as a result, every rank gets the exact k-nearest neighbors over the whole dataset.
+ * The neighbor indices are global: the rows of the shard of rank `r` are numbered after all
+ * rows of the ranks `0..r-1`.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   raft::resources handle;  // with a communicator injected, e.g. via raft-dask or std_comms
+ *   // every rank builds the index over its local shard
+ *   auto index = brute_force::build(handle, local_dataset, metric);
+ *   // every rank gets the same (global) results
+ *   brute_force::search_mg(handle, index, queries, out_inds, out_dists);
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] handle a handle with an initialized communicator
+ * @param[in] local_index brute-force index over the local shard (at least k rows); the metric
+ *   must be the same on all ranks
+ * @param[in] queries a device matrix view to a row-major matrix [n_queries, index->dim()]; must
+ *   be the same on all ranks
+ * @param[out] neighbors a device matrix view to the global indices of the neighbors
+ *   [n_queries, k]
+ * @param[out] distances a device matrix view to the distances to the selected neighbors
+ *   [n_queries, k]
+ */
+template <typename T, typename IdxT>
+void search_mg(raft::resources const& handle,
+               const index<T>& local_index,
+               raft::device_matrix_view<const T, int64_t, row_major> queries,
+               raft::device_matrix_view<IdxT, int64_t, row_major> neighbors,
+               raft::device_matrix_view<T, int64_t, row_major> distances)
+{
+  detail::brute_force_search_mg<T, IdxT>(handle, local_index, queries, neighbors, distances);
+}
+
 /** @} */  // end group brute_force_knn
 
 }  // namespace raft::neighbors::brute_force
@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "ann_types.hpp"
+#include "detail/faiss_select/DistanceUtils.h"
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/error.hpp>
+#include <raft/core/memory_estimate.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/distance_types.hpp>
+
+#include <algorithm>
+#include <optional>
+
+namespace raft::neighbors::brute_force {
+/**
+ * @ingroup brute_force_knn
+ * @{
+ */
+
+/**
+ * @brief Brute-force index: a (non-owning) view of the dataset plus the data precomputed once
+ * for all searches.
+ *
+ * For the L2Expanded/L2SqrtExpanded metrics the index caches the squared L2 norms of the dataset
+ * rows, and for CosineExpanded - the L2 norms; thus, the search only computes the query norms and
+ * the distances themselves.
+ *
+ * NB: the index does not own the dataset; the dataset must outlive the index.
+ *
+ * @tparam T data element type
+ */
+template <typename T>
+struct index : ann::index {
+ public:
+  /** Distance metric used for the search. */
+  [[nodiscard]] constexpr inline auto metric() const noexcept -> raft::distance::DistanceType
+  {
+    return metric_;
+  }
+  /** Metric argument (e.g. `p` of the Minkowski distance). */
+  [[nodiscard]] constexpr inline auto metric_arg() const noexcept -> T { return metric_arg_; }
+  /** Total length of the index (number of vectors). */
+  [[nodiscard]] constexpr inline auto size() const noexcept -> int64_t
+  {
+    return dataset_view_.extent(0);
+  }
+  /** Dimensionality of the data. */
+  [[nodiscard]] constexpr inline auto dim() const noexcept -> uint32_t
+  {
+    return dataset_view_.extent(1);
+  }
+  /** Dataset [size, dim] */
+  [[nodiscard]] inline auto dataset() const noexcept
+    -> device_matrix_view<const T, int64_t, row_major>
+  {
+    return dataset_view_;
+  }
+  /** Whether the dataset norms are precomputed. */
+  [[nodiscard]] inline auto has_norms() const noexcept -> bool { return norms_.has_value(); }
+  /** Precomputed dataset norms [size] (see the class description). */
+  [[nodiscard]] inline auto norms() const -> device_vector_view<const T, int64_t>
+  {
+    RAFT_EXPECTS(has_norms(), "The norms are not computed for this index (metric %d)", metric_);
+    return norms_->view();
+  }
+
+  // Don't allow copying the index for performance reasons (try avoiding copying data)
+  index(const index&)                    = delete;
+  index(index&&)                         = default;
+  auto operator=(const index&) -> index& = delete;
+  auto operator=(index&&) -> index&      = default;
+  ~index()                               = default;
+
+  /** Construct a brute-force index from the dataset and (optionally) its precomputed norms. */
+  index(raft::resources const& res,
+        raft::device_matrix_view<const T, int64_t, row_major> dataset_view,
+        std::optional<raft::device_vector<T, int64_t>>&& norms,
+        raft::distance::DistanceType metric,
+        T metric_arg = 0.0)
+    : ann::index(),
+      metric_(metric),
+      metric_arg_(metric_arg),
+      dataset_view_(dataset_view),
+      norms_(std::move(norms))
+  {
+    RAFT_EXPECTS(!norms_.has_value() || norms_->extent(0) == dataset_view.extent(0),
+                 "The number of norms must be equal to the number of dataset rows");
+  }
+
+ private:
+  raft::distance::DistanceType metric_;
+  T metric_arg_;
+  raft::device_matrix_view<const T, int64_t, row_major> dataset_view_;
+  std::optional<raft::device_vector<T, int64_t>> norms_;
+};
+
+/**
+ * @brief Estimate the device memory of `brute_force::knn` and `brute_force::search`.
+ *
+ * The estimate follows the tiling of the distance computation (`chooseTileSize`, for the total
+ * size of the workspace resource of `res`): the distance tile, the norms of the queries and of the
+ * index rows (for the expanded L2 and the cosine metrics) and the running top-k of a tile of
+ * queries when the index rows are tiled too. The fused kernels used for some metrics and small
+ * `k` need less memory, so the estimate is an upper bound for them.
+ *
+ * @code{.cpp}
+ *   auto est = raft::neighbors::brute_force::estimate_knn_memory<float, int64_t>(
+ *     res, n_rows, n_queries, dim, k, raft::distance::DistanceType::L2Expanded);
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ * @param[in] res raft resources
+ * @param[in] n_index_rows the number of the index (dataset) vectors
+ * @param[in] n_queries the number of the queries
+ * @param[in] dim the dimensionality of the data
+ * @param[in] k the number of the neighbors to find for each query
+ * @param[in] metric the distance metric
+ * @param[in] has_index_norms whether the norms of the index rows are precomputed (see `index`)
+ * @return the estimated memory, in bytes
+ */
+template <typename T, typename IdxT = int64_t>
+auto estimate_knn_memory(raft::resources const& res,
+                         size_t n_index_rows,
+                         size_t n_queries,
+                         size_t dim,
+                         size_t k,
+                         raft::distance::DistanceType metric,
+                         bool has_index_norms = false) -> raft::memory_estimate
+{
+  size_t tile_rows = 0;
+  size_t tile_cols = 0;
+  raft::neighbors::detail::faiss_select::chooseTileSize(n_queries,
+                                                        n_index_rows,
+                                                        dim,
+                                                        sizeof(T),
+                                                        resource::get_workspace_total_bytes(res),
+                                                        tile_rows,
+                                                        tile_cols);
+  tile_cols = std::max(tile_cols, k);
+
+  raft::memory_estimate estimate;
+  estimate.device_workspace = tile_rows * tile_cols * sizeof(T);
+  if (metric == raft::distance::DistanceType::L2Expanded ||
+      metric == raft::distance::DistanceType::L2SqrtExpanded ||
+      metric == raft::distance::DistanceType::CosineExpanded) {
+    estimate.device_workspace += (n_queries + (has_index_norms ? 0 : n_index_rows)) * sizeof(T);
+  }
+  if (tile_cols != n_index_rows) {
+    estimate.device_workspace += tile_rows * k * (sizeof(T) + sizeof(IdxT));
+  }
+  return estimate;
+}
+
+/** @} */
+
+}  // namespace raft::neighbors::brute_force
@@ -17,14 +17,25 @@
 #pragma once
 
 #include "detail/cagra/cagra_build.cuh"
+#include "detail/cagra/cagra_extend.cuh"
 #include "detail/cagra/cagra_search.cuh"
+#include "detail/cagra/cagra_sharded.cuh"
+#include "detail/cagra/cagra_tune.cuh"
+#include "detail/cagra/compressed_dataset.cuh"
+#include "detail/cagra/entry_points.cuh"
 #include "detail/cagra/graph_core.cuh"
+#include "detail/ragged_search.cuh"
 
 #include <raft/core/device_mdspan.hpp>
 #include <raft/core/host_device_accessor.hpp>
+#include <raft/core/memory_estimate.hpp>
 #include <raft/core/mdspan.hpp>
+#include <raft/core/metrics.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/neighbors/cagra_types.hpp>
+#include <raft/neighbors/nn_descent.cuh>
+#include <raft/neighbors/sample_filter_types.hpp>
 #include <rmm/cuda_stream_view.hpp>
 
 namespace raft::neighbors::experimental::cagra {
@@ -45,6 +56,10 @@ namespace raft::neighbors::experimental::cagra {
  *
  * See [cagra::build](#cagra::build) for an alternative method.
  *
+ * A dataset in the host memory is copied to the device in batches, unless the device reads the
+ * host memory through the host page tables (e.g. on Grace-Hopper): then the kernels read the
+ * dataset in place, and the graph is refined on the device.
+ *
  * The following distance metrics are supported:
  * - L2Expanded
  *
@@ -197,6 +212,9 @@ void prune(raft::resources const& res,
  * graphs.
  *
  * It is required that dataset and the pruned graph fit the GPU memory.
+ * Setting `index_params::n_shards > 1` bounds the device memory used while building the
+ * intermediate knn-graph, which allows building the graph of a host dataset that does not fit the
+ * GPU memory.
  *
  * To customize the parameters for knn-graph building and pruning, and to reuse the
  * intermediate results, you could build the index in two steps using
@@ -254,25 +272,160 @@ index<T, IdxT> build(raft::resources const& res,
     graph_degree = intermediate_degree;
   }
 
+  auto stream = resource::get_cuda_stream(res);
+  std::optional<raft::metrics::phase> phase;
+  phase.emplace("cagra::build::knn_graph", stream);
   auto knn_graph = raft::make_host_matrix<IdxT, IdxT>(dataset.extent(0), intermediate_degree);
 
-  build_knn_graph(res, dataset, knn_graph.view());
+  if (params.n_shards > 1) {
+    using internal_IdxT     = typename std::make_unsigned<IdxT>::type;
+    auto knn_graph_internal = make_host_matrix_view<internal_IdxT, internal_IdxT>(
+      reinterpret_cast<internal_IdxT*>(knn_graph.data_handle()),
+      knn_graph.extent(0),
+      knn_graph.extent(1));
+    auto dataset_internal = mdspan<const T, matrix_extent<internal_IdxT>, row_major, Accessor>(
+      dataset.data_handle(), dataset.extent(0), dataset.extent(1));
+    detail::build_knn_graph_sharded(res,
+                                    dataset_internal,
+                                    knn_graph_internal,
+                                    static_cast<uint32_t>(params.n_shards),
+                                    static_cast<uint32_t>(params.shard_overlap));
+  } else if (params.build_algo == graph_build_algo::NN_DESCENT) {
+    nn_descent::index_params nn_descent_params;
+    nn_descent_params.metric                    = params.metric;
+    nn_descent_params.graph_degree              = intermediate_degree;
+    nn_descent_params.intermediate_graph_degree = 1.5 * intermediate_degree;
+    nn_descent_params.max_iterations            = params.nn_descent_niter;
+    // the nn-descent index writes the graph directly into `knn_graph`
+    nn_descent::index<IdxT> nn_descent_idx{
+      res,
+      make_host_matrix_view<IdxT, int64_t>(
+        knn_graph.data_handle(), knn_graph.extent(0), knn_graph.extent(1))};
+    nn_descent::build<T, IdxT>(
+      res,
+      nn_descent_params,
+      mdspan<const T, matrix_extent<int64_t>, row_major, Accessor>(
+        dataset.data_handle(), dataset.extent(0), dataset.extent(1)),
+      nn_descent_idx);
+  } else {
+    build_knn_graph(res, dataset, knn_graph.view());
+  }
 
+  phase.emplace("cagra::build::optimize", stream);
   auto cagra_graph = raft::make_host_matrix<IdxT, IdxT>(dataset.extent(0), graph_degree);
 
   prune<IdxT>(res, knn_graph.view(), cagra_graph.view());
 
   // Construct an index from dataset and pruned knn graph.
-  return index<T, IdxT>(res, params.metric, dataset, cagra_graph.view());
+  phase.emplace("cagra::build::index", stream);
+  index<T, IdxT> idx(res, params.metric, dataset, cagra_graph.view());
+  detail::compress_dataset(res, idx, params.compression);
+  if (params.n_entry_points > 0) {
+    phase.emplace("cagra::build::entry_points", stream);
+    detail::select_entry_points(res, idx, params.n_entry_points);
+  }
+  return idx;
 }
 
 /**
- * @brief Search ANN using the constructed index.
+ * @brief Estimate the memory `cagra::build` needs for a dataset of the given size.
  *
- * See the [cagra::build](#cagra::build) documentation for a usage example.
+ * The result is the index (the dataset and the graph in the device memory); the workspace is the
+ * peak of the kNN graph build and the pruning, including the intermediate graph held in the host
+ * memory. The estimate follows the batching heuristics of the build with the default IVF-PQ
+ * parameters of `build_knn_graph` and assumes the dataset is in the device memory.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   cagra::index_params index_params;
+ *   auto est = cagra::estimate_build_memory<float, uint32_t>(index_params, n_rows, dim);
+ *   if (est.device_peak() > free_bytes) { index_params.n_shards = 4; }
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices in the source dataset
+ *
+ * @param[in] params parameters for building the index
+ * @param[in] n_rows the number of the vectors of the dataset
+ * @param[in] dim the dimensionality of the dataset
+ * @return the estimated memory, in bytes
+ */
+template <typename T, typename IdxT = uint32_t>
+auto estimate_build_memory(const index_params& params, size_t n_rows, size_t dim)
+  -> raft::memory_estimate
+{
+  return detail::estimate_build_memory<T, IdxT>(params, n_rows, dim);
+}
+
+/**
+ * @brief Add new vectors to a CAGRA index.
+ *
+ * The neighbors of the new vectors are found by searching the index; the candidate edges are
+ * pruned using the same rank-based (2-hop detour) criterion as `cagra::prune`, and the new vectors
+ * are added as reverse edges to the neighbor lists of their neighbors. The storage of the index
+ * grows geometrically, so that repeated calls do not reallocate the dataset and the graph every
+ * time. If the index stores a compressed copy of the dataset, it is recomputed for the extended
+ * dataset.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors;
+ *   auto index = cagra::build(res, index_params, dataset);
+ *   // add new vectors to the index
+ *   cagra::extend(res, cagra::extend_params{}, new_vectors, index);
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices in the source dataset
+ *
+ * @param[in] res raft resources
+ * @param[in] params extend parameters
+ * @param[in] new_vectors a matrix view (host or device) to a row-major matrix [n_rows, idx.dim()]
+ * @param[inout] idx cagra index to be extended
+ */
+template <typename T,
+          typename IdxT = uint32_t,
+          typename Accessor =
+            host_device_accessor<std::experimental::default_accessor<T>, memory_type::device>>
+void extend(raft::resources const& res,
+            const extend_params& params,
+            mdspan<const T, matrix_extent<IdxT>, row_major, Accessor> new_vectors,
+            index<T, IdxT>& idx)
+{
+  auto compression = idx.compression();
+  detail::extend(res, params, new_vectors, idx);
+  detail::compress_dataset(res, idx, compression);
+}
+
+/**
+ * @brief Search ANN using the constructed index with the given sample filter.
+ *
+ * The filter is evaluated on the nodes of the internal top-k list. The nodes it rejects are still
+ * used as parents to traverse the graph, but they are never returned. If fewer than k nodes pass
+ * the filter, the remaining neighbors are set to the maximum index value and the maximum distance.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   // filter that greenlights only the samples whose bit is set in a device bit mask
+ *   struct bitmask_filter {
+ *     const uint32_t* bits;
+ *     __device__ bool operator()(uint32_t query_ix, uint32_t sample_ix) const
+ *     {
+ *       return (bits[sample_ix / 32] >> (sample_ix % 32)) & 1u;
+ *     }
+ *   };
+ *
+ *   using namespace raft::neighbors::experimental;
+ *   // use default search parameters
+ *   cagra::search_params search_params;
+ *   cagra::search_with_filtering(
+ *     res, search_params, index, queries, neighbors, distances, bitmask_filter{bits.data()});
+ * @endcode
  *
  * @tparam T data element type
  * @tparam IdxT type of the indices
+ * @tparam CagraSampleFilterT Device filter function, with the signature
+ *         `(uint32_t query_ix, uint32_t sample_ix) -> bool`
  *
  * @param[in] res raft resources
  * @param[in] params configure the search
@@ -282,14 +435,16 @@ index<T, IdxT> build(raft::resources const& res,
  * [n_queries, k]
  * @param[out] distances a device matrix view to the distances to the selected neighbors [n_queries,
  * k]
+ * @param[in] sample_filter a filter the greenlights samples for a given query
  */
-template <typename T, typename IdxT>
-void search(raft::resources const& res,
-            const search_params& params,
-            const index<T, IdxT>& idx,
-            raft::device_matrix_view<const T, IdxT, row_major> queries,
-            raft::device_matrix_view<IdxT, IdxT, row_major> neighbors,
-            raft::device_matrix_view<float, IdxT, row_major> distances)
+template <typename T, typename IdxT, typename CagraSampleFilterT>
+void search_with_filtering(raft::resources const& res,
+                           const search_params& params,
+                           const index<T, IdxT>& idx,
+                           raft::device_matrix_view<const T, IdxT, row_major> queries,
+                           raft::device_matrix_view<IdxT, IdxT, row_major> neighbors,
+                           raft::device_matrix_view<float, IdxT, row_major> distances,
+                           CagraSampleFilterT sample_filter = CagraSampleFilterT())
 {
   RAFT_EXPECTS(
     queries.extent(0) == neighbors.extent(0) && queries.extent(0) == distances.extent(0),
@@ -310,8 +465,245 @@ void search(raft::resources const& res,
   auto distances_internal = raft::make_device_matrix_view<float, internal_IdxT, row_major>(
     distances.data_handle(), distances.extent(0), distances.extent(1));
 
-  detail::search_main<T, internal_IdxT, IdxT>(
-    res, params, idx, queries_internal, neighbors_internal, distances_internal);
+  detail::search_main<T, internal_IdxT, IdxT, float, CagraSampleFilterT>(
+    res, params, idx, queries_internal, neighbors_internal, distances_internal, sample_filter);
+}
+
+/**
+ * @brief Search ANN using the constructed index.
+ *
+ * See the [cagra::build](#cagra::build) documentation for a usage example.
+ *
+ * The queries are searched in batches of `params.max_queries`. If `res` holds a stream pool
+ * (`raft::resource::set_cuda_stream_pool`), the batches are distributed over the pool streams and
+ * their kernels overlap; the results are ready in the main stream of `res`.
+ *
+ * With a deadline (`params.deadline`), the search iterations stop once it expires (but not before
+ * `params.min_iterations`), returning the current internal top-k of every query. The kernels see
+ * the deadline expired by `raft::interruptible::synchronize(stream, params.deadline)` or
+ * `deadline.expire()`; the MULTI_KERNEL algorithm checks it on the host between the iterations.
+ * The persistent search does not observe the deadline.
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] res raft resources
+ * @param[in] params configure the search
+ * @param[in] idx cagra index
+ * @param[in] queries a device matrix view to a row-major matrix [n_queries, index->dim()]
+ * @param[out] neighbors a device matrix view to the indices of the neighbors in the source dataset
+ * [n_queries, k]
+ * @param[out] distances a device matrix view to the distances to the selected neighbors [n_queries,
+ * k]
+ */
+template <typename T, typename IdxT>
+void search(raft::resources const& res,
+            const search_params& params,
+            const index<T, IdxT>& idx,
+            raft::device_matrix_view<const T, IdxT, row_major> queries,
+            raft::device_matrix_view<IdxT, IdxT, row_major> neighbors,
+            raft::device_matrix_view<float, IdxT, row_major> distances)
+{
+  search_with_filtering<T, IdxT, raft::neighbors::filtering::none_cagra_sample_filter>(
+    res, params, idx, queries, neighbors, distances);
+}
+
+/**
+ * @brief Search ANN with a different number of neighbors per query.
+ *
+ * The neighbors are returned as a CSR matrix [n_queries, idx.size()]: the row `i` holds the `k[i]`
+ * neighbors of the query `i` and the distances to them, sorted as by `search`. The queries are
+ * searched in buckets of a similar k (within a factor of two), so a batch mixing small and large k
+ * keeps its batching while the internal top-k of the small-k queries is not sized for the largest
+ * k of the batch: the `itopk_size` of a bucket is raised to its k only where it is smaller.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors::experimental;
+ *   auto k = raft::make_host_vector<uint32_t, uint32_t>(queries.extent(0));
+ *   ...
+ *   auto out = raft::make_device_csr_matrix<float, int64_t, uint32_t, int64_t>(
+ *     res, queries.extent(0), index.size());
+ *   cagra::search(res, search_params, index, queries, raft::make_const_mdspan(k.view()), out);
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] res raft resources
+ * @param[in] params configure the search
+ * @param[in] idx cagra index
+ * @param[in] queries a device matrix view to a row-major matrix [n_queries, index->dim()]
+ * @param[in] k the number of neighbors to find for every query [n_queries]
+ * @param[out] out a CSR matrix [n_queries, idx.size()]; its sparsity is initialized with `sum(k)`
+ */
+template <typename T, typename IdxT>
+void search(raft::resources const& res,
+            const search_params& params,
+            const index<T, IdxT>& idx,
+            raft::device_matrix_view<const T, IdxT, row_major> queries,
+            raft::host_vector_view<const uint32_t, IdxT> k,
+            raft::device_csr_matrix<float, int64_t, IdxT, int64_t>& out)
+{
+  RAFT_EXPECTS(queries.extent(1) == idx.dim(), "Queries and index dim must match");
+  RAFT_EXPECTS(out.structure_view().get_n_cols() == idx.size(),
+               "The output must be a CSR matrix of shape [n_queries, idx.size()]");
+  raft::neighbors::detail::search_ragged(
+    res, queries, k, out, [&](auto bucket_queries, auto neighbors, auto distances) {
+      search_params bucket_params = params;
+      bucket_params.itopk_size =
+        std::max<size_t>(params.itopk_size, static_cast<size_t>(neighbors.extent(1)));
+      search(res, bucket_params, idx, bucket_queries, neighbors, distances);
+    });
+}
+
+/**
+ * @brief Find the fastest search parameters reaching a target recall on a sample of queries.
+ *
+ * The candidate configurations are run and timed on the current device, so the result is specific
+ * to the index, the batch size and the GPU. The fields of `base` that are not tuned (e.g.
+ * `max_queries`) are kept. Tuning `algo` and `team_size` is skipped if they are not `AUTO`/0 in
+ * `base`. If no configuration reaches the target recall, the most accurate one is returned.
+ *
+ * The tuned parameters can be saved next to the index with `cagra::serialize_search_params`.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors::experimental;
+ *   // ground truth of the sample queries, e.g. computed with raft::neighbors::brute_force::knn
+ *   auto params = cagra::tune_search_params(res, index, sample_queries, ground_truth, 0.95);
+ *   cagra::search(res, params, index, queries, neighbors, distances);
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] res raft resources
+ * @param[in] idx cagra index
+ * @param[in] queries a device matrix view to the sample queries [n_queries, idx.dim()]
+ * @param[in] ground_truth a device matrix view to the true k nearest neighbors of the sample
+ *   queries [n_queries, k]
+ * @param[in] target_recall the fraction of the true neighbors to be found
+ * @param[in] base the starting point of the tuning
+ * @param[in] n_repeats number of timed searches per configuration; the fastest is kept
+ *
+ * @return the search parameters
+ */
+template <typename T, typename IdxT>
+auto tune_search_params(raft::resources const& res,
+                        const index<T, IdxT>& idx,
+                        raft::device_matrix_view<const T, IdxT, row_major> queries,
+                        raft::device_matrix_view<const IdxT, IdxT, row_major> ground_truth,
+                        float target_recall,
+                        const search_params& base = search_params{},
+                        uint32_t n_repeats = 3) -> search_params
+{
+  RAFT_EXPECTS(queries.extent(0) == ground_truth.extent(0),
+               "The ground truth must have one row per sample query");
+  const IdxT n_queries = queries.extent(0);
+  const IdxT k         = ground_truth.extent(1);
+  auto neighbors       = make_device_matrix<IdxT, IdxT>(res, n_queries, k);
+  auto distances       = make_device_matrix<float, IdxT>(res, n_queries, k);
+  return detail::tune_search_params(
+    res,
+    base,
+    raft::make_device_matrix_view<const IdxT, int64_t>(ground_truth.data_handle(), n_queries, k),
+    raft::make_device_matrix_view<const IdxT, int64_t>(neighbors.data_handle(), n_queries, k),
+    target_recall,
+    n_repeats,
+    [&](const search_params& params) {
+      search<T, IdxT>(res, params, idx, queries, neighbors.view(), distances.view());
+    });
+}
+
+/**
+ * @brief Build a CAGRA index partitioned across several GPUs.
+ *
+ * The dataset rows are split into `res.size()` contiguous shards of equal size, and the CAGRA
+ * index of every shard is built on the device of the corresponding handle. The shards are built
+ * concurrently, one host thread per device.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors::experimental;
+ *   // one handle per visible device
+ *   raft::multi_device_resources mres;
+ *   const auto& res = mres.handles();
+ *   auto index = cagra::build_sharded(res, cagra::index_params{}, dataset);
+ *   // queries, neighbors and distances are on the device of res[0]
+ *   cagra::search_sharded(res, cagra::search_params{}, index, queries, neighbors, distances);
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices in the source dataset
+ *
+ * @param[in] res one handle per device; every handle must be bound to its device
+ * @param[in] params parameters for building the index of every shard
+ * @param[in] dataset a host matrix view to a row-major matrix [n_rows, dim]
+ *
+ * @return the sharded index
+ */
+template <typename T, typename IdxT = uint32_t>
+auto build_sharded(const std::vector<raft::resources>& res,
+                   const index_params& params,
+                   raft::host_matrix_view<const T, IdxT, row_major> dataset)
+  -> sharded_index<T, IdxT>
+{
+  return detail::build_sharded(
+    res, dataset, [&params](raft::resources const& shard_res, auto shard_dataset) {
+      return build<T, IdxT>(shard_res, params, shard_dataset);
+    });
+}
+
+/**
+ * @brief Search a CAGRA index partitioned across several GPUs.
+ *
+ * All the shards are searched concurrently, and the k nearest neighbors of every shard are merged
+ * on the device of `res[0]`, where the queries and the results reside.
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] res the handles used to build the index, in the same order
+ * @param[in] params configure the search of every shard
+ * @param[in] idx the sharded index
+ * @param[in] queries a device matrix view to a row-major matrix [n_queries, idx.dim()] on the
+ *   device of `res[0]`
+ * @param[out] neighbors a device matrix view to the indices of the neighbors in the source dataset
+ *   [n_queries, k] on the device of `res[0]`
+ * @param[out] distances a device matrix view to the distances to the selected neighbors
+ *   [n_queries, k] on the device of `res[0]`
+ */
+template <typename T, typename IdxT>
+void search_sharded(const std::vector<raft::resources>& res,
+                    const search_params& params,
+                    const sharded_index<T, IdxT>& idx,
+                    raft::device_matrix_view<const T, IdxT, row_major> queries,
+                    raft::device_matrix_view<IdxT, IdxT, row_major> neighbors,
+                    raft::device_matrix_view<float, IdxT, row_major> distances)
+{
+  RAFT_EXPECTS(
+    queries.extent(0) == neighbors.extent(0) && queries.extent(0) == distances.extent(0),
+    "Number of rows in output neighbors and distances matrices must equal the number of queries.");
+  RAFT_EXPECTS(neighbors.extent(1) == distances.extent(1),
+               "Number of columns in output neighbors and distances matrices must equal k");
+  detail::search_sharded(res,
+                         idx,
+                         queries,
+                         neighbors,
+                         distances,
+                         [&params](raft::resources const& shard_res,
+                                   const index<T, IdxT>& shard,
+                                   auto shard_queries,
+                                   auto shard_neighbors,
+                                   auto shard_distances) {
+                           search<T, IdxT>(shard_res,
+                                           params,
+                                           shard,
+                                           shard_queries,
+                                           shard_neighbors,
+                                           shard_distances);
+                         });
 }
 /** @} */  // end group cagra
 
@@ -47,12 +47,17 @@ namespace raft::neighbors::experimental::cagra {
  * @param[in] handle the raft handle
  * @param[in] os output stream
  * @param[in] index CAGRA index
+ * @param[in] include_dataset whether to write the dataset; when false, the dataset must be
+ *   attached to the loaded index with `index.update_dataset(handle, dataset)` before searching
  *
  */
 template <typename T, typename IdxT>
-void serialize(raft::resources const& handle, std::ostream& os, const index<T, IdxT>& index)
+void serialize(raft::resources const& handle,
+               std::ostream& os,
+               const index<T, IdxT>& index,
+               bool include_dataset = true)
 {
-  detail::serialize(handle, os, index);
+  detail::serialize(handle, os, index, include_dataset);
 }
 
 /**
@@ -77,14 +82,17 @@ void serialize(raft::resources const& handle, std::ostream& os, const index<T, I
  * @param[in] handle the raft handle
  * @param[in] filename the file name for saving the index
  * @param[in] index CAGRA index
+ * @param[in] include_dataset whether to write the dataset; when false, the dataset must be
+ *   attached to the loaded index with `index.update_dataset(handle, dataset)` before searching
  *
  */
 template <typename T, typename IdxT>
 void serialize(raft::resources const& handle,
                const std::string& filename,
-               const index<T, IdxT>& index)
+               const index<T, IdxT>& index,
+               bool include_dataset = true)
 {
-  detail::serialize(handle, filename, index);
+  detail::serialize(handle, filename, index, include_dataset);
 }
 
 /**
@@ -123,6 +131,9 @@ index<T, IdxT> deserialize(raft::resources const& handle, std::istream& is)
  *
  * Experimental, both the API and the serialization format are subject to change.
  *
+ * The file is mapped to memory and streamed to the device through pinned buffers, without an
+ * intermediate host copy of the index.
+ *
  * @code{.cpp}
  * #include <raft/core/resources.hpp>
  *
@@ -149,6 +160,45 @@ index<T, IdxT> deserialize(raft::resources const& handle, const std::string& fil
   return detail::deserialize<T, IdxT>(handle, filename);
 }
 
+/**
+ * Write the search parameters to an output stream, e.g. next to the index they were tuned for.
+ *
+ * Experimental, both the API and the serialization format are subject to change.
+ *
+ * @code{.cpp}
+ * auto params = cagra::tune_search_params(handle, index, sample_queries, ground_truth, 0.95);
+ * std::ofstream os("/path/to/index", std::ios::binary);
+ * cagra::serialize(handle, os, index);
+ * cagra::serialize_search_params(handle, os, params);
+ * @endcode
+ *
+ * @param[in] handle the raft handle
+ * @param[in] os output stream
+ * @param[in] params the search parameters
+ */
+inline void serialize_search_params(raft::resources const& handle,
+                                    std::ostream& os,
+                                    const search_params& params)
+{
+  detail::serialize_search_params(handle, os, params);
+}
+
+/**
+ * Load the search parameters from an input stream.
+ *
+ * Experimental, both the API and the serialization format are subject to change.
+ *
+ * @param[in] handle the raft handle
+ * @param[in] is input stream
+ *
+ * @return the search parameters
+ */
+inline auto deserialize_search_params(raft::resources const& handle, std::istream& is)
+  -> search_params
+{
+  return detail::deserialize_search_params(handle, is);
+}
+
 /**@}*/
 
 }  // namespace raft::neighbors::experimental::cagra
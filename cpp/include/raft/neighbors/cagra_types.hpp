@@ -28,11 +28,15 @@
 #include <raft/util/integer_utils.hpp>
 #include <raft/util/pow2_utils.cuh>
 
+#include <cuda_fp16.h>
+
+#include <algorithm>
 #include <memory>
 #include <optional>
 #include <string>
 #include <thrust/fill.h>
 #include <type_traits>
+#include <vector>
 
 namespace raft::neighbors::experimental::cagra {
 /**
@@ -40,9 +44,61 @@ namespace raft::neighbors::experimental::cagra {
  * @{
  */
 
+/** Storage format of the dataset rows read by the search kernels. */
+enum class dataset_compression {
+  /** Search on the dataset in its original type. */
+  NONE,
+  /** Search on a half-precision copy of the dataset. */
+  FP16,
+  /**
+   * Search on a scalar-quantized int8 copy of the dataset. The vectors are centered with a
+   * per-dimension offset and scaled by a factor shared by all dimensions.
+   */
+  INT8
+};
+
+/** The algorithm to build the intermediate knn-graph with. */
+enum class graph_build_algo {
+  /** Search an IVF-PQ index of the dataset for the neighbors of every vector. */
+  IVF_PQ,
+  /** Refine a random graph with nn-descent (experimental, L2 only). */
+  NN_DESCENT
+};
+
 struct index_params : ann::index_params {
   size_t intermediate_graph_degree = 128;  // Degree of input graph for pruning.
   size_t graph_degree              = 64;   // Degree of output graph.
+  /**
+   * Number of overlapping shards the dataset is split into while building the kNN graph.
+   *
+   * With `n_shards > 1`, a sub-graph is built for one shard at a time, so that the device memory
+   * usage of the graph build is bounded by the shard size rather than by the dataset size. Use it
+   * for host datasets whose graph build does not fit into the device memory. Note that the built
+   * index still keeps a device copy of the whole dataset for the search, so the dataset itself
+   * must fit into the device memory.
+   */
+  size_t n_shards = 1;
+  /** Number of shards each vector is assigned to when `n_shards > 1`. */
+  size_t shard_overlap = 2;
+  /**
+   * Keep a compressed copy of a float dataset for the search kernels. This reduces the memory
+   * traffic of the distance computation by a factor of 2 (FP16) or 4 (INT8); the original dataset
+   * is kept for re-ranking the results (see `search_params::refine_topk`).
+   */
+  dataset_compression compression = dataset_compression::NONE;
+  /** The algorithm to build the intermediate knn-graph with (ignored when `n_shards > 1`). */
+  graph_build_algo build_algo = graph_build_algo::IVF_PQ;
+  /** Number of nn-descent iterations when `build_algo == NN_DESCENT` (supports degrees <= 128). */
+  size_t nn_descent_niter = 20;
+  /**
+   * Number of entry points stored with the index (0 to disable).
+   *
+   * The entry points are the dataset rows nearest to the k-means centroids of the dataset. Every
+   * query is seeded with the entry points instead of the random nodes, so that the search starts
+   * in the right region of the graph and fewer iterations are needed at the same recall. At most
+   * as many entry points as the search keeps candidates (about `itopk_size`) are used per query.
+   */
+  size_t n_entry_points = 0;
 };
 
 enum class search_algo {
@@ -96,10 +152,44 @@ struct search_params : ann::search_params {
   uint32_t num_random_samplings = 1;
   // Bit mask used for initial random seed node selection. */
   uint64_t rand_xor_mask = 0x128394;
+
+  /**
+   * Number of candidates searched on the compressed dataset and re-ranked with the exact distances
+   * to the original dataset. Used only if the index has a compressed dataset; no re-ranking when
+   * 0, otherwise it must be equal to or greater than k.
+   */
+  size_t refine_topk = 0;
+
+  /**
+   * Whether to use the persistent version of the single-CTA search (implies SINGLE_CTA).
+   *
+   * The persistent kernel stays resident on the GPU and takes the queries from a work queue fed by
+   * the host, so that a search call does not launch a kernel nor allocate the hashmaps. This
+   * reduces the latency of small batches. The kernel keeps running as long as the following
+   * searches use the same index and search parameters; it is relaunched when they change. While
+   * it is running, the kernel occupies the GPU share given by `persistent_device_usage`.
+   */
+  bool persistent = false;
+  /** Fraction of the maximum number of resident thread blocks used by the persistent kernel. */
+  float persistent_device_usage = 1.0;
+};
+
+struct extend_params {
+  /** Number of candidate neighbors searched for every new vector before pruning. */
+  size_t intermediate_graph_degree = 128;
+  /**
+   * Maximum number of vectors added to the index in one step. The new vectors are linked to the
+   * vectors already in the index, so smaller chunks link the new vectors better to each other.
+   * Auto selection when 0.
+   */
+  size_t max_chunk_size = 0;
+  /** Parameters of the search for the candidate neighbors of the new vectors. */
+  search_params candidate_search;
 };
 
 static_assert(std::is_aggregate_v<index_params>);
 static_assert(std::is_aggregate_v<search_params>);
+static_assert(std::is_aggregate_v<extend_params>);
 
 /**
  * @brief CAGRA index.
@@ -126,7 +216,7 @@ struct index : ann::index {
   // /** Total length of the index. */
   [[nodiscard]] constexpr inline auto size() const noexcept -> IdxT
   {
-    return dataset_view_.extent(0);
+    return graph_view_.extent(0);
   }
 
   /** Dimensionality of the data. */
@@ -139,24 +229,67 @@ struct index : ann::index {
   {
     return graph_.extent(1);
   }
+  /** Storage format of the dataset used by the search kernels. */
+  [[nodiscard]] constexpr inline auto compression() const noexcept -> dataset_compression
+  {
+    return compression_;
+  }
+  /** Number of vectors the index can hold without reallocating the dataset and the graph. */
+  [[nodiscard]] constexpr inline auto capacity() const noexcept -> IdxT
+  {
+    return dataset_.extent(0);
+  }
 
-  /** Dataset [size, dim] */
+  /**
+   * Dataset [size, dim]
+   *
+   * The dataset is empty if the index was loaded without it (see `cagra::deserialize`); it must be
+   * attached with `update_dataset` before searching.
+   */
   [[nodiscard]] inline auto dataset() const noexcept
     -> device_matrix_view<const T, IdxT, layout_stride>
   {
     return dataset_view_;
   }
 
-  /** neighborhood graph [size, graph-degree] */
-  inline auto graph() noexcept -> device_matrix_view<IdxT, IdxT, row_major>
+  /** Half-precision copy of the dataset [size, dim]; empty unless compression() is FP16. */
+  [[nodiscard]] inline auto dataset_fp16() const noexcept
+    -> device_matrix_view<const half, IdxT, layout_stride>
   {
-    return graph_.view();
+    return make_device_strided_matrix_view<const half, IdxT>(
+      dataset_fp16_.data_handle(), dataset_fp16_.extent(0), dim(), dataset_fp16_.extent(1));
   }
 
+  /** Scalar-quantized copy of the dataset [size, dim]; empty unless compression() is INT8. */
+  [[nodiscard]] inline auto dataset_int8() const noexcept
+    -> device_matrix_view<const int8_t, IdxT, layout_stride>
+  {
+    return make_device_strided_matrix_view<const int8_t, IdxT>(
+      dataset_int8_.data_handle(), dataset_int8_.extent(0), dim(), dataset_int8_.extent(1));
+  }
+
+  /** Per-dimension offset of the int8 quantization [dim]. */
+  [[nodiscard]] inline auto vq_offset() const noexcept -> device_vector_view<const float, IdxT>
+  {
+    return vq_offset_.view();
+  }
+
+  /** Scale of the int8 quantization: `x ~ code * vq_scale + vq_offset`. */
+  [[nodiscard]] constexpr inline auto vq_scale() const noexcept -> float { return vq_scale_; }
+
+  /** neighborhood graph [size, graph-degree] */
+  inline auto graph() noexcept -> device_matrix_view<IdxT, IdxT, row_major> { return graph_view_; }
+
   [[nodiscard]] inline auto graph() const noexcept
     -> device_matrix_view<const IdxT, IdxT, row_major>
   {
-    return graph_.view();
+    return make_const_mdspan(graph_view_);
+  }
+
+  /** Ids of the nodes every search starts from [n_entry_points]; empty for random seeds. */
+  [[nodiscard]] inline auto entry_points() const noexcept -> device_vector_view<const IdxT, IdxT>
+  {
+    return entry_points_.view();
   }
 
   // Don't allow copying the index for performance reasons (try avoiding copying data)
@@ -167,11 +300,17 @@ struct index : ann::index {
   ~index()                               = default;
 
   /** Construct an empty index. */
-  index(raft::resources const& res)
+  index(raft::resources const& res,
+        raft::distance::DistanceType metric = raft::distance::DistanceType::L2Expanded)
     : ann::index(),
-      metric_(raft::distance::DistanceType::L2Expanded),
+      metric_(metric),
       dataset_(make_device_matrix<T, IdxT>(res, 0, 0)),
-      graph_(make_device_matrix<IdxT, IdxT>(res, 0, 0))
+      graph_(make_device_matrix<IdxT, IdxT>(res, 0, 0)),
+      graph_view_(graph_.view()),
+      dataset_fp16_(make_device_matrix<half, IdxT>(res, 0, 0)),
+      dataset_int8_(make_device_matrix<int8_t, IdxT>(res, 0, 0)),
+      vq_offset_(make_device_vector<float, IdxT>(res, 0)),
+      entry_points_(make_device_vector<IdxT, IdxT>(res, 0))
   {
   }
 
@@ -185,7 +324,11 @@ struct index : ann::index {
       metric_(metric),
       dataset_(
         make_device_matrix<T, IdxT>(res, dataset.extent(0), AlignDim::roundUp(dataset.extent(1)))),
-      graph_(make_device_matrix<IdxT, IdxT>(res, knn_graph.extent(0), knn_graph.extent(1)))
+      graph_(make_device_matrix<IdxT, IdxT>(res, knn_graph.extent(0), knn_graph.extent(1))),
+      dataset_fp16_(make_device_matrix<half, IdxT>(res, 0, 0)),
+      dataset_int8_(make_device_matrix<int8_t, IdxT>(res, 0, 0)),
+      vq_offset_(make_device_vector<float, IdxT>(res, 0)),
+      entry_points_(make_device_vector<IdxT, IdxT>(res, 0))
   {
     RAFT_EXPECTS(dataset.extent(0) == knn_graph.extent(0),
                  "Dataset and knn_graph must have equal number of rows");
@@ -217,14 +360,244 @@ struct index : ann::index {
                knn_graph.data_handle(),
                knn_graph.size(),
                resource::get_cuda_stream(res));
+    graph_view_ = graph_.view();
+    resource::sync_stream(res);
+  }
+
+  /**
+   * Make sure the index can hold at least `new_capacity` vectors without reallocation.
+   *
+   * The content of the dataset and the graph is preserved; the size of the index does not change.
+   */
+  void reserve(raft::resources const& res, IdxT new_capacity)
+  {
+    if (new_capacity <= capacity()) { return; }
+    auto stream      = resource::get_cuda_stream(res);
+    auto new_dataset = make_device_matrix<T, IdxT>(res, new_capacity, dataset_.extent(1));
+    auto new_graph   = make_device_matrix<IdxT, IdxT>(res, new_capacity, graph_.extent(1));
+    // Keep the padding of the dataset rows zeroed
+    RAFT_CUDA_TRY(
+      cudaMemsetAsync(new_dataset.data_handle(), 0, new_dataset.size() * sizeof(T), stream));
+    raft::copy(new_dataset.data_handle(),
+               dataset_.data_handle(),
+               static_cast<size_t>(dataset_view_.extent(0)) * dataset_.extent(1),
+               stream);
+    raft::copy(new_graph.data_handle(), graph_.data_handle(), graph_view_.size(), stream);
+    dataset_      = std::move(new_dataset);
+    graph_        = std::move(new_graph);
+    dataset_view_ = make_device_strided_matrix_view<T, IdxT>(
+      dataset_.data_handle(), dataset_view_.extent(0), dataset_view_.extent(1), dataset_.extent(1));
+    graph_view_ = make_device_matrix_view<IdxT, IdxT>(
+      graph_.data_handle(), graph_view_.extent(0), graph_.extent(1));
+  }
+
+  /**
+   * Replace the dataset, e.g. to attach it to an index loaded without the dataset.
+   *
+   * The dataset is copied to the device with its rows padded to 16 bytes. The compressed copy
+   * of the dataset, if any, is discarded.
+   *
+   * @param[in] res
+   * @param[in] dataset a host or device matrix view to the dataset [size, dim]
+   */
+  template <typename data_accessor>
+  void update_dataset(raft::resources const& res,
+                      mdspan<const T, matrix_extent<IdxT>, row_major, data_accessor> dataset)
+  {
+    RAFT_EXPECTS(dataset.extent(0) == size(), "The dataset and the graph sizes differ");
+    auto stream = resource::get_cuda_stream(res);
+    auto padded = make_device_matrix<T, IdxT>(res, size(), AlignDim::roundUp(dataset.extent(1)));
+    RAFT_CUDA_TRY(cudaMemsetAsync(padded.data_handle(), 0, padded.size() * sizeof(T), stream));
+    RAFT_CUDA_TRY(cudaMemcpy2DAsync(padded.data_handle(),
+                                    sizeof(T) * padded.extent(1),
+                                    dataset.data_handle(),
+                                    sizeof(T) * dataset.extent(1),
+                                    sizeof(T) * dataset.extent(1),
+                                    dataset.extent(0),
+                                    cudaMemcpyDefault,
+                                    stream));
+    update_dataset(res, std::move(padded), dataset.extent(1));
+    // The source may be released by the caller after the call returns
     resource::sync_stream(res);
   }
 
+  /**
+   * Replace the dataset, taking the ownership of the array.
+   *
+   * The rows of `dataset` must be padded to 16 bytes (`AlignDim`) and the padding zeroed. A dataset
+   * with no rows detaches the dataset from the index, keeping the dimensionality.
+   *
+   * @param[in] res
+   * @param[in] dataset the padded dataset [size, AlignDim::roundUp(dim)] or [0, ...]
+   * @param[in] dim the dimensionality of the data
+   */
+  void update_dataset(raft::resources const& res,
+                      raft::device_matrix<T, IdxT, row_major>&& dataset,
+                      uint32_t dim)
+  {
+    RAFT_EXPECTS(dataset.extent(0) == size() || dataset.extent(0) == 0,
+                 "The dataset and the graph sizes differ");
+    RAFT_EXPECTS(static_cast<uint32_t>(dataset.extent(1)) == AlignDim::roundUp(dim),
+                 "The dataset rows must be padded to 16 bytes");
+    clear_compressed_dataset(res);
+    dataset_      = std::move(dataset);
+    dataset_view_ = make_device_strided_matrix_view<T, IdxT>(
+      dataset_.data_handle(), dataset_.extent(0), dim, dataset_.extent(1));
+  }
+
+  /**
+   * Replace the graph, taking the ownership of the array.
+   *
+   * @param[in] res
+   * @param[in] knn_graph the neighbor lists [size, graph_degree]
+   */
+  void update_graph(raft::resources const& res,
+                    raft::device_matrix<IdxT, IdxT, row_major>&& knn_graph)
+  {
+    RAFT_EXPECTS(dataset_view_.extent(0) == 0 || knn_graph.extent(0) == dataset_view_.extent(0),
+                 "The dataset and the graph sizes differ");
+    graph_      = std::move(knn_graph);
+    graph_view_ = graph_.view();
+  }
+
+  /**
+   * Replace the entry points of the search, taking the ownership of the array.
+   *
+   * @param[in] res
+   * @param[in] entry_points ids of the graph nodes [n_entry_points]; empty to use random seeds
+   */
+  void update_entry_points(raft::resources const& res,
+                           raft::device_vector<IdxT, IdxT>&& entry_points)
+  {
+    entry_points_ = std::move(entry_points);
+  }
+
+  /**
+   * Replace the compressed copy of the dataset used by the search kernels.
+   *
+   * The rows are expected to be padded to 16 bytes, as the rows of the original dataset.
+   */
+  void update_dataset(raft::resources const& res,
+                      raft::device_matrix<half, IdxT, row_major>&& dataset_fp16)
+  {
+    RAFT_EXPECTS(dataset_fp16.extent(0) == size(), "Compressed dataset size differs");
+    clear_compressed_dataset(res);
+    dataset_fp16_ = std::move(dataset_fp16);
+    compression_  = dataset_compression::FP16;
+  }
+
+  /** @copydoc update_dataset */
+  void update_dataset(raft::resources const& res,
+                      raft::device_matrix<int8_t, IdxT, row_major>&& dataset_int8,
+                      raft::device_vector<float, IdxT>&& vq_offset,
+                      float vq_scale)
+  {
+    RAFT_EXPECTS(dataset_int8.extent(0) == size(), "Compressed dataset size differs");
+    RAFT_EXPECTS(vq_offset.extent(0) == dim(), "Quantization offset must have dim elements");
+    clear_compressed_dataset(res);
+    dataset_int8_ = std::move(dataset_int8);
+    vq_offset_    = std::move(vq_offset);
+    vq_scale_     = vq_scale;
+    compression_  = dataset_compression::INT8;
+  }
+
+  /**
+   * Append vectors and their neighbor lists to the index.
+   *
+   * The storage grows geometrically, so that the existing rows are not copied on every call.
+   * The compressed copy of the dataset, if any, is discarded.
+   *
+   * @param[in] res
+   * @param[in] new_vectors a device matrix view to the appended vectors [n_new, dim]
+   * @param[in] new_graph a device matrix view to the neighbor lists of the appended vectors
+   *   [n_new, graph_degree]
+   */
+  void append(raft::resources const& res,
+              device_matrix_view<const T, IdxT, row_major> new_vectors,
+              device_matrix_view<const IdxT, IdxT, row_major> new_graph)
+  {
+    RAFT_EXPECTS(new_vectors.extent(0) == new_graph.extent(0),
+                 "The appended vectors and graph must have equal number of rows");
+    RAFT_EXPECTS(new_vectors.extent(1) == dim(), "Dimensionality of the appended vectors differs");
+    RAFT_EXPECTS(new_graph.extent(1) == graph_degree(), "Degree of the appended graph differs");
+    RAFT_EXPECTS(dataset_view_.extent(0) == size(), "The index has no dataset attached");
+    clear_compressed_dataset(res);
+    auto stream         = resource::get_cuda_stream(res);
+    const IdxT old_size = size();
+    const IdxT new_size = old_size + new_vectors.extent(0);
+    if (new_size > capacity()) { reserve(res, std::max<IdxT>(new_size, capacity() * 2)); }
+    RAFT_CUDA_TRY(cudaMemcpy2DAsync(dataset_.data_handle() + old_size * dataset_.extent(1),
+                                    sizeof(T) * dataset_.extent(1),
+                                    new_vectors.data_handle(),
+                                    sizeof(T) * new_vectors.extent(1),
+                                    sizeof(T) * new_vectors.extent(1),
+                                    new_vectors.extent(0),
+                                    cudaMemcpyDefault,
+                                    stream));
+    raft::copy(graph_.data_handle() + old_size * graph_.extent(1),
+               new_graph.data_handle(),
+               new_graph.size(),
+               stream);
+    dataset_view_ = make_device_strided_matrix_view<T, IdxT>(
+      dataset_.data_handle(), new_size, dataset_view_.extent(1), dataset_.extent(1));
+    graph_view_ =
+      make_device_matrix_view<IdxT, IdxT>(graph_.data_handle(), new_size, graph_.extent(1));
+  }
+
  private:
+  void clear_compressed_dataset(raft::resources const& res)
+  {
+    if (compression_ == dataset_compression::NONE) { return; }
+    dataset_fp16_ = make_device_matrix<half, IdxT>(res, 0, 0);
+    dataset_int8_ = make_device_matrix<int8_t, IdxT>(res, 0, 0);
+    vq_offset_    = make_device_vector<float, IdxT>(res, 0);
+    vq_scale_     = 1.0f;
+    compression_  = dataset_compression::NONE;
+  }
+
   raft::distance::DistanceType metric_;
+  dataset_compression compression_ = dataset_compression::NONE;
   raft::device_matrix<T, IdxT, row_major> dataset_;
   raft::device_matrix<IdxT, IdxT, row_major> graph_;
   raft::device_matrix_view<T, IdxT, layout_stride> dataset_view_;
+  raft::device_matrix_view<IdxT, IdxT, row_major> graph_view_;
+  raft::device_matrix<half, IdxT, row_major> dataset_fp16_;
+  raft::device_matrix<int8_t, IdxT, row_major> dataset_int8_;
+  raft::device_vector<float, IdxT> vq_offset_;
+  float vq_scale_ = 1.0f;
+  raft::device_vector<IdxT, IdxT> entry_points_;
+};
+
+/**
+ * @brief CAGRA index partitioned across several GPUs.
+ *
+ * Every shard is an independent CAGRA index built on a contiguous range of the source dataset
+ * rows, and resides on the device of the corresponding handle passed to `cagra::build_sharded`.
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices in the source dataset
+ */
+template <typename T, typename IdxT>
+struct sharded_index {
+  /** The index of every shard. */
+  std::vector<index<T, IdxT>> shards;
+  /** Source dataset row of the first vector of every shard. */
+  std::vector<IdxT> offsets;
+
+  /** Total number of vectors. */
+  [[nodiscard]] auto size() const noexcept -> IdxT
+  {
+    IdxT n = 0;
+    for (const auto& shard : shards) {
+      n += shard.size();
+    }
+    return n;
+  }
+  /** Dimensionality of the data. */
+  [[nodiscard]] auto dim() const noexcept -> uint32_t
+  {
+    return shards.empty() ? 0 : shards.front().dim();
+  }
 };
 
 /** @} */
@@ -17,6 +17,8 @@
 
 #include <cstdint>
 #include <raft/core/detail/macros.hpp>
+#include <raft/util/bitonic_sort.cuh>
+#include <raft/util/cuda_utils.cuh>
 
 namespace raft::neighbors::experimental::cagra::detail {
 namespace bitonic {
@@ -47,47 +49,10 @@ _RAFT_DEVICE inline void swap_if_needed(K& k0, V& v0, const unsigned lane_offset
   }
 }
 
+// The networks of the sizes that are not a power of two; the others are those of
+// raft::util::bitonic_blocked.
 template <class K, class V, unsigned N, unsigned warp_size = 32>
-struct warp_merge_core {
-  _RAFT_DEVICE inline void operator()(K k[N], V v[N], const std::uint32_t range, const bool asc)
-  {
-    const auto lane_id = threadIdx.x % warp_size;
-
-    if (range == 1) {
-      for (std::uint32_t b = 2; b <= N; b <<= 1) {
-        for (std::uint32_t c = b / 2; c >= 1; c >>= 1) {
-#pragma unroll
-          for (std::uint32_t i = 0; i < N; i++) {
-            std::uint32_t j = i ^ c;
-            if (i >= j) continue;
-            const auto line_id = i + (N * lane_id);
-            const auto p       = static_cast<bool>(line_id & b) == static_cast<bool>(line_id & c);
-            swap_if_needed(k[i], v[i], k[j], v[j], p);
-          }
-        }
-      }
-      return;
-    }
-
-    const std::uint32_t b = range;
-    for (std::uint32_t c = b / 2; c >= 1; c >>= 1) {
-      const auto p = static_cast<bool>(lane_id & b) == static_cast<bool>(lane_id & c);
-#pragma unroll
-      for (std::uint32_t i = 0; i < N; i++) {
-        swap_if_needed(k[i], v[i], c, p);
-      }
-    }
-    const auto p = ((lane_id & b) == 0);
-    for (std::uint32_t c = N / 2; c >= 1; c >>= 1) {
-#pragma unroll
-      for (std::uint32_t i = 0; i < N; i++) {
-        std::uint32_t j = i ^ c;
-        if (i >= j) continue;
-        swap_if_needed(k[i], v[i], k[j], v[j], p);
-      }
-    }
-  }
-};
+struct warp_merge_core;
 
 template <class K, class V, unsigned warp_size>
 struct warp_merge_core<K, V, 6, warp_size> {
@@ -167,58 +132,31 @@ struct warp_merge_core<K, V, 3, warp_size> {
   }
 };
 
-template <class K, class V, unsigned warp_size>
-struct warp_merge_core<K, V, 2, warp_size> {
-  _RAFT_DEVICE inline void operator()(K k[2], V v[2], const std::uint32_t range, const bool asc)
-  {
-    constexpr unsigned N = 2;
-    const auto lane_id   = threadIdx.x % warp_size;
-
-    if (range == 1) {
-      const auto p = ((lane_id & 1) == 0);
-      swap_if_needed(k[0], v[0], k[1], v[1], p);
-      return;
-    }
-
-    const std::uint32_t b = range;
-    for (std::uint32_t c = b / 2; c >= 1; c >>= 1) {
-      const auto p = static_cast<bool>(lane_id & b) == static_cast<bool>(lane_id & c);
-#pragma unroll
-      for (std::uint32_t i = 0; i < N; i++) {
-        swap_if_needed(k[i], v[i], c, p);
-      }
-    }
-    const auto p = ((lane_id & b) == 0);
-    swap_if_needed(k[0], v[0], k[1], v[1], p);
-  }
-};
-
-template <class K, class V, unsigned warp_size>
-struct warp_merge_core<K, V, 1, warp_size> {
-  _RAFT_DEVICE inline void operator()(K k[1], V v[1], const std::uint32_t range, const bool asc)
-  {
-    const auto lane_id    = threadIdx.x % warp_size;
-    const std::uint32_t b = range;
-    for (std::uint32_t c = b / 2; c >= 1; c >>= 1) {
-      const auto p = static_cast<bool>(lane_id & b) == static_cast<bool>(lane_id & c);
-      swap_if_needed(k[0], v[0], c, p);
-    }
-  }
-};
-
 }  // namespace detail
 
+/**
+ * Sort the bitonic sequence of the warp (`range == warp_size`) in the blocked layout: `k[i]` of
+ * the lane `j` is the element `j * N + i`.
+ */
 template <class K, class V, unsigned N, unsigned warp_size = 32>
 __device__ void warp_merge(K k[N], V v[N], unsigned range, const bool asc = true)
 {
-  detail::warp_merge_core<K, V, N, warp_size>{}(k, v, range, asc);
+  if constexpr (raft::isPo2(N)) {
+    raft::util::bitonic_blocked<N>(asc, range).merge(k, v);
+  } else {
+    detail::warp_merge_core<K, V, N, warp_size>{}(k, v, range, asc);
+  }
 }
 
 template <class K, class V, unsigned N, unsigned warp_size = 32>
 __device__ void warp_sort(K k[N], V v[N], const bool asc = true)
 {
-  for (std::uint32_t range = 1; range <= warp_size; range <<= 1) {
-    warp_merge<K, V, N, warp_size>(k, v, range, asc);
+  if constexpr (raft::isPo2(N)) {
+    raft::util::bitonic_blocked<N>(asc, warp_size).sort(k, v);
+  } else {
+    for (std::uint32_t range = 1; range <= warp_size; range <<= 1) {
+      warp_merge<K, V, N, warp_size>(k, v, range, asc);
+    }
   }
 }
 
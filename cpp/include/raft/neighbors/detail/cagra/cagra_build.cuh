@@ -17,27 +17,52 @@
 
 #include "../../cagra_types.hpp"
 #include "graph_core.cuh"
+#include <algorithm>
 #include <chrono>
 #include <cstdio>
+#include <cstring>
+#include <numeric>
+#include <optional>
 #include <raft/core/resource/cuda_stream.hpp>
+#include <tuple>
 #include <vector>
 
+#include <raft/cluster/kmeans_balanced.cuh>
 #include <raft/core/device_mdarray.hpp>
 #include <raft/core/device_mdspan.hpp>
 #include <raft/core/host_device_accessor.hpp>
 #include <raft/core/host_mdarray.hpp>
 #include <raft/core/host_mdspan.hpp>
 #include <raft/core/logger.hpp>
+#include <raft/core/memory_estimate.hpp>
+#include <raft/core/metrics.hpp>
+#include <raft/core/pinned_mdarray.hpp>
 #include <raft/distance/distance_types.hpp>
+#include <raft/linalg/map.cuh>
 #include <raft/spatial/knn/detail/ann_utils.cuh>
 
+#include <raft/neighbors/brute_force.cuh>
 #include <raft/neighbors/detail/refine.cuh>
 #include <raft/neighbors/ivf_pq.cuh>
+#include <raft/neighbors/ivf_pq_helpers.cuh>
 #include <raft/neighbors/ivf_pq_types.hpp>
 #include <raft/neighbors/refine.cuh>
 
 namespace raft::neighbors::experimental::cagra::detail {
 
+/** The parameters of the IVF-PQ index the kNN graph is built with, unless given by the user. */
+inline auto default_ivf_pq_build_params(int64_t n_rows, int64_t dim) -> ivf_pq::index_params
+{
+  ivf_pq::index_params params;
+  params.n_lists                  = n_rows < 4 * 2500 ? 4 : (uint32_t)(n_rows / 2500);
+  params.pq_dim                   = raft::Pow2<8>::roundUp(dim / 2);
+  params.pq_bits                  = 8;
+  params.kmeans_trainset_fraction = n_rows < 10000 ? 1 : 10;
+  params.kmeans_n_iters           = 25;
+  params.add_data_on_build        = true;
+  return params;
+}
+
 template <typename DataT, typename IdxT, typename accessor>
 void build_knn_graph(raft::resources const& res,
                      mdspan<const DataT, matrix_extent<IdxT>, row_major, accessor> dataset,
@@ -56,13 +81,7 @@ void build_knn_graph(raft::resources const& res,
                                                             node_degree);
 
   if (!build_params) {
-    build_params          = ivf_pq::index_params{};
-    build_params->n_lists = dataset.extent(0) < 4 * 2500 ? 4 : (uint32_t)(dataset.extent(0) / 2500);
-    build_params->pq_dim  = raft::Pow2<8>::roundUp(dataset.extent(1) / 2);
-    build_params->pq_bits = 8;
-    build_params->kmeans_trainset_fraction = dataset.extent(0) < 10000 ? 1 : 10;
-    build_params->kmeans_n_iters           = 25;
-    build_params->add_data_on_build        = true;
+    build_params = default_ivf_pq_build_params(dataset.extent(0), dataset.extent(1));
   }
 
   // Make model name
@@ -83,8 +102,11 @@ void build_knn_graph(raft::resources const& res,
   }();
 
   RAFT_LOG_DEBUG("# Building IVF-PQ index %s", model_name.c_str());
+  std::optional<raft::metrics::phase> phase;
+  phase.emplace("cagra::build::ivf_pq", resource::get_cuda_stream(res));
   auto index = ivf_pq::build<DataT, int64_t>(
     res, *build_params, dataset.data_handle(), dataset.extent(0), dataset.extent(1));
+  phase.reset();
 
   //
   // search top (k + 1) neighbors
@@ -108,15 +130,31 @@ void build_knn_graph(raft::resources const& res,
     max_batch_size,
     search_params->n_probes);
 
+  // The refinement runs on the GPU whenever the dataset is accessible from the device (device,
+  // managed or registered host memory, or the pageable host memory on the systems where the device
+  // reads it through the host page tables). Otherwise, the dataset is refined on the host.
+  const DataT* dataset_dev_ptr =
+    raft::spatial::knn::detail::utils::device_accessible_pointer(dataset.data_handle());
+  const bool refine_on_device = dataset_dev_ptr != nullptr;
+  RAFT_LOG_DEBUG("# Refining the kNN graph on the %s", refine_on_device ? "device" : "host");
+
   // TODO(tfeher): shall we use uint32_t?
   auto distances = raft::make_device_matrix<float, int64_t>(res, max_batch_size, gpu_top_k);
   auto neighbors = raft::make_device_matrix<int64_t, int64_t>(res, max_batch_size, gpu_top_k);
   auto refined_distances = raft::make_device_matrix<float, int64_t>(res, max_batch_size, top_k);
   auto refined_neighbors = raft::make_device_matrix<int64_t, int64_t>(res, max_batch_size, top_k);
-  auto neighbors_host    = raft::make_host_matrix<int64_t, int64_t>(max_batch_size, gpu_top_k);
-  auto queries_host = raft::make_host_matrix<DataT, int64_t>(max_batch_size, dataset.extent(1));
-  auto refined_neighbors_host = raft::make_host_matrix<int64_t, int64_t>(max_batch_size, top_k);
-  auto refined_distances_host = raft::make_host_matrix<float, int64_t>(max_batch_size, top_k);
+  // The host buffers are double-buffered: while the GPU processes one batch, the host refines
+  // (host path) and writes out the results of the previous batch. The buffers filled from the
+  // device are pinned, so that their copies are truly asynchronous.
+  constexpr uint32_t kNumSlots = 2;
+  auto neighbors_host =
+    raft::make_pinned_matrix<int64_t, int64_t>(res,
+                                               refine_on_device ? 0 : kNumSlots * max_batch_size,
+                                               gpu_top_k);
+  auto refined_neighbors_host =
+    raft::make_pinned_matrix<int64_t, int64_t>(res, kNumSlots * max_batch_size, top_k);
+  auto refined_distances_host =
+    raft::make_host_matrix<float, int64_t>(refine_on_device ? 0 : max_batch_size, top_k);
 
   // TODO(tfeher): batched search with multiple GPUs
   std::size_t num_self_included = 0;
@@ -135,6 +173,64 @@ void build_knn_graph(raft::resources const& res,
     resource::get_cuda_stream(res),
     device_memory);
 
+  // Finish the processing of a batch whose GPU results are already in the host slot `slot`:
+  // refine on the host if necessary, omit the point itself and write out.
+  auto finalize_batch = [&](size_t batch_offset, size_t batch_size, uint32_t slot) {
+    auto slot_neighbors = refined_neighbors_host.data_handle() + slot * max_batch_size * top_k;
+    if (!refine_on_device) {
+      if constexpr (is_host_mdspan_v<decltype(dataset)>) {
+        auto queries_host_view = make_host_matrix_view<const DataT, int64_t>(
+          dataset.data_handle() + batch_offset * dataset.extent(1), batch_size, dataset.extent(1));
+        auto neighbors_host_view = make_host_matrix_view<const int64_t, int64_t>(
+          neighbors_host.data_handle() + slot * max_batch_size * gpu_top_k, batch_size, gpu_top_k);
+        auto refined_neighbors_host_view =
+          make_host_matrix_view<int64_t, int64_t>(slot_neighbors, batch_size, top_k);
+        auto refined_distances_host_view = make_host_matrix_view<float, int64_t>(
+          refined_distances_host.data_handle(), batch_size, top_k);
+
+        raft::neighbors::detail::refine_host<int64_t, DataT, float, int64_t>(
+          dataset,
+          queries_host_view,
+          neighbors_host_view,
+          refined_neighbors_host_view,
+          refined_distances_host_view,
+          build_params->metric);
+      }
+    }
+    // omit itself & write out
+    for (std::size_t i = 0; i < batch_size; i++) {
+      size_t vec_idx = i + batch_offset;
+      for (std::size_t j = 0, num_added = 0; j < top_k && num_added < node_degree; j++) {
+        const auto v = slot_neighbors[i * top_k + j];
+        if (static_cast<size_t>(v) == vec_idx) {
+          num_self_included++;
+          continue;
+        }
+        knn_graph(vec_idx, num_added) = v;
+        num_added++;
+      }
+    }
+
+    size_t num_queries_done = batch_offset + batch_size;
+    const auto end_clock    = std::chrono::system_clock::now();
+    const auto time =
+      std::chrono::duration_cast<std::chrono::microseconds>(end_clock - start_clock).count() * 1e-6;
+    const auto throughput = num_queries_done / time;
+    RAFT_LOG_DEBUG(
+      "# Search %12lu / %12lu (%3.2f %%), %e queries/sec, %.2f minutes ETA, self included = "
+      "%3.2f %%    \r",
+      num_queries_done,
+      dataset.extent(0),
+      num_queries_done / static_cast<double>(dataset.extent(0)) * 100,
+      throughput,
+      (num_queries - num_queries_done) / throughput / 60,
+      static_cast<double>(num_self_included) / num_queries_done * 100.);
+    first = false;
+  };
+
+  // (offset, size, slot) of the batch waiting for the host-side post-processing.
+  std::optional<std::tuple<size_t, size_t, uint32_t>> pending_batch = std::nullopt;
+  uint32_t slot                                                     = 0;
   for (const auto& batch : vec_batches) {
     auto queries_view = raft::make_device_matrix_view<const DataT, uint32_t>(
       batch.data(), batch.size(), batch.row_width());
@@ -145,33 +241,7 @@ void build_knn_graph(raft::resources const& res,
 
     ivf_pq::search(res, *search_params, index, queries_view, neighbors_view, distances_view);
 
-    if constexpr (is_host_mdspan_v<decltype(dataset)>) {
-      raft::copy(neighbors_host.data_handle(),
-                 neighbors.data_handle(),
-                 neighbors_view.size(),
-                 resource::get_cuda_stream(res));
-      raft::copy(queries_host.data_handle(),
-                 batch.data(),
-                 queries_view.size(),
-                 resource::get_cuda_stream(res));
-      auto queries_host_view = make_host_matrix_view<const DataT, int64_t>(
-        queries_host.data_handle(), batch.size(), batch.row_width());
-      auto neighbors_host_view = make_host_matrix_view<const int64_t, int64_t>(
-        neighbors_host.data_handle(), batch.size(), neighbors.extent(1));
-      auto refined_neighbors_host_view = make_host_matrix_view<int64_t, int64_t>(
-        refined_neighbors_host.data_handle(), batch.size(), top_k);
-      auto refined_distances_host_view = make_host_matrix_view<float, int64_t>(
-        refined_distances_host.data_handle(), batch.size(), top_k);
-      resource::sync_stream(res);
-
-      raft::neighbors::detail::refine_host<int64_t, DataT, float, int64_t>(  // res,
-        dataset,
-        queries_host_view,
-        neighbors_host_view,
-        refined_neighbors_host_view,
-        refined_distances_host_view,
-        build_params->metric);
-    } else {
+    if (refine_on_device) {
       auto neighbor_candidates_view = make_device_matrix_view<const int64_t, uint64_t>(
         neighbors.data_handle(), batch.size(), gpu_top_k);
       auto refined_neighbors_view = make_device_matrix_view<int64_t, int64_t>(
@@ -180,7 +250,8 @@ void build_knn_graph(raft::resources const& res,
         refined_distances.data_handle(), batch.size(), top_k);
 
       auto dataset_view = make_device_matrix_view<const DataT, int64_t>(
-        dataset.data_handle(), dataset.extent(0), dataset.extent(1));
+        dataset_dev_ptr, dataset.extent(0), dataset.extent(1));
+      raft::metrics::phase refine_phase("cagra::build::refine", resource::get_cuda_stream(res));
       raft::neighbors::detail::refine_device<int64_t, DataT, float, int64_t>(
         res,
         dataset_view,
@@ -189,44 +260,353 @@ void build_knn_graph(raft::resources const& res,
         refined_neighbors_view,
         refined_distances_view,
         build_params->metric);
-      raft::copy(refined_neighbors_host.data_handle(),
-                 refined_neighbors_view.data_handle(),
-                 refined_neighbors_view.size(),
+    }
+
+    // The GPU work for the current batch is in flight: use this time to post-process the
+    // previous one on the host.
+    if (pending_batch.has_value()) {
+      auto [offset, size, pending_slot] = *pending_batch;
+      finalize_batch(offset, size, pending_slot);
+    }
+
+    if (refine_on_device) {
+      raft::copy(refined_neighbors_host.data_handle() + slot * max_batch_size * top_k,
+                 refined_neighbors.data_handle(),
+                 batch.size() * top_k,
+                 resource::get_cuda_stream(res));
+    } else {
+      raft::copy(neighbors_host.data_handle() + slot * max_batch_size * gpu_top_k,
+                 neighbors.data_handle(),
+                 batch.size() * gpu_top_k,
                  resource::get_cuda_stream(res));
-      resource::sync_stream(res);
     }
-    // omit itself & write out
-    // TODO(tfeher): do this in parallel with GPU processing of next batch
-    for (std::size_t i = 0; i < batch.size(); i++) {
-      size_t vec_idx = i + batch.offset();
-      for (std::size_t j = 0, num_added = 0; j < top_k && num_added < node_degree; j++) {
-        const auto v = refined_neighbors_host(i, j);
-        if (static_cast<size_t>(v) == vec_idx) {
-          num_self_included++;
-          continue;
-        }
-        knn_graph(vec_idx, num_added) = v;
-        num_added++;
+    resource::sync_stream(res);
+
+    pending_batch = std::make_tuple(size_t(batch.offset()), size_t(batch.size()), slot);
+    slot          = (slot + 1) % kNumSlots;
+  }
+  if (pending_batch.has_value()) {
+    auto [offset, size, pending_slot] = *pending_batch;
+    finalize_batch(offset, size, pending_slot);
+  }
+  if (!first) RAFT_LOG_DEBUG("# Finished building kNN graph");
+}
+
+/**
+ * Build a kNN graph of a dataset that does not fit into the device memory.
+ *
+ * The dataset is split into `n_shards` overlapping shards: every vector is assigned to its
+ * `shard_overlap` closest balanced k-means centers. A kNN sub-graph is built for one shard at a
+ * time with `build_knn_graph`, so that only a single shard resides in the device memory. The
+ * neighbor lists of the vectors belonging to several shards are merged by rank on the GPU.
+ * The dataset may reside in the host, device or managed memory.
+ */
+template <typename DataT, typename IdxT, typename accessor>
+void build_knn_graph_sharded(raft::resources const& res,
+                             mdspan<const DataT, matrix_extent<IdxT>, row_major, accessor> dataset,
+                             raft::host_matrix_view<IdxT, IdxT, row_major> knn_graph,
+                             uint32_t n_shards,
+                             uint32_t shard_overlap)
+{
+  using raft::spatial::knn::detail::utils::mapping;
+
+  const int64_t n_rows       = dataset.extent(0);
+  const int64_t dim          = dataset.extent(1);
+  const uint32_t node_degree = knn_graph.extent(1);
+  shard_overlap              = std::min(shard_overlap, n_shards);
+  RAFT_EXPECTS(n_shards > 0 && shard_overlap > 0,
+               "The number of shards and the shard overlap must be positive");
+  RAFT_EXPECTS(shard_overlap <= std::numeric_limits<uint8_t>::max(), "Shard overlap is too large");
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "cagra::build_graph_sharded(%zu, %zu, %u, %u)",
+    size_t(n_rows),
+    size_t(dim),
+    n_shards,
+    shard_overlap);
+  auto stream = resource::get_cuda_stream(res);
+
+  // The shards of a device (or managed) dataset are gathered on the device, the shards of a host
+  // dataset on the host.
+  bool dataset_on_device = false;
+  {
+    cudaPointerAttributes attr;
+    RAFT_CUDA_TRY(cudaPointerGetAttributes(&attr, dataset.data_handle()));
+    dataset_on_device = attr.type == cudaMemoryTypeDevice || attr.type == cudaMemoryTypeManaged;
+  }
+
+  //
+  // Train the shard centers on a subsample of the dataset
+  //
+  constexpr int64_t kTrainPointsPerShard = 2048;
+  auto centers = raft::make_device_matrix<float, int64_t>(res, n_shards, dim);
+  {
+    const int64_t trainset_ratio =
+      std::max<int64_t>(1, n_rows / std::max<int64_t>(n_shards * kTrainPointsPerShard, 1));
+    const int64_t n_rows_train = n_rows / trainset_ratio;
+    auto trainset              = raft::make_device_matrix<DataT, int64_t>(res, n_rows_train, dim);
+    RAFT_CUDA_TRY(cudaMemcpy2DAsync(trainset.data_handle(),
+                                    sizeof(DataT) * dim,
+                                    dataset.data_handle(),
+                                    sizeof(DataT) * dim * trainset_ratio,
+                                    sizeof(DataT) * dim,
+                                    n_rows_train,
+                                    cudaMemcpyDefault,
+                                    stream));
+    raft::cluster::kmeans_balanced_params kmeans_params;
+    kmeans_params.metric = distance::DistanceType::L2Expanded;
+    raft::cluster::kmeans_balanced::fit(res,
+                                        kmeans_params,
+                                        raft::make_const_mdspan(trainset.view()),
+                                        centers.view(),
+                                        mapping<float>{});
+  }
+
+  //
+  // Assign every vector to its `shard_overlap` closest shards
+  //
+  auto shard_ids = raft::make_host_matrix<int64_t, int64_t>(n_rows, shard_overlap);
+  {
+    constexpr int64_t kMaxBatchSize = 64 * 1024;
+    const int64_t max_batch_size    = std::min(kMaxBatchSize, n_rows);
+    auto batch_float = raft::make_device_matrix<float, int64_t>(res, max_batch_size, dim);
+    auto batch_ids =
+      raft::make_device_matrix<int64_t, int64_t>(res, max_batch_size, shard_overlap);
+    auto batch_dists =
+      raft::make_device_matrix<float, int64_t>(res, max_batch_size, shard_overlap);
+    auto centers_view =
+      raft::make_device_matrix_view<const float, int64_t>(centers.data_handle(), n_shards, dim);
+    raft::spatial::knn::detail::utils::batch_load_iterator<DataT> vec_batches(
+      dataset.data_handle(), n_rows, dim, max_batch_size, stream);
+    for (const auto& batch : vec_batches) {
+      auto batch_view = raft::make_device_matrix_view<const DataT, int64_t>(
+        batch.data(), batch.size(), batch.row_width());
+      auto float_view =
+        raft::make_device_matrix_view<float, int64_t>(batch_float.data_handle(), batch.size(), dim);
+      raft::linalg::map(res, float_view, mapping<float>{}, batch_view);
+      raft::neighbors::brute_force::knn<int64_t, float, int64_t>(
+        res,
+        std::vector<raft::device_matrix_view<const float, int64_t, row_major>>{centers_view},
+        raft::make_const_mdspan(float_view),
+        raft::make_device_matrix_view<int64_t, int64_t>(
+          batch_ids.data_handle(), batch.size(), shard_overlap),
+        raft::make_device_matrix_view<float, int64_t>(
+          batch_dists.data_handle(), batch.size(), shard_overlap));
+      raft::copy(shard_ids.data_handle() + batch.offset() * shard_overlap,
+                 batch_ids.data_handle(),
+                 batch.size() * shard_overlap,
+                 stream);
+    }
+    resource::sync_stream(res);
+  }
+
+  // Members of each shard in CSR format
+  std::vector<int64_t> shard_offsets(n_shards + 1, 0);
+  for (int64_t i = 0; i < n_rows * shard_overlap; i++) {
+    shard_offsets[shard_ids.data_handle()[i] + 1]++;
+  }
+  std::partial_sum(shard_offsets.begin(), shard_offsets.end(), shard_offsets.begin());
+  std::vector<IdxT> shard_members(shard_offsets.back());
+  {
+    std::vector<int64_t> fill_pos(shard_offsets.begin(), shard_offsets.end() - 1);
+    for (int64_t i = 0; i < n_rows; i++) {
+      for (uint32_t j = 0; j < shard_overlap; j++) {
+        shard_members[fill_pos[shard_ids(i, j)]++] = static_cast<IdxT>(i);
       }
     }
+  }
+  for (uint32_t s = 0; s < n_shards; s++) {
+    RAFT_EXPECTS(shard_offsets[s + 1] - shard_offsets[s] > int64_t(node_degree),
+                 "Shard %u has only %zu vectors, which is not enough for the graph degree %u. "
+                 "Reduce the number of shards.",
+                 s,
+                 size_t(shard_offsets[s + 1] - shard_offsets[s]),
+                 node_degree);
+  }
 
-    size_t num_queries_done = batch.offset() + batch.size();
-    const auto end_clock    = std::chrono::system_clock::now();
-    const auto time =
-      std::chrono::duration_cast<std::chrono::microseconds>(end_clock - start_clock).count() * 1e-6;
-    const auto throughput = num_queries_done / time;
-    RAFT_LOG_DEBUG(
-      "# Search %12lu / %12lu (%3.2f %%), %e queries/sec, %.2f minutes ETA, self included = "
-      "%3.2f %%    \r",
-      num_queries_done,
-      dataset.extent(0),
-      num_queries_done / static_cast<double>(dataset.extent(0)) * 100,
-      throughput,
-      (num_queries - num_queries_done) / throughput / 60,
-      static_cast<double>(num_self_included) / num_queries_done * 100.);
-    first = false;
+  //
+  // Build the sub-graphs one shard at a time and merge them into the output graph
+  //
+  auto num_merged = raft::make_host_vector<uint8_t, int64_t>(n_rows);
+  std::fill(num_merged.data_handle(), num_merged.data_handle() + n_rows, 0);
+  for (uint32_t s = 0; s < n_shards; s++) {
+    const int64_t shard_size = shard_offsets[s + 1] - shard_offsets[s];
+    const IdxT* members      = shard_members.data() + shard_offsets[s];
+    RAFT_LOG_DEBUG("# Building the sub-graph of shard %u / %u (%zu vectors)",
+                   s + 1,
+                   n_shards,
+                   size_t(shard_size));
+
+    auto d_members = raft::make_device_vector<IdxT, int64_t>(res, shard_size);
+    raft::copy(d_members.data_handle(), members, shard_size, stream);
+
+    auto shard_graph = raft::make_host_matrix<IdxT, IdxT>(shard_size, node_degree);
+    if (dataset_on_device) {
+      // The host cannot read the dataset: gather the shard on the device.
+      auto shard_data = raft::make_device_matrix<DataT, IdxT>(res, shard_size, dim);
+      raft::spatial::knn::detail::utils::copy_selected<DataT, DataT, int64_t, IdxT>(
+        shard_size,
+        dim,
+        dataset.data_handle(),
+        d_members.data_handle(),
+        dim,
+        shard_data.data_handle(),
+        dim,
+        stream);
+      build_knn_graph(res, raft::make_const_mdspan(shard_data.view()), shard_graph.view());
+    } else {
+      auto shard_data = raft::make_host_matrix<DataT, IdxT>(shard_size, dim);
+#pragma omp parallel for
+      for (int64_t i = 0; i < shard_size; i++) {
+        std::memcpy(shard_data.data_handle() + i * dim,
+                    dataset.data_handle() + static_cast<int64_t>(members[i]) * dim,
+                    sizeof(DataT) * dim);
+      }
+      build_knn_graph(res, raft::make_const_mdspan(shard_data.view()), shard_graph.view());
+    }
+
+    // Gather the already merged rows of the shard members, merge on the device, scatter back.
+    auto merged_rows = raft::make_host_matrix<IdxT, int64_t>(shard_size, node_degree);
+    auto shard_num_merged = raft::make_host_vector<uint8_t, int64_t>(shard_size);
+#pragma omp parallel for
+    for (int64_t i = 0; i < shard_size; i++) {
+      shard_num_merged(i) = num_merged(members[i]);
+      std::memcpy(merged_rows.data_handle() + i * node_degree,
+                  knn_graph.data_handle() + static_cast<int64_t>(members[i]) * node_degree,
+                  sizeof(IdxT) * node_degree);
+    }
+    auto d_merged_rows = raft::make_device_matrix<IdxT, int64_t>(res, shard_size, node_degree);
+    auto d_shard_graph = raft::make_device_matrix<IdxT, int64_t>(res, shard_size, node_degree);
+    auto d_output      = raft::make_device_matrix<IdxT, int64_t>(res, shard_size, node_degree);
+    auto d_num_merged  = raft::make_device_vector<uint8_t, int64_t>(res, shard_size);
+    raft::copy(d_merged_rows.data_handle(), merged_rows.data_handle(), merged_rows.size(), stream);
+    raft::copy(d_shard_graph.data_handle(), shard_graph.data_handle(), shard_graph.size(), stream);
+    raft::copy(d_num_merged.data_handle(), shard_num_merged.data_handle(), shard_size, stream);
+
+    const dim3 threads(128, 1, 1);
+    const dim3 blocks(raft::ceildiv<int64_t>(shard_size, threads.x), 1, 1);
+    graph::kern_merge_by_rank<IdxT><<<blocks, threads, 0, stream>>>(d_merged_rows.data_handle(),
+                                                                    d_shard_graph.data_handle(),
+                                                                    d_members.data_handle(),
+                                                                    d_num_merged.data_handle(),
+                                                                    d_output.data_handle(),
+                                                                    shard_size,
+                                                                    node_degree);
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+    raft::copy(merged_rows.data_handle(), d_output.data_handle(), merged_rows.size(), stream);
+    resource::sync_stream(res);
+
+#pragma omp parallel for
+    for (int64_t i = 0; i < shard_size; i++) {
+      std::memcpy(knn_graph.data_handle() + static_cast<int64_t>(members[i]) * node_degree,
+                  merged_rows.data_handle() + i * node_degree,
+                  sizeof(IdxT) * node_degree);
+      num_merged(members[i])++;
+    }
   }
-  if (!first) RAFT_LOG_DEBUG("# Finished building kNN graph");
+  RAFT_LOG_DEBUG("# Finished building the sharded kNN graph");
+}
+
+/**
+ * Estimate the memory of building the kNN graph of `n_rows` vectors with an IVF-PQ index of the
+ * default parameters (see `build_knn_graph`): the index and the peak of its build, or of the
+ * batched search and refinement of the dataset. The dataset is assumed to be on the device.
+ */
+template <typename DataT, typename IdxT>
+auto estimate_build_knn_graph_memory(size_t n_rows, size_t dim, size_t node_degree)
+  -> raft::memory_estimate
+{
+  const auto build_params = default_ivf_pq_build_params(n_rows, dim);
+  auto estimate = ivf_pq::detail::estimate_build_memory<DataT, int64_t>(build_params, n_rows, dim);
+
+  ivf_pq::search_params search_params;
+  search_params.n_probes = std::min<size_t>(dim * 2, build_params.n_lists);
+  const uint32_t pq_dim  = build_params.pq_dim;
+  const size_t pq_len    = raft::div_rounding_up_safe<size_t>(dim, pq_dim);
+  const size_t top_k     = node_degree + 1;
+  const size_t gpu_top_k = std::min(std::max<size_t>(node_degree * 2, top_k), n_rows);
+  // the lists are assumed to be of at most twice the average size
+  const size_t max_samples = std::min<size_t>(
+    n_rows,
+    2 * search_params.n_probes * raft::div_rounding_up_safe<size_t>(n_rows, build_params.n_lists));
+  constexpr size_t kMaxBatchSize = 1024;
+  constexpr size_t kNumSlots     = 2;
+  const size_t search_bytes =
+    ivf_pq::detail::estimate_search_workspace<int64_t>(search_params,
+                                                       build_params.n_lists,
+                                                       raft::round_up_safe<size_t>(dim + 1, 8),
+                                                       pq_len * pq_dim,
+                                                       max_samples,
+                                                       kMaxBatchSize,
+                                                       gpu_top_k);
+  // the results of a batch, before and after the refinement
+  const size_t batch_bytes =
+    kMaxBatchSize * (gpu_top_k + top_k) * (sizeof(float) + sizeof(int64_t));
+  estimate.device_workspace = std::max(estimate.device_workspace,
+                                       estimate.device_result + batch_bytes + search_bytes);
+  estimate.device_result    = 0;
+  estimate.host_workspace   = kNumSlots * kMaxBatchSize * top_k * sizeof(int64_t);
+  estimate.host_result      = 0;
+  return estimate;
+}
+
+/**
+ * Estimate the memory of `cagra::build` for `n_rows` vectors of the dimensionality `dim`.
+ *
+ * The result is the index: the dataset and the graph in the device memory. The workspace is the
+ * peak of the kNN graph build (by the selected algorithm, sharded or not) and of the pruning,
+ * along with the intermediate graphs held in the host memory.
+ */
+template <typename DataT, typename IdxT>
+auto estimate_build_memory(const index_params& params, size_t n_rows, size_t dim)
+  -> raft::memory_estimate
+{
+  raft::memory_estimate estimate;
+  if (n_rows < 2) { return estimate; }
+  const size_t intermediate_degree = std::min(params.intermediate_graph_degree, n_rows - 1);
+  const size_t graph_degree        = std::min(params.graph_degree, intermediate_degree);
+
+  // the knn graph build
+  raft::memory_estimate knn;
+  if (params.n_shards > 1) {
+    const size_t shard_overlap = std::min(params.shard_overlap, params.n_shards);
+    const size_t shard_size =
+      raft::div_rounding_up_safe<size_t>(n_rows * shard_overlap, params.n_shards);
+    knn = estimate_build_knn_graph_memory<DataT, IdxT>(shard_size, dim, intermediate_degree);
+    // the gathered shard and its graph, the shard assignments and the members of all the shards
+    knn.host_workspace += shard_size * (dim * sizeof(DataT) + intermediate_degree * sizeof(IdxT)) +
+                          n_rows * (shard_overlap * (sizeof(int64_t) + sizeof(IdxT)) + 1);
+  } else if (params.build_algo == graph_build_algo::NN_DESCENT) {
+    // the degree of the nn-descent graph, see `nn_descent::build`
+    const size_t max_degree = std::min<size_t>(128, n_rows - 1);
+    const size_t degree     = std::min<size_t>(1.5 * intermediate_degree, max_degree);
+    const size_t run_bytes = n_rows * degree * (sizeof(uint8_t) + sizeof(uint64_t)) +
+                             n_rows * sizeof(uint32_t) * (4 * 32 + 3);
+    knn.device_workspace = n_rows * dim * sizeof(half) + n_rows * degree * sizeof(uint64_t) +
+                           std::max(run_bytes, n_rows * intermediate_degree * sizeof(IdxT));
+  } else {
+    knn = estimate_build_knn_graph_memory<DataT, IdxT>(n_rows, dim, intermediate_degree);
+  }
+
+  // the pruning: the dataset, the input graph and the batches of the detour counts, then the
+  // reverse graph
+  constexpr size_t kPruneBatchSize = 256 * 1024;
+  const size_t prune_batch_size    = std::min(n_rows, kPruneBatchSize);
+  const size_t prune_device_bytes =
+    std::max(n_rows * intermediate_degree * sizeof(IdxT) +
+               prune_batch_size * (intermediate_degree + sizeof(uint32_t)),
+             n_rows * (graph_degree * sizeof(IdxT) + sizeof(uint32_t) + 2 * sizeof(IdxT)));
+  const size_t prune_host_bytes =
+    n_rows * (2 * graph_degree * sizeof(IdxT) + intermediate_degree + sizeof(uint32_t) +
+              sizeof(IdxT));
+
+  const size_t knn_graph_bytes = n_rows * intermediate_degree * sizeof(IdxT);
+  const size_t graph_bytes     = n_rows * graph_degree * sizeof(IdxT);
+  estimate.device_result       = n_rows * dim * sizeof(DataT) + graph_bytes;
+  estimate.device_workspace =
+    std::max(knn.device_workspace, n_rows * dim * sizeof(DataT) + prune_device_bytes);
+  estimate.host_workspace =
+    knn_graph_bytes + std::max(knn.host_workspace, graph_bytes + prune_host_bytes);
+  return estimate;
 }
 
 }  // namespace raft::neighbors::experimental::cagra::detail
@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "cagra_search.cuh"
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/host_mdarray.hpp>
+#include <raft/core/logger.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/neighbors/cagra_types.hpp>
+#include <raft/spatial/knn/detail/ann_utils.cuh>
+#include <raft/util/cuda_rt_essentials.hpp>
+#include <raft/util/integer_utils.hpp>
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+namespace raft::neighbors::experimental::cagra::detail {
+
+/**
+ * Count the 2-hop detours of the candidate edges of the new nodes.
+ *
+ * Same as `graph::kern_prune`, except that the candidate lists of the new nodes are not part of
+ * the graph: the 2nd hop (D->B) is looked up in the existing graph of the index.
+ */
+template <int MAX_DEGREE, class IdxT>
+__global__ void kern_count_new_node_detours(
+  const IdxT* const candidates,  // [num_new_nodes, num_candidates]
+  const IdxT* const graph,       // [graph_size, graph_degree]
+  const uint32_t num_new_nodes,
+  const uint32_t num_candidates,
+  const uint32_t graph_degree,
+  uint8_t* const detour_count)  // [num_new_nodes, num_candidates]
+{
+  __shared__ uint32_t smem_num_detour[MAX_DEGREE];
+
+  const uint64_t iA = blockIdx.x;
+  if (iA >= num_new_nodes) { return; }
+  for (uint32_t k = threadIdx.x; k < num_candidates; k += blockDim.x) {
+    smem_num_detour[k] = 0;
+  }
+  __syncthreads();
+
+  const IdxT* const candidates_A = candidates + (static_cast<uint64_t>(num_candidates) * iA);
+  for (uint32_t kAD = 0; kAD < num_candidates - 1; kAD++) {
+    const uint64_t iD = candidates_A[kAD];
+    for (uint32_t kDB = threadIdx.x; kDB < graph_degree; kDB += blockDim.x) {
+      const IdxT iB_candidate = graph[kDB + (static_cast<uint64_t>(graph_degree) * iD)];
+      for (uint32_t kAB = kAD + 1; kAB < num_candidates; kAB++) {
+        if (candidates_A[kAB] == iB_candidate) {
+          atomicAdd(smem_num_detour + kAB, 1);
+          break;
+        }
+      }
+    }
+    __syncthreads();
+  }
+
+  for (uint32_t k = threadIdx.x; k < num_candidates; k += blockDim.x) {
+    detour_count[k + (static_cast<uint64_t>(num_candidates) * iA)] =
+      min(smem_num_detour[k], (uint32_t)255);
+  }
+}
+
+/** Copy `n_rows` rows of the graph, optionally indirected on the source and/or destination side. */
+template <class IdxT>
+__global__ void kern_copy_graph_rows(const IdxT* const src,
+                                     const IdxT* const src_row_ids,  // nullable
+                                     IdxT* const dst,
+                                     const IdxT* const dst_row_ids,  // nullable
+                                     const uint64_t n_rows,
+                                     const uint32_t degree)
+{
+  const uint64_t tid = threadIdx.x + (static_cast<uint64_t>(blockDim.x) * blockIdx.x);
+  if (tid >= n_rows * degree) { return; }
+  const uint64_t i     = tid / degree;
+  const uint64_t k     = tid % degree;
+  const uint64_t src_i = src_row_ids == nullptr ? i : static_cast<uint64_t>(src_row_ids[i]);
+  const uint64_t dst_i = dst_row_ids == nullptr ? i : static_cast<uint64_t>(dst_row_ids[i]);
+  dst[k + degree * dst_i] = src[k + degree * src_i];
+}
+
+template <class IdxT>
+void copy_graph_rows(const IdxT* src,
+                     const IdxT* src_row_ids,
+                     IdxT* dst,
+                     const IdxT* dst_row_ids,
+                     uint64_t n_rows,
+                     uint32_t degree,
+                     rmm::cuda_stream_view stream)
+{
+  if (n_rows == 0) { return; }
+  const dim3 threads(256, 1, 1);
+  const dim3 blocks(raft::ceildiv<uint64_t>(n_rows * degree, threads.x), 1, 1);
+  kern_copy_graph_rows<IdxT>
+    <<<blocks, threads, 0, stream>>>(src, src_row_ids, dst, dst_row_ids, n_rows, degree);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+/**
+ * Add a chunk of vectors (residing in device memory) to the index.
+ *
+ * 1. Search the index for `num_candidates` neighbors of the new vectors.
+ * 2. Rank-based pruning: count the 2-hop detours of the candidate edges via the existing graph and
+ *    keep the `graph_degree` edges with the fewest detours (as in `graph::prune`).
+ * 3. Append the vectors and their neighbor lists to the index.
+ * 4. Add the reverse edges: the new node is inserted into the neighbor lists of its neighbors right
+ *    after the protected (first `graph_degree / 2`) edges, shifting out the last edges
+ *    (as in `graph::prune`).
+ */
+template <typename T, typename IdxT>
+void extend_chunk(raft::resources const& res,
+                  const extend_params& params,
+                  raft::device_matrix_view<const T, IdxT, row_major> new_vectors,
+                  index<T, IdxT>& idx)
+{
+  using internal_IdxT = typename std::make_unsigned<IdxT>::type;
+
+  auto stream                   = resource::get_cuda_stream(res);
+  const IdxT n_new              = new_vectors.extent(0);
+  const IdxT old_size           = idx.size();
+  const uint32_t graph_degree   = idx.graph_degree();
+  const uint32_t num_candidates = std::min<uint64_t>(
+    std::max<uint64_t>(params.intermediate_graph_degree, graph_degree), old_size);
+  const uint64_t num_protected  = graph_degree / 2;
+  constexpr uint32_t kMaxDegree = 1024;
+  RAFT_EXPECTS(num_candidates >= graph_degree,
+               "The index must contain at least graph_degree (%u) vectors to be extended",
+               graph_degree);
+  RAFT_EXPECTS(num_candidates <= kMaxDegree,
+               "The intermediate graph degree cannot be larger than %u",
+               kMaxDegree);
+
+  //
+  // Search the candidate neighbors of the new vectors
+  //
+  auto candidates =
+    raft::make_device_matrix<internal_IdxT, internal_IdxT>(res, n_new, num_candidates);
+  {
+    auto distances = raft::make_device_matrix<float, internal_IdxT>(res, n_new, num_candidates);
+    search_params candidate_search = params.candidate_search;
+    candidate_search.itopk_size    = std::max<size_t>(candidate_search.itopk_size,
+                                                   raft::round_up_safe<size_t>(num_candidates, 32));
+    search_main<T, internal_IdxT, IdxT>(
+      res,
+      candidate_search,
+      idx,
+      raft::make_device_matrix_view<const T, internal_IdxT>(
+        new_vectors.data_handle(), n_new, new_vectors.extent(1)),
+      candidates.view(),
+      distances.view());
+  }
+
+  //
+  // Rank-based pruning of the candidate edges
+  //
+  auto detour_count = raft::make_host_matrix<uint8_t, int64_t>(n_new, num_candidates);
+  auto candidates_h = raft::make_host_matrix<IdxT, int64_t>(n_new, num_candidates);
+  {
+    auto d_detour_count = raft::make_device_matrix<uint8_t, int64_t>(res, n_new, num_candidates);
+    const auto graph    = idx.graph();
+    kern_count_new_node_detours<kMaxDegree, internal_IdxT>
+      <<<n_new, 32, 0, stream>>>(candidates.data_handle(),
+                                 reinterpret_cast<const internal_IdxT*>(graph.data_handle()),
+                                 n_new,
+                                 num_candidates,
+                                 graph_degree,
+                                 d_detour_count.data_handle());
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+    raft::copy(
+      detour_count.data_handle(), d_detour_count.data_handle(), detour_count.size(), stream);
+    raft::copy(candidates_h.data_handle(),
+               reinterpret_cast<const IdxT*>(candidates.data_handle()),
+               candidates_h.size(),
+               stream);
+    resource::sync_stream(res);
+  }
+
+  auto new_graph = raft::make_host_matrix<IdxT, int64_t>(n_new, graph_degree);
+#pragma omp parallel for
+  for (int64_t i = 0; i < static_cast<int64_t>(n_new); i++) {
+    uint64_t pk = 0;
+    for (uint32_t num_detour = 0; num_detour <= 255 && pk < graph_degree; num_detour++) {
+      for (uint64_t k = 0; k < num_candidates && pk < graph_degree; k++) {
+        if (detour_count(i, k) != num_detour) { continue; }
+        new_graph(i, pk++) = candidates_h(i, k);
+      }
+    }
+  }
+
+  //
+  // Append the new nodes
+  //
+  {
+    auto d_new_graph = raft::make_device_matrix<IdxT, IdxT>(res, n_new, graph_degree);
+    raft::copy(d_new_graph.data_handle(), new_graph.data_handle(), new_graph.size(), stream);
+    idx.append(res, new_vectors, raft::make_const_mdspan(d_new_graph.view()));
+    resource::sync_stream(res);
+  }
+
+  //
+  // Add the reverse edges
+  //
+  // (destination node, rank of the edge in the new node's list, new node)
+  std::vector<std::tuple<IdxT, uint32_t, IdxT>> rev_edges;
+  rev_edges.reserve(static_cast<size_t>(n_new) * graph_degree);
+  for (int64_t i = 0; i < static_cast<int64_t>(n_new); i++) {
+    for (uint32_t k = 0; k < graph_degree; k++) {
+      rev_edges.emplace_back(new_graph(i, k), k, old_size + static_cast<IdxT>(i));
+    }
+  }
+  std::sort(rev_edges.begin(), rev_edges.end());
+
+  std::vector<IdxT> dest_ids;
+  std::vector<size_t> dest_offsets;
+  for (size_t e = 0; e < rev_edges.size(); e++) {
+    if (e == 0 || std::get<0>(rev_edges[e]) != std::get<0>(rev_edges[e - 1])) {
+      dest_ids.push_back(std::get<0>(rev_edges[e]));
+      dest_offsets.push_back(e);
+    }
+  }
+  dest_offsets.push_back(rev_edges.size());
+  const uint64_t n_dest = dest_ids.size();
+  if (n_dest == 0) { return; }
+
+  auto d_dest_ids  = raft::make_device_vector<IdxT, int64_t>(res, n_dest);
+  auto d_dest_rows = raft::make_device_matrix<IdxT, int64_t>(res, n_dest, graph_degree);
+  auto dest_rows   = raft::make_host_matrix<IdxT, int64_t>(n_dest, graph_degree);
+  raft::copy(d_dest_ids.data_handle(), dest_ids.data(), n_dest, stream);
+  copy_graph_rows<IdxT>(idx.graph().data_handle(),
+                        d_dest_ids.data_handle(),
+                        d_dest_rows.data_handle(),
+                        nullptr,
+                        n_dest,
+                        graph_degree,
+                        stream);
+  raft::copy(dest_rows.data_handle(), d_dest_rows.data_handle(), dest_rows.size(), stream);
+  resource::sync_stream(res);
+
+#pragma omp parallel for schedule(dynamic, 1024)
+  for (int64_t j = 0; j < static_cast<int64_t>(n_dest); j++) {
+    IdxT* const row = dest_rows.data_handle() + j * graph_degree;
+    // Insert in the reverse order of ranks, so that the closest new node ends up first.
+    for (size_t e = dest_offsets[j + 1]; e > dest_offsets[j]; e--) {
+      const IdxT i = std::get<2>(rev_edges[e - 1]);
+      uint64_t pos = graph_degree;
+      for (uint64_t k = 0; k < graph_degree; k++) {
+        if (row[k] == i) {
+          pos = k;
+          break;
+        }
+      }
+      if (pos < num_protected) { continue; }
+      uint64_t num_shift = pos - num_protected;
+      if (pos == graph_degree) { num_shift = graph_degree - num_protected - 1; }
+      for (uint64_t k = num_protected + num_shift; k > num_protected; k--) {
+        row[k] = row[k - 1];
+      }
+      row[num_protected] = i;
+    }
+  }
+
+  raft::copy(d_dest_rows.data_handle(), dest_rows.data_handle(), dest_rows.size(), stream);
+  copy_graph_rows<IdxT>(d_dest_rows.data_handle(),
+                        nullptr,
+                        idx.graph().data_handle(),
+                        d_dest_ids.data_handle(),
+                        n_dest,
+                        graph_degree,
+                        stream);
+  resource::sync_stream(res);
+}
+
+template <typename T, typename IdxT, typename Accessor>
+void extend(raft::resources const& res,
+            const extend_params& params,
+            raft::mdspan<const T, matrix_extent<IdxT>, row_major, Accessor> new_vectors,
+            index<T, IdxT>& idx)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "cagra::extend(%zu, %u)", size_t(new_vectors.extent(0)), uint32_t(new_vectors.extent(1)));
+  RAFT_EXPECTS(new_vectors.extent(1) == idx.dim(),
+               "Dimensionality of the new vectors must match the index");
+
+  const IdxT n_rows = new_vectors.extent(0);
+  if (n_rows == 0) { return; }
+  // New vectors are linked only to the vectors already in the index; adding them in chunks lets
+  // the later chunks link to the earlier ones.
+  const size_t max_chunk_size =
+    params.max_chunk_size > 0
+      ? params.max_chunk_size
+      : std::max<size_t>(1, std::min<size_t>(static_cast<size_t>(idx.size()), 64 * 1024));
+  // Reserve the space for all the new vectors at once.
+  idx.reserve(res, std::max<IdxT>(idx.size() + n_rows, idx.capacity()));
+
+  spatial::knn::detail::utils::batch_load_iterator<T> vec_batches(new_vectors.data_handle(),
+                                                                  n_rows,
+                                                                  new_vectors.extent(1),
+                                                                  max_chunk_size,
+                                                                  resource::get_cuda_stream(res));
+  for (const auto& batch : vec_batches) {
+    extend_chunk<T, IdxT>(
+      res,
+      params,
+      raft::make_device_matrix_view<const T, IdxT>(batch.data(), batch.size(), batch.row_width()),
+      idx);
+  }
+}
+
+}  // namespace raft::neighbors::experimental::cagra::detail
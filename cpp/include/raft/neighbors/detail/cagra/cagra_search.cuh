@@ -17,21 +17,302 @@
 #pragma once
 
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/cuda_stream_pool.hpp>
 #include <raft/neighbors/detail/ivf_pq_search.cuh>
 #include <raft/spatial/knn/detail/ann_utils.cuh>
+#include <raft/util/integer_utils.hpp>
 
 #include <raft/core/device_mdspan.hpp>
 #include <raft/core/host_mdspan.hpp>
+#include <raft/core/metrics.hpp>
+#include <raft/core/nvtx.hpp>
 #include <raft/core/resources.hpp>
+#include <raft/linalg/map.cuh>
+#include <raft/matrix/select_k.cuh>
 #include <raft/neighbors/cagra_types.hpp>
+#include <raft/neighbors/sample_filter_types.hpp>
 #include <rmm/cuda_stream_view.hpp>
 
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "compressed_dataset.cuh"
 #include "factory.cuh"
 #include "search_plan.cuh"
 #include "search_single_cta.cuh"
 
 namespace raft::neighbors::experimental::cagra::detail {
 
+/**
+ * Queries are searched in batches of `max_queries`; the kernels see the query index within the
+ * batch, so the offset of the batch is added back before the user filter is called.
+ */
+template <class CagraSampleFilterT>
+struct cagra_sample_filter_with_query_id_offset {
+  CagraSampleFilterT filter;
+  uint32_t offset;
+
+  inline _RAFT_HOST_DEVICE bool operator()(const uint32_t query_ix, const uint32_t sample_ix) const
+  {
+    return filter(query_ix + offset, sample_ix);
+  }
+};
+
+template <class CagraSampleFilterT>
+using cagra_internal_sample_filter_t = std::conditional_t<
+  std::is_same_v<CagraSampleFilterT, raft::neighbors::filtering::none_cagra_sample_filter>,
+  CagraSampleFilterT,
+  cagra_sample_filter_with_query_id_offset<CagraSampleFilterT>>;
+
+template <class CagraSampleFilterT>
+inline auto set_query_id_offset(CagraSampleFilterT sample_filter, uint32_t offset)
+  -> cagra_internal_sample_filter_t<CagraSampleFilterT>
+{
+  if constexpr (std::is_same_v<cagra_internal_sample_filter_t<CagraSampleFilterT>,
+                               CagraSampleFilterT>) {
+    return sample_filter;
+  } else {
+    return {sample_filter, offset};
+  }
+}
+
+/**
+ * Seed every query of the plan with the entry points of the index.
+ *
+ * The kernels read the seeds of the i-th query of a batch at `dev_seed + i * num_seeds`, so the
+ * entry points are repeated for all `max_queries` queries of the plan. The seeds take the first
+ * slots of the initial random samples; the ones that do not fit are ignored by the kernels.
+ */
+template <typename PlanT, typename internal_IdxT>
+void set_entry_points(raft::resources const& res,
+                      PlanT& plan,
+                      raft::device_vector_view<const internal_IdxT, internal_IdxT> entry_points)
+{
+  const uint32_t n_entries = entry_points.extent(0);
+  if (n_entries == 0) { return; }
+  plan.num_seeds = n_entries;
+  plan.dev_seed.resize(static_cast<size_t>(plan.max_queries) * n_entries,
+                       resource::get_cuda_stream(res));
+  const internal_IdxT* src = entry_points.data_handle();
+  raft::linalg::map_offset(
+    res,
+    raft::make_device_vector_view<internal_IdxT, size_t>(plan.dev_seed.data(),
+                                                         plan.dev_seed.size()),
+    [src, n_entries] __device__(size_t i) { return src[i % n_entries]; });
+}
+
+/**
+ * Run the search plan on the given dataset in batches of `plan->max_queries`.
+ *
+ * The dataset is either the index dataset, or its compressed copy; in the latter case the queries
+ * must be compressed the same way.
+ *
+ * If the resources hold a stream pool, the batches are distributed round-robin over the pool
+ * streams, so that the kernels of consecutive batches overlap. Every stream has its own search
+ * plan, whose workspace is reused by all the batches of the stream.
+ */
+template <typename DataT, typename internal_IdxT, typename DistanceT, typename CagraSampleFilterT>
+void search_on_dataset(
+  raft::resources const& res,
+  search_params params,
+  raft::device_matrix_view<const DataT, internal_IdxT, layout_stride> dataset,
+  raft::device_matrix_view<const internal_IdxT, internal_IdxT, row_major> graph,
+  raft::device_vector_view<const internal_IdxT, internal_IdxT> entry_points,
+  raft::device_matrix_view<const DataT, internal_IdxT, row_major> queries,
+  raft::device_matrix_view<internal_IdxT, internal_IdxT, row_major> neighbors,
+  raft::device_matrix_view<DistanceT, internal_IdxT, row_major> distances,
+  CagraSampleFilterT sample_filter)
+{
+  uint32_t topk = neighbors.extent(1);
+
+  using internal_filter_t = cagra_internal_sample_filter_t<CagraSampleFilterT>;
+  using plan_t            = search_plan_impl<DataT, internal_IdxT, DistanceT, internal_filter_t>;
+  std::unique_ptr<plan_t> plan =
+    factory<DataT, internal_IdxT, DistanceT, internal_filter_t>::create(
+      res, params, dataset.extent(1), graph.extent(1), topk);
+
+  plan->check(neighbors.extent(1));
+  set_entry_points(res, *plan, entry_points);
+
+  RAFT_LOG_DEBUG("Cagra search");
+  uint32_t max_queries = plan->max_queries;
+  uint32_t query_dim   = queries.extent(1);
+  raft::metrics::record(
+    "cagra::search::batch_size", raft::metrics::metric_kind::count, max_queries);
+
+  auto run_batch = [&](raft::resources const& batch_res, plan_t& batch_plan, unsigned qid) {
+    const uint32_t n_queries         = std::min<std::size_t>(max_queries, queries.extent(0) - qid);
+    internal_IdxT* _topk_indices_ptr = neighbors.data_handle() + (topk * qid);
+    DistanceT* _topk_distances_ptr   = distances.data_handle() + (topk * qid);
+    // todo(tfeher): one could keep distances optional and pass nullptr
+    const DataT* _query_ptr = queries.data_handle() + (query_dim * qid);
+    // All the queries share the same entry points, so the seeds need no batch offset.
+    const internal_IdxT* _seed_ptr =
+      batch_plan.num_seeds > 0 ? reinterpret_cast<const internal_IdxT*>(batch_plan.dev_seed.data())
+                               : nullptr;
+    uint32_t* _num_executed_iterations = nullptr;
+
+    batch_plan(batch_res,
+               dataset,
+               graph,
+               _topk_indices_ptr,
+               _topk_distances_ptr,
+               _query_ptr,
+               n_queries,
+               _seed_ptr,
+               _num_executed_iterations,
+               topk,
+               set_query_id_offset(sample_filter, qid));
+  };
+
+  const size_t n_batches = raft::ceildiv<size_t>(queries.extent(0), max_queries);
+  // The persistent kernel runs in its own stream already
+  const size_t n_streams = resource::is_stream_pool_initialized(res) && !params.persistent
+                             ? std::min(resource::get_stream_pool_size(res), n_batches)
+                             : 1;
+  if (n_streams <= 1) {
+    raft::metrics::stream_timer timer("cagra::search::graph_search",
+                                      resource::get_cuda_stream(res));
+    for (unsigned qid = 0; qid < queries.extent(0); qid += max_queries) {
+      run_batch(res, *plan, qid);
+    }
+    return;
+  }
+
+  RAFT_LOG_DEBUG("# %zu batches over %zu streams", n_batches, n_streams);
+  // The inputs are ready in the main stream
+  resource::wait_stream_pool_on_stream(res);
+  std::vector<std::unique_ptr<raft::resources>> stream_res;
+  std::vector<std::unique_ptr<plan_t>> stream_plans;
+  for (size_t i = 0; i < n_streams; i++) {
+    stream_res.push_back(std::make_unique<raft::resources>(res));
+    resource::set_cuda_stream(*stream_res[i], resource::get_stream_from_stream_pool(res, i));
+    stream_plans.push_back(factory<DataT, internal_IdxT, DistanceT, internal_filter_t>::create(
+      *stream_res[i], params, dataset.extent(1), graph.extent(1), topk));
+    set_entry_points(*stream_res[i], *stream_plans[i], entry_points);
+  }
+  for (size_t batch = 0; batch < n_batches; batch++) {
+    const size_t i = batch % n_streams;
+    run_batch(*stream_res[i], *stream_plans[i], batch * max_queries);
+  }
+  // The main stream waits for all the batches; the workspace of the plans is freed in the order of
+  // their streams.
+  auto main_stream = resource::get_cuda_stream(res);
+  for (size_t i = 0; i < n_streams; i++) {
+    cudaEvent_t event;
+    RAFT_CUDA_TRY(cudaEventCreateWithFlags(&event, cudaEventDisableTiming));
+    RAFT_CUDA_TRY(cudaEventRecord(event, resource::get_stream_from_stream_pool(res, i)));
+    RAFT_CUDA_TRY(cudaStreamWaitEvent(main_stream, event, 0));
+    RAFT_CUDA_TRY(cudaEventDestroy(event));
+  }
+}
+
+/**
+ * Search the compressed copy of the dataset. When `params.refine_topk > 0`, that many candidates
+ * are searched and re-ranked using the exact distances to the original dataset rows.
+ *
+ * @return the scale of the distances written to `distances`, to be restored by the caller.
+ */
+template <typename internal_IdxT, typename IdxT, typename DistanceT, typename CagraSampleFilterT>
+auto search_compressed(raft::resources const& res,
+                       search_params params,
+                       const index<float, IdxT>& index,
+                       raft::device_matrix_view<const float, internal_IdxT, row_major> queries,
+                       raft::device_matrix_view<internal_IdxT, internal_IdxT, row_major> neighbors,
+                       raft::device_matrix_view<DistanceT, internal_IdxT, row_major> distances,
+                       CagraSampleFilterT sample_filter) -> float
+{
+  const uint32_t topk        = neighbors.extent(1);
+  const uint32_t n_cand      = params.refine_topk > 0 ? params.refine_topk : topk;
+  const internal_IdxT n_rows = queries.extent(0);
+  const uint32_t dim         = queries.extent(1);
+  RAFT_EXPECTS(n_cand >= topk, "refine_topk must not be smaller than the number of neighbors");
+
+  auto graph_internal =
+    raft::make_device_matrix_view<const internal_IdxT, internal_IdxT, row_major>(
+      reinterpret_cast<const internal_IdxT*>(index.graph().data_handle()),
+      index.graph().extent(0),
+      index.graph().extent(1));
+  auto entry_points = raft::make_device_vector_view<const internal_IdxT, internal_IdxT>(
+    reinterpret_cast<const internal_IdxT*>(index.entry_points().data_handle()),
+    index.entry_points().extent(0));
+
+  const internal_IdxT n_cand_rows = n_cand > topk ? n_rows : 0;
+  // Without re-ranking, the results are written directly to the output
+  auto cand_neighbors = make_device_matrix<internal_IdxT, internal_IdxT>(res, n_cand_rows, n_cand);
+  auto cand_distances = make_device_matrix<DistanceT, internal_IdxT>(res, n_cand_rows, n_cand);
+
+  auto search_neighbors = n_cand > topk ? cand_neighbors.view() : neighbors;
+  auto search_distances = n_cand > topk ? cand_distances.view() : distances;
+
+  float scale = 1.0f;
+  if (index.compression() == dataset_compression::FP16) {
+    auto dataset = index.dataset_fp16();
+    auto q       = make_device_matrix<half, internal_IdxT>(res, n_rows, dim);
+    compress_rows(res,
+                  q.data_handle(),
+                  dim,
+                  queries.data_handle(),
+                  dim,
+                  n_rows,
+                  dim,
+                  fp16_compression_op{});
+    search_on_dataset(res,
+                      params,
+                      make_device_strided_matrix_view<const half, internal_IdxT, row_major>(
+                        dataset.data_handle(), dataset.extent(0), dim, dataset.stride(0)),
+                      graph_internal,
+                      entry_points,
+                      raft::make_const_mdspan(q.view()),
+                      search_neighbors,
+                      search_distances,
+                      sample_filter);
+  } else {
+    auto dataset = index.dataset_int8();
+    auto q       = make_device_matrix<int8_t, internal_IdxT>(res, n_rows, dim);
+    compress_rows(res,
+                  q.data_handle(),
+                  dim,
+                  queries.data_handle(),
+                  dim,
+                  n_rows,
+                  dim,
+                  int8_compression_op{index.vq_offset().data_handle(), 1.0f / index.vq_scale()});
+    search_on_dataset(res,
+                      params,
+                      make_device_strided_matrix_view<const int8_t, internal_IdxT, row_major>(
+                        dataset.data_handle(), dataset.extent(0), dim, dataset.stride(0)),
+                      graph_internal,
+                      entry_points,
+                      raft::make_const_mdspan(q.view()),
+                      search_neighbors,
+                      search_distances,
+                      sample_filter);
+    // The kernels map the codes to float dividing them by kDivisor.
+    scale = spatial::knn::detail::utils::config<int8_t>::kDivisor * index.vq_scale();
+  }
+  if (n_cand == topk) { return scale; }
+
+  auto dataset = make_device_strided_matrix_view<const float, internal_IdxT, row_major>(
+    index.dataset().data_handle(), index.dataset().extent(0), dim, index.dataset().stride(0));
+  candidate_distances(res,
+                      dataset,
+                      queries,
+                      raft::make_const_mdspan(cand_neighbors.view()),
+                      cand_distances.view());
+  raft::matrix::select_k<DistanceT, internal_IdxT>(
+    res,
+    raft::make_device_matrix_view<const DistanceT, int64_t>(
+      cand_distances.data_handle(), n_rows, n_cand),
+    raft::make_device_matrix_view<const internal_IdxT, int64_t>(
+      cand_neighbors.data_handle(), n_rows, n_cand),
+    raft::make_device_matrix_view<DistanceT, int64_t>(distances.data_handle(), n_rows, topk),
+    raft::make_device_matrix_view<internal_IdxT, int64_t>(neighbors.data_handle(), n_rows, topk),
+    true);
+  return 1.0f;
+}
+
 /**
  * @brief Search ANN using the constructed index.
  *
@@ -48,16 +329,27 @@ namespace raft::neighbors::experimental::cagra::detail {
  * [n_queries, k]
  * @param[out] distances a device matrix view to the distances to the selected neighbors [n_queries,
  * k]
+ * @param[in] sample_filter a filter the greenlights samples for a given query
  */
 
-template <typename T, typename internal_IdxT, typename IdxT = uint32_t, typename DistanceT = float>
+template <typename T,
+          typename internal_IdxT,
+          typename IdxT               = uint32_t,
+          typename DistanceT          = float,
+          typename CagraSampleFilterT = raft::neighbors::filtering::none_cagra_sample_filter>
 void search_main(raft::resources const& res,
                  search_params params,
                  const index<T, IdxT>& index,
                  raft::device_matrix_view<const T, internal_IdxT, row_major> queries,
                  raft::device_matrix_view<internal_IdxT, internal_IdxT, row_major> neighbors,
-                 raft::device_matrix_view<DistanceT, internal_IdxT, row_major> distances)
+                 raft::device_matrix_view<DistanceT, internal_IdxT, row_major> distances,
+                 CagraSampleFilterT sample_filter = CagraSampleFilterT())
 {
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "cagra::search(k = %u, n_queries = %u, dim = %zu)",
+    static_cast<uint32_t>(neighbors.extent(1)),
+    static_cast<uint32_t>(queries.extent(0)),
+    static_cast<size_t>(queries.extent(1)));
   RAFT_LOG_DEBUG("# dataset size = %lu, dim = %lu\n",
                  static_cast<size_t>(index.dataset().extent(0)),
                  static_cast<size_t>(index.dataset().extent(1)));
@@ -65,31 +357,24 @@ void search_main(raft::resources const& res,
                  static_cast<size_t>(queries.extent(0)),
                  static_cast<size_t>(queries.extent(1)));
   RAFT_EXPECTS(queries.extent(1) == index.dim(), "Querise and index dim must match");
-  uint32_t topk = neighbors.extent(1);
-
-  std::unique_ptr<search_plan_impl<T, internal_IdxT, DistanceT>> plan =
-    factory<T, internal_IdxT, DistanceT>::create(
-      res, params, index.dim(), index.graph_degree(), topk);
+  RAFT_EXPECTS(index.dataset().extent(0) == index.size(),
+               "The dataset must be attached to the index before searching");
 
-  plan->check(neighbors.extent(1));
-
-  RAFT_LOG_DEBUG("Cagra search");
-  uint32_t max_queries = plan->max_queries;
-  uint32_t query_dim   = queries.extent(1);
-
-  for (unsigned qid = 0; qid < queries.extent(0); qid += max_queries) {
-    const uint32_t n_queries = std::min<std::size_t>(max_queries, queries.extent(0) - qid);
-    internal_IdxT* _topk_indices_ptr =
-      reinterpret_cast<internal_IdxT*>(neighbors.data_handle()) + (topk * qid);
-    DistanceT* _topk_distances_ptr = distances.data_handle() + (topk * qid);
-    // todo(tfeher): one could keep distances optional and pass nullptr
-    const T* _query_ptr = queries.data_handle() + (query_dim * qid);
-    const internal_IdxT* _seed_ptr =
-      plan->num_seeds > 0
-        ? reinterpret_cast<const internal_IdxT*>(plan->dev_seed.data()) + (plan->num_seeds * qid)
-        : nullptr;
-    uint32_t* _num_executed_iterations = nullptr;
+  static_assert(std::is_same_v<DistanceT, float>,
+                "only float distances are supported at the moment");
+  // We're converting the data from T to DistanceT during distance computation
+  // and divide the values by kDivisor. Here we restore the original scale.
+  float kScale = spatial::knn::detail::utils::config<T>::kDivisor /
+                 spatial::knn::detail::utils::config<DistanceT>::kDivisor;
 
+  bool compressed_search = false;
+  if constexpr (std::is_same_v<T, float>) {
+    if (index.compression() != dataset_compression::NONE) {
+      kScale = search_compressed(res, params, index, queries, neighbors, distances, sample_filter);
+      compressed_search = true;
+    }
+  }
+  if (!compressed_search) {
     auto dataset_internal = make_device_strided_matrix_view<const T, internal_IdxT, row_major>(
       index.dataset().data_handle(),
       index.dataset().extent(0),
@@ -100,27 +385,22 @@ void search_main(raft::resources const& res,
         reinterpret_cast<const internal_IdxT*>(index.graph().data_handle()),
         index.graph().extent(0),
         index.graph().extent(1));
-
-    (*plan)(res,
-            dataset_internal,
-            graph_internal,
-            _topk_indices_ptr,
-            _topk_distances_ptr,
-            _query_ptr,
-            n_queries,
-            _seed_ptr,
-            _num_executed_iterations,
-            topk);
+    auto entry_points = raft::make_device_vector_view<const internal_IdxT, internal_IdxT>(
+      reinterpret_cast<const internal_IdxT*>(index.entry_points().data_handle()),
+      index.entry_points().extent(0));
+    search_on_dataset(res,
+                      params,
+                      dataset_internal,
+                      graph_internal,
+                      entry_points,
+                      queries,
+                      neighbors,
+                      distances,
+                      sample_filter);
   }
 
-  static_assert(std::is_same_v<DistanceT, float>,
-                "only float distances are supported at the moment");
   float* dist_out          = distances.data_handle();
   const DistanceT* dist_in = distances.data_handle();
-  // We're converting the data from T to DistanceT during distance computation
-  // and divide the values by kDivisor. Here we restore the original scale.
-  constexpr float kScale = spatial::knn::detail::utils::config<T>::kDivisor /
-                           spatial::knn::detail::utils::config<DistanceT>::kDivisor;
   ivf_pq::detail::postprocess_distances(dist_out,
                                         dist_in,
                                         index.metric(),
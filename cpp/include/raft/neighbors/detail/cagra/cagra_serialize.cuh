@@ -16,16 +16,29 @@
 
 #pragma once
 
+#include <raft/core/detail/mdspan_device_serializer.hpp>
+#include <raft/core/detail/mdspan_numpy_serializer.hpp>
 #include <raft/core/mdarray.hpp>
 #include <raft/core/serialize.hpp>
 #include <raft/neighbors/cagra_types.hpp>
+#include <raft/util/cuda_rt_essentials.hpp>
 
+#include "compressed_dataset.cuh"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
 #include <fstream>
+#include <vector>
 
 namespace raft::neighbors::experimental::cagra::detail {
 
-// Serialization version 1.
-constexpr int serialization_version = 2;
+// Serialization version 5.
+constexpr int serialization_version = 5;
 
 // NB: we wrap this check in a struct, so that the updated RealSize is easy to see in the error
 // message.
@@ -36,9 +49,56 @@ struct check_index_layout {
                 "paste in the new size and consider updating the serialization logic");
 };
 
-constexpr size_t expected_size = 176;
+constexpr size_t expected_size = 384;
 template struct check_index_layout<sizeof(index<double, std::uint64_t>), expected_size>;
 
+/**
+ * Write a device matrix [n_rows, width] with rows `ld` elements apart as a numpy array.
+ *
+ * The rows are staged through pinned buffers, so that the whole matrix is never copied to host.
+ */
+template <typename T, typename IdxT>
+void serialize_device_rows(
+  raft::resources const& res, std::ostream& os, const T* data, size_t ld, IdxT n_rows, size_t width)
+{
+  namespace numpy = raft::detail::numpy_serializer;
+  numpy::write_header(os,
+                      {numpy::get_numpy_dtype<T>(),
+                       false,
+                       {static_cast<numpy::ndarray_len_t>(n_rows), width}});
+  raft::detail::write_device_rows(res, os, data, sizeof(T) * ld, n_rows, sizeof(T) * width);
+}
+
+/** Read the header of a numpy matrix and check it matches the expected type and shape. */
+template <typename T>
+void check_matrix_header(std::istream& is, size_t n_rows, size_t width)
+{
+  namespace numpy = raft::detail::numpy_serializer;
+  const auto header = numpy::read_header(is);
+  RAFT_EXPECTS(header.dtype == numpy::get_numpy_dtype<T>(),
+               "Expected dtype %s but got %s instead",
+               numpy::get_numpy_dtype<T>().to_string().c_str(),
+               header.dtype.to_string().c_str());
+  RAFT_EXPECTS(!header.fortran_order, "Wrong matrix layout; expected C layout");
+  RAFT_EXPECTS(header.shape.size() == 2 && header.shape[0] == n_rows && header.shape[1] == width,
+               "Incorrect shape: expected (%zu, %zu)",
+               n_rows,
+               width);
+}
+
+/**
+ * Fill a device matrix [n_rows, width] with rows `ld` elements apart from a raw row-major source.
+ *
+ * `read(dst, n_bytes)` copies the next `n_bytes` of the source to the host pointer `dst`. Reading
+ * a chunk into one pinned buffer overlaps with the device copy of the other buffer.
+ */
+template <typename T, typename IdxT, typename ReadF>
+void deserialize_device_rows(
+  raft::resources const& res, T* data, size_t ld, IdxT n_rows, size_t width, ReadF read)
+{
+  raft::detail::read_device_rows(res, data, sizeof(T) * ld, n_rows, sizeof(T) * width, read);
+}
+
 /**
  * Save the index to file.
  *
@@ -47,49 +107,140 @@ template struct check_index_layout<sizeof(index<double, std::uint64_t>), expecte
  * @param[in] res the raft resource handle
  * @param[in] filename the file name for saving the index
  * @param[in] index_ CAGRA index
+ * @param[in] include_dataset whether to write the dataset
  *
  */
 template <typename T, typename IdxT>
-void serialize(raft::resources const& res, std::ostream& os, const index<T, IdxT>& index_)
+void serialize(raft::resources const& res,
+               std::ostream& os,
+               const index<T, IdxT>& index_,
+               bool include_dataset = true)
 {
   RAFT_LOG_DEBUG(
     "Saving CAGRA index, size %zu, dim %u", static_cast<size_t>(index_.size()), index_.dim());
+  RAFT_EXPECTS(!include_dataset || index_.dataset().extent(0) == index_.size(),
+               "The index has no dataset attached");
 
   serialize_scalar(res, os, serialization_version);
   serialize_scalar(res, os, index_.size());
   serialize_scalar(res, os, index_.dim());
   serialize_scalar(res, os, index_.graph_degree());
   serialize_scalar(res, os, index_.metric());
-  auto dataset = index_.dataset();
-  // Remove padding before saving the dataset
-  auto host_dataset = make_host_matrix<T, IdxT>(dataset.extent(0), dataset.extent(1));
-  RAFT_CUDA_TRY(cudaMemcpy2DAsync(host_dataset.data_handle(),
-                                  sizeof(T) * host_dataset.extent(1),
-                                  dataset.data_handle(),
-                                  sizeof(T) * dataset.stride(0),
-                                  sizeof(T) * host_dataset.extent(1),
-                                  dataset.extent(0),
-                                  cudaMemcpyDefault,
-                                  resource::get_cuda_stream(res)));
-  resource::sync_stream(res);
-  serialize_mdspan(res, os, host_dataset.view());
-  serialize_mdspan(res, os, index_.graph());
+  // The compressed copy is recomputed from the dataset on load, if there is one.
+  serialize_scalar(res, os, include_dataset ? index_.compression() : dataset_compression::NONE);
+  serialize_scalar(res, os, include_dataset);
+  if (include_dataset) {
+    // The padding of the rows is not saved
+    auto dataset = index_.dataset();
+    serialize_device_rows(
+      res, os, dataset.data_handle(), dataset.stride(0), index_.size(), index_.dim());
+  }
+  serialize_device_rows(res,
+                        os,
+                        index_.graph().data_handle(),
+                        index_.graph_degree(),
+                        index_.size(),
+                        index_.graph_degree());
+  serialize_scalar(res, os, index_.entry_points().extent(0));
+  if (index_.entry_points().extent(0) > 0) { serialize_mdspan(res, os, index_.entry_points()); }
 }
 
 template <typename T, typename IdxT>
 void serialize(raft::resources const& res,
                const std::string& filename,
-               const index<T, IdxT>& index_)
+               const index<T, IdxT>& index_,
+               bool include_dataset = true)
 {
   std::ofstream of(filename, std::ios::out | std::ios::binary);
   if (!of) { RAFT_FAIL("Cannot open file %s", filename.c_str()); }
 
-  detail::serialize(res, of, index_);
+  detail::serialize(res, of, index_, include_dataset);
 
   of.close();
   if (!of) { RAFT_FAIL("Error writing output %s", filename.c_str()); }
 }
 
+/** The scalars stored at the beginning of a serialized index. */
+template <typename IdxT>
+struct index_header {
+  IdxT n_rows;
+  std::uint32_t dim;
+  std::uint32_t graph_degree;
+  raft::distance::DistanceType metric;
+  dataset_compression compression;
+  bool include_dataset;
+};
+
+template <typename IdxT>
+auto deserialize_header(raft::resources const& res, std::istream& is) -> index_header<IdxT>
+{
+  auto ver = deserialize_scalar<int>(res, is);
+  if (ver != serialization_version) {
+    RAFT_FAIL("serialization version mismatch, expected %d, got %d ", serialization_version, ver);
+  }
+  index_header<IdxT> h;
+  h.n_rows          = deserialize_scalar<IdxT>(res, is);
+  h.dim             = deserialize_scalar<std::uint32_t>(res, is);
+  h.graph_degree    = deserialize_scalar<std::uint32_t>(res, is);
+  h.metric          = deserialize_scalar<raft::distance::DistanceType>(res, is);
+  h.compression     = deserialize_scalar<dataset_compression>(res, is);
+  h.include_dataset = deserialize_scalar<bool>(res, is);
+  return h;
+}
+
+/**
+ * Load the arrays of an index straight into the device memory.
+ *
+ * `array_reader(is_dataset)` is called once per stored array, in order; it returns the reader of
+ * the array content for `deserialize_device_rows`.
+ */
+template <typename T, typename IdxT, typename ArrayReaderF>
+auto deserialize_arrays(raft::resources const& res,
+                        const index_header<IdxT>& h,
+                        ArrayReaderF array_reader) -> index<T, IdxT>
+{
+  using AlignDim = typename index<T, IdxT>::AlignDim;
+  index<T, IdxT> idx(res, h.metric);
+  auto dataset =
+    make_device_matrix<T, IdxT>(res, h.include_dataset ? h.n_rows : 0, AlignDim::roundUp(h.dim));
+  if (h.include_dataset) {
+    RAFT_CUDA_TRY(cudaMemsetAsync(
+      dataset.data_handle(), 0, dataset.size() * sizeof(T), resource::get_cuda_stream(res)));
+    deserialize_device_rows(
+      res, dataset.data_handle(), dataset.extent(1), h.n_rows, h.dim, array_reader(true));
+  }
+  auto graph = make_device_matrix<IdxT, IdxT>(res, h.n_rows, h.graph_degree);
+  deserialize_device_rows(
+    res, graph.data_handle(), graph.extent(1), h.n_rows, h.graph_degree, array_reader(false));
+  idx.update_graph(res, std::move(graph));
+  idx.update_dataset(res, std::move(dataset), h.dim);
+  // The compressed copy of the dataset is not stored, but recomputed from the dataset.
+  compress_dataset(res, idx, h.compression);
+  return idx;
+}
+
+/** Read the entry points stored after the graph. */
+template <typename IdxT>
+auto deserialize_entry_points(raft::resources const& res, std::istream& is)
+  -> raft::device_vector<IdxT, IdxT>
+{
+  auto n_entry_points = deserialize_scalar<IdxT>(res, is);
+  auto entry_points   = make_device_vector<IdxT, IdxT>(res, n_entry_points);
+  if (n_entry_points > 0) { deserialize_mdspan(res, is, entry_points.view()); }
+  return entry_points;
+}
+
+/** Read the numpy header of the dataset or the graph array of the index. */
+template <typename T, typename IdxT>
+void check_array_header(std::istream& is, const index_header<IdxT>& h, bool is_dataset)
+{
+  if (is_dataset) {
+    check_matrix_header<T>(is, h.n_rows, h.dim);
+  } else {
+    check_matrix_header<IdxT>(is, h.n_rows, h.graph_degree);
+  }
+}
+
 /** Load an index from file.
  *
  * Experimental, both the API and the serialization format are subject to change.
@@ -102,34 +253,142 @@ void serialize(raft::resources const& res,
 template <typename T, typename IdxT>
 auto deserialize(raft::resources const& res, std::istream& is) -> index<T, IdxT>
 {
-  auto ver = deserialize_scalar<int>(res, is);
-  if (ver != serialization_version) {
-    RAFT_FAIL("serialization version mismatch, expected %d, got %d ", serialization_version, ver);
-  }
-  auto n_rows       = deserialize_scalar<IdxT>(res, is);
-  auto dim          = deserialize_scalar<std::uint32_t>(res, is);
-  auto graph_degree = deserialize_scalar<std::uint32_t>(res, is);
-  auto metric       = deserialize_scalar<raft::distance::DistanceType>(res, is);
-
-  auto dataset = raft::make_host_matrix<T, IdxT>(n_rows, dim);
-  auto graph   = raft::make_host_matrix<IdxT, IdxT>(n_rows, graph_degree);
-  deserialize_mdspan(res, is, dataset.view());
-  deserialize_mdspan(res, is, graph.view());
-
-  return index<T, IdxT>(res, metric, raft::make_const_mdspan(dataset.view()), graph.view());
+  auto h   = deserialize_header<IdxT>(res, is);
+  auto idx = deserialize_arrays<T, IdxT>(res, h, [&](bool is_dataset) {
+    check_array_header<T>(is, h, is_dataset);
+    return [&is](char* dst, size_t n_bytes) {
+      is.read(dst, n_bytes);
+      RAFT_EXPECTS(is.good(), "Error while reading mdspan content");
+    };
+  });
+  idx.update_entry_points(res, deserialize_entry_points<IdxT>(res, is));
+  return idx;
 }
 
+/**
+ * Load an index from file.
+ *
+ * The file is mapped to memory and the arrays are copied to the device in chunks through pinned
+ * buffers, overlapping the reading of the file with the host-to-device copies.
+ */
 template <typename T, typename IdxT>
 auto deserialize(raft::resources const& res, const std::string& filename) -> index<T, IdxT>
 {
+  // Parse the headers to find where the arrays are
   std::ifstream is(filename, std::ios::in | std::ios::binary);
-
   if (!is) { RAFT_FAIL("Cannot open file %s", filename.c_str()); }
+  auto h = deserialize_header<IdxT>(res, is);
+  std::vector<size_t> array_begin;
+  std::vector<size_t> array_bytes;
+  for (bool is_dataset : {true, false}) {
+    if (is_dataset && !h.include_dataset) { continue; }
+    check_array_header<T>(is, h, is_dataset);
+    array_begin.push_back(static_cast<size_t>(is.tellg()));
+    array_bytes.push_back(is_dataset ? sizeof(T) * h.n_rows * h.dim
+                                     : sizeof(IdxT) * h.n_rows * h.graph_degree);
+    is.seekg(array_bytes.back(), std::ios::cur);
+  }
+  // The entry points are small; they are read with the headers.
+  auto entry_points = deserialize_entry_points<IdxT>(res, is);
+  RAFT_EXPECTS(is.good(), "Error while reading the headers of %s", filename.c_str());
+  is.close();
 
-  auto index = detail::deserialize<T, IdxT>(res, is);
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) { RAFT_FAIL("Cannot open file %s", filename.c_str()); }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    RAFT_FAIL("Cannot stat file %s", filename.c_str());
+  }
+  const size_t file_size = st.st_size;
+  RAFT_EXPECTS(array_begin.back() + array_bytes.back() <= file_size,
+               "The file %s is truncated",
+               filename.c_str());
+  void* mapped = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED) { RAFT_FAIL("Cannot map file %s", filename.c_str()); }
+  madvise(mapped, file_size, MADV_SEQUENTIAL);
 
-  is.close();
+  size_t i_array = 0;
+  try {
+    auto idx = deserialize_arrays<T, IdxT>(res, h, [&](bool) {
+      const char* src = static_cast<const char*>(mapped) + array_begin[i_array++];
+      return [src](char* dst, size_t n_bytes) mutable {
+        std::memcpy(dst, src, n_bytes);
+        src += n_bytes;
+      };
+    });
+    munmap(mapped, file_size);
+    idx.update_entry_points(res, std::move(entry_points));
+    return idx;
+  } catch (...) {
+    munmap(mapped, file_size);
+    throw;
+  }
+}
+// Serialization version of the search parameters.
+constexpr int search_params_serialization_version = 1;
 
-  return index;
+template <typename T, size_t ExpectedSize>
+struct check_search_params_layout {
+  static_assert(sizeof(T) == ExpectedSize,
+                "The size of the search_params struct has changed since the last update; "
+                "paste in the new size and consider updating the serialization logic");
+};
+template struct check_search_params_layout<search_params, 112>;
+
+/** Save the search parameters, e.g. the ones found by `tune_search_params`, to a stream. */
+inline void serialize_search_params(raft::resources const& res,
+                                    std::ostream& os,
+                                    const search_params& params)
+{
+  serialize_scalar(res, os, search_params_serialization_version);
+  serialize_scalar(res, os, params.max_queries);
+  serialize_scalar(res, os, params.itopk_size);
+  serialize_scalar(res, os, params.max_iterations);
+  serialize_scalar(res, os, params.algo);
+  serialize_scalar(res, os, params.team_size);
+  serialize_scalar(res, os, params.num_parents);
+  serialize_scalar(res, os, params.min_iterations);
+  serialize_scalar(res, os, params.thread_block_size);
+  serialize_scalar(res, os, params.hashmap_mode);
+  serialize_scalar(res, os, params.hashmap_min_bitlen);
+  serialize_scalar(res, os, params.hashmap_max_fill_rate);
+  serialize_scalar(res, os, params.num_random_samplings);
+  serialize_scalar(res, os, params.rand_xor_mask);
+  serialize_scalar(res, os, params.refine_topk);
+  serialize_scalar(res, os, params.persistent);
+  serialize_scalar(res, os, params.persistent_device_usage);
+}
+
+/** Load the search parameters saved by `serialize_search_params`. */
+inline auto deserialize_search_params(raft::resources const& res, std::istream& is)
+  -> search_params
+{
+  auto ver = deserialize_scalar<int>(res, is);
+  if (ver != search_params_serialization_version) {
+    RAFT_FAIL("serialization version mismatch, expected %d, got %d ",
+              search_params_serialization_version,
+              ver);
+  }
+  search_params params;
+  params.max_queries             = deserialize_scalar<size_t>(res, is);
+  params.itopk_size              = deserialize_scalar<size_t>(res, is);
+  params.max_iterations          = deserialize_scalar<size_t>(res, is);
+  params.algo                    = deserialize_scalar<search_algo>(res, is);
+  params.team_size               = deserialize_scalar<size_t>(res, is);
+  params.num_parents             = deserialize_scalar<size_t>(res, is);
+  params.min_iterations          = deserialize_scalar<size_t>(res, is);
+  params.thread_block_size       = deserialize_scalar<size_t>(res, is);
+  params.hashmap_mode            = deserialize_scalar<hash_mode>(res, is);
+  params.hashmap_min_bitlen      = deserialize_scalar<size_t>(res, is);
+  params.hashmap_max_fill_rate   = deserialize_scalar<float>(res, is);
+  params.num_random_samplings    = deserialize_scalar<uint32_t>(res, is);
+  params.rand_xor_mask           = deserialize_scalar<uint64_t>(res, is);
+  params.refine_topk             = deserialize_scalar<size_t>(res, is);
+  params.persistent              = deserialize_scalar<bool>(res, is);
+  params.persistent_device_usage = deserialize_scalar<float>(res, is);
+  return params;
 }
+
 }  // namespace raft::neighbors::experimental::cagra::detail
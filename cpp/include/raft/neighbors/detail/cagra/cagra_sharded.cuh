@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/host_mdspan.hpp>
+#include <raft/core/multi_device_resources.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_id.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/neighbors/cagra_types.hpp>
+#include <raft/neighbors/detail/knn_merge_parts.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace raft::neighbors::experimental::cagra::detail {
+
+template <typename T, typename IdxT, typename BuildF>
+auto build_sharded(const std::vector<raft::resources>& res,
+                   raft::host_matrix_view<const T, IdxT, row_major> dataset,
+                   BuildF build_shard) -> sharded_index<T, IdxT>
+{
+  const size_t n_shards = res.size();
+  RAFT_EXPECTS(n_shards > 0, "At least one device handle is required");
+  RAFT_EXPECTS(static_cast<size_t>(dataset.extent(0)) >= n_shards,
+               "The dataset must have at least one row per shard");
+
+  sharded_index<T, IdxT> idx;
+  for (size_t i = 0; i < n_shards; i++) {
+    idx.offsets.push_back(static_cast<IdxT>(dataset.extent(0) * i / n_shards));
+  }
+  std::vector<std::unique_ptr<index<T, IdxT>>> shards(n_shards);
+  raft::detail::for_each_device(res, [&](size_t i) {
+    const IdxT begin = idx.offsets[i];
+    const IdxT end   = i + 1 < n_shards ? idx.offsets[i + 1] : dataset.extent(0);
+    auto shard_view  = raft::make_host_matrix_view<const T, IdxT>(
+      dataset.data_handle() + static_cast<size_t>(begin) * dataset.extent(1),
+      end - begin,
+      dataset.extent(1));
+    shards[i] = std::make_unique<index<T, IdxT>>(build_shard(res[i], shard_view));
+    resource::sync_stream(res[i]);
+  });
+  for (auto& shard : shards) {
+    idx.shards.push_back(std::move(*shard));
+  }
+  return idx;
+}
+
+template <typename T, typename IdxT, typename SearchF>
+void search_sharded(const std::vector<raft::resources>& res,
+                    const sharded_index<T, IdxT>& idx,
+                    raft::device_matrix_view<const T, IdxT, row_major> queries,
+                    raft::device_matrix_view<IdxT, IdxT, row_major> neighbors,
+                    raft::device_matrix_view<float, IdxT, row_major> distances,
+                    SearchF search_shard)
+{
+  const size_t n_shards = idx.shards.size();
+  RAFT_EXPECTS(n_shards > 0 && res.size() == n_shards,
+               "One device handle per shard is required (%zu handles, %zu shards)",
+               res.size(),
+               n_shards);
+  RAFT_EXPECTS(queries.extent(1) == idx.dim(), "Queries and index dim must match");
+  const IdxT n_queries = queries.extent(0);
+  const IdxT k         = neighbors.extent(1);
+  const uint32_t dim   = queries.extent(1);
+  if (n_queries == 0) { return; }
+
+  // The queries and the results live on the device of the first handle; the neighbors of all the
+  // shards are gathered there and merged.
+  const auto& res0      = res[0];
+  const int dev0        = resource::get_device_id(res0);
+  auto all_neighbors    = make_device_matrix<IdxT, IdxT>(res0, n_shards * n_queries, k);
+  auto all_distances    = make_device_matrix<float, IdxT>(res0, n_shards * n_queries, k);
+  auto shard_offsets    = make_device_vector<IdxT, IdxT>(res0, n_shards);
+  auto stream0          = resource::get_cuda_stream(res0);
+  const size_t out_size = static_cast<size_t>(n_queries) * k;
+  raft::copy(shard_offsets.data_handle(), idx.offsets.data(), n_shards, stream0);
+  // The other devices read the queries after this point.
+  resource::sync_stream(res0);
+
+  raft::detail::for_each_device(res, [&](size_t i) {
+    auto shard_neighbors = raft::make_device_matrix_view<IdxT, IdxT>(
+      all_neighbors.data_handle() + i * out_size, n_queries, k);
+    auto shard_distances = raft::make_device_matrix_view<float, IdxT>(
+      all_distances.data_handle() + i * out_size, n_queries, k);
+    if (i == 0) {
+      search_shard(res0, idx.shards[0], queries, shard_neighbors, shard_distances);
+      return;
+    }
+    const int dev = resource::get_device_id(res[i]);
+    auto stream   = resource::get_cuda_stream(res[i]);
+    auto q        = make_device_matrix<T, IdxT>(res[i], n_queries, dim);
+    auto nbrs     = make_device_matrix<IdxT, IdxT>(res[i], n_queries, k);
+    auto dists    = make_device_matrix<float, IdxT>(res[i], n_queries, k);
+    RAFT_CUDA_TRY(cudaMemcpyPeerAsync(
+      q.data_handle(), dev, queries.data_handle(), dev0, q.size() * sizeof(T), stream));
+    search_shard(
+      res[i], idx.shards[i], raft::make_const_mdspan(q.view()), nbrs.view(), dists.view());
+    RAFT_CUDA_TRY(cudaMemcpyPeerAsync(shard_neighbors.data_handle(),
+                                      dev0,
+                                      nbrs.data_handle(),
+                                      dev,
+                                      out_size * sizeof(IdxT),
+                                      stream));
+    RAFT_CUDA_TRY(cudaMemcpyPeerAsync(shard_distances.data_handle(),
+                                      dev0,
+                                      dists.data_handle(),
+                                      dev,
+                                      out_size * sizeof(float),
+                                      stream));
+    // The temporary buffers are released when the copies are done.
+    resource::sync_stream(res[i]);
+  });
+
+  // The neighbors of the first shard are computed in stream0, the other ones are already copied.
+  raft::neighbors::detail::knn_merge_parts(all_distances.data_handle(),
+                                           all_neighbors.data_handle(),
+                                           distances.data_handle(),
+                                           neighbors.data_handle(),
+                                           n_queries,
+                                           n_shards,
+                                           k,
+                                           stream0,
+                                           shard_offsets.data_handle());
+}
+
+}  // namespace raft::neighbors::experimental::cagra::detail
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/error.hpp>
+#include <raft/core/host_mdarray.hpp>
+#include <raft/core/logger.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/neighbors/cagra_types.hpp>
+#include <raft/util/cudart_utils.hpp>
+#include <raft/util/integer_utils.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <unordered_set>
+#include <vector>
+
+namespace raft::neighbors::experimental::cagra::detail {
+
+/** Fraction of the ground truth neighbors found by the search, over all the queries. */
+template <typename IdxT>
+auto neighbors_recall(raft::host_matrix_view<const IdxT, int64_t, row_major> found,
+                      raft::host_matrix_view<const IdxT, int64_t, row_major> truth) -> double
+{
+  const int64_t k = found.extent(1);
+  size_t n_hits   = 0;
+  std::unordered_set<IdxT> truth_set;
+  for (int64_t i = 0; i < found.extent(0); i++) {
+    truth_set.clear();
+    for (int64_t j = 0; j < k; j++) {
+      truth_set.insert(truth(i, j));
+    }
+    for (int64_t j = 0; j < k; j++) {
+      n_hits += truth_set.count(found(i, j));
+    }
+  }
+  return found.size() == 0 ? 1.0 : static_cast<double>(n_hits) / found.size();
+}
+
+/** Recall and latency of a search configuration; the latency is infinite if it is not usable. */
+struct tune_result {
+  search_params params;
+  double recall  = 0;
+  double latency = std::numeric_limits<double>::infinity();
+};
+
+/**
+ * Search the space of the search parameters for the fastest configuration reaching the target
+ * recall.
+ *
+ * For every combination of the algorithm, the team size and the number of parents, the internal
+ * top-k size is doubled until the target recall is reached (larger sizes are only slower). The
+ * thread block size and the hash map mode of the fastest configuration are then refined one at a
+ * time.
+ *
+ * @param search `search(params)` runs the search of the sample queries into `neighbors`, and may
+ *   throw raft::exception for unsupported parameter combinations.
+ */
+template <typename IdxT, typename SearchF>
+auto tune_search_params(raft::resources const& res,
+                        const search_params& base,
+                        raft::device_matrix_view<const IdxT, int64_t, row_major> ground_truth,
+                        raft::device_matrix_view<const IdxT, int64_t, row_major> neighbors,
+                        float target_recall,
+                        uint32_t n_repeats,
+                        SearchF search) -> search_params
+{
+  const int64_t n_queries = neighbors.extent(0);
+  const int64_t k         = neighbors.extent(1);
+  RAFT_EXPECTS(ground_truth.extent(0) == n_queries && ground_truth.extent(1) >= k,
+               "The ground truth must have at least k neighbors for every sample query");
+  RAFT_EXPECTS(n_repeats > 0, "At least one timed search is required");
+  auto stream = resource::get_cuda_stream(res);
+
+  // Only the first k columns of the ground truth are compared with the results
+  auto truth = make_host_matrix<IdxT, int64_t>(n_queries, k);
+  RAFT_CUDA_TRY(cudaMemcpy2DAsync(truth.data_handle(),
+                                  sizeof(IdxT) * k,
+                                  ground_truth.data_handle(),
+                                  sizeof(IdxT) * ground_truth.extent(1),
+                                  sizeof(IdxT) * k,
+                                  n_queries,
+                                  cudaMemcpyDefault,
+                                  stream));
+  auto found = make_host_matrix<IdxT, int64_t>(n_queries, k);
+
+  auto evaluate = [&](const search_params& params) {
+    tune_result r{params};
+    try {
+      // The first run is the warm-up and provides the results
+      search(params);
+      raft::copy(found.data_handle(), neighbors.data_handle(), neighbors.size(), stream);
+      resource::sync_stream(res);
+      r.recall = neighbors_recall(raft::make_const_mdspan(found.view()),
+                                  raft::make_const_mdspan(truth.view()));
+      if (r.recall < target_recall) { return r; }
+      for (uint32_t i = 0; i < n_repeats; i++) {
+        auto start = std::chrono::steady_clock::now();
+        search(params);
+        resource::sync_stream(res);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        r.latency = std::min(r.latency, elapsed.count());
+      }
+    } catch (const raft::exception& e) {
+      RAFT_LOG_DEBUG("# tune: skipping an unsupported configuration: %s", e.what());
+    }
+    return r;
+  };
+
+  // The configuration with the highest recall is returned if the target is not reachable
+  tune_result best{base};
+  tune_result most_accurate{base};
+  auto consider = [&](const tune_result& r) {
+    if (r.latency < best.latency) { best = r; }
+    if (r.recall > most_accurate.recall) { most_accurate = r; }
+    return r.latency < std::numeric_limits<double>::infinity();
+  };
+
+  std::vector<search_algo> algos{base.algo};
+  if (base.algo == search_algo::AUTO) {
+    algos = {search_algo::SINGLE_CTA, search_algo::MULTI_CTA, search_algo::MULTI_KERNEL};
+  }
+  std::vector<size_t> team_sizes{base.team_size};
+  if (base.team_size == 0) { team_sizes = {0, 8, 16, 32}; }
+  const size_t min_itopk = raft::round_up_safe<size_t>(std::max<size_t>(k, 32), 32);
+  const size_t max_itopk = std::max<size_t>(min_itopk, 512);
+  const size_t parents[] = {1, 2, 4};
+  for (auto algo : algos) {
+    for (auto team_size : team_sizes) {
+      for (auto num_parents : parents) {
+        for (size_t itopk = min_itopk; itopk <= max_itopk; itopk *= 2) {
+          auto params        = base;
+          params.algo        = algo;
+          params.team_size   = team_size;
+          params.num_parents = num_parents;
+          params.itopk_size  = itopk;
+          if (consider(evaluate(params))) { break; }
+        }
+      }
+    }
+  }
+
+  if (best.latency == std::numeric_limits<double>::infinity()) {
+    RAFT_LOG_WARN("The target recall %f is not reachable; the best recall found is %f",
+                  target_recall,
+                  most_accurate.recall);
+    return most_accurate.params;
+  }
+
+  for (size_t thread_block_size : {64, 128, 256, 512, 1024}) {
+    auto params              = best.params;
+    params.thread_block_size = thread_block_size;
+    consider(evaluate(params));
+  }
+  for (auto hashmap_mode : {hash_mode::HASH, hash_mode::SMALL}) {
+    auto params         = best.params;
+    params.hashmap_mode = hashmap_mode;
+    consider(evaluate(params));
+  }
+  RAFT_LOG_DEBUG("# tune: recall %f, latency %f s, algo %d, itopk_size %zu, num_parents %zu",
+                 best.recall,
+                 best.latency,
+                 static_cast<int>(best.params.algo),
+                 best.params.itopk_size,
+                 best.params.num_parents);
+  return best.params;
+}
+
+}  // namespace raft::neighbors::experimental::cagra::detail
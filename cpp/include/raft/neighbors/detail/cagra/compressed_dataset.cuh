@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/host_mdarray.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/linalg/reduce.cuh>
+#include <raft/neighbors/cagra_types.hpp>
+#include <raft/spatial/knn/detail/ann_utils.cuh>
+#include <raft/util/cuda_rt_essentials.hpp>
+#include <raft/util/cudart_utils.hpp>
+#include <raft/util/integer_utils.hpp>
+#include <raft/util/pow2_utils.cuh>
+
+#include <cuda_fp16.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace raft::neighbors::experimental::cagra::detail {
+
+/** Converts the dataset or query values to half precision. */
+struct fp16_compression_op {
+  __device__ inline auto operator()(float x, uint32_t) const -> half { return __float2half(x); }
+};
+
+/** Scalar-quantizes the dataset or query values: `code = round((x - offset[j]) / scale)`. */
+struct int8_compression_op {
+  const float* offset;
+  float inv_scale;
+
+  __device__ inline auto operator()(float x, uint32_t j) const -> int8_t
+  {
+    const float code = roundf((x - offset[j]) * inv_scale);
+    return static_cast<int8_t>(fminf(fmaxf(code, -127.0f), 127.0f));
+  }
+};
+
+template <typename OutT, typename InT, typename CompressionOp>
+__global__ void kern_compress_rows(OutT* const out,  // [n_rows, out_ld]
+                                   const uint64_t out_ld,
+                                   const InT* const in,  // [n_rows, in_ld]
+                                   const uint64_t in_ld,
+                                   const uint64_t n_rows,
+                                   const uint32_t dim,
+                                   CompressionOp op)
+{
+  const uint64_t tid = threadIdx.x + static_cast<uint64_t>(blockDim.x) * blockIdx.x;
+  if (tid >= n_rows * dim) { return; }
+  const uint64_t i    = tid / dim;
+  const uint32_t j    = tid % dim;
+  out[i * out_ld + j] = op(spatial::knn::detail::utils::mapping<float>{}(in[i * in_ld + j]), j);
+}
+
+/** Compress the first `dim` columns of the rows of `in`; the padding of `out` is not touched. */
+template <typename OutT, typename InT, typename CompressionOp>
+void compress_rows(raft::resources const& res,
+                   OutT* out,
+                   uint64_t out_ld,
+                   const InT* in,
+                   uint64_t in_ld,
+                   uint64_t n_rows,
+                   uint32_t dim,
+                   CompressionOp op)
+{
+  if (n_rows == 0) { return; }
+  constexpr uint32_t block_size = 256;
+  const uint64_t grid_size      = raft::ceildiv<uint64_t>(n_rows * dim, block_size);
+  kern_compress_rows<<<grid_size, block_size, 0, resource::get_cuda_stream(res)>>>(
+    out, out_ld, in, in_ld, n_rows, dim, op);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+/**
+ * Create the compressed copy of the index dataset used by the search kernels.
+ *
+ * The int8 codes share one scale for all dimensions: with a scale per dimension the L2 distance
+ * between the codes would need to be weighted by the squared scales, which the search kernels do
+ * not do. The per-dimension offset centers the range of every dimension.
+ */
+template <typename T, typename IdxT>
+void compress_dataset(raft::resources const& res,
+                      index<T, IdxT>& idx,
+                      dataset_compression compression)
+{
+  if (compression == dataset_compression::NONE) { return; }
+  RAFT_EXPECTS((std::is_same_v<T, float>), "Only float datasets can be compressed");
+  auto stream        = resource::get_cuda_stream(res);
+  auto dataset       = idx.dataset();
+  const IdxT n_rows  = dataset.extent(0);
+  const uint32_t dim = dataset.extent(1);
+
+  if (compression == dataset_compression::FP16) {
+    using AlignDim = raft::Pow2<16 / sizeof(half)>;
+    auto out = make_device_matrix<half, IdxT>(res, n_rows, AlignDim::roundUp(dim));
+    RAFT_CUDA_TRY(cudaMemsetAsync(out.data_handle(), 0, out.size() * sizeof(half), stream));
+    compress_rows(res,
+                  out.data_handle(),
+                  out.extent(1),
+                  dataset.data_handle(),
+                  dataset.stride(0),
+                  n_rows,
+                  dim,
+                  fp16_compression_op{});
+    idx.update_dataset(res, std::move(out));
+    return;
+  }
+
+  // Range of every dimension; the zero padding of the rows is reduced as well, but not used.
+  const IdxT ld = dataset.stride(0);
+  auto col_min  = make_device_vector<float, IdxT>(res, ld);
+  auto col_max  = make_device_vector<float, IdxT>(res, ld);
+  raft::linalg::reduce(col_min.data_handle(),
+                       dataset.data_handle(),
+                       ld,
+                       n_rows,
+                       std::numeric_limits<float>::max(),
+                       true,
+                       false,
+                       stream,
+                       false,
+                       raft::cast_op<float>{},
+                       raft::min_op{});
+  raft::linalg::reduce(col_max.data_handle(),
+                       dataset.data_handle(),
+                       ld,
+                       n_rows,
+                       std::numeric_limits<float>::lowest(),
+                       true,
+                       false,
+                       stream,
+                       false,
+                       raft::cast_op<float>{},
+                       raft::max_op{});
+  auto offset_h  = make_host_vector<float, IdxT>(dim);
+  auto col_max_h = make_host_vector<float, IdxT>(dim);
+  raft::copy(offset_h.data_handle(), col_min.data_handle(), dim, stream);
+  raft::copy(col_max_h.data_handle(), col_max.data_handle(), dim, stream);
+  resource::sync_stream(res);
+  float half_range = 0;
+  for (uint32_t j = 0; j < dim; j++) {
+    half_range  = std::max(half_range, (col_max_h(j) - offset_h(j)) / 2);
+    offset_h(j) = (col_max_h(j) + offset_h(j)) / 2;
+  }
+  const float vq_scale = half_range > 0 ? half_range / 127.0f : 1.0f;
+
+  auto vq_offset = make_device_vector<float, IdxT>(res, dim);
+  raft::copy(vq_offset.data_handle(), offset_h.data_handle(), dim, stream);
+  using AlignDim = raft::Pow2<16 / sizeof(int8_t)>;
+  auto out       = make_device_matrix<int8_t, IdxT>(res, n_rows, AlignDim::roundUp(dim));
+  RAFT_CUDA_TRY(cudaMemsetAsync(out.data_handle(), 0, out.size() * sizeof(int8_t), stream));
+  compress_rows(res,
+                out.data_handle(),
+                out.extent(1),
+                dataset.data_handle(),
+                dataset.stride(0),
+                n_rows,
+                dim,
+                int8_compression_op{vq_offset.data_handle(), 1.0f / vq_scale});
+  // Keep the host buffers alive until the copies are done.
+  resource::sync_stream(res);
+  idx.update_dataset(res, std::move(out), std::move(vq_offset), vq_scale);
+}
+
+/** Squared L2 distances between the queries and their candidate neighbors. */
+template <typename T, typename IdxT>
+__global__ void kern_candidate_distances(float* const distances,  // [n_queries, n_candidates]
+                                         const T* const dataset,  // [n_rows, dataset_ld]
+                                         const uint64_t dataset_ld,
+                                         const uint64_t n_rows,
+                                         const T* const queries,  // [n_queries, dim]
+                                         const uint32_t dim,
+                                         const IdxT* const candidates,  // [n_queries, n_candidates]
+                                         const uint32_t n_candidates,
+                                         const uint64_t n_queries)
+{
+  const uint64_t tid = threadIdx.x + static_cast<uint64_t>(blockDim.x) * blockIdx.x;
+  if (tid >= n_queries * n_candidates) { return; }
+  const uint64_t i_query = tid / n_candidates;
+  const uint64_t id      = candidates[tid];
+  if (id >= n_rows) {
+    // Not enough candidates were found (e.g. filtered out)
+    distances[tid] = std::numeric_limits<float>::max();
+    return;
+  }
+  const T* query = queries + i_query * dim;
+  const T* row   = dataset + id * dataset_ld;
+  float dist     = 0;
+  for (uint32_t j = 0; j < dim; j++) {
+    const float diff = spatial::knn::detail::utils::mapping<float>{}(query[j]) -
+                       spatial::knn::detail::utils::mapping<float>{}(row[j]);
+    dist += diff * diff;
+  }
+  distances[tid] = dist;
+}
+
+template <typename T, typename IdxT>
+void candidate_distances(raft::resources const& res,
+                         device_matrix_view<const T, IdxT, layout_stride> dataset,
+                         device_matrix_view<const T, IdxT, row_major> queries,
+                         device_matrix_view<const IdxT, IdxT, row_major> candidates,
+                         device_matrix_view<float, IdxT, row_major> distances)
+{
+  const uint64_t n_pairs = static_cast<uint64_t>(candidates.extent(0)) * candidates.extent(1);
+  if (n_pairs == 0) { return; }
+  constexpr uint32_t block_size = 256;
+  const uint64_t grid_size      = raft::ceildiv<uint64_t>(n_pairs, block_size);
+  kern_candidate_distances<<<grid_size, block_size, 0, resource::get_cuda_stream(res)>>>(
+    distances.data_handle(),
+    dataset.data_handle(),
+    dataset.stride(0),
+    dataset.extent(0),
+    queries.data_handle(),
+    queries.extent(1),
+    candidates.data_handle(),
+    candidates.extent(1),
+    candidates.extent(0));
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+}  // namespace raft::neighbors::experimental::cagra::detail
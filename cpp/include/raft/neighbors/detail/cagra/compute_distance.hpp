@@ -16,6 +16,7 @@
 #pragma once
 
 #include <raft/spatial/knn/detail/ann_utils.cuh>
+#include <raft/util/fast_int_div.cuh>
 
 #include "device_common.hpp"
 #include "hashmap.hpp"
@@ -150,7 +151,7 @@ _RAFT_DEVICE void compute_distance_to_child_nodes(INDEX_T* const result_child_in
                                                   const std::size_t dataset_ld,
                                                   // [knn_k, dataset_size]
                                                   const INDEX_T* const knn_graph,
-                                                  const std::uint32_t knn_k,
+                                                  const raft::util::FastUIntDiv<uint32_t> knn_k,
                                                   // hashmap
                                                   INDEX_T* const visited_hashmap_ptr,
                                                   const std::uint32_t hash_bitlen,
@@ -161,11 +162,12 @@ _RAFT_DEVICE void compute_distance_to_child_nodes(INDEX_T* const result_child_in
 
   // Read child indices of parents from knn graph and check if the distance
   // computaiton is necessary.
-  for (uint32_t i = threadIdx.x; i < knn_k * num_parents; i += BLOCK_SIZE) {
-    const INDEX_T parent_id = parent_indices[i / knn_k];
-    INDEX_T child_id        = invalid_index;
+  for (uint32_t i = threadIdx.x; i < knn_k.d * num_parents; i += BLOCK_SIZE) {
+    const uint32_t parent_ix = i / knn_k;
+    const INDEX_T parent_id  = parent_indices[parent_ix];
+    INDEX_T child_id         = invalid_index;
     if (parent_id != invalid_index) {
-      child_id = knn_graph[(i % knn_k) + ((uint64_t)knn_k * parent_id)];
+      child_id = knn_graph[(i - parent_ix * knn_k.d) + ((uint64_t)knn_k.d * parent_id)];
     }
     if (child_id != invalid_index) {
       if (hashmap::insert(visited_hashmap_ptr, hash_bitlen, child_id) == 0) {
@@ -203,10 +205,10 @@ _RAFT_DEVICE void compute_distance_to_child_nodes(INDEX_T* const result_child_in
   __syncthreads();
 
   // Compute the distance to child nodes
-  std::uint32_t max_i = knn_k * num_parents;
+  std::uint32_t max_i = knn_k.d * num_parents;
   if (max_i % (32 / TEAM_SIZE)) { max_i += (32 / TEAM_SIZE) - (max_i % (32 / TEAM_SIZE)); }
   for (std::uint32_t i = threadIdx.x / TEAM_SIZE; i < max_i; i += BLOCK_SIZE / TEAM_SIZE) {
-    const bool valid_i = (i < (knn_k * num_parents));
+    const bool valid_i = (i < (knn_k.d * num_parents));
     INDEX_T child_id   = invalid_index;
     if (valid_i) { child_id = result_child_indices_ptr[i]; }
 
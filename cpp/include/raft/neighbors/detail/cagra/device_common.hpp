@@ -48,5 +48,36 @@ _RAFT_DEVICE inline T swizzling(T x)
   return x ^ (x >> 5);  // "x" must be less than 1024
 }
 
+/**
+ * Remove the nodes rejected by the sample filter from the internal top-k buffer.
+ *
+ * When `parents_only` is set, only the nodes that have already been used as parents (most
+ * significant bit set) are removed: their neighbors are visited regardless of the filter, so the
+ * filtered nodes still guide the traversal, but they free their slot for the nodes that can be
+ * returned. Removed entries get the maximum distance and an invalid index.
+ */
+template <class INDEX_T, class DISTANCE_T, class SAMPLE_FILTER_T>
+_RAFT_DEVICE inline void remove_filtered_nodes(INDEX_T* const itopk_indices,
+                                               DISTANCE_T* const itopk_distances,
+                                               const std::uint32_t itopk_size,
+                                               const std::uint32_t query_id,
+                                               SAMPLE_FILTER_T sample_filter,
+                                               const bool parents_only,
+                                               const std::uint32_t first_tid,
+                                               const std::uint32_t num_threads)
+{
+  constexpr INDEX_T index_msb_1_mask = utils::gen_index_msb_1_mask<INDEX_T>::value;
+  const INDEX_T invalid_index        = utils::get_max_value<INDEX_T>();
+  for (std::uint32_t i = threadIdx.x - first_tid; i < itopk_size; i += num_threads) {
+    const INDEX_T index = itopk_indices[i];
+    if (index == invalid_index) { continue; }
+    if (parents_only && (index & index_msb_1_mask) == 0) { continue; }
+    if (!sample_filter(query_id, index & ~index_msb_1_mask)) {
+      itopk_indices[i]   = invalid_index;
+      itopk_distances[i] = utils::get_max_value<DISTANCE_T>();
+    }
+  }
+}
+
 }  // namespace device
 }  // namespace raft::neighbors::experimental::cagra::detail
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/cluster/kmeans_balanced.cuh>
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/host_mdarray.hpp>
+#include <raft/core/logger.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/neighbors/cagra_types.hpp>
+#include <raft/spatial/knn/detail/ann_utils.cuh>
+#include <raft/util/cuda_rt_essentials.hpp>
+#include <raft/util/cudart_utils.hpp>
+#include <raft/util/integer_utils.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace raft::neighbors::experimental::cagra::detail {
+
+/** The number of training rows sampled per entry point. */
+constexpr size_t kEntryPointTrainsetRatio = 256;
+
+/**
+ * For every training row, offer it as the nearest row to its own cluster center.
+ *
+ * The squared distance and the row are packed in one 64-bit word, so that the nearest row of a
+ * cluster is the minimum of the words; the non-negative floats compare the same as their bits.
+ */
+template <typename T, typename IdxT>
+__global__ void kern_nearest_to_centers(uint64_t* const best,          // [n_centers]
+                                        const T* const trainset,       // [n_rows, dim]
+                                        const float* const centers,    // [n_centers, dim]
+                                        const uint32_t* const labels,  // [n_rows]
+                                        const IdxT n_rows,
+                                        const uint32_t dim)
+{
+  const IdxT row = IdxT(blockIdx.x) * IdxT(blockDim.x) + IdxT(threadIdx.x);
+  if (row >= n_rows) { return; }
+  const uint32_t label = labels[row];
+  const T* x           = trainset + static_cast<uint64_t>(row) * dim;
+  const float* c       = centers + static_cast<uint64_t>(label) * dim;
+  float dist           = 0;
+  for (uint32_t j = 0; j < dim; j++) {
+    const float diff = spatial::knn::detail::utils::mapping<float>{}(x[j]) - c[j];
+    dist += diff * diff;
+  }
+  const uint64_t packed =
+    (static_cast<uint64_t>(__float_as_uint(dist)) << 32) | static_cast<uint64_t>(row);
+  atomicMin(reinterpret_cast<unsigned long long*>(best + label),
+            static_cast<unsigned long long>(packed));
+}
+
+/**
+ * Select the entry points of the search and store them in the index.
+ *
+ * A uniform subsample of the dataset is clustered with the balanced k-means; the entry points are
+ * the sampled rows nearest to the cluster centers. The empty clusters are skipped, so the index
+ * may get fewer than `n_entry_points` entries.
+ */
+template <typename T, typename IdxT>
+void select_entry_points(raft::resources const& res, index<T, IdxT>& idx, size_t n_entry_points)
+{
+  auto stream         = resource::get_cuda_stream(res);
+  const size_t n_rows = idx.size();
+  const uint32_t dim  = idx.dim();
+  RAFT_EXPECTS(idx.dataset().extent(0) == idx.size(), "The index has no dataset attached");
+  RAFT_EXPECTS(n_rows <= std::numeric_limits<uint32_t>::max(),
+               "The dataset is too large for selecting the entry points");
+  const size_t n_centers = std::min(n_entry_points, n_rows);
+  if (n_centers == 0) {
+    idx.update_entry_points(res, make_device_vector<IdxT, IdxT>(res, 0));
+    return;
+  }
+
+  // Rows [0, step, 2 * step, ...] of the dataset
+  const size_t step    = std::max<size_t>(1, n_rows / (n_centers * kEntryPointTrainsetRatio));
+  const size_t n_train = raft::ceildiv(n_rows, step);
+  auto trainset        = make_device_matrix<T, uint32_t>(res, n_train, dim);
+  RAFT_CUDA_TRY(cudaMemcpy2DAsync(trainset.data_handle(),
+                                  sizeof(T) * dim,
+                                  idx.dataset().data_handle(),
+                                  sizeof(T) * idx.dataset().stride(0) * step,
+                                  sizeof(T) * dim,
+                                  n_train,
+                                  cudaMemcpyDefault,
+                                  stream));
+
+  raft::cluster::kmeans_balanced_params kmeans_params;
+  kmeans_params.metric = raft::distance::DistanceType::L2Expanded;
+  auto centers         = make_device_matrix<float, uint32_t>(res, n_centers, dim);
+  auto labels          = make_device_vector<uint32_t, uint32_t>(res, n_train);
+  auto trainset_view   = raft::make_const_mdspan(trainset.view());
+  raft::cluster::kmeans_balanced::fit(res,
+                                      kmeans_params,
+                                      trainset_view,
+                                      centers.view(),
+                                      spatial::knn::detail::utils::mapping<float>{});
+  raft::cluster::kmeans_balanced::predict(res,
+                                          kmeans_params,
+                                          trainset_view,
+                                          raft::make_const_mdspan(centers.view()),
+                                          labels.view(),
+                                          spatial::knn::detail::utils::mapping<float>{});
+
+  auto best = make_device_vector<uint64_t, uint32_t>(res, n_centers);
+  RAFT_CUDA_TRY(cudaMemsetAsync(best.data_handle(), 0xff, best.size() * sizeof(uint64_t), stream));
+  constexpr uint32_t kBlockSize = 256;
+  const dim3 blocks(raft::ceildiv<size_t>(n_train, kBlockSize), 1, 1);
+  kern_nearest_to_centers<T, uint32_t><<<blocks, kBlockSize, 0, stream>>>(best.data_handle(),
+                                                                          trainset.data_handle(),
+                                                                          centers.data_handle(),
+                                                                          labels.data_handle(),
+                                                                          n_train,
+                                                                          dim);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+  std::vector<uint64_t> best_host(n_centers);
+  raft::copy(best_host.data(), best.data_handle(), n_centers, stream);
+  resource::sync_stream(res, stream);
+  std::vector<IdxT> entries;
+  entries.reserve(n_centers);
+  for (auto packed : best_host) {
+    if (packed == ~uint64_t(0)) { continue; }  // empty cluster
+    entries.push_back(static_cast<IdxT>((packed & 0xffffffffull) * step));
+  }
+  std::sort(entries.begin(), entries.end());
+  entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+  RAFT_LOG_DEBUG("# CAGRA entry points: %zu (of %zu requested)", entries.size(), n_entry_points);
+
+  auto entry_points = make_device_vector<IdxT, IdxT>(res, entries.size());
+  raft::copy(entry_points.data_handle(), entries.data(), entries.size(), stream);
+  // `entries` goes out of scope
+  resource::sync_stream(res, stream);
+  idx.update_entry_points(res, std::move(entry_points));
+}
+
+}  // namespace raft::neighbors::experimental::cagra::detail
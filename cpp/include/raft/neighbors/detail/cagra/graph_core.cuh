@@ -15,13 +15,14 @@
  */
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <climits>
 #include <cuda_fp16.h>
 #include <float.h>
 #include <iostream>
+#include <limits>
 #include <memory>
-#include <omp.h>
 #include <raft/core/device_mdspan.hpp>
 #include <raft/core/host_device_accessor.hpp>
 #include <raft/core/mdspan.hpp>
@@ -131,8 +132,8 @@ __global__ void kern_prune(const IdxT* const knn_graph,  // [graph_chunk_size, g
                            const uint32_t degree,
                            const uint32_t batch_size,
                            const uint32_t batch_id,
-                           uint8_t* const detour_count,          // [graph_chunk_size, graph_degree]
-                           uint32_t* const num_no_detour_edges,  // [graph_size]
+                           uint8_t* const detour_count,          // [batch_size, graph_degree]
+                           uint32_t* const num_no_detour_edges,  // [batch_size]
                            uint64_t* const stats)
 {
   __shared__ uint32_t smem_num_detour[MAX_DEGREE];
@@ -168,9 +169,12 @@ __global__ void kern_prune(const IdxT* const knn_graph,  // [graph_chunk_size, g
     __syncthreads();
   }
 
+  // detour_count and num_no_detour_edges only hold the rows of the current batch
+  const uint64_t iA_batch = iA - (batch_size * batch_id);
+
   uint32_t num_edges_no_detour = 0;
   for (uint32_t k = threadIdx.x; k < graph_degree; k += blockDim.x) {
-    detour_count[k + (graph_degree * iA)] = min(smem_num_detour[k], (uint32_t)255);
+    detour_count[k + (graph_degree * iA_batch)] = min(smem_num_detour[k], (uint32_t)255);
     if (smem_num_detour[k] == 0) { num_edges_no_detour++; }
   }
   num_edges_no_detour += __shfl_xor_sync(0xffffffff, num_edges_no_detour, 1);
@@ -181,7 +185,7 @@ __global__ void kern_prune(const IdxT* const knn_graph,  // [graph_chunk_size, g
   num_edges_no_detour = min(num_edges_no_detour, degree);
 
   if (threadIdx.x == 0) {
-    num_no_detour_edges[iA] = num_edges_no_detour;
+    num_no_detour_edges[iA_batch] = num_edges_no_detour;
     atomicAdd((unsigned long long int*)num_retain, (unsigned long long int)num_edges_no_detour);
     if (num_edges_no_detour >= degree) { atomicAdd((unsigned long long int*)num_full, 1); }
   }
@@ -189,25 +193,88 @@ __global__ void kern_prune(const IdxT* const knn_graph,  // [graph_chunk_size, g
 
 template <class IdxT>
 __global__ void kern_make_rev_graph(const IdxT* const dest_nodes,     // [graph_size]
-                                    IdxT* const rev_graph,            // [size, degree]
-                                    uint32_t* const rev_graph_count,  // [graph_size]
+                                    IdxT* const rev_graph,            // [chunk_size, degree]
+                                    uint32_t* const rev_graph_count,  // [chunk_size]
                                     const uint32_t graph_size,
-                                    const uint32_t degree)
+                                    const uint32_t degree,
+                                    const uint32_t chunk_offset,
+                                    const uint32_t chunk_size)
 {
   const uint32_t tid  = threadIdx.x + (blockDim.x * blockIdx.x);
   const uint32_t tnum = blockDim.x * gridDim.x;
 
   for (uint32_t src_id = tid; src_id < graph_size; src_id += tnum) {
     const IdxT dest_id = dest_nodes[src_id];
-    if (dest_id >= graph_size) continue;
+    // Only the destination nodes of the current chunk are collected.
+    if (dest_id < chunk_offset || dest_id >= graph_size) continue;
+    const uint64_t chunk_id = dest_id - chunk_offset;
+    if (chunk_id >= chunk_size) continue;
+
+    const uint32_t pos = atomicAdd(rev_graph_count + chunk_id, 1);
+    if (pos < degree) { rev_graph[pos + ((uint64_t)degree * chunk_id)] = src_id; }
+  }
+}
 
-    const uint32_t pos = atomicAdd(rev_graph_count + dest_id, 1);
-    if (pos < degree) { rev_graph[pos + ((uint64_t)degree * dest_id)] = src_id; }
+/**
+ * Merge the neighbor lists of a node coming from different sub-graphs, by rank.
+ *
+ * `graph` holds the rows already merged from `num_merged[i]` lists; the new list is interleaved
+ * into it so that each of the source lists contributes evenly: `num_merged[i]` neighbors are taken
+ * from the merged row for every neighbor taken from the new list. Duplicated neighbors are skipped.
+ */
+template <class IdxT>
+__global__ void kern_merge_by_rank(const IdxT* const graph,        // [num_nodes, degree]
+                                   const IdxT* const new_graph,    // [num_nodes, degree]
+                                   const IdxT* const id_map,       // new_graph ids -> global ids
+                                   const uint8_t* const num_merged,  // [num_nodes]
+                                   IdxT* const output_graph,       // [num_nodes, degree]
+                                   const uint64_t num_nodes,
+                                   const uint32_t degree)
+{
+  const uint64_t i = threadIdx.x + (static_cast<uint64_t>(blockDim.x) * blockIdx.x);
+  if (i >= num_nodes) { return; }
+
+  const IdxT* const row_a = graph + (static_cast<uint64_t>(degree) * i);
+  const IdxT* const row_b = new_graph + (static_cast<uint64_t>(degree) * i);
+  IdxT* const row_out     = output_graph + (static_cast<uint64_t>(degree) * i);
+
+  const uint32_t weight_a = num_merged[i];
+  uint32_t ka = 0, kb = 0, num_out = 0;
+  while (num_out < degree && (ka < degree || kb < degree)) {
+    for (uint32_t w = 0; w <= weight_a && num_out < degree; w++) {
+      IdxT v;
+      if (w < weight_a) {
+        if (ka >= degree) { continue; }
+        v = row_a[ka++];
+      } else {
+        if (kb >= degree) { break; }
+        v = id_map[row_b[kb++]];
+      }
+      bool duplicate = false;
+      for (uint32_t k = 0; k < num_out && !duplicate; k++) {
+        duplicate = (row_out[k] == v);
+      }
+      if (!duplicate) { row_out[num_out++] = v; }
+    }
   }
 }
 
+/**
+ * Number of rows of the given size that comfortably fit into the free device memory, at most
+ * `max_rows`.
+ */
+inline auto max_rows_in_device_memory(size_t bytes_per_row, size_t n_rows, size_t max_rows)
+  -> size_t
+{
+  size_t free_mem, total_mem;
+  constexpr size_t kTolerableRatio = 2;
+  RAFT_CUDA_TRY(cudaMemGetInfo(&free_mem, &total_mem));
+  return std::clamp<size_t>(
+    free_mem / kTolerableRatio / bytes_per_row, 1, std::min(n_rows, max_rows));
+}
+
 template <class T>
-uint64_t pos_in_array(T val, const T* array, uint64_t num)
+__device__ inline uint64_t pos_in_array(T val, const T* array, uint64_t num)
 {
   for (uint64_t i = 0; i < num; i++) {
     if (val == array[i]) { return i; }
@@ -216,12 +283,93 @@ uint64_t pos_in_array(T val, const T* array, uint64_t num)
 }
 
 template <class T>
-void shift_array(T* array, uint64_t num)
+__device__ inline void shift_array(T* array, uint64_t num)
 {
   for (uint64_t i = num; i > 0; i--) {
     array[i] = array[i - 1];
   }
 }
+
+/**
+ * Pick the `degree` edges with the fewest detours of every node of the batch (the rank in the kNN
+ * list breaks the ties).
+ *
+ * The pruned graph is written transposed, `pruned_graph[k * ld + i]` being the `k`-th edge of the
+ * `i`-th node of the batch, so that every rank forms a contiguous column.
+ */
+template <class IdxT>
+__global__ void kern_make_pruned_graph(const IdxT* const knn_graph,  // [graph_size, graph_degree]
+                                       const uint8_t* const detour_count,  // [batch, graph_degree]
+                                       IdxT* const pruned_graph,           // [degree, ld]
+                                       const uint64_t ld,
+                                       const uint64_t batch_offset,
+                                       const uint32_t batch_size,
+                                       const uint32_t graph_degree,
+                                       const uint32_t degree)
+{
+  const uint64_t i = threadIdx.x + (static_cast<uint64_t>(blockDim.x) * blockIdx.x);
+  if (i >= batch_size) { return; }
+  const IdxT* const knn_row    = knn_graph + graph_degree * (batch_offset + i);
+  const uint8_t* const detours = detour_count + graph_degree * i;
+
+  // the detour counts are saturated at 255, so every edge is considered
+  uint32_t pk = 0;
+  for (uint32_t num_detour = 0; pk < degree && num_detour <= 255; num_detour++) {
+    for (uint32_t k = 0; k < graph_degree && pk < degree; k++) {
+      if (detours[k] != num_detour) { continue; }
+      pruned_graph[pk++ * ld + i] = knn_row[k];
+    }
+  }
+}
+
+/**
+ * Replace some edges of the pruned graph with the reverse edges: the first `num_protected_edges`
+ * edges of a node stay, the reverse edges are inserted right after them, the lower ranked ones
+ * ending up first. The number of the pruned edges dropped in favor of the reverse edges is
+ * accumulated in `num_replaced_edges`.
+ */
+template <class IdxT>
+__global__ void kern_add_rev_edges(const IdxT* const pruned_graph,         // [degree, ld]
+                                   const uint64_t ld,
+                                   const IdxT* const rev_graph,            // [num_nodes, degree]
+                                   const uint32_t* const rev_graph_count,  // [num_nodes]
+                                   IdxT* const output_graph,               // [num_nodes, degree]
+                                   const uint64_t num_nodes,
+                                   const uint32_t degree,
+                                   const uint32_t num_protected_edges,
+                                   uint64_t* const num_replaced_edges)
+{
+  const uint64_t j = threadIdx.x + (static_cast<uint64_t>(blockDim.x) * blockIdx.x);
+  if (j >= num_nodes) { return; }
+  IdxT* const out_row = output_graph + (static_cast<uint64_t>(degree) * j);
+  for (uint32_t k = 0; k < degree; k++) {
+    out_row[k] = pruned_graph[k * ld + j];
+  }
+
+  const uint32_t num_rev = min(rev_graph_count[j], degree);
+  for (uint32_t _k = 0; _k < num_rev; _k++) {
+    const uint32_t k = num_rev - 1 - _k;
+    const IdxT i     = rev_graph[k + (static_cast<uint64_t>(degree) * j)];
+
+    const uint64_t pos = pos_in_array<IdxT>(i, out_row, degree);
+    if (pos < num_protected_edges) { continue; }
+    uint64_t num_shift = pos - num_protected_edges;
+    if (pos == degree) { num_shift = degree - num_protected_edges - 1; }
+    shift_array<IdxT>(out_row + num_protected_edges, num_shift);
+    out_row[num_protected_edges] = i;
+  }
+
+  /* stats */
+  uint64_t num_replaced = 0;
+  for (uint32_t k = 0; k < degree; k++) {
+    if (pos_in_array<IdxT>(pruned_graph[k * ld + j], out_row, degree) == degree) {
+      num_replaced++;
+    }
+  }
+  if (num_replaced > 0) {
+    atomicAdd((unsigned long long int*)num_replaced_edges, (unsigned long long int)num_replaced);
+  }
+}
 }  // namespace
 
 template <typename DataT,
@@ -315,12 +463,20 @@ void sort_knn_graph(raft::resources const& res,
   RAFT_LOG_DEBUG("# Sorting kNN graph time: %.1lf sec\n", time_sort_end - time_sort_start);
 }
 
+/**
+ * Prune the kNN graph into `new_graph`.
+ *
+ * `max_device_rows` caps the number of graph rows held in the device memory at a time, on top of
+ * the free memory; below the graph size, it forces the chunked processing through the host
+ * buffers (the tests use it to check that path against the on-device one).
+ */
 template <typename IdxT = uint32_t,
           typename g_accessor =
             host_device_accessor<std::experimental::default_accessor<IdxT>, memory_type::host>>
 void prune(raft::resources const& res,
            mdspan<IdxT, matrix_extent<IdxT>, row_major, g_accessor> knn_graph,
-           raft::host_matrix_view<IdxT, IdxT, row_major> new_graph)
+           raft::host_matrix_view<IdxT, IdxT, row_major> new_graph,
+           size_t max_device_rows = std::numeric_limits<size_t>::max())
 {
   RAFT_LOG_DEBUG(
     "# Pruning kNN graph (size=%lu, degree=%lu)\n", knn_graph.extent(0), knn_graph.extent(1));
@@ -334,28 +490,46 @@ void prune(raft::resources const& res,
   auto input_graph_ptr               = knn_graph.data_handle();
   auto output_graph_ptr              = new_graph.data_handle();
   const IdxT graph_size              = new_graph.extent(0);
-
-  auto pruned_graph = raft::make_host_matrix<IdxT, IdxT>(graph_size, output_graph_degree);
+  auto stream                        = resource::get_cuda_stream(res);
+
+  // The pruned graph is kept transposed [output_graph_degree, graph_size]: the reverse graph is
+  // built from one rank (column) at a time. All of the pruned, reverse and output graphs stay on
+  // the device when they fit there; otherwise the pruned graph is kept on the host, and the
+  // reverse edges are collected and merged in chunks that bound the device memory usage.
+  const bool graph_on_device =
+    max_rows_in_device_memory(output_graph_degree * 3 * sizeof(IdxT) + sizeof(uint32_t),
+                              graph_size,
+                              max_device_rows) == static_cast<size_t>(graph_size);
+  auto d_pruned_graph = raft::make_device_matrix<IdxT, IdxT>(
+    res, graph_on_device ? output_graph_degree : 0, graph_size);
+  auto pruned_graph =
+    raft::make_host_matrix<IdxT, IdxT>(graph_on_device ? 0 : output_graph_degree, graph_size);
 
   {
     //
     // Prune kNN graph
     //
-    auto d_input_graph = raft::make_device_matrix<IdxT, IdxT>(res, graph_size, input_graph_degree);
+    const uint32_t batch_size =
+      std::min(static_cast<uint32_t>(graph_size), static_cast<uint32_t>(256 * 1024));
+    const uint32_t num_batch = (graph_size + batch_size - 1) / batch_size;
+
+    // The input graph is copied to the device when it fits there, otherwise the kernel reads it
+    // from the (registered) host memory.
+    const bool input_graph_on_device =
+      max_rows_in_device_memory(input_graph_degree * (sizeof(IdxT) + sizeof(uint8_t)),
+                                graph_size,
+                                max_device_rows) == static_cast<size_t>(graph_size);
+    auto d_input_graph = raft::make_device_matrix<IdxT, IdxT>(
+      res, input_graph_on_device ? graph_size : 0, input_graph_degree);
 
-    auto detour_count = raft::make_host_matrix<uint8_t, IdxT>(graph_size, input_graph_degree);
     auto d_detour_count =
-      raft::make_device_matrix<uint8_t, IdxT>(res, graph_size, input_graph_degree);
-    RAFT_CUDA_TRY(cudaMemsetAsync(d_detour_count.data_handle(),
-                                  0xff,
-                                  graph_size * input_graph_degree * sizeof(uint8_t),
-                                  resource::get_cuda_stream(res)));
-
-    auto d_num_no_detour_edges = raft::make_device_vector<uint32_t, IdxT>(res, graph_size);
-    RAFT_CUDA_TRY(cudaMemsetAsync(d_num_no_detour_edges.data_handle(),
-                                  0x00,
-                                  graph_size * sizeof(uint32_t),
-                                  resource::get_cuda_stream(res)));
+      raft::make_device_matrix<uint8_t, IdxT>(res, batch_size, input_graph_degree);
+    auto d_pruned_batch = raft::make_device_matrix<IdxT, IdxT>(
+      res, graph_on_device ? 0 : output_graph_degree, batch_size);
+
+    auto d_num_no_detour_edges = raft::make_device_vector<uint32_t, IdxT>(res, batch_size);
+    RAFT_CUDA_TRY(cudaMemsetAsync(
+      d_num_no_detour_edges.data_handle(), 0x00, batch_size * sizeof(uint32_t), stream));
 
     auto dev_stats  = raft::make_device_vector<uint64_t>(res, 2);
     auto host_stats = raft::make_host_vector<uint64_t>(2);
@@ -376,10 +550,6 @@ void prune(raft::resources const& res,
     const double time_prune_start = cur_time();
     RAFT_LOG_DEBUG("# Pruning kNN Graph on GPUs\r");
 
-    raft::copy(d_input_graph.data_handle(),
-               input_graph_ptr,
-               graph_size * input_graph_degree,
-               resource::get_cuda_stream(res));
     void (*kernel_prune)(const IdxT* const,
                          const uint32_t,
                          const uint32_t,
@@ -401,64 +571,82 @@ void prune(raft::resources const& res,
         1024);
       exit(-1);
     }
-    const uint32_t batch_size =
-      std::min(static_cast<uint32_t>(graph_size), static_cast<uint32_t>(256 * 1024));
-    const uint32_t num_batch = (graph_size + batch_size - 1) / batch_size;
     const dim3 threads_prune(32, 1, 1);
     const dim3 blocks_prune(batch_size, 1, 1);
 
-    RAFT_CUDA_TRY(cudaMemsetAsync(
-      dev_stats.data_handle(), 0, sizeof(uint64_t) * 2, resource::get_cuda_stream(res)));
-
-    for (uint32_t i_batch = 0; i_batch < num_batch; i_batch++) {
-      kernel_prune<<<blocks_prune, threads_prune, 0, resource::get_cuda_stream(res)>>>(
-        d_input_graph.data_handle(),
-        graph_size,
-        input_graph_degree,
-        output_graph_degree,
-        batch_size,
-        i_batch,
-        d_detour_count.data_handle(),
-        d_num_no_detour_edges.data_handle(),
-        dev_stats.data_handle());
+    RAFT_CUDA_TRY(cudaMemsetAsync(dev_stats.data_handle(), 0, sizeof(uint64_t) * 2, stream));
+
+    auto prune_batches = [&](const IdxT* d_input_graph_ptr) {
+      for (uint32_t i_batch = 0; i_batch < num_batch; i_batch++) {
+        const uint32_t batch_offset = i_batch * batch_size;
+        const uint32_t this_batch_size =
+          std::min<uint32_t>(batch_size, static_cast<uint32_t>(graph_size) - batch_offset);
+        RAFT_CUDA_TRY(cudaMemsetAsync(d_detour_count.data_handle(),
+                                      0xff,
+                                      batch_size * input_graph_degree * sizeof(uint8_t),
+                                      stream));
+        kernel_prune<<<blocks_prune, threads_prune, 0, stream>>>(
+          d_input_graph_ptr,
+          graph_size,
+          input_graph_degree,
+          output_graph_degree,
+          batch_size,
+          i_batch,
+          d_detour_count.data_handle(),
+          d_num_no_detour_edges.data_handle(),
+          dev_stats.data_handle());
+        // Create pruned kNN graph
+        auto* pruned_ptr = graph_on_device ? d_pruned_graph.data_handle() + batch_offset
+                                           : d_pruned_batch.data_handle();
+        const uint64_t pruned_ld = graph_on_device ? graph_size : batch_size;
+        const dim3 threads_make(256, 1, 1);
+        const dim3 blocks_make(raft::ceildiv<uint32_t>(this_batch_size, threads_make.x), 1, 1);
+        kern_make_pruned_graph<IdxT><<<blocks_make, threads_make, 0, stream>>>(
+          d_input_graph_ptr,
+          d_detour_count.data_handle(),
+          pruned_ptr,
+          pruned_ld,
+          batch_offset,
+          this_batch_size,
+          input_graph_degree,
+          output_graph_degree);
+        RAFT_CUDA_TRY(cudaPeekAtLastError());
+        if (!graph_on_device) {
+          RAFT_CUDA_TRY(cudaMemcpy2DAsync(pruned_graph.data_handle() + batch_offset,
+                                          sizeof(IdxT) * graph_size,
+                                          d_pruned_batch.data_handle(),
+                                          sizeof(IdxT) * batch_size,
+                                          sizeof(IdxT) * this_batch_size,
+                                          output_graph_degree,
+                                          cudaMemcpyDefault,
+                                          stream));
+        }
+        RAFT_LOG_DEBUG(
+          "# Pruning kNN Graph on GPUs (%.1lf %%)\r",
+          (double)std::min<IdxT>((i_batch + 1) * batch_size, graph_size) / graph_size * 100);
+      }
+      // the mapped input graph must not be unregistered before the kernels are done
       resource::sync_stream(res);
-      RAFT_LOG_DEBUG(
-        "# Pruning kNN Graph on GPUs (%.1lf %%)\r",
-        (double)std::min<IdxT>((i_batch + 1) * batch_size, graph_size) / graph_size * 100);
+    };
+
+    if (input_graph_on_device) {
+      raft::copy(
+        d_input_graph.data_handle(), input_graph_ptr, graph_size * input_graph_degree, stream);
+      prune_batches(d_input_graph.data_handle());
+    } else {
+      RAFT_LOG_DEBUG("# The input kNN graph does not fit into the device memory, mapping it");
+      spatial::knn::detail::utils::with_mapped_memory_t{
+        static_cast<const IdxT*>(input_graph_ptr),
+        sizeof(IdxT) * graph_size * input_graph_degree,
+        prune_batches}();
     }
-    resource::sync_stream(res);
     RAFT_LOG_DEBUG("\n");
 
-    raft::copy(detour_count.data_handle(),
-               d_detour_count.data_handle(),
-               graph_size * input_graph_degree,
-               resource::get_cuda_stream(res));
-
-    raft::copy(
-      host_stats.data_handle(), dev_stats.data_handle(), 2, resource::get_cuda_stream(res));
+    raft::copy(host_stats.data_handle(), dev_stats.data_handle(), 2, stream);
+    resource::sync_stream(res);
     const auto num_keep = host_stats.data_handle()[0];
     const auto num_full = host_stats.data_handle()[1];
 
-    // Create pruned kNN graph
-    uint32_t max_detour = 0;
-#pragma omp parallel for reduction(max : max_detour)
-    for (uint64_t i = 0; i < graph_size; i++) {
-      uint64_t pk = 0;
-      for (uint32_t num_detour = 0; num_detour < output_graph_degree; num_detour++) {
-        if (max_detour < num_detour) { max_detour = num_detour; /* stats */ }
-        for (uint64_t k = 0; k < input_graph_degree; k++) {
-          if (detour_count.data_handle()[k + (input_graph_degree * i)] != num_detour) { continue; }
-          pruned_graph.data_handle()[pk + (output_graph_degree * i)] =
-            input_graph_ptr[k + (input_graph_degree * i)];
-          pk += 1;
-          if (pk >= output_graph_degree) break;
-        }
-        if (pk >= output_graph_degree) break;
-      }
-      assert(pk == output_graph_degree);
-    }
-    // RAFT_LOG_DEBUG("# max_detour: %u\n", max_detour);
-
     const double time_prune_end = cur_time();
     RAFT_LOG_DEBUG(
       "# Pruning time: %.1lf sec, "
@@ -470,8 +658,12 @@ void prune(raft::resources const& res,
       (double)num_full / graph_size * 100);
   }
 
-  auto rev_graph       = raft::make_host_matrix<IdxT, IdxT>(graph_size, output_graph_degree);
-  auto rev_graph_count = raft::make_host_vector<uint32_t, IdxT>(graph_size);
+  // When the graph stays on the device, the reverse graph is built in one chunk and kept there.
+  auto d_rev_graph       = raft::make_device_matrix<IdxT, IdxT>(res, 0, output_graph_degree);
+  auto d_rev_graph_count = raft::make_device_vector<uint32_t, IdxT>(res, 0);
+  auto rev_graph =
+    raft::make_host_matrix<IdxT, IdxT>(graph_on_device ? 0 : graph_size, output_graph_degree);
+  auto rev_graph_count = raft::make_host_vector<uint32_t, IdxT>(graph_on_device ? 0 : graph_size);
 
   {
     //
@@ -479,55 +671,71 @@ void prune(raft::resources const& res,
     //
     const double time_make_start = cur_time();
 
-    auto d_rev_graph = raft::make_device_matrix<IdxT, IdxT>(res, graph_size, output_graph_degree);
-    RAFT_CUDA_TRY(cudaMemsetAsync(d_rev_graph.data_handle(),
-                                  0xff,
-                                  graph_size * output_graph_degree * sizeof(IdxT),
-                                  resource::get_cuda_stream(res)));
-
-    auto d_rev_graph_count = raft::make_device_vector<uint32_t, IdxT>(res, graph_size);
-    RAFT_CUDA_TRY(cudaMemsetAsync(d_rev_graph_count.data_handle(),
-                                  0x00,
-                                  graph_size * sizeof(uint32_t),
-                                  resource::get_cuda_stream(res)));
-
-    auto dest_nodes   = raft::make_host_vector<IdxT, IdxT>(graph_size);
-    auto d_dest_nodes = raft::make_device_vector<IdxT, IdxT>(res, graph_size);
-
-    for (uint64_t k = 0; k < output_graph_degree; k++) {
-#pragma omp parallel for
-      for (uint64_t i = 0; i < graph_size; i++) {
-        dest_nodes.data_handle()[i] = pruned_graph.data_handle()[k + (output_graph_degree * i)];
-      }
-      resource::sync_stream(res);
+    // The reverse graph is built in chunks of destination nodes to bound the device memory usage.
+    const uint32_t rev_chunk_size =
+      graph_on_device
+        ? graph_size
+        : max_rows_in_device_memory(
+            output_graph_degree * sizeof(IdxT) + sizeof(uint32_t) + sizeof(IdxT),
+            graph_size,
+            max_device_rows);
+    d_rev_graph = raft::make_device_matrix<IdxT, IdxT>(res, rev_chunk_size, output_graph_degree);
+    d_rev_graph_count = raft::make_device_vector<uint32_t, IdxT>(res, rev_chunk_size);
+
+    // The host pruned graph is copied to the device one rank at a time.
+    auto d_dest_nodes = raft::make_device_vector<IdxT, IdxT>(res, graph_on_device ? 0 : graph_size);
+
+    for (uint64_t chunk_offset = 0; chunk_offset < graph_size; chunk_offset += rev_chunk_size) {
+      const uint32_t chunk_size =
+        std::min<uint64_t>(rev_chunk_size, static_cast<uint64_t>(graph_size) - chunk_offset);
+      RAFT_CUDA_TRY(cudaMemsetAsync(
+        d_rev_graph.data_handle(),
+        0xff,
+        static_cast<uint64_t>(chunk_size) * output_graph_degree * sizeof(IdxT),
+        stream));
+      RAFT_CUDA_TRY(cudaMemsetAsync(
+        d_rev_graph_count.data_handle(), 0x00, chunk_size * sizeof(uint32_t), stream));
 
-      raft::copy(d_dest_nodes.data_handle(),
-                 dest_nodes.data_handle(),
-                 graph_size,
-                 resource::get_cuda_stream(res));
+      for (uint64_t k = 0; k < output_graph_degree; k++) {
+        const IdxT* dest_nodes = d_pruned_graph.data_handle() + k * graph_size;
+        if (!graph_on_device) {
+          raft::copy(d_dest_nodes.data_handle(),
+                     pruned_graph.data_handle() + k * graph_size,
+                     graph_size,
+                     stream);
+          dest_nodes = d_dest_nodes.data_handle();
+        }
 
-      dim3 threads(256, 1, 1);
-      dim3 blocks(1024, 1, 1);
-      kern_make_rev_graph<<<blocks, threads, 0, resource::get_cuda_stream(res)>>>(
-        d_dest_nodes.data_handle(),
-        d_rev_graph.data_handle(),
-        d_rev_graph_count.data_handle(),
-        graph_size,
-        output_graph_degree);
-      RAFT_LOG_DEBUG("# Making reverse graph on GPUs: %lu / %u    \r", k, output_graph_degree);
+        dim3 threads(256, 1, 1);
+        dim3 blocks(1024, 1, 1);
+        kern_make_rev_graph<<<blocks, threads, 0, stream>>>(dest_nodes,
+                                                            d_rev_graph.data_handle(),
+                                                            d_rev_graph_count.data_handle(),
+                                                            graph_size,
+                                                            output_graph_degree,
+                                                            chunk_offset,
+                                                            chunk_size);
+        RAFT_LOG_DEBUG("# Making reverse graph on GPUs: %lu / %u    \r", k, output_graph_degree);
+      }
+      RAFT_LOG_DEBUG("\n");
+
+      if (!graph_on_device) {
+        raft::copy(rev_graph.data_handle() + chunk_offset * output_graph_degree,
+                   d_rev_graph.data_handle(),
+                   static_cast<uint64_t>(chunk_size) * output_graph_degree,
+                   stream);
+        raft::copy(rev_graph_count.data_handle() + chunk_offset,
+                   d_rev_graph_count.data_handle(),
+                   chunk_size,
+                   stream);
+      }
     }
-
     resource::sync_stream(res);
-    RAFT_LOG_DEBUG("\n");
-
-    raft::copy(rev_graph.data_handle(),
-               d_rev_graph.data_handle(),
-               graph_size * output_graph_degree,
-               resource::get_cuda_stream(res));
-    raft::copy(rev_graph_count.data_handle(),
-               d_rev_graph_count.data_handle(),
-               graph_size,
-               resource::get_cuda_stream(res));
+    if (!graph_on_device) {
+      // release the chunk buffers before the merge
+      d_rev_graph       = raft::make_device_matrix<IdxT, IdxT>(res, 0, output_graph_degree);
+      d_rev_graph_count = raft::make_device_vector<uint32_t, IdxT>(res, 0);
+    }
 
     const double time_make_end = cur_time();
     RAFT_LOG_DEBUG("# Making reverse graph time: %.1lf sec", time_make_end - time_make_start);
@@ -539,51 +747,83 @@ void prune(raft::resources const& res,
     //
     const double time_replace_start = cur_time();
 
-    const uint64_t num_protected_edges = output_graph_degree / 2;
-    RAFT_LOG_DEBUG("# num_protected_edges: %lu", num_protected_edges);
-
-    memcpy(output_graph_ptr,
-           pruned_graph.data_handle(),
-           sizeof(IdxT) * graph_size * output_graph_degree);
-
-    constexpr int _omp_chunk = 1024;
-#pragma omp parallel for schedule(dynamic, _omp_chunk)
-    for (uint64_t j = 0; j < graph_size; j++) {
-      for (uint64_t _k = 0; _k < rev_graph_count.data_handle()[j]; _k++) {
-        uint64_t k = rev_graph_count.data_handle()[j] - 1 - _k;
-        uint64_t i = rev_graph.data_handle()[k + (output_graph_degree * j)];
-
-        uint64_t pos =
-          pos_in_array<IdxT>(i, output_graph_ptr + (output_graph_degree * j), output_graph_degree);
-        if (pos < num_protected_edges) { continue; }
-        uint64_t num_shift = pos - num_protected_edges;
-        if (pos == output_graph_degree) {
-          num_shift = output_graph_degree - num_protected_edges - 1;
-        }
-        shift_array<IdxT>(output_graph_ptr + num_protected_edges + (output_graph_degree * j),
-                          num_shift);
-        output_graph_ptr[num_protected_edges + (output_graph_degree * j)] = i;
-      }
-      if ((omp_get_thread_num() == 0) && ((j % _omp_chunk) == 0)) {
-        RAFT_LOG_DEBUG("# Replacing reverse edges: %lu / %lu    ", j, graph_size);
+    const uint32_t num_protected_edges = output_graph_degree / 2;
+    RAFT_LOG_DEBUG("# num_protected_edges: %u", num_protected_edges);
+
+    // The nodes are merged in batches; a single batch when the graph stays on the device.
+    const uint32_t merge_batch_size =
+      graph_on_device
+        ? graph_size
+        : max_rows_in_device_memory(output_graph_degree * 3 * sizeof(IdxT) + sizeof(uint32_t),
+                                    graph_size,
+                                    max_device_rows);
+    auto d_output_graph =
+      raft::make_device_matrix<IdxT, IdxT>(res, merge_batch_size, output_graph_degree);
+    auto d_pruned_batch = raft::make_device_matrix<IdxT, IdxT>(
+      res, graph_on_device ? 0 : output_graph_degree, merge_batch_size);
+    auto d_rev_batch = raft::make_device_matrix<IdxT, IdxT>(
+      res, graph_on_device ? 0 : merge_batch_size, output_graph_degree);
+    auto d_rev_count_batch =
+      raft::make_device_vector<uint32_t, IdxT>(res, graph_on_device ? 0 : merge_batch_size);
+    auto d_num_replaced = raft::make_device_vector<uint64_t>(res, 1);
+    RAFT_CUDA_TRY(cudaMemsetAsync(d_num_replaced.data_handle(), 0, sizeof(uint64_t), stream));
+
+    for (uint64_t batch_offset = 0; batch_offset < graph_size; batch_offset += merge_batch_size) {
+      const uint32_t this_batch_size =
+        std::min<uint64_t>(merge_batch_size, static_cast<uint64_t>(graph_size) - batch_offset);
+      const IdxT* pruned_ptr        = d_pruned_graph.data_handle();
+      uint64_t pruned_ld            = graph_size;
+      const IdxT* rev_ptr           = d_rev_graph.data_handle();
+      const uint32_t* rev_count_ptr = d_rev_graph_count.data_handle();
+      if (!graph_on_device) {
+        RAFT_CUDA_TRY(cudaMemcpy2DAsync(d_pruned_batch.data_handle(),
+                                        sizeof(IdxT) * merge_batch_size,
+                                        pruned_graph.data_handle() + batch_offset,
+                                        sizeof(IdxT) * graph_size,
+                                        sizeof(IdxT) * this_batch_size,
+                                        output_graph_degree,
+                                        cudaMemcpyDefault,
+                                        stream));
+        raft::copy(d_rev_batch.data_handle(),
+                   rev_graph.data_handle() + batch_offset * output_graph_degree,
+                   static_cast<uint64_t>(this_batch_size) * output_graph_degree,
+                   stream);
+        raft::copy(d_rev_count_batch.data_handle(),
+                   rev_graph_count.data_handle() + batch_offset,
+                   this_batch_size,
+                   stream);
+        pruned_ptr    = d_pruned_batch.data_handle();
+        pruned_ld     = merge_batch_size;
+        rev_ptr       = d_rev_batch.data_handle();
+        rev_count_ptr = d_rev_count_batch.data_handle();
       }
+      const dim3 threads(256, 1, 1);
+      const dim3 blocks(raft::ceildiv<uint32_t>(this_batch_size, threads.x), 1, 1);
+      kern_add_rev_edges<IdxT><<<blocks, threads, 0, stream>>>(pruned_ptr,
+                                                               pruned_ld,
+                                                               rev_ptr,
+                                                               rev_count_ptr,
+                                                               d_output_graph.data_handle(),
+                                                               this_batch_size,
+                                                               output_graph_degree,
+                                                               num_protected_edges,
+                                                               d_num_replaced.data_handle());
+      RAFT_CUDA_TRY(cudaPeekAtLastError());
+      raft::copy(output_graph_ptr + batch_offset * output_graph_degree,
+                 d_output_graph.data_handle(),
+                 static_cast<uint64_t>(this_batch_size) * output_graph_degree,
+                 stream);
+      RAFT_LOG_DEBUG("# Replacing reverse edges: %lu / %lu    ", batch_offset, graph_size);
     }
+    uint64_t num_replaced_edges = 0;
+    raft::copy(&num_replaced_edges, d_num_replaced.data_handle(), 1, stream);
+    resource::sync_stream(res);
     RAFT_LOG_DEBUG("\n");
 
     const double time_replace_end = cur_time();
     RAFT_LOG_DEBUG("# Replacing edges time: %.1lf sec", time_replace_end - time_replace_start);
 
     /* stats */
-    uint64_t num_replaced_edges = 0;
-#pragma omp parallel for reduction(+ : num_replaced_edges)
-    for (uint64_t i = 0; i < graph_size; i++) {
-      for (uint64_t k = 0; k < output_graph_degree; k++) {
-        const uint64_t j = pruned_graph.data_handle()[k + (output_graph_degree * i)];
-        const uint64_t pos =
-          pos_in_array<IdxT>(j, output_graph_ptr + (output_graph_degree * i), output_graph_degree);
-        if (pos == output_graph_degree) { num_replaced_edges += 1; }
-      }
-    }
     RAFT_LOG_DEBUG("# Average number of replaced edges per node: %.2f",
                    (double)num_replaced_edges / graph_size);
   }
@@ -26,6 +26,7 @@
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resource/device_properties.hpp>
 #include <raft/core/resources.hpp>
+#include <raft/neighbors/sample_filter_types.hpp>
 
 #include <vector>
 
@@ -131,7 +132,8 @@ template <unsigned TEAM_SIZE,
           class DATA_T,
           class DISTANCE_T,
           class INDEX_T,
-          class LOAD_T>
+          class LOAD_T,
+          class SAMPLE_FILTER_T>
 __launch_bounds__(BLOCK_SIZE, BLOCK_COUNT) __global__ void search_kernel(
   INDEX_T* const result_indices_ptr,       // [num_queries, num_cta_per_query, itopk_size]
   DISTANCE_T* const result_distances_ptr,  // [num_queries, num_cta_per_query, itopk_size]
@@ -152,8 +154,9 @@ __launch_bounds__(BLOCK_SIZE, BLOCK_COUNT) __global__ void search_kernel(
   const uint32_t num_parents,
   const uint32_t min_iteration,
   const uint32_t max_iteration,
-  uint32_t* const num_executed_iterations /* stats */
-)
+  uint32_t* const num_executed_iterations, /* stats */
+  SAMPLE_FILTER_T sample_filter,
+  const volatile uint32_t* const deadline_flag)  // or nullptr
 {
   assert(blockDim.x == BLOCK_SIZE);
   assert(dataset_dim <= MAX_DATASET_DIM);
@@ -189,6 +192,8 @@ __launch_bounds__(BLOCK_SIZE, BLOCK_COUNT) __global__ void search_kernel(
   uint32_t result_buffer_size    = itopk_size + (num_parents * graph_degree);
   uint32_t result_buffer_size_32 = result_buffer_size;
   if (result_buffer_size % 32) { result_buffer_size_32 += 32 - (result_buffer_size % 32); }
+  // Splits the children of the parents into (parent, neighbor) pairs in every iteration
+  const raft::util::FastUIntDiv<std::uint32_t> graph_degree_div(graph_degree);
   assert(result_buffer_size_32 <= MAX_ELEMENTS);
 
   auto query_buffer          = reinterpret_cast<float*>(smem);
@@ -264,6 +269,10 @@ __launch_bounds__(BLOCK_SIZE, BLOCK_COUNT) __global__ void search_kernel(
     _CLK_START();
     pickup_next_parents<INDEX_T>(
       parent_indices_buffer, num_parents, result_indices_buffer, itopk_size, terminate_flag);
+    // An expired deadline stops the search like a lack of new parents.
+    if (threadIdx.x == 0 && deadline_flag != nullptr && *deadline_flag != 0) {
+      *terminate_flag = 1;
+    }
     _CLK_REC(clk_pickup_parents);
 
     __syncthreads();
@@ -282,17 +291,45 @@ __launch_bounds__(BLOCK_SIZE, BLOCK_COUNT) __global__ void search_kernel(
         dataset_dim,
         dataset_ld,
         knn_graph,
-        graph_degree,
+        graph_degree_div,
         local_visited_hashmap_ptr,
         hash_bitlen,
         parent_indices_buffer,
         num_parents);
     _CLK_REC(clk_compute_distance);
+    if constexpr (!std::is_same<SAMPLE_FILTER_T,
+                                raft::neighbors::filtering::none_cagra_sample_filter>::value) {
+      // The neighbors of the parents are in the candidate list now; the filtered parents are not
+      // needed anymore.
+      device::remove_filtered_nodes(result_indices_buffer,
+                                    result_distances_buffer,
+                                    itopk_size,
+                                    query_id,
+                                    sample_filter,
+                                    true,
+                                    0,
+                                    BLOCK_SIZE);
+    }
     __syncthreads();
 
     iter++;
   }
 
+  if constexpr (!std::is_same<SAMPLE_FILTER_T,
+                              raft::neighbors::filtering::none_cagra_sample_filter>::value) {
+    // The removed nodes have the maximum distance, so they are dropped when the intermediate
+    // results of all CTAs are merged.
+    device::remove_filtered_nodes(result_indices_buffer,
+                                  result_distances_buffer,
+                                  itopk_size,
+                                  query_id,
+                                  sample_filter,
+                                  false,
+                                  0,
+                                  BLOCK_SIZE);
+    __syncthreads();
+  }
+
   for (uint32_t i = threadIdx.x; i < itopk_size; i += BLOCK_SIZE) {
     uint32_t j = i + (itopk_size * (cta_id + (num_cta_per_query * query_id)));
     if (result_distances_ptr != nullptr) { result_distances_ptr[j] = result_distances_buffer[i]; }
@@ -338,7 +375,8 @@ __launch_bounds__(BLOCK_SIZE, BLOCK_COUNT) __global__ void search_kernel(
                          DATA_T,                               \
                          DISTANCE_T,                           \
                          INDEX_T,                              \
-                         device::LOAD_128BIT_T>;
+                         device::LOAD_128BIT_T,                \
+                         SAMPLE_FILTER_T>;
 
 #define SET_MC_KERNEL_1(MAX_ELEMENTS)         \
   /* if ( block_size == 32 ) {                \
@@ -356,34 +394,36 @@ __launch_bounds__(BLOCK_SIZE, BLOCK_COUNT) __global__ void search_kernel(
     SET_MC_KERNEL_3(1024, 1, MAX_ELEMENTS)    \
   }
 
-#define SET_MC_KERNEL                                                       \
-  typedef void (*search_kernel_t)(INDEX_T* const result_indices_ptr,        \
-                                  DISTANCE_T* const result_distances_ptr,   \
-                                  const DATA_T* const dataset_ptr,          \
-                                  const size_t dataset_dim,                 \
-                                  const size_t dataset_size,                \
-                                  const size_t dataset_ld,                  \
-                                  const DATA_T* const queries_ptr,          \
-                                  const INDEX_T* const knn_graph,           \
-                                  const uint32_t graph_degree,              \
-                                  const unsigned num_distilation,           \
-                                  const uint64_t rand_xor_mask,             \
-                                  const INDEX_T* seed_ptr,                  \
-                                  const uint32_t num_seeds,                 \
-                                  INDEX_T* const visited_hashmap_ptr,       \
-                                  const uint32_t hash_bitlen,               \
-                                  const uint32_t itopk_size,                \
-                                  const uint32_t num_parents,               \
-                                  const uint32_t min_iteration,             \
-                                  const uint32_t max_iteration,             \
-                                  uint32_t* const num_executed_iterations); \
-  search_kernel_t kernel;                                                   \
-  if (result_buffer_size <= 64) {                                           \
-    SET_MC_KERNEL_1(64)                                                     \
-  } else if (result_buffer_size <= 128) {                                   \
-    SET_MC_KERNEL_1(128)                                                    \
-  } else if (result_buffer_size <= 256) {                                   \
-    SET_MC_KERNEL_1(256)                                                    \
+#define SET_MC_KERNEL                                                            \
+  typedef void (*search_kernel_t)(INDEX_T* const result_indices_ptr,             \
+                                  DISTANCE_T* const result_distances_ptr,        \
+                                  const DATA_T* const dataset_ptr,               \
+                                  const size_t dataset_dim,                      \
+                                  const size_t dataset_size,                     \
+                                  const size_t dataset_ld,                       \
+                                  const DATA_T* const queries_ptr,               \
+                                  const INDEX_T* const knn_graph,                \
+                                  const uint32_t graph_degree,                   \
+                                  const unsigned num_distilation,                \
+                                  const uint64_t rand_xor_mask,                  \
+                                  const INDEX_T* seed_ptr,                       \
+                                  const uint32_t num_seeds,                      \
+                                  INDEX_T* const visited_hashmap_ptr,            \
+                                  const uint32_t hash_bitlen,                    \
+                                  const uint32_t itopk_size,                     \
+                                  const uint32_t num_parents,                    \
+                                  const uint32_t min_iteration,                  \
+                                  const uint32_t max_iteration,                  \
+                                  uint32_t* const num_executed_iterations,       \
+                                  SAMPLE_FILTER_T sample_filter,                 \
+                                  const volatile uint32_t* const deadline_flag); \
+  search_kernel_t kernel;                                                        \
+  if (result_buffer_size <= 64) {                                                \
+    SET_MC_KERNEL_1(64)                                                          \
+  } else if (result_buffer_size <= 128) {                                        \
+    SET_MC_KERNEL_1(128)                                                         \
+  } else if (result_buffer_size <= 256) {                                        \
+    SET_MC_KERNEL_1(256)                                                         \
   }
 
 template <class T>
@@ -418,42 +458,43 @@ template <unsigned TEAM_SIZE,
           unsigned MAX_DATASET_DIM,
           typename DATA_T,
           typename INDEX_T,
-          typename DISTANCE_T>
-
-struct search : public search_plan_impl<DATA_T, INDEX_T, DISTANCE_T> {
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::max_queries;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::itopk_size;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::algo;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::team_size;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::num_parents;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::min_iterations;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::max_iterations;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::thread_block_size;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::hashmap_mode;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::hashmap_min_bitlen;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::hashmap_max_fill_rate;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::num_random_samplings;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::rand_xor_mask;
-
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::max_dim;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::dim;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::graph_degree;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::topk;
-
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::hash_bitlen;
-
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::small_hash_bitlen;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::small_hash_reset_interval;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::hashmap_size;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::dataset_size;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::result_buffer_size;
-
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::smem_size;
-
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::hashmap;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::num_executed_iterations;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::dev_seed;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::num_seeds;
+          typename DISTANCE_T,
+          typename SAMPLE_FILTER_T>
+
+struct search : public search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T> {
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::max_queries;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::itopk_size;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::algo;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::team_size;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::num_parents;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::min_iterations;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::max_iterations;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::thread_block_size;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::hashmap_mode;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::hashmap_min_bitlen;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::hashmap_max_fill_rate;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::num_random_samplings;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::rand_xor_mask;
+
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::max_dim;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::dim;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::graph_degree;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::topk;
+
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::hash_bitlen;
+
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::small_hash_bitlen;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::small_hash_reset_interval;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::hashmap_size;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::dataset_size;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::result_buffer_size;
+
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::smem_size;
+
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::hashmap;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::num_executed_iterations;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::dev_seed;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::num_seeds;
 
   uint32_t num_cta_per_query;
   rmm::device_uvector<INDEX_T> intermediate_indices;
@@ -466,7 +507,8 @@ struct search : public search_plan_impl<DATA_T, INDEX_T, DISTANCE_T> {
          int64_t dim,
          int64_t graph_degree,
          uint32_t topk)
-    : search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>(res, params, dim, graph_degree, topk),
+    : search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>(
+        res, params, dim, graph_degree, topk),
       intermediate_indices(0, resource::get_cuda_stream(res)),
       intermediate_distances(0, resource::get_cuda_stream(res)),
       topk_workspace(0, resource::get_cuda_stream(res))
@@ -554,7 +596,8 @@ struct search : public search_plan_impl<DATA_T, INDEX_T, DISTANCE_T> {
                   const uint32_t num_queries,
                   const INDEX_T* dev_seed_ptr,              // [num_queries, num_seeds]
                   uint32_t* const num_executed_iterations,  // [num_queries,]
-                  uint32_t topk)
+                  uint32_t topk,
+                  SAMPLE_FILTER_T sample_filter)
   {
     cudaStream_t stream = resource::get_cuda_stream(res);
     uint32_t block_size = thread_block_size;
@@ -593,7 +636,9 @@ struct search : public search_plan_impl<DATA_T, INDEX_T, DISTANCE_T> {
                                                          num_parents,
                                                          min_iterations,
                                                          max_iterations,
-                                                         num_executed_iterations);
+                                                         num_executed_iterations,
+                                                         sample_filter,
+                                                         this->deadline.device_flag());
     RAFT_CUDA_TRY(cudaPeekAtLastError());
 
     // Select the top-k results from the intermediate results
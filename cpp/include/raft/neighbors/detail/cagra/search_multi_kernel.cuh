@@ -25,6 +25,7 @@
 #include <raft/core/device_mdspan.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resources.hpp>
+#include <raft/neighbors/sample_filter_types.hpp>
 #include <rmm/device_scalar.hpp>
 #include <rmm/device_uvector.hpp>
 #include <vector>
@@ -39,6 +40,7 @@
 #include <raft/core/logger.hpp>
 #include <raft/util/cuda_rt_essentials.hpp>
 #include <raft/util/cudart_utils.hpp>  // RAFT_CUDA_TRY_NOT_THROW is used TODO(tfeher): consider moving this to cuda_rt_essentials.hpp
+#include <raft/util/fast_int_div.cuh>
 
 namespace raft::neighbors::experimental::cagra::detail {
 namespace multi_kernel_search {
@@ -92,7 +94,7 @@ template <unsigned TEAM_SIZE,
 __global__ void random_pickup_kernel(
   const DATA_T* const dataset_ptr,  // [dataset_size, dataset_dim]
   const std::size_t dataset_dim,
-  const std::size_t dataset_size,
+  const raft::util::FastUIntDiv<uint64_t> dataset_size,
   const std::size_t dataset_ld,
   const DATA_T* const queries_ptr,  // [num_queries, dataset_dim]
   const std::size_t num_pickup,
@@ -315,7 +317,7 @@ __global__ void compute_distance_to_child_nodes_kernel(
   const std::uint32_t dataset_size,
   const std::uint32_t dataset_ld,
   const INDEX_T* const neighbor_graph_ptr,  // [dataset_size, graph_degree]
-  const std::uint32_t graph_degree,
+  const raft::util::FastUIntDiv<uint32_t> graph_degree,
   const DATA_T* query_ptr,                  // [num_queries, data_dim]
   INDEX_T* const visited_hashmap_ptr,       // [num_queries, 1 << hash_bitlen]
   const std::uint32_t hash_bitlen,
@@ -327,17 +329,17 @@ __global__ void compute_distance_to_child_nodes_kernel(
   const uint32_t ldb        = hashmap::get_size(hash_bitlen);
   const auto tid            = threadIdx.x + blockDim.x * blockIdx.x;
   const auto global_team_id = tid / TEAM_SIZE;
-  if (global_team_id >= num_parents * graph_degree) { return; }
+  if (global_team_id >= num_parents * graph_degree.d) { return; }
 
-  const std::size_t parent_index =
-    parent_node_list[global_team_id / graph_degree + (num_parents * blockIdx.y)];
+  const uint32_t parent_ix = global_team_id / graph_degree;
+  const std::size_t parent_index = parent_node_list[parent_ix + (num_parents * blockIdx.y)];
   if (parent_index == utils::get_max_value<INDEX_T>()) {
     result_distances_ptr[ldd * blockIdx.y + global_team_id] = utils::get_max_value<DISTANCE_T>();
     return;
   }
-  const auto neighbor_list_head_ptr = neighbor_graph_ptr + (graph_degree * parent_index);
+  const auto neighbor_list_head_ptr = neighbor_graph_ptr + (graph_degree.d * parent_index);
 
-  const std::size_t child_id = neighbor_list_head_ptr[global_team_id % graph_degree];
+  const std::size_t child_id = neighbor_list_head_ptr[global_team_id - parent_ix * graph_degree.d];
 
   if (hashmap::insert<TEAM_SIZE, INDEX_T>(
         visited_hashmap_ptr + (ldb * blockIdx.y), hash_bitlen, child_id)) {
@@ -436,6 +438,115 @@ void remove_parent_bit(const std::uint32_t num_queries,
     num_queries, num_topk, topk_indices_ptr, ld);
 }
 
+template <class INDEX_T, class DISTANCE_T, class SAMPLE_FILTER_T>
+__global__ void apply_filter_kernel(INDEX_T* const result_indices_ptr,       // [num_queries, ld]
+                                    DISTANCE_T* const result_distances_ptr,  // [num_queries, ld]
+                                    const std::uint32_t ld,
+                                    const std::uint32_t result_buffer_size,
+                                    const std::uint32_t num_queries,
+                                    const bool parents_only,
+                                    SAMPLE_FILTER_T sample_filter)
+{
+  const uint32_t i_query = blockIdx.x;
+  if (i_query >= num_queries) return;
+
+  device::remove_filtered_nodes(result_indices_ptr + (ld * i_query),
+                                result_distances_ptr + (ld * i_query),
+                                result_buffer_size,
+                                i_query,
+                                sample_filter,
+                                parents_only,
+                                0,
+                                blockDim.x);
+}
+
+template <class INDEX_T, class DISTANCE_T, class SAMPLE_FILTER_T>
+void apply_filter(INDEX_T* const result_indices_ptr,       // [num_queries, ld]
+                  DISTANCE_T* const result_distances_ptr,  // [num_queries, ld]
+                  const std::uint32_t ld,
+                  const std::uint32_t result_buffer_size,
+                  const std::uint32_t num_queries,
+                  const bool parents_only,
+                  SAMPLE_FILTER_T sample_filter,
+                  cudaStream_t cuda_stream)
+{
+  const std::size_t grid_size  = num_queries;
+  const std::size_t block_size = 256;
+  apply_filter_kernel<<<grid_size, block_size, 0, cuda_stream>>>(result_indices_ptr,
+                                                                 result_distances_ptr,
+                                                                 ld,
+                                                                 result_buffer_size,
+                                                                 num_queries,
+                                                                 parents_only,
+                                                                 sample_filter);
+}
+
+// Copy the first `count` valid entries of each sorted result list, keeping their order. A single
+// warp handles each query.
+template <class INDEX_T, class DISTANCE_T>
+__global__ void compact_results_kernel(INDEX_T* const dst_indices_ptr,       // [num_queries, count]
+                                       DISTANCE_T* const dst_distances_ptr,  // [num_queries, count]
+                                       const std::uint32_t count,
+                                       const INDEX_T* const src_indices_ptr,  // [num_queries, ld]
+                                       const DISTANCE_T* const src_distances_ptr,
+                                       const std::uint32_t ld,
+                                       const std::uint32_t num_src,
+                                       const std::uint32_t num_queries)
+{
+  constexpr INDEX_T index_msb_1_mask = utils::gen_index_msb_1_mask<INDEX_T>::value;
+  const INDEX_T invalid_index        = utils::get_max_value<INDEX_T>();
+
+  const uint32_t i_query = blockIdx.x;
+  if (i_query >= num_queries) return;
+  const unsigned lane_id = threadIdx.x;
+
+  uint32_t max_src = num_src;
+  if (max_src % 32) { max_src += 32 - (max_src % 32); }
+  uint32_t num_found = 0;
+  for (uint32_t i = lane_id; i < max_src && num_found < count; i += 32) {
+    const INDEX_T index = i < num_src ? src_indices_ptr[i + (ld * i_query)] : invalid_index;
+    const bool valid                = index != invalid_index;
+    const std::uint32_t ballot_mask = __ballot_sync(0xffffffff, valid);
+    const std::uint32_t k = num_found + __popc(ballot_mask & ((1u << lane_id) - 1));
+    if (valid && k < count) {
+      dst_indices_ptr[k + (count * i_query)] = index & ~index_msb_1_mask;
+      if (dst_distances_ptr != nullptr) {
+        dst_distances_ptr[k + (count * i_query)] = src_distances_ptr[i + (ld * i_query)];
+      }
+    }
+    num_found += __popc(ballot_mask);
+  }
+  for (uint32_t k = num_found + lane_id; k < count; k += 32) {
+    dst_indices_ptr[k + (count * i_query)] = invalid_index;
+    if (dst_distances_ptr != nullptr) {
+      dst_distances_ptr[k + (count * i_query)] = utils::get_max_value<DISTANCE_T>();
+    }
+  }
+}
+
+template <class INDEX_T, class DISTANCE_T>
+void compact_results(INDEX_T* const dst_indices_ptr,       // [num_queries, count]
+                     DISTANCE_T* const dst_distances_ptr,  // [num_queries, count]
+                     const std::uint32_t count,
+                     const INDEX_T* const src_indices_ptr,  // [num_queries, ld]
+                     const DISTANCE_T* const src_distances_ptr,
+                     const std::uint32_t ld,
+                     const std::uint32_t num_src,
+                     const std::uint32_t num_queries,
+                     cudaStream_t cuda_stream)
+{
+  const std::size_t grid_size  = num_queries;
+  const std::size_t block_size = 32;
+  compact_results_kernel<<<grid_size, block_size, 0, cuda_stream>>>(dst_indices_ptr,
+                                                                    dst_distances_ptr,
+                                                                    count,
+                                                                    src_indices_ptr,
+                                                                    src_distances_ptr,
+                                                                    ld,
+                                                                    num_src,
+                                                                    num_queries);
+}
+
 template <class T>
 __global__ void batched_memcpy_kernel(T* const dst,        // [batch_size, ld_dst]
                                       const uint64_t ld_dst,
@@ -508,41 +619,42 @@ template <unsigned TEAM_SIZE,
           unsigned MAX_DATASET_DIM,
           typename DATA_T,
           typename INDEX_T,
-          typename DISTANCE_T>
-struct search : search_plan_impl<DATA_T, INDEX_T, DISTANCE_T> {
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::max_queries;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::itopk_size;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::algo;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::team_size;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::num_parents;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::min_iterations;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::max_iterations;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::thread_block_size;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::hashmap_mode;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::hashmap_min_bitlen;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::hashmap_max_fill_rate;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::num_random_samplings;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::rand_xor_mask;
-
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::max_dim;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::dim;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::graph_degree;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::topk;
-
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::hash_bitlen;
-
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::small_hash_bitlen;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::small_hash_reset_interval;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::hashmap_size;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::dataset_size;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::result_buffer_size;
-
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::smem_size;
-
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::hashmap;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::num_executed_iterations;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::dev_seed;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::num_seeds;
+          typename DISTANCE_T,
+          typename SAMPLE_FILTER_T>
+struct search : search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T> {
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::max_queries;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::itopk_size;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::algo;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::team_size;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::num_parents;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::min_iterations;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::max_iterations;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::thread_block_size;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::hashmap_mode;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::hashmap_min_bitlen;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::hashmap_max_fill_rate;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::num_random_samplings;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::rand_xor_mask;
+
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::max_dim;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::dim;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::graph_degree;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::topk;
+
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::hash_bitlen;
+
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::small_hash_bitlen;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::small_hash_reset_interval;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::hashmap_size;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::dataset_size;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::result_buffer_size;
+
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::smem_size;
+
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::hashmap;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::num_executed_iterations;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::dev_seed;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::num_seeds;
 
   size_t result_buffer_allocation_size;
   rmm::device_uvector<INDEX_T> result_indices;  // results_indices_buffer
@@ -557,7 +669,8 @@ struct search : search_plan_impl<DATA_T, INDEX_T, DISTANCE_T> {
          int64_t dim,
          int64_t graph_degree,
          uint32_t topk)
-    : search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>(res, params, dim, graph_degree, topk),
+    : search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>(
+        res, params, dim, graph_degree, topk),
       result_indices(0, resource::get_cuda_stream(res)),
       result_distances(0, resource::get_cuda_stream(res)),
       parent_node_list(0, resource::get_cuda_stream(res)),
@@ -602,8 +715,12 @@ struct search : search_plan_impl<DATA_T, INDEX_T, DISTANCE_T> {
                   const uint32_t num_queries,
                   const INDEX_T* dev_seed_ptr,              // [num_queries, num_seeds]
                   uint32_t* const num_executed_iterations,  // [num_queries,]
-                  uint32_t topk)
+                  uint32_t topk,
+                  SAMPLE_FILTER_T sample_filter)
   {
+    constexpr bool kFiltered =
+      !std::is_same<SAMPLE_FILTER_T, raft::neighbors::filtering::none_cagra_sample_filter>::value;
+
     // Init hashmap
     cudaStream_t stream      = resource::get_cuda_stream(res);
     const uint32_t hash_size = hashmap::get_size(hash_bitlen);
@@ -632,6 +749,13 @@ struct search : search_plan_impl<DATA_T, INDEX_T, DISTANCE_T> {
       hash_bitlen,
       stream);
 
+    // Reading the termination flag synchronizes the stream, which is not allowed while the search
+    // is captured into a CUDA graph; the captured search runs all the iterations instead (the
+    // iterations after the convergence find no new parents and change nothing).
+    cudaStreamCaptureStatus capture_status;
+    RAFT_CUDA_TRY(cudaStreamIsCapturing(stream, &capture_status));
+    const bool check_termination = capture_status == cudaStreamCaptureStatusNone;
+
     unsigned iter = 0;
     while (1) {
       // Make an index list of internal top-k nodes
@@ -676,7 +800,12 @@ struct search : search_plan_impl<DATA_T, INDEX_T, DISTANCE_T> {
                           stream);
 
       // termination (2)
-      if (iter + 1 >= min_iterations && terminate_flag.value(stream)) {
+      if (check_termination && iter + 1 >= min_iterations && terminate_flag.value(stream)) {
+        iter++;
+        break;
+      }
+      // termination (3): the deadline, checked on the host as the loop synchronizes anyway
+      if (check_termination && iter + 1 >= min_iterations && this->deadline.expired()) {
         iter++;
         break;
       }
@@ -700,32 +829,67 @@ struct search : search_plan_impl<DATA_T, INDEX_T, DISTANCE_T> {
         result_buffer_allocation_size,
         stream);
 
+      // The neighbors of the parents are in the candidate list now; the filtered parents are not
+      // needed anymore.
+      if constexpr (kFiltered) {
+        apply_filter(result_indices.data() + (1 - (iter & 0x1)) * result_buffer_size,
+                     result_distances.data() + (1 - (iter & 0x1)) * result_buffer_size,
+                     result_buffer_allocation_size,
+                     itopk_size,
+                     num_queries,
+                     true,
+                     sample_filter,
+                     stream);
+      }
+
       iter++;
     }  // while ( 1 )
 
-    // Remove parent bit in search results
-    remove_parent_bit(num_queries,
-                      itopk_size,
-                      result_indices.data() + (iter & 0x1) * result_buffer_size,
-                      result_buffer_allocation_size,
-                      stream);
-
-    // Copy results from working buffer to final buffer
-    batched_memcpy(topk_indices_ptr,
-                   topk,
-                   result_indices.data() + (iter & 0x1) * result_buffer_size,
+    if constexpr (kFiltered) {
+      // Drop the remaining filtered nodes and copy the rest of the sorted list to the final
+      // buffer.
+      apply_filter(result_indices.data() + (iter & 0x1) * result_buffer_size,
+                   result_distances.data() + (iter & 0x1) * result_buffer_size,
                    result_buffer_allocation_size,
-                   topk,
+                   itopk_size,
                    num_queries,
+                   false,
+                   sample_filter,
                    stream);
-    if (topk_distances_ptr) {
-      batched_memcpy(topk_distances_ptr,
+      compact_results(topk_indices_ptr,
+                      topk_distances_ptr,
+                      topk,
+                      result_indices.data() + (iter & 0x1) * result_buffer_size,
+                      result_distances.data() + (iter & 0x1) * result_buffer_size,
+                      result_buffer_allocation_size,
+                      itopk_size,
+                      num_queries,
+                      stream);
+    } else {
+      // Remove parent bit in search results
+      remove_parent_bit(num_queries,
+                        itopk_size,
+                        result_indices.data() + (iter & 0x1) * result_buffer_size,
+                        result_buffer_allocation_size,
+                        stream);
+
+      // Copy results from working buffer to final buffer
+      batched_memcpy(topk_indices_ptr,
                      topk,
-                     result_distances.data() + (iter & 0x1) * result_buffer_size,
+                     result_indices.data() + (iter & 0x1) * result_buffer_size,
                      result_buffer_allocation_size,
                      topk,
                      num_queries,
                      stream);
+      if (topk_distances_ptr) {
+        batched_memcpy(topk_distances_ptr,
+                       topk,
+                       result_distances.data() + (iter & 0x1) * result_buffer_size,
+                       result_buffer_allocation_size,
+                       topk,
+                       num_queries,
+                       stream);
+      }
     }
 
     if (num_executed_iterations) {
@@ -24,6 +24,7 @@
 #include <raft/core/device_mdspan.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/neighbors/cagra_types.hpp>
+#include <raft/neighbors/sample_filter_types.hpp>
 #include <raft/util/pow2_utils.cuh>
 
 namespace raft::neighbors::experimental::cagra::detail {
@@ -38,7 +39,10 @@ struct search_plan_impl_base : public search_params {
   {
     set_max_dim_team(dim);
     if (algo == search_algo::AUTO) {
-      if (itopk_size <= 512) {
+      if (persistent) {
+        algo = search_algo::SINGLE_CTA;
+        RAFT_LOG_DEBUG("Auto strategy: selecting single-cta for the persistent search");
+      } else if (itopk_size <= 512) {
         algo = search_algo::SINGLE_CTA;
         RAFT_LOG_DEBUG("Auto strategy: selecting single-cta");
       } else {
@@ -66,7 +70,7 @@ struct search_plan_impl_base : public search_params {
   }
 };
 
-template <class DATA_T, class INDEX_T, class DISTANCE_T>
+template <class DATA_T, class INDEX_T, class DISTANCE_T, class SAMPLE_FILTER_T>
 struct search_plan_impl : public search_plan_impl_base {
   int64_t hash_bitlen;
 
@@ -114,7 +118,8 @@ struct search_plan_impl : public search_plan_impl_base {
                           const std::uint32_t num_queries,
                           const INDEX_T* dev_seed_ptr,             // [num_queries, num_seeds]
                           std::uint32_t* const num_executed_iterations,  // [num_queries]
-                          uint32_t topk){};
+                          uint32_t topk,
+                          SAMPLE_FILTER_T sample_filter){};
 
   void adjust_search_params()
   {
@@ -299,6 +304,17 @@ struct search_plan_impl : public search_plan_impl_base {
         "`hashmap_max_fill_rate` must be equal to or greater than 0.1 and smaller than 0.9. " +
         std::to_string(hashmap_max_fill_rate) + " has been given.";
     }
+    if (persistent) {
+      if (algo != search_algo::SINGLE_CTA) {
+        error_message += "The persistent search is only available when 'search_mode' is "
+                         "\"single-cta\"";
+      }
+      if (!(persistent_device_usage > 0 && persistent_device_usage <= 1)) {
+        error_message += "`persistent_device_usage` must be greater than 0 and equal to or "
+                         "smaller than 1. " +
+                         std::to_string(persistent_device_usage) + " has been given.";
+      }
+    }
     if (algo == search_algo::MULTI_CTA) {
       if (hashmap_mode == hash_mode::SMALL) {
         error_message += "`small_hash` is not available when 'search_mode' is \"multi-cta\"";
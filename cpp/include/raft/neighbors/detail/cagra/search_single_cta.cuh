@@ -26,7 +26,10 @@
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resource/device_properties.hpp>
 #include <raft/core/resources.hpp>
+#include <raft/neighbors/detail/persistent_kernel.cuh>
+#include <raft/neighbors/sample_filter_types.hpp>
 #include <rmm/device_uvector.hpp>
+#include <tuple>
 #include <vector>
 
 #include "bitonic.hpp"
@@ -521,10 +524,25 @@ __device__ inline void set_value_device(T* const ptr, const T fill, const std::u
   }
 }
 
+/**
+ * The job of the persistent kernel: a batch of queries submitted by a single search call.
+ */
+template <class DATA_T, class INDEX_T, class DISTANCE_T, class SAMPLE_FILTER_T>
+struct persistent_job {
+  INDEX_T* result_indices_ptr;       // [num_queries, top_k]
+  DISTANCE_T* result_distances_ptr;  // [num_queries, top_k]
+  const DATA_T* queries_ptr;         // [num_queries, dataset_dim]
+  const INDEX_T* seed_ptr;           // [num_queries, num_seeds]
+  SAMPLE_FILTER_T sample_filter;
+};
+
+template <class DATA_T, class INDEX_T, class DISTANCE_T, class SAMPLE_FILTER_T>
+using persistent_queue =
+  persistent::work_queue<persistent_job<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>>;
+
 // One query one thread block
 template <unsigned TEAM_SIZE,
           unsigned BLOCK_SIZE,
-          unsigned BLOCK_COUNT,
           unsigned MAX_ITOPK,
           unsigned MAX_CANDIDATES,
           unsigned TOPK_BY_BITONIC_SORT,
@@ -532,34 +550,36 @@ template <unsigned TEAM_SIZE,
           class DATA_T,
           class DISTANCE_T,
           class INDEX_T,
-          class LOAD_T>
-__launch_bounds__(BLOCK_SIZE, BLOCK_COUNT) __global__
-  void search_kernel(INDEX_T* const result_indices_ptr,       // [num_queries, top_k]
-                     DISTANCE_T* const result_distances_ptr,  // [num_queries, top_k]
-                     const std::uint32_t top_k,
-                     const DATA_T* const dataset_ptr,         // [dataset_size, dataset_dim]
-                     const std::size_t dataset_dim,
-                     const std::size_t dataset_size,
-                     const std::size_t dataset_ld,     // stride of dataset
-                     const DATA_T* const queries_ptr,  // [num_queries, dataset_dim]
-                     const INDEX_T* const knn_graph,   // [dataset_size, graph_degree]
-                     const std::uint32_t graph_degree,
-                     const unsigned num_distilation,
-                     const uint64_t rand_xor_mask,
-                     const INDEX_T* seed_ptr,             // [num_queries, num_seeds]
-                     const uint32_t num_seeds,
-                     INDEX_T* const visited_hashmap_ptr,  // [num_queries, 1 << hash_bitlen]
-                     const std::uint32_t internal_topk,
-                     const std::uint32_t num_parents,
-                     const std::uint32_t min_iteration,
-                     const std::uint32_t max_iteration,
-                     std::uint32_t* const num_executed_iterations,  // [num_queries]
-                     const std::uint32_t hash_bitlen,
-                     const std::uint32_t small_hash_bitlen,
-                     const std::uint32_t small_hash_reset_interval)
+          class LOAD_T,
+          class SAMPLE_FILTER_T>
+__device__ void search_core(INDEX_T* const result_indices_ptr,       // [num_queries, top_k]
+                            DISTANCE_T* const result_distances_ptr,  // [num_queries, top_k]
+                            const std::uint32_t top_k,
+                            const DATA_T* const dataset_ptr,  // [dataset_size, dataset_dim]
+                            const std::size_t dataset_dim,
+                            const std::size_t dataset_size,
+                            const std::size_t dataset_ld,     // stride of dataset
+                            const DATA_T* const queries_ptr,  // [num_queries, dataset_dim]
+                            const INDEX_T* const knn_graph,   // [dataset_size, graph_degree]
+                            const std::uint32_t graph_degree,
+                            const unsigned num_distilation,
+                            const uint64_t rand_xor_mask,
+                            const INDEX_T* seed_ptr,  // [num_queries, num_seeds]
+                            const uint32_t num_seeds,
+                            INDEX_T* const visited_hashmap_ptr,  // [num_slots, 1 << hash_bitlen]
+                            const std::uint32_t internal_topk,
+                            const std::uint32_t num_parents,
+                            const std::uint32_t min_iteration,
+                            const std::uint32_t max_iteration,
+                            std::uint32_t* const num_executed_iterations,  // [num_queries]
+                            const std::uint32_t hash_bitlen,
+                            const std::uint32_t small_hash_bitlen,
+                            const std::uint32_t small_hash_reset_interval,
+                            SAMPLE_FILTER_T sample_filter,
+                            const volatile std::uint32_t* const deadline_flag,  // or nullptr
+                            const std::uint32_t query_id,
+                            const std::uint32_t hashmap_slot)
 {
-  const auto query_id = blockIdx.y;
-
 #ifdef _CLK_BREAKDOWN
   std::uint64_t clk_init                 = 0;
   std::uint64_t clk_compute_1st_distance = 0;
@@ -588,6 +608,8 @@ __launch_bounds__(BLOCK_SIZE, BLOCK_COUNT) __global__
   std::uint32_t result_buffer_size    = internal_topk + (num_parents * graph_degree);
   std::uint32_t result_buffer_size_32 = result_buffer_size;
   if (result_buffer_size % 32) { result_buffer_size_32 += 32 - (result_buffer_size % 32); }
+  // Splits the children of the parents into (parent, neighbor) pairs in every iteration
+  const raft::util::FastUIntDiv<std::uint32_t> graph_degree_div(graph_degree);
   const auto small_hash_size = hashmap::get_size(small_hash_bitlen);
   auto query_buffer          = reinterpret_cast<float*>(smem);
   auto result_indices_buffer = reinterpret_cast<INDEX_T*>(query_buffer + MAX_DATASET_DIM);
@@ -619,7 +641,8 @@ __launch_bounds__(BLOCK_SIZE, BLOCK_COUNT) __global__
   if (small_hash_bitlen) {
     local_visited_hashmap_ptr = visited_hash_buffer;
   } else {
-    local_visited_hashmap_ptr = visited_hashmap_ptr + (hashmap::get_size(hash_bitlen) * query_id);
+    local_visited_hashmap_ptr =
+      visited_hashmap_ptr + (hashmap::get_size(hash_bitlen) * hashmap_slot);
   }
   hashmap::init<0, BLOCK_SIZE>(local_visited_hashmap_ptr, hash_bitlen);
   __syncthreads();
@@ -735,6 +758,10 @@ __launch_bounds__(BLOCK_SIZE, BLOCK_COUNT) __global__
                                                          internal_topk,
                                                          dataset_size,
                                                          num_parents);
+      // An expired deadline stops the search like a lack of new parents.
+      if (threadIdx.x == 0 && deadline_flag != nullptr && *deadline_flag != 0) {
+        *terminate_flag = 1;
+      }
       _CLK_REC(clk_pickup_parents);
     }
 
@@ -762,26 +789,74 @@ __launch_bounds__(BLOCK_SIZE, BLOCK_COUNT) __global__
         dataset_dim,
         dataset_ld,
         knn_graph,
-        graph_degree,
+        graph_degree_div,
         local_visited_hashmap_ptr,
         hash_bitlen,
         parent_list_buffer,
         num_parents);
+    if constexpr (!std::is_same<SAMPLE_FILTER_T,
+                                raft::neighbors::filtering::none_cagra_sample_filter>::value) {
+      // The neighbors of the parents are in the candidate list now; the filtered parents are not
+      // needed anymore.
+      device::remove_filtered_nodes(result_indices_buffer,
+                                    result_distances_buffer,
+                                    internal_topk,
+                                    query_id,
+                                    sample_filter,
+                                    true,
+                                    0,
+                                    BLOCK_SIZE);
+    }
     __syncthreads();
     _CLK_REC(clk_compute_distance);
 
     iter++;
   }
-  for (std::uint32_t i = threadIdx.x; i < top_k; i += BLOCK_SIZE) {
-    unsigned j  = i + (top_k * query_id);
-    unsigned ii = i;
-    if (TOPK_BY_BITONIC_SORT) { ii = device::swizzling(i); }
-    if (result_distances_ptr != nullptr) { result_distances_ptr[j] = result_distances_buffer[ii]; }
+  if constexpr (std::is_same<SAMPLE_FILTER_T,
+                             raft::neighbors::filtering::none_cagra_sample_filter>::value) {
+    for (std::uint32_t i = threadIdx.x; i < top_k; i += BLOCK_SIZE) {
+      unsigned j  = i + (top_k * query_id);
+      unsigned ii = i;
+      if (TOPK_BY_BITONIC_SORT) { ii = device::swizzling(i); }
+      if (result_distances_ptr != nullptr) {
+        result_distances_ptr[j] = result_distances_buffer[ii];
+      }
 
-    constexpr INDEX_T index_msb_1_mask = utils::gen_index_msb_1_mask<INDEX_T>::value;
+      constexpr INDEX_T index_msb_1_mask = utils::gen_index_msb_1_mask<INDEX_T>::value;
 
-    result_indices_ptr[j] =
-      result_indices_buffer[ii] & ~index_msb_1_mask;  // clear most significant bit
+      result_indices_ptr[j] =
+        result_indices_buffer[ii] & ~index_msb_1_mask;  // clear most significant bit
+    }
+  } else if (threadIdx.x < 32) {
+    // The internal top-k list is sorted, so the first top_k nodes that pass the filter are the
+    // results. They are compacted with a single warp to keep their order.
+    constexpr INDEX_T index_msb_1_mask = utils::gen_index_msb_1_mask<INDEX_T>::value;
+    const INDEX_T invalid_index        = utils::get_max_value<INDEX_T>();
+    std::uint32_t num_found            = 0;
+    for (std::uint32_t i = threadIdx.x; i < internal_topk && num_found < top_k; i += 32) {
+      unsigned ii = i;
+      if (TOPK_BY_BITONIC_SORT) { ii = device::swizzling(i); }
+      const INDEX_T index = result_indices_buffer[ii] & ~index_msb_1_mask;
+      const bool valid =
+        result_indices_buffer[ii] != invalid_index && sample_filter(query_id, index);
+      const std::uint32_t ballot_mask = __ballot_sync(0xffffffff, valid);
+      const std::uint32_t k = num_found + __popc(ballot_mask & ((1u << threadIdx.x) - 1));
+      if (valid && k < top_k) {
+        const unsigned j = k + (top_k * query_id);
+        if (result_distances_ptr != nullptr) {
+          result_distances_ptr[j] = result_distances_buffer[ii];
+        }
+        result_indices_ptr[j] = index;
+      }
+      num_found += __popc(ballot_mask);
+    }
+    for (std::uint32_t k = num_found + threadIdx.x; k < top_k; k += 32) {
+      const unsigned j = k + (top_k * query_id);
+      if (result_distances_ptr != nullptr) {
+        result_distances_ptr[j] = utils::get_max_value<DISTANCE_T>();
+      }
+      result_indices_ptr[j] = invalid_index;
+    }
   }
   if (threadIdx.x == 0 && num_executed_iterations != nullptr) {
     num_executed_iterations[query_id] = iter + 1;
@@ -811,6 +886,138 @@ __launch_bounds__(BLOCK_SIZE, BLOCK_COUNT) __global__
 #endif
 }
 
+/**
+ * When PERSISTENT is false, the thread block `blockIdx.y` searches the query `blockIdx.y`.
+ *
+ * When PERSISTENT is true, the kernel runs until the host sets `queue->stop`; the thread blocks
+ * take the queries of the jobs submitted through `queue` one by one. The per-query arguments
+ * (results, queries, seeds and filter) are taken from the job, and the hashmap
+ * `visited_hashmap_ptr` has a slot per thread block.
+ */
+template <unsigned TEAM_SIZE,
+          unsigned BLOCK_SIZE,
+          unsigned BLOCK_COUNT,
+          unsigned MAX_ITOPK,
+          unsigned MAX_CANDIDATES,
+          unsigned TOPK_BY_BITONIC_SORT,
+          unsigned MAX_DATASET_DIM,
+          class DATA_T,
+          class DISTANCE_T,
+          class INDEX_T,
+          class LOAD_T,
+          class SAMPLE_FILTER_T,
+          bool PERSISTENT>
+__launch_bounds__(BLOCK_SIZE, BLOCK_COUNT) __global__ void search_kernel(
+  INDEX_T* const result_indices_ptr,       // [num_queries, top_k]
+  DISTANCE_T* const result_distances_ptr,  // [num_queries, top_k]
+  const std::uint32_t top_k,
+  const DATA_T* const dataset_ptr,  // [dataset_size, dataset_dim]
+  const std::size_t dataset_dim,
+  const std::size_t dataset_size,
+  const std::size_t dataset_ld,     // stride of dataset
+  const DATA_T* const queries_ptr,  // [num_queries, dataset_dim]
+  const INDEX_T* const knn_graph,   // [dataset_size, graph_degree]
+  const std::uint32_t graph_degree,
+  const unsigned num_distilation,
+  const uint64_t rand_xor_mask,
+  const INDEX_T* seed_ptr,  // [num_queries, num_seeds]
+  const uint32_t num_seeds,
+  INDEX_T* const visited_hashmap_ptr,  // [num_queries or gridDim.x, 1 << hash_bitlen]
+  const std::uint32_t internal_topk,
+  const std::uint32_t num_parents,
+  const std::uint32_t min_iteration,
+  const std::uint32_t max_iteration,
+  std::uint32_t* const num_executed_iterations,  // [num_queries]
+  const std::uint32_t hash_bitlen,
+  const std::uint32_t small_hash_bitlen,
+  const std::uint32_t small_hash_reset_interval,
+  SAMPLE_FILTER_T sample_filter,
+  const volatile std::uint32_t* const deadline_flag,  // or nullptr
+  persistent_queue<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>* const queue,
+  std::uint64_t* const next_ticket)
+{
+  if constexpr (!PERSISTENT) {
+    search_core<TEAM_SIZE,
+                BLOCK_SIZE,
+                MAX_ITOPK,
+                MAX_CANDIDATES,
+                TOPK_BY_BITONIC_SORT,
+                MAX_DATASET_DIM,
+                DATA_T,
+                DISTANCE_T,
+                INDEX_T,
+                LOAD_T,
+                SAMPLE_FILTER_T>(result_indices_ptr,
+                                 result_distances_ptr,
+                                 top_k,
+                                 dataset_ptr,
+                                 dataset_dim,
+                                 dataset_size,
+                                 dataset_ld,
+                                 queries_ptr,
+                                 knn_graph,
+                                 graph_degree,
+                                 num_distilation,
+                                 rand_xor_mask,
+                                 seed_ptr,
+                                 num_seeds,
+                                 visited_hashmap_ptr,
+                                 internal_topk,
+                                 num_parents,
+                                 min_iteration,
+                                 max_iteration,
+                                 num_executed_iterations,
+                                 hash_bitlen,
+                                 small_hash_bitlen,
+                                 small_hash_reset_interval,
+                                 sample_filter,
+                                 deadline_flag,
+                                 blockIdx.y,
+                                 blockIdx.y);
+  } else {
+    using job_t = persistent_job<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>;
+    persistent::serve(queue, next_ticket, [&](const job_t& job, std::uint32_t query_id) {
+      search_core<TEAM_SIZE,
+                  BLOCK_SIZE,
+                  MAX_ITOPK,
+                  MAX_CANDIDATES,
+                  TOPK_BY_BITONIC_SORT,
+                  MAX_DATASET_DIM,
+                  DATA_T,
+                  DISTANCE_T,
+                  INDEX_T,
+                  LOAD_T,
+                  SAMPLE_FILTER_T>(job.result_indices_ptr,
+                                   job.result_distances_ptr,
+                                   top_k,
+                                   dataset_ptr,
+                                   dataset_dim,
+                                   dataset_size,
+                                   dataset_ld,
+                                   job.queries_ptr,
+                                   knn_graph,
+                                   graph_degree,
+                                   num_distilation,
+                                   rand_xor_mask,
+                                   job.seed_ptr,
+                                   num_seeds,
+                                   visited_hashmap_ptr,
+                                   internal_topk,
+                                   num_parents,
+                                   min_iteration,
+                                   max_iteration,
+                                   nullptr,
+                                   hash_bitlen,
+                                   small_hash_bitlen,
+                                   small_hash_reset_interval,
+                                   job.sample_filter,
+                                   nullptr,
+                                   query_id,
+                                   blockIdx.x);
+    });
+  }
+}
+
 #define SET_KERNEL_3(BLOCK_SIZE, BLOCK_COUNT, MAX_ITOPK, MAX_CANDIDATES, TOPK_BY_BITONIC_SORT) \
   kernel = search_kernel<TEAM_SIZE,                                                            \
                          BLOCK_SIZE,                                                           \
@@ -822,7 +1029,9 @@ __launch_bounds__(BLOCK_SIZE, BLOCK_COUNT) __global__
                          DATA_T,                                                               \
                          DISTANCE_T,                                                           \
                          INDEX_T,                                                              \
-                         device::LOAD_128BIT_T>;
+                         device::LOAD_128BIT_T,                                                \
+                         SAMPLE_FILTER_T,                                                      \
+                         PERSISTENT>;
 
 #define SET_KERNEL_1B(MAX_ITOPK, MAX_CANDIDATES)              \
   /* if ( block_size == 32 ) {                                \
@@ -850,30 +1059,6 @@ __launch_bounds__(BLOCK_SIZE, BLOCK_COUNT) __global__
   }
 
 #define SET_KERNEL                                                                \
-  typedef void (*search_kernel_t)(INDEX_T* const result_indices_ptr,              \
-                                  DISTANCE_T* const result_distances_ptr,         \
-                                  const std::uint32_t top_k,                      \
-                                  const DATA_T* const dataset_ptr,                \
-                                  const std::size_t dataset_dim,                  \
-                                  const std::size_t dataset_size,                 \
-                                  const std::size_t dataset_ld,                   \
-                                  const DATA_T* const queries_ptr,                \
-                                  const INDEX_T* const knn_graph,                 \
-                                  const std::uint32_t graph_degree,               \
-                                  const unsigned num_distilation,                 \
-                                  const uint64_t rand_xor_mask,                   \
-                                  const INDEX_T* seed_ptr,                        \
-                                  const uint32_t num_seeds,                       \
-                                  INDEX_T* const visited_hashmap_ptr,             \
-                                  const std::uint32_t itopk_size,                 \
-                                  const std::uint32_t num_parents,                \
-                                  const std::uint32_t min_iteration,              \
-                                  const std::uint32_t max_iteration,              \
-                                  std::uint32_t* const num_executed_iterations,   \
-                                  const std::uint32_t hash_bitlen,                \
-                                  const std::uint32_t small_hash_bitlen,          \
-                                  const std::uint32_t small_hash_reset_interval); \
-  search_kernel_t kernel;                                                         \
   if (num_itopk_candidates <= 64) {                                               \
     constexpr unsigned max_candidates = 64;                                       \
     if (itopk_size <= 64) {                                                       \
@@ -920,41 +1105,97 @@ template <unsigned TEAM_SIZE,
           unsigned MAX_DATASET_DIM,
           typename DATA_T,
           typename INDEX_T,
-          typename DISTANCE_T>
-struct search : search_plan_impl<DATA_T, INDEX_T, DISTANCE_T> {
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::max_queries;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::itopk_size;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::algo;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::team_size;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::num_parents;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::min_iterations;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::max_iterations;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::thread_block_size;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::hashmap_mode;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::hashmap_min_bitlen;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::hashmap_max_fill_rate;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::num_random_samplings;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::rand_xor_mask;
-
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::max_dim;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::dim;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::graph_degree;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::topk;
-
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::hash_bitlen;
-
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::small_hash_bitlen;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::small_hash_reset_interval;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::hashmap_size;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::dataset_size;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::result_buffer_size;
-
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::smem_size;
-
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::hashmap;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::num_executed_iterations;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::dev_seed;
-  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>::num_seeds;
+          typename DISTANCE_T,
+          typename SAMPLE_FILTER_T>
+struct search : search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T> {
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::max_queries;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::itopk_size;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::algo;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::team_size;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::num_parents;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::min_iterations;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::max_iterations;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::thread_block_size;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::hashmap_mode;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::hashmap_min_bitlen;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::hashmap_max_fill_rate;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::num_random_samplings;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::rand_xor_mask;
+
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::max_dim;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::dim;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::graph_degree;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::topk;
+
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::hash_bitlen;
+
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::small_hash_bitlen;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::small_hash_reset_interval;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::hashmap_size;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::dataset_size;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::result_buffer_size;
+
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::smem_size;
+
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::hashmap;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::num_executed_iterations;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::dev_seed;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::num_seeds;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::persistent;
+  using search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>::persistent_device_usage;
+
+  using queue_type      = persistent_queue<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>;
+  using search_kernel_t = void (*)(INDEX_T* const result_indices_ptr,
+                                   DISTANCE_T* const result_distances_ptr,
+                                   const std::uint32_t top_k,
+                                   const DATA_T* const dataset_ptr,
+                                   const std::size_t dataset_dim,
+                                   const std::size_t dataset_size,
+                                   const std::size_t dataset_ld,
+                                   const DATA_T* const queries_ptr,
+                                   const INDEX_T* const knn_graph,
+                                   const std::uint32_t graph_degree,
+                                   const unsigned num_distilation,
+                                   const uint64_t rand_xor_mask,
+                                   const INDEX_T* seed_ptr,
+                                   const uint32_t num_seeds,
+                                   INDEX_T* const visited_hashmap_ptr,
+                                   const std::uint32_t itopk_size,
+                                   const std::uint32_t num_parents,
+                                   const std::uint32_t min_iteration,
+                                   const std::uint32_t max_iteration,
+                                   std::uint32_t* const num_executed_iterations,
+                                   const std::uint32_t hash_bitlen,
+                                   const std::uint32_t small_hash_bitlen,
+                                   const std::uint32_t small_hash_reset_interval,
+                                   SAMPLE_FILTER_T sample_filter,
+                                   const volatile std::uint32_t* const deadline_flag,
+                                   queue_type* const queue,
+                                   std::uint64_t* const next_ticket);
+  // The parameters of the persistent kernel launch
+  using persistent_key_type = std::tuple<search_kernel_t,
+                                         uint32_t,  // block_size
+                                         uint32_t,  // smem_size
+                                         float,     // persistent_device_usage
+                                         const DATA_T*,
+                                         int64_t,  // dataset size
+                                         int64_t,  // dataset dim
+                                         int64_t,  // dataset stride
+                                         const INDEX_T*,
+                                         int64_t,   // graph degree
+                                         uint32_t,  // topk
+                                         uint32_t,  // num_random_samplings
+                                         uint64_t,  // rand_xor_mask
+                                         uint32_t,  // num_seeds
+                                         size_t,    // itopk_size
+                                         size_t,    // num_parents
+                                         size_t,    // min_iterations
+                                         size_t,    // max_iterations
+                                         int64_t,   // hash_bitlen
+                                         size_t,    // small_hash_bitlen
+                                         size_t>;   // small_hash_reset_interval
+  using persistent_job_type = persistent_job<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>;
+  using persistent_runner_type = persistent::runner<persistent_job_type, persistent_key_type>;
 
   uint32_t num_itopk_candidates;
 
@@ -963,7 +1204,8 @@ struct search : search_plan_impl<DATA_T, INDEX_T, DISTANCE_T> {
          int64_t dim,
          int64_t graph_degree,
          uint32_t topk)
-    : search_plan_impl<DATA_T, INDEX_T, DISTANCE_T>(res, params, dim, graph_degree, topk)
+    : search_plan_impl<DATA_T, INDEX_T, DISTANCE_T, SAMPLE_FILTER_T>(
+        res, params, dim, graph_degree, topk)
   {
     set_params(res);
   }
@@ -1089,7 +1331,8 @@ struct search : search_plan_impl<DATA_T, INDEX_T, DISTANCE_T> {
     }
     RAFT_LOG_DEBUG("# smem_size: %u", smem_size);
     hashmap_size = 0;
-    if (small_hash_bitlen == 0) {
+    // The persistent kernel uses the hashmap of its runner
+    if (small_hash_bitlen == 0 && !persistent) {
       hashmap_size = sizeof(INDEX_T) * max_queries * hashmap::get_size(hash_bitlen);
       hashmap.resize(hashmap_size, resource::get_cuda_stream(res));
     }
@@ -1105,11 +1348,25 @@ struct search : search_plan_impl<DATA_T, INDEX_T, DISTANCE_T> {
                   const std::uint32_t num_queries,
                   const INDEX_T* dev_seed_ptr,                   // [num_queries, num_seeds]
                   std::uint32_t* const num_executed_iterations,  // [num_queries]
-                  uint32_t topk)
+                  uint32_t topk,
+                  SAMPLE_FILTER_T sample_filter)
   {
     cudaStream_t stream = resource::get_cuda_stream(res);
     uint32_t block_size = thread_block_size;
-    SET_KERNEL;
+    if (persistent) {
+      run_persistent(res,
+                     dataset,
+                     graph,
+                     result_indices_ptr,
+                     result_distances_ptr,
+                     queries_ptr,
+                     num_queries,
+                     dev_seed_ptr,
+                     topk,
+                     sample_filter);
+      return;
+    }
+    auto kernel = select_kernel<false>(block_size);
     RAFT_CUDA_TRY(
       cudaFuncSetAttribute(kernel, cudaFuncAttributeMaxDynamicSharedMemorySize, smem_size));
     dim3 thread_dims(block_size, 1, 1);
@@ -1138,9 +1395,113 @@ struct search : search_plan_impl<DATA_T, INDEX_T, DISTANCE_T> {
                                                            num_executed_iterations,
                                                            hash_bitlen,
                                                            small_hash_bitlen,
-                                                           small_hash_reset_interval);
+                                                           small_hash_reset_interval,
+                                                           sample_filter,
+                                                           this->deadline.device_flag(),
+                                                           nullptr,
+                                                           nullptr);
     RAFT_CUDA_TRY(cudaPeekAtLastError());
   }
+
+ private:
+  template <bool PERSISTENT>
+  auto select_kernel(uint32_t block_size) -> search_kernel_t
+  {
+    search_kernel_t kernel = nullptr;
+    SET_KERNEL;
+    return kernel;
+  }
+
+  void run_persistent(raft::resources const& res,
+                      raft::device_matrix_view<const DATA_T, INDEX_T, layout_stride> dataset,
+                      raft::device_matrix_view<const INDEX_T, INDEX_T, row_major> graph,
+                      INDEX_T* const result_indices_ptr,       // [num_queries, topk]
+                      DISTANCE_T* const result_distances_ptr,  // [num_queries, topk]
+                      const DATA_T* const queries_ptr,         // [num_queries, dataset_dim]
+                      const std::uint32_t num_queries,
+                      const INDEX_T* dev_seed_ptr,  // [num_queries, num_seeds]
+                      uint32_t topk,
+                      SAMPLE_FILTER_T sample_filter)
+  {
+    uint32_t block_size = thread_block_size;
+    auto kernel         = select_kernel<true>(block_size);
+    RAFT_CUDA_TRY(
+      cudaFuncSetAttribute(kernel, cudaFuncAttributeMaxDynamicSharedMemorySize, smem_size));
+    persistent_key_type key{kernel,
+                            block_size,
+                            smem_size,
+                            persistent_device_usage,
+                            dataset.data_handle(),
+                            dataset.extent(0),
+                            dataset.extent(1),
+                            dataset.stride(0),
+                            graph.data_handle(),
+                            graph.extent(1),
+                            topk,
+                            num_random_samplings,
+                            rand_xor_mask,
+                            num_seeds,
+                            itopk_size,
+                            num_parents,
+                            min_iterations,
+                            max_iterations,
+                            hash_bitlen,
+                            small_hash_bitlen,
+                            small_hash_reset_interval};
+    // The search arguments are copied to the launch, which runs only if the runner is replaced.
+    auto launch = [=](queue_type* queue,
+                      std::uint64_t* next_ticket,
+                      void* hashmap_ptr,
+                      uint32_t num_blocks,
+                      cudaStream_t stream) {
+      RAFT_LOG_DEBUG("Launching persistent kernel with %u threads, %u blocks %u smem",
+                     block_size,
+                     num_blocks,
+                     smem_size);
+      kernel<<<num_blocks, block_size, smem_size, stream>>>(nullptr,
+                                                            nullptr,
+                                                            topk,
+                                                            dataset.data_handle(),
+                                                            dataset.extent(1),
+                                                            dataset.extent(0),
+                                                            dataset.stride(0),
+                                                            nullptr,
+                                                            graph.data_handle(),
+                                                            graph.extent(1),
+                                                            num_random_samplings,
+                                                            rand_xor_mask,
+                                                            nullptr,
+                                                            num_seeds,
+                                                            static_cast<INDEX_T*>(hashmap_ptr),
+                                                            itopk_size,
+                                                            num_parents,
+                                                            min_iterations,
+                                                            max_iterations,
+                                                            nullptr,
+                                                            hash_bitlen,
+                                                            small_hash_bitlen,
+                                                            small_hash_reset_interval,
+                                                            sample_filter,
+                                                            nullptr,
+                                                            queue,
+                                                            next_ticket);
+    };
+    auto runner = persistent::get_runner<persistent_runner_type>(
+      key,
+      reinterpret_cast<const void*>(kernel),
+      block_size,
+      smem_size,
+      persistent_device_usage,
+      small_hash_bitlen == 0 ? sizeof(INDEX_T) * hashmap::get_size(hash_bitlen) : 0,
+      launch);
+    // The queries (and seeds) are produced in the stream of the caller, and the results are
+    // consumed there; the runner itself works in its own stream.
+    resource::sync_stream(res);
+    runner->submit(
+      persistent_job_type{
+        result_indices_ptr, result_distances_ptr, queries_ptr, dev_seed_ptr, sample_filter},
+      num_queries);
+  }
 };
 
 }  // namespace single_cta_search
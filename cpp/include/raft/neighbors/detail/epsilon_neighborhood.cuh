@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/error.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/distance.cuh>
+#include <raft/distance/distance_types.hpp>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+#include <raft/util/warp_primitives.cuh>
+
+#include <rmm/device_uvector.hpp>
+
+#include <thrust/copy.h>
+#include <thrust/scan.h>
+
+#include <algorithm>
+#include <cstdint>
+
+namespace raft::neighbors::epsilon_neighborhood::detail {
+
+/** The maximum number of elements in a tile of the distance matrix. */
+constexpr size_t kMaxTileSize = size_t{1} << 25;
+/** The maximum number of columns in a tile of the distance matrix. */
+constexpr int kMaxTileCols = 1 << 15;
+
+/**
+ * Compact the neighbors in every row of a distance tile [tile_rows, tile_cols].
+ *
+ * A warp per row walks over the tile columns, `WarpSize` at a time, and uses a ballot to find the
+ * neighbors and their positions in the output, so the order of the columns is preserved.
+ * `row_cursor[r]` is the position in the output the next neighbor of the row `r` goes to; it is
+ * advanced by the number of neighbors found in the tile. When `indices == nullptr`, only the
+ * cursors are updated (the counting pass).
+ */
+template <typename value_t, typename idx_t, typename nnz_t>
+__global__ void compact_tile_kernel(const value_t* dist,
+                                    idx_t tile_rows,
+                                    idx_t tile_cols,
+                                    value_t eps,
+                                    bool select_min,
+                                    idx_t col_offset,
+                                    nnz_t* row_cursor,
+                                    idx_t* indices,
+                                    value_t* values)
+{
+  const auto row = idx_t((size_t(blockIdx.x) * blockDim.x + threadIdx.x) / WarpSize);
+  if (row >= tile_rows) { return; }
+  const uint32_t lane    = laneId();
+  const uint32_t lt_mask = (1u << lane) - 1u;
+  dist += size_t(row) * size_t(tile_cols);
+
+  nnz_t cursor = row_cursor[row];
+  for (idx_t j0 = 0; j0 < tile_cols; j0 += WarpSize) {
+    const idx_t j = j0 + lane;
+    value_t d     = 0;
+    bool is_neigh = false;
+    if (j < tile_cols) {
+      d        = dist[j];
+      is_neigh = select_min ? d <= eps : d >= eps;
+    }
+    const uint32_t mask = ballot(is_neigh);
+    if (is_neigh && indices != nullptr) {
+      const nnz_t pos = cursor + __popc(mask & lt_mask);
+      indices[pos]    = col_offset + j;
+      values[pos]     = d;
+    }
+    cursor += __popc(mask);
+  }
+  if (lane == 0) { row_cursor[row] = cursor; }
+}
+
+/**
+ * See raft::neighbors::epsilon_neighborhood::eps_neighbors for docs.
+ *
+ * The distances are computed tile by tile twice: the first pass counts the neighbors of every row
+ * to compute the CSR row offsets and the total number of the neighbors, the second one fills in
+ * the column indices and the distances. Hence, the temporary memory is bounded by the tile size
+ * and the output is allocated exactly.
+ */
+template <typename value_t, typename idx_t, typename nnz_t>
+void eps_neighbors(raft::resources const& handle,
+                   raft::device_matrix_view<const value_t, idx_t, row_major> x,
+                   raft::device_matrix_view<const value_t, idx_t, row_major> y,
+                   raft::device_csr_matrix<value_t, idx_t, idx_t, nnz_t>& adj,
+                   value_t eps,
+                   raft::distance::DistanceType metric,
+                   value_t metric_arg)
+{
+  const idx_t m = x.extent(0);
+  const idx_t n = y.extent(0);
+  const idx_t k = x.extent(1);
+  RAFT_EXPECTS(y.extent(1) == k, "x and y must have the same number of columns");
+  RAFT_EXPECTS(adj.structure_view().get_n_rows() == m && adj.structure_view().get_n_cols() == n,
+               "The output adjacency matrix must be [x.extent(0), y.extent(0)]");
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "epsilon_neighborhood::eps_neighbors(%zu, %zu)", size_t(m), size_t(n));
+
+  auto stream           = resource::get_cuda_stream(handle);
+  auto mr               = resource::get_workspace_resource(handle);
+  const bool select_min = raft::distance::is_min_close(metric);
+
+  const idx_t tile_cols = std::max<idx_t>(1, std::min<idx_t>(n, kMaxTileCols));
+  const idx_t tile_rows =
+    std::max<idx_t>(1, std::min<idx_t>(m, idx_t(kMaxTileSize / size_t(tile_cols))));
+  rmm::device_uvector<value_t> dist(size_t(tile_rows) * size_t(tile_cols), stream, mr);
+  rmm::device_uvector<char> workspace(0, stream, mr);
+  rmm::device_uvector<nnz_t> row_cursor(m + 1, stream, mr);
+
+  // Run `compact_tile_kernel` over all tiles of the distance matrix.
+  auto tiled_pass = [&](idx_t* indices, value_t* values) {
+    for (idx_t i = 0; i < m; i += tile_rows) {
+      const idx_t rows = std::min<idx_t>(tile_rows, m - i);
+      for (idx_t j = 0; j < n; j += tile_cols) {
+        const idx_t cols = std::min<idx_t>(tile_cols, n - j);
+        raft::distance::pairwise_distance<value_t, int>(handle,
+                                                        x.data_handle() + size_t(i) * k,
+                                                        y.data_handle() + size_t(j) * k,
+                                                        dist.data(),
+                                                        int(rows),
+                                                        int(cols),
+                                                        int(k),
+                                                        workspace,
+                                                        metric,
+                                                        true,
+                                                        metric_arg);
+        constexpr int kBlockDim = 256;
+        const auto n_blocks     = raft::ceildiv<size_t>(size_t(rows) * WarpSize, kBlockDim);
+        compact_tile_kernel<<<n_blocks, kBlockDim, 0, stream>>>(dist.data(),
+                                                                rows,
+                                                                cols,
+                                                                eps,
+                                                                select_min,
+                                                                j,
+                                                                row_cursor.data() + i,
+                                                                indices,
+                                                                values);
+        RAFT_CUDA_TRY(cudaPeekAtLastError());
+      }
+    }
+  };
+
+  // Pass 1: count the neighbors of every row.
+  RAFT_CUDA_TRY(cudaMemsetAsync(row_cursor.data(), 0, sizeof(nnz_t) * row_cursor.size(), stream));
+  if (n > 0) { tiled_pass(nullptr, nullptr); }
+  thrust::exclusive_scan(resource::get_thrust_policy(handle),
+                         row_cursor.data(),
+                         row_cursor.data() + m + 1,
+                         row_cursor.data());
+  nnz_t nnz = 0;
+  raft::update_host(&nnz, row_cursor.data() + m, 1, stream);
+  resource::sync_stream(handle);
+
+  adj.initialize_sparsity(nnz);
+  auto structure = adj.structure_view();
+  auto indptr    = structure.get_indptr().data();
+  thrust::copy(resource::get_thrust_policy(handle),
+               row_cursor.data(),
+               row_cursor.data() + m + 1,
+               indptr);
+  if (nnz == 0) { return; }
+
+  // Pass 2: fill in the neighbors, starting at the row offsets.
+  tiled_pass(structure.get_indices().data(), adj.get_elements().data());
+}
+
+}  // namespace raft::neighbors::epsilon_neighborhood::detail
@@ -7,6 +7,9 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
+
 namespace raft::neighbors::detail::faiss_select {
 // If the inner size (dim) of the vectors is small, we want a larger query tile
 // size, like 1024
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/deadline.hpp>
+#include <raft/core/interruptible.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+#include <raft/util/integer_utils.hpp>
+
+#include <cstdint>
+#include <limits>
+
+namespace raft::neighbors::ivf::detail {
+
+/** The label of a probe dropped by the adaptive probing (see `adaptive_probes`). */
+constexpr static inline uint32_t kSkippedProbe = std::numeric_limits<uint32_t>::max();
+
+/** The maximum number of queries searched in one batch by a search with a deadline. */
+constexpr static inline uint32_t kDeadlineMaxQueries = 4096;
+
+/**
+ * Whether the IVF search with the given deadline is late, i.e. the following batches of queries
+ * should probe their closest cluster only.
+ *
+ * The batches are enqueued much faster than they run, hence, with `wait`, the work already in the
+ * stream is waited for first, so that the deadline is compared with the actual progress.
+ */
+inline auto is_past_deadline(raft::resources const& res, const raft::deadline& deadline, bool wait)
+  -> bool
+{
+  if (!deadline.is_set()) { return false; }
+  if (deadline.expired()) { return true; }
+  if (!wait) { return false; }
+  interruptible::synchronize(resource::get_cuda_stream(res));
+  return deadline.expired();
+}
+
+/** Whether the adaptive probing is enabled by the given search parameters. */
+inline auto is_adaptive_probing(uint32_t max_candidates, float probe_distance_ratio) -> bool
+{
+  return max_candidates > 0 || probe_distance_ratio > 0.0f;
+}
+
+template <int BlockDim>
+__launch_bounds__(BlockDim) __global__
+  void adaptive_probes_kernel(uint32_t n_queries,
+                              uint32_t n_probes,
+                              const float* coarse_dists,    // [n_queries, n_probes]
+                              const float* query_norms,     // [n_queries] or nullptr
+                              uint32_t* clusters_to_probe,  // [n_queries, n_probes]
+                              const uint32_t* list_sizes,   // [n_lists]
+                              uint64_t max_candidates,
+                              float probe_distance_ratio,
+                              bool mark_skipped,
+                              uint32_t* probe_counts)  // [n_queries] or nullptr
+{
+  const uint32_t query_ix = threadIdx.x + BlockDim * blockIdx.x;
+  if (query_ix >= n_queries) { return; }
+  coarse_dists += uint64_t(n_probes) * query_ix;
+  clusters_to_probe += uint64_t(n_probes) * query_ix;
+  const float norm  = query_norms != nullptr ? query_norms[query_ix] : 0.0f;
+  const float limit = probe_distance_ratio > 0.0f
+                        ? max(coarse_dists[0] + norm, 0.0f) * probe_distance_ratio
+                        : upper_bound<float>();
+  uint64_t n_candidates = 0;
+  uint32_t n_kept       = 0;
+  // The closest cluster is always probed; the rest - while within the budget and the ratio.
+  for (; n_kept < n_probes; n_kept++) {
+    if (n_kept > 0 && (n_candidates >= max_candidates || coarse_dists[n_kept] + norm > limit)) {
+      break;
+    }
+    n_candidates += list_sizes[clusters_to_probe[n_kept]];
+  }
+  if (probe_counts != nullptr) { probe_counts[query_ix] = n_kept; }
+  if (mark_skipped) {
+    for (uint32_t probe_ix = n_kept; probe_ix < n_probes; probe_ix++) {
+      clusters_to_probe[probe_ix] = kSkippedProbe;
+    }
+  }
+}
+
+/**
+ * Bound the number of probes of every query (adaptive probing).
+ *
+ * Every query keeps the clusters in the order of the coarse distance (the closest one is always
+ * kept) until the probed lists contain at least `max_candidates` records in total, or the coarse
+ * distance exceeds `probe_distance_ratio` times the distance to the closest cluster. Thus, the
+ * queries landing in the dense clusters probe fewer lists than those landing in the sparse ones.
+ *
+ * The probes kept by a query form a prefix of its row in `clusters_to_probe`; the rest are either
+ * marked as `kSkippedProbe` (when `mark_skipped`) or left intact, with the sizes of the prefixes
+ * written to `probe_counts`.
+ *
+ * @param[in] res
+ * @param n_queries
+ * @param n_probes
+ * @param[in] coarse_dists the sorted (ascending) coarse distances [n_queries, n_probes]; for the
+ *   distance ratio to make sense, they must be non-negative (i.e. squared L2 distances).
+ * @param[in] query_norms optional terms added to the coarse distances of the queries [n_queries]
+ *   (e.g. the squared query norms, if the coarse distances omit them).
+ * @param[inout] clusters_to_probe the probed clusters [n_queries, n_probes]
+ * @param[in] list_sizes the sizes of the lists of the index [n_lists]
+ * @param max_candidates the candidate budget per query (zero means unlimited)
+ * @param probe_distance_ratio the coarse distance ratio (zero means unlimited)
+ * @param mark_skipped whether to overwrite the dropped probes with `kSkippedProbe`
+ * @param[out] probe_counts optional numbers of the probes kept by the queries [n_queries]
+ */
+inline void adaptive_probes(raft::resources const& res,
+                            uint32_t n_queries,
+                            uint32_t n_probes,
+                            const float* coarse_dists,
+                            const float* query_norms,
+                            uint32_t* clusters_to_probe,
+                            const uint32_t* list_sizes,
+                            uint32_t max_candidates,
+                            float probe_distance_ratio,
+                            bool mark_skipped,
+                            uint32_t* probe_counts)
+{
+  if (n_queries == 0) { return; }
+  constexpr int kBlockDim = 128;
+  const uint64_t budget =
+    max_candidates > 0 ? uint64_t(max_candidates) : std::numeric_limits<uint64_t>::max();
+  const uint32_t n_blocks = raft::ceildiv<uint32_t>(n_queries, kBlockDim);
+  adaptive_probes_kernel<kBlockDim>
+    <<<n_blocks, kBlockDim, 0, resource::get_cuda_stream(res)>>>(n_queries,
+                                                                 n_probes,
+                                                                 coarse_dists,
+                                                                 query_norms,
+                                                                 clusters_to_probe,
+                                                                 list_sizes,
+                                                                 budget,
+                                                                 probe_distance_ratio,
+                                                                 mark_skipped,
+                                                                 probe_counts);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+}  // namespace raft::neighbors::ivf::detail
@@ -26,6 +26,9 @@
 #include <raft/linalg/add.cuh>
 #include <raft/linalg/map.cuh>
 #include <raft/linalg/norm.cuh>
+#include <raft/linalg/unary_op.cuh>
+#include <raft/matrix/gather.cuh>
+#include <raft/neighbors/detail/ivf_remove.cuh>
 #include <raft/neighbors/ivf_flat_types.hpp>
 #include <raft/neighbors/ivf_list.hpp>
 #include <raft/neighbors/ivf_list_types.hpp>
@@ -34,8 +37,11 @@
 #include <raft/util/pow2_utils.cuh>
 
 #include <rmm/cuda_stream_view.hpp>
+#include <rmm/device_scalar.hpp>
 
 #include <cstdint>
+#include <memory>
+#include <vector>
 
 namespace raft::neighbors::ivf_flat::detail {
 
@@ -71,7 +77,8 @@ auto clone(const raft::resources& res, const index<T, IdxT>& source) -> index<T,
          stream);
   }
   // Copy shared pointers
-  target.lists() = source.lists();
+  target.lists()      = source.lists();
+  target.list_arena() = source.list_arena();
 
   // Make sure the device pointers point to the new lists
   target.recompute_internal_state(res);
@@ -108,6 +115,15 @@ auto clone(const raft::resources& res, const index<T, IdxT>& source) -> index<T,
  * @param n_rows source length
  * @param dim the dimensionality of the data
  * @param veclen size of vectorized loads/stores; must satisfy `dim % veclen == 0`.
+ * @param[in] list_capacities optional device pointer to the capacities of the lists [n_lists];
+ *   if given, the rows not fitting into their lists are not recorded, but reported in
+ *   `overflow_rows` (and the list sizes must be clamped to the capacities afterwards).
+ * @param[out] overflow_rows device pointer to the overflowed source rows [n_rows]
+ *   (used only along with `list_capacities`)
+ * @param[inout] n_overflow device pointer to the counter of the overflowed rows
+ *   (used only along with `list_capacities`); must be initialized with zero.
+ * @param normalize whether to normalize the vectors while recording them (the `CosineExpanded`
+ *   metric, floating-point `T` only).
  *
  */
 template <typename T, typename IdxT, typename LabelT, bool gather_src = false>
@@ -119,13 +135,21 @@ __global__ void build_index_kernel(const LabelT* labels,
                                    uint32_t* list_sizes_ptr,
                                    IdxT n_rows,
                                    uint32_t dim,
-                                   uint32_t veclen)
+                                   uint32_t veclen,
+                                   const uint32_t* list_capacities = nullptr,
+                                   IdxT* overflow_rows             = nullptr,
+                                   uint32_t* n_overflow            = nullptr,
+                                   bool normalize                  = false)
 {
   const IdxT i = IdxT(blockDim.x) * IdxT(blockIdx.x) + threadIdx.x;
   if (i >= n_rows) { return; }
 
-  auto list_id     = labels[i];
-  auto inlist_id   = atomicAdd(list_sizes_ptr + list_id, 1);
+  auto list_id   = labels[i];
+  auto inlist_id = atomicAdd(list_sizes_ptr + list_id, 1);
+  if (list_capacities != nullptr && inlist_id >= list_capacities[list_id]) {
+    overflow_rows[atomicAdd(n_overflow, 1)] = i;
+    return;
+  }
   auto* list_index = list_index_ptrs[list_id];
   auto* list_data  = list_data_ptrs[list_id];
 
@@ -148,6 +172,22 @@ __global__ void build_index_kernel(const LabelT* labels,
   }
   // Interleave dimensions of the source vector while recording it.
   // NB: such `veclen` is selected, that `dim % veclen == 0`
+  if constexpr (std::is_same_v<T, float> || std::is_same_v<T, half>) {
+    if (normalize) {
+      float norm = 0.0f;
+      for (uint32_t l = 0; l < dim; l++) {
+        const float x = float(source_vecs[l]);
+        norm += x * x;
+      }
+      const float scale = norm > 0.0f ? rsqrtf(norm) : 1.0f;
+      for (uint32_t l = 0; l < dim; l += veclen) {
+        for (uint32_t j = 0; j < veclen; j++) {
+          list_data[l * kIndexGroupSize + ingroup_id + j] = T(float(source_vecs[l + j]) * scale);
+        }
+      }
+      return;
+    }
+  }
   for (uint32_t l = 0; l < dim; l += veclen) {
     for (uint32_t j = 0; j < veclen; j++) {
       list_data[l * kIndexGroupSize + ingroup_id + j] = source_vecs[l + j];
@@ -176,10 +216,13 @@ void extend(raft::resources const& handle,
 
   RAFT_EXPECTS(new_indices != nullptr || index->size() == 0,
                "You must pass data indices when the index is non-empty.");
+  const bool normalize = index->metric() == raft::distance::DistanceType::CosineExpanded;
 
   auto new_labels = raft::make_device_vector<LabelT, IdxT>(handle, n_rows);
   raft::cluster::kmeans_balanced_params kmeans_params;
-  kmeans_params.metric  = index->metric();
+  // NB: the nearest (normalized) center by the inner product does not depend on the norm of the
+  //     row, hence the rows are not normalized for the cosine metric here.
+  kmeans_params.metric  = utils::internal_metric(index->metric());
   auto new_vectors_view = raft::make_device_matrix_view<const T, IdxT>(new_vectors, n_rows, dim);
   auto orig_centroids_view =
     raft::make_device_matrix_view<const float, IdxT>(index->centers().data_handle(), n_lists, dim);
@@ -234,7 +277,8 @@ void extend(raft::resources const& handle,
                        lists[label],
                        list_device_spec,
                        new_list_sizes[label],
-                       Pow2<kIndexGroupSize>::roundUp(old_list_sizes[label]));
+                       Pow2<kIndexGroupSize>::roundUp(old_list_sizes[label]),
+                       index->list_arena());
     }
   }
   // Update the pointers and the sizes
@@ -254,7 +298,11 @@ void extend(raft::resources const& handle,
                                                          list_sizes_ptr,
                                                          n_rows,
                                                          dim,
-                                                         index->veclen());
+                                                         index->veclen(),
+                                                         nullptr,
+                                                         nullptr,
+                                                         nullptr,
+                                                         normalize);
   RAFT_CUDA_TRY(cudaPeekAtLastError());
 
   // Precompute the centers vector norms for L2Expanded distance
@@ -282,6 +330,136 @@ void extend(raft::resources const& handle,
   }
 }
 
+/** See raft::neighbors::ivf_flat::helpers::reserve docs */
+template <typename T, typename IdxT>
+void reserve(raft::resources const& handle, index<T, IdxT>* index, uint32_t n_free_records)
+{
+  RAFT_EXPECTS(index != nullptr, "index cannot be empty.");
+  auto stream  = resource::get_cuda_stream(handle);
+  auto n_lists = index->n_lists();
+  list_spec<uint32_t, T, IdxT> list_device_spec{index->dim(),
+                                                index->conservative_memory_allocation()};
+  std::vector<uint32_t> list_sizes(n_lists);
+  copy(list_sizes.data(), index->list_sizes().data_handle(), n_lists, stream);
+  resource::sync_stream(handle);
+  auto& lists = index->lists();
+  for (uint32_t label = 0; label < n_lists; label++) {
+    ivf::resize_list(handle,
+                     lists[label],
+                     list_device_spec,
+                     list_sizes[label] + n_free_records,
+                     Pow2<kIndexGroupSize>::roundUp(list_sizes[label]),
+                     index->list_arena());
+  }
+  index->recompute_internal_state(handle);
+}
+
+/** See raft::neighbors::ivf_flat::helpers::extend_inplace docs */
+template <typename T, typename IdxT>
+void extend_inplace(raft::resources const& handle,
+                    index<T, IdxT>* index,
+                    const T* new_vectors,
+                    const IdxT* new_indices,
+                    IdxT n_rows)
+{
+  using LabelT = uint32_t;
+  RAFT_EXPECTS(index != nullptr, "index cannot be empty.");
+  RAFT_EXPECTS(new_indices != nullptr || index->size() == 0,
+               "You must pass data indices when the index is non-empty.");
+  // The in-place path updates neither the centers nor their norms, and it must not write into the
+  // lists shared with the clones of the index; fall back to the regular path in these cases.
+  bool inplace_feasible =
+    !index->adaptive_centers() &&
+    (index->center_norms().has_value() ||
+     utils::internal_metric(index->metric()) == raft::distance::DistanceType::InnerProduct);
+  for (const auto& list : index->lists()) {
+    inplace_feasible &= !list || list.use_count() == 1;
+  }
+  if (!inplace_feasible) {
+    extend(handle, index, new_vectors, new_indices, n_rows);
+    return;
+  }
+
+  auto stream  = resource::get_cuda_stream(handle);
+  auto n_lists = index->n_lists();
+  auto dim     = index->dim();
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "ivf_flat::extend_inplace(%zu, %u)", size_t(n_rows), dim);
+  const bool normalize = index->metric() == raft::distance::DistanceType::CosineExpanded;
+
+  auto new_labels = raft::make_device_vector<LabelT, IdxT>(handle, n_rows);
+  raft::cluster::kmeans_balanced_params kmeans_params;
+  kmeans_params.metric  = utils::internal_metric(index->metric());
+  auto new_vectors_view = raft::make_device_matrix_view<const T, IdxT>(new_vectors, n_rows, dim);
+  auto orig_centroids_view =
+    raft::make_device_matrix_view<const float, IdxT>(index->centers().data_handle(), n_lists, dim);
+  raft::cluster::kmeans_balanced::predict(handle,
+                                          kmeans_params,
+                                          new_vectors_view,
+                                          orig_centroids_view,
+                                          new_labels.view(),
+                                          utils::mapping<float>{});
+
+  // Append the new vectors to the slack space of the lists; the pointers stay intact.
+  auto overflow_rows = raft::make_device_vector<IdxT, IdxT>(handle, n_rows);
+  rmm::device_scalar<uint32_t> n_overflow(0, stream);
+  auto* list_sizes_ptr = index->list_sizes().data_handle();
+  const dim3 block_dim(256);
+  const dim3 grid_dim(raft::ceildiv<IdxT>(n_rows, block_dim.x));
+  build_index_kernel<<<grid_dim, block_dim, 0, stream>>>(new_labels.data_handle(),
+                                                         new_vectors,
+                                                         new_indices,
+                                                         index->data_ptrs().data_handle(),
+                                                         index->inds_ptrs().data_handle(),
+                                                         list_sizes_ptr,
+                                                         n_rows,
+                                                         dim,
+                                                         index->veclen(),
+                                                         index->list_capacities().data_handle(),
+                                                         overflow_rows.data_handle(),
+                                                         n_overflow.data(),
+                                                         normalize);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+  raft::linalg::map(handle,
+                    raft::make_device_vector_view<uint32_t, uint32_t>(list_sizes_ptr, n_lists),
+                    raft::min_op{},
+                    raft::make_const_mdspan(index->list_sizes()),
+                    index->list_capacities());
+
+  // Only the rows not fitting into the preallocated lists go through the regular path.
+  const IdxT n_overflow_rows = n_overflow.value(stream);
+  index->increment_size(n_rows - n_overflow_rows);
+  if (n_overflow_rows == 0) { return; }
+  RAFT_LOG_DEBUG("ivf_flat::extend_inplace: %zu rows overflow the lists",
+                 size_t(n_overflow_rows));
+  auto overflow_vectors = raft::make_device_matrix<T, IdxT>(handle, n_overflow_rows, dim);
+  auto overflow_indices = raft::make_device_vector<IdxT, IdxT>(handle, n_overflow_rows);
+  raft::matrix::gather(new_vectors,
+                       IdxT(dim),
+                       n_rows,
+                       overflow_rows.data_handle(),
+                       n_overflow_rows,
+                       overflow_vectors.data_handle(),
+                       stream);
+  if (new_indices != nullptr) {
+    raft::matrix::gather(new_indices,
+                         IdxT(1),
+                         n_rows,
+                         overflow_rows.data_handle(),
+                         n_overflow_rows,
+                         overflow_indices.data_handle(),
+                         stream);
+  } else {
+    raft::copy(
+      overflow_indices.data_handle(), overflow_rows.data_handle(), n_overflow_rows, stream);
+  }
+  extend(handle,
+         index,
+         overflow_vectors.data_handle(),
+         overflow_indices.data_handle(),
+         n_overflow_rows);
+}
+
 /** See raft::neighbors::ivf_flat::extend docs */
 template <typename T, typename IdxT>
 auto extend(raft::resources const& handle,
@@ -295,6 +473,102 @@ auto extend(raft::resources const& handle,
   return ext_index;
 }
 
+/**
+ * @brief Copy the selected records of a list into a new list, preserving their order.
+ *
+ * CUDA launch grid:
+ *   X dimension must cover the output records (n_rows), YZ are not used.
+ *
+ * @param[out] out_data the interleaved data of the new list [capacity, dim]
+ * @param[out] out_inds the source indices of the new list [capacity]
+ * @param[in] in_data the interleaved data of the old list
+ * @param[in] in_inds the source indices of the old list
+ * @param[in] kept the positions of the selected records in the old list [n_rows]
+ * @param n_rows the number of selected records
+ * @param dim the dimensionality of the data
+ * @param veclen size of vectorized loads/stores; must satisfy `dim % veclen == 0`.
+ */
+template <typename T, typename IdxT>
+__global__ void compact_list_kernel(T* out_data,
+                                    IdxT* out_inds,
+                                    const T* in_data,
+                                    const IdxT* in_inds,
+                                    const uint32_t* kept,
+                                    uint32_t n_rows,
+                                    uint32_t dim,
+                                    uint32_t veclen)
+{
+  const uint32_t i = blockDim.x * blockIdx.x + threadIdx.x;
+  if (i >= n_rows) { return; }
+  const uint32_t src = kept[i];
+  out_inds[i]        = in_inds[src];
+
+  using interleaved_group = Pow2<kIndexGroupSize>;
+  out_data += interleaved_group::roundDown(i) * dim + interleaved_group::mod(i) * veclen;
+  in_data += interleaved_group::roundDown(src) * dim + interleaved_group::mod(src) * veclen;
+  for (uint32_t l = 0; l < dim; l += veclen) {
+    for (uint32_t j = 0; j < veclen; j++) {
+      out_data[l * kIndexGroupSize + j] = in_data[l * kIndexGroupSize + j];
+    }
+  }
+}
+
+/** See raft::neighbors::ivf_flat::helpers::remove docs */
+template <typename T, typename IdxT>
+auto remove(raft::resources const& handle,
+            raft::device_vector_view<const IdxT, IdxT> ids,
+            index<T, IdxT>* index) -> IdxT
+{
+  auto stream = resource::get_cuda_stream(handle);
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope("ivf_flat::remove(%zu)",
+                                                            size_t(ids.extent(0)));
+  list_spec<uint32_t, T, IdxT> list_device_spec{index->dim(),
+                                                index->conservative_memory_allocation()};
+  auto n_removed = ivf::detail::remove_records(
+    handle,
+    index->inds_ptrs().data_handle(),
+    index->list_sizes().data_handle(),
+    index->n_lists(),
+    ids,
+    [&](uint32_t label, const uint32_t* kept, uint32_t new_size) {
+      auto& list = index->lists()[label];
+      if (new_size == 0) { return list.reset(); }
+      // The compacted list is a new one, because the old one may be shared with a clone.
+      auto new_list = std::make_shared<list_data<T, IdxT>>(
+        handle, list_device_spec, new_size, index->list_arena());
+      const dim3 block_dim(256);
+      const dim3 grid_dim(raft::ceildiv<uint32_t>(new_size, block_dim.x));
+      compact_list_kernel<<<grid_dim, block_dim, 0, stream>>>(new_list->data.data_handle(),
+                                                              new_list->indices.data_handle(),
+                                                              list->data.data_handle(),
+                                                              list->indices.data_handle(),
+                                                              kept,
+                                                              new_size,
+                                                              index->dim(),
+                                                              index->veclen());
+      RAFT_CUDA_TRY(cudaPeekAtLastError());
+      list = std::move(new_list);
+    });
+  // Update the pointers and the sizes
+  index->recompute_internal_state(handle);
+  return static_cast<IdxT>(n_removed);
+}
+
+/** See raft::neighbors::ivf_flat::helpers::compact docs */
+template <typename T, typename IdxT>
+void compact(raft::resources const& handle, index<T, IdxT>* index)
+{
+  list_spec<uint32_t, T, IdxT> list_device_spec{index->dim(), true};
+  // The lists are moved into a new arena of the same chunk size, the old one is released with
+  // the last of the old lists.
+  auto& arena = index->list_arena();
+  if (arena) { arena = std::make_shared<ivf::list_arena>(arena->chunk_size()); }
+  auto n_freed = ivf::compact_lists(handle, index->lists(), list_device_spec, arena);
+  RAFT_LOG_DEBUG("ivf_flat::compact: freed the space of %zu records", n_freed);
+  // Update the pointers and the sizes
+  index->recompute_internal_state(handle);
+}
+
 /** See raft::neighbors::ivf_flat::build docs */
 template <typename T, typename IdxT>
 inline auto build(raft::resources const& handle,
@@ -306,9 +580,19 @@ inline auto build(raft::resources const& handle,
   auto stream = resource::get_cuda_stream(handle);
   common::nvtx::range<common::nvtx::domain::raft> fun_scope(
     "ivf_flat::build(%zu, %u)", size_t(n_rows), dim);
-  static_assert(std::is_same_v<T, float> || std::is_same_v<T, uint8_t> || std::is_same_v<T, int8_t>,
+  static_assert(std::is_same_v<T, float> || std::is_same_v<T, half> ||
+                  std::is_same_v<T, uint8_t> || std::is_same_v<T, int8_t>,
                 "unsupported data type");
   RAFT_EXPECTS(n_rows > 0 && dim > 0, "empty dataset");
+  const bool cosine = params.metric == raft::distance::DistanceType::CosineExpanded;
+  if (cosine) {
+    // The normalized vectors are stored in the lists, hence the type must represent them.
+    RAFT_EXPECTS((std::is_same_v<T, float> || std::is_same_v<T, half>),
+                 "The CosineExpanded metric requires the float or half data.");
+    // The centers must stay the (normalized) means of the normalized vectors.
+    RAFT_EXPECTS(!params.adaptive_centers,
+                 "The adaptive centers are not supported with the CosineExpanded metric.");
+  }
 
   index<T, IdxT> index(handle, params, dim);
   utils::memzero(index.list_sizes().data_handle(), index.list_sizes().size(), stream);
@@ -336,9 +620,26 @@ inline auto build(raft::resources const& handle,
       index.centers().data_handle(), index.n_lists(), index.dim());
     raft::cluster::kmeans_balanced_params kmeans_params;
     kmeans_params.n_iters = params.kmeans_n_iters;
-    kmeans_params.metric  = index.metric();
-    raft::cluster::kmeans_balanced::fit(
-      handle, kmeans_params, trainset_const_view, centers_view, utils::mapping<float>{});
+    kmeans_params.metric  = utils::internal_metric(index.metric());
+    if (cosine) {
+      // The cosine metric is the inner product of the normalized vectors
+      rmm::device_uvector<float> normalized_trainset(n_rows_train * index.dim(), stream);
+      linalg::unaryOp(normalized_trainset.data(),
+                      trainset.data(),
+                      normalized_trainset.size(),
+                      utils::mapping<float>{},
+                      stream);
+      utils::normalize_rows<IdxT>(
+        handle, normalized_trainset.data(), IdxT(n_rows_train), IdxT(index.dim()));
+      raft::cluster::kmeans_balanced::fit(handle,
+                                          kmeans_params,
+                                          raft::make_device_matrix_view<const float, IdxT>(
+                                            normalized_trainset.data(), n_rows_train, index.dim()),
+                                          centers_view);
+    } else {
+      raft::cluster::kmeans_balanced::fit(
+        handle, kmeans_params, trainset_const_view, centers_view, utils::mapping<float>{});
+    }
   }
 
   // add the data if necessary
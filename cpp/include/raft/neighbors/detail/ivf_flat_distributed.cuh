@@ -0,0 +1,505 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/cluster/kmeans_balanced.cuh>
+#include <raft/core/comms.hpp>
+#include <raft/core/error.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/resource/comms.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/linalg/norm.cuh>
+#include <raft/linalg/unary_op.cuh>
+#include <raft/matrix/detail/select_k.cuh>
+#include <raft/matrix/gather.cuh>
+#include <raft/neighbors/detail/ivf_adaptive_probes.cuh>
+#include <raft/neighbors/detail/ivf_flat_build.cuh>
+#include <raft/neighbors/detail/ivf_flat_search-inl.cuh>
+#include <raft/neighbors/ivf_flat_types.hpp>
+#include <raft/neighbors/ivf_list_types.hpp>
+#include <raft/neighbors/sample_filter_types.hpp>
+#include <raft/spatial/knn/detail/ann_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+#include <rmm/exec_policy.hpp>
+#include <rmm/mr/device/per_device_resource.hpp>
+
+#include <thrust/binary_search.h>
+#include <thrust/fill.h>
+#include <thrust/for_each.h>
+#include <thrust/gather.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
+#include <thrust/transform.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace raft::neighbors::ivf_flat::distributed::detail {
+
+using namespace raft::spatial::knn::detail;  // NOLINT
+
+/**
+ * The part of a distributed IVF-Flat index held by one rank: the coarse centers are replicated,
+ * the lists of the clusters `label % n_ranks == rank` are filled, the other lists stay empty.
+ * See raft::neighbors::ivf_flat::distributed::index for docs.
+ */
+template <typename T, typename IdxT>
+class index {
+ public:
+  index(ivf_flat::index<T, IdxT>&& local, int rank, int n_ranks)
+    : local_(std::move(local)), rank_(rank), n_ranks_(n_ranks)
+  {
+  }
+
+  /** The local index: the replicated centers and the lists owned by this rank. */
+  auto local() noexcept -> ivf_flat::index<T, IdxT>& { return local_; }
+  [[nodiscard]] auto local() const noexcept -> const ivf_flat::index<T, IdxT>& { return local_; }
+
+  [[nodiscard]] int rank() const noexcept { return rank_; }
+  [[nodiscard]] int n_ranks() const noexcept { return n_ranks_; }
+  /** The rank owning the list of the cluster `label`. */
+  [[nodiscard]] int owner(uint32_t label) const noexcept { return int(label % n_ranks_); }
+
+ private:
+  ivf_flat::index<T, IdxT> local_;
+  int rank_;
+  int n_ranks_;
+};
+
+struct list_owner_op {
+  int n_ranks;
+
+  __device__ int operator()(uint32_t label) const { return int(label % n_ranks); }
+};
+
+/**
+ * Every rank tells every other rank how many rows it sends to it.
+ *
+ * @return the number of rows received from every rank [n_ranks]
+ */
+inline auto exchange_counts(const comms_t& comm,
+                            const std::vector<size_t>& send_counts,
+                            cudaStream_t stream) -> std::vector<size_t>
+{
+  const int n_ranks = comm.get_size();
+  const int rank    = comm.get_rank();
+  rmm::device_uvector<size_t> all_counts_d(size_t(n_ranks) * n_ranks, stream);
+  raft::update_device(all_counts_d.data() + rank * n_ranks, send_counts.data(), n_ranks, stream);
+  comm.allgather(all_counts_d.data() + rank * n_ranks, all_counts_d.data(), n_ranks, stream);
+  std::vector<size_t> all_counts(all_counts_d.size());
+  raft::update_host(all_counts.data(), all_counts_d.data(), all_counts.size(), stream);
+  RAFT_EXPECTS(comm.sync_stream(stream) == status_t::SUCCESS, "exchange of the counts failed");
+  std::vector<size_t> recv_counts(n_ranks);
+  for (int r = 0; r < n_ranks; r++) {
+    recv_counts[r] = all_counts[r * n_ranks + rank];
+  }
+  return recv_counts;
+}
+
+/** Exclusive prefix sum of the counts [n_ranks + 1]. */
+inline auto counts_to_offsets(const std::vector<size_t>& counts) -> std::vector<size_t>
+{
+  std::vector<size_t> offsets(counts.size() + 1, 0);
+  for (size_t r = 0; r < counts.size(); r++) {
+    offsets[r + 1] = offsets[r] + counts[r];
+  }
+  return offsets;
+}
+
+/**
+ * Send the rows `[send_offsets[r], send_offsets[r + 1])` of `sendbuf` to every rank r and receive
+ * the rows of every rank r into `[recv_offsets[r], recv_offsets[r + 1])` of `recvbuf`; a row holds
+ * `width` values. The block of the rank itself is copied locally.
+ */
+template <typename value_t>
+void exchange_rows(const comms_t& comm,
+                   const value_t* sendbuf,
+                   const std::vector<size_t>& send_offsets,
+                   value_t* recvbuf,
+                   const std::vector<size_t>& recv_offsets,
+                   size_t width,
+                   cudaStream_t stream)
+{
+  const int n_ranks = comm.get_size();
+  const int rank    = comm.get_rank();
+  std::vector<size_t> send_sizes, send_displs, recv_sizes, recv_displs;
+  std::vector<int> dests, sources;
+  for (int r = 0; r < n_ranks; r++) {
+    size_t n_send = send_offsets[r + 1] - send_offsets[r];
+    size_t n_recv = recv_offsets[r + 1] - recv_offsets[r];
+    if (r == rank) {
+      raft::copy(recvbuf + recv_offsets[r] * width,
+                 sendbuf + send_offsets[r] * width,
+                 n_send * width,
+                 stream);
+      continue;
+    }
+    if (n_send > 0) {
+      send_sizes.push_back(n_send * width);
+      send_displs.push_back(send_offsets[r] * width);
+      dests.push_back(r);
+    }
+    if (n_recv > 0) {
+      recv_sizes.push_back(n_recv * width);
+      recv_displs.push_back(recv_offsets[r] * width);
+      sources.push_back(r);
+    }
+  }
+  comm.device_multicast_sendrecv(
+    sendbuf, send_sizes, send_displs, dests, recvbuf, recv_sizes, recv_displs, sources, stream);
+}
+
+/** See raft::neighbors::ivf_flat::distributed::extend docs */
+template <typename T, typename IdxT>
+void extend(raft::resources const& handle,
+            index<T, IdxT>* dindex,
+            const T* new_vectors,
+            const IdxT* new_indices,
+            IdxT n_rows)
+{
+  const auto& comm = resource::get_comms(handle);
+  auto stream      = resource::get_cuda_stream(handle);
+  auto& local      = dindex->local();
+  const auto dim   = local.dim();
+  const int n      = dindex->n_ranks();
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "ivf_flat::distributed::extend(%zu, %u)", size_t(n_rows), dim);
+  RAFT_EXPECTS(n_rows == 0 || new_indices != nullptr,
+               "The distributed index needs the global ids of the new vectors.");
+
+  // Send every vector, with its global id, to the rank owning its cluster
+  rmm::device_uvector<int> owners(n_rows, stream);
+  rmm::device_uvector<IdxT> order(n_rows, stream);
+  if (n_rows > 0) {
+    auto labels = raft::make_device_vector<uint32_t, IdxT>(handle, n_rows);
+    raft::cluster::kmeans_balanced_params kmeans_params;
+    kmeans_params.metric = local.metric();
+    raft::cluster::kmeans_balanced::predict(
+      handle,
+      kmeans_params,
+      raft::make_device_matrix_view<const T, IdxT>(new_vectors, n_rows, dim),
+      raft::make_device_matrix_view<const float, IdxT>(
+        local.centers().data_handle(), local.n_lists(), dim),
+      labels.view(),
+      utils::mapping<float>{});
+    thrust::transform(rmm::exec_policy(stream),
+                      labels.data_handle(),
+                      labels.data_handle() + n_rows,
+                      owners.data(),
+                      list_owner_op{n});
+    thrust::sequence(rmm::exec_policy(stream), order.data(), order.data() + n_rows);
+    thrust::stable_sort_by_key(
+      rmm::exec_policy(stream), owners.data(), owners.data() + n_rows, order.data());
+  }
+  rmm::device_uvector<IdxT> send_offsets_d(n + 1, stream);
+  thrust::lower_bound(rmm::exec_policy(stream),
+                      owners.data(),
+                      owners.data() + n_rows,
+                      thrust::make_counting_iterator<int>(0),
+                      thrust::make_counting_iterator<int>(n + 1),
+                      send_offsets_d.data());
+  std::vector<IdxT> send_bounds(n + 1);
+  raft::update_host(send_bounds.data(), send_offsets_d.data(), n + 1, stream);
+  resource::sync_stream(handle);
+  std::vector<size_t> send_counts(n);
+  for (int r = 0; r < n; r++) {
+    send_counts[r] = size_t(send_bounds[r + 1] - send_bounds[r]);
+  }
+
+  rmm::device_uvector<T> send_vectors(size_t(n_rows) * dim, stream);
+  rmm::device_uvector<IdxT> send_indices(n_rows, stream);
+  if (n_rows > 0) {
+    raft::matrix::gather(
+      new_vectors, IdxT(dim), n_rows, order.data(), n_rows, send_vectors.data(), stream);
+    thrust::gather(rmm::exec_policy(stream),
+                   order.data(),
+                   order.data() + n_rows,
+                   new_indices,
+                   send_indices.data());
+  }
+
+  auto recv_counts  = exchange_counts(comm, send_counts, stream);
+  auto send_offsets = counts_to_offsets(send_counts);
+  auto recv_offsets = counts_to_offsets(recv_counts);
+  size_t n_recv     = recv_offsets.back();
+  rmm::device_uvector<T> recv_vectors(n_recv * dim, stream);
+  rmm::device_uvector<IdxT> recv_indices(n_recv, stream);
+  exchange_rows(
+    comm, send_vectors.data(), send_offsets, recv_vectors.data(), recv_offsets, dim, stream);
+  exchange_rows(
+    comm, send_indices.data(), send_offsets, recv_indices.data(), recv_offsets, 1, stream);
+
+  if (n_recv > 0) {
+    raft::neighbors::ivf_flat::detail::extend<T, IdxT>(
+      handle, &local, recv_vectors.data(), recv_indices.data(), IdxT(n_recv));
+  }
+}
+
+/** See raft::neighbors::ivf_flat::distributed::build docs */
+template <typename T, typename IdxT>
+auto build(raft::resources const& handle,
+           const index_params& params,
+           const T* dataset,
+           IdxT n_rows,
+           uint32_t dim) -> index<T, IdxT>
+{
+  const auto& comm = resource::get_comms(handle);
+  auto stream      = resource::get_cuda_stream(handle);
+  const int rank   = comm.get_rank();
+  const int n      = comm.get_size();
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "ivf_flat::distributed::build(%zu, %u)", size_t(n_rows), dim);
+  // the ranks route the queries by their own copy of the centers, which must stay the same
+  RAFT_EXPECTS(!params.adaptive_centers,
+               "The centers of a distributed index are replicated and cannot be adaptive.");
+  RAFT_EXPECTS(params.metric != raft::distance::DistanceType::CosineExpanded,
+               "The CosineExpanded metric is not supported by the distributed index.");
+
+  // The global ids: the local vectors follow those of the lower ranks
+  std::vector<size_t> own_count(n, size_t(n_rows));
+  auto all_counts = exchange_counts(comm, own_count, stream);
+  IdxT id_offset  = 0;
+  for (int r = 0; r < rank; r++) {
+    id_offset += IdxT(all_counts[r]);
+  }
+
+  // The first rank trains the centers on its part of the dataset and shares them
+  auto train_params              = params;
+  train_params.add_data_on_build = false;
+  auto local = rank == 0 ? raft::neighbors::ivf_flat::detail::build<T, IdxT>(
+                             handle, train_params, dataset, n_rows, dim)
+                         : ivf_flat::index<T, IdxT>(handle, params, dim);
+  if (rank != 0) {
+    utils::memzero(local.list_sizes().data_handle(), local.list_sizes().size(), stream);
+    utils::memzero(local.data_ptrs().data_handle(), local.data_ptrs().size(), stream);
+    utils::memzero(local.inds_ptrs().data_handle(), local.inds_ptrs().size(), stream);
+  }
+  comm.bcast(local.centers().data_handle(), local.centers().size(), 0, stream);
+
+  // The center norms are needed by the coarse search, even on the ranks which own no vectors
+  local.allocate_center_norms(handle);
+  if (local.center_norms().has_value()) {
+    raft::linalg::rowNorm(local.center_norms()->data_handle(),
+                          local.centers().data_handle(),
+                          dim,
+                          local.n_lists(),
+                          raft::linalg::L2Norm,
+                          true,
+                          stream);
+  }
+
+  index<T, IdxT> dindex(std::move(local), rank, n);
+  rmm::device_uvector<IdxT> ids(n_rows, stream);
+  thrust::sequence(rmm::exec_policy(stream), ids.data(), ids.data() + n_rows, id_offset);
+  extend<T, IdxT>(handle, &dindex, dataset, ids.data(), n_rows);
+  return dindex;
+}
+
+/** See raft::neighbors::ivf_flat::distributed::search docs */
+template <typename T, typename IdxT>
+void search(raft::resources const& handle,
+            const search_params& params,
+            const index<T, IdxT>& dindex,
+            const T* queries,
+            uint32_t n_queries,
+            uint32_t k,
+            IdxT* neighbors,
+            float* distances,
+            rmm::mr::device_memory_resource* mr = nullptr)
+{
+  const auto& comm  = resource::get_comms(handle);
+  auto stream       = resource::get_cuda_stream(handle);
+  const auto& local = dindex.local();
+  const uint32_t d  = local.dim();
+  const int n       = dindex.n_ranks();
+  const int rank    = dindex.rank();
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "ivf_flat::distributed::search(k = %u, n_queries = %u, dim = %u)", k, n_queries, d);
+  RAFT_EXPECTS(params.n_probes > 0,
+               "n_probes (number of clusters to probe in the search) must be positive.");
+  // the candidate budget would need the sizes of the lists of all the ranks
+  RAFT_EXPECTS(params.max_candidates == 0,
+               "The candidate budget is not supported by the distributed search.");
+  if (mr == nullptr) { mr = rmm::mr::get_current_device_resource(); }
+  const auto n_probes   = std::min<uint32_t>(params.n_probes, local.n_lists());
+  const bool select_min = raft::distance::is_min_close(local.metric());
+
+  // The coarse search runs on the replicated centers
+  rmm::device_uvector<float> converted_queries(size_t(n_queries) * d, stream, mr);
+  rmm::device_uvector<uint32_t> coarse_indices(size_t(n_queries) * n_probes, stream, mr);
+  std::vector<uint32_t> coarse_host(size_t(n_queries) * n_probes);
+  if (n_queries > 0) {
+    linalg::unaryOp(
+      converted_queries.data(), queries, size_t(n_queries) * d, utils::mapping<float>{}, stream);
+    raft::neighbors::ivf_flat::detail::select_clusters(handle,
+                                                       local,
+                                                       converted_queries.data(),
+                                                       n_queries,
+                                                       n_probes,
+                                                       params.max_candidates,
+                                                       params.probe_distance_ratio,
+                                                       select_min,
+                                                       coarse_indices.data(),
+                                                       mr);
+    raft::copy(coarse_host.data(), coarse_indices.data(), coarse_host.size(), stream);
+    resource::sync_stream(handle);
+  }
+
+  // Every query goes to the ranks owning its probed lists, with the probes of those lists only
+  std::vector<std::vector<uint32_t>> dest_queries(n);
+  for (uint32_t q = 0; q < n_queries; q++) {
+    std::vector<bool> sent(n, false);
+    for (uint32_t p = 0; p < n_probes; p++) {
+      auto label = coarse_host[size_t(q) * n_probes + p];
+      if (label == ivf::detail::kSkippedProbe || sent[dindex.owner(label)]) { continue; }
+      sent[dindex.owner(label)] = true;
+      dest_queries[dindex.owner(label)].push_back(q);
+    }
+  }
+  std::vector<size_t> send_counts(n);
+  for (int r = 0; r < n; r++) {
+    send_counts[r] = dest_queries[r].size();
+  }
+  auto send_offsets = counts_to_offsets(send_counts);
+  size_t n_send     = send_offsets.back();
+  std::vector<uint32_t> send_map(n_send);
+  std::vector<int> send_dest(n_send);
+  std::vector<uint32_t> send_coarse_host(n_send * n_probes);
+  for (int r = 0; r < n; r++) {
+    for (size_t i = 0; i < dest_queries[r].size(); i++) {
+      size_t row     = send_offsets[r] + i;
+      uint32_t q     = dest_queries[r][i];
+      send_map[row]  = q;
+      send_dest[row] = r;
+      for (uint32_t p = 0; p < n_probes; p++) {
+        auto label = coarse_host[size_t(q) * n_probes + p];
+        send_coarse_host[row * n_probes + p] =
+          label != ivf::detail::kSkippedProbe && dindex.owner(label) == r
+            ? label
+            : ivf::detail::kSkippedProbe;
+      }
+    }
+  }
+  rmm::device_uvector<uint32_t> send_map_d(n_send, stream, mr);
+  rmm::device_uvector<int> send_dest_d(n_send, stream, mr);
+  rmm::device_uvector<uint32_t> send_coarse(n_send * n_probes, stream, mr);
+  rmm::device_uvector<T> send_queries(n_send * d, stream, mr);
+  raft::copy(send_map_d.data(), send_map.data(), n_send, stream);
+  raft::copy(send_dest_d.data(), send_dest.data(), n_send, stream);
+  raft::copy(send_coarse.data(), send_coarse_host.data(), send_coarse_host.size(), stream);
+  if (n_send > 0) {
+    raft::matrix::gather(
+      queries, d, n_queries, send_map_d.data(), uint32_t(n_send), send_queries.data(), stream);
+  }
+
+  auto recv_counts  = exchange_counts(comm, send_counts, stream);
+  auto recv_offsets = counts_to_offsets(recv_counts);
+  size_t n_recv     = recv_offsets.back();
+  rmm::device_uvector<T> recv_queries(n_recv * d, stream, mr);
+  rmm::device_uvector<uint32_t> recv_coarse(n_recv * n_probes, stream, mr);
+  exchange_rows(
+    comm, send_queries.data(), send_offsets, recv_queries.data(), recv_offsets, d, stream);
+  exchange_rows(
+    comm, send_coarse.data(), send_offsets, recv_coarse.data(), recv_offsets, n_probes, stream);
+
+  // Scan the owned lists for the received queries
+  rmm::device_uvector<float> recv_distances(n_recv * k, stream, mr);
+  rmm::device_uvector<IdxT> recv_neighbors(n_recv * k, stream, mr);
+  {
+    constexpr uint32_t kMaxQueries = 16384;
+    const size_t max_queries       = std::min<size_t>(n_recv, kMaxQueries);
+    rmm::device_uvector<float> converted(max_queries * d, stream, mr);
+    for (size_t offset_q = 0; offset_q < n_recv; offset_q += max_queries) {
+      auto queries_batch = uint32_t(std::min(max_queries, n_recv - offset_q));
+      const T* batch     = recv_queries.data() + offset_q * d;
+      linalg::unaryOp(
+        converted.data(), batch, size_t(queries_batch) * d, utils::mapping<float>{}, stream);
+      raft::neighbors::ivf_flat::detail::scan_lists<T, float, IdxT>(
+        handle,
+        local,
+        batch,
+        converted.data(),
+        recv_coarse.data() + offset_q * n_probes,
+        queries_batch,
+        uint32_t(offset_q),
+        k,
+        n_probes,
+        select_min,
+        recv_neighbors.data() + offset_q * k,
+        recv_distances.data() + offset_q * k,
+        mr,
+        raft::neighbors::filtering::none_ivf_sample_filter());
+    }
+  }
+
+  // Return the partial results to the ranks of the queries
+  rmm::device_uvector<float> back_distances(n_send * k, stream, mr);
+  rmm::device_uvector<IdxT> back_neighbors(n_send * k, stream, mr);
+  exchange_rows(
+    comm, recv_distances.data(), recv_offsets, back_distances.data(), send_offsets, k, stream);
+  exchange_rows(
+    comm, recv_neighbors.data(), recv_offsets, back_neighbors.data(), send_offsets, k, stream);
+
+  // Merge the partial results: [n_queries, n_ranks * k], the ranks not asked left as dummies
+  if (n_queries == 0) { return; }
+  const size_t row_len = size_t(n) * k;
+  rmm::device_uvector<float> merged_distances(n_queries * row_len, stream, mr);
+  rmm::device_uvector<IdxT> merged_neighbors(n_queries * row_len, stream, mr);
+  thrust::fill(rmm::exec_policy(stream),
+               merged_distances.begin(),
+               merged_distances.end(),
+               select_min ? upper_bound<float>() : lower_bound<float>());
+  thrust::fill(rmm::exec_policy(stream),
+               merged_neighbors.begin(),
+               merged_neighbors.end(),
+               ivf::kInvalidRecord<IdxT>);
+  auto* merged_d_ptr     = merged_distances.data();
+  auto* merged_n_ptr     = merged_neighbors.data();
+  const auto* back_d_ptr = back_distances.data();
+  const auto* back_n_ptr = back_neighbors.data();
+  const auto* map_ptr    = send_map_d.data();
+  const auto* dest_ptr   = send_dest_d.data();
+  thrust::for_each(rmm::exec_policy(stream),
+                   thrust::make_counting_iterator<size_t>(0),
+                   thrust::make_counting_iterator<size_t>(n_send * k),
+                   [=] __device__(size_t i) {
+                     size_t row        = i / k;
+                     size_t j          = i % k;
+                     size_t out        = map_ptr[row] * row_len + dest_ptr[row] * k + j;
+                     merged_d_ptr[out] = back_d_ptr[i];
+                     merged_n_ptr[out] = back_n_ptr[i];
+                   });
+  matrix::detail::select_k<float, IdxT>(merged_distances.data(),
+                                        merged_neighbors.data(),
+                                        n_queries,
+                                        row_len,
+                                        k,
+                                        distances,
+                                        neighbors,
+                                        select_min,
+                                        stream,
+                                        mr);
+}
+
+}  // namespace raft::neighbors::ivf_flat::distributed::detail
@@ -0,0 +1,467 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/error.hpp>
+#include <raft/core/host_mdarray.hpp>
+#include <raft/core/logger.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/linalg/map.cuh>
+#include <raft/linalg/unary_op.cuh>
+#include <raft/matrix/detail/select_k.cuh>
+#include <raft/neighbors/detail/ivf_adaptive_probes.cuh>
+#include <raft/neighbors/detail/ivf_flat_search-inl.cuh>
+#include <raft/neighbors/ivf_flat_types.hpp>
+#include <raft/neighbors/ivf_list_types.hpp>
+#include <raft/spatial/knn/detail/ann_utils.cuh>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+#include <raft/util/integer_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+#include <rmm/mr/device/per_device_resource.hpp>
+
+#include <omp.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace raft::neighbors::ivf_flat::detail {
+
+/**
+ * The inverted lists of an IVF-Flat index split between the device and the host memory.
+ *
+ * The most frequently probed lists stay on the device; the rest ("cold" lists) are moved to the
+ * host memory, keeping the interleaved layout, and scanned by the CPU. The search scans both sides
+ * at the same time (the host scan overlaps with the device scan) and merges the results.
+ */
+template <typename T, typename IdxT>
+class host_lists {
+ public:
+  /**
+   * Move the cold lists of the index to the host memory. These lists are released on the device,
+   * so the index can only be searched together with this object afterwards.
+   *
+   * @param[in] res
+   * @param[in] params the list placement parameters
+   * @param[inout] index
+   * @param[in] probe_counts how often the lists are probed (e.g. see `profile_probes`) [n_lists]
+   */
+  host_lists(raft::resources const& res,
+             const hybrid_params& params,
+             index<T, IdxT>& index,
+             raft::host_vector_view<const uint64_t, uint32_t> probe_counts)
+    : n_lists_(index.n_lists()),
+      dim_(index.dim()),
+      veclen_(index.veclen()),
+      n_threads_(params.n_threads),
+      sizes_(index.n_lists()),
+      host_flags_(index.n_lists(), 0),
+      host_data_(index.n_lists()),
+      host_inds_(index.n_lists()),
+      on_host_(make_device_vector<uint8_t, uint32_t>(res, index.n_lists()))
+  {
+    RAFT_EXPECTS(probe_counts.extent(0) == n_lists_,
+                 "The number of the probe counts must be equal to the number of lists");
+    auto stream = resource::get_cuda_stream(res);
+    raft::copy(sizes_.data(), index.list_sizes().data_handle(), n_lists_, stream);
+    resource::sync_stream(res);
+
+    // Keep the most frequently probed lists on the device while they fit into the budget
+    std::vector<uint32_t> order(n_lists_);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&probe_counts](uint32_t a, uint32_t b) {
+      return probe_counts(a) > probe_counts(b);
+    });
+    size_t device_bytes = 0;
+    for (auto label : order) {
+      auto& list = index.lists()[label];
+      if (!list) { continue; }
+      const size_t list_bytes = list->data.size() * sizeof(T) + list->indices.size() * sizeof(IdxT);
+      if (device_bytes + list_bytes <= params.device_memory_limit) {
+        device_bytes += list_bytes;
+        continue;
+      }
+      // NB: only the used part of the list is copied (rounded up to the interleaved groups)
+      const size_t n_rows = raft::round_up_safe<size_t>(sizes_[label], kIndexGroupSize);
+      host_data_[label].resize(n_rows * dim_);
+      host_inds_[label].resize(sizes_[label]);
+      raft::copy(host_data_[label].data(), list->data.data_handle(), n_rows * dim_, stream);
+      raft::copy(host_inds_[label].data(), list->indices.data_handle(), sizes_[label], stream);
+      host_flags_[label] = 1;
+      n_host_lists_++;
+    }
+    raft::copy(on_host_.data_handle(), host_flags_.data(), n_lists_, stream);
+    resource::sync_stream(res);
+    for (uint32_t label = 0; label < n_lists_; label++) {
+      if (host_flags_[label]) { index.lists()[label].reset(); }
+    }
+    index.recompute_internal_state(res);
+    RAFT_LOG_DEBUG("ivf_flat::host_lists: %u of %u lists moved to the host (%zu bytes kept)",
+                   n_host_lists_,
+                   n_lists_,
+                   device_bytes);
+  }
+
+  /** The number of lists kept in the host memory. */
+  [[nodiscard]] auto n_host_lists() const noexcept -> uint32_t { return n_host_lists_; }
+
+  /** Whether the lists are kept in the host memory (non-zero) or on the device [n_lists]. */
+  [[nodiscard]] auto on_host() const noexcept -> device_vector_view<const uint8_t, uint32_t>
+  {
+    return on_host_.view();
+  }
+
+  /**
+   * Scan the host lists probed by the queries (on the CPU).
+   *
+   * @param[in] queries the queries converted to float [n_queries, dim] (host memory)
+   * @param[in] coarse_indices the probed lists [n_queries, n_probes] (host memory)
+   * @param n_queries
+   * @param n_probes
+   * @param k
+   * @param metric
+   * @param select_min
+   * @param[out] distances [n_queries, k] (host memory); padded with the dummy values
+   * @param[out] neighbors [n_queries, k] (host memory); padded with `ivf::kInvalidRecord`
+   */
+  void scan(const float* queries,
+            const uint32_t* coarse_indices,
+            uint32_t n_queries,
+            uint32_t n_probes,
+            uint32_t k,
+            raft::distance::DistanceType metric,
+            bool select_min,
+            float* distances,
+            IdxT* neighbors) const
+  {
+    if (metric == raft::distance::DistanceType::InnerProduct) {
+      scan_impl<true>(
+        queries, coarse_indices, n_queries, n_probes, k, false, select_min, distances, neighbors);
+    } else {
+      const bool take_sqrt = metric == raft::distance::DistanceType::L2SqrtExpanded ||
+                             metric == raft::distance::DistanceType::L2SqrtUnexpanded;
+      scan_impl<false>(queries,
+                       coarse_indices,
+                       n_queries,
+                       n_probes,
+                       k,
+                       take_sqrt,
+                       select_min,
+                       distances,
+                       neighbors);
+    }
+  }
+
+ private:
+  uint32_t n_lists_;
+  uint32_t dim_;
+  uint32_t veclen_;
+  uint32_t n_threads_;
+  uint32_t n_host_lists_ = 0;
+  std::vector<uint32_t> sizes_;
+  std::vector<uint8_t> host_flags_;
+  std::vector<std::vector<T>> host_data_;
+  std::vector<std::vector<IdxT>> host_inds_;
+  device_vector<uint8_t, uint32_t> on_host_;
+
+  template <bool kInnerProduct>
+  void scan_impl(const float* queries,
+                 const uint32_t* coarse_indices,
+                 uint32_t n_queries,
+                 uint32_t n_probes,
+                 uint32_t k,
+                 bool take_sqrt,
+                 bool select_min,
+                 float* distances,
+                 IdxT* neighbors) const
+  {
+    const float dummy_dist = select_min ? upper_bound<float>() : lower_bound<float>();
+    const int n_threads    = n_threads_ > 0 ? int(n_threads_) : omp_get_max_threads();
+#pragma omp parallel for num_threads(n_threads) schedule(dynamic)
+    for (int64_t query_ix = 0; query_ix < int64_t(n_queries); query_ix++) {
+      const float* query = queries + size_t(dim_) * query_ix;
+      std::vector<std::pair<float, IdxT>> candidates;
+      float acc[kIndexGroupSize];
+      for (uint32_t probe_ix = 0; probe_ix < n_probes; probe_ix++) {
+        const auto label = coarse_indices[size_t(n_probes) * query_ix + probe_ix];
+        if (label == ivf::detail::kSkippedProbe || !host_flags_[label]) { continue; }
+        const T* list_data    = host_data_[label].data();
+        const IdxT* list_inds = host_inds_[label].data();
+        const uint32_t size   = sizes_[label];
+        // Process an interleaved group of `kIndexGroupSize` records at a time: in this layout,
+        // the innermost loop runs over contiguous memory and is vectorized by the compiler.
+        for (uint32_t group = 0; group * kIndexGroupSize < size; group++) {
+          std::fill(acc, acc + kIndexGroupSize, 0.0f);
+          const T* group_data = list_data + size_t(group) * kIndexGroupSize * dim_;
+          for (uint32_t l = 0; l < dim_; l += veclen_) {
+            const T* block = group_data + size_t(l) * kIndexGroupSize;
+            for (uint32_t r = 0; r < kIndexGroupSize; r++) {
+              for (uint32_t j = 0; j < veclen_; j++) {
+                const float x = utils::mapping<float>{}(block[r * veclen_ + j]);
+                if constexpr (kInnerProduct) {
+                  acc[r] += x * query[l + j];
+                } else {
+                  const float d = x - query[l + j];
+                  acc[r] += d * d;
+                }
+              }
+            }
+          }
+          const uint32_t n_valid = std::min(kIndexGroupSize, size - group * kIndexGroupSize);
+          for (uint32_t r = 0; r < n_valid; r++) {
+            candidates.emplace_back(take_sqrt ? std::sqrt(acc[r]) : acc[r],
+                                    list_inds[group * kIndexGroupSize + r]);
+          }
+        }
+      }
+      const size_t n_best = std::min<size_t>(k, candidates.size());
+      auto cmp            = [select_min](const auto& a, const auto& b) {
+        return select_min ? a.first < b.first : a.first > b.first;
+      };
+      std::partial_sort(candidates.begin(), candidates.begin() + n_best, candidates.end(), cmp);
+      for (size_t i = 0; i < k; i++) {
+        distances[size_t(k) * query_ix + i] = i < n_best ? candidates[i].first : dummy_dist;
+        neighbors[size_t(k) * query_ix + i] =
+          i < n_best ? candidates[i].second : ivf::kInvalidRecord<IdxT>;
+      }
+    }
+  }
+};
+
+/** See raft::neighbors::ivf_flat::profile_probes docs */
+template <typename T, typename IdxT>
+auto profile_probes(raft::resources const& handle,
+                    const search_params& params,
+                    const index<T, IdxT>& index,
+                    const T* queries,
+                    uint32_t n_queries) -> raft::host_vector<uint64_t, uint32_t>
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "ivf_flat::profile_probes(n_queries = %u)", n_queries);
+  auto stream   = resource::get_cuda_stream(handle);
+  auto mr       = resource::get_workspace_resource(handle);
+  auto n_probes = std::min<uint32_t>(params.n_probes, index.n_lists());
+  auto counts   = raft::make_host_vector<uint64_t, uint32_t>(index.n_lists());
+  std::fill(counts.data_handle(), counts.data_handle() + index.n_lists(), 0);
+
+  constexpr uint32_t kMaxQueries = 65536;
+  const uint32_t max_queries     = std::min(n_queries, kMaxQueries);
+  rmm::device_uvector<float> converted_queries(size_t(max_queries) * index.dim(), stream, mr);
+  rmm::device_uvector<uint32_t> coarse_indices(size_t(max_queries) * n_probes, stream, mr);
+  std::vector<uint32_t> coarse_indices_host(size_t(max_queries) * n_probes);
+  for (uint32_t offset_q = 0; offset_q < n_queries; offset_q += max_queries) {
+    uint32_t queries_batch = std::min(max_queries, n_queries - offset_q);
+    linalg::unaryOp(converted_queries.data(),
+                    queries + size_t(offset_q) * index.dim(),
+                    size_t(queries_batch) * index.dim(),
+                    utils::mapping<float>{},
+                    stream);
+    select_clusters(handle,
+                    index,
+                    converted_queries.data(),
+                    queries_batch,
+                    n_probes,
+                    params.max_candidates,
+                    params.probe_distance_ratio,
+                    raft::distance::is_min_close(index.metric()),
+                    coarse_indices.data(),
+                    mr);
+    raft::copy(coarse_indices_host.data(),
+               coarse_indices.data(),
+               size_t(queries_batch) * n_probes,
+               stream);
+    resource::sync_stream(handle);
+    for (size_t i = 0; i < size_t(queries_batch) * n_probes; i++) {
+      auto label = coarse_indices_host[i];
+      if (label != ivf::detail::kSkippedProbe) { counts(label)++; }
+    }
+  }
+  return counts;
+}
+
+/** See raft::neighbors::ivf_flat::search (host_lists) docs */
+template <typename T, typename IdxT>
+void search(raft::resources const& handle,
+            const search_params& params,
+            const index<T, IdxT>& index,
+            const host_lists<T, IdxT>& lists,
+            const T* queries,
+            uint32_t n_queries,
+            uint32_t k,
+            IdxT* neighbors,
+            float* distances,
+            rmm::mr::device_memory_resource* mr = nullptr)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "ivf_flat::search(host_lists, k = %u, n_queries = %u, dim = %zu)", k, n_queries, index.dim());
+  RAFT_EXPECTS(params.n_probes > 0,
+               "n_probes (number of clusters to probe in the search) must be positive.");
+  // the host scan would need the normalized queries and the conversion of the distances
+  RAFT_EXPECTS(index.metric() != raft::distance::DistanceType::CosineExpanded,
+               "The CosineExpanded metric is not supported by the host lists search.");
+  if (mr == nullptr) { mr = rmm::mr::get_current_device_resource(); }
+  auto stream           = resource::get_cuda_stream(handle);
+  auto n_probes         = std::min<uint32_t>(params.n_probes, index.n_lists());
+  const bool select_min = raft::distance::is_min_close(index.metric());
+  const uint32_t dim    = index.dim();
+
+  constexpr uint32_t kMaxQueries = 16384;
+  const uint32_t max_queries     = std::min(n_queries, kMaxQueries);
+  rmm::device_uvector<float> converted_queries(size_t(max_queries) * dim, stream, mr);
+  rmm::device_uvector<uint32_t> coarse_indices(size_t(max_queries) * n_probes, stream, mr);
+  // The device (first k columns) and the host (last k columns) results [max_queries, 2 * k]
+  rmm::device_uvector<float> merged_distances(size_t(max_queries) * 2 * k, stream, mr);
+  rmm::device_uvector<IdxT> merged_neighbors(size_t(max_queries) * 2 * k, stream, mr);
+  rmm::device_uvector<float> device_distances(size_t(max_queries) * k, stream, mr);
+  rmm::device_uvector<IdxT> device_neighbors(size_t(max_queries) * k, stream, mr);
+  std::vector<float> queries_host(size_t(max_queries) * dim);
+  std::vector<uint32_t> coarse_indices_host(size_t(max_queries) * n_probes);
+  std::vector<float> host_distances(size_t(max_queries) * k);
+  std::vector<IdxT> host_neighbors(size_t(max_queries) * k);
+  const uint8_t* on_host = lists.on_host().data_handle();
+
+  for (uint32_t offset_q = 0; offset_q < n_queries; offset_q += max_queries) {
+    uint32_t queries_batch = std::min(max_queries, n_queries - offset_q);
+    const T* batch_queries = queries + size_t(offset_q) * dim;
+    linalg::unaryOp(converted_queries.data(),
+                    batch_queries,
+                    size_t(queries_batch) * dim,
+                    utils::mapping<float>{},
+                    stream);
+    select_clusters(handle,
+                    index,
+                    converted_queries.data(),
+                    queries_batch,
+                    n_probes,
+                    params.max_candidates,
+                    params.probe_distance_ratio,
+                    select_min,
+                    coarse_indices.data(),
+                    mr);
+    raft::copy(
+      queries_host.data(), converted_queries.data(), size_t(queries_batch) * dim, stream);
+    raft::copy(coarse_indices_host.data(),
+               coarse_indices.data(),
+               size_t(queries_batch) * n_probes,
+               stream);
+    resource::sync_stream(handle);
+
+    // Device side: skip the host lists and scan the rest asynchronously
+    auto coarse_view = make_device_vector_view<uint32_t, size_t>(coarse_indices.data(),
+                                                                 size_t(queries_batch) * n_probes);
+    linalg::map(
+      handle,
+      coarse_view,
+      [on_host] __device__(uint32_t label) {
+        return label == ivf::detail::kSkippedProbe || on_host[label] != 0
+                 ? ivf::detail::kSkippedProbe
+                 : label;
+      },
+      make_const_mdspan(coarse_view));
+    scan_lists<T, float, IdxT>(handle,
+                               index,
+                               batch_queries,
+                               converted_queries.data(),
+                               coarse_indices.data(),
+                               queries_batch,
+                               offset_q,
+                               k,
+                               n_probes,
+                               select_min,
+                               device_neighbors.data(),
+                               device_distances.data(),
+                               mr,
+                               raft::neighbors::filtering::none_ivf_sample_filter());
+
+    // Host side: scan the host lists meanwhile
+    lists.scan(queries_host.data(),
+               coarse_indices_host.data(),
+               queries_batch,
+               n_probes,
+               k,
+               index.metric(),
+               select_min,
+               host_distances.data(),
+               host_neighbors.data());
+
+    // Merge the results of both sides
+    RAFT_CUDA_TRY(cudaMemcpy2DAsync(merged_distances.data(),
+                                    sizeof(float) * 2 * k,
+                                    device_distances.data(),
+                                    sizeof(float) * k,
+                                    sizeof(float) * k,
+                                    queries_batch,
+                                    cudaMemcpyDefault,
+                                    stream));
+    RAFT_CUDA_TRY(cudaMemcpy2DAsync(merged_distances.data() + k,
+                                    sizeof(float) * 2 * k,
+                                    host_distances.data(),
+                                    sizeof(float) * k,
+                                    sizeof(float) * k,
+                                    queries_batch,
+                                    cudaMemcpyDefault,
+                                    stream));
+    RAFT_CUDA_TRY(cudaMemcpy2DAsync(merged_neighbors.data(),
+                                    sizeof(IdxT) * 2 * k,
+                                    device_neighbors.data(),
+                                    sizeof(IdxT) * k,
+                                    sizeof(IdxT) * k,
+                                    queries_batch,
+                                    cudaMemcpyDefault,
+                                    stream));
+    RAFT_CUDA_TRY(cudaMemcpy2DAsync(merged_neighbors.data() + k,
+                                    sizeof(IdxT) * 2 * k,
+                                    host_neighbors.data(),
+                                    sizeof(IdxT) * k,
+                                    sizeof(IdxT) * k,
+                                    queries_batch,
+                                    cudaMemcpyDefault,
+                                    stream));
+    matrix::detail::select_k<float, IdxT>(merged_distances.data(),
+                                          merged_neighbors.data(),
+                                          queries_batch,
+                                          2 * k,
+                                          k,
+                                          distances + size_t(offset_q) * k,
+                                          neighbors + size_t(offset_q) * k,
+                                          select_min,
+                                          stream,
+                                          mr);
+    // The host buffers are reused by the next batch
+    resource::sync_stream(handle);
+  }
+}
+
+}  // namespace raft::neighbors::ivf_flat::detail
+
+namespace raft::neighbors::ivf_flat {
+
+/** The lists of an IVF-Flat index split between the device and the host memory. */
+template <typename T, typename IdxT>
+using host_lists = detail::host_lists<T, IdxT>;
+
+}  // namespace raft::neighbors::ivf_flat
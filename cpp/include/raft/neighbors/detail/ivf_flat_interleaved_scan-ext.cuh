@@ -16,17 +16,23 @@
 
 #pragma once
 
-#include <cstdint>                                 // uintX_t
-#include <raft/neighbors/ivf_flat_types.hpp>       // raft::neighbors::ivf_flat::index
-#include <raft/neighbors/sample_filter_types.hpp>  // none_ivf_sample_filter
-#include <raft/util/raft_explicit.hpp>             // RAFT_EXPLICIT
-#include <rmm/cuda_stream_view.hpp>                // rmm:cuda_stream_view
+#include <cstdint>                                    // uintX_t
+#include <cuda_fp16.h>                                // half
+#include <raft/neighbors/detail/ivf_static_dims.hpp>  // ivf::detail::ann_static_dims
+#include <raft/neighbors/ivf_flat_types.hpp>          // raft::neighbors::ivf_flat::index
+#include <raft/neighbors/sample_filter_types.hpp>     // none_ivf_sample_filter
+#include <raft/util/raft_explicit.hpp>                // RAFT_EXPLICIT
+#include <rmm/cuda_stream_view.hpp>                   // rmm:cuda_stream_view
 
 #ifdef RAFT_EXPLICIT_INSTANTIATE_ONLY
 
 namespace raft::neighbors::ivf_flat::detail {
 
-template <typename T, typename AccT, typename IdxT, typename IvfSampleFilterT>
+template <typename T,
+          typename AccT,
+          typename IdxT,
+          typename IvfSampleFilterT,
+          typename StaticDims = ivf::detail::ann_static_dims>
 void ivfflat_interleaved_scan(const raft::neighbors::ivf_flat::index<T, IdxT>& index,
                               const T* queries,
                               const uint32_t* coarse_query_results,
@@ -42,6 +48,21 @@ void ivfflat_interleaved_scan(const raft::neighbors::ivf_flat::index<T, IdxT>& i
                               uint32_t& grid_dim_x,
                               rmm::cuda_stream_view stream) RAFT_EXPLICIT;
 
+template <typename T, typename AccT, typename IdxT>
+void ivfflat_interleaved_range_scan(const raft::neighbors::ivf_flat::index<T, IdxT>& index,
+                                    const T* queries,
+                                    const uint32_t* coarse_query_results,
+                                    const uint32_t n_queries,
+                                    const raft::distance::DistanceType metric,
+                                    const uint32_t n_probes,
+                                    const float radius,
+                                    const bool select_min,
+                                    const bool count_only,
+                                    int64_t* row_counters,
+                                    IdxT* out_indices,
+                                    float* out_distances,
+                                    rmm::cuda_stream_view stream) RAFT_EXPLICIT;
+
 }  // namespace raft::neighbors::ivf_flat::detail
 
 #endif  // RAFT_EXPLICIT_INSTANTIATE_ONLY
@@ -71,5 +92,33 @@ instantiate_raft_neighbors_ivf_flat_detail_ivfflat_interleaved_scan(
   int8_t, int32_t, int64_t, raft::neighbors::filtering::none_ivf_sample_filter);
 instantiate_raft_neighbors_ivf_flat_detail_ivfflat_interleaved_scan(
   uint8_t, uint32_t, int64_t, raft::neighbors::filtering::none_ivf_sample_filter);
+instantiate_raft_neighbors_ivf_flat_detail_ivfflat_interleaved_scan(
+  half, float, int64_t, raft::neighbors::filtering::none_ivf_sample_filter);
 
 #undef instantiate_raft_neighbors_ivf_flat_detail_ivfflat_interleaved_scan
+
+#define instantiate_raft_neighbors_ivf_flat_detail_ivfflat_interleaved_range_scan(T, AccT, IdxT) \
+  extern template void                                                                           \
+  raft::neighbors::ivf_flat::detail::ivfflat_interleaved_range_scan<T, AccT, IdxT>(              \
+    const raft::neighbors::ivf_flat::index<T, IdxT>& index,                                      \
+    const T* queries,                                                                            \
+    const uint32_t* coarse_query_results,                                                        \
+    const uint32_t n_queries,                                                                    \
+    const raft::distance::DistanceType metric,                                                   \
+    const uint32_t n_probes,                                                                     \
+    const float radius,                                                                          \
+    const bool select_min,                                                                       \
+    const bool count_only,                                                                       \
+    int64_t* row_counters,                                                                       \
+    IdxT* out_indices,                                                                           \
+    float* out_distances,                                                                        \
+    rmm::cuda_stream_view stream)
+
+instantiate_raft_neighbors_ivf_flat_detail_ivfflat_interleaved_range_scan(float, float, int64_t);
+instantiate_raft_neighbors_ivf_flat_detail_ivfflat_interleaved_range_scan(int8_t, int32_t, int64_t);
+instantiate_raft_neighbors_ivf_flat_detail_ivfflat_interleaved_range_scan(uint8_t,
+                                                                          uint32_t,
+                                                                          int64_t);
+instantiate_raft_neighbors_ivf_flat_detail_ivfflat_interleaved_range_scan(half, float, int64_t);
+
+#undef instantiate_raft_neighbors_ivf_flat_detail_ivfflat_interleaved_range_scan
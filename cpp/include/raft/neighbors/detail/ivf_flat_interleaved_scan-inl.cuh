@@ -20,66 +20,27 @@
 #include <raft/core/operators.hpp>
 #include <raft/distance/distance_types.hpp>
 #include <raft/matrix/detail/select_warpsort.cuh>
+#include <raft/neighbors/detail/ivf_adaptive_probes.cuh>
+#include <raft/neighbors/detail/ivf_static_dims.hpp>
 #include <raft/neighbors/ivf_flat_types.hpp>
 #include <raft/spatial/knn/detail/ann_utils.cuh>
 #include <raft/util/cuda_rt_essentials.hpp>  // RAFT_CUDA_TRY
+#include <raft/util/device_atomics.cuh>
 #include <raft/util/device_loads_stores.cuh>
 #include <raft/util/integer_utils.hpp>
 #include <raft/util/pow2_utils.cuh>
 #include <raft/util/vectorized.cuh>
 #include <rmm/cuda_stream_view.hpp>
 
+#include <cuda_fp16.h>
+
 namespace raft::neighbors::ivf_flat::detail {
 
 using namespace raft::spatial::knn::detail;  // NOLINT
 
 constexpr int kThreadsPerBlock = 128;
-
-/**
- * @brief Copy `n` elements per block from one place to another.
- *
- * @param[out] out target pointer (unique per block)
- * @param[in] in source pointer
- * @param n number of elements to copy
- */
-template <int VecBytes = 16, typename T>
-__device__ inline void copy_vectorized(T* out, const T* in, uint32_t n)
-{
-  constexpr int VecElems = VecBytes / sizeof(T);  // NOLINT
-  using align_bytes      = Pow2<(size_t)VecBytes>;
-  if constexpr (VecElems > 1) {
-    using align_elems = Pow2<VecElems>;
-    if (!align_bytes::areSameAlignOffsets(out, in)) {
-      return copy_vectorized<(VecBytes >> 1), T>(out, in, n);
-    }
-    {  // process unaligned head
-      uint32_t head = align_bytes::roundUp(in) - in;
-      if (head > 0) {
-        copy_vectorized<sizeof(T), T>(out, in, head);
-        n -= head;
-        in += head;
-        out += head;
-      }
-    }
-    {  // process main part vectorized
-      using vec_t = typename IOType<T, VecElems>::Type;
-      copy_vectorized<sizeof(vec_t), vec_t>(
-        reinterpret_cast<vec_t*>(out), reinterpret_cast<const vec_t*>(in), align_elems::div(n));
-    }
-    {  // process unaligned tail
-      uint32_t tail = align_elems::mod(n);
-      if (tail > 0) {
-        n -= tail;
-        copy_vectorized<sizeof(T), T>(out + n, in + n, tail);
-      }
-    }
-  }
-  if constexpr (VecElems <= 1) {
-    for (int i = threadIdx.x; i < n; i += blockDim.x) {
-      out[i] = in[i];
-    }
-  }
-}
+/** The maximum size, in bytes, of the part of the query kept in shared memory. */
+constexpr int kMaxQuerySmem = 16384;
 
 /**
  * @brief Load a part of a vector from the index and from query, compute the (part of the) distance
@@ -626,6 +587,153 @@ struct loadAndComputeDist<kUnroll, Lambda, 1, int8_t, int32_t> {
   }
 };
 
+// This handles half 2, 4, 8 Veclens: the data is loaded as 32bit words, each holding two halves,
+// and the distance is accumulated in fp32.
+template <int kUnroll, typename Lambda, int half_veclen>
+struct loadAndComputeDist<kUnroll, Lambda, half_veclen, half, float> {
+  Lambda compute_dist;
+  float& dist;
+
+  __device__ __forceinline__ loadAndComputeDist(float& dist, Lambda op)
+    : dist(dist), compute_dist(op)
+  {
+  }
+
+  __device__ __forceinline__ void compute_dist_half2(uint32_t x, uint32_t y)
+  {
+    const float2 xf = __half22float2(*reinterpret_cast<const __half2*>(&x));
+    const float2 yf = __half22float2(*reinterpret_cast<const __half2*>(&y));
+    compute_dist(dist, xf.x, yf.x);
+    compute_dist(dist, xf.y, yf.y);
+  }
+
+  __device__ __forceinline__ void runLoadShmemCompute(const half* const& data,
+                                                      const half* query_shared,
+                                                      int loadIndex,
+                                                      int shmemIndex)
+  {
+    constexpr int veclen_int = half_veclen / 2;  // converting half veclens to int
+    loadIndex                = loadIndex * veclen_int;
+#pragma unroll
+    for (int j = 0; j < kUnroll; ++j) {
+      uint32_t encV[veclen_int];
+      ldg(encV,
+          reinterpret_cast<unsigned const*>(data) + loadIndex + j * kIndexGroupSize * veclen_int);
+      uint32_t queryRegs[veclen_int];
+      lds(queryRegs, reinterpret_cast<unsigned const*>(query_shared + shmemIndex) + j * veclen_int);
+#pragma unroll
+      for (int k = 0; k < veclen_int; k++) {
+        compute_dist_half2(queryRegs[k], encV[k]);
+      }
+    }
+  }
+
+  __device__ __forceinline__ void runLoadShflAndCompute(const half*& data,
+                                                        const half* query,
+                                                        int baseLoadIndex,
+                                                        const int lane_id)
+  {
+    constexpr int veclen_int = half_veclen / 2;  // converting half veclens to int
+    uint32_t queryReg =
+      (lane_id < WarpSize / 2) ? reinterpret_cast<unsigned const*>(query + baseLoadIndex)[lane_id]
+                               : 0;
+    constexpr int stride = kUnroll * half_veclen;
+
+#pragma unroll
+    for (int i = 0; i < WarpSize / stride; ++i, data += stride * kIndexGroupSize) {
+#pragma unroll
+      for (int j = 0; j < kUnroll; ++j) {
+        uint32_t encV[veclen_int];
+        ldg(encV,
+            reinterpret_cast<unsigned const*>(data) + (lane_id + j * kIndexGroupSize) * veclen_int);
+        const int d = (i * kUnroll + j) * veclen_int;
+#pragma unroll
+        for (int k = 0; k < veclen_int; ++k) {
+          compute_dist_half2(shfl(queryReg, d + k, WarpSize), encV[k]);
+        }
+      }
+    }
+  }
+
+  __device__ __forceinline__ void runLoadShflAndComputeRemainder(const half*& data,
+                                                                 const half* query,
+                                                                 const int lane_id,
+                                                                 const int dim,
+                                                                 const int dimBlocks)
+  {
+    constexpr int veclen_int = half_veclen / 2;
+    const int loadDim        = dimBlocks + lane_id * 2;  // Here 2 is for 1 - int
+    uint32_t queryReg = loadDim < dim ? reinterpret_cast<uint32_t const*>(query + loadDim)[0] : 0;
+    for (int d = 0; d < dim - dimBlocks; d += half_veclen, data += kIndexGroupSize * half_veclen) {
+      uint32_t enc[veclen_int];
+      ldg(enc, reinterpret_cast<uint32_t const*>(data) + lane_id * veclen_int);
+#pragma unroll
+      for (int k = 0; k < veclen_int; k++) {
+        uint32_t q = shfl(queryReg, (d / 2) + k, WarpSize);
+        compute_dist_half2(q, enc[k]);
+      }
+    }
+  }
+};
+
+template <int kUnroll, typename Lambda>
+struct loadAndComputeDist<kUnroll, Lambda, 1, half, float> {
+  Lambda compute_dist;
+  float& dist;
+
+  __device__ __forceinline__ loadAndComputeDist(float& dist, Lambda op)
+    : dist(dist), compute_dist(op)
+  {
+  }
+
+  __device__ __forceinline__ void runLoadShmemCompute(const half* const& data,
+                                                      const half* query_shared,
+                                                      int loadIndex,
+                                                      int shmemIndex)
+  {
+#pragma unroll
+    for (int j = 0; j < kUnroll; ++j) {
+      float encV      = __half2float(data[loadIndex + j * kIndexGroupSize]);
+      float queryRegs = __half2float(query_shared[shmemIndex + j]);
+      compute_dist(dist, queryRegs, encV);
+    }
+  }
+
+  __device__ __forceinline__ void runLoadShflAndCompute(const half*& data,
+                                                        const half* query,
+                                                        int baseLoadIndex,
+                                                        const int lane_id)
+  {
+    float queryReg       = __half2float(query[baseLoadIndex + lane_id]);
+    constexpr int veclen = 1;
+    constexpr int stride = kUnroll * veclen;
+
+#pragma unroll
+    for (int i = 0; i < WarpSize / stride; ++i, data += stride * kIndexGroupSize) {
+#pragma unroll
+      for (int j = 0; j < kUnroll; ++j) {
+        float encV = __half2float(data[lane_id + j * kIndexGroupSize]);
+        float q    = shfl(queryReg, i * kUnroll + j, WarpSize);
+        compute_dist(dist, q, encV);
+      }
+    }
+  }
+
+  __device__ __forceinline__ void runLoadShflAndComputeRemainder(const half*& data,
+                                                                 const half* query,
+                                                                 const int lane_id,
+                                                                 const int dim,
+                                                                 const int dimBlocks)
+  {
+    constexpr int veclen = 1;
+    const int loadDim    = dimBlocks + lane_id;
+    float queryReg       = loadDim < dim ? __half2float(query[loadDim]) : 0.0f;
+    for (int d = 0; d < dim - dimBlocks; d += veclen, data += kIndexGroupSize * veclen) {
+      compute_dist(dist, shfl(queryReg, d, WarpSize), __half2float(data[lane_id]));
+    }
+  }
+};
+
 /**
  * Scan clusters for nearest neighbors of the query vectors.
  * See `ivfflat_interleaved_scan` for more information.
@@ -638,20 +746,25 @@ struct loadAndComputeDist<kUnroll, Lambda, 1, int8_t, int32_t> {
  * @param query_smem_elems number of dimensions of the query vector to fit in a shared memory of a
  * block; this number must be a multiple of `WarpSize * Veclen`.
  * @param[in] query a pointer to all queries in a row-major contiguous format [gridDim.y, dim]
- * @param[in] coarse_index a pointer to the cluster indices to search through [n_probes]
+ * @param[in] coarse_index a pointer to the cluster indices to search through [n_probes];
+ *   the search stops at the first probe marked as `ivf::detail::kSkippedProbe`.
  * @param[in] list_indices index<T, IdxT>.indices
  * @param[in] list_data index<T, IdxT>.data
  * @param[in] list_sizes index<T, IdxT>.list_sizes
  * @param[in] list_offsets index<T, IdxT>.list_offsets
  * @param n_probes
  * @param k
- * @param dim
+ * @param runtime_dim the dimensionality of the data; ignored when `StaticDim > 0`
  * @param sample_filter
  * @param[out] neighbors
  * @param[out] distances
+ *
+ * @tparam StaticDim the dimensionality of the data when known at compile time, or zero
+ *   (see `ivf::detail::ann_static_dims`).
  */
 template <int Capacity,
           int Veclen,
+          uint32_t StaticDim,
           bool Ascending,
           typename T,
           typename AccT,
@@ -671,11 +784,16 @@ __global__ void __launch_bounds__(kThreadsPerBlock)
                           const uint32_t queries_offset,
                           const uint32_t n_probes,
                           const uint32_t k,
-                          const uint32_t dim,
+                          const uint32_t runtime_dim,
                           IvfSampleFilterT sample_filter,
                           IdxT* neighbors,
                           float* distances)
 {
+  // With the dimensionality known at compile time, the loops over the dimensions are unrolled,
+  // and the query is known to fit in shared memory as a whole whenever it can.
+  constexpr bool kQueryFitsSmem = StaticDim > 0 && StaticDim * sizeof(T) <= size_t(kMaxQuerySmem);
+  const uint32_t dim            = StaticDim > 0 ? StaticDim : runtime_dim;
+  const bool dim_beyond_smem    = !kQueryFitsSmem && dim > query_smem_elems;
   extern __shared__ __align__(256) uint8_t interleaved_scan_kernel_smem[];
   // Using shared memory for the (part of the) query;
   // This allows to save on global memory bandwidth when reading index and query
@@ -710,12 +828,13 @@ __global__ void __launch_bounds__(kThreadsPerBlock)
     // How many full warps needed to compute the distance (without remainder)
     const uint32_t full_warps_along_dim = align_warp::roundDown(dim);
 
-    const uint32_t shm_assisted_dim =
-      (dim > query_smem_elems) ? query_smem_elems : full_warps_along_dim;
+    const uint32_t shm_assisted_dim = dim_beyond_smem ? query_smem_elems : full_warps_along_dim;
 
     // Every CUDA block scans one cluster at a time.
     for (int probe_id = blockIdx.x; probe_id < n_probes; probe_id += gridDim.x) {
       const uint32_t list_id = coarse_index[probe_id];  // The id of cluster(list)
+      // The probes dropped by the adaptive probing are always at the end.
+      if (list_id == ivf::detail::kSkippedProbe) { break; }
 
       // The number of vectors in each cluster(list); [nlist]
       const uint32_t list_length = list_sizes[list_id];
@@ -743,13 +862,14 @@ __global__ void __launch_bounds__(kThreadsPerBlock)
         if (valid && sample_filter(queries_offset + blockIdx.y, probe_id, vec_id)) {
           loadAndComputeDist<kUnroll, decltype(compute_dist), Veclen, T, AccT> lc(dist,
                                                                                   compute_dist);
+#pragma unroll
           for (int pos = 0; pos < shm_assisted_dim;
                pos += WarpSize, data += kIndexGroupSize * WarpSize) {
             lc.runLoadShmemCompute(data, query_shared, lane_id, pos);
           }
         }
 
-        if (dim > query_smem_elems) {
+        if (dim_beyond_smem) {
           // The default path - using shfl ops - for dimensions beyond query_smem_elems
           loadAndComputeDist<kUnroll, decltype(compute_dist), Veclen, T, AccT> lc(dist,
                                                                                   compute_dist);
@@ -761,6 +881,7 @@ __global__ void __launch_bounds__(kThreadsPerBlock)
           // when  shm_assisted_dim == full_warps_along_dim < dim
           if (valid) {
             loadAndComputeDist<1, decltype(compute_dist), Veclen, T, AccT> lc(dist, compute_dist);
+#pragma unroll
             for (int pos = full_warps_along_dim; pos < dim;
                  pos += Veclen, data += kIndexGroupSize * Veclen) {
               lc.runLoadShmemCompute(data, query_shared, lane_id, pos);
@@ -803,6 +924,7 @@ uint32_t configure_launch_x(uint32_t numQueries, uint32_t n_probes, int32_t sMem
 
 template <int Capacity,
           int Veclen,
+          uint32_t StaticDim,
           bool Ascending,
           typename T,
           typename AccT,
@@ -827,8 +949,9 @@ void launch_kernel(Lambda lambda,
 {
   RAFT_EXPECTS(Veclen == index.veclen(),
                "Configured Veclen does not match the index interleaving pattern.");
-  constexpr auto kKernel   = interleaved_scan_kernel<Capacity,
+  constexpr auto kKernel = interleaved_scan_kernel<Capacity,
                                                    Veclen,
+                                                   StaticDim,
                                                    Ascending,
                                                    T,
                                                    AccT,
@@ -836,9 +959,8 @@ void launch_kernel(Lambda lambda,
                                                    IvfSampleFilterT,
                                                    Lambda,
                                                    PostLambda>;
-  const int max_query_smem = 16384;
   int query_smem_elems =
-    std::min<int>(max_query_smem / sizeof(T), Pow2<Veclen * WarpSize>::roundUp(index.dim()));
+    std::min<int>(kMaxQuerySmem / sizeof(T), Pow2<Veclen * WarpSize>::roundUp(index.dim()));
   int smem_size              = query_smem_elems * sizeof(T);
   constexpr int kSubwarpSize = std::min<int>(Capacity, WarpSize);
   auto block_merge_mem =
@@ -943,6 +1065,7 @@ struct inner_prod_dist {
 /** Select the distance computation function and forward the rest of the arguments. */
 template <int Capacity,
           int Veclen,
+          uint32_t StaticDim,
           bool Ascending,
           typename T,
           typename AccT,
@@ -956,6 +1079,7 @@ void launch_with_fixed_consts(raft::distance::DistanceType metric, Args&&... arg
     case raft::distance::DistanceType::L2Unexpanded:
       return launch_kernel<Capacity,
                            Veclen,
+                           StaticDim,
                            Ascending,
                            T,
                            AccT,
@@ -967,6 +1091,7 @@ void launch_with_fixed_consts(raft::distance::DistanceType metric, Args&&... arg
     case raft::distance::DistanceType::L2SqrtUnexpanded:
       return launch_kernel<Capacity,
                            Veclen,
+                           StaticDim,
                            Ascending,
                            T,
                            AccT,
@@ -977,6 +1102,7 @@ void launch_with_fixed_consts(raft::distance::DistanceType metric, Args&&... arg
     case raft::distance::DistanceType::InnerProduct:
       return launch_kernel<Capacity,
                            Veclen,
+                           StaticDim,
                            Ascending,
                            T,
                            AccT,
@@ -992,13 +1118,16 @@ void launch_with_fixed_consts(raft::distance::DistanceType metric, Args&&... arg
 /**
  * Lift the `capacity` and `veclen` parameters to the template level,
  * forward the rest of the arguments unmodified to `launch_interleaved_scan_kernel`.
+ *
+ * `StaticDim` is the dimensionality of the data when it is known at compile time, or zero.
  */
 template <typename T,
           typename AccT,
           typename IdxT,
           typename IvfSampleFilterT,
-          int Capacity = matrix::detail::select::warpsort::kMaxCapacity,
-          int Veclen   = std::max<int>(1, 16 / sizeof(T))>
+          uint32_t StaticDim = 0,
+          int Capacity       = matrix::detail::select::warpsort::kMaxCapacity,
+          int Veclen         = std::max<int>(1, 16 / sizeof(T))>
 struct select_interleaved_scan_kernel {
   /**
    * Recursively reduce the `Capacity` and `Veclen` parameters until they match the
@@ -1015,6 +1144,7 @@ struct select_interleaved_scan_kernel {
                                               AccT,
                                               IdxT,
                                               IvfSampleFilterT,
+                                              StaticDim,
                                               Capacity / 2,
                                               Veclen>::run(capacity,
                                                            veclen,
@@ -1024,8 +1154,16 @@ struct select_interleaved_scan_kernel {
     }
     if constexpr (Veclen > 1) {
       if (veclen % Veclen != 0) {
-        return select_interleaved_scan_kernel<T, AccT, IdxT, IvfSampleFilterT, Capacity, 1>::run(
-          capacity, 1, select_min, std::forward<Args>(args)...);
+        return select_interleaved_scan_kernel<T,
+                                              AccT,
+                                              IdxT,
+                                              IvfSampleFilterT,
+                                              StaticDim,
+                                              Capacity,
+                                              1>::run(capacity,
+                                                      1,
+                                                      select_min,
+                                                      std::forward<Args>(args)...);
       }
     }
     // NB: this is the limitation of the warpsort structures that use a huge number of
@@ -1038,10 +1176,10 @@ struct select_interleaved_scan_kernel {
       veclen == Veclen,
       "Veclen must be power-of-two not bigger than the maximum allowed size for this data type.");
     if (select_min) {
-      launch_with_fixed_consts<Capacity, Veclen, true, T, AccT, IdxT, IvfSampleFilterT>(
+      launch_with_fixed_consts<Capacity, Veclen, StaticDim, true, T, AccT, IdxT, IvfSampleFilterT>(
         std::forward<Args>(args)...);
     } else {
-      launch_with_fixed_consts<Capacity, Veclen, false, T, AccT, IdxT, IvfSampleFilterT>(
+      launch_with_fixed_consts<Capacity, Veclen, StaticDim, false, T, AccT, IdxT, IvfSampleFilterT>(
         std::forward<Args>(args)...);
     }
   }
@@ -1053,6 +1191,7 @@ struct select_interleaved_scan_kernel {
  * @tparam T value type
  * @tparam AccT accumulated type
  * @tparam IdxT type of the indices
+ * @tparam StaticDims the dimensions to specialize the kernel for (see `ivf::detail::static_dims_t`)
  *
  * @param index previously built ivf-flat index
  * @param[in] queries device pointer to the query vectors [batch_size, dim]
@@ -1078,7 +1217,11 @@ struct select_interleaved_scan_kernel {
  *   A filter that selects samples for a given query. Use an instance of none_ivf_sample_filter to
  *   provide a green light for every sample.
  */
-template <typename T, typename AccT, typename IdxT, typename IvfSampleFilterT>
+template <typename T,
+          typename AccT,
+          typename IdxT,
+          typename IvfSampleFilterT,
+          typename StaticDims = ivf::detail::ann_static_dims>
 void ivfflat_interleaved_scan(const index<T, IdxT>& index,
                               const T* queries,
                               const uint32_t* coarse_query_results,
@@ -1095,22 +1238,315 @@ void ivfflat_interleaved_scan(const index<T, IdxT>& index,
                               rmm::cuda_stream_view stream)
 {
   const int capacity = bound_by_power_of_two(k);
-  select_interleaved_scan_kernel<T, AccT, IdxT, IvfSampleFilterT>::run(capacity,
-                                                                       index.veclen(),
-                                                                       select_min,
-                                                                       metric,
-                                                                       index,
-                                                                       queries,
-                                                                       coarse_query_results,
-                                                                       n_queries,
-                                                                       queries_offset,
-                                                                       n_probes,
-                                                                       k,
-                                                                       sample_filter,
-                                                                       neighbors,
-                                                                       distances,
-                                                                       grid_dim_x,
-                                                                       stream);
+  ivf::detail::dispatch_static_dim(StaticDims{}, index.dim(), [&](auto static_dim) {
+    select_interleaved_scan_kernel<T, AccT, IdxT, IvfSampleFilterT, decltype(static_dim)::value>::
+      run(capacity,
+          index.veclen(),
+          select_min,
+          metric,
+          index,
+          queries,
+          coarse_query_results,
+          n_queries,
+          queries_offset,
+          n_probes,
+          k,
+          sample_filter,
+          neighbors,
+          distances,
+          grid_dim_x,
+          stream);
+  });
+}
+
+/**
+ * Scan clusters for the neighbors within a radius of the query vectors (range search).
+ * See `ivfflat_interleaved_range_scan` for more information.
+ *
+ * The distances are computed the same way as in `interleaved_scan_kernel`, but instead of being
+ * selected, the neighbors within the radius are counted or written out. The kernel is run twice:
+ *   - `CountOnly`: the numbers of the neighbors are added to `row_counters` [gridDim.y];
+ *   - otherwise, `row_counters` are the write positions of the queries in the CSR output, and
+ *     every warp reserves the space for its neighbors with a single atomic.
+ *
+ * Every CUDA block scans one cluster: the block (x, y) scans the probe x of the query y.
+ */
+template <bool CountOnly,
+          int Veclen,
+          typename T,
+          typename AccT,
+          typename IdxT,
+          typename Lambda,
+          typename PostLambda>
+__global__ void __launch_bounds__(kThreadsPerBlock)
+  interleaved_range_scan_kernel(Lambda compute_dist,
+                                PostLambda post_process,
+                                const uint32_t query_smem_elems,
+                                const T* query,
+                                const uint32_t* coarse_index,
+                                const IdxT* const* list_indices_ptrs,
+                                const T* const* list_data_ptrs,
+                                const uint32_t* list_sizes,
+                                const uint32_t n_probes,
+                                const uint32_t dim,
+                                const float radius,
+                                const bool select_min,
+                                int64_t* row_counters,
+                                IdxT* out_indices,
+                                float* out_distances)
+{
+  extern __shared__ __align__(256) uint8_t interleaved_range_scan_kernel_smem[];
+  const uint32_t query_id = blockIdx.y;
+  const uint32_t list_id  = coarse_index[size_t(query_id) * n_probes + blockIdx.x];
+  // The probes dropped by the adaptive probing are skipped by the whole block.
+  if (list_id == ivf::detail::kSkippedProbe) { return; }
+
+  query += size_t(query_id) * dim;
+  T* query_shared = reinterpret_cast<T*>(interleaved_range_scan_kernel_smem);
+  copy_vectorized(query_shared, query, std::min(dim, query_smem_elems));
+  __syncthreads();
+
+  using align_warp  = Pow2<WarpSize>;
+  const int lane_id = align_warp::mod(threadIdx.x);
+
+  const bool dim_beyond_smem          = dim > query_smem_elems;
+  const uint32_t full_warps_along_dim = align_warp::roundDown(dim);
+  const uint32_t shm_assisted_dim = dim_beyond_smem ? query_smem_elems : full_warps_along_dim;
+
+  const uint32_t list_length = list_sizes[list_id];
+  const uint32_t num_groups  = align_warp::div(list_length + align_warp::Mask);
+
+  constexpr int kUnroll        = WarpSize / Veclen;
+  constexpr uint32_t kNumWarps = kThreadsPerBlock / WarpSize;
+  for (uint32_t group_id = align_warp::div(threadIdx.x); group_id < num_groups;
+       group_id += kNumWarps) {
+    AccT dist     = 0;
+    const T* data = list_data_ptrs[list_id] + (group_id * kIndexGroupSize) * dim;
+
+    const uint32_t vec_id = group_id * WarpSize + lane_id;
+    const bool valid      = vec_id < list_length;
+
+    if (valid) {
+      loadAndComputeDist<kUnroll, decltype(compute_dist), Veclen, T, AccT> lc(dist, compute_dist);
+      for (int pos = 0; pos < shm_assisted_dim;
+           pos += WarpSize, data += kIndexGroupSize * WarpSize) {
+        lc.runLoadShmemCompute(data, query_shared, lane_id, pos);
+      }
+    }
+
+    if (dim_beyond_smem) {
+      // All lanes take part in the shuffles, including the ones past the end of the list.
+      loadAndComputeDist<kUnroll, decltype(compute_dist), Veclen, T, AccT> lc(dist, compute_dist);
+      for (int pos = shm_assisted_dim; pos < full_warps_along_dim; pos += WarpSize) {
+        lc.runLoadShflAndCompute(data, query, pos, lane_id);
+      }
+      lc.runLoadShflAndComputeRemainder(data, query, lane_id, dim, full_warps_along_dim);
+    } else if (valid) {
+      loadAndComputeDist<1, decltype(compute_dist), Veclen, T, AccT> lc(dist, compute_dist);
+      for (int pos = full_warps_along_dim; pos < dim;
+           pos += Veclen, data += kIndexGroupSize * Veclen) {
+        lc.runLoadShmemCompute(data, query_shared, lane_id, pos);
+      }
+    }
+
+    const float val     = post_process(static_cast<float>(dist));
+    const bool in_range = valid && (select_min ? val <= radius : val >= radius);
+    // the mask is the same for all lanes of the warp
+    const uint32_t mask = raft::ballot(in_range);
+    if (mask == 0) { continue; }
+    const auto n_in_range = static_cast<int64_t>(__popc(mask));
+    if constexpr (CountOnly) {
+      if (lane_id == 0) { atomicAdd(row_counters + query_id, n_in_range); }
+    } else {
+      int64_t out_pos = 0;
+      if (lane_id == 0) { out_pos = atomicAdd(row_counters + query_id, n_in_range); }
+      out_pos = shfl(out_pos, 0);
+      if (in_range) {
+        out_pos += __popc(mask & ((1u << lane_id) - 1u));
+        out_indices[out_pos]   = list_indices_ptrs[list_id][vec_id];
+        out_distances[out_pos] = val;
+      }
+    }
+  }
+}
+
+template <bool CountOnly,
+          int Veclen,
+          typename T,
+          typename AccT,
+          typename IdxT,
+          typename Lambda,
+          typename PostLambda>
+void launch_range_kernel(Lambda lambda,
+                         PostLambda post_process,
+                         const index<T, IdxT>& index,
+                         const T* queries,
+                         const uint32_t* coarse_index,
+                         const uint32_t num_queries,
+                         const uint32_t n_probes,
+                         const float radius,
+                         const bool select_min,
+                         int64_t* row_counters,
+                         IdxT* out_indices,
+                         float* out_distances,
+                         rmm::cuda_stream_view stream)
+{
+  RAFT_EXPECTS(Veclen == index.veclen(),
+               "Configured Veclen does not match the index interleaving pattern.");
+  constexpr auto kKernel =
+    interleaved_range_scan_kernel<CountOnly, Veclen, T, AccT, IdxT, Lambda, PostLambda>;
+  const int query_smem_elems =
+    std::min<int>(kMaxQuerySmem / sizeof(T), Pow2<Veclen * WarpSize>::roundUp(index.dim()));
+  const int smem_size = query_smem_elems * sizeof(T);
+
+  // power-of-two less than cuda limit (for better addr alignment)
+  constexpr uint32_t kMaxGridY = 32768;
+
+  for (uint32_t query_offset = 0; query_offset < num_queries; query_offset += kMaxGridY) {
+    uint32_t grid_dim_y = std::min<uint32_t>(kMaxGridY, num_queries - query_offset);
+    dim3 grid_dim(n_probes, grid_dim_y, 1);
+    dim3 block_dim(kThreadsPerBlock);
+    RAFT_LOG_TRACE(
+      "Launching the ivf-flat interleaved_range_scan_kernel (%d, %d, 1) x (%d, 1, 1), "
+      "count_only = %d, smem_size = %d",
+      grid_dim.x,
+      grid_dim.y,
+      block_dim.x,
+      int(CountOnly),
+      smem_size);
+    kKernel<<<grid_dim, block_dim, smem_size, stream>>>(lambda,
+                                                        post_process,
+                                                        query_smem_elems,
+                                                        queries,
+                                                        coarse_index,
+                                                        index.inds_ptrs().data_handle(),
+                                                        index.data_ptrs().data_handle(),
+                                                        index.list_sizes().data_handle(),
+                                                        n_probes,
+                                                        index.dim(),
+                                                        radius,
+                                                        select_min,
+                                                        row_counters,
+                                                        out_indices,
+                                                        out_distances);
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+    queries += grid_dim_y * index.dim();
+    coarse_index += grid_dim_y * n_probes;
+    row_counters += grid_dim_y;
+  }
+}
+
+/** Select the distance computation function of the range scan and forward the arguments. */
+template <bool CountOnly, int Veclen, typename T, typename AccT, typename IdxT, typename... Args>
+void launch_range_with_fixed_consts(raft::distance::DistanceType metric, Args&&... args)
+{
+  switch (metric) {
+    case raft::distance::DistanceType::L2Expanded:
+    case raft::distance::DistanceType::L2Unexpanded:
+      return launch_range_kernel<CountOnly,
+                                 Veclen,
+                                 T,
+                                 AccT,
+                                 IdxT,
+                                 euclidean_dist<Veclen, T, AccT>,
+                                 raft::identity_op>({}, {}, std::forward<Args>(args)...);
+    case raft::distance::DistanceType::L2SqrtExpanded:
+    case raft::distance::DistanceType::L2SqrtUnexpanded:
+      return launch_range_kernel<CountOnly,
+                                 Veclen,
+                                 T,
+                                 AccT,
+                                 IdxT,
+                                 euclidean_dist<Veclen, T, AccT>,
+                                 raft::sqrt_op>({}, {}, std::forward<Args>(args)...);
+    case raft::distance::DistanceType::InnerProduct:
+      return launch_range_kernel<CountOnly,
+                                 Veclen,
+                                 T,
+                                 AccT,
+                                 IdxT,
+                                 inner_prod_dist<Veclen, T, AccT>,
+                                 raft::identity_op>({}, {}, std::forward<Args>(args)...);
+    default: RAFT_FAIL("The chosen distance metric is not supported (%d)", int(metric));
+  }
+}
+
+/**
+ * @brief Configure and launch one pass of the range scan over the probed clusters.
+ *
+ * The neighbors of a query are the vectors of its probed clusters within `radius` of it (w.r.t.
+ * the distances as returned by `ivfflat_interleaved_scan`, e.g. the squared distances for
+ * L2Expanded). The range search runs the scan twice:
+ *   - with `count_only`, the numbers of the neighbors are added to `row_counters` [n_queries],
+ *     which gives the CSR row offsets;
+ *   - then, with `row_counters` set to the row offsets, the neighbors are written into
+ *     `out_indices` and `out_distances` [nnz]; the counters are moved to the row ends.
+ *
+ * @param index previously built ivf-flat index
+ * @param[in] queries device pointer to the query vectors [n_queries, dim]
+ * @param[in] coarse_query_results device pointer to the cluster (list) ids [n_queries, n_probes]
+ * @param n_queries
+ * @param metric type of the measured distance
+ * @param n_probes number of clusters to scan per query
+ * @param radius
+ * @param select_min whether the neighbors are the points closer (true) or farther (false) than
+ *   the radius w.r.t. the given metric.
+ * @param count_only the pass of the scan
+ * @param[inout] row_counters device pointer to the per-query counters [n_queries]
+ * @param[out] out_indices device pointer to the indices of the neighbors (ignored if count_only)
+ * @param[out] out_distances device pointer to the distances to the neighbors (ignored if
+ *   count_only)
+ * @param stream
+ */
+template <typename T, typename AccT, typename IdxT>
+void ivfflat_interleaved_range_scan(const index<T, IdxT>& index,
+                                    const T* queries,
+                                    const uint32_t* coarse_query_results,
+                                    const uint32_t n_queries,
+                                    const raft::distance::DistanceType metric,
+                                    const uint32_t n_probes,
+                                    const float radius,
+                                    const bool select_min,
+                                    const bool count_only,
+                                    int64_t* row_counters,
+                                    IdxT* out_indices,
+                                    float* out_distances,
+                                    rmm::cuda_stream_view stream)
+{
+  constexpr int kMaxVeclen = std::max<int>(1, 16 / sizeof(T));
+  auto launch              = [&](auto count_pass, auto veclen) {
+    launch_range_with_fixed_consts<decltype(count_pass)::value,
+                                   decltype(veclen)::value,
+                                   T,
+                                   AccT,
+                                   IdxT>(metric,
+                                         index,
+                                         queries,
+                                         coarse_query_results,
+                                         n_queries,
+                                         n_probes,
+                                         radius,
+                                         select_min,
+                                         row_counters,
+                                         out_indices,
+                                         out_distances,
+                                         stream);
+  };
+  auto with_veclen = [&](auto count_pass) {
+    if (index.veclen() == kMaxVeclen) {
+      launch(count_pass, std::integral_constant<int, kMaxVeclen>{});
+    } else {
+      RAFT_EXPECTS(index.veclen() == 1,
+                   "Veclen must be power-of-two not bigger than the maximum allowed size for this "
+                   "data type.");
+      launch(count_pass, std::integral_constant<int, 1>{});
+    }
+  };
+  if (count_only) {
+    with_veclen(std::true_type{});
+  } else {
+    with_veclen(std::false_type{});
+  }
 }
 
 }  // namespace raft::neighbors::ivf_flat::detail
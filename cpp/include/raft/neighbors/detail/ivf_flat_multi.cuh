@@ -0,0 +1,301 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/error.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/linalg/map.cuh>
+#include <raft/linalg/unary_op.cuh>
+#include <raft/matrix/detail/select_k.cuh>
+#include <raft/neighbors/detail/ivf_adaptive_probes.cuh>  // ivf::detail::kSkippedProbe
+#include <raft/neighbors/detail/ivf_flat_search-inl.cuh>
+#include <raft/neighbors/ivf_flat_types.hpp>
+#include <raft/neighbors/sample_filter_types.hpp>
+#include <raft/spatial/knn/detail/ann_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+#include <raft/util/warp_primitives.cuh>
+
+#include <rmm/device_uvector.hpp>
+#include <rmm/mr/device/per_device_resource.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace raft::neighbors::ivf_flat::multi::detail {
+
+using namespace raft::spatial::knn::detail;  // NOLINT
+
+/**
+ * A group of IVF-Flat indices searched together: the lists (and the centers) of all the members
+ * are concatenated into one index, the lists of the member `i` occupying the labels
+ * `[list_offsets[i], list_offsets[i + 1])`. The lists are shared with the members, not copied.
+ * See raft::neighbors::ivf_flat::multi::index_group for docs.
+ */
+template <typename T, typename IdxT>
+class index_group {
+ public:
+  index_group(ivf_flat::index<T, IdxT>&& lists,
+              std::vector<uint32_t>&& list_offsets,
+              device_vector<uint32_t, uint32_t>&& list_offsets_dev)
+    : lists_(std::move(lists)),
+      list_offsets_(std::move(list_offsets)),
+      list_offsets_dev_(std::move(list_offsets_dev)),
+      max_n_lists_(0)
+  {
+    for (size_t i = 0; i + 1 < list_offsets_.size(); i++) {
+      max_n_lists_ = std::max(max_n_lists_, list_offsets_[i + 1] - list_offsets_[i]);
+    }
+  }
+
+  /** The concatenated lists and centers of all the members. */
+  [[nodiscard]] auto lists() const noexcept -> const ivf_flat::index<T, IdxT>& { return lists_; }
+  /** The number of the member indices. */
+  [[nodiscard]] auto size() const noexcept -> uint32_t
+  {
+    return static_cast<uint32_t>(list_offsets_.size() - 1);
+  }
+  /** The first label of every member in the concatenated lists [size() + 1]. */
+  [[nodiscard]] auto list_offsets() const noexcept -> const std::vector<uint32_t>&
+  {
+    return list_offsets_;
+  }
+  [[nodiscard]] auto list_offsets_dev() const noexcept
+    -> device_vector_view<const uint32_t, uint32_t>
+  {
+    return list_offsets_dev_.view();
+  }
+  /** The largest number of lists of a member. */
+  [[nodiscard]] auto max_n_lists() const noexcept -> uint32_t { return max_n_lists_; }
+
+ private:
+  ivf_flat::index<T, IdxT> lists_;
+  std::vector<uint32_t> list_offsets_;
+  device_vector<uint32_t, uint32_t> list_offsets_dev_;
+  uint32_t max_n_lists_;
+};
+
+/** See raft::neighbors::ivf_flat::multi::make_group docs */
+template <typename T, typename IdxT>
+auto make_group(raft::resources const& handle,
+                const std::vector<const ivf_flat::index<T, IdxT>*>& indices)
+  -> index_group<T, IdxT>
+{
+  auto stream = resource::get_cuda_stream(handle);
+  RAFT_EXPECTS(!indices.empty(), "The group must contain at least one index.");
+  const auto& first = *indices.front();
+  RAFT_EXPECTS(first.metric() != raft::distance::DistanceType::CosineExpanded,
+               "The CosineExpanded metric is not supported by the grouped search.");
+  std::vector<uint32_t> list_offsets(indices.size() + 1, 0);
+  for (size_t i = 0; i < indices.size(); i++) {
+    RAFT_EXPECTS(indices[i] != nullptr, "The indices of the group cannot be null.");
+    RAFT_EXPECTS(indices[i]->dim() == first.dim() && indices[i]->metric() == first.metric(),
+                 "All the indices of the group must have the same dimensionality and metric.");
+    list_offsets[i + 1] = list_offsets[i] + indices[i]->n_lists();
+  }
+  const uint32_t n_lists = list_offsets.back();
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "ivf_flat::multi::make_group(%zu indices, %u lists)", indices.size(), n_lists);
+
+  ivf_flat::index<T, IdxT> lists(handle, first.metric(), n_lists, false, true, first.dim());
+  for (size_t i = 0; i < indices.size(); i++) {
+    const auto& member = *indices[i];
+    const auto offset  = list_offsets[i];
+    std::copy(member.lists().begin(), member.lists().end(), lists.lists().begin() + offset);
+    raft::copy(lists.list_sizes().data_handle() + offset,
+               member.list_sizes().data_handle(),
+               member.n_lists(),
+               stream);
+    raft::copy(lists.centers().data_handle() + size_t(offset) * first.dim(),
+               member.centers().data_handle(),
+               size_t(member.n_lists()) * first.dim(),
+               stream);
+  }
+  lists.recompute_internal_state(handle);
+
+  auto list_offsets_dev = make_device_vector<uint32_t, uint32_t>(handle, list_offsets.size());
+  raft::copy(list_offsets_dev.data_handle(), list_offsets.data(), list_offsets.size(), stream);
+  resource::sync_stream(handle);
+  return index_group<T, IdxT>(
+    std::move(lists), std::move(list_offsets), std::move(list_offsets_dev));
+}
+
+/**
+ * The coarse distances between every query and the centers of its own index, [n_queries, ld];
+ * the columns beyond the number of lists of the index are filled with `dummy`.
+ *
+ * Every block processes one query, every warp computes the distance to one center at a time.
+ */
+template <uint32_t kBlockDim>
+__global__ void coarse_distance_kernel(const float* queries,          // [n_queries, dim]
+                                       const float* centers,          // [n_lists, dim]
+                                       const uint32_t* query_members,  // [n_queries]
+                                       const uint32_t* list_offsets,   // [n_members + 1]
+                                       uint32_t dim,
+                                       uint32_t ld,
+                                       bool inner_product,
+                                       float dummy,
+                                       float* distances)  // [n_queries, ld]
+{
+  constexpr uint32_t kNumWarps = kBlockDim / WarpSize;
+  const uint32_t q             = blockIdx.x;
+  const uint32_t lane_id       = threadIdx.x % WarpSize;
+  const uint32_t member        = query_members[q];
+  const uint32_t first_list    = list_offsets[member];
+  const uint32_t n_lists       = list_offsets[member + 1] - first_list;
+  const float* query           = queries + size_t(q) * dim;
+  distances += size_t(q) * ld;
+
+  for (uint32_t l = threadIdx.x / WarpSize; l < n_lists; l += kNumWarps) {
+    const float* center = centers + size_t(first_list + l) * dim;
+    float d             = 0;
+    for (uint32_t j = lane_id; j < dim; j += WarpSize) {
+      const float x = query[j];
+      const float c = center[j];
+      d += inner_product ? x * c : (x - c) * (x - c);
+    }
+    for (int offset = WarpSize / 2; offset > 0; offset /= 2) {
+      d += shfl_xor(d, offset);
+    }
+    if (lane_id == 0) { distances[l] = d; }
+  }
+  for (uint32_t l = n_lists + threadIdx.x; l < ld; l += kBlockDim) {
+    distances[l] = dummy;
+  }
+}
+
+/** See raft::neighbors::ivf_flat::multi::search docs */
+template <typename T, typename IdxT>
+void search(raft::resources const& handle,
+            const search_params& params,
+            const index_group<T, IdxT>& group,
+            const T* queries,
+            const uint32_t* n_queries_per_index,
+            uint32_t k,
+            IdxT* neighbors,
+            float* distances,
+            rmm::mr::device_memory_resource* mr = nullptr)
+{
+  const auto& lists    = group.lists();
+  const uint32_t dim   = lists.dim();
+  auto stream          = resource::get_cuda_stream(handle);
+  const auto n_members = group.size();
+
+  // The member of every query
+  std::vector<uint32_t> query_members;
+  for (uint32_t i = 0; i < n_members; i++) {
+    query_members.insert(query_members.end(), n_queries_per_index[i], i);
+  }
+  const auto n_queries = static_cast<uint32_t>(query_members.size());
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "ivf_flat::multi::search(k = %u, n_queries = %u, n_indices = %u)", k, n_queries, n_members);
+  RAFT_EXPECTS(params.n_probes > 0,
+               "n_probes (number of clusters to probe in the search) must be positive.");
+  if (n_queries == 0) { return; }
+  if (mr == nullptr) { mr = rmm::mr::get_current_device_resource(); }
+
+  const uint32_t ld        = group.max_n_lists();
+  const uint32_t n_probes  = std::min<uint32_t>(params.n_probes, ld);
+  const bool select_min    = raft::distance::is_min_close(lists.metric());
+  const bool inner_product = lists.metric() == raft::distance::DistanceType::InnerProduct;
+  const float dummy        = select_min ? upper_bound<float>() : lower_bound<float>();
+
+  constexpr uint32_t kMaxQueries = 4096;
+  const uint32_t max_queries     = std::min(n_queries, kMaxQueries);
+  rmm::device_uvector<uint32_t> query_members_dev(n_queries, stream, mr);
+  raft::copy(query_members_dev.data(), query_members.data(), n_queries, stream);
+  rmm::device_uvector<float> converted_queries(size_t(max_queries) * dim, stream, mr);
+  rmm::device_uvector<float> coarse_distances(size_t(max_queries) * ld, stream, mr);
+  rmm::device_uvector<float> coarse_topk(size_t(max_queries) * n_probes, stream, mr);
+  rmm::device_uvector<uint32_t> coarse_indices(size_t(max_queries) * n_probes, stream, mr);
+
+  const auto* list_offsets = group.list_offsets_dev().data_handle();
+  for (uint32_t offset_q = 0; offset_q < n_queries; offset_q += max_queries) {
+    const uint32_t queries_batch  = std::min(max_queries, n_queries - offset_q);
+    const T* batch_queries        = queries + size_t(offset_q) * dim;
+    const uint32_t* batch_members = query_members_dev.data() + offset_q;
+    linalg::unaryOp(converted_queries.data(),
+                    batch_queries,
+                    size_t(queries_batch) * dim,
+                    utils::mapping<float>{},
+                    stream);
+
+    // The coarse search: every query against the centers of its own index only, then one
+    // selection over the rows padded to the largest number of lists
+    constexpr uint32_t kBlockDim = 256;
+    coarse_distance_kernel<kBlockDim><<<queries_batch, kBlockDim, 0, stream>>>(
+      converted_queries.data(),
+      lists.centers().data_handle(),
+      batch_members,
+      list_offsets,
+      dim,
+      ld,
+      inner_product,
+      dummy,
+      coarse_distances.data());
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+    matrix::detail::select_k<float, uint32_t>(coarse_distances.data(),
+                                              nullptr,
+                                              queries_batch,
+                                              ld,
+                                              n_probes,
+                                              coarse_topk.data(),
+                                              coarse_indices.data(),
+                                              select_min,
+                                              stream,
+                                              mr);
+    // The positions within the lists of a member become the labels of the concatenated lists;
+    // the padding selected by the queries of the members with fewer than n_probes lists is skipped
+    auto coarse_view = make_device_vector_view<uint32_t, size_t>(
+      coarse_indices.data(), size_t(queries_batch) * n_probes);
+    linalg::map_offset(
+      handle,
+      coarse_view,
+      [batch_members, list_offsets, n_probes] __device__(size_t i, uint32_t pos) {
+        const uint32_t member     = batch_members[i / n_probes];
+        const uint32_t first_list = list_offsets[member];
+        return pos < list_offsets[member + 1] - first_list ? first_list + pos
+                                                           : ivf::detail::kSkippedProbe;
+      },
+      make_const_mdspan(coarse_view));
+
+    // The fine search: one scan over the probed lists of all the indices
+    ivf_flat::detail::scan_lists<T, float, IdxT>(
+      handle,
+      lists,
+      batch_queries,
+      converted_queries.data(),
+      coarse_indices.data(),
+      queries_batch,
+      offset_q,
+      k,
+      n_probes,
+      select_min,
+      neighbors + size_t(offset_q) * k,
+      distances + size_t(offset_q) * k,
+      mr,
+      raft::neighbors::filtering::none_ivf_sample_filter());
+  }
+}
+
+}  // namespace raft::neighbors::ivf_flat::multi::detail
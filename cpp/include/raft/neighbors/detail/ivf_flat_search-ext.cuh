@@ -16,16 +16,22 @@
 
 #pragma once
 
-#include <cstdint>                                 // uintX_t
-#include <raft/neighbors/ivf_flat_types.hpp>       // raft::neighbors::ivf_flat::index
-#include <raft/neighbors/sample_filter_types.hpp>  // none_ivf_sample_filter
-#include <raft/util/raft_explicit.hpp>             // RAFT_EXPLICIT
+#include <cstdint>                                    // uintX_t
+#include <cuda_fp16.h>                                // half
+#include <raft/core/device_csr_matrix.hpp>            // raft::device_csr_matrix
+#include <raft/neighbors/detail/ivf_static_dims.hpp>  // ivf::detail::ann_static_dims
+#include <raft/neighbors/ivf_flat_types.hpp>          // raft::neighbors::ivf_flat::index
+#include <raft/neighbors/sample_filter_types.hpp>     // none_ivf_sample_filter
+#include <raft/util/raft_explicit.hpp>                // RAFT_EXPLICIT
 
 #ifdef RAFT_EXPLICIT_INSTANTIATE_ONLY
 
 namespace raft::neighbors::ivf_flat::detail {
 
-template <typename T, typename IdxT, typename IvfSampleFilterT>
+template <typename T,
+          typename IdxT,
+          typename IvfSampleFilterT,
+          typename StaticDims = ivf::detail::ann_static_dims>
 void search(raft::resources const& handle,
             const search_params& params,
             const raft::neighbors::ivf_flat::index<T, IdxT>& index,
@@ -37,6 +43,16 @@ void search(raft::resources const& handle,
             rmm::mr::device_memory_resource* mr = nullptr,
             IvfSampleFilterT sample_filter      = IvfSampleFilterT()) RAFT_EXPLICIT;
 
+template <typename T, typename IdxT>
+void range_search(raft::resources const& handle,
+                  const search_params& params,
+                  const raft::neighbors::ivf_flat::index<T, IdxT>& index,
+                  const T* queries,
+                  uint32_t n_queries,
+                  float radius,
+                  raft::device_csr_matrix<float, int64_t, IdxT, int64_t>& out,
+                  rmm::mr::device_memory_resource* mr = nullptr) RAFT_EXPLICIT;
+
 }  // namespace raft::neighbors::ivf_flat::detail
 
 #endif  // RAFT_EXPLICIT_INSTANTIATE_ONLY
@@ -60,5 +76,25 @@ instantiate_raft_neighbors_ivf_flat_detail_search(
   int8_t, int64_t, raft::neighbors::filtering::none_ivf_sample_filter);
 instantiate_raft_neighbors_ivf_flat_detail_search(
   uint8_t, int64_t, raft::neighbors::filtering::none_ivf_sample_filter);
+instantiate_raft_neighbors_ivf_flat_detail_search(
+  half, int64_t, raft::neighbors::filtering::none_ivf_sample_filter);
 
 #undef instantiate_raft_neighbors_ivf_flat_detail_search
+
+#define instantiate_raft_neighbors_ivf_flat_detail_range_search(T, IdxT)         \
+  extern template void raft::neighbors::ivf_flat::detail::range_search<T, IdxT>( \
+    raft::resources const& handle,                                               \
+    const search_params& params,                                                 \
+    const raft::neighbors::ivf_flat::index<T, IdxT>& index,                      \
+    const T* queries,                                                            \
+    uint32_t n_queries,                                                          \
+    float radius,                                                                \
+    raft::device_csr_matrix<float, int64_t, IdxT, int64_t>& out,                 \
+    rmm::mr::device_memory_resource* mr)
+
+instantiate_raft_neighbors_ivf_flat_detail_range_search(float, int64_t);
+instantiate_raft_neighbors_ivf_flat_detail_range_search(int8_t, int64_t);
+instantiate_raft_neighbors_ivf_flat_detail_range_search(uint8_t, int64_t);
+instantiate_raft_neighbors_ivf_flat_detail_range_search(half, int64_t);
+
+#undef instantiate_raft_neighbors_ivf_flat_detail_range_search
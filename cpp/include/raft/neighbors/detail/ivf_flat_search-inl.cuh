@@ -16,37 +16,54 @@
 
 #pragma once
 
+#include <raft/core/device_csr_matrix.hpp>                      // raft::device_csr_matrix
 #include <raft/core/logger.hpp>                                 // RAFT_LOG_TRACE
+#include <raft/core/metrics.hpp>                                // raft::metrics::stream_timer
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/thrust_policy.hpp>                 // raft::resource::get_thrust_policy
 #include <raft/core/resources.hpp>                              // raft::resources
 #include <raft/distance/distance_types.hpp>                     // is_min_close, DistanceType
 #include <raft/linalg/gemm.cuh>                                 // raft::linalg::gemm
 #include <raft/linalg/norm.cuh>                                 // raft::linalg::norm
 #include <raft/linalg/unary_op.cuh>                             // raft::linalg::unary_op
 #include <raft/matrix/detail/select_k.cuh>                      // matrix::detail::select_k
+#include <raft/neighbors/detail/ivf_adaptive_probes.cuh>        // ivf::detail::adaptive_probes
 #include <raft/neighbors/detail/ivf_flat_interleaved_scan.cuh>  // interleaved_scan
+#include <raft/neighbors/detail/ivf_flat_search_grouped.cuh>    // grouped_scan
+#include <raft/neighbors/detail/ivf_static_dims.hpp>            // ivf::detail::ann_static_dims
 #include <raft/neighbors/ivf_flat_types.hpp>                    // raft::neighbors::ivf_flat::index
 #include <raft/neighbors/sample_filter_types.hpp>               // none_ivf_sample_filter
 #include <raft/spatial/knn/detail/ann_utils.cuh>                // utils::mapping
 #include <rmm/mr/device/per_device_resource.hpp>                // rmm::device_memory_resource
 
+#include <thrust/scan.h>
+
 namespace raft::neighbors::ivf_flat::detail {
 
 using namespace raft::spatial::knn::detail;  // NOLINT
 
-template <typename T, typename AccT, typename IdxT, typename IvfSampleFilterT>
-void search_impl(raft::resources const& handle,
-                 const raft::neighbors::ivf_flat::index<T, IdxT>& index,
-                 const T* queries,
-                 uint32_t n_queries,
-                 uint32_t queries_offset,
-                 uint32_t k,
-                 uint32_t n_probes,
-                 bool select_min,
-                 IdxT* neighbors,
-                 AccT* distances,
-                 rmm::mr::device_memory_resource* search_mr,
-                 IvfSampleFilterT sample_filter)
+/** The type of the distances accumulated by the interleaved scan (fp32 for the fp16 data). */
+template <typename T>
+using scan_acc_t =
+  std::conditional_t<std::is_same_v<T, half>, float, typename utils::config<T>::value_t>;
+
+/**
+ * Select the clusters (lists) to probe for every query (the coarse search).
+ *
+ * @param[out] coarse_indices the probed lists [n_queries, n_probes]; the probes dropped by the
+ *   adaptive probing are marked as `ivf::detail::kSkippedProbe`.
+ */
+template <typename T, typename IdxT>
+void select_clusters(raft::resources const& handle,
+                     const raft::neighbors::ivf_flat::index<T, IdxT>& index,
+                     const float* converted_queries_ptr,
+                     uint32_t n_queries,
+                     uint32_t n_probes,
+                     uint32_t max_candidates,
+                     float probe_distance_ratio,
+                     bool select_min,
+                     uint32_t* coarse_indices,
+                     rmm::mr::device_memory_resource* search_mr)
 {
   auto stream = resource::get_cuda_stream(handle);
   // The norm of query
@@ -55,34 +72,12 @@ void search_impl(raft::resources const& handle,
   rmm::device_uvector<float> distance_buffer_dev(n_queries * index.n_lists(), stream, search_mr);
   // The topk distance value of cluster(list) and queries
   rmm::device_uvector<float> coarse_distances_dev(n_queries * n_probes, stream, search_mr);
-  // The topk  index of cluster(list) and queries
-  rmm::device_uvector<uint32_t> coarse_indices_dev(n_queries * n_probes, stream, search_mr);
-  // The topk distance value of candidate vectors from each cluster(list)
-  rmm::device_uvector<AccT> refined_distances_dev(n_queries * n_probes * k, stream, search_mr);
-  // The topk index of candidate vectors from each cluster(list)
-  rmm::device_uvector<IdxT> refined_indices_dev(n_queries * n_probes * k, stream, search_mr);
-
-  size_t float_query_size;
-  if constexpr (std::is_integral_v<T>) {
-    float_query_size = n_queries * index.dim();
-  } else {
-    float_query_size = 0;
-  }
-  rmm::device_uvector<float> converted_queries_dev(float_query_size, stream, search_mr);
-  float* converted_queries_ptr = converted_queries_dev.data();
-
-  if constexpr (std::is_same_v<T, float>) {
-    converted_queries_ptr = const_cast<float*>(queries);
-  } else {
-    linalg::unaryOp(
-      converted_queries_ptr, queries, n_queries * index.dim(), utils::mapping<float>{}, stream);
-  }
 
   float alpha = 1.0f;
   float beta  = 0.0f;
 
   // todo(lsugy): raft distance? (if performance is similar/better than gemm)
-  switch (index.metric()) {
+  switch (utils::internal_metric(index.metric())) {
     case raft::distance::DistanceType::L2Expanded:
     case raft::distance::DistanceType::L2SqrtExpanded: {
       alpha = -2.0f;
@@ -127,18 +122,94 @@ void search_impl(raft::resources const& handle,
                stream);
 
   RAFT_LOG_TRACE_VEC(distance_buffer_dev.data(), std::min<uint32_t>(20, index.n_lists()));
-  matrix::detail::select_k<AccT, uint32_t>(distance_buffer_dev.data(),
-                                           nullptr,
+  matrix::detail::select_k<float, uint32_t>(distance_buffer_dev.data(),
+                                            nullptr,
+                                            n_queries,
+                                            index.n_lists(),
+                                            n_probes,
+                                            coarse_distances_dev.data(),
+                                            coarse_indices,
+                                            select_min,
+                                            stream,
+                                            search_mr);
+  RAFT_LOG_TRACE_VEC(coarse_indices, n_probes);
+  RAFT_LOG_TRACE_VEC(coarse_distances_dev.data(), n_probes);
+
+  if (ivf::detail::is_adaptive_probing(max_candidates, probe_distance_ratio)) {
+    // The distance ratio is defined for the (non-negative, ascending) L2 distances only
+    ivf::detail::adaptive_probes(handle,
+                                 n_queries,
+                                 n_probes,
+                                 coarse_distances_dev.data(),
+                                 nullptr,
+                                 coarse_indices,
+                                 index.list_sizes().data_handle(),
+                                 max_candidates,
+                                 select_min ? probe_distance_ratio : 0.0f,
+                                 true,
+                                 nullptr);
+  }
+}
+
+/**
+ * Scan the probed lists and select the top-k neighbors of every query (the fine search).
+ *
+ * The probes marked as `ivf::detail::kSkippedProbe` in `coarse_indices` are not scanned.
+ */
+template <typename T,
+          typename AccT,
+          typename IdxT,
+          typename IvfSampleFilterT,
+          typename StaticDims = ivf::detail::ann_static_dims>
+void scan_lists(raft::resources const& handle,
+                const raft::neighbors::ivf_flat::index<T, IdxT>& index,
+                const T* queries,
+                const float* converted_queries_ptr,
+                const uint32_t* coarse_indices,
+                uint32_t n_queries,
+                uint32_t queries_offset,
+                uint32_t k,
+                uint32_t n_probes,
+                bool select_min,
+                IdxT* neighbors,
+                AccT* distances,
+                rmm::mr::device_memory_resource* search_mr,
+                IvfSampleFilterT sample_filter)
+{
+  auto stream = resource::get_cuda_stream(handle);
+  // The topk distance value of candidate vectors from each cluster(list)
+  rmm::device_uvector<AccT> refined_distances_dev(n_queries * n_probes * k, stream, search_mr);
+  // The topk index of candidate vectors from each cluster(list)
+  rmm::device_uvector<IdxT> refined_indices_dev(n_queries * n_probes * k, stream, search_mr);
+
+  // Large batches: every list is probed by many queries, compute the distances by GEMMs
+  if constexpr (std::is_same_v<IvfSampleFilterT,
+                               raft::neighbors::filtering::none_ivf_sample_filter>) {
+    if (is_grouped_scan_profitable(n_queries, n_probes, index.n_lists())) {
+      grouped_scan<T, IdxT>(handle,
+                            index,
+                            converted_queries_ptr,
+                            coarse_indices,
+                            n_queries,
+                            n_probes,
+                            k,
+                            select_min,
+                            refined_indices_dev.data(),
+                            refined_distances_dev.data(),
+                            search_mr);
+      matrix::detail::select_k<AccT, IdxT>(refined_distances_dev.data(),
+                                           refined_indices_dev.data(),
                                            n_queries,
-                                           index.n_lists(),
-                                           n_probes,
-                                           coarse_distances_dev.data(),
-                                           coarse_indices_dev.data(),
+                                           k * n_probes,
+                                           k,
+                                           distances,
+                                           neighbors,
                                            select_min,
                                            stream,
                                            search_mr);
-  RAFT_LOG_TRACE_VEC(coarse_indices_dev.data(), n_probes);
-  RAFT_LOG_TRACE_VEC(coarse_distances_dev.data(), n_probes);
+      return;
+    }
+  }
 
   auto distances_dev_ptr = refined_distances_dev.data();
   auto indices_dev_ptr   = refined_indices_dev.data();
@@ -146,13 +217,13 @@ void search_impl(raft::resources const& handle,
   uint32_t grid_dim_x = 0;
   if (n_probes > 1) {
     // query the gridDimX size to store probes topK output
-    ivfflat_interleaved_scan<T, typename utils::config<T>::value_t, IdxT, IvfSampleFilterT>(
+    ivfflat_interleaved_scan<T, scan_acc_t<T>, IdxT, IvfSampleFilterT, StaticDims>(
       index,
       nullptr,
       nullptr,
       n_queries,
       queries_offset,
-      index.metric(),
+      utils::internal_metric(index.metric()),
       n_probes,
       k,
       select_min,
@@ -170,13 +241,13 @@ void search_impl(raft::resources const& handle,
     indices_dev_ptr   = neighbors;
   }
 
-  ivfflat_interleaved_scan<T, typename utils::config<T>::value_t, IdxT, IvfSampleFilterT>(
+  ivfflat_interleaved_scan<T, scan_acc_t<T>, IdxT, IvfSampleFilterT, StaticDims>(
     index,
     queries,
-    coarse_indices_dev.data(),
+    coarse_indices,
     n_queries,
     queries_offset,
-    index.metric(),
+    utils::internal_metric(index.metric()),
     n_probes,
     k,
     select_min,
@@ -204,10 +275,100 @@ void search_impl(raft::resources const& handle,
   }
 }
 
-/** See raft::neighbors::ivf_flat::search docs */
+template <typename T,
+          typename AccT,
+          typename IdxT,
+          typename IvfSampleFilterT,
+          typename StaticDims = ivf::detail::ann_static_dims>
+void search_impl(raft::resources const& handle,
+                 const raft::neighbors::ivf_flat::index<T, IdxT>& index,
+                 const T* queries,
+                 uint32_t n_queries,
+                 uint32_t queries_offset,
+                 uint32_t k,
+                 uint32_t n_probes,
+                 uint32_t max_candidates,
+                 float probe_distance_ratio,
+                 bool select_min,
+                 IdxT* neighbors,
+                 AccT* distances,
+                 rmm::mr::device_memory_resource* search_mr,
+                 IvfSampleFilterT sample_filter)
+{
+  auto stream = resource::get_cuda_stream(handle);
+  // The topk  index of cluster(list) and queries
+  rmm::device_uvector<uint32_t> coarse_indices_dev(n_queries * n_probes, stream, search_mr);
+
+  // The cosine metric is the inner product of the normalized vectors: the queries are normalized
+  // in the converted copy, which is then used by the scan too.
+  const bool normalize = index.metric() == raft::distance::DistanceType::CosineExpanded;
+  const bool convert   = !std::is_same_v<T, float> || normalize;
+  rmm::device_uvector<float> converted_queries_dev(
+    convert ? n_queries * index.dim() : 0, stream, search_mr);
+  float* converted_queries_ptr = converted_queries_dev.data();
+
+  if (convert) {
+    linalg::unaryOp(
+      converted_queries_ptr, queries, n_queries * index.dim(), utils::mapping<float>{}, stream);
+  } else if constexpr (std::is_same_v<T, float>) {
+    converted_queries_ptr = const_cast<float*>(queries);
+  }
+  rmm::device_uvector<T> normalized_queries_dev(0, stream, search_mr);
+  if (normalize) {
+    utils::normalize_rows(handle, converted_queries_ptr, n_queries, index.dim());
+    if constexpr (std::is_same_v<T, float>) {
+      queries = converted_queries_ptr;
+    } else {
+      normalized_queries_dev.resize(n_queries * index.dim(), stream);
+      linalg::unaryOp(normalized_queries_dev.data(),
+                      converted_queries_ptr,
+                      normalized_queries_dev.size(),
+                      raft::cast_op<T>{},
+                      stream);
+      queries = normalized_queries_dev.data();
+    }
+  }
+
+  {
+    raft::metrics::stream_timer timer("ivf_flat::search::coarse_search", stream);
+    select_clusters(handle,
+                    index,
+                    converted_queries_ptr,
+                    n_queries,
+                    n_probes,
+                    max_candidates,
+                    probe_distance_ratio,
+                    select_min,
+                    coarse_indices_dev.data(),
+                    search_mr);
+  }
+  // NB: the scan includes the merge of the top-k of the probed lists
+  raft::metrics::stream_timer timer("ivf_flat::search::scan", stream);
+  scan_lists<T, AccT, IdxT, IvfSampleFilterT, StaticDims>(handle,
+                                                          index,
+                                                          queries,
+                                                          converted_queries_ptr,
+                                                          coarse_indices_dev.data(),
+                                                          n_queries,
+                                                          queries_offset,
+                                                          k,
+                                                          n_probes,
+                                                          select_min,
+                                                          neighbors,
+                                                          distances,
+                                                          search_mr,
+                                                          sample_filter);
+}
+
+/**
+ * See raft::neighbors::ivf_flat::search docs
+ *
+ * @tparam StaticDims the dimensions to specialize the scan for (see `ivf::detail::static_dims_t`)
+ */
 template <typename T,
           typename IdxT,
-          typename IvfSampleFilterT = raft::neighbors::filtering::none_ivf_sample_filter>
+          typename IvfSampleFilterT = raft::neighbors::filtering::none_ivf_sample_filter,
+          typename StaticDims       = ivf::detail::ann_static_dims>
 inline void search(raft::resources const& handle,
                    const search_params& params,
                    const index<T, IdxT>& index,
@@ -228,10 +389,15 @@ inline void search(raft::resources const& handle,
 
   // a batch size heuristic: try to keep the workspace within the specified size
   constexpr uint32_t kExpectedWsSize = 1024 * 1024 * 1024;
-  const uint32_t max_queries =
+  uint32_t max_queries =
     std::min<uint32_t>(n_queries,
                        raft::div_rounding_up_safe<uint64_t>(
                          kExpectedWsSize, 16ull * uint64_t{n_probes} * k + 4ull * index.dim()));
+  // With a deadline, the batches are kept small enough to check it often.
+  if (params.deadline.is_set()) { max_queries = std::min(max_queries, kDeadlineMaxQueries); }
+
+  raft::metrics::record(
+    "ivf_flat::search::batch_size", raft::metrics::metric_kind::count, max_queries);
 
   auto pool_guard = raft::get_pool_memory_resource(mr, max_queries * n_probes * k * 16);
   if (pool_guard) {
@@ -241,20 +407,164 @@ inline void search(raft::resources const& handle,
 
   for (uint32_t offset_q = 0; offset_q < n_queries; offset_q += max_queries) {
     uint32_t queries_batch = min(max_queries, n_queries - offset_q);
+    // Past the deadline, the remaining queries probe their closest cluster only.
+    const bool late = ivf::detail::is_past_deadline(handle, params.deadline, offset_q > 0);
 
-    search_impl<T, float, IdxT, IvfSampleFilterT>(handle,
-                                                  index,
-                                                  queries + offset_q * index.dim(),
-                                                  queries_batch,
-                                                  offset_q,
-                                                  k,
-                                                  n_probes,
-                                                  raft::distance::is_min_close(index.metric()),
-                                                  neighbors + offset_q * k,
-                                                  distances + offset_q * k,
-                                                  mr,
-                                                  sample_filter);
+    search_impl<T, float, IdxT, IvfSampleFilterT, StaticDims>(
+      handle,
+      index,
+      queries + offset_q * index.dim(),
+      queries_batch,
+      offset_q,
+      k,
+      n_probes,
+      late ? 1 : params.max_candidates,
+      late ? 0.0f : params.probe_distance_ratio,
+      raft::distance::is_min_close(utils::internal_metric(index.metric())),
+      neighbors + offset_q * k,
+      distances + offset_q * k,
+      mr,
+      sample_filter);
+    if (index.metric() == raft::distance::DistanceType::CosineExpanded) {
+      utils::inner_product_to_cosine(handle, distances + offset_q * k, size_t(queries_batch) * k);
+    }
   }
 }
 
+/** See raft::neighbors::ivf_flat::range_search docs */
+template <typename T, typename IdxT>
+void range_search(raft::resources const& handle,
+                  const search_params& params,
+                  const index<T, IdxT>& index,
+                  const T* queries,
+                  uint32_t n_queries,
+                  float radius,
+                  raft::device_csr_matrix<float, int64_t, IdxT, int64_t>& out,
+                  rmm::mr::device_memory_resource* mr = nullptr)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "ivf_flat::range_search(n_queries = %u, dim = %zu)", n_queries, index.dim());
+
+  RAFT_EXPECTS(params.n_probes > 0,
+               "n_probes (number of clusters to probe in the search) must be positive.");
+  auto n_probes         = std::min<uint32_t>(params.n_probes, index.n_lists());
+  auto stream           = resource::get_cuda_stream(handle);
+  const auto metric     = utils::internal_metric(index.metric());
+  const bool select_min = raft::distance::is_min_close(metric);
+  if (mr == nullptr) { mr = rmm::mr::get_current_device_resource(); }
+  // The cosine distance within the radius is the inner product of the normalized vectors above
+  // `1 - radius`; the scans read the normalized copy of the queries.
+  const bool cosine = index.metric() == raft::distance::DistanceType::CosineExpanded;
+  rmm::device_uvector<T> normalized_queries(
+    cosine ? size_t(n_queries) * index.dim() : 0, stream, mr);
+  if (cosine) {
+    rmm::device_uvector<float> float_queries(normalized_queries.size(), stream, mr);
+    linalg::unaryOp(
+      float_queries.data(), queries, float_queries.size(), utils::mapping<float>{}, stream);
+    utils::normalize_rows(handle, float_queries.data(), n_queries, index.dim());
+    linalg::unaryOp(normalized_queries.data(),
+                    float_queries.data(),
+                    float_queries.size(),
+                    raft::cast_op<T>{},
+                    stream);
+    queries = normalized_queries.data();
+    radius  = 1.0f - radius;
+  }
+
+  // the output is sized once the number of the neighbors is known
+  auto init_output = [&](int64_t nnz) {
+    out.initialize_sparsity(nnz);
+    auto structure = out.structure_view();
+    RAFT_EXPECTS(
+      structure.get_n_rows() == int64_t(n_queries) && structure.get_n_cols() == index.size(),
+      "The output must be a CSR matrix of shape [n_queries, index.size()]");
+    return structure;
+  };
+  if (n_queries == 0 || index.size() == 0) {
+    auto structure = init_output(0);
+    RAFT_CUDA_TRY(cudaMemsetAsync(
+      structure.get_indptr().data(), 0, (size_t(n_queries) + 1) * sizeof(int64_t), stream));
+    return;
+  }
+
+  // The probed clusters are kept for both passes of the scan; the coarse search is batched to keep
+  // the distances to the cluster centers within the workspace budget.
+  rmm::device_uvector<uint32_t> coarse_indices_dev(size_t(n_queries) * n_probes, stream, mr);
+  {
+    raft::metrics::stream_timer timer("ivf_flat::range_search::coarse_search", stream);
+    constexpr uint64_t kExpectedWsSize = 1024 * 1024 * 1024;
+    const uint32_t max_queries         = std::min<uint32_t>(
+      n_queries,
+      raft::div_rounding_up_safe<uint64_t>(
+        kExpectedWsSize, 4ull * (uint64_t{index.n_lists()} + n_probes + index.dim())));
+    rmm::device_uvector<float> converted_queries_dev(
+      std::is_same_v<T, float> ? 0 : size_t(max_queries) * index.dim(), stream, mr);
+    for (uint32_t offset_q = 0; offset_q < n_queries; offset_q += max_queries) {
+      const uint32_t queries_batch = std::min(max_queries, n_queries - offset_q);
+      const T* batch               = queries + size_t(offset_q) * index.dim();
+      const float* converted_queries_ptr;
+      if constexpr (std::is_same_v<T, float>) {
+        converted_queries_ptr = batch;
+      } else {
+        linalg::unaryOp(converted_queries_dev.data(),
+                        batch,
+                        size_t(queries_batch) * index.dim(),
+                        utils::mapping<float>{},
+                        stream);
+        converted_queries_ptr = converted_queries_dev.data();
+      }
+      select_clusters(handle,
+                      index,
+                      converted_queries_ptr,
+                      queries_batch,
+                      n_probes,
+                      params.max_candidates,
+                      params.probe_distance_ratio,
+                      select_min,
+                      coarse_indices_dev.data() + size_t(offset_q) * n_probes,
+                      mr);
+    }
+  }
+
+  raft::metrics::stream_timer timer("ivf_flat::range_search::scan", stream);
+  // the number of neighbors of every query in the first pass, the write positions in the second
+  rmm::device_uvector<int64_t> row_counters(n_queries, stream, mr);
+  RAFT_CUDA_TRY(cudaMemsetAsync(row_counters.data(), 0, n_queries * sizeof(int64_t), stream));
+  auto scan = [&](bool count_only, IdxT* out_indices, float* out_distances) {
+    ivfflat_interleaved_range_scan<T, scan_acc_t<T>, IdxT>(index,
+                                                           queries,
+                                                           coarse_indices_dev.data(),
+                                                           n_queries,
+                                                           metric,
+                                                           n_probes,
+                                                           radius,
+                                                           select_min,
+                                                           count_only,
+                                                           row_counters.data(),
+                                                           out_indices,
+                                                           out_distances,
+                                                           stream);
+  };
+
+  // first pass: count the neighbors, the row offsets are their prefix sum
+  scan(true, nullptr, nullptr);
+  rmm::device_uvector<int64_t> indptr(size_t(n_queries) + 1, stream, mr);
+  RAFT_CUDA_TRY(cudaMemsetAsync(indptr.data(), 0, sizeof(int64_t), stream));
+  thrust::inclusive_scan(resource::get_thrust_policy(handle),
+                         row_counters.data(),
+                         row_counters.data() + n_queries,
+                         indptr.data() + 1);
+  int64_t nnz;
+  raft::update_host(&nnz, indptr.data() + n_queries, 1, stream);
+  resource::sync_stream(handle, stream);
+  auto structure = init_output(nnz);
+  raft::copy(structure.get_indptr().data(), indptr.data(), size_t(n_queries) + 1, stream);
+  if (nnz == 0) { return; }
+
+  // second pass: recompute the distances and write the neighbors
+  raft::copy(row_counters.data(), indptr.data(), n_queries, stream);
+  scan(false, structure.get_indices().data(), out.get_elements().data());
+  if (cosine) { utils::inner_product_to_cosine(handle, out.get_elements().data(), nnz); }
+}
+
 }  // namespace raft::neighbors::ivf_flat::detail
@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/linalg/gemm.cuh>
+#include <raft/linalg/map.cuh>
+#include <raft/linalg/norm.cuh>
+#include <raft/matrix/detail/select_k.cuh>
+#include <raft/matrix/gather.cuh>
+#include <raft/neighbors/detail/ivf_probe_inversion.cuh>
+#include <raft/neighbors/ivf_flat_types.hpp>
+#include <raft/neighbors/ivf_list_types.hpp>
+#include <raft/spatial/knn/detail/ann_utils.cuh>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+#include <raft/util/integer_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <thrust/fill.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace raft::neighbors::ivf_flat::detail {
+
+/**
+ * The minimum average number of queries per list, starting from which the grouped scan
+ * (see `grouped_scan`) is used in place of the interleaved scan.
+ */
+constexpr static inline uint32_t kGroupedScanMinQueriesPerList = 128;
+/** The maximum number of elements in a distance tile of the grouped scan. */
+constexpr static inline size_t kGroupedScanMaxTileSize = size_t{1} << 26;
+
+/** Whether the grouped scan is expected to be faster than the interleaved scan. */
+inline auto is_grouped_scan_profitable(uint32_t n_queries, uint32_t n_probes, uint32_t n_lists)
+  -> bool
+{
+  return uint64_t(n_queries) * uint64_t(n_probes) >=
+         uint64_t(kGroupedScanMinQueriesPerList) * uint64_t(n_lists);
+}
+
+template <typename IdxT>
+__global__ void grouped_scan_scatter_kernel(uint32_t n_rows,
+                                            uint32_t k_tile,
+                                            uint32_t k,
+                                            const uint32_t* out_rows,        // [n_rows]
+                                            const float* tile_dists,         // [n_rows, k_tile]
+                                            const uint32_t* tile_positions,  // [n_rows, k_tile]
+                                            const IdxT* list_indices,        // [list_size]
+                                            bool clamp_to_zero,
+                                            bool take_sqrt,
+                                            float* out_dists,  // [n_queries * n_probes, k]
+                                            IdxT* out_indices)  // [n_queries * n_probes, k]
+{
+  const uint64_t i = threadIdx.x + uint64_t(blockDim.x) * uint64_t(blockIdx.x);
+  if (i >= uint64_t(n_rows) * uint64_t(k_tile)) { return; }
+  const uint32_t row    = i / k_tile;
+  const uint32_t j      = i % k_tile;
+  const uint64_t out_ix = uint64_t(out_rows[row]) * uint64_t(k) + j;
+  float dist            = tile_dists[i];
+  // The expanded form of the L2 distance may go slightly below zero due to the rounding errors.
+  if (clamp_to_zero) { dist = max(dist, 0.0f); }
+  if (take_sqrt) { dist = sqrtf(dist); }
+  out_dists[out_ix]   = dist;
+  out_indices[out_ix] = list_indices[tile_positions[i]];
+}
+
+/**
+ * Scan the probed lists by groups of queries (the grouped scan).
+ *
+ * The (query, probe) pairs are grouped by the probed list, so that every list is read once and the
+ * distances between it and all the queries probing it are computed by a single GEMM, followed by
+ * the per-query top-k selection. Compared to the interleaved scan, which reads the list once per
+ * probing query, this pays the extra cost of de-interleaving the list data, but benefits from the
+ * much higher arithmetic throughput of the GEMM; it is profitable when the lists are probed by
+ * many queries each (large query batches; see `is_grouped_scan_profitable`).
+ *
+ * The results are written per (query, probe) pair, in the same layout as the output of the
+ * interleaved scan with `grid_dim_x == n_probes`; the slots of the skipped probes and of the lists
+ * shorter than `k` are filled with the dummy values.
+ *
+ * @param[in] handle
+ * @param[in] index
+ * @param[in] queries the queries converted to float [n_queries, dim]
+ * @param[in] coarse_indices the probed lists [n_queries, n_probes] (device memory);
+ *   the probes may be skipped by the adaptive probing (`ivf::detail::kSkippedProbe`).
+ * @param n_queries
+ * @param n_probes
+ * @param k
+ * @param select_min
+ * @param[out] neighbors [n_queries, n_probes, k]
+ * @param[out] distances [n_queries, n_probes, k]
+ * @param mr the memory resource for the temporary buffers
+ */
+template <typename T, typename IdxT>
+void grouped_scan(raft::resources const& handle,
+                  const index<T, IdxT>& index,
+                  const float* queries,
+                  const uint32_t* coarse_indices,
+                  uint32_t n_queries,
+                  uint32_t n_probes,
+                  uint32_t k,
+                  bool select_min,
+                  IdxT* neighbors,
+                  float* distances,
+                  rmm::mr::device_memory_resource* mr)
+{
+  auto stream             = resource::get_cuda_stream(handle);
+  const uint32_t dim      = index.dim();
+  const uint32_t veclen   = index.veclen();
+  const uint32_t n_lists  = index.n_lists();
+  const size_t n_pairs    = size_t(n_queries) * size_t(n_probes);
+  const bool is_l2 =
+    utils::internal_metric(index.metric()) != raft::distance::DistanceType::InnerProduct;
+  const bool is_l2_sqrt   = index.metric() == raft::distance::DistanceType::L2SqrtExpanded ||
+                          index.metric() == raft::distance::DistanceType::L2SqrtUnexpanded;
+  const float dummy_dist  = select_min ? upper_bound<float>() : lower_bound<float>();
+  const float alpha       = is_l2 ? -2.0f : 1.0f;
+  const float beta        = is_l2 ? 1.0f : 0.0f;
+  constexpr int kBlockDim = 256;
+
+  thrust::fill_n(resource::get_thrust_policy(handle), distances, n_pairs * k, dummy_dist);
+  thrust::fill_n(
+    resource::get_thrust_policy(handle), neighbors, n_pairs * k, ivf::kInvalidRecord<IdxT>);
+
+  // Group the (query, probe) pairs by the probed list; only the segment offsets go to the host.
+  // The pair `query_ix * n_probes + probe_ix` is also the row of its results in the output.
+  rmm::device_uvector<uint32_t> pair_rows(n_pairs, stream, mr);
+  rmm::device_uvector<uint32_t> list_offsets_dev(n_lists + 1, stream, mr);
+  ivf::detail::invert_probes(handle,
+                             coarse_indices,
+                             n_queries,
+                             n_probes,
+                             n_lists,
+                             pair_rows.data(),
+                             list_offsets_dev.data(),
+                             mr);
+  std::vector<uint32_t> list_offsets(n_lists + 1);
+  std::vector<uint32_t> h_list_sizes(n_lists);
+  raft::copy(list_offsets.data(), list_offsets_dev.data(), n_lists + 1, stream);
+  raft::copy(h_list_sizes.data(), index.list_sizes().data_handle(), n_lists, stream);
+  resource::sync_stream(handle);
+
+  // The buffers for the de-interleaved lists are sized for the largest probed list
+  uint32_t max_list_size = 0;
+  for (uint32_t l = 0; l < n_lists; l++) {
+    if (list_offsets[l + 1] > list_offsets[l]) {
+      max_list_size = std::max(max_list_size, h_list_sizes[l]);
+    }
+  }
+  rmm::device_uvector<float> list_vectors(size_t(max_list_size) * dim, stream, mr);
+  rmm::device_uvector<float> list_norms(is_l2 ? max_list_size : 0, stream, mr);
+
+  for (uint32_t l = 0; l < n_lists; l++) {
+    const uint32_t n_list_queries = list_offsets[l + 1] - list_offsets[l];
+    const uint32_t list_size      = h_list_sizes[l];
+    if (n_list_queries == 0 || list_size == 0) { continue; }
+    const auto& list          = index.lists()[l];
+    const T* list_data        = list->data.data_handle();
+    const IdxT* list_indices  = list->indices.data_handle();
+    const uint32_t* list_rows = pair_rows.data() + list_offsets[l];
+
+    // De-interleave the list data (see `list_spec` in ivf_flat_types.hpp for the layout).
+    linalg::map_offset(
+      handle,
+      make_device_vector_view<float, size_t>(list_vectors.data(), size_t(list_size) * dim),
+      [list_data, dim, veclen] __device__(size_t i) {
+        const size_t row       = i / dim;
+        const uint32_t col     = i % dim;
+        const size_t group     = row / kIndexGroupSize;
+        const uint32_t ingroup = row % kIndexGroupSize;
+        const size_t offset    = group * kIndexGroupSize * dim +
+                              (col / veclen) * kIndexGroupSize * veclen + ingroup * veclen +
+                              col % veclen;
+        return utils::mapping<float>{}(list_data[offset]);
+      });
+    if (is_l2) {
+      raft::linalg::rowNorm(list_norms.data(),
+                            list_vectors.data(),
+                            dim,
+                            list_size,
+                            raft::linalg::L2Norm,
+                            true,
+                            stream);
+    }
+
+    // Tile the queries to bound the size of the distance buffer
+    const uint32_t max_tile_rows = std::clamp<size_t>(
+      kGroupedScanMaxTileSize / list_size, size_t{1}, size_t{n_list_queries});
+    const uint32_t k_tile = std::min(k, list_size);
+    rmm::device_uvector<float> tile_queries(size_t(max_tile_rows) * dim, stream, mr);
+    rmm::device_uvector<float> tile_norms(is_l2 ? max_tile_rows : 0, stream, mr);
+    rmm::device_uvector<float> tile_dists(size_t(max_tile_rows) * list_size, stream, mr);
+    rmm::device_uvector<float> tile_best_dists(size_t(max_tile_rows) * k_tile, stream, mr);
+    rmm::device_uvector<uint32_t> tile_best_positions(size_t(max_tile_rows) * k_tile, stream, mr);
+    for (uint32_t offset = 0; offset < n_list_queries; offset += max_tile_rows) {
+      const uint32_t n_rows = std::min(max_tile_rows, n_list_queries - offset);
+      raft::matrix::gather(queries,
+                           dim,
+                           n_queries,
+                           list_rows + offset,
+                           n_rows,
+                           tile_queries.data(),
+                           raft::div_const_op<uint32_t>(n_probes),
+                           stream);
+      if (is_l2) {
+        raft::linalg::rowNorm(tile_norms.data(),
+                              tile_queries.data(),
+                              dim,
+                              n_rows,
+                              raft::linalg::L2Norm,
+                              true,
+                              stream);
+        utils::outer_add(
+          tile_norms.data(), n_rows, list_norms.data(), list_size, tile_dists.data(), stream);
+      }
+      linalg::gemm(handle,
+                   true,
+                   false,
+                   list_size,
+                   n_rows,
+                   dim,
+                   &alpha,
+                   list_vectors.data(),
+                   dim,
+                   tile_queries.data(),
+                   dim,
+                   &beta,
+                   tile_dists.data(),
+                   list_size,
+                   stream);
+      matrix::detail::select_k<float, uint32_t>(tile_dists.data(),
+                                                nullptr,
+                                                n_rows,
+                                                list_size,
+                                                k_tile,
+                                                tile_best_dists.data(),
+                                                tile_best_positions.data(),
+                                                select_min,
+                                                stream,
+                                                mr);
+      const uint32_t n_blocks =
+        raft::ceildiv<uint64_t>(uint64_t(n_rows) * uint64_t(k_tile), kBlockDim);
+      grouped_scan_scatter_kernel<IdxT>
+        <<<n_blocks, kBlockDim, 0, stream>>>(n_rows,
+                                             k_tile,
+                                             k,
+                                             list_rows + offset,
+                                             tile_best_dists.data(),
+                                             tile_best_positions.data(),
+                                             list_indices,
+                                             is_l2,
+                                             is_l2_sqrt,
+                                             distances,
+                                             neighbors);
+      RAFT_CUDA_TRY(cudaPeekAtLastError());
+    }
+  }
+}
+
+}  // namespace raft::neighbors::ivf_flat::detail
@@ -16,17 +16,23 @@
 
 #pragma once
 
+#include <raft/core/resource/comms.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/cuda_stream_pool.hpp>
 #include <raft/core/resource/device_memory_resource.hpp>
 #include <raft/spatial/knn/detail/ann_utils.cuh>
 
 #include <raft/neighbors/detail/ivf_pq_codepacking.cuh>
+#include <raft/neighbors/detail/ivf_remove.cuh>
 #include <raft/neighbors/ivf_list.hpp>
 #include <raft/neighbors/ivf_pq_types.hpp>
 
 #include <raft/cluster/kmeans_balanced.cuh>
+#include <raft/core/comms.hpp>
 #include <raft/core/device_mdarray.hpp>
 #include <raft/core/logger.hpp>
+#include <raft/core/memory_estimate.hpp>
+#include <raft/core/metrics.hpp>
 #include <raft/core/nvtx.hpp>
 #include <raft/core/operators.hpp>
 #include <raft/core/resources.hpp>
@@ -36,6 +42,7 @@
 #include <raft/linalg/gemm.cuh>
 #include <raft/linalg/map.cuh>
 #include <raft/linalg/norm.cuh>
+#include <raft/linalg/svd.cuh>
 #include <raft/linalg/unary_op.cuh>
 #include <raft/matrix/gather.cuh>
 #include <raft/matrix/linewise_op.cuh>
@@ -48,16 +55,24 @@
 #include <raft/util/vectorized.cuh>
 
 #include <rmm/cuda_stream_view.hpp>
+#include <rmm/device_scalar.hpp>
 #include <rmm/device_uvector.hpp>
 #include <rmm/mr/device/managed_memory_resource.hpp>
 #include <rmm/mr/device/per_device_resource.hpp>
 #include <rmm/mr/device/pool_memory_resource.hpp>
 
 #include <thrust/extrema.h>
+#include <thrust/gather.h>
 #include <thrust/scan.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
 
+#include <cmath>
 #include <memory>
+#include <optional>
+#include <tuple>
 #include <variant>
+#include <vector>
 
 namespace raft::neighbors::ivf_pq::detail {
 
@@ -155,6 +170,167 @@ inline void make_rotation_matrix(raft::resources const& handle,
   }
 }
 
+/**
+ * @brief Learn the rotation matrix by the (non-parametric) optimized product quantization (OPQ).
+ *
+ * Starting from the given `rotation_matrix`, the algorithm alternates the two steps:
+ *
+ *   1. Train the PQ codebooks (one per subspace) on the rotated residuals `Y = X R^T` and compute
+ *      their reconstruction `Y'` (every subvector is replaced by its closest codebook entry).
+ *   2. Solve the orthogonal Procrustes problem `R = argmin |X R^T - Y'|` given the SVD
+ *      `Y'^T X = U S V^T`: `R = U V^T`.
+ *
+ * Here `X` are the residuals of the (subsampled) trainset w.r.t. their cluster centers. Neither
+ * step increases the quantization error, so the learned rotation yields a smaller error than the
+ * initial one. Note, the per-subspace codebooks are learned here regardless of the
+ * `codebook_kind`; the final codebooks are trained after the rotation is fixed.
+ */
+template <typename IdxT>
+void train_rotation_opq(raft::resources const& handle,
+                        const index<IdxT>& index,
+                        uint32_t n_iters,
+                        uint32_t kmeans_n_iters,
+                        size_t n_rows_train,
+                        const float* trainset,         // [n_rows_train, dim]
+                        const uint32_t* labels,        // [n_rows_train]
+                        const float* cluster_centers,  // [n_lists, dim]
+                        float* rotation_matrix,        // [rot_dim, dim]
+                        rmm::mr::device_memory_resource* device_memory)
+{
+  // The rows beyond this limit do not improve the rotation noticeably, but keep the memory usage
+  // and the cost of the codebook training per iteration in check.
+  constexpr size_t kMaxRows = 65536;
+  const uint32_t n_rows     = std::min(n_rows_train, kMaxRows);
+  const size_t row_stride   = n_rows_train / n_rows;
+  const uint32_t dim        = index.dim();
+  const uint32_t rot_dim    = index.rot_dim();
+  const uint32_t pq_len     = index.pq_len();
+  const uint32_t book_size  = index.pq_book_size();
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "ivf_pq::train_rotation_opq(%u iters, %u rows)", n_iters, n_rows);
+  auto stream = resource::get_cuda_stream(handle);
+
+  // Residuals of a subsample of the trainset
+  rmm::device_uvector<float> residuals(size_t(n_rows) * size_t(dim), stream, device_memory);
+  linalg::map_offset(
+    handle,
+    raft::make_device_vector_view<float, size_t>(residuals.data(), residuals.size()),
+    [trainset, labels, cluster_centers, dim, row_stride] __device__(size_t i) {
+      const size_t row = (i / dim) * row_stride;
+      const size_t col = i % dim;
+      return trainset[row * dim + col] - cluster_centers[size_t(labels[row]) * dim + col];
+    });
+
+  rmm::device_uvector<float> rotated(size_t(n_rows) * size_t(rot_dim), stream, device_memory);
+  rmm::device_uvector<float> sub_data(size_t(n_rows) * size_t(pq_len), stream, device_memory);
+  rmm::device_uvector<float> sub_centers(size_t(book_size) * size_t(pq_len), stream, device_memory);
+  rmm::device_uvector<uint32_t> sub_labels(n_rows, stream, device_memory);
+  rmm::device_uvector<uint32_t> sub_sizes(book_size, stream, device_memory);
+  rmm::device_uvector<float> cross(size_t(rot_dim) * size_t(dim), stream, device_memory);
+  rmm::device_uvector<float> sing_vals(dim, stream, device_memory);
+  rmm::device_uvector<float> left_vecs(size_t(rot_dim) * size_t(dim), stream, device_memory);
+  rmm::device_uvector<float> right_vecs_t(size_t(dim) * size_t(dim), stream, device_memory);
+
+  raft::cluster::kmeans_balanced_params kmeans_params;
+  kmeans_params.n_iters = kmeans_n_iters;
+  kmeans_params.metric  = raft::distance::DistanceType::L2Expanded;
+
+  float alpha = 1.0;
+  float beta  = 0.0;
+  for (uint32_t iter = 0; iter < n_iters; iter++) {
+    // Y = X R^T  [n_rows, rot_dim]
+    linalg::gemm(handle,
+                 true,
+                 false,
+                 rot_dim,
+                 n_rows,
+                 dim,
+                 &alpha,
+                 rotation_matrix,
+                 dim,
+                 residuals.data(),
+                 dim,
+                 &beta,
+                 rotated.data(),
+                 rot_dim,
+                 stream);
+
+    // Y -> Y': quantize every subspace in-place
+    for (uint32_t j = 0; j < index.pq_dim(); j++) {
+      RAFT_CUDA_TRY(cudaMemcpy2DAsync(sub_data.data(),
+                                      sizeof(float) * pq_len,
+                                      rotated.data() + j * pq_len,
+                                      sizeof(float) * rot_dim,
+                                      sizeof(float) * pq_len,
+                                      n_rows,
+                                      cudaMemcpyDefault,
+                                      stream));
+      raft::cluster::kmeans_balanced::helpers::build_clusters(
+        handle,
+        kmeans_params,
+        raft::make_device_matrix_view<const float, uint32_t>(sub_data.data(), n_rows, pq_len),
+        raft::make_device_matrix_view<float, uint32_t>(sub_centers.data(), book_size, pq_len),
+        raft::make_device_vector_view<uint32_t, uint32_t>(sub_labels.data(), n_rows),
+        raft::make_device_vector_view<uint32_t, uint32_t>(sub_sizes.data(), book_size),
+        utils::mapping<float>{});
+      raft::matrix::gather(
+        sub_centers.data(), pq_len, book_size, sub_labels.data(), n_rows, sub_data.data(), stream);
+      RAFT_CUDA_TRY(cudaMemcpy2DAsync(rotated.data() + j * pq_len,
+                                      sizeof(float) * rot_dim,
+                                      sub_data.data(),
+                                      sizeof(float) * pq_len,
+                                      sizeof(float) * pq_len,
+                                      n_rows,
+                                      cudaMemcpyDefault,
+                                      stream));
+    }
+
+    // Y'^T X  (column-major [rot_dim, dim])
+    linalg::gemm(handle,
+                 false,
+                 true,
+                 rot_dim,
+                 dim,
+                 n_rows,
+                 &alpha,
+                 rotated.data(),
+                 rot_dim,
+                 residuals.data(),
+                 dim,
+                 &beta,
+                 cross.data(),
+                 rot_dim,
+                 stream);
+    linalg::svdQR(handle,
+                  cross.data(),
+                  int(rot_dim),
+                  int(dim),
+                  sing_vals.data(),
+                  left_vecs.data(),
+                  right_vecs_t.data(),
+                  false,
+                  true,
+                  true,
+                  stream);
+    // R = U V^T; the row-major R is stored as the column-major R^T = V U^T
+    linalg::gemm(handle,
+                 true,
+                 true,
+                 dim,
+                 rot_dim,
+                 dim,
+                 &alpha,
+                 right_vecs_t.data(),
+                 dim,
+                 left_vecs.data(),
+                 rot_dim,
+                 &beta,
+                 rotation_matrix,
+                 dim,
+                 stream);
+  }
+}
+
 /**
  * @brief Compute residual vectors from the source dataset given by selected indices.
  *
@@ -215,6 +391,8 @@ void select_residuals(raft::resources const& handle,
  * The residual has the form
  *  `rotation_matrix %* (dataset[:, :] - centers[labels[:], 0:dim])`
  *
+ * With `normalize`, the dataset rows are normalized on the fly (used by the `CosineExpanded`
+ * metric, see `utils::internal_metric`).
  */
 template <typename T, typename IdxT>
 void flat_compute_residuals(
@@ -225,21 +403,42 @@ void flat_compute_residuals(
   device_matrix_view<const float, uint32_t, row_major> centers,          // [n_lists, dim_ext]
   const T* dataset,                                                      // [n_rows, dim]
   std::variant<uint32_t, const uint32_t*> labels,                        // [n_rows]
-  rmm::mr::device_memory_resource* device_memory)
+  rmm::mr::device_memory_resource* device_memory,
+  bool normalize = false)
 {
   auto stream  = resource::get_cuda_stream(handle);
   auto dim     = rotation_matrix.extent(1);
   auto rot_dim = rotation_matrix.extent(0);
+  // The inverse norms of the rows, if the rows are normalized
+  rmm::device_uvector<float> row_scales(normalize ? n_rows : 0, stream, device_memory);
+  if (normalize) {
+    linalg::map_offset(
+      handle,
+      raft::make_device_vector_view<float, IdxT>(row_scales.data(), n_rows),
+      [dataset, dim] __device__(IdxT row_ix) {
+        const T* row = dataset + size_t(row_ix) * dim;
+        float norm   = 0.0f;
+        for (uint32_t j = 0; j < dim; j++) {
+          const float x = utils::mapping<float>{}(row[j]);
+          norm += x * x;
+        }
+        return norm > 0.0f ? rsqrtf(norm) : 1.0f;
+      });
+  }
+  const float* scales = normalize ? row_scales.data() : nullptr;
   rmm::device_uvector<float> tmp(n_rows * dim, stream, device_memory);
   auto tmp_view = raft::make_device_vector_view<float, IdxT>(tmp.data(), tmp.size());
-  linalg::map_offset(handle, tmp_view, [centers, dataset, labels, dim] __device__(size_t i) {
-    auto row_ix = i / dim;
-    auto el_ix  = i % dim;
-    auto label  = std::holds_alternative<uint32_t>(labels)
-                    ? std::get<uint32_t>(labels)
-                    : std::get<const uint32_t*>(labels)[row_ix];
-    return utils::mapping<float>{}(dataset[i]) - centers(label, el_ix);
-  });
+  linalg::map_offset(
+    handle, tmp_view, [centers, dataset, labels, scales, dim] __device__(size_t i) {
+      auto row_ix = i / dim;
+      auto el_ix  = i % dim;
+      auto label  = std::holds_alternative<uint32_t>(labels)
+                      ? std::get<uint32_t>(labels)
+                      : std::get<const uint32_t*>(labels)[row_ix];
+      auto x      = utils::mapping<float>{}(dataset[i]);
+      if (scales != nullptr) { x *= scales[row_ix]; }
+      return x - centers(label, el_ix);
+    });
 
   float alpha = 1.0f;
   float beta  = 0.0f;
@@ -316,18 +515,17 @@ auto calculate_offsets_and_indices(IdxT n_rows,
 
 template <typename IdxT>
 void transpose_pq_centers(const resources& handle,
-                          index<IdxT>& index,
+                          device_mdspan<float, extent_3d<uint32_t>, row_major> pq_centers,
                           const float* pq_centers_source)
 {
-  auto stream  = resource::get_cuda_stream(handle);
-  auto extents = index.pq_centers().extents();
+  auto extents = pq_centers.extents();
   static_assert(extents.rank() == 3);
   auto extents_source =
     make_extents<uint32_t>(extents.extent(0), extents.extent(2), extents.extent(1));
   auto span_source =
     make_mdspan<const float, uint32_t, row_major, false, true>(pq_centers_source, extents_source);
-  auto pq_centers_view = raft::make_device_vector_view<float, IdxT>(
-    index.pq_centers().data_handle(), index.pq_centers().size());
+  auto pq_centers_view =
+    raft::make_device_vector_view<float, IdxT>(pq_centers.data_handle(), pq_centers.size());
   linalg::map_offset(handle, pq_centers_view, [span_source, extents] __device__(size_t i) {
     uint32_t ii[3];
     for (int r = 2; r > 0; r--) {
@@ -339,6 +537,14 @@ void transpose_pq_centers(const resources& handle,
   });
 }
 
+template <typename IdxT>
+void transpose_pq_centers(const resources& handle,
+                          index<IdxT>& index,
+                          const float* pq_centers_source)
+{
+  transpose_pq_centers<IdxT>(handle, index.pq_centers(), pq_centers_source);
+}
+
 template <typename IdxT>
 void train_per_subset(raft::resources const& handle,
                       index<IdxT>& index,
@@ -347,17 +553,20 @@ void train_per_subset(raft::resources const& handle,
                       const uint32_t* labels,  // [n_rows]
                       uint32_t kmeans_n_iters,
                       rmm::mr::device_memory_resource* managed_memory,
-                      rmm::mr::device_memory_resource* device_memory)
+                      rmm::mr::device_memory_resource* device_memory,
+                      uint32_t part    = 0,
+                      uint32_t n_parts = 1)
 {
   auto stream = resource::get_cuda_stream(handle);
 
   rmm::device_uvector<float> pq_centers_tmp(index.pq_centers().size(), stream, device_memory);
+  if (n_parts > 1) { utils::memzero(pq_centers_tmp.data(), pq_centers_tmp.size(), stream); }
   rmm::device_uvector<float> sub_trainset(n_rows * size_t(index.pq_len()), stream, device_memory);
   rmm::device_uvector<uint32_t> sub_labels(n_rows, stream, device_memory);
 
   rmm::device_uvector<uint32_t> pq_cluster_sizes(index.pq_book_size(), stream, device_memory);
 
-  for (uint32_t j = 0; j < index.pq_dim(); j++) {
+  for (uint32_t j = part; j < index.pq_dim(); j += n_parts) {
     common::nvtx::range<common::nvtx::domain::raft> pq_per_subspace_scope(
       "ivf_pq::build::per_subspace[%u]", j);
 
@@ -428,11 +637,14 @@ void train_per_cluster(raft::resources const& handle,
                        const uint32_t* labels,  // [n_rows]
                        uint32_t kmeans_n_iters,
                        rmm::mr::device_memory_resource* managed_memory,
-                       rmm::mr::device_memory_resource* device_memory)
+                       rmm::mr::device_memory_resource* device_memory,
+                       uint32_t part    = 0,
+                       uint32_t n_parts = 1)
 {
   auto stream = resource::get_cuda_stream(handle);
 
   rmm::device_uvector<float> pq_centers_tmp(index.pq_centers().size(), stream, device_memory);
+  if (n_parts > 1) { utils::memzero(pq_centers_tmp.data(), pq_centers_tmp.size(), stream); }
   rmm::device_uvector<uint32_t> cluster_sizes(index.n_lists(), stream, managed_memory);
   rmm::device_uvector<IdxT> indices_buf(n_rows, stream, device_memory);
   rmm::device_uvector<IdxT> offsets_buf(index.n_lists() + 1, stream, managed_memory);
@@ -457,7 +669,7 @@ void train_per_cluster(raft::resources const& handle,
     size_t(max_cluster_size) * size_t(index.rot_dim()), stream, device_memory);
 
   resource::sync_stream(handle);  // make sure cluster offsets are up-to-date
-  for (uint32_t l = 0; l < index.n_lists(); l++) {
+  for (uint32_t l = part; l < index.n_lists(); l += n_parts) {
     auto cluster_size = cluster_sizes.data()[l];
     if (cluster_size == 0) continue;
     common::nvtx::range<common::nvtx::domain::raft> pq_per_cluster_scope(
@@ -949,16 +1161,60 @@ struct encode_vectors {
   }
 };
 
+/**
+ * An encoding action, which also subtracts the selected codebook entries from the input vectors;
+ * that is, it leaves the errors of the reconstruction of the vectors in place of them, to be
+ * encoded by the residual PQ layer.
+ *
+ * NB: the lanes of a subwarp read a subspace before the first lane updates it (they are
+ * synchronized by the shuffles of `encode_vectors`), and the subspaces are processed one by one.
+ */
+template <uint32_t SubWarpSize, typename IdxT>
+struct encode_and_subtract_vectors {
+  encode_vectors<SubWarpSize, IdxT> encode;
+  device_mdspan<float, extent_3d<IdxT>, row_major> vectors;
+
+  __device__ inline encode_and_subtract_vectors(
+    device_mdspan<const float, extent_3d<uint32_t>, row_major> pq_centers,
+    device_matrix_view<float, IdxT, row_major> in_vectors,
+    codebook_gen codebook_kind,
+    uint32_t cluster_ix)
+    : encode{pq_centers, make_const_mdspan(in_vectors), codebook_kind, cluster_ix},
+      vectors{reinterpret_vectors(in_vectors, pq_centers)}
+  {
+  }
+
+  __device__ inline auto operator()(IdxT i, uint32_t j) -> uint8_t
+  {
+    const uint8_t code = encode(i, j);
+    const uint32_t partition_ix =
+      encode.codebook_kind == codebook_gen::PER_CLUSTER ? encode.cluster_ix : j;
+    if (Pow2<SubWarpSize>::mod(laneId()) == 0) {
+      for (uint32_t k = 0; k < vectors.extent(2); k++) {
+        vectors(i, j, k) -= encode.pq_centers(partition_ix, k, code);
+      }
+    }
+    return code;
+  }
+};
+
+/**
+ * Encode the new vectors and write them into the lists (one vector per subwarp).
+ *
+ * With the residual PQ layer, the in-list positions of the vectors are written to `out_positions`,
+ * and the vectors (residuals) are replaced by the errors of their reconstruction.
+ */
 template <uint32_t BlockSize, uint32_t PqBits, typename IdxT>
 __launch_bounds__(BlockSize) __global__ void process_and_fill_codes_kernel(
-  device_matrix_view<const float, IdxT, row_major> new_vectors,
+  device_matrix_view<float, IdxT, row_major> new_vectors,
   std::variant<IdxT, const IdxT*> src_offset_or_indices,
   const uint32_t* new_labels,
   device_vector_view<uint32_t, uint32_t, row_major> list_sizes,
   device_vector_view<IdxT*, uint32_t, row_major> inds_ptrs,
   device_vector_view<uint8_t*, uint32_t, row_major> data_ptrs,
   device_mdspan<const float, extent_3d<uint32_t>, row_major> pq_centers,
-  codebook_gen codebook_kind)
+  codebook_gen codebook_kind,
+  uint32_t* out_positions)
 {
   constexpr uint32_t kSubWarpSize = std::min<uint32_t>(WarpSize, 1u << PqBits);
   using subwarp_align             = Pow2<kSubWarpSize>;
@@ -986,12 +1242,102 @@ __launch_bounds__(BlockSize) __global__ void process_and_fill_codes_kernel(
   auto pq_extents = list_spec<uint32_t, IdxT>{PqBits, pq_dim, true}.make_list_extents(out_ix + 1);
   auto pq_dataset =
     make_mdspan<uint8_t, uint32_t, row_major, false, true>(data_ptrs[cluster_ix], pq_extents);
-  write_vector<PqBits, kSubWarpSize>(
-    pq_dataset,
-    out_ix,
-    row_ix,
-    pq_dim,
-    encode_vectors<kSubWarpSize, IdxT>{pq_centers, new_vectors, codebook_kind, cluster_ix});
+  if (out_positions == nullptr) {
+    auto encode_action = encode_vectors<kSubWarpSize, IdxT>{
+      pq_centers, make_const_mdspan(new_vectors), codebook_kind, cluster_ix};
+    write_vector<PqBits, kSubWarpSize>(pq_dataset, out_ix, row_ix, pq_dim, encode_action);
+  } else {
+    if (lane_id == 0) { out_positions[row_ix] = out_ix; }
+    auto encode_action = encode_and_subtract_vectors<kSubWarpSize, IdxT>{
+      pq_centers, new_vectors, codebook_kind, cluster_ix};
+    write_vector<PqBits, kSubWarpSize>(pq_dataset, out_ix, row_ix, pq_dim, encode_action);
+  }
+}
+
+/**
+ * Encode the reconstruction errors of the new vectors with the residual codebook and write them
+ * into the residual lists, at the positions of the vectors in the lists (one vector per subwarp).
+ */
+template <uint32_t BlockSize, uint32_t PqBits, typename IdxT>
+__launch_bounds__(BlockSize) __global__ void fill_residual_codes_kernel(
+  device_matrix_view<const float, IdxT, row_major> new_residuals,
+  const uint32_t* new_labels,
+  const uint32_t* positions,
+  device_vector_view<uint8_t*, uint32_t, row_major> residual_data_ptrs,
+  device_mdspan<const float, extent_3d<uint32_t>, row_major> residual_pq_centers)
+{
+  constexpr uint32_t kSubWarpSize = std::min<uint32_t>(WarpSize, 1u << PqBits);
+  using subwarp_align             = Pow2<kSubWarpSize>;
+  const IdxT row_ix = subwarp_align::div(IdxT{threadIdx.x} + IdxT{BlockSize} * IdxT{blockIdx.x});
+  if (row_ix >= new_residuals.extent(0)) { return; }
+
+  const uint32_t cluster_ix = new_labels[row_ix];
+  const uint32_t out_ix     = positions[row_ix];
+  const uint32_t pq_dim     = new_residuals.extent(1) / residual_pq_centers.extent(1);
+  auto pq_extents = list_spec<uint32_t, IdxT>{PqBits, pq_dim, true}.make_list_extents(out_ix + 1);
+  auto pq_dataset = make_mdspan<uint8_t, uint32_t, row_major, false, true>(
+    residual_data_ptrs[cluster_ix], pq_extents);
+  auto encode_action = encode_vectors<kSubWarpSize, IdxT>{
+    residual_pq_centers, new_residuals, codebook_gen::PER_SUBSPACE, 0};
+  write_vector<PqBits, kSubWarpSize>(pq_dataset, out_ix, row_ix, pq_dim, encode_action);
+}
+
+/**
+ * Replace the vectors (residuals) by the errors of their reconstruction with the codebook
+ * (one vector per subwarp); used to make the trainset of the residual PQ layer.
+ */
+template <uint32_t BlockSize, uint32_t PqBits, typename IdxT>
+__launch_bounds__(BlockSize) __global__ void subtract_codes_kernel(
+  device_matrix_view<float, IdxT, row_major> vectors,
+  std::variant<uint32_t, const uint32_t*> labels,
+  device_mdspan<const float, extent_3d<uint32_t>, row_major> pq_centers,
+  codebook_gen codebook_kind)
+{
+  constexpr uint32_t kSubWarpSize = std::min<uint32_t>(WarpSize, 1u << PqBits);
+  using subwarp_align             = Pow2<kSubWarpSize>;
+  const IdxT row_ix = subwarp_align::div(IdxT{threadIdx.x} + IdxT{BlockSize} * IdxT{blockIdx.x});
+  if (row_ix >= vectors.extent(0)) { return; }
+
+  const uint32_t pq_dim = vectors.extent(1) / pq_centers.extent(1);
+  const uint32_t label  = std::holds_alternative<uint32_t>(labels)
+                            ? std::get<uint32_t>(labels)
+                            : std::get<const uint32_t*>(labels)[row_ix];
+  auto action =
+    encode_and_subtract_vectors<kSubWarpSize, IdxT>{pq_centers, vectors, codebook_kind, label};
+  for (uint32_t j = 0; j < pq_dim; j++) {
+    action(row_ix, j);
+  }
+}
+
+/**
+ * Replace the rotated residuals by the errors of their reconstruction with the PQ codebook of the
+ * index (the first layer).
+ */
+template <typename IdxT, typename RowT>
+void subtract_codes(raft::resources const& res,
+                    const index<IdxT>& index,
+                    device_matrix_view<float, RowT, row_major> vectors,
+                    std::variant<uint32_t, const uint32_t*> labels)
+{
+  const RowT n_rows = vectors.extent(0);
+  if (n_rows == 0) { return; }
+  constexpr uint32_t kBlockSize  = 256;
+  const uint32_t threads_per_vec = std::min<uint32_t>(WarpSize, index.pq_book_size());
+  dim3 blocks(div_rounding_up_safe<size_t>(n_rows, kBlockSize / threads_per_vec), 1, 1);
+  dim3 threads(kBlockSize, 1, 1);
+  auto kernel = [](uint32_t pq_bits) {
+    switch (pq_bits) {
+      case 4: return subtract_codes_kernel<kBlockSize, 4, RowT>;
+      case 5: return subtract_codes_kernel<kBlockSize, 5, RowT>;
+      case 6: return subtract_codes_kernel<kBlockSize, 6, RowT>;
+      case 7: return subtract_codes_kernel<kBlockSize, 7, RowT>;
+      case 8: return subtract_codes_kernel<kBlockSize, 8, RowT>;
+      default: RAFT_FAIL("Invalid pq_bits (%u), the value must be within [4, 8]", pq_bits);
+    }
+  }(index.pq_bits());
+  kernel<<<blocks, threads, 0, resource::get_cuda_stream(res)>>>(
+    vectors, labels, index.pq_centers(), index.codebook_kind());
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
 }
 
 template <uint32_t BlockSize, uint32_t PqBits>
@@ -1033,7 +1379,8 @@ void encode_list_data(raft::resources const& res,
                                       index->centers(),
                                       new_vectors.data_handle(),
                                       label,
-                                      mr);
+                                      mr,
+                                      index->metric() == distance::DistanceType::CosineExpanded);
 
   constexpr uint32_t kBlockSize  = 256;
   const uint32_t threads_per_vec = std::min<uint32_t>(WarpSize, index->pq_book_size());
@@ -1056,6 +1403,33 @@ void encode_list_data(raft::resources const& res,
                                                                  label,
                                                                  offset_or_indices);
   RAFT_CUDA_TRY(cudaPeekAtLastError());
+  if (index->residual_pq_bits() == 0) { return; }
+
+  // Encode the errors of the first layer into the residual list at the same positions
+  subtract_codes<IdxT, uint32_t>(res, *index, new_vectors_residual.view(), label);
+  const uint32_t residual_threads_per_vec =
+    std::min<uint32_t>(WarpSize, index->residual_pq_book_size());
+  dim3 residual_blocks(
+    div_rounding_up_safe<uint32_t>(n_rows, kBlockSize / residual_threads_per_vec), 1, 1);
+  auto residual_kernel = [](uint32_t pq_bits) {
+    switch (pq_bits) {
+      case 4: return encode_list_data_kernel<kBlockSize, 4>;
+      case 5: return encode_list_data_kernel<kBlockSize, 5>;
+      case 6: return encode_list_data_kernel<kBlockSize, 6>;
+      case 7: return encode_list_data_kernel<kBlockSize, 7>;
+      case 8: return encode_list_data_kernel<kBlockSize, 8>;
+      default:
+        RAFT_FAIL("Invalid residual_pq_bits (%u), the value must be within [4, 8]", pq_bits);
+    }
+  }(index->residual_pq_bits());
+  residual_kernel<<<residual_blocks, threads, 0, resource::get_cuda_stream(res)>>>(
+    index->residual_lists()[label]->data.view(),
+    new_vectors_residual.view(),
+    index->residual_pq_centers(),
+    codebook_gen::PER_SUBSPACE,
+    label,
+    offset_or_indices);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
 }
 
 /**
@@ -1104,7 +1478,8 @@ void process_and_fill_codes(raft::resources const& handle,
                                   index.centers(),
                                   new_vectors,
                                   new_labels,
-                                  mr);
+                                  mr,
+                                  index.metric() == distance::DistanceType::CosineExpanded);
 
   constexpr uint32_t kBlockSize  = 256;
   const uint32_t threads_per_vec = std::min<uint32_t>(WarpSize, index.pq_book_size());
@@ -1120,15 +1495,125 @@ void process_and_fill_codes(raft::resources const& handle,
       default: RAFT_FAIL("Invalid pq_bits (%u), the value must be within [4, 8]", pq_bits);
     }
   }(index.pq_bits());
-  kernel<<<blocks, threads, 0, resource::get_cuda_stream(handle)>>>(new_vectors_residual.view(),
-                                                                    src_offset_or_indices,
-                                                                    new_labels,
-                                                                    index.list_sizes(),
-                                                                    index.inds_ptrs(),
-                                                                    index.data_ptrs(),
-                                                                    index.pq_centers(),
-                                                                    index.codebook_kind());
+  // With the residual layer, the in-list positions of the new records are kept for its codes.
+  rmm::device_uvector<uint32_t> positions(
+    index.residual_pq_bits() > 0 ? n_rows : 0, resource::get_cuda_stream(handle), mr);
+  kernel<<<blocks, threads, 0, resource::get_cuda_stream(handle)>>>(
+    new_vectors_residual.view(),
+    src_offset_or_indices,
+    new_labels,
+    index.list_sizes(),
+    index.inds_ptrs(),
+    index.data_ptrs(),
+    index.pq_centers(),
+    index.codebook_kind(),
+    index.residual_pq_bits() > 0 ? positions.data() : nullptr);
   RAFT_CUDA_TRY(cudaPeekAtLastError());
+  if (index.residual_pq_bits() == 0) { return; }
+
+  const uint32_t residual_threads_per_vec =
+    std::min<uint32_t>(WarpSize, index.residual_pq_book_size());
+  dim3 residual_blocks(
+    div_rounding_up_safe<IdxT>(n_rows, kBlockSize / residual_threads_per_vec), 1, 1);
+  auto residual_kernel = [](uint32_t pq_bits) {
+    switch (pq_bits) {
+      case 4: return fill_residual_codes_kernel<kBlockSize, 4, IdxT>;
+      case 5: return fill_residual_codes_kernel<kBlockSize, 5, IdxT>;
+      case 6: return fill_residual_codes_kernel<kBlockSize, 6, IdxT>;
+      case 7: return fill_residual_codes_kernel<kBlockSize, 7, IdxT>;
+      case 8: return fill_residual_codes_kernel<kBlockSize, 8, IdxT>;
+      default: RAFT_FAIL("Invalid residual_pq_bits (%u), the value must be within [4, 8]", pq_bits);
+    }
+  }(index.residual_pq_bits());
+  residual_kernel<<<residual_blocks, threads, 0, resource::get_cuda_stream(handle)>>>(
+    make_const_mdspan(new_vectors_residual.view()),
+    new_labels,
+    positions.data(),
+    index.residual_data_ptrs(),
+    index.residual_pq_centers());
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+/**
+ * Train the codebook of the residual PQ layer (see `index_params::residual_pq_bits`).
+ *
+ * The trainset of the residual layer is the errors of the reconstruction of the rotated residuals
+ * of the trainset with the trained PQ codebooks; a codebook is trained in every subspace.
+ * In the distributed mode, every rank trains its share of the subspaces and leaves the rest zeroed.
+ */
+template <typename IdxT>
+void train_residual_codebook(raft::resources const& handle,
+                             index<IdxT>& index,
+                             size_t n_rows,
+                             const float* trainset,   // [n_rows, dim]
+                             const uint32_t* labels,  // [n_rows]
+                             uint32_t kmeans_n_iters,
+                             rmm::mr::device_memory_resource* big_memory_resource,
+                             rmm::mr::device_memory_resource* device_memory,
+                             uint32_t part    = 0,
+                             uint32_t n_parts = 1)
+{
+  auto stream             = resource::get_cuda_stream(handle);
+  const uint32_t pq_len   = index.pq_len();
+  const uint32_t book_len = index.residual_pq_book_size();
+
+  // The rotated residuals of the trainset, less their PQ reconstruction
+  rmm::device_uvector<float> errors(n_rows * index.rot_dim(), stream, big_memory_resource);
+  flat_compute_residuals<float, IdxT>(handle,
+                                      errors.data(),
+                                      IdxT(n_rows),
+                                      index.rotation_matrix(),
+                                      index.centers(),
+                                      trainset,
+                                      labels,
+                                      device_memory);
+  subtract_codes<IdxT, IdxT>(
+    handle,
+    index,
+    raft::make_device_matrix_view<float, IdxT>(errors.data(), IdxT(n_rows), index.rot_dim()),
+    labels);
+
+  rmm::device_uvector<float> pq_centers_tmp(
+    index.residual_pq_centers().size(), stream, device_memory);
+  if (n_parts > 1) { utils::memzero(pq_centers_tmp.data(), pq_centers_tmp.size(), stream); }
+  rmm::device_uvector<float> sub_trainset(n_rows * size_t(pq_len), stream, device_memory);
+  rmm::device_uvector<uint32_t> sub_labels(n_rows, stream, device_memory);
+  rmm::device_uvector<uint32_t> pq_cluster_sizes(book_len, stream, device_memory);
+
+  // clone the handle and attached the device memory resource to it
+  const resources new_handle(handle);
+  resource::set_workspace_resource(new_handle, device_memory);
+
+  for (uint32_t j = part; j < index.pq_dim(); j += n_parts) {
+    common::nvtx::range<common::nvtx::domain::raft> pq_per_subspace_scope(
+      "ivf_pq::build::residual_per_subspace[%u]", j);
+    RAFT_CUDA_TRY(cudaMemcpy2DAsync(sub_trainset.data(),
+                                    sizeof(float) * pq_len,
+                                    errors.data() + size_t(pq_len) * j,
+                                    sizeof(float) * index.rot_dim(),
+                                    sizeof(float) * pq_len,
+                                    n_rows,
+                                    cudaMemcpyDefault,
+                                    stream));
+    auto sub_trainset_view =
+      raft::make_device_matrix_view<const float, IdxT>(sub_trainset.data(), n_rows, pq_len);
+    auto centers_tmp_view = raft::make_device_matrix_view<float, IdxT>(
+      pq_centers_tmp.data() + size_t(book_len) * pq_len * j, book_len, pq_len);
+    auto sub_labels_view = raft::make_device_vector_view<uint32_t, IdxT>(sub_labels.data(), n_rows);
+    auto cluster_sizes_view =
+      raft::make_device_vector_view<uint32_t, IdxT>(pq_cluster_sizes.data(), book_len);
+    raft::cluster::kmeans_balanced_params kmeans_params;
+    kmeans_params.n_iters = kmeans_n_iters;
+    kmeans_params.metric  = raft::distance::DistanceType::L2Expanded;
+    raft::cluster::kmeans_balanced::helpers::build_clusters(new_handle,
+                                                            kmeans_params,
+                                                            sub_trainset_view,
+                                                            centers_tmp_view,
+                                                            sub_labels_view,
+                                                            cluster_sizes_view,
+                                                            utils::mapping<float>{});
+  }
+  transpose_pq_centers<IdxT>(handle, index.residual_pq_centers(), pq_centers_tmp.data());
 }
 
 /** Update the state of the dependent index members. */
@@ -1149,6 +1634,12 @@ void recompute_internal_state(const raft::resources& res, index<IdxT>& index)
     copy(&data_ptrs(label), &data_ptr, 1, stream);
     copy(&inds_ptrs(label), &inds_ptr, 1, stream);
   }
+  auto residual_data_ptrs = index.residual_data_ptrs();
+  for (uint32_t label = 0; label < index.residual_lists().size(); label++) {
+    auto& list          = index.residual_lists()[label];
+    const auto data_ptr = list ? list->data.data_handle() : nullptr;
+    copy(&residual_data_ptrs(label), &data_ptr, 1, stream);
+  }
 
   // Sort the cluster sizes in the descending order.
   int begin_bit             = 0;
@@ -1206,7 +1697,13 @@ auto extend_list_prepare(raft::resources const& res,
   auto spec = list_spec<uint32_t, IdxT>{
     index->pq_bits(), index->pq_dim(), index->conservative_memory_allocation()};
   auto& list = index->lists()[label];
-  ivf::resize_list(res, list, spec, new_size, offset);
+  ivf::resize_list(res, list, spec, new_size, offset, index->list_arena());
+  if (index->residual_pq_bits() > 0) {
+    auto residual_spec = list_spec<uint32_t, IdxT>{
+      index->residual_pq_bits(), index->pq_dim(), index->conservative_memory_allocation()};
+    ivf::resize_list(
+      res, index->residual_lists()[label], residual_spec, new_size, offset, index->list_arena());
+  }
   copy(list->indices.data_handle() + offset,
        new_indices.data_handle(),
        n_rows,
@@ -1226,6 +1723,8 @@ void extend_list_with_codes(raft::resources const& res,
                             device_vector_view<const IdxT, uint32_t, row_major> new_indices,
                             uint32_t label)
 {
+  RAFT_EXPECTS(index->residual_pq_bits() == 0,
+               "extend_list_with_codes is not supported by the indices with the residual PQ layer");
   // Allocate memory and write indices
   auto offset = extend_list_prepare(res, index, new_indices, label);
   // Pack the data
@@ -1263,7 +1762,68 @@ void erase_list(raft::resources const& res, index<IdxT>* index, uint32_t label)
   uint32_t zero = 0;
   copy(index->list_sizes().data_handle() + label, &zero, 1, resource::get_cuda_stream(res));
   index->lists()[label].reset();
+  if (index->residual_pq_bits() > 0) { index->residual_lists()[label].reset(); }
+  recompute_internal_state(res, *index);
+}
+
+/**
+ * Remove the records with the given source indices from the index.
+ * See the public interface for the api and usage.
+ */
+template <typename IdxT>
+auto remove(raft::resources const& res,
+            raft::device_vector_view<const IdxT, IdxT> ids,
+            index<IdxT>* index) -> IdxT
+{
+  auto stream        = resource::get_cuda_stream(res);
+  auto spec          = list_spec<uint32_t, IdxT>{
+    index->pq_bits(), index->pq_dim(), index->conservative_memory_allocation()};
+  auto residual_spec = list_spec<uint32_t, IdxT>{
+    index->residual_pq_bits(), index->pq_dim(), index->conservative_memory_allocation()};
+  auto n_removed = ivf::detail::remove_records(
+    res,
+    index->inds_ptrs().data_handle(),
+    index->list_sizes().data_handle(),
+    index->n_lists(),
+    ids,
+    [&](uint32_t label, const uint32_t* kept, uint32_t new_size) {
+      auto& list = index->lists()[label];
+      if (new_size == 0) {
+        if (index->residual_pq_bits() > 0) { index->residual_lists()[label].reset(); }
+        return list.reset();
+      }
+      // The compacted list is a new one, because the old one may be shared with a clone.
+      auto new_list = std::make_shared<list_data<IdxT>>(res, spec, new_size, index->list_arena());
+      auto codes    = make_device_matrix<uint8_t, uint32_t>(res, new_size, index->pq_dim());
+      unpack_list_data(codes.view(), list->data.view(), kept, index->pq_bits(), stream);
+      pack_list_data(new_list->data.view(),
+                     make_const_mdspan(codes.view()),
+                     uint32_t{0},
+                     index->pq_bits(),
+                     stream);
+      thrust::gather(resource::get_thrust_policy(res),
+                     kept,
+                     kept + new_size,
+                     list->indices.data_handle(),
+                     new_list->indices.data_handle());
+      list = std::move(new_list);
+      if (index->residual_pq_bits() == 0) { return; }
+      // The residual codes are compacted the same way
+      auto& residual_list = index->residual_lists()[label];
+      auto new_residual_list =
+        std::make_shared<list_data<IdxT>>(res, residual_spec, new_size, index->list_arena());
+      unpack_list_data(
+        codes.view(), residual_list->data.view(), kept, index->residual_pq_bits(), stream);
+      pack_list_data(new_residual_list->data.view(),
+                     make_const_mdspan(codes.view()),
+                     uint32_t{0},
+                     index->residual_pq_bits(),
+                     stream);
+      residual_list = std::move(new_residual_list);
+    });
+  // Update the pointers and the sizes
   recompute_internal_state(res, *index);
+  return static_cast<IdxT>(n_removed);
 }
 
 /** Copy the state of an index into a new index, but share the list data among the two. */
@@ -1279,7 +1839,9 @@ auto clone(const raft::resources& res, const index<IdxT>& source) -> index<IdxT>
                      source.n_lists(),
                      source.dim(),
                      source.pq_bits(),
-                     source.pq_dim());
+                     source.pq_dim(),
+                     source.conservative_memory_allocation(),
+                     source.residual_pq_bits());
 
   // Copy the independent parts
   copy(target.list_sizes().data_handle(),
@@ -1302,9 +1864,15 @@ auto clone(const raft::resources& res, const index<IdxT>& source) -> index<IdxT>
        source.centers_rot().data_handle(),
        source.centers_rot().size(),
        stream);
+  copy(target.residual_pq_centers().data_handle(),
+       source.residual_pq_centers().data_handle(),
+       source.residual_pq_centers().size(),
+       stream);
 
   // Copy shared pointers
-  target.lists() = source.lists();
+  target.lists()          = source.lists();
+  target.residual_lists() = source.residual_lists();
+  target.list_arena()     = source.list_arena();
 
   // Make sure the device pointers point to the new lists
   recompute_internal_state(res, target);
@@ -1312,6 +1880,249 @@ auto clone(const raft::resources& res, const index<IdxT>& source) -> index<IdxT>
   return target;
 }
 
+/**
+ * Shrink the lists of the index to fit their sizes.
+ * See the public interface for the api and usage.
+ */
+template <typename IdxT>
+void compact(raft::resources const& res, index<IdxT>* index)
+{
+  auto spec = list_spec<uint32_t, IdxT>{index->pq_bits(), index->pq_dim(), true};
+  // The lists are moved into a new arena of the same chunk size, the old one is released with
+  // the last of the old lists.
+  auto& arena = index->list_arena();
+  if (arena) { arena = std::make_shared<ivf::list_arena>(arena->chunk_size()); }
+  auto n_freed = ivf::compact_lists(res, index->lists(), spec, arena);
+  RAFT_LOG_DEBUG("ivf_pq::compact: freed the space of %zu records", n_freed);
+  if (index->residual_pq_bits() > 0) {
+    auto residual_spec =
+      list_spec<uint32_t, IdxT>{index->residual_pq_bits(), index->pq_dim(), true};
+    ivf::compact_lists(res, index->residual_lists(), residual_spec, arena);
+  }
+  // Update the pointers and the sizes
+  recompute_internal_state(res, *index);
+}
+
+/**
+ * Split the overloaded lists of the index and shrink all lists to fit their sizes.
+ * See the public interface for the api and usage.
+ */
+template <typename IdxT>
+void rebalance(raft::resources const& res,
+               index<IdxT>* index,
+               double max_list_size_ratio,
+               uint32_t kmeans_n_iters)
+{
+  RAFT_EXPECTS(max_list_size_ratio > 1.0, "max_list_size_ratio must be greater than one.");
+  RAFT_EXPECTS(index->residual_pq_bits() == 0,
+               "rebalance is not supported by the indices with the residual PQ layer");
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "ivf_pq::rebalance(%zu, %u)", size_t(index->size()), index->n_lists());
+  auto stream        = resource::get_cuda_stream(res);
+  auto policy        = resource::get_thrust_policy(res);
+  const auto n_lists = index->n_lists();
+
+  std::vector<uint32_t> list_sizes(n_lists);
+  copy(list_sizes.data(), index->list_sizes().data_handle(), n_lists, stream);
+  resource::sync_stream(res);
+
+  // Every overloaded list is split into the parts of about the average list size.
+  const double avg_size = double(index->size()) / double(n_lists);
+  const uint32_t part_size =
+    std::max<uint32_t>(static_cast<uint32_t>(std::ceil(avg_size)), kIndexGroupSize);
+  std::vector<std::tuple<uint32_t, uint32_t>> splits;  // (label, n_parts)
+  uint32_t n_new_lists = 0;
+  for (uint32_t label = 0; label < n_lists; label++) {
+    auto size = list_sizes[label];
+    if (double(size) <= max_list_size_ratio * avg_size || size < 2 * part_size) { continue; }
+    auto n_parts = raft::div_rounding_up_safe<uint32_t>(size, part_size);
+    splits.emplace_back(label, n_parts);
+    n_new_lists += n_parts - 1;
+  }
+  RAFT_LOG_DEBUG("ivf_pq::rebalance: splitting %zu lists into %u new ones",
+                 splits.size(),
+                 n_new_lists + uint32_t(splits.size()));
+  if (splits.empty()) { return compact(res, index); }
+
+  // Allocate the new index; the new lists are appended after the existing ones.
+  ivf_pq::index<IdxT> target(res,
+                             index->metric(),
+                             index->codebook_kind(),
+                             n_lists + n_new_lists,
+                             index->dim(),
+                             index->pq_bits(),
+                             index->pq_dim(),
+                             index->conservative_memory_allocation());
+  RAFT_CUDA_TRY(cudaMemsetAsync(
+    target.list_sizes().data_handle(), 0, target.list_sizes().size() * sizeof(uint32_t), stream));
+  copy(target.list_sizes().data_handle(), index->list_sizes().data_handle(), n_lists, stream);
+  copy(target.rotation_matrix().data_handle(),
+       index->rotation_matrix().data_handle(),
+       index->rotation_matrix().size(),
+       stream);
+  copy(target.pq_centers().data_handle(),
+       index->pq_centers().data_handle(),
+       index->pq_centers().size(),
+       stream);
+  copy(target.centers().data_handle(),
+       index->centers().data_handle(),
+       index->centers().size(),
+       stream);
+  copy(target.centers_rot().data_handle(),
+       index->centers_rot().data_handle(),
+       index->centers_rot().size(),
+       stream);
+  for (uint32_t label = 0; label < n_lists; label++) {
+    target.lists()[label] = index->lists()[label];
+  }
+
+  raft::cluster::kmeans_balanced_params kmeans_params;
+  kmeans_params.n_iters = kmeans_n_iters;
+  kmeans_params.metric  = utils::internal_metric(index->metric());
+
+  const uint32_t dim      = index->dim();
+  const size_t book_size  = size_t(index->pq_len()) * size_t(index->pq_book_size());
+  uint32_t next_new_label = n_lists;
+  for (auto [label, n_parts] : splits) {
+    const uint32_t size = list_sizes[label];
+    // Decode the list and split it with a local balanced k-means
+    auto vectors = make_device_matrix<float, uint32_t>(res, size, dim);
+    reconstruct_list_data<float, IdxT>(res, *index, vectors.view(), label, uint32_t{0});
+    auto part_centers = make_device_matrix<float, uint32_t>(res, n_parts, dim);
+    auto part_labels  = make_device_vector<uint32_t, uint32_t>(res, size);
+    raft::cluster::kmeans_balanced::fit(res,
+                                        kmeans_params,
+                                        make_const_mdspan(vectors.view()),
+                                        part_centers.view(),
+                                        utils::mapping<float>{});
+    raft::cluster::kmeans_balanced::predict(res,
+                                            kmeans_params,
+                                            make_const_mdspan(vectors.view()),
+                                            make_const_mdspan(part_centers.view()),
+                                            part_labels.view(),
+                                            utils::mapping<float>{});
+
+    // The first part keeps the label of the split list, the rest get the new consecutive labels.
+    auto part_label = [label = label, next_new_label](uint32_t part) {
+      return part == 0 ? label : next_new_label + part - 1;
+    };
+
+    // Combine the part centers and their norms, rotate the centers
+    auto part_centers_ext = make_device_matrix<float, uint32_t>(res, n_parts, index->dim_ext());
+    auto part_centers_rot = make_device_matrix<float, uint32_t>(res, n_parts, index->rot_dim());
+    RAFT_CUDA_TRY(cudaMemcpy2DAsync(part_centers_ext.data_handle(),
+                                    sizeof(float) * index->dim_ext(),
+                                    part_centers.data_handle(),
+                                    sizeof(float) * dim,
+                                    sizeof(float) * dim,
+                                    n_parts,
+                                    cudaMemcpyDefault,
+                                    stream));
+    auto part_norms = make_device_vector<float, uint32_t>(res, n_parts);
+    raft::linalg::rowNorm(part_norms.data_handle(),
+                          part_centers.data_handle(),
+                          dim,
+                          n_parts,
+                          raft::linalg::L2Norm,
+                          true,
+                          stream);
+    RAFT_CUDA_TRY(cudaMemcpy2DAsync(part_centers_ext.data_handle() + dim,
+                                    sizeof(float) * index->dim_ext(),
+                                    part_norms.data_handle(),
+                                    sizeof(float),
+                                    sizeof(float),
+                                    n_parts,
+                                    cudaMemcpyDefault,
+                                    stream));
+    float alpha = 1.0;
+    float beta  = 0.0;
+    linalg::gemm(res,
+                 true,
+                 false,
+                 index->rot_dim(),
+                 n_parts,
+                 dim,
+                 &alpha,
+                 index->rotation_matrix().data_handle(),
+                 dim,
+                 part_centers.data_handle(),
+                 dim,
+                 &beta,
+                 part_centers_rot.data_handle(),
+                 index->rot_dim(),
+                 stream);
+    for (uint32_t part = 0; part < n_parts; part++) {
+      auto l = part_label(part);
+      copy(target.centers().data_handle() + size_t(l) * index->dim_ext(),
+           part_centers_ext.data_handle() + size_t(part) * index->dim_ext(),
+           index->dim_ext(),
+           stream);
+      copy(target.centers_rot().data_handle() + size_t(l) * index->rot_dim(),
+           part_centers_rot.data_handle() + size_t(part) * index->rot_dim(),
+           index->rot_dim(),
+           stream);
+      // The new lists inherit the codebook of the split one
+      if (part > 0 && index->codebook_kind() == codebook_gen::PER_CLUSTER) {
+        copy(target.pq_centers().data_handle() + size_t(l) * book_size,
+             index->pq_centers().data_handle() + size_t(label) * book_size,
+             book_size,
+             stream);
+      }
+    }
+
+    // Group the records by their new labels
+    auto order = make_device_vector<uint32_t, uint32_t>(res, size);
+    thrust::sequence(policy, order.data_handle(), order.data_handle() + size);
+    thrust::stable_sort_by_key(policy,
+                               part_labels.data_handle(),
+                               part_labels.data_handle() + size,
+                               order.data_handle());
+    auto sorted_vectors = make_device_matrix<float, uint32_t>(res, size, dim);
+    auto sorted_indices = make_device_vector<IdxT, uint32_t>(res, size);
+    raft::matrix::gather(vectors.data_handle(),
+                         dim,
+                         size,
+                         order.data_handle(),
+                         size,
+                         sorted_vectors.data_handle(),
+                         stream);
+    thrust::gather(policy,
+                   order.data_handle(),
+                   order.data_handle() + size,
+                   index->lists()[label]->indices.data_handle(),
+                   sorted_indices.data_handle());
+    std::vector<uint32_t> sorted_labels(size);
+    copy(sorted_labels.data(), part_labels.data_handle(), size, stream);
+    resource::sync_stream(res);
+
+    // Re-encode the records into the lists of the parts
+    uint32_t zero = 0;
+    copy(target.list_sizes().data_handle() + label, &zero, 1, stream);
+    target.lists()[label].reset();
+    uint32_t offset = 0;
+    for (uint32_t part = 0; part < n_parts; part++) {
+      uint32_t n_part_rows = 0;
+      while (offset + n_part_rows < size && sorted_labels[offset + n_part_rows] == part) {
+        n_part_rows++;
+      }
+      if (n_part_rows == 0) { continue; }
+      extend_list<float, IdxT>(
+        res,
+        &target,
+        make_device_matrix_view<const float, uint32_t>(
+          sorted_vectors.data_handle() + size_t(offset) * dim, n_part_rows, dim),
+        make_device_vector_view<const IdxT, uint32_t>(sorted_indices.data_handle() + offset,
+                                                      n_part_rows),
+        part_label(part));
+      offset += n_part_rows;
+    }
+    next_new_label += n_parts - 1;
+  }
+
+  *index = std::move(target);
+  compact(res, index);
+}
+
 /**
  * Extend the index in-place.
  * See raft::spatial::knn::ivf_pq::extend docs.
@@ -1343,8 +2154,10 @@ void extend(raft::resources const& handle,
     &managed_memory_upstream, 1024 * 1024);
 
   // The spec defines how the clusters look like
-  auto spec = list_spec<uint32_t, IdxT>{
+  auto spec          = list_spec<uint32_t, IdxT>{
     index->pq_bits(), index->pq_dim(), index->conservative_memory_allocation()};
+  auto residual_spec = list_spec<uint32_t, IdxT>{
+    index->residual_pq_bits(), index->pq_dim(), index->conservative_memory_allocation()};
   // Try to allocate an index with the same parameters and the projected new size
   // (which can be slightly larger than index->size() + n_rows, due to padding).
   // If this fails, the index would be too big to fit in the device anyway.
@@ -1379,18 +2192,19 @@ void extend(raft::resources const& handle,
     size_factor += (index->dim() + index->rot_dim()) * sizeof(float);
     // ...and another buffer for indices
     size_factor += sizeof(IdxT);
-    // if the input data is not accessible on device, we'd need a buffer for it.
+    // if the input data is not accessible on device, we'd need a pair of buffers for it
+    // (the next batch is copied while the current one is processed).
     switch (utils::check_pointer_residency(new_vectors)) {
       case utils::pointer_residency::device_only:
       case utils::pointer_residency::host_and_device: break;
-      default: size_factor += index->dim() * sizeof(T);
+      default: size_factor += 2 * index->dim() * sizeof(T);
     }
     // the same with indices
     if (new_indices != nullptr) {
       switch (utils::check_pointer_residency(new_indices)) {
         case utils::pointer_residency::device_only:
         case utils::pointer_residency::host_and_device: break;
-        default: size_factor += sizeof(IdxT);
+        default: size_factor += 2 * sizeof(IdxT);
       }
     }
     // make the batch size fit into the remaining memory
@@ -1410,6 +2224,10 @@ void extend(raft::resources const& handle,
   // Predict the cluster labels for the new data, in batches if necessary
   utils::batch_load_iterator<T> vec_batches(
     new_vectors, n_rows, index->dim(), max_batch_size, stream, batches_mr);
+  // The host data is staged through the pinned buffers: the copy of the next batch in the copy
+  // stream overlaps the prediction and the encoding of the current batch in the main stream.
+  auto copy_stream = resource::get_next_usable_stream(handle);
+  vec_batches.enable_pipelining(copy_stream, batches_mr);
   // Release the placeholder memory, because we don't intend to allocate any more long-living
   // temporary buffers before we allocate the index data.
   // This memory could potentially speed up UVM accesses, if any.
@@ -1435,7 +2253,9 @@ void extend(raft::resources const& handle,
       auto centers_view = raft::make_device_matrix_view<const float, IdxT>(
         cluster_centers.data(), n_clusters, index->dim());
       raft::cluster::kmeans_balanced_params kmeans_params;
-      kmeans_params.metric = index->metric();
+      // NB: the nearest (normalized) center by the inner product does not depend on the norm of
+      //     the row, hence the rows are not normalized for the cosine metric here.
+      kmeans_params.metric = utils::internal_metric(index->metric());
       raft::cluster::kmeans_balanced::predict(handle,
                                               kmeans_params,
                                               batch_data_view,
@@ -1468,8 +2288,20 @@ void extend(raft::resources const& handle,
     copy(old_cluster_sizes.data(), orig_list_sizes.data(), n_clusters, stream);
     resource::sync_stream(handle);
     for (uint32_t label = 0; label < n_clusters; label++) {
-      ivf::resize_list(
-        handle, index->lists()[label], spec, new_cluster_sizes[label], old_cluster_sizes[label]);
+      ivf::resize_list(handle,
+                       index->lists()[label],
+                       spec,
+                       new_cluster_sizes[label],
+                       old_cluster_sizes[label],
+                       index->list_arena());
+      if (index->residual_pq_bits() > 0) {
+        ivf::resize_list(handle,
+                         index->residual_lists()[label],
+                         residual_spec,
+                         new_cluster_sizes[label],
+                         old_cluster_sizes[label],
+                         index->list_arena());
+      }
     }
   }
 
@@ -1483,6 +2315,7 @@ void extend(raft::resources const& handle,
   // Fill the extended index with the new data (possibly, in batches)
   utils::batch_load_iterator<IdxT> idx_batches(
     new_indices, n_rows, 1, max_batch_size, stream, batches_mr);
+  idx_batches.enable_pipelining(copy_stream, batches_mr);
   for (const auto& vec_batch : vec_batches) {
     const auto& idx_batch = *idx_batches++;
     process_and_fill_codes(handle,
@@ -1513,6 +2346,286 @@ auto extend(raft::resources const& handle,
   return ext_index;
 }
 
+/**
+ * Train the coarse clusters, the rotation and the PQ codebooks (including the residual one, if any)
+ * of an index on a sample of the dataset.
+ *
+ * In the distributed mode, every rank of the communicator attached to the handle passes its own
+ * part of the dataset. The coarse clusters are trained by the data-parallel balanced k-means, the
+ * PQ codebooks (subspaces or clusters) are divided among the ranks; all ranks end up with the
+ * same trained index.
+ */
+template <typename T, typename IdxT>
+void train(raft::resources const& handle,
+           const index_params& params,
+           const T* dataset,
+           IdxT n_rows,
+           index<IdxT>& index,
+           bool distributed = false)
+{
+  auto stream = resource::get_cuda_stream(handle);
+  std::optional<raft::metrics::phase> phase;
+  phase.emplace("ivf_pq::build::trainset", stream);
+
+  auto trainset_ratio = std::max<size_t>(
+    1,
+    size_t(n_rows) / std::max<size_t>(params.kmeans_trainset_fraction * n_rows, index.n_lists()));
+  size_t n_rows_train = n_rows / trainset_ratio;
+
+  rmm::mr::device_memory_resource* device_memory = nullptr;
+  auto pool_guard = raft::get_pool_memory_resource(device_memory, 1024 * 1024);
+  if (pool_guard) { RAFT_LOG_DEBUG("ivf_pq::build: using pool memory resource"); }
+
+  rmm::mr::managed_memory_resource managed_memory_upstream;
+  rmm::mr::pool_memory_resource<rmm::mr::managed_memory_resource> managed_memory(
+    &managed_memory_upstream, 1024 * 1024);
+
+  // If the trainset is small enough to comfortably fit into device memory, put it there.
+  // Otherwise, use the managed memory.
+  rmm::mr::device_memory_resource* big_memory_resource = &managed_memory;
+  {
+    size_t free_mem, total_mem;
+    constexpr size_t kTolerableRatio = 4;
+    RAFT_CUDA_TRY(cudaMemGetInfo(&free_mem, &total_mem));
+    if (sizeof(float) * n_rows_train * index.dim() * kTolerableRatio < free_mem) {
+      big_memory_resource = device_memory;
+    }
+  }
+
+  // Besides just sampling, we transform the input dataset into floats to make it easier
+  // to use gemm operations from cublas.
+  rmm::device_uvector<float> trainset(n_rows_train * index.dim(), stream, big_memory_resource);
+  // TODO: a proper sampling
+  if constexpr (std::is_same_v<T, float>) {
+    RAFT_CUDA_TRY(cudaMemcpy2DAsync(trainset.data(),
+                                    sizeof(T) * index.dim(),
+                                    dataset,
+                                    sizeof(T) * index.dim() * trainset_ratio,
+                                    sizeof(T) * index.dim(),
+                                    n_rows_train,
+                                    cudaMemcpyDefault,
+                                    stream));
+  } else {
+    size_t dim = index.dim();
+    if (auto p = utils::device_accessible_pointer(dataset); p != nullptr) {
+      // data is available on device (this includes the pageable host memory on the systems where
+      // the device reads it through the host page tables): just run the kernel to copy and map
+      auto trainset_view =
+        raft::make_device_vector_view<float, IdxT>(trainset.data(), dim * n_rows_train);
+      linalg::map_offset(handle, trainset_view, [p, trainset_ratio, dim] __device__(size_t i) {
+        auto col = i % dim;
+        return utils::mapping<float>{}(p[(i - col) * size_t(trainset_ratio) + col]);
+      });
+    } else {
+      // data is not available: first copy, then map inplace
+      auto trainset_tmp = reinterpret_cast<T*>(reinterpret_cast<uint8_t*>(trainset.data()) +
+                                               (sizeof(float) - sizeof(T)) * index.dim());
+      // We copy the data in strides, one row at a time, and place the smaller rows of type T
+      // at the end of float rows.
+      RAFT_CUDA_TRY(cudaMemcpy2DAsync(trainset_tmp,
+                                      sizeof(float) * index.dim(),
+                                      dataset,
+                                      sizeof(T) * index.dim() * trainset_ratio,
+                                      sizeof(T) * index.dim(),
+                                      n_rows_train,
+                                      cudaMemcpyDefault,
+                                      stream));
+      // Transform the input `{T -> float}`, one row per warp.
+      // The threads in each warp copy the data synchronously; this and the layout of the data
+      // (content is aligned to the end of the rows) together allow doing the transform in-place.
+      copy_warped(trainset.data(),
+                  index.dim(),
+                  trainset_tmp,
+                  index.dim() * sizeof(float) / sizeof(T),
+                  index.dim(),
+                  n_rows_train,
+                  stream);
+    }
+  }
+
+  // The cosine metric is the inner product of the normalized vectors
+  if (index.metric() == distance::DistanceType::CosineExpanded) {
+    utils::normalize_rows<IdxT>(handle, trainset.data(), IdxT(n_rows_train), IdxT(index.dim()));
+  }
+
+  // NB: here cluster_centers is used as if it is [n_clusters, data_dim] not [n_clusters,
+  // dim_ext]!
+  phase.emplace("ivf_pq::build::kmeans", stream);
+  rmm::device_uvector<float> cluster_centers_buf(
+    index.n_lists() * index.dim(), stream, device_memory);
+  auto cluster_centers = cluster_centers_buf.data();
+
+  // Train balanced hierarchical kmeans clustering
+  auto trainset_const_view =
+    raft::make_device_matrix_view<const float, IdxT>(trainset.data(), n_rows_train, index.dim());
+  auto centers_view =
+    raft::make_device_matrix_view<float, IdxT>(cluster_centers, index.n_lists(), index.dim());
+  raft::cluster::kmeans_balanced_params kmeans_params;
+  kmeans_params.n_iters = params.kmeans_n_iters;
+  kmeans_params.metric  = utils::internal_metric(index.metric());
+  if (distributed) {
+    raft::cluster::kmeans_balanced::fit_mg(
+      handle, kmeans_params, trainset_const_view, centers_view, utils::mapping<float>{});
+  } else {
+    raft::cluster::kmeans_balanced::fit(
+      handle, kmeans_params, trainset_const_view, centers_view, utils::mapping<float>{});
+  }
+
+  // Trainset labels are needed for training PQ codebooks
+  rmm::device_uvector<uint32_t> labels(n_rows_train, stream, big_memory_resource);
+  auto centers_const_view = raft::make_device_matrix_view<const float, IdxT>(
+    cluster_centers, index.n_lists(), index.dim());
+  auto labels_view = raft::make_device_vector_view<uint32_t, IdxT>(labels.data(), n_rows_train);
+  raft::cluster::kmeans_balanced::predict(handle,
+                                          kmeans_params,
+                                          trainset_const_view,
+                                          centers_const_view,
+                                          labels_view,
+                                          utils::mapping<float>());
+
+  {
+    // combine cluster_centers and their norms
+    RAFT_CUDA_TRY(cudaMemcpy2DAsync(index.centers().data_handle(),
+                                    sizeof(float) * index.dim_ext(),
+                                    cluster_centers,
+                                    sizeof(float) * index.dim(),
+                                    sizeof(float) * index.dim(),
+                                    index.n_lists(),
+                                    cudaMemcpyDefault,
+                                    stream));
+
+    rmm::device_uvector<float> center_norms(index.n_lists(), stream, device_memory);
+    raft::linalg::rowNorm(center_norms.data(),
+                          cluster_centers,
+                          index.dim(),
+                          index.n_lists(),
+                          raft::linalg::L2Norm,
+                          true,
+                          stream);
+    RAFT_CUDA_TRY(cudaMemcpy2DAsync(index.centers().data_handle() + index.dim(),
+                                    sizeof(float) * index.dim_ext(),
+                                    center_norms.data(),
+                                    sizeof(float),
+                                    sizeof(float),
+                                    index.n_lists(),
+                                    cudaMemcpyDefault,
+                                    stream));
+  }
+
+  // Make rotation matrix
+  phase.emplace("ivf_pq::build::rotation", stream);
+  make_rotation_matrix(handle,
+                       params.force_random_rotation,
+                       index.rot_dim(),
+                       index.dim(),
+                       index.rotation_matrix().data_handle());
+  if (params.opq_n_iters > 0) {
+    train_rotation_opq(handle,
+                       index,
+                       params.opq_n_iters,
+                       params.kmeans_n_iters,
+                       n_rows_train,
+                       trainset.data(),
+                       labels.data(),
+                       cluster_centers,
+                       index.rotation_matrix().data_handle(),
+                       device_memory);
+  }
+  // The rotation is seeded (or learned on the local data), but the ranks must agree on it
+  // bit-for-bit.
+  if (distributed) {
+    resource::get_comms(handle).bcast(
+      index.rotation_matrix().data_handle(), index.rotation_matrix().size(), 0, stream);
+  }
+
+  // Rotate cluster_centers
+  float alpha = 1.0;
+  float beta  = 0.0;
+  linalg::gemm(handle,
+               true,
+               false,
+               index.rot_dim(),
+               index.n_lists(),
+               index.dim(),
+               &alpha,
+               index.rotation_matrix().data_handle(),
+               index.dim(),
+               cluster_centers,
+               index.dim(),
+               &beta,
+               index.centers_rot().data_handle(),
+               index.rot_dim(),
+               stream);
+
+  // Train PQ codebooks; in the distributed mode, every rank trains its share of the codebooks
+  // and leaves the rest zeroed, so that they are combined by a sum.
+  phase.emplace("ivf_pq::build::codebooks", stream);
+  const uint32_t part    = distributed ? resource::get_comms(handle).get_rank() : 0;
+  const uint32_t n_parts = distributed ? resource::get_comms(handle).get_size() : 1;
+  switch (index.codebook_kind()) {
+    case codebook_gen::PER_SUBSPACE:
+      train_per_subset(handle,
+                       index,
+                       n_rows_train,
+                       trainset.data(),
+                       labels.data(),
+                       params.kmeans_n_iters,
+                       &managed_memory,
+                       device_memory,
+                       part,
+                       n_parts);
+      break;
+    case codebook_gen::PER_CLUSTER:
+      train_per_cluster(handle,
+                        index,
+                        n_rows_train,
+                        trainset.data(),
+                        labels.data(),
+                        params.kmeans_n_iters,
+                        &managed_memory,
+                        device_memory,
+                        part,
+                        n_parts);
+      break;
+    default: RAFT_FAIL("Unreachable code");
+  }
+  if (distributed) {
+    const auto& comms = resource::get_comms(handle);
+    comms.allreduce(index.pq_centers().data_handle(),
+                    index.pq_centers().data_handle(),
+                    index.pq_centers().size(),
+                    comms::op_t::SUM,
+                    stream);
+    RAFT_EXPECTS(comms.sync_stream(stream) == comms::status_t::SUCCESS,
+                 "ivf_pq::build_mg: allreduce of the PQ codebooks failed");
+  }
+
+  // Train the codebook of the residual layer on the errors of the trained PQ codebooks
+  if (index.residual_pq_bits() > 0) {
+    phase.emplace("ivf_pq::build::residual_codebook", stream);
+    train_residual_codebook(handle,
+                            index,
+                            n_rows_train,
+                            trainset.data(),
+                            labels.data(),
+                            params.kmeans_n_iters,
+                            big_memory_resource,
+                            device_memory,
+                            part,
+                            n_parts);
+    if (distributed) {
+      const auto& comms = resource::get_comms(handle);
+      comms.allreduce(index.residual_pq_centers().data_handle(),
+                      index.residual_pq_centers().data_handle(),
+                      index.residual_pq_centers().size(),
+                      comms::op_t::SUM,
+                      stream);
+      RAFT_EXPECTS(comms.sync_stream(stream) == comms::status_t::SUCCESS,
+                   "ivf_pq::build_mg: allreduce of the residual PQ codebook failed");
+    }
+  }
+}
+
 /** See raft::spatial::knn::ivf_pq::build docs */
 template <typename T, typename IdxT>
 auto build(raft::resources const& handle,
@@ -1537,199 +2650,174 @@ auto build(raft::resources const& handle,
   utils::memzero(index.data_ptrs().data_handle(), index.data_ptrs().size(), stream);
   utils::memzero(index.inds_ptrs().data_handle(), index.inds_ptrs().size(), stream);
 
-  {
-    auto trainset_ratio = std::max<size_t>(
-      1,
-      size_t(n_rows) / std::max<size_t>(params.kmeans_trainset_fraction * n_rows, index.n_lists()));
-    size_t n_rows_train = n_rows / trainset_ratio;
-
-    rmm::mr::device_memory_resource* device_memory = nullptr;
-    auto pool_guard = raft::get_pool_memory_resource(device_memory, 1024 * 1024);
-    if (pool_guard) { RAFT_LOG_DEBUG("ivf_pq::build: using pool memory resource"); }
-
-    rmm::mr::managed_memory_resource managed_memory_upstream;
-    rmm::mr::pool_memory_resource<rmm::mr::managed_memory_resource> managed_memory(
-      &managed_memory_upstream, 1024 * 1024);
-
-    // If the trainset is small enough to comfortably fit into device memory, put it there.
-    // Otherwise, use the managed memory.
-    rmm::mr::device_memory_resource* big_memory_resource = &managed_memory;
-    {
-      size_t free_mem, total_mem;
-      constexpr size_t kTolerableRatio = 4;
-      RAFT_CUDA_TRY(cudaMemGetInfo(&free_mem, &total_mem));
-      if (sizeof(float) * n_rows_train * index.dim() * kTolerableRatio < free_mem) {
-        big_memory_resource = device_memory;
-      }
-    }
+  train(handle, params, dataset, n_rows, index);
 
-    // Besides just sampling, we transform the input dataset into floats to make it easier
-    // to use gemm operations from cublas.
-    rmm::device_uvector<float> trainset(n_rows_train * index.dim(), stream, big_memory_resource);
-    // TODO: a proper sampling
-    if constexpr (std::is_same_v<T, float>) {
-      RAFT_CUDA_TRY(cudaMemcpy2DAsync(trainset.data(),
-                                      sizeof(T) * index.dim(),
-                                      dataset,
-                                      sizeof(T) * index.dim() * trainset_ratio,
-                                      sizeof(T) * index.dim(),
-                                      n_rows_train,
-                                      cudaMemcpyDefault,
-                                      stream));
-    } else {
-      size_t dim = index.dim();
-      cudaPointerAttributes dataset_attr;
-      RAFT_CUDA_TRY(cudaPointerGetAttributes(&dataset_attr, dataset));
-      if (dataset_attr.devicePointer != nullptr) {
-        // data is available on device: just run the kernel to copy and map the data
-        auto p = reinterpret_cast<T*>(dataset_attr.devicePointer);
-        auto trainset_view =
-          raft::make_device_vector_view<float, IdxT>(trainset.data(), dim * n_rows_train);
-        linalg::map_offset(handle, trainset_view, [p, trainset_ratio, dim] __device__(size_t i) {
-          auto col = i % dim;
-          return utils::mapping<float>{}(p[(i - col) * size_t(trainset_ratio) + col]);
-        });
-      } else {
-        // data is not available: first copy, then map inplace
-        auto trainset_tmp = reinterpret_cast<T*>(reinterpret_cast<uint8_t*>(trainset.data()) +
-                                                 (sizeof(float) - sizeof(T)) * index.dim());
-        // We copy the data in strides, one row at a time, and place the smaller rows of type T
-        // at the end of float rows.
-        RAFT_CUDA_TRY(cudaMemcpy2DAsync(trainset_tmp,
-                                        sizeof(float) * index.dim(),
-                                        dataset,
-                                        sizeof(T) * index.dim() * trainset_ratio,
-                                        sizeof(T) * index.dim(),
-                                        n_rows_train,
-                                        cudaMemcpyDefault,
-                                        stream));
-        // Transform the input `{T -> float}`, one row per warp.
-        // The threads in each warp copy the data synchronously; this and the layout of the data
-        // (content is aligned to the end of the rows) together allow doing the transform in-place.
-        copy_warped(trainset.data(),
-                    index.dim(),
-                    trainset_tmp,
-                    index.dim() * sizeof(float) / sizeof(T),
-                    index.dim(),
-                    n_rows_train,
-                    stream);
-      }
-    }
+  // add the data if necessary
+  if (params.add_data_on_build) {
+    raft::metrics::phase phase("ivf_pq::build::encode", stream);
+    detail::extend<T, IdxT>(handle, &index, dataset, nullptr, n_rows);
+  }
+  return index;
+}
 
-    // NB: here cluster_centers is used as if it is [n_clusters, data_dim] not [n_clusters,
-    // dim_ext]!
-    rmm::device_uvector<float> cluster_centers_buf(
-      index.n_lists() * index.dim(), stream, device_memory);
-    auto cluster_centers = cluster_centers_buf.data();
-
-    // Train balanced hierarchical kmeans clustering
-    auto trainset_const_view =
-      raft::make_device_matrix_view<const float, IdxT>(trainset.data(), n_rows_train, index.dim());
-    auto centers_view =
-      raft::make_device_matrix_view<float, IdxT>(cluster_centers, index.n_lists(), index.dim());
-    raft::cluster::kmeans_balanced_params kmeans_params;
-    kmeans_params.n_iters = params.kmeans_n_iters;
-    kmeans_params.metric  = index.metric();
-    raft::cluster::kmeans_balanced::fit(
-      handle, kmeans_params, trainset_const_view, centers_view, utils::mapping<float>{});
+/** See raft::neighbors::ivf_pq::build_mg docs */
+template <typename T, typename IdxT>
+auto build_mg(raft::resources const& handle,
+              const index_params& params,
+              const T* dataset,
+              IdxT n_rows,
+              uint32_t dim) -> index<IdxT>
+{
+  RAFT_EXPECTS(resource::comms_initialized(handle),
+               "ivf_pq::build_mg: the handle must have an initialized communicator");
+  const auto& comms = resource::get_comms(handle);
+  const int rank    = comms.get_rank();
+  const int n_ranks = comms.get_size();
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "ivf_pq::build_mg(%zu, %u, rank = %d)", size_t(n_rows), dim, rank);
+  static_assert(std::is_same_v<T, float> || std::is_same_v<T, uint8_t> || std::is_same_v<T, int8_t>,
+                "Unsupported data type");
 
-    // Trainset labels are needed for training PQ codebooks
-    rmm::device_uvector<uint32_t> labels(n_rows_train, stream, big_memory_resource);
-    auto centers_const_view = raft::make_device_matrix_view<const float, IdxT>(
-      cluster_centers, index.n_lists(), index.dim());
-    auto labels_view = raft::make_device_vector_view<uint32_t, IdxT>(labels.data(), n_rows_train);
-    raft::cluster::kmeans_balanced::predict(handle,
-                                            kmeans_params,
-                                            trainset_const_view,
-                                            centers_const_view,
-                                            labels_view,
-                                            utils::mapping<float>());
-
-    {
-      // combine cluster_centers and their norms
-      RAFT_CUDA_TRY(cudaMemcpy2DAsync(index.centers().data_handle(),
-                                      sizeof(float) * index.dim_ext(),
-                                      cluster_centers,
-                                      sizeof(float) * index.dim(),
-                                      sizeof(float) * index.dim(),
-                                      index.n_lists(),
-                                      cudaMemcpyDefault,
-                                      stream));
+  RAFT_EXPECTS(n_rows > 0 && dim > 0, "empty dataset");
 
-      rmm::device_uvector<float> center_norms(index.n_lists(), stream, device_memory);
-      raft::linalg::rowNorm(center_norms.data(),
-                            cluster_centers,
-                            index.dim(),
-                            index.n_lists(),
-                            raft::linalg::L2Norm,
-                            true,
-                            stream);
-      RAFT_CUDA_TRY(cudaMemcpy2DAsync(index.centers().data_handle() + index.dim(),
-                                      sizeof(float) * index.dim_ext(),
-                                      center_norms.data(),
-                                      sizeof(float),
-                                      sizeof(float),
-                                      index.n_lists(),
-                                      cudaMemcpyDefault,
-                                      stream));
-    }
+  auto stream = resource::get_cuda_stream(handle);
 
-    // Make rotation matrix
-    make_rotation_matrix(handle,
-                         params.force_random_rotation,
-                         index.rot_dim(),
-                         index.dim(),
-                         index.rotation_matrix().data_handle());
+  // The source indices of the local rows are offset by the sizes of the shards of the lower ranks.
+  auto shard_sizes = raft::make_device_vector<uint64_t, int>(handle, n_ranks);
+  std::vector<uint64_t> shard_sizes_host(n_ranks);
+  {
+    rmm::device_scalar<uint64_t> local_size(uint64_t(n_rows), stream);
+    comms.allgather(local_size.data(), shard_sizes.data_handle(), 1, stream);
+    RAFT_EXPECTS(comms.sync_stream(stream) == comms::status_t::SUCCESS,
+                 "ivf_pq::build_mg: allgather of the shard sizes failed");
+    raft::copy(shard_sizes_host.data(), shard_sizes.data_handle(), n_ranks, stream);
+    resource::sync_stream(handle);
+  }
+  uint64_t row_offset = 0;
+  for (int r = 0; r < rank; r++) {
+    row_offset += shard_sizes_host[r];
+  }
 
-    // Rotate cluster_centers
-    float alpha = 1.0;
-    float beta  = 0.0;
-    linalg::gemm(handle,
-                 true,
-                 false,
-                 index.rot_dim(),
-                 index.n_lists(),
-                 index.dim(),
-                 &alpha,
-                 index.rotation_matrix().data_handle(),
-                 index.dim(),
-                 cluster_centers,
-                 index.dim(),
-                 &beta,
-                 index.centers_rot().data_handle(),
-                 index.rot_dim(),
-                 stream);
+  index<IdxT> index(handle, params, dim);
+  utils::memzero(
+    index.accum_sorted_sizes().data_handle(), index.accum_sorted_sizes().size(), stream);
+  utils::memzero(index.list_sizes().data_handle(), index.list_sizes().size(), stream);
+  utils::memzero(index.data_ptrs().data_handle(), index.data_ptrs().size(), stream);
+  utils::memzero(index.inds_ptrs().data_handle(), index.inds_ptrs().size(), stream);
+
+  train(handle, params, dataset, n_rows, index, true);
 
-    // Train PQ codebooks
-    switch (index.codebook_kind()) {
-      case codebook_gen::PER_SUBSPACE:
-        train_per_subset(handle,
-                         index,
-                         n_rows_train,
-                         trainset.data(),
-                         labels.data(),
-                         params.kmeans_n_iters,
-                         &managed_memory,
-                         device_memory);
-        break;
-      case codebook_gen::PER_CLUSTER:
-        train_per_cluster(handle,
-                          index,
-                          n_rows_train,
-                          trainset.data(),
-                          labels.data(),
-                          params.kmeans_n_iters,
-                          &managed_memory,
-                          device_memory);
-        break;
-      default: RAFT_FAIL("Unreachable code");
+  // add the local shard if necessary
+  if (params.add_data_on_build) {
+    auto indices = raft::make_device_vector<IdxT, IdxT>(handle, n_rows);
+    raft::linalg::map_offset(
+      handle, indices.view(), raft::add_const_op<IdxT>(static_cast<IdxT>(row_offset)));
+    raft::metrics::phase phase("ivf_pq::build::encode", stream);
+    detail::extend<T, IdxT>(handle, &index, dataset, indices.data_handle(), n_rows);
+  }
+  return index;
+}
+
+/**
+ * Estimate the memory of `build` for a dataset of `n_rows` vectors of the dimensionality `dim`.
+ *
+ * The lists are assumed to be balanced (about `n_rows / n_lists` records each); the workspace is
+ * the peak of the training (the trainset, the balanced k-means, the labels and the codebook
+ * training) and of the batched encoding of the dataset when `params.add_data_on_build`.
+ */
+template <typename T, typename IdxT>
+auto estimate_build_memory(const index_params& params, IdxT n_rows, uint32_t dim)
+  -> raft::memory_estimate
+{
+  const size_t n          = n_rows;
+  const size_t n_lists    = params.n_lists;
+  const uint32_t pq_dim   = params.pq_dim == 0 ? index<IdxT>::calculate_pq_dim(dim) : params.pq_dim;
+  const size_t pq_len     = raft::div_rounding_up_unsafe(dim, pq_dim);
+  const size_t rot_dim    = pq_len * pq_dim;
+  const size_t dim_ext    = raft::round_up_safe(dim + 1, 8u);
+  const size_t book_size  = size_t{1} << params.pq_bits;
+  const size_t n_codebook = params.codebook_kind == codebook_gen::PER_CLUSTER ? n_lists : pq_dim;
+  const size_t residual_book_size =
+    params.residual_pq_bits > 0 ? size_t{1} << params.residual_pq_bits : 0;
+
+  raft::memory_estimate estimate;
+  // the centers, the rotation, the codebooks and the per-list arrays
+  estimate.device_result = sizeof(float) * (n_lists * (dim_ext + rot_dim) + rot_dim * dim +
+                                            n_codebook * pq_len * book_size) +
+                           n_lists * (sizeof(uint32_t) + sizeof(uint8_t*) + sizeof(IdxT*));
+  estimate.host_result = (n_lists + 1) * sizeof(IdxT);
+  if (params.add_data_on_build && n_lists > 0) {
+    list_spec<uint32_t, IdxT> spec{params.pq_bits, pq_dim, params.conservative_memory_allocation};
+    const auto list_size = static_cast<uint32_t>(raft::div_rounding_up_safe<size_t>(n, n_lists));
+    auto capacity        = round_up_safe<uint32_t>(list_size, spec.align_max);
+    if (list_size < spec.align_max) {
+      capacity = bound_by_power_of_two<uint32_t>(std::max<uint32_t>(list_size, spec.align_min));
+      capacity = std::min<uint32_t>(capacity, spec.align_max);
     }
+    const auto exts = spec.make_list_extents(capacity);
+    const size_t list_bytes =
+      size_t(exts.extent(0)) * exts.extent(1) * exts.extent(2) * exts.extent(3);
+    estimate.device_result += n_lists * (list_bytes + size_t(capacity) * sizeof(IdxT));
+    if (params.residual_pq_bits > 0) {
+      // the residual lists of the same capacity (and their unused indices)
+      list_spec<uint32_t, IdxT> residual_spec{
+        params.residual_pq_bits, pq_dim, params.conservative_memory_allocation};
+      const auto residual_exts = residual_spec.make_list_extents(capacity);
+      const size_t residual_list_bytes = size_t(residual_exts.extent(0)) * residual_exts.extent(1) *
+                                         residual_exts.extent(2) * residual_exts.extent(3);
+      estimate.device_result +=
+        n_lists * (residual_list_bytes + size_t(capacity) * sizeof(IdxT));
+    }
+  }
+  if (params.residual_pq_bits > 0) {
+    estimate.device_result +=
+      sizeof(float) * pq_dim * pq_len * residual_book_size + n_lists * sizeof(uint8_t*);
   }
 
-  // add the data if necessary
+  // training
+  const auto trainset_ratio = std::max<size_t>(
+    1, n / std::max<size_t>(params.kmeans_trainset_fraction * n, std::max<size_t>(n_lists, 1)));
+  const size_t n_rows_train = n / trainset_ratio;
+  raft::cluster::kmeans_balanced_params kmeans_params;
+  kmeans_params.n_iters = params.kmeans_n_iters;
+  kmeans_params.metric  = utils::internal_metric(params.metric);
+  using raft::cluster::kmeans_balanced::helpers::estimate_fit_memory;
+  const size_t kmeans_bytes = estimate_fit_memory<float, float, IdxT, utils::mapping<float>>(
+                                kmeans_params, IdxT(n_rows_train), IdxT(dim), IdxT(n_lists))
+                                .device_workspace;
+  size_t codebook_bytes = sizeof(float) * n_codebook * pq_len * book_size;
+  if (params.codebook_kind == codebook_gen::PER_CLUSTER) {
+    // the rows of the largest cluster, assuming the clusters are at most twice the average size
+    const size_t max_cluster_size =
+      2 * raft::div_rounding_up_safe<size_t>(n_rows_train, std::max<size_t>(n_lists, 1));
+    codebook_bytes += n_rows_train * sizeof(IdxT) +
+                      max_cluster_size * pq_dim * sizeof(uint32_t) +
+                      max_cluster_size * rot_dim * sizeof(float);
+  } else {
+    codebook_bytes += n_rows_train * (pq_len * sizeof(float) + sizeof(uint32_t));
+  }
+  // the trainset and the centers are kept while the k-means and then the codebooks are trained
+  const size_t trainset_bytes = sizeof(float) * (n_rows_train + n_lists) * dim;
+  if (params.residual_pq_bits > 0) {
+    // the reconstruction errors of the trainset, then the trainset of a subspace
+    const size_t residual_codebook_bytes =
+      sizeof(float) * (n_rows_train * (rot_dim + pq_len) + pq_dim * pq_len * residual_book_size) +
+      n_rows_train * sizeof(uint32_t);
+    codebook_bytes = std::max(codebook_bytes, residual_codebook_bytes);
+  }
+  const size_t train_bytes =
+    trainset_bytes + std::max(kmeans_bytes, n_rows_train * sizeof(uint32_t) + codebook_bytes);
+
+  // encoding the dataset: the labels of all the rows and the buffers of a batch
+  size_t extend_bytes = 0;
   if (params.add_data_on_build) {
-    detail::extend<T, IdxT>(handle, &index, dataset, nullptr, n_rows);
+    const size_t max_batch_size = std::min<size_t>(n, 65536);
+    extend_bytes = n * sizeof(uint32_t) +
+                   max_batch_size * ((dim + rot_dim) * sizeof(float) + sizeof(IdxT));
+    // the in-list positions of a batch for the residual codes
+    if (params.residual_pq_bits > 0) { extend_bytes += max_batch_size * sizeof(uint32_t); }
   }
-  return index;
+  estimate.device_workspace = std::max(train_bytes, extend_bytes);
+  return estimate;
 }
 }  // namespace raft::neighbors::ivf_pq::detail
@@ -85,6 +85,34 @@ struct bitfield_view_t {
   }
 };
 
+/**
+ * Read a single PQ code of a vector in a list, with the code width known at runtime only.
+ *
+ * @param[in] list_data the encoded cluster data (see `list_spec`).
+ * @param[in] pq_bits
+ * @param[in] pq_dim
+ * @param[in] ix in-cluster index of the vector.
+ * @param[in] j the component of the encoding, [0..pq_dim).
+ */
+__device__ inline auto read_code(
+  const uint8_t* list_data, uint32_t pq_bits, uint32_t pq_dim, uint32_t ix, uint32_t j) -> uint32_t
+{
+  using group_align         = Pow2<kIndexGroupSize>;
+  const uint32_t chunk_size = (kIndexGroupVecLen * 8u) / pq_bits;
+  const uint32_t n_chunks   = div_rounding_up_unsafe(pq_dim, chunk_size);
+  const uint32_t chunk_ix   = j / chunk_size;
+  const uint32_t bit        = (j % chunk_size) * pq_bits;
+  const uint8_t* chunk =
+    list_data + ((size_t(group_align::div(ix)) * n_chunks + chunk_ix) * kIndexGroupSize +
+                 group_align::mod(ix)) *
+                  kIndexGroupVecLen;
+  auto pair = static_cast<uint32_t>(chunk[Pow2<8>::div(bit)]);
+  if (Pow2<8>::mod(bit) + pq_bits > 8) {
+    pair |= static_cast<uint32_t>(chunk[Pow2<8>::div(bit) + 1]) << 8;
+  }
+  return (pair >> Pow2<8>::mod(bit)) & ((1u << pq_bits) - 1u);
+}
+
 /**
  * Process a single vector in a list.
  *
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2022-2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/neighbors/ivf_pq_types.hpp>  // kIndexGroupSize
+
+#include <cstdint>
+
+namespace raft::neighbors::ivf_pq::detail {
+
+/* Manually unrolled loop over a chunk of pq_dataset that fits into one VecT. */
+template <typename OutT,
+          typename LutT,
+          typename VecT,
+          bool CheckBounds,
+          uint32_t PqBits,
+          uint32_t BitsLeft = 0,
+          uint32_t Ix       = 0>
+__device__ __forceinline__ void ivfpq_compute_chunk(OutT& score /* NOLINT */,
+                                                    typename VecT::math_t& pq_code,
+                                                    const VecT& pq_codes,
+                                                    const LutT*& lut_head,
+                                                    const LutT*& lut_end)
+{
+  if constexpr (CheckBounds) {
+    if (lut_head >= lut_end) { return; }
+  }
+  constexpr uint32_t kTotalBits = 8 * sizeof(typename VecT::math_t);
+  constexpr uint32_t kPqShift   = 1u << PqBits;
+  constexpr uint32_t kPqMask    = kPqShift - 1u;
+  if constexpr (BitsLeft >= PqBits) {
+    uint8_t code = pq_code & kPqMask;
+    pq_code >>= PqBits;
+    score += OutT(lut_head[code]);
+    lut_head += kPqShift;
+    return ivfpq_compute_chunk<OutT, LutT, VecT, CheckBounds, PqBits, BitsLeft - PqBits, Ix>(
+      score, pq_code, pq_codes, lut_head, lut_end);
+  } else if constexpr (Ix < VecT::Ratio) {
+    uint8_t code                = pq_code;
+    pq_code                     = pq_codes.val.data[Ix];
+    constexpr uint32_t kRemBits = PqBits - BitsLeft;
+    constexpr uint32_t kRemMask = (1u << kRemBits) - 1u;
+    code |= (pq_code & kRemMask) << BitsLeft;
+    pq_code >>= kRemBits;
+    score += OutT(lut_head[code]);
+    lut_head += kPqShift;
+    return ivfpq_compute_chunk<OutT,
+                               LutT,
+                               VecT,
+                               CheckBounds,
+                               PqBits,
+                               kTotalBits - kRemBits,
+                               Ix + 1>(score, pq_code, pq_codes, lut_head, lut_end);
+  }
+}
+
+/* Compute the similarity for one vector in the pq_dataset */
+template <typename OutT, typename LutT, typename VecT, uint32_t PqBits>
+__device__ auto ivfpq_compute_score(uint32_t pq_dim,
+                                    const typename VecT::io_t* pq_head,
+                                    const LutT* lut_scores,
+                                    OutT early_stop_limit) -> OutT
+{
+  constexpr uint32_t kChunkSize = sizeof(VecT) * 8u / PqBits;
+  auto lut_head                 = lut_scores;
+  auto lut_end                  = lut_scores + (pq_dim << PqBits);
+  VecT pq_codes;
+  OutT score{0};
+#pragma unroll
+  for (; pq_dim >= kChunkSize; pq_dim -= kChunkSize) {
+    *pq_codes.vectorized_data() = *pq_head;
+    pq_head += kIndexGroupSize;
+    typename VecT::math_t pq_code = 0;
+    ivfpq_compute_chunk<OutT, LutT, VecT, false, PqBits>(
+      score, pq_code, pq_codes, lut_head, lut_end);
+    // Early stop when it makes sense (otherwise early_stop_limit is kDummy/infinity).
+    if (score >= early_stop_limit) { return score; }
+  }
+  if (pq_dim > 0) {
+    *pq_codes.vectorized_data()   = *pq_head;
+    typename VecT::math_t pq_code = 0;
+    ivfpq_compute_chunk<OutT, LutT, VecT, true, PqBits>(
+      score, pq_code, pq_codes, lut_head, lut_end);
+  }
+  return score;
+}
+
+/*
+  NOTE[fast_scan]
+
+  With `pq_bits = 4`, a subspace of the lookup table has just 16 entries. When the LUT is
+  quantized to 8 bits (the user chose an 8-bit `lut_dtype`), these 16 entries fit into four 32-bit
+  registers. Then we can replace the per-code gather `lut[code]` from shared memory (which is
+  served at the rate of the bank conflicts of a warp with random codes) by a broadcast read of
+  the whole subspace (all threads of a warp read the same 16 bytes) and a register-level byte
+  selection (`__byte_perm`).
+
+  The LUT of a (query, probe) pair is quantized linearly: every subspace `s` is shifted by its
+  minimum `m_s`, and all subspaces share the same scale `d`, such that the score is reconstructed
+  with a single multiply-add from the integer sum of the quantized values:
+
+    score = sum_s lut[s][code_s] ~= sum_s m_s + d * sum_s q[s][code_s]
+
+  The quantization error is at most `d / 2` per subspace, comparable to that of the `fp_8bit` LUT.
+ */
+
+/* Compute the similarity for one vector in the pq_dataset using the fast-scan (pq_bits = 4). */
+template <typename OutT, typename VecT>
+__device__ auto ivfpq_compute_score_fast_scan(uint32_t pq_dim,
+                                              const typename VecT::io_t* pq_head,
+                                              const uint4* lut,  // [pq_dim] x 16 x uint8_t
+                                              float lut_offset,
+                                              float lut_scale,
+                                              OutT early_stop_limit) -> OutT
+{
+  static_assert(sizeof(typename VecT::math_t) == sizeof(uint32_t));
+  constexpr uint32_t kCodesPerWord = 8;
+  uint32_t acc                     = 0;
+  VecT pq_codes;
+#pragma unroll
+  for (uint32_t s = 0; s < pq_dim; pq_head += kIndexGroupSize) {
+    *pq_codes.vectorized_data() = *pq_head;
+#pragma unroll
+    for (uint32_t w = 0; w < VecT::Ratio; w++) {
+      uint32_t codes = pq_codes.val.data[w];
+#pragma unroll
+      for (uint32_t n = 0; n < kCodesPerWord; n++, codes >>= 4) {
+        if (s + n < pq_dim) {
+          const uint4 l    = lut[s + n];
+          const uint32_t c = codes & 0xfu;
+          // Select the byte `c` out of the 16 bytes of the subspace.
+          const uint32_t lo_word = (c & 8u) ? l.z : l.x;
+          const uint32_t hi_word = (c & 8u) ? l.w : l.y;
+          acc += __byte_perm(lo_word, hi_word, c & 7u) & 0xffu;
+        }
+      }
+      s += kCodesPerWord;
+    }
+    // Early stop when it makes sense (otherwise early_stop_limit is kDummy/infinity).
+    if (s < pq_dim && OutT(lut_offset + lut_scale * float(acc)) >= early_stop_limit) { break; }
+  }
+  return OutT(lut_offset + lut_scale * float(acc));
+}
+
+}  // namespace raft::neighbors::ivf_pq::detail
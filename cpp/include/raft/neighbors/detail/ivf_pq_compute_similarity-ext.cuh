@@ -16,14 +16,15 @@
 
 #pragma once
 
-#include <cuda_fp16.h>                               // __half
-#include <raft/core/detail/macros.hpp>               // RAFT_WEAK_FUNCTION
-#include <raft/distance/distance_types.hpp>          // raft::distance::DistanceType
-#include <raft/neighbors/detail/ivf_pq_fp_8bit.cuh>  // raft::neighbors::ivf_pq::detail::fp_8bit
-#include <raft/neighbors/ivf_pq_types.hpp>           // raft::neighbors::ivf_pq::codebook_gen
-#include <raft/neighbors/sample_filter_types.hpp>    // none_ivf_sample_filter
-#include <raft/util/raft_explicit.hpp>               // RAFT_EXPLICIT
-#include <rmm/cuda_stream_view.hpp>                  // rmm::cuda_stream_view
+#include <cuda_fp16.h>                                // __half
+#include <raft/core/detail/macros.hpp>                // RAFT_WEAK_FUNCTION
+#include <raft/distance/distance_types.hpp>           // raft::distance::DistanceType
+#include <raft/neighbors/detail/ivf_pq_fp_8bit.cuh>   // raft::neighbors::ivf_pq::detail::fp_8bit
+#include <raft/neighbors/detail/ivf_static_dims.hpp>  // ivf::detail::ann_static_dims
+#include <raft/neighbors/ivf_pq_types.hpp>            // raft::neighbors::ivf_pq::codebook_gen
+#include <raft/neighbors/sample_filter_types.hpp>     // none_ivf_sample_filter
+#include <raft/util/raft_explicit.hpp>                // RAFT_EXPLICIT
+#include <rmm/cuda_stream_view.hpp>                   // rmm::cuda_stream_view
 
 #ifdef RAFT_EXPLICIT_INSTANTIATE_ONLY
 
@@ -40,12 +41,13 @@ template <typename OutT,
           typename IvfSampleFilterT,
           uint32_t PqBits,
           int Capacity,
+          uint32_t StaticPqDim,
           bool PrecompBaseDiff,
           bool EnableSMemLut>
 __global__ void compute_similarity_kernel(uint32_t n_rows,
                                           uint32_t dim,
                                           uint32_t n_probes,
-                                          uint32_t pq_dim,
+                                          uint32_t runtime_pq_dim,
                                           uint32_t n_queries,
                                           uint32_t queries_offset,
                                           distance::DistanceType metric,
@@ -68,7 +70,7 @@ __global__ void compute_similarity_kernel(uint32_t n_rows,
 // The signature of the kernel defined by a minimal set of template parameters
 template <typename OutT, typename LutT, typename IvfSampleFilterT>
 using compute_similarity_kernel_t =
-  decltype(&compute_similarity_kernel<OutT, LutT, IvfSampleFilterT, 8, 0, true, true>);
+  decltype(&compute_similarity_kernel<OutT, LutT, IvfSampleFilterT, 8, 0, 0, true, true>);
 
 template <typename OutT, typename LutT, typename IvfSampleFilterT>
 struct selected {
@@ -119,7 +121,10 @@ void compute_similarity_run(selected<OutT, LutT, IvfSampleFilterT> s,
  *    beyond this limit do not consider increasing the number of active blocks per SM
  *    would improve locality anymore.
  */
-template <typename OutT, typename LutT, typename IvfSampleFilterT>
+template <typename OutT,
+          typename LutT,
+          typename IvfSampleFilterT,
+          typename StaticDims = ivf::detail::ann_static_dims>
 auto compute_similarity_select(const cudaDeviceProp& dev_props,
                                bool manage_local_topk,
                                int locality_hint,
@@ -18,12 +18,15 @@
 
 #include <raft/distance/distance_types.hpp>  // raft::distance::DistanceType
 #include <raft/matrix/detail/select_warpsort.cuh>  // matrix::detail::select::warpsort::warp_sort_distributed
+#include <raft/neighbors/detail/ivf_pq_compute_score.cuh>     // ivfpq_compute_score
 #include <raft/neighbors/detail/ivf_pq_dummy_block_sort.cuh>  // dummy_block_sort_t
+#include <raft/neighbors/detail/ivf_static_dims.hpp>          // ivf::detail::static_dims_t
 #include <raft/neighbors/ivf_pq_types.hpp>                    // codebook_gen
 #include <raft/neighbors/sample_filter_types.hpp>             // none_ivf_sample_filter
 #include <raft/util/cuda_rt_essentials.hpp>                   // RAFT_CUDA_TRY
 #include <raft/util/device_atomics.cuh>                       // raft::atomicMin
 #include <raft/util/pow2_utils.cuh>                           // raft::Pow2
+#include <raft/util/reduction.cuh>                            // raft::blockReduce
 #include <raft/util/vectorized.cuh>                           // raft::TxN_t
 #include <rmm/cuda_stream_view.hpp>                           // rmm::cuda_stream_view
 
@@ -93,82 +96,6 @@ constexpr inline auto estimate_carveout(double shmem_fraction,
   return (size_t(100 * s * m * shmem_fraction) - (m - 1) * r) / (s * (m + r));
 }
 
-/* Manually unrolled loop over a chunk of pq_dataset that fits into one VecT. */
-template <typename OutT,
-          typename LutT,
-          typename VecT,
-          bool CheckBounds,
-          uint32_t PqBits,
-          uint32_t BitsLeft = 0,
-          uint32_t Ix       = 0>
-__device__ __forceinline__ void ivfpq_compute_chunk(OutT& score /* NOLINT */,
-                                                    typename VecT::math_t& pq_code,
-                                                    const VecT& pq_codes,
-                                                    const LutT*& lut_head,
-                                                    const LutT*& lut_end)
-{
-  if constexpr (CheckBounds) {
-    if (lut_head >= lut_end) { return; }
-  }
-  constexpr uint32_t kTotalBits = 8 * sizeof(typename VecT::math_t);
-  constexpr uint32_t kPqShift   = 1u << PqBits;
-  constexpr uint32_t kPqMask    = kPqShift - 1u;
-  if constexpr (BitsLeft >= PqBits) {
-    uint8_t code = pq_code & kPqMask;
-    pq_code >>= PqBits;
-    score += OutT(lut_head[code]);
-    lut_head += kPqShift;
-    return ivfpq_compute_chunk<OutT, LutT, VecT, CheckBounds, PqBits, BitsLeft - PqBits, Ix>(
-      score, pq_code, pq_codes, lut_head, lut_end);
-  } else if constexpr (Ix < VecT::Ratio) {
-    uint8_t code                = pq_code;
-    pq_code                     = pq_codes.val.data[Ix];
-    constexpr uint32_t kRemBits = PqBits - BitsLeft;
-    constexpr uint32_t kRemMask = (1u << kRemBits) - 1u;
-    code |= (pq_code & kRemMask) << BitsLeft;
-    pq_code >>= kRemBits;
-    score += OutT(lut_head[code]);
-    lut_head += kPqShift;
-    return ivfpq_compute_chunk<OutT,
-                               LutT,
-                               VecT,
-                               CheckBounds,
-                               PqBits,
-                               kTotalBits - kRemBits,
-                               Ix + 1>(score, pq_code, pq_codes, lut_head, lut_end);
-  }
-}
-
-/* Compute the similarity for one vector in the pq_dataset */
-template <typename OutT, typename LutT, typename VecT, uint32_t PqBits>
-__device__ auto ivfpq_compute_score(uint32_t pq_dim,
-                                    const typename VecT::io_t* pq_head,
-                                    const LutT* lut_scores,
-                                    OutT early_stop_limit) -> OutT
-{
-  constexpr uint32_t kChunkSize = sizeof(VecT) * 8u / PqBits;
-  auto lut_head                 = lut_scores;
-  auto lut_end                  = lut_scores + (pq_dim << PqBits);
-  VecT pq_codes;
-  OutT score{0};
-  for (; pq_dim >= kChunkSize; pq_dim -= kChunkSize) {
-    *pq_codes.vectorized_data() = *pq_head;
-    pq_head += kIndexGroupSize;
-    typename VecT::math_t pq_code = 0;
-    ivfpq_compute_chunk<OutT, LutT, VecT, false, PqBits>(
-      score, pq_code, pq_codes, lut_head, lut_end);
-    // Early stop when it makes sense (otherwise early_stop_limit is kDummy/infinity).
-    if (score >= early_stop_limit) { return score; }
-  }
-  if (pq_dim > 0) {
-    *pq_codes.vectorized_data()   = *pq_head;
-    typename VecT::math_t pq_code = 0;
-    ivfpq_compute_chunk<OutT, LutT, VecT, true, PqBits>(
-      score, pq_code, pq_codes, lut_head, lut_end);
-  }
-  return score;
-}
-
 /**
  * The main kernel that computes similarity scores across multiple queries and probes.
  * When `Capacity > 0`, it also selects top K candidates for each query and probe
@@ -186,10 +113,14 @@ __device__ auto ivfpq_compute_score(uint32_t pq_dim,
  *   (NB: pq_book_size = 1 << PqBits).
  * @tparam Capacity
  *   Power-of-two; the maximum possible `k` in top-k. Value zero disables fused top-k search.
+ * @tparam StaticPqDim
+ *   The dimensionality of an encoded vector when known at compile time, or zero
+ *   (see `ivf::detail::ann_static_dims`).
  * @tparam PrecompBaseDiff
  *   Defines whether we should precompute part of the distance and keep it in shared memory
  *   before the main part (score calculation) to increase memory usage efficiency in the latter.
- *   For L2, this is the distance between the query and the cluster center.
+ *   For L2, this is the distance between the query and the cluster center; for the inner product,
+ *   this is the query itself.
  * @tparam EnableSMemLut
  *   Defines whether to use the shared memory for the lookup table (`lut_scores`).
  *   Setting this to `false` allows to reduce the shared memory usage (and maximum data dim)
@@ -198,8 +129,9 @@ __device__ auto ivfpq_compute_score(uint32_t pq_dim,
  * @param n_rows the number of records in the dataset
  * @param dim the dimensionality of the data (NB: after rotation transform, i.e. `index.rot_dim()`).
  * @param n_probes the number of clusters to search for each query
- * @param pq_dim
- *   The dimensionality of an encoded vector after compression by PQ.
+ * @param runtime_pq_dim
+ *   The dimensionality of an encoded vector after compression by PQ; ignored when
+ *   `StaticPqDim > 0`.
  * @param n_queries the number of queries.
  * @param queries_offset
  *   An offset of the current query batch. It is used for feeding sample_filter with the
@@ -249,12 +181,13 @@ template <typename OutT,
           typename IvfSampleFilterT,
           uint32_t PqBits,
           int Capacity,
+          uint32_t StaticPqDim,
           bool PrecompBaseDiff,
           bool EnableSMemLut>
 __global__ void compute_similarity_kernel(uint32_t n_rows,
                                           uint32_t dim,
                                           uint32_t n_probes,
-                                          uint32_t pq_dim,
+                                          uint32_t runtime_pq_dim,
                                           uint32_t n_queries,
                                           uint32_t queries_offset,
                                           distance::DistanceType metric,
@@ -277,16 +210,20 @@ __global__ void compute_similarity_kernel(uint32_t n_rows,
   /* Shared memory:
 
     * lut_scores: lookup table (LUT) of size = `pq_dim << PqBits`  (when EnableSMemLut)
-    * base_diff: size = dim (which is equal to `pq_dim * pq_len`)  or dim*2
+    * base_diff: size = dim (which is equal to `pq_dim * pq_len`)
     * topk::block_sort: some amount of shared memory, but overlaps with the rest:
         block_sort only needs shared memory for `.done()` operation, which can come very last.
   */
   extern __shared__ __align__(256) uint8_t smem_buf[];  // NOLINT
   constexpr bool kManageLocalTopK = Capacity > 0;
+  // The 4-bit codes with an 8-bit LUT in shared memory are scored by the fast-scan method.
+  constexpr bool kFastScan = PqBits == 4 && sizeof(LutT) == 1 && EnableSMemLut;
 
   constexpr uint32_t PqShift = 1u << PqBits;  // NOLINT
   constexpr uint32_t PqMask  = PqShift - 1u;  // NOLINT
 
+  // With the number of subspaces known at compile time, the loops over them are unrolled.
+  const uint32_t pq_dim   = StaticPqDim > 0 ? StaticPqDim : runtime_pq_dim;
   const uint32_t pq_len   = dim / pq_dim;
   const uint32_t lut_size = pq_dim * PqShift;
 
@@ -333,6 +270,17 @@ __global__ void compute_similarity_kernel(uint32_t n_rows,
       // Store all calculated distances to out_scores
       out_scores = _out_scores + max_samples * query_ix;
     }
+    // Nothing to compute for an empty probe (e.g. dropped by the adaptive probing), but the slots
+    // of the probe in the fused top-k output are filled with dummies.
+    if (chunk_indices[probe_ix] == (probe_ix > 0 ? chunk_indices[probe_ix - 1] : 0u)) {
+      if constexpr (kManageLocalTopK) {
+        for (uint32_t i = threadIdx.x; i < topk; i += blockDim.x) {
+          out_scores[i]  = upper_bound<OutT>();
+          out_indices[i] = 0;
+        }
+      }
+      continue;
+    }
     uint32_t label              = cluster_labels[n_probes * query_ix + probe_ix];
     const float* cluster_center = cluster_centers + (dim * label);
     const float* pq_center;
@@ -342,71 +290,123 @@ __global__ void compute_similarity_kernel(uint32_t n_rows,
       pq_center = pq_centers + (pq_len << PqBits) * label;
     }
 
-    if constexpr (PrecompBaseDiff) {
+    // For the inner product, the query-center term `-(query, cluster_center)` is the same for all
+    // records in the cluster. It is computed once here and added to the scores of the records,
+    // rather than spread over the subspaces and recomputed in every entry of the lookup table.
+    float score_offset = 0.0f;
+    if (metric == distance::DistanceType::InnerProduct) {
+      __shared__ float qc_reduce[WarpSize];
+      __shared__ float qc_score;
+      float qc = 0.0f;
+      for (uint32_t i = threadIdx.x; i < dim; i += blockDim.x) {
+        float q = query[i];
+        if constexpr (PrecompBaseDiff) { base_diff[i] = q; }
+        qc += q * cluster_center[i];
+      }
+      qc = blockReduce(qc, reinterpret_cast<char*>(qc_reduce));
+      if (threadIdx.x == 0) { qc_score = -qc; }
+      __syncthreads();
+      score_offset = qc_score;
+    } else if constexpr (PrecompBaseDiff) {
       // Reduce number of memory reads later by pre-computing parts of the score
-      switch (metric) {
-        case distance::DistanceType::L2SqrtExpanded:
-        case distance::DistanceType::L2Expanded: {
-          for (uint32_t i = threadIdx.x; i < dim; i += blockDim.x) {
-            base_diff[i] = query[i] - cluster_center[i];
-          }
-        } break;
-        case distance::DistanceType::InnerProduct: {
-          float2 pvals;
-          for (uint32_t i = threadIdx.x; i < dim; i += blockDim.x) {
-            pvals.x                                 = query[i];
-            pvals.y                                 = cluster_center[i] * pvals.x;
-            reinterpret_cast<float2*>(base_diff)[i] = pvals;
-          }
-        } break;
-        default: __builtin_unreachable();
+      for (uint32_t i = threadIdx.x; i < dim; i += blockDim.x) {
+        base_diff[i] = query[i] - cluster_center[i];
       }
       __syncthreads();
     }
 
-    {
+    // For each subspace, the lookup table stores the distance between the actual query vector
+    // (projected into the subspace) and all possible pq vectors in that subspace.
+    auto lut_entry = [=](uint32_t i) -> float {
+      const uint32_t i_pq  = i >> PqBits;
+      uint32_t j           = i_pq * pq_len;
+      const uint32_t j_end = pq_len + j;
+      auto cur_pq_center   = pq_center + (i & PqMask) +
+                           (codebook_kind == codebook_gen::PER_SUBSPACE ? j * PqShift : 0u);
+      float score = 0.0;
+      do {
+        float pq_c = *cur_pq_center;
+        cur_pq_center += PqShift;
+        switch (metric) {
+          case distance::DistanceType::L2SqrtExpanded:
+          case distance::DistanceType::L2Expanded: {
+            float diff;
+            if constexpr (PrecompBaseDiff) {
+              diff = base_diff[j];
+            } else {
+              diff = query[j] - cluster_center[j];
+            }
+            diff -= pq_c;
+            score += diff * diff;
+          } break;
+          case distance::DistanceType::InnerProduct: {
+            // NB: we negate the scores as we hardcoded select-topk to always compute the minimum
+            float q;
+            if constexpr (PrecompBaseDiff) {
+              q = base_diff[j];
+            } else {
+              q = query[j];
+            }
+            score -= q * pq_c;
+          } break;
+          default: __builtin_unreachable();
+        }
+      } while (++j < j_end);
+      return score;
+    };
+
+    float fast_scan_offset = 0.0f;
+    float fast_scan_scale  = 0.0f;
+    if constexpr (kFastScan) {
+      // Create a linearly quantized lookup table, see NOTE[fast_scan].
+      __shared__ float fast_scan_reduce[2 * WarpSize];
+      __shared__ float fast_scan_stats[2];
+      float min_sum   = 0.0f;
+      float max_range = 0.0f;
+      for (uint32_t i_pq = threadIdx.x; i_pq < pq_dim; i_pq += blockDim.x) {
+        float lo = upper_bound<float>();
+        float hi = lower_bound<float>();
+#pragma unroll
+        for (uint32_t c = 0; c < PqShift; c++) {
+          float v = lut_entry((i_pq << PqBits) | c);
+          lo      = min(lo, v);
+          hi      = max(hi, v);
+        }
+        min_sum += lo;
+        max_range = max(max_range, hi - lo);
+      }
+      min_sum   = blockReduce(min_sum, reinterpret_cast<char*>(fast_scan_reduce));
+      max_range = blockReduce(
+        max_range, reinterpret_cast<char*>(fast_scan_reduce + WarpSize), raft::max_op{});
+      if (threadIdx.x == 0) {
+        fast_scan_stats[0] = min_sum;
+        fast_scan_stats[1] = max_range / 255.0f;
+      }
+      __syncthreads();
+      fast_scan_offset      = fast_scan_stats[0] + score_offset;
+      fast_scan_scale       = fast_scan_stats[1];
+      const float inv_scale = fast_scan_scale > 0.0f ? 1.0f / fast_scan_scale : 0.0f;
+      for (uint32_t i_pq = threadIdx.x; i_pq < pq_dim; i_pq += blockDim.x) {
+        float vals[PqShift];
+        float lo = upper_bound<float>();
+#pragma unroll
+        for (uint32_t c = 0; c < PqShift; c++) {
+          vals[c] = lut_entry((i_pq << PqBits) | c);
+          lo      = min(lo, vals[c]);
+        }
+        uint32_t words[4] = {0, 0, 0, 0};
+#pragma unroll
+        for (uint32_t c = 0; c < PqShift; c++) {
+          uint32_t q = min(255u, __float2uint_rn((vals[c] - lo) * inv_scale));
+          words[c >> 2] |= q << (8u * (c & 3u));
+        }
+        reinterpret_cast<uint4*>(lut_scores)[i_pq] =
+          make_uint4(words[0], words[1], words[2], words[3]);
+      }
+    } else {
       // Create a lookup table
-      // For each subspace, the lookup table stores the distance between the actual query vector
-      // (projected into the subspace) and all possible pq vectors in that subspace.
       for (uint32_t i = threadIdx.x; i < lut_size; i += blockDim.x) {
-        const uint32_t i_pq  = i >> PqBits;
-        uint32_t j           = i_pq * pq_len;
-        const uint32_t j_end = pq_len + j;
-        auto cur_pq_center   = pq_center + (i & PqMask) +
-                             (codebook_kind == codebook_gen::PER_SUBSPACE ? j * PqShift : 0u);
-        float score = 0.0;
-        do {
-          float pq_c = *cur_pq_center;
-          cur_pq_center += PqShift;
-          switch (metric) {
-            case distance::DistanceType::L2SqrtExpanded:
-            case distance::DistanceType::L2Expanded: {
-              float diff;
-              if constexpr (PrecompBaseDiff) {
-                diff = base_diff[j];
-              } else {
-                diff = query[j] - cluster_center[j];
-              }
-              diff -= pq_c;
-              score += diff * diff;
-            } break;
-            case distance::DistanceType::InnerProduct: {
-              // NB: we negate the scores as we hardcoded select-topk to always compute the minimum
-              float q;
-              if constexpr (PrecompBaseDiff) {
-                float2 pvals = reinterpret_cast<float2*>(base_diff)[j];
-                q            = pvals.x;
-                score -= pvals.y;
-              } else {
-                q = query[j];
-                score -= q * cluster_center[j];
-              }
-              score -= q * pq_c;
-            } break;
-            default: __builtin_unreachable();
-          }
-        } while (++j < j_end);
-        lut_scores[i] = LutT(score);
+        lut_scores[i] = LutT(lut_entry(i));
       }
     }
 
@@ -462,11 +462,24 @@ __global__ void compute_similarity_kernel(uint32_t n_rows,
       bool valid = i < n_samples;
       // Check bounds and that the sample is acceptable for the query
       if (valid && sample_filter(queries_offset + query_ix, label, i)) {
-        score = ivfpq_compute_score<OutT, LutT, vec_t, PqBits>(
-          pq_dim,
-          reinterpret_cast<const vec_t::io_t*>(pq_thread_data),
-          lut_scores,
-          early_stop_limit);
+        if constexpr (kFastScan) {
+          score = ivfpq_compute_score_fast_scan<OutT, vec_t>(
+            pq_dim,
+            reinterpret_cast<const vec_t::io_t*>(pq_thread_data),
+            reinterpret_cast<const uint4*>(lut_scores),
+            fast_scan_offset,
+            fast_scan_scale,
+            early_stop_limit);
+        } else {
+          score = ivfpq_compute_score<OutT, LutT, vec_t, PqBits>(
+            pq_dim,
+            reinterpret_cast<const vec_t::io_t*>(pq_thread_data),
+            lut_scores,
+            early_stop_limit);
+          if (metric == distance::DistanceType::InnerProduct) {
+            score = OutT(float(score) + score_offset);
+          }
+        }
       }
       if constexpr (kManageLocalTopK) {
         block_topk.add(score, sample_offset + i);
@@ -497,53 +510,62 @@ template <typename OutT,
           typename LutT,
           typename IvfSampleFilterT = raft::neighbors::filtering::none_ivf_sample_filter>
 using compute_similarity_kernel_t =
-  decltype(&compute_similarity_kernel<OutT, LutT, IvfSampleFilterT, 8, 0, true, true>);
+  decltype(&compute_similarity_kernel<OutT, LutT, IvfSampleFilterT, 8, 0, 0, true, true>);
 
 // The config struct lifts the runtime parameters to the template parameters
 template <typename OutT,
           typename LutT,
           bool PrecompBaseDiff,
           bool EnableSMemLut,
-          typename IvfSampleFilterT = raft::neighbors::filtering::none_ivf_sample_filter>
+          typename IvfSampleFilterT = raft::neighbors::filtering::none_ivf_sample_filter,
+          typename StaticDims       = ivf::detail::ann_static_dims>
 struct compute_similarity_kernel_config {
  public:
-  static auto get(uint32_t pq_bits, uint32_t k_max)
+  static auto get(uint32_t pq_bits, uint32_t k_max, uint32_t pq_dim)
     -> compute_similarity_kernel_t<OutT, LutT, IvfSampleFilterT>
   {
-    return kernel_choose_bits(pq_bits, k_max);
+    return kernel_choose_bits(pq_bits, k_max, pq_dim);
   }
 
  private:
-  static auto kernel_choose_bits(uint32_t pq_bits, uint32_t k_max)
+  static auto kernel_choose_bits(uint32_t pq_bits, uint32_t k_max, uint32_t pq_dim)
     -> compute_similarity_kernel_t<OutT, LutT, IvfSampleFilterT>
   {
     switch (pq_bits) {
-      case 4: return kernel_try_capacity<4, kMaxCapacity>(k_max);
-      case 5: return kernel_try_capacity<5, kMaxCapacity>(k_max);
-      case 6: return kernel_try_capacity<6, kMaxCapacity>(k_max);
-      case 7: return kernel_try_capacity<7, kMaxCapacity>(k_max);
-      case 8: return kernel_try_capacity<8, kMaxCapacity>(k_max);
+      case 4: return kernel_try_capacity<4, kMaxCapacity>(k_max, pq_dim);
+      case 5: return kernel_try_capacity<5, kMaxCapacity>(k_max, pq_dim);
+      case 6: return kernel_try_capacity<6, kMaxCapacity>(k_max, pq_dim);
+      case 7: return kernel_try_capacity<7, kMaxCapacity>(k_max, pq_dim);
+      case 8: return kernel_try_capacity<8, kMaxCapacity>(k_max, pq_dim);
       default: RAFT_FAIL("Invalid pq_bits (%u), the value must be within [4, 8]", pq_bits);
     }
   }
 
   template <uint32_t PqBits, int Capacity>
-  static auto kernel_try_capacity(uint32_t k_max)
+  static auto kernel_try_capacity(uint32_t k_max, uint32_t pq_dim)
     -> compute_similarity_kernel_t<OutT, LutT, IvfSampleFilterT>
   {
     if constexpr (Capacity > 0) {
-      if (k_max == 0 || k_max > Capacity) { return kernel_try_capacity<PqBits, 0>(k_max); }
+      if (k_max == 0 || k_max > Capacity) { return kernel_try_capacity<PqBits, 0>(k_max, pq_dim); }
     }
     if constexpr (Capacity > 1) {
-      if (k_max * 2 <= Capacity) { return kernel_try_capacity<PqBits, (Capacity / 2)>(k_max); }
+      if (k_max * 2 <= Capacity) {
+        return kernel_try_capacity<PqBits, (Capacity / 2)>(k_max, pq_dim);
+      }
     }
-    return compute_similarity_kernel<OutT,
-                                     LutT,
-                                     IvfSampleFilterT,
-                                     PqBits,
-                                     Capacity,
-                                     PrecompBaseDiff,
-                                     EnableSMemLut>;
+    return ivf::detail::dispatch_static_dim(
+      StaticDims{},
+      pq_dim,
+      [](auto static_pq_dim) -> compute_similarity_kernel_t<OutT, LutT, IvfSampleFilterT> {
+        return compute_similarity_kernel<OutT,
+                                         LutT,
+                                         IvfSampleFilterT,
+                                         PqBits,
+                                         Capacity,
+                                         decltype(static_pq_dim)::value,
+                                         PrecompBaseDiff,
+                                         EnableSMemLut>;
+      });
   }
 };
 
@@ -554,15 +576,17 @@ template <typename OutT,
           typename LutT,
           bool PrecompBaseDiff,
           bool EnableSMemLut,
-          typename IvfSampleFilterT = raft::neighbors::filtering::none_ivf_sample_filter>
-auto get_compute_similarity_kernel(uint32_t pq_bits, uint32_t k_max)
+          typename IvfSampleFilterT = raft::neighbors::filtering::none_ivf_sample_filter,
+          typename StaticDims       = ivf::detail::ann_static_dims>
+auto get_compute_similarity_kernel(uint32_t pq_bits, uint32_t k_max, uint32_t pq_dim)
   -> compute_similarity_kernel_t<OutT, LutT, IvfSampleFilterT>
 {
   return compute_similarity_kernel_config<OutT,
                                           LutT,
                                           PrecompBaseDiff,
                                           EnableSMemLut,
-                                          IvfSampleFilterT>::get(pq_bits, k_max);
+                                          IvfSampleFilterT,
+                                          StaticDims>::get(pq_bits, k_max, pq_dim);
 }
 
 /** Estimate the occupancy for the given kernel on the given device. */
@@ -663,10 +687,14 @@ void compute_similarity_run(selected<OutT, LutT, IvfSampleFilterT> s,
  * @param locality_hint
  *    beyond this limit do not consider increasing the number of active blocks per SM
  *    would improve locality anymore.
+ *
+ * @tparam StaticDims the numbers of PQ subspaces to specialize the kernel for
+ *    (see `ivf::detail::static_dims_t`).
  */
 template <typename OutT,
           typename LutT,
-          typename IvfSampleFilterT = raft::neighbors::filtering::none_ivf_sample_filter>
+          typename IvfSampleFilterT = raft::neighbors::filtering::none_ivf_sample_filter,
+          typename StaticDims       = ivf::detail::ann_static_dims>
 auto compute_similarity_select(const cudaDeviceProp& dev_props,
                                bool manage_local_topk,
                                int locality_hint,
@@ -748,13 +776,17 @@ auto compute_similarity_select(const cudaDeviceProp& dev_props,
    the minimum number of blocks (just one, really). Then, we tweak the `n_threads` to further
    optimize occupancy and data locality for the L1 cache.
    */
-  auto conf_fast        = get_compute_similarity_kernel<OutT, LutT, true, true, IvfSampleFilterT>;
-  auto conf_no_basediff = get_compute_similarity_kernel<OutT, LutT, false, true, IvfSampleFilterT>;
-  auto conf_no_smem_lut = get_compute_similarity_kernel<OutT, LutT, true, false, IvfSampleFilterT>;
+  auto conf_fast        =
+    get_compute_similarity_kernel<OutT, LutT, true, true, IvfSampleFilterT, StaticDims>;
+  auto conf_no_basediff =
+    get_compute_similarity_kernel<OutT, LutT, false, true, IvfSampleFilterT, StaticDims>;
+  auto conf_no_smem_lut =
+    get_compute_similarity_kernel<OutT, LutT, true, false, IvfSampleFilterT, StaticDims>;
   auto topk_or_zero     = manage_local_topk ? topk : 0u;
-  std::array candidates{std::make_tuple(conf_fast(pq_bits, topk_or_zero), lut_mem + bdf_mem, true),
-                        std::make_tuple(conf_no_basediff(pq_bits, topk_or_zero), lut_mem, true),
-                        std::make_tuple(conf_no_smem_lut(pq_bits, topk_or_zero), bdf_mem, false)};
+  std::array candidates{
+    std::make_tuple(conf_fast(pq_bits, topk_or_zero, pq_dim), lut_mem + bdf_mem, true),
+    std::make_tuple(conf_no_basediff(pq_bits, topk_or_zero, pq_dim), lut_mem, true),
+    std::make_tuple(conf_no_smem_lut(pq_bits, topk_or_zero, pq_dim), bdf_mem, false)};
 
   // we may allow slightly lower than 100% occupancy;
   constexpr double kTargetOccupancy = 0.75;
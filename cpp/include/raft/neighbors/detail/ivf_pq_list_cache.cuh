@@ -0,0 +1,335 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/error.hpp>
+#include <raft/core/logger.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/neighbors/ivf_pq_types.hpp>
+#include <raft/util/block_cache.hpp>
+#include <raft/util/cuda_rt_essentials.hpp>
+#include <raft/util/cudart_utils.hpp>
+#include <raft/util/integer_utils.hpp>
+
+#include <rmm/cuda_stream.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace raft::neighbors::ivf_pq::detail {
+
+/**
+ * The inverted lists of an IVF-PQ index moved out of the device memory, together with a device
+ * cache of the lists probed by the recent searches.
+ *
+ * The search copies every probed list that is not resident to a cache slot, evicting a list chosen
+ * by `offload_params::cache_policy`. The copies run in a dedicated stream, so that the copies for a
+ * batch of queries overlap with the similarity computation of the previous batch.
+ */
+template <typename IdxT>
+class list_cache {
+ public:
+  /** Number of batches whose pointer arrays may be in flight at the same time. */
+  static constexpr uint32_t kDepth = 2;
+
+  /**
+   * Move the lists of the index to the host storage. The lists of the index are released, so the
+   * index can only be searched together with this cache afterwards.
+   */
+  list_cache(raft::resources const& res, const offload_params& params, index<IdxT>& index)
+    : n_lists_(index.n_lists()),
+      storage_(params.storage),
+      n_slots_(std::min(params.cache_lists, index.n_lists())),
+      slots_(std::max(n_slots_, 1u), params.cache_policy),
+      list_epoch_(index.n_lists(), 0),
+      data_ptrs_(make_device_matrix<const uint8_t*, uint32_t>(res, kDepth, index.n_lists())),
+      inds_ptrs_(make_device_matrix<const IdxT*, uint32_t>(res, kDepth, index.n_lists())),
+      slots_data_(make_device_vector<uint8_t, size_t>(res, 0)),
+      slots_inds_(make_device_vector<IdxT, size_t>(res, 0))
+  {
+    // The host storage, the pinned arrays and the events are released if the construction fails.
+    try {
+      RAFT_EXPECTS(params.cache_lists > 0, "The cache must hold at least one list");
+      auto stream = resource::get_cuda_stream(res);
+      list_spec<uint32_t, IdxT> spec{
+        index.pq_bits(), index.pq_dim(), index.conservative_memory_allocation()};
+
+      // Layout of the host storage: the data and the indices of every list, 256-byte aligned.
+      sizes_.resize(n_lists_);
+      raft::copy(sizes_.data(), index.list_sizes().data_handle(), n_lists_, stream);
+      resource::sync_stream(res);
+      size_t total_bytes = 0;
+      for (uint32_t label = 0; label < n_lists_; label++) {
+        const auto extents = spec.make_list_extents(sizes_[label]);
+        data_bytes_.push_back(size_t{1} * extents.extent(0) * extents.extent(1) *
+                              extents.extent(2) * extents.extent(3));
+        data_offset_.push_back(total_bytes);
+        total_bytes += raft::round_up_safe<size_t>(data_bytes_.back(), kAlign);
+        inds_offset_.push_back(total_bytes);
+        total_bytes += raft::round_up_safe<size_t>(sizeof(IdxT) * sizes_[label], kAlign);
+        slot_data_bytes_ = std::max(slot_data_bytes_, data_bytes_.back());
+        slot_size_       = std::max<size_t>(slot_size_, sizes_[label]);
+      }
+      slot_data_bytes_ = std::max(raft::round_up_safe<size_t>(slot_data_bytes_, kAlign), kAlign);
+      host_bytes_      = std::max<size_t>(total_bytes, 1);
+      allocate_host_storage(params.file_path);
+
+      // Move the lists out of the device
+      for (uint32_t label = 0; label < n_lists_; label++) {
+        auto& list = index.lists()[label];
+        if (!list || sizes_[label] == 0) { continue; }
+        raft::copy(
+          host_data_ + data_offset_[label], list->data.data_handle(), data_bytes_[label], stream);
+        raft::copy(reinterpret_cast<IdxT*>(host_data_ + inds_offset_[label]),
+                   list->indices.data_handle(),
+                   sizes_[label],
+                   stream);
+      }
+      resource::sync_stream(res);
+      for (auto& list : index.lists()) {
+        list.reset();
+      }
+      RAFT_CUDA_TRY(cudaMemsetAsync(
+        index.data_ptrs().data_handle(), 0, sizeof(uint8_t*) * n_lists_, stream));
+      RAFT_CUDA_TRY(
+        cudaMemsetAsync(index.inds_ptrs().data_handle(), 0, sizeof(IdxT*) * n_lists_, stream));
+
+      // The device cache
+      slots_data_ = make_device_vector<uint8_t, size_t>(res, n_slots_ * slot_data_bytes_);
+      slots_inds_ = make_device_vector<IdxT, size_t>(res, n_slots_ * slot_size_);
+      batch_of_slot_.resize(n_slots_, 0);
+      for (uint32_t d = 0; d < kDepth; d++) {
+        RAFT_CUDA_TRY(cudaMallocHost(&host_data_ptrs_[d], sizeof(uint8_t*) * n_lists_));
+        RAFT_CUDA_TRY(cudaMallocHost(&host_inds_ptrs_[d], sizeof(IdxT*) * n_lists_));
+        RAFT_CUDA_TRY(cudaEventCreateWithFlags(&copied_[d], cudaEventDisableTiming));
+        RAFT_CUDA_TRY(cudaEventCreateWithFlags(&done_[d], cudaEventDisableTiming));
+      }
+      RAFT_LOG_DEBUG(
+        "ivf_pq::list_cache: %zu bytes of lists offloaded, %u device slots of %zu bytes",
+        total_bytes,
+        n_slots_,
+        slot_data_bytes_ + sizeof(IdxT) * slot_size_);
+      // The copy stream starts using the device buffers allocated here
+      resource::sync_stream(res);
+    } catch (...) {
+      release_resources();
+      throw;
+    }
+  }
+
+  list_cache(const list_cache&)                    = delete;
+  list_cache(list_cache&&)                         = delete;
+  auto operator=(const list_cache&) -> list_cache& = delete;
+  auto operator=(list_cache&&) -> list_cache&      = delete;
+
+  ~list_cache() noexcept { release_resources(); }
+
+  /** Number of lists the device cache can hold. */
+  [[nodiscard]] auto capacity() const noexcept -> uint32_t { return n_slots_; }
+  /** The hits and misses of the probed lists (counted once per batch of queries). */
+  [[nodiscard]] auto stats() const noexcept -> const raft::cache::cache_stats&
+  {
+    return slots_.stats();
+  }
+  void reset_stats() noexcept { slots_.reset_stats(); }
+
+  /**
+   * Make the given lists resident in the device cache.
+   *
+   * The main stream of `res` waits for the copies. The returned pointer arrays [n_lists] are valid
+   * for the requested labels only, and until the batch is released with `release`.
+   *
+   * @param labels the host array of the probed lists, possibly repeated [n_labels]
+   */
+  auto fetch(raft::resources const& res, const uint32_t* labels, size_t n_labels)
+    -> std::tuple<const uint8_t* const*, const IdxT* const*>
+  {
+    const uint32_t d = batch_ % kDepth;
+    // The pointer arrays of this depth are not used by the batch `batch_ - kDepth` anymore
+    RAFT_CUDA_TRY(cudaEventSynchronize(done_[d]));
+    auto copy_stream = copy_stream_.value();
+    epoch_++;
+    slots_.begin_batch();
+
+    // Keep the resident lists of the batch from being evicted, before copying the missing ones.
+    std::vector<uint32_t> misses;
+    uint32_t n_distinct = 0;
+    for (size_t i = 0; i < n_labels; i++) {
+      const uint32_t label = labels[i];
+      if (list_epoch_[label] == epoch_) { continue; }
+      list_epoch_[label] = epoch_;
+      n_distinct++;
+      if (slots_.slot_of(label) != slot_map::kNoSlot) {
+        slots_.acquire(label);
+      } else {
+        misses.push_back(label);
+      }
+    }
+    RAFT_EXPECTS(n_distinct <= n_slots_,
+                 "The batch probes %u distinct lists, but the cache holds only %u",
+                 n_distinct,
+                 n_slots_);
+    for (auto label : misses) {
+      const auto assigned = slots_.acquire(label);
+      const uint32_t slot = assigned.slot;
+      // Wait for the searches still reading the evicted list
+      if (assigned.evicted && batch_of_slot_[slot] + kDepth > batch_) {
+        RAFT_CUDA_TRY(cudaStreamWaitEvent(copy_stream, done_[batch_of_slot_[slot] % kDepth], 0));
+      }
+      RAFT_CUDA_TRY(cudaMemcpyAsync(slot_data(slot),
+                                    host_data_ + data_offset_[label],
+                                    data_bytes_[label],
+                                    cudaMemcpyHostToDevice,
+                                    copy_stream));
+      RAFT_CUDA_TRY(cudaMemcpyAsync(slot_inds(slot),
+                                    host_data_ + inds_offset_[label],
+                                    sizeof(IdxT) * sizes_[label],
+                                    cudaMemcpyHostToDevice,
+                                    copy_stream));
+    }
+    RAFT_LOG_DEBUG("ivf_pq::list_cache: %u lists probed, %zu copied", n_distinct, misses.size());
+
+    for (size_t i = 0; i < n_labels; i++) {
+      const uint32_t label      = labels[i];
+      const uint32_t slot       = slots_.slot_of(label);
+      batch_of_slot_[slot]      = batch_;
+      host_data_ptrs_[d][label] = slot_data(slot);
+      host_inds_ptrs_[d][label] = slot_inds(slot);
+    }
+    RAFT_CUDA_TRY(cudaMemcpyAsync(&data_ptrs_(d, 0),
+                                  host_data_ptrs_[d],
+                                  sizeof(uint8_t*) * n_lists_,
+                                  cudaMemcpyHostToDevice,
+                                  copy_stream));
+    RAFT_CUDA_TRY(cudaMemcpyAsync(&inds_ptrs_(d, 0),
+                                  host_inds_ptrs_[d],
+                                  sizeof(IdxT*) * n_lists_,
+                                  cudaMemcpyHostToDevice,
+                                  copy_stream));
+    RAFT_CUDA_TRY(cudaEventRecord(copied_[d], copy_stream));
+    RAFT_CUDA_TRY(cudaStreamWaitEvent(resource::get_cuda_stream(res), copied_[d], 0));
+    return {&data_ptrs_(d, 0), &inds_ptrs_(d, 0)};
+  }
+
+  /** Mark the end of the work on the lists of the last fetched batch in the main stream. */
+  void release(raft::resources const& res)
+  {
+    RAFT_CUDA_TRY(cudaEventRecord(done_[batch_ % kDepth], resource::get_cuda_stream(res)));
+    batch_++;
+  }
+
+ private:
+  static constexpr size_t kAlign = 256;
+  using slot_map                  = raft::cache::slot_map<uint32_t>;
+
+  uint32_t n_lists_;
+  list_storage storage_;
+  std::vector<uint32_t> sizes_;
+  std::vector<size_t> data_bytes_;
+  std::vector<size_t> data_offset_;
+  std::vector<size_t> inds_offset_;
+  size_t slot_data_bytes_ = 0;
+  size_t slot_size_       = 0;
+
+  // Host storage of the lists
+  uint8_t* host_data_ = nullptr;
+  size_t host_bytes_  = 0;
+  int fd_             = -1;
+
+  // Device cache
+  uint32_t n_slots_;
+  slot_map slots_;
+  std::vector<uint64_t> batch_of_slot_;
+  std::vector<uint64_t> list_epoch_;
+  uint64_t epoch_ = 0;
+  uint64_t batch_ = 0;
+
+  rmm::cuda_stream copy_stream_;
+  device_matrix<const uint8_t*, uint32_t, row_major> data_ptrs_;
+  device_matrix<const IdxT*, uint32_t, row_major> inds_ptrs_;
+  device_vector<uint8_t, size_t> slots_data_;
+  device_vector<IdxT, size_t> slots_inds_;
+  const uint8_t** host_data_ptrs_[kDepth] = {};
+  const IdxT** host_inds_ptrs_[kDepth]    = {};
+  cudaEvent_t copied_[kDepth]             = {};
+  cudaEvent_t done_[kDepth]               = {};
+
+  auto slot_data(uint32_t slot) -> uint8_t*
+  {
+    return slots_data_.data_handle() + slot * slot_data_bytes_;
+  }
+  auto slot_inds(uint32_t slot) -> IdxT* { return slots_inds_.data_handle() + slot * slot_size_; }
+
+  void allocate_host_storage(const std::string& file_path)
+  {
+    if (storage_ == list_storage::PINNED_HOST) {
+      RAFT_CUDA_TRY(cudaMallocHost(&host_data_, host_bytes_));
+      return;
+    }
+    RAFT_EXPECTS(!file_path.empty(), "A file path is required for the MAPPED_FILE storage");
+    fd_ = open(file_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) { RAFT_FAIL("Cannot open file %s", file_path.c_str()); }
+    if (ftruncate(fd_, host_bytes_) != 0) {
+      RAFT_FAIL("Cannot resize file %s to %zu bytes", file_path.c_str(), host_bytes_);
+    }
+    void* mapped = mmap(nullptr, host_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (mapped == MAP_FAILED) { RAFT_FAIL("Cannot map file %s", file_path.c_str()); }
+    host_data_ = static_cast<uint8_t*>(mapped);
+  }
+
+  /** Release the host storage, the pinned pointer arrays and the events allocated so far. */
+  void release_resources() noexcept
+  {
+    RAFT_CUDA_TRY_NO_THROW(cudaStreamSynchronize(copy_stream_.value()));
+    for (uint32_t d = 0; d < kDepth; d++) {
+      if (done_[d] != nullptr) {
+        RAFT_CUDA_TRY_NO_THROW(cudaEventSynchronize(done_[d]));
+        RAFT_CUDA_TRY_NO_THROW(cudaEventDestroy(done_[d]));
+      }
+      if (copied_[d] != nullptr) { RAFT_CUDA_TRY_NO_THROW(cudaEventDestroy(copied_[d])); }
+      RAFT_CUDA_TRY_NO_THROW(cudaFreeHost(host_data_ptrs_[d]));
+      RAFT_CUDA_TRY_NO_THROW(cudaFreeHost(host_inds_ptrs_[d]));
+    }
+    if (host_data_ != nullptr) {
+      if (storage_ == list_storage::PINNED_HOST) {
+        RAFT_CUDA_TRY_NO_THROW(cudaFreeHost(host_data_));
+      } else {
+        munmap(host_data_, host_bytes_);
+      }
+    }
+    if (fd_ >= 0) { close(fd_); }
+  }
+};
+
+}  // namespace raft::neighbors::ivf_pq::detail
+
+namespace raft::neighbors::ivf_pq {
+
+/** @copydoc raft::neighbors::ivf_pq::detail::list_cache */
+template <typename IdxT>
+using list_cache = detail::list_cache<IdxT>;
+
+}  // namespace raft::neighbors::ivf_pq
@@ -17,18 +17,27 @@
 #pragma once
 
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/cuda_stream_pool.hpp>
 #include <raft/core/resource/device_properties.hpp>
+#include <raft/core/workspace_arena_resource.hpp>
 #include <raft/spatial/knn/detail/ann_utils.cuh>
 
+#include <raft/neighbors/detail/ivf_adaptive_probes.cuh>
+#include <raft/neighbors/detail/ivf_pq_codepacking.cuh>
 #include <raft/neighbors/detail/ivf_pq_compute_similarity.cuh>
 #include <raft/neighbors/detail/ivf_pq_dummy_block_sort.cuh>
 #include <raft/neighbors/detail/ivf_pq_fp_8bit.cuh>
+#include <raft/neighbors/detail/ivf_pq_list_cache.cuh>
+#include <raft/neighbors/detail/ivf_pq_search_small_batch.cuh>
+#include <raft/neighbors/detail/ivf_probe_inversion.cuh>
+#include <raft/neighbors/detail/ivf_static_dims.hpp>
 #include <raft/neighbors/ivf_pq_types.hpp>
 #include <raft/neighbors/sample_filter_types.hpp>
 
 #include <raft/core/cudart_utils.hpp>
 #include <raft/core/device_mdarray.hpp>
 #include <raft/core/logger.hpp>
+#include <raft/core/metrics.hpp>
 #include <raft/core/nvtx.hpp>
 #include <raft/core/operators.hpp>
 #include <raft/core/resources.hpp>
@@ -51,7 +60,11 @@
 
 #include <cuda_fp16.h>
 
+#include <algorithm>
+#include <memory>
 #include <optional>
+#include <tuple>
+#include <vector>
 
 namespace raft::neighbors::ivf_pq::detail {
 
@@ -76,7 +89,8 @@ void select_clusters(raft::resources const& handle,
                      raft::distance::DistanceType metric,
                      const T* queries,              // [n_queries, dim]
                      const float* cluster_centers,  // [n_lists, dim_ext]
-                     rmm::mr::device_memory_resource* mr)
+                     rmm::mr::device_memory_resource* mr,
+                     float* coarse_dists = nullptr)  // [n_queries, n_probes]
 {
   auto stream = resource::get_cuda_stream(handle);
   /* NOTE[qc_distances]
@@ -97,8 +111,14 @@ void select_clusters(raft::resources const& handle,
 
       This is a negative inner-product distance. We minimize it to find the similar clusters.
 
-      NB: qc_distances is NOT used further in ivfpq_search.
+      NB: qc_distances is NOT used further in ivfpq_search, except for the adaptive probing
+          (the selected `coarse_dists`).
+
+    Cosine distance:
+      the same as the IP distance, but the queries are normalized (see `utils::internal_metric`).
  */
+  const bool normalize_queries = metric == raft::distance::DistanceType::CosineExpanded;
+  metric                       = utils::internal_metric(metric);
   float norm_factor;
   switch (metric) {
     case raft::distance::DistanceType::L2SqrtExpanded:
@@ -114,6 +134,8 @@ void select_clusters(raft::resources const& handle,
       uint32_t row = ix / dim_ext;
       return col < dim ? utils::mapping<float>{}(queries[col + dim * row]) : norm_factor;
     });
+  // NB: the extra columns are zeros for the inner product, they don't change the norms.
+  if (normalize_queries) { utils::normalize_rows(handle, float_queries, n_queries, dim_ext); }
 
   float alpha;
   float beta;
@@ -150,13 +172,16 @@ void select_clusters(raft::resources const& handle,
                stream);
 
   // Select neighbor clusters for each query.
-  rmm::device_uvector<float> cluster_dists(n_queries * n_probes, stream, mr);
+  rmm::device_uvector<float> cluster_dists(coarse_dists == nullptr ? n_queries * n_probes : 0,
+                                           stream,
+                                           mr);
   matrix::detail::select_k<float, uint32_t>(qc_distances.data(),
                                             nullptr,
                                             n_queries,
                                             n_lists,
                                             n_probes,
-                                            cluster_dists.data(),
+                                            coarse_dists == nullptr ? cluster_dists.data()
+                                                                    : coarse_dists,
                                             clusters_to_probe,
                                             true,
                                             stream,
@@ -173,6 +198,7 @@ __launch_bounds__(BlockDim) __global__
   void calc_chunk_indices_kernel(uint32_t n_probes,
                                  const uint32_t* cluster_sizes,      // [n_clusters]
                                  const uint32_t* clusters_to_probe,  // [n_queries, n_probes]
+                                 const uint32_t* probe_counts,       // [n_queries] or nullptr
                                  uint32_t* chunk_indices,            // [n_queries, n_probes]
                                  uint32_t* n_samples                 // [n_queries]
   )
@@ -184,12 +210,15 @@ __launch_bounds__(BlockDim) __global__
   clusters_to_probe += n_probes * blockIdx.x;
   chunk_indices += n_probes * blockIdx.x;
 
+  // the probes dropped by the adaptive probing yield empty chunks
+  const uint32_t n_probes_used = probe_counts != nullptr ? probe_counts[blockIdx.x] : n_probes;
+
   // block scan
   const uint32_t n_probes_aligned = Pow2<BlockDim>::roundUp(n_probes);
   uint32_t total                  = 0;
   for (uint32_t probe_ix = threadIdx.x; probe_ix < n_probes_aligned; probe_ix += BlockDim) {
     auto label = probe_ix < n_probes ? clusters_to_probe[probe_ix] : 0u;
-    auto chunk = probe_ix < n_probes ? cluster_sizes[label] : 0u;
+    auto chunk = probe_ix < n_probes_used ? cluster_sizes[label] : 0u;
     if (threadIdx.x == 0) { chunk += total; }
     block_scan(shm).InclusiveSum(chunk, chunk, total);
     __syncthreads();
@@ -209,12 +238,13 @@ struct calc_chunk_indices {
 
     inline void operator()(const uint32_t* cluster_sizes,
                            const uint32_t* clusters_to_probe,
+                           const uint32_t* probe_counts,
                            uint32_t* chunk_indices,
                            uint32_t* n_samples,
                            rmm::cuda_stream_view stream)
     {
       void* args[] =  // NOLINT
-        {&n_probes, &cluster_sizes, &clusters_to_probe, &chunk_indices, &n_samples};
+        {&n_probes, &cluster_sizes, &clusters_to_probe, &probe_counts, &chunk_indices, &n_samples};
       RAFT_CUDA_TRY(cudaLaunchKernel(kernel, grid_dim, block_dim, args, 0, stream));
     }
   };
@@ -328,6 +358,124 @@ void postprocess_neighbors(IdxT* neighbors_out,                // [n_queries, to
                                            topk);
 }
 
+/**
+ * Score the candidates again with both PQ layers of the index (one candidate per warp).
+ *
+ * The candidates are the sample indices selected by the first layer, as in
+ * `postprocess_neighbors`; the score is that of the first layer (the squared L2 distance or the
+ * negated inner product in the rotated space), but computed with the reconstruction of the record
+ * by its center, its PQ code and its residual PQ code. The invalid candidates (out of bounds or
+ * filtered out) keep the worst score.
+ */
+template <int BlockDim, typename ScoreT>
+__launch_bounds__(BlockDim) __global__ void rerank_residual_kernel(
+  float* scores_out,                         // [n_queries, n_cand]
+  const ScoreT* scores_in,                   // [n_queries, n_cand]
+  const uint32_t* candidates,                // [n_queries, n_cand]
+  const float* queries,                      // [n_queries, rot_dim]
+  const float* centers_rot,                  // [n_lists, rot_dim]
+  device_mdspan<const float, extent_3d<uint32_t>, row_major> pq_centers,
+  device_mdspan<const float, extent_3d<uint32_t>, row_major> residual_pq_centers,
+  const uint8_t* const* data_ptrs,           // [n_lists]
+  const uint8_t* const* residual_data_ptrs,  // [n_lists]
+  const uint32_t* clusters_to_probe,         // [n_queries, n_probes]
+  const uint32_t* chunk_indices,             // [n_queries, n_probes]
+  uint32_t n_queries,
+  uint32_t n_probes,
+  uint32_t n_cand,
+  uint32_t pq_bits,
+  uint32_t residual_pq_bits,
+  codebook_gen codebook_kind,
+  bool inner_product)
+{
+  const uint64_t i        = (threadIdx.x + BlockDim * uint64_t(blockIdx.x)) / WarpSize;
+  const uint32_t lane_id  = threadIdx.x % WarpSize;
+  const uint32_t query_ix = i / uint64_t(n_cand);
+  if (query_ix >= n_queries) { return; }
+  const uint32_t pq_dim  = residual_pq_centers.extent(0);
+  const uint32_t pq_len  = residual_pq_centers.extent(1);
+  const uint32_t rot_dim = pq_dim * pq_len;
+  chunk_indices += uint64_t(n_probes) * query_ix;
+  clusters_to_probe += uint64_t(n_probes) * query_ix;
+  queries += uint64_t(rot_dim) * query_ix;
+
+  uint32_t data_ix        = candidates[i];
+  const uint32_t chunk_ix = find_chunk_ix(data_ix, n_probes, chunk_indices);
+  if (chunk_ix >= n_probes || !(float(scores_in[i]) < upper_bound<float>())) {
+    if (lane_id == 0) { scores_out[i] = upper_bound<float>(); }
+    return;
+  }
+  const uint32_t label  = clusters_to_probe[chunk_ix];
+  const float* center   = centers_rot + uint64_t(rot_dim) * label;
+  const uint8_t* codes  = data_ptrs[label];
+  const uint8_t* codes2 = residual_data_ptrs[label];
+  float score           = 0.0f;
+  for (uint32_t j = lane_id; j < pq_dim; j += WarpSize) {
+    const uint32_t partition_ix = codebook_kind == codebook_gen::PER_CLUSTER ? label : j;
+    const uint32_t code         = read_code(codes, pq_bits, pq_dim, data_ix, j);
+    const uint32_t code2        = read_code(codes2, residual_pq_bits, pq_dim, data_ix, j);
+    for (uint32_t k = 0; k < pq_len; k++) {
+      const uint32_t l = j * pq_len + k;
+      const float x =
+        center[l] + pq_centers(partition_ix, k, code) + residual_pq_centers(j, k, code2);
+      if (inner_product) {
+        score -= queries[l] * x;
+      } else {
+        const float d = queries[l] - x;
+        score += d * d;
+      }
+    }
+  }
+#pragma unroll
+  for (uint32_t stride = WarpSize >> 1; stride > 0; stride >>= 1) {
+    score += shfl_xor(score, stride);
+  }
+  if (lane_id == 0) { scores_out[i] = score; }
+}
+
+/**
+ * Re-rank the candidates of the first PQ layer with both layers of the index
+ * (see `rerank_residual_kernel`).
+ */
+template <typename ScoreT, typename IdxT>
+void rerank_residual(const index<IdxT>& index,
+                     float* scores_out,                  // [n_queries, n_cand]
+                     const ScoreT* scores_in,            // [n_queries, n_cand]
+                     const uint32_t* candidates,         // [n_queries, n_cand]
+                     const float* queries,               // [n_queries, rot_dim]
+                     const uint8_t* const* data_ptrs,    // [n_lists]
+                     const uint32_t* clusters_to_probe,  // [n_queries, n_probes]
+                     const uint32_t* chunk_indices,      // [n_queries, n_probes]
+                     uint32_t n_queries,
+                     uint32_t n_probes,
+                     uint32_t n_cand,
+                     rmm::cuda_stream_view stream)
+{
+  constexpr int kBlockDim = 256;
+  const auto n_blocks =
+    raft::div_rounding_up_safe<uint64_t>(uint64_t(n_queries) * n_cand, kBlockDim / WarpSize);
+  rerank_residual_kernel<kBlockDim, ScoreT><<<n_blocks, kBlockDim, 0, stream>>>(
+    scores_out,
+    scores_in,
+    candidates,
+    queries,
+    index.centers_rot().data_handle(),
+    index.pq_centers(),
+    index.residual_pq_centers(),
+    data_ptrs,
+    index.residual_data_ptrs().data_handle(),
+    clusters_to_probe,
+    chunk_indices,
+    n_queries,
+    n_probes,
+    n_cand,
+    index.pq_bits(),
+    index.residual_pq_bits(),
+    index.codebook_kind(),
+    utils::internal_metric(index.metric()) == distance::DistanceType::InnerProduct);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
 /**
  * Post-process the scores depending on the metric type;
  * translate the element type if necessary.
@@ -370,6 +518,16 @@ void postprocess_distances(float* out,        // [n_queries, topk]
                                        raft::cast_op<float>{}),
                       stream);
     } break;
+    case distance::DistanceType::CosineExpanded: {
+      // `1 - ip` of the normalized vectors, where the score is `-ip`
+      linalg::unaryOp(out,
+                      in,
+                      len,
+                      raft::compose_op(raft::add_const_op<float>{1.0f},
+                                       raft::mul_const_op<float>{scaling_factor * scaling_factor},
+                                       raft::cast_op<float>{}),
+                      stream);
+    } break;
     default: RAFT_FAIL("Unexpected metric.");
   }
 }
@@ -413,18 +571,31 @@ constexpr inline auto expected_probe_coresidency(uint32_t n_clusters,
  *   1. computed the closest clusters to probe (`clusters_to_probe`);
  *   2. transformed input queries into the rotated space (rot_dim);
  *   3. split the query batch into smaller chunks, so that the device workspace
- *      is guaranteed to fit into GPU memory.
+ *      is guaranteed to fit into GPU memory;
+ *   4. resolved the device pointers to the data and indices of the probed lists
+ *      (`data_ptrs`, `inds_ptrs`).
+ *
+ * With a positive `n_candidates` (the indices with the residual PQ layer), the first layer selects
+ * that many candidates, which are then re-ranked with both layers to select the `topK`.
  */
-template <typename ScoreT, typename LutT, typename IvfSampleFilterT, typename IdxT>
+template <typename ScoreT,
+          typename LutT,
+          typename IvfSampleFilterT,
+          typename IdxT,
+          typename StaticDims = ivf::detail::ann_static_dims>
 void ivfpq_search_worker(raft::resources const& handle,
                          const index<IdxT>& index,
                          uint32_t max_samples,
                          uint32_t n_probes,
                          uint32_t topK,
+                         uint32_t n_candidates,
                          uint32_t n_queries,
                          uint32_t queries_offset,            // needed for filtering
                          const uint32_t* clusters_to_probe,  // [n_queries, n_probes]
+                         const uint32_t* probe_counts,       // [n_queries] or nullptr
                          const float* query,                 // [n_queries, rot_dim]
+                         const uint8_t* const* data_ptrs,    // [n_lists]
+                         const IdxT* const* inds_ptrs,       // [n_lists]
                          IdxT* neighbors,                    // [n_queries, topK]
                          float* distances,                   // [n_queries, topK]
                          float scaling_factor,
@@ -434,8 +605,12 @@ void ivfpq_search_worker(raft::resources const& handle,
 {
   auto stream = resource::get_cuda_stream(handle);
 
-  bool manage_local_topk = is_local_topk_feasible(topK, n_probes, n_queries);
-  auto topk_len          = manage_local_topk ? n_probes * topK : max_samples;
+  // The number of the records selected by the first layer
+  const bool rerank     = n_candidates > 0;
+  const uint32_t n_cand = rerank ? n_candidates : topK;
+
+  bool manage_local_topk = is_local_topk_feasible(n_cand, n_probes, n_queries);
+  auto topk_len          = manage_local_topk ? n_probes * n_cand : max_samples;
   if (manage_local_topk) {
     RAFT_LOG_DEBUG("Fused version of the search kernel is selected (manage_local_topk == true)");
   } else {
@@ -457,15 +632,16 @@ void ivfpq_search_worker(raft::resources const& handle,
   }
   rmm::device_uvector<uint32_t> neighbors_uint32_buf(0, stream, mr);
   uint32_t* neighbors_uint32 = nullptr;
-  if constexpr (sizeof(IdxT) == sizeof(uint32_t)) {
+  if (sizeof(IdxT) == sizeof(uint32_t) && !rerank) {
     neighbors_uint32 = reinterpret_cast<uint32_t*>(neighbors);
   } else {
-    neighbors_uint32_buf.resize(n_queries * topK, stream);
+    neighbors_uint32_buf.resize(n_queries * n_cand, stream);
     neighbors_uint32 = neighbors_uint32_buf.data();
   }
 
   calc_chunk_indices::configure(n_probes, n_queries)(index.list_sizes().data_handle(),
                                                      clusters_to_probe,
+                                                     probe_counts,
                                                      chunk_index.data(),
                                                      num_samples.data(),
                                                      stream);
@@ -478,43 +654,21 @@ void ivfpq_search_worker(raft::resources const& handle,
     // of a cluster by processing the cluster at the same time as much as
     // possible.
     index_list_sorted_buf.resize(n_queries * n_probes, stream);
-    auto index_list_buf =
-      make_device_mdarray<uint32_t>(handle, mr, make_extents<uint32_t>(n_queries * n_probes));
-    rmm::device_uvector<uint32_t> cluster_labels_out(n_queries * n_probes, stream, mr);
-    auto index_list   = index_list_buf.data_handle();
     index_list_sorted = index_list_sorted_buf.data();
-
-    linalg::map_offset(handle, index_list_buf.view(), identity_op{});
-
-    int begin_bit             = 0;
-    int end_bit               = sizeof(uint32_t) * 8;
-    size_t cub_workspace_size = 0;
-    cub::DeviceRadixSort::SortPairs(nullptr,
-                                    cub_workspace_size,
-                                    clusters_to_probe,
-                                    cluster_labels_out.data(),
-                                    index_list,
-                                    index_list_sorted,
-                                    n_queries * n_probes,
-                                    begin_bit,
-                                    end_bit,
-                                    stream);
-    rmm::device_buffer cub_workspace(cub_workspace_size, stream, mr);
-    cub::DeviceRadixSort::SortPairs(cub_workspace.data(),
-                                    cub_workspace_size,
-                                    clusters_to_probe,
-                                    cluster_labels_out.data(),
-                                    index_list,
-                                    index_list_sorted,
-                                    n_queries * n_probes,
-                                    begin_bit,
-                                    end_bit,
-                                    stream);
+    ivf::detail::invert_probes(handle,
+                               clusters_to_probe,
+                               n_queries,
+                               n_probes,
+                               index.n_lists(),
+                               index_list_sorted,
+                               nullptr,
+                               mr);
   }
 
   // select and run the main search kernel
+  const auto metric           = utils::internal_metric(index.metric());
   uint32_t precomp_data_count = 0;
-  switch (index.metric()) {
+  switch (metric) {
     case distance::DistanceType::L2SqrtExpanded:
     case distance::DistanceType::L2SqrtUnexpanded:
     case distance::DistanceType::L2Unexpanded:
@@ -523,15 +677,15 @@ void ivfpq_search_worker(raft::resources const& handle,
       precomp_data_count = index.rot_dim();
     } break;
     case distance::DistanceType::InnerProduct: {
-      // stores two components (query[i] * center[i], query[i] * center[i])
-      precomp_data_count = index.rot_dim() * 2;
+      // stores the query (query[i]); the query-center term is added to the scores afterwards
+      precomp_data_count = index.rot_dim();
     } break;
     default: {
       RAFT_FAIL("Unsupported metric");
     } break;
   }
 
-  auto search_instance = compute_similarity_select<ScoreT, LutT, IvfSampleFilterT>(
+  auto search_instance = compute_similarity_select<ScoreT, LutT, IvfSampleFilterT, StaticDims>(
     resource::get_device_properties(handle),
     manage_local_topk,
     coresidency,
@@ -541,7 +695,7 @@ void ivfpq_search_worker(raft::resources const& handle,
     precomp_data_count,
     n_queries,
     n_probes,
-    topK);
+    n_cand);
 
   rmm::device_uvector<LutT> device_lut(search_instance.device_lut_size, stream, mr);
   std::optional<device_vector<float>> query_kths_buf{std::nullopt};
@@ -554,6 +708,9 @@ void ivfpq_search_worker(raft::resources const& handle,
                 raft::const_op<float>{dummy_block_sort_t<ScoreT, IdxT>::queue_t::kDummy});
     query_kths = query_kths_buf->data_handle();
   }
+  // NB: the LUT is computed by the scan kernel itself, hence it is timed as a part of the scan.
+  std::optional<raft::metrics::stream_timer> phase_timer;
+  phase_timer.emplace("ivf_pq::search::scan", stream);
   compute_similarity_run(search_instance,
                          stream,
                          index.size(),
@@ -562,13 +719,13 @@ void ivfpq_search_worker(raft::resources const& handle,
                          index.pq_dim(),
                          n_queries,
                          queries_offset,
-                         index.metric(),
+                         metric,
                          index.codebook_kind(),
-                         topK,
+                         n_cand,
                          max_samples,
                          index.centers_rot().data_handle(),
                          index.pq_centers().data_handle(),
-                         index.data_ptrs().data_handle(),
+                         data_ptrs,
                          clusters_to_probe,
                          chunk_index.data(),
                          query,
@@ -580,24 +737,71 @@ void ivfpq_search_worker(raft::resources const& handle,
                          neighbors_ptr);
 
   // Select topk vectors for each query
-  rmm::device_uvector<ScoreT> topk_dists(n_queries * topK, stream, mr);
+  phase_timer.emplace("ivf_pq::search::select", stream);
+  rmm::device_uvector<ScoreT> topk_dists(n_queries * n_cand, stream, mr);
   matrix::detail::select_k<ScoreT, uint32_t>(distances_buf.data(),
                                              neighbors_ptr,
                                              n_queries,
                                              topk_len,
-                                             topK,
+                                             n_cand,
                                              topk_dists.data(),
                                              neighbors_uint32,
                                              true,
                                              stream,
                                              mr);
 
+  if (rerank) {
+    phase_timer.emplace("ivf_pq::search::rerank", stream);
+    rmm::device_uvector<float> cand_dists(n_queries * n_cand, stream, mr);
+    rerank_residual(index,
+                    cand_dists.data(),
+                    topk_dists.data(),
+                    neighbors_uint32,
+                    query,
+                    data_ptrs,
+                    clusters_to_probe,
+                    chunk_index.data(),
+                    n_queries,
+                    n_probes,
+                    n_cand,
+                    stream);
+    rmm::device_uvector<float> rerank_dists(n_queries * topK, stream, mr);
+    rmm::device_uvector<uint32_t> rerank_neighbors_buf(0, stream, mr);
+    uint32_t* rerank_neighbors = reinterpret_cast<uint32_t*>(neighbors);
+    if constexpr (sizeof(IdxT) != sizeof(uint32_t)) {
+      rerank_neighbors_buf.resize(n_queries * topK, stream);
+      rerank_neighbors = rerank_neighbors_buf.data();
+    }
+    matrix::detail::select_k<float, uint32_t>(cand_dists.data(),
+                                              neighbors_uint32,
+                                              n_queries,
+                                              n_cand,
+                                              topK,
+                                              rerank_dists.data(),
+                                              rerank_neighbors,
+                                              true,
+                                              stream,
+                                              mr);
+    postprocess_distances(
+      distances, rerank_dists.data(), index.metric(), n_queries, topK, scaling_factor, stream);
+    postprocess_neighbors(neighbors,
+                          rerank_neighbors,
+                          inds_ptrs,
+                          clusters_to_probe,
+                          chunk_index.data(),
+                          n_queries,
+                          n_probes,
+                          topK,
+                          stream);
+    return;
+  }
+
   // Postprocessing
   postprocess_distances(
     distances, topk_dists.data(), index.metric(), n_queries, topK, scaling_factor, stream);
   postprocess_neighbors(neighbors,
                         neighbors_uint32,
-                        index.inds_ptrs().data_handle(),
+                        inds_ptrs,
                         clusters_to_probe,
                         chunk_index.data(),
                         n_queries,
@@ -610,10 +814,12 @@ void ivfpq_search_worker(raft::resources const& handle,
  * This structure helps selecting a proper instance of the worker search function,
  * which contains a few template parameters.
  */
-template <typename IdxT, typename IvfSampleFilterT>
+template <typename IdxT,
+          typename IvfSampleFilterT,
+          typename StaticDims = ivf::detail::ann_static_dims>
 struct ivfpq_search {
  public:
-  using fun_t = decltype(&ivfpq_search_worker<float, float, IvfSampleFilterT, IdxT>);
+  using fun_t = decltype(&ivfpq_search_worker<float, float, IvfSampleFilterT, IdxT, StaticDims>);
 
   /**
    * Select an instance of the ivf-pq search function based on search tuning parameters,
@@ -629,7 +835,7 @@ struct ivfpq_search {
   static auto filter_reasonable_instances(const search_params& params) -> fun_t
   {
     if constexpr (sizeof(ScoreT) >= sizeof(LutT)) {
-      return ivfpq_search_worker<ScoreT, LutT, IvfSampleFilterT, IdxT>;
+      return ivfpq_search_worker<ScoreT, LutT, IvfSampleFilterT, IdxT, StaticDims>;
     } else {
       RAFT_FAIL(
         "Unexpected lut_dtype / internal_distance_dtype combination (%d, %d). "
@@ -682,13 +888,15 @@ struct ivfpq_search {
  * @param n_queries number of queries hoped to be processed at once.
  *                  (maximum value for the returned batch size)
  * @param max_samples maximum possible number of samples to be processed for the given `n_probes`
+ * @param max_ws_size the limit of the tmp distance buffer size (in elements)
  *
  * @return maximum recommended batch size.
  */
 inline auto get_max_batch_size(uint32_t k,
                                uint32_t n_probes,
                                uint32_t n_queries,
-                               uint32_t max_samples) -> uint32_t
+                               uint32_t max_samples,
+                               uint64_t max_ws_size = uint64_t{1024} * 1024 * 1024) -> uint32_t
 {
   uint32_t max_batch_size         = n_queries;
   uint32_t n_ctas_total           = getMultiProcessorCount() * 2;
@@ -704,11 +912,10 @@ inline auto get_max_batch_size(uint32_t k,
   auto ws_size = [k, n_probes, max_samples](uint32_t bs) -> uint64_t {
     return uint64_t(is_local_topk_feasible(k, n_probes, bs) ? k * n_probes : max_samples) * bs;
   };
-  constexpr uint64_t kMaxWsSize = 1024 * 1024 * 1024;
-  if (ws_size(max_batch_size) > kMaxWsSize) {
+  if (ws_size(max_batch_size) > max_ws_size) {
     uint32_t smaller_batch_size = bound_by_power_of_two(max_batch_size);
     // gradually reduce the batch size until we fit into the max size limit.
-    while (smaller_batch_size > 1 && ws_size(smaller_batch_size) > kMaxWsSize) {
+    while (smaller_batch_size > 1 && ws_size(smaller_batch_size) > max_ws_size) {
       smaller_batch_size >>= 1;
     }
     return smaller_batch_size;
@@ -716,10 +923,116 @@ inline auto get_max_batch_size(uint32_t k,
   return max_batch_size;
 }
 
-/** See raft::spatial::knn::ivf_pq::search docs */
+/**
+ * Estimate the peak device memory of the temporary buffers of `search` for `n_queries` queries.
+ *
+ * The estimate follows the batching of the search (chunks of at most 4096 queries, cut into the
+ * batches of `get_max_batch_size`) on a single stream; the lookup tables spilled to the global
+ * memory by the kernel and the buffers of the k-selection are not counted.
+ *
+ * @param max_samples the number of the records in the `n_probes` largest lists
+ */
+template <typename IdxT>
+auto estimate_search_workspace(const search_params& params,
+                               uint32_t n_lists,
+                               uint32_t dim_ext,
+                               uint32_t rot_dim,
+                               uint32_t max_samples,
+                               uint32_t n_queries,
+                               uint32_t k) -> size_t
+{
+  const uint32_t n_probes = std::min<uint32_t>(params.n_probes, n_lists);
+  if (n_queries == 0 || n_probes == 0) { return 0; }
+  const uint32_t max_queries = std::min<uint32_t>(n_queries, 4096);
+  max_samples                = Pow2<128>::roundUp(max_samples);
+  const size_t batch_size    = get_max_batch_size(k, n_probes, max_queries, max_samples);
+  const size_t score_size =
+    params.internal_distance_dtype == CUDA_R_16F ? sizeof(half) : sizeof(float);
+
+  // the converted and rotated queries and the probed clusters of a chunk of queries
+  const size_t chunk_bytes =
+    max_queries * (sizeof(float) * (dim_ext + rot_dim) + sizeof(uint32_t) * n_probes);
+  // the coarse search: the distances to all the centers and to the probed ones
+  const size_t select_bytes = sizeof(float) * max_queries * (n_lists + n_probes);
+  // the fine search of a batch: the candidates per query and the selected neighbors
+  const bool local_topk      = is_local_topk_feasible(k, n_probes, batch_size);
+  const size_t topk_len      = local_topk ? size_t(n_probes) * k : max_samples;
+  const size_t candidate_len = score_size + (local_topk ? sizeof(uint32_t) : 0);
+  size_t scan_bytes =
+    batch_size * (sizeof(uint32_t) * (n_probes + 1) + topk_len * candidate_len + score_size * k);
+  if constexpr (sizeof(IdxT) != sizeof(uint32_t)) {
+    scan_bytes += batch_size * k * sizeof(uint32_t);
+  }
+  return chunk_bytes + std::max(select_bytes, scan_bytes);
+}
+
+/** Estimate the peak device memory of the temporary buffers of `search` in this index. */
+template <typename IdxT>
+auto estimate_search_workspace(const search_params& params,
+                               const index<IdxT>& index,
+                               uint32_t n_queries,
+                               uint32_t k) -> size_t
+{
+  const uint32_t n_probes = std::min<uint32_t>(params.n_probes, index.n_lists());
+  const auto max_samples  = static_cast<uint32_t>(std::min<IdxT>(
+    index.accum_sorted_sizes()(n_probes), IdxT(std::numeric_limits<uint32_t>::max() - 128)));
+  // The re-ranking selects more candidates by the first layer (its own buffers are not counted).
+  const uint32_t n_first = index.residual_pq_bits() > 0 && params.residual_rerank_ratio > 0
+                             ? k * params.residual_rerank_ratio
+                             : k;
+  return estimate_search_workspace<IdxT>(
+    params, index.n_lists(), index.dim_ext(), index.rot_dim(), max_samples, n_queries, n_first);
+}
+
+/**
+ * The largest number of queries, starting from the first one and up to `max_batch_size`, that
+ * probe at most `max_lists` distinct lists.
+ *
+ * @param clusters_to_probe the host array of the probed lists [max_batch_size, n_probes]
+ * @param marks a zeroed host work array [n_lists]; it is zeroed again on return
+ */
+inline auto bound_batch_by_cache(const uint32_t* clusters_to_probe,
+                                 uint32_t max_batch_size,
+                                 uint32_t n_probes,
+                                 uint32_t max_lists,
+                                 std::vector<uint32_t>& marks) -> uint32_t
+{
+  uint32_t n_distinct = 0;
+  uint32_t batch_size = 0;
+  for (; batch_size < max_batch_size; batch_size++) {
+    const uint32_t* probes = clusters_to_probe + uint64_t(n_probes) * batch_size;
+    uint32_t n_new         = 0;
+    for (uint32_t j = 0; j < n_probes; j++) {
+      if (marks[probes[j]] == 0) {
+        marks[probes[j]] = batch_size + 1;
+        n_new++;
+      }
+    }
+    if (n_distinct + n_new > max_lists) {
+      // Roll back the lists of the query that does not fit
+      for (uint32_t j = 0; j < n_probes; j++) {
+        if (marks[probes[j]] == batch_size + 1) { marks[probes[j]] = 0; }
+      }
+      break;
+    }
+    n_distinct += n_new;
+  }
+  for (uint32_t i = 0; i < batch_size * n_probes; i++) {
+    marks[clusters_to_probe[i]] = 0;
+  }
+  return batch_size;
+}
+
+/**
+ * See raft::spatial::knn::ivf_pq::search docs
+ *
+ * @tparam StaticDims the numbers of PQ subspaces to specialize the similarity kernel for
+ *   (see `ivf::detail::static_dims_t`)
+ */
 template <typename T,
           typename IdxT,
-          typename IvfSampleFilterT = raft::neighbors::filtering::none_ivf_sample_filter>
+          typename IvfSampleFilterT = raft::neighbors::filtering::none_ivf_sample_filter,
+          typename StaticDims       = ivf::detail::ann_static_dims>
 inline void search(raft::resources const& handle,
                    const search_params& params,
                    const index<IdxT>& index,
@@ -729,7 +1042,8 @@ inline void search(raft::resources const& handle,
                    IdxT* neighbors,
                    float* distances,
                    rmm::mr::device_memory_resource* mr = nullptr,
-                   IvfSampleFilterT sample_filter      = IvfSampleFilterT())
+                   IvfSampleFilterT sample_filter      = IvfSampleFilterT(),
+                   list_cache<IdxT>* cache             = nullptr)
 {
   static_assert(std::is_same_v<T, float> || std::is_same_v<T, uint8_t> || std::is_same_v<T, int8_t>,
                 "Unsupported element type.");
@@ -754,6 +1068,10 @@ inline void search(raft::resources const& handle,
     static_cast<uint64_t>(index.size()));
   RAFT_EXPECTS(params.n_probes > 0,
                "n_probes (number of clusters to probe in the search) must be positive.");
+  RAFT_EXPECTS(cache == nullptr || std::min(params.n_probes, index.n_lists()) <= cache->capacity(),
+               "n_probes (%u) must not exceed the number of lists in the cache (%u)",
+               params.n_probes,
+               cache->capacity());
 
   switch (utils::check_pointer_residency(queries, neighbors, distances)) {
     case utils::pointer_residency::device_only:
@@ -775,42 +1093,121 @@ inline void search(raft::resources const& handle,
     max_samples = ms;
   }
 
+  // With the residual PQ layer, the first layer selects the candidates to re-rank with both layers
+  // (at least `k` and at most as many as there may be samples).
+  const bool rerank = index.residual_pq_bits() > 0 && params.residual_rerank_ratio > 0;
+  const uint32_t n_candidates =
+    rerank ? std::max<uint32_t>(
+               k, std::min<uint64_t>(uint64_t(k) * params.residual_rerank_ratio, max_samples))
+           : 0;
+  const uint32_t n_first = rerank ? n_candidates : k;
+
+  // A handful of queries is searched by a single kernel, one block per query, to reduce latency.
+  // NB: the small-batch search reads the lists directly and does not normalize the queries, hence
+  //     it is used neither with the list cache nor with the cosine distance; it does not re-rank.
+  const bool adaptive_probing =
+    ivf::detail::is_adaptive_probing(params.max_candidates, params.probe_distance_ratio);
+  if (cache == nullptr && !adaptive_probing && !rerank &&
+      index.metric() != distance::DistanceType::CosineExpanded &&
+      is_small_batch_search_feasible(n_queries, n_probes, k)) {
+    auto small_batch_instance =
+      small_batch_search<T, IdxT, IvfSampleFilterT>::fun(params, index.metric());
+    if (small_batch_instance(handle,
+                             index,
+                             queries,
+                             n_queries,
+                             n_probes,
+                             k,
+                             neighbors,
+                             distances,
+                             utils::config<T>::kDivisor / utils::config<float>::kDivisor,
+                             sample_filter)) {
+      return;
+    }
+  }
+
   auto pool_guard = raft::get_pool_memory_resource(mr, n_queries * n_probes * k * 16);
   if (pool_guard) {
     RAFT_LOG_DEBUG("ivf_pq::search: using pool memory resource with initial size %zu bytes",
                    n_queries * n_probes * k * 16ull);
   }
 
-  // Maximum number of query vectors to search at the same time.
-  const auto max_queries = std::min<uint32_t>(std::max<uint32_t>(n_queries, 1), 4096);
-  auto max_batch_size    = get_max_batch_size(k, n_probes, max_queries, max_samples);
-
-  rmm::device_uvector<float> float_queries(max_queries * dim_ext, stream, mr);
-  rmm::device_uvector<float> rot_queries(max_queries * index.rot_dim(), stream, mr);
-  rmm::device_uvector<uint32_t> clusters_to_probe(max_queries * n_probes, stream, mr);
-
-  auto search_instance = ivfpq_search<IdxT, IvfSampleFilterT>::fun(params, index.metric());
-
-  for (uint32_t offset_q = 0; offset_q < n_queries; offset_q += max_queries) {
-    uint32_t queries_batch = min(max_queries, n_queries - offset_q);
-
-    select_clusters(handle,
-                    clusters_to_probe.data(),
-                    float_queries.data(),
+  auto search_instance = ivfpq_search<IdxT, IvfSampleFilterT, StaticDims>::fun(
+    params, utils::internal_metric(index.metric()));
+
+  std::vector<uint32_t> clusters_host;
+  std::vector<uint32_t> list_marks(cache != nullptr ? index.n_lists() : 0, 0);
+
+  // Search a chunk of queries in the stream of the given resources.
+  auto search_chunk = [&](raft::resources const& res,
+                          float* float_queries,         // [queries_batch, dim_ext]
+                          float* rot_queries,           // [queries_batch, rot_dim]
+                          uint32_t* clusters_to_probe,  // [queries_batch, n_probes]
+                          uint32_t max_batch_size,
+                          uint32_t offset_q,
+                          uint32_t queries_batch,
+                          const T* chunk_queries,    // [queries_batch, dim]
+                          IdxT* chunk_neighbors,     // [queries_batch, k]
+                          float* chunk_distances) {  // [queries_batch, k]
+    auto chunk_stream = resource::get_cuda_stream(res);
+    // Past the deadline, the remaining queries probe their closest cluster only.
+    const bool late           = ivf::detail::is_past_deadline(res, params.deadline, offset_q > 0);
+    const bool chunk_adaptive = adaptive_probing || late;
+    std::optional<raft::metrics::stream_timer> coarse_timer;
+    coarse_timer.emplace("ivf_pq::search::coarse_search", chunk_stream);
+    rmm::device_uvector<float> coarse_dists(
+      chunk_adaptive ? queries_batch * n_probes : 0, chunk_stream, mr);
+    rmm::device_uvector<uint32_t> probe_counts(
+      chunk_adaptive ? queries_batch : 0, chunk_stream, mr);
+    select_clusters(res,
+                    clusters_to_probe,
+                    float_queries,
                     queries_batch,
                     n_probes,
                     index.n_lists(),
                     dim,
                     dim_ext,
                     index.metric(),
-                    queries + static_cast<size_t>(dim) * offset_q,
+                    chunk_queries,
                     index.centers().data_handle(),
-                    mr);
+                    mr,
+                    chunk_adaptive ? coarse_dists.data() : nullptr);
+    if (chunk_adaptive) {
+      // The L2 coarse distances lack the squared norms of the queries, see NOTE[qc_distances];
+      // the distance ratio is not defined for the inner product.
+      const bool is_l2 = utils::internal_metric(index.metric()) !=
+                         distance::DistanceType::InnerProduct;
+      rmm::device_uvector<float> query_norms(is_l2 ? queries_batch : 0, chunk_stream, mr);
+      if (is_l2) {
+        linalg::map_offset(
+          res,
+          raft::make_device_vector_view<float, uint32_t>(query_norms.data(), queries_batch),
+          [float_queries, dim, dim_ext] __device__(uint32_t i) {
+            const float* q = float_queries + size_t(dim_ext) * i;
+            float norm     = 0.0f;
+            for (uint32_t j = 0; j < dim; j++) {
+              norm += q[j] * q[j];
+            }
+            return norm;
+          });
+      }
+      ivf::detail::adaptive_probes(res,
+                                   queries_batch,
+                                   n_probes,
+                                   coarse_dists.data(),
+                                   is_l2 ? query_norms.data() : nullptr,
+                                   clusters_to_probe,
+                                   index.list_sizes().data_handle(),
+                                   late ? 1 : params.max_candidates,
+                                   is_l2 && !late ? params.probe_distance_ratio : 0.0f,
+                                   false,
+                                   probe_counts.data());
+    }
 
     // Rotate queries
     float alpha = 1.0;
     float beta  = 0.0;
-    linalg::gemm(handle,
+    linalg::gemm(res,
                  true,
                  false,
                  index.rot_dim(),
@@ -819,35 +1216,168 @@ inline void search(raft::resources const& handle,
                  &alpha,
                  index.rotation_matrix().data_handle(),
                  dim,
-                 float_queries.data(),
+                 float_queries,
                  dim_ext,
                  &beta,
-                 rot_queries.data(),
+                 rot_queries,
                  index.rot_dim(),
-                 stream);
+                 chunk_stream);
+    coarse_timer.reset();
+
+    // With the offloaded lists, the batches are also bounded by the capacity of the cache.
+    if (cache != nullptr) {
+      clusters_host.resize(queries_batch * n_probes);
+      raft::copy(clusters_host.data(), clusters_to_probe, clusters_host.size(), chunk_stream);
+      resource::sync_stream(res);
+    }
 
-    for (uint32_t offset_b = 0; offset_b < queries_batch; offset_b += max_batch_size) {
-      uint32_t batch_size = min(max_batch_size, queries_batch - offset_b);
+    for (uint32_t offset_b = 0, batch_size = 0; offset_b < queries_batch; offset_b += batch_size) {
+      batch_size                      = min(max_batch_size, queries_batch - offset_b);
+      const uint8_t* const* data_ptrs = index.data_ptrs().data_handle();
+      const IdxT* const* inds_ptrs    = index.inds_ptrs().data_handle();
+      if (cache != nullptr) {
+        batch_size = bound_batch_by_cache(clusters_host.data() + uint64_t(n_probes) * offset_b,
+                                          batch_size,
+                                          n_probes,
+                                          cache->capacity(),
+                                          list_marks);
+        std::tie(data_ptrs, inds_ptrs) = cache->fetch(
+          res, clusters_host.data() + uint64_t(n_probes) * offset_b, batch_size * n_probes);
+      }
       /* The distance calculation is done in the rotated/transformed space;
          as long as `index.rotation_matrix()` is orthogonal, the distances and thus results are
          preserved.
        */
-      search_instance(handle,
+      search_instance(res,
                       index,
                       max_samples,
                       n_probes,
                       k,
+                      n_candidates,
                       batch_size,
                       offset_q + offset_b,
-                      clusters_to_probe.data() + uint64_t(n_probes) * offset_b,
-                      rot_queries.data() + uint64_t(index.rot_dim()) * offset_b,
-                      neighbors + uint64_t(k) * (offset_q + offset_b),
-                      distances + uint64_t(k) * (offset_q + offset_b),
+                      clusters_to_probe + uint64_t(n_probes) * offset_b,
+                      chunk_adaptive ? probe_counts.data() + offset_b : nullptr,
+                      rot_queries + uint64_t(index.rot_dim()) * offset_b,
+                      data_ptrs,
+                      inds_ptrs,
+                      chunk_neighbors + uint64_t(k) * offset_b,
+                      chunk_distances + uint64_t(k) * offset_b,
                       utils::config<T>::kDivisor / utils::config<float>::kDivisor,
                       params.preferred_shmem_carveout,
                       sample_filter,
                       mr);
+      if (cache != nullptr) { cache->release(res); }
     }
+  };
+
+  // Maximum number of query vectors to search at the same time.
+  const auto max_queries = std::min<uint32_t>(std::max<uint32_t>(n_queries, 1), 4096);
+  // With a bounded workspace arena, the tmp distance buffers (a distance and an index per element)
+  // are kept within a half of the remaining capacity, leaving the rest to the other temporaries.
+  uint64_t max_ws_size = uint64_t{1024} * 1024 * 1024;
+  if (auto* arena = dynamic_cast<raft::workspace_arena_resource*>(mr); arena != nullptr) {
+    const uint64_t bytes_per_element = sizeof(float) + sizeof(uint32_t);
+    max_ws_size = std::min<uint64_t>(max_ws_size, arena->free_bytes() / (2 * bytes_per_element));
+  }
+  auto max_batch_size =
+    get_max_batch_size(n_first, n_probes, max_queries, max_samples, max_ws_size);
+  raft::metrics::record(
+    "ivf_pq::search::batch_size", raft::metrics::metric_kind::count, max_batch_size);
+
+  // With a stream pool, the batches are pipelined over (at most) two streams: the `select_k` of
+  // one batch and the transfers of its queries and results overlap with the scan of the next
+  // batch. The list cache is shared by all batches, hence it is not used in the pipelined mode.
+  constexpr size_t kMaxPipelineStreams = 2;
+  const uint32_t n_batches             = raft::ceildiv(n_queries, max_batch_size);
+  const size_t n_streams =
+    cache == nullptr && resource::is_stream_pool_initialized(handle)
+      ? std::min({resource::get_stream_pool_size(handle), kMaxPipelineStreams, size_t(n_batches)})
+      : 1;
+  if (n_streams <= 1) {
+    rmm::device_uvector<float> float_queries(max_queries * dim_ext, stream, mr);
+    rmm::device_uvector<float> rot_queries(max_queries * index.rot_dim(), stream, mr);
+    rmm::device_uvector<uint32_t> clusters_to_probe(max_queries * n_probes, stream, mr);
+    for (uint32_t offset_q = 0; offset_q < n_queries; offset_q += max_queries) {
+      uint32_t queries_batch = min(max_queries, n_queries - offset_q);
+      search_chunk(handle,
+                   float_queries.data(),
+                   rot_queries.data(),
+                   clusters_to_probe.data(),
+                   max_batch_size,
+                   offset_q,
+                   queries_batch,
+                   queries + static_cast<size_t>(dim) * offset_q,
+                   neighbors + uint64_t(k) * offset_q,
+                   distances + uint64_t(k) * offset_q);
+    }
+    return;
+  }
+
+  RAFT_LOG_DEBUG("ivf_pq::search: %u batches over %zu streams", n_batches, size_t(n_streams));
+  // The queries and results outside of the device memory (e.g. pinned or managed host memory) are
+  // staged through the device buffers, so that their transfers run in the streams of the batches.
+  const bool stage_queries =
+    utils::check_pointer_residency(queries) != utils::pointer_residency::device_only;
+  const bool stage_results =
+    utils::check_pointer_residency(neighbors, distances) != utils::pointer_residency::device_only;
+  // The buffers of all streams are allocated (and freed) in the main stream.
+  const size_t n_slots = n_streams * max_batch_size;
+  rmm::device_uvector<float> float_queries(n_slots * dim_ext, stream, mr);
+  rmm::device_uvector<float> rot_queries(n_slots * index.rot_dim(), stream, mr);
+  rmm::device_uvector<uint32_t> clusters_to_probe(n_slots * n_probes, stream, mr);
+  rmm::device_uvector<T> queries_buf(stage_queries ? n_slots * dim : 0, stream, mr);
+  rmm::device_uvector<IdxT> neighbors_buf(stage_results ? n_slots * k : 0, stream, mr);
+  rmm::device_uvector<float> distances_buf(stage_results ? n_slots * k : 0, stream, mr);
+
+  // The inputs are ready in the main stream
+  resource::wait_stream_pool_on_stream(handle);
+  std::vector<std::unique_ptr<raft::resources>> stream_res;
+  for (size_t i = 0; i < n_streams; i++) {
+    stream_res.push_back(std::make_unique<raft::resources>(handle));
+    resource::set_cuda_stream(*stream_res[i], resource::get_stream_from_stream_pool(handle, i));
+  }
+  for (uint32_t batch = 0; batch < n_batches; batch++) {
+    const size_t i           = batch % n_streams;
+    const auto& res          = *stream_res[i];
+    auto batch_stream        = resource::get_cuda_stream(res);
+    const uint32_t offset_q  = batch * max_batch_size;
+    const uint32_t n_batch_q = min(max_batch_size, n_queries - offset_q);
+    const size_t slot        = i * max_batch_size;
+
+    const T* batch_queries = queries + static_cast<size_t>(dim) * offset_q;
+    IdxT* batch_neighbors  = neighbors + uint64_t(k) * offset_q;
+    float* batch_distances = distances + uint64_t(k) * offset_q;
+    if (stage_queries) {
+      raft::copy(queries_buf.data() + slot * dim, batch_queries, n_batch_q * dim, batch_stream);
+      batch_queries = queries_buf.data() + slot * dim;
+    }
+    if (stage_results) {
+      batch_neighbors = neighbors_buf.data() + slot * k;
+      batch_distances = distances_buf.data() + slot * k;
+    }
+    search_chunk(res,
+                 float_queries.data() + slot * dim_ext,
+                 rot_queries.data() + slot * index.rot_dim(),
+                 clusters_to_probe.data() + slot * n_probes,
+                 max_batch_size,
+                 offset_q,
+                 n_batch_q,
+                 batch_queries,
+                 batch_neighbors,
+                 batch_distances);
+    if (stage_results) {
+      raft::copy(neighbors + uint64_t(k) * offset_q, batch_neighbors, n_batch_q * k, batch_stream);
+      raft::copy(distances + uint64_t(k) * offset_q, batch_distances, n_batch_q * k, batch_stream);
+    }
+  }
+  // The main stream waits for all the batches before the buffers are freed.
+  for (size_t i = 0; i < n_streams; i++) {
+    cudaEvent_t event;
+    RAFT_CUDA_TRY(cudaEventCreateWithFlags(&event, cudaEventDisableTiming));
+    RAFT_CUDA_TRY(cudaEventRecord(event, resource::get_stream_from_stream_pool(handle, i)));
+    RAFT_CUDA_TRY(cudaStreamWaitEvent(stream, event, 0));
+    RAFT_CUDA_TRY(cudaEventDestroy(event));
   }
 }
 
@@ -0,0 +1,500 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_properties.hpp>
+#include <raft/spatial/knn/detail/ann_utils.cuh>
+
+#include <raft/neighbors/detail/ivf_pq_compute_score.cuh>
+#include <raft/neighbors/detail/ivf_pq_fp_8bit.cuh>
+#include <raft/neighbors/ivf_pq_types.hpp>
+#include <raft/neighbors/sample_filter_types.hpp>
+
+#include <raft/core/logger.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/matrix/detail/select_warpsort.cuh>
+#include <raft/util/cuda_rt_essentials.hpp>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+#include <raft/util/integer_utils.hpp>
+#include <raft/util/pow2_utils.cuh>
+#include <raft/util/reduction.cuh>
+#include <raft/util/vectorized.cuh>
+
+#include <cuda_fp16.h>
+
+#include <algorithm>
+
+namespace raft::neighbors::ivf_pq::detail {
+
+using namespace raft::spatial::knn::detail;  // NOLINT
+
+/**
+ * The small-batch search does the whole search of a query in one thread block: the coarse
+ * search (selecting the clusters to probe), the rotation of the query, and, for every probed
+ * cluster, the construction of the lookup table and the scan of the cluster. The results are
+ * merged in a block-wide top-k queue and written out post-processed.
+ *
+ * This saves about a dozen of kernel launches and the intermediate buffers of the regular search,
+ * which dominate the latency for a handful of queries; in exchange, the probed clusters of a query
+ * are processed sequentially by a single block. Hence the path is only used for tiny batches.
+ */
+
+/** Maximum number of queries, for which the small-batch search is selected. */
+constexpr static uint32_t kSmallBatchMaxQueries = 8;
+/** Maximum value of both `k` and `n_probes` in the small-batch search. */
+constexpr static int kSmallBatchMaxCapacity = 128;
+/** The block size of the small-batch search kernel. */
+constexpr static uint32_t kSmallBatchBlockDim = 512;
+
+inline auto is_small_batch_search_feasible(uint32_t n_queries, uint32_t n_probes, uint32_t k)
+  -> bool
+{
+  return n_queries > 0 && n_queries <= kSmallBatchMaxQueries &&
+         std::max(n_probes, k) <= uint32_t(kSmallBatchMaxCapacity);
+}
+
+/**
+ * Offsets (in bytes) of the shared memory buffers of the small-batch search kernel.
+ *
+ * The lookup table shares its buffer with the merge buffer of the block-wide top-k queues: the
+ * coarse queue is merged before the first lookup table is built and the fine queue is merged after
+ * the last cluster is scanned.
+ */
+struct small_batch_smem_layout {
+  uint32_t query;        // float [dim]
+  uint32_t rot_query;    // float [rot_dim]
+  uint32_t probes;       // uint32_t [n_probes]
+  uint32_t probe_dists;  // float [n_probes]
+  uint32_t out_dists;    // OutT [topk]
+  uint32_t out_inds;     // IdxT [topk]
+  uint32_t shared;       // LutT [pq_dim << pq_bits] or the top-k merge buffer
+  uint32_t total_size;
+};
+
+template <typename OutT, typename LutT, typename IdxT>
+auto make_small_batch_smem_layout(uint32_t dim,
+                                  uint32_t rot_dim,
+                                  uint32_t pq_dim,
+                                  uint32_t pq_bits,
+                                  uint32_t n_probes,
+                                  uint32_t topk) -> small_batch_smem_layout
+{
+  namespace warpsort     = matrix::detail::select::warpsort;
+  using align            = Pow2<256>;
+  const uint32_t n_warps = kSmallBatchBlockDim / WarpSize;
+  small_batch_smem_layout l{};
+  l.query       = 0;
+  l.rot_query   = align::roundUp(l.query + sizeof(float) * dim);
+  l.probes      = align::roundUp(l.rot_query + sizeof(float) * rot_dim);
+  l.probe_dists = align::roundUp(l.probes + sizeof(uint32_t) * n_probes);
+  l.out_dists   = align::roundUp(l.probe_dists + sizeof(float) * n_probes);
+  l.out_inds    = align::roundUp(l.out_dists + sizeof(OutT) * topk);
+  l.shared      = align::roundUp(l.out_inds + sizeof(IdxT) * topk);
+  size_t shared_size =
+    std::max<size_t>({sizeof(LutT) * (pq_dim << pq_bits),
+                      warpsort::calc_smem_size_for_block_wide<float, uint32_t>(n_warps, n_probes),
+                      warpsort::calc_smem_size_for_block_wide<OutT, IdxT>(n_warps, topk)});
+  l.total_size = l.shared + shared_size;
+  return l;
+}
+
+/** The final transformation of the scores, the same as in `postprocess_distances`. */
+__device__ inline auto small_batch_postprocess_distance(distance::DistanceType metric,
+                                                        float score,
+                                                        float scaling_factor) -> float
+{
+  switch (metric) {
+    case distance::DistanceType::L2SqrtUnexpanded:
+    case distance::DistanceType::L2SqrtExpanded: return scaling_factor * sqrtf(score);
+    case distance::DistanceType::InnerProduct: return -scaling_factor * scaling_factor * score;
+    default: return scaling_factor * scaling_factor * score;
+  }
+}
+
+/**
+ * The small-batch search kernel; one block per query.
+ *
+ * @tparam T the element type of the queries.
+ * @tparam OutT the internal distance type.
+ * @tparam LutT the element type of the lookup table.
+ * @tparam PqBits the bit length of an encoded vector element.
+ * @tparam Capacity power-of-two, not smaller than both `n_probes` and `topk`.
+ *
+ * @param layout the shared memory buffers
+ * @param dim the dimensionality of the data (before the rotation)
+ * @param dim_ext the row width of the `cluster_centers` (see `index::dim_ext`)
+ * @param rot_dim the dimensionality of the data after rotation
+ * @param n_lists the number of clusters in the index
+ * @param n_probes the number of clusters to search for each query
+ * @param pq_dim the dimensionality of an encoded vector after compression by PQ
+ * @param topk the `k` in the select top-k
+ * @param metric the distance type
+ * @param codebook_kind defines the way PQ codebooks have been trained
+ * @param queries the device pointer to the queries [n_queries, dim]
+ * @param cluster_centers the cluster centers with the norms (see `index::centers`)
+ *   [n_lists, dim_ext]
+ * @param cluster_centers_rot the cluster centers in the rotated space [n_lists, rot_dim]
+ * @param rotation_matrix the rotation matrix [rot_dim, dim]
+ * @param pq_centers the PQ codebooks (see `index::pq_centers`)
+ * @param list_sizes the sizes of the clusters [n_lists]
+ * @param data_ptrs the pointers to the PQ-encoded data of the clusters [n_lists]
+ * @param inds_ptrs the pointers to the source indices of the clusters [n_lists]
+ * @param sample_filter a filter that selects samples for a given query
+ * @param scaling_factor the scaling of the distances due to the query type conversion
+ * @param neighbors the output neighbors [n_queries, topk]
+ * @param distances the output distances [n_queries, topk]
+ */
+template <typename T,
+          typename OutT,
+          typename LutT,
+          typename IdxT,
+          typename IvfSampleFilterT,
+          uint32_t PqBits,
+          int Capacity>
+__launch_bounds__(kSmallBatchBlockDim) __global__
+  void small_batch_search_kernel(small_batch_smem_layout layout,
+                                 uint32_t dim,
+                                 uint32_t dim_ext,
+                                 uint32_t rot_dim,
+                                 uint32_t n_lists,
+                                 uint32_t n_probes,
+                                 uint32_t pq_dim,
+                                 uint32_t topk,
+                                 distance::DistanceType metric,
+                                 codebook_gen codebook_kind,
+                                 const T* queries,
+                                 const float* cluster_centers,
+                                 const float* cluster_centers_rot,
+                                 const float* rotation_matrix,
+                                 const float* pq_centers,
+                                 const uint32_t* list_sizes,
+                                 const uint8_t* const* data_ptrs,
+                                 const IdxT* const* inds_ptrs,
+                                 IvfSampleFilterT sample_filter,
+                                 float scaling_factor,
+                                 IdxT* neighbors,
+                                 float* distances)
+{
+  extern __shared__ __align__(256) uint8_t smem_buf[];  // NOLINT
+  namespace warpsort = matrix::detail::select::warpsort;
+  using coarse_topk_t =
+    warpsort::block_sort<warpsort::warp_sort_distributed, Capacity, true, float, uint32_t>;
+  using fine_topk_t =
+    warpsort::block_sort<warpsort::warp_sort_distributed, Capacity, true, OutT, IdxT>;
+  using group_align = Pow2<kIndexGroupSize>;
+  using vec_align   = Pow2<kIndexGroupVecLen>;
+  using vec_t       = TxN_t<uint32_t, kIndexGroupVecLen / sizeof(uint32_t)>;
+  constexpr uint32_t kPqShift   = 1u << PqBits;
+  constexpr uint32_t kPqMask    = kPqShift - 1u;
+  constexpr uint32_t kChunkSize = (kIndexGroupVecLen * 8u) / PqBits;
+  constexpr OutT kDummy         = upper_bound<OutT>();
+
+  const uint32_t query_ix = blockIdx.x;
+  const uint32_t lane_id  = Pow2<WarpSize>::mod(threadIdx.x);
+  const uint32_t warp_id  = Pow2<WarpSize>::div(threadIdx.x);
+  const uint32_t n_warps  = Pow2<WarpSize>::div(blockDim.x);
+  const uint32_t pq_len   = rot_dim / pq_dim;
+  const uint32_t lut_size = pq_dim * kPqShift;
+
+  auto query       = reinterpret_cast<float*>(smem_buf + layout.query);
+  auto rot_query   = reinterpret_cast<float*>(smem_buf + layout.rot_query);
+  auto probes      = reinterpret_cast<uint32_t*>(smem_buf + layout.probes);
+  auto probe_dists = reinterpret_cast<float*>(smem_buf + layout.probe_dists);
+  auto out_dists   = reinterpret_cast<OutT*>(smem_buf + layout.out_dists);
+  auto out_inds    = reinterpret_cast<IdxT*>(smem_buf + layout.out_inds);
+  auto lut_scores  = reinterpret_cast<LutT*>(smem_buf + layout.shared);
+
+  // The rows of the queries are read with vector loads, whatever their alignment, and only once
+  queries += size_t(dim) * size_t(query_ix);
+  vectorized_for_each<true>(
+    queries,
+    dim,
+    [query](uint32_t i, T x) { query[i] = utils::mapping<float>{}(x); },
+    uint32_t(threadIdx.x),
+    uint32_t(blockDim.x));
+  __syncthreads();
+
+  // Rotate the query; a warp per output component.
+  for (uint32_t i = warp_id; i < rot_dim; i += n_warps) {
+    const float* row = rotation_matrix + size_t(dim) * size_t(i);
+    float r          = 0.0f;
+    vectorized_for_each(
+      row,
+      dim,
+      [&r, query](uint32_t j, float x) { r += x * query[j]; },
+      lane_id,
+      uint32_t(WarpSize));
+    r = warpReduce(r);
+    if (lane_id == 0) { rot_query[i] = r; }
+  }
+
+  // Select the clusters to probe, using the same scores as `select_clusters`
+  // (see NOTE[qc_distances]). A warp computes the scores for a group of WarpSize clusters, one
+  // cluster at a time; every lane keeps the score of one cluster of the group.
+  {
+    coarse_topk_t coarse_topk(n_probes);
+    const bool is_ip = metric == distance::DistanceType::InnerProduct;
+    for (uint32_t group = warp_id * WarpSize; group < n_lists; group += n_warps * WarpSize) {
+      float score = coarse_topk_t::queue_t::kDummy;
+      for (uint32_t j = 0; j < WarpSize && group + j < n_lists; j++) {
+        const float* center = cluster_centers + size_t(dim_ext) * size_t(group + j);
+        float s             = 0.0f;
+        for (uint32_t d = lane_id; d < dim; d += WarpSize) {
+          s += query[d] * center[d];
+        }
+        s = warpReduce(s);
+        if (lane_id == j) { score = is_ip ? -s : center[dim] - 2.0f * s; }
+      }
+      coarse_topk.add(score, group + lane_id);
+    }
+    coarse_topk.done(smem_buf + layout.shared);
+    coarse_topk.store(probe_dists, probes);
+  }
+
+  // Scan the probed clusters.
+  fine_topk_t fine_topk(topk);
+  for (uint32_t probe_ix = 0; probe_ix < n_probes; probe_ix++) {
+    // The probes are ready, and the lookup table of the previous probe is not used anymore.
+    __syncthreads();
+    const uint32_t label        = probes[probe_ix];
+    const float* cluster_center = cluster_centers_rot + size_t(rot_dim) * size_t(label);
+    const float* pq_center;
+    if (codebook_kind == codebook_gen::PER_SUBSPACE) {
+      pq_center = pq_centers;
+    } else {
+      pq_center = pq_centers + (pq_len << PqBits) * label;
+    }
+
+    // Create a lookup table (the same as in `compute_similarity_kernel`)
+    for (uint32_t i = threadIdx.x; i < lut_size; i += blockDim.x) {
+      const uint32_t i_pq  = i >> PqBits;
+      uint32_t j           = i_pq * pq_len;
+      const uint32_t j_end = pq_len + j;
+      auto cur_pq_center   = pq_center + (i & kPqMask) +
+                           (codebook_kind == codebook_gen::PER_SUBSPACE ? j * kPqShift : 0u);
+      float score = 0.0;
+      do {
+        float pq_c = *cur_pq_center;
+        cur_pq_center += kPqShift;
+        switch (metric) {
+          case distance::DistanceType::L2SqrtExpanded:
+          case distance::DistanceType::L2Expanded: {
+            float diff = rot_query[j] - cluster_center[j] - pq_c;
+            score += diff * diff;
+          } break;
+          case distance::DistanceType::InnerProduct: {
+            // NB: we negate the scores as we hardcoded select-topk to always compute the minimum
+            float q = rot_query[j];
+            score -= q * (cluster_center[j] + pq_c);
+          } break;
+          default: __builtin_unreachable();
+        }
+      } while (++j < j_end);
+      lut_scores[i] = LutT(score);
+    }
+    __syncthreads();
+
+    const uint32_t n_samples         = list_sizes[label];
+    const uint32_t n_samples_aligned = group_align::roundUp(n_samples);
+    uint32_t pq_line_width = div_rounding_up_unsafe(pq_dim, kChunkSize) * kIndexGroupVecLen;
+    auto pq_thread_data    = data_ptrs[label] +
+                          group_align::roundDown(threadIdx.x) * pq_line_width +
+                          group_align::mod(threadIdx.x) * vec_align::Value;
+    pq_line_width *= blockDim.x;
+    const IdxT* list_inds = inds_ptrs[label];
+    for (uint32_t i = threadIdx.x; i < n_samples_aligned;
+         i += blockDim.x, pq_thread_data += pq_line_width) {
+      OutT score = kDummy;
+      IdxT ix    = kOutOfBoundsRecord<IdxT>;
+      if (i < n_samples && sample_filter(query_ix, label, i)) {
+        score = ivfpq_compute_score<OutT, LutT, vec_t, PqBits>(
+          pq_dim, reinterpret_cast<const vec_t::io_t*>(pq_thread_data), lut_scores, kDummy);
+        ix = list_inds[i];
+      }
+      fine_topk.add(score, ix);
+    }
+  }
+  // The lookup table buffer is reused by the queue.
+  __syncthreads();
+  fine_topk.done(smem_buf + layout.shared);
+  fine_topk.store(out_dists, out_inds);
+  __syncthreads();
+
+  neighbors += size_t(topk) * size_t(query_ix);
+  distances += size_t(topk) * size_t(query_ix);
+  for (uint32_t i = threadIdx.x; i < topk; i += blockDim.x) {
+    const OutT score = out_dists[i];
+    neighbors[i]     = score < kDummy ? out_inds[i] : kOutOfBoundsRecord<IdxT>;
+    distances[i]     = small_batch_postprocess_distance(metric, float(score), scaling_factor);
+  }
+}
+
+// The signature of the kernel defined by a minimal set of template parameters
+template <typename T, typename OutT, typename LutT, typename IdxT, typename IvfSampleFilterT>
+using small_batch_search_kernel_t =
+  decltype(&small_batch_search_kernel<T, OutT, LutT, IdxT, IvfSampleFilterT, 8, WarpSize>);
+
+// The config struct lifts the runtime parameters to the template parameters
+template <typename T, typename OutT, typename LutT, typename IdxT, typename IvfSampleFilterT>
+struct small_batch_search_kernel_config {
+ public:
+  static auto get(uint32_t pq_bits, uint32_t k_max)
+    -> small_batch_search_kernel_t<T, OutT, LutT, IdxT, IvfSampleFilterT>
+  {
+    switch (pq_bits) {
+      case 4: return kernel_try_capacity<4, kSmallBatchMaxCapacity>(k_max);
+      case 5: return kernel_try_capacity<5, kSmallBatchMaxCapacity>(k_max);
+      case 6: return kernel_try_capacity<6, kSmallBatchMaxCapacity>(k_max);
+      case 7: return kernel_try_capacity<7, kSmallBatchMaxCapacity>(k_max);
+      case 8: return kernel_try_capacity<8, kSmallBatchMaxCapacity>(k_max);
+      default: RAFT_FAIL("Invalid pq_bits (%u), the value must be within [4, 8]", pq_bits);
+    }
+  }
+
+ private:
+  template <uint32_t PqBits, int Capacity>
+  static auto kernel_try_capacity(uint32_t k_max)
+    -> small_batch_search_kernel_t<T, OutT, LutT, IdxT, IvfSampleFilterT>
+  {
+    // NB: the capacity is not reduced below the warp size to keep the number of instances low.
+    if constexpr (Capacity > WarpSize) {
+      if (k_max * 2 <= Capacity) { return kernel_try_capacity<PqBits, (Capacity / 2)>(k_max); }
+    }
+    return small_batch_search_kernel<T, OutT, LutT, IdxT, IvfSampleFilterT, PqBits, Capacity>;
+  }
+};
+
+/**
+ * Run the small-batch search for all queries at once.
+ *
+ * @return whether the search has been done; `false` means the configuration (the lookup table
+ *   size) does not fit into the shared memory, and the regular search should be used instead.
+ */
+template <typename T, typename OutT, typename LutT, typename IvfSampleFilterT, typename IdxT>
+auto small_batch_search_worker(raft::resources const& handle,
+                               const index<IdxT>& index,
+                               const T* queries,
+                               uint32_t n_queries,
+                               uint32_t n_probes,
+                               uint32_t topk,
+                               IdxT* neighbors,
+                               float* distances,
+                               float scaling_factor,
+                               IvfSampleFilterT sample_filter) -> bool
+{
+  switch (index.metric()) {
+    case distance::DistanceType::L2SqrtExpanded:
+    case distance::DistanceType::L2Expanded:
+    case distance::DistanceType::InnerProduct: break;
+    default: RAFT_FAIL("Unsupported metric");
+  }
+  auto stream           = resource::get_cuda_stream(handle);
+  const auto& dev_props = resource::get_device_properties(handle);
+  auto layout           = make_small_batch_smem_layout<OutT, LutT, IdxT>(
+    index.dim(), index.rot_dim(), index.pq_dim(), index.pq_bits(), n_probes, topk);
+  if (layout.total_size > dev_props.sharedMemPerBlockOptin) { return false; }
+
+  auto kernel = small_batch_search_kernel_config<T, OutT, LutT, IdxT, IvfSampleFilterT>::get(
+    index.pq_bits(), std::max(n_probes, topk));
+  RAFT_CUDA_TRY(
+    cudaFuncSetAttribute(kernel, cudaFuncAttributeMaxDynamicSharedMemorySize, layout.total_size));
+  RAFT_LOG_DEBUG("ivf_pq::search: small-batch search kernel is selected (n_queries = %u)",
+                 n_queries);
+  kernel<<<n_queries, kSmallBatchBlockDim, layout.total_size, stream>>>(
+    layout,
+    index.dim(),
+    index.dim_ext(),
+    index.rot_dim(),
+    index.n_lists(),
+    n_probes,
+    index.pq_dim(),
+    topk,
+    index.metric(),
+    index.codebook_kind(),
+    queries,
+    index.centers().data_handle(),
+    index.centers_rot().data_handle(),
+    index.rotation_matrix().data_handle(),
+    index.pq_centers().data_handle(),
+    index.list_sizes().data_handle(),
+    index.data_ptrs().data_handle(),
+    index.inds_ptrs().data_handle(),
+    sample_filter,
+    scaling_factor,
+    neighbors,
+    distances);
+  RAFT_CHECK_CUDA(stream);
+  return true;
+}
+
+/**
+ * This structure helps selecting a proper instance of the small-batch search function
+ * (see `ivfpq_search` for the regular search).
+ */
+template <typename T, typename IdxT, typename IvfSampleFilterT>
+struct small_batch_search {
+ public:
+  using fun_t = decltype(&small_batch_search_worker<T, float, float, IvfSampleFilterT, IdxT>);
+
+  static auto fun(const search_params& params, distance::DistanceType metric) -> fun_t
+  {
+    switch (params.internal_distance_dtype) {
+      case CUDA_R_32F: return fun_try_lut_t<float>(params, metric);
+      case CUDA_R_16F: return fun_try_lut_t<half>(params, metric);
+      default:
+        RAFT_FAIL("Unexpected internal_distance_dtype (%d)", int(params.internal_distance_dtype));
+    }
+  }
+
+ private:
+  template <typename OutT, typename LutT>
+  static auto filter_reasonable_instances(const search_params& params) -> fun_t
+  {
+    if constexpr (sizeof(OutT) >= sizeof(LutT)) {
+      return small_batch_search_worker<T, OutT, LutT, IvfSampleFilterT, IdxT>;
+    } else {
+      RAFT_FAIL(
+        "Unexpected lut_dtype / internal_distance_dtype combination (%d, %d). "
+        "Size of the internal_distance_dtype should be not smaller than the size of the lut_dtype.",
+        int(params.lut_dtype),
+        int(params.internal_distance_dtype));
+    }
+  }
+
+  template <typename OutT>
+  static auto fun_try_lut_t(const search_params& params, distance::DistanceType metric) -> fun_t
+  {
+    const bool signed_metric = metric == raft::distance::DistanceType::InnerProduct;
+    switch (params.lut_dtype) {
+      case CUDA_R_32F: return filter_reasonable_instances<OutT, float>(params);
+      case CUDA_R_16F: return filter_reasonable_instances<OutT, half>(params);
+      case CUDA_R_8U:
+      case CUDA_R_8I:
+        if (signed_metric) {
+          return filter_reasonable_instances<OutT, fp_8bit<5, true>>(params);
+        } else {
+          return filter_reasonable_instances<OutT, fp_8bit<5, false>>(params);
+        }
+      default: RAFT_FAIL("Unexpected lut_dtype (%d)", int(params.lut_dtype));
+    }
+  }
+};
+
+}  // namespace raft::neighbors::ivf_pq::detail
@@ -36,7 +36,9 @@ namespace raft::neighbors::ivf_pq::detail {
 // backward compatibility.
 // TODO(hcho3) Implement next-gen serializer for IVF that allows for expansion in a backward
 //             compatible fashion.
-constexpr int kSerializationVersion = 3;
+constexpr int kSerializationVersion = 4;
+// Version 4 added the residual PQ layer; the earlier version is read as an index without it.
+constexpr int kSerializationVersionNoResidual = 3;
 
 // NB: we wrap this check in a struct, so that the updated RealSize is easy to see in the error
 // message.
@@ -75,6 +77,7 @@ void serialize(raft::resources const& handle_, std::ostream& os, const index<Idx
   serialize_scalar(handle_, os, index.pq_bits());
   serialize_scalar(handle_, os, index.pq_dim());
   serialize_scalar(handle_, os, index.conservative_memory_allocation());
+  serialize_scalar(handle_, os, index.residual_pq_bits());
 
   serialize_scalar(handle_, os, index.metric());
   serialize_scalar(handle_, os, index.codebook_kind());
@@ -96,6 +99,16 @@ void serialize(raft::resources const& handle_, std::ostream& os, const index<Idx
   for (uint32_t label = 0; label < index.n_lists(); label++) {
     ivf::serialize_list(handle_, os, index.lists()[label], list_store_spec, sizes_host(label));
   }
+
+  if (index.residual_pq_bits() > 0) {
+    serialize_mdspan(handle_, os, index.residual_pq_centers());
+    auto residual_store_spec =
+      list_spec<uint32_t, IdxT>{index.residual_pq_bits(), index.pq_dim(), true};
+    for (uint32_t label = 0; label < index.n_lists(); label++) {
+      ivf::serialize_list(
+        handle_, os, index.residual_lists()[label], residual_store_spec, sizes_host(label));
+    }
+  }
 }
 
 /**
@@ -136,7 +149,7 @@ template <typename IdxT>
 auto deserialize(raft::resources const& handle_, std::istream& is) -> index<IdxT>
 {
   auto ver = deserialize_scalar<int>(handle_, is);
-  if (ver != kSerializationVersion) {
+  if (ver != kSerializationVersion && ver != kSerializationVersionNoResidual) {
     RAFT_FAIL("serialization version mismatch %d vs. %d", ver, kSerializationVersion);
   }
   auto n_rows  = deserialize_scalar<IdxT>(handle_, is);
@@ -144,6 +157,8 @@ auto deserialize(raft::resources const& handle_, std::istream& is) -> index<IdxT
   auto pq_bits = deserialize_scalar<std::uint32_t>(handle_, is);
   auto pq_dim  = deserialize_scalar<std::uint32_t>(handle_, is);
   auto cma     = deserialize_scalar<bool>(handle_, is);
+  auto residual_pq_bits =
+    ver == kSerializationVersionNoResidual ? 0u : deserialize_scalar<std::uint32_t>(handle_, is);
 
   auto metric        = deserialize_scalar<raft::distance::DistanceType>(handle_, is);
   auto codebook_kind = deserialize_scalar<raft::neighbors::ivf_pq::codebook_gen>(handle_, is);
@@ -157,7 +172,7 @@ auto deserialize(raft::resources const& handle_, std::istream& is) -> index<IdxT
                  static_cast<int>(n_lists));
 
   auto index = raft::neighbors::ivf_pq::index<IdxT>(
-    handle_, metric, codebook_kind, n_lists, dim, pq_bits, pq_dim, cma);
+    handle_, metric, codebook_kind, n_lists, dim, pq_bits, pq_dim, cma, residual_pq_bits);
 
   deserialize_mdspan(handle_, is, index.pq_centers());
   deserialize_mdspan(handle_, is, index.centers());
@@ -169,6 +184,14 @@ auto deserialize(raft::resources const& handle_, std::istream& is) -> index<IdxT
   for (auto& list : index.lists()) {
     ivf::deserialize_list(handle_, is, list, list_store_spec, list_device_spec);
   }
+  if (residual_pq_bits > 0) {
+    deserialize_mdspan(handle_, is, index.residual_pq_centers());
+    auto residual_device_spec = list_spec<uint32_t, IdxT>{residual_pq_bits, pq_dim, cma};
+    auto residual_store_spec  = list_spec<uint32_t, IdxT>{residual_pq_bits, pq_dim, true};
+    for (auto& list : index.residual_lists()) {
+      ivf::deserialize_list(handle_, is, list, residual_store_spec, residual_device_spec);
+    }
+  }
 
   resource::sync_stream(handle_);
 
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/linalg/map.cuh>
+
+#include <rmm/device_buffer.hpp>
+#include <rmm/device_uvector.hpp>
+
+#include <cub/cub.cuh>
+#include <thrust/binary_search.h>
+#include <thrust/iterator/counting_iterator.h>
+
+#include <cstdint>
+
+namespace raft::neighbors::ivf::detail {
+
+/**
+ * Invert the probes of a query batch: group the (query, probe) pairs by the probed list.
+ *
+ * Every pair is identified by its position `query_ix * n_probes + probe_ix` in the
+ * `clusters_to_probe` matrix. On exit, `sorted_pairs` contains the pairs ordered by the probed
+ * list (and by the position within the same list); if requested, `list_offsets` contains the
+ * boundaries of the per-list segments of `sorted_pairs`, i.e. the pairs probing the list `l` are
+ * `sorted_pairs[list_offsets[l] : list_offsets[l + 1]]`. The pairs marked as `kSkippedProbe` by
+ * the adaptive probing come last, after `list_offsets[n_lists]`.
+ *
+ * Processing the pairs in this order, rather than query by query, lets one read every probed list
+ * once per batch (or, at least, increases the cache hit rate of reading the list data).
+ *
+ * @param[in] res
+ * @param[in] clusters_to_probe the probed lists [n_queries, n_probes] (device memory)
+ * @param n_queries
+ * @param n_probes
+ * @param n_lists
+ * @param[out] sorted_pairs [n_queries * n_probes] (device memory)
+ * @param[out] list_offsets optional segment offsets [n_lists + 1] (device memory)
+ * @param mr the memory resource for the temporary buffers
+ */
+inline void invert_probes(raft::resources const& res,
+                          const uint32_t* clusters_to_probe,
+                          uint32_t n_queries,
+                          uint32_t n_probes,
+                          uint32_t n_lists,
+                          uint32_t* sorted_pairs,
+                          uint32_t* list_offsets,
+                          rmm::mr::device_memory_resource* mr)
+{
+  auto stream            = resource::get_cuda_stream(res);
+  const uint32_t n_pairs = n_queries * n_probes;
+  rmm::device_uvector<uint32_t> pair_ids(n_pairs, stream, mr);
+  rmm::device_uvector<uint32_t> sorted_labels(n_pairs, stream, mr);
+  linalg::map_offset(
+    res, make_device_vector_view<uint32_t, uint32_t>(pair_ids.data(), n_pairs), identity_op{});
+
+  // NB: sorting by all bits keeps the skipped probes (the max label) at the end.
+  int begin_bit             = 0;
+  int end_bit               = sizeof(uint32_t) * 8;
+  size_t cub_workspace_size = 0;
+  cub::DeviceRadixSort::SortPairs(nullptr,
+                                  cub_workspace_size,
+                                  clusters_to_probe,
+                                  sorted_labels.data(),
+                                  pair_ids.data(),
+                                  sorted_pairs,
+                                  n_pairs,
+                                  begin_bit,
+                                  end_bit,
+                                  stream);
+  rmm::device_buffer cub_workspace(cub_workspace_size, stream, mr);
+  cub::DeviceRadixSort::SortPairs(cub_workspace.data(),
+                                  cub_workspace_size,
+                                  clusters_to_probe,
+                                  sorted_labels.data(),
+                                  pair_ids.data(),
+                                  sorted_pairs,
+                                  n_pairs,
+                                  begin_bit,
+                                  end_bit,
+                                  stream);
+
+  if (list_offsets != nullptr) {
+    thrust::lower_bound(resource::get_thrust_policy(res),
+                        sorted_labels.data(),
+                        sorted_labels.data() + n_pairs,
+                        thrust::make_counting_iterator<uint32_t>(0),
+                        thrust::make_counting_iterator<uint32_t>(n_lists + 1),
+                        list_offsets);
+  }
+}
+
+}  // namespace raft::neighbors::ivf::detail
@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/error.hpp>
+#include <raft/core/logger.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/util/cudart_utils.hpp>
+#include <raft/util/integer_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <thrust/copy.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/sort.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace raft::neighbors::ivf::detail {
+
+/**
+ * Mark the records of all lists whose source indices are in the (sorted) set of the removed ones.
+ *
+ * The lists are viewed as one flat array of records; a thread per record.
+ */
+template <typename IdxT>
+__global__ void mark_removed_kernel(const IdxT* const* inds_ptrs,  // [n_lists]
+                                    const uint64_t* list_offsets,  // [n_lists + 1]
+                                    uint32_t n_lists,
+                                    const IdxT* removed_ids,  // [n_removed_ids]
+                                    uint64_t n_removed_ids,
+                                    uint8_t* keep,        // [list_offsets[n_lists]]
+                                    uint32_t* n_removed)  // [n_lists]
+{
+  const uint64_t i = threadIdx.x + uint64_t(blockDim.x) * uint64_t(blockIdx.x);
+  if (i >= list_offsets[n_lists]) { return; }
+  // The last list starting at or before the record is the (non-empty) list containing it.
+  uint32_t label = 0;
+  uint32_t hi    = n_lists;
+  while (hi - label > 1) {
+    const uint32_t mid = (label + hi) / 2;
+    if (list_offsets[mid] <= i) {
+      label = mid;
+    } else {
+      hi = mid;
+    }
+  }
+  const IdxT id = inds_ptrs[label][i - list_offsets[label]];
+  uint64_t lo   = 0;
+  uint64_t up   = n_removed_ids;
+  while (lo < up) {
+    const uint64_t mid = (lo + up) / 2;
+    if (removed_ids[mid] < id) {
+      lo = mid + 1;
+    } else {
+      up = mid;
+    }
+  }
+  const bool removed = lo < n_removed_ids && removed_ids[lo] == id;
+  keep[i]            = !removed;
+  if (removed) { atomicAdd(n_removed + label, 1u); }
+}
+
+/**
+ * Remove the records with the given source indices from the lists of an IVF index.
+ *
+ * The records to remove are marked in a single pass over all lists; only the lists that lose
+ * records are then rewritten by `compact_list(label, kept, new_size)`, where `kept` is a device
+ * array of the positions of the remaining records in the list [new_size], in their original order.
+ * The list sizes are updated here; the caller is responsible for recomputing the rest of the
+ * dependent state of the index (list pointers, total size).
+ *
+ * The source indices that are not in the index are ignored.
+ *
+ * @return the number of removed records.
+ */
+template <typename IdxT, typename CompactF>
+auto remove_records(raft::resources const& res,
+                    const IdxT* const* inds_ptrs,  // [n_lists]
+                    uint32_t* list_sizes,          // [n_lists]
+                    uint32_t n_lists,
+                    raft::device_vector_view<const IdxT, IdxT> ids,
+                    CompactF compact_list) -> uint64_t
+{
+  auto stream  = resource::get_cuda_stream(res);
+  auto policy  = resource::get_thrust_policy(res);
+  auto tmp_res = resource::get_workspace_resource(res);
+
+  std::vector<uint32_t> sizes(n_lists);
+  std::vector<uint64_t> offsets(n_lists + 1, 0);
+  raft::copy(sizes.data(), list_sizes, n_lists, stream);
+  resource::sync_stream(res);
+  for (uint32_t label = 0; label < n_lists; label++) {
+    offsets[label + 1] = offsets[label] + sizes[label];
+  }
+  const uint64_t n_records = offsets[n_lists];
+  if (n_records == 0 || ids.extent(0) == 0) { return 0; }
+
+  rmm::device_uvector<IdxT> removed_ids(ids.extent(0), stream, tmp_res);
+  rmm::device_uvector<uint64_t> offsets_dev(n_lists + 1, stream, tmp_res);
+  rmm::device_uvector<uint8_t> keep(n_records, stream, tmp_res);
+  rmm::device_uvector<uint32_t> n_removed_dev(n_lists, stream, tmp_res);
+  raft::copy(removed_ids.data(), ids.data_handle(), ids.extent(0), stream);
+  raft::copy(offsets_dev.data(), offsets.data(), n_lists + 1, stream);
+  RAFT_CUDA_TRY(cudaMemsetAsync(n_removed_dev.data(), 0, sizeof(uint32_t) * n_lists, stream));
+  thrust::sort(policy, removed_ids.begin(), removed_ids.end());
+
+  constexpr uint32_t kBlockSize = 256;
+  const uint64_t grid_size      = raft::ceildiv<uint64_t>(n_records, kBlockSize);
+  mark_removed_kernel<<<grid_size, kBlockSize, 0, stream>>>(inds_ptrs,
+                                                            offsets_dev.data(),
+                                                            n_lists,
+                                                            removed_ids.data(),
+                                                            removed_ids.size(),
+                                                            keep.data(),
+                                                            n_removed_dev.data());
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+  std::vector<uint32_t> n_removed(n_lists);
+  raft::copy(n_removed.data(), n_removed_dev.data(), n_lists, stream);
+  resource::sync_stream(res);
+
+  uint64_t n_removed_total = 0;
+  rmm::device_uvector<uint32_t> kept(0, stream, tmp_res);
+  for (uint32_t label = 0; label < n_lists; label++) {
+    if (n_removed[label] == 0) { continue; }
+    const uint32_t new_size = sizes[label] - n_removed[label];
+    kept.resize(new_size, stream);
+    thrust::copy_if(policy,
+                    thrust::make_counting_iterator<uint32_t>(0),
+                    thrust::make_counting_iterator<uint32_t>(sizes[label]),
+                    keep.data() + offsets[label],
+                    kept.data(),
+                    raft::identity_op{});
+    compact_list(label, kept.data(), new_size);
+    sizes[label] = new_size;
+    n_removed_total += n_removed[label];
+  }
+  raft::copy(list_sizes, sizes.data(), n_lists, stream);
+  // Keep the host sizes alive until the copy is done.
+  resource::sync_stream(res);
+  RAFT_LOG_DEBUG("ivf::remove: %zu records removed", size_t(n_removed_total));
+  return n_removed_total;
+}
+
+}  // namespace raft::neighbors::ivf::detail
@@ -0,0 +1,282 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/cluster/kmeans_balanced.cuh>
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/host_mdarray.hpp>
+#include <raft/core/logger.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/linalg/add.cuh>
+#include <raft/linalg/map.cuh>
+#include <raft/linalg/norm.cuh>
+#include <raft/linalg/reduce.cuh>
+#include <raft/neighbors/detail/ivf_flat_build.cuh>  // ivf_flat::detail::build_index_kernel
+#include <raft/neighbors/ivf_list.hpp>
+#include <raft/neighbors/ivf_sq_types.hpp>
+#include <raft/spatial/knn/detail/ann_utils.cuh>
+#include <raft/stats/histogram.cuh>
+#include <raft/util/pow2_utils.cuh>
+
+#include <rmm/device_uvector.hpp>
+
+#include <cuda_fp16.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace raft::neighbors::ivf_sq::detail {
+
+using namespace raft::spatial::knn::detail;  // NOLINT
+
+/** Quantizes the dataset values: `code = (x - offset[j]) / scale[j]`, clamped to the code range. */
+template <typename CodeT>
+struct encode_op {
+  const float* offset;
+  const float* scale;
+  uint32_t dim;
+
+  template <typename IdxT>
+  __device__ inline auto operator()(IdxT i, float x) const -> CodeT
+  {
+    const uint32_t j = i % dim;
+    const float code = fminf(fmaxf((x - offset[j]) / scale[j], -kCodeRange<CodeT>),
+                             kCodeRange<CodeT>);
+    if constexpr (std::is_same_v<CodeT, int8_t>) {
+      return static_cast<int8_t>(roundf(code));
+    } else {
+      return __float2half(code);
+    }
+  }
+};
+
+/**
+ * Learn the per-dimension offsets and scales of the quantization from the range of the trainset:
+ * the range of every dimension is mapped onto `[-kCodeRange, kCodeRange]`.
+ */
+template <typename CodeT, typename IdxT>
+void train_quantizer(raft::resources const& handle,
+                     index<CodeT, IdxT>& index,
+                     const float* trainset,
+                     IdxT n_rows)
+{
+  auto stream    = resource::get_cuda_stream(handle);
+  const auto dim = index.dim();
+  auto col_min   = make_device_vector<float, uint32_t>(handle, dim);
+  auto col_max   = make_device_vector<float, uint32_t>(handle, dim);
+  raft::linalg::reduce(col_min.data_handle(),
+                       trainset,
+                       IdxT(dim),
+                       n_rows,
+                       std::numeric_limits<float>::max(),
+                       true,
+                       false,
+                       stream,
+                       false,
+                       raft::identity_op{},
+                       raft::min_op{});
+  raft::linalg::reduce(col_max.data_handle(),
+                       trainset,
+                       IdxT(dim),
+                       n_rows,
+                       std::numeric_limits<float>::lowest(),
+                       true,
+                       false,
+                       stream,
+                       false,
+                       raft::identity_op{},
+                       raft::max_op{});
+  // A constant dimension is encoded by zeros, any positive scale will do.
+  raft::linalg::map(handle,
+                    raft::make_const_mdspan(col_min.view()),
+                    raft::make_const_mdspan(col_max.view()),
+                    index.sq_offset(),
+                    raft::compose_op(raft::div_const_op<float>{2.0f}, raft::add_op{}));
+  raft::linalg::map(handle,
+                    raft::make_const_mdspan(col_min.view()),
+                    raft::make_const_mdspan(col_max.view()),
+                    index.sq_scale(),
+                    [] __device__(float lo, float hi) {
+                      return hi > lo ? (hi - lo) / (2.0f * kCodeRange<CodeT>) : 1.0f;
+                    });
+  RAFT_LOG_TRACE_VEC(index.sq_scale().data_handle(), std::min<uint32_t>(dim, 20));
+}
+
+/** See raft::neighbors::ivf_sq::extend docs */
+template <typename CodeT, typename IdxT>
+void extend(raft::resources const& handle,
+            index<CodeT, IdxT>* index,
+            const float* new_vectors,
+            const IdxT* new_indices,
+            IdxT n_rows)
+{
+  using LabelT = uint32_t;
+  RAFT_EXPECTS(index != nullptr, "index cannot be empty.");
+  RAFT_EXPECTS(new_indices != nullptr || index->size() == 0,
+               "You must pass data indices when the index is non-empty.");
+
+  auto stream  = resource::get_cuda_stream(handle);
+  auto n_lists = index->n_lists();
+  auto dim     = index->dim();
+  ivf_flat::list_spec<uint32_t, CodeT, IdxT> list_device_spec{
+    dim, index->conservative_memory_allocation()};
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "ivf_sq::extend(%zu, %u)", size_t(n_rows), dim);
+
+  // The rows are classified by their original values; only the stored copies are quantized.
+  auto new_labels = raft::make_device_vector<LabelT, IdxT>(handle, n_rows);
+  raft::cluster::kmeans_balanced_params kmeans_params;
+  kmeans_params.metric = index->metric();
+  raft::cluster::kmeans_balanced::predict(
+    handle,
+    kmeans_params,
+    raft::make_device_matrix_view<const float, IdxT>(new_vectors, n_rows, dim),
+    raft::make_device_matrix_view<const float, IdxT>(index->centers().data_handle(), n_lists, dim),
+    new_labels.view());
+
+  auto new_codes = raft::make_device_matrix<CodeT, IdxT>(handle, n_rows, dim);
+  raft::linalg::map_offset(
+    handle,
+    new_codes.view(),
+    encode_op<CodeT>{index->sq_offset().data_handle(), index->sq_scale().data_handle(), dim},
+    raft::make_device_vector_view<const float, IdxT>(new_vectors, n_rows * IdxT(dim)));
+
+  auto* list_sizes_ptr    = index->list_sizes().data_handle();
+  auto old_list_sizes_dev = raft::make_device_vector<uint32_t, IdxT>(handle, n_lists);
+  copy(old_list_sizes_dev.data_handle(), list_sizes_ptr, n_lists, stream);
+  raft::stats::histogram<uint32_t, IdxT>(raft::stats::HistTypeAuto,
+                                         reinterpret_cast<int32_t*>(list_sizes_ptr),
+                                         IdxT(n_lists),
+                                         new_labels.data_handle(),
+                                         n_rows,
+                                         1,
+                                         stream);
+  raft::linalg::add(
+    list_sizes_ptr, list_sizes_ptr, old_list_sizes_dev.data_handle(), n_lists, stream);
+
+  // Calculate and allocate new list data
+  {
+    std::vector<uint32_t> new_list_sizes(n_lists);
+    std::vector<uint32_t> old_list_sizes(n_lists);
+    copy(old_list_sizes.data(), old_list_sizes_dev.data_handle(), n_lists, stream);
+    copy(new_list_sizes.data(), list_sizes_ptr, n_lists, stream);
+    resource::sync_stream(handle);
+    auto& lists = index->lists();
+    for (uint32_t label = 0; label < n_lists; label++) {
+      ivf::resize_list(handle,
+                       lists[label],
+                       list_device_spec,
+                       new_list_sizes[label],
+                       Pow2<kIndexGroupSize>::roundUp(old_list_sizes[label]));
+    }
+  }
+  // Update the pointers and the sizes
+  index->recompute_internal_state(handle);
+  // The list sizes serve as the atomic counters of the insertion kernel; start from the old sizes.
+  raft::copy(list_sizes_ptr, old_list_sizes_dev.data_handle(), n_lists, stream);
+
+  // The codes are interleaved exactly as the IVF-Flat data
+  const dim3 block_dim(256);
+  const dim3 grid_dim(raft::ceildiv<IdxT>(n_rows, block_dim.x));
+  ivf_flat::detail::build_index_kernel<<<grid_dim, block_dim, 0, stream>>>(
+    new_labels.data_handle(),
+    new_codes.data_handle(),
+    new_indices,
+    index->data_ptrs().data_handle(),
+    index->inds_ptrs().data_handle(),
+    list_sizes_ptr,
+    n_rows,
+    dim,
+    index->veclen());
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+/** See raft::neighbors::ivf_sq::build docs */
+template <typename CodeT, typename IdxT>
+auto build(raft::resources const& handle,
+           const index_params& params,
+           const float* dataset,
+           IdxT n_rows,
+           uint32_t dim) -> index<CodeT, IdxT>
+{
+  auto stream = resource::get_cuda_stream(handle);
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "ivf_sq::build(%zu, %u)", size_t(n_rows), dim);
+  RAFT_EXPECTS(n_rows > 0 && dim > 0, "empty dataset");
+  RAFT_EXPECTS(params.metric == raft::distance::DistanceType::L2Expanded ||
+                 params.metric == raft::distance::DistanceType::L2SqrtExpanded ||
+                 params.metric == raft::distance::DistanceType::InnerProduct,
+               "Unsupported distance type %d.",
+               int(params.metric));
+
+  index<CodeT, IdxT> index(handle, params, dim);
+  utils::memzero(index.list_sizes().data_handle(), index.list_sizes().size(), stream);
+  utils::memzero(index.data_ptrs().data_handle(), index.data_ptrs().size(), stream);
+  utils::memzero(index.inds_ptrs().data_handle(), index.inds_ptrs().size(), stream);
+
+  // Train the kmeans clustering and the quantizer on the same subset of the data
+  {
+    auto trainset_ratio = std::max<size_t>(
+      1, n_rows / std::max<size_t>(params.kmeans_trainset_fraction * n_rows, index.n_lists()));
+    auto n_rows_train = n_rows / trainset_ratio;
+    rmm::device_uvector<float> trainset(n_rows_train * index.dim(), stream);
+    // TODO: a proper sampling
+    RAFT_CUDA_TRY(cudaMemcpy2DAsync(trainset.data(),
+                                    sizeof(float) * index.dim(),
+                                    dataset,
+                                    sizeof(float) * index.dim() * trainset_ratio,
+                                    sizeof(float) * index.dim(),
+                                    n_rows_train,
+                                    cudaMemcpyDefault,
+                                    stream));
+    train_quantizer<CodeT, IdxT>(handle, index, trainset.data(), IdxT(n_rows_train));
+    auto centers_view = raft::make_device_matrix_view<float, IdxT>(
+      index.centers().data_handle(), index.n_lists(), index.dim());
+    raft::cluster::kmeans_balanced_params kmeans_params;
+    kmeans_params.n_iters = params.kmeans_n_iters;
+    kmeans_params.metric  = index.metric();
+    raft::cluster::kmeans_balanced::fit(
+      handle,
+      kmeans_params,
+      raft::make_device_matrix_view<const float, IdxT>(trainset.data(), n_rows_train, index.dim()),
+      centers_view);
+  }
+  // The centers stay fixed, their norms are used by the coarse search with the L2 metrics
+  index.allocate_center_norms(handle);
+  if (index.center_norms().has_value()) {
+    raft::linalg::rowNorm(index.center_norms()->data_handle(),
+                          index.centers().data_handle(),
+                          index.dim(),
+                          index.n_lists(),
+                          raft::linalg::L2Norm,
+                          true,
+                          stream);
+  }
+
+  // add the data if necessary
+  if (params.add_data_on_build) {
+    detail::extend<CodeT, IdxT>(handle, &index, dataset, nullptr, n_rows);
+  }
+  return index;
+}
+
+}  // namespace raft::neighbors::ivf_sq::detail
@@ -0,0 +1,511 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/logger.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/linalg/gemm.cuh>
+#include <raft/linalg/gemv.cuh>
+#include <raft/linalg/map.cuh>
+#include <raft/linalg/norm.cuh>
+#include <raft/matrix/detail/select_k.cuh>
+#include <raft/matrix/detail/select_warpsort.cuh>
+#include <raft/neighbors/ivf_sq_types.hpp>
+#include <raft/spatial/knn/detail/ann_utils.cuh>
+#include <raft/util/cuda_rt_essentials.hpp>
+#include <raft/util/integer_utils.hpp>
+#include <raft/util/pow2_utils.cuh>
+#include <raft/util/vectorized.cuh>
+
+#include <rmm/device_uvector.hpp>
+#include <rmm/mr/device/per_device_resource.hpp>
+
+#include <cuda_fp16.h>
+
+#include <algorithm>
+#include <cstdint>
+
+namespace raft::neighbors::ivf_sq::detail {
+
+using namespace raft::spatial::knn::detail;  // NOLINT
+
+constexpr int kThreadsPerBlock = 128;
+/** The maximum size, in bytes, of the query terms kept in shared memory. */
+constexpr int kMaxQuerySmem = 16384;
+
+__device__ inline auto code_to_float(int8_t code) -> float { return static_cast<float>(code); }
+__device__ inline auto code_to_float(half code) -> float { return __half2float(code); }
+
+/**
+ * The per-query terms of the distance, with the quantization folded in:
+ *   - L2: `terms[j] = (q[j] - offset[j]) / scale[j]`, so that
+ *     `|q - x|^2 = sum_j scale[j]^2 * (terms[j] - code[j])^2`;
+ *   - inner product: `terms[j] = q[j] * scale[j]`, so that
+ *     `<q, x> = <q, offset> + sum_j terms[j] * code[j]`.
+ */
+struct query_terms_op {
+  const float* offset;
+  const float* scale;
+  uint32_t dim;
+  bool l2;
+
+  template <typename IdxT>
+  __device__ inline auto operator()(IdxT i, float q) const -> float
+  {
+    const uint32_t j = i % dim;
+    return l2 ? (q - offset[j]) / scale[j] : q * scale[j];
+  }
+};
+
+/**
+ * Scan the probed lists of the queries and select the top-k candidates of every CUDA block.
+ *
+ * The codes are loaded `Veclen` at a time in the interleaved layout of the IVF-Flat lists (every
+ * lane of a warp reads one vector of an interleaved group) and converted to float in registers;
+ * the offsets and scales of the quantization are folded into the query terms (see
+ * `query_terms_op`), hence the distances need no lookup tables.
+ *
+ * CUDA launch grid: the block (x, y) scans the probes x, x + gridDim.x, ... of the query y.
+ *
+ * @tparam L2 whether the distance is the (squared) L2 distance, otherwise the inner product;
+ *   the former is selected in the ascending order, the latter in the descending order.
+ *
+ * @param[in] query_terms [n_queries, dim]
+ * @param[in] weights the squared scales of the quantization [dim] (L2 only)
+ * @param[in] query_bias `<q, offset>` [n_queries] (inner product only)
+ * @param terms_in_smem whether to copy the query terms (and the weights) into shared memory
+ * @param[in] coarse_index the lists probed by every query [n_queries, n_probes]
+ * @param[out] neighbors [n_queries, gridDim.x, k]
+ * @param[out] distances [n_queries, gridDim.x, k]
+ */
+template <int Capacity, int Veclen, bool L2, typename CodeT, typename IdxT>
+__global__ void __launch_bounds__(kThreadsPerBlock)
+  scan_kernel(const float* query_terms,
+              const float* weights,
+              const float* query_bias,
+              const bool terms_in_smem,
+              const uint32_t* coarse_index,
+              const IdxT* const* list_indices_ptrs,
+              const CodeT* const* list_data_ptrs,
+              const uint32_t* list_sizes,
+              const uint32_t n_probes,
+              const uint32_t k,
+              const uint32_t dim,
+              IdxT* neighbors,
+              float* distances)
+{
+  extern __shared__ __align__(256) uint8_t sq_scan_kernel_smem[];
+  {
+    const uint32_t query_id = blockIdx.y;
+    query_terms += size_t(query_id) * dim;
+    coarse_index += size_t(query_id) * n_probes;
+    neighbors += (size_t(query_id) * gridDim.x + blockIdx.x) * k;
+    distances += (size_t(query_id) * gridDim.x + blockIdx.x) * k;
+  }
+  const float bias = L2 ? 0.0f : query_bias[blockIdx.y];
+
+  const float* terms = query_terms;
+  const float* ws    = weights;
+  if (terms_in_smem) {
+    auto* terms_shared = reinterpret_cast<float*>(sq_scan_kernel_smem);
+    for (uint32_t j = threadIdx.x; j < dim; j += blockDim.x) {
+      terms_shared[j] = query_terms[j];
+      if constexpr (L2) { terms_shared[dim + j] = weights[j]; }
+    }
+    terms = terms_shared;
+    ws    = terms_shared + dim;
+    __syncthreads();
+  }
+
+  using block_sort_t = matrix::detail::select::warpsort::
+    block_sort<matrix::detail::select::warpsort::warp_sort_filtered, Capacity, L2, float, IdxT>;
+  block_sort_t queue(k);
+
+  using align_warp             = Pow2<WarpSize>;
+  const uint32_t lane_id       = align_warp::mod(threadIdx.x);
+  constexpr uint32_t kNumWarps = kThreadsPerBlock / WarpSize;
+  for (uint32_t probe_id = blockIdx.x; probe_id < n_probes; probe_id += gridDim.x) {
+    const uint32_t list_id     = coarse_index[probe_id];
+    const uint32_t list_length = list_sizes[list_id];
+    const uint32_t num_groups  = ceildiv<uint32_t>(list_length, kIndexGroupSize);
+    // Every warp scans one interleaved group at a time, every lane computes one distance.
+    for (uint32_t group_id = align_warp::div(threadIdx.x); group_id < num_groups;
+         group_id += kNumWarps) {
+      const uint32_t vec_id = group_id * kIndexGroupSize + lane_id;
+      const bool valid      = vec_id < list_length;
+      float dist            = 0;
+      if (valid) {
+        const CodeT* data =
+          list_data_ptrs[list_id] + size_t(group_id) * kIndexGroupSize * dim + lane_id * Veclen;
+        for (uint32_t j = 0; j < dim; j += Veclen, data += kIndexGroupSize * Veclen) {
+          TxN_t<CodeT, Veclen> codes;
+          codes.load(data, 0);
+#pragma unroll
+          for (int v = 0; v < Veclen; v++) {
+            const float c = code_to_float(codes.val.data[v]);
+            if constexpr (L2) {
+              const float d = terms[j + v] - c;
+              dist += ws[j + v] * d * d;
+            } else {
+              dist += terms[j + v] * c;
+            }
+          }
+        }
+      }
+      const float val = valid ? dist + bias : block_sort_t::queue_t::kDummy;
+      const IdxT idx  = valid ? list_indices_ptrs[list_id][vec_id] : IdxT(0);
+      queue.add(val, idx);
+    }
+  }
+
+  // the shared memory of the query terms is reused by the merge of the warp queues
+  __syncthreads();
+  queue.done(sq_scan_kernel_smem);
+  queue.store(distances, neighbors);
+}
+
+template <int Capacity, int Veclen, bool L2, typename CodeT, typename IdxT>
+void launch_scan_kernel(const index<CodeT, IdxT>& index,
+                        const float* query_terms,
+                        const float* weights,
+                        const float* query_bias,
+                        const uint32_t* coarse_index,
+                        uint32_t n_queries,
+                        uint32_t n_probes,
+                        uint32_t k,
+                        IdxT* neighbors,
+                        float* distances,
+                        uint32_t& grid_dim_x,
+                        rmm::cuda_stream_view stream)
+{
+  RAFT_EXPECTS(Veclen == index.veclen(),
+               "Configured Veclen does not match the index interleaving pattern.");
+  constexpr auto kKernel     = scan_kernel<Capacity, Veclen, L2, CodeT, IdxT>;
+  const uint32_t dim         = index.dim();
+  const int terms_smem_size  = (L2 ? 2 : 1) * dim * sizeof(float);
+  const bool terms_in_smem   = terms_smem_size <= kMaxQuerySmem;
+  constexpr int kSubwarpSize = std::min<int>(Capacity, WarpSize);
+  const int smem_size        = std::max<int>(
+    terms_in_smem ? terms_smem_size : 0,
+    matrix::detail::select::warpsort::calc_smem_size_for_block_wide<float, IdxT>(
+      kThreadsPerBlock / kSubwarpSize, k));
+
+  // power-of-two less than cuda limit (for better addr alignment)
+  constexpr uint32_t kMaxGridY = 32768;
+
+  if (grid_dim_x == 0) {
+    // Enough blocks to keep the GPU busy, but not more than needed
+    int dev_id;
+    RAFT_CUDA_TRY(cudaGetDevice(&dev_id));
+    int num_sms;
+    RAFT_CUDA_TRY(cudaDeviceGetAttribute(&num_sms, cudaDevAttrMultiProcessorCount, dev_id));
+    int num_blocks_per_sm = 0;
+    RAFT_CUDA_TRY(cudaOccupancyMaxActiveBlocksPerMultiprocessor(
+      &num_blocks_per_sm, kKernel, kThreadsPerBlock, smem_size));
+    const size_t min_grid_x =
+      ceildiv<size_t>(size_t(num_sms) * num_blocks_per_sm, std::min(kMaxGridY, n_queries));
+    grid_dim_x = static_cast<uint32_t>(std::min<size_t>(min_grid_x, n_probes));
+    return;
+  }
+
+  for (uint32_t query_offset = 0; query_offset < n_queries; query_offset += kMaxGridY) {
+    const uint32_t grid_dim_y = std::min<uint32_t>(kMaxGridY, n_queries - query_offset);
+    const dim3 grid_dim(grid_dim_x, grid_dim_y, 1);
+    const dim3 block_dim(kThreadsPerBlock);
+    RAFT_LOG_TRACE(
+      "Launching the ivf-sq scan_kernel (%d, %d, 1) x (%d, 1, 1), n_probes = %d, smem_size = %d",
+      grid_dim.x,
+      grid_dim.y,
+      block_dim.x,
+      n_probes,
+      smem_size);
+    kKernel<<<grid_dim, block_dim, smem_size, stream>>>(query_terms,
+                                                        weights,
+                                                        query_bias,
+                                                        terms_in_smem,
+                                                        coarse_index,
+                                                        index.inds_ptrs().data_handle(),
+                                                        index.data_ptrs().data_handle(),
+                                                        index.list_sizes().data_handle(),
+                                                        n_probes,
+                                                        k,
+                                                        dim,
+                                                        neighbors,
+                                                        distances);
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+    query_terms += size_t(grid_dim_y) * dim;
+    if (query_bias != nullptr) { query_bias += grid_dim_y; }
+    coarse_index += size_t(grid_dim_y) * n_probes;
+    neighbors += size_t(grid_dim_y) * grid_dim_x * k;
+    distances += size_t(grid_dim_y) * grid_dim_x * k;
+  }
+}
+
+/**
+ * Recursively reduce the `Capacity` and `Veclen` parameters until they match the corresponding
+ * runtime arguments (see `ivf_flat::detail::select_interleaved_scan_kernel`).
+ */
+template <typename CodeT,
+          typename IdxT,
+          int Capacity = matrix::detail::select::warpsort::kMaxCapacity,
+          int Veclen   = std::max<int>(1, 16 / sizeof(CodeT))>
+struct select_scan_kernel {
+  template <typename... Args>
+  static inline void run(int capacity, int veclen, bool l2, Args&&... args)
+  {
+    if constexpr (Capacity > 1) {
+      if (capacity * 2 <= Capacity) {
+        return select_scan_kernel<CodeT, IdxT, Capacity / 2, Veclen>::run(
+          capacity, veclen, l2, std::forward<Args>(args)...);
+      }
+    }
+    if constexpr (Veclen > 1) {
+      if (veclen % Veclen != 0) {
+        return select_scan_kernel<CodeT, IdxT, Capacity, 1>::run(
+          capacity, 1, l2, std::forward<Args>(args)...);
+      }
+    }
+    RAFT_EXPECTS(capacity == Capacity,
+                 "Capacity must be power-of-two not bigger than the maximum allowed size "
+                 "matrix::detail::select::warpsort::kMaxCapacity (%d).",
+                 matrix::detail::select::warpsort::kMaxCapacity);
+    RAFT_EXPECTS(
+      veclen == Veclen,
+      "Veclen must be power-of-two not bigger than the maximum allowed size for this data type.");
+    if (l2) {
+      launch_scan_kernel<Capacity, Veclen, true, CodeT, IdxT>(std::forward<Args>(args)...);
+    } else {
+      launch_scan_kernel<Capacity, Veclen, false, CodeT, IdxT>(std::forward<Args>(args)...);
+    }
+  }
+};
+
+/** Select the clusters (lists) to probe for every query (the coarse search). */
+template <typename CodeT, typename IdxT>
+void select_clusters(raft::resources const& handle,
+                     const index<CodeT, IdxT>& index,
+                     const float* queries,
+                     uint32_t n_queries,
+                     uint32_t n_probes,
+                     bool select_min,
+                     uint32_t* coarse_indices,
+                     rmm::mr::device_memory_resource* mr)
+{
+  auto stream = resource::get_cuda_stream(handle);
+  rmm::device_uvector<float> qc_distances(size_t(n_queries) * index.n_lists(), stream, mr);
+  rmm::device_uvector<float> coarse_distances(size_t(n_queries) * n_probes, stream, mr);
+
+  float alpha = 1.0f;
+  float beta  = 0.0f;
+  if (select_min) {
+    // |q - c|^2 = |q|^2 + |c|^2 - 2 <q, c>
+    alpha = -2.0f;
+    beta  = 1.0f;
+    rmm::device_uvector<float> query_norms(n_queries, stream, mr);
+    raft::linalg::rowNorm(query_norms.data(),
+                          queries,
+                          IdxT(index.dim()),
+                          IdxT(n_queries),
+                          raft::linalg::L2Norm,
+                          true,
+                          stream);
+    utils::outer_add(query_norms.data(),
+                     IdxT(n_queries),
+                     index.center_norms()->data_handle(),
+                     IdxT(index.n_lists()),
+                     qc_distances.data(),
+                     stream);
+  }
+  linalg::gemm(handle,
+               true,
+               false,
+               index.n_lists(),
+               n_queries,
+               index.dim(),
+               &alpha,
+               index.centers().data_handle(),
+               index.dim(),
+               queries,
+               index.dim(),
+               &beta,
+               qc_distances.data(),
+               index.n_lists(),
+               stream);
+  matrix::detail::select_k<float, uint32_t>(qc_distances.data(),
+                                            nullptr,
+                                            n_queries,
+                                            index.n_lists(),
+                                            n_probes,
+                                            coarse_distances.data(),
+                                            coarse_indices,
+                                            select_min,
+                                            stream,
+                                            mr);
+}
+
+template <typename CodeT, typename IdxT>
+void search_impl(raft::resources const& handle,
+                 const index<CodeT, IdxT>& index,
+                 const float* queries,
+                 uint32_t n_queries,
+                 uint32_t k,
+                 uint32_t n_probes,
+                 IdxT* neighbors,
+                 float* distances,
+                 rmm::mr::device_memory_resource* mr)
+{
+  auto stream     = resource::get_cuda_stream(handle);
+  const auto dim  = index.dim();
+  const bool l2   = index.metric() != raft::distance::DistanceType::InnerProduct;
+  rmm::device_uvector<uint32_t> coarse_indices(size_t(n_queries) * n_probes, stream, mr);
+  select_clusters(handle, index, queries, n_queries, n_probes, l2, coarse_indices.data(), mr);
+
+  // Fold the quantization into the queries
+  rmm::device_uvector<float> query_terms(size_t(n_queries) * dim, stream, mr);
+  rmm::device_uvector<float> weights(l2 ? dim : 0, stream, mr);
+  rmm::device_uvector<float> query_bias(l2 ? 0 : n_queries, stream, mr);
+  raft::linalg::map_offset(
+    handle,
+    raft::make_device_vector_view<float, size_t>(query_terms.data(), query_terms.size()),
+    query_terms_op{index.sq_offset().data_handle(), index.sq_scale().data_handle(), dim, l2},
+    raft::make_device_vector_view<const float, size_t>(queries, query_terms.size()));
+  if (l2) {
+    raft::linalg::map(handle,
+                      index.sq_scale(),
+                      raft::make_device_vector_view<float, uint32_t>(weights.data(), dim),
+                      raft::sq_op{});
+  } else {
+    // The bias term: <q, offset> for every query
+    raft::linalg::gemv(handle,
+                       queries,
+                       int(dim),
+                       int(n_queries),
+                       index.sq_offset().data_handle(),
+                       query_bias.data(),
+                       true,
+                       1.0f,
+                       0.0f,
+                       stream);
+  }
+
+  // The top-k candidates of every block, merged afterwards
+  const int capacity  = bound_by_power_of_two(k);
+  uint32_t grid_dim_x = 0;
+  select_scan_kernel<CodeT, IdxT>::run(capacity,
+                                       index.veclen(),
+                                       l2,
+                                       index,
+                                       nullptr,
+                                       nullptr,
+                                       nullptr,
+                                       nullptr,
+                                       n_queries,
+                                       n_probes,
+                                       k,
+                                       nullptr,
+                                       nullptr,
+                                       grid_dim_x,
+                                       stream);
+  rmm::device_uvector<float> block_distances(
+    grid_dim_x > 1 ? size_t(n_queries) * grid_dim_x * k : 0, stream, mr);
+  rmm::device_uvector<IdxT> block_neighbors(
+    grid_dim_x > 1 ? size_t(n_queries) * grid_dim_x * k : 0, stream, mr);
+  select_scan_kernel<CodeT, IdxT>::run(capacity,
+                                       index.veclen(),
+                                       l2,
+                                       index,
+                                       query_terms.data(),
+                                       weights.data(),
+                                       query_bias.data(),
+                                       coarse_indices.data(),
+                                       n_queries,
+                                       n_probes,
+                                       k,
+                                       grid_dim_x > 1 ? block_neighbors.data() : neighbors,
+                                       grid_dim_x > 1 ? block_distances.data() : distances,
+                                       grid_dim_x,
+                                       stream);
+  if (grid_dim_x > 1) {
+    matrix::detail::select_k<float, IdxT>(block_distances.data(),
+                                          block_neighbors.data(),
+                                          n_queries,
+                                          k * grid_dim_x,
+                                          k,
+                                          distances,
+                                          neighbors,
+                                          l2,
+                                          stream,
+                                          mr);
+  }
+  if (index.metric() == raft::distance::DistanceType::L2SqrtExpanded) {
+    raft::linalg::map(
+      handle,
+      raft::make_device_vector_view<const float, size_t>(distances, size_t(n_queries) * k),
+      raft::make_device_vector_view<float, size_t>(distances, size_t(n_queries) * k),
+      raft::sqrt_op{});
+  }
+}
+
+/** See raft::neighbors::ivf_sq::search docs */
+template <typename CodeT, typename IdxT>
+void search(raft::resources const& handle,
+            const search_params& params,
+            const index<CodeT, IdxT>& index,
+            const float* queries,
+            uint32_t n_queries,
+            uint32_t k,
+            IdxT* neighbors,
+            float* distances,
+            rmm::mr::device_memory_resource* mr = nullptr)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "ivf_sq::search(k = %u, n_queries = %u, dim = %u)", k, n_queries, index.dim());
+  RAFT_EXPECTS(params.n_probes > 0,
+               "n_probes (number of clusters to probe in the search) must be positive.");
+  RAFT_EXPECTS(k <= matrix::detail::select::warpsort::kMaxCapacity,
+               "k must not exceed %d",
+               matrix::detail::select::warpsort::kMaxCapacity);
+  if (mr == nullptr) { mr = rmm::mr::get_current_device_resource(); }
+  const auto n_probes = std::min<uint32_t>(params.n_probes, index.n_lists());
+
+  // a batch size heuristic: try to keep the workspace within the specified size
+  constexpr uint64_t kExpectedWsSize = 1024 * 1024 * 1024;
+  const uint64_t bytes_per_query =
+    8ull * uint64_t{n_probes} * k + 4ull * index.n_lists() + 4ull * index.dim();
+  const uint32_t max_queries = std::min<uint32_t>(
+    n_queries, raft::div_rounding_up_safe<uint64_t>(kExpectedWsSize, bytes_per_query));
+
+  for (uint32_t offset_q = 0; offset_q < n_queries; offset_q += max_queries) {
+    const uint32_t queries_batch = std::min(max_queries, n_queries - offset_q);
+    search_impl(handle,
+                index,
+                queries + size_t(offset_q) * index.dim(),
+                queries_batch,
+                k,
+                n_probes,
+                neighbors + size_t(offset_q) * k,
+                distances + size_t(offset_q) * k,
+                mr);
+  }
+}
+
+}  // namespace raft::neighbors::ivf_sq::detail
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+/**
+ * The comma-separated list of the dimensions for which the IVF search kernels are additionally
+ * compiled with the dimension known at compile time, e.g. `-DRAFT_ANN_STATIC_DIMS=96,128,384,768`
+ * (set by the `RAFT_ANN_STATIC_DIMS` CMake option; the definition is public on libraft, so that
+ * every translation unit compiled against libraft sees the same list).
+ *
+ * For a listed dimension, the loops over the dimensions are fully unrolled. The list is empty by
+ * default, because every listed dimension adds a full set of kernel instances to the compile time
+ * and to the binary size.
+ *
+ * The IVF-Flat interleaved scan is specialized on the data dimension (`index.dim()`), and the
+ * IVF-PQ similarity kernel on the number of PQ subspaces (`index.pq_dim()`).
+ *
+ * The search functions down to the kernel selection take the list as a `StaticDims` template
+ * parameter defaulting to `ann_static_dims`. The list is thus a part of the names of their
+ * instances, and the code compiled with different lists never ends up with two different
+ * definitions of the same instance.
+ */
+#ifndef RAFT_ANN_STATIC_DIMS
+#define RAFT_ANN_STATIC_DIMS
+#endif
+
+namespace raft::neighbors::ivf::detail {
+
+template <uint32_t... Dims>
+struct static_dims_t {};
+
+/** The dimensions listed in RAFT_ANN_STATIC_DIMS. */
+using ann_static_dims = static_dims_t<RAFT_ANN_STATIC_DIMS>;
+
+template <uint32_t Dim, uint32_t... Rest, typename Func>
+auto dispatch_static_dim_impl(uint32_t dim, Func&& f)
+{
+  if (dim == Dim) { return f(std::integral_constant<uint32_t, Dim>{}); }
+  if constexpr (sizeof...(Rest) > 0) {
+    return dispatch_static_dim_impl<Rest...>(dim, std::forward<Func>(f));
+  } else {
+    return f(std::integral_constant<uint32_t, 0>{});
+  }
+}
+
+/**
+ * @brief Lift the dimension to the template level when it is one of the listed dimensions.
+ *
+ * Calls `f(std::integral_constant<uint32_t, Dim>{})` for the `Dim` of the list that equals `dim`,
+ * or `f(std::integral_constant<uint32_t, 0>{})` (the dimension is known at runtime only) if there
+ * is none.
+ */
+template <uint32_t... Dims, typename Func>
+auto dispatch_static_dim(static_dims_t<Dims...>, uint32_t dim, Func&& f)
+{
+  if constexpr (sizeof...(Dims) > 0) {
+    return dispatch_static_dim_impl<Dims...>(dim, std::forward<Func>(f));
+  } else {
+    return f(std::integral_constant<uint32_t, 0>{});
+  }
+}
+
+}  // namespace raft::neighbors::ivf::detail
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <raft/core/resource/comms.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resource/cuda_stream_pool.hpp>
 #include <raft/core/resource/device_memory_resource.hpp>
@@ -24,32 +25,147 @@
 #include <raft/util/cudart_utils.hpp>
 #include <rmm/cuda_stream_pool.hpp>
 
+#include <rmm/device_scalar.hpp>
 #include <rmm/device_uvector.hpp>
 
 #include <cstdint>
 #include <iostream>
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/nvtx.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/distance/distance.cuh>
 #include <raft/distance/distance_types.hpp>
 #include <raft/linalg/map.cuh>
 #include <raft/linalg/transpose.cuh>
+#include <raft/matrix/gather.cuh>
 #include <raft/matrix/init.cuh>
 #include <raft/matrix/select_k.cuh>
+#include <raft/matrix/topk_accumulator.cuh>
+#include <raft/neighbors/brute_force_types.hpp>
 #include <raft/neighbors/detail/faiss_select/DistanceUtils.h>
+#include <raft/neighbors/detail/knn_brute_force_fused.cuh>
 #include <raft/neighbors/detail/knn_merge_parts.cuh>
+#include <raft/neighbors/sample_filter_types.hpp>
 #include <raft/spatial/knn/detail/fused_l2_knn.cuh>
 #include <raft/spatial/knn/detail/haversine_distance.cuh>
 #include <raft/spatial/knn/detail/processing.cuh>
+#include <raft/util/device_atomics.cuh>
 #include <set>
+#include <thrust/copy.h>
+#include <thrust/for_each.h>
+#include <thrust/gather.h>
+#include <thrust/iterator/counting_iterator.h>
 #include <thrust/iterator/transform_iterator.h>
+#include <thrust/scan.h>
+#include <thrust/transform_reduce.h>
 
 namespace raft::neighbors::detail {
 using namespace raft::spatial::knn::detail;
 using namespace raft::spatial::knn;
 
+/**
+ * Computes the distances between the rows [i, i + n_rows) of `search` and the rows [j, j + n_cols)
+ * of `index` into the tile `distances` [n_rows, n_cols], and applies the epilogue to them.
+ *
+ * For the L2 expanded and cosine metrics the tile is an inner product, completed with the norms
+ * of the rows (the squared L2 norms for the L2 metrics, the L2 norms for cosine).
+ */
+template <typename ElementType, typename IndexType, typename DistanceEpilogue>
+void tile_pairwise_distances(const raft::resources& handle,
+                             const ElementType* search,
+                             const ElementType* index,
+                             size_t i,
+                             size_t j,
+                             size_t current_query_size,
+                             size_t current_centroid_size,
+                             size_t d,
+                             raft::distance::DistanceType metric,
+                             float metric_arg,
+                             const ElementType* search_norms,
+                             const ElementType* index_norms,
+                             ElementType* distances,
+                             DistanceEpilogue distance_epilogue)
+{
+  auto pairwise_metric = metric;
+  if (metric == raft::distance::DistanceType::L2Expanded ||
+      metric == raft::distance::DistanceType::L2SqrtExpanded ||
+      metric == raft::distance::DistanceType::CosineExpanded) {
+    pairwise_metric = raft::distance::DistanceType::InnerProduct;
+  }
+
+  // note: we're using a int32 IndexType here on purpose in order to
+  // use the pairwise_distance instantiations. Since the tile size will ensure
+  // that the total memory is < 1GB per tile, this will not cause any issues
+  distance::pairwise_distance<ElementType, int>(handle,
+                                                search + i * d,
+                                                index + j * d,
+                                                distances,
+                                                current_query_size,
+                                                current_centroid_size,
+                                                d,
+                                                pairwise_metric,
+                                                true,
+                                                metric_arg);
+  if (metric == raft::distance::DistanceType::L2Expanded ||
+      metric == raft::distance::DistanceType::L2SqrtExpanded) {
+    auto row_norms = search_norms;
+    auto col_norms = index_norms;
+    auto dist      = distances;
+
+    raft::linalg::map_offset(
+      handle,
+      raft::make_device_vector_view(dist, current_query_size * current_centroid_size),
+      [=] __device__(IndexType idx) {
+        IndexType row = i + (idx / current_centroid_size);
+        IndexType col = j + (idx % current_centroid_size);
+
+        auto val = row_norms[row] + col_norms[col] - 2.0 * dist[idx];
+
+        // due to numerical instability (especially around self-distance)
+        // the distances here could be slightly negative, which will
+        // cause NaN values in the subsequent sqrt. Clamp to 0
+        val = val * (val >= 0.0001);
+        if (metric == raft::distance::DistanceType::L2SqrtExpanded) { val = sqrt(val); }
+        val = distance_epilogue(val, row, col);
+        return val;
+      });
+  } else if (metric == raft::distance::DistanceType::CosineExpanded) {
+    auto row_norms = search_norms;
+    auto col_norms = index_norms;
+    auto dist      = distances;
+
+    raft::linalg::map_offset(
+      handle,
+      raft::make_device_vector_view(dist, current_query_size * current_centroid_size),
+      [=] __device__(IndexType idx) {
+        IndexType row = i + (idx / current_centroid_size);
+        IndexType col = j + (idx % current_centroid_size);
+        auto val      = 1.0 - dist[idx] / (row_norms[row] * col_norms[col]);
+        val           = distance_epilogue(val, row, col);
+        return val;
+      });
+  } else {
+    // if we're not l2 distance, and we have a distance epilogue - run it now
+    if constexpr (!std::is_same_v<DistanceEpilogue, raft::identity_op>) {
+      auto distances_ptr = distances;
+      raft::linalg::map_offset(
+        handle,
+        raft::make_device_vector_view(distances, current_query_size * current_centroid_size),
+        [=] __device__(size_t idx) {
+          IndexType row = i + (idx / current_centroid_size);
+          IndexType col = j + (idx % current_centroid_size);
+          return distance_epilogue(distances_ptr[idx], row, col);
+        });
+    }
+  }
+}
+
 /**
  * Calculates brute force knn, using a fixed memory budget
  * by tiling over both the rows and columns of pairwise_distances
+ *
+ * The norms of the index rows (squared L2 norms for the L2 expanded metrics, L2 norms for cosine)
+ * can be passed via `precomputed_index_norms` to avoid computing them on every call.
  */
 template <typename ElementType      = float,
           typename IndexType        = int64_t,
@@ -64,10 +180,11 @@ void tiled_brute_force_knn(const raft::resources& handle,
                            ElementType* distances,  // size (m, k)
                            IndexType* indices,      // size (m, k)
                            raft::distance::DistanceType metric,
-                           float metric_arg                   = 2.0,
-                           size_t max_row_tile_size           = 0,
-                           size_t max_col_tile_size           = 0,
-                           DistanceEpilogue distance_epilogue = raft::identity_op())
+                           float metric_arg                           = 2.0,
+                           size_t max_row_tile_size                   = 0,
+                           size_t max_col_tile_size                   = 0,
+                           DistanceEpilogue distance_epilogue         = raft::identity_op(),
+                           const ElementType* precomputed_index_norms = nullptr)
 {
   // Figure out the number of rows/cols to tile for
   size_t tile_rows   = 0;
@@ -86,18 +203,21 @@ void tiled_brute_force_knn(const raft::resources& handle,
   tile_cols = std::max(tile_cols, k);
 
   // stores pairwise distances for the current tile
-  rmm::device_uvector<ElementType> temp_distances(tile_rows * tile_cols, stream);
+  rmm::device_uvector<ElementType> temp_distances(tile_rows * tile_cols, stream, device_memory);
 
   // calculate norms for L2 expanded distances - this lets us avoid calculating
   // norms repeatedly per-tile, and just do once for the entire input
-  auto pairwise_metric = metric;
-  rmm::device_uvector<ElementType> search_norms(0, stream);
-  rmm::device_uvector<ElementType> index_norms(0, stream);
+  rmm::device_uvector<ElementType> search_norms(0, stream, device_memory);
+  rmm::device_uvector<ElementType> index_norms(0, stream, device_memory);
+  const ElementType* index_norms_ptr = precomputed_index_norms;
   if (metric == raft::distance::DistanceType::L2Expanded ||
       metric == raft::distance::DistanceType::L2SqrtExpanded ||
       metric == raft::distance::DistanceType::CosineExpanded) {
     search_norms.resize(m, stream);
-    index_norms.resize(n, stream);
+    if (index_norms_ptr == nullptr) {
+      index_norms.resize(n, stream);
+      index_norms_ptr = index_norms.data();
+    }
     // cosine needs the l2norm, where as l2 distances needs the squared norm
     if (metric == raft::distance::DistanceType::CosineExpanded) {
       raft::linalg::rowNorm(search_norms.data(),
@@ -108,34 +228,26 @@ void tiled_brute_force_knn(const raft::resources& handle,
                             true,
                             stream,
                             raft::sqrt_op{});
-      raft::linalg::rowNorm(index_norms.data(),
-                            index,
-                            d,
-                            n,
-                            raft::linalg::NormType::L2Norm,
-                            true,
-                            stream,
-                            raft::sqrt_op{});
+      if (precomputed_index_norms == nullptr) {
+        raft::linalg::rowNorm(index_norms.data(),
+                              index,
+                              d,
+                              n,
+                              raft::linalg::NormType::L2Norm,
+                              true,
+                              stream,
+                              raft::sqrt_op{});
+      }
     } else {
       raft::linalg::rowNorm(
         search_norms.data(), search, d, m, raft::linalg::NormType::L2Norm, true, stream);
-      raft::linalg::rowNorm(
-        index_norms.data(), index, d, n, raft::linalg::NormType::L2Norm, true, stream);
+      if (precomputed_index_norms == nullptr) {
+        raft::linalg::rowNorm(
+          index_norms.data(), index, d, n, raft::linalg::NormType::L2Norm, true, stream);
+      }
     }
-    pairwise_metric = raft::distance::DistanceType::InnerProduct;
   }
 
-  // if we're tiling over columns, we need additional buffers for temporary output
-  // distances/indices
-  size_t num_col_tiles = raft::ceildiv(n, tile_cols);
-  size_t temp_out_cols = k * num_col_tiles;
-
-  // the final column tile could have less than 'k' items in it
-  // in which case the number of columns here is too high in the temp output.
-  // adjust if necessary
-  auto last_col_tile_size = n % tile_cols;
-  if (last_col_tile_size && (last_col_tile_size < k)) { temp_out_cols -= k - last_col_tile_size; }
-
   // if we have less than k items in the index, we should fill out the result
   // to indicate that we are missing items (and match behaviour in faiss)
   if (n < k) {
@@ -148,13 +260,16 @@ void tiled_brute_force_knn(const raft::resources& handle,
     }
   }
 
-  rmm::device_uvector<ElementType> temp_out_distances(tile_rows * temp_out_cols, stream);
-  rmm::device_uvector<IndexType> temp_out_indices(tile_rows * temp_out_cols, stream);
-
   bool select_min = raft::distance::is_min_close(metric);
 
+  // if we're tiling over columns, the top-k of the column tiles are merged into a running top-k
+  // of the current row tile
+  std::optional<matrix::topk_accumulator<ElementType, IndexType>> topk;
+  if (tile_cols != n) { topk.emplace(handle, tile_rows, k, select_min); }
+
   for (size_t i = 0; i < m; i += tile_rows) {
     size_t current_query_size = std::min(tile_rows, m - i);
+    if (topk.has_value()) { topk->reset(handle); }
 
     for (size_t j = 0; j < n; j += tile_cols) {
       size_t current_centroid_size = std::min(tile_cols, n - j);
@@ -162,125 +277,45 @@ void tiled_brute_force_knn(const raft::resources& handle,
 
       // calculate the top-k elements for the current tile, by calculating the
       // full pairwise distance for the tile - and then selecting the top-k from that
-      // note: we're using a int32 IndexType here on purpose in order to
-      // use the pairwise_distance instantiations. Since the tile size will ensure
-      // that the total memory is < 1GB per tile, this will not cause any issues
-      distance::pairwise_distance<ElementType, int>(handle,
-                                                    search + i * d,
-                                                    index + j * d,
-                                                    temp_distances.data(),
-                                                    current_query_size,
-                                                    current_centroid_size,
-                                                    d,
-                                                    pairwise_metric,
-                                                    true,
-                                                    metric_arg);
-      if (metric == raft::distance::DistanceType::L2Expanded ||
-          metric == raft::distance::DistanceType::L2SqrtExpanded) {
-        auto row_norms = search_norms.data();
-        auto col_norms = index_norms.data();
-        auto dist      = temp_distances.data();
-
-        raft::linalg::map_offset(
-          handle,
-          raft::make_device_vector_view(dist, current_query_size * current_centroid_size),
-          [=] __device__(IndexType idx) {
-            IndexType row = i + (idx / current_centroid_size);
-            IndexType col = j + (idx % current_centroid_size);
-
-            auto val = row_norms[row] + col_norms[col] - 2.0 * dist[idx];
-
-            // due to numerical instability (especially around self-distance)
-            // the distances here could be slightly negative, which will
-            // cause NaN values in the subsequent sqrt. Clamp to 0
-            val = val * (val >= 0.0001);
-            if (metric == raft::distance::DistanceType::L2SqrtExpanded) { val = sqrt(val); }
-            val = distance_epilogue(val, row, col);
-            return val;
-          });
-      } else if (metric == raft::distance::DistanceType::CosineExpanded) {
-        auto row_norms = search_norms.data();
-        auto col_norms = index_norms.data();
-        auto dist      = temp_distances.data();
-
-        raft::linalg::map_offset(
-          handle,
-          raft::make_device_vector_view(dist, current_query_size * current_centroid_size),
-          [=] __device__(IndexType idx) {
-            IndexType row = i + (idx / current_centroid_size);
-            IndexType col = j + (idx % current_centroid_size);
-            auto val      = 1.0 - dist[idx] / (row_norms[row] * col_norms[col]);
-            val           = distance_epilogue(val, row, col);
-            return val;
-          });
-      } else {
-        // if we're not l2 distance, and we have a distance epilogue - run it now
-        if constexpr (!std::is_same_v<DistanceEpilogue, raft::identity_op>) {
-          auto distances_ptr = temp_distances.data();
-          raft::linalg::map_offset(
-            handle,
-            raft::make_device_vector_view(temp_distances.data(),
-                                          current_query_size * current_centroid_size),
-            [=] __device__(size_t idx) {
-              IndexType row = i + (idx / current_centroid_size);
-              IndexType col = j + (idx % current_centroid_size);
-              return distance_epilogue(distances_ptr[idx], row, col);
-            });
-        }
-      }
+      tile_pairwise_distances<ElementType, IndexType>(handle,
+                                                      search,
+                                                      index,
+                                                      i,
+                                                      j,
+                                                      current_query_size,
+                                                      current_centroid_size,
+                                                      d,
+                                                      metric,
+                                                      metric_arg,
+                                                      search_norms.data(),
+                                                      index_norms_ptr,
+                                                      temp_distances.data(),
+                                                      distance_epilogue);
 
-      matrix::select_k<ElementType, IndexType>(
-        handle,
-        raft::make_device_matrix_view<const ElementType, int64_t, row_major>(
-          temp_distances.data(), current_query_size, current_centroid_size),
-        std::nullopt,
-        raft::make_device_matrix_view<ElementType, int64_t, row_major>(
-          distances + i * k, current_query_size, current_k),
-        raft::make_device_matrix_view<IndexType, int64_t, row_major>(
-          indices + i * k, current_query_size, current_k),
-        select_min);
-
-      // if we're tiling over columns, we need to do a couple things to fix up
-      // the output of select_k
-      // 1. The column id's in the output are relative to the tile, so we need
-      // to adjust the column ids by adding the column the tile starts at (j)
-      // 2. select_k writes out output in a row-major format, which means we
-      // can't just concat the output of all the tiles and do a select_k on the
-      // concatenation.
-      // Fix both of these problems in a single pass here
-      if (tile_cols != n) {
-        const ElementType* in_distances = distances + i * k;
-        const IndexType* in_indices     = indices + i * k;
-        ElementType* out_distances      = temp_out_distances.data();
-        IndexType* out_indices          = temp_out_indices.data();
-
-        auto count = thrust::make_counting_iterator<IndexType>(0);
-        thrust::for_each(resource::get_thrust_policy(handle),
-                         count,
-                         count + current_query_size * current_k,
-                         [=] __device__(IndexType i) {
-                           IndexType row = i / current_k, col = i % current_k;
-                           IndexType out_index = row * temp_out_cols + j * k / tile_cols + col;
-
-                           out_distances[out_index] = in_distances[i];
-                           out_indices[out_index]   = in_indices[i] + j;
-                         });
+      if (topk.has_value()) {
+        // the column ids in the tile are relative to the tile, hence shifted by `j`
+        topk->add(handle,
+                  raft::make_device_matrix_view<const ElementType, int64_t, row_major>(
+                    temp_distances.data(), current_query_size, current_centroid_size),
+                  std::nullopt,
+                  IndexType(j));
+      } else {
+        matrix::select_k<ElementType, IndexType>(
+          handle,
+          raft::make_device_matrix_view<const ElementType, int64_t, row_major>(
+            temp_distances.data(), current_query_size, current_centroid_size),
+          std::nullopt,
+          raft::make_device_matrix_view<ElementType, int64_t, row_major>(
+            distances + i * k, current_query_size, current_k),
+          raft::make_device_matrix_view<IndexType, int64_t, row_major>(
+            indices + i * k, current_query_size, current_k),
+          select_min);
       }
     }
 
-    if (tile_cols != n) {
-      // select the actual top-k items here from the temporary output
-      matrix::select_k<ElementType, IndexType>(
-        handle,
-        raft::make_device_matrix_view<const ElementType, int64_t, row_major>(
-          temp_out_distances.data(), current_query_size, temp_out_cols),
-        raft::make_device_matrix_view<const IndexType, int64_t, row_major>(
-          temp_out_indices.data(), current_query_size, temp_out_cols),
-        raft::make_device_matrix_view<ElementType, int64_t, row_major>(
-          distances + i * k, current_query_size, k),
-        raft::make_device_matrix_view<IndexType, int64_t, row_major>(
-          indices + i * k, current_query_size, k),
-        select_min);
+    if (topk.has_value()) {
+      raft::copy(distances + i * k, topk->values().data_handle(), current_query_size * k, stream);
+      raft::copy(indices + i * k, topk->indices().data_handle(), current_query_size * k, stream);
     }
   }
 }
@@ -437,15 +472,35 @@ void brute_force_knn_impl(
           [p] __device__(float input) { return powf(fabsf(input), p); },
           stream);
       }
+    } else if (rowMajorQuery == rowMajorIndex && rowMajorQuery == true &&
+               std::is_same_v<DistanceEpilogue, raft::identity_op> &&
+               is_fused_knn_supported(metric, k, sizes[i])) {
+      // Fuse the distances with the top-k selection to not write the distance tiles out.
+      raft::resources stream_pool_handle(handle);
+      raft::resource::set_cuda_stream(stream_pool_handle, stream);
+      fused_knn<value_t, IdxType>(stream_pool_handle,
+                                  search_items,
+                                  input[i],
+                                  n,
+                                  sizes[i],
+                                  D,
+                                  k,
+                                  out_d_ptr,
+                                  out_i_ptr,
+                                  metric);
     } else {
       switch (metric) {
-        case raft::distance::DistanceType::Haversine:
+        case raft::distance::DistanceType::Haversine: {
           ASSERT(D == 2,
                  "Haversine distance requires 2 dimensions "
                  "(latitude / longitude).");
 
-          haversine_knn(out_i_ptr, out_d_ptr, input[i], search_items, sizes[i], n, k, stream);
+          raft::resources stream_pool_handle(handle);
+          raft::resource::set_cuda_stream(stream_pool_handle, stream);
+          haversine_knn(
+            stream_pool_handle, out_i_ptr, out_d_ptr, input[i], search_items, sizes[i], n, k);
           break;
+        }
         default:
           // Create a new handle with the current stream from the stream pool
           raft::resources stream_pool_handle(handle);
@@ -493,4 +548,565 @@ void brute_force_knn_impl(
   if (translations == nullptr) delete id_ranges;
 };
 
+template <typename T>
+auto build(raft::resources const& res,
+           raft::device_matrix_view<const T, int64_t, row_major> dataset,
+           raft::distance::DistanceType metric,
+           T metric_arg) -> brute_force::index<T>
+{
+  auto stream = resource::get_cuda_stream(res);
+  std::optional<device_vector<T, int64_t>> norms;
+  // cosine needs the l2norm, where as l2 distances needs the squared norm
+  if (metric == raft::distance::DistanceType::L2Expanded ||
+      metric == raft::distance::DistanceType::L2SqrtExpanded) {
+    norms = make_device_vector<T, int64_t>(res, dataset.extent(0));
+    raft::linalg::rowNorm(norms->data_handle(),
+                          dataset.data_handle(),
+                          dataset.extent(1),
+                          dataset.extent(0),
+                          raft::linalg::NormType::L2Norm,
+                          true,
+                          stream);
+  } else if (metric == raft::distance::DistanceType::CosineExpanded) {
+    norms = make_device_vector<T, int64_t>(res, dataset.extent(0));
+    raft::linalg::rowNorm(norms->data_handle(),
+                          dataset.data_handle(),
+                          dataset.extent(1),
+                          dataset.extent(0),
+                          raft::linalg::NormType::L2Norm,
+                          true,
+                          stream,
+                          raft::sqrt_op{});
+  }
+  return brute_force::index<T>(res, dataset, std::move(norms), metric, metric_arg);
+}
+
+template <typename T, typename IdxT>
+void brute_force_search(raft::resources const& res,
+                        const brute_force::index<T>& idx,
+                        raft::device_matrix_view<const T, int64_t, row_major> queries,
+                        raft::device_matrix_view<IdxT, int64_t, row_major> neighbors,
+                        raft::device_matrix_view<T, int64_t, row_major> distances)
+{
+  RAFT_EXPECTS(neighbors.extent(1) == distances.extent(1), "Value of k must match for outputs");
+  RAFT_EXPECTS(idx.dim() == queries.extent(1),
+               "Number of columns in queries must match the index dimensionality");
+  RAFT_EXPECTS(neighbors.extent(0) == queries.extent(0) && distances.extent(0) == queries.extent(0),
+               "Number of rows in the outputs must match the number of queries");
+  const size_t m    = queries.extent(0);
+  const size_t n    = idx.size();
+  const size_t d    = idx.dim();
+  const size_t k    = neighbors.extent(1);
+  const T* norms    = idx.has_norms() ? idx.norms().data_handle() : nullptr;
+  const auto metric = idx.metric();
+
+  if (is_fused_knn_supported(metric, k, n)) {
+    fused_knn<T, IdxT>(res,
+                       queries.data_handle(),
+                       idx.dataset().data_handle(),
+                       m,
+                       n,
+                       d,
+                       k,
+                       distances.data_handle(),
+                       neighbors.data_handle(),
+                       metric,
+                       norms);
+  } else {
+    tiled_brute_force_knn<T, IdxT>(res,
+                                   queries.data_handle(),
+                                   idx.dataset().data_handle(),
+                                   m,
+                                   n,
+                                   d,
+                                   k,
+                                   distances.data_handle(),
+                                   neighbors.data_handle(),
+                                   metric,
+                                   idx.metric_arg(),
+                                   0,
+                                   0,
+                                   raft::identity_op{},
+                                   norms);
+  }
+}
+
+/**
+ * See raft::neighbors::brute_force::search_mg docs.
+ *
+ * The queries are searched in batches, so that the candidates gathered from all ranks take at most
+ * `max_gathered_bytes` (the same on all ranks).
+ */
+template <typename T, typename IdxT>
+void brute_force_search_mg(raft::resources const& res,
+                           const brute_force::index<T>& local_index,
+                           raft::device_matrix_view<const T, int64_t, row_major> queries,
+                           raft::device_matrix_view<IdxT, int64_t, row_major> neighbors,
+                           raft::device_matrix_view<T, int64_t, row_major> distances,
+                           size_t max_gathered_bytes = size_t(1) << 30)
+{
+  RAFT_EXPECTS(resource::comms_initialized(res),
+               "brute_force::search_mg: the handle must have an initialized communicator");
+  const auto& comms    = resource::get_comms(res);
+  const int n_ranks    = comms.get_size();
+  auto stream          = resource::get_cuda_stream(res);
+  auto mr              = resource::get_workspace_resource(res);
+  const auto n_queries = queries.extent(0);
+  const auto k         = neighbors.extent(1);
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "brute_force::search_mg(%zu, k = %zu, rank = %d)", size_t(n_queries), k, comms.get_rank());
+  RAFT_EXPECTS(neighbors.extent(1) == distances.extent(1), "Value of k must match for outputs");
+  RAFT_EXPECTS(k <= 1024, "brute_force::search_mg: k must be <= 1024 (knn_merge_parts limit)");
+  RAFT_EXPECTS(size_t(local_index.size()) >= size_t(k),
+               "brute_force::search_mg: every shard must contain at least k rows");
+
+  // The shards are numbered by rank: the global ids of the shard `r` are offset by the sizes of
+  // the shards of the lower ranks.
+  rmm::device_uvector<IdxT> translations(n_ranks, stream, mr);
+  {
+    rmm::device_uvector<uint64_t> shard_sizes(n_ranks, stream, mr);
+    rmm::device_scalar<uint64_t> local_size(uint64_t(local_index.size()), stream);
+    comms.allgather(local_size.data(), shard_sizes.data(), 1, stream);
+    RAFT_EXPECTS(comms.sync_stream(stream) == comms::status_t::SUCCESS,
+                 "brute_force::search_mg: allgather of the shard sizes failed");
+    std::vector<uint64_t> shard_sizes_host(n_ranks);
+    std::vector<IdxT> translations_host(n_ranks);
+    raft::copy(shard_sizes_host.data(), shard_sizes.data(), n_ranks, stream);
+    resource::sync_stream(res);
+    uint64_t offset = 0;
+    for (int r = 0; r < n_ranks; r++) {
+      translations_host[r] = IdxT(offset);
+      offset += shard_sizes_host[r];
+    }
+    raft::copy(translations.data(), translations_host.data(), n_ranks, stream);
+  }
+
+  // knn_merge_parts always selects the minimum; flip the sign of the similarities.
+  const bool select_min = raft::distance::is_min_close(local_index.metric());
+
+  // Bound the size of the gathered candidates by batching the queries (the same on all ranks).
+  const size_t batch_size =
+    std::max<size_t>(1, max_gathered_bytes / (n_ranks * k * (sizeof(T) + sizeof(IdxT))));
+  const size_t max_batch = std::min<size_t>(batch_size, n_queries);
+  rmm::device_uvector<T> local_dists(max_batch * k, stream, mr);
+  rmm::device_uvector<IdxT> local_ids(max_batch * k, stream, mr);
+  rmm::device_uvector<T> all_dists(n_ranks * max_batch * k, stream, mr);
+  rmm::device_uvector<IdxT> all_ids(n_ranks * max_batch * k, stream, mr);
+  for (size_t offset = 0; offset < size_t(n_queries); offset += max_batch) {
+    const size_t batch = std::min<size_t>(max_batch, n_queries - offset);
+    brute_force_search<T, IdxT>(
+      res,
+      local_index,
+      make_device_matrix_view<const T, int64_t>(
+        queries.data_handle() + offset * queries.extent(1), batch, queries.extent(1)),
+      make_device_matrix_view<IdxT, int64_t>(local_ids.data(), batch, k),
+      make_device_matrix_view<T, int64_t>(local_dists.data(), batch, k));
+
+    // The gathered results of the rank `r` are stored contiguously as a [batch, k] matrix, which
+    // is exactly the layout of the parts expected by knn_merge_parts.
+    comms.allgather(local_dists.data(), all_dists.data(), batch * k, stream);
+    comms.allgather(local_ids.data(), all_ids.data(), batch * k, stream);
+    RAFT_EXPECTS(comms.sync_stream(stream) == comms::status_t::SUCCESS,
+                 "brute_force::search_mg: allgather of the partial results failed");
+
+    auto out_dists = distances.data_handle() + offset * k;
+    if (!select_min) {
+      linalg::map(res,
+                  make_device_vector_view<T, int64_t>(all_dists.data(), n_ranks * batch * k),
+                  raft::mul_const_op<T>(T(-1)),
+                  make_device_vector_view<const T, int64_t>(all_dists.data(), n_ranks * batch * k));
+    }
+    knn_merge_parts(all_dists.data(),
+                    all_ids.data(),
+                    out_dists,
+                    neighbors.data_handle() + offset * k,
+                    batch,
+                    n_ranks,
+                    k,
+                    stream,
+                    translations.data());
+    if (!select_min) {
+      linalg::map(res,
+                  make_device_vector_view<T, int64_t>(out_dists, batch * k),
+                  raft::mul_const_op<T>(T(-1)),
+                  make_device_vector_view<const T, int64_t>(out_dists, batch * k));
+    }
+  }
+}
+
+/** Replaces the distances to the samples rejected by the filter with a value never selected. */
+template <typename T, typename FilterT>
+struct filtered_distance_op {
+  FilterT filter;
+  T masked_value;
+
+  template <typename RowT, typename ColT>
+  inline _RAFT_HOST_DEVICE auto operator()(T val, RowT row, ColT col) const -> T
+  {
+    return filter(uint32_t(row), int64_t(col)) ? val : masked_value;
+  }
+};
+
+/** See raft::neighbors::brute_force::search_with_filtering docs */
+template <typename T, typename IdxT>
+void brute_force_search_filtered(raft::resources const& res,
+                                 const brute_force::index<T>& idx,
+                                 raft::device_matrix_view<const T, int64_t, row_major> queries,
+                                 raft::device_matrix_view<IdxT, int64_t, row_major> neighbors,
+                                 raft::device_matrix_view<T, int64_t, row_major> distances,
+                                 raft::device_vector_view<const uint32_t, int64_t> filter_bitset)
+{
+  // The allowed rows are compacted when at most this fraction of the index passes the filter:
+  // gathering them costs one more pass over them, while no distance is computed to the others.
+  constexpr double kMaxCompactedFraction = 0.25;
+  // The allowed rows are gathered in chunks of at most this size.
+  constexpr size_t kMaxCompactedBytes = size_t(1) << 30;
+
+  RAFT_EXPECTS(neighbors.extent(1) == distances.extent(1), "Value of k must match for outputs");
+  RAFT_EXPECTS(idx.dim() == queries.extent(1),
+               "Number of columns in queries must match the index dimensionality");
+  RAFT_EXPECTS(neighbors.extent(0) == queries.extent(0) && distances.extent(0) == queries.extent(0),
+               "Number of rows in the outputs must match the number of queries");
+  const int64_t m       = queries.extent(0);
+  const int64_t n       = idx.size();
+  const int64_t d       = idx.dim();
+  const int64_t k       = neighbors.extent(1);
+  const int64_t n_words = raft::ceildiv<int64_t>(n, 32);
+  RAFT_EXPECTS(filter_bitset.extent(0) >= n_words,
+               "The filter bitset must have a bit per index row (%zu words)",
+               size_t(n_words));
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "brute_force::search_with_filtering(%zu, k = %zu)", size_t(m), size_t(k));
+
+  auto stream           = resource::get_cuda_stream(res);
+  auto mr               = resource::get_workspace_resource(res);
+  auto policy           = resource::get_thrust_policy(res);
+  const auto metric     = idx.metric();
+  const bool select_min = raft::distance::is_min_close(metric);
+  const T masked_value  = select_min ? upper_bound<T>() : lower_bound<T>();
+  using filter_type = filtering::bitset_filter<int64_t>;
+  const filter_type filter(filter_bitset.data_handle());
+  auto out_nbrs  = neighbors.data_handle();
+  auto out_dists = distances.data_handle();
+
+  // The bits past the end of the index are ignored.
+  const int64_t n_allowed = thrust::transform_reduce(
+    policy,
+    thrust::make_counting_iterator<int64_t>(0),
+    thrust::make_counting_iterator<int64_t>(n_words),
+    [bits = filter_bitset.data_handle(), n] __device__(int64_t w) -> int64_t {
+      uint32_t word = bits[w];
+      if ((w + 1) * 32 > n) { word &= (uint32_t(1) << (n % 32)) - 1u; }
+      return __popc(word);
+    },
+    int64_t(0),
+    thrust::plus<int64_t>());
+
+  if (n_allowed == 0) {
+    matrix::fill(res, distances, masked_value);
+    matrix::fill(res, neighbors, static_cast<IdxT>(-1));
+    return;
+  }
+
+  if (double(n_allowed) > kMaxCompactedFraction * double(n)) {
+    // Most of the rows pass: compute all the distances, but mask the rejected rows before the
+    // top-k selection.
+    tiled_brute_force_knn<T, IdxT>(res,
+                                   queries.data_handle(),
+                                   idx.dataset().data_handle(),
+                                   m,
+                                   n,
+                                   d,
+                                   k,
+                                   out_dists,
+                                   out_nbrs,
+                                   metric,
+                                   idx.metric_arg(),
+                                   0,
+                                   0,
+                                   filtered_distance_op<T, filter_type>{filter, masked_value},
+                                   idx.has_norms() ? idx.norms().data_handle() : nullptr);
+    if (n_allowed < k) {
+      // The tails of the results are the masked rows.
+      thrust::for_each(policy,
+                       thrust::make_counting_iterator<int64_t>(0),
+                       thrust::make_counting_iterator<int64_t>(m * k),
+                       [=] __device__(int64_t i) {
+                         const auto j = int64_t(out_nbrs[i]);
+                         if (j < 0 || j >= n || !filter(uint32_t(i / k), j)) {
+                           out_nbrs[i]  = static_cast<IdxT>(-1);
+                           out_dists[i] = masked_value;
+                         }
+                       });
+    }
+    return;
+  }
+
+  // Few rows pass: compact their ids and compute the distances to these rows only. The rows are
+  // gathered into a compact index chunk by chunk to bound the memory, and the top-k of the chunks
+  // are merged.
+  rmm::device_uvector<IdxT> ids(n_allowed, stream, mr);
+  thrust::copy_if(policy,
+                  thrust::make_counting_iterator<IdxT>(0),
+                  thrust::make_counting_iterator<IdxT>(n),
+                  ids.begin(),
+                  [filter] __device__(IdxT i) { return filter(0, int64_t(i)); });
+
+  const int64_t chunk_rows = std::min<int64_t>(
+    n_allowed, std::max<int64_t>(k, kMaxCompactedBytes / (d * sizeof(T))));
+  auto chunk_data = make_device_matrix<T, int64_t>(res, chunk_rows, d);
+  std::optional<matrix::topk_accumulator<T, IdxT>> topk;
+  if (chunk_rows < n_allowed) { topk.emplace(res, m, k, select_min); }
+  const bool direct = !topk.has_value() && chunk_rows >= k;
+  rmm::device_uvector<T> chunk_dists(direct ? 0 : m * std::min(k, chunk_rows), stream, mr);
+  rmm::device_uvector<IdxT> chunk_nbrs(direct ? 0 : m * std::min(k, chunk_rows), stream, mr);
+
+  for (int64_t offset = 0; offset < n_allowed; offset += chunk_rows) {
+    const int64_t rows = std::min(chunk_rows, n_allowed - offset);
+    const int64_t ck   = std::min(k, rows);
+    auto chunk_ids     = ids.data() + offset;
+    auto chunk_view    = make_device_matrix_view<T, int64_t>(chunk_data.data_handle(), rows, d);
+    matrix::gather(res,
+                   idx.dataset(),
+                   make_device_vector_view<const IdxT, int64_t>(chunk_ids, rows),
+                   chunk_view);
+    std::optional<device_vector<T, int64_t>> chunk_norms;
+    if (idx.has_norms()) {
+      chunk_norms = make_device_vector<T, int64_t>(res, rows);
+      thrust::gather(policy,
+                     chunk_ids,
+                     chunk_ids + rows,
+                     idx.norms().data_handle(),
+                     chunk_norms->data_handle());
+    }
+    brute_force::index<T> chunk_index(
+      res,
+      make_device_matrix_view<const T, int64_t>(chunk_data.data_handle(), rows, d),
+      std::move(chunk_norms),
+      metric,
+      idx.metric_arg());
+
+    auto nbrs  = direct ? out_nbrs : chunk_nbrs.data();
+    auto dists = direct ? out_dists : chunk_dists.data();
+    brute_force_search<T, IdxT>(res,
+                                chunk_index,
+                                queries,
+                                make_device_matrix_view<IdxT, int64_t>(nbrs, m, ck),
+                                make_device_matrix_view<T, int64_t>(dists, m, ck));
+    // The neighbors are the positions in the chunk, map them to the rows of the index.
+    linalg::map(
+      res,
+      make_device_vector_view<IdxT, int64_t>(nbrs, m * ck),
+      [chunk_ids, rows] __device__(IdxT j) {
+        return int64_t(j) >= 0 && int64_t(j) < rows ? chunk_ids[j] : static_cast<IdxT>(-1);
+      },
+      make_device_vector_view<const IdxT, int64_t>(nbrs, m * ck));
+
+    if (topk.has_value()) {
+      topk->add(res,
+                make_device_matrix_view<const T, int64_t>(dists, m, ck),
+                make_device_matrix_view<const IdxT, int64_t>(nbrs, m, ck));
+    } else if (!direct) {
+      // Fewer rows pass than the requested number of neighbors: pad the results.
+      thrust::for_each(policy,
+                       thrust::make_counting_iterator<int64_t>(0),
+                       thrust::make_counting_iterator<int64_t>(m * k),
+                       [=] __device__(int64_t i) {
+                         const int64_t row = i / k;
+                         const int64_t col = i % k;
+                         out_nbrs[i]  = col < ck ? nbrs[row * ck + col] : static_cast<IdxT>(-1);
+                         out_dists[i] = col < ck ? dists[row * ck + col] : masked_value;
+                       });
+    }
+  }
+
+  if (topk.has_value()) {
+    raft::copy(out_dists, topk->values().data_handle(), m * k, stream);
+    raft::copy(out_nbrs, topk->indices().data_handle(), m * k, stream);
+  }
+}
+
+/**
+ * One pass of the range search over a tile of distances [n_rows, n_cols]: the block (x, y) checks
+ * the columns [x * TPB, (x + 1) * TPB) of the row y of the tile.
+ *
+ * `CountOnly`: the number of the neighbors within the radius is added to `row_counters` of every
+ * query. Otherwise, `row_counters` are the write positions of the queries in the CSR output: every
+ * warp reserves the space for its neighbors with a single atomic.
+ */
+template <bool CountOnly, int TPB, typename T, typename IdxT>
+__global__ void __launch_bounds__(TPB) range_search_tile_kernel(const T* tile,
+                                                                size_t n_cols,
+                                                                size_t row_offset,
+                                                                size_t col_offset,
+                                                                T radius,
+                                                                bool select_min,
+                                                                int64_t* row_counters,
+                                                                IdxT* out_indices,
+                                                                T* out_distances)
+{
+  const size_t row    = blockIdx.y;
+  const size_t col    = size_t(blockIdx.x) * TPB + threadIdx.x;
+  const bool valid    = col < n_cols;
+  const T val         = valid ? tile[row * n_cols + col] : T(0);
+  const bool in_range = valid && (select_min ? val <= radius : val >= radius);
+  // the mask is the same for all lanes of the warp
+  const uint32_t mask = raft::ballot(in_range);
+  if (mask == 0) { return; }
+  const int lane_id     = raft::laneId();
+  const auto n_in_range = static_cast<int64_t>(__popc(mask));
+  int64_t* row_counter  = row_counters + row_offset + row;
+  if constexpr (CountOnly) {
+    if (lane_id == 0) { atomicAdd(row_counter, n_in_range); }
+  } else {
+    int64_t pos = 0;
+    if (lane_id == 0) { pos = atomicAdd(row_counter, n_in_range); }
+    pos = raft::shfl(pos, 0);
+    if (in_range) {
+      pos += __popc(mask & ((1u << lane_id) - 1u));
+      out_indices[pos]   = static_cast<IdxT>(col_offset + col);
+      out_distances[pos] = val;
+    }
+  }
+}
+
+/** See raft::neighbors::brute_force::range_search docs */
+template <typename T, typename IdxT>
+void brute_force_range_search(raft::resources const& res,
+                              const brute_force::index<T>& idx,
+                              raft::device_matrix_view<const T, int64_t, row_major> queries,
+                              T radius,
+                              raft::device_csr_matrix<T, int64_t, IdxT, int64_t>& out)
+{
+  RAFT_EXPECTS(idx.dim() == queries.extent(1),
+               "Number of columns in queries must match the index dimensionality");
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "brute_force::range_search(n_queries = %zu, n_rows = %zu)",
+    size_t(queries.extent(0)),
+    size_t(idx.size()));
+
+  const size_t m        = queries.extent(0);
+  const size_t n        = idx.size();
+  const size_t d        = idx.dim();
+  const auto metric     = idx.metric();
+  const bool select_min = raft::distance::is_min_close(metric);
+  auto stream           = resource::get_cuda_stream(res);
+  auto device_memory    = resource::get_workspace_resource(res);
+  const T* search       = queries.data_handle();
+  const T* index        = idx.dataset().data_handle();
+
+  // the output is sized once the number of the neighbors is known
+  auto init_output = [&](int64_t nnz) {
+    out.initialize_sparsity(nnz);
+    auto structure = out.structure_view();
+    RAFT_EXPECTS(size_t(structure.get_n_rows()) == m && size_t(structure.get_n_cols()) == n,
+                 "The output must be a CSR matrix of shape [n_queries, index.size()]");
+    return structure;
+  };
+  if (m == 0 || n == 0) {
+    auto structure = init_output(0);
+    RAFT_CUDA_TRY(
+      cudaMemsetAsync(structure.get_indptr().data(), 0, (m + 1) * sizeof(int64_t), stream));
+    return;
+  }
+
+  size_t tile_rows = 0;
+  size_t tile_cols = 0;
+  auto total_mem   = device_memory->get_mem_info(stream).second;
+  faiss_select::chooseTileSize(m, n, d, sizeof(T), total_mem, tile_rows, tile_cols);
+  rmm::device_uvector<T> temp_distances(tile_rows * tile_cols, stream, device_memory);
+
+  // the norms of the expanded metrics, the index ones are usually precomputed by `build`
+  rmm::device_uvector<T> search_norms(0, stream, device_memory);
+  rmm::device_uvector<T> index_norms(0, stream, device_memory);
+  const T* index_norms_ptr = idx.has_norms() ? idx.norms().data_handle() : nullptr;
+  if (metric == raft::distance::DistanceType::L2Expanded ||
+      metric == raft::distance::DistanceType::L2SqrtExpanded ||
+      metric == raft::distance::DistanceType::CosineExpanded) {
+    const bool cosine = metric == raft::distance::DistanceType::CosineExpanded;
+    auto row_norms    = [&](T* out_norms, const T* data, size_t n_rows) {
+      if (cosine) {
+        raft::linalg::rowNorm(out_norms,
+                              data,
+                              d,
+                              n_rows,
+                              raft::linalg::NormType::L2Norm,
+                              true,
+                              stream,
+                              raft::sqrt_op{});
+      } else {
+        raft::linalg::rowNorm(
+          out_norms, data, d, n_rows, raft::linalg::NormType::L2Norm, true, stream);
+      }
+    };
+    search_norms.resize(m, stream);
+    row_norms(search_norms.data(), search, m);
+    if (index_norms_ptr == nullptr) {
+      index_norms.resize(n, stream);
+      row_norms(index_norms.data(), index, n);
+      index_norms_ptr = index_norms.data();
+    }
+  }
+
+  // the number of neighbors of every query in the first pass, the write positions in the second
+  rmm::device_uvector<int64_t> row_counters(m, stream, device_memory);
+  RAFT_CUDA_TRY(cudaMemsetAsync(row_counters.data(), 0, m * sizeof(int64_t), stream));
+
+  constexpr int kTPB = 256;
+  auto scan_tiles    = [&](auto count_only, IdxT* out_indices, T* out_distances) {
+    constexpr bool kCountOnly = decltype(count_only)::value;
+    for (size_t i = 0; i < m; i += tile_rows) {
+      const size_t current_query_size = std::min(tile_rows, m - i);
+      for (size_t j = 0; j < n; j += tile_cols) {
+        const size_t current_centroid_size = std::min(tile_cols, n - j);
+        tile_pairwise_distances<T, int64_t>(res,
+                                            search,
+                                            index,
+                                            i,
+                                            j,
+                                            current_query_size,
+                                            current_centroid_size,
+                                            d,
+                                            metric,
+                                            idx.metric_arg(),
+                                            search_norms.data(),
+                                            index_norms_ptr,
+                                            temp_distances.data(),
+                                            raft::identity_op{});
+        dim3 grid(raft::ceildiv<size_t>(current_centroid_size, kTPB), current_query_size, 1);
+        range_search_tile_kernel<kCountOnly, kTPB, T, IdxT>
+          <<<grid, kTPB, 0, stream>>>(temp_distances.data(),
+                                      current_centroid_size,
+                                      i,
+                                      j,
+                                      radius,
+                                      select_min,
+                                      row_counters.data(),
+                                      out_indices,
+                                      out_distances);
+        RAFT_CUDA_TRY(cudaPeekAtLastError());
+      }
+    }
+  };
+
+  // first pass: count the neighbors, the row offsets are their prefix sum
+  scan_tiles(std::true_type{}, nullptr, nullptr);
+  rmm::device_uvector<int64_t> indptr(m + 1, stream, device_memory);
+  RAFT_CUDA_TRY(cudaMemsetAsync(indptr.data(), 0, sizeof(int64_t), stream));
+  thrust::inclusive_scan(resource::get_thrust_policy(res),
+                         row_counters.data(),
+                         row_counters.data() + m,
+                         indptr.data() + 1);
+  int64_t nnz;
+  raft::update_host(&nnz, indptr.data() + m, 1, stream);
+  resource::sync_stream(res, stream);
+  auto structure = init_output(nnz);
+  raft::copy(structure.get_indptr().data(), indptr.data(), m + 1, stream);
+  if (nnz == 0) { return; }
+
+  // second pass: recompute the distances and write the neighbors
+  raft::copy(row_counters.data(), indptr.data(), m, stream);
+  scan_tiles(std::false_type{}, structure.get_indices().data(), out.get_elements().data());
+}
+
 }  // namespace raft::neighbors::detail
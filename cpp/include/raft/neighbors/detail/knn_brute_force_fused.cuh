@@ -0,0 +1,488 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/detail/distance_ops/cosine.cuh>
+#include <raft/distance/detail/distance_ops/l2_exp.cuh>
+#include <raft/distance/detail/distance_ops/l2_unexp.cuh>
+#include <raft/distance/detail/pairwise_distance_base.cuh>
+#include <raft/distance/distance_types.hpp>
+#include <raft/linalg/contractions.cuh>
+#include <raft/linalg/norm.cuh>
+#include <raft/matrix/detail/select_k.cuh>
+#include <raft/matrix/detail/select_warpsort.cuh>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <algorithm>
+#include <cstdint>
+
+namespace raft::neighbors::detail {
+
+/**
+ * The largest k supported by the fused brute-force kernel
+ * (the capacity of the warp-level priority queues).
+ */
+constexpr int kFusedKnnMaxK = matrix::detail::select::warpsort::kMaxCapacity;
+
+/**
+ * @brief the inner product "distance" for the fused brute-force kernel
+ *
+ * It computes the following equation:
+ *
+ * c_ij = sum_k x_ik * y_kj
+ *
+ * NB: in contrast to the other metrics, the nearest neighbors have the largest values.
+ */
+template <typename DataType, typename AccType, typename IdxType>
+struct inner_product_op {
+  using DataT = DataType;
+  using AccT  = AccType;
+  using IdxT  = IdxType;
+
+  static constexpr bool use_norms            = false;
+  static constexpr bool expensive_inner_loop = false;
+
+  template <typename Policy>
+  static constexpr size_t shared_mem_size()
+  {
+    return Policy::SmemSize;
+  }
+
+  DI void core(AccT& acc, DataT& x, DataT& y) const { acc += x * y; };
+
+  template <typename Policy>
+  DI void epilog(AccT acc[Policy::AccRowsPerTh][Policy::AccColsPerTh],
+                 DataT* regxn,
+                 DataT* regyn,
+                 IdxT gridStrideX,
+                 IdxT gridStrideY) const
+  {
+  }
+};
+
+/** Whether `fused_knn` can be used for the given metric and k. */
+inline auto is_fused_knn_supported(raft::distance::DistanceType metric, size_t k, size_t n) -> bool
+{
+  if (k > size_t(kFusedKnnMaxK) || k > n) { return false; }
+  switch (metric) {
+    case raft::distance::DistanceType::L2Expanded:
+    case raft::distance::DistanceType::L2SqrtExpanded:
+    case raft::distance::DistanceType::L2Unexpanded:
+    case raft::distance::DistanceType::L2SqrtUnexpanded:
+    case raft::distance::DistanceType::InnerProduct:
+    case raft::distance::DistanceType::CosineExpanded: return true;
+    default: return false;
+  }
+}
+
+/**
+ * Compute the pairwise distances between a block tile of the queries and the index and select
+ * the top-k of every query row without writing the distances out.
+ *
+ * Every row of the block tile is processed by a single warp (`Policy::AccThCols == WarpSize`),
+ * so every warp keeps `Policy::AccRowsPerTh` warp-level queues. A block processes exactly one
+ * tile of rows (`gridDim.y * Policy::Mblk >= m`) and a grid-strided subset of the column tiles;
+ * the queues persist across the column tiles. On exit, every block stores its own top-k
+ * candidates for every row in `out_dists/out_inds [m, gridDim.x, k]`.
+ */
+template <typename DataT,
+          typename OutT,
+          typename IdxT,
+          typename Policy,
+          typename OpT,
+          int Capacity,
+          bool SelectMin>
+__global__ __launch_bounds__(Policy::Nthreads, 2) void fused_knn_kernel(const DataT* x,
+                                                                        const DataT* y,
+                                                                        const DataT* xn,
+                                                                        const DataT* yn,
+                                                                        const IdxT m,
+                                                                        const IdxT n,
+                                                                        const IdxT dim,
+                                                                        OpT distance_op,
+                                                                        uint32_t k,
+                                                                        OutT* out_dists,
+                                                                        IdxT* out_inds)
+{
+  using AccT    = typename OpT::AccT;
+  using queue_t =
+    matrix::detail::select::warpsort::warp_sort_filtered<Capacity, SelectMin, AccT, IdxT>;
+  static_assert(Policy::AccThCols == WarpSize, "fused_knn: one warp must process one row");
+  static_assert(Policy::AccRowsPerTh <= 2, "fused_knn: at most two rows per thread");
+  extern __shared__ char smem[];
+
+  queue_t queue1(k);
+  queue_t queue2(k);
+  queue_t* queues[] = {&queue1, &queue2};
+
+  auto epilog_lambda =
+    [&queues, m, n] __device__(AccT acc[Policy::AccRowsPerTh][Policy::AccColsPerTh],
+                               DataT * regxn,
+                               DataT * regyn,
+                               IdxT gridStrideX,
+                               IdxT gridStrideY) {
+      const IdxT starty = gridStrideY + (threadIdx.x / Policy::AccThCols);
+      const IdxT startx = gridStrideX + (threadIdx.x % Policy::AccThCols);
+#pragma unroll
+      for (int i = 0; i < Policy::AccRowsPerTh; ++i) {
+        // The row is the same for the whole warp, hence the warp never diverges here.
+        if (starty + i * Policy::AccThRows >= m) { continue; }
+#pragma unroll
+        for (int j = 0; j < Policy::AccColsPerTh; ++j) {
+          const IdxT colId = startx + j * Policy::AccThCols;
+          queues[i]->add(colId < n ? acc[i][j] : queue_t::kDummy, colId);
+        }
+      }
+    };
+
+  auto rowEpilog_lambda = [&queues, m, k, out_dists, out_inds] __device__(IdxT gridStrideY) {
+    const IdxT starty = gridStrideY + (threadIdx.x / Policy::AccThCols);
+#pragma unroll
+    for (int i = 0; i < Policy::AccRowsPerTh; ++i) {
+      const IdxT rowId = starty + i * Policy::AccThRows;
+      if (rowId >= m) { continue; }
+      queues[i]->done();
+      const size_t out_offset = (size_t(rowId) * gridDim.x + blockIdx.x) * k;
+      queues[i]->store(out_dists + out_offset, out_inds + out_offset);
+    }
+  };
+
+  constexpr bool write_out = false;
+  raft::distance::detail::PairwiseDistances<DataT,
+                                            AccT,
+                                            IdxT,
+                                            Policy,
+                                            OpT,
+                                            decltype(epilog_lambda),
+                                            raft::identity_op,
+                                            decltype(rowEpilog_lambda),
+                                            true,
+                                            write_out>
+    obj(x,
+        y,
+        m,
+        n,
+        dim,
+        dim,
+        dim,
+        n,
+        xn,
+        yn,
+        nullptr,  // output ptr, can be null as write_out == false.
+        smem,
+        distance_op,
+        epilog_lambda,
+        raft::identity_op{},
+        rowEpilog_lambda);
+  obj.run();
+}
+
+template <typename DataT, typename IdxT, int VecLen, int Capacity, bool SelectMin, typename OpT>
+void fused_knn_impl(raft::resources const& handle,
+                    const DataT* search,
+                    const DataT* index,
+                    const DataT* search_norms,
+                    const DataT* index_norms,
+                    IdxT m,
+                    IdxT n,
+                    IdxT d,
+                    IdxT k,
+                    OpT distance_op,
+                    DataT* distances,
+                    IdxT* indices)
+{
+  using AccT   = typename OpT::AccT;
+  using Policy = typename raft::linalg::Policy2x8<DataT, VecLen>::Policy;
+  auto stream  = resource::get_cuda_stream(handle);
+  auto mr      = resource::get_workspace_resource(handle);
+
+  constexpr auto kernel = fused_knn_kernel<DataT, AccT, IdxT, Policy, OpT, Capacity, SelectMin>;
+  const auto smem_size  = distance_op.template shared_mem_size<Policy>();
+
+  int dev_id;
+  int n_sms;
+  int blocks_per_sm = 0;
+  RAFT_CUDA_TRY(cudaGetDevice(&dev_id));
+  RAFT_CUDA_TRY(cudaDeviceGetAttribute(&n_sms, cudaDevAttrMultiProcessorCount, dev_id));
+  RAFT_CUDA_TRY(cudaOccupancyMaxActiveBlocksPerMultiprocessor(
+    &blocks_per_sm, kernel, Policy::Nthreads, smem_size));
+  const size_t min_grid_size = size_t(n_sms) * size_t(std::max(blocks_per_sm, 1));
+
+  // Every block processes exactly one tile of rows, hence the batching along the grid y-dim.
+  constexpr size_t kMaxGridY = 65535;
+  const size_t max_batch     = kMaxGridY * Policy::Mblk;
+  const size_t x_chunks      = raft::ceildiv<size_t>(n, Policy::Nblk);
+  rmm::device_uvector<AccT> tmp_distances(0, stream, mr);
+  rmm::device_uvector<IdxT> tmp_indices(0, stream, mr);
+  for (size_t offset = 0; offset < size_t(m); offset += max_batch) {
+    const auto batch = std::min<size_t>(max_batch, m - offset);
+    dim3 grid;
+    grid.y = raft::ceildiv<size_t>(batch, Policy::Mblk);
+    // Split the columns among the blocks only to fill the device.
+    grid.x = std::min<size_t>(x_chunks, std::max<size_t>(1, min_grid_size / grid.y));
+    dim3 blk(Policy::Nthreads);
+
+    auto batch_norms = search_norms == nullptr ? nullptr : search_norms + offset;
+    auto out_dists   = distances + offset * k;
+    auto out_inds    = indices + offset * k;
+    if (grid.x > 1) {
+      tmp_distances.resize(batch * grid.x * k, stream);
+      tmp_indices.resize(batch * grid.x * k, stream);
+      out_dists = tmp_distances.data();
+      out_inds  = tmp_indices.data();
+    }
+    kernel<<<grid, blk, smem_size, stream>>>(search + offset * d,
+                                             index,
+                                             batch_norms,
+                                             index_norms,
+                                             IdxT(batch),
+                                             n,
+                                             d,
+                                             distance_op,
+                                             uint32_t(k),
+                                             out_dists,
+                                             out_inds);
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+    if (grid.x > 1) {
+      // Merge the per-block candidates.
+      matrix::detail::select_k<AccT, IdxT>(tmp_distances.data(),
+                                           tmp_indices.data(),
+                                           batch,
+                                           grid.x * k,
+                                           k,
+                                           distances + offset * k,
+                                           indices + offset * k,
+                                           SelectMin,
+                                           stream,
+                                           mr);
+    }
+  }
+}
+
+template <typename DataT, typename IdxT, int VecLen, bool SelectMin, typename OpT>
+void fused_knn_dispatch_capacity(raft::resources const& handle,
+                                 const DataT* x,
+                                 const DataT* y,
+                                 const DataT* xn,
+                                 const DataT* yn,
+                                 IdxT m,
+                                 IdxT n,
+                                 IdxT d,
+                                 IdxT k,
+                                 OpT distance_op,
+                                 DataT* distances,
+                                 IdxT* indices)
+{
+  // NB: the capacity is at least a warp, because the whole warp keeps one queue.
+  if (k <= 32) {
+    fused_knn_impl<DataT, IdxT, VecLen, 32, SelectMin>(
+      handle, x, y, xn, yn, m, n, d, k, distance_op, distances, indices);
+  } else if (k <= 64) {
+    fused_knn_impl<DataT, IdxT, VecLen, 64, SelectMin>(
+      handle, x, y, xn, yn, m, n, d, k, distance_op, distances, indices);
+  } else if (k <= 128) {
+    fused_knn_impl<DataT, IdxT, VecLen, 128, SelectMin>(
+      handle, x, y, xn, yn, m, n, d, k, distance_op, distances, indices);
+  } else {
+    RAFT_EXPECTS(k <= kFusedKnnMaxK, "fused_knn: k must be <= %d", kFusedKnnMaxK);
+    fused_knn_impl<DataT, IdxT, VecLen, 256, SelectMin>(
+      handle, x, y, xn, yn, m, n, d, k, distance_op, distances, indices);
+  }
+}
+
+template <typename DataT, typename IdxT, bool SelectMin, typename OpT>
+void fused_knn_dispatch(raft::resources const& handle,
+                        const DataT* x,
+                        const DataT* y,
+                        const DataT* xn,
+                        const DataT* yn,
+                        IdxT m,
+                        IdxT n,
+                        IdxT d,
+                        IdxT k,
+                        OpT distance_op,
+                        DataT* distances,
+                        IdxT* indices)
+{
+  size_t bytes = sizeof(DataT) * d;
+  if (16 % sizeof(DataT) == 0 && bytes % 16 == 0) {
+    fused_knn_dispatch_capacity<DataT, IdxT, 16 / sizeof(DataT), SelectMin>(
+      handle, x, y, xn, yn, m, n, d, k, distance_op, distances, indices);
+  } else if (8 % sizeof(DataT) == 0 && bytes % 8 == 0) {
+    fused_knn_dispatch_capacity<DataT, IdxT, 8 / sizeof(DataT), SelectMin>(
+      handle, x, y, xn, yn, m, n, d, k, distance_op, distances, indices);
+  } else {
+    fused_knn_dispatch_capacity<DataT, IdxT, 1, SelectMin>(
+      handle, x, y, xn, yn, m, n, d, k, distance_op, distances, indices);
+  }
+}
+
+/**
+ * Compute the k-nearest neighbors by fusing the distance computation with the top-k selection:
+ * in contrast to `tiled_brute_force_knn`, the distance tiles never leave the registers.
+ *
+ * Supports the L2 (expanded or not, with or without sqrt), inner product and cosine metrics for
+ * `k <= kFusedKnnMaxK` (see `is_fused_knn_supported`); the inputs must be row-major.
+ *
+ * @param[in] handle
+ * @param[in] search the queries [m, d]
+ * @param[in] index the database [n, d]
+ * @param m the number of queries
+ * @param n the number of database vectors
+ * @param d the dimensionality of the data
+ * @param k the number of neighbors to select (k <= n)
+ * @param[out] distances [m, k]
+ * @param[out] indices [m, k]
+ * @param metric
+ * @param[in] precomputed_index_norms optional norms of the index rows [n] (squared L2 norms for
+ *   the L2 expanded metrics, L2 norms for cosine)
+ */
+template <typename DataT, typename IdxT>
+void fused_knn(raft::resources const& handle,
+               const DataT* search,
+               const DataT* index,
+               size_t m,
+               size_t n,
+               size_t d,
+               size_t k,
+               DataT* distances,
+               IdxT* indices,
+               raft::distance::DistanceType metric,
+               const DataT* precomputed_index_norms = nullptr)
+{
+  RAFT_EXPECTS(is_fused_knn_supported(metric, k, n),
+               "fused_knn: unsupported metric or k (must be <= min(n, %d))",
+               kFusedKnnMaxK);
+  auto stream = resource::get_cuda_stream(handle);
+  auto mr     = resource::get_workspace_resource(handle);
+
+  rmm::device_uvector<DataT> search_norms(0, stream, mr);
+  rmm::device_uvector<DataT> index_norms(0, stream, mr);
+  if (metric == raft::distance::DistanceType::L2Expanded ||
+      metric == raft::distance::DistanceType::L2SqrtExpanded ||
+      metric == raft::distance::DistanceType::CosineExpanded) {
+    search_norms.resize(m, stream);
+    if (precomputed_index_norms == nullptr) { index_norms.resize(n, stream); }
+    // cosine needs the l2norm, where as l2 distances needs the squared norm
+    if (metric == raft::distance::DistanceType::CosineExpanded) {
+      raft::linalg::rowNorm(search_norms.data(),
+                            search,
+                            d,
+                            m,
+                            raft::linalg::NormType::L2Norm,
+                            true,
+                            stream,
+                            raft::sqrt_op{});
+      if (precomputed_index_norms == nullptr) {
+        raft::linalg::rowNorm(index_norms.data(),
+                              index,
+                              d,
+                              n,
+                              raft::linalg::NormType::L2Norm,
+                              true,
+                              stream,
+                              raft::sqrt_op{});
+      }
+    } else {
+      raft::linalg::rowNorm(
+        search_norms.data(), search, d, m, raft::linalg::NormType::L2Norm, true, stream);
+      if (precomputed_index_norms == nullptr) {
+        raft::linalg::rowNorm(
+          index_norms.data(), index, d, n, raft::linalg::NormType::L2Norm, true, stream);
+      }
+    }
+  }
+  const DataT* index_norms_ptr =
+    precomputed_index_norms == nullptr ? index_norms.data() : precomputed_index_norms;
+
+  switch (metric) {
+    case raft::distance::DistanceType::L2Expanded:
+    case raft::distance::DistanceType::L2SqrtExpanded: {
+      const bool sqrt = metric == raft::distance::DistanceType::L2SqrtExpanded;
+      raft::distance::detail::ops::l2_exp_distance_op<DataT, DataT, IdxT> distance_op{sqrt};
+      fused_knn_dispatch<DataT, IdxT, true>(handle,
+                                            search,
+                                            index,
+                                            search_norms.data(),
+                                            index_norms_ptr,
+                                            IdxT(m),
+                                            IdxT(n),
+                                            IdxT(d),
+                                            IdxT(k),
+                                            distance_op,
+                                            distances,
+                                            indices);
+    } break;
+    case raft::distance::DistanceType::L2Unexpanded:
+    case raft::distance::DistanceType::L2SqrtUnexpanded: {
+      const bool sqrt = metric == raft::distance::DistanceType::L2SqrtUnexpanded;
+      raft::distance::detail::ops::l2_unexp_distance_op<DataT, DataT, IdxT> distance_op{sqrt};
+      fused_knn_dispatch<DataT, IdxT, true>(handle,
+                                            search,
+                                            index,
+                                            nullptr,
+                                            nullptr,
+                                            IdxT(m),
+                                            IdxT(n),
+                                            IdxT(d),
+                                            IdxT(k),
+                                            distance_op,
+                                            distances,
+                                            indices);
+    } break;
+    case raft::distance::DistanceType::CosineExpanded: {
+      raft::distance::detail::ops::cosine_distance_op<DataT, DataT, IdxT> distance_op{};
+      fused_knn_dispatch<DataT, IdxT, true>(handle,
+                                            search,
+                                            index,
+                                            search_norms.data(),
+                                            index_norms_ptr,
+                                            IdxT(m),
+                                            IdxT(n),
+                                            IdxT(d),
+                                            IdxT(k),
+                                            distance_op,
+                                            distances,
+                                            indices);
+    } break;
+    case raft::distance::DistanceType::InnerProduct: {
+      inner_product_op<DataT, DataT, IdxT> distance_op{};
+      fused_knn_dispatch<DataT, IdxT, false>(handle,
+                                             search,
+                                             index,
+                                             nullptr,
+                                             nullptr,
+                                             IdxT(m),
+                                             IdxT(n),
+                                             IdxT(d),
+                                             IdxT(k),
+                                             distance_op,
+                                             distances,
+                                             indices);
+    } break;
+    default: RAFT_FAIL("fused_knn: unsupported metric %d", int(metric));
+  }
+}
+
+}  // namespace raft::neighbors::detail
@@ -0,0 +1,600 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "../nn_descent_types.hpp"
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/error.hpp>
+#include <raft/core/host_device_accessor.hpp>
+#include <raft/core/logger.hpp>
+#include <raft/core/mdspan.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/linalg/map.cuh>
+#include <raft/spatial/knn/detail/ann_utils.cuh>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+#include <raft/util/reduction.cuh>
+#include <raft/util/vectorized.cuh>
+#include <raft/util/warp_primitives.cuh>
+
+#include <rmm/device_scalar.hpp>
+#include <rmm/device_uvector.hpp>
+
+#include <cub/block/block_radix_sort.cuh>
+#include <cub/block/block_scan.cuh>
+
+#include <cuda_fp16.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+namespace raft::neighbors::experimental::nn_descent::detail {
+
+/**
+ * A neighbor in the graph: the bits of the (non-negative) distance in the high half and the id in
+ * the low half. Hence, the keys are ordered by the distance and then by the id, and two equal keys
+ * always mean the same neighbor.
+ */
+using key_t                 = uint64_t;
+constexpr key_t kEmptyKey   = ~key_t{0};
+constexpr uint32_t kEmptyId = ~uint32_t{0};
+
+/** The number of the new (and old) neighbors sampled for the local join of a node. */
+constexpr uint32_t kNumSamples = 32;
+/** The maximum supported degree of the graph refined by nn-descent. */
+constexpr uint32_t kMaxDegree = 128;
+/** One thread per candidate of the local join (the sampled and the reverse, new and old). */
+constexpr int kBlockDim = 4 * kNumSamples;
+/** The local join keeps the candidate vectors in shared memory up to this size. */
+constexpr size_t kMaxJoinSmem = 32 * 1024;
+
+static_assert(kNumSamples == WarpSize, "A segment of the candidates is handled by a warp.");
+static_assert((2 * kMaxDegree) % kBlockDim == 0, "The merge must fit the graph and the proposals.");
+
+/** The flags stored along the neighbors during the merge. */
+constexpr uint8_t kNew       = 1;  // the neighbor has not taken part in a local join yet
+constexpr uint8_t kFromGraph = 2;  // the neighbor is already in the graph
+
+__device__ inline auto pack(float dist, uint32_t id) -> key_t
+{
+  return (key_t(__float_as_uint(dist)) << 32) | key_t(id);
+}
+
+__device__ inline auto splitmix64(uint64_t x) -> uint64_t
+{
+  x += 0x9E3779B97F4A7C15ull;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+  return x ^ (x >> 31);
+}
+
+/**
+ * The squared L2 distance between two fp16 vectors, computed by a warp (valid in all lanes).
+ *
+ * The pointers to the global memory are read through the read-only cache, the non-const ones
+ * (the shared memory) directly.
+ */
+template <int VecLen, typename PtrA, typename PtrB>
+__device__ inline auto warp_l2(PtrA a, PtrB b, uint32_t dim) -> float
+{
+  float acc = 0;
+  for (uint32_t i = laneId() * VecLen; i < dim; i += WarpSize * VecLen) {
+    TxN_t<half, VecLen> x;
+    TxN_t<half, VecLen> y;
+    x.load(a, i);
+    y.load(b, i);
+#pragma unroll
+    for (int j = 0; j < VecLen; j++) {
+      const float d = __half2float(x.val.data[j]) - __half2float(y.val.data[j]);
+      acc += d * d;
+    }
+  }
+  return warpReduce(acc);
+}
+
+/**
+ * Propose `id` as a neighbor of the node `to`.
+ *
+ * The proposals which can't make it into the current neighbor list are dropped right away; the
+ * rest is dropped once the proposal buffer of the node is full.
+ */
+__device__ inline void propose(const key_t* graph,
+                               uint32_t degree,
+                               key_t* proposals,
+                               uint32_t* proposal_counts,
+                               uint32_t to,
+                               uint32_t id,
+                               float dist)
+{
+  const key_t key = pack(dist, id);
+  if (key >= graph[size_t(to) * degree + degree - 1]) { return; }
+  const uint32_t pos = atomicAdd(proposal_counts + to, 1u);
+  if (pos < degree) { proposals[size_t(to) * degree + pos] = key; }
+}
+
+/** Propose `n_init` random neighbors to every node, a warp per proposal. */
+template <int VecLen>
+__global__ void init_random_kernel(const half* data,
+                                   uint32_t n_rows,
+                                   uint32_t dim,
+                                   uint32_t degree,
+                                   uint32_t n_init,
+                                   uint64_t seed,
+                                   key_t* proposals,
+                                   uint32_t* proposal_counts)
+{
+  const uint64_t warp_ix = (uint64_t(blockIdx.x) * blockDim.x + threadIdx.x) / WarpSize;
+  if (warp_ix >= uint64_t(n_rows) * n_init) { return; }
+  const auto row  = uint32_t(warp_ix / n_init);
+  const auto slot = uint32_t(warp_ix % n_init);
+  // any node but the row itself
+  auto id = uint32_t(splitmix64(seed ^ warp_ix) % (n_rows - 1));
+  if (id >= row) { id++; }
+  const float d = warp_l2<VecLen>(data + size_t(row) * dim, data + size_t(id) * dim, dim);
+  if (laneId() == 0) {
+    proposals[size_t(row) * degree + slot] = pack(d, id);
+    if (slot == 0) { proposal_counts[row] = n_init; }
+  }
+}
+
+/**
+ * Sample the candidates for the local joins, a warp per node.
+ *
+ * Up to `kNumSamples` nearest new and old neighbors of every node are taken for the join; the new
+ * ones are marked old. The node is added to the reverse lists of the sampled neighbors (as many
+ * as fit).
+ */
+__global__ void sample_kernel(const key_t* graph,
+                              uint8_t* flags,
+                              uint32_t n_rows,
+                              uint32_t degree,
+                              uint32_t* new_fw,
+                              uint32_t* old_fw,
+                              uint32_t* new_rev,
+                              uint32_t* new_rev_counts,
+                              uint32_t* old_rev,
+                              uint32_t* old_rev_counts)
+{
+  const auto row = uint32_t((uint64_t(blockIdx.x) * blockDim.x + threadIdx.x) / WarpSize);
+  if (row >= n_rows) { return; }
+  const uint32_t lane    = laneId();
+  const uint32_t lt_mask = (1u << lane) - 1u;
+  graph += size_t(row) * degree;
+  flags += size_t(row) * degree;
+  new_fw += size_t(row) * kNumSamples;
+  old_fw += size_t(row) * kNumSamples;
+
+  uint32_t n_new = 0;
+  uint32_t n_old = 0;
+  for (uint32_t j0 = 0; j0 < degree && (n_new < kNumSamples || n_old < kNumSamples);
+       j0 += WarpSize) {
+    const uint32_t j    = j0 + lane;
+    const key_t key     = j < degree ? graph[j] : kEmptyKey;
+    const auto id       = uint32_t(key);
+    const bool is_new   = key != kEmptyKey && flags[j] != 0;
+    const bool is_old   = key != kEmptyKey && flags[j] == 0;
+    const uint32_t mask = ballot(is_new);
+    const uint32_t pos  = n_new + __popc(mask & lt_mask);
+    if (is_new && pos < kNumSamples) {
+      new_fw[pos] = id;
+      flags[j]    = 0;
+      const uint32_t rev_pos = atomicAdd(new_rev_counts + id, 1u);
+      if (rev_pos < kNumSamples) { new_rev[size_t(id) * kNumSamples + rev_pos] = row; }
+    }
+    n_new += __popc(mask);
+    const uint32_t old_mask = ballot(is_old);
+    const uint32_t old_pos  = n_old + __popc(old_mask & lt_mask);
+    if (is_old && old_pos < kNumSamples) {
+      old_fw[old_pos]        = id;
+      const uint32_t rev_pos = atomicAdd(old_rev_counts + id, 1u);
+      if (rev_pos < kNumSamples) { old_rev[size_t(id) * kNumSamples + rev_pos] = row; }
+    }
+    n_old += __popc(old_mask);
+  }
+  for (uint32_t i = min(n_new, kNumSamples) + lane; i < kNumSamples; i += WarpSize) {
+    new_fw[i] = kEmptyId;
+  }
+  for (uint32_t i = min(n_old, kNumSamples) + lane; i < kNumSamples; i += WarpSize) {
+    old_fw[i] = kEmptyId;
+  }
+}
+
+/**
+ * The local join of a node, a thread block per node.
+ *
+ * The candidates are the sampled and the reverse neighbors of the node; every pair of the new
+ * candidates and every pair of a new and an old candidate is compared (a warp per pair) and the
+ * two candidates are proposed to each other as neighbors. With `UseSmem`, the candidate vectors
+ * are first loaded into shared memory.
+ */
+template <int VecLen, bool UseSmem>
+__launch_bounds__(kBlockDim) __global__ void local_join_kernel(const half* data,
+                                                               uint32_t dim,
+                                                               const key_t* graph,
+                                                               uint32_t degree,
+                                                               const uint32_t* new_fw,
+                                                               const uint32_t* old_fw,
+                                                               const uint32_t* new_rev,
+                                                               const uint32_t* new_rev_counts,
+                                                               const uint32_t* old_rev,
+                                                               const uint32_t* old_rev_counts,
+                                                               key_t* proposals,
+                                                               uint32_t* proposal_counts)
+{
+  extern __shared__ __align__(16) half smem_vectors[];
+  __shared__ uint32_t candidates[kBlockDim];
+  __shared__ uint32_t segment_counts[4];
+
+  const size_t row       = blockIdx.x;
+  const uint32_t lane    = laneId();
+  const uint32_t segment = threadIdx.x / WarpSize;
+
+  // Segments: new sampled, new reverse, old sampled, old reverse.
+  uint32_t id = kEmptyId;
+  switch (segment) {
+    case 0: id = new_fw[row * kNumSamples + lane]; break;
+    case 1:
+      if (lane < new_rev_counts[row]) { id = new_rev[row * kNumSamples + lane]; }
+      break;
+    case 2: id = old_fw[row * kNumSamples + lane]; break;
+    default:
+      if (lane < old_rev_counts[row]) { id = old_rev[row * kNumSamples + lane]; }
+      break;
+  }
+  const bool valid    = id != kEmptyId;
+  const uint32_t mask = ballot(valid);
+  if (lane == 0) { segment_counts[segment] = __popc(mask); }
+  __syncthreads();
+  const uint32_t n_new = segment_counts[0] + segment_counts[1];
+  const uint32_t n_old = segment_counts[2] + segment_counts[3];
+  uint32_t offset      = 0;
+  for (uint32_t s = 0; s < segment; s++) {
+    offset += segment_counts[s];
+  }
+  if (valid) { candidates[offset + __popc(mask & ((1u << lane) - 1u))] = id; }
+  __syncthreads();
+  if (n_new == 0) { return; }
+
+  const uint32_t n_candidates = n_new + n_old;
+  if constexpr (UseSmem) {
+    for (uint32_t i = threadIdx.x * VecLen; i < n_candidates * dim; i += kBlockDim * VecLen) {
+      const uint32_t c = i / dim;
+      TxN_t<half, VecLen> v;
+      v.load(data + size_t(candidates[c]) * dim, i - c * dim);
+      v.store(smem_vectors, i);
+    }
+    __syncthreads();
+  }
+  auto vector_of = [&](uint32_t c) {
+    if constexpr (UseSmem) {
+      return smem_vectors + c * dim;
+    } else {
+      return data + size_t(candidates[c]) * dim;
+    }
+  };
+
+  const uint32_t warp_id     = threadIdx.x / WarpSize;
+  const uint32_t n_warps     = kBlockDim / WarpSize;
+  const uint32_t n_pairs_new = n_new * n_new;
+  const uint32_t n_pairs     = n_pairs_new + n_new * n_old;
+  for (uint32_t p = warp_id; p < n_pairs; p += n_warps) {
+    uint32_t i;
+    uint32_t j;
+    if (p < n_pairs_new) {
+      i = p / n_new;
+      j = p % n_new;
+      if (j <= i) { continue; }
+    } else {
+      i = (p - n_pairs_new) / n_old;
+      j = n_new + (p - n_pairs_new) % n_old;
+    }
+    const uint32_t a = candidates[i];
+    const uint32_t b = candidates[j];
+    if (a == b) { continue; }
+    const float d = warp_l2<VecLen>(vector_of(i), vector_of(j), dim);
+    if (lane == 0) { propose(graph, degree, proposals, proposal_counts, a, b, d); }
+    if (lane == 1) { propose(graph, degree, proposals, proposal_counts, b, a, d); }
+  }
+}
+
+/**
+ * Merge the proposals into the neighbor lists, a thread block per node.
+ *
+ * The current neighbors and the proposals are sorted together; the duplicates are dropped and the
+ * `degree` nearest neighbors are kept. The neighbors which were not in the graph before are new
+ * and counted as the updates.
+ */
+__launch_bounds__(kBlockDim) __global__ void merge_kernel(key_t* graph,
+                                                          uint8_t* flags,
+                                                          uint32_t degree,
+                                                          const key_t* proposals,
+                                                          uint32_t* proposal_counts,
+                                                          unsigned long long* n_updates)
+{
+  constexpr int kItems = 2 * kMaxDegree / kBlockDim;
+  constexpr int kSize  = kItems * kBlockDim;
+  using sort_t         = cub::BlockRadixSort<key_t, kBlockDim, kItems, uint8_t>;
+  using scan_t         = cub::BlockScan<uint32_t, kBlockDim>;
+  __shared__ union {
+    typename sort_t::TempStorage sort;
+    typename scan_t::TempStorage scan;
+  } temp_storage;
+  __shared__ key_t sorted_keys[kSize];
+  __shared__ uint8_t sorted_flags[kSize];
+
+  const size_t row = blockIdx.x;
+  graph += row * degree;
+  flags += row * degree;
+  proposals += row * degree;
+  const uint32_t n_proposals = min(proposal_counts[row], degree);
+
+  key_t keys[kItems];
+  uint8_t vals[kItems];
+#pragma unroll
+  for (int j = 0; j < kItems; j++) {
+    const uint32_t i = threadIdx.x * kItems + j;
+    if (i < degree) {
+      keys[j] = graph[i];
+      vals[j] = kFromGraph | flags[i];
+    } else if (i < degree + n_proposals) {
+      keys[j] = proposals[i - degree];
+      vals[j] = kNew;
+    } else {
+      keys[j] = kEmptyKey;
+      vals[j] = 0;
+    }
+  }
+  sort_t(temp_storage.sort).Sort(keys, vals);
+#pragma unroll
+  for (int j = 0; j < kItems; j++) {
+    sorted_keys[threadIdx.x * kItems + j]  = keys[j];
+    sorted_flags[threadIdx.x * kItems + j] = vals[j];
+  }
+  __syncthreads();
+
+  // Keep the first of every run of the equal keys; it's an update unless it was in the graph.
+  bool keep[kItems];
+  uint8_t out_flags[kItems];
+  uint32_t n_keep = 0;
+#pragma unroll
+  for (int j = 0; j < kItems; j++) {
+    const uint32_t i = threadIdx.x * kItems + j;
+    keep[j]          = keys[j] != kEmptyKey && (i == 0 || sorted_keys[i - 1] != keys[j]);
+    out_flags[j]     = kNew;
+    if (keep[j]) {
+      for (uint32_t l = i; l < kSize && sorted_keys[l] == keys[j]; l++) {
+        if (sorted_flags[l] & kFromGraph) { out_flags[j] = sorted_flags[l]; }
+      }
+    }
+    n_keep += keep[j];
+  }
+  uint32_t pos;
+  scan_t(temp_storage.scan).ExclusiveSum(n_keep, pos);
+  bool updated[kItems];
+#pragma unroll
+  for (int j = 0; j < kItems; j++) {
+    updated[j] = false;
+    if (keep[j]) {
+      if (pos < degree) {
+        graph[pos] = keys[j];
+        flags[pos] = out_flags[j] & kNew;
+        updated[j] = (out_flags[j] & kFromGraph) == 0;
+      }
+      pos++;
+    }
+  }
+  // the thread holding the last kept key knows the number of the neighbors
+  if (threadIdx.x == kBlockDim - 1) {
+    for (uint32_t i = pos; i < degree; i++) {
+      graph[i] = kEmptyKey;
+      flags[i] = 0;
+    }
+  }
+  int n_updated = 0;
+#pragma unroll
+  for (int j = 0; j < kItems; j++) {
+    n_updated += __syncthreads_count(updated[j]);
+  }
+  if (threadIdx.x == 0) {
+    proposal_counts[row] = 0;
+    if (n_updated > 0) { atomicAdd(n_updates, static_cast<unsigned long long>(n_updated)); }
+  }
+}
+
+/** Run one merge of the proposals of all nodes and return the number of the updates. */
+inline auto merge(key_t* graph,
+                  uint8_t* flags,
+                  uint32_t n_rows,
+                  uint32_t degree,
+                  const key_t* proposals,
+                  uint32_t* proposal_counts,
+                  rmm::device_scalar<unsigned long long>& n_updates,
+                  rmm::cuda_stream_view stream) -> uint64_t
+{
+  n_updates.set_value_to_zero_async(stream);
+  merge_kernel<<<n_rows, kBlockDim, 0, stream>>>(
+    graph, flags, degree, proposals, proposal_counts, n_updates.data());
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+  return n_updates.value(stream);
+}
+
+template <int VecLen>
+void run_nn_descent(raft::resources const& res,
+                    const half* data,
+                    uint32_t n_rows,
+                    uint32_t dim,
+                    uint32_t degree,
+                    const index_params& params,
+                    key_t* graph)
+{
+  auto stream = resource::get_cuda_stream(res);
+  auto mr     = resource::get_workspace_resource(res);
+
+  rmm::device_uvector<uint8_t> flags(size_t(n_rows) * degree, stream, mr);
+  rmm::device_uvector<key_t> proposals(size_t(n_rows) * degree, stream, mr);
+  rmm::device_uvector<uint32_t> proposal_counts(n_rows, stream, mr);
+  rmm::device_uvector<uint32_t> new_fw(size_t(n_rows) * kNumSamples, stream, mr);
+  rmm::device_uvector<uint32_t> old_fw(size_t(n_rows) * kNumSamples, stream, mr);
+  rmm::device_uvector<uint32_t> new_rev(size_t(n_rows) * kNumSamples, stream, mr);
+  rmm::device_uvector<uint32_t> old_rev(size_t(n_rows) * kNumSamples, stream, mr);
+  rmm::device_uvector<uint32_t> new_rev_counts(n_rows, stream, mr);
+  rmm::device_uvector<uint32_t> old_rev_counts(n_rows, stream, mr);
+  rmm::device_scalar<unsigned long long> n_updates(stream, mr);
+
+  RAFT_CUDA_TRY(cudaMemsetAsync(graph, 0xff, sizeof(key_t) * n_rows * degree, stream));
+  RAFT_CUDA_TRY(cudaMemsetAsync(flags.data(), 0, flags.size(), stream));
+  auto merge_proposals = [&]() {
+    return merge(graph,
+                 flags.data(),
+                 n_rows,
+                 degree,
+                 proposals.data(),
+                 proposal_counts.data(),
+                 n_updates,
+                 stream);
+  };
+
+  // Start from a random graph.
+  {
+    constexpr int kInitBlockDim = 256;
+    const auto n_blocks =
+      raft::ceildiv<uint64_t>(uint64_t(n_rows) * degree * WarpSize, kInitBlockDim);
+    init_random_kernel<VecLen><<<n_blocks, kInitBlockDim, 0, stream>>>(
+      data, n_rows, dim, degree, degree, 0x5EED5EEDull, proposals.data(), proposal_counts.data());
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+    merge_proposals();
+  }
+
+  const size_t join_smem = size_t(kBlockDim) * dim * sizeof(half);
+  const bool use_smem    = join_smem <= kMaxJoinSmem;
+  const auto threshold   = static_cast<uint64_t>(params.termination_threshold * n_rows * degree);
+  for (size_t iter = 0; iter < params.max_iterations; iter++) {
+    RAFT_CUDA_TRY(
+      cudaMemsetAsync(new_rev_counts.data(), 0, sizeof(uint32_t) * new_rev_counts.size(), stream));
+    RAFT_CUDA_TRY(
+      cudaMemsetAsync(old_rev_counts.data(), 0, sizeof(uint32_t) * old_rev_counts.size(), stream));
+    constexpr int kSampleBlockDim = 256;
+    sample_kernel<<<raft::ceildiv<uint64_t>(uint64_t(n_rows) * WarpSize, kSampleBlockDim),
+                    kSampleBlockDim,
+                    0,
+                    stream>>>(graph,
+                              flags.data(),
+                              n_rows,
+                              degree,
+                              new_fw.data(),
+                              old_fw.data(),
+                              new_rev.data(),
+                              new_rev_counts.data(),
+                              old_rev.data(),
+                              old_rev_counts.data());
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+    auto join_kernel =
+      use_smem ? local_join_kernel<VecLen, true> : local_join_kernel<VecLen, false>;
+    join_kernel<<<n_rows, kBlockDim, use_smem ? join_smem : 0, stream>>>(data,
+                                                                         dim,
+                                                                         graph,
+                                                                         degree,
+                                                                         new_fw.data(),
+                                                                         old_fw.data(),
+                                                                         new_rev.data(),
+                                                                         new_rev_counts.data(),
+                                                                         old_rev.data(),
+                                                                         old_rev_counts.data(),
+                                                                         proposals.data(),
+                                                                         proposal_counts.data());
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+    const auto updates = merge_proposals();
+    RAFT_LOG_DEBUG("# nn-descent iteration %zu: %zu updates", iter, size_t(updates));
+    if (updates <= threshold) { break; }
+  }
+}
+
+/**
+ * See raft::neighbors::experimental::nn_descent::build for docs.
+ */
+template <typename T, typename IdxT, typename Accessor>
+void build(raft::resources const& res,
+           const index_params& params,
+           mdspan<const T, matrix_extent<int64_t>, row_major, Accessor> dataset,
+           index<IdxT>& idx)
+{
+  const int64_t n_rows = dataset.extent(0);
+  const int64_t dim    = dataset.extent(1);
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "nn_descent::build(%zu, %zu)", size_t(n_rows), size_t(dim));
+
+  RAFT_EXPECTS(params.metric == raft::distance::DistanceType::L2Expanded ||
+                 params.metric == raft::distance::DistanceType::L2Unexpanded,
+               "nn-descent supports only the L2 distance");
+  RAFT_EXPECTS(n_rows > 1, "The dataset must have at least two rows");
+  RAFT_EXPECTS(n_rows < int64_t(kEmptyId), "The dataset is too large for 32-bit ids");
+  RAFT_EXPECTS(idx.size() == IdxT(n_rows), "The index graph must have a row per dataset row");
+  const size_t graph_degree = idx.graph_degree();
+  RAFT_EXPECTS(graph_degree < size_t(n_rows),
+               "The graph degree must be smaller than the number of rows");
+  RAFT_EXPECTS(graph_degree <= kMaxDegree,
+               "The graph degree must not be larger than %u",
+               kMaxDegree);
+
+  size_t degree = std::max(params.intermediate_graph_degree, graph_degree);
+  if (degree > kMaxDegree) {
+    RAFT_LOG_WARN("Intermediate graph degree cannot be larger than %u, reducing it", kMaxDegree);
+    degree = kMaxDegree;
+  }
+  degree = std::min<size_t>(degree, n_rows - 1);
+
+  auto stream = resource::get_cuda_stream(res);
+  auto mr     = resource::get_workspace_resource(res);
+
+  // The distances are computed on an fp16 copy of the dataset.
+  auto data = raft::make_device_matrix<half, int64_t>(res, n_rows, dim);
+  raft::spatial::knn::detail::utils::batch_load_iterator<T> batches(
+    dataset.data_handle(), n_rows, dim, 65536, stream, mr);
+  for (const auto& batch : batches) {
+    raft::linalg::map(
+      res,
+      make_device_vector_view<half, int64_t>(data.data_handle() + batch.offset() * dim,
+                                             batch.size() * dim),
+      raft::compose_op(raft::cast_op<half>{}, raft::cast_op<float>{}),
+      make_device_vector_view<const T, int64_t>(batch.data(), batch.size() * dim));
+  }
+
+  rmm::device_uvector<key_t> graph(n_rows * degree, stream, mr);
+  auto run = dim % 8 == 0 ? run_nn_descent<8> : run_nn_descent<1>;
+  run(res, data.data_handle(), n_rows, dim, degree, params, graph.data());
+
+  // Output the ids of the `graph_degree` nearest neighbors.
+  auto out = raft::make_device_matrix<IdxT, int64_t>(res, n_rows, graph_degree);
+  raft::linalg::map_offset(
+    res, out.view(), [graph = graph.data(), degree, graph_degree] __device__(int64_t i) {
+      const auto row = i / graph_degree;
+      const auto col = i % graph_degree;
+      return static_cast<IdxT>(static_cast<uint32_t>(graph[row * degree + col]));
+    });
+  raft::copy(idx.graph().data_handle(), out.data_handle(), out.size(), stream);
+  resource::sync_stream(res);
+}
+
+}  // namespace raft::neighbors::experimental::nn_descent::detail
@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/logger.hpp>
+#include <raft/util/cuda_rt_essentials.hpp>
+#include <raft/util/cudart_utils.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+
+/**
+ * A persistent kernel framework for the single-CTA searches.
+ *
+ * For a handful of queries, the kernel launch dominates the latency of a search that does the whole
+ * work of a query in one thread block. A persistent kernel occupies the GPU with resident thread
+ * blocks instead, which serve the queries submitted from the host through a work queue in the
+ * host-mapped memory:
+ *
+ * - every work item (a query) is numbered with a ticket in the order of the submission;
+ * - a job is a batch of the work items submitted at once; its arguments are shared by the items;
+ * - a thread block takes a ticket from a counter in the device memory, waits until the ticket is
+ *   covered by a job (or until the host stops the kernel), copies the job to the shared memory,
+ *   runs the work item, and reports it as completed.
+ *
+ * An algorithm plugs in by defining the job type (trivially copyable) and calling `serve` in its
+ * kernel with a device functor, which does the work of one item by the whole thread block. Every
+ * thread block may have a chunk of the scratch memory in the device memory (see `runner`), which
+ * stays with it for all the items it serves.
+ */
+namespace raft::neighbors::detail::persistent {
+
+/** A job, together with the ticket of its first work item. */
+template <class JobT>
+struct alignas(sizeof(std::uint64_t)) job_slot {
+  JobT job;
+  std::uint64_t begin;
+};
+
+/**
+ * The state shared by the persistent kernel and the host, in host-mapped memory.
+ *
+ * Only one job is in flight at a time: the host writes the job, then moves `job_end`, and waits
+ * until `num_completed` reaches `job_end`.
+ */
+template <class JobT>
+struct work_queue {
+  job_slot<JobT> slot;          // written by the host
+  std::uint64_t job_end;        // written by the host
+  std::uint64_t num_completed;  // written by the device
+  std::uint32_t stop;           // written by the host
+};
+
+/**
+ * The main loop of a persistent kernel: serve the work items until the host stops the kernel.
+ *
+ * Must be called by all threads of the block.
+ *
+ * @param queue the work queue (the device pointer to the host-mapped memory)
+ * @param next_ticket the ticket counter in the device memory, shared by all thread blocks
+ * @param work `work(job, item_id)` does the work item `item_id` of the job; the item number is
+ *   local to the job, i.e. within [0, number of the items of the job).
+ */
+template <class JobT, class WorkT>
+__device__ void serve(work_queue<JobT>* const queue,
+                      std::uint64_t* const next_ticket,
+                      WorkT&& work)
+{
+  using slot_t                       = job_slot<JobT>;
+  constexpr std::uint32_t kSlotWords = sizeof(slot_t) / sizeof(std::uint64_t);
+  // The job may not be default-constructible, hence the raw storage.
+  __shared__ std::uint64_t slot_buf[kSlotWords];
+  __shared__ std::uint32_t item_id;
+  __shared__ std::uint32_t stop;
+  volatile auto* const vqueue = queue;
+  while (true) {
+    if (threadIdx.x == 0) {
+      const std::uint64_t ticket =
+        atomicAdd(reinterpret_cast<unsigned long long*>(next_ticket), 1ull);
+      while (ticket >= vqueue->job_end && !vqueue->stop) {}
+      stop = ticket >= vqueue->job_end;
+      if (!stop) {
+        // The job cannot change until this ticket is completed.
+        __threadfence_system();
+        auto* const src = reinterpret_cast<const volatile std::uint64_t*>(&vqueue->slot);
+        for (std::uint32_t i = 0; i < kSlotWords; i++) {
+          slot_buf[i] = src[i];
+        }
+        item_id = ticket - reinterpret_cast<const slot_t*>(slot_buf)->begin;
+      }
+    }
+    __syncthreads();
+    if (stop) { return; }
+    work(reinterpret_cast<const slot_t*>(slot_buf)->job, item_id);
+    // Make the results visible to the host before reporting the item as completed.
+    __threadfence_system();
+    __syncthreads();
+    if (threadIdx.x == 0) {
+      atomicAdd(reinterpret_cast<unsigned long long*>(&queue->num_completed), 1ull);
+    }
+  }
+}
+
+/**
+ * The host side of a persistent kernel: owns the kernel stream, the work queue and the scratch
+ * memory of the thread blocks, and submits the jobs.
+ *
+ * The kernel is launched in the constructor and stopped in the destructor. The arguments of the
+ * kernel, except for those in the job, are fixed at the launch; `key` identifies them.
+ *
+ * @tparam JobT the job type; trivially copyable
+ * @tparam KeyT the launch parameters; equality comparable
+ */
+template <class JobT, class KeyT>
+class runner {
+ public:
+  using queue_type = work_queue<JobT>;
+
+  /**
+   * @param key the parameters of the launch
+   * @param kernel the persistent kernel, used to find the number of resident thread blocks
+   * @param block_size
+   * @param smem_size
+   * @param device_usage fraction of the resident thread blocks to launch
+   * @param scratch_bytes_per_block the size of the scratch memory of a thread block (may be 0)
+   * @param launch `launch(queue, next_ticket, scratch, num_blocks, stream)` launches the kernel;
+   *   the thread block `i` owns the bytes [i * scratch_bytes_per_block, (i + 1) *
+   *   scratch_bytes_per_block) of `scratch`
+   */
+  template <class LaunchT>
+  runner(KeyT key,
+         const void* kernel,
+         uint32_t block_size,
+         uint32_t smem_size,
+         float device_usage,
+         size_t scratch_bytes_per_block,
+         LaunchT launch)
+    : key_(key)
+  {
+    RAFT_CUDA_TRY(cudaStreamCreateWithFlags(&stream_, cudaStreamNonBlocking));
+    int dev_id, num_sms, blocks_per_sm;
+    RAFT_CUDA_TRY(cudaGetDevice(&dev_id));
+    RAFT_CUDA_TRY(cudaDeviceGetAttribute(&num_sms, cudaDevAttrMultiProcessorCount, dev_id));
+    RAFT_CUDA_TRY(
+      cudaOccupancyMaxActiveBlocksPerMultiprocessor(&blocks_per_sm, kernel, block_size, smem_size));
+    // All the thread blocks must be resident, otherwise the waiting ones could block the others.
+    num_blocks_ = std::max<uint32_t>(1, blocks_per_sm * num_sms * device_usage);
+    RAFT_LOG_DEBUG("# persistent kernel: %u thread blocks", num_blocks_);
+
+    RAFT_CUDA_TRY(cudaHostAlloc(&queue_, sizeof(queue_type), cudaHostAllocMapped));
+    std::memset(static_cast<void*>(queue_), 0, sizeof(queue_type));
+    RAFT_CUDA_TRY(cudaHostGetDevicePointer(reinterpret_cast<void**>(&queue_dev_), queue_, 0));
+    RAFT_CUDA_TRY(cudaMalloc(&next_ticket_, sizeof(std::uint64_t)));
+    RAFT_CUDA_TRY(cudaMemsetAsync(next_ticket_, 0, sizeof(std::uint64_t), stream_));
+    if (scratch_bytes_per_block > 0) {
+      RAFT_CUDA_TRY(cudaMalloc(&scratch_, scratch_bytes_per_block * num_blocks_));
+    }
+    launch(queue_dev_, next_ticket_, scratch_, num_blocks_, stream_);
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+  }
+
+  ~runner() noexcept
+  {
+    reinterpret_cast<volatile queue_type*>(queue_)->stop = 1;
+    RAFT_CUDA_TRY_NO_THROW(cudaStreamSynchronize(stream_));
+    RAFT_CUDA_TRY_NO_THROW(cudaStreamDestroy(stream_));
+    if (scratch_ != nullptr) { RAFT_CUDA_TRY_NO_THROW(cudaFree(scratch_)); }
+    RAFT_CUDA_TRY_NO_THROW(cudaFree(next_ticket_));
+    RAFT_CUDA_TRY_NO_THROW(cudaFreeHost(queue_));
+  }
+
+  runner(const runner&)                    = delete;
+  auto operator=(const runner&) -> runner& = delete;
+
+  [[nodiscard]] auto key() const -> const KeyT& { return key_; }
+  [[nodiscard]] auto num_blocks() const -> uint32_t { return num_blocks_; }
+
+  /**
+   * Run the `num_items` work items of the job and wait for their completion.
+   *
+   * The inputs of the job must be ready, i.e. the streams producing them must be synchronized.
+   */
+  void submit(const JobT& job, std::uint32_t num_items)
+  {
+    if (num_items == 0) { return; }
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto* const vqueue          = reinterpret_cast<volatile queue_type*>(queue_);
+    const std::uint64_t job_end = num_submitted_ + num_items;
+    // No thread block reads the job until `job_end` is moved.
+    new (&queue_->slot) job_slot<JobT>{job, num_submitted_};
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    vqueue->job_end = job_end;
+    num_submitted_  = job_end;
+    while (vqueue->num_completed < job_end) {}
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+  }
+
+ private:
+  KeyT key_;
+  cudaStream_t stream_;
+  uint32_t num_blocks_;
+  queue_type* queue_;
+  queue_type* queue_dev_;
+  std::uint64_t* next_ticket_  = nullptr;
+  void* scratch_               = nullptr;
+  std::uint64_t num_submitted_ = 0;
+  std::mutex mutex_;
+};
+
+/**
+ * Get the persistent runner for the given launch parameters.
+ *
+ * One runner per type is kept alive between the calls; it is replaced when the parameters change.
+ */
+template <class RunnerT, class KeyT, class... Args>
+auto get_runner(const KeyT& key, Args&&... args) -> std::shared_ptr<RunnerT>
+{
+  static std::mutex mutex;
+  static std::shared_ptr<RunnerT> instance;
+  std::lock_guard<std::mutex> guard(mutex);
+  if (instance == nullptr || instance->key() != key) {
+    // Stop the running kernel first to free its thread blocks.
+    instance.reset();
+    instance = std::make_shared<RunnerT>(key, std::forward<Args>(args)...);
+  }
+  return instance;
+}
+
+}  // namespace raft::neighbors::detail::persistent
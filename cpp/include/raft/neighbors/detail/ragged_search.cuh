@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/host_mdarray.hpp>
+#include <raft/core/host_mdspan.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/linalg/map.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <thrust/for_each.h>
+#include <thrust/iterator/counting_iterator.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace raft::neighbors::detail {
+
+/** The number of the buckets of the queries; the bucket `b` holds the k in (2^(b-1), 2^b]. */
+constexpr static inline uint32_t kRaggedSearchBuckets = 33;
+
+/**
+ * Search a batch of queries with a different number of neighbors per query.
+ *
+ * The queries are grouped by k into the power-of-two buckets, and every bucket is searched as one
+ * batch with the largest k of the bucket: the top-k queues and the selection are sized for at most
+ * twice the k of any query in the bucket rather than for the largest k of the whole batch. The
+ * results are written to a CSR matrix with a row per query, the first `ks[i]` neighbors of the
+ * bucket search of the query `i` (sorted as by the underlying search).
+ *
+ * @param[in] res
+ * @param[in] queries [n_queries, dim]
+ * @param[in] ks the number of neighbors of every query, at most the columns of `out` [n_queries]
+ * @param[out] out a CSR matrix [n_queries, n_cols]; its sparsity is initialized with `sum(ks)`
+ * @param[in] search_fn `search_fn(queries, neighbors, distances)`: the underlying search of the
+ *   device matrix views [n, dim], [n, k], [n, k], where `k` is the number of columns of the outputs
+ */
+template <typename T, typename IdxT, typename OutIdxT, typename SearchFn>
+void search_ragged(raft::resources const& res,
+                   raft::device_matrix_view<const T, IdxT, row_major> queries,
+                   raft::host_vector_view<const uint32_t, IdxT> ks,
+                   raft::device_csr_matrix<float, int64_t, OutIdxT, int64_t>& out,
+                   SearchFn&& search_fn)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "neighbors::search_ragged(n_queries = %zu)", size_t(queries.extent(0)));
+  auto stream          = resource::get_cuda_stream(res);
+  const IdxT n_queries = queries.extent(0);
+  const IdxT dim       = queries.extent(1);
+  RAFT_EXPECTS(ks.extent(0) == n_queries, "There must be one k per query");
+
+  auto indptr_h = raft::make_host_vector<int64_t, IdxT>(n_queries + 1);
+  std::vector<std::vector<IdxT>> buckets(kRaggedSearchBuckets);
+  std::vector<uint32_t> bucket_k(kRaggedSearchBuckets, 0);
+  indptr_h(0)         = 0;
+  const size_t n_cols = out.structure_view().get_n_cols();
+  for (IdxT i = 0; i < n_queries; i++) {
+    const uint32_t k = ks(i);
+    RAFT_EXPECTS(k <= n_cols,
+                 "The k of the query %zu (%u) exceeds the number of columns of the output (%zu)",
+                 size_t(i),
+                 k,
+                 n_cols);
+    indptr_h(i + 1) = indptr_h(i) + k;
+    if (k == 0) { continue; }
+    uint32_t b = 0;
+    while ((uint64_t{1} << b) < k) {
+      b++;
+    }
+    buckets[b].push_back(i);
+    bucket_k[b] = std::max(bucket_k[b], k);
+  }
+
+  out.initialize_sparsity(indptr_h(n_queries));
+  auto structure = out.structure_view();
+  RAFT_EXPECTS(structure.get_n_rows() == int64_t(n_queries),
+               "The output must be a CSR matrix with a row per query");
+  raft::copy(structure.get_indptr().data(), indptr_h.data_handle(), n_queries + 1, stream);
+
+  const int64_t* indptr = structure.get_indptr().data();
+  OutIdxT* out_indices  = structure.get_indices().data();
+  float* out_distances  = out.get_elements().data();
+
+  for (uint32_t b = 0; b < kRaggedSearchBuckets; b++) {
+    const auto& bucket = buckets[b];
+    if (bucket.empty()) { continue; }
+    const IdxT n_bucket = bucket.size();
+    const uint32_t k    = bucket_k[b];
+
+    auto query_ids = raft::make_device_vector<IdxT, IdxT>(res, n_bucket);
+    raft::copy(query_ids.data_handle(), bucket.data(), n_bucket, stream);
+    const IdxT* query_ids_ptr = query_ids.data_handle();
+
+    // If all the queries are in the bucket, they are in their order: no need to gather them.
+    const bool gather        = n_bucket < n_queries;
+    auto bucket_queries      = raft::make_device_matrix<T, IdxT>(res, gather ? n_bucket : 0, dim);
+    auto bucket_queries_view = queries;
+    if (gather) {
+      const T* queries_ptr = queries.data_handle();
+      raft::linalg::map_offset(res, bucket_queries.view(), [=] __device__(IdxT e) {
+        return queries_ptr[static_cast<size_t>(query_ids_ptr[e / dim]) * dim + e % dim];
+      });
+      bucket_queries_view = raft::make_const_mdspan(bucket_queries.view());
+    }
+
+    auto neighbors = raft::make_device_matrix<OutIdxT, IdxT>(res, n_bucket, k);
+    auto distances = raft::make_device_matrix<float, IdxT>(res, n_bucket, k);
+    search_fn(bucket_queries_view, neighbors.view(), distances.view());
+
+    const OutIdxT* neighbors_ptr = neighbors.data_handle();
+    const float* distances_ptr   = distances.data_handle();
+    auto entries                 = thrust::make_counting_iterator<int64_t>(0);
+    thrust::for_each(resource::get_thrust_policy(res),
+                     entries,
+                     entries + int64_t(n_bucket) * k,
+                     [=] __device__(int64_t e) {
+                       const IdxT q        = query_ids_ptr[e / k];
+                       const int64_t j     = e % k;
+                       const int64_t begin = indptr[q];
+                       if (j < indptr[q + 1] - begin) {
+                         out_indices[begin + j]   = neighbors_ptr[e];
+                         out_distances[begin + j] = distances_ptr[e];
+                       }
+                     });
+  }
+  // the host buckets and offsets go out of scope
+  resource::sync_stream(res, stream);
+}
+
+}  // namespace raft::neighbors::detail
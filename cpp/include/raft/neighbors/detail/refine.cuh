@@ -17,22 +17,36 @@
 #pragma once
 
 #include <raft/core/device_mdarray.hpp>
+#include <raft/core/error.hpp>
 #include <raft/core/host_mdspan.hpp>
+#include <raft/core/math.hpp>
 #include <raft/core/nvtx.hpp>
+#include <raft/core/pinned_container_policy.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
-#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
 #include <raft/core/resources.hpp>
+#include <raft/distance/distance_types.hpp>
 #include <raft/matrix/detail/select_warpsort.cuh>
-#include <raft/neighbors/detail/ivf_flat_build.cuh>
-#include <raft/neighbors/detail/ivf_flat_interleaved_scan.cuh>
-#include <raft/neighbors/detail/ivf_flat_search.cuh>
-#include <raft/neighbors/sample_filter_types.hpp>
-#include <raft/spatial/knn/detail/ann_utils.cuh>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+#include <raft/util/integer_utils.hpp>
+#include <raft/util/reduction.cuh>
+#include <raft/util/vectorized.cuh>
 
-#include <cstdlib>
-#include <omp.h>
+#include <rmm/cuda_stream_view.hpp>
+#include <rmm/device_uvector.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+#include <vector>
 
-#include <thrust/sequence.h>
+#include <omp.h>
 
 namespace raft::neighbors::detail {
 
@@ -73,6 +87,239 @@ void check_input(extents_t dataset,
                static_cast<int>(k));
 }
 
+/**
+ * The distance between the query and a dataset row, computed cooperatively by a warp.
+ *
+ * The lanes read the rows in consecutive `VecLen`-element vectors, so that a warp gathers up to
+ * 512 contiguous bytes of the (randomly accessed) candidate row per load instruction.
+ * The result is valid in all lanes.
+ */
+template <int VecLen, bool InnerProduct, typename distance_t, typename data_t>
+__device__ inline auto refine_warp_distance(const data_t* query, const data_t* row, uint32_t dim)
+  -> distance_t
+{
+  distance_t acc = 0;
+  for (uint32_t i = laneId() * VecLen; i < dim; i += WarpSize * VecLen) {
+    TxN_t<data_t, VecLen> q;
+    TxN_t<data_t, VecLen> x;
+    q.load(query, i);
+    x.load(row, i);
+#pragma unroll
+    for (int j = 0; j < VecLen; j++) {
+      const auto a = static_cast<distance_t>(q.val.data[j]);
+      const auto b = static_cast<distance_t>(x.val.data[j]);
+      if constexpr (InnerProduct) {
+        acc += a * b;
+      } else {
+        const auto d = a - b;
+        acc += d * d;
+      }
+    }
+  }
+  return warpReduce(acc);
+}
+
+/**
+ * Re-rank the candidates of one query per thread block.
+ *
+ * Every warp takes `WarpSize` candidates at a time and computes their distances one after another
+ * (see `refine_warp_distance`), so that the lane `j` ends up holding the distance to the candidate
+ * `j`. Then the whole warp feeds the distances into the block-wide warp-sort queue, fusing the
+ * selection with the distance computation.
+ *
+ * The candidates outside of the dataset range (e.g. the padding of an incomplete search result)
+ * are kept with the dummy distance of the queue.
+ *
+ * When `candidate_rows != nullptr`, the dataset contains only the gathered candidate rows and
+ * `candidate_rows` gives the row of every candidate, while `neighbor_candidates` is the payload.
+ */
+template <int Capacity,
+          int VecLen,
+          bool InnerProduct,
+          typename idx_t,
+          typename data_t,
+          typename distance_t>
+__launch_bounds__(256) __global__ void refine_kernel(const data_t* dataset,
+                                                     idx_t n_rows,
+                                                     uint32_t dim,
+                                                     const data_t* queries,
+                                                     const idx_t* neighbor_candidates,
+                                                     const uint32_t* candidate_rows,
+                                                     uint32_t n_candidates,
+                                                     uint32_t k,
+                                                     bool take_sqrt,
+                                                     idx_t* indices,
+                                                     distance_t* distances)
+{
+  using namespace raft::matrix::detail::select::warpsort;  // NOLINT
+  using uidx_t = std::make_unsigned_t<idx_t>;
+  extern __shared__ __align__(256) uint8_t smem_buf_bytes[];
+  using bq_t = block_sort<warp_sort_filtered, Capacity, !InnerProduct, distance_t, idx_t>;
+  bq_t queue(k);
+
+  const size_t query_ix = blockIdx.x;
+  queries += query_ix * dim;
+  neighbor_candidates += query_ix * n_candidates;
+  if (candidate_rows != nullptr) { candidate_rows += query_ix * n_candidates; }
+
+  const uint32_t lane    = laneId();
+  const uint32_t warp_id = threadIdx.x / WarpSize;
+  const uint32_t n_warps = blockDim.x / WarpSize;
+  for (uint32_t base = warp_id * WarpSize; base < n_candidates; base += n_warps * WarpSize) {
+    const uint32_t n = min(uint32_t(WarpSize), n_candidates - base);
+    idx_t id         = lane < n ? neighbor_candidates[base + lane] : idx_t(-1);
+    idx_t row        = id;
+    if (candidate_rows != nullptr && lane < n) {
+      row = static_cast<idx_t>(candidate_rows[base + lane]);
+    }
+    distance_t dist = bq_t::queue_t::kDummy;
+    for (uint32_t j = 0; j < n; j++) {
+      const idx_t row_id = shfl(row, j);
+      if (static_cast<uidx_t>(row_id) >= static_cast<uidx_t>(n_rows)) { continue; }
+      const auto d = refine_warp_distance<VecLen, InnerProduct, distance_t>(
+        queries, dataset + static_cast<size_t>(row_id) * dim, dim);
+      if (lane == j) { dist = take_sqrt ? raft::sqrt(d) : d; }
+    }
+    queue.add(dist, id);
+  }
+
+  queue.done(smem_buf_bytes);
+  queue.store(distances + query_ix * k, indices + query_ix * k);
+}
+
+template <int VecLen,
+          bool InnerProduct,
+          typename idx_t,
+          typename data_t,
+          typename distance_t,
+          int Capacity = raft::matrix::detail::select::warpsort::kMaxCapacity>
+void launch_refine_kernel(const data_t* dataset,
+                          idx_t n_rows,
+                          uint32_t dim,
+                          const data_t* queries,
+                          uint32_t n_queries,
+                          const idx_t* neighbor_candidates,
+                          const uint32_t* candidate_rows,
+                          uint32_t n_candidates,
+                          uint32_t k,
+                          bool take_sqrt,
+                          idx_t* indices,
+                          distance_t* distances,
+                          rmm::cuda_stream_view stream)
+{
+  const int capacity = bound_by_power_of_two(k);
+  if constexpr (Capacity > 1) {
+    if (capacity < Capacity) {
+      return launch_refine_kernel<VecLen, InnerProduct, idx_t, data_t, distance_t, Capacity / 2>(
+        dataset,
+        n_rows,
+        dim,
+        queries,
+        n_queries,
+        neighbor_candidates,
+        candidate_rows,
+        n_candidates,
+        k,
+        take_sqrt,
+        indices,
+        distances,
+        stream);
+    }
+  }
+  ASSERT(capacity <= Capacity, "Requested k is too big (%d)", k);
+
+  // One warp per `WarpSize` candidates, but no more than 256 threads per query.
+  constexpr uint32_t kMaxWarps = 256 / WarpSize;
+
+  const uint32_t n_warps   = std::min(kMaxWarps, raft::ceildiv<uint32_t>(n_candidates, WarpSize));
+  const uint32_t block_dim = n_warps * WarpSize;
+  // The queue is arranged in sub-warps of the capacity width when `Capacity < WarpSize`.
+  const int n_queues  = block_dim / std::min<int>(Capacity, WarpSize);
+  const int smem_size = raft::matrix::detail::select::warpsort::
+    calc_smem_size_for_block_wide<distance_t, idx_t>(n_queues, k);
+  refine_kernel<Capacity, VecLen, InnerProduct>
+    <<<n_queries, block_dim, smem_size, stream>>>(dataset,
+                                                  n_rows,
+                                                  dim,
+                                                  queries,
+                                                  neighbor_candidates,
+                                                  candidate_rows,
+                                                  n_candidates,
+                                                  k,
+                                                  take_sqrt,
+                                                  indices,
+                                                  distances);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+/**
+ * Select the kernel instance by the metric and the alignment of the rows, and run it.
+ *
+ * See `refine_kernel` for the meaning of the arguments.
+ */
+template <typename idx_t, typename data_t, typename distance_t>
+void run_refine_kernel(const data_t* dataset,
+                       idx_t n_rows,
+                       uint32_t dim,
+                       const data_t* queries,
+                       uint32_t n_queries,
+                       const idx_t* neighbor_candidates,
+                       const uint32_t* candidate_rows,
+                       uint32_t n_candidates,
+                       uint32_t k,
+                       distance::DistanceType metric,
+                       idx_t* indices,
+                       distance_t* distances,
+                       rmm::cuda_stream_view stream)
+{
+  bool inner_product = false;
+  bool take_sqrt     = false;
+  switch (metric) {
+    case raft::distance::DistanceType::L2Expanded:
+    case raft::distance::DistanceType::L2Unexpanded: break;
+    case raft::distance::DistanceType::L2SqrtExpanded:
+    case raft::distance::DistanceType::L2SqrtUnexpanded: take_sqrt = true; break;
+    case raft::distance::DistanceType::InnerProduct: inner_product = true; break;
+    default: RAFT_FAIL("Unsupported metric in refine: %d", static_cast<int>(metric));
+  }
+
+  // Use the 16-byte loads whenever all rows are aligned to them.
+  constexpr int kVecLen = std::max<int>(1, 16 / sizeof(data_t));
+  const bool vectorized = dim % kVecLen == 0 && reinterpret_cast<uintptr_t>(dataset) % 16 == 0 &&
+                          reinterpret_cast<uintptr_t>(queries) % 16 == 0;
+
+  auto launch = [&](auto vec_len, auto ip) {
+    launch_refine_kernel<decltype(vec_len)::value, decltype(ip)::value>(dataset,
+                                                                        n_rows,
+                                                                        dim,
+                                                                        queries,
+                                                                        n_queries,
+                                                                        neighbor_candidates,
+                                                                        candidate_rows,
+                                                                        n_candidates,
+                                                                        k,
+                                                                        take_sqrt,
+                                                                        indices,
+                                                                        distances,
+                                                                        stream);
+  };
+  using vec_t    = std::integral_constant<int, kVecLen>;
+  using scalar_t = std::integral_constant<int, 1>;
+  if (vectorized) {
+    if (inner_product) {
+      launch(vec_t{}, std::true_type{});
+    } else {
+      launch(vec_t{}, std::false_type{});
+    }
+  } else {
+    if (inner_product) {
+      launch(scalar_t{}, std::true_type{});
+    } else {
+      launch(scalar_t{}, std::false_type{});
+    }
+  }
+}
+
 /**
  * See raft::neighbors::refine for docs.
  */
@@ -99,71 +346,195 @@ void refine_device(raft::resources const& handle,
               indices.extents(),
               distances.extents(),
               metric);
+  if (n_queries == 0) { return; }
 
-  // The refinement search can be mapped to an IVF flat search:
-  // - We consider that the candidate vectors form a cluster, separately for each query.
-  // - In other words, the n_queries * n_candidates vectors form n_queries clusters, each with
-  //   n_candidates elements.
-  // - We consider that the coarse level search is already performed and assigned a single cluster
-  //   to search for each query (the cluster formed from the corresponding candidates).
-  // - We run IVF flat search with n_probes=1 to select the best k elements of the candidates.
-  rmm::device_uvector<uint32_t> fake_coarse_idx(n_queries, resource::get_cuda_stream(handle));
-
-  thrust::sequence(resource::get_thrust_policy(handle),
-                   fake_coarse_idx.data(),
-                   fake_coarse_idx.data() + n_queries);
-
-  raft::neighbors::ivf_flat::index<data_t, idx_t> refinement_index(
-    handle, metric, n_queries, false, true, dim);
-
-  raft::neighbors::ivf_flat::detail::fill_refinement_index(handle,
-                                                           &refinement_index,
-                                                           dataset.data_handle(),
-                                                           neighbor_candidates.data_handle(),
-                                                           n_queries,
-                                                           n_candidates);
-  uint32_t grid_dim_x = 1;
-  raft::neighbors::ivf_flat::detail::ivfflat_interleaved_scan<
-    data_t,
-    typename raft::spatial::knn::detail::utils::config<data_t>::value_t,
-    idx_t>(refinement_index,
-           queries.data_handle(),
-           fake_coarse_idx.data(),
-           static_cast<uint32_t>(n_queries),
-           0,
-           refinement_index.metric(),
-           1,
-           k,
-           raft::distance::is_min_close(metric),
-           raft::neighbors::filtering::none_ivf_sample_filter(),
-           indices.data_handle(),
-           distances.data_handle(),
-           grid_dim_x,
-           resource::get_cuda_stream(handle));
+  run_refine_kernel(dataset.data_handle(),
+                    static_cast<idx_t>(dataset.extent(0)),
+                    static_cast<uint32_t>(dim),
+                    queries.data_handle(),
+                    static_cast<uint32_t>(n_queries),
+                    neighbor_candidates.data_handle(),
+                    nullptr,
+                    static_cast<uint32_t>(n_candidates),
+                    k,
+                    metric,
+                    indices.data_handle(),
+                    distances.data_handle(),
+                    resource::get_cuda_stream(handle));
 }
 
-/** Helper structure for naive CPU implementation of refine. */
-typedef struct {
-  uint64_t id;
-  float distance;
-} struct_for_refinement;
+/** Size of each of the pinned host buffers the candidate rows are gathered into. */
+constexpr size_t kRefineStagingBufferSize = size_t{64} << 20;
+
+/**
+ * A pair of pinned host buffers to stage the gathered candidate rows and their positions.
+ *
+ * While the host gathers the rows of one batch into one buffer, the copy of the other one proceeds
+ * in the stream; an event for every buffer tells when the copy is done.
+ */
+class refine_staging_buffers {
+ public:
+  explicit refine_staging_buffers(size_t rows_bytes, size_t positions_count)
+    : rows_{pinned_container<char>(rows_bytes), pinned_container<char>(rows_bytes)},
+      positions_{pinned_container<uint32_t>(positions_count),
+                 pinned_container<uint32_t>(positions_count)}
+  {
+    for (int i = 0; i < 2; i++) {
+      RAFT_CUDA_TRY(cudaEventCreateWithFlags(&events_[i], cudaEventDisableTiming));
+    }
+  }
+  ~refine_staging_buffers() noexcept
+  {
+    for (int i = 0; i < 2; i++) {
+      // the pending copies must not read the memory after it is freed
+      RAFT_CUDA_TRY_NO_THROW(cudaEventSynchronize(events_[i]));
+      RAFT_CUDA_TRY_NO_THROW(cudaEventDestroy(events_[i]));
+    }
+  }
+  refine_staging_buffers(const refine_staging_buffers&)                    = delete;
+  refine_staging_buffers(refine_staging_buffers&&)                         = delete;
+  auto operator=(const refine_staging_buffers&) -> refine_staging_buffers& = delete;
+  auto operator=(refine_staging_buffers&&) -> refine_staging_buffers&      = delete;
+
+  [[nodiscard]] auto rows(int i) -> char* { return rows_[i].data(); }
+  [[nodiscard]] auto positions(int i) -> uint32_t* { return positions_[i].data(); }
+  /** Mark the end of the device copies of the buffer `i` issued so far. */
+  void record(int i, rmm::cuda_stream_view stream)
+  {
+    RAFT_CUDA_TRY(cudaEventRecord(events_[i], stream));
+  }
+  /** Wait until the buffer `i` can be used by the host. */
+  void wait(int i) { RAFT_CUDA_TRY(cudaEventSynchronize(events_[i])); }
 
-inline int _postprocessing_qsort_compare(const void* v1, const void* v2)
+ private:
+  pinned_container<char> rows_[2];
+  pinned_container<uint32_t> positions_[2];
+  cudaEvent_t events_[2];
+};
+  uint32_t* positions_[2] = {nullptr, nullptr};
+  cudaEvent_t events_[2];
+};
+
+/**
+ * Refine with the dataset in host memory (pageable, pinned or memory-mapped) and everything else
+ * on the device.
+ *
+ * The queries are processed in batches. For every batch, the host collects the unique valid
+ * candidate ids and gathers only those rows into a pinned staging buffer. The rows are copied to
+ * the device asynchronously and scored there by the refine kernel, while the host gathers the rows
+ * of the next batch. Hence, only the pages of the dataset holding the candidates are ever touched.
+ */
+template <typename idx_t, typename data_t, typename distance_t, typename matrix_idx>
+void refine_hybrid(raft::resources const& handle,
+                   raft::host_matrix_view<const data_t, matrix_idx, row_major> dataset,
+                   raft::device_matrix_view<const data_t, matrix_idx, row_major> queries,
+                   raft::device_matrix_view<const idx_t, matrix_idx, row_major> neighbor_candidates,
+                   raft::device_matrix_view<idx_t, matrix_idx, row_major> indices,
+                   raft::device_matrix_view<distance_t, matrix_idx, row_major> distances,
+                   distance::DistanceType metric = distance::DistanceType::L2Unexpanded)
 {
-  // sort in ascending order
-  if (((struct_for_refinement*)v1)->distance > ((struct_for_refinement*)v2)->distance) {
-    return 1;
-  } else if (((struct_for_refinement*)v1)->distance < ((struct_for_refinement*)v2)->distance) {
-    return -1;
-  } else {
-    return 0;
+  const size_t n_candidates = neighbor_candidates.extent(1);
+  const size_t n_queries    = queries.extent(0);
+  const size_t dim          = dataset.extent(1);
+  const int64_t n_rows      = dataset.extent(0);
+  const uint32_t k          = static_cast<uint32_t>(indices.extent(1));
+
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "neighbors::refine_hybrid(%zu, %zu)", n_queries, n_candidates);
+
+  check_input(dataset.extents(),
+              queries.extents(),
+              neighbor_candidates.extents(),
+              indices.extents(),
+              distances.extents(),
+              metric);
+  if (n_queries == 0) { return; }
+
+  auto stream = resource::get_cuda_stream(handle);
+  auto mr     = resource::get_workspace_resource(handle);
+
+  // The candidate ids drive the gathering on the host.
+  std::vector<idx_t> candidates_host(n_queries * n_candidates);
+  raft::copy(
+    candidates_host.data(), neighbor_candidates.data_handle(), candidates_host.size(), stream);
+  resource::sync_stream(handle);
+
+  const size_t row_bytes      = sizeof(data_t) * dim;
+  const size_t query_bytes    = std::max<size_t>(1, n_candidates * row_bytes);
+  const size_t max_batch_size =
+    std::min(n_queries, std::max<size_t>(1, kRefineStagingBufferSize / query_bytes));
+  const size_t max_batch_rows = max_batch_size * n_candidates;
+
+  refine_staging_buffers staging(max_batch_rows * row_bytes, max_batch_rows);
+  rmm::device_uvector<data_t> rows_dev(max_batch_rows * dim, stream, mr);
+  rmm::device_uvector<uint32_t> positions_dev(max_batch_rows, stream, mr);
+  std::vector<idx_t> unique_ids;
+  unique_ids.reserve(max_batch_rows);
+  auto is_valid = [n_rows](idx_t id) { return int64_t(id) >= 0 && int64_t(id) < n_rows; };
+
+  for (size_t offset = 0, batch_ix = 0; offset < n_queries; offset += max_batch_size, batch_ix++) {
+    const int slot          = batch_ix % 2;
+    const size_t batch_size = std::min(max_batch_size, n_queries - offset);
+    const size_t batch_rows = batch_size * n_candidates;
+    const idx_t* batch_ids  = candidates_host.data() + offset * n_candidates;
+
+    // Deduplicate the candidates of the batch.
+    unique_ids.clear();
+    std::copy_if(batch_ids, batch_ids + batch_rows, std::back_inserter(unique_ids), is_valid);
+    std::sort(unique_ids.begin(), unique_ids.end());
+    unique_ids.erase(std::unique(unique_ids.begin(), unique_ids.end()), unique_ids.end());
+    const size_t n_unique = unique_ids.size();
+
+    // Gather the rows and the positions of the candidates among them into the free buffer.
+    staging.wait(slot);
+    auto* staged_rows      = staging.rows(slot);
+    auto* staged_positions = staging.positions(slot);
+#pragma omp parallel
+    {
+#pragma omp for nowait
+      for (int64_t i = 0; i < int64_t(n_unique); i++) {
+        std::memcpy(staged_rows + i * row_bytes,
+                    dataset.data_handle() + static_cast<size_t>(unique_ids[i]) * dim,
+                    row_bytes);
+      }
+#pragma omp for
+      for (int64_t i = 0; i < int64_t(batch_rows); i++) {
+        const idx_t id = batch_ids[i];
+        // the invalid candidates are mapped outside of the gathered rows
+        staged_positions[i] =
+          is_valid(id) ? static_cast<uint32_t>(
+                           std::lower_bound(unique_ids.begin(), unique_ids.end(), id) -
+                           unique_ids.begin())
+                       : std::numeric_limits<uint32_t>::max();
+      }
+    }
+    raft::copy(
+      rows_dev.data(), reinterpret_cast<const data_t*>(staged_rows), n_unique * dim, stream);
+    raft::copy(positions_dev.data(), staged_positions, batch_rows, stream);
+    staging.record(slot, stream);
+
+    run_refine_kernel(rows_dev.data(),
+                      static_cast<idx_t>(n_unique),
+                      static_cast<uint32_t>(dim),
+                      queries.data_handle() + offset * dim,
+                      static_cast<uint32_t>(batch_size),
+                      neighbor_candidates.data_handle() + offset * n_candidates,
+                      positions_dev.data(),
+                      static_cast<uint32_t>(n_candidates),
+                      k,
+                      metric,
+                      indices.data_handle() + offset * k,
+                      distances.data_handle() + offset * k,
+                      stream);
   }
 }
 
 /**
- * Naive CPU implementation of refine operation
+ * CPU implementation of refine operation
  *
  * All pointers are expected to be accessible on the host.
+ * The queries are processed in parallel by the OpenMP threads; the distances are computed with
+ * the SIMD-vectorized loops and the best k candidates are found with a partial sort.
  */
 template <typename idx_t, typename data_t, typename distance_t, typename matrix_idx>
 void refine_host(raft::host_matrix_view<const data_t, matrix_idx, row_major> dataset,
@@ -180,63 +551,76 @@ void refine_host(raft::host_matrix_view<const data_t, matrix_idx, row_major> dat
               distances.extents(),
               metric);
 
+  bool inner_product = false;
+  bool take_sqrt     = false;
   switch (metric) {
-    case raft::distance::DistanceType::L2Expanded: break;
-    case raft::distance::DistanceType::InnerProduct: break;
-    default: throw raft::logic_error("Unsopported metric");
+    case raft::distance::DistanceType::L2Expanded:
+    case raft::distance::DistanceType::L2Unexpanded: break;
+    case raft::distance::DistanceType::L2SqrtExpanded:
+    case raft::distance::DistanceType::L2SqrtUnexpanded: take_sqrt = true; break;
+    case raft::distance::DistanceType::InnerProduct: inner_product = true; break;
+    default: throw raft::logic_error("Unsupported metric");
   }
 
-  size_t numDataset            = dataset.extent(0);
-  size_t numQueries            = queries.extent(0);
-  size_t dimDataset            = dataset.extent(1);
-  const data_t* dataset_ptr    = dataset.data_handle();
-  const data_t* queries_ptr    = queries.data_handle();
-  const idx_t* neighbors       = neighbor_candidates.data_handle();
-  idx_t topK                   = neighbor_candidates.extent(1);
-  idx_t refinedTopK            = indices.extent(1);
-  idx_t* refinedNeighbors      = indices.data_handle();
-  distance_t* refinedDistances = distances.data_handle();
+  const int64_t n_rows        = dataset.extent(0);
+  const int64_t n_queries     = queries.extent(0);
+  const size_t dim            = dataset.extent(1);
+  const size_t n_candidates   = neighbor_candidates.extent(1);
+  const size_t k              = indices.extent(1);
+  const data_t* dataset_ptr   = dataset.data_handle();
+  const data_t* queries_ptr   = queries.data_handle();
+  const idx_t* candidates_ptr = neighbor_candidates.data_handle();
+  idx_t* indices_ptr          = indices.data_handle();
+  distance_t* distances_ptr   = distances.data_handle();
 
   common::nvtx::range<common::nvtx::domain::raft> fun_scope(
-    "neighbors::refine_host(%zu, %u)", size_t(numQueries), uint32_t(topK));
+    "neighbors::refine_host(%zu, %zu)", size_t(n_queries), n_candidates);
 
 #pragma omp parallel
   {
-    struct_for_refinement* sfr =
-      (struct_for_refinement*)malloc(sizeof(struct_for_refinement) * topK);
-    for (size_t i = omp_get_thread_num(); i < numQueries; i += omp_get_num_threads()) {
-      // compute distance with original dataset vectors
-      const data_t* cur_query = queries_ptr + ((uint64_t)dimDataset * i);
-      for (size_t j = 0; j < (size_t)topK; j++) {
-        idx_t id                  = neighbors[j + (topK * i)];
-        const data_t* cur_dataset = dataset_ptr + ((uint64_t)dimDataset * id);
-        float distance            = 0.0;
-        for (size_t k = 0; k < (size_t)dimDataset; k++) {
-          float val_q = (float)(cur_query[k]);
-          float val_d = (float)(cur_dataset[k]);
-          if (metric == raft::distance::DistanceType::InnerProduct) {
-            distance += -val_q * val_d;  // Negate because we sort in ascending order.
-          } else {
-            distance += (val_q - val_d) * (val_q - val_d);
+    // (distance, id) pairs; the inner product is negated to sort everything in ascending order.
+    std::vector<std::tuple<distance_t, idx_t>> refined(n_candidates);
+#pragma omp for schedule(dynamic, 16)
+    for (int64_t i = 0; i < n_queries; i++) {
+      const data_t* query = queries_ptr + dim * i;
+      for (size_t j = 0; j < n_candidates; j++) {
+        const idx_t id = candidates_ptr[j + n_candidates * i];
+        // the candidates outside of the dataset range go to the end of the list
+        if (int64_t(id) < 0 || int64_t(id) >= n_rows) {
+          refined[j] = {std::numeric_limits<distance_t>::max(), id};
+          continue;
+        }
+        const data_t* row = dataset_ptr + dim * static_cast<size_t>(id);
+        distance_t dist   = 0;
+        if (inner_product) {
+#pragma omp simd reduction(+ : dist)
+          for (size_t l = 0; l < dim; l++) {
+            dist -= static_cast<distance_t>(query[l]) * static_cast<distance_t>(row[l]);
+          }
+        } else {
+#pragma omp simd reduction(+ : dist)
+          for (size_t l = 0; l < dim; l++) {
+            const auto d = static_cast<distance_t>(query[l]) - static_cast<distance_t>(row[l]);
+            dist += d * d;
           }
         }
-        sfr[j].id       = id;
-        sfr[j].distance = distance;
+        refined[j] = {dist, id};
       }
 
-      qsort(sfr, topK, sizeof(struct_for_refinement), _postprocessing_qsort_compare);
+      std::partial_sort(refined.begin(), refined.begin() + k, refined.end());
 
-      for (size_t j = 0; j < (size_t)refinedTopK; j++) {
-        refinedNeighbors[j + (refinedTopK * i)] = sfr[j].id;
-        if (refinedDistances == NULL) continue;
-        if (metric == raft::distance::DistanceType::InnerProduct) {
-          refinedDistances[j + (refinedTopK * i)] = -sfr[j].distance;
-        } else {
-          refinedDistances[j + (refinedTopK * i)] = sfr[j].distance;
+      for (size_t j = 0; j < k; j++) {
+        auto [dist, id]        = refined[j];
+        indices_ptr[j + k * i] = id;
+        if (distances_ptr == nullptr) { continue; }
+        if (inner_product) {
+          dist = -dist;
+        } else if (take_sqrt) {
+          dist = std::sqrt(dist);
         }
+        distances_ptr[j + k * i] = dist;
       }
     }
-    free(sfr);
   }
 }
 
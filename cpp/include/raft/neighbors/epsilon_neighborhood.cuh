@@ -19,9 +19,12 @@
 
 #pragma once
 
+#include <raft/core/device_csr_matrix.hpp>
 #include <raft/core/device_mdspan.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resources.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/neighbors/detail/epsilon_neighborhood.cuh>
 #include <raft/spatial/knn/detail/epsilon_neighborhood.cuh>
 
 namespace raft::neighbors::epsilon_neighborhood {
@@ -116,6 +119,58 @@ void eps_neighbors_l2sq(raft::resources const& handle,
                                            resource::get_cuda_stream(handle));
 }
 
+/**
+ * @brief Computes epsilon neighborhood for any supported distance metric, producing a sparse
+ * adjacency matrix in the compressed sparse row (CSR) format.
+ *
+ * Unlike `eps_neighbors_l2sq`, the dense m * n adjacency matrix is never materialized: the
+ * distances are computed tile by tile, so the memory footprint scales with the number of the
+ * found neighbors. The column indices of every row are sorted, and the elements of the output
+ * matrix are the distances to the neighbors.
+ *
+ * A point `y[j]` is a neighbor of `x[i]` if `dist(x[i], y[j]) <= eps` for the distance metrics,
+ * or `dist(x[i], y[j]) >= eps` for the similarity metrics (such as the inner product).
+ *
+ * @code{.cpp}
+ *  #include <raft/neighbors/epsilon_neighborhood.cuh>
+ *  #include <raft/core/resources.hpp>
+ *  #include <raft/core/device_csr_matrix.hpp>
+ *  using namespace raft::neighbors;
+ *  raft::resources handle;
+ *  ...
+ *  auto adj = raft::make_device_csr_matrix<float, int, int, int64_t>(handle, m, n);
+ *  epsilon_neighborhood::eps_neighbors(
+ *    handle, x, y, adj, eps, raft::distance::DistanceType::L2SqrtUnexpanded);
+ *  auto indptr  = adj.structure_view().get_indptr();
+ *  auto indices = adj.structure_view().get_indices();
+ * @endcode
+ *
+ * @tparam value_t   IO and math type
+ * @tparam idx_t    Index type
+ * @tparam nnz_t    The type of the number of the non-zeros in the adjacency matrix
+ *
+ * @param[in]  handle raft handle to manage library resources
+ * @param[in]  x      first matrix [row-major] [on device] [dim = m x k]
+ * @param[in]  y      second matrix [row-major] [on device] [dim = n x k]
+ * @param[out] adj    sparsity-owning adjacency matrix [on device] [dim = m x n]; its sparsity is
+ *                    initialized to the number of the found neighbors
+ * @param[in]  eps    defines epsilon neighborhood radius in terms of the chosen metric (e.g.
+ *                    should be passed as squared for the L2-squared distance)
+ * @param[in]  metric the distance metric
+ * @param[in]  metric_arg the argument of the metric (e.g. p for the Minkowski distance)
+ */
+template <typename value_t, typename idx_t, typename nnz_t>
+void eps_neighbors(raft::resources const& handle,
+                   raft::device_matrix_view<const value_t, idx_t, row_major> x,
+                   raft::device_matrix_view<const value_t, idx_t, row_major> y,
+                   raft::device_csr_matrix<value_t, idx_t, idx_t, nnz_t>& adj,
+                   value_t eps,
+                   raft::distance::DistanceType metric = raft::distance::DistanceType::L2Unexpanded,
+                   value_t metric_arg                  = 2.0)
+{
+  detail::eps_neighbors<value_t, idx_t, nnz_t>(handle, x, y, adj, eps, metric, metric_arg);
+}
+
 /** @} */  // end group epsilon_neighbors
 
 }  // namespace raft::neighbors::epsilon_neighborhood
@@ -17,8 +17,11 @@
 #pragma once
 
 #include <cstdint>                                // int64_t
+#include <cuda_fp16.h>                            // half
 
+#include <raft/core/device_csr_matrix.hpp>        // raft::device_csr_matrix
 #include <raft/core/device_mdspan.hpp>            // raft::device_matrix_view
+#include <raft/core/host_mdspan.hpp>              // raft::host_vector_view
 #include <raft/core/resources.hpp>                // raft::resources
 #include <raft/neighbors/ivf_flat_serialize.cuh>
 #include <raft/neighbors/ivf_flat_types.hpp>      // raft::neighbors::ivf_flat::index
@@ -114,6 +117,22 @@ void search(raft::resources const& handle,
             raft::device_matrix_view<IdxT, IdxT, row_major> neighbors,
             raft::device_matrix_view<float, IdxT, row_major> distances) RAFT_EXPLICIT;
 
+template <typename T, typename IdxT>
+void search(raft::resources const& handle,
+            const search_params& params,
+            const index<T, IdxT>& index,
+            raft::device_matrix_view<const T, IdxT, row_major> queries,
+            raft::host_vector_view<const uint32_t, IdxT> k,
+            raft::device_csr_matrix<float, int64_t, IdxT, int64_t>& out) RAFT_EXPLICIT;
+
+template <typename T, typename IdxT>
+void range_search(raft::resources const& handle,
+                  const search_params& params,
+                  const index<T, IdxT>& index,
+                  raft::device_matrix_view<const T, IdxT, row_major> queries,
+                  float radius,
+                  raft::device_csr_matrix<float, int64_t, IdxT, int64_t>& out) RAFT_EXPLICIT;
+
 }  // namespace raft::neighbors::ivf_flat
 
 #endif  // RAFT_EXPLICIT_INSTANTIATE_ONLY
@@ -142,6 +161,7 @@ void search(raft::resources const& handle,
 instantiate_raft_neighbors_ivf_flat_build(float, int64_t);
 instantiate_raft_neighbors_ivf_flat_build(int8_t, int64_t);
 instantiate_raft_neighbors_ivf_flat_build(uint8_t, int64_t);
+instantiate_raft_neighbors_ivf_flat_build(half, int64_t);
 #undef instantiate_raft_neighbors_ivf_flat_build
 
 #define instantiate_raft_neighbors_ivf_flat_extend(T, IdxT)                \
@@ -176,31 +196,49 @@ instantiate_raft_neighbors_ivf_flat_build(uint8_t, int64_t);
 instantiate_raft_neighbors_ivf_flat_extend(float, int64_t);
 instantiate_raft_neighbors_ivf_flat_extend(int8_t, int64_t);
 instantiate_raft_neighbors_ivf_flat_extend(uint8_t, int64_t);
+instantiate_raft_neighbors_ivf_flat_extend(half, int64_t);
 
 #undef instantiate_raft_neighbors_ivf_flat_extend
 
-#define instantiate_raft_neighbors_ivf_flat_search(T, IdxT)        \
-  extern template void raft::neighbors::ivf_flat::search<T, IdxT>( \
-    raft::resources const& handle,                                 \
-    const raft::neighbors::ivf_flat::search_params& params,        \
-    const raft::neighbors::ivf_flat::index<T, IdxT>& index,        \
-    const T* queries,                                              \
-    uint32_t n_queries,                                            \
-    uint32_t k,                                                    \
-    IdxT* neighbors,                                               \
-    float* distances,                                              \
-    rmm::mr::device_memory_resource* mr);                          \
-                                                                   \
-  extern template void raft::neighbors::ivf_flat::search<T, IdxT>( \
-    raft::resources const& handle,                                 \
-    const raft::neighbors::ivf_flat::search_params& params,        \
-    const raft::neighbors::ivf_flat::index<T, IdxT>& index,        \
-    raft::device_matrix_view<const T, IdxT, row_major> queries,    \
-    raft::device_matrix_view<IdxT, IdxT, row_major> neighbors,     \
-    raft::device_matrix_view<float, IdxT, row_major> distances);
+#define instantiate_raft_neighbors_ivf_flat_search(T, IdxT)              \
+  extern template void raft::neighbors::ivf_flat::search<T, IdxT>(       \
+    raft::resources const& handle,                                       \
+    const raft::neighbors::ivf_flat::search_params& params,              \
+    const raft::neighbors::ivf_flat::index<T, IdxT>& index,              \
+    const T* queries,                                                    \
+    uint32_t n_queries,                                                  \
+    uint32_t k,                                                          \
+    IdxT* neighbors,                                                     \
+    float* distances,                                                    \
+    rmm::mr::device_memory_resource* mr);                                \
+                                                                         \
+  extern template void raft::neighbors::ivf_flat::search<T, IdxT>(       \
+    raft::resources const& handle,                                       \
+    const raft::neighbors::ivf_flat::search_params& params,              \
+    const raft::neighbors::ivf_flat::index<T, IdxT>& index,              \
+    raft::device_matrix_view<const T, IdxT, row_major> queries,          \
+    raft::device_matrix_view<IdxT, IdxT, row_major> neighbors,           \
+    raft::device_matrix_view<float, IdxT, row_major> distances);         \
+                                                                         \
+  extern template void raft::neighbors::ivf_flat::range_search<T, IdxT>( \
+    raft::resources const& handle,                                       \
+    const raft::neighbors::ivf_flat::search_params& params,              \
+    const raft::neighbors::ivf_flat::index<T, IdxT>& index,              \
+    raft::device_matrix_view<const T, IdxT, row_major> queries,          \
+    float radius,                                                        \
+    raft::device_csr_matrix<float, int64_t, IdxT, int64_t>& out);        \
+                                                                         \
+  extern template void raft::neighbors::ivf_flat::search<T, IdxT>(       \
+    raft::resources const& handle,                                       \
+    const raft::neighbors::ivf_flat::search_params& params,              \
+    const raft::neighbors::ivf_flat::index<T, IdxT>& index,              \
+    raft::device_matrix_view<const T, IdxT, row_major> queries,          \
+    raft::host_vector_view<const uint32_t, IdxT> k,                      \
+    raft::device_csr_matrix<float, int64_t, IdxT, int64_t>& out);
 
 instantiate_raft_neighbors_ivf_flat_search(float, int64_t);
 instantiate_raft_neighbors_ivf_flat_search(int8_t, int64_t);
 instantiate_raft_neighbors_ivf_flat_search(uint8_t, int64_t);
+instantiate_raft_neighbors_ivf_flat_search(half, int64_t);
 
 #undef instantiate_raft_neighbors_ivf_flat_search
@@ -17,12 +17,15 @@
 #pragma once
 
 #include <raft/neighbors/detail/ivf_flat_build.cuh>
+#include <raft/neighbors/detail/ivf_flat_host_lists.cuh>
 #include <raft/neighbors/detail/ivf_flat_search.cuh>
+#include <raft/neighbors/detail/ragged_search.cuh>
 #include <raft/neighbors/ivf_flat_serialize.cuh>
 #include <raft/neighbors/ivf_flat_types.hpp>
 
 #include <raft/core/resources.hpp>
 
+#include <raft/core/device_csr_matrix.hpp>
 #include <raft/core/device_mdspan.hpp>
 #include <rmm/cuda_stream_view.hpp>
 #include <rmm/mr/device/per_device_resource.hpp>
@@ -36,6 +39,7 @@ namespace raft::neighbors::ivf_flat {
  * - L2Expanded
  * - L2Unexpanded
  * - InnerProduct
+ * - CosineExpanded (float and half data only; normalized internally)
  *
  * Usage example:
  * @code{.cpp}
@@ -83,6 +87,7 @@ auto build(raft::resources const& handle,
  * - L2Expanded
  * - L2Unexpanded
  * - InnerProduct
+ * - CosineExpanded (float and half data only; normalized internally)
  *
  * Usage example:
  * @code{.cpp}
@@ -125,6 +130,7 @@ auto build(raft::resources const& handle,
  * - L2Expanded
  * - L2Unexpanded
  * - InnerProduct
+ * - CosineExpanded (float and half data only; normalized internally)
  *
  * Usage example:
  * @code{.cpp}
@@ -563,6 +569,10 @@ void search_with_filtering(raft::resources const& handle,
  *   ...
  * @endcode
  *
+ * With a deadline (`params.deadline`), the queries are searched in batches of at most 4096 and the
+ * search waits for every batch before starting the next one; once the deadline expires, the
+ * remaining batches probe the closest cluster of every query only.
+ *
  * @tparam T data element type
  * @tparam IdxT type of the indices
  *
@@ -591,6 +601,211 @@ void search(raft::resources const& handle,
                         raft::neighbors::filtering::none_ivf_sample_filter());
 }
 
+/**
+ * @brief Search ANN with a different number of neighbors per query.
+ *
+ * The neighbors are returned as a CSR matrix [n_queries, index.size()]: the row `i` holds the
+ * `k[i]` neighbors of the query `i` and the distances to them, sorted as by `search`. The queries
+ * are searched in buckets of a similar k (within a factor of two), so a batch mixing small and
+ * large k keeps its batching while the top-k selection of the small-k queries is not sized for
+ * the largest k of the batch.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors;
+ *   auto index = ivf_flat::build(handle, index_params, dataset);
+ *   ivf_flat::search_params search_params;
+ *   // e.g. k = 10 for the first queries and k = 1000 for the rest
+ *   auto k = raft::make_host_vector<uint32_t, int64_t>(queries.extent(0));
+ *   ...
+ *   auto out = raft::make_device_csr_matrix<float, int64_t, int64_t, int64_t>(
+ *     handle, queries.extent(0), index.size());
+ *   ivf_flat::search(
+ *     handle, search_params, index, queries, raft::make_const_mdspan(k.view()), out);
+ *   auto neighbors = out.structure_view();  // get_indptr(), get_indices()
+ *   auto distances = out.get_elements();
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] handle
+ * @param[in] params configure the search
+ * @param[in] index ivf-flat constructed index
+ * @param[in] queries a device matrix view to a row-major matrix [n_queries, index->dim()]
+ * @param[in] k the number of neighbors to find for every query [n_queries]
+ * @param[out] out a CSR matrix [n_queries, index.size()]; its sparsity is initialized with `sum(k)`
+ */
+template <typename T, typename IdxT>
+void search(raft::resources const& handle,
+            const search_params& params,
+            const index<T, IdxT>& index,
+            raft::device_matrix_view<const T, IdxT, row_major> queries,
+            raft::host_vector_view<const uint32_t, IdxT> k,
+            raft::device_csr_matrix<float, int64_t, IdxT, int64_t>& out)
+{
+  RAFT_EXPECTS(queries.extent(1) == index.dim(),
+               "Number of query dimensions should equal number of dimensions in the index.");
+  RAFT_EXPECTS(out.structure_view().get_n_cols() == index.size(),
+               "The output must be a CSR matrix of shape [n_queries, index.size()]");
+  raft::neighbors::detail::search_ragged(
+    handle, queries, k, out, [&](auto bucket_queries, auto neighbors, auto distances) {
+      search(handle, params, index, bucket_queries, neighbors, distances);
+    });
+}
+
+/**
+ * @brief Find all the neighbors of the queries within a radius (range search).
+ *
+ * Unlike `search`, the number of neighbors varies per query, hence they are returned as a CSR
+ * matrix [n_queries, index.size()]: the row `i` holds the indices (in the source dataset) of the
+ * neighbors of the query `i` and the distances to them, in no particular order.
+ *
+ * The clusters to probe are selected as in `search`, then the probed lists are scanned twice: the
+ * first pass counts the neighbors of every query to size the output, the second one writes them.
+ * Hence, as for `search`, the neighbors in the clusters which are not probed are missed.
+ *
+ * A vector is a neighbor of a query if its distance is not greater than `radius` (not less than
+ * `radius` for the inner product). The distances and the radius are in the units of the index
+ * metric, e.g. the squared distances for `L2Expanded`.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors;
+ *   auto index = ivf_flat::build(handle, index_params, dataset);
+ *   ivf_flat::search_params search_params;
+ *   auto out = raft::make_device_csr_matrix<float, int64_t, int64_t, int64_t>(
+ *     handle, queries.extent(0), index.size());
+ *   ivf_flat::range_search(handle, search_params, index, queries, 0.5f, out);
+ *   auto neighbors = out.structure_view();  // get_indptr(), get_indices()
+ *   auto distances = out.get_elements();
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] handle
+ * @param[in] params configure the search (the deadline is not supported)
+ * @param[in] index ivf-flat constructed index
+ * @param[in] queries a device matrix view to a row-major matrix [n_queries, index->dim()]
+ * @param[in] radius the maximum distance (the minimum similarity) of the neighbors
+ * @param[out] out a CSR matrix [n_queries, index.size()]; its sparsity is initialized with the
+ *   total number of the neighbors found
+ */
+template <typename T, typename IdxT>
+void range_search(raft::resources const& handle,
+                  const search_params& params,
+                  const index<T, IdxT>& index,
+                  raft::device_matrix_view<const T, IdxT, row_major> queries,
+                  float radius,
+                  raft::device_csr_matrix<float, int64_t, IdxT, int64_t>& out)
+{
+  RAFT_EXPECTS(queries.extent(1) == index.dim(),
+               "Number of query dimensions should equal number of dimensions in the index.");
+
+  detail::range_search(handle,
+                       params,
+                       index,
+                       queries.data_handle(),
+                       static_cast<uint32_t>(queries.extent(0)),
+                       radius,
+                       out,
+                       resource::get_workspace_resource(handle));
+}
+
+/**
+ * @brief Count how often the lists of the index are probed by the given (sample of) queries.
+ *
+ * The counts are meant to drive the placement of the lists split between the device and the host
+ * memory (see `host_lists`).
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] handle
+ * @param[in] params the search parameters (the probing ones are used)
+ * @param[in] index ivf-flat constructed index
+ * @param[in] queries a device matrix view to a row-major matrix [n_queries, index->dim()]
+ * @return the number of probes of every list [n_lists]
+ */
+template <typename T, typename IdxT>
+auto profile_probes(raft::resources const& handle,
+                    const search_params& params,
+                    const index<T, IdxT>& index,
+                    raft::device_matrix_view<const T, IdxT, row_major> queries)
+  -> raft::host_vector<uint64_t, uint32_t>
+{
+  RAFT_EXPECTS(queries.extent(1) == index.dim(),
+               "Number of query dimensions should equal number of dimensions in the index.");
+  return detail::profile_probes(
+    handle, params, index, queries.data_handle(), static_cast<uint32_t>(queries.extent(0)));
+}
+
+/**
+ * @brief Search ANN using an index whose cold lists are kept in the host memory.
+ *
+ * The most frequently probed lists stay on the device, the rest are moved to the host memory by
+ * constructing a `host_lists` object. The device lists are scanned by the GPU and, at the same
+ * time, the host lists are scanned by the CPU; the results are merged on the device.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   // build the index on the device
+ *   auto index = ivf_flat::build(handle, index_params, dataset);
+ *   // count the probes of a representative sample of the queries
+ *   auto probe_counts = ivf_flat::profile_probes(handle, search_params, index, sample_queries);
+ *   // keep up to 8GB of the lists on the device
+ *   ivf_flat::hybrid_params hybrid;
+ *   hybrid.device_memory_limit = size_t{8} << 30;
+ *   ivf_flat::host_lists<float, int64_t> lists(
+ *     handle, hybrid, index, raft::make_const_mdspan(probe_counts.view()));
+ *   ivf_flat::search(handle, search_params, index, lists, queries, neighbors, distances);
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] handle
+ * @param[in] params configure the search (filtering is not supported)
+ * @param[in] index ivf-flat constructed index, with the cold lists moved to `lists`
+ * @param[in] lists the host lists of `index`
+ * @param[in] queries a device matrix view to a row-major matrix [n_queries, index->dim()]
+ * @param[out] neighbors a device matrix view to the indices of the neighbors in the source dataset
+ * [n_queries, k]
+ * @param[out] distances a device matrix view to the distances to the selected neighbors [n_queries,
+ * k]
+ */
+template <typename T, typename IdxT>
+void search(raft::resources const& handle,
+            const search_params& params,
+            const index<T, IdxT>& index,
+            const host_lists<T, IdxT>& lists,
+            raft::device_matrix_view<const T, IdxT, row_major> queries,
+            raft::device_matrix_view<IdxT, IdxT, row_major> neighbors,
+            raft::device_matrix_view<float, IdxT, row_major> distances)
+{
+  RAFT_EXPECTS(
+    queries.extent(0) == neighbors.extent(0) && queries.extent(0) == distances.extent(0),
+    "Number of rows in output neighbors and distances matrices must equal the number of queries.");
+
+  RAFT_EXPECTS(neighbors.extent(1) == distances.extent(1),
+               "Number of columns in output neighbors and distances matrices must equal k");
+
+  RAFT_EXPECTS(queries.extent(1) == index.dim(),
+               "Number of query dimensions should equal number of dimensions in the index.");
+
+  detail::search(handle,
+                 params,
+                 index,
+                 lists,
+                 queries.data_handle(),
+                 static_cast<uint32_t>(queries.extent(0)),
+                 static_cast<uint32_t>(neighbors.extent(1)),
+                 neighbors.data_handle(),
+                 distances.data_handle(),
+                 resource::get_workspace_resource(handle));
+}
+
 /** @} */
 
 }  // namespace raft::neighbors::ivf_flat
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/neighbors/detail/ivf_flat_distributed.cuh>
+#include <raft/neighbors/ivf_flat_types.hpp>
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resources.hpp>
+
+namespace raft::neighbors::ivf_flat::distributed {
+
+/**
+ * @defgroup ivf_flat_distributed IVF-Flat index distributed over the ranks of a communicator
+ * @{
+ */
+
+/**
+ * @brief The part of a distributed IVF-Flat index held by one rank.
+ *
+ * The coarse centers are replicated on all the ranks, while the inverted lists are partitioned by
+ * the cluster id: the rank `label % n_ranks` owns the list `label`. A query is sent only to the
+ * ranks owning the lists it probes; so, unlike sharding the dataset (where every rank searches
+ * every query), the work per query does not grow with the number of ranks.
+ *
+ * The local index (`local()`) holds the replicated centers and the owned lists; the other lists
+ * are empty. The ids stored in the lists are the global ids of the vectors.
+ */
+template <typename T, typename IdxT>
+using index = detail::index<T, IdxT>;
+
+/**
+ * @brief Build a distributed IVF-Flat index from the parts of the dataset held by the ranks.
+ *
+ * This is a collective operation over the communicator of the handle
+ * (`raft::resource::get_comms`). The first rank trains the centers on its part of the dataset
+ * and broadcasts them; then every rank sends its vectors to the owners of their clusters.
+ * The global id of a vector is its row in the concatenation of the parts in the rank order.
+ *
+ * The centers are shared by all the ranks, so `params.adaptive_centers` must be false.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors;
+ *   // the handle has the communicator injected (e.g. raft::comms::initialize_mpi_comms)
+ *   ivf_flat::index_params index_params;
+ *   auto dindex = ivf_flat::distributed::build(handle, index_params, local_dataset);
+ *   // all the ranks search at the same time; every rank gets the results of its own queries
+ *   ivf_flat::search_params search_params;
+ *   ivf_flat::distributed::search(
+ *     handle, search_params, dindex, local_queries, out_inds, out_dists);
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices in the source dataset
+ *
+ * @param[in] handle the raft handle, with the communicator injected
+ * @param[in] params configure the index building
+ * @param[in] dataset the part of the dataset held by this rank [n_rows, dim]; the first rank
+ *   must hold at least `params.n_lists` rows
+ *
+ * @return the part of the index held by this rank
+ */
+template <typename T, typename IdxT>
+auto build(raft::resources const& handle,
+           const ivf_flat::index_params& params,
+           raft::device_matrix_view<const T, IdxT, row_major> dataset) -> index<T, IdxT>
+{
+  return detail::build(handle,
+                       params,
+                       dataset.data_handle(),
+                       static_cast<IdxT>(dataset.extent(0)),
+                       static_cast<uint32_t>(dataset.extent(1)));
+}
+
+/**
+ * @brief Add new vectors to a distributed index.
+ *
+ * This is a collective operation: every rank calls it with its new vectors (possibly none), which
+ * are sent to the owners of their clusters.
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices in the source dataset
+ *
+ * @param[in] handle the raft handle, with the communicator injected
+ * @param[in] new_vectors the new vectors of this rank [n_rows, index->local().dim()]
+ * @param[in] new_indices the global ids of the new vectors [n_rows]
+ * @param[inout] index the part of the index held by this rank
+ */
+template <typename T, typename IdxT>
+void extend(raft::resources const& handle,
+            raft::device_matrix_view<const T, IdxT, row_major> new_vectors,
+            raft::device_vector_view<const IdxT, IdxT> new_indices,
+            index<T, IdxT>* index)
+{
+  RAFT_EXPECTS(new_indices.extent(0) == new_vectors.extent(0),
+               "new_vectors and new_indices have different number of rows");
+  RAFT_EXPECTS(new_vectors.extent(1) == index->local().dim(),
+               "new_vectors should have the same dimension as the index");
+  detail::extend(handle,
+                 index,
+                 new_vectors.data_handle(),
+                 new_indices.data_handle(),
+                 static_cast<IdxT>(new_vectors.extent(0)));
+}
+
+/**
+ * @brief Search the distributed index for the k nearest neighbors of the queries of every rank.
+ *
+ * This is a collective operation: every rank calls it with its own queries (possibly none). A rank
+ * selects the probed clusters of its queries on the replicated centers, sends every query, with
+ * its probes, to the ranks owning the probed lists only (`device_multicast_sendrecv`), scans the
+ * lists it owns for the queries it receives and sends the partial results back; the partial
+ * results of a query are then merged by the rank of the query. The results are the same as those
+ * of `ivf_flat::search` on a single index holding all the lists.
+ *
+ * The candidate budget of the adaptive probing (`params.max_candidates`) is not supported, since
+ * it depends on the sizes of the lists of all the ranks.
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] handle the raft handle, with the communicator injected
+ * @param[in] params configure the search
+ * @param[in] index the part of the index held by this rank
+ * @param[in] queries the queries of this rank [n_queries, index.local().dim()]
+ * @param[out] neighbors the global ids of the neighbors [n_queries, k]
+ * @param[out] distances the distances to the neighbors [n_queries, k]
+ */
+template <typename T, typename IdxT>
+void search(raft::resources const& handle,
+            const ivf_flat::search_params& params,
+            const index<T, IdxT>& index,
+            raft::device_matrix_view<const T, IdxT, row_major> queries,
+            raft::device_matrix_view<IdxT, IdxT, row_major> neighbors,
+            raft::device_matrix_view<float, IdxT, row_major> distances)
+{
+  RAFT_EXPECTS(
+    queries.extent(0) == neighbors.extent(0) && queries.extent(0) == distances.extent(0),
+    "Number of rows in output neighbors and distances matrices must equal the number of queries.");
+  RAFT_EXPECTS(neighbors.extent(1) == distances.extent(1),
+               "Number of columns in output neighbors and distances matrices must be equal");
+  RAFT_EXPECTS(queries.extent(1) == index.local().dim(),
+               "Number of query dimensions should equal number of dimensions in the index.");
+
+  detail::search(handle,
+                 params,
+                 index,
+                 queries.data_handle(),
+                 static_cast<uint32_t>(queries.extent(0)),
+                 static_cast<uint32_t>(neighbors.extent(1)),
+                 neighbors.data_handle(),
+                 distances.data_handle());
+}
+
+/** @} */
+
+}  // namespace raft::neighbors::ivf_flat::distributed
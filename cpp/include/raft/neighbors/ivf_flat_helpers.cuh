@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/neighbors/detail/ivf_flat_build.cuh>
+#include <raft/neighbors/ivf_flat_types.hpp>
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resources.hpp>
+
+#include <optional>
+
+namespace raft::neighbors::ivf_flat::helpers {
+/**
+ * @defgroup ivf_flat_helpers Helper functions for manipulationg IVF Flat Index
+ * @{
+ */
+
+/**
+ * @brief Remove the records with the given source indices from the index in-place.
+ *
+ * Only the lists containing the removed records are rewritten; they are compacted, so that the
+ * list sizes (and thus the search cost) shrink along with the index. The cluster centers are not
+ * updated, even if the index has adaptive centers. The source indices that are not in the index
+ * are ignored; if the same source index occurs in the index multiple times, all its occurrences
+ * are removed.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   // remove the records 10 and 42
+ *   std::vector<int64_t> ids_host{10, 42};
+ *   auto ids = raft::make_device_vector<int64_t, int64_t>(res, ids_host.size());
+ *   raft::copy(ids.data_handle(), ids_host.data(), ids_host.size(), stream);
+ *   auto n_removed = ivf_flat::helpers::remove(res, raft::make_const_mdspan(ids.view()), &index);
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices in the source dataset
+ *
+ * @param[in] res
+ * @param[in] ids the source indices of the records to remove [n_ids]
+ * @param[inout] index
+ * @return the number of removed records
+ */
+template <typename T, typename IdxT>
+auto remove(raft::resources const& res,
+            raft::device_vector_view<const IdxT, IdxT> ids,
+            index<T, IdxT>* index) -> IdxT
+{
+  return ivf_flat::detail::remove(res, ids, index);
+}
+
+/**
+ * @brief Preallocate the free space for at least `n_free_records` more records in every list.
+ *
+ * Together with `extend_inplace`, this allows to ingest the new data in small batches without
+ * reallocating the lists.
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices in the source dataset
+ *
+ * @param[in] res
+ * @param[inout] index
+ * @param n_free_records the minimum number of free records per list
+ */
+template <typename T, typename IdxT>
+void reserve(raft::resources const& res, index<T, IdxT>* index, uint32_t n_free_records)
+{
+  ivf_flat::detail::reserve(res, index, n_free_records);
+}
+
+/**
+ * @brief Extend the index in-place, writing the new records into the free space of the lists.
+ *
+ * Unlike `ivf_flat::extend`, this does not reallocate the lists nor update the list pointers
+ * (hence, does not synchronize with the host beyond fetching a single counter) unless some of the
+ * lists overflow; only the records that do not fit into the preallocated lists go through the
+ * regular `ivf_flat::extend`. Use `reserve` to preallocate the free space in advance.
+ *
+ * The regular `ivf_flat::extend` is used for the whole batch if the index has adaptive centers,
+ * has no precomputed center norms yet, or any of its lists is shared with a clone of the index.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   // preallocate the space for new records
+ *   ivf_flat::helpers::reserve(res, &index, 1024);
+ *   // ingest the small batches of data as they arrive
+ *   ivf_flat::helpers::extend_inplace(res, batch_vectors, batch_indices, &index);
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices in the source dataset
+ *
+ * @param[in] res
+ * @param[in] new_vectors a device matrix view to a row-major matrix [n_rows, index.dim()]
+ * @param[in] new_indices a device vector view to a vector of indices [n_rows].
+ *    If the original index is empty (`index.size() == 0`), you can pass `std::nullopt`
+ *    here to imply a continuous range `[0...n_rows)`.
+ * @param[inout] index
+ */
+template <typename T, typename IdxT>
+void extend_inplace(raft::resources const& res,
+                    raft::device_matrix_view<const T, IdxT, row_major> new_vectors,
+                    std::optional<raft::device_vector_view<const IdxT, IdxT>> new_indices,
+                    index<T, IdxT>* index)
+{
+  ivf_flat::detail::extend_inplace(
+    res,
+    index,
+    new_vectors.data_handle(),
+    new_indices.has_value() ? new_indices.value().data_handle() : nullptr,
+    static_cast<IdxT>(new_vectors.extent(0)));
+}
+
+/**
+ * @brief Shrink the lists of the index in-place to fit their sizes.
+ *
+ * After many calls to `extend`, the lists may hold a lot of unused space (unless the index uses
+ * the conservative memory allocation). This function reallocates every such list with the
+ * smallest capacity fitting its records and returns the unused memory. If the lists are kept in
+ * an arena (see `index_params::list_arena_chunk_size`), all of them are moved into a new arena,
+ * which also returns the memory left in the chunks by the reallocated lists. The lists shared with
+ * the clones of the index are copied, not modified. The content of the index does not change.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   ivf_flat::extend(res, new_vectors, new_indices, &index);
+ *   // return the unused space of the lists
+ *   ivf_flat::helpers::compact(res, &index);
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices in the source dataset
+ *
+ * @param[in] res
+ * @param[inout] index
+ */
+template <typename T, typename IdxT>
+void compact(raft::resources const& res, index<T, IdxT>* index)
+{
+  ivf_flat::detail::compact(res, index);
+}
+
+/** @} */
+}  // namespace raft::neighbors::ivf_flat::helpers
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/neighbors/detail/ivf_flat_multi.cuh>
+#include <raft/neighbors/ivf_flat_types.hpp>
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/host_mdspan.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resources.hpp>
+
+#include <vector>
+
+namespace raft::neighbors::ivf_flat::multi {
+
+/**
+ * @defgroup ivf_flat_multi Grouped search of many IVF-Flat indices
+ * @{
+ */
+
+/**
+ * @brief A group of IVF-Flat indices searched together.
+ *
+ * Searching many small indices (e.g. one per tenant) one by one costs several kernel launches per
+ * index, each of them too small to occupy the GPU. The group concatenates the lists and the
+ * centers of its members into one index, so that the queries of all the members are searched in
+ * a few launches: one coarse search against the centers of the own index of every query, one
+ * interleaved scan over the probed lists of all the members and one selection.
+ *
+ * The lists are shared with the member indices (not copied), while the centers are copied. The
+ * group must be made again after a member is modified (e.g. by `ivf_flat::extend`).
+ */
+template <typename T, typename IdxT>
+using index_group = detail::index_group<T, IdxT>;
+
+/**
+ * @brief Group the IVF-Flat indices for the grouped search.
+ *
+ * All the indices must have the same dimensionality and metric; the CosineExpanded metric is not
+ * supported.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors;
+ *   std::vector<const ivf_flat::index<float, int64_t>*> tenants = ...;
+ *   auto group = ivf_flat::multi::make_group(handle, tenants);
+ *   // the queries of every tenant follow those of the previous ones
+ *   ivf_flat::search_params search_params;
+ *   ivf_flat::multi::search(
+ *     handle, search_params, group, queries, n_queries_per_tenant, out_inds, out_dists);
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices in the source dataset
+ *
+ * @param[in] handle
+ * @param[in] indices the member indices (the group keeps their lists alive)
+ *
+ * @return the group
+ */
+template <typename T, typename IdxT>
+auto make_group(raft::resources const& handle,
+                const std::vector<const ivf_flat::index<T, IdxT>*>& indices)
+  -> index_group<T, IdxT>
+{
+  return detail::make_group(handle, indices);
+}
+
+/**
+ * @brief Search the k nearest neighbors of the queries of every member of the group.
+ *
+ * The queries are grouped by their index: the first `n_queries_per_index(0)` queries are searched
+ * in the first member, the next `n_queries_per_index(1)` queries in the second one and so on. The
+ * results are the same as those of `ivf_flat::search` on the member of every query (the ids are
+ * those of the member), except that `params.max_candidates` and `params.probe_distance_ratio` are
+ * ignored. A query probes at most as many lists as its index has.
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] handle
+ * @param[in] params configure the search
+ * @param[in] group the grouped indices
+ * @param[in] queries the queries of all the members [n_queries, dim]
+ * @param[in] n_queries_per_index the number of the queries of every member [group.size()]
+ * @param[out] neighbors the neighbors in the members of the queries [n_queries, k]
+ * @param[out] distances the distances to the neighbors [n_queries, k]
+ */
+template <typename T, typename IdxT>
+void search(raft::resources const& handle,
+            const ivf_flat::search_params& params,
+            const index_group<T, IdxT>& group,
+            raft::device_matrix_view<const T, IdxT, row_major> queries,
+            raft::host_vector_view<const uint32_t, uint32_t> n_queries_per_index,
+            raft::device_matrix_view<IdxT, IdxT, row_major> neighbors,
+            raft::device_matrix_view<float, IdxT, row_major> distances)
+{
+  RAFT_EXPECTS(
+    queries.extent(0) == neighbors.extent(0) && queries.extent(0) == distances.extent(0),
+    "Number of rows in output neighbors and distances matrices must equal the number of queries.");
+  RAFT_EXPECTS(neighbors.extent(1) == distances.extent(1),
+               "Number of columns in output neighbors and distances matrices must be equal");
+  RAFT_EXPECTS(queries.extent(1) == group.lists().dim(),
+               "Number of query dimensions should equal number of dimensions in the index.");
+  RAFT_EXPECTS(n_queries_per_index.extent(0) == group.size(),
+               "There must be a number of queries for every index of the group.");
+  size_t n_queries = 0;
+  for (uint32_t i = 0; i < group.size(); i++) {
+    n_queries += n_queries_per_index(i);
+  }
+  RAFT_EXPECTS(n_queries == size_t(queries.extent(0)),
+               "The numbers of queries per index must add up to the number of queries.");
+
+  detail::search(handle,
+                 params,
+                 group,
+                 queries.data_handle(),
+                 n_queries_per_index.data_handle(),
+                 static_cast<uint32_t>(neighbors.extent(1)),
+                 neighbors.data_handle(),
+                 distances.data_handle(),
+                 resource::get_workspace_resource(handle));
+}
+
+/** @} */
+
+}  // namespace raft::neighbors::ivf_flat::multi
@@ -27,6 +27,7 @@
 #include <raft/core/resource/thrust_policy.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/distance/distance_types.hpp>
+#include <raft/neighbors/ivf_list_arena.hpp>
 #include <raft/neighbors/ivf_list_types.hpp>
 #include <raft/util/integer_utils.hpp>
 
@@ -76,15 +77,56 @@ struct index_params : ann::index_params {
    * flag to `true` if you prefer to use as little GPU memory for the database as possible.
    */
   bool conservative_memory_allocation = false;
+  /**
+   * The size of the chunks of the arena holding the lists (`list_data`) of the index, in bytes.
+   *
+   * By default (zero), every list takes separate allocations from the device memory resource; with
+   * many lists, these are many small allocations, which fragment the memory. When positive, the
+   * lists are placed next to each other in a few large chunks of this size (see
+   * `ivf::list_arena`); the memory held by the reallocated lists is reclaimed by
+   * `helpers::compact`. The arena is not serialized.
+   */
+  size_t list_arena_chunk_size = 0;
 };
 
 struct search_params : ann::search_params {
-  /** The number of clusters to search. */
+  /** The number of clusters to search (the maximum number, if the adaptive probing is used). */
   uint32_t n_probes = 20;
+  /**
+   * The candidate budget of the adaptive probing.
+   *
+   * When positive, every query probes the clusters in the order of their coarse distance to the
+   * query, but stops (before reaching `n_probes`) as soon as the probed lists contain at least this
+   * many records in total. This way, the queries landing in dense clusters probe fewer lists,
+   * and the work is spent on the queries that need it. Zero (default) disables the budget.
+   */
+  uint32_t max_candidates = 0;
+  /**
+   * The coarse distance ratio of the adaptive probing (L2 metrics only).
+   *
+   * When positive, a query does not probe the clusters whose squared coarse distance to the query
+   * is larger than this factor times that of the closest cluster (the value should be greater
+   * than one). Zero (default) disables the ratio.
+   */
+  float probe_distance_ratio = 0.0f;
+};
+
+/** Placement of the lists of an index split between the device and the host (`host_lists`). */
+struct hybrid_params {
+  /**
+   * The device memory budget of the lists kept on the device (in bytes).
+   *
+   * The lists are placed on the device in the order of their probe frequencies, as long as they
+   * fit into the budget; the rest are moved to the host memory and scanned by the CPU.
+   */
+  size_t device_memory_limit = 0;
+  /** The number of CPU threads scanning the host lists (zero means the OpenMP default). */
+  uint32_t n_threads = 0;
 };
 
 static_assert(std::is_aggregate_v<index_params>);
 static_assert(std::is_aggregate_v<search_params>);
+static_assert(std::is_aggregate_v<hybrid_params>);
 
 template <typename SizeT, typename ValueT, typename IdxT>
 struct list_spec {
@@ -257,6 +299,7 @@ struct index : ann::index {
       list_sizes_{make_device_vector<uint32_t, uint32_t>(res, n_lists)},
       data_ptrs_{make_device_vector<T*, uint32_t>(res, n_lists)},
       inds_ptrs_{make_device_vector<IdxT*, uint32_t>(res, n_lists)},
+      list_capacities_{make_device_vector<uint32_t, uint32_t>(res, n_lists)},
       total_size_{0}
   {
     check_consistency();
@@ -271,6 +314,9 @@ struct index : ann::index {
             params.conservative_memory_allocation,
             dim)
   {
+    if (params.list_arena_chunk_size > 0) {
+      list_arena_ = std::make_shared<ivf::list_arena>(params.list_arena_chunk_size);
+    }
   }
 
   /** Pointers to the inverted lists (clusters) data  [n_lists]. */
@@ -289,6 +335,16 @@ struct index : ann::index {
   {
     return inds_ptrs_.view();
   }
+
+  /**
+   * Capacities of the inverted lists (clusters) [n_lists]; that is, the number of records that
+   * fit into the currently allocated lists.
+   */
+  [[nodiscard]] inline auto list_capacities() const noexcept
+    -> device_vector_view<const uint32_t, uint32_t>
+  {
+    return list_capacities_.view();
+  }
   /**
    * Whether to use convervative memory allocation when extending the list (cluster) data
    * (see index_params.conservative_memory_allocation).
@@ -298,6 +354,16 @@ struct index : ann::index {
     return conservative_memory_allocation_;
   }
 
+  /**
+   * The arena holding the lists (see index_params.list_arena_chunk_size); null if the lists are
+   * allocated separately.
+   */
+  inline auto list_arena() noexcept -> std::shared_ptr<ivf::list_arena>& { return list_arena_; }
+  [[nodiscard]] inline auto list_arena() const noexcept -> const std::shared_ptr<ivf::list_arena>&
+  {
+    return list_arena_;
+  }
+
   /**
    * Update the state of the dependent index members.
    */
@@ -310,11 +376,13 @@ struct index : ann::index {
     auto this_data_ptrs = data_ptrs();
     auto this_inds_ptrs = inds_ptrs();
     for (uint32_t label = 0; label < this_lists.size(); label++) {
-      auto& list          = this_lists[label];
-      const auto data_ptr = list ? list->data.data_handle() : nullptr;
-      const auto inds_ptr = list ? list->indices.data_handle() : nullptr;
+      auto& list              = this_lists[label];
+      const auto data_ptr     = list ? list->data.data_handle() : nullptr;
+      const auto inds_ptr     = list ? list->indices.data_handle() : nullptr;
+      const uint32_t capacity = list ? list->indices.extent(0) : 0;
       copy(&this_data_ptrs(label), &data_ptr, 1, stream);
       copy(&this_inds_ptrs(label), &inds_ptr, 1, stream);
+      copy(list_capacities_.data_handle() + label, &capacity, 1, stream);
     }
     auto this_list_sizes = list_sizes().data_handle();
     total_size_          = thrust::reduce(resource::get_thrust_policy(res),
@@ -325,6 +393,12 @@ struct index : ann::index {
     check_consistency();
   }
 
+  /**
+   * Account for the records appended to the lists without reallocating them
+   * (see `ivf_flat::helpers::extend_inplace`); the list sizes must be already up to date.
+   */
+  void increment_size(IdxT n_records) noexcept { total_size_ += n_records; }
+
   void allocate_center_norms(raft::resources const& res)
   {
     switch (metric_) {
@@ -358,6 +432,7 @@ struct index : ann::index {
   raft::distance::DistanceType metric_;
   bool adaptive_centers_;
   bool conservative_memory_allocation_;
+  std::shared_ptr<ivf::list_arena> list_arena_;
   std::vector<std::shared_ptr<list_data<T, IdxT>>> lists_;
   device_vector<uint32_t, uint32_t> list_sizes_;
   device_matrix<float, uint32_t, row_major> centers_;
@@ -366,6 +441,7 @@ struct index : ann::index {
   // Computed members
   device_vector<T*, uint32_t> data_ptrs_;
   device_vector<IdxT*, uint32_t> inds_ptrs_;
+  device_vector<uint32_t, uint32_t> list_capacities_;
   IdxT total_size_;
 
   /** Throw an error if the index content is inconsistent. */
@@ -376,6 +452,7 @@ struct index : ann::index {
     RAFT_EXPECTS(list_sizes_.extent(0) == n_lists, "inconsistent list size");
     RAFT_EXPECTS(data_ptrs_.extent(0) == n_lists, "inconsistent list size");
     RAFT_EXPECTS(inds_ptrs_.extent(0) == n_lists, "inconsistent list size");
+    RAFT_EXPECTS(list_capacities_.extent(0) == n_lists, "inconsistent list size");
     RAFT_EXPECTS(                                       //
       (centers_.extent(0) == list_sizes_.extent(0)) &&  //
         (!center_norms_.has_value() || centers_.extent(0) == center_norms_->extent(0)),
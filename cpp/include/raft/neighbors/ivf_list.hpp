@@ -17,7 +17,9 @@
 #pragma once
 
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
 #include <raft/core/resource/thrust_policy.hpp>
+#include <raft/neighbors/ivf_list_arena.hpp>
 #include <raft/neighbors/ivf_list_types.hpp>
 
 #include <raft/core/device_mdarray.hpp>
@@ -30,9 +32,12 @@
 
 #include <thrust/fill.h>
 
+#include <algorithm>
 #include <fstream>
 #include <memory>
+#include <optional>
 #include <type_traits>
+#include <vector>
 
 namespace raft::neighbors::ivf {
 
@@ -42,17 +47,25 @@ template <template <typename, typename...> typename SpecT,
           typename... SpecExtraArgs>
 list<SpecT, SizeT, SpecExtraArgs...>::list(raft::resources const& res,
                                            const spec_type& spec,
-                                           size_type n_rows)
-  : size{n_rows}, data{res}, indices{res}
+                                           size_type n_rows,
+                                           std::shared_ptr<list_arena> arena)
+  : arena{std::move(arena)}, size{n_rows}, data{res}, indices{res}
 {
   auto capacity = round_up_safe<SizeT>(n_rows, spec.align_max);
   if (n_rows < spec.align_max) {
     capacity = bound_by_power_of_two<SizeT>(std::max<SizeT>(n_rows, spec.align_min));
     capacity = std::min<SizeT>(capacity, spec.align_max);
   }
+  // The arena is plugged in as the workspace resource of a (shallow) copy of the handle
+  std::optional<raft::resources> arena_res;
+  if (this->arena) {
+    arena_res.emplace(res);
+    resource::set_workspace_resource(*arena_res, this->arena.get());
+  }
+  const raft::resources& alloc_res = arena_res.has_value() ? *arena_res : res;
   try {
-    data    = make_device_mdarray<value_type>(res, spec.make_list_extents(capacity));
-    indices = make_device_vector<index_type, SizeT>(res, capacity);
+    data    = make_device_mdarray<value_type>(alloc_res, spec.make_list_extents(capacity));
+    indices = make_device_vector<index_type, SizeT>(alloc_res, capacity);
   } catch (std::bad_alloc& e) {
     RAFT_FAIL(
       "ivf::list: failed to allocate a big enough list to hold all data "
@@ -72,13 +85,17 @@ list<SpecT, SizeT, SpecExtraArgs...>::list(raft::resources const& res,
 /**
  * Resize a list by the given id, so that it can contain the given number of records;
  * copy the data if necessary.
+ *
+ * A reallocated list is placed in the given `arena`, or in the arena of the original list if
+ * none is given.
  */
 template <typename ListT>
 void resize_list(raft::resources const& res,
                  std::shared_ptr<ListT>& orig_list,  // NOLINT
                  const typename ListT::spec_type& spec,
                  typename ListT::size_type new_used_size,
-                 typename ListT::size_type old_used_size)
+                 typename ListT::size_type old_used_size,
+                 std::shared_ptr<list_arena> arena = nullptr)
 {
   bool skip_resize = false;
   if (orig_list) {
@@ -97,7 +114,8 @@ void resize_list(raft::resources const& res,
     old_used_size = 0;
   }
   if (skip_resize) { return; }
-  auto new_list = std::make_shared<ListT>(res, spec, new_used_size);
+  if (!arena && orig_list) { arena = orig_list->arena; }
+  auto new_list = std::make_shared<ListT>(res, spec, new_used_size, std::move(arena));
   if (old_used_size > 0) {
     auto copied_data_extents = spec.make_list_extents(old_used_size);
     auto copied_view =
@@ -129,22 +147,17 @@ auto serialize_list(const raft::resources& handle,
   serialize_scalar(handle, os, size);
   if (size == 0) { return; }
 
+  // The stored extents cover the first `size` records of the device list; they are streamed
+  // straight from the device memory
   auto data_extents = store_spec.make_list_extents(size);
-  auto data_array =
-    make_host_mdarray<typename ListT::value_type, size_type, row_major>(data_extents);
-  auto inds_array = make_host_mdarray<typename ListT::index_type, size_type, row_major>(
-    make_extents<size_type>(size));
-  copy(data_array.data_handle(),
-       ld.data.data_handle(),
-       data_array.size(),
-       resource::get_cuda_stream(handle));
-  copy(inds_array.data_handle(),
-       ld.indices.data_handle(),
-       inds_array.size(),
-       resource::get_cuda_stream(handle));
-  resource::sync_stream(handle);
-  serialize_mdspan(handle, os, data_array.view());
-  serialize_mdspan(handle, os, inds_array.view());
+  serialize_mdspan(handle,
+                   os,
+                   make_mdspan<const typename ListT::value_type, size_type, row_major, false, true>(
+                     ld.data.data_handle(), data_extents));
+  serialize_mdspan(handle,
+                   os,
+                   make_mdspan<const typename ListT::index_type, size_type, row_major, false, true>(
+                     ld.indices.data_handle(), make_extents<size_type>(size)));
 }
 
 template <typename ListT>
@@ -167,28 +180,68 @@ auto deserialize_list(const raft::resources& handle,
                       std::istream& is,
                       std::shared_ptr<ListT>& ld,
                       const typename ListT::spec_type& store_spec,
-                      const typename ListT::spec_type& device_spec) -> enable_if_valid_list_t<ListT>
+                      const typename ListT::spec_type& device_spec,
+                      std::shared_ptr<list_arena> arena = nullptr) -> enable_if_valid_list_t<ListT>
 {
   using size_type = typename ListT::size_type;
   auto size       = deserialize_scalar<size_type>(handle, is);
   if (size == 0) { return ld.reset(); }
-  std::make_shared<ListT>(handle, device_spec, size).swap(ld);
+  std::make_shared<ListT>(handle, device_spec, size, std::move(arena)).swap(ld);
+  // The records are read straight into the device list.
+  // NB: reading exactly 'size' indices to leave the rest 'kInvalidRecord' intact.
   auto data_extents = store_spec.make_list_extents(size);
-  auto data_array =
-    make_host_mdarray<typename ListT::value_type, size_type, row_major>(data_extents);
-  auto inds_array = make_host_mdarray<typename ListT::index_type, size_type, row_major>(
-    make_extents<size_type>(size));
-  deserialize_mdspan(handle, is, data_array.view());
-  deserialize_mdspan(handle, is, inds_array.view());
-  copy(ld->data.data_handle(),
-       data_array.data_handle(),
-       data_array.size(),
-       resource::get_cuda_stream(handle));
-  // NB: copying exactly 'size' indices to leave the rest 'kInvalidRecord' intact.
-  copy(
-    ld->indices.data_handle(), inds_array.data_handle(), size, resource::get_cuda_stream(handle));
-  // Make sure the data is copied from host to device before the host arrays get out of the scope.
-  resource::sync_stream(handle);
+  deserialize_mdspan(handle,
+                     is,
+                     make_mdspan<typename ListT::value_type, size_type, row_major, false, true>(
+                       ld->data.data_handle(), data_extents));
+  deserialize_mdspan(handle,
+                     is,
+                     make_mdspan<typename ListT::index_type, size_type, row_major, false, true>(
+                       ld->indices.data_handle(), make_extents<size_type>(size)));
+}
+
+/**
+ * Move the lists into the `arena` (or into separate allocations if it is null), shrinking them
+ * with the given spec (normally, the conservative one); the empty lists are released.
+ *
+ * The moved lists are new ones, because the old ones may be shared with a clone of the index;
+ * the memory of old lists (and their arena) is released once they are not used anymore.
+ *
+ * @return the number of the records of the capacity freed by shrinking the lists
+ */
+template <typename ListT>
+auto compact_lists(raft::resources const& res,
+                   std::vector<std::shared_ptr<ListT>>& lists,  // NOLINT
+                   const typename ListT::spec_type& spec,
+                   std::shared_ptr<list_arena> arena) -> size_t
+{
+  using size_type = typename ListT::size_type;
+  auto stream     = resource::get_cuda_stream(res);
+  size_t n_freed  = 0;
+  for (auto& list : lists) {
+    if (!list) { continue; }
+    auto size = list->size.load();
+    if (size == 0) {
+      n_freed += list->indices.extent(0);
+      list.reset();
+      continue;
+    }
+    auto capacity = list->indices.extent(0);
+    // Without the arenas, there's nothing to do for the lists fitting their sizes already
+    if (!arena && !list->arena && capacity <= round_up_safe<size_type>(size, spec.align_max)) {
+      continue;
+    }
+    auto new_list = std::make_shared<ListT>(res, spec, size, arena);
+    // The last (interleaved) group of the records is copied whole
+    auto copied_view = make_mdspan<typename ListT::value_type, size_type, row_major, false, true>(
+      new_list->data.data_handle(),
+      spec.make_list_extents(round_up_safe<size_type>(size, spec.align_min)));
+    copy(copied_view.data_handle(), list->data.data_handle(), copied_view.size(), stream);
+    copy(new_list->indices.data_handle(), list->indices.data_handle(), size, stream);
+    n_freed += capacity - std::min(capacity, new_list->indices.extent(0));
+    list = std::move(new_list);
+  }
+  return n_freed;
 }
 
 }  // namespace raft::neighbors::ivf
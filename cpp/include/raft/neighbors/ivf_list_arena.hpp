@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <rmm/cuda_stream_view.hpp>
+#include <rmm/mr/device/device_memory_resource.hpp>
+#include <rmm/mr/device/per_device_resource.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <utility>
+
+namespace raft::neighbors::ivf {
+
+/**
+ * @brief A memory resource placing the lists (clusters) of an IVF index next to each other.
+ *
+ * By default, every list of an index takes two separate allocations from the device memory
+ * resource (the data and the indices); an index of a hundred thousand lists makes hundreds of
+ * thousands of small allocations, which are slow to make and fragment the memory. The arena takes
+ * the memory from the upstream resource in large chunks and places the lists in them one after
+ * another by bumping an offset, so that the lists of an index are made of a few contiguous
+ * blocks. The capacity slack of the lists (see `conservative_memory_allocation`) is kept, so that
+ * the lists still grow without reallocation most of the time.
+ *
+ * The memory of a freed list is not reused by the arena until all the lists of its chunk are
+ * freed; then the chunk is returned to the upstream resource. Hence, after many reallocations of
+ * the lists (e.g. repeated `extend` calls), a part of the chunks is held by the lists that no
+ * longer exist; the indices reclaim this memory by moving all their lists into a new arena (see
+ * `ivf_pq::helpers::compact` and `ivf_flat::helpers::compact`).
+ *
+ * The lists of an index are usually modified on a single stream; the chunks are returned to the
+ * upstream resource on the stream of the last deallocation in them.
+ */
+class list_arena final : public rmm::mr::device_memory_resource {
+ public:
+  /** Alignment of the allocations, in bytes (same as the other RMM resources). */
+  static constexpr size_t kAlignment = 256;
+
+  /**
+   * @param chunk_size the size of the chunks taken from the upstream resource, in bytes; a larger
+   *   allocation takes a chunk of its own.
+   * @param upstream the resource to take the chunks from (the current device resource if null);
+   *   it must outlive the arena
+   */
+  explicit list_arena(size_t chunk_size, rmm::mr::device_memory_resource* upstream = nullptr)
+    : upstream_(upstream == nullptr ? rmm::mr::get_current_device_resource() : upstream),
+      chunk_size_(std::max(align_up(chunk_size), kAlignment))
+  {
+  }
+
+  list_arena(const list_arena&)                    = delete;
+  list_arena(list_arena&&)                         = delete;
+  auto operator=(const list_arena&) -> list_arena& = delete;
+  auto operator=(list_arena&&) -> list_arena&      = delete;
+
+  ~list_arena() override
+  {
+    for (auto& [base, c] : chunks_) {
+      upstream_->deallocate(base, c.size, c.stream);
+    }
+  }
+
+  /** The size of the chunks taken from the upstream resource, in bytes. */
+  [[nodiscard]] auto chunk_size() const noexcept -> size_t { return chunk_size_; }
+  /** The number of the chunks currently held by the arena. */
+  [[nodiscard]] auto n_chunks() const -> size_t
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return chunks_.size();
+  }
+  /** The memory taken from the upstream resource, in bytes. */
+  [[nodiscard]] auto reserved_bytes() const -> size_t
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return reserved_;
+  }
+  /** The memory of the live allocations, in bytes; the rest of `reserved_bytes()` is wasted. */
+  [[nodiscard]] auto used_bytes() const -> size_t
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return used_;
+  }
+
+  [[nodiscard]] auto supports_streams() const noexcept -> bool override { return true; }
+  [[nodiscard]] auto supports_get_mem_info() const noexcept -> bool override { return false; }
+
+ private:
+  struct chunk {
+    size_t size;
+    /** The offset of the free space at the end of the chunk. */
+    size_t top;
+    /** The total size of the live allocations in the chunk. */
+    size_t used;
+    rmm::cuda_stream_view stream;
+  };
+
+  static constexpr auto align_up(size_t bytes) noexcept -> size_t
+  {
+    return (bytes + kAlignment - 1) / kAlignment * kAlignment;
+  }
+
+  auto do_allocate(size_t bytes, rmm::cuda_stream_view stream) -> void* override
+  {
+    const size_t size = align_up(bytes);
+    if (size == 0) { return nullptr; }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = chunks_.find(current_);
+    if (it == chunks_.end() || it->second.size - it->second.top < size) {
+      // The large allocations take the chunks of their own and leave the current chunk be.
+      const size_t new_size = std::max(size, chunk_size_);
+      auto* base            = static_cast<char*>(upstream_->allocate(new_size, stream));
+      it                    = chunks_.emplace(base, chunk{new_size, 0, 0, stream}).first;
+      reserved_ += new_size;
+      if (new_size == chunk_size_) { current_ = base; }
+    }
+    auto& c   = it->second;
+    void* ptr = it->first + c.top;
+    c.top += size;
+    c.used += size;
+    used_ += size;
+    return ptr;
+  }
+
+  void do_deallocate(void* ptr, size_t bytes, rmm::cuda_stream_view stream) override
+  {
+    if (ptr == nullptr) { return; }
+    const size_t size = align_up(bytes);
+    std::lock_guard<std::mutex> lock(mutex_);
+    // the chunk holding the allocation is the last one starting at or before it
+    auto it = std::prev(chunks_.upper_bound(static_cast<char*>(ptr)));
+    auto& c = it->second;
+    c.used -= size;
+    c.stream = stream;
+    used_ -= size;
+    if (c.used > 0) { return; }
+    upstream_->deallocate(it->first, c.size, stream);
+    reserved_ -= c.size;
+    if (it->first == current_) { current_ = nullptr; }
+    chunks_.erase(it);
+  }
+
+  [[nodiscard]] auto do_get_mem_info(rmm::cuda_stream_view) const
+    -> std::pair<size_t, size_t> override
+  {
+    return {0, 0};
+  }
+
+  rmm::mr::device_memory_resource* upstream_;
+  size_t chunk_size_;
+
+  mutable std::mutex mutex_;
+  std::map<char*, chunk> chunks_;
+  char* current_   = nullptr;
+  size_t reserved_ = 0;
+  size_t used_     = 0;
+};
+
+}  // namespace raft::neighbors::ivf
@@ -18,9 +18,11 @@
 
 #include <raft/core/device_mdarray.hpp>
 #include <raft/core/resources.hpp>
+#include <raft/neighbors/ivf_list_arena.hpp>
 
 #include <atomic>
 #include <limits>
+#include <memory>
 #include <type_traits>
 
 namespace raft::neighbors::ivf {
@@ -45,6 +47,11 @@ struct list {
   using index_type   = typename spec_type::index_type;
   using list_extents = typename spec_type::list_extents;
 
+  /**
+   * The arena holding the data and the indices, if any (otherwise, they are allocated separately
+   * from the workspace resource); declared first to outlive them.
+   */
+  std::shared_ptr<list_arena> arena;
   /** Possibly encoded data; it's layout is defined by `SpecT`. */
   device_mdarray<value_type, list_extents, row_major> data;
   /** Source indices. */
@@ -52,8 +59,14 @@ struct list {
   /** The actual size of the content. */
   std::atomic<size_type> size;
 
-  /** Allocate a new list capable of holding at least `n_rows` data records and indices. */
-  list(raft::resources const& res, const spec_type& spec, size_type n_rows);
+  /**
+   * Allocate a new list capable of holding at least `n_rows` data records and indices
+   * (in the `arena`, if given).
+   */
+  list(raft::resources const& res,
+       const spec_type& spec,
+       size_type n_rows,
+       std::shared_ptr<list_arena> arena = nullptr);
 };
 
 template <typename ListT, class T = void>
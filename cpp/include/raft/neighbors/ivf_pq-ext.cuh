@@ -18,7 +18,9 @@
 
 #include <cstdint>                                // int64_t
 
+#include <raft/core/device_csr_matrix.hpp>        // raft::device_csr_matrix
 #include <raft/core/device_mdspan.hpp>            // raft::device_matrix_view
+#include <raft/core/host_mdspan.hpp>              // raft::host_vector_view
 #include <raft/core/resources.hpp>                // raft::resources
 #include <raft/neighbors/ivf_pq_types.hpp>        // raft::neighbors::ivf_pq::index
 #include <raft/util/raft_explicit.hpp>            // RAFT_EXPLICIT
@@ -62,6 +64,14 @@ void search(raft::resources const& handle,
             raft::device_matrix_view<IdxT, uint32_t, row_major> neighbors,
             raft::device_matrix_view<float, uint32_t, row_major> distances) RAFT_EXPLICIT;
 
+template <typename T, typename IdxT>
+void search(raft::resources const& handle,
+            const search_params& params,
+            const index<IdxT>& idx,
+            raft::device_matrix_view<const T, uint32_t, row_major> queries,
+            raft::host_vector_view<const uint32_t, uint32_t> k,
+            raft::device_csr_matrix<float, int64_t, IdxT, int64_t>& out) RAFT_EXPLICIT;
+
 template <typename T, typename IdxT = uint32_t>
 auto build(raft::resources const& handle,
            const index_params& params,
@@ -182,7 +192,15 @@ instantiate_raft_neighbors_ivf_pq_extend(uint8_t, int64_t);
     uint32_t k,                                                      \
     IdxT* neighbors,                                                 \
     float* distances,                                                \
-    rmm::mr::device_memory_resource* mr)
+    rmm::mr::device_memory_resource* mr);                            \
+                                                                     \
+  extern template void raft::neighbors::ivf_pq::search<T, IdxT>(     \
+    raft::resources const& handle,                                   \
+    const raft::neighbors::ivf_pq::search_params& params,            \
+    const raft::neighbors::ivf_pq::index<IdxT>& idx,                 \
+    raft::device_matrix_view<const T, uint32_t, row_major> queries,  \
+    raft::host_vector_view<const uint32_t, uint32_t> k,              \
+    raft::device_csr_matrix<float, int64_t, IdxT, int64_t>& out);
 
 instantiate_raft_neighbors_ivf_pq_search(float, int64_t);
 instantiate_raft_neighbors_ivf_pq_search(int8_t, int64_t);
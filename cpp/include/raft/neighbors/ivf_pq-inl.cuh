@@ -19,6 +19,7 @@
 #include <raft/core/resource/device_memory_resource.hpp>
 #include <raft/neighbors/detail/ivf_pq_build.cuh>
 #include <raft/neighbors/detail/ivf_pq_search.cuh>
+#include <raft/neighbors/detail/ragged_search.cuh>
 #include <raft/neighbors/ivf_pq_serialize.cuh>
 #include <raft/neighbors/ivf_pq_types.hpp>
 
@@ -42,6 +43,7 @@ namespace raft::neighbors::ivf_pq {
  * - L2Expanded
  * - L2Unexpanded
  * - InnerProduct
+ * - CosineExpanded (the data and the queries are normalized internally)
  *
  * @tparam T data element type
  * @tparam IdxT type of the indices in the source dataset
@@ -62,6 +64,46 @@ index<IdxT> build(raft::resources const& handle,
   return detail::build(handle, params, dataset.data_handle(), n_rows, dim);
 }
 
+/**
+ * @brief Build the index from a dataset distributed across multiple GPUs.
+ *
+ * Every rank of the communicator attached to the handle passes its own shard of the dataset. The
+ * cluster centers are trained by the balanced k-means over all shards (initialized on the shard
+ * of the root rank), and the PQ codebooks are split among the ranks and trained in parallel.
+ * As a result, every rank gets an index with the same cluster centers, rotation and codebooks,
+ * which contains the records of the local shard only (if `params.add_data_on_build`). The source
+ * indices of the records are global: the rows of the shard of rank `r` are numbered after all
+ * rows of the ranks `0..r-1`.
+ *
+ * The per-rank indices can be searched independently and their results merged.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   raft::resources handle;  // with a communicator injected, e.g. via raft-dask or std_comms
+ *   ivf_pq::index_params index_params;
+ *   // every rank builds the index over its local shard
+ *   auto index = ivf_pq::build_mg(handle, index_params, local_dataset);
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices in the source dataset
+ *
+ * @param[in] handle a handle with an initialized communicator
+ * @param[in] params configure the index building; must be the same on all ranks
+ * @param[in] dataset a device matrix view to the local shard [n_local_rows, dim]
+ *
+ * @return the ivf-pq index over the local shard
+ */
+template <typename T, typename IdxT = uint32_t>
+index<IdxT> build_mg(raft::resources const& handle,
+                     const index_params& params,
+                     raft::device_matrix_view<const T, IdxT, row_major> dataset)
+{
+  IdxT n_rows = dataset.extent(0);
+  IdxT dim    = dataset.extent(1);
+  return detail::build_mg(handle, params, dataset.data_handle(), n_rows, dim);
+}
+
 /**
  * @brief Extend the index with the new data.
  * *
@@ -145,6 +187,14 @@ void extend(raft::resources const& handle,
  * detail. However, you can safely specify a small initial size for the memory pool, so that only a
  * few allocations happen to grow it during the first invocations of the `search`.
  *
+ * If the handle has a stream pool (see `raft::resource::set_cuda_stream_pool`), the large query
+ * sets are searched in batches pipelined over up to two streams of the pool; the queries and
+ * results in the pinned/managed host memory are transferred in the same pipeline.
+ *
+ * With a deadline (`params.deadline`), the search waits for every chunk of 4096 queries before
+ * starting the next one; once the deadline expires, the remaining chunks probe the closest cluster
+ * of every query only.
+ *
  * @tparam T data element type
  * @tparam IdxT type of the indices
  *
@@ -203,6 +253,14 @@ void search_with_filtering(raft::resources const& handle,
  * detail. However, you can safely specify a small initial size for the memory pool, so that only a
  * few allocations happen to grow it during the first invocations of the `search`.
  *
+ * If the handle has a stream pool (see `raft::resource::set_cuda_stream_pool`), the large query
+ * sets are searched in batches pipelined over up to two streams of the pool; the queries and
+ * results in the pinned/managed host memory are transferred in the same pipeline.
+ *
+ * With a deadline (`params.deadline`), the search waits for every chunk of 4096 queries before
+ * starting the next one; once the deadline expires, the remaining chunks probe the closest cluster
+ * of every query only.
+ *
  * @tparam T data element type
  * @tparam IdxT type of the indices
  *
@@ -232,6 +290,121 @@ void search(raft::resources const& handle,
                         raft::neighbors::filtering::none_ivf_sample_filter());
 }
 
+/**
+ * @brief Search ANN with a different number of neighbors per query.
+ *
+ * The neighbors are returned as a CSR matrix [n_queries, idx.size()]: the row `i` holds the `k[i]`
+ * neighbors of the query `i` and the distances to them, sorted as by `search`. The queries are
+ * searched in buckets of a similar k (within a factor of two), so a batch mixing small and large k
+ * keeps its batching while the top-k selection of the small-k queries is not sized for the largest
+ * k of the batch.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors;
+ *   auto index = ivf_pq::build(handle, index_params, dataset);
+ *   ivf_pq::search_params search_params;
+ *   auto k = raft::make_host_vector<uint32_t, uint32_t>(queries.extent(0));
+ *   ...
+ *   auto out = raft::make_device_csr_matrix<float, int64_t, int64_t, int64_t>(
+ *     handle, queries.extent(0), index.size());
+ *   ivf_pq::search(handle, search_params, index, queries, raft::make_const_mdspan(k.view()), out);
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] handle
+ * @param[in] params configure the search
+ * @param[in] idx ivf-pq constructed index
+ * @param[in] queries a device matrix view to a row-major matrix [n_queries, index->dim()]
+ * @param[in] k the number of neighbors to find for every query [n_queries]
+ * @param[out] out a CSR matrix [n_queries, idx.size()]; its sparsity is initialized with `sum(k)`
+ */
+template <typename T, typename IdxT>
+void search(raft::resources const& handle,
+            const search_params& params,
+            const index<IdxT>& idx,
+            raft::device_matrix_view<const T, uint32_t, row_major> queries,
+            raft::host_vector_view<const uint32_t, uint32_t> k,
+            raft::device_csr_matrix<float, int64_t, IdxT, int64_t>& out)
+{
+  RAFT_EXPECTS(queries.extent(1) == idx.dim(),
+               "Number of query dimensions should equal number of dimensions in the index.");
+  RAFT_EXPECTS(out.structure_view().get_n_cols() == idx.size(),
+               "The output must be a CSR matrix of shape [n_queries, idx.size()]");
+  raft::neighbors::detail::search_ragged(
+    handle, queries, k, out, [&](auto bucket_queries, auto neighbors, auto distances) {
+      search(handle, params, idx, bucket_queries, neighbors, distances);
+    });
+}
+
+/**
+ * @brief Search ANN using an index whose lists are kept in the host memory.
+ *
+ * The lists of the index are moved out of the device memory by constructing a `list_cache`; the
+ * search then copies the probed lists to the device cache on demand, overlapping the copies with
+ * the similarity computation. The queries are split into batches whose probed lists fit in the
+ * cache, hence `params.n_probes` must not exceed `cache.capacity()`.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   // build the index on the device
+ *   auto index = ivf_pq::build(handle, index_params, dataset);
+ *   // move the lists to a file, keep up to 512 lists on the device
+ *   ivf_pq::offload_params offload;
+ *   offload.storage     = ivf_pq::list_storage::MAPPED_FILE;
+ *   offload.file_path   = "/local/ssd/lists.bin";
+ *   offload.cache_lists = 512;
+ *   ivf_pq::list_cache<int64_t> cache(handle, offload, index);
+ *   ivf_pq::search(handle, search_params, index, cache, queries, neighbors, distances);
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] handle
+ * @param[in] params configure the search
+ * @param[in] idx ivf-pq constructed index, with the lists offloaded to `cache`
+ * @param[inout] cache the host storage of the lists of `idx` and their device cache
+ * @param[in] queries a device matrix view to a row-major matrix [n_queries, index->dim()]
+ * @param[out] neighbors a device matrix view to the indices of the neighbors in the source dataset
+ * [n_queries, k]
+ * @param[out] distances a device matrix view to the distances to the selected neighbors [n_queries,
+ * k]
+ */
+template <typename T, typename IdxT>
+void search(raft::resources const& handle,
+            const search_params& params,
+            const index<IdxT>& idx,
+            list_cache<IdxT>& cache,
+            raft::device_matrix_view<const T, uint32_t, row_major> queries,
+            raft::device_matrix_view<IdxT, uint32_t, row_major> neighbors,
+            raft::device_matrix_view<float, uint32_t, row_major> distances)
+{
+  RAFT_EXPECTS(
+    queries.extent(0) == neighbors.extent(0) && queries.extent(0) == distances.extent(0),
+    "Number of rows in output neighbors and distances matrices must equal the number of queries.");
+
+  RAFT_EXPECTS(neighbors.extent(1) == distances.extent(1),
+               "Number of columns in output neighbors and distances matrices must equal k");
+
+  RAFT_EXPECTS(queries.extent(1) == idx.dim(),
+               "Number of query dimensions should equal number of dimensions in the index.");
+
+  detail::search(handle,
+                 params,
+                 idx,
+                 queries.data_handle(),
+                 queries.extent(0),
+                 neighbors.extent(1),
+                 neighbors.data_handle(),
+                 distances.data_handle(),
+                 resource::get_workspace_resource(handle),
+                 raft::neighbors::filtering::none_ivf_sample_filter(),
+                 &cache);
+}
+
 /** @} */  // end group ivf_pq
 
 /**
@@ -241,6 +414,7 @@ void search(raft::resources const& handle,
  * - L2Expanded
  * - L2Unexpanded
  * - InnerProduct
+ * - CosineExpanded (the data and the queries are normalized internally)
  *
  * Usage example:
  * @code{.cpp}
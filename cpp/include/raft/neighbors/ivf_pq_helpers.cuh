@@ -18,9 +18,11 @@
 
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/neighbors/detail/ivf_pq_build.cuh>
+#include <raft/neighbors/detail/ivf_pq_search.cuh>
 #include <raft/neighbors/ivf_pq_types.hpp>
 
 #include <raft/core/device_mdspan.hpp>
+#include <raft/core/memory_estimate.hpp>
 #include <raft/core/resources.hpp>
 
 namespace raft::neighbors::ivf_pq::helpers {
@@ -311,6 +313,9 @@ void reconstruct_list_data(raft::resources const& res,
  * @brief Extend one list of the index in-place, by the list label, skipping the classification and
  * encoding steps.
  *
+ * NB: not supported by the indices with the residual PQ layer (`index.residual_pq_bits() > 0`),
+ * whose records cannot be restored from their first-layer codes alone.
+ *
  * Usage example:
  * @code{.cpp}
  *   // We will extend the fourth cluster
@@ -407,5 +412,157 @@ void erase_list(raft::resources const& res, index<IdxT>* index, uint32_t label)
   ivf_pq::detail::erase_list(res, index, label);
 }
 
+/**
+ * @brief Remove the records with the given source indices from the index in-place.
+ *
+ * Only the lists containing the removed records are rewritten; they are compacted, so that the
+ * list sizes (and thus the search cost) shrink along with the index. The cluster centers and the
+ * codebooks are not updated. The source indices that are not in the index are ignored; if the
+ * same source index occurs in the index multiple times, all its occurrences are removed.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   // remove the records 10 and 42
+ *   std::vector<int64_t> ids_host{10, 42};
+ *   auto ids = raft::make_device_vector<int64_t, int64_t>(res, ids_host.size());
+ *   raft::copy(ids.data_handle(), ids_host.data(), ids_host.size(), stream);
+ *   auto n_removed = ivf_pq::helpers::remove(res, raft::make_const_mdspan(ids.view()), &index);
+ * @endcode
+ *
+ * @tparam IdxT
+ * @param[in] res
+ * @param[in] ids the source indices of the records to remove [n_ids]
+ * @param[inout] index
+ * @return the number of removed records
+ */
+template <typename IdxT>
+auto remove(raft::resources const& res,
+            raft::device_vector_view<const IdxT, IdxT> ids,
+            index<IdxT>* index) -> IdxT
+{
+  return ivf_pq::detail::remove(res, ids, index);
+}
+
+/**
+ * @brief Shrink the lists of the index in-place to fit their sizes.
+ *
+ * After many calls to `extend`, the lists may hold a lot of unused space (unless the index uses
+ * the conservative memory allocation). This function reallocates every such list with the
+ * smallest capacity fitting its records and returns the unused memory. If the lists are kept in
+ * an arena (see `index_params::list_arena_chunk_size`), all of them are moved into a new arena,
+ * which also returns the memory left in the chunks by the reallocated lists. The lists shared with
+ * the clones of the index are copied, not modified. The content of the index does not change.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   ivf_pq::extend(res, new_vectors, new_indices, &index);
+ *   // return the unused space of the lists
+ *   ivf_pq::helpers::compact(res, &index);
+ * @endcode
+ *
+ * @tparam IdxT
+ * @param[in] res
+ * @param[inout] index
+ */
+template <typename IdxT>
+void compact(raft::resources const& res, index<IdxT>* index)
+{
+  ivf_pq::detail::compact(res, index);
+}
+
+/**
+ * @brief Split the overloaded lists (clusters) of the index in-place and shrink all lists to fit
+ * their sizes.
+ *
+ * After heavy `extend`s with data following a different distribution than the training set, some
+ * lists may grow much larger than the others, which slows down the search. Every list larger
+ * than `max_list_size_ratio` times the average list size is split into the parts of about the
+ * average size: its records are decoded, clustered with a local balanced k-means, and re-encoded
+ * into the lists of the new clusters. The first part keeps the label of the split list; the rest
+ * are appended after the existing lists, so `index.n_lists()` grows. The new lists reuse the
+ * codebook of the split list (`codebook_gen::PER_CLUSTER`). Finally, the index is compacted (see
+ * `compact`).
+ *
+ * NB: the split records are re-encoded from their decoded (approximate) values, which adds to
+ * their quantization error.
+ Not supported by the indices with the residual PQ layer
+ * (`index.residual_pq_bits() > 0`).
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   ivf_pq::extend(res, new_vectors, new_indices, &index);
+ *   // split the lists holding more than twice the average number of records
+ *   ivf_pq::helpers::rebalance(res, &index, 2.0);
+ * @endcode
+ *
+ * @tparam IdxT
+ * @param[in] res
+ * @param[inout] index
+ * @param[in] max_list_size_ratio the lists larger than this times the average list size are split;
+ *   must be greater than one.
+ * @param[in] kmeans_n_iters the number of iterations of the k-means splitting a list.
+ */
+template <typename IdxT>
+void rebalance(raft::resources const& res,
+               index<IdxT>* index,
+               double max_list_size_ratio = 2.0,
+               uint32_t kmeans_n_iters    = 20)
+{
+  ivf_pq::detail::rebalance(res, index, max_list_size_ratio, kmeans_n_iters);
+}
+
+/**
+ * @brief Estimate the memory `ivf_pq::build` needs for a dataset of the given size.
+ *
+ * The result is the index (the lists are assumed to be balanced); the workspace is the peak of
+ * the temporary buffers of the training and of the encoding of the dataset. The estimate follows
+ * the batching heuristics of the build and assumes the dataset is in the device memory.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   ivf_pq::index_params index_params;
+ *   auto est = ivf_pq::helpers::estimate_build_memory<float, int64_t>(index_params, n_rows, dim);
+ *   if (est.device_peak() > free_bytes) { index_params.kmeans_trainset_fraction /= 2; }
+ * @endcode
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices in the source dataset
+ * @param[in] params configure the index building
+ * @param[in] n_rows the number of the vectors of the dataset
+ * @param[in] dim the dimensionality of the dataset
+ * @return the estimated memory, in bytes
+ */
+template <typename T, typename IdxT>
+auto estimate_build_memory(const index_params& params, IdxT n_rows, uint32_t dim)
+  -> raft::memory_estimate
+{
+  return ivf_pq::detail::estimate_build_memory<T, IdxT>(params, n_rows, dim);
+}
+
+/**
+ * @brief Estimate the memory `ivf_pq::search` needs for the given number of queries.
+ *
+ * The estimate follows the batching of the search (`get_max_batch_size`) for this index; the
+ * outputs passed by the caller are not counted.
+ *
+ * @tparam IdxT type of the indices
+ * @param[in] params configure the search
+ * @param[in] index ivf-pq constructed index
+ * @param[in] n_queries the number of the queries
+ * @param[in] k the number of the neighbors to find for each query
+ * @return the estimated memory, in bytes
+ */
+template <typename IdxT>
+auto estimate_search_memory(const search_params& params,
+                            const index<IdxT>& index,
+                            uint32_t n_queries,
+                            uint32_t k) -> raft::memory_estimate
+{
+  raft::memory_estimate estimate;
+  estimate.device_workspace =
+    ivf_pq::detail::estimate_search_workspace(params, index, n_queries, k);
+  return estimate;
+}
+
 /** @} */
 }  // namespace raft::neighbors::ivf_pq::helpers
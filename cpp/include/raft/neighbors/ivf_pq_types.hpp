@@ -17,6 +17,7 @@
 #pragma once
 
 #include <raft/neighbors/ann_types.hpp>
+#include <raft/neighbors/ivf_list_arena.hpp>
 #include <raft/neighbors/ivf_list_types.hpp>
 
 #include <raft/core/device_mdarray.hpp>
@@ -25,11 +26,13 @@
 #include <raft/core/mdspan_types.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/distance/distance_types.hpp>
+#include <raft/util/block_cache.hpp>
 #include <raft/util/integer_utils.hpp>
 
 #include <thrust/fill.h>
 
 #include <memory>
+#include <string>
 #include <type_traits>
 
 namespace raft::neighbors::ivf_pq {
@@ -95,6 +98,18 @@ struct index_params : ann::index_params {
    * regardless of the values of `dim` and `pq_dim`.
    */
   bool force_random_rotation = false;
+  /**
+   * The number of iterations of the optimized product quantization (OPQ) used to learn the
+   * rotation matrix.
+   *
+   * When positive, the rotation matrix (identity or random, see `force_random_rotation`) is refined
+   * by alternating the training of the PQ codebooks on the rotated residuals of the trainset with
+   * solving the orthogonal Procrustes problem for the rotation. A learned rotation reduces the
+   * quantization error, which improves the recall at the same `pq_dim` and `pq_bits` (or allows
+   * smaller codes at the same recall); the cost is a longer index build. A few (e.g. 5-10)
+   * iterations are normally enough. By default (zero), the rotation is not learned.
+   */
+  uint32_t opq_n_iters = 0;
   /**
    * By default, the algorithm allocates more space than necessary for individual clusters
    * (`list_data`). This allows to amortize the cost of memory allocation and reduce the number of
@@ -105,10 +120,34 @@ struct index_params : ann::index_params {
    * flag to `true` if you prefer to use as little GPU memory for the database as possible.
    */
   bool conservative_memory_allocation = false;
+  /**
+   * The size of the chunks of the arena holding the lists (`list_data`) of the index, in bytes.
+   *
+   * By default (zero), every list takes separate allocations from the device memory resource; with
+   * many lists, these are many small allocations, which fragment the memory. When positive, the
+   * lists are placed next to each other in a few large chunks of this size (see
+   * `ivf::list_arena`); the memory held by the reallocated lists is reclaimed by
+   * `helpers::compact`. The arena is not serialized.
+   */
+  size_t list_arena_chunk_size = 0;
+  /**
+   * The bit length of the codes of the optional second (residual) PQ layer.
+   *
+   * Possible values: [0, 4, 5, 6, 7, 8]; `pq_dim * residual_pq_bits` must be a multiple of 8.
+   *
+   * When positive, every record gets a second PQ code of `pq_dim` components, which encodes the
+   * error of its first-layer reconstruction (the residual of the residual) with a separate codebook
+   * per subspace trained on these errors. The search re-ranks the best candidates of the first
+   * layer by their distances to the reconstruction with both layers (see
+   * `search_params::residual_rerank_ratio`); this gets the recall close to that of `refine`
+   * without keeping the raw dataset, at the cost of `pq_dim * residual_pq_bits / 8` more bytes per
+   * record. By default (zero), the index has a single layer.
+   */
+  uint32_t residual_pq_bits = 0;
 };
 
 struct search_params : ann::search_params {
-  /** The number of clusters to search. */
+  /** The number of clusters to search (the maximum number, if the adaptive probing is used). */
   uint32_t n_probes = 20;
   /**
    * Data type of look up table to be created dynamically at search time.
@@ -144,11 +183,61 @@ struct search_params : ann::search_params {
    * performance if tweaked incorrectly.
    */
   double preferred_shmem_carveout = 1.0;
+  /**
+   * The candidate budget of the adaptive probing.
+   *
+   * When positive, every query probes the clusters in the order of their coarse distance to the
+   * query, but stops (before reaching `n_probes`) as soon as the probed lists contain at least this
+   * many records in total. This way, the queries landing in dense clusters probe fewer lists,
+   * and the work is spent on the queries that need it. Zero (default) disables the budget.
+   */
+  uint32_t max_candidates = 0;
+  /**
+   * The coarse distance ratio of the adaptive probing (L2 metrics only).
+   *
+   * When positive, a query does not probe the clusters whose squared coarse distance to the query
+   * is larger than this factor times that of the closest cluster (the value should be greater
+   * than one). Zero (default) disables the ratio.
+   */
+  float probe_distance_ratio = 0.0f;
+  /**
+   * The re-ranking ratio of the indices with the residual PQ layer (see
+   * `index_params::residual_pq_bits`); ignored by the single-layer indices.
+   *
+   * The first layer selects `k * residual_rerank_ratio` candidates per query, which are scored
+   * again with both layers; the best `k` of them are returned. Zero disables the re-ranking.
+   */
+  uint32_t residual_rerank_ratio = 2;
 };
 
 static_assert(std::is_aggregate_v<index_params>);
 static_assert(std::is_aggregate_v<search_params>);
 
+/** Where the inverted lists of an index offloaded to an `ivf_pq::list_cache` are stored. */
+enum class list_storage {
+  /** Page-locked host memory. */
+  PINNED_HOST = 0,
+  /** A file mapped to the host memory; the OS pages the lists in and out as needed. */
+  MAPPED_FILE = 1,
+};
+
+struct offload_params {
+  /** The storage of the offloaded lists. */
+  list_storage storage = list_storage::PINNED_HOST;
+  /** The file the lists are written to (`MAPPED_FILE` only); it is overwritten. */
+  std::string file_path;
+  /**
+   * The number of lists the device cache holds (capped by the number of lists in the index).
+   *
+   * The search processes the queries in batches probing at most that many distinct lists, so it
+   * must be at least `search_params::n_probes`; a larger cache allows for larger batches and
+   * fewer copies.
+   */
+  uint32_t cache_lists = 1024;
+  /** The choice of the list evicted from the device cache when a probed list is missing. */
+  raft::cache::replacement_policy cache_policy = raft::cache::replacement_policy::LRU;
+};
+
 /** Size of the interleaved group. */
 constexpr static uint32_t kIndexGroupSize = 32;
 /** Stride of the interleaved group for vectorized loads. */
@@ -255,6 +344,13 @@ using list_data = ivf::list<list_spec, SizeT, IdxT>;
  * In either case, the centroids are again found using k-means clustering interpreting the data as
  * having pq_len dimensions.
  *
+ * Optionally (see `index_params::residual_pq_bits`), the error of this reconstruction is encoded
+ * by one more product quantizer with the same subspaces and a codebook per subspace:
+ *
+ * y = Q_1(y) + Q_2(y - Q_1(y)) + Q_3(y - Q_1(y) - Q_2(y - Q_1(y)))
+ *
+ * The search uses the third level to re-rank the best candidates found with the first two.
+ *
  * [1] Product quantization for nearest neighbor search Herve Jegou, Matthijs Douze, Cordelia Schmid
  *
  * @tparam IdxT type of the indices in the source dataset
@@ -313,6 +409,16 @@ struct index : ann::index {
   {
     return codebook_kind_;
   }
+  /** The bit length of the codes of the residual PQ layer; zero if the index has no such layer. */
+  [[nodiscard]] constexpr inline auto residual_pq_bits() const noexcept -> uint32_t
+  {
+    return residual_pq_bits_;
+  }
+  /** The number of vectors in the residual PQ codebook (zero if there is no residual layer). */
+  [[nodiscard]] constexpr inline auto residual_pq_book_size() const noexcept -> uint32_t
+  {
+    return residual_pq_bits() > 0 ? 1 << residual_pq_bits() : 0;
+  }
   /** Number of clusters/inverted lists (first level quantization). */
   [[nodiscard]] constexpr inline auto n_lists() const noexcept -> uint32_t { return lists_.size(); }
   /**
@@ -339,7 +445,8 @@ struct index : ann::index {
         uint32_t dim,
         uint32_t pq_bits                    = 8,
         uint32_t pq_dim                     = 0,
-        bool conservative_memory_allocation = false)
+        bool conservative_memory_allocation = false,
+        uint32_t residual_pq_bits           = 0)
     : ann::index(),
       metric_(metric),
       codebook_kind_(codebook_kind),
@@ -347,6 +454,7 @@ struct index : ann::index {
       pq_bits_(pq_bits),
       pq_dim_(pq_dim == 0 ? calculate_pq_dim(dim) : pq_dim),
       conservative_memory_allocation_(conservative_memory_allocation),
+      residual_pq_bits_(residual_pq_bits),
       pq_centers_{make_device_mdarray<float>(handle, make_pq_centers_extents())},
       lists_{n_lists},
       rotation_matrix_{make_device_matrix<float, uint32_t>(handle, this->rot_dim(), this->dim())},
@@ -355,7 +463,12 @@ struct index : ann::index {
       centers_rot_{make_device_matrix<float, uint32_t>(handle, n_lists, this->rot_dim())},
       data_ptrs_{make_device_vector<uint8_t*, uint32_t>(handle, n_lists)},
       inds_ptrs_{make_device_vector<IdxT*, uint32_t>(handle, n_lists)},
-      accum_sorted_sizes_{make_host_vector<IdxT, uint32_t>(n_lists + 1)}
+      accum_sorted_sizes_{make_host_vector<IdxT, uint32_t>(n_lists + 1)},
+      residual_lists_{residual_pq_bits > 0 ? n_lists : 0},
+      residual_pq_centers_{make_device_mdarray<float>(
+        handle, make_extents<uint32_t>(pq_dim_, pq_len(), residual_pq_book_size()))},
+      residual_data_ptrs_{
+        make_device_vector<uint8_t*, uint32_t>(handle, residual_pq_bits > 0 ? n_lists : 0)}
   {
     check_consistency();
     accum_sorted_sizes_(n_lists) = 0;
@@ -370,8 +483,12 @@ struct index : ann::index {
             dim,
             params.pq_bits,
             params.pq_dim,
-            params.conservative_memory_allocation)
+            params.conservative_memory_allocation,
+            params.residual_pq_bits)
   {
+    if (params.list_arena_chunk_size > 0) {
+      list_arena_ = std::make_shared<ivf::list_arena>(params.list_arena_chunk_size);
+    }
   }
 
   using pq_centers_extents =
@@ -400,6 +517,16 @@ struct index : ann::index {
     return lists_;
   }
 
+  /**
+   * The arena holding the lists (see index_params.list_arena_chunk_size); null if the lists are
+   * allocated separately.
+   */
+  inline auto list_arena() noexcept -> std::shared_ptr<ivf::list_arena>& { return list_arena_; }
+  [[nodiscard]] inline auto list_arena() const noexcept -> const std::shared_ptr<ivf::list_arena>&
+  {
+    return list_arena_;
+  }
+
   /** Pointers to the inverted lists (clusters) data  [n_lists]. */
   inline auto data_ptrs() noexcept -> device_vector_view<uint8_t*, uint32_t, row_major>
   {
@@ -487,6 +614,66 @@ struct index : ann::index {
     return centers_rot_.view();
   }
 
+  /**
+   * The codebook of the residual PQ layer [pq_dim, pq_len, residual_pq_book_size]; it encodes the
+   * subspaces of the first-layer reconstruction errors.
+   */
+  inline auto residual_pq_centers() noexcept
+    -> device_mdspan<float, pq_centers_extents, row_major>
+  {
+    return residual_pq_centers_.view();
+  }
+  [[nodiscard]] inline auto residual_pq_centers() const noexcept
+    -> device_mdspan<const float, pq_centers_extents, row_major>
+  {
+    return residual_pq_centers_.view();
+  }
+
+  /**
+   * The residual codes of the lists [n_lists] (empty if there is no residual layer).
+   *
+   * The residual list of a cluster has the same size as its list and the same layout (with
+   * `residual_pq_bits` instead of `pq_bits`); the record at a position of the list has its residual
+   * code at the same position of the residual list. The indices of the residual lists are unused.
+   */
+  inline auto residual_lists() noexcept -> std::vector<std::shared_ptr<list_data<IdxT>>>&
+  {
+    return residual_lists_;
+  }
+  [[nodiscard]] inline auto residual_lists() const noexcept
+    -> const std::vector<std::shared_ptr<list_data<IdxT>>>&
+  {
+    return residual_lists_;
+  }
+
+  /** Pointers to the residual codes of the lists [n_lists] (empty without the residual layer). */
+  inline auto residual_data_ptrs() noexcept -> device_vector_view<uint8_t*, uint32_t, row_major>
+  {
+    return residual_data_ptrs_.view();
+  }
+  [[nodiscard]] inline auto residual_data_ptrs() const noexcept
+    -> device_vector_view<const uint8_t* const, uint32_t, row_major>
+  {
+    return make_mdspan<const uint8_t* const, uint32_t, row_major, false, true>(
+      residual_data_ptrs_.data_handle(), residual_data_ptrs_.extents());
+  }
+
+  /** The `pq_dim` an index of the dimensionality `dim` gets when `index_params::pq_dim == 0`. */
+  static inline auto calculate_pq_dim(uint32_t dim) -> uint32_t
+  {
+    // If the dimensionality is large enough, we can reduce it to improve performance
+    if (dim >= 128) { dim /= 2; }
+    // Round it down to 32 to improve performance.
+    auto r = raft::round_down_safe<uint32_t>(dim, 32);
+    if (r > 0) return r;
+    // If the dimensionality is really low, round it to the closest power-of-two
+    r = 1;
+    while ((r << 1) <= dim) {
+      r = r << 1;
+    }
+    return r;
+  }
+
  private:
   raft::distance::DistanceType metric_;
   codebook_gen codebook_kind_;
@@ -494,8 +681,10 @@ struct index : ann::index {
   uint32_t pq_bits_;
   uint32_t pq_dim_;
   bool conservative_memory_allocation_;
+  uint32_t residual_pq_bits_;
 
   // Primary data members
+  std::shared_ptr<ivf::list_arena> list_arena_;
   std::vector<std::shared_ptr<list_data<IdxT>>> lists_;
   device_vector<uint32_t, uint32_t, row_major> list_sizes_;
   device_mdarray<float, pq_centers_extents, row_major> pq_centers_;
@@ -508,6 +697,11 @@ struct index : ann::index {
   device_vector<IdxT*, uint32_t, row_major> inds_ptrs_;
   host_vector<IdxT, uint32_t, row_major> accum_sorted_sizes_;
 
+  // The optional residual PQ layer
+  std::vector<std::shared_ptr<list_data<IdxT>>> residual_lists_;
+  device_mdarray<float, pq_centers_extents, row_major> residual_pq_centers_;
+  device_vector<uint8_t*, uint32_t, row_major> residual_data_ptrs_;
+
   /** Throw an error if the index content is inconsistent. */
   void check_consistency()
   {
@@ -519,6 +713,14 @@ struct index : ann::index {
                  pq_bits(),
                  pq_dim(),
                  pq_bits() * pq_dim());
+    RAFT_EXPECTS(residual_pq_bits() == 0 || (residual_pq_bits() >= 4 && residual_pq_bits() <= 8),
+                 "`residual_pq_bits` must be zero or within closed range [4,8], but got %u.",
+                 residual_pq_bits());
+    RAFT_EXPECTS((residual_pq_bits() * pq_dim()) % 8 == 0,
+                 "`residual_pq_bits * pq_dim` must be a multiple of 8, but got %u * %u = %u.",
+                 residual_pq_bits(),
+                 pq_dim(),
+                 residual_pq_bits() * pq_dim());
   }
 
   auto make_pq_centers_extents() -> pq_centers_extents
@@ -532,20 +734,6 @@ struct index : ann::index {
     }
   }
 
-  static inline auto calculate_pq_dim(uint32_t dim) -> uint32_t
-  {
-    // If the dimensionality is large enough, we can reduce it to improve performance
-    if (dim >= 128) { dim /= 2; }
-    // Round it down to 32 to improve performance.
-    auto r = raft::round_down_safe<uint32_t>(dim, 32);
-    if (r > 0) return r;
-    // If the dimensionality is really low, round it to the closest power-of-two
-    r = 1;
-    while ((r << 1) <= dim) {
-      r = r << 1;
-    }
-    return r;
-  }
 };
 
 /** @} */
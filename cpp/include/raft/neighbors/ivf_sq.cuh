@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "detail/ivf_sq_build.cuh"
+#include "detail/ivf_sq_search.cuh"
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/neighbors/ivf_sq_types.hpp>
+
+#include <optional>
+
+namespace raft::neighbors::ivf_sq {
+
+/**
+ * @defgroup ivf_sq IVF-SQ Algorithm
+ * @{
+ */
+
+/**
+ * @brief Build the index from the dataset for efficient search.
+ *
+ * The dataset is clustered by the balanced k-means, and every dimension is scalar-quantized to the
+ * type `CodeT` (`int8_t` or `half`) within the range observed in the training subset.
+ *
+ * NB: Currently, the following distance metrics are supported:
+ * - L2Expanded
+ * - L2SqrtExpanded
+ * - InnerProduct
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors;
+ *   // use default index parameters
+ *   ivf_sq::index_params index_params;
+ *   // create and fill the index of the int8 codes from a [N, D] dataset
+ *   auto index = ivf_sq::build<int8_t>(handle, index_params, dataset);
+ *   // use default search parameters
+ *   ivf_sq::search_params search_params;
+ *   // search K nearest neighbours for each of the N queries
+ *   ivf_sq::search(handle, search_params, index, queries, out_inds, out_dists);
+ * @endcode
+ *
+ * @tparam CodeT the type of the codes (`int8_t` or `half`)
+ * @tparam IdxT type of the indices in the source dataset
+ *
+ * @param[in] handle
+ * @param[in] params configure the index building
+ * @param[in] dataset a device matrix view to a row-major matrix [n_rows, dim]
+ *
+ * @return the constructed ivf-sq index
+ */
+template <typename CodeT, typename IdxT>
+auto build(raft::resources const& handle,
+           const index_params& params,
+           raft::device_matrix_view<const float, IdxT, row_major> dataset) -> index<CodeT, IdxT>
+{
+  return detail::build<CodeT, IdxT>(handle,
+                                    params,
+                                    dataset.data_handle(),
+                                    static_cast<IdxT>(dataset.extent(0)),
+                                    static_cast<uint32_t>(dataset.extent(1)));
+}
+
+/**
+ * @brief Extend the index in-place with the new data.
+ *
+ * The new rows are assigned to the lists by their original values and quantized with the
+ * quantization of the index; the values outside of the trained range are clamped.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors;
+ *   ivf_sq::index_params index_params;
+ *   index_params.add_data_on_build = false;      // don't populate index on build
+ *   index_params.kmeans_trainset_fraction = 1.0; // use whole dataset for the training
+ *   // train the index from a [N, D] dataset
+ *   auto index = ivf_sq::build<int8_t>(handle, index_params, dataset);
+ *   // fill the index with the data
+ *   std::optional<raft::device_vector_view<const IdxT, IdxT>> no_opt = std::nullopt;
+ *   ivf_sq::extend(handle, dataset, no_opt, &index);
+ * @endcode
+ *
+ * @tparam CodeT the type of the codes
+ * @tparam IdxT type of the indices in the source dataset
+ *
+ * @param[in] handle
+ * @param[in] new_vectors raft::device_matrix_view to a row-major matrix [n_rows, index.dim()]
+ * @param[in] new_indices optional raft::device_vector_view to a vector of indices [n_rows].
+ *    If the original index is empty (`orig_index.size() == 0`), you can pass `std::nullopt`
+ *    here to imply a continuous range `[0...n_rows)`.
+ * @param[inout] index pointer to index, to be overwritten in-place
+ */
+template <typename CodeT, typename IdxT>
+void extend(raft::resources const& handle,
+            raft::device_matrix_view<const float, IdxT, row_major> new_vectors,
+            std::optional<raft::device_vector_view<const IdxT, IdxT>> new_indices,
+            index<CodeT, IdxT>* index)
+{
+  RAFT_EXPECTS(index != nullptr && new_vectors.extent(1) == IdxT(index->dim()),
+               "new_vectors should have the same dimension as the index");
+  detail::extend(handle,
+                 index,
+                 new_vectors.data_handle(),
+                 new_indices.has_value() ? new_indices.value().data_handle() : nullptr,
+                 static_cast<IdxT>(new_vectors.extent(0)));
+}
+
+/**
+ * @brief Search ANN using the constructed index.
+ *
+ * See the [ivf_sq::build](#ivf_sq::build) documentation for a usage example.
+ *
+ * The distances are computed between the queries and the dequantized codes; `k` must not exceed
+ * `matrix::detail::select::warpsort::kMaxCapacity` (256).
+ *
+ * @tparam CodeT the type of the codes
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] handle
+ * @param[in] params configure the search
+ * @param[in] index ivf-sq constructed index
+ * @param[in] queries a device matrix view to a row-major matrix [n_queries, index->dim()]
+ * @param[out] neighbors a device matrix view to the indices of the neighbors in the source dataset
+ * [n_queries, k]
+ * @param[out] distances a device matrix view to the distances to the selected neighbors
+ * [n_queries, k]
+ */
+template <typename CodeT, typename IdxT>
+void search(raft::resources const& handle,
+            const search_params& params,
+            const index<CodeT, IdxT>& index,
+            raft::device_matrix_view<const float, IdxT, row_major> queries,
+            raft::device_matrix_view<IdxT, IdxT, row_major> neighbors,
+            raft::device_matrix_view<float, IdxT, row_major> distances)
+{
+  RAFT_EXPECTS(
+    queries.extent(0) == neighbors.extent(0) && queries.extent(0) == distances.extent(0),
+    "Number of rows in output neighbors and distances matrices must equal the number of queries.");
+  RAFT_EXPECTS(neighbors.extent(1) == distances.extent(1),
+               "Number of columns in output neighbors and distances matrices must be equal");
+  RAFT_EXPECTS(queries.extent(1) == IdxT(index.dim()),
+               "Number of query dimensions should equal number of dimensions in the index.");
+  detail::search(handle,
+                 params,
+                 index,
+                 queries.data_handle(),
+                 static_cast<uint32_t>(queries.extent(0)),
+                 static_cast<uint32_t>(neighbors.extent(1)),
+                 neighbors.data_handle(),
+                 distances.data_handle(),
+                 resource::get_workspace_resource(handle));
+}
+
+/** @} */
+
+}  // namespace raft::neighbors::ivf_sq
@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "ann_types.hpp"
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/error.hpp>
+#include <raft/core/mdspan_types.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/neighbors/ivf_flat_types.hpp>
+
+#include <cuda_fp16.h>
+
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+namespace raft::neighbors::ivf_sq {
+/**
+ * @ingroup ivf_sq
+ * @{
+ */
+
+/** Size of the interleaved group (see `ivf_flat::index::data` description). */
+using ivf_flat::kIndexGroupSize;
+
+struct index_params : ann::index_params {
+  /** The number of inverted lists (clusters) */
+  uint32_t n_lists = 1024;
+  /** The number of iterations searching for kmeans centers (index building). */
+  uint32_t kmeans_n_iters = 20;
+  /**
+   * The fraction of data to use during iterative kmeans building; the same subset is used to learn
+   * the ranges of the scalar quantization.
+   */
+  double kmeans_trainset_fraction = 0.5;
+  /** See `ivf_flat::index_params::conservative_memory_allocation`. */
+  bool conservative_memory_allocation = false;
+};
+
+struct search_params : ann::search_params {
+  /** The number of clusters to search. */
+  uint32_t n_probes = 20;
+};
+
+static_assert(std::is_aggregate_v<index_params>);
+static_assert(std::is_aggregate_v<search_params>);
+
+/**
+ * The half-width of the range of the codes: the trained range of every dimension is mapped onto
+ * `[-kCodeRange, kCodeRange]`.
+ */
+template <typename CodeT>
+constexpr float kCodeRange = std::is_same_v<CodeT, int8_t> ? 127.0f : 1.0f;
+
+template <typename CodeT, typename IdxT, typename SizeT = uint32_t>
+using list_data = ivf_flat::list_data<CodeT, IdxT, SizeT>;
+
+/**
+ * @brief IVF-SQ index: the IVF-Flat lists of the scalar-quantized dataset rows.
+ *
+ * Every dimension `j` of the dataset is quantized independently:
+ * `x[j] ~ code[j] * sq_scale[j] + sq_offset[j]`, where the codes are either `int8_t`
+ * (4x compression) or `half` (2x compression). The offsets and scales are learned from the range
+ * of the training data. The codes are stored in the interleaved layout of the IVF-Flat lists
+ * (see `ivf_flat::index::data`), and the search dequantizes them in registers, so the index needs
+ * neither the original data nor the lookup tables of IVF-PQ.
+ *
+ * @tparam CodeT the type of the codes (`int8_t` or `half`)
+ * @tparam IdxT type of the indices in the source dataset
+ *
+ */
+template <typename CodeT, typename IdxT>
+struct index : ann::index {
+  static_assert(std::is_same_v<CodeT, int8_t> || std::is_same_v<CodeT, half>,
+                "IVF-SQ codes must be either int8_t or half");
+
+ public:
+  /** Vectorized load size in codes, determines the size of interleaved data chunks. */
+  [[nodiscard]] constexpr inline auto veclen() const noexcept -> uint32_t
+  {
+    return lists_.veclen();
+  }
+  /** Distance metric used for clustering and search. */
+  [[nodiscard]] constexpr inline auto metric() const noexcept -> raft::distance::DistanceType
+  {
+    return lists_.metric();
+  }
+  /** Sizes of the lists (clusters) [n_lists]. */
+  inline auto list_sizes() noexcept -> device_vector_view<uint32_t, uint32_t>
+  {
+    return lists_.list_sizes();
+  }
+  [[nodiscard]] inline auto list_sizes() const noexcept
+    -> device_vector_view<const uint32_t, uint32_t>
+  {
+    return lists_.list_sizes();
+  }
+  /** k-means cluster centers corresponding to the lists [n_lists, dim] (not quantized). */
+  inline auto centers() noexcept -> device_matrix_view<float, uint32_t, row_major>
+  {
+    return lists_.centers();
+  }
+  [[nodiscard]] inline auto centers() const noexcept
+    -> device_matrix_view<const float, uint32_t, row_major>
+  {
+    return lists_.centers();
+  }
+  /** (Optional) Precomputed L2 norms of the `centers` [n_lists]. */
+  inline auto center_norms() noexcept -> std::optional<device_vector_view<float, uint32_t>>
+  {
+    return lists_.center_norms();
+  }
+  [[nodiscard]] inline auto center_norms() const noexcept
+    -> std::optional<device_vector_view<const float, uint32_t>>
+  {
+    return lists_.center_norms();
+  }
+  /** Per-dimension offsets of the quantization [dim]. */
+  inline auto sq_offset() noexcept -> device_vector_view<float, uint32_t>
+  {
+    return sq_offset_.view();
+  }
+  [[nodiscard]] inline auto sq_offset() const noexcept -> device_vector_view<const float, uint32_t>
+  {
+    return sq_offset_.view();
+  }
+  /** Per-dimension scales of the quantization [dim]: `x ~ code * sq_scale + sq_offset`. */
+  inline auto sq_scale() noexcept -> device_vector_view<float, uint32_t>
+  {
+    return sq_scale_.view();
+  }
+  [[nodiscard]] inline auto sq_scale() const noexcept -> device_vector_view<const float, uint32_t>
+  {
+    return sq_scale_.view();
+  }
+
+  /** Total length of the index. */
+  [[nodiscard]] constexpr inline auto size() const noexcept -> IdxT { return lists_.size(); }
+  /** Dimensionality of the data. */
+  [[nodiscard]] constexpr inline auto dim() const noexcept -> uint32_t { return lists_.dim(); }
+  /** Number of clusters/inverted lists. */
+  [[nodiscard]] constexpr inline auto n_lists() const noexcept -> uint32_t
+  {
+    return lists_.n_lists();
+  }
+  /** See `ivf_flat::index::conservative_memory_allocation`. */
+  [[nodiscard]] constexpr inline auto conservative_memory_allocation() const noexcept -> bool
+  {
+    return lists_.conservative_memory_allocation();
+  }
+
+  // Don't allow copying the index for performance reasons (try avoiding copying data)
+  index(const index&)                    = delete;
+  index(index&&)                         = default;
+  auto operator=(const index&) -> index& = delete;
+  auto operator=(index&&) -> index&      = default;
+  ~index()                               = default;
+
+  /** Construct an empty index. It needs to be trained and then populated. */
+  index(raft::resources const& res,
+        raft::distance::DistanceType metric,
+        uint32_t n_lists,
+        bool conservative_memory_allocation,
+        uint32_t dim)
+    : ann::index(),
+      lists_(res, metric, n_lists, false, conservative_memory_allocation, dim),
+      sq_offset_{make_device_vector<float, uint32_t>(res, dim)},
+      sq_scale_{make_device_vector<float, uint32_t>(res, dim)}
+  {
+  }
+
+  /** Construct an empty index. It needs to be trained and then populated. */
+  index(raft::resources const& res, const index_params& params, uint32_t dim)
+    : index(res, params.metric, params.n_lists, params.conservative_memory_allocation, dim)
+  {
+  }
+
+  /** Pointers to the inverted lists (clusters) codes [n_lists]. */
+  inline auto data_ptrs() noexcept -> device_vector_view<CodeT*, uint32_t>
+  {
+    return lists_.data_ptrs();
+  }
+  [[nodiscard]] inline auto data_ptrs() const noexcept
+    -> device_vector_view<CodeT* const, uint32_t>
+  {
+    return lists_.data_ptrs();
+  }
+  /** Pointers to the inverted lists (clusters) indices [n_lists]. */
+  inline auto inds_ptrs() noexcept -> device_vector_view<IdxT*, uint32_t>
+  {
+    return lists_.inds_ptrs();
+  }
+  [[nodiscard]] inline auto inds_ptrs() const noexcept -> device_vector_view<IdxT* const, uint32_t>
+  {
+    return lists_.inds_ptrs();
+  }
+
+  /** Update the state of the dependent index members. */
+  void recompute_internal_state(raft::resources const& res)
+  {
+    lists_.recompute_internal_state(res);
+  }
+  void allocate_center_norms(raft::resources const& res) { lists_.allocate_center_norms(res); }
+
+  /** Lists' codes and indices. */
+  inline auto lists() noexcept -> std::vector<std::shared_ptr<list_data<CodeT, IdxT>>>&
+  {
+    return lists_.lists();
+  }
+  [[nodiscard]] inline auto lists() const noexcept
+    -> const std::vector<std::shared_ptr<list_data<CodeT, IdxT>>>&
+  {
+    return lists_.lists();
+  }
+
+ private:
+  /** The lists of the codes share the storage and the layout of the IVF-Flat index. */
+  ivf_flat::index<CodeT, IdxT> lists_;
+  device_vector<float, uint32_t> sq_offset_;
+  device_vector<float, uint32_t> sq_scale_;
+};
+
+/** @} */
+
+}  // namespace raft::neighbors::ivf_sq
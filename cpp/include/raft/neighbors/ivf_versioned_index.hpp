@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/error.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+namespace raft::neighbors::ivf {
+
+/**
+ * @defgroup ivf_versioned_index A versioned IVF index for concurrent search and updates
+ * @{
+ */
+
+/**
+ * @brief A versioned handle of an IVF index (`ivf_flat::index` or `ivf_pq::index`), which allows
+ * searching the index while it is being updated.
+ *
+ * The readers pin an immutable snapshot of the index; the writers build a new version of the index
+ * off the current one and publish it atomically. A new version shares all unchanged inverted lists
+ * with the previous one: the functional `extend` (the one returning a new index) clones the index
+ * and either appends the new records to the shared lists past their sizes observed by the older
+ * versions or reallocates the lists; thus, the pinned snapshots stay consistent. The old versions,
+ * and the lists no longer referenced by any version, are reclaimed once the last reader releases
+ * its snapshot.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors;
+ *   ivf::versioned_index<ivf_flat::index<float, int64_t>> vindex(
+ *     ivf_flat::build(res, index_params, dataset));
+ *   // reader (e.g. a search thread, with its own raft::resources)
+ *   {
+ *     auto snapshot = vindex.snapshot();
+ *     ivf_flat::search(reader_res, search_params, *snapshot, queries, neighbors, distances);
+ *     raft::resource::sync_stream(reader_res);  // keep the snapshot until the search is done
+ *   }
+ *   // writer (e.g. an ingestion thread)
+ *   vindex.update(writer_res, [&](const auto& current) {
+ *     return ivf_flat::extend(writer_res, new_vectors, new_indices, current);
+ *   });
+ * @endcode
+ *
+ * NB: the readers must keep their snapshots until the GPU work using them completes; the memory
+ * owned by a version can be released as soon as the last snapshot of it is destroyed.
+ *
+ * @tparam IndexT the IVF index type
+ */
+template <typename IndexT>
+class versioned_index {
+ public:
+  using index_type = IndexT;
+
+  /** Wrap the (initial version of) the index. */
+  explicit versioned_index(index_type&& index)
+    : current_{std::make_shared<const index_type>(std::move(index))}, version_{0}
+  {
+  }
+
+  versioned_index(const versioned_index&)                    = delete;
+  versioned_index(versioned_index&&)                         = delete;
+  auto operator=(const versioned_index&) -> versioned_index& = delete;
+  auto operator=(versioned_index&&) -> versioned_index&      = delete;
+  ~versioned_index()                                         = default;
+
+  /** Pin the current version of the index. */
+  [[nodiscard]] auto snapshot() const -> std::shared_ptr<const index_type>
+  {
+    std::lock_guard<std::mutex> guard(current_mutex_);
+    return current_;
+  }
+
+  /** The number of versions published so far. */
+  [[nodiscard]] auto version() const -> uint64_t
+  {
+    std::lock_guard<std::mutex> guard(current_mutex_);
+    return version_;
+  }
+
+  /**
+   * Build a new version of the index and publish it.
+   *
+   * The writers are serialized; the readers are not blocked while the new version is built.
+   *
+   * @param[in] res the resources of the writer; the new version is published after its stream
+   *   is synchronized, so that the readers never observe the partially written data.
+   * @param update_op a callable `(const index_type&) -> index_type`, which must not modify the
+   *   current version of the index (e.g. the functional `extend`).
+   */
+  template <typename UpdateOpT>
+  void update(raft::resources const& res, UpdateOpT update_op)
+  {
+    static_assert(std::is_invocable_r_v<index_type, UpdateOpT, const index_type&>,
+                  "update_op must accept the current index and return a new one");
+    std::lock_guard<std::mutex> writer_guard(writer_mutex_);
+    auto current = snapshot();
+    auto next    = std::make_shared<const index_type>(update_op(*current));
+    resource::sync_stream(res);
+    publish(std::move(next));
+  }
+
+  /**
+   * Publish a new version of the index built by the caller.
+   *
+   * @param[in] res the resources used to build the new version (synchronized before publishing).
+   * @param index the new version of the index.
+   */
+  void publish(raft::resources const& res, index_type&& index)
+  {
+    std::lock_guard<std::mutex> writer_guard(writer_mutex_);
+    resource::sync_stream(res);
+    publish(std::make_shared<const index_type>(std::move(index)));
+  }
+
+ private:
+  mutable std::mutex current_mutex_;
+  std::mutex writer_mutex_;
+  std::shared_ptr<const index_type> current_;
+  uint64_t version_;
+
+  void publish(std::shared_ptr<const index_type>&& next)
+  {
+    // The old version is released outside the lock (if this was the last reference to it)
+    std::shared_ptr<const index_type> prev;
+    {
+      std::lock_guard<std::mutex> guard(current_mutex_);
+      prev = std::exchange(current_, std::move(next));
+      version_++;
+    }
+  }
+};
+
+/** @} */
+
+}  // namespace raft::neighbors::ivf
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "detail/nn_descent.cuh"
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/host_device_accessor.hpp>
+#include <raft/core/mdspan.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/neighbors/nn_descent_types.hpp>
+
+namespace raft::neighbors::experimental::nn_descent {
+
+/**
+ * @defgroup nn_descent CUDA gradient descent nearest neighbor
+ * @{
+ */
+
+/**
+ * @brief Build nn-descent Index with dataset in device or host memory
+ *
+ * The all-neighbors knn graph is refined iteratively: in every iteration, the neighbors of the
+ * neighbors of a node are compared with each other (the local join) and proposed as its new
+ * neighbors. The distances are computed on a half-precision copy of the dataset in the device
+ * memory.
+ *
+ * The following distance metrics are supported:
+ * - L2
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors::experimental;
+ *   // use default index parameters
+ *   nn_descent::index_params index_params;
+ *   // create and fill the index from a [N, D] dataset
+ *   auto index = nn_descent::build(res, index_params, dataset);
+ *   // index.graph() provides a raft::host_matrix_view of an
+ *   // all-neighbors knn graph of dimensions [N, k] of the input
+ *   // dataset
+ * @endcode
+ *
+ * @tparam T data-type of the input dataset
+ * @tparam IdxT data-type for the output index
+ * @param[in] res raft::resources is an object managing resources
+ * @param[in] params an instance of nn_descent::index_params that are parameters
+ *               to run the nn-descent algorithm
+ * @param[in] dataset a matrix view (host or device) to a row-major matrix [n_rows, dim]
+ * @return index<IdxT> index containing all-neighbors knn graph in host memory
+ */
+template <typename T,
+          typename IdxT = uint32_t,
+          typename Accessor =
+            host_device_accessor<std::experimental::default_accessor<T>, memory_type::host>>
+index<IdxT> build(raft::resources const& res,
+                  index_params const& params,
+                  mdspan<const T, matrix_extent<int64_t>, row_major, Accessor> dataset)
+{
+  index<IdxT> idx{res, dataset.extent(0), static_cast<int64_t>(params.graph_degree)};
+  detail::build(res, params, dataset, idx);
+  return idx;
+}
+
+/**
+ * @brief Build nn-descent Index with dataset in device or host memory into a user provided index
+ *
+ * The degree of the output graph is the number of columns of `idx.graph()`.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   using namespace raft::neighbors::experimental;
+ *   // use default index parameters
+ *   nn_descent::index_params index_params;
+ *   auto knn_graph = raft::make_host_matrix<uint32_t, int64_t>(N, index_params.graph_degree);
+ *   nn_descent::index<uint32_t> index{res, knn_graph.view()};
+ *   nn_descent::build(res, index_params, dataset, index);
+ * @endcode
+ *
+ * @tparam T data-type of the input dataset
+ * @tparam IdxT data-type for the output index
+ * @param[in] res raft::resources is an object managing resources
+ * @param[in] params an instance of nn_descent::index_params that are parameters
+ *               to run the nn-descent algorithm
+ * @param[in] dataset a matrix view (host or device) to a row-major matrix [n_rows, dim]
+ * @param[out] idx raft::neighbors::experimental::nn_descent::index containing all-neighbors knn
+ *                 graph in host memory
+ */
+template <typename T,
+          typename IdxT = uint32_t,
+          typename Accessor =
+            host_device_accessor<std::experimental::default_accessor<T>, memory_type::host>>
+void build(raft::resources const& res,
+           index_params const& params,
+           mdspan<const T, matrix_extent<int64_t>, row_major, Accessor> dataset,
+           index<IdxT>& idx)
+{
+  detail::build(res, params, dataset, idx);
+}
+
+/** @} */  // end group nn_descent
+
+}  // namespace raft::neighbors::experimental::nn_descent
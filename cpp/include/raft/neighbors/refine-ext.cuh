@@ -17,6 +17,7 @@
 #pragma once
 
 #include <cstdint>                           // int64_t
+#include <cuda_fp16.h>                       // half
 
 #include <raft/core/device_mdspan.hpp>       // raft::device_matrix_view
 #include <raft/core/host_mdspan.hpp>         // // raft::host_matrix_view
@@ -48,6 +49,16 @@ void refine(raft::resources const& handle,
             raft::distance::DistanceType metric = distance::DistanceType::L2Unexpanded)
   RAFT_EXPLICIT;
 
+template <typename idx_t, typename data_t, typename distance_t, typename matrix_idx>
+void refine(raft::resources const& handle,
+            raft::host_matrix_view<const data_t, matrix_idx, row_major> dataset,
+            raft::device_matrix_view<const data_t, matrix_idx, row_major> queries,
+            raft::device_matrix_view<const idx_t, matrix_idx, row_major> neighbor_candidates,
+            raft::device_matrix_view<idx_t, matrix_idx, row_major> indices,
+            raft::device_matrix_view<distance_t, matrix_idx, row_major> distances,
+            raft::distance::DistanceType metric = distance::DistanceType::L2Unexpanded)
+  RAFT_EXPLICIT;
+
 }  // namespace raft::neighbors
 
 #endif  // RAFT_EXPLICIT_INSTANTIATE_ONLY
@@ -69,9 +80,19 @@ void refine(raft::resources const& handle,
     raft::host_matrix_view<const idx_t, matrix_idx, row_major> neighbor_candidates,    \
     raft::host_matrix_view<idx_t, matrix_idx, row_major> indices,                      \
     raft::host_matrix_view<distance_t, matrix_idx, row_major> distances,               \
+    raft::distance::DistanceType metric);                                              \
+                                                                                       \
+  extern template void raft::neighbors::refine<idx_t, data_t, distance_t, matrix_idx>( \
+    raft::resources const& handle,                                                     \
+    raft::host_matrix_view<const data_t, matrix_idx, row_major> dataset,               \
+    raft::device_matrix_view<const data_t, matrix_idx, row_major> queries,             \
+    raft::device_matrix_view<const idx_t, matrix_idx, row_major> neighbor_candidates,  \
+    raft::device_matrix_view<idx_t, matrix_idx, row_major> indices,                    \
+    raft::device_matrix_view<distance_t, matrix_idx, row_major> distances,             \
     raft::distance::DistanceType metric);
 
 instantiate_raft_neighbors_refine(int64_t, float, float, int64_t);
+instantiate_raft_neighbors_refine(int64_t, half, float, int64_t);
 instantiate_raft_neighbors_refine(int64_t, int8_t, float, int64_t);
 instantiate_raft_neighbors_refine(int64_t, uint8_t, float, int64_t);
 
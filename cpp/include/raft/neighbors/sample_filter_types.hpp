@@ -37,6 +37,42 @@ struct none_ivf_sample_filter {
   }
 };
 
+/* A filter that filters nothing. This is the default behavior of CAGRA search. */
+struct none_cagra_sample_filter {
+  inline _RAFT_HOST_DEVICE bool operator()(
+    // query index
+    const uint32_t query_ix,
+    // the index of the current sample in the dataset
+    const uint32_t sample_ix) const
+  {
+    return true;
+  }
+};
+
+/**
+ * A filter that greenlights the samples whose bits are set in a bitset shared by all queries:
+ * the sample `i` passes if the bit `i % 32` of the word `bitset_ptr[i / 32]` is set.
+ *
+ * It is the filter of `raft::neighbors::brute_force::search_with_filtering`, and it can be passed
+ * to the CAGRA search as well (with `index_t = uint32_t`).
+ */
+template <typename index_t>
+struct bitset_filter {
+  const uint32_t* bitset_ptr = nullptr;
+
+  bitset_filter() = default;
+  explicit bitset_filter(const uint32_t* _bitset_ptr) : bitset_ptr{_bitset_ptr} {}
+
+  inline _RAFT_HOST_DEVICE bool operator()(
+    // query index
+    const uint32_t query_ix,
+    // the index of the current sample in the dataset
+    const index_t sample_ix) const
+  {
+    return (bitset_ptr[sample_ix / 32] >> (sample_ix % 32)) & 1u;
+  }
+};
+
 /**
  * If the filtering depends on the index of a sample, then the following
  * filter template can be used:
@@ -114,5 +150,27 @@ struct none_ivf_sample_filter {
  *     return is_bit_set;
  *   }
  * };
+ *
+ * CAGRA filters receive the dataset index of a sample directly. For example, a filter that
+ * greenlights samples according to a bit mask shared by all queries:
+ *
+ * struct bitmask_cagra_sample_filter {
+ *   const uint32_t* const bit_mask_ptr = nullptr;
+ *
+ *   bitmask_cagra_sample_filter(const uint32_t* const _bit_mask_ptr)
+ *       : bit_mask_ptr{_bit_mask_ptr} {}
+ *
+ *   inline _RAFT_HOST_DEVICE bool operator()(
+ *       const uint32_t query_ix,
+ *       const uint32_t sample_ix) const {
+ *     return (bit_mask_ptr[sample_ix / 32] >> (sample_ix % 32)) & 1u;
+ *   }
+ * };
+ *
+ * Use it as:
+ *   raft::neighbors::experimental::cagra::search_with_filtering(
+ *     ...regular parameters here...,
+ *     bitmask_cagra_sample_filter(bit_mask.data_handle())
+ *   );
  */
 }  // namespace raft::neighbors::filtering
@@ -0,0 +1,455 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/error.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/cuda_stream_pool.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/core/workspace_arena_resource.hpp>
+#include <raft/neighbors/cagra.cuh>
+#include <raft/neighbors/ivf_flat.cuh>
+#include <raft/neighbors/ivf_pq.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/cuda_stream.hpp>
+#include <rmm/mr/device/per_device_resource.hpp>
+#include <rmm/mr/device/statistics_resource_adaptor.hpp>
+
+#include <cuda_runtime_api.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace raft::neighbors {
+
+/**
+ * @defgroup search_graph Replay of the ANN searches from CUDA graphs
+ * @{
+ */
+
+/**
+ * @brief A search of a fixed shape captured into a CUDA graph.
+ *
+ * The kernels of one search of `n_queries` queries for their `k` nearest neighbors are captured
+ * once; a replay then costs a single graph launch, which removes the launch overhead of the many
+ * small kernels of a search of a small batch. The graph reads the queries from and writes the
+ * results to buffers owned by the object (`queries()`, `neighbors()`, `distances()`); the `run`
+ * overload taking views copies the data in and out of them in the stream of the caller.
+ *
+ * All the temporary memory of the search is taken from a workspace arena owned by the object, so
+ * the graph allocates nothing when replayed. The arena is sized by running the search once before
+ * the capture; this run also initializes the state the search creates lazily (e.g. the cuBLAS
+ * handle).
+ *
+ * Use the factories `ivf_pq::make_search_graph`, `ivf_flat::make_search_graph` and
+ * `cagra::make_search_graph` rather than the constructor:
+ * @code{.cpp}
+ *   auto graph = raft::neighbors::ivf_pq::make_search_graph<float, int64_t>(
+ *     res, search_params, index, batch_size, k);
+ *   while (...) {
+ *     // fill `queries` with at most `batch_size` queries
+ *     graph.run(res, queries, neighbors, distances);
+ *   }
+ * @endcode
+ *
+ * The captured search keeps referring to the index, which must outlive the object. The replays
+ * share the buffers and the workspace of the object: the replays in different streams must be
+ * ordered by the caller, who must also synchronize the stream of the last replay before destroying
+ * the object.
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices of the neighbors
+ */
+template <typename T, typename IdxT>
+class search_graph {
+ public:
+  /** A search of the queries, run in the stream of the resources. */
+  using search_function =
+    std::function<void(raft::resources const&,
+                       raft::device_matrix_view<const T, int64_t, row_major>,
+                       raft::device_matrix_view<IdxT, int64_t, row_major>,
+                       raft::device_matrix_view<float, int64_t, row_major>)>;
+
+  /**
+   * Run the search once and capture it.
+   *
+   * The search must not synchronize the host with its stream, must not use other streams and
+   * must take all its temporary memory from the workspace resource or the current device resource
+   * of the handle; the capture fails otherwise.
+   *
+   * @param[in] res raft resources
+   * @param[in] n_queries the number of queries of the captured search
+   * @param[in] dim the dimensionality of the queries
+   * @param[in] k the number of neighbors
+   * @param[in] search the search to capture
+   */
+  search_graph(raft::resources const& res,
+               int64_t n_queries,
+               int64_t dim,
+               int64_t k,
+               search_function search)
+    : res_(res),
+      search_(std::move(search)),
+      queries_(make_device_matrix<T, int64_t>(res, n_queries, dim)),
+      neighbors_(make_device_matrix<IdxT, int64_t>(res, n_queries, k)),
+      distances_(make_device_matrix<float, int64_t>(res, n_queries, k))
+  {
+    RAFT_EXPECTS(n_queries > 0, "invalid parameter (n_queries<=0)");
+    RAFT_EXPECTS(k > 0, "invalid parameter (k<=0)");
+    // The buffers are ready in the stream of the caller
+    resource::sync_stream(res);
+    resource::set_cuda_stream(res_, stream_.view());
+    // The batches of a search must not be spread over the streams of the pool
+    resource::set_cuda_stream_pool(res_, nullptr);
+    RAFT_CUDA_TRY(
+      cudaMemsetAsync(queries_.data_handle(), 0, queries_.size() * sizeof(T), stream_.view()));
+
+    auto workspace_size = warm_up();
+    // The search may adapt its batches to the free space of the arena, or (rarely) take a little
+    // more memory than in the warm-up run because of the alignment; in the latter case the
+    // capture is retried with a larger arena.
+    constexpr int kMaxAttempts = 4;
+    for (int attempt = 1;; attempt++) {
+      try {
+        capture(workspace_size);
+        break;
+      } catch (const rmm::out_of_memory&) {
+        if (attempt == kMaxAttempts) { throw; }
+        workspace_size *= 2;
+      }
+    }
+  }
+
+  search_graph(const search_graph&)                    = delete;
+  auto operator=(const search_graph&) -> search_graph& = delete;
+  search_graph(search_graph&&)                         = default;
+  auto operator=(search_graph&&) -> search_graph&      = default;
+
+  /**
+   * Replay the search in the stream of `res`: it reads the queries from `queries()` and writes the
+   * results to `neighbors()` and `distances()`.
+   */
+  void run(raft::resources const& res) const
+  {
+    RAFT_CUDA_TRY(cudaGraphLaunch(graph_.get(), resource::get_cuda_stream(res)));
+  }
+
+  /**
+   * Replay the search for the given queries.
+   *
+   * The queries are copied to `queries()` and the results are copied back from `neighbors()` and
+   * `distances()`. If there are fewer queries than `n_queries()`, the remaining rows of `queries()`
+   * keep their previous content and their results are dropped.
+   *
+   * @param[in] res raft resources
+   * @param[in] queries the queries [n_rows <= n_queries(), dim()]
+   * @param[out] neighbors the indices of the neighbors [n_rows, k()]
+   * @param[out] distances the distances to the neighbors [n_rows, k()]
+   */
+  void run(raft::resources const& res,
+           raft::device_matrix_view<const T, int64_t, row_major> queries,
+           raft::device_matrix_view<IdxT, int64_t, row_major> neighbors,
+           raft::device_matrix_view<float, int64_t, row_major> distances)
+  {
+    RAFT_EXPECTS(queries.extent(0) <= n_queries(),
+                 "The number of queries exceeds the number of queries of the captured search.");
+    RAFT_EXPECTS(queries.extent(1) == dim(),
+                 "Number of query dimensions should equal the dimensions of the captured search.");
+    RAFT_EXPECTS(
+      queries.extent(0) == neighbors.extent(0) && queries.extent(0) == distances.extent(0),
+      "Number of rows in output neighbors and distances matrices must equal the number of "
+      "queries.");
+    RAFT_EXPECTS(neighbors.extent(1) == k() && distances.extent(1) == k(),
+                 "Number of columns in output neighbors and distances matrices must equal k");
+    if (queries.extent(0) == 0) { return; }
+    auto stream = resource::get_cuda_stream(res);
+    raft::copy(queries_.data_handle(), queries.data_handle(), queries.size(), stream);
+    run(res);
+    raft::copy(neighbors.data_handle(), neighbors_.data_handle(), neighbors.size(), stream);
+    raft::copy(distances.data_handle(), distances_.data_handle(), distances.size(), stream);
+  }
+
+  /** The queries read by the graph. [n_queries, dim] */
+  [[nodiscard]] auto queries() noexcept -> raft::device_matrix_view<T, int64_t, row_major>
+  {
+    return queries_.view();
+  }
+  /** The indices of the neighbors written by the graph. [n_queries, k] */
+  [[nodiscard]] auto neighbors() const noexcept
+    -> raft::device_matrix_view<const IdxT, int64_t, row_major>
+  {
+    return neighbors_.view();
+  }
+  /** The distances to the neighbors written by the graph. [n_queries, k] */
+  [[nodiscard]] auto distances() const noexcept
+    -> raft::device_matrix_view<const float, int64_t, row_major>
+  {
+    return distances_.view();
+  }
+  [[nodiscard]] auto n_queries() const noexcept -> int64_t { return queries_.extent(0); }
+  [[nodiscard]] auto dim() const noexcept -> int64_t { return queries_.extent(1); }
+  [[nodiscard]] auto k() const noexcept -> int64_t { return neighbors_.extent(1); }
+  /** The size of the workspace arena held by the graph, in bytes. */
+  [[nodiscard]] auto workspace_size() const noexcept -> size_t { return workspace_->capacity(); }
+
+ private:
+  struct graph_exec_deleter {
+    void operator()(cudaGraphExec_t exec) const { cudaGraphExecDestroy(exec); }
+  };
+
+  /** Make `mr` the current device resource for the lifetime of the guard. */
+  struct current_device_resource_guard {
+    explicit current_device_resource_guard(rmm::mr::device_memory_resource* mr)
+      : prev_(rmm::mr::set_current_device_resource(mr))
+    {
+    }
+    ~current_device_resource_guard() { rmm::mr::set_current_device_resource(prev_); }
+    current_device_resource_guard(const current_device_resource_guard&) = delete;
+    auto operator=(const current_device_resource_guard&)
+      -> current_device_resource_guard& = delete;
+
+   private:
+    rmm::mr::device_memory_resource* prev_;
+  };
+
+  // The stream is declared first: the resources and the buffers refer to it.
+  rmm::cuda_stream stream_;
+  raft::resources res_;
+  search_function search_;
+  raft::device_matrix<T, int64_t, row_major> queries_;
+  raft::device_matrix<IdxT, int64_t, row_major> neighbors_;
+  raft::device_matrix<float, int64_t, row_major> distances_;
+  std::shared_ptr<raft::workspace_arena_resource> workspace_;
+  std::unique_ptr<std::remove_pointer_t<cudaGraphExec_t>, graph_exec_deleter> graph_;
+
+  /** Run the search eagerly and return the size of the workspace it needs, in bytes. */
+  auto warm_up() -> size_t
+  {
+    rmm::mr::statistics_resource_adaptor<rmm::mr::device_memory_resource> stats(
+      resource::get_workspace_resource(res_));
+    {
+      raft::resources warm_up_res(res_);
+      resource::set_workspace_resource(warm_up_res, &stats);
+      current_device_resource_guard guard(&stats);
+      search_(warm_up_res,
+              raft::make_const_mdspan(queries_.view()),
+              neighbors_.view(),
+              distances_.view());
+      resource::sync_stream(warm_up_res);
+    }
+    // every allocation may take up to the alignment in addition to its size
+    return stats.get_bytes_counter().peak +
+           stats.get_allocations_counter().peak * raft::workspace_arena_resource::kAlignment;
+  }
+
+  void capture(size_t workspace_size)
+  {
+    graph_.reset();
+    workspace_.reset();
+    workspace_ = std::make_shared<raft::workspace_arena_resource>(
+      workspace_size, stream_.view(), resource::get_workspace_resource(res_));
+    raft::resources capture_res(res_);
+    resource::set_workspace_resource(capture_res, workspace_.get());
+    current_device_resource_guard guard(workspace_.get());
+    auto stream = stream_.view();
+
+    cudaGraph_t graph;
+    RAFT_CUDA_TRY(cudaStreamBeginCapture(stream, cudaStreamCaptureModeThreadLocal));
+    try {
+      search_(capture_res,
+              raft::make_const_mdspan(queries_.view()),
+              neighbors_.view(),
+              distances_.view());
+    } catch (const rmm::out_of_memory&) {
+      if (cudaStreamEndCapture(stream, &graph) == cudaSuccess) { cudaGraphDestroy(graph); }
+      throw;
+    } catch (const std::exception& e) {
+      // leave the stream usable for the caller
+      if (cudaStreamEndCapture(stream, &graph) == cudaSuccess) { cudaGraphDestroy(graph); }
+      cudaGetLastError();
+      RAFT_FAIL(
+        "The search cannot be captured into a CUDA graph (it must not synchronize the stream, "
+        "use other streams or allocate memory outside of the workspace): %s",
+        e.what());
+    }
+    RAFT_CUDA_TRY(cudaStreamEndCapture(stream, &graph));
+    cudaGraphExec_t exec;
+    auto status = cudaGraphInstantiateWithFlags(&exec, graph, 0);
+    RAFT_CUDA_TRY(cudaGraphDestroy(graph));
+    RAFT_CUDA_TRY(status);
+    graph_.reset(exec);
+  }
+};
+
+/** @} */  // end group search_graph
+
+}  // namespace raft::neighbors
+
+namespace raft::neighbors::ivf_pq {
+
+/**
+ * @ingroup search_graph
+ * @brief Capture an IVF-PQ search of `n_queries` queries into a CUDA graph.
+ *
+ * The search parameters are copied; the index is referred to and must outlive the graph. The
+ * searches of the offloaded lists (`list_cache`) are not supported.
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] res raft resources
+ * @param[in] params configure the search
+ * @param[in] idx ivf-pq constructed index
+ * @param[in] n_queries the number of queries of a search
+ * @param[in] k the number of neighbors
+ */
+template <typename T, typename IdxT>
+auto make_search_graph(raft::resources const& res,
+                       const search_params& params,
+                       const index<IdxT>& idx,
+                       uint32_t n_queries,
+                       uint32_t k) -> search_graph<T, IdxT>
+{
+  return search_graph<T, IdxT>(
+    res,
+    n_queries,
+    idx.dim(),
+    k,
+    [params, &idx](raft::resources const& handle,
+                   raft::device_matrix_view<const T, int64_t, row_major> queries,
+                   raft::device_matrix_view<IdxT, int64_t, row_major> neighbors,
+                   raft::device_matrix_view<float, int64_t, row_major> distances) {
+      ivf_pq::search(handle,
+                     params,
+                     idx,
+                     raft::make_device_matrix_view<const T, uint32_t>(
+                       queries.data_handle(), queries.extent(0), queries.extent(1)),
+                     raft::make_device_matrix_view<IdxT, uint32_t>(
+                       neighbors.data_handle(), neighbors.extent(0), neighbors.extent(1)),
+                     raft::make_device_matrix_view<float, uint32_t>(
+                       distances.data_handle(), distances.extent(0), distances.extent(1)));
+    });
+}
+
+}  // namespace raft::neighbors::ivf_pq
+
+namespace raft::neighbors::ivf_flat {
+
+/**
+ * @ingroup search_graph
+ * @brief Capture an IVF-Flat search of `n_queries` queries into a CUDA graph.
+ *
+ * The search parameters are copied; the index is referred to and must outlive the graph. The
+ * searches of the lists kept in the host memory (`host_lists`) are not supported.
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] res raft resources
+ * @param[in] params configure the search
+ * @param[in] idx ivf-flat constructed index
+ * @param[in] n_queries the number of queries of a search
+ * @param[in] k the number of neighbors
+ */
+template <typename T, typename IdxT>
+auto make_search_graph(raft::resources const& res,
+                       const search_params& params,
+                       const index<T, IdxT>& idx,
+                       IdxT n_queries,
+                       IdxT k) -> search_graph<T, IdxT>
+{
+  return search_graph<T, IdxT>(
+    res,
+    n_queries,
+    idx.dim(),
+    k,
+    [params, &idx](raft::resources const& handle,
+                   raft::device_matrix_view<const T, int64_t, row_major> queries,
+                   raft::device_matrix_view<IdxT, int64_t, row_major> neighbors,
+                   raft::device_matrix_view<float, int64_t, row_major> distances) {
+      ivf_flat::search(handle,
+                       params,
+                       idx,
+                       raft::make_device_matrix_view<const T, IdxT>(
+                         queries.data_handle(), queries.extent(0), queries.extent(1)),
+                       raft::make_device_matrix_view<IdxT, IdxT>(
+                         neighbors.data_handle(), neighbors.extent(0), neighbors.extent(1)),
+                       raft::make_device_matrix_view<float, IdxT>(
+                         distances.data_handle(), distances.extent(0), distances.extent(1)));
+    });
+}
+
+}  // namespace raft::neighbors::ivf_flat
+
+namespace raft::neighbors::experimental::cagra {
+
+/**
+ * @ingroup search_graph
+ * @brief Capture a CAGRA search of `n_queries` queries into a CUDA graph.
+ *
+ * The search parameters are copied; the index is referred to and must outlive the graph. The
+ * persistent search is not supported, since its kernel outlives the search calls. The
+ * `MULTI_KERNEL` search cannot stop at the convergence within a graph, so the captured search
+ * runs all the `max_iterations` (with the same results).
+ *
+ * @tparam T data element type
+ * @tparam IdxT type of the indices
+ *
+ * @param[in] res raft resources
+ * @param[in] params configure the search
+ * @param[in] idx cagra index
+ * @param[in] n_queries the number of queries of a search
+ * @param[in] k the number of neighbors
+ */
+template <typename T, typename IdxT>
+auto make_search_graph(raft::resources const& res,
+                       const search_params& params,
+                       const index<T, IdxT>& idx,
+                       IdxT n_queries,
+                       IdxT k) -> search_graph<T, IdxT>
+{
+  RAFT_EXPECTS(!params.persistent,
+               "The persistent search cannot be captured into a CUDA graph.");
+  return search_graph<T, IdxT>(
+    res,
+    n_queries,
+    idx.dim(),
+    k,
+    [params, &idx](raft::resources const& handle,
+                   raft::device_matrix_view<const T, int64_t, row_major> queries,
+                   raft::device_matrix_view<IdxT, int64_t, row_major> neighbors,
+                   raft::device_matrix_view<float, int64_t, row_major> distances) {
+      cagra::search(handle,
+                    params,
+                    idx,
+                    raft::make_device_matrix_view<const T, IdxT>(
+                      queries.data_handle(), queries.extent(0), queries.extent(1)),
+                    raft::make_device_matrix_view<IdxT, IdxT>(
+                      neighbors.data_handle(), neighbors.extent(0), neighbors.extent(1)),
+                    raft::make_device_matrix_view<float, IdxT>(
+                      distances.data_handle(), distances.extent(0), distances.extent(1)));
+    });
+}
+
+}  // namespace raft::neighbors::experimental::cagra
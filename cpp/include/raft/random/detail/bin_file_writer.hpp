@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/error.hpp>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+namespace raft::random::detail {
+
+/**
+ * Writes the rows of a matrix to a file of the layout of the `.fbin` / `.u8bin` / `.ibin` files of
+ * the ANN benchmarks: two uint32 (n_rows, n_cols) followed by the rows. The rows can be written in
+ * any order and by several processes at once, every one of them writing its own rows into the
+ * same file: the file is sized, not truncated, so that no writer erases the rows of another one.
+ */
+template <typename T>
+class bin_file_writer {
+ public:
+  static constexpr size_t kHeaderBytes = 2 * sizeof(uint32_t);
+
+  /** Open (or create) the file of a [n_rows, n_cols] matrix; `owner` writes the header. */
+  bin_file_writer(const std::string& path, uint64_t n_rows, uint64_t n_cols, bool owner)
+    : path_(path), n_cols_(n_cols)
+  {
+    RAFT_EXPECTS(n_rows <= std::numeric_limits<uint32_t>::max() &&
+                   n_cols <= std::numeric_limits<uint32_t>::max(),
+                 "The shape of the matrix of %s must fit the uint32 header",
+                 path.c_str());
+    fd_ = open(path.c_str(), O_WRONLY | O_CREAT, 0644);
+    if (fd_ < 0) { RAFT_FAIL("Cannot open file %s", path.c_str()); }
+    if (owner) {
+      auto bytes = off_t(kHeaderBytes + n_rows * n_cols * sizeof(T));
+      if (ftruncate(fd_, bytes) != 0) {
+        close(fd_);
+        RAFT_FAIL("Cannot resize file %s", path.c_str());
+      }
+      uint32_t header[2] = {uint32_t(n_rows), uint32_t(n_cols)};
+      write_bytes(header, sizeof(header), 0);
+    }
+  }
+
+  bin_file_writer(const bin_file_writer&)            = delete;
+  bin_file_writer& operator=(const bin_file_writer&) = delete;
+
+  ~bin_file_writer() { close(fd_); }
+
+  /** Write `n` contiguous rows, the first of which is the row `first_row` of the matrix. */
+  void write(const T* rows, uint64_t first_row, uint64_t n)
+  {
+    write_bytes(rows, n * n_cols_ * sizeof(T), kHeaderBytes + first_row * n_cols_ * sizeof(T));
+  }
+
+ private:
+  void write_bytes(const void* data, size_t bytes, size_t offset)
+  {
+    auto ptr = static_cast<const char*>(data);
+    while (bytes > 0) {
+      auto written = pwrite(fd_, ptr, bytes, off_t(offset));
+      if (written <= 0) { RAFT_FAIL("Cannot write to file %s", path_.c_str()); }
+      ptr += written;
+      offset += written;
+      bytes -= written;
+    }
+  }
+
+  std::string path_;
+  uint64_t n_cols_;
+  int fd_;
+};
+
+}  // namespace raft::random::detail
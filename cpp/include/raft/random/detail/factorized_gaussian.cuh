@@ -0,0 +1,332 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "multi_variable_gaussian.cuh"
+
+#include <raft/core/resource/cublas_handle.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/cusolver_dn_handle.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/linalg/detail/cublas_wrappers.hpp>
+#include <raft/linalg/detail/cusolver_wrappers.hpp>
+#include <raft/random/device/philox.cuh>
+#include <raft/random/random_types.hpp>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace raft::random::detail {
+
+/** Up to this dimension, the eigen decompositions of a batch are a single `syevjBatched`. */
+constexpr int kSyevjBatchedMaxDim = 32;
+/** The shared memory of a block of `factorized_gaussian_kernel`, beyond which a GEMM is used. */
+constexpr size_t kFactorizedGaussianMaxSmem = 48 * 1024;
+
+/** Zero the strict upper triangles of a batch of column-major square matrices. */
+template <typename T>
+__global__ void zero_upper_kernel(T* factors, int batch, int dim)
+{
+  size_t len    = size_t(batch) * dim * dim;
+  size_t stride = size_t(blockDim.x) * gridDim.x;
+  for (size_t idx = blockIdx.x * size_t(blockDim.x) + threadIdx.x; idx < len; idx += stride) {
+    auto row = int(idx % dim);
+    auto col = int((idx / dim) % dim);
+    if (row < col) { factors[idx] = T(0); }
+  }
+}
+
+/**
+ * Scale the eigenvectors (the columns) of a batch of matrices by the square roots of their
+ * eigenvalues; `negative` is set if one of them is negative.
+ */
+template <typename T>
+__global__ void scale_eigenvectors_kernel(
+  T* factors, const T* eig, int batch, int dim, int* negative)
+{
+  size_t len    = size_t(batch) * dim * dim;
+  size_t stride = size_t(blockDim.x) * gridDim.x;
+  for (size_t idx = blockIdx.x * size_t(blockDim.x) + threadIdx.x; idx < len; idx += stride) {
+    // the column of the batch, which is also the index of its eigenvalue
+    T w = eig[idx / dim];
+    if (w >= T(0)) {
+      factors[idx] *= raft::sqrt(w);
+    } else {
+      *negative = 1;
+    }
+  }
+}
+
+/**
+ * Factorize a batch of covariances [batch, dim, dim] into `factors` such that
+ * `factor * factor^T = covariance`: the lower Cholesky factors (returns true) or the eigenvectors
+ * scaled by the square roots of the eigenvalues (returns false).
+ */
+template <typename T>
+bool factorize_covariances(raft::resources const& handle,
+                           const T* covs,
+                           T* factors,
+                           int batch,
+                           int dim,
+                           multi_variable_gaussian_decomposition_method method)
+{
+  auto stream   = resource::get_cuda_stream(handle);
+  auto cusolver = resource::get_cusolver_dn_handle(handle);
+
+  constexpr cublasFillMode_t uplo  = CUBLAS_FILL_MODE_LOWER;
+  constexpr cusolverEigMode_t jobz = CUSOLVER_EIG_MODE_VECTOR;
+  constexpr int kThreads           = 256;
+  size_t len                       = size_t(batch) * dim * dim;
+
+  auto n_blocks = int(std::min<size_t>(raft::ceildiv<size_t>(len, kThreads), 65536));
+  raft::copy(factors, covs, len, stream);
+
+  rmm::device_uvector<int> info(batch, stream);
+  std::vector<int> h_info(batch);
+  auto check_info = [&](const char* routine) {
+    raft::update_host(h_info.data(), info.data(), batch, stream);
+    resource::sync_stream(handle, stream);
+    for (int b = 0; b < batch; b++) {
+      ASSERT(h_info[b] == 0,
+             "mvg: error in %s of the covariance %d, info=%d | expected=0",
+             routine,
+             b,
+             h_info[b]);
+    }
+  };
+
+  if (method == multi_variable_gaussian_decomposition_method::CHOLESKY) {
+    std::vector<T*> h_ptrs(batch);
+    for (int b = 0; b < batch; b++) {
+      h_ptrs[b] = factors + size_t(b) * dim * dim;
+    }
+    rmm::device_uvector<T*> ptrs(batch, stream);
+    raft::update_device(ptrs.data(), h_ptrs.data(), batch, stream);
+    RAFT_CUSOLVER_TRY(raft::linalg::detail::cusolverDnpotrfBatched(
+      cusolver, uplo, dim, ptrs.data(), dim, info.data(), batch, stream));
+    check_info("potrf");
+    zero_upper_kernel<<<n_blocks, kThreads, 0, stream>>>(factors, batch, dim);
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+    return true;
+  }
+
+  rmm::device_uvector<T> eig(size_t(batch) * dim, stream);
+  const bool jacobi        = method == multi_variable_gaussian_decomposition_method::JACOBI;
+  const bool batched       = jacobi && dim <= kSyevjBatchedMaxDim;
+  syevjInfo_t syevj_params = nullptr;
+  int lwork                = 0;
+  if (jacobi) {
+    RAFT_CUSOLVER_TRY(cusolverDnCreateSyevjInfo(&syevj_params));
+    RAFT_CUSOLVER_TRY(cusolverDnXsyevjSetTolerance(syevj_params, 1.e-7));
+    RAFT_CUSOLVER_TRY(cusolverDnXsyevjSetMaxSweeps(syevj_params, 100));
+  }
+  if (batched) {
+    RAFT_CUSOLVER_TRY(raft::linalg::detail::cusolverDnsyevjBatched_bufferSize(
+      cusolver, jobz, uplo, dim, factors, dim, eig.data(), &lwork, syevj_params, batch));
+  } else if (jacobi) {
+    RAFT_CUSOLVER_TRY(raft::linalg::detail::cusolverDnsyevj_bufferSize(
+      cusolver, jobz, uplo, dim, factors, dim, eig.data(), &lwork, syevj_params));
+  } else {
+    RAFT_CUSOLVER_TRY(raft::linalg::detail::cusolverDnsyevd_bufferSize(
+      cusolver, jobz, uplo, dim, factors, dim, eig.data(), &lwork));
+  }
+  rmm::device_uvector<T> work(lwork, stream);
+  if (batched) {
+    RAFT_CUSOLVER_TRY(raft::linalg::detail::cusolverDnsyevjBatched(cusolver,
+                                                                   jobz,
+                                                                   uplo,
+                                                                   dim,
+                                                                   factors,
+                                                                   dim,
+                                                                   eig.data(),
+                                                                   work.data(),
+                                                                   lwork,
+                                                                   info.data(),
+                                                                   syevj_params,
+                                                                   batch,
+                                                                   stream));
+  } else {
+    // one solver call per matrix: the factorization is computed once per distribution
+    for (int b = 0; b < batch; b++) {
+      T* factor = factors + size_t(b) * dim * dim;
+      T* w      = eig.data() + size_t(b) * dim;
+      if (jacobi) {
+        RAFT_CUSOLVER_TRY(raft::linalg::detail::cusolverDnsyevj(cusolver,
+                                                                jobz,
+                                                                uplo,
+                                                                dim,
+                                                                factor,
+                                                                dim,
+                                                                w,
+                                                                work.data(),
+                                                                lwork,
+                                                                info.data() + b,
+                                                                syevj_params,
+                                                                stream));
+      } else {
+        RAFT_CUSOLVER_TRY(raft::linalg::detail::cusolverDnsyevd(
+          cusolver, jobz, uplo, dim, factor, dim, w, work.data(), lwork, info.data() + b, stream));
+      }
+    }
+  }
+  check_info(jacobi ? "syevj" : "syevd");
+  if (syevj_params != nullptr) { RAFT_CUSOLVER_TRY(cusolverDnDestroySyevjInfo(syevj_params)); }
+
+  epsilonToZero(eig.data(), T(1.e-12), batch * dim, stream);
+  RAFT_CUDA_TRY(cudaMemsetAsync(info.data(), 0, sizeof(int), stream));
+  scale_eigenvectors_kernel<<<n_blocks, kThreads, 0, stream>>>(
+    factors, eig.data(), batch, dim, info.data());
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+  int negative = 0;
+  raft::update_host(&negative, info.data(), 1, stream);
+  resource::sync_stream(handle, stream);
+  ASSERT(negative == 0, "mvg: a covariance matrix has a negative eigenvalue");
+  return false;
+}
+
+/**
+ * The points [batch, n_points, dim] `x = mean + factor * z`, with the normal `z` of the point `j`
+ * of the batch `b` the elements `(b * n_points + j) * dim` onwards of `rng`. The normals are
+ * generated into the shared memory of the thread of the point, next to the factor of the batch,
+ * and never stored in the global memory.
+ */
+template <typename T>
+__global__ void factorized_gaussian_kernel(T* out,
+                                           const T* factors,
+                                           const T* means,
+                                           int batch,
+                                           int n_points,
+                                           int dim,
+                                           bool triangular,
+                                           raft::random::device::counter_rng rng)
+{
+  extern __shared__ char smem_buf[];
+  T* s_factor = reinterpret_cast<T*>(smem_buf);
+  // the normals of a thread are strided by the block size: no bank conflicts
+  T* s_z = s_factor + dim * dim;
+
+  int j = blockIdx.x * blockDim.x + threadIdx.x;
+  for (int b = blockIdx.y; b < batch; b += gridDim.y) {
+    __syncthreads();
+    const T* factor = factors + size_t(b) * dim * dim;
+    for (int i = threadIdx.x; i < dim * dim; i += blockDim.x) {
+      s_factor[i] = factor[i];
+    }
+    __syncthreads();
+    if (j >= n_points) { continue; }
+
+    uint64_t first = (uint64_t(b) * n_points + j) * dim;
+    for (int k = 0; k < dim; k++) {
+      s_z[k * blockDim.x + threadIdx.x] = rng.normal<T>(first + k);
+    }
+    T* x = out + first;
+    for (int i = 0; i < dim; i++) {
+      T acc     = means == nullptr ? T(0) : means[size_t(b) * dim + i];
+      int k_end = triangular ? i + 1 : dim;
+      for (int k = 0; k < k_end; k++) {
+        acc += s_factor[k * dim + i] * s_z[k * blockDim.x + threadIdx.x];
+      }
+      x[i] = acc;
+    }
+  }
+}
+
+/** The normals of `factorized_gaussian_kernel`, for the GEMM of the large dimensions. */
+template <typename T>
+__global__ void factorized_gaussian_normals_kernel(T* z,
+                                                   size_t len,
+                                                   raft::random::device::counter_rng rng)
+{
+  size_t stride = size_t(blockDim.x) * gridDim.x;
+  for (size_t idx = blockIdx.x * size_t(blockDim.x) + threadIdx.x; idx < len; idx += stride) {
+    z[idx] = rng.normal<T>(idx);
+  }
+}
+
+template <typename T>
+__global__ void add_means_kernel(T* out, const T* means, int n_points, int dim, size_t len)
+{
+  size_t stride = size_t(blockDim.x) * gridDim.x;
+  for (size_t idx = blockIdx.x * size_t(blockDim.x) + threadIdx.x; idx < len; idx += stride) {
+    auto b = idx / (size_t(n_points) * dim);
+    out[idx] += means[b * dim + idx % dim];
+  }
+}
+
+/** Sample the points [batch, n_points, dim] of a batch of factorized Gaussians. */
+template <typename T>
+void sample_factorized_gaussian(raft::resources const& handle,
+                                const T* factors,
+                                const T* means,
+                                T* out,
+                                int batch,
+                                int n_points,
+                                int dim,
+                                bool triangular,
+                                const raft::random::device::counter_rng& rng)
+{
+  auto stream = resource::get_cuda_stream(handle);
+  if (batch == 0 || n_points == 0 || dim == 0) { return; }
+  constexpr int kThreads = 128;
+  size_t smem            = sizeof(T) * (size_t(dim) * dim + size_t(kThreads) * dim);
+  if (smem <= kFactorizedGaussianMaxSmem) {
+    dim3 grid(raft::ceildiv(n_points, kThreads), std::min(batch, 65535));
+    factorized_gaussian_kernel<<<grid, kThreads, smem, stream>>>(
+      out, factors, means, batch, n_points, dim, triangular, rng);
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+    return;
+  }
+
+  // the same normals in the global memory, then a batched GEMM
+  size_t len    = size_t(batch) * n_points * dim;
+  auto n_blocks = int(std::min<size_t>(raft::ceildiv<size_t>(len, 256), 65536));
+  rmm::device_uvector<T> z(len, stream);
+  factorized_gaussian_normals_kernel<<<n_blocks, 256, 0, stream>>>(z.data(), len, rng);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+  T alpha     = T(1);
+  T beta      = T(0);
+  auto cublas = resource::get_cublas_handle(handle);
+  RAFT_CUBLAS_TRY(raft::linalg::detail::cublasgemmStridedBatched(cublas,
+                                                                 CUBLAS_OP_N,
+                                                                 CUBLAS_OP_N,
+                                                                 dim,
+                                                                 n_points,
+                                                                 dim,
+                                                                 &alpha,
+                                                                 factors,
+                                                                 dim,
+                                                                 int64_t(dim) * dim,
+                                                                 z.data(),
+                                                                 dim,
+                                                                 int64_t(n_points) * dim,
+                                                                 &beta,
+                                                                 out,
+                                                                 dim,
+                                                                 int64_t(n_points) * dim,
+                                                                 batch,
+                                                                 stream));
+  if (means != nullptr) {
+    add_means_kernel<<<n_blocks, 256, 0, stream>>>(out, means, n_points, dim, len);
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+  }
+}
+
+}  // namespace raft::random::detail
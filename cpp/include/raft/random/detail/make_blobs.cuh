@@ -16,14 +16,20 @@
 
 #pragma once
 
+#include "bin_file_writer.hpp"
 #include "permute.cuh"
 #include <raft/core/handle.hpp>
 #include <raft/linalg/map.cuh>
+#include <raft/random/device/philox.cuh>
 #include <raft/random/rng.cuh>
 #include <raft/random/rng_device.cuh>
 #include <raft/util/cuda_utils.cuh>
 #include <raft/util/cudart_utils.hpp>
 #include <rmm/device_uvector.hpp>
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <type_traits>
 #include <vector>
 
 namespace raft {
@@ -253,6 +259,174 @@ void make_blobs_caller(DataT* out,
                 r);
 }
 
+/** A generated value, rounded and clamped to the range of an integral output type. */
+template <typename OutT, typename DataT>
+HDI OutT blobs_output_value(DataT val)
+{
+  if constexpr (std::is_integral_v<OutT>) {
+    constexpr auto lo = DataT(std::numeric_limits<OutT>::lowest());
+    constexpr auto hi = DataT(std::numeric_limits<OutT>::max());
+    return OutT(raft::min(raft::max(rint(val), lo), hi));
+  } else {
+    return OutT(val);
+  }
+}
+
+/**
+ * The rows `row_offset` to `row_offset + n_rows - 1` of the blobs. Unlike `generate_data_kernel`,
+ * every element is a function of its position in the whole dataset only: the label of the row `i`
+ * is the affine map `(a * i + b) % n_clusters` of `generate_labels` and the element `(i, j)` is
+ * the normal `i * n_cols + j` of the counter-based stream `rng`.
+ */
+template <typename OutT, typename DataT, typename IdxT>
+__global__ void generate_blobs_shard_kernel(OutT* out,
+                                            IdxT* labels,
+                                            IdxT n_rows,
+                                            IdxT n_cols,
+                                            IdxT row_offset,
+                                            bool row_major,
+                                            const DataT* centers,
+                                            bool centers_row_major,
+                                            const DataT* cluster_std,
+                                            DataT cluster_std_scalar,
+                                            IdxT n_clusters,
+                                            uint64_t label_a,
+                                            uint64_t label_b,
+                                            raft::random::device::counter_rng rng)
+{
+  size_t len    = size_t(n_rows) * size_t(n_cols);
+  size_t stride = size_t(blockDim.x) * gridDim.x;
+  for (size_t idx = blockIdx.x * size_t(blockDim.x) + threadIdx.x; idx < len; idx += stride) {
+    IdxT row, col;
+    if (row_major) {
+      row = IdxT(idx / n_cols);
+      col = IdxT(idx % n_cols);
+    } else {
+      row = IdxT(idx % n_rows);
+      col = IdxT(idx / n_rows);
+    }
+    uint64_t global_row = uint64_t(row_offset) + uint64_t(row);
+    auto label          = IdxT((label_a * global_row + label_b) % uint64_t(n_clusters));
+    if (labels != nullptr && col == 0) { labels[row] = label; }
+    DataT mu    = centers_row_major ? centers[size_t(label) * n_cols + col]
+                                    : centers[label + size_t(col) * n_clusters];
+    DataT sigma = cluster_std == nullptr ? cluster_std_scalar : cluster_std[label];
+    out[idx]    = blobs_output_value<OutT>(rng.normal<DataT>(global_row * n_cols + col, mu, sigma));
+  }
+}
+
+/**
+ * The rows `row_offset` to `row_offset + n_rows - 1` of the blobs of a seed: the centers and the
+ * labelling are drawn from the seed alone, so that every shard draws the same ones.
+ */
+template <typename OutT, typename DataT, typename IdxT>
+void make_blobs_shard_caller(OutT* out,
+                             IdxT* labels,
+                             IdxT n_rows,
+                             IdxT n_cols,
+                             IdxT row_offset,
+                             IdxT n_clusters,
+                             cudaStream_t stream,
+                             bool row_major,
+                             const DataT* centers,
+                             bool centers_row_major,
+                             const DataT* cluster_std,
+                             const DataT cluster_std_scalar,
+                             bool shuffle,
+                             DataT center_box_min,
+                             DataT center_box_max,
+                             uint64_t seed)
+{
+  raft::random::RngState r(seed, GenPC);
+  rmm::device_uvector<DataT> rand_centers(0, stream);
+  if (centers == nullptr) {
+    rand_centers.resize(size_t(n_clusters) * n_cols, stream);
+    detail::uniform(
+      r, rand_centers.data(), n_clusters * n_cols, center_box_min, center_box_max, stream);
+    centers           = rand_centers.data();
+    centers_row_major = true;
+  }
+  uint64_t label_a = 1;
+  uint64_t label_b = 0;
+  if (shuffle) {
+    IdxT a, b;
+    raft::random::affine_transform_params(r, n_clusters, a, b);
+    label_a = a;
+    label_b = b;
+  }
+
+  constexpr int block_size = 256;
+  size_t len               = size_t(n_rows) * size_t(n_cols);
+  if (len == 0) { return; }
+  auto n_blocks = std::min<size_t>(raft::ceildiv<size_t>(len, block_size), 65536);
+  generate_blobs_shard_kernel<<<n_blocks, block_size, 0, stream>>>(
+    out,
+    labels,
+    n_rows,
+    n_cols,
+    row_offset,
+    row_major,
+    centers,
+    centers_row_major,
+    cluster_std,
+    cluster_std_scalar,
+    n_clusters,
+    label_a,
+    label_b,
+    raft::random::device::counter_rng(r));
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+/**
+ * Write the rows of the shard `rank` of `n_ranks` of the blobs of a seed to a file, by batches of
+ * `batch_rows` rows generated on the device.
+ */
+template <typename OutT, typename DataT, typename IdxT>
+void make_blobs_file_caller(raft::resources const& handle,
+                            const std::string& path,
+                            IdxT n_rows,
+                            IdxT n_cols,
+                            IdxT n_clusters,
+                            const DataT cluster_std_scalar,
+                            bool shuffle,
+                            DataT center_box_min,
+                            DataT center_box_max,
+                            uint64_t seed,
+                            IdxT row_offset,
+                            IdxT shard_rows,
+                            IdxT batch_rows,
+                            bool owner)
+{
+  auto stream = resource::get_cuda_stream(handle);
+  bin_file_writer<OutT> file(path, n_rows, n_cols, owner);
+  if (batch_rows <= 0) { batch_rows = IdxT(std::max<size_t>(1, (size_t(1) << 24) / n_cols)); }
+  batch_rows = std::min(batch_rows, shard_rows);
+  rmm::device_uvector<OutT> d_batch(size_t(batch_rows) * n_cols, stream);
+  std::vector<OutT> h_batch(size_t(batch_rows) * n_cols);
+  for (IdxT row = 0; row < shard_rows; row += batch_rows) {
+    auto rows = std::min(batch_rows, shard_rows - row);
+    make_blobs_shard_caller<OutT, DataT, IdxT>(d_batch.data(),
+                                               nullptr,
+                                               rows,
+                                               n_cols,
+                                               row_offset + row,
+                                               n_clusters,
+                                               stream,
+                                               true,
+                                               nullptr,
+                                               true,
+                                               nullptr,
+                                               cluster_std_scalar,
+                                               shuffle,
+                                               center_box_min,
+                                               center_box_max,
+                                               seed);
+    raft::update_host(h_batch.data(), d_batch.data(), size_t(rows) * n_cols, stream);
+    resource::sync_stream(handle, stream);
+    file.write(h_batch.data(), uint64_t(row_offset + row), uint64_t(rows));
+  }
+}
+
 }  // end namespace detail
 }  // end namespace random
 }  // end namespace raft
@@ -18,9 +18,21 @@
 
 #include <cooperative_groups.h>
 #include <memory>
+#include <raft/core/mdspan.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
 #include <raft/util/cuda_utils.cuh>
 #include <raft/util/cudart_utils.hpp>
 #include <raft/util/vectorized.cuh>
+#include <rmm/device_uvector.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <utility>
+#include <vector>
 
 namespace raft::random {
 namespace detail {
@@ -120,23 +132,23 @@ struct permute_impl_t<Type, IntType, IdxType, TPB, rowMajor, 1> {
   }
 };
 
+/**
+ * Permute the rows with the affine map `in_row = (a * out_row + b) % N`; `a` must be coprime to N
+ * for the map to be a permutation.
+ */
 template <typename Type, typename IntType = int, typename IdxType = int, int TPB = 256>
-void permute(IntType* perms,
-             Type* out,
-             const Type* in,
-             IntType D,
-             IntType N,
-             bool rowMajor,
-             cudaStream_t stream)
+void permute_affine(IntType* perms,
+                    Type* out,
+                    const Type* in,
+                    IntType D,
+                    IntType N,
+                    IdxType a,
+                    IdxType b,
+                    bool rowMajor,
+                    cudaStream_t stream)
 {
   auto nblks = raft::ceildiv(N, (IntType)TPB);
 
-  // always keep 'a' to be coprime to N
-  IdxType a = rand() % N;
-  while (raft::gcd(a, N) != 1)
-    a = (a + 1) % N;
-  IdxType b = rand() % N;
-
   if (rowMajor) {
     permute_impl_t<Type,
                    IntType,
@@ -158,5 +170,175 @@ void permute(IntType* perms,
   }
 }
 
+template <typename Type, typename IntType = int, typename IdxType = int, int TPB = 256>
+void permute(IntType* perms,
+             Type* out,
+             const Type* in,
+             IntType D,
+             IntType N,
+             bool rowMajor,
+             cudaStream_t stream)
+{
+  // always keep 'a' to be coprime to N
+  IdxType a = rand() % N;
+  while (raft::gcd(a, N) != 1)
+    a = (a + 1) % N;
+  IdxType b = rand() % N;
+
+  permute_affine<Type, IntType, IdxType, TPB>(perms, out, in, D, N, a, b, rowMajor, stream);
+}
+
+/** Draw the parameters of a random affine permutation `i -> (a * i + b) % n` of [0, n). */
+template <typename IdxT>
+auto random_affine_map(IdxT n, std::mt19937_64& gen) -> std::pair<IdxT, IdxT>
+{
+  if (n <= 1) { return {IdxT(1), IdxT(0)}; }
+  IdxT a = std::uniform_int_distribution<IdxT>(1, n - 1)(gen);
+  while (std::gcd(a, n) != 1) {
+    a = a % (n - 1) + 1;
+  }
+  IdxT b = std::uniform_int_distribution<IdxT>(0, n - 1)(gen);
+  return {a, b};
+}
+
+/**
+ * Permute the rows in place by following the cycles of a random affine permutation.
+ *
+ * The permutation is computed on the fly, so the only extra memory is one row and a bitmap with
+ * one bit per row marking the rows already moved. The rows of the host matrices are moved with
+ * `memcpy`, the rows of the device matrices with one `cudaMemcpyAsync` each.
+ */
+template <typename T, typename IdxT, typename Accessor>
+void permute_inplace_exact(
+  raft::resources const& handle,
+  std::mt19937_64& gen,
+  raft::mdspan<T, raft::matrix_extent<IdxT>, raft::row_major, Accessor> data)
+{
+  constexpr bool kHostCopy = Accessor::is_host_accessible && !Accessor::is_device_accessible;
+  const uint64_t n_rows    = data.extent(0);
+  const uint64_t dim       = data.extent(1);
+  const size_t row_bytes   = sizeof(T) * dim;
+  if (n_rows < 2 || dim == 0) { return; }
+  auto stream = resource::get_cuda_stream(handle);
+
+  const auto [a, b] = random_affine_map<uint64_t>(n_rows, gen);
+  // the row moved to the position `i`
+  auto source = [a = a, b = b, n_rows](uint64_t i) {
+    return static_cast<uint64_t>((static_cast<unsigned __int128>(a) * i + b) % n_rows);
+  };
+
+  auto row = [base = data.data_handle(), dim](uint64_t i) { return base + i * dim; };
+  std::vector<T> tmp_host(kHostCopy ? dim : 0);
+  rmm::device_uvector<T> tmp_dev(kHostCopy ? 0 : dim, stream);
+  T* tmp        = kHostCopy ? tmp_host.data() : tmp_dev.data();
+  auto copy_row = [&](T* dst, const T* src) {
+    if constexpr (kHostCopy) {
+      std::memcpy(dst, src, row_bytes);
+    } else {
+      RAFT_CUDA_TRY(cudaMemcpyAsync(dst, src, row_bytes, cudaMemcpyDefault, stream));
+    }
+  };
+
+  std::vector<uint64_t> visited(raft::ceildiv<uint64_t>(n_rows, 64), 0);
+  auto mark = [&visited](uint64_t i) { visited[i / 64] |= uint64_t(1) << (i % 64); };
+  for (uint64_t start = 0; start < n_rows; start++) {
+    if (visited[start / 64] & (uint64_t(1) << (start % 64))) { continue; }
+    mark(start);
+    uint64_t src = source(start);
+    if (src == start) { continue; }
+    copy_row(tmp, row(start));
+    uint64_t dst = start;
+    while (src != start) {
+      copy_row(row(dst), row(src));
+      dst = src;
+      mark(dst);
+      src = source(dst);
+    }
+    copy_row(row(dst), tmp);
+  }
+  resource::sync_stream(handle, stream);
+}
+
+/**
+ * Permute the blocks of `block_rows` rows in place and shuffle the rows within every block.
+ *
+ * The order of the blocks is a uniform random permutation, applied by following its cycles; every
+ * block is shuffled with a random affine permutation on its way to the new position. The blocks are
+ * staged through three device buffers of `block_rows` rows. The last `n_rows % block_rows` rows are
+ * shuffled among themselves and swapped with a random range of rows.
+ */
+template <typename T, typename IdxT, typename Accessor>
+void permute_inplace_blockwise(
+  raft::resources const& handle,
+  std::mt19937_64& gen,
+  raft::mdspan<T, raft::matrix_extent<IdxT>, raft::row_major, Accessor> data,
+  uint64_t block_rows)
+{
+  const uint64_t n_rows = data.extent(0);
+  const uint64_t dim    = data.extent(1);
+  if (n_rows < 2 || dim == 0) { return; }
+  auto stream = resource::get_cuda_stream(handle);
+
+  block_rows              = std::min(block_rows, n_rows);
+  const uint64_t n_blocks = n_rows / block_rows;
+  const uint64_t n_tail   = n_rows - n_blocks * block_rows;
+
+  auto row   = [base = data.data_handle(), dim](uint64_t i) { return base + i * dim; };
+  auto block = [&row, block_rows](uint64_t i) { return row(i * block_rows); };
+
+  rmm::device_uvector<T> saved(block_rows * dim, stream);
+  rmm::device_uvector<T> staged(block_rows * dim, stream);
+  rmm::device_uvector<T> shuffled(block_rows * dim, stream);
+  auto copy_rows = [&](T* dst, const T* src, uint64_t n) {
+    RAFT_CUDA_TRY(cudaMemcpyAsync(dst, src, sizeof(T) * n * dim, cudaMemcpyDefault, stream));
+  };
+  // Shuffle `n` rows of the device buffer `src` into `dst`
+  auto shuffle_rows = [&](T* dst, const T* src, uint64_t n) {
+    const auto [a, b] = random_affine_map<int64_t>(n, gen);
+    permute_affine<T, int64_t, int64_t>(
+      nullptr, shuffled.data(), src, int64_t(dim), int64_t(n), a, b, true, stream);
+    copy_rows(dst, shuffled.data(), n);
+  };
+
+  // the block moved to the position `i`
+  std::vector<uint64_t> source(n_blocks);
+  std::iota(source.begin(), source.end(), 0);
+  std::shuffle(source.begin(), source.end(), gen);
+  std::vector<bool> visited(n_blocks, false);
+  for (uint64_t start = 0; start < n_blocks; start++) {
+    if (visited[start]) { continue; }
+    visited[start] = true;
+    uint64_t src   = source[start];
+    if (src == start) {
+      copy_rows(staged.data(), block(start), block_rows);
+      shuffle_rows(block(start), staged.data(), block_rows);
+      continue;
+    }
+    copy_rows(saved.data(), block(start), block_rows);
+    uint64_t dst = start;
+    while (src != start) {
+      copy_rows(staged.data(), block(src), block_rows);
+      shuffle_rows(block(dst), staged.data(), block_rows);
+      dst          = src;
+      visited[dst] = true;
+      src          = source[dst];
+    }
+    shuffle_rows(block(dst), saved.data(), block_rows);
+  }
+
+  if (n_tail > 0) {
+    T* tail = row(n_blocks * block_rows);
+    copy_rows(staged.data(), tail, n_tail);
+    shuffle_rows(tail, staged.data(), n_tail);
+    // The tail is shorter than a block, so the range does not overlap it
+    const uint64_t offset =
+      std::uniform_int_distribution<uint64_t>(0, n_blocks * block_rows - n_tail)(gen);
+    copy_rows(staged.data(), row(offset), n_tail);
+    copy_rows(row(offset), tail, n_tail);
+    copy_rows(tail, staged.data(), n_tail);
+  }
+  resource::sync_stream(handle, stream);
+}
+
 };  // end namespace detail
 };  // end namespace raft::random
\ No newline at end of file
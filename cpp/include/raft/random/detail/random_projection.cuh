@@ -0,0 +1,367 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/random/device/philox.cuh>
+#include <raft/random/rng_state.hpp>
+#include <raft/sparse/linalg/spmm.cuh>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+#include <raft/util/reduction.cuh>
+#include <raft/util/warp_primitives.cuh>
+#include <rmm/device_uvector.hpp>
+
+#include <thrust/scan.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+namespace raft::random::detail {
+
+/** The streams of the projections, relative to the base subsequence of the state. */
+constexpr uint64_t kProjectionMatrixStream = 0;
+constexpr uint64_t kProjectionSampleStream = 1;
+
+/** The element `(row, col)` of the Gaussian projection matrix, `N(0, 1)` [n_features, k]. */
+template <typename T>
+HDI T gaussian_projection_element(const device::counter_rng& rng,
+                                  int64_t row,
+                                  int64_t col,
+                                  int64_t k)
+{
+  return rng.normal<T>(uint64_t(row * k + col));
+}
+
+/**
+ * y = x * R * scale, with the Gaussian R [d, k] generated tile by tile in the shared memory and
+ * never stored: every block computes a [TileM, TileN] tile of y, every thread [TileM / 16, 4]
+ * values of it; every thread generates four consecutive values of the tile of R from a single
+ * Philox block when the rows of R are aligned.
+ */
+template <typename T, typename IdxT, int TileM = 128, int TileN = 64, int TileK = 16>
+__global__ __launch_bounds__(256) void gaussian_projection_kernel(
+  const T* x, T* y, IdxT n, IdxT d, IdxT k, device::counter_rng rng, T scale)
+{
+  constexpr int kThreads    = 256;
+  constexpr int kThreadCols = TileN / 4;
+  constexpr int kRowsPerTh  = TileM / (kThreads / kThreadCols);
+  static_assert(TileK * TileN == 4 * kThreads, "every thread generates four values of R");
+
+  __shared__ T xs[TileK][TileM];
+  __shared__ T rs[TileK][TileN];
+
+  const IdxT row0 = IdxT(blockIdx.y) * TileM;
+  const IdxT col0 = IdxT(blockIdx.x) * TileN;
+  const int tx    = threadIdx.x % kThreadCols;
+  const int ty    = threadIdx.x / kThreadCols;
+
+  T acc[kRowsPerTh][4];
+#pragma unroll
+  for (int i = 0; i < kRowsPerTh; i++) {
+#pragma unroll
+    for (int j = 0; j < 4; j++) {
+      acc[i][j] = T(0);
+    }
+  }
+
+  const bool aligned = k % 4 == 0;
+  for (IdxT k0 = 0; k0 < d; k0 += TileK) {
+    for (int e = threadIdx.x; e < TileM * TileK; e += kThreads) {
+      const int r   = e / TileK;
+      const int kk  = e % TileK;
+      const IdxT gr = row0 + r;
+      const IdxT gk = k0 + kk;
+      xs[kk][r]     = gr < n && gk < d ? x[int64_t(gr) * d + gk] : T(0);
+    }
+    {
+      const int kk  = threadIdx.x / kThreadCols;
+      const int c   = tx * 4;
+      const IdxT gk = k0 + kk;
+      const IdxT gc = col0 + c;
+      T v[4];
+      if (aligned && gk < d && gc < k) {
+        rng.normal4<T>(uint64_t(int64_t(gk) * k + gc) / 4, v);
+      } else {
+#pragma unroll
+        for (int j = 0; j < 4; j++) {
+          v[j] = gk < d && gc + j < k ? gaussian_projection_element<T>(rng, gk, gc + j, k) : T(0);
+        }
+      }
+#pragma unroll
+      for (int j = 0; j < 4; j++) {
+        rs[kk][c + j] = v[j] * scale;
+      }
+    }
+    __syncthreads();
+#pragma unroll
+    for (int kk = 0; kk < TileK; kk++) {
+      T a[kRowsPerTh];
+      T b[4];
+#pragma unroll
+      for (int i = 0; i < kRowsPerTh; i++) {
+        a[i] = xs[kk][ty * kRowsPerTh + i];
+      }
+#pragma unroll
+      for (int j = 0; j < 4; j++) {
+        b[j] = rs[kk][tx * 4 + j];
+      }
+#pragma unroll
+      for (int i = 0; i < kRowsPerTh; i++) {
+#pragma unroll
+        for (int j = 0; j < 4; j++) {
+          acc[i][j] += a[i] * b[j];
+        }
+      }
+    }
+    __syncthreads();
+  }
+
+#pragma unroll
+  for (int i = 0; i < kRowsPerTh; i++) {
+    const IdxT row = row0 + ty * kRowsPerTh + i;
+    if (row >= n) { continue; }
+#pragma unroll
+    for (int j = 0; j < 4; j++) {
+      const IdxT col = col0 + tx * 4 + j;
+      if (col < k) { y[int64_t(row) * k + col] = acc[i][j]; }
+    }
+  }
+}
+
+template <typename T, typename IdxT>
+void gaussian_projection(raft::resources const& handle,
+                         const RngState& rng_state,
+                         const T* x,
+                         T* y,
+                         IdxT n,
+                         IdxT d,
+                         IdxT k)
+{
+  constexpr int kTileM = 128;
+  constexpr int kTileN = 64;
+  auto stream          = resource::get_cuda_stream(handle);
+  device::counter_rng rng(rng_state, kProjectionMatrixStream);
+  T scale = T(1) / std::sqrt(T(k));
+  dim3 grid(raft::ceildiv<IdxT>(k, kTileN), raft::ceildiv<IdxT>(n, kTileM));
+  RAFT_EXPECTS(grid.y <= 65535u, "Too many rows for a single call; project them in batches");
+  gaussian_projection_kernel<T, IdxT, kTileM, kTileN><<<grid, 256, 0, stream>>>(
+    x, y, n, d, k, rng, scale);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+/**
+ * Whether element `(row, col)` of the sparse projection matrix is non-zero (with probability
+ * `density`) and its sign, from a single random word.
+ */
+HDI bool sparse_projection_element(const device::counter_rng& rng,
+                                   int64_t row,
+                                   int64_t col,
+                                   int64_t n_cols,
+                                   double density,
+                                   bool& neg)
+{
+  uint32_t u = rng.u32(uint64_t(row * n_cols + col));
+  neg        = u & 1u;
+  return double(u >> 1) < density * double(uint32_t(1) << 31);
+}
+
+/** The number of non-zeros of every row; one warp per row. */
+template <typename IdxT>
+__global__ void sparse_projection_count_kernel(
+  IdxT* row_nnz, device::counter_rng rng, IdxT n_rows, IdxT n_cols, double density)
+{
+  const int64_t row = (blockIdx.x * int64_t(blockDim.x) + threadIdx.x) / raft::WarpSize;
+  const int lane    = raft::laneId();
+  if (row >= n_rows) { return; }
+  IdxT count = 0;
+  for (IdxT col = lane; col < n_cols; col += raft::WarpSize) {
+    bool neg;
+    count += sparse_projection_element(rng, row, col, n_cols, density, neg);
+  }
+  count = raft::warpReduce(count);
+  if (lane == 0) { row_nnz[row] = count; }
+}
+
+/** The sorted column indices and the values of every row; one warp per row. */
+template <typename T, typename IdxT>
+__global__ void sparse_projection_fill_kernel(IdxT* indices,
+                                              T* values,
+                                              const IdxT* indptr,
+                                              device::counter_rng rng,
+                                              IdxT n_rows,
+                                              IdxT n_cols,
+                                              double density,
+                                              T value)
+{
+  const int64_t row = (blockIdx.x * int64_t(blockDim.x) + threadIdx.x) / raft::WarpSize;
+  const int lane    = raft::laneId();
+  if (row >= n_rows) { return; }
+  IdxT pos = indptr[row];
+  for (IdxT col0 = 0; col0 < n_cols; col0 += raft::WarpSize) {
+    IdxT col      = col0 + lane;
+    bool neg      = false;
+    bool nz       = col < n_cols && sparse_projection_element(rng, row, col, n_cols, density, neg);
+    uint32_t mask = raft::ballot(nz);
+    if (nz) {
+      IdxT p     = pos + __popc(mask & ((1u << lane) - 1u));
+      indices[p] = col;
+      values[p]  = neg ? -value : value;
+    }
+    pos += __popc(mask);
+  }
+}
+
+template <typename T>
+auto make_sparse_projection(raft::resources const& handle,
+                            const RngState& rng_state,
+                            int n_features,
+                            int n_components,
+                            double density) -> raft::device_csr_matrix<T, int, int, int>
+{
+  RAFT_EXPECTS(n_features > 0 && n_components > 0, "The dimensions must be positive");
+  if (density <= 0) { density = 1.0 / std::sqrt(double(n_features)); }
+  RAFT_EXPECTS(density <= 1, "The density must be in (0, 1]");
+  auto stream = resource::get_cuda_stream(handle);
+  device::counter_rng rng(rng_state, kProjectionMatrixStream);
+
+  // R^T: the rows are the components
+  auto csr = raft::make_device_csr_matrix<T, int, int, int>(handle, n_components, n_features);
+  rmm::device_uvector<int> indptr(n_components + 1, stream);
+  RAFT_CUDA_TRY(cudaMemsetAsync(indptr.data(), 0, sizeof(int), stream));
+  constexpr int kThreads = 256;
+  auto n_blocks          = raft::ceildiv<int64_t>(int64_t(n_components) * raft::WarpSize, kThreads);
+  sparse_projection_count_kernel<int><<<n_blocks, kThreads, 0, stream>>>(
+    indptr.data() + 1, rng, n_components, n_features, density);
+  thrust::inclusive_scan(resource::get_thrust_policy(handle),
+                         indptr.data() + 1,
+                         indptr.data() + n_components + 1,
+                         indptr.data() + 1);
+  int nnz = 0;
+  raft::update_host(&nnz, indptr.data() + n_components, 1, stream);
+  resource::sync_stream(handle, stream);
+
+  csr.initialize_sparsity(nnz);
+  auto structure = csr.structure_view();
+  raft::copy(structure.get_indptr().data(), indptr.data(), n_components + 1, stream);
+  T value = T(1.0 / std::sqrt(density * double(n_components)));
+  sparse_projection_fill_kernel<T, int><<<n_blocks, kThreads, 0, stream>>>(
+    structure.get_indices().data(),
+    csr.get_elements().data(),
+    indptr.data(),
+    rng,
+    n_components,
+    n_features,
+    density,
+    value);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+  return csr;
+}
+
+/**
+ * The subsampled randomized Hadamard transform of every row, one block per row:
+ * y = sqrt(d' / k) * S * H * D * x, with the signs D, the (orthonormal) Walsh-Hadamard transform H
+ * of the row zero-padded to d' = 2^ceil(log2(d)) and the sample S of k of the d' coordinates.
+ */
+template <typename T, typename IdxT>
+__global__ void srht_kernel(const T* x,
+                            T* y,
+                            const int* sample,
+                            IdxT d,
+                            IdxT d_pad,
+                            IdxT k,
+                            device::counter_rng rng,
+                            T scale)
+{
+  extern __shared__ char smem_bytes[];
+  T* s = reinterpret_cast<T*>(smem_bytes);
+
+  const T* row_x = x + int64_t(blockIdx.x) * d;
+  for (IdxT j = threadIdx.x; j < d_pad; j += blockDim.x) {
+    T v  = j < d ? row_x[j] : T(0);
+    s[j] = (rng.u32(j) & 1u) ? -v : v;
+  }
+  __syncthreads();
+  for (IdxT h = 1; h < d_pad; h *= 2) {
+    for (IdxT p = threadIdx.x; p < d_pad / 2; p += blockDim.x) {
+      IdxT i   = (p / h) * 2 * h + p % h;
+      T a      = s[i];
+      T b      = s[i + h];
+      s[i]     = a + b;
+      s[i + h] = a - b;
+    }
+    __syncthreads();
+  }
+  T* row_y = y + int64_t(blockIdx.x) * k;
+  for (IdxT c = threadIdx.x; c < k; c += blockDim.x) {
+    row_y[c] = s[sample[c]] * scale;
+  }
+}
+
+template <typename T, typename IdxT>
+void srht_projection(raft::resources const& handle,
+                     const RngState& rng_state,
+                     const T* x,
+                     T* y,
+                     IdxT n,
+                     IdxT d,
+                     IdxT k)
+{
+  auto stream = resource::get_cuda_stream(handle);
+  IdxT d_pad  = 1;
+  while (d_pad < d) {
+    d_pad *= 2;
+  }
+  RAFT_EXPECTS(k <= d_pad, "The number of components must not exceed the padded dimension");
+  size_t smem_size = size_t(d_pad) * sizeof(T);
+  RAFT_EXPECTS(smem_size <= 48 * 1024,
+               "The padded dimension is too large for the shared memory of a block");
+
+  // the same k distinct coordinates for all the rows (Floyd's algorithm)
+  device::counter_rng sample_rng(rng_state, kProjectionSampleStream);
+  std::unordered_set<int> picked;
+  std::vector<int> h_sample;
+  h_sample.reserve(k);
+  uint64_t draw = 0;
+  for (int64_t j = int64_t(d_pad) - k; j < int64_t(d_pad); j++) {
+    auto t = int(sample_rng.u64(draw++) % uint64_t(j + 1));
+    if (!picked.insert(t).second) {
+      picked.insert(int(j));
+      t = int(j);
+    }
+    h_sample.push_back(t);
+  }
+  std::sort(h_sample.begin(), h_sample.end());
+  rmm::device_uvector<int> sample(k, stream);
+  raft::update_device(sample.data(), h_sample.data(), k, stream);
+
+  device::counter_rng sign_rng(rng_state, kProjectionMatrixStream);
+  // the butterflies compute sqrt(d') * H: sqrt(d' / k) * H = butterflies / sqrt(k)
+  T scale     = T(1) / std::sqrt(T(k));
+  int threads = std::min<int>(256, std::max<int>(raft::WarpSize, d_pad / 2));
+  srht_kernel<T, IdxT>
+    <<<n, threads, smem_size, stream>>>(x, y, sample.data(), d, d_pad, k, sign_rng, scale);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+}  // namespace raft::random::detail
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include "bin_file_writer.hpp"
 #include "rmat_rectangular_generator_types.cuh"
 
 #include <raft/core/resource/cuda_stream.hpp>
@@ -25,6 +26,12 @@
 #include <raft/util/cuda_utils.cuh>
 #include <raft/util/cudart_utils.hpp>
 
+#include <rmm/device_uvector.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
 namespace raft {
 namespace random {
 namespace detail {
@@ -300,6 +307,64 @@ void rmat_rectangular_gen_impl(raft::resources const& handle,
                                       r);
 }
 
+/**
+ * @brief The state generating the edges `edge_offset` onwards of the graph of the state `r`: the
+ * edge `i` of a call is generated from the subsequence `r.base_subsequence + i` alone.
+ */
+inline auto rmat_shard_state(const raft::random::RngState& r, uint64_t edge_offset)
+  -> raft::random::RngState
+{
+  raft::random::RngState shard = r;
+  shard.base_subsequence += edge_offset;
+  return shard;
+}
+
+/**
+ * @brief Write the edges `edge_offset` to `edge_offset + shard_edges - 1` of the graph of the
+ * state `r` to the [n_edges, 2] matrix of a file, by batches of `batch_edges` edges.
+ */
+template <typename IdxT, typename ProbT>
+void rmat_rectangular_gen_file_caller(raft::resources const& handle,
+                                      const raft::random::RngState& r,
+                                      const std::string& path,
+                                      IdxT n_edges,
+                                      ProbT a,
+                                      ProbT b,
+                                      ProbT c,
+                                      IdxT r_scale,
+                                      IdxT c_scale,
+                                      IdxT edge_offset,
+                                      IdxT shard_edges,
+                                      IdxT batch_edges,
+                                      bool owner)
+{
+  auto stream = resource::get_cuda_stream(handle);
+  bin_file_writer<IdxT> file(path, n_edges, 2, owner);
+  if (batch_edges <= 0) { batch_edges = IdxT(1) << 23; }
+  batch_edges = std::min(batch_edges, shard_edges);
+  rmm::device_uvector<IdxT> d_batch(size_t(batch_edges) * 2, stream);
+  std::vector<IdxT> h_batch(size_t(batch_edges) * 2);
+  // every batch advances the state by its edges, to the state of the next batch
+  auto state = rmat_shard_state(r, uint64_t(edge_offset));
+  for (IdxT edge = 0; edge < shard_edges; edge += batch_edges) {
+    auto edges = std::min(batch_edges, shard_edges - edge);
+    rmat_rectangular_gen_caller(d_batch.data(),
+                                static_cast<IdxT*>(nullptr),
+                                static_cast<IdxT*>(nullptr),
+                                a,
+                                b,
+                                c,
+                                r_scale,
+                                c_scale,
+                                edges,
+                                stream,
+                                state);
+    raft::update_host(h_batch.data(), d_batch.data(), size_t(edges) * 2, stream);
+    resource::sync_stream(handle, stream);
+    file.write(h_batch.data(), uint64_t(edge_offset + edge), uint64_t(edges));
+  }
+}
+
 }  // end namespace detail
 }  // end namespace random
 }  // end namespace raft
@@ -422,7 +422,7 @@ DI void custom_next(
 {
   OutType res;
   gen.next(res);
-  params.inIdxPtr[idx]  = idx;
+  if (params.inIdxPtr != nullptr) { params.inIdxPtr[idx] = idx; }
   constexpr OutType one = (OutType)1.0;
   auto exp              = -raft::log(one - res);
   if (params.wts != nullptr) {
@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "rng_impl.cuh"
+
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/matrix/detail/select_k.cuh>
+#include <raft/random/device/philox.cuh>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+#include <raft/util/detail/cub_wrappers.cuh>
+#include <raft/util/scatter.cuh>
+
+#include <rmm/device_uvector.hpp>
+
+#include <algorithm>
+
+namespace raft::random::detail {
+
+/** Up to `len / kSampleSelectRatio` samples, selecting the smallest keys beats sorting them. */
+constexpr int kSampleSelectRatio = 8;
+/** The batched and the streaming samplers generate at most that many keys at a time. */
+constexpr size_t kSampleMaxKeys = size_t(1) << 26;
+
+/**
+ * The Efraimidis-Spirakis key of the element `i` of weight `w`: `E / w` for a standard
+ * exponential `E`, so that the elements of the `k` smallest keys are a weighted sample without
+ * replacement (the same key as the one of `SamplingParams`).
+ */
+template <typename WeightsT>
+HDI WeightsT exponential_key(const device::counter_rng& rng, uint64_t i, WeightsT w)
+{
+  // 1 - u in (0, 1]: the logarithm is finite
+  return -raft::log(WeightsT(1) - rng.uniform<WeightsT>(i)) / w;
+}
+
+/**
+ * The keys [n_rows, len] of the elements `offset` to `offset + len - 1`, the row `r` of the
+ * stream `subsequence + r`; optionally, their indices `offset + j` too.
+ */
+template <typename WeightsT, typename IdxT>
+__global__ void exponential_keys_kernel(WeightsT* keys,
+                                        IdxT* indices,
+                                        const WeightsT* wts,
+                                        IdxT n_rows,
+                                        IdxT len,
+                                        uint64_t seed,
+                                        uint64_t subsequence,
+                                        IdxT offset)
+{
+  size_t n      = size_t(n_rows) * size_t(len);
+  size_t stride = size_t(blockDim.x) * gridDim.x;
+  for (size_t i = blockIdx.x * size_t(blockDim.x) + threadIdx.x; i < n; i += stride) {
+    auto r = IdxT(i / len);
+    auto j = IdxT(i % len);
+    device::counter_rng rng(seed, subsequence + r);
+    keys[i] = exponential_key(rng, uint64_t(offset + j), wts == nullptr ? WeightsT(1) : wts[j]);
+    if (indices != nullptr) { indices[i] = offset + j; }
+  }
+}
+
+template <typename WeightsT, typename IdxT>
+void exponential_keys(WeightsT* keys,
+                      IdxT* indices,
+                      const WeightsT* wts,
+                      IdxT n_rows,
+                      IdxT len,
+                      const device::counter_rng& rng,
+                      IdxT offset,
+                      cudaStream_t stream)
+{
+  constexpr int kThreads = 256;
+  size_t n               = size_t(n_rows) * size_t(len);
+  if (n == 0) { return; }
+  auto n_blocks = std::min<size_t>(raft::ceildiv<size_t>(n, kThreads), 65536);
+  exponential_keys_kernel<<<n_blocks, kThreads, 0, stream>>>(
+    keys, indices, wts, n_rows, len, rng.seed, rng.subsequence, offset);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+/**
+ * `sampleWithoutReplacement`, selecting the `sampledLen` smallest keys instead of sorting all of
+ * them when there are few samples: the same keys, hence the same samples in the same order.
+ */
+template <typename DataT, typename WeightsT, typename IdxT>
+void sample_without_replacement(raft::resources const& handle,
+                                RngState& rng_state,
+                                DataT* out,
+                                IdxT* outIdx,
+                                const DataT* in,
+                                const WeightsT* wts,
+                                IdxT sampledLen,
+                                IdxT len)
+{
+  ASSERT(sampledLen <= len, "sampleWithoutReplacement: 'sampledLen' cant be more than 'len'.");
+  auto stream = resource::get_cuda_stream(handle);
+  if (sampledLen > len / kSampleSelectRatio) {
+    sampleWithoutReplacement(rng_state, out, outIdx, in, wts, sampledLen, len, stream);
+    return;
+  }
+
+  rmm::device_uvector<WeightsT> expWts(len, stream);
+  SamplingParams<WeightsT, IdxT> params;
+  params.inIdxPtr = nullptr;
+  params.wts      = wts;
+  RAFT_CALL_RNG_FUNC(rng_state, call_rng_kernel<1>, rng_state, stream, expWts.data(), len, params);
+  if (sampledLen == 0) { return; }
+
+  rmm::device_uvector<WeightsT> selectedWts(sampledLen, stream);
+  rmm::device_uvector<WeightsT> sortedWts(sampledLen, stream);
+  rmm::device_uvector<IdxT> selectedIdx(sampledLen, stream);
+  rmm::device_uvector<IdxT> sortedIdx(sampledLen, stream);
+  raft::matrix::detail::select_k<WeightsT, IdxT>(expWts.data(),
+                                                 nullptr,
+                                                 1,
+                                                 len,
+                                                 int(sampledLen),
+                                                 selectedWts.data(),
+                                                 selectedIdx.data(),
+                                                 true,
+                                                 stream);
+  // only the selected keys are sorted, to keep the order of the full sort
+  rmm::device_uvector<char> workspace(0, stream);
+  sortPairs(workspace,
+            selectedWts.data(),
+            sortedWts.data(),
+            selectedIdx.data(),
+            sortedIdx.data(),
+            (int)sampledLen,
+            stream);
+  if (outIdx != nullptr) {
+    RAFT_CUDA_TRY(cudaMemcpyAsync(
+      outIdx, sortedIdx.data(), sizeof(IdxT) * sampledLen, cudaMemcpyDeviceToDevice, stream));
+  }
+  scatter<DataT, IdxT>(out, in, sortedIdx.data(), sampledLen, stream);
+}
+
+/**
+ * `n_batches` independent samples [n_batches, sampledLen] of the same input, the batch `b` from
+ * the keys of the stream `b` of the state: a single selection of the rows of the keys of as many
+ * batches as fit `kSampleMaxKeys`, instead of a sort per sample.
+ */
+template <typename DataT, typename WeightsT, typename IdxT>
+void sample_without_replacement_batched(raft::resources const& handle,
+                                        RngState& rng_state,
+                                        DataT* out,
+                                        IdxT* outIdx,
+                                        const DataT* in,
+                                        const WeightsT* wts,
+                                        IdxT n_batches,
+                                        IdxT sampledLen,
+                                        IdxT len)
+{
+  ASSERT(sampledLen <= len, "sampleWithoutReplacement: 'sampledLen' cant be more than 'len'.");
+  auto stream = resource::get_cuda_stream(handle);
+  device::counter_rng rng(rng_state);
+  rng_state.advance(uint64_t(n_batches));
+  if (n_batches == 0 || sampledLen == 0) { return; }
+
+  auto max_rows = IdxT(std::max<size_t>(1, kSampleMaxKeys / size_t(len)));
+  auto n_rows   = std::min(n_batches, max_rows);
+  rmm::device_uvector<WeightsT> keys(size_t(n_rows) * len, stream);
+  rmm::device_uvector<WeightsT> selected(size_t(n_rows) * sampledLen, stream);
+  rmm::device_uvector<IdxT> indices(outIdx == nullptr ? size_t(n_rows) * sampledLen : 0, stream);
+  for (IdxT row = 0; row < n_batches; row += n_rows) {
+    auto rows = std::min(n_rows, n_batches - row);
+    auto idx  = outIdx == nullptr ? indices.data() : outIdx + size_t(row) * sampledLen;
+    exponential_keys(keys.data(),
+                     static_cast<IdxT*>(nullptr),
+                     wts,
+                     rows,
+                     len,
+                     device::counter_rng(rng.seed, rng.subsequence + row),
+                     IdxT(0),
+                     stream);
+    raft::matrix::detail::select_k<WeightsT, IdxT>(
+      keys.data(), nullptr, rows, len, int(sampledLen), selected.data(), idx, true, stream);
+    scatter<DataT, IdxT>(out + size_t(row) * sampledLen, in, idx, rows * sampledLen, stream);
+  }
+}
+
+/**
+ * Merge the keys of the elements `offset` to `offset + len - 1` into a reservoir of the
+ * `capacity` smallest keys seen so far, of which there are `size`.
+ */
+template <typename WeightsT, typename IdxT>
+void reservoir_update(raft::resources const& handle,
+                      const device::counter_rng& rng,
+                      rmm::device_uvector<WeightsT>& keys,
+                      rmm::device_uvector<IdxT>& indices,
+                      IdxT& size,
+                      IdxT capacity,
+                      const WeightsT* wts,
+                      IdxT offset,
+                      IdxT len)
+{
+  auto stream = resource::get_cuda_stream(handle);
+  if (len == 0 || capacity == 0) { return; }
+  // the candidates: the reservoir followed by the new elements
+  IdxT n_candidates = size + len;
+  rmm::device_uvector<WeightsT> candidate_keys(n_candidates, stream);
+  rmm::device_uvector<IdxT> candidate_indices(n_candidates, stream);
+  raft::copy(candidate_keys.data(), keys.data(), size, stream);
+  raft::copy(candidate_indices.data(), indices.data(), size, stream);
+  exponential_keys(candidate_keys.data() + size,
+                   candidate_indices.data() + size,
+                   wts,
+                   IdxT(1),
+                   len,
+                   rng,
+                   offset,
+                   stream);
+  if (n_candidates <= capacity) {
+    raft::copy(keys.data(), candidate_keys.data(), n_candidates, stream);
+    raft::copy(indices.data(), candidate_indices.data(), n_candidates, stream);
+    size = n_candidates;
+    return;
+  }
+  raft::matrix::detail::select_k<WeightsT, IdxT>(candidate_keys.data(),
+                                                 candidate_indices.data(),
+                                                 1,
+                                                 n_candidates,
+                                                 int(capacity),
+                                                 keys.data(),
+                                                 indices.data(),
+                                                 true,
+                                                 stream);
+  size = capacity;
+}
+
+}  // namespace raft::random::detail
@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <raft/core/math.hpp>
+#include <raft/random/rng_state.hpp>
+#include <raft/util/cuda_dev_essentials.cuh>
+
+#include <type_traits>
+
+namespace raft::random::device {
+
+/**
+ * @brief The Philox4x32-10 bijection (Salmon et al., "Parallel random numbers: as easy as 1, 2,
+ * 3"): four random 32-bit words from a 128-bit counter and a 64-bit key, the same function as
+ * the one of curand's `curandStatePhilox4_32_10_t`.
+ */
+HDI uint4 philox4x32_10(uint4 ctr, uint2 key)
+{
+  constexpr uint32_t kMul0  = 0xD2511F53u;
+  constexpr uint32_t kMul1  = 0xCD9E8D57u;
+  constexpr uint32_t kWeyl0 = 0x9E3779B9u;
+  constexpr uint32_t kWeyl1 = 0xBB67AE85u;
+#pragma unroll
+  for (int round = 0; round < 10; round++) {
+#ifdef __CUDA_ARCH__
+    uint32_t hi0 = __umulhi(kMul0, ctr.x);
+    uint32_t hi1 = __umulhi(kMul1, ctr.z);
+#else
+    uint32_t hi0 = uint32_t((uint64_t(kMul0) * ctr.x) >> 32);
+    uint32_t hi1 = uint32_t((uint64_t(kMul1) * ctr.z) >> 32);
+#endif
+    uint32_t lo0 = kMul0 * ctr.x;
+    uint32_t lo1 = kMul1 * ctr.z;
+    ctr          = make_uint4(hi1 ^ ctr.y ^ key.x, lo1, hi0 ^ ctr.w ^ key.y, lo0);
+    key.x += kWeyl0;
+    key.y += kWeyl1;
+  }
+  return ctr;
+}
+
+/**
+ * @brief Counter-based random number generator: any element of a random stream at O(1) cost,
+ * without a state.
+ *
+ * Element `i` of the stream `(seed, subsequence)` is the `i`-th value returned by `next_u32()` of
+ * `PhiloxGenerator(seed, subsequence, 0)`, so that a kernel can generate exactly the values of
+ * the part of a (virtual) random array it works on, e.g. a tile of a random projection matrix or
+ * of a dropout mask, in registers. Element `(row, col)` of a random matrix is typically
+ * `u32(row * n_cols + col)`, or `u32(col)` of the subsequence `row`.
+ *
+ * The functions are callable on the host too, mainly for testing.
+ *
+ * @code{.cpp}
+ *   #include <raft/random/device/philox.cuh>
+ *
+ *   __global__ void dropout(float* x, int64_t n, float p, raft::random::device::counter_rng rng)
+ *   {
+ *     int64_t i = blockIdx.x * int64_t(blockDim.x) + threadIdx.x;
+ *     if (i < n) { x[i] = rng.uniform<float>(i) < p ? 0.f : x[i] / (1.f - p); }
+ *   }
+ * @endcode
+ */
+struct counter_rng {
+  uint64_t seed;
+  uint64_t subsequence;
+
+  HDI explicit counter_rng(uint64_t seed, uint64_t subsequence = 0)
+    : seed(seed), subsequence(subsequence)
+  {
+  }
+
+  /** The stream `subsequence` of the seed and the base subsequence of an `RngState`. */
+  counter_rng(const RngState& rng_state, uint64_t subsequence = 0)
+    : seed(rng_state.seed), subsequence(rng_state.base_subsequence + subsequence)
+  {
+  }
+
+  /** Elements `4 * block_id` to `4 * block_id + 3` of the stream. */
+  [[nodiscard]] HDI uint4 block(uint64_t block_id) const
+  {
+    return philox4x32_10(make_uint4(uint32_t(block_id),
+                                    uint32_t(block_id >> 32),
+                                    uint32_t(subsequence),
+                                    uint32_t(subsequence >> 32)),
+                         make_uint2(uint32_t(seed), uint32_t(seed >> 32)));
+  }
+
+  /** Element `i` of the stream. */
+  [[nodiscard]] HDI uint32_t u32(uint64_t i) const
+  {
+    uint4 r = block(i >> 2);
+    switch (i & 3) {
+      case 0: return r.x;
+      case 1: return r.y;
+      case 2: return r.z;
+      default: return r.w;
+    }
+  }
+
+  /** Elements `2 * i` (low bits) and `2 * i + 1` (high bits), as `PhiloxGenerator::next_u64`. */
+  [[nodiscard]] HDI uint64_t u64(uint64_t i) const
+  {
+    uint4 r = block(i >> 1);
+    return (i & 1) ? (uint64_t(r.z) | (uint64_t(r.w) << 32))
+                   : (uint64_t(r.x) | (uint64_t(r.y) << 32));
+  }
+
+  /**
+   * Uniform in [0, 1): element `i` of the stream for float (as `PhiloxGenerator::next_float`),
+   * `u64(i)` for double (as `PhiloxGenerator::next_double`).
+   */
+  template <typename T>
+  [[nodiscard]] HDI T uniform(uint64_t i) const
+  {
+    static_assert(std::is_same_v<T, float> || std::is_same_v<T, double>,
+                  "counter_rng::uniform: T must be float or double");
+    if constexpr (std::is_same_v<T, float>) {
+      return static_cast<float>(u32(i) >> 8) / float(uint32_t(1) << 24);
+    } else {
+      return static_cast<double>(u64(i) >> 11) / double(uint64_t(1) << 53);
+    }
+  }
+
+  /** Uniform in [start, end). */
+  template <typename T>
+  [[nodiscard]] HDI T uniform(uint64_t i, T start, T end) const
+  {
+    return start + uniform<T>(i) * (end - start);
+  }
+
+  /**
+   * Normal: the Box-Muller transform of the pair of uniforms `2 * (i / 2)` and `2 * (i / 2) + 1`,
+   * of which element `i` takes the cosine (even `i`) or the sine (odd `i`) part.
+   */
+  template <typename T>
+  [[nodiscard]] HDI T normal(uint64_t i, T mu = T(0), T sigma = T(1)) const
+  {
+    constexpr T twoPi = T(2.0) * T(3.141592653589793);
+    uint64_t pair     = i & ~uint64_t(1);
+    // 1 - u in (0, 1]: the logarithm is finite
+    T r     = raft::sqrt(T(-2.0) * raft::log(T(1) - uniform<T>(pair)));
+    T theta = twoPi * uniform<T>(pair + 1);
+    return mu + sigma * r * ((i & 1) ? raft::sin(theta) : raft::cos(theta));
+  }
+
+  /**
+   * Elements `4 * block_id` to `4 * block_id + 3` of `normal<T>`; for float, from a single
+   * Philox block.
+   */
+  template <typename T>
+  HDI void normal4(uint64_t block_id, T (&out)[4], T mu = T(0), T sigma = T(1)) const
+  {
+    if constexpr (std::is_same_v<T, float>) {
+      constexpr float twoPi = float(2.0) * float(3.141592653589793);
+      constexpr float scale = 1.0f / float(uint32_t(1) << 24);
+      uint4 b               = block(block_id);
+
+      float r0     = raft::sqrt(-2.0f * raft::log(1.0f - static_cast<float>(b.x >> 8) * scale));
+      float r1     = raft::sqrt(-2.0f * raft::log(1.0f - static_cast<float>(b.z >> 8) * scale));
+      float theta0 = twoPi * (static_cast<float>(b.y >> 8) * scale);
+      float theta1 = twoPi * (static_cast<float>(b.w >> 8) * scale);
+      out[0]       = mu + sigma * r0 * raft::cos(theta0);
+      out[1]       = mu + sigma * r0 * raft::sin(theta0);
+      out[2]       = mu + sigma * r1 * raft::cos(theta1);
+      out[3]       = mu + sigma * r1 * raft::sin(theta1);
+    } else {
+#pragma unroll
+      for (int j = 0; j < 4; j++) {
+        out[j] = normal<T>(4 * block_id + j, mu, sigma);
+      }
+    }
+  }
+
+  /** Bernoulli: true with probability `prob`. */
+  template <typename T>
+  [[nodiscard]] HDI bool bernoulli(uint64_t i, T prob) const
+  {
+    return uniform<T>(i) < prob;
+  }
+};
+
+}  // namespace raft::random::device
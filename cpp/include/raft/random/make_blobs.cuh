@@ -20,10 +20,12 @@
 #pragma once
 
 #include "detail/make_blobs.cuh"
+#include "shard.hpp"
 #include <optional>
 #include <raft/core/device_mdspan.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resources.hpp>
+#include <string>
 
 namespace raft::random {
 
@@ -181,6 +183,183 @@ void make_blobs(
                             type);
 }
 
+/**
+ * @brief Generate the rows `row_offset` to `row_offset + out.extent(0) - 1` of a make_blobs
+ * dataset, independently of the other rows.
+ *
+ * Every element is a function of the seed and of its position in the whole dataset only (a
+ * counter-based normal, `device::counter_rng`), so that the shards of a dataset generated by
+ * several ranks, or by one device a batch of rows at a time, are exactly the rows of the dataset
+ * generated at once with `row_offset = 0`; `shard_offset` and `shard_size` give the rows of a
+ * rank. The random centers and the labelling of the rows are drawn from the seed alone, the same
+ * on every rank. The dataset is not the one of `make_blobs` with the same seed.
+ *
+ * @code{.cpp}
+ *   #include <raft/random/make_blobs.cuh>
+ *
+ *   // the shard of this rank of a dataset of n_rows rows
+ *   auto first = raft::random::shard_offset<int64_t>(n_rows, rank, n_ranks);
+ *   auto rows  = raft::random::shard_size<int64_t>(n_rows, rank, n_ranks);
+ *   auto shard = raft::make_device_matrix<float, int64_t>(handle, rows, n_cols);
+ *   auto labels = raft::make_device_vector<int64_t, int64_t>(handle, rows);
+ *   raft::random::make_blobs_shard(handle, shard.view(), labels.view(), first, int64_t(10));
+ * @endcode
+ *
+ * @tparam DataT output data type
+ * @tparam IdxT  indexing arithmetic type
+ *
+ * @param[in] handle raft handle for managing expensive resources
+ * @param[out] out                the generated rows [on device]
+ *                                [dim = shard rows x n_cols]
+ * @param[out] labels             labels for the generated rows [on device]
+ *                                [len = shard rows]
+ * @param[in]  row_offset         the position of the first generated row in the dataset
+ * @param[in]  n_clusters         number of clusters (or classes) to generate
+ * @param[in]  centers            centers of each of the cluster, pass a nullopt
+ *                                if you need this also to be generated randomly
+ *                                [on device] [dim = n_clusters x n_cols]
+ * @param[in]  cluster_std        standard deviation of each cluster center,
+ *                                pass a nullopt if this is to be read from the
+ *                                `cluster_std_scalar`. [on device]
+ *                                [len = n_clusters]
+ * @param[in]  cluster_std_scalar if 'cluster_std' is nullopt, then use this as
+ *                                the std-dev across all dimensions.
+ * @param[in]  shuffle            shuffle the labels of the rows
+ * @param[in]  center_box_min     min value of box from which to pick cluster
+ *                                centers. Useful only if 'centers' is nullopt
+ * @param[in]  center_box_max     max value of box from which to pick cluster
+ *                                centers. Useful only if 'centers' is nullopt
+ * @param[in]  seed               seed for the RNG
+ */
+template <typename DataT, typename IdxT, typename layout>
+void make_blobs_shard(
+  raft::resources const& handle,
+  raft::device_matrix_view<DataT, IdxT, layout> out,
+  raft::device_vector_view<IdxT, IdxT> labels,
+  IdxT row_offset,
+  IdxT n_clusters                                                              = 5,
+  std::optional<raft::device_matrix_view<const DataT, IdxT, layout>> centers   = std::nullopt,
+  std::optional<raft::device_vector_view<const DataT, IdxT>> const cluster_std = std::nullopt,
+  const DataT cluster_std_scalar                                               = (DataT)1.0,
+  bool shuffle                                                                 = true,
+  DataT center_box_min                                                         = (DataT)-10.0,
+  DataT center_box_max                                                         = (DataT)10.0,
+  uint64_t seed                                                                = 0ULL)
+{
+  if (centers.has_value()) {
+    RAFT_EXPECTS(centers.value().extent(0) == (IdxT)n_clusters,
+                 "n_centers must equal size of centers");
+    RAFT_EXPECTS(centers.value().extent(1) == out.extent(1),
+                 "centers must have the columns of the output matrix");
+  }
+
+  if (cluster_std.has_value()) {
+    RAFT_EXPECTS(cluster_std.value().extent(0) == (IdxT)n_clusters,
+                 "n_centers must equal size of cluster_std");
+  }
+
+  RAFT_EXPECTS(out.extent(0) == labels.extent(0),
+               "Number of labels must equal the number of row in output matrix");
+
+  RAFT_EXPECTS(out.is_exhaustive(), "Output must be contiguous.");
+
+  bool row_major = std::is_same<layout, raft::layout_c_contiguous>::value;
+
+  auto prm_centers     = centers.has_value() ? centers.value().data_handle() : nullptr;
+  auto prm_cluster_std = cluster_std.has_value() ? cluster_std.value().data_handle() : nullptr;
+
+  detail::make_blobs_shard_caller<DataT, DataT, IdxT>(out.data_handle(),
+                                                      labels.data_handle(),
+                                                      (IdxT)out.extent(0),
+                                                      (IdxT)out.extent(1),
+                                                      row_offset,
+                                                      n_clusters,
+                                                      resource::get_cuda_stream(handle),
+                                                      row_major,
+                                                      prm_centers,
+                                                      row_major,
+                                                      prm_cluster_std,
+                                                      cluster_std_scalar,
+                                                      shuffle,
+                                                      center_box_min,
+                                                      center_box_max,
+                                                      seed);
+}
+
+/**
+ * @brief Stream a make_blobs dataset to a file, a batch of rows at a time.
+ *
+ * The file has the layout of the `.fbin` (`OutT = float`), `.u8bin` (`uint8_t`) and `.i8bin`
+ * (`int8_t`) datasets of the ANN benchmarks: two uint32 (n_rows, n_cols) followed by the
+ * row-major rows, which are the rows of `make_blobs_shard` with the same parameters. The values
+ * are generated in `DataT`, then rounded and clamped to the range of an integral `OutT` (choose
+ * the center box and the deviation accordingly, e.g. a box of [0, 255] for `uint8_t`).
+ *
+ * Every rank of `n_ranks` can write its `shard_offset` / `shard_size` rows into the same
+ * (shared) file at once; rank 0 sizes the file and writes the header. Only one batch of rows is
+ * on the device and on the host at a time, so that datasets larger than the memory can be
+ * generated.
+ *
+ * @code{.cpp}
+ *   #include <raft/random/make_blobs.cuh>
+ *
+ *   // 1B rows of 96 bytes
+ *   raft::random::make_blobs_file<uint8_t, int64_t>(
+ *     handle, "base.1B.u8bin", 1000000000, 96, 1000, 8.f, true, 0.f, 255.f);
+ * @endcode
+ *
+ * @tparam OutT  the element type of the file
+ * @tparam IdxT  indexing arithmetic type
+ * @tparam DataT the type of the generated values
+ *
+ * @param[in] handle raft handle for managing expensive resources
+ * @param[in]  path               the file to write
+ * @param[in]  n_rows             number of rows of the dataset
+ * @param[in]  n_cols             number of columns of the dataset
+ * @param[in]  n_clusters         number of clusters (or classes) to generate
+ * @param[in]  cluster_std_scalar the std-dev of the clusters across all dimensions
+ * @param[in]  shuffle            shuffle the labels of the rows
+ * @param[in]  center_box_min     min value of box from which to pick cluster centers
+ * @param[in]  center_box_max     max value of box from which to pick cluster centers
+ * @param[in]  seed               seed for the RNG
+ * @param[in]  rank               the rank writing its shard of the rows
+ * @param[in]  n_ranks            the number of ranks writing the file
+ * @param[in]  batch_rows         the number of rows generated at a time; about 2^24 elements if
+ *                                not positive
+ */
+template <typename OutT, typename IdxT, typename DataT = float>
+void make_blobs_file(raft::resources const& handle,
+                     const std::string& path,
+                     IdxT n_rows,
+                     IdxT n_cols,
+                     IdxT n_clusters                = 5,
+                     const DataT cluster_std_scalar = (DataT)1.0,
+                     bool shuffle                   = true,
+                     DataT center_box_min           = (DataT)-10.0,
+                     DataT center_box_max           = (DataT)10.0,
+                     uint64_t seed                  = 0ULL,
+                     int rank                       = 0,
+                     int n_ranks                    = 1,
+                     IdxT batch_rows                = 0)
+{
+  RAFT_EXPECTS(0 <= rank && rank < n_ranks, "rank must be in [0, n_ranks)");
+  RAFT_EXPECTS(n_cols > 0, "n_cols must be positive");
+  detail::make_blobs_file_caller<OutT, DataT, IdxT>(handle,
+                                                    path,
+                                                    n_rows,
+                                                    n_cols,
+                                                    n_clusters,
+                                                    cluster_std_scalar,
+                                                    shuffle,
+                                                    center_box_min,
+                                                    center_box_max,
+                                                    seed,
+                                                    shard_offset(n_rows, rank, n_ranks),
+                                                    shard_size(n_rows, rank, n_ranks),
+                                                    batch_rows,
+                                                    rank == 0);
+}
+
 /** @} */  // end group make_blobs
 
 }  // end namespace raft::random
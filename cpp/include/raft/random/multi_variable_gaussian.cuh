@@ -19,9 +19,16 @@
 
 #pragma once
 
+#include "detail/factorized_gaussian.cuh"
 #include "detail/multi_variable_gaussian.cuh"
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resources.hpp>
+#include <raft/random/device/philox.cuh>
 #include <raft/random/random_types.hpp>
+#include <raft/random/rng_state.hpp>
+
+#include <rmm/device_uvector.hpp>
 
 namespace raft::random {
 
@@ -56,6 +63,163 @@ void multi_variable_gaussian(raft::resources const& handle,
   detail::compute_multi_variable_gaussian_impl(handle, *mem_resource_ptr, x, P, X, method);
 }
 
+/**
+ * @brief A multi-variable Gaussian, or a batch of them, the factorization of the covariance of
+ * which is computed once and reused by every sample.
+ *
+ * `multi_variable_gaussian` decomposes the covariance on every call; this one decomposes the
+ * covariances [batch, dim, dim] at construction (a single batched Cholesky or Jacobi call when
+ * the dimension allows it) and then samples all the distributions of the batch by a single
+ * kernel, which generates the normals in shared memory and multiplies them by the factor there.
+ *
+ * @code{.cpp}
+ *   using raft::random::multi_variable_gaussian_decomposition_method;
+ *   raft::random::factorized_gaussian<float> mvg(
+ *     handle, covariances, means, multi_variable_gaussian_decomposition_method::CHOLESKY);
+ *   raft::random::RngState rng(1234ULL);
+ *   auto X = raft::make_device_mdarray<float>(
+ *     handle, raft::make_extents<int>(mvg.batch_size(), n_points, mvg.dim()));
+ *   mvg.sample(handle, rng, X.view());
+ * @endcode
+ *
+ * @tparam ValueType the data type (float or double)
+ */
+template <typename ValueType>
+class factorized_gaussian {
+ public:
+  using batched_matrix_extents =
+    raft::extents<int, raft::dynamic_extent, raft::dynamic_extent, raft::dynamic_extent>;
+
+  /**
+   * @brief Factorize a single covariance.
+   *
+   * @param[in] handle the raft handle
+   * @param[in] P the symmetric positive semi-definite covariance [dim, dim]
+   * @param[in] x the optional mean [dim]; zero if absent
+   * @param[in] method the decomposition of the covariance
+   */
+  factorized_gaussian(raft::resources const& handle,
+                      raft::device_matrix_view<const ValueType, int, raft::col_major> P,
+                      std::optional<raft::device_vector_view<const ValueType, int>> x,
+                      multi_variable_gaussian_decomposition_method method)
+    : batch_(1),
+      dim_(P.extent(0)),
+      factors_(size_t(dim_) * dim_, resource::get_cuda_stream(handle)),
+      means_(0, resource::get_cuda_stream(handle))
+  {
+    RAFT_EXPECTS(P.extent(0) == P.extent(1), "factorized_gaussian: the covariance must be square");
+    if (x.has_value()) {
+      RAFT_EXPECTS(x->extent(0) == dim_, "factorized_gaussian: the mean must be of size dim");
+    }
+    init(handle, P.data_handle(), x.has_value() ? x->data_handle() : nullptr, method);
+  }
+
+  /**
+   * @brief Factorize a batch of covariances.
+   *
+   * @param[in] handle the raft handle
+   * @param[in] P the symmetric positive semi-definite covariances [batch, dim, dim]
+   * @param[in] x the optional means [batch, dim]; zero if absent
+   * @param[in] method the decomposition of the covariances
+   */
+  factorized_gaussian(raft::resources const& handle,
+                      raft::device_mdspan<const ValueType, batched_matrix_extents> P,
+                      std::optional<raft::device_matrix_view<const ValueType, int>> x,
+                      multi_variable_gaussian_decomposition_method method)
+    : batch_(P.extent(0)),
+      dim_(P.extent(1)),
+      factors_(size_t(batch_) * dim_ * dim_, resource::get_cuda_stream(handle)),
+      means_(0, resource::get_cuda_stream(handle))
+  {
+    RAFT_EXPECTS(P.extent(1) == P.extent(2),
+                 "factorized_gaussian: the covariances must be square");
+    if (x.has_value()) {
+      RAFT_EXPECTS(x->extent(0) == batch_ && x->extent(1) == dim_,
+                   "factorized_gaussian: the means must be of shape [batch, dim]");
+    }
+    init(handle, P.data_handle(), x.has_value() ? x->data_handle() : nullptr, method);
+  }
+
+  /** @brief The number of distributions. */
+  [[nodiscard]] auto batch_size() const -> int { return batch_; }
+  /** @brief The dimension of the distributions. */
+  [[nodiscard]] auto dim() const -> int { return dim_; }
+
+  /**
+   * @brief Sample the points [batch, n_points, dim] of all the distributions of the batch.
+   *
+   * The points only depend on the state, which is advanced past them, and not on the shape of the
+   * launch: the point `j` of the distribution `b` is the same whatever `n_points`.
+   *
+   * @param[in] handle the raft handle
+   * @param[inout] rng the random state
+   * @param[out] X the points [batch, n_points, dim]
+   */
+  void sample(raft::resources const& handle,
+              RngState& rng,
+              raft::device_mdspan<ValueType, batched_matrix_extents> X) const
+  {
+    RAFT_EXPECTS(X.extent(0) == batch_ && X.extent(2) == dim_,
+                 "factorized_gaussian: the samples must be of shape [batch, n_points, dim]");
+    sample_impl(handle, rng, X.data_handle(), X.extent(1));
+  }
+
+  /**
+   * @brief Sample the points [dim, n_points] of a single distribution, in the layout of
+   * `multi_variable_gaussian`.
+   *
+   * @param[in] handle the raft handle
+   * @param[inout] rng the random state
+   * @param[out] X the points [dim, n_points], a column per point
+   */
+  void sample(raft::resources const& handle,
+              RngState& rng,
+              raft::device_matrix_view<ValueType, int, raft::col_major> X) const
+  {
+    RAFT_EXPECTS(batch_ == 1, "factorized_gaussian: a batch must be sampled into [batch, n, dim]");
+    RAFT_EXPECTS(X.extent(0) == dim_, "factorized_gaussian: the samples must have dim rows");
+    sample_impl(handle, rng, X.data_handle(), X.extent(1));
+  }
+
+ private:
+  void init(raft::resources const& handle,
+            const ValueType* covs,
+            const ValueType* means,
+            multi_variable_gaussian_decomposition_method method)
+  {
+    auto stream = resource::get_cuda_stream(handle);
+    if (means != nullptr) {
+      means_.resize(size_t(batch_) * dim_, stream);
+      raft::copy(means_.data(), means, means_.size(), stream);
+    }
+    if (batch_ == 0 || dim_ == 0) { return; }
+    triangular_ =
+      detail::factorize_covariances(handle, covs, factors_.data(), batch_, dim_, method);
+  }
+
+  void sample_impl(raft::resources const& handle, RngState& rng, ValueType* out, int n_points)
+    const
+  {
+    device::counter_rng counter(rng);
+    rng.advance(1);
+    detail::sample_factorized_gaussian(handle,
+                                       factors_.data(),
+                                       means_.size() == 0 ? nullptr : means_.data(),
+                                       out,
+                                       batch_,
+                                       n_points,
+                                       dim_,
+                                       triangular_,
+                                       counter);
+  }
+
+  int batch_;
+  int dim_;
+  bool triangular_{false};
+  rmm::device_uvector<ValueType> factors_;
+  rmm::device_uvector<ValueType> means_;
+};
+
 /** @} */
 
 };  // end of namespace raft::random
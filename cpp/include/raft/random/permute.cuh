@@ -23,8 +23,11 @@
 
 #include <optional>
 #include <raft/core/device_mdspan.hpp>
+#include <raft/core/mdspan.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resources.hpp>
+#include <raft/random/rng_state.hpp>
+#include <random>
 #include <type_traits>
 
 namespace raft::random {
@@ -170,6 +173,61 @@ void permute(raft::resources const& handle,
   permute(handle, in, permsOut_arg, out_arg);
 }
 
+/**
+ * @brief Randomly permute the rows of a row-major matrix in place, using bounded extra memory.
+ *
+ * Unlike `permute`, no output matrix is needed, so that a training set that fills the device or
+ * the host memory (e.g. a memory-mapped file) can be reshuffled before every epoch. Two modes are
+ * available:
+ *
+ * - `block_rows == 0` (exact): the rows are moved one by one along the cycles of a random affine
+ *   permutation `i -> (a * i + b) % n_rows`, the same family of permutations as `permute`
+ *   generates. The extra memory is one row and a bitmap of `n_rows` bits. This is fast for the
+ *   host matrices; the device matrices take one `cudaMemcpyAsync` per row.
+ * - `block_rows > 0` (blockwise): the blocks of `block_rows` consecutive rows are put in a uniform
+ *   random order, and the rows of every block are shuffled on the way. The blocks are moved with
+ *   bulk copies through three device buffers of `block_rows` rows, so the extra device memory is
+ *   `3 * block_rows * dim` elements. Larger blocks are faster, smaller blocks mix the rows better.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   raft::random::RngState rng(42);
+ *   for (int epoch = 0; epoch < n_epochs; epoch++) {
+ *     raft::random::permute_inplace(handle, rng, trainset.view(), 1 << 16);
+ *     // ... train on the batches of `trainset`
+ *   }
+ * @endcode
+ *
+ * @tparam T type of the matrix elements
+ * @tparam IdxT integer type of the extents
+ * @tparam Accessor host or device accessor of the matrix
+ *
+ * @param[in] handle RAFT handle containing the CUDA stream on which to run
+ * @param[inout] rng random number generator state; advanced, so that every call permutes the rows
+ *   differently
+ * @param[inout] data a (host or device) row-major matrix [n_rows, dim] to permute
+ * @param[in] block_rows the number of rows of the blocks, or zero for the exact permutation
+ */
+template <typename T, typename IdxT, typename Accessor>
+void permute_inplace(raft::resources const& handle,
+                     RngState& rng,
+                     raft::mdspan<T, raft::matrix_extent<IdxT>, raft::row_major, Accessor> data,
+                     size_t block_rows = 0)
+{
+  static_assert(!std::is_const_v<T>, "permute_inplace: The matrix must be writable.");
+  std::seed_seq seq{uint32_t(rng.seed),
+                    uint32_t(rng.seed >> 32),
+                    uint32_t(rng.base_subsequence),
+                    uint32_t(rng.base_subsequence >> 32)};
+  std::mt19937_64 gen(seq);
+  rng.advance(1);
+  if (block_rows == 0) {
+    detail::permute_inplace_exact(handle, gen, data);
+  } else {
+    detail::permute_inplace_blockwise(handle, gen, data, block_rows);
+  }
+}
+
 /** @} */
 
 /**
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "detail/random_projection.cuh"
+
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/random/rng_state.hpp>
+
+namespace raft::random {
+
+/**
+ * @defgroup random_projection Random projections
+ * @{
+ */
+
+/**
+ * @brief Project the rows of a dense matrix with a Gaussian random matrix generated on the fly.
+ *
+ * Computes `y = x * R / sqrt(n_components)`, where R [n_features, n_components] has i.i.d.
+ * standard normal entries, so that the squared norms of the rows are preserved in expectation
+ * (Johnson-Lindenstrauss). R is never stored: every tile of it is regenerated from the counter of
+ * its elements (`device::counter_rng`) inside the tiled product, so the cost is that of a GEMM
+ * without reading the matrix. R depends only on the seed and the base subsequence of the state,
+ * which is not advanced: the batches of the rows of a dataset projected with the same state are
+ * projected consistently.
+ *
+ * @code{.cpp}
+ *   #include <raft/random/random_projection.cuh>
+ *
+ *   raft::random::RngState state(42);
+ *   auto y = raft::make_device_matrix<float, int64_t>(handle, n_rows, 128);
+ *   raft::random::gaussian_random_projection(handle, state, x.view(), y.view());
+ * @endcode
+ *
+ * @tparam T data type (float or double)
+ * @tparam IdxT index type
+ * @param[in] handle raft handle
+ * @param[in] rng_state the random state of the projection
+ * @param[in] x the input rows [n_rows, n_features]
+ * @param[out] y the projected rows [n_rows, n_components]
+ */
+template <typename T, typename IdxT>
+void gaussian_random_projection(raft::resources const& handle,
+                                const RngState& rng_state,
+                                raft::device_matrix_view<const T, IdxT, raft::row_major> x,
+                                raft::device_matrix_view<T, IdxT, raft::row_major> y)
+{
+  RAFT_EXPECTS(x.extent(0) == y.extent(0), "Number of rows mismatch between x and y");
+  detail::gaussian_projection(
+    handle, rng_state, x.data_handle(), y.data_handle(), x.extent(0), x.extent(1), y.extent(1));
+}
+
+/**
+ * @brief Create a very sparse random projection matrix (Achlioptas; Li, Hastie and Church).
+ *
+ * Every entry is non-zero with probability `density`, with the values
+ * `+- 1 / sqrt(density * n_components)` of equal probabilities. The matrix is stored transposed,
+ * with a row per component, as the `components_` of a scikit-learn projection; apply it with
+ * `sparse_random_projection`. The default density `1 / sqrt(n_features)` makes the product
+ * about `sqrt(n_features)` times cheaper than a dense projection, and `density = 1 / 3` is the
+ * projection of Achlioptas. The matrix depends only on the seed and the base subsequence of the
+ * state.
+ *
+ * @tparam T data type (float or double)
+ * @param[in] handle raft handle
+ * @param[in] rng_state the random state of the projection
+ * @param[in] n_features the number of features of the input rows
+ * @param[in] n_components the number of components of the projected rows
+ * @param[in] density the probability of the non-zeros; `1 / sqrt(n_features)` if not positive
+ * @return the projection matrix [n_components, n_features]
+ */
+template <typename T>
+auto make_sparse_random_projection(raft::resources const& handle,
+                                   const RngState& rng_state,
+                                   int n_features,
+                                   int n_components,
+                                   double density = 0)
+  -> raft::device_csr_matrix<T, int, int, int>
+{
+  return detail::make_sparse_projection<T>(handle, rng_state, n_features, n_components, density);
+}
+
+/**
+ * @brief Project the rows of a dense matrix with a sparse projection matrix:
+ * `y = x * components^T`.
+ *
+ * @tparam T data type (float or double)
+ * @param[in] handle raft handle
+ * @param[in] components the projection matrix of `make_sparse_random_projection`
+ * [n_components, n_features]
+ * @param[in] x the input rows [n_rows, n_features]
+ * @param[out] y the projected rows [n_rows, n_components]
+ */
+template <typename T>
+void sparse_random_projection(raft::resources const& handle,
+                              raft::device_csr_matrix_view<const T, int, int, int> components,
+                              raft::device_matrix_view<const T, int, raft::row_major> x,
+                              raft::device_matrix_view<T, int, raft::row_major> y)
+{
+  auto structure = components.structure_view();
+  RAFT_EXPECTS(x.extent(0) == y.extent(0), "Number of rows mismatch between x and y");
+  RAFT_EXPECTS(structure.get_n_cols() == x.extent(1), "Number of features mismatch");
+  RAFT_EXPECTS(structure.get_n_rows() == y.extent(1), "Number of components mismatch");
+  // y^T = components * x^T, with the row-major x and y seen as their column-major transposes
+  T alpha = T(1);
+  T beta  = T(0);
+  raft::sparse::linalg::spmm(
+    handle,
+    false,
+    false,
+    &alpha,
+    components,
+    raft::make_device_matrix_view<const T, int, raft::col_major>(
+      x.data_handle(), x.extent(1), x.extent(0)),
+    &beta,
+    raft::make_device_matrix_view<T, int, raft::col_major>(
+      y.data_handle(), y.extent(1), y.extent(0)));
+}
+
+/**
+ * @brief Project the rows of a dense matrix with the subsampled randomized Hadamard transform.
+ *
+ * Computes `y = sqrt(d / n_components) * S * H * D * x` for every row x: D flips the signs of
+ * random coordinates, H is the orthonormal Walsh-Hadamard transform of the row zero-padded to
+ * `d = 2^ceil(log2(n_features))` and S samples `n_components` of the `d` coordinates (the same
+ * for all the rows). Every row takes `d * log2(d)` operations in the shared memory instead of
+ * `n_features * n_components`, so `d` is limited by the shared memory of a block (8192 floats or
+ * 4096 doubles). The projection depends only on the seed and the base subsequence of the state.
+ *
+ * @tparam T data type (float or double)
+ * @tparam IdxT index type
+ * @param[in] handle raft handle
+ * @param[in] rng_state the random state of the projection
+ * @param[in] x the input rows [n_rows, n_features]
+ * @param[out] y the projected rows [n_rows, n_components]
+ */
+template <typename T, typename IdxT>
+void srht_random_projection(raft::resources const& handle,
+                            const RngState& rng_state,
+                            raft::device_matrix_view<const T, IdxT, raft::row_major> x,
+                            raft::device_matrix_view<T, IdxT, raft::row_major> y)
+{
+  RAFT_EXPECTS(x.extent(0) == y.extent(0), "Number of rows mismatch between x and y");
+  detail::srht_projection(
+    handle, rng_state, x.data_handle(), y.data_handle(), x.extent(0), x.extent(1), y.extent(1));
+}
+
+/** @} */
+
+}  // namespace raft::random
@@ -17,7 +17,9 @@
 #pragma once
 
 #include "detail/rmat_rectangular_generator.cuh"
+#include "shard.hpp"
 #include <raft/core/resources.hpp>
+#include <string>
 
 namespace raft::random {
 
@@ -218,6 +220,136 @@ void rmat_rectangular_gen(
   detail::rmat_rectangular_gen_impl(handle, r, output, a, b, c, r_scale, c_scale);
 }
 
+/**
+ * @brief Generate the edges `edge_offset` to `edge_offset + out_src.extent(0) - 1` of the RMAT
+ * graph of the state `r`, independently of the other edges.
+ *
+ * Every edge is generated from its own subsequence of the state, so that the shards of a graph
+ * generated by several ranks (see `shard_offset` and `shard_size`), or by one device a batch of
+ * edges at a time, are exactly the edges of `rmat_rectangular_gen` called with the same state
+ * for the whole graph. The state is not advanced: to continue with the state of the whole graph,
+ * advance it by its number of edges (`r.advance(n_edges)`) on every rank.
+ *
+ * @code{.cpp}
+ *   #include <raft/random/rmat_rectangular_generator.cuh>
+ *
+ *   auto first = raft::random::shard_offset<int64_t>(n_edges, rank, n_ranks);
+ *   auto n     = raft::random::shard_size<int64_t>(n_edges, rank, n_ranks);
+ *   auto src   = raft::make_device_vector<int64_t, int64_t>(handle, n);
+ *   auto dst   = raft::make_device_vector<int64_t, int64_t>(handle, n);
+ *   raft::random::rmat_rectangular_gen_shard(
+ *     handle, state, theta, src.view(), dst.view(), r_scale, c_scale, first);
+ *   state.advance(n_edges);
+ * @endcode
+ *
+ * @tparam IdxT  Type of each node index
+ * @tparam ProbT Data type used for probability distributions (either fp32 or fp64)
+ *
+ * @param[in]  handle      RAFT handle, containing the CUDA stream on which to schedule work
+ * @param[in]  r           underlying state of the random generator of the whole graph
+ * @param[in]  theta       distribution of each quadrant at each level of resolution, as in
+ *                         `rmat_rectangular_gen` [on device] [dim = max(r_scale, c_scale) x 2 x 2]
+ * @param[out] out_src     Source node id's of the shard [on device].
+ * @param[out] out_dst     Destination node id's of the shard [on device].
+ * @param[in]  r_scale     2^r_scale represents the number of source nodes
+ * @param[in]  c_scale     2^c_scale represents the number of destination nodes
+ * @param[in]  edge_offset the position of the first edge of the shard in the graph
+ */
+template <typename IdxT, typename ProbT>
+void rmat_rectangular_gen_shard(raft::resources const& handle,
+                                const raft::random::RngState& r,
+                                raft::device_vector_view<const ProbT, IdxT> theta,
+                                raft::device_vector_view<IdxT, IdxT> out_src,
+                                raft::device_vector_view<IdxT, IdxT> out_dst,
+                                IdxT r_scale,
+                                IdxT c_scale,
+                                IdxT edge_offset)
+{
+  auto state = detail::rmat_shard_state(r, uint64_t(edge_offset));
+  detail::rmat_rectangular_gen_output<IdxT> output(out_src, out_dst);
+  detail::rmat_rectangular_gen_impl(handle, state, theta, output, r_scale, c_scale);
+}
+
+/**
+ * @brief Overload of `rmat_rectangular_gen_shard` that assumes the same
+ *   a, b, c, d probability distributions across all the scales.
+ */
+template <typename IdxT, typename ProbT>
+void rmat_rectangular_gen_shard(raft::resources const& handle,
+                                const raft::random::RngState& r,
+                                raft::device_vector_view<IdxT, IdxT> out_src,
+                                raft::device_vector_view<IdxT, IdxT> out_dst,
+                                ProbT a,
+                                ProbT b,
+                                ProbT c,
+                                IdxT r_scale,
+                                IdxT c_scale,
+                                IdxT edge_offset)
+{
+  auto state = detail::rmat_shard_state(r, uint64_t(edge_offset));
+  detail::rmat_rectangular_gen_output<IdxT> output(out_src, out_dst);
+  detail::rmat_rectangular_gen_impl(handle, state, output, a, b, c, r_scale, c_scale);
+}
+
+/**
+ * @brief Stream the edges of an RMAT graph to a file, a batch of edges at a time.
+ *
+ * The file stores the edges as a [n_edges, 2] matrix of `IdxT` (source, destination), after
+ * two uint32 (n_edges, 2), as the `.ibin` files of the ANN benchmarks. The edges are the ones of
+ * `rmat_rectangular_gen` called with the same state for the whole graph; every rank of `n_ranks`
+ * can write its `shard_offset` / `shard_size` edges into the same (shared) file at once, rank 0
+ * sizing the file and writing the header. The state is advanced by `n_edges` on every rank.
+ *
+ * @tparam IdxT  Type of each node index
+ * @tparam ProbT Data type used for probability distributions (either fp32 or fp64)
+ *
+ * @param[in]    handle      RAFT handle, containing the CUDA stream on which to schedule work
+ * @param[inout] r           underlying state of the random generator of the whole graph
+ * @param[in]    path        the file to write
+ * @param[in]    n_edges     the number of edges of the graph
+ * @param[in]    a           the probability of the top-left quadrant at every scale
+ * @param[in]    b           the probability of the top-right quadrant at every scale
+ * @param[in]    c           the probability of the bottom-left quadrant at every scale
+ * @param[in]    r_scale     2^r_scale represents the number of source nodes
+ * @param[in]    c_scale     2^c_scale represents the number of destination nodes
+ * @param[in]    rank        the rank writing its shard of the edges
+ * @param[in]    n_ranks     the number of ranks writing the file
+ * @param[in]    batch_edges the number of edges generated at a time; 2^23 if not positive
+ */
+template <typename IdxT, typename ProbT>
+void rmat_rectangular_gen_file(raft::resources const& handle,
+                               raft::random::RngState& r,
+                               const std::string& path,
+                               IdxT n_edges,
+                               ProbT a,
+                               ProbT b,
+                               ProbT c,
+                               IdxT r_scale,
+                               IdxT c_scale,
+                               int rank         = 0,
+                               int n_ranks      = 1,
+                               IdxT batch_edges = 0)
+{
+  static_assert(std::is_integral_v<IdxT>,
+                "rmat_rectangular_gen_file: "
+                "Template parameter IdxT must be an integral type");
+  RAFT_EXPECTS(0 <= rank && rank < n_ranks, "rank must be in [0, n_ranks)");
+  detail::rmat_rectangular_gen_file_caller(handle,
+                                           r,
+                                           path,
+                                           n_edges,
+                                           a,
+                                           b,
+                                           c,
+                                           r_scale,
+                                           c_scale,
+                                           shard_offset(n_edges, rank, n_ranks),
+                                           shard_size(n_edges, rank, n_ranks),
+                                           batch_edges,
+                                           rank == 0);
+  r.advance(n_edges);
+}
+
 /** @} */  // end group rmat
 
 /**
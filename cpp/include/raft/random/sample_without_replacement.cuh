@@ -17,12 +17,17 @@
 #pragma once
 
 #include "detail/rng_impl.cuh"
+#include "detail/sample_without_replacement.cuh"
 #include "rng_state.hpp"
+#include <algorithm>
 #include <cassert>
 #include <optional>
 #include <raft/core/device_mdspan.hpp>
+#include <raft/core/host_mdspan.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resources.hpp>
+#include <raft/random/device/philox.cuh>
+#include <rmm/device_uvector.hpp>
 #include <type_traits>
 #include <variant>
 
@@ -67,6 +72,10 @@ using weight_t = typename weight_alias<T>::type;
  * particular about the order (for e.g., array permutations), then
  * this might not be the right choice.
  *
+ * Up to `in.extent(0) / 8` samples, the smallest keys are selected with `matrix::select_k`
+ * instead of sorting all of them, which makes the cost linear in the number of inputs with the
+ * same samples; only the selected keys are sorted.
+ *
  * @tparam DataT type of each element of the input array @c in
  * @tparam IdxT type of the dimensions of the arrays; output index type
  * @tparam WeightsVectorType std::optional<raft::device_vector_view<const weight_type, IdxT>> of
@@ -138,14 +147,8 @@ void sample_without_replacement(raft::resources const& handle,
   }
   const weight_type* wts_ptr = wts_has_value ? (*wts).data_handle() : nullptr;
 
-  detail::sampleWithoutReplacement(rng_state,
-                                   out.data_handle(),
-                                   outIdx_ptr,
-                                   in.data_handle(),
-                                   wts_ptr,
-                                   sampledLen,
-                                   len,
-                                   resource::get_cuda_stream(handle));
+  detail::sample_without_replacement(
+    handle, rng_state, out.data_handle(), outIdx_ptr, in.data_handle(), wts_ptr, sampledLen, len);
 }
 
 /**
@@ -162,6 +165,208 @@ void sample_without_replacement(Args... args)
   sample_without_replacement(std::forward<Args>(args)..., std::nullopt);
 }
 
+/**
+ * @brief Draw several independent samples without replacement of the same input vector,
+ * optionally based on the input weight vector for each element in the array.
+ *
+ * The row `b` of `out` is a sample as the one of `sample_without_replacement`, from the keys of
+ * the stream `b` of the state (`device::counter_rng`); the state is advanced by the number of
+ * samples. The keys of as many samples as fit in 2^26 elements are generated at once and the
+ * smallest ones of all their rows are selected with a single batched `matrix::select_k`, so that
+ * drawing many small samples (e.g. the bootstrap samples of an ensemble) costs about as much as
+ * generating their keys. The elements of a sample are in no particular order.
+ *
+ * @code{.cpp}
+ *   #include <raft/random/sample_without_replacement.cuh>
+ *
+ *   raft::random::RngState state(42);
+ *   auto samples = raft::make_device_matrix<float, int64_t>(handle, 16, 1000);
+ *   raft::random::sample_without_replacement_batched(
+ *     handle, state, raft::make_const_mdspan(in.view()), std::nullopt, samples.view());
+ * @endcode
+ *
+ * @tparam DataT type of each element of the input array @c in
+ * @tparam IdxT type of the dimensions of the arrays; output index type
+ * @tparam WeightsVectorType std::optional<raft::device_vector_view<const weight_type, IdxT>> of
+ * each elements of the weights array @c weights_opt
+ * @tparam OutIndexMatrixType std::optional<raft::device_matrix_view<IdxT, IdxT, row_major>> of
+ * output indices @c outIdx_opt
+ *
+ * @param[in] handle RAFT handle containing (among other resources)
+ *   the CUDA stream on which to run.
+ * @param[inout] rng_state Pseudorandom number generator state.
+ * @param[in] in Input vector to be sampled.
+ * @param[in] weights_opt std::optional weights vector.
+ *        If not provided, uniform sampling will be used.
+ * @param[out] out The samples [n_samples, sample_size] of the input vector.
+ * @param[out] outIdx_opt std::optional matrix of the indices
+ *   sampled from the input array [n_samples, sample_size].
+ *
+ * @pre The sample size `out.extent(1)`
+ *   is less than or equal to the number of inputs `in.extent(0)`.
+ */
+template <typename DataT, typename IdxT, typename WeightsVectorType, class OutIndexMatrixType>
+void sample_without_replacement_batched(raft::resources const& handle,
+                                        RngState& rng_state,
+                                        raft::device_vector_view<const DataT, IdxT> in,
+                                        WeightsVectorType&& weights_opt,
+                                        raft::device_matrix_view<DataT, IdxT, row_major> out,
+                                        OutIndexMatrixType&& outIdx_opt)
+{
+  using weight_type = sample_without_replacement_impl::weight_t<
+    std::remove_const_t<std::remove_reference_t<WeightsVectorType>>>;
+
+  std::optional<raft::device_vector_view<const weight_type, IdxT>> wts =
+    std::forward<WeightsVectorType>(weights_opt);
+  std::optional<raft::device_matrix_view<IdxT, IdxT, row_major>> outIdx =
+    std::forward<OutIndexMatrixType>(outIdx_opt);
+
+  static_assert(std::is_integral<IdxT>::value, "IdxT must be an integral type.");
+  const IdxT n_batches  = out.extent(0);
+  const IdxT sampledLen = out.extent(1);
+  const IdxT len        = in.extent(0);
+  RAFT_EXPECTS(sampledLen <= len,
+               "sample_without_replacement_batched: "
+               "sampledLen (out.extent(1)) must be <= len (in.extent(0))");
+  if (outIdx.has_value()) {
+    RAFT_EXPECTS((*outIdx).extent(0) == n_batches && (*outIdx).extent(1) == sampledLen,
+                 "sample_without_replacement_batched: "
+                 "If outIdx is provided, its extents must equal the ones of out");
+  }
+  if (wts.has_value()) {
+    RAFT_EXPECTS((*wts).extent(0) == len,
+                 "sample_without_replacement_batched: "
+                 "If wts is provided, its extent(0) must equal in.extent(0)");
+  }
+  detail::sample_without_replacement_batched(
+    handle,
+    rng_state,
+    out.data_handle(),
+    outIdx.has_value() ? (*outIdx).data_handle() : static_cast<IdxT*>(nullptr),
+    in.data_handle(),
+    wts.has_value() ? (*wts).data_handle() : static_cast<const weight_type*>(nullptr),
+    n_batches,
+    sampledLen,
+    len);
+}
+
+/**
+ * @brief Overload of `sample_without_replacement_batched` to help the
+ *   compiler find the above overload, in case users pass in
+ *   `std::nullopt` for one or both of the optional arguments.
+ *
+ * Please see above for documentation of `sample_without_replacement_batched`.
+ */
+template <typename... Args, typename = std::enable_if_t<sizeof...(Args) == 5>>
+void sample_without_replacement_batched(Args... args)
+{
+  sample_without_replacement_batched(std::forward<Args>(args)..., std::nullopt);
+}
+
+/**
+ * @brief A weighted sample without replacement of a stream of blocks of elements, e.g. the rows
+ * of a host-resident dataset too large for the device (A-ES, the reservoir variant of the
+ * algorithm of Efraimidis and Spirakis).
+ *
+ * Every block of weights (or uniform elements) is given to `update`, and the reservoir keeps
+ * the indices of the `n_samples` smallest keys of all the elements seen so far, in O(n_samples)
+ * device memory beyond the block. The key of an element depends only on the state and on its
+ * index in the stream (`device::counter_rng`), so that the sample does not depend on the way the
+ * stream is split into blocks. The host blocks are staged to the device by chunks of 2^26
+ * elements.
+ *
+ * @code{.cpp}
+ *   #include <raft/random/sample_without_replacement.cuh>
+ *
+ *   raft::random::RngState state(42);
+ *   raft::random::sample_reservoir<float> reservoir(handle, state, 1000000);
+ *   for (auto& block : host_weight_blocks) {
+ *     reservoir.update(handle, raft::make_host_vector_view<const float, int64_t>(
+ *                                block.data(), int64_t(block.size())));
+ *   }
+ *   // the indices of the sampled rows, in no particular order
+ *   auto indices = reservoir.indices();
+ * @endcode
+ *
+ * @tparam WeightsT type of the weights (float or double)
+ * @tparam IdxT type of the indices
+ */
+template <typename WeightsT, typename IdxT = int64_t>
+class sample_reservoir {
+ public:
+  /**
+   * @param[in] handle raft handle
+   * @param[inout] rng_state the random state; advanced by one stream
+   * @param[in] n_samples the size of the sample
+   */
+  sample_reservoir(raft::resources const& handle, RngState& rng_state, IdxT n_samples)
+    : rng_(rng_state),
+      capacity_(n_samples),
+      keys_(n_samples, resource::get_cuda_stream(handle)),
+      indices_(n_samples, resource::get_cuda_stream(handle))
+  {
+    rng_state.advance(1);
+  }
+
+  /** Add a block of weighted elements, with the indices following the ones already seen. */
+  void update(raft::resources const& handle, raft::device_vector_view<const WeightsT, IdxT> wts)
+  {
+    detail::reservoir_update(
+      handle, rng_, keys_, indices_, size_, capacity_, wts.data_handle(), n_rows_, wts.extent(0));
+    n_rows_ += wts.extent(0);
+  }
+
+  /** Add a block of weighted elements from the host. */
+  void update(raft::resources const& handle, raft::host_vector_view<const WeightsT, IdxT> wts)
+  {
+    auto stream = resource::get_cuda_stream(handle);
+    auto chunk  = IdxT(std::min<size_t>(detail::kSampleMaxKeys, size_t(wts.extent(0))));
+    rmm::device_uvector<WeightsT> staged(chunk, stream);
+    for (IdxT offset = 0; offset < wts.extent(0); offset += chunk) {
+      auto len = std::min(chunk, wts.extent(0) - offset);
+      raft::update_device(staged.data(), wts.data_handle() + offset, len, stream);
+      update(handle, raft::make_device_vector_view<const WeightsT, IdxT>(staged.data(), len));
+    }
+  }
+
+  /** Add a block of `n_rows` elements of unit weight. */
+  void update(raft::resources const& handle, IdxT n_rows)
+  {
+    auto chunk = IdxT(detail::kSampleMaxKeys);
+    for (IdxT offset = 0; offset < n_rows; offset += chunk) {
+      auto len = std::min(chunk, n_rows - offset);
+      detail::reservoir_update(handle,
+                               rng_,
+                               keys_,
+                               indices_,
+                               size_,
+                               capacity_,
+                               static_cast<const WeightsT*>(nullptr),
+                               n_rows_,
+                               len);
+      n_rows_ += len;
+    }
+  }
+
+  /** The number of elements seen so far. */
+  [[nodiscard]] auto n_rows() const -> IdxT { return n_rows_; }
+  /** The size of the sample so far: `min(n_samples, n_rows())`. */
+  [[nodiscard]] auto size() const -> IdxT { return size_; }
+  /** The indices of the sample so far, in no particular order. */
+  [[nodiscard]] auto indices() const -> raft::device_vector_view<const IdxT, IdxT>
+  {
+    return raft::make_device_vector_view<const IdxT, IdxT>(indices_.data(), size_);
+  }
+
+ private:
+  device::counter_rng rng_;
+  IdxT capacity_;
+  IdxT size_{0};
+  IdxT n_rows_{0};
+  rmm::device_uvector<WeightsT> keys_;
+  rmm::device_uvector<IdxT> indices_;
+};
+
 /** @} */
 
 }  // end namespace raft::random
\ No newline at end of file
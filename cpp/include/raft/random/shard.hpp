@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/detail/macros.hpp>
+
+namespace raft::random {
+
+/**
+ * @defgroup random_shard Partitioning of generated data
+ * @{
+ */
+
+/**
+ * @brief The first item of the shard `rank` of the partition of `n` items into `n_ranks`
+ * contiguous shards, the sizes of which differ by one at most.
+ *
+ * The sharded generators (`make_blobs_shard`, `rmat_rectangular_gen_shard`) generate the same
+ * items whatever the partition; this one is the partition they use for a rank.
+ */
+template <typename IdxT>
+constexpr _RAFT_HOST_DEVICE auto shard_offset(IdxT n, int rank, int n_ranks) -> IdxT
+{
+  IdxT base = n / IdxT(n_ranks);
+  IdxT rem  = n % IdxT(n_ranks);
+  return IdxT(rank) * base + (IdxT(rank) < rem ? IdxT(rank) : rem);
+}
+
+/** @brief The number of items of the shard `rank` of `shard_offset`. */
+template <typename IdxT>
+constexpr _RAFT_HOST_DEVICE auto shard_size(IdxT n, int rank, int n_ranks) -> IdxT
+{
+  return shard_offset(n, rank + 1, n_ranks) - shard_offset(n, rank, n_ranks);
+}
+
+/** @} */
+
+}  // namespace raft::random
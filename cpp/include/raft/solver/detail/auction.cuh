@@ -0,0 +1,584 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *      Auction algorithm for the sparse asymmetric assignment problem
+ *
+ *      Article reference:
+ *          Bertsekas, Dimitri P., and David A. Castanon. "A forward/reverse auction algorithm
+ *          for asymmetric assignment problems." Computational Optimization and Applications
+ *          1.3 (1992): 277-297.
+ *
+ */
+#pragma once
+
+#include "../linear_assignment_types.hpp"
+
+#include <raft/core/math.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <thrust/binary_search.h>
+#include <thrust/copy.h>
+#include <thrust/count.h>
+#include <thrust/execution_policy.h>
+#include <thrust/extrema.h>
+#include <thrust/fill.h>
+#include <thrust/functional.h>
+#include <thrust/gather.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/transform_iterator.h>
+#include <thrust/reduce.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
+#include <thrust/transform_reduce.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace raft::solver::detail {
+
+const int AUCTION_BLOCKDIM{256};
+const unsigned long long AUCTION_NO_WINNER{std::numeric_limits<unsigned long long>::max()};
+
+// The best and the second best values of the neighbors of a vertex, the first neighbor of the
+// best value on ties.
+template <typename ValueT, typename IndexT>
+struct auction_best_two {
+  ValueT best{std::numeric_limits<ValueT>::lowest()};
+  ValueT second{std::numeric_limits<ValueT>::lowest()};
+  IndexT idx{-1};
+
+  __device__ void push(ValueT v, IndexT i)
+  {
+    if (idx < 0 || v > best || (v == best && i < idx)) {
+      if (idx >= 0) second = raft::max(second, best);
+      best = v;
+      idx  = i;
+    } else {
+      second = raft::max(second, v);
+    }
+  }
+
+  // Combines the best two of all the lanes of the warp into every one of them.
+  __device__ void warp_reduce()
+  {
+    for (int offset = raft::WarpSize / 2; offset > 0; offset /= 2) {
+      ValueT other_best   = __shfl_xor_sync(0xffffffff, best, offset);
+      ValueT other_second = __shfl_xor_sync(0xffffffff, second, offset);
+      IndexT other_idx    = __shfl_xor_sync(0xffffffff, idx, offset);
+      if (other_idx >= 0 &&
+          (idx < 0 || other_best > best || (other_best == best && other_idx < idx))) {
+        second = idx >= 0 ? raft::max(best, other_second) : other_second;
+        best   = other_best;
+        idx    = other_idx;
+      } else if (other_idx >= 0) {
+        second = raft::max(second, other_best);
+      }
+    }
+  }
+};
+
+// Kernel for the forward bids: a warp per unassigned row bids for the column of the best value
+// (benefit minus price), raising its price by the margin to the second best plus epsilon.
+template <typename ValueT, typename IndexT, typename NZT>
+__global__ void kernel_auctionBid(NZT const* d_indptr,
+                                  IndexT const* d_indices,
+                                  ValueT const* d_costs,
+                                  ValueT const* d_prices,
+                                  IndexT const* d_bidders,
+                                  IndexT n_bidders,
+                                  ValueT epsilon,
+                                  ValueT max_increment,
+                                  IndexT* d_bid_targets,
+                                  ValueT* d_bids,
+                                  ValueT* d_target_bids)
+{
+  IndexT warp = (blockIdx.x * IndexT(blockDim.x) + threadIdx.x) / raft::WarpSize;
+  int lane    = threadIdx.x % raft::WarpSize;
+  if (warp >= n_bidders) return;
+
+  IndexT row = d_bidders[warp];
+  auction_best_two<ValueT, IndexT> top;
+  for (NZT k = d_indptr[row] + lane; k < d_indptr[row + 1]; k += raft::WarpSize) {
+    IndexT col = d_indices[k];
+    top.push(-d_costs[k] - d_prices[col], col);
+  }
+  top.warp_reduce();
+
+  if (lane == 0) {
+    d_bid_targets[warp] = top.idx;
+    if (top.idx < 0) return;
+    // a single neighbor: any raise keeps the epsilon-complementary slackness
+    ValueT increment = top.second == std::numeric_limits<ValueT>::lowest()
+                         ? max_increment
+                         : top.best - top.second;
+    ValueT bid       = d_prices[top.idx] + increment + epsilon;
+    d_bids[warp]     = bid;
+    raft::myAtomicMax(d_target_bids + top.idx, bid);
+  }
+}
+
+// Kernel for the reverse bids: a warp per unassigned column of a price above lambda lowers its
+// price to attract the row of the best value (benefit minus profit), or down to lambda when no row
+// is worth it.
+template <typename ValueT, typename IndexT, typename NZT>
+__global__ void kernel_auctionReverseBid(NZT const* d_csc_indptr,
+                                         IndexT const* d_csc_rows,
+                                         ValueT const* d_csc_costs,
+                                         ValueT const* d_profits,
+                                         ValueT* d_prices,
+                                         IndexT const* d_bidders,
+                                         IndexT n_bidders,
+                                         ValueT epsilon,
+                                         ValueT lambda,
+                                         IndexT* d_bid_targets,
+                                         ValueT* d_bids,
+                                         ValueT* d_bid_prices,
+                                         ValueT* d_target_bids)
+{
+  IndexT warp = (blockIdx.x * IndexT(blockDim.x) + threadIdx.x) / raft::WarpSize;
+  int lane    = threadIdx.x % raft::WarpSize;
+  if (warp >= n_bidders) return;
+
+  IndexT col = d_bidders[warp];
+  auction_best_two<ValueT, IndexT> top;
+  for (NZT k = d_csc_indptr[col] + lane; k < d_csc_indptr[col + 1]; k += raft::WarpSize) {
+    IndexT row = d_csc_rows[k];
+    top.push(-d_csc_costs[k] - d_profits[row], row);
+  }
+  top.warp_reduce();
+
+  if (lane == 0) {
+    if (top.idx < 0 || lambda >= top.best - epsilon) {
+      d_prices[col]       = lambda;
+      d_bid_targets[warp] = -1;
+      return;
+    }
+    ValueT price = top.second == std::numeric_limits<ValueT>::lowest()
+                     ? lambda
+                     : raft::max(lambda, top.second - epsilon);
+    // the profit of the row from the column at its new price
+    ValueT bid          = top.best + d_profits[top.idx] - price;
+    d_bid_targets[warp] = top.idx;
+    d_bids[warp]        = bid;
+    d_bid_prices[warp]  = price;
+    raft::myAtomicMax(d_target_bids + top.idx, bid);
+  }
+}
+
+// Kernel for selecting the winner of every target among its highest bidders: the first one.
+template <typename ValueT, typename IndexT>
+__global__ void kernel_auctionSelectWinners(IndexT const* d_bidders,
+                                            IndexT const* d_bid_targets,
+                                            ValueT const* d_bids,
+                                            IndexT n_bidders,
+                                            ValueT const* d_target_bids,
+                                            unsigned long long* d_target_winners)
+{
+  IndexT t = blockIdx.x * IndexT(blockDim.x) + threadIdx.x;
+  if (t >= n_bidders) return;
+  IndexT target = d_bid_targets[t];
+  if (target >= 0 && d_bids[t] == d_target_bids[target]) {
+    atomicMin(d_target_winners + target, (unsigned long long)d_bidders[t]);
+  }
+}
+
+// Kernel for assigning the targets to their winners: the previous match of a target becomes
+// unassigned. With `d_bid_prices`, the bidders are the columns (reverse bids), else the rows.
+template <typename ValueT, typename IndexT>
+__global__ void kernel_auctionAssign(IndexT const* d_bidders,
+                                     IndexT const* d_bid_targets,
+                                     ValueT const* d_bids,
+                                     ValueT const* d_bid_prices,
+                                     IndexT n_bidders,
+                                     unsigned long long const* d_target_winners,
+                                     IndexT* d_bidder_matches,
+                                     IndexT* d_target_matches,
+                                     ValueT* d_prices,
+                                     ValueT* d_profits)
+{
+  IndexT t = blockIdx.x * IndexT(blockDim.x) + threadIdx.x;
+  if (t >= n_bidders) return;
+  IndexT target = d_bid_targets[t];
+  IndexT bidder = d_bidders[t];
+  if (target < 0 || d_target_winners[target] != (unsigned long long)bidder) return;
+
+  IndexT previous = d_target_matches[target];
+  if (previous >= 0) d_bidder_matches[previous] = -1;
+  d_target_matches[target] = bidder;
+  d_bidder_matches[bidder] = target;
+  if (d_bid_prices == nullptr) {
+    d_prices[target] = d_bids[t];
+  } else {
+    d_prices[bidder]  = d_bid_prices[t];
+    d_profits[target] = d_bids[t];
+  }
+}
+
+// Kernel for clearing the bids of a round.
+template <typename ValueT, typename IndexT>
+__global__ void kernel_auctionResetBids(IndexT const* d_bid_targets,
+                                        IndexT n_bidders,
+                                        ValueT* d_target_bids,
+                                        unsigned long long* d_target_winners)
+{
+  IndexT t = blockIdx.x * IndexT(blockDim.x) + threadIdx.x;
+  if (t >= n_bidders) return;
+  IndexT target = d_bid_targets[t];
+  if (target < 0) return;
+  d_target_bids[target]    = std::numeric_limits<ValueT>::lowest();
+  d_target_winners[target] = AUCTION_NO_WINNER;
+}
+
+// Kernel for the profits (benefit minus price) of the rows from their assigned columns.
+template <typename ValueT, typename IndexT, typename NZT>
+__global__ void kernel_auctionProfits(NZT const* d_indptr,
+                                      IndexT const* d_indices,
+                                      ValueT const* d_costs,
+                                      ValueT const* d_prices,
+                                      IndexT const* d_row_assignments,
+                                      IndexT n_rows,
+                                      ValueT* d_profits)
+{
+  IndexT row = blockIdx.x * IndexT(blockDim.x) + threadIdx.x;
+  if (row >= n_rows) return;
+  IndexT col = d_row_assignments[row];
+  if (col < 0) return;
+  for (NZT k = d_indptr[row]; k < d_indptr[row + 1]; k++) {
+    if (d_indices[k] == col) {
+      d_profits[row] = -d_costs[k] - d_prices[col];
+      return;
+    }
+  }
+}
+
+// Kernel for the rows of the nonzeros of a CSR matrix.
+template <typename IndexT, typename NZT>
+__global__ void kernel_auctionExpandRows(NZT const* d_indptr, IndexT n_rows, IndexT* d_rows)
+{
+  IndexT row = (blockIdx.x * IndexT(blockDim.x) + threadIdx.x) / raft::WarpSize;
+  int lane   = threadIdx.x % raft::WarpSize;
+  if (row >= n_rows) return;
+  for (NZT k = d_indptr[row] + lane; k < d_indptr[row + 1]; k += raft::WarpSize) {
+    d_rows[k] = row;
+  }
+}
+
+// The state of the bids of a round, over the bidders (rows or columns) and their targets.
+template <typename ValueT, typename IndexT>
+struct auction_bids {
+  rmm::device_uvector<IndexT> bidders;
+  rmm::device_uvector<IndexT> targets;
+  rmm::device_uvector<ValueT> bids;
+  rmm::device_uvector<ValueT> prices;
+  rmm::device_uvector<ValueT> target_bids;
+  rmm::device_uvector<unsigned long long> target_winners;
+
+  auction_bids(IndexT n_bidders, IndexT n_targets, bool reverse, cudaStream_t stream)
+    : bidders(n_bidders, stream),
+      targets(n_bidders, stream),
+      bids(n_bidders, stream),
+      prices(reverse ? n_bidders : 0, stream),
+      target_bids(n_targets, stream),
+      target_winners(n_targets, stream)
+  {
+    thrust::fill(rmm::exec_policy(stream),
+                 target_bids.begin(),
+                 target_bids.end(),
+                 std::numeric_limits<ValueT>::lowest());
+    thrust::fill(
+      rmm::exec_policy(stream), target_winners.begin(), target_winners.end(), AUCTION_NO_WINNER);
+  }
+};
+
+// Resolves the bids of a round: selection of the winners, assignment and reset of the bids.
+template <typename ValueT, typename IndexT>
+inline void resolveBids(raft::resources const& handle,
+                        auction_bids<ValueT, IndexT>& state,
+                        IndexT n_bidders,
+                        IndexT* d_bidder_matches,
+                        IndexT* d_target_matches,
+                        ValueT* d_prices,
+                        ValueT* d_profits)
+{
+  auto stream  = resource::get_cuda_stream(handle);
+  auto blocks  = raft::ceildiv<IndexT>(n_bidders, AUCTION_BLOCKDIM);
+  bool reverse = state.prices.size() > 0;
+
+  kernel_auctionSelectWinners<<<blocks, AUCTION_BLOCKDIM, 0, stream>>>(state.bidders.data(),
+                                                                      state.targets.data(),
+                                                                      state.bids.data(),
+                                                                      n_bidders,
+                                                                      state.target_bids.data(),
+                                                                      state.target_winners.data());
+  RAFT_CHECK_CUDA(stream);
+  kernel_auctionAssign<<<blocks, AUCTION_BLOCKDIM, 0, stream>>>(
+    state.bidders.data(),
+    state.targets.data(),
+    state.bids.data(),
+    reverse ? state.prices.data() : static_cast<ValueT*>(nullptr),
+    n_bidders,
+    state.target_winners.data(),
+    d_bidder_matches,
+    d_target_matches,
+    d_prices,
+    d_profits);
+  RAFT_CHECK_CUDA(stream);
+  kernel_auctionResetBids<<<blocks, AUCTION_BLOCKDIM, 0, stream>>>(
+    state.targets.data(), n_bidders, state.target_bids.data(), state.target_winners.data());
+  RAFT_CHECK_CUDA(stream);
+}
+
+// Function for the forward auction of a phase of the epsilon-scaling: all the rows start
+// unassigned and bid until they are all assigned. Returns the number of rows left unassigned.
+template <typename ValueT, typename IndexT, typename NZT>
+inline IndexT forwardAuction(raft::resources const& handle,
+                             NZT const* d_indptr,
+                             IndexT const* d_indices,
+                             ValueT const* d_costs,
+                             IndexT n_rows,
+                             IndexT n_cols,
+                             ValueT epsilon,
+                             ValueT max_increment,
+                             int max_rounds,
+                             ValueT* d_prices,
+                             IndexT* d_row_assignments,
+                             IndexT* d_col_assignments,
+                             auction_bids<ValueT, IndexT>& state)
+{
+  auto stream = resource::get_cuda_stream(handle);
+  auto policy = resource::get_thrust_policy(handle);
+  thrust::fill(policy, d_row_assignments, d_row_assignments + n_rows, IndexT{-1});
+  thrust::fill(policy, d_col_assignments, d_col_assignments + n_cols, IndexT{-1});
+
+  // the rows without neighbors can never be assigned: they never bid
+  auto bidding = [d_row_assignments, d_indptr] __device__(IndexT row) {
+    return d_row_assignments[row] < 0 && d_indptr[row + 1] > d_indptr[row];
+  };
+  IndexT n_bidders = 0;
+  for (int round = 0; round < max_rounds; round++) {
+    auto end  = thrust::copy_if(policy,
+                                thrust::make_counting_iterator<IndexT>(0),
+                                thrust::make_counting_iterator<IndexT>(n_rows),
+                                state.bidders.data(),
+                                bidding);
+    n_bidders = IndexT(end - state.bidders.data());
+    if (n_bidders == 0) break;
+
+    auto warps_per_block = AUCTION_BLOCKDIM / raft::WarpSize;
+    auto blocks          = raft::ceildiv<IndexT>(n_bidders, warps_per_block);
+    kernel_auctionBid<<<blocks, AUCTION_BLOCKDIM, 0, stream>>>(d_indptr,
+                                                               d_indices,
+                                                               d_costs,
+                                                               d_prices,
+                                                               state.bidders.data(),
+                                                               n_bidders,
+                                                               epsilon,
+                                                               max_increment,
+                                                               state.targets.data(),
+                                                               state.bids.data(),
+                                                               state.target_bids.data());
+    RAFT_CHECK_CUDA(stream);
+    resolveBids(handle,
+                state,
+                n_bidders,
+                d_row_assignments,
+                d_col_assignments,
+                d_prices,
+                static_cast<ValueT*>(nullptr));
+  }
+  return thrust::count(policy, d_row_assignments, d_row_assignments + n_rows, IndexT{-1});
+}
+
+// Function for the reverse auction which follows the last forward auction when there are more
+// columns than rows: the unassigned columns of a price above lambda, the lowest price of the
+// assigned ones, lower their prices until every unassigned column is priced at most lambda; the
+// assignment is then epsilon-optimal for the asymmetric problem.
+template <typename ValueT, typename IndexT, typename NZT>
+inline void reverseAuction(raft::resources const& handle,
+                           NZT const* d_indptr,
+                           IndexT const* d_indices,
+                           ValueT const* d_costs,
+                           NZT nnz,
+                           IndexT n_rows,
+                           IndexT n_cols,
+                           ValueT epsilon,
+                           int max_rounds,
+                           ValueT* d_prices,
+                           IndexT* d_row_assignments,
+                           IndexT* d_col_assignments)
+{
+  auto stream = resource::get_cuda_stream(handle);
+  auto policy = resource::get_thrust_policy(handle);
+
+  // the transposed (CSC) cost matrix
+  rmm::device_uvector<IndexT> csc_cols(nnz, stream);
+  rmm::device_uvector<IndexT> csc_rows(nnz, stream);
+  rmm::device_uvector<ValueT> csc_costs(nnz, stream);
+  rmm::device_uvector<NZT> csc_indptr(n_cols + 1, stream);
+  {
+    rmm::device_uvector<IndexT> rows(nnz, stream);
+    rmm::device_uvector<NZT> perm(nnz, stream);
+    auto warps_per_block = AUCTION_BLOCKDIM / raft::WarpSize;
+    kernel_auctionExpandRows<<<raft::ceildiv<IndexT>(n_rows, warps_per_block),
+                               AUCTION_BLOCKDIM,
+                               0,
+                               stream>>>(d_indptr, n_rows, rows.data());
+    RAFT_CHECK_CUDA(stream);
+    raft::copy(csc_cols.data(), d_indices, nnz, stream);
+    thrust::sequence(policy, perm.begin(), perm.end());
+    thrust::stable_sort_by_key(policy, csc_cols.begin(), csc_cols.end(), perm.begin());
+    thrust::gather(policy, perm.begin(), perm.end(), rows.begin(), csc_rows.begin());
+    thrust::gather(policy, perm.begin(), perm.end(), d_costs, csc_costs.begin());
+    thrust::lower_bound(policy,
+                        csc_cols.begin(),
+                        csc_cols.end(),
+                        thrust::make_counting_iterator<IndexT>(0),
+                        thrust::make_counting_iterator<IndexT>(n_cols + 1),
+                        csc_indptr.begin());
+  }
+
+  rmm::device_uvector<ValueT> profits(n_rows, stream);
+  kernel_auctionProfits<<<raft::ceildiv<IndexT>(n_rows, AUCTION_BLOCKDIM),
+                          AUCTION_BLOCKDIM,
+                          0,
+                          stream>>>(
+    d_indptr, d_indices, d_costs, d_prices, d_row_assignments, n_rows, profits.data());
+  RAFT_CHECK_CUDA(stream);
+
+  auto assigned_price = [d_prices, d_col_assignments] __device__(IndexT col) {
+    return d_col_assignments[col] >= 0 ? d_prices[col] : std::numeric_limits<ValueT>::max();
+  };
+  ValueT lambda = thrust::transform_reduce(policy,
+                                           thrust::make_counting_iterator<IndexT>(0),
+                                           thrust::make_counting_iterator<IndexT>(n_cols),
+                                           assigned_price,
+                                           std::numeric_limits<ValueT>::max(),
+                                           thrust::minimum<ValueT>());
+
+  auction_bids<ValueT, IndexT> state(n_cols, n_rows, true, stream);
+  auto bidding = [d_col_assignments, d_prices, lambda] __device__(IndexT col) {
+    return d_col_assignments[col] < 0 && d_prices[col] > lambda;
+  };
+  for (int round = 0; round < max_rounds; round++) {
+    auto end         = thrust::copy_if(policy,
+                                       thrust::make_counting_iterator<IndexT>(0),
+                                       thrust::make_counting_iterator<IndexT>(n_cols),
+                                       state.bidders.data(),
+                                       bidding);
+    IndexT n_bidders = IndexT(end - state.bidders.data());
+    if (n_bidders == 0) break;
+
+    auto warps_per_block = AUCTION_BLOCKDIM / raft::WarpSize;
+    auto blocks          = raft::ceildiv<IndexT>(n_bidders, warps_per_block);
+    kernel_auctionReverseBid<<<blocks, AUCTION_BLOCKDIM, 0, stream>>>(csc_indptr.data(),
+                                                                      csc_rows.data(),
+                                                                      csc_costs.data(),
+                                                                      profits.data(),
+                                                                      d_prices,
+                                                                      state.bidders.data(),
+                                                                      n_bidders,
+                                                                      epsilon,
+                                                                      lambda,
+                                                                      state.targets.data(),
+                                                                      state.bids.data(),
+                                                                      state.prices.data(),
+                                                                      state.target_bids.data());
+    RAFT_CHECK_CUDA(stream);
+    resolveBids(
+      handle, state, n_bidders, d_col_assignments, d_row_assignments, d_prices, profits.data());
+  }
+}
+
+// Function for solving the sparse asymmetric assignment problem by epsilon-scaling forward
+// auctions, followed by a reverse auction when there are more columns than rows. Returns the
+// number of rows left unassigned.
+template <typename ValueT, typename IndexT, typename NZT>
+IndexT sparseAuction(raft::resources const& handle,
+                     NZT const* d_indptr,
+                     IndexT const* d_indices,
+                     ValueT const* d_costs,
+                     NZT nnz,
+                     IndexT n_rows,
+                     IndexT n_cols,
+                     IndexT* d_row_assignments,
+                     IndexT* d_col_assignments,
+                     const auction_params& params)
+{
+  auto stream = resource::get_cuda_stream(handle);
+  auto policy = resource::get_thrust_policy(handle);
+  if (n_rows == 0) return 0;
+  if (nnz == 0) {
+    thrust::fill(policy, d_row_assignments, d_row_assignments + n_rows, IndexT{-1});
+    thrust::fill(policy, d_col_assignments, d_col_assignments + n_cols, IndexT{-1});
+    return n_rows;
+  }
+
+  // the range of the costs bounds the raises of the bids and the initial epsilon
+  auto minmax = thrust::minmax_element(policy, d_costs, d_costs + nnz);
+  ValueT lo, hi;
+  raft::update_host(&lo, thrust::raw_pointer_cast(&*minmax.first), 1, stream);
+  raft::update_host(&hi, thrust::raw_pointer_cast(&*minmax.second), 1, stream);
+  resource::sync_stream(handle, stream);
+
+  ValueT range         = hi - lo;
+  ValueT final_epsilon = params.epsilon > 0 ? ValueT(params.epsilon) : ValueT(1) / (n_rows + 1);
+  ValueT scaling       = ValueT(params.epsilon_scaling);
+  ValueT epsilon       = std::max(range / scaling, final_epsilon);
+
+  rmm::device_uvector<ValueT> prices(n_cols, stream);
+  thrust::fill(policy, prices.begin(), prices.end(), ValueT{0});
+  auction_bids<ValueT, IndexT> state(n_rows, n_cols, false, stream);
+  while (true) {
+    IndexT unassigned = forwardAuction(handle,
+                                       d_indptr,
+                                       d_indices,
+                                       d_costs,
+                                       n_rows,
+                                       n_cols,
+                                       epsilon,
+                                       range + epsilon,
+                                       params.max_rounds,
+                                       prices.data(),
+                                       d_row_assignments,
+                                       d_col_assignments,
+                                       state);
+    if (unassigned > 0) return unassigned;
+    if (epsilon <= final_epsilon) break;
+    epsilon = std::max(epsilon / scaling, final_epsilon);
+  }
+  if (n_cols > n_rows) {
+    reverseAuction(handle,
+                   d_indptr,
+                   d_indices,
+                   d_costs,
+                   nnz,
+                   n_rows,
+                   n_cols,
+                   epsilon,
+                   params.max_rounds,
+                   prices.data(),
+                   d_row_assignments,
+                   d_col_assignments);
+  }
+  return 0;
+}
+
+}  // namespace raft::solver::detail
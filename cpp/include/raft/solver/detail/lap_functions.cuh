@@ -38,6 +38,7 @@
 #include <thrust/reduce.h>
 #include <thrust/scan.h>
 
+#include <algorithm>
 #include <cstddef>
 
 namespace raft::solver::detail {
@@ -45,6 +46,13 @@ namespace raft::solver::detail {
 const int BLOCKDIMX{64};
 const int BLOCKDIMY{1};
 
+// Up to this size, the problems of a batch are solved by kernel_smallProblems.
+const int SMALL_PROBLEM_MAX_SIZE{128};
+// A warp per problem.
+const int SMALL_PROBLEM_THREADS{32};
+// The problems of a batch beyond this many blocks are strided over the blocks.
+const int SMALL_PROBLEM_MAX_BLOCKS{65536};
+
 // Function for calculating grid and block dimensions from the given input size.
 inline void calculateLinearDims(dim3& blocks_per_grid,
                                 dim3& threads_per_block,
@@ -563,4 +571,37 @@ inline void calcObjValPrimal(raft::resources const& handle,
   RAFT_CHECK_CUDA(resource::get_cuda_stream(handle));
 }
 
+
+// Function for solving a batch of small problems with a single kernel launch.
+template <typename vertex_t, typename weight_t>
+inline void solveSmallProblems(raft::resources const& handle,
+                               weight_t const* d_costs,
+                               Vertices<vertex_t, weight_t>& d_vertices_dev,
+                               weight_t* d_obj_val_primal,
+                               weight_t* d_obj_val_dual,
+                               int SP,
+                               vertex_t N)
+{
+  if (SP == 0 || N == 0) return;
+
+  size_t smem_size = 3 * (N + 1) * sizeof(weight_t) + 2 * (N + 1) * sizeof(vertex_t) +
+                     (N + 1) * sizeof(int);
+  int blocks       = std::min(SP, SMALL_PROBLEM_MAX_BLOCKS);
+
+  kernel_smallProblems<<<blocks,
+                         SMALL_PROBLEM_THREADS,
+                         smem_size,
+                         resource::get_cuda_stream(handle)>>>(d_costs,
+                                                              d_vertices_dev.row_assignments,
+                                                              d_vertices_dev.col_assignments,
+                                                              d_vertices_dev.row_duals,
+                                                              d_vertices_dev.col_duals,
+                                                              d_obj_val_primal,
+                                                              d_obj_val_dual,
+                                                              SP,
+                                                              N);
+
+  RAFT_CHECK_CUDA(resource::get_cuda_stream(handle));
+}
+
 }  // namespace raft::solver::detail
@@ -33,6 +33,7 @@
 #include <thrust/for_each.h>
 
 #include <cstddef>
+#include <limits>
 namespace raft::solver::detail {
 const int DORMANT{0};
 const int ACTIVE{1};
@@ -552,4 +553,130 @@ __global__ void kernel_calcObjValPrimal(weight_t* d_obj_val_primal,
   }
 }
 
+
+// Kernel for solving a batch of small problems entirely on the device, one warp (the whole block)
+// per problem. This is the shortest augmenting path variant of the Hungarian algorithm (Jonker &
+// Volgenant): the rows are added one at a time, each one by a Dijkstra-like search over the
+// columns, with the lanes of the warp scanning the columns and the minimum slack found by a warp
+// reduction. The potentials, the matching and the search state of a problem live in shared
+// memory, so that a problem needs no host loop and no convergence check through the host.
+template <typename vertex_t, typename weight_t>
+__global__ void kernel_smallProblems(weight_t const* d_costs,
+                                     vertex_t* d_row_assignments,
+                                     vertex_t* d_col_assignments,
+                                     weight_t* d_row_duals,
+                                     weight_t* d_col_duals,
+                                     weight_t* d_obj_val_primal,
+                                     weight_t* d_obj_val_dual,
+                                     int SP,
+                                     vertex_t N)
+{
+  extern __shared__ __align__(16) char smem_buf[];
+  // 1-based rows and columns: the column 0 is the root of the search of the current row
+  weight_t* u    = reinterpret_cast<weight_t*>(smem_buf);
+  weight_t* v    = u + N + 1;
+  weight_t* minv = v + N + 1;
+  vertex_t* p    = reinterpret_cast<vertex_t*>(minv + N + 1);
+  vertex_t* way  = p + N + 1;
+  int* used      = reinterpret_cast<int*>(way + N + 1);
+
+  const int lane     = threadIdx.x;
+  const weight_t inf = std::numeric_limits<weight_t>::max();
+
+  for (int spid = blockIdx.x; spid < SP; spid += gridDim.x) {
+    weight_t const* costs = d_costs + size_t(spid) * N * N;
+    for (vertex_t j = lane; j <= N; j += blockDim.x) {
+      u[j]   = 0;
+      v[j]   = 0;
+      p[j]   = 0;
+      way[j] = 0;
+    }
+    __syncwarp();
+
+    for (vertex_t i = 1; i <= N; i++) {
+      for (vertex_t j = lane; j <= N; j += blockDim.x) {
+        minv[j] = inf;
+        used[j] = 0;
+      }
+      if (lane == 0) p[0] = i;
+      __syncwarp();
+
+      vertex_t j0 = 0;
+      do {
+        if (lane == 0) used[j0] = 1;
+        __syncwarp();
+        vertex_t i0    = p[j0];
+        weight_t ui0   = u[i0];
+        weight_t delta = inf;
+        vertex_t j1    = 0;
+        for (vertex_t j = lane + 1; j <= N; j += blockDim.x) {
+          if (used[j]) continue;
+          weight_t cur = costs[size_t(i0 - 1) * N + (j - 1)] - ui0 - v[j];
+          if (cur < minv[j]) {
+            minv[j] = cur;
+            way[j]  = j0;
+          }
+          if (j1 == 0 || minv[j] < delta) {
+            delta = minv[j];
+            j1    = j;
+          }
+        }
+        // the smallest slack of the warp, the first column of it on ties
+        for (int offset = warpSize / 2; offset > 0; offset /= 2) {
+          weight_t other_delta = __shfl_xor_sync(0xffffffff, delta, offset);
+          vertex_t other_j     = __shfl_xor_sync(0xffffffff, j1, offset);
+          if (other_j != 0 &&
+              (j1 == 0 || other_delta < delta || (other_delta == delta && other_j < j1))) {
+            delta = other_delta;
+            j1    = other_j;
+          }
+        }
+        __syncwarp();
+        for (vertex_t j = lane; j <= N; j += blockDim.x) {
+          if (used[j]) {
+            u[p[j]] += delta;
+            v[j] -= delta;
+          } else {
+            minv[j] -= delta;
+          }
+        }
+        __syncwarp();
+        j0 = j1;
+      } while (p[j0] != 0);
+
+      // augment the matching along the path of the search
+      if (lane == 0) {
+        do {
+          vertex_t j1 = way[j0];
+          p[j0]       = p[j1];
+          j0          = j1;
+        } while (j0 != 0);
+      }
+      __syncwarp();
+    }
+
+    weight_t primal = 0;
+    weight_t dual   = 0;
+    for (vertex_t j = lane + 1; j <= N; j += blockDim.x) {
+      vertex_t row = p[j] - 1;
+      vertex_t col = j - 1;
+      d_row_assignments[size_t(spid) * N + row] = col;
+      d_col_assignments[size_t(spid) * N + col] = row;
+      d_row_duals[size_t(spid) * N + col]       = u[j];
+      d_col_duals[size_t(spid) * N + col]       = v[j];
+      primal += costs[size_t(row) * N + col];
+      dual += u[j] + v[j];
+    }
+    for (int offset = warpSize / 2; offset > 0; offset /= 2) {
+      primal += __shfl_xor_sync(0xffffffff, primal, offset);
+      dual += __shfl_xor_sync(0xffffffff, dual, offset);
+    }
+    if (lane == 0) {
+      d_obj_val_primal[spid] = primal;
+      d_obj_val_dual[spid]   = dual;
+    }
+    __syncwarp();
+  }
+}
+
 }  // namespace raft::solver::detail
\ No newline at end of file
@@ -112,6 +112,11 @@ class LinearAssignmentProblem {
 
   /**
    * Executes Hungarian algorithm on the input cost matrix.
+   *
+   * Problems of size up to 128 are solved with a single kernel launch for the whole batch, a warp
+   * per problem, without any host synchronization; the larger ones by the steps of the
+   * alternating tree algorithm.
+   *
    * @param d_cost_matrix
    * @param d_row_assignment
    * @param d_col_assignment
@@ -125,6 +130,18 @@ class LinearAssignmentProblem {
 
     d_costs_ = d_cost_matrix;
 
+    if (size_ <= detail::SMALL_PROBLEM_MAX_SIZE) {
+      detail::solveSmallProblems(handle_,
+                                 d_costs_,
+                                 d_vertices_dev,
+                                 obj_val_primal_v.data(),
+                                 obj_val_dual_v.data(),
+                                 batchsize_,
+                                 size_);
+      d_costs_ = nullptr;
+      return;
+    }
+
     int step = 0;
 
     while (step != 100) {
@@ -42,4 +42,23 @@ struct VertexData {
   vertex_t* children;
   int* is_visited;
 };
+
+/**
+ * @brief The parameters of the auction solver of `sparse_linear_assignment`.
+ */
+struct auction_params {
+  /**
+   * The final epsilon of the epsilon-scaling: the assignment is within `n_rows * epsilon` of the
+   * optimal cost. When not positive, 1 / (n_rows + 1), the largest one which gives the optimal
+   * assignment of integer costs.
+   */
+  double epsilon = 0;
+  /** The factor epsilon is divided by from a phase of the epsilon-scaling to the next one. */
+  double epsilon_scaling = 4;
+  /**
+   * The maximum number of bidding rounds of a phase, beyond which the rows still unassigned are
+   * considered unassignable (the bipartite graph has no matching of all the rows).
+   */
+  int max_rounds = 100000;
+};
 }  // namespace raft::solver
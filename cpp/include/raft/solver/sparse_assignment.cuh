@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/error.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/solver/detail/auction.cuh>
+#include <raft/solver/linear_assignment_types.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <optional>
+#include <type_traits>
+
+namespace raft::solver {
+
+/**
+ * @defgroup sparse_assignment Sparse linear assignment
+ * @{
+ */
+
+/**
+ * @brief Solve the linear assignment problem of a sparse, possibly rectangular, cost matrix by
+ * the auction algorithm.
+ *
+ * Every row is assigned a distinct column of one of its nonzeros, minimizing the sum of the costs
+ * of the assignment; `n_cols - n_rows` columns stay unassigned. Unlike
+ * `LinearAssignmentProblem`, the cost matrix is neither padded nor densified: the memory and the
+ * work of every bidding round scale with the number of nonzeros.
+ *
+ * The rows bid in parallel (a warp per row, Jacobi style) in phases of decreasing epsilon
+ * (epsilon-scaling); when there are more columns than rows, a reverse auction, in which the
+ * unassigned columns bid for the rows, follows the last phase. The assignment is within
+ * `n_rows * params.epsilon` of the optimal cost, which makes it optimal for integer costs with the
+ * default epsilon.
+ *
+ * @code{.cpp}
+ *   auto structure = raft::make_device_compressed_structure_view(
+ *     indptr, indices, n_rows, n_cols, nnz);
+ *   auto costs = raft::make_device_csr_matrix_view<const float, int, int, int>(values, structure);
+ *   auto row_assignment = raft::make_device_vector<int, int>(handle, n_rows);
+ *   int unassigned = raft::solver::sparse_linear_assignment(handle, costs, row_assignment.view());
+ * @endcode
+ *
+ * @tparam ValueT the type of the costs (float or double)
+ * @tparam IndexT the type of the row offsets and of the column indices
+ * @tparam NZT the type of the number of nonzeros
+ *
+ * @param[in] handle the raft handle
+ * @param[in] costs the cost matrix [n_rows, n_cols], n_rows <= n_cols
+ * @param[out] row_assignment the column of every row [n_rows], -1 for an unassigned row
+ * @param[out] col_assignment the optional row of every column [n_cols], -1 for an unassigned
+ *   column
+ * @param[in] params the parameters of the auction
+ * @return the number of rows left unassigned: 0 unless the bipartite graph has no matching of all
+ *   the rows (or `params.max_rounds` was too small), in which case the assignment is incomplete
+ *   and not optimal
+ */
+template <typename ValueT, typename IndexT, typename NZT>
+IndexT sparse_linear_assignment(
+  raft::resources const& handle,
+  raft::device_csr_matrix_view<const ValueT, IndexT, IndexT, NZT> costs,
+  raft::device_vector_view<IndexT, IndexT> row_assignment,
+  std::optional<raft::device_vector_view<IndexT, IndexT>> col_assignment = std::nullopt,
+  const auction_params& params                                          = auction_params{})
+{
+  static_assert(std::is_floating_point_v<ValueT>, "The costs must be float or double");
+  auto structure = costs.structure_view();
+  IndexT n_rows  = structure.get_n_rows();
+  IndexT n_cols  = structure.get_n_cols();
+  RAFT_EXPECTS(n_rows <= n_cols, "There must be at most as many rows as columns");
+  RAFT_EXPECTS(row_assignment.extent(0) == n_rows, "row_assignment must be of size n_rows");
+  RAFT_EXPECTS(params.epsilon_scaling > 1, "epsilon_scaling must be greater than 1");
+  RAFT_EXPECTS(params.max_rounds > 0, "max_rounds must be positive");
+
+  auto stream = resource::get_cuda_stream(handle);
+  rmm::device_uvector<IndexT> cols(col_assignment.has_value() ? 0 : n_cols, stream);
+  IndexT* d_col_assignment = cols.data();
+  if (col_assignment.has_value()) {
+    RAFT_EXPECTS(col_assignment->extent(0) == n_cols, "col_assignment must be of size n_cols");
+    d_col_assignment = col_assignment->data_handle();
+  }
+  // the offsets of the rows are of the index type: so is the number of nonzeros
+  return detail::sparseAuction<ValueT, IndexT, IndexT>(handle,
+                                                       structure.get_indptr().data(),
+                                                       structure.get_indices().data(),
+                                                       costs.get_elements().data(),
+                                                       IndexT(structure.get_nnz()),
+                                                       n_rows,
+                                                       n_cols,
+                                                       row_assignment.data_handle(),
+                                                       d_col_assignment,
+                                                       params);
+}
+
+/** @} */
+
+}  // namespace raft::solver
@@ -16,12 +16,16 @@
 
 #pragma once
 
+#include <cuda_fp16.h>
 #include <cusparse.h>
 #include <raft/core/cusparse_macros.hpp>
 #include <raft/core/error.hpp>
 #include <raft/linalg/transpose.cuh>
 #include <rmm/device_uvector.hpp>
 
+#include <cstdint>
+#include <type_traits>
+
 namespace raft {
 namespace sparse {
 namespace detail {
@@ -150,6 +154,17 @@ inline void cusparsecoosortByRow(  // NOLINT
 /** @} */
 
 #if not defined CUDA_ENFORCE_LOWER and CUDA_VER_10_1_UP
+/**
+ * The compute type of the generic products (SpMV, SpMM) of the `ValueT` inputs into the `OutT`
+ * outputs, which is also the type of the alpha and beta scalars: the half and int8 inputs are
+ * accumulated in fp32, except for the int8 products into int32 outputs.
+ */
+template <typename ValueT, typename OutT = ValueT>
+using spmm_compute_t =
+  std::conditional_t<std::is_same_v<OutT, int32_t>,
+                     int32_t,
+                     std::conditional_t<std::is_same_v<ValueT, double>, double, float>>;
+
 /**
  * @defgroup cusparse Create CSR operations
  * @{
@@ -246,6 +261,90 @@ inline cusparseStatus_t cusparsecreatecsr(cusparseSpMatDescr_t* spMatDescr,
                            CUSPARSE_INDEX_BASE_ZERO,
                            CUDA_R_64F);
 }
+template <>
+inline cusparseStatus_t cusparsecreatecsr(cusparseSpMatDescr_t* spMatDescr,
+                                          int64_t rows,
+                                          int64_t cols,
+                                          int64_t nnz,
+                                          int* csrRowOffsets,
+                                          int* csrColInd,
+                                          half* csrValues)
+{
+  return cusparseCreateCsr(spMatDescr,
+                           rows,
+                           cols,
+                           nnz,
+                           csrRowOffsets,
+                           csrColInd,
+                           csrValues,
+                           CUSPARSE_INDEX_32I,
+                           CUSPARSE_INDEX_32I,
+                           CUSPARSE_INDEX_BASE_ZERO,
+                           CUDA_R_16F);
+}
+template <>
+inline cusparseStatus_t cusparsecreatecsr(cusparseSpMatDescr_t* spMatDescr,
+                                          int64_t rows,
+                                          int64_t cols,
+                                          int64_t nnz,
+                                          int64_t* csrRowOffsets,
+                                          int64_t* csrColInd,
+                                          half* csrValues)
+{
+  return cusparseCreateCsr(spMatDescr,
+                           rows,
+                           cols,
+                           nnz,
+                           csrRowOffsets,
+                           csrColInd,
+                           csrValues,
+                           CUSPARSE_INDEX_64I,
+                           CUSPARSE_INDEX_64I,
+                           CUSPARSE_INDEX_BASE_ZERO,
+                           CUDA_R_16F);
+}
+template <>
+inline cusparseStatus_t cusparsecreatecsr(cusparseSpMatDescr_t* spMatDescr,
+                                          int64_t rows,
+                                          int64_t cols,
+                                          int64_t nnz,
+                                          int* csrRowOffsets,
+                                          int* csrColInd,
+                                          int8_t* csrValues)
+{
+  return cusparseCreateCsr(spMatDescr,
+                           rows,
+                           cols,
+                           nnz,
+                           csrRowOffsets,
+                           csrColInd,
+                           csrValues,
+                           CUSPARSE_INDEX_32I,
+                           CUSPARSE_INDEX_32I,
+                           CUSPARSE_INDEX_BASE_ZERO,
+                           CUDA_R_8I);
+}
+template <>
+inline cusparseStatus_t cusparsecreatecsr(cusparseSpMatDescr_t* spMatDescr,
+                                          int64_t rows,
+                                          int64_t cols,
+                                          int64_t nnz,
+                                          int64_t* csrRowOffsets,
+                                          int64_t* csrColInd,
+                                          int8_t* csrValues)
+{
+  return cusparseCreateCsr(spMatDescr,
+                           rows,
+                           cols,
+                           nnz,
+                           csrRowOffsets,
+                           csrColInd,
+                           csrValues,
+                           CUSPARSE_INDEX_64I,
+                           CUSPARSE_INDEX_64I,
+                           CUSPARSE_INDEX_BASE_ZERO,
+                           CUDA_R_8I);
+}
 /** @} */
 /**
  * @defgroup cusparse CreateDnVec operations
@@ -267,6 +366,27 @@ inline cusparseStatus_t cusparsecreatednvec(cusparseDnVecDescr_t* dnVecDescr,
 {
   return cusparseCreateDnVec(dnVecDescr, size, values, CUDA_R_64F);
 }
+template <>
+inline cusparseStatus_t cusparsecreatednvec(cusparseDnVecDescr_t* dnVecDescr,
+                                            int64_t size,
+                                            half* values)
+{
+  return cusparseCreateDnVec(dnVecDescr, size, values, CUDA_R_16F);
+}
+template <>
+inline cusparseStatus_t cusparsecreatednvec(cusparseDnVecDescr_t* dnVecDescr,
+                                            int64_t size,
+                                            int8_t* values)
+{
+  return cusparseCreateDnVec(dnVecDescr, size, values, CUDA_R_8I);
+}
+template <>
+inline cusparseStatus_t cusparsecreatednvec(cusparseDnVecDescr_t* dnVecDescr,
+                                            int64_t size,
+                                            int32_t* values)
+{
+  return cusparseCreateDnVec(dnVecDescr, size, values, CUDA_R_32I);
+}
 /** @} */
 
 /**
@@ -300,6 +420,36 @@ inline cusparseStatus_t cusparsecreatednmat(cusparseDnMatDescr_t* dnMatDescr,
 {
   return cusparseCreateDnMat(dnMatDescr, rows, cols, ld, values, CUDA_R_64F, order);
 }
+template <>
+inline cusparseStatus_t cusparsecreatednmat(cusparseDnMatDescr_t* dnMatDescr,
+                                            int64_t rows,
+                                            int64_t cols,
+                                            int64_t ld,
+                                            half* values,
+                                            cusparseOrder_t order)
+{
+  return cusparseCreateDnMat(dnMatDescr, rows, cols, ld, values, CUDA_R_16F, order);
+}
+template <>
+inline cusparseStatus_t cusparsecreatednmat(cusparseDnMatDescr_t* dnMatDescr,
+                                            int64_t rows,
+                                            int64_t cols,
+                                            int64_t ld,
+                                            int8_t* values,
+                                            cusparseOrder_t order)
+{
+  return cusparseCreateDnMat(dnMatDescr, rows, cols, ld, values, CUDA_R_8I, order);
+}
+template <>
+inline cusparseStatus_t cusparsecreatednmat(cusparseDnMatDescr_t* dnMatDescr,
+                                            int64_t rows,
+                                            int64_t cols,
+                                            int64_t ld,
+                                            int32_t* values,
+                                            cusparseOrder_t order)
+{
+  return cusparseCreateDnMat(dnMatDescr, rows, cols, ld, values, CUDA_R_32I, order);
+}
 /** @} */
 
 /**
@@ -349,6 +499,22 @@ inline cusparseStatus_t cusparsespmv_buffersize(cusparseHandle_t handle,
   return cusparseSpMV_bufferSize(
     handle, opA, alpha, matA, vecX, beta, vecY, CUDA_R_64F, alg, bufferSize);
 }
+template <>
+inline cusparseStatus_t cusparsespmv_buffersize(cusparseHandle_t handle,
+                                                cusparseOperation_t opA,
+                                                const int32_t* alpha,
+                                                const cusparseSpMatDescr_t matA,
+                                                const cusparseDnVecDescr_t vecX,
+                                                const int32_t* beta,
+                                                const cusparseDnVecDescr_t vecY,
+                                                cusparseSpMVAlg_t alg,
+                                                size_t* bufferSize,
+                                                cudaStream_t stream)
+{
+  CUSPARSE_CHECK(cusparseSetStream(handle, stream));
+  return cusparseSpMV_bufferSize(
+    handle, opA, alpha, matA, vecX, beta, vecY, CUDA_R_32I, alg, bufferSize);
+}
 
 template <typename T>
 cusparseStatus_t cusparsespmv(cusparseHandle_t handle,
@@ -391,6 +557,21 @@ inline cusparseStatus_t cusparsespmv(cusparseHandle_t handle,
   CUSPARSE_CHECK(cusparseSetStream(handle, stream));
   return cusparseSpMV(handle, opA, alpha, matA, vecX, beta, vecY, CUDA_R_64F, alg, externalBuffer);
 }
+template <>
+inline cusparseStatus_t cusparsespmv(cusparseHandle_t handle,
+                                     cusparseOperation_t opA,
+                                     const int32_t* alpha,
+                                     const cusparseSpMatDescr_t matA,
+                                     const cusparseDnVecDescr_t vecX,
+                                     const int32_t* beta,
+                                     const cusparseDnVecDescr_t vecY,
+                                     cusparseSpMVAlg_t alg,
+                                     int32_t* externalBuffer,
+                                     cudaStream_t stream)
+{
+  CUSPARSE_CHECK(cusparseSetStream(handle, stream));
+  return cusparseSpMV(handle, opA, alpha, matA, vecX, beta, vecY, CUDA_R_32I, alg, externalBuffer);
+}
 /** @} */
 #else
 /**
@@ -507,6 +688,23 @@ inline cusparseStatus_t cusparsespmm_bufferSize(cusparseHandle_t handle,
   return cusparseSpMM_bufferSize(
     handle, opA, opB, alpha, matA, matB, beta, matC, CUDA_R_64F, alg, bufferSize);
 }
+template <>
+inline cusparseStatus_t cusparsespmm_bufferSize(cusparseHandle_t handle,
+                                                cusparseOperation_t opA,
+                                                cusparseOperation_t opB,
+                                                const int32_t* alpha,
+                                                const cusparseSpMatDescr_t matA,
+                                                const cusparseDnMatDescr_t matB,
+                                                const int32_t* beta,
+                                                cusparseDnMatDescr_t matC,
+                                                cusparseSpMMAlg_t alg,
+                                                size_t* bufferSize,
+                                                cudaStream_t stream)
+{
+  CUSPARSE_CHECK(cusparseSetStream(handle, stream));
+  return cusparseSpMM_bufferSize(
+    handle, opA, opB, alpha, matA, matB, beta, matC, CUDA_R_32I, alg, bufferSize);
+}
 template <typename T>
 inline cusparseStatus_t cusparsespmm(cusparseHandle_t handle,
                                      cusparseOperation_t opA,
@@ -571,6 +769,75 @@ inline cusparseStatus_t cusparsespmm(cusparseHandle_t handle,
                       alg,
                       static_cast<void*>(externalBuffer));
 }
+template <>
+inline cusparseStatus_t cusparsespmm(cusparseHandle_t handle,
+                                     cusparseOperation_t opA,
+                                     cusparseOperation_t opB,
+                                     const int32_t* alpha,
+                                     const cusparseSpMatDescr_t matA,
+                                     const cusparseDnMatDescr_t matB,
+                                     const int32_t* beta,
+                                     cusparseDnMatDescr_t matC,
+                                     cusparseSpMMAlg_t alg,
+                                     int32_t* externalBuffer,
+                                     cudaStream_t stream)
+{
+  CUSPARSE_CHECK(cusparseSetStream(handle, stream));
+  return cusparseSpMM(handle,
+                      opA,
+                      opB,
+                      static_cast<void const*>(alpha),
+                      matA,
+                      matB,
+                      static_cast<void const*>(beta),
+                      matC,
+                      CUDA_R_32I,
+                      alg,
+                      static_cast<void*>(externalBuffer));
+}
+#if CUDART_VERSION >= 11020
+/**
+ * Analyze the sparse matrix once for the SpMM calls which reuse the same descriptors and
+ * `externalBuffer`; the buffer must stay alive and unmodified until the last of these calls.
+ */
+template <typename T,
+          typename std::enable_if_t<std::is_same_v<T, float> || std::is_same_v<T, double> ||
+                                    std::is_same_v<T, int32_t>>* = nullptr>
+cusparseStatus_t cusparsespmm_preprocess(cusparseHandle_t handle,
+                                         cusparseOperation_t opA,
+                                         cusparseOperation_t opB,
+                                         const T* alpha,
+                                         const cusparseSpMatDescr_t matA,
+                                         const cusparseDnMatDescr_t matB,
+                                         const T* beta,
+                                         cusparseDnMatDescr_t matC,
+                                         cusparseSpMMAlg_t alg,
+                                         void* externalBuffer,
+                                         cudaStream_t stream)
+{
+  auto constexpr float_type = []() constexpr {
+    if constexpr (std::is_same_v<T, float>) {
+      return CUDA_R_32F;
+    } else if constexpr (std::is_same_v<T, double>) {
+      return CUDA_R_64F;
+    } else if constexpr (std::is_same_v<T, int32_t>) {
+      return CUDA_R_32I;
+    }
+  }();
+  CUSPARSE_CHECK(cusparseSetStream(handle, stream));
+  return cusparseSpMM_preprocess(handle,
+                                 opA,
+                                 opB,
+                                 static_cast<void const*>(alpha),
+                                 matA,
+                                 matB,
+                                 static_cast<void const*>(beta),
+                                 matC,
+                                 float_type,
+                                 alg,
+                                 externalBuffer);
+}
+#endif
 /** @} */
 #else
 /**
@@ -645,6 +912,111 @@ inline cusparseStatus_t cusparsecsrmm(cusparseHandle_t handle,
 /** @} */
 #endif
 
+#if not defined CUDA_ENFORCE_LOWER and CUDA_VER_10_1_UP
+/**
+ * @defgroup SpGEMM cusparse sparse-sparse matrix multiplication (CSR x CSR -> CSR)
+ * @{
+ */
+namespace spgemm_detail {
+template <typename T>
+constexpr cudaDataType_t float_type()
+{
+  if constexpr (std::is_same_v<T, float>) {
+    return CUDA_R_32F;
+  } else {
+    return CUDA_R_64F;
+  }
+}
+}  // namespace spgemm_detail
+
+template <
+  typename T,
+  typename std::enable_if_t<std::is_same_v<T, float> || std::is_same_v<T, double>>* = nullptr>
+cusparseStatus_t cusparsespgemm_workestimation(cusparseHandle_t handle,
+                                               const T* alpha,
+                                               cusparseSpMatDescr_t matA,
+                                               cusparseSpMatDescr_t matB,
+                                               const T* beta,
+                                               cusparseSpMatDescr_t matC,
+                                               cusparseSpGEMMDescr_t spgemmDescr,
+                                               size_t* bufferSize1,
+                                               void* externalBuffer1,
+                                               cudaStream_t stream)
+{
+  CUSPARSE_CHECK(cusparseSetStream(handle, stream));
+  return cusparseSpGEMM_workEstimation(handle,
+                                       CUSPARSE_OPERATION_NON_TRANSPOSE,
+                                       CUSPARSE_OPERATION_NON_TRANSPOSE,
+                                       static_cast<void const*>(alpha),
+                                       matA,
+                                       matB,
+                                       static_cast<void const*>(beta),
+                                       matC,
+                                       spgemm_detail::float_type<T>(),
+                                       CUSPARSE_SPGEMM_DEFAULT,
+                                       spgemmDescr,
+                                       bufferSize1,
+                                       externalBuffer1);
+}
+
+template <
+  typename T,
+  typename std::enable_if_t<std::is_same_v<T, float> || std::is_same_v<T, double>>* = nullptr>
+cusparseStatus_t cusparsespgemm_compute(cusparseHandle_t handle,
+                                        const T* alpha,
+                                        cusparseSpMatDescr_t matA,
+                                        cusparseSpMatDescr_t matB,
+                                        const T* beta,
+                                        cusparseSpMatDescr_t matC,
+                                        cusparseSpGEMMDescr_t spgemmDescr,
+                                        size_t* bufferSize2,
+                                        void* externalBuffer2,
+                                        cudaStream_t stream)
+{
+  CUSPARSE_CHECK(cusparseSetStream(handle, stream));
+  return cusparseSpGEMM_compute(handle,
+                                CUSPARSE_OPERATION_NON_TRANSPOSE,
+                                CUSPARSE_OPERATION_NON_TRANSPOSE,
+                                static_cast<void const*>(alpha),
+                                matA,
+                                matB,
+                                static_cast<void const*>(beta),
+                                matC,
+                                spgemm_detail::float_type<T>(),
+                                CUSPARSE_SPGEMM_DEFAULT,
+                                spgemmDescr,
+                                bufferSize2,
+                                externalBuffer2);
+}
+
+template <
+  typename T,
+  typename std::enable_if_t<std::is_same_v<T, float> || std::is_same_v<T, double>>* = nullptr>
+cusparseStatus_t cusparsespgemm_copy(cusparseHandle_t handle,
+                                     const T* alpha,
+                                     cusparseSpMatDescr_t matA,
+                                     cusparseSpMatDescr_t matB,
+                                     const T* beta,
+                                     cusparseSpMatDescr_t matC,
+                                     cusparseSpGEMMDescr_t spgemmDescr,
+                                     cudaStream_t stream)
+{
+  CUSPARSE_CHECK(cusparseSetStream(handle, stream));
+  return cusparseSpGEMM_copy(handle,
+                             CUSPARSE_OPERATION_NON_TRANSPOSE,
+                             CUSPARSE_OPERATION_NON_TRANSPOSE,
+                             static_cast<void const*>(alpha),
+                             matA,
+                             matB,
+                             static_cast<void const*>(beta),
+                             matC,
+                             spgemm_detail::float_type<T>(),
+                             CUSPARSE_SPGEMM_DEFAULT,
+                             spgemmDescr);
+}
+/** @} */
+#endif
+
 /**
  * @defgroup Gemmi cusparse gemmi operations
  * @{
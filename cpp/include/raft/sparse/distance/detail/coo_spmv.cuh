@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include "coo_spmv_strategies/adaptive_strategy.cuh"
 #include "coo_spmv_strategies/dense_smem_strategy.cuh"
 #include "coo_spmv_strategies/hash_strategy.cuh"
 #include <raft/core/resource/cuda_stream.hpp>
@@ -79,7 +80,9 @@ inline void balanced_coo_pairwise_generalized_spmv(
  * 3. Multiplication by 0 annihilates x. e.g. product(x, 0) = 0
  *
  * Each vector of A is loaded into shared memory in dense form and the
- * non-zeros of B load balanced across the threads of each block.
+ * non-zeros of B load balanced across the threads of each block. When the
+ * dense vectors do not fit the shared memory, the strategy is selected per
+ * row of A from its number of non-zeros (see adaptive_strategy).
  * @tparam value_idx index type
  * @tparam value_t value type
  * @tparam threads_per_block block size
@@ -123,7 +126,7 @@ inline void balanced_coo_pairwise_generalized_spmv(
     dense_smem_strategy<value_idx, value_t, threads_per_block> strategy(config_);
     strategy.dispatch(out_dists, coo_rows_b, product_func, accum_func, write_func, chunk_size);
   } else {
-    hash_strategy<value_idx, value_t, threads_per_block> strategy(config_);
+    adaptive_strategy<value_idx, value_t, threads_per_block> strategy(config_);
     strategy.dispatch(out_dists, coo_rows_b, product_func, accum_func, write_func, chunk_size);
   }
 };
@@ -206,7 +209,7 @@ inline void balanced_coo_pairwise_generalized_spmv_rev(
     dense_smem_strategy<value_idx, value_t, threads_per_block> strategy(config_);
     strategy.dispatch_rev(out_dists, coo_rows_a, product_func, accum_func, write_func, chunk_size);
   } else {
-    hash_strategy<value_idx, value_t, threads_per_block> strategy(config_);
+    adaptive_strategy<value_idx, value_t, threads_per_block> strategy(config_);
     strategy.dispatch_rev(out_dists, coo_rows_a, product_func, accum_func, write_func, chunk_size);
   }
 };
@@ -0,0 +1,255 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "base_strategy.cuh"
+#include "dense_global_strategy.cuh"
+#include "hash_strategy.cuh"
+#include "small_row_strategy.cuh"
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+
+#include <thrust/copy.h>
+#include <thrust/iterator/counting_iterator.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace raft {
+namespace sparse {
+namespace distance {
+namespace detail {
+
+/**
+ * Strategy for the matrices whose dense rows do not fit the shared memory, selected per row
+ * from the number of non-zeros of the rows:
+ *
+ * 1. rows with at most `small_row_strategy::max_degree` non-zeros use a small shared memory
+ *    array scanned linearly, which lets many blocks reside on each SM;
+ * 2. rows which fit the shared memory hash table use `hash_strategy`;
+ * 3. the remaining (heavy) rows are expanded to dense vectors in global memory
+ *    (`dense_global_strategy`), where the hash strategy would split them into several tables
+ *    and scan B once per table. These rows are processed in groups bounded by
+ *    `max_buffer_bytes`.
+ *
+ * The rows are binned with one pass over the indptr array and every bin is processed by its own
+ * launch, in the same stream.
+ */
+template <typename value_idx, typename value_t, int tpb, int small_capacity = 32>
+class adaptive_strategy : public coo_spmv_strategy<value_idx, value_t, tpb> {
+ public:
+  using small_strategy_t = small_row_strategy<value_idx, value_t, tpb, small_capacity>;
+  using hash_strategy_t  = hash_strategy<value_idx, value_t, tpb>;
+  using dense_strategy_t = dense_global_strategy<value_idx, value_t, tpb>;
+
+  adaptive_strategy(const distances_config_t<value_idx, value_t>& config_,
+                    float capacity_threshold_ = 0.5,
+                    int map_size_             = hash_strategy_t::get_map_size(),
+                    size_t max_buffer_bytes_  = size_t(1) << 28)
+    : coo_spmv_strategy<value_idx, value_t, tpb>(config_),
+      capacity_threshold(capacity_threshold_),
+      map_size(map_size_),
+      max_buffer_bytes(max_buffer_bytes_)
+  {
+  }
+
+  template <typename product_f, typename accum_f, typename write_f>
+  void dispatch(value_t* out_dists,
+                value_idx* coo_rows_b,
+                product_f product_func,
+                accum_f accum_func,
+                write_f write_func,
+                int chunk_size)
+  {
+    auto n_blocks_per_row = raft::ceildiv(this->config.b_nnz, chunk_size * tpb);
+    run<false>(this->config.a_indptr,
+               this->config.a_nrows,
+               this->config.b_ncols,
+               n_blocks_per_row,
+               out_dists,
+               coo_rows_b,
+               product_func,
+               accum_func,
+               write_func,
+               chunk_size);
+  }
+
+  template <typename product_f, typename accum_f, typename write_f>
+  void dispatch_rev(value_t* out_dists,
+                    value_idx* coo_rows_a,
+                    product_f product_func,
+                    accum_f accum_func,
+                    write_f write_func,
+                    int chunk_size)
+  {
+    auto n_blocks_per_row = raft::ceildiv(this->config.a_nnz, chunk_size * tpb);
+    run<true>(this->config.b_indptr,
+              this->config.b_nrows,
+              this->config.a_ncols,
+              n_blocks_per_row,
+              out_dists,
+              coo_rows_a,
+              product_func,
+              accum_func,
+              write_func,
+              chunk_size);
+  }
+
+ private:
+  template <bool rev, typename strategy_t, typename product_f, typename accum_f, typename write_f>
+  void launch(strategy_t& strategy,
+              int smem_dim,
+              mask_row_it<value_idx>& rows,
+              value_t* out_dists,
+              value_idx* coo_rows,
+              product_f product_func,
+              accum_f accum_func,
+              write_f write_func,
+              int chunk_size,
+              int n_blocks,
+              int n_blocks_per_row)
+  {
+    if constexpr (rev) {
+      strategy._dispatch_base_rev(strategy,
+                                  smem_dim,
+                                  rows,
+                                  out_dists,
+                                  coo_rows,
+                                  product_func,
+                                  accum_func,
+                                  write_func,
+                                  chunk_size,
+                                  n_blocks,
+                                  n_blocks_per_row);
+    } else {
+      strategy._dispatch_base(strategy,
+                              smem_dim,
+                              rows,
+                              out_dists,
+                              coo_rows,
+                              product_func,
+                              accum_func,
+                              write_func,
+                              chunk_size,
+                              n_blocks,
+                              n_blocks_per_row);
+    }
+  }
+
+  template <bool rev, typename product_f, typename accum_f, typename write_f>
+  void run(const value_idx* indptr,
+           value_idx n_rows,
+           value_idx n_cols,
+           int n_blocks_per_row,
+           value_t* out_dists,
+           value_idx* coo_rows,
+           product_f product_func,
+           accum_f accum_func,
+           write_f write_func,
+           int chunk_size)
+  {
+    auto stream = resource::get_cuda_stream(this->config.handle);
+    auto policy = resource::get_thrust_policy(this->config.handle);
+
+    value_idx small_max  = small_strategy_t::max_degree;
+    value_idx medium_max = std::max<value_idx>(small_max + 1, capacity_threshold * map_size);
+
+    // bin the rows by their number of non-zeros
+    using fits_t = typename hash_strategy_t::fits_in_hash_table;
+    rmm::device_uvector<value_idx> mask_indptr(n_rows, stream);
+    value_idx no_max = std::numeric_limits<value_idx>::max();
+    auto first       = thrust::make_counting_iterator(value_idx(0));
+    auto last        = thrust::make_counting_iterator(n_rows);
+    auto small_end   = thrust::copy_if(
+      policy, first, last, mask_indptr.data(), fits_t(indptr, 0, small_max + 1));
+    auto medium_end  = thrust::copy_if(
+      policy, first, last, small_end, fits_t(indptr, small_max + 1, medium_max));
+    auto heavy_end   =
+      thrust::copy_if(policy, first, last, medium_end, fits_t(indptr, medium_max, no_max));
+    value_idx small_rows  = small_end - mask_indptr.data();
+    value_idx medium_rows = medium_end - small_end;
+    value_idx heavy_rows  = heavy_end - medium_end;
+
+    if (small_rows > 0) {
+      small_strategy_t strategy(this->config);
+      mask_row_it<value_idx> rows(indptr, small_rows, mask_indptr.data());
+      launch<rev>(strategy,
+                  small_strategy_t::max_degree,
+                  rows,
+                  out_dists,
+                  coo_rows,
+                  product_func,
+                  accum_func,
+                  write_func,
+                  chunk_size,
+                  small_rows * n_blocks_per_row,
+                  n_blocks_per_row);
+    }
+
+    if (medium_rows > 0) {
+      hash_strategy_t strategy(this->config, capacity_threshold, map_size);
+      mask_row_it<value_idx> rows(indptr, medium_rows, mask_indptr.data() + small_rows);
+      launch<rev>(strategy,
+                  map_size,
+                  rows,
+                  out_dists,
+                  coo_rows,
+                  product_func,
+                  accum_func,
+                  write_func,
+                  chunk_size,
+                  medium_rows * n_blocks_per_row,
+                  n_blocks_per_row);
+    }
+
+    if (heavy_rows > 0) {
+      // one dense row per block: bound the number of rows per launch by the buffer size
+      size_t row_bytes  = static_cast<size_t>(n_cols) * n_blocks_per_row * sizeof(value_t);
+      value_idx group   = std::clamp<size_t>(max_buffer_bytes / row_bytes, 1, heavy_rows);
+      rmm::device_uvector<value_t> buffer(static_cast<size_t>(group) * n_blocks_per_row * n_cols,
+                                          stream,
+                                          resource::get_workspace_resource(this->config.handle));
+      dense_strategy_t strategy(this->config, buffer.data(), n_cols);
+      for (value_idx offset = 0; offset < heavy_rows; offset += group) {
+        value_idx group_rows = std::min<value_idx>(group, heavy_rows - offset);
+        mask_row_it<value_idx> rows(
+          indptr, group_rows, mask_indptr.data() + small_rows + medium_rows + offset);
+        launch<rev>(strategy,
+                    0,
+                    rows,
+                    out_dists,
+                    coo_rows,
+                    product_func,
+                    accum_func,
+                    write_func,
+                    chunk_size,
+                    group_rows * n_blocks_per_row,
+                    n_blocks_per_row);
+      }
+    }
+  }
+
+  float capacity_threshold;
+  int map_size;
+  size_t max_buffer_bytes;
+};
+
+}  // namespace detail
+}  // namespace distance
+}  // namespace sparse
+}  // namespace raft
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "base_strategy.cuh"
+
+namespace raft {
+namespace sparse {
+namespace distance {
+namespace detail {
+
+/**
+ * Strategy for the rows with many non-zeros, when the dense rows do not fit the shared memory.
+ *
+ * Instead of splitting such a row over several hash tables (and scanning B once per part),
+ * every block expands its row into a dense vector of global memory, which stays in the L2 cache
+ * while the chunk of B is looked up. `buffer` must hold `n_cols` values for every block of a
+ * launch.
+ */
+template <typename value_idx, typename value_t, int tpb>
+class dense_global_strategy : public coo_spmv_strategy<value_idx, value_t, tpb> {
+ public:
+  using smem_type   = value_t*;
+  using insert_type = smem_type;
+  using find_type   = smem_type;
+
+  dense_global_strategy(const distances_config_t<value_idx, value_t>& config_,
+                        value_t* buffer_,
+                        value_idx n_cols_)
+    : coo_spmv_strategy<value_idx, value_t, tpb>(config_), buffer(buffer_), n_cols(n_cols_)
+  {
+    // only the warp reductions use the shared memory
+    this->smem = (tpb / raft::warp_size()) * sizeof(value_t);
+  }
+
+  __device__ inline insert_type init_insert(smem_type cache, const value_idx& cache_size)
+  {
+    value_t* row = buffer + static_cast<size_t>(blockIdx.x) * n_cols;
+    for (value_idx k = threadIdx.x; k < n_cols; k += blockDim.x) {
+      row[k] = 0.0;
+    }
+    return row;
+  }
+
+  __device__ inline void insert(insert_type cache, const value_idx& key, const value_t& value)
+  {
+    cache[key] = value;
+  }
+
+  __device__ inline find_type init_find(smem_type cache, const value_idx& cache_size)
+  {
+    return buffer + static_cast<size_t>(blockIdx.x) * n_cols;
+  }
+
+  __device__ inline value_t find(find_type cache, const value_idx& key) { return cache[key]; }
+
+ private:
+  value_t* buffer;
+  value_idx n_cols;
+};
+
+}  // namespace detail
+}  // namespace distance
+}  // namespace sparse
+}  // namespace raft
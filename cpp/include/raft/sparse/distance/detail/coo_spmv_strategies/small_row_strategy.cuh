@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "base_strategy.cuh"
+
+#include <type_traits>
+
+namespace raft {
+namespace sparse {
+namespace distance {
+namespace detail {
+
+/**
+ * Strategy for the rows with very few non-zeros (at most `capacity`).
+ *
+ * The non-zeros of the row are stored unordered in a small array of shared memory, and looked up
+ * by a linear scan. All the lanes of a warp read the same entry at every step of the scan, so the
+ * reads are broadcast and do not conflict. Unlike the hash table, which is scaled to the full
+ * shared memory and initialized by every block, the cache takes a few hundred bytes, so that
+ * many blocks can reside on every SM.
+ */
+template <typename value_idx, typename value_t, int tpb, int capacity = 32>
+class small_row_strategy : public coo_spmv_strategy<value_idx, value_t, tpb> {
+ public:
+  struct entry {
+    value_idx key;
+    value_t value;
+  };
+
+  using smem_type   = entry*;
+  using insert_type = smem_type;
+  using find_type   = smem_type;
+
+  static constexpr int max_degree = capacity;
+
+  small_row_strategy(const distances_config_t<value_idx, value_t>& config_)
+    : coo_spmv_strategy<value_idx, value_t, tpb>(config_)
+  {
+    this->smem = smem_per_block();
+  }
+
+  inline static int smem_per_block()
+  {
+    return capacity * sizeof(entry) + (tpb / raft::warp_size()) * sizeof(value_t);
+  }
+
+  __device__ inline insert_type init_insert(smem_type cache, const value_idx& cache_size)
+  {
+    for (int k = threadIdx.x; k < capacity; k += blockDim.x) {
+      cache[k].key = -1;
+    }
+    return cache;
+  }
+
+  __device__ inline void insert(insert_type cache, const value_idx& key, const value_t& value)
+  {
+    for (int k = 0; k < capacity; k++) {
+      if (claim(&cache[k].key, key)) {
+        cache[k].value = value;
+        return;
+      }
+    }
+  }
+
+  __device__ inline find_type init_find(smem_type cache, const value_idx& cache_size)
+  {
+    return cache;
+  }
+
+  __device__ inline value_t find(find_type cache, const value_idx& key)
+  {
+    for (int k = 0; k < capacity; k++) {
+      value_idx cur = cache[k].key;
+      if (cur == key) { return cache[k].value; }
+      if (cur == -1) { break; }
+    }
+    return 0.0;
+  }
+
+ private:
+  /** Atomically set an empty slot to `key`; returns whether the slot was empty. */
+  __device__ inline static bool claim(value_idx* slot, const value_idx& key)
+  {
+    if constexpr (sizeof(value_idx) == sizeof(int)) {
+      return atomicCAS(reinterpret_cast<int*>(slot), -1, int(key)) == -1;
+    } else {
+      using cas_t = unsigned long long int;
+      return atomicCAS(reinterpret_cast<cas_t*>(slot), cas_t(-1), cas_t(key)) == cas_t(-1);
+    }
+  }
+};
+
+}  // namespace detail
+}  // namespace distance
+}  // namespace sparse
+}  // namespace raft
@@ -0,0 +1,306 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/cusparse_handle.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/matrix/col_wise_sort.cuh>
+#include <raft/matrix/select_k.cuh>
+#include <raft/sparse/convert/coo.cuh>
+#include <raft/sparse/detail/cusparse_wrappers.h>
+#include <raft/sparse/distance/common.h>
+#include <raft/sparse/distance/detail/l2_distance.cuh>
+#include <raft/sparse/linalg/transpose.cuh>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <thrust/functional.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/transform_reduce.h>
+
+namespace raft::sparse::distance::detail {
+
+/** Turns the dot products stored in C into distances, using the squared norms of the rows. */
+template <typename value_idx, typename value_t, typename expansion_f>
+__global__ void compute_sparse_expansion_kernel(value_t* __restrict__ C_data,
+                                                const value_idx* __restrict__ C_rows,
+                                                const value_idx* __restrict__ C_cols,
+                                                const value_t* __restrict__ Q_sq_norms,
+                                                const value_t* __restrict__ R_sq_norms,
+                                                value_idx nnz,
+                                                expansion_f expansion_func)
+{
+  value_idx i = blockDim.x * blockIdx.x + threadIdx.x;
+  if (i >= nnz) return;
+  value_t val = expansion_func(C_data[i], Q_sq_norms[C_rows[i]], R_sq_norms[C_cols[i]]);
+
+  // correct for small instabilities
+  C_data[i] = val * (fabs(val) >= 0.0001);
+}
+
+inline bool spgemm_distance_supported(raft::distance::DistanceType metric)
+{
+  return metric == raft::distance::DistanceType::InnerProduct ||
+         metric == raft::distance::DistanceType::L2Expanded ||
+         metric == raft::distance::DistanceType::CosineExpanded;
+}
+
+/**
+ * C = A * B^T with cuSPARSE SpGEMM. The product is written straight to the arrays of `out`, once
+ * its number of non-zeros is known, so the memory only scales with the sparsity of the output.
+ */
+template <typename value_idx, typename value_t>
+void spgemm_a_bt(const distances_config_t<value_idx, value_t>& config,
+                 raft::device_csr_matrix<value_t, value_idx, value_idx, value_idx>& out)
+{
+  auto& handle   = config.handle;
+  auto stream    = resource::get_cuda_stream(handle);
+  auto cusparse  = resource::get_cusparse_handle(handle);
+  value_t alpha  = 1;
+  value_t beta   = 0;
+  auto structure = out.structure_view();
+
+  if (config.a_nnz == 0 || config.b_nnz == 0) {
+    out.initialize_sparsity(0);
+    RAFT_CUDA_TRY(cudaMemsetAsync(structure.get_indptr().data(),
+                                  0,
+                                  (config.a_nrows + 1) * sizeof(value_idx),
+                                  stream));
+    return;
+  }
+
+  // cuSPARSE SpGEMM only multiplies non-transposed operands
+  rmm::device_uvector<value_idx> bt_indptr(config.b_ncols + 1, stream);
+  rmm::device_uvector<value_idx> bt_indices(config.b_nnz, stream);
+  rmm::device_uvector<value_t> bt_data(config.b_nnz, stream);
+  raft::sparse::linalg::csr_transpose(handle,
+                                      config.b_indptr,
+                                      config.b_indices,
+                                      config.b_data,
+                                      bt_indptr.data(),
+                                      bt_indices.data(),
+                                      bt_data.data(),
+                                      config.b_nrows,
+                                      config.b_ncols,
+                                      config.b_nnz,
+                                      stream);
+
+  cusparseSpMatDescr_t matA, matBt, matC;
+  RAFT_CUSPARSE_TRY(raft::sparse::detail::cusparsecreatecsr(&matA,
+                                                            config.a_nrows,
+                                                            config.a_ncols,
+                                                            config.a_nnz,
+                                                            config.a_indptr,
+                                                            config.a_indices,
+                                                            config.a_data));
+  RAFT_CUSPARSE_TRY(raft::sparse::detail::cusparsecreatecsr(&matBt,
+                                                            config.b_ncols,
+                                                            config.b_nrows,
+                                                            config.b_nnz,
+                                                            bt_indptr.data(),
+                                                            bt_indices.data(),
+                                                            bt_data.data()));
+  RAFT_CUSPARSE_TRY(raft::sparse::detail::cusparsecreatecsr(&matC,
+                                                            config.a_nrows,
+                                                            config.b_nrows,
+                                                            0,
+                                                            structure.get_indptr().data(),
+                                                            static_cast<value_idx*>(nullptr),
+                                                            static_cast<value_t*>(nullptr)));
+  cusparseSpGEMMDescr_t spgemm_descr;
+  RAFT_CUSPARSE_TRY(cusparseSpGEMM_createDescr(&spgemm_descr));
+
+  size_t buffer_size1 = 0;
+  size_t buffer_size2 = 0;
+  RAFT_CUSPARSE_TRY(raft::sparse::detail::cusparsespgemm_workestimation(
+    cusparse, &alpha, matA, matBt, &beta, matC, spgemm_descr, &buffer_size1, nullptr, stream));
+  rmm::device_uvector<char> buffer1(
+    buffer_size1, stream, resource::get_workspace_resource(handle));
+  RAFT_CUSPARSE_TRY(raft::sparse::detail::cusparsespgemm_workestimation(cusparse,
+                                                                        &alpha,
+                                                                        matA,
+                                                                        matBt,
+                                                                        &beta,
+                                                                        matC,
+                                                                        spgemm_descr,
+                                                                        &buffer_size1,
+                                                                        buffer1.data(),
+                                                                        stream));
+  RAFT_CUSPARSE_TRY(raft::sparse::detail::cusparsespgemm_compute(
+    cusparse, &alpha, matA, matBt, &beta, matC, spgemm_descr, &buffer_size2, nullptr, stream));
+  rmm::device_uvector<char> buffer2(
+    buffer_size2, stream, resource::get_workspace_resource(handle));
+  RAFT_CUSPARSE_TRY(raft::sparse::detail::cusparsespgemm_compute(cusparse,
+                                                                 &alpha,
+                                                                 matA,
+                                                                 matBt,
+                                                                 &beta,
+                                                                 matC,
+                                                                 spgemm_descr,
+                                                                 &buffer_size2,
+                                                                 buffer2.data(),
+                                                                 stream));
+
+  int64_t c_rows, c_cols, c_nnz;
+  RAFT_CUSPARSE_TRY(cusparseSpMatGetSize(matC, &c_rows, &c_cols, &c_nnz));
+  out.initialize_sparsity(c_nnz);
+  structure = out.structure_view();
+  RAFT_CUSPARSE_TRY(cusparseCsrSetPointers(matC,
+                                           structure.get_indptr().data(),
+                                           structure.get_indices().data(),
+                                           out.get_elements().data()));
+  RAFT_CUSPARSE_TRY(raft::sparse::detail::cusparsespgemm_copy(
+    cusparse, &alpha, matA, matBt, &beta, matC, spgemm_descr, stream));
+
+  RAFT_CUSPARSE_TRY_NO_THROW(cusparseSpGEMM_destroyDescr(spgemm_descr));
+  RAFT_CUSPARSE_TRY_NO_THROW(cusparseDestroySpMat(matA));
+  RAFT_CUSPARSE_TRY_NO_THROW(cusparseDestroySpMat(matBt));
+  RAFT_CUSPARSE_TRY_NO_THROW(cusparseDestroySpMat(matC));
+}
+
+/**
+ * Sparse output of the distances between the rows of A and B: only the pairs of rows which share
+ * at least one column are stored. The dot products of the product A * B^T are turned into
+ * distances in place by an epilogue over the non-zeros of the output.
+ */
+template <typename value_idx, typename value_t, int tpb = 256>
+void spgemm_distances(const distances_config_t<value_idx, value_t>& config,
+                      raft::distance::DistanceType metric,
+                      raft::device_csr_matrix<value_t, value_idx, value_idx, value_idx>& out)
+{
+  RAFT_EXPECTS(spgemm_distance_supported(metric),
+               "Sparse output is only supported for the InnerProduct, L2Expanded and "
+               "CosineExpanded distances");
+  RAFT_EXPECTS(config.a_ncols == config.b_ncols, "A and B must have the same number of columns");
+  RAFT_EXPECTS(out.structure_view().get_n_rows() == config.a_nrows &&
+                 out.structure_view().get_n_cols() == config.b_nrows,
+               "The output must be of size A.nrows x B.nrows");
+  auto stream = resource::get_cuda_stream(config.handle);
+
+  spgemm_a_bt(config, out);
+  if (metric == raft::distance::DistanceType::InnerProduct) { return; }
+
+  auto structure = out.structure_view();
+  value_idx nnz  = structure.get_nnz();
+  if (nnz == 0) { return; }
+
+  rmm::device_uvector<value_idx> a_coo_rows(config.a_nnz, stream);
+  rmm::device_uvector<value_idx> b_coo_rows(config.b_nnz, stream);
+  rmm::device_uvector<value_idx> c_coo_rows(nnz, stream);
+  raft::sparse::convert::csr_to_coo(
+    config.a_indptr, config.a_nrows, a_coo_rows.data(), config.a_nnz, stream);
+  raft::sparse::convert::csr_to_coo(
+    config.b_indptr, config.b_nrows, b_coo_rows.data(), config.b_nnz, stream);
+  raft::sparse::convert::csr_to_coo(
+    structure.get_indptr().data(), config.a_nrows, c_coo_rows.data(), nnz, stream);
+
+  rmm::device_uvector<value_t> Q_sq_norms(config.a_nrows, stream);
+  rmm::device_uvector<value_t> R_sq_norms(config.b_nrows, stream);
+  RAFT_CUDA_TRY(cudaMemsetAsync(Q_sq_norms.data(), 0, Q_sq_norms.size() * sizeof(value_t), stream));
+  RAFT_CUDA_TRY(cudaMemsetAsync(R_sq_norms.data(), 0, R_sq_norms.size() * sizeof(value_t), stream));
+  compute_row_norm_kernel<<<raft::ceildiv(config.a_nnz, tpb), tpb, 0, stream>>>(
+    Q_sq_norms.data(), a_coo_rows.data(), config.a_data, config.a_nnz);
+  compute_row_norm_kernel<<<raft::ceildiv(config.b_nnz, tpb), tpb, 0, stream>>>(
+    R_sq_norms.data(), b_coo_rows.data(), config.b_data, config.b_nnz);
+
+  auto launch = [&](auto expansion_func) {
+    compute_sparse_expansion_kernel<<<raft::ceildiv(nnz, tpb), tpb, 0, stream>>>(
+      out.get_elements().data(),
+      c_coo_rows.data(),
+      structure.get_indices().data(),
+      Q_sq_norms.data(),
+      R_sq_norms.data(),
+      nnz,
+      expansion_func);
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+  };
+  if (metric == raft::distance::DistanceType::L2Expanded) {
+    launch([] __device__(value_t dot, value_t q_norm, value_t r_norm) {
+      return -2 * dot + q_norm + r_norm;
+    });
+  } else {
+    // a stored pair shares at least one column, so neither of its rows is empty
+    launch([] __device__(value_t dot, value_t q_norm, value_t r_norm) {
+      value_t norms = raft::sqrt(q_norm) * raft::sqrt(r_norm);
+      return 1 - ((norms != 0) * dot) / ((norms == 0) + norms);
+    });
+  }
+}
+
+template <typename value_idx>
+struct csr_row_length_op {
+  const value_idx* indptr;
+
+  __device__ value_idx operator()(value_idx i) const { return indptr[i + 1] - indptr[i]; }
+};
+
+/**
+ * The k nearest rows of B of every row of A, among the rows sharing at least one column with it.
+ * The sparse distances are computed by `spgemm_distances` and the best k entries of every row of
+ * the output are selected by a segmented select_k, so no dense A.nrows x B.nrows buffer is needed.
+ */
+template <typename value_idx, typename value_t>
+void spgemm_distances_topk(const distances_config_t<value_idx, value_t>& config,
+                           raft::distance::DistanceType metric,
+                           value_idx* out_indices,
+                           value_t* out_dists,
+                           int k)
+{
+  RAFT_EXPECTS(k > 0 && k <= config.b_nrows, "k must be in [1, B.nrows]");
+  auto& handle = config.handle;
+  auto C       = raft::make_device_csr_matrix<value_t, value_idx, value_idx, value_idx>(
+    handle, config.a_nrows, config.b_nrows);
+  spgemm_distances(config, metric, C);
+
+  auto structure    = C.structure_view();
+  value_idx nnz     = structure.get_nnz();
+  value_idx max_len = thrust::transform_reduce(
+    resource::get_thrust_policy(handle),
+    thrust::make_counting_iterator<value_idx>(0),
+    thrust::make_counting_iterator(config.a_nrows),
+    csr_row_length_op<value_idx>{structure.get_indptr().data()},
+    value_idx(0),
+    thrust::maximum<value_idx>());
+
+  // the similarities are the largest inner products, the distances the smallest values
+  bool select_min = metric != raft::distance::DistanceType::InnerProduct;
+
+  auto out_d = raft::make_device_matrix_view<value_t, int64_t>(out_dists, config.a_nrows, k);
+  auto out_i = raft::make_device_matrix_view<value_idx, int64_t>(out_indices, config.a_nrows, k);
+  raft::matrix::select_k_segmented<value_t, value_idx>(
+    handle,
+    raft::make_device_vector_view<const value_t, int64_t>(C.get_elements().data(), nnz),
+    raft::make_device_vector_view<const value_idx, int64_t>(structure.get_indices().data(), nnz),
+    raft::make_device_vector_view<const value_idx, int64_t>(structure.get_indptr().data(),
+                                                            config.a_nrows + 1),
+    max_len,
+    out_d,
+    out_i,
+    select_min);
+  // select_k does not order its output
+  raft::matrix::sort_cols_per_row_inplace(handle, out_d, out_i, select_min);
+}
+
+}  // namespace raft::sparse::distance::detail
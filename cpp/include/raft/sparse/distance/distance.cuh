@@ -22,12 +22,14 @@
 #include <raft/sparse/distance/common.h>
 #include <unordered_set>
 
+#include <raft/core/device_csr_matrix.hpp>
 #include <raft/distance/distance_types.hpp>
 
 #include <raft/sparse/distance/detail/bin_distance.cuh>
 #include <raft/sparse/distance/detail/ip_distance.cuh>
 #include <raft/sparse/distance/detail/l2_distance.cuh>
 #include <raft/sparse/distance/detail/lp_distance.cuh>
+#include <raft/sparse/distance/detail/spgemm_distance.cuh>
 
 namespace raft {
 namespace sparse {
@@ -130,6 +132,64 @@ void pairwiseDistance(value_t* out,
   }
 }
 
+/**
+ * Compute the pairwise distances between A and B into a sparse output, using a sparse-sparse
+ * matrix product (cuSPARSE SpGEMM) of A and the transpose of B followed by an epilogue over its
+ * non-zeros, so the memory scales with the sparsity of the output instead of A.nrows * B.nrows.
+ *
+ * Only the pairs of rows which share at least one column are stored; the distances of the
+ * other pairs follow from a dot product of 0: 0 for InnerProduct, |a|^2 + |b|^2 for L2Expanded
+ * and 1 for CosineExpanded.
+ *
+ * @code{.cpp}
+ *  auto out = raft::make_device_csr_matrix<float, int, int, int>(handle, a_nrows, b_nrows);
+ *  raft::sparse::distance::pairwiseDistanceSparseOutput(
+ *    out, config, raft::distance::DistanceType::CosineExpanded);
+ * @endcode
+ *
+ * @tparam value_idx index type
+ * @tparam value_t value type
+ * @param[out] out sparse output of size A.nrows x B.nrows, its sparsity is initialized here
+ * @param[in] input_config input argument configuration
+ * @param[in] metric InnerProduct, L2Expanded or CosineExpanded
+ */
+template <typename value_idx = int, typename value_t = float>
+void pairwiseDistanceSparseOutput(
+  raft::device_csr_matrix<value_t, value_idx, value_idx, value_idx>& out,
+  distances_config_t<value_idx, value_t> input_config,
+  raft::distance::DistanceType metric)
+{
+  detail::spgemm_distances(input_config, metric, out);
+}
+
+/**
+ * Select, for every row of A, the k closest rows of B (the k largest inner products for
+ * InnerProduct) among the rows sharing at least one column with it. The distances are computed
+ * as in `pairwiseDistanceSparseOutput` and reduced by a segmented select_k over the rows of the
+ * sparse output, without materializing the dense A.nrows x B.nrows matrix.
+ *
+ * The neighbors of every row are sorted from the best to the worst one. The rows with fewer than
+ * k candidates are padded with `upper_bound<value_t>()` (`lower_bound<value_t>()` for
+ * InnerProduct); the indices of the padded entries are undefined.
+ *
+ * @tparam value_idx index type
+ * @tparam value_t value type
+ * @param[out] out_indices indices of the selected rows of B (size A.nrows * k)
+ * @param[out] out_dists distances of the selected rows of B (size A.nrows * k)
+ * @param[in] input_config input argument configuration
+ * @param[in] metric InnerProduct, L2Expanded or CosineExpanded
+ * @param[in] k number of neighbors
+ */
+template <typename value_idx = int, typename value_t = float>
+void pairwiseDistanceTopK(value_idx* out_indices,
+                          value_t* out_dists,
+                          distances_config_t<value_idx, value_t> input_config,
+                          raft::distance::DistanceType metric,
+                          int k)
+{
+  detail::spgemm_distances_topk(input_config, metric, out_indices, out_dists, k);
+}
+
 };  // namespace distance
 };  // namespace sparse
 };  // namespace raft
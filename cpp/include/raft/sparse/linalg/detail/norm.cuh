@@ -24,10 +24,20 @@
 #include <raft/util/cuda_utils.cuh>
 #include <raft/util/cudart_utils.hpp>
 
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
 #include <raft/sparse/op/row_op.cuh>
+#include <raft/util/reduction.cuh>
 
+#include <rmm/device_uvector.hpp>
+
+#include <thrust/copy.h>
 #include <thrust/device_ptr.h>
+#include <thrust/iterator/counting_iterator.h>
 #include <thrust/scan.h>
+#include <thrust/transform.h>
 
 #include <cuda_runtime.h>
 #include <stdio.h>
@@ -231,6 +241,272 @@ void rowNormCsrCaller(const IdxType* ia,
   };
 }
 
+// rows longer than this are processed by a whole block instead of a single warp
+static constexpr int kCsrBlockRowThreshold = 32 * raft::WarpSize;
+static constexpr int kCsrRowTPB            = 256;
+
+template <typename IdxType>
+struct csr_long_row_op {
+  const IdxType* ia;
+  IdxType N;
+  IdxType nnz;
+
+  __device__ bool operator()(IdxType row) const
+  {
+    IdxType stop = row < N - 1 ? ia[row + 1] : nnz;
+    return stop - ia[row] > kCsrBlockRowThreshold;
+  }
+};
+
+/**
+ * The rows of a CSR matrix split by length, to balance the work of the rows of power-law lengths:
+ * every row is handled by a warp, except the long rows which are handled by a block each.
+ */
+template <typename IdxType>
+struct csr_row_partition {
+  csr_row_partition(raft::resources const& handle, const IdxType* ia, IdxType nnz, IdxType N)
+    : long_rows(N, resource::get_cuda_stream(handle), resource::get_workspace_resource(handle))
+  {
+    auto first = thrust::make_counting_iterator<IdxType>(0);
+    n_long     = static_cast<IdxType>(thrust::copy_if(resource::get_thrust_policy(handle),
+                                                  first,
+                                                  first + N,
+                                                  long_rows.data(),
+                                                  csr_long_row_op<IdxType>{ia, N, nnz}) -
+                                  long_rows.data());
+  }
+
+  rmm::device_uvector<IdxType> long_rows;
+  IdxType n_long;
+};
+
+/**
+ * The row of the calling group of threads (a warp, or the block for kBlockPerRow) and its range
+ * of non-zeros; false when the group has no row to process.
+ */
+template <int TPB, bool kBlockPerRow, typename IdxType>
+DI bool csr_balanced_row(const IdxType* ia,
+                         IdxType nnz,
+                         IdxType N,
+                         const IdxType* long_rows,
+                         IdxType& start_idx,
+                         IdxType& stop_idx,
+                         IdxType& row)
+{
+  if constexpr (kBlockPerRow) {
+    row = long_rows[blockIdx.x];
+  } else {
+    row = IdxType(blockIdx.x) * (TPB / raft::WarpSize) + threadIdx.x / raft::WarpSize;
+    if (row >= N) { return false; }
+  }
+  start_idx = ia[row];
+  stop_idx  = row < N - 1 ? ia[row + 1] : nnz;
+  return kBlockPerRow || stop_idx - start_idx <= kCsrBlockRowThreshold;
+}
+
+/** Reduction over the group of threads of a row; all the threads get the result. */
+template <bool kBlockPerRow, typename Type, typename ReduceLambda>
+DI Type csr_row_reduce(Type val, Type* smem, ReduceLambda reduce_op)
+{
+  val = raft::warpReduce(val, reduce_op);
+  if constexpr (kBlockPerRow) {
+    if (raft::laneId() == 0) { smem[threadIdx.x / raft::WarpSize] = val; }
+    __syncthreads();
+    val = smem[0];
+    for (int i = 1; i < int(blockDim.x / raft::WarpSize); i++) {
+      val = reduce_op(val, smem[i]);
+    }
+    __syncthreads();
+  }
+  return val;
+}
+
+template <int TPB, bool kBlockPerRow, typename Type, typename IdxType>
+__global__ void csr_row_stats_kernel(const IdxType* ia,
+                                     const Type* data,
+                                     IdxType nnz,
+                                     IdxType N,
+                                     const IdxType* long_rows,
+                                     IdxType* row_nnz,
+                                     Type* sum,
+                                     Type* l1,
+                                     Type* l2,
+                                     Type* linf)
+{
+  __shared__ Type smem[TPB / raft::WarpSize];
+  IdxType start_idx, stop_idx, row;
+  if (!csr_balanced_row<TPB, kBlockPerRow>(ia, nnz, N, long_rows, start_idx, stop_idx, row)) {
+    return;
+  }
+  const int lane   = kBlockPerRow ? threadIdx.x : raft::laneId();
+  const int stride = kBlockPerRow ? TPB : raft::WarpSize;
+
+  Type s = 0, a = 0, sq = 0, mx = 0;
+  for (IdxType i = start_idx + lane; i < stop_idx; i += stride) {
+    Type v = data[i];
+    s += v;
+    a += raft::abs(v);
+    sq += v * v;
+    mx = raft::max(mx, raft::abs(v));
+  }
+  s  = csr_row_reduce<kBlockPerRow>(s, smem, raft::add_op{});
+  a  = csr_row_reduce<kBlockPerRow>(a, smem, raft::add_op{});
+  sq = csr_row_reduce<kBlockPerRow>(sq, smem, raft::add_op{});
+  mx = csr_row_reduce<kBlockPerRow>(mx, smem, raft::max_op{});
+  if (lane == 0) {
+    if (row_nnz != nullptr) { row_nnz[row] = stop_idx - start_idx; }
+    if (sum != nullptr) { sum[row] = s; }
+    if (l1 != nullptr) { l1[row] = a; }
+    if (l2 != nullptr) { l2[row] = raft::sqrt(sq); }
+    if (linf != nullptr) { linf[row] = mx; }
+  }
+}
+
+template <typename Type, typename IdxType>
+void csr_row_stats(raft::resources const& handle,
+                   const IdxType* ia,
+                   const Type* data,
+                   IdxType nnz,
+                   IdxType N,
+                   IdxType* row_nnz,
+                   Type* sum,
+                   Type* l1,
+                   Type* l2,
+                   Type* linf)
+{
+  if (N == 0) { return; }
+  auto stream = resource::get_cuda_stream(handle);
+  csr_row_partition<IdxType> rows(handle, ia, nnz, N);
+
+  constexpr int kWarps = kCsrRowTPB / raft::WarpSize;
+  csr_row_stats_kernel<kCsrRowTPB, false>
+    <<<raft::ceildiv<IdxType>(N, kWarps), kCsrRowTPB, 0, stream>>>(
+      ia, data, nnz, N, rows.long_rows.data(), row_nnz, sum, l1, l2, linf);
+  if (rows.n_long > 0) {
+    csr_row_stats_kernel<kCsrRowTPB, true><<<rows.n_long, kCsrRowTPB, 0, stream>>>(
+      ia, data, nnz, N, rows.long_rows.data(), row_nnz, sum, l1, l2, linf);
+  }
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+/**
+ * Weigh the values of every row by the weights of their columns and divide them by the norm of
+ * the weighted row. The row is read twice by the same group of threads: the second time, from
+ * the cache.
+ */
+template <int TPB, bool kBlockPerRow, typename Type, typename IdxType>
+__global__ void csr_row_scale_kernel(const IdxType* ia,
+                                     const IdxType* indices,
+                                     const Type* data,
+                                     IdxType nnz,
+                                     IdxType N,
+                                     const IdxType* long_rows,
+                                     const Type* col_weights,
+                                     raft::linalg::NormType norm,
+                                     Type* result)
+{
+  __shared__ Type smem[TPB / raft::WarpSize];
+  IdxType start_idx, stop_idx, row;
+  if (!csr_balanced_row<TPB, kBlockPerRow>(ia, nnz, N, long_rows, start_idx, stop_idx, row)) {
+    return;
+  }
+  const int lane   = kBlockPerRow ? threadIdx.x : raft::laneId();
+  const int stride = kBlockPerRow ? TPB : raft::WarpSize;
+  auto weighted    = [=](IdxType i) {
+    return col_weights == nullptr ? data[i] : data[i] * col_weights[indices[i]];
+  };
+
+  Type acc = 0;
+  for (IdxType i = start_idx + lane; i < stop_idx; i += stride) {
+    Type v = weighted(i);
+    switch (norm) {
+      case raft::linalg::NormType::L1Norm: acc += raft::abs(v); break;
+      case raft::linalg::NormType::L2Norm: acc += v * v; break;
+      default: acc = raft::max(acc, raft::abs(v));
+    }
+  }
+  acc = norm == raft::linalg::NormType::LinfNorm
+          ? csr_row_reduce<kBlockPerRow>(acc, smem, raft::max_op{})
+          : csr_row_reduce<kBlockPerRow>(acc, smem, raft::add_op{});
+  if (norm == raft::linalg::NormType::L2Norm) { acc = raft::sqrt(acc); }
+
+  for (IdxType i = start_idx + lane; i < stop_idx; i += stride) {
+    result[i] = acc != Type(0) ? weighted(i) / acc : Type(0);
+  }
+}
+
+template <typename Type, typename IdxType>
+void csr_row_scale(raft::resources const& handle,
+                   const IdxType* ia,
+                   const IdxType* indices,
+                   const Type* data,
+                   IdxType nnz,
+                   IdxType N,
+                   const Type* col_weights,
+                   raft::linalg::NormType norm,
+                   Type* result)
+{
+  RAFT_EXPECTS(norm == raft::linalg::NormType::L1Norm || norm == raft::linalg::NormType::L2Norm ||
+                 norm == raft::linalg::NormType::LinfNorm,
+               "Unsupported norm type: %d",
+               norm);
+  if (N == 0) { return; }
+  auto stream = resource::get_cuda_stream(handle);
+  csr_row_partition<IdxType> rows(handle, ia, nnz, N);
+
+  constexpr int kWarps = kCsrRowTPB / raft::WarpSize;
+  csr_row_scale_kernel<kCsrRowTPB, false>
+    <<<raft::ceildiv<IdxType>(N, kWarps), kCsrRowTPB, 0, stream>>>(
+      ia, indices, data, nnz, N, rows.long_rows.data(), col_weights, norm, result);
+  if (rows.n_long > 0) {
+    csr_row_scale_kernel<kCsrRowTPB, true><<<rows.n_long, kCsrRowTPB, 0, stream>>>(
+      ia, indices, data, nnz, N, rows.long_rows.data(), col_weights, norm, result);
+  }
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+template <typename IdxType>
+__global__ void csr_document_frequency_kernel(const IdxType* indices, IdxType nnz, IdxType* df)
+{
+  for (IdxType i = blockIdx.x * blockDim.x + threadIdx.x; i < nnz; i += blockDim.x * gridDim.x) {
+    atomicAdd(df + indices[i], IdxType(1));
+  }
+}
+
+template <typename Type, typename IdxType>
+struct smooth_idf_op {
+  IdxType N;
+
+  __device__ Type operator()(IdxType df) const
+  {
+    return raft::log(Type(1 + N) / Type(1 + df)) + Type(1);
+  }
+};
+
+template <typename Type, typename IdxType>
+void csr_idf(raft::resources const& handle,
+             const IdxType* indices,
+             IdxType nnz,
+             IdxType N,
+             IdxType D,
+             Type* idf)
+{
+  if (D == 0) { return; }
+  auto stream = resource::get_cuda_stream(handle);
+  rmm::device_uvector<IdxType> df(D, stream, resource::get_workspace_resource(handle));
+  RAFT_CUDA_TRY(cudaMemsetAsync(df.data(), 0, D * sizeof(IdxType), stream));
+  if (nnz > 0) {
+    auto n_blocks = std::min<IdxType>(raft::ceildiv<IdxType>(nnz, kCsrRowTPB), 65535);
+    csr_document_frequency_kernel<<<n_blocks, kCsrRowTPB, 0, stream>>>(indices, nnz, df.data());
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+  }
+  thrust::transform(resource::get_thrust_policy(handle),
+                    df.begin(),
+                    df.end(),
+                    idf,
+                    smooth_idf_op<Type, IdxType>{N});
+}
+
 };  // end NAMESPACE detail
 };  // end NAMESPACE linalg
 };  // end NAMESPACE sparse
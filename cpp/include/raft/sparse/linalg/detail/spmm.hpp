@@ -30,7 +30,8 @@ namespace detail {
 
 /**
  * @brief determine common data layout for both dense matrices
- * @tparam ValueType Data type of Y,Z (float/double)
+ * @tparam ValueType Data type of Y
+ * @tparam OutType Data type of Z
  * @tparam IndexType Type of Y,Z
  * @tparam LayoutPolicyY layout of Y
  * @tparam LayoutPolicyZ layout of Z
@@ -38,9 +39,13 @@ namespace detail {
  * @param[in] y input raft::device_matrix_view
  * @returns dense matrix descriptor to be used by cuSparse API
  */
-template <typename ValueType, typename IndexType, typename LayoutPolicyY, typename LayoutPolicyZ>
+template <typename ValueType,
+          typename OutType,
+          typename IndexType,
+          typename LayoutPolicyY,
+          typename LayoutPolicyZ>
 bool is_row_major(raft::device_matrix_view<const ValueType, IndexType, LayoutPolicyY>& y,
-                  raft::device_matrix_view<ValueType, IndexType, LayoutPolicyZ>& z)
+                  raft::device_matrix_view<OutType, IndexType, LayoutPolicyZ>& z)
 {
   bool is_row_major = z.stride(1) == 1 && y.stride(1) == 1;
   bool is_col_major = z.stride(0) == 1 && y.stride(0) == 1;
@@ -50,7 +55,7 @@ bool is_row_major(raft::device_matrix_view<const ValueType, IndexType, LayoutPol
 
 /**
  * @brief create a cuSparse dense descriptor
- * @tparam ValueType Data type of dense_view (float/double)
+ * @tparam ValueType Data type of dense_view (float/double/half/int8_t/int32_t)
  * @tparam IndexType Type of dense_view
  * @tparam LayoutPolicy layout of dense_view
  * @param[in] dense_view input raft::device_matrix_view
@@ -76,7 +81,7 @@ cusparseDnMatDescr_t create_descriptor(
 
 /**
  * @brief create a cuSparse sparse descriptor
- * @tparam ValueType Data type of sparse_view (float/double)
+ * @tparam ValueType Data type of sparse_view (float/double/half/int8_t)
  * @tparam NZType Type of sparse_view
  * @param[in] sparse_view input raft::device_csr_matrix_view of size M rows x K columns
  * @returns sparse matrix descriptor to be used by cuSparse API
@@ -103,11 +108,7 @@ cusparseSpMatDescr_t create_descriptor(
  * combinations of operand layouts for cuSparse.
  * It computes the following equation: Z = alpha . X * Y + beta . Z
  * where X is a CSR device matrix view and Y,Z are device matrix views
- * @tparam ValueType Data type of input/output matrices (float/double)
- * @tparam IndexType Type of Y and Z
- * @tparam NZType Type of X
- * @tparam LayoutPolicyY layout of Y
- * @tparam LayoutPolicyZ layout of Z
+ * @tparam ValueType Compute type of the product, the type of alpha and beta
  * @param[in] handle raft handle
  * @param[in] trans_x transpose operation for X
  * @param[in] trans_y transpose operation for Y
@@ -25,9 +25,15 @@
 #include <rmm/device_uvector.hpp>
 #include <rmm/exec_policy.hpp>
 
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
 #include <raft/sparse/op/sort.cuh>
 #include <raft/util/device_atomics.cuh>
+#include <raft/util/warp_primitives.cuh>
 #include <thrust/device_ptr.h>
+#include <thrust/functional.h>
 #include <thrust/scan.h>
 
 #include <cuda_runtime.h>
@@ -363,6 +369,139 @@ void symmetrize(raft::resources const& handle,
     handle, out, symm_rows.data(), symm_cols.data(), symm_vals.data(), nnz * 2, m, n);
 }
 
+/**
+ * @brief For every kNN edge (i, j), look for i among the k neighbors of j, with one warp per edge.
+ * The position of i in the row of j is stored in rev, or -1 when the transposed edge is new, in
+ * which case it is counted in extra[j].
+ */
+template <int TPB, typename value_idx>
+__global__ void __launch_bounds__(TPB) knn_find_reverse_kernel(
+  const value_idx* __restrict__ knn_indices, value_idx n, int k, int* rev, value_idx* extra)
+{
+  const int lane       = threadIdx.x % raft::WarpSize;
+  const size_t n_edges = size_t(n) * k;
+  const size_t n_warps = size_t(gridDim.x) * (TPB / raft::WarpSize);
+  for (size_t e = (size_t(blockIdx.x) * TPB + threadIdx.x) / raft::WarpSize; e < n_edges;
+       e += n_warps) {
+    value_idx i            = e / k;
+    value_idx j            = knn_indices[e];
+    const value_idx* row_j = knn_indices + size_t(j) * k;
+    int pos                = -1;
+    for (int base = 0; base < k && pos < 0; base += raft::WarpSize) {
+      uint32_t hits = raft::ballot(base + lane < k && row_j[base + lane] == i);
+      if (hits != 0) { pos = base + __ffs(hits) - 1; }
+    }
+    if (lane == 0) {
+      rev[e] = pos;
+      if (pos < 0) { atomicAdd(extra + j, value_idx(1)); }
+    }
+  }
+}
+
+/**
+ * @brief Write every kNN edge (i, j) at its position in row i, and the transposed edges which are
+ * not kNN edges after the k neighbors of their row, in the order they are claimed.
+ */
+template <typename value_idx, typename value_t, typename ReduceOp>
+__global__ void knn_symmetrize_scatter_kernel(const value_idx* __restrict__ knn_indices,
+                                              const value_t* __restrict__ knn_dists,
+                                              const int* __restrict__ rev,
+                                              value_idx n,
+                                              int k,
+                                              const value_idx* __restrict__ indptr,
+                                              value_idx* cursor,
+                                              value_idx* out_indices,
+                                              value_t* out_data,
+                                              ReduceOp reduction_op)
+{
+  const size_t n_edges = size_t(n) * k;
+  for (size_t e = size_t(blockIdx.x) * blockDim.x + threadIdx.x; e < n_edges;
+       e += size_t(gridDim.x) * blockDim.x) {
+    value_idx i = e / k;
+    value_idx j = knn_indices[e];
+    value_t w   = knn_dists[e];
+    int pos     = rev[e];
+
+    size_t out       = indptr[i] + e % k;
+    out_indices[out] = j;
+    out_data[out]    = pos < 0 ? w : reduction_op(w, knn_dists[size_t(j) * k + pos]);
+    if (pos < 0) {
+      size_t slot       = indptr[j] + k + atomicAdd(cursor + j, value_idx(1));
+      out_indices[slot] = i;
+      out_data[slot]    = w;
+    }
+  }
+}
+
+/**
+ * @brief Symmetrize a kNN graph straight into a CSR matrix, without sorting.
+ *
+ * The graph has a fixed degree, so the membership of the transposed edge (j, i) is found by
+ * scanning the k neighbors of j. The rows are then sized by a count / scan pass and filled by a
+ * scatter pass: row i holds its k neighbors in their kNN order, followed by the rows which have i
+ * among their neighbors but are not neighbors of i, in no particular order.
+ */
+template <typename value_idx, typename value_t, typename ReduceOp>
+void from_knn_symmetrize_csr(raft::resources const& handle,
+                             const value_idx* knn_indices,
+                             const value_t* knn_dists,
+                             value_idx n,
+                             int k,
+                             raft::device_csr_matrix<value_t, value_idx, value_idx, value_idx>& out,
+                             ReduceOp reduction_op)
+{
+  auto stream          = resource::get_cuda_stream(handle);
+  const size_t n_edges = size_t(n) * k;
+  auto indptr          = out.structure_view().get_indptr().data();
+  if (n_edges == 0) {
+    RAFT_CUDA_TRY(cudaMemsetAsync(indptr, 0, (n + 1) * sizeof(value_idx), stream));
+    out.initialize_sparsity(0);
+    return;
+  }
+
+  rmm::device_uvector<int> rev(n_edges, stream, resource::get_workspace_resource(handle));
+  rmm::device_uvector<value_idx> extra(n, stream, resource::get_workspace_resource(handle));
+  RAFT_CUDA_TRY(cudaMemsetAsync(extra.data(), 0, n * sizeof(value_idx), stream));
+
+  constexpr int TPB           = 256;
+  constexpr int kWarps        = TPB / raft::WarpSize;
+  constexpr size_t kMaxBlocks = size_t(1) << 20;
+  knn_find_reverse_kernel<TPB>
+    <<<std::min(raft::ceildiv<size_t>(n_edges, kWarps), kMaxBlocks), TPB, 0, stream>>>(
+      knn_indices, n, k, rev.data(), extra.data());
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+  // row i holds its k neighbors and the extra[i] new transposed edges
+  RAFT_CUDA_TRY(cudaMemsetAsync(indptr, 0, sizeof(value_idx), stream));
+  thrust::transform_inclusive_scan(resource::get_thrust_policy(handle),
+                                   extra.data(),
+                                   extra.data() + n,
+                                   indptr + 1,
+                                   raft::add_const_op<value_idx>(k),
+                                   thrust::plus<value_idx>());
+  value_idx nnz;
+  raft::update_host(&nnz, indptr + n, 1, stream);
+  resource::sync_stream(handle, stream);
+  out.initialize_sparsity(nnz);
+
+  // extra is reused as the cursor of the transposed edges of every row
+  RAFT_CUDA_TRY(cudaMemsetAsync(extra.data(), 0, n * sizeof(value_idx), stream));
+  knn_symmetrize_scatter_kernel<<<std::min(raft::ceildiv<size_t>(n_edges, TPB), kMaxBlocks),
+                                  TPB,
+                                  0,
+                                  stream>>>(knn_indices,
+                                            knn_dists,
+                                            rev.data(),
+                                            n,
+                                            k,
+                                            indptr,
+                                            extra.data(),
+                                            out.structure_view().get_indices().data(),
+                                            out.get_elements().data(),
+                                            reduction_op);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
 };  // end NAMESPACE detail
 };  // end NAMESPACE linalg
 };  // end NAMESPACE sparse
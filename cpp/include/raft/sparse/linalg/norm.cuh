@@ -100,6 +100,108 @@ void rowNormCsr(raft::resources const& handle,
   detail::rowNormCsrCaller(ia, data, nnz, N, norm, type, fin_op, resource::get_cuda_stream(handle));
 }
 
+/**
+ * @brief Compute the statistics of every row of a CSR matrix in a single pass over its values:
+ * the number of non-zeros, the sum and the L1, L2 and max norms.
+ *
+ * Every row is reduced by a warp, except the rows of more than `32 * WarpSize` non-zeros which are
+ * reduced by a whole block, so that a few long rows (e.g. of a power-law distribution of row
+ * lengths) don't serialize the pass. Any of the outputs may be nullptr to skip it.
+ *
+ * @tparam Type the data type
+ * @tparam IdxType Integer type used to for addressing
+ * @param handle raft handle
+ * @param ia the input matrix row index array [N]
+ * @param data the input matrix nnz data
+ * @param nnz number of elements in data
+ * @param N number of rows
+ * @param row_nnz the output number of non-zeros of every row, size [N]
+ * @param sum the output sum of every row, size [N]
+ * @param l1 the output L1 norm of every row, size [N]
+ * @param l2 the output L2 norm (sqrt of the sum of squares) of every row, size [N]
+ * @param linf the output max norm of every row, size [N]
+ */
+template <typename Type, typename IdxType = int>
+void csr_row_stats(raft::resources const& handle,
+                   const IdxType* ia,
+                   const Type* data,
+                   const IdxType nnz,
+                   const IdxType N,
+                   IdxType* row_nnz,
+                   Type* sum,
+                   Type* l1,
+                   Type* l2,
+                   Type* linf)
+{
+  detail::csr_row_stats(handle, ia, data, nnz, N, row_nnz, sum, l1, l2, linf);
+}
+
+/**
+ * @brief Weigh the values of a CSR matrix by the weights of their columns and normalize the rows
+ * of the weighted matrix: result[i] = data[i] * w[col(i)] / norm(row), fused in one kernel.
+ *
+ * Rows of norm 0 are left to 0. With the `csr_idf` weights and the L2 norm, this transforms a
+ * matrix of term counts into its TF-IDF matrix; without weights, this is the row normalization
+ * of the matrix. The rows are balanced between warps and blocks as in `csr_row_stats`.
+ *
+ * @tparam Type the data type
+ * @tparam IdxType Integer type used to for addressing
+ * @param handle raft handle
+ * @param ia the input matrix row index array [N]
+ * @param indices the input matrix column indices [nnz]
+ * @param data the input matrix nnz data
+ * @param nnz number of elements in data
+ * @param N number of rows
+ * @param col_weights the weights of the columns, or nullptr for none
+ * @param norm the norm of the rows: L1Norm, L2Norm or LinfNorm
+ * @param result the output data array, size [nnz]; may alias data
+ */
+template <typename Type, typename IdxType = int>
+void csr_row_scale(raft::resources const& handle,
+                   const IdxType* ia,
+                   const IdxType* indices,
+                   const Type* data,
+                   const IdxType nnz,
+                   const IdxType N,
+                   const Type* col_weights,
+                   raft::linalg::NormType norm,
+                   Type* result)
+{
+  detail::csr_row_scale(handle, ia, indices, data, nnz, N, col_weights, norm, result);
+}
+
+/**
+ * @brief Compute the smoothed inverse document frequency of every column of a CSR matrix whose
+ * rows are documents and whose columns are terms: idf(j) = log((1 + N) / (1 + df(j))) + 1, where
+ * df(j) is the number of non-zeros of the column j.
+ *
+ * Usage example of the TF-IDF transform:
+ * @code{.cpp}
+ *   raft::sparse::linalg::csr_idf(handle, indices, nnz, n_docs, n_terms, idf);
+ *   raft::sparse::linalg::csr_row_scale(
+ *     handle, ia, indices, counts, nnz, n_docs, idf, raft::linalg::L2Norm, tfidf);
+ * @endcode
+ *
+ * @tparam Type the data type
+ * @tparam IdxType Integer type used to for addressing
+ * @param handle raft handle
+ * @param indices the input matrix column indices [nnz]; a column appears at most once per row
+ * @param nnz number of non-zeros
+ * @param N number of rows (documents)
+ * @param D number of columns (terms)
+ * @param idf the output weights of the columns, size [D]
+ */
+template <typename Type, typename IdxType = int>
+void csr_idf(raft::resources const& handle,
+             const IdxType* indices,
+             const IdxType nnz,
+             const IdxType N,
+             const IdxType D,
+             Type* idf)
+{
+  detail::csr_idf(handle, indices, nnz, N, D, idf);
+}
+
 };  // end NAMESPACE linalg
 };  // end NAMESPACE sparse
 };  // end NAMESPACE raft
@@ -0,0 +1,344 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/cusparse_handle.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/sparse/detail/cusparse_wrappers.h>
+
+#include <rmm/device_uvector.hpp>
+
+#include <cstdint>
+#include <type_traits>
+
+namespace raft::sparse::linalg {
+
+/**
+ * @brief A CSR matrix bound to the cuSPARSE state of its products with dense operands.
+ *
+ * The sparse descriptor is created once, and the dense descriptors and the size of the external
+ * buffer of the last SpMM and SpMV shapes are kept: when an iterative solver applies the operator
+ * to new vectors of the same shape, only the data pointers of the dense descriptors are updated.
+ * The external buffer is allocated from the workspace resource of the `raft::resources` passed to
+ * the constructor and only grows.
+ *
+ * With `preprocess`, `cusparseSpMM_preprocess` analyzes the matrix the first time a shape is
+ * used, which speeds up the following products of that shape.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *  raft::sparse::linalg::sparse_operator<float, int, int> op(handle, csr_view, true);
+ *  for (int i = 0; i < n_iter; i++) {
+ *    op.spmm(false, false, &alpha, x_view, &beta, y_view);
+ *    ...
+ *  }
+ * @endcode
+ *
+ * The operator holds a reference to the resources and a view of the matrix: both must outlive it.
+ *
+ * A half or int8 matrix is multiplied with dense inputs of the same type into outputs of
+ * `OutType`, accumulating in `compute_type` (see raft::sparse::detail::spmm_compute_t); e.g. a
+ * `sparse_operator<half, int, int, float>` reads the half weights and writes fp32 products.
+ *
+ * @tparam ValueType data type of the matrix and of the dense inputs (float/double/half/int8_t)
+ * @tparam IndexType type of the row offsets and the column indices (int/int64_t)
+ * @tparam NZType type of the number of non-zeros
+ * @tparam OutType data type of the dense outputs
+ */
+template <typename ValueType, typename IndexType, typename NZType, typename OutType = ValueType>
+class sparse_operator {
+ public:
+  using csr_view_type =
+    raft::device_csr_matrix_view<const ValueType, IndexType, IndexType, NZType>;
+  /** The type of the accumulation and of the alpha and beta scalars. */
+  using compute_type = raft::sparse::detail::spmm_compute_t<ValueType, OutType>;
+
+  /**
+   * @param[in] handle raft resources, providing the cuSPARSE handle, the stream and the workspace
+   * @param[in] x the CSR matrix
+   * @param[in] preprocess whether to run cusparseSpMM_preprocess on the first product of a shape
+   */
+  sparse_operator(raft::resources const& handle, csr_view_type x, bool preprocess = false)
+    : handle_(handle),
+      x_(x),
+      preprocess_(preprocess),
+      workspace_(0, resource::get_cuda_stream(handle), resource::get_workspace_resource(handle))
+  {
+    auto structure = x_.structure_view();
+    RAFT_CUSPARSE_TRY(raft::sparse::detail::cusparsecreatecsr(
+      &descr_x_,
+      structure.get_n_rows(),
+      structure.get_n_cols(),
+      structure.get_nnz(),
+      const_cast<IndexType*>(structure.get_indptr().data()),
+      const_cast<IndexType*>(structure.get_indices().data()),
+      const_cast<ValueType*>(x_.get_elements().data())));
+  }
+
+  sparse_operator(const sparse_operator&)            = delete;
+  sparse_operator& operator=(const sparse_operator&) = delete;
+
+  ~sparse_operator()
+  {
+    reset_spmm();
+    reset_spmv();
+    RAFT_CUSPARSE_TRY_NO_THROW(cusparseDestroySpMat(descr_x_));
+  }
+
+  /**
+   * @brief Z = alpha . op(X) * op(Y) + beta . Z, with X the bound CSR matrix
+   * @param[in] trans_x transpose operation for X
+   * @param[in] trans_y transpose operation for Y
+   * @param[in] alpha scalar
+   * @param[in] y input raft::device_matrix_view
+   * @param[in] beta scalar
+   * @param[out] z output raft::device_matrix_view, of the layout of Y
+   */
+  template <typename DenseIdxT, typename LayoutPolicyY, typename LayoutPolicyZ>
+  void spmm(const bool trans_x,
+            const bool trans_y,
+            const compute_type* alpha,
+            raft::device_matrix_view<const ValueType, DenseIdxT, LayoutPolicyY> y,
+            const compute_type* beta,
+            raft::device_matrix_view<OutType, DenseIdxT, LayoutPolicyZ> z)
+  {
+    auto cusparse_h   = resource::get_cusparse_handle(handle_);
+    auto stream       = resource::get_cuda_stream(handle_);
+    bool is_row_major = z.stride(1) == 1 && y.stride(1) == 1;
+    bool is_col_major = z.stride(0) == 1 && y.stride(0) == 1;
+    ASSERT(is_row_major || is_col_major, "Both matrices need to be either row or col major");
+
+    auto shape_y = make_shape(y, is_row_major);
+    auto shape_z = make_shape(z, is_row_major);
+    auto op_x    = trans_x ? CUSPARSE_OPERATION_TRANSPOSE : CUSPARSE_OPERATION_NON_TRANSPOSE;
+    auto op_y    = trans_y ? CUSPARSE_OPERATION_TRANSPOSE : CUSPARSE_OPERATION_NON_TRANSPOSE;
+    auto ptr_y   = const_cast<ValueType*>(y.data_handle());
+    auto ptr_z   = z.data_handle();
+
+    if (spmm_.valid && spmm_.op_x == op_x && spmm_.op_y == op_y &&
+        spmm_.row_major == is_row_major && spmm_.shape_y == shape_y && spmm_.shape_z == shape_z) {
+      RAFT_CUSPARSE_TRY(cusparseDnMatSetValues(spmm_.descr_y, ptr_y));
+      RAFT_CUSPARSE_TRY(cusparseDnMatSetValues(spmm_.descr_z, ptr_z));
+    } else {
+      reset_spmm();
+      auto order = is_row_major ? CUSPARSE_ORDER_ROW : CUSPARSE_ORDER_COL;
+      RAFT_CUSPARSE_TRY(raft::sparse::detail::cusparsecreatednmat(
+        &spmm_.descr_y, shape_y.rows, shape_y.cols, shape_y.ld, ptr_y, order));
+      RAFT_CUSPARSE_TRY(raft::sparse::detail::cusparsecreatednmat(
+        &spmm_.descr_z, shape_z.rows, shape_z.cols, shape_z.ld, ptr_z, order));
+      spmm_.op_x      = op_x;
+      spmm_.op_y      = op_y;
+      spmm_.row_major = is_row_major;
+      spmm_.shape_y   = shape_y;
+      spmm_.shape_z   = shape_z;
+      spmm_.alg       = is_row_major ? CUSPARSE_SPMM_CSR_ALG2 : CUSPARSE_SPMM_CSR_ALG1;
+      size_t buffer_size;
+      RAFT_CUSPARSE_TRY(raft::sparse::detail::cusparsespmm_bufferSize(cusparse_h,
+                                                                      op_x,
+                                                                      op_y,
+                                                                      alpha,
+                                                                      descr_x_,
+                                                                      spmm_.descr_y,
+                                                                      beta,
+                                                                      spmm_.descr_z,
+                                                                      spmm_.alg,
+                                                                      &buffer_size,
+                                                                      stream));
+      reserve(buffer_size);
+      spmm_.valid = true;
+    }
+
+#if CUDART_VERSION >= 11020
+    if (preprocess_ && !spmm_.preprocessed) {
+      RAFT_CUSPARSE_TRY(raft::sparse::detail::cusparsespmm_preprocess(cusparse_h,
+                                                                      op_x,
+                                                                      op_y,
+                                                                      alpha,
+                                                                      descr_x_,
+                                                                      spmm_.descr_y,
+                                                                      beta,
+                                                                      spmm_.descr_z,
+                                                                      spmm_.alg,
+                                                                      workspace_.data(),
+                                                                      stream));
+      spmm_.preprocessed = true;
+    }
+#endif
+
+    RAFT_CUSPARSE_TRY(
+      raft::sparse::detail::cusparsespmm(cusparse_h,
+                                         op_x,
+                                         op_y,
+                                         alpha,
+                                         descr_x_,
+                                         spmm_.descr_y,
+                                         beta,
+                                         spmm_.descr_z,
+                                         spmm_.alg,
+                                         reinterpret_cast<compute_type*>(workspace_.data()),
+                                         stream));
+  }
+
+  /**
+   * @brief y = alpha . op(X) * x + beta . y, with X the bound CSR matrix
+   * @param[in] trans_x transpose operation for X
+   * @param[in] alpha scalar
+   * @param[in] x input raft::device_vector_view
+   * @param[in] beta scalar
+   * @param[out] y output raft::device_vector_view
+   * @param[in] alg cuSPARSE SpMV algorithm
+   */
+  template <typename DenseIdxT>
+  void spmv(const bool trans_x,
+            const compute_type* alpha,
+            raft::device_vector_view<const ValueType, DenseIdxT> x,
+            const compute_type* beta,
+            raft::device_vector_view<OutType, DenseIdxT> y,
+            cusparseSpMVAlg_t alg = CUSPARSE_SPMV_CSR_ALG1)
+  {
+    auto cusparse_h = resource::get_cusparse_handle(handle_);
+    auto stream     = resource::get_cuda_stream(handle_);
+    auto op_x       = trans_x ? CUSPARSE_OPERATION_TRANSPOSE : CUSPARSE_OPERATION_NON_TRANSPOSE;
+    auto ptr_x      = const_cast<ValueType*>(x.data_handle());
+    auto ptr_y      = y.data_handle();
+
+    if (spmv_.valid && spmv_.op_x == op_x && spmv_.alg == alg &&
+        spmv_.size_x == int64_t(x.extent(0)) && spmv_.size_y == int64_t(y.extent(0))) {
+      RAFT_CUSPARSE_TRY(cusparseDnVecSetValues(spmv_.descr_x, ptr_x));
+      RAFT_CUSPARSE_TRY(cusparseDnVecSetValues(spmv_.descr_y, ptr_y));
+    } else {
+      reset_spmv();
+      spmv_.op_x   = op_x;
+      spmv_.alg    = alg;
+      spmv_.size_x = x.extent(0);
+      spmv_.size_y = y.extent(0);
+      RAFT_CUSPARSE_TRY(
+        raft::sparse::detail::cusparsecreatednvec(&spmv_.descr_x, spmv_.size_x, ptr_x));
+      RAFT_CUSPARSE_TRY(
+        raft::sparse::detail::cusparsecreatednvec(&spmv_.descr_y, spmv_.size_y, ptr_y));
+      size_t buffer_size;
+      RAFT_CUSPARSE_TRY(raft::sparse::detail::cusparsespmv_buffersize(cusparse_h,
+                                                                      op_x,
+                                                                      alpha,
+                                                                      descr_x_,
+                                                                      spmv_.descr_x,
+                                                                      beta,
+                                                                      spmv_.descr_y,
+                                                                      alg,
+                                                                      &buffer_size,
+                                                                      stream));
+      reserve(buffer_size);
+      spmv_.valid = true;
+    }
+
+    RAFT_CUSPARSE_TRY(
+      raft::sparse::detail::cusparsespmv(cusparse_h,
+                                         op_x,
+                                         alpha,
+                                         descr_x_,
+                                         spmv_.descr_x,
+                                         beta,
+                                         spmv_.descr_y,
+                                         alg,
+                                         reinterpret_cast<compute_type*>(workspace_.data()),
+                                         stream));
+  }
+
+  /** The bound CSR matrix. */
+  [[nodiscard]] auto view() const -> csr_view_type { return x_; }
+
+ private:
+  struct dense_shape {
+    int64_t rows = 0;
+    int64_t cols = 0;
+    int64_t ld   = 0;
+
+    bool operator==(const dense_shape& other) const
+    {
+      return rows == other.rows && cols == other.cols && ld == other.ld;
+    }
+  };
+
+  struct spmm_state {
+    bool valid        = false;
+    bool preprocessed = false;
+    bool row_major    = false;
+    cusparseOperation_t op_x;
+    cusparseOperation_t op_y;
+    cusparseSpMMAlg_t alg;
+    dense_shape shape_y;
+    dense_shape shape_z;
+    cusparseDnMatDescr_t descr_y;
+    cusparseDnMatDescr_t descr_z;
+  };
+
+  struct spmv_state {
+    bool valid     = false;
+    int64_t size_x = 0;
+    int64_t size_y = 0;
+    cusparseOperation_t op_x;
+    cusparseSpMVAlg_t alg;
+    cusparseDnVecDescr_t descr_x;
+    cusparseDnVecDescr_t descr_y;
+  };
+
+  template <typename MatrixView>
+  static dense_shape make_shape(const MatrixView& view, bool is_row_major)
+  {
+    return dense_shape{static_cast<int64_t>(view.extent(0)),
+                       static_cast<int64_t>(view.extent(1)),
+                       static_cast<int64_t>(is_row_major ? view.stride(0) : view.stride(1))};
+  }
+
+  /** Grow the external buffer; the analysis of a preprocessed SpMM lives in it. */
+  void reserve(size_t buffer_size)
+  {
+    if (buffer_size <= workspace_.size()) { return; }
+    workspace_.resize(buffer_size, resource::get_cuda_stream(handle_));
+    spmm_.preprocessed = false;
+  }
+
+  void reset_spmm()
+  {
+    if (!spmm_.valid) { return; }
+    RAFT_CUSPARSE_TRY_NO_THROW(cusparseDestroyDnMat(spmm_.descr_y));
+    RAFT_CUSPARSE_TRY_NO_THROW(cusparseDestroyDnMat(spmm_.descr_z));
+    spmm_ = spmm_state{};
+  }
+
+  void reset_spmv()
+  {
+    if (!spmv_.valid) { return; }
+    RAFT_CUSPARSE_TRY_NO_THROW(cusparseDestroyDnVec(spmv_.descr_x));
+    RAFT_CUSPARSE_TRY_NO_THROW(cusparseDestroyDnVec(spmv_.descr_y));
+    spmv_ = spmv_state{};
+  }
+
+  raft::resources const& handle_;
+  csr_view_type x_;
+  bool preprocess_;
+  cusparseSpMatDescr_t descr_x_;
+  rmm::device_uvector<char> workspace_;
+  spmm_state spmm_;
+  spmv_state spmv_;
+};
+
+}  // namespace raft::sparse::linalg
@@ -20,6 +20,8 @@
 
 #include "detail/spmm.hpp"
 
+#include <type_traits>
+
 namespace raft {
 namespace sparse {
 namespace linalg {
@@ -29,11 +31,17 @@ namespace linalg {
  * combinations of operand layouts for cuSparse.
  * It computes the following equation: Z = alpha . X * Y + beta . Z
  * where X is a CSR device matrix view and Y,Z are device matrix views
- * @tparam ValueType Data type of input/output matrices (float/double)
+ *
+ * Besides float and double, X and Y may hold half values, with Z in half or float, or int8 values,
+ * with Z in float or int32. The reduced precision products are accumulated in fp32 (int32 for the
+ * int8 products into int32), which is the type of alpha and beta (see spmm_compute_t).
+ * @tparam ValueType Data type of X and Y (float/double/half/int8_t)
  * @tparam IndexType Type of Y and Z
  * @tparam NZType Type of X
  * @tparam LayoutPolicyY layout of Y
  * @tparam LayoutPolicyZ layout of Z
+ * @tparam OutType Data type of Z
+ * @tparam ComputeType Data type of alpha and beta
  * @param[in] handle raft handle
  * @param[in] trans_x transpose operation for X
  * @param[in] trans_y transpose operation for Y
@@ -47,16 +55,21 @@ template <typename ValueType,
           typename IndexType,
           typename NZType,
           typename LayoutPolicyY,
-          typename LayoutPolicyZ>
+          typename LayoutPolicyZ,
+          typename OutType,
+          typename ComputeType>
 void spmm(raft::resources const& handle,
           const bool trans_x,
           const bool trans_y,
-          const ValueType* alpha,
+          const ComputeType* alpha,
           raft::device_csr_matrix_view<const ValueType, int, int, NZType> x,
           raft::device_matrix_view<const ValueType, IndexType, LayoutPolicyY> y,
-          const ValueType* beta,
-          raft::device_matrix_view<ValueType, IndexType, LayoutPolicyZ> z)
+          const ComputeType* beta,
+          raft::device_matrix_view<OutType, IndexType, LayoutPolicyZ> z)
 {
+  static_assert(
+    std::is_same_v<ComputeType, raft::sparse::detail::spmm_compute_t<ValueType, OutType>>,
+    "alpha and beta must be of the compute type of the product");
   bool is_row_major = detail::is_row_major(y, z);
 
   auto descr_x = detail::create_descriptor(x);
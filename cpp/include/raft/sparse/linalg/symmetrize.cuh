@@ -18,6 +18,8 @@
 
 #pragma once
 
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/operators.hpp>
 #include <raft/sparse/coo.hpp>
 #include <raft/sparse/linalg/detail/symmetrize.cuh>
 
@@ -145,6 +147,44 @@ void from_knn_symmetrize_matrix(const value_idx* __restrict__ knn_indices,
   detail::from_knn_symmetrize_matrix(knn_indices, knn_dists, n, k, out, stream);
 }
 
+/**
+ * @brief Symmetrize raw kNN data straight into a CSR matrix: the output holds the edges of A and
+ * of its transpose, each pair of rows appearing once.
+ *
+ * Unlike `from_knn_symmetrize_matrix` followed by a COO to CSR conversion, no sort is needed: the
+ * transposed edges are looked up in the fixed-degree rows of the input, the rows are sized by a
+ * count / scan pass and filled by a scatter pass. Row i first holds its k neighbors in their kNN
+ * order, then the rows having i among their neighbors which are not neighbors of i, in no
+ * particular order (the column indices of a row are not sorted).
+ *
+ * The neighbors of every row must be valid and distinct indices in [0, n).
+ *
+ * @tparam value_idx index type
+ * @tparam value_t value type
+ * @tparam ReduceOp binary device functor
+ * @param[in] handle raft handle
+ * @param[in] knn_indices input knn indices (n, k)
+ * @param[in] knn_dists input knn distances (n, k)
+ * @param[in] n number of rows
+ * @param[in] k number of neighbors
+ * @param[out] out output n x n CSR matrix, its sparsity is initialized here
+ * @param[in] reduction_op combines the two weights of the edges present in both directions; the
+ *   edges present in one direction keep their weight
+ */
+template <typename value_idx, typename value_t, typename ReduceOp = raft::max_op>
+void from_knn_symmetrize_csr(raft::resources const& handle,
+                             const value_idx* knn_indices,
+                             const value_t* knn_dists,
+                             value_idx n,
+                             int k,
+                             raft::device_csr_matrix<value_t, value_idx, value_idx, value_idx>& out,
+                             ReduceOp reduction_op = raft::max_op())
+{
+  RAFT_EXPECTS(out.structure_view().get_n_rows() == n && out.structure_view().get_n_cols() == n,
+               "The output must be of size n x n");
+  detail::from_knn_symmetrize_csr(handle, knn_indices, knn_dists, n, k, out, reduction_op);
+}
+
 /**
  * Symmetrizes a COO matrix
  */
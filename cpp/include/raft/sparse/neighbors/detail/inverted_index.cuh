@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/matrix/col_wise_sort.cuh>
+#include <raft/matrix/select_k.cuh>
+#include <raft/sparse/linalg/transpose.cuh>
+#include <raft/sparse/neighbors/inverted_index_types.hpp>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <cub/cub.cuh>
+
+#include <algorithm>
+#include <limits>
+
+namespace raft::sparse::neighbors::inverted_index::detail {
+
+// the score buffers of a query batch are limited to this many elements by default
+static constexpr size_t kDefaultScoreBufferElems = size_t(1) << 28;
+
+template <typename value_idx, typename value_t>
+index<value_idx, value_t> build(raft::resources const& handle,
+                                const value_idx* indptr,
+                                const value_idx* indices,
+                                const value_t* data,
+                                value_idx nnz,
+                                value_idx n_rows,
+                                value_idx n_cols)
+{
+  auto stream = resource::get_cuda_stream(handle);
+  index<value_idx, value_t> idx(handle, n_rows, n_cols, nnz);
+  if (nnz == 0) {
+    RAFT_CUDA_TRY(
+      cudaMemsetAsync(idx.indptr.data(), 0, idx.indptr.size() * sizeof(value_idx), stream));
+    return idx;
+  }
+
+  rmm::device_uvector<value_idx> csc_rows(nnz, stream);
+  rmm::device_uvector<value_t> csc_data(nnz, stream);
+  raft::sparse::linalg::csr_transpose(handle,
+                                      indptr,
+                                      indices,
+                                      data,
+                                      idx.indptr.data(),
+                                      csc_rows.data(),
+                                      csc_data.data(),
+                                      n_rows,
+                                      n_cols,
+                                      nnz,
+                                      stream);
+
+  // sort every posting list by decreasing weight
+  size_t workspace_size = 0;
+  RAFT_CUDA_TRY(cub::DeviceSegmentedRadixSort::SortPairsDescending(nullptr,
+                                                                   workspace_size,
+                                                                   csc_data.data(),
+                                                                   idx.weights.data(),
+                                                                   csc_rows.data(),
+                                                                   idx.rows.data(),
+                                                                   nnz,
+                                                                   n_cols,
+                                                                   idx.indptr.data(),
+                                                                   idx.indptr.data() + 1,
+                                                                   0,
+                                                                   sizeof(value_t) * 8,
+                                                                   stream));
+  rmm::device_uvector<char> workspace(
+    workspace_size, stream, resource::get_workspace_resource(handle));
+  RAFT_CUDA_TRY(cub::DeviceSegmentedRadixSort::SortPairsDescending(workspace.data(),
+                                                                   workspace_size,
+                                                                   csc_data.data(),
+                                                                   idx.weights.data(),
+                                                                   csc_rows.data(),
+                                                                   idx.rows.data(),
+                                                                   nnz,
+                                                                   n_cols,
+                                                                   idx.indptr.data(),
+                                                                   idx.indptr.data() + 1,
+                                                                   0,
+                                                                   sizeof(value_t) * 8,
+                                                                   stream));
+  return idx;
+}
+
+/**
+ * Term-at-a-time accumulation: one block per query walks the posting lists of the terms of the
+ * query and adds the products of the weights to the scores of the documents. The warps of a block
+ * may work on different terms at the same time, hence the atomics; they are almost never
+ * contended.
+ */
+template <int TPB, typename value_idx, typename value_t>
+__global__ void __launch_bounds__(TPB)
+  inverted_index_accumulate_kernel(const value_idx* postings_indptr,
+                                   const value_idx* postings_rows,
+                                   const value_t* postings_weights,
+                                   const value_idx* query_indptr,
+                                   const value_idx* query_indices,
+                                   const value_t* query_data,
+                                   value_idx query_offset,
+                                   value_idx n_rows,
+                                   value_idx max_postings,
+                                   value_t* scores)
+{
+  const value_idx q   = query_offset + blockIdx.x;
+  value_t* row_scores = scores + static_cast<size_t>(blockIdx.x) * n_rows;
+  for (value_idx nz = query_indptr[q]; nz < query_indptr[q + 1]; nz++) {
+    const value_idx term  = query_indices[nz];
+    const value_t weight  = query_data[nz];
+    const value_idx start = postings_indptr[term];
+    const value_idx stop  = min(postings_indptr[term + 1], start + max_postings);
+    for (value_idx p = start + threadIdx.x; p < stop; p += TPB) {
+      atomicAdd(row_scores + postings_rows[p], weight * postings_weights[p]);
+    }
+  }
+}
+
+template <typename value_idx, typename value_t>
+void search(raft::resources const& handle,
+            const index<value_idx, value_t>& idx,
+            const value_idx* queryIndptr,
+            const value_idx* queryIndices,
+            const value_t* queryData,
+            value_idx n_query_rows,
+            value_idx* output_indices,
+            value_t* output_dists,
+            int k,
+            size_t batch_size_query,
+            value_idx max_postings_per_term)
+{
+  RAFT_EXPECTS(k > 0 && k <= idx.n_rows, "k must be in [1, number of indexed rows]");
+  auto stream = resource::get_cuda_stream(handle);
+  if (n_query_rows == 0) { return; }
+
+  if (batch_size_query == 0) {
+    batch_size_query = std::max<size_t>(1, kDefaultScoreBufferElems / size_t(idx.n_rows));
+  }
+  batch_size_query = std::min<size_t>(batch_size_query, n_query_rows);
+  value_idx max_postings =
+    max_postings_per_term > 0 ? max_postings_per_term : std::numeric_limits<value_idx>::max();
+
+  rmm::device_uvector<value_t> scores(
+    batch_size_query * idx.n_rows, stream, resource::get_workspace_resource(handle));
+
+  constexpr int TPB = 256;
+  for (size_t offset = 0; offset < size_t(n_query_rows); offset += batch_size_query) {
+    auto batch_rows = std::min<size_t>(batch_size_query, n_query_rows - offset);
+    RAFT_CUDA_TRY(
+      cudaMemsetAsync(scores.data(), 0, batch_rows * idx.n_rows * sizeof(value_t), stream));
+    inverted_index_accumulate_kernel<TPB><<<batch_rows, TPB, 0, stream>>>(idx.indptr.data(),
+                                                                         idx.rows.data(),
+                                                                         idx.weights.data(),
+                                                                         queryIndptr,
+                                                                         queryIndices,
+                                                                         queryData,
+                                                                         value_idx(offset),
+                                                                         idx.n_rows,
+                                                                         max_postings,
+                                                                         scores.data());
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+    // select_k does not order its output: the neighbors are sorted afterwards
+    auto out_dists   = raft::make_device_matrix_view<value_t, int64_t>(
+      output_dists + offset * k, batch_rows, k);
+    auto out_indices = raft::make_device_matrix_view<value_idx, int64_t>(
+      output_indices + offset * k, batch_rows, k);
+    raft::matrix::select_k<value_t, value_idx>(
+      handle,
+      raft::make_device_matrix_view<const value_t, int64_t>(scores.data(), batch_rows, idx.n_rows),
+      std::nullopt,
+      out_dists,
+      out_indices,
+      false);
+    raft::matrix::sort_cols_per_row_inplace(handle, out_dists, out_indices, false);
+  }
+}
+
+}  // namespace raft::sparse::neighbors::inverted_index::detail
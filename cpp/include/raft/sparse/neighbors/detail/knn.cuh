@@ -17,6 +17,7 @@
 #pragma once
 
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
 #include <rmm/device_uvector.hpp>
 
 #include <raft/distance/distance_types.hpp>
@@ -35,80 +36,52 @@
 
 namespace raft::sparse::neighbors::detail {
 
+/**
+ * Batches of consecutive rows of a CSR matrix. The boundaries of all the batches are planned
+ * up front and the columns and values of a batch are views of the arrays of the matrix, so that
+ * selecting a batch neither synchronizes nor copies.
+ */
 template <typename value_idx, typename value_t>
 struct csr_batcher_t {
-  csr_batcher_t(value_idx batch_size,
+  csr_batcher_t(raft::resources const& handle,
+                value_idx batch_size,
                 value_idx n_rows,
                 const value_idx* csr_indptr,
                 const value_idx* csr_indices,
                 const value_t* csr_data)
-    : batch_start_(0),
-      batch_stop_(0),
-      batch_rows_(0),
-      total_rows_(n_rows),
-      batch_size_(batch_size),
-      csr_indptr_(csr_indptr),
+    : batches_(handle, csr_indptr, n_rows, batch_size),
+      batch_(0),
       csr_indices_(csr_indices),
-      csr_data_(csr_data),
-      batch_csr_start_offset_(0),
-      batch_csr_stop_offset_(0)
+      csr_data_(csr_data)
   {
   }
 
-  void set_batch(int batch_num)
-  {
-    batch_start_ = batch_num * batch_size_;
-    batch_stop_  = batch_start_ + batch_size_ - 1;                  // zero-based indexing
-
-    if (batch_stop_ >= total_rows_) batch_stop_ = total_rows_ - 1;  // zero-based indexing
-
-    batch_rows_ = (batch_stop_ - batch_start_) + 1;
-  }
+  void set_batch(int batch_num) { batch_ = batch_num; }
 
   value_idx get_batch_csr_indptr_nnz(value_idx* batch_indptr, cudaStream_t stream)
   {
-    raft::sparse::op::csr_row_slice_indptr(batch_start_,
-                                           batch_stop_,
-                                           csr_indptr_,
-                                           batch_indptr,
-                                           &batch_csr_start_offset_,
-                                           &batch_csr_stop_offset_,
-                                           stream);
-
-    return batch_csr_stop_offset_ - batch_csr_start_offset_;
+    batches_.batch_indptr(batch_, batch_indptr, stream);
+    return batches_.batch_nnz(batch_);
   }
 
-  void get_batch_csr_indices_data(value_idx* csr_indices, value_t* csr_data, cudaStream_t stream)
-  {
-    raft::sparse::op::csr_row_slice_populate(batch_csr_start_offset_,
-                                             batch_csr_stop_offset_,
-                                             csr_indices_,
-                                             csr_data_,
-                                             csr_indices,
-                                             csr_data,
-                                             stream);
-  }
+  const value_idx* batch_csr_indices() const { return batches_.batch_view(batch_, csr_indices_); }
 
-  value_idx batch_rows() const { return batch_rows_; }
+  const value_t* batch_csr_data() const { return batches_.batch_view(batch_, csr_data_); }
 
-  value_idx batch_start() const { return batch_start_; }
+  value_idx batch_rows() const { return batches_.batch_rows(batch_); }
 
-  value_idx batch_stop() const { return batch_stop_; }
+  value_idx max_batch_rows() const { return batches_.max_batch_rows(); }
 
- private:
-  value_idx batch_size_;
-  value_idx batch_start_;
-  value_idx batch_stop_;
-  value_idx batch_rows_;
+  value_idx batch_start() const { return batches_.batch_start(batch_); }
+
+  value_idx batch_stop() const { return batch_start() + batch_rows() - 1; }
 
-  value_idx total_rows_;
+ private:
+  raft::sparse::op::csr_row_batches<value_idx> batches_;
+  value_idx batch_;
 
-  const value_idx* csr_indptr_;
   const value_idx* csr_indices_;
   const value_t* csr_data_;
-
-  value_idx batch_csr_start_offset_;
-  value_idx batch_csr_stop_offset_;
 };
 
 template <typename value_idx, typename value_t>
@@ -163,7 +136,17 @@ class sparse_knn_t {
 
     int n_batches_query = raft::ceildiv((size_t)n_query_rows, batch_size_query);
     csr_batcher_t<value_idx, value_t> query_batcher(
-      batch_size_query, n_query_rows, queryIndptr, queryIndices, queryData);
+      handle, batch_size_query, n_query_rows, queryIndptr, queryIndices, queryData);
+
+    // the index batches are the same for every query batch: plan them once
+    int n_batches_idx = raft::ceildiv((size_t)n_idx_rows, batch_size_index);
+    csr_batcher_t<value_idx, value_t> idx_batcher(
+      handle, batch_size_index, n_idx_rows, idxIndptr, idxIndices, idxData);
+
+    rmm::device_uvector<value_idx> query_batch_indptr(query_batcher.max_batch_rows() + 1,
+                                                      resource::get_cuda_stream(handle));
+    rmm::device_uvector<value_idx> idx_batch_indptr(idx_batcher.max_batch_rows() + 1,
+                                                    resource::get_cuda_stream(handle));
 
     size_t rows_processed = 0;
 
@@ -176,21 +159,9 @@ class sparse_knn_t {
       /**
        * Slice CSR to rows in batch
        */
-
-      rmm::device_uvector<value_idx> query_batch_indptr(query_batcher.batch_rows() + 1,
-                                                        resource::get_cuda_stream(handle));
-
       value_idx n_query_batch_nnz = query_batcher.get_batch_csr_indptr_nnz(
         query_batch_indptr.data(), resource::get_cuda_stream(handle));
 
-      rmm::device_uvector<value_idx> query_batch_indices(n_query_batch_nnz,
-                                                         resource::get_cuda_stream(handle));
-      rmm::device_uvector<value_t> query_batch_data(n_query_batch_nnz,
-                                                    resource::get_cuda_stream(handle));
-
-      query_batcher.get_batch_csr_indices_data(
-        query_batch_indices.data(), query_batch_data.data(), resource::get_cuda_stream(handle));
-
       // A 3-partition temporary merge space to scale the batching. 2 parts for subsequent
       // batches and 1 space for the results of the merge, which get copied back to the top
       rmm::device_uvector<value_idx> merge_buffer_indices(0, resource::get_cuda_stream(handle));
@@ -199,10 +170,6 @@ class sparse_knn_t {
       value_t* dists_merge_buffer_ptr;
       value_idx* indices_merge_buffer_ptr;
 
-      int n_batches_idx = raft::ceildiv((size_t)n_idx_rows, batch_size_index);
-      csr_batcher_t<value_idx, value_t> idx_batcher(
-        batch_size_index, n_idx_rows, idxIndptr, idxIndices, idxData);
-
       for (int j = 0; j < n_batches_idx; j++) {
         idx_batcher.set_batch(j);
 
@@ -214,20 +181,9 @@ class sparse_knn_t {
         /**
          * Slice CSR to rows in batch
          */
-        rmm::device_uvector<value_idx> idx_batch_indptr(idx_batcher.batch_rows() + 1,
-                                                        resource::get_cuda_stream(handle));
-        rmm::device_uvector<value_idx> idx_batch_indices(0, resource::get_cuda_stream(handle));
-        rmm::device_uvector<value_t> idx_batch_data(0, resource::get_cuda_stream(handle));
-
         value_idx idx_batch_nnz = idx_batcher.get_batch_csr_indptr_nnz(
           idx_batch_indptr.data(), resource::get_cuda_stream(handle));
 
-        idx_batch_indices.resize(idx_batch_nnz, resource::get_cuda_stream(handle));
-        idx_batch_data.resize(idx_batch_nnz, resource::get_cuda_stream(handle));
-
-        idx_batcher.get_batch_csr_indices_data(
-          idx_batch_indices.data(), idx_batch_data.data(), resource::get_cuda_stream(handle));
-
         /**
          * Compute distances
          */
@@ -241,11 +197,11 @@ class sparse_knn_t {
                           idx_batch_nnz,
                           n_query_batch_nnz,
                           idx_batch_indptr.data(),
-                          idx_batch_indices.data(),
-                          idx_batch_data.data(),
+                          idx_batcher.batch_csr_indices(),
+                          idx_batcher.batch_csr_data(),
                           query_batch_indptr.data(),
-                          query_batch_indices.data(),
-                          query_batch_data.data(),
+                          query_batcher.batch_csr_indices(),
+                          query_batcher.batch_csr_data(),
                           batch_dists.data());
 
         // Build batch indices array
@@ -380,11 +336,11 @@ class sparse_knn_t {
                          size_t idx_batch_nnz,
                          size_t query_batch_nnz,
                          value_idx* idx_batch_indptr,
-                         value_idx* idx_batch_indices,
-                         value_t* idx_batch_data,
+                         const value_idx* idx_batch_indices,
+                         const value_t* idx_batch_data,
                          value_idx* query_batch_indptr,
-                         value_idx* query_batch_indices,
-                         value_t* query_batch_data,
+                         const value_idx* query_batch_indices,
+                         const value_t* query_batch_data,
                          value_t* batch_dists)
   {
     /**
@@ -395,17 +351,18 @@ class sparse_knn_t {
     dist_config.b_ncols = n_idx_cols;
     dist_config.b_nnz   = idx_batch_nnz;
 
+    // the batches are views of the inputs, which the distances only read
     dist_config.b_indptr  = idx_batch_indptr;
-    dist_config.b_indices = idx_batch_indices;
-    dist_config.b_data    = idx_batch_data;
+    dist_config.b_indices = const_cast<value_idx*>(idx_batch_indices);
+    dist_config.b_data    = const_cast<value_t*>(idx_batch_data);
 
     dist_config.a_nrows = query_batcher.batch_rows();
     dist_config.a_ncols = n_query_cols;
     dist_config.a_nnz   = query_batch_nnz;
 
     dist_config.a_indptr  = query_batch_indptr;
-    dist_config.a_indices = query_batch_indices;
-    dist_config.a_data    = query_batch_data;
+    dist_config.a_indices = const_cast<value_idx*>(query_batch_indices);
+    dist_config.a_data    = const_cast<value_t*>(query_batch_data);
 
     if (raft::sparse::distance::supportedDistance.find(metric) ==
         raft::sparse::distance::supportedDistance.end())
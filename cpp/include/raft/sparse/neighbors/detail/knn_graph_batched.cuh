@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/host_csr_matrix.hpp>
+#include <raft/core/host_mdspan.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/cuda_stream_pool.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/sparse/neighbors/detail/knn_graph.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <algorithm>
+#include <cstdint>
+
+namespace raft::sparse::neighbors::detail {
+
+/**
+ * The device buffers of one batch of the pipeline, and the events which tell when the neighbors
+ * of the batch are computed and when they are copied to the host.
+ */
+template <typename value_idx, typename value_t, typename T>
+struct knn_graph_batch_slot {
+  knn_graph_batch_slot(size_t batch_size, size_t dim, int k, rmm::cuda_stream_view stream)
+    : queries(batch_size * dim, stream),
+      neighbors(batch_size * k, stream),
+      indices(batch_size * k, stream),
+      distances(batch_size * k, stream)
+  {
+    RAFT_CUDA_TRY(cudaEventCreateWithFlags(&computed, cudaEventDisableTiming));
+    RAFT_CUDA_TRY(cudaEventCreateWithFlags(&copied, cudaEventDisableTiming));
+  }
+  ~knn_graph_batch_slot() noexcept
+  {
+    RAFT_CUDA_TRY_NO_THROW(cudaEventSynchronize(copied));
+    RAFT_CUDA_TRY_NO_THROW(cudaEventDestroy(computed));
+    RAFT_CUDA_TRY_NO_THROW(cudaEventDestroy(copied));
+  }
+  knn_graph_batch_slot(const knn_graph_batch_slot&)                    = delete;
+  knn_graph_batch_slot(knn_graph_batch_slot&&)                         = delete;
+  auto operator=(const knn_graph_batch_slot&) -> knn_graph_batch_slot& = delete;
+  auto operator=(knn_graph_batch_slot&&) -> knn_graph_batch_slot&      = delete;
+
+  rmm::device_uvector<T> queries;
+  rmm::device_uvector<int64_t> neighbors;
+  rmm::device_uvector<value_idx> indices;
+  rmm::device_uvector<value_t> distances;
+  cudaEvent_t computed;
+  cudaEvent_t copied;
+};
+
+/**
+ * Build the kNN graph batch by batch, with two batches in flight: the neighbors of a batch are
+ * copied to the host in a stream of the pool while the next batch is searched in the main stream.
+ * See raft::sparse::neighbors::knn_graph_batched for docs.
+ */
+template <typename value_idx, typename value_t, typename T, typename NeighborsT>
+void knn_graph_batched(raft::resources const& handle,
+                       raft::host_matrix_view<const T, int64_t, row_major> X,
+                       int k,
+                       NeighborsT& neighbors,
+                       raft::host_csr_matrix_view<value_t, int64_t, value_idx, int64_t> out,
+                       int64_t batch_size)
+{
+  const int64_t m   = X.extent(0);
+  const int64_t dim = X.extent(1);
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "knn_graph_batched(%zu, %zu, %d)", size_t(m), size_t(dim), k);
+  auto structure = out.structure_view();
+  RAFT_EXPECTS(k > 0, "k should be positive");
+  RAFT_EXPECTS(batch_size > 0, "batch_size should be positive");
+  RAFT_EXPECTS(structure.get_n_rows() == m && structure.get_nnz() == m * k,
+               "The output should have one row per sample and k non-zeros per row");
+
+  // every row holds exactly k neighbors: the offsets are known before the search
+  auto* indptr = structure.get_indptr().data();
+  for (int64_t i = 0; i <= m; i++) {
+    indptr[i] = i * k;
+  }
+  if (m == 0) { return; }
+
+  auto stream      = resource::get_cuda_stream(handle);
+  auto copy_stream = resource::get_next_usable_stream(handle);
+  batch_size       = std::min(batch_size, m);
+  knn_graph_batch_slot<value_idx, value_t, T> slots[2] = {
+    {size_t(batch_size), size_t(dim), k, stream}, {size_t(batch_size), size_t(dim), k, stream}};
+
+  auto* out_indices   = structure.get_indices().data();
+  auto* out_distances = out.get_elements().data();
+  for (int64_t row = 0, batch = 0; row < m; row += batch_size, batch++) {
+    const int64_t rows = std::min(batch_size, m - row);
+    auto& slot         = slots[batch % 2];
+    // the buffers of the slot are reused once the copy of the batch two steps back is done
+    if (batch >= 2) { RAFT_CUDA_TRY(cudaStreamWaitEvent(stream, slot.copied, 0)); }
+
+    raft::update_device(slot.queries.data(), X.data_handle() + row * dim, rows * dim, stream);
+    neighbors(handle,
+              raft::make_device_matrix_view<const T, int64_t>(slot.queries.data(), rows, dim),
+              raft::make_device_matrix_view<int64_t, int64_t>(slot.neighbors.data(), rows, k),
+              raft::make_device_matrix_view<value_t, int64_t>(slot.distances.data(), rows, k));
+    conv_indices(slot.neighbors.data(), slot.indices.data(), rows * k, stream);
+    RAFT_CUDA_TRY(cudaEventRecord(slot.computed, stream));
+
+    RAFT_CUDA_TRY(cudaStreamWaitEvent(copy_stream, slot.computed, 0));
+    raft::update_host(out_indices + row * k, slot.indices.data(), rows * k, copy_stream);
+    raft::update_host(out_distances + row * k, slot.distances.data(), rows * k, copy_stream);
+    RAFT_CUDA_TRY(cudaEventRecord(slot.copied, copy_stream));
+  }
+  resource::sync_stream(handle, copy_stream);
+}
+
+}  // namespace raft::sparse::neighbors::detail
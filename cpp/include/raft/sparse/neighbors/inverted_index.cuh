@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/resources.hpp>
+#include <raft/sparse/neighbors/detail/inverted_index.cuh>
+#include <raft/sparse/neighbors/inverted_index_types.hpp>
+
+namespace raft::sparse::neighbors::inverted_index {
+
+/**
+ * Build an inverted index of a sparse matrix, for the inner product search of sparse vectors
+ * with many features (e.g. learned sparse embeddings or BM25 weights over a vocabulary).
+ *
+ * @param[in] handle raft handle
+ * @param[in] indptr csr indptr of the index matrix (size n_rows + 1)
+ * @param[in] indices csr column indices array of the index matrix (size nnz)
+ * @param[in] data csr data array of the index matrix (size nnz)
+ * @param[in] nnz number of non-zeros of the index matrix
+ * @param[in] n_rows number of data samples (documents) in the index matrix
+ * @param[in] n_cols number of features (terms) in the index matrix
+ * @return the inverted index, with one posting list per feature
+ */
+template <typename value_idx = int, typename value_t = float>
+index<value_idx, value_t> build(raft::resources const& handle,
+                                const value_idx* indptr,
+                                const value_idx* indices,
+                                const value_t* data,
+                                value_idx nnz,
+                                value_idx n_rows,
+                                value_idx n_cols)
+{
+  return detail::build(handle, indptr, indices, data, nnz, n_rows, n_cols);
+}
+
+/**
+ * Search the k rows of the index with the largest inner products with a set of sparse queries.
+ *
+ * Unlike raft::sparse::neighbors::brute_force_knn, which computes the distances between the
+ * queries and all the rows of the index, the scores are accumulated term-at-a-time from the
+ * posting lists of the features of every query, so the cost is proportional to the number of
+ * postings touched by the queries rather than to the number of non-zeros of the index. The
+ * scores of a batch of queries are kept in a dense [batch_size_query, n_rows] buffer before the
+ * top k selection.
+ *
+ * @param[in] handle raft handle
+ * @param[in] idx the inverted index
+ * @param[in] queryIndptr csr indptr of the query matrix (size n_query_rows + 1)
+ * @param[in] queryIndices csr indices array of the query matrix
+ * @param[in] queryData csr data array of the query matrix
+ * @param[in] n_query_rows number of queries
+ * @param[out] output_indices dense matrix for output indices (size n_query_rows * k)
+ * @param[out] output_dists dense matrix for the output inner products, in decreasing order
+ *   (size n_query_rows * k)
+ * @param[in] k the number of neighbors to query
+ * @param[in] batch_size_query maximum number of queries scored at once; when 0, it is chosen
+ *   to keep the score buffer below 2^28 elements
+ * @param[in] max_postings_per_term when positive, only the postings with the largest weights of
+ *   every posting list are visited (approximate search, exact when 0)
+ */
+template <typename value_idx = int, typename value_t = float>
+void search(raft::resources const& handle,
+            const index<value_idx, value_t>& idx,
+            const value_idx* queryIndptr,
+            const value_idx* queryIndices,
+            const value_t* queryData,
+            value_idx n_query_rows,
+            value_idx* output_indices,
+            value_t* output_dists,
+            int k,
+            size_t batch_size_query         = 0,
+            value_idx max_postings_per_term = 0)
+{
+  detail::search(handle,
+                 idx,
+                 queryIndptr,
+                 queryIndices,
+                 queryData,
+                 n_query_rows,
+                 output_indices,
+                 output_dists,
+                 k,
+                 batch_size_query,
+                 max_postings_per_term);
+}
+
+}  // namespace raft::sparse::neighbors::inverted_index
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+namespace raft::sparse::neighbors::inverted_index {
+
+/**
+ * @brief An inverted index of a sparse matrix (one posting list per column).
+ *
+ * The postings are stored in CSC format: the posting list of the column (term) `j` holds the
+ * rows (documents) `rows[indptr[j]:indptr[j + 1]]` whose value in the column is not zero, along
+ * with the values `weights[indptr[j]:indptr[j + 1]]`. Within every posting list, the postings are
+ * sorted by decreasing weight, so the most significant ones come first.
+ *
+ * @tparam value_idx the type of the indices
+ * @tparam value_t the type of the values
+ */
+template <typename value_idx, typename value_t>
+struct index {
+  index(raft::resources const& handle, value_idx n_rows, value_idx n_cols, value_idx nnz)
+    : n_rows(n_rows),
+      n_cols(n_cols),
+      nnz(nnz),
+      indptr(n_cols + 1, resource::get_cuda_stream(handle)),
+      rows(nnz, resource::get_cuda_stream(handle)),
+      weights(nnz, resource::get_cuda_stream(handle))
+  {
+  }
+
+  /** Number of rows (documents) of the indexed matrix. */
+  value_idx n_rows;
+  /** Number of columns (terms) of the indexed matrix. */
+  value_idx n_cols;
+  /** Number of postings. */
+  value_idx nnz;
+  /** Offsets of the posting lists [n_cols + 1]. */
+  rmm::device_uvector<value_idx> indptr;
+  /** Row of every posting [nnz]. */
+  rmm::device_uvector<value_idx> rows;
+  /** Value of every posting [nnz]. */
+  rmm::device_uvector<value_t> weights;
+};
+
+}  // namespace raft::sparse::neighbors::inverted_index
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/host_csr_matrix.hpp>
+#include <raft/core/host_mdspan.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/neighbors/brute_force.cuh>
+#include <raft/neighbors/ivf_flat.cuh>
+#include <raft/neighbors/ivf_pq.cuh>
+#include <raft/sparse/neighbors/detail/knn_graph_batched.cuh>
+
+#include <cstdint>
+
+namespace raft::sparse::neighbors {
+
+/**
+ * @defgroup knn_graph_batched Batched kNN graph construction into host memory
+ * @{
+ */
+
+/** Neighbors of a batch of queries from a brute-force index (exact kNN graph). */
+template <typename T>
+struct brute_force_neighbors {
+  const raft::neighbors::brute_force::index<T>& index;
+
+  void operator()(raft::resources const& handle,
+                  raft::device_matrix_view<const T, int64_t, row_major> queries,
+                  raft::device_matrix_view<int64_t, int64_t, row_major> neighbors,
+                  raft::device_matrix_view<T, int64_t, row_major> distances) const
+  {
+    raft::neighbors::brute_force::search(handle, index, queries, neighbors, distances);
+  }
+};
+
+/** Neighbors of a batch of queries from an IVF-Flat index (approximate kNN graph). */
+template <typename T>
+struct ivf_flat_neighbors {
+  const raft::neighbors::ivf_flat::index<T, int64_t>& index;
+  raft::neighbors::ivf_flat::search_params params;
+
+  void operator()(raft::resources const& handle,
+                  raft::device_matrix_view<const T, int64_t, row_major> queries,
+                  raft::device_matrix_view<int64_t, int64_t, row_major> neighbors,
+                  raft::device_matrix_view<float, int64_t, row_major> distances) const
+  {
+    raft::neighbors::ivf_flat::search(handle, params, index, queries, neighbors, distances);
+  }
+};
+
+/** Neighbors of a batch of queries from an IVF-PQ index (approximate kNN graph). */
+template <typename T>
+struct ivf_pq_neighbors {
+  const raft::neighbors::ivf_pq::index<int64_t>& index;
+  raft::neighbors::ivf_pq::search_params params;
+
+  void operator()(raft::resources const& handle,
+                  raft::device_matrix_view<const T, int64_t, row_major> queries,
+                  raft::device_matrix_view<int64_t, int64_t, row_major> neighbors,
+                  raft::device_matrix_view<float, int64_t, row_major> distances) const
+  {
+    auto n_queries = uint32_t(queries.extent(0));
+    auto k         = uint32_t(neighbors.extent(1));
+    raft::neighbors::ivf_pq::search<T, int64_t>(
+      handle,
+      params,
+      index,
+      raft::make_device_matrix_view<const T, uint32_t>(
+        queries.data_handle(), n_queries, uint32_t(queries.extent(1))),
+      raft::make_device_matrix_view<int64_t, uint32_t>(neighbors.data_handle(), n_queries, k),
+      raft::make_device_matrix_view<float, uint32_t>(distances.data_handle(), n_queries, k));
+  }
+};
+
+/**
+ * @brief Construct the (directed) kNN graph of a dataset batch by batch into host memory.
+ *
+ * Unlike `knn_graph`, neither the dataset nor the graph has to fit in the device memory: the
+ * samples are copied to the device one batch at a time, and since every row of the graph holds
+ * exactly k neighbors, the neighbors of each batch are written straight to their final place in
+ * the output CSR. Two batches are in flight, so the device-to-host copies of a batch (in a stream
+ * of the stream pool of the handle, when there is one) overlap the search of the next one. The
+ * overlap requires the output arrays, and preferably X, to be in pinned host memory.
+ *
+ * The neighbors are given by a functor called on the batches of queries:
+ * @code{.cpp}
+ *   void operator()(raft::resources const& handle,
+ *                   raft::device_matrix_view<const T, int64_t, row_major> queries,
+ *                   raft::device_matrix_view<int64_t, int64_t, row_major> neighbors,
+ *                   raft::device_matrix_view<value_t, int64_t, row_major> distances);
+ * @endcode
+ * `brute_force_neighbors`, `ivf_flat_neighbors` and `ivf_pq_neighbors` wrap the searches of the
+ * corresponding indices, which should be built over X. Each sample is usually its own nearest
+ * neighbor. The graph is not symmetrized.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   auto index = raft::neighbors::ivf_pq::build(handle, index_params, dataset);
+ *   raft::sparse::neighbors::ivf_pq_neighbors<float> neighbors{index, search_params};
+ *   // indptr, indices and distances are pinned buffers of m + 1, m * k and m * k elements
+ *   auto structure = raft::make_host_compressed_structure_view<int64_t, int, int64_t>(
+ *     indptr, indices, m, m, m * k);
+ *   auto graph = raft::make_host_csr_matrix_view(distances, structure);
+ *   raft::sparse::neighbors::knn_graph_batched(handle, X, k, neighbors, graph);
+ * @endcode
+ *
+ * @tparam value_idx integer type of the column indices of the graph
+ * @tparam value_t type of the distances
+ * @tparam T type of the samples
+ * @tparam NeighborsT type of the neighbors functor
+ * @param[in] handle raft resources
+ * @param[in] X host row-major matrix of the samples [m, dim]
+ * @param[in] k number of neighbors of every sample
+ * @param[in] neighbors the functor computing the neighbors of a batch of samples
+ * @param[out] out host CSR matrix of the graph [m, m] with m * k non-zeros: the indptr, the
+ *   neighbors (in increasing order of distance) and their distances are all written here
+ * @param[in] batch_size number of samples searched at once
+ */
+template <typename value_idx, typename value_t, typename T, typename NeighborsT>
+void knn_graph_batched(raft::resources const& handle,
+                       raft::host_matrix_view<const T, int64_t, row_major> X,
+                       int k,
+                       NeighborsT neighbors,
+                       raft::host_csr_matrix_view<value_t, int64_t, value_idx, int64_t> out,
+                       int64_t batch_size = 65536)
+{
+  detail::knn_graph_batched(handle, X, k, neighbors, out, batch_size);
+}
+
+/** @} */  // end group knn_graph_batched
+
+};  // namespace raft::sparse::neighbors
@@ -0,0 +1,306 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/util/cuda_dev_essentials.cuh>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+#include <raft/util/device_atomics.cuh>
+
+#include <rmm/device_uvector.hpp>
+
+#include <thrust/fill.h>
+#include <thrust/find.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/reverse.h>
+#include <thrust/scan.h>
+#include <thrust/scatter.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
+
+#include <cub/cub.cuh>
+
+#include <algorithm>
+#include <limits>
+
+namespace raft {
+namespace sparse {
+namespace op {
+namespace detail {
+
+/** Orders the vertices by increasing degree, the ties being broken by the vertex id. */
+template <typename value_idx, typename nnz_t>
+struct rcm_degree_less {
+  const nnz_t* indptr;
+
+  __device__ bool operator()(value_idx a, value_idx b) const
+  {
+    nnz_t da = indptr[a + 1] - indptr[a];
+    nnz_t db = indptr[b + 1] - indptr[b];
+    return da != db ? da < db : a < b;
+  }
+};
+
+/**
+ * Orders the vertices of a BFS level by the position of their parent in the ordering (the first
+ * visited vertex of the previous level which is adjacent to them), then by degree.
+ */
+template <typename value_idx, typename nnz_t>
+struct rcm_level_less {
+  const value_idx* parent;
+  rcm_degree_less<value_idx, nnz_t> by_degree;
+
+  __device__ bool operator()(value_idx a, value_idx b) const
+  {
+    return parent[a] != parent[b] ? parent[a] < parent[b] : by_degree(a, b);
+  }
+};
+
+template <typename value_idx>
+struct rcm_unvisited_op {
+  const value_idx* parent;
+
+  __device__ bool operator()(value_idx v) const
+  {
+    return parent[v] == std::numeric_limits<value_idx>::max();
+  }
+};
+
+/**
+ * Expands the BFS level order[begin, end): one warp per vertex of the level walks its neighbors.
+ * The first warp to reach an unvisited vertex appends it to the next level; the parent of every
+ * vertex of the next level ends up being the smallest position of its neighbors in the level.
+ */
+template <int TPB, typename value_idx, typename nnz_t>
+__global__ void rcm_expand_level_kernel(const nnz_t* indptr,
+                                        const value_idx* indices,
+                                        value_idx* order,
+                                        value_idx begin,
+                                        value_idx end,
+                                        value_idx* parent,
+                                        value_idx* n_next)
+{
+  constexpr value_idx kUnvisited = std::numeric_limits<value_idx>::max();
+
+  const int lane = threadIdx.x % raft::WarpSize;
+  value_idx pos  = begin + (blockIdx.x * (TPB / raft::WarpSize) + threadIdx.x / raft::WarpSize);
+  if (pos >= end) return;
+
+  value_idx v = order[pos];
+  for (nnz_t p = indptr[v] + lane; p < indptr[v + 1]; p += raft::WarpSize) {
+    value_idx u   = indices[p];
+    value_idx old = atomicCAS(parent + u, kUnvisited, pos);
+    if (old == kUnvisited) {
+      order[end + atomicAdd(n_next, value_idx(1))] = u;
+    } else if (old > pos) {
+      atomicMin(parent + u, pos);
+    }
+  }
+}
+
+/**
+ * Reverse Cuthill-McKee ordering computed by a level-synchronous BFS. Every connected component
+ * is started from its unvisited vertex of minimum degree, and every level is sorted as in the
+ * sequential algorithm, so the ordering does not depend on the scheduling of the kernels.
+ */
+template <typename value_idx, typename nnz_t>
+void reverse_cuthill_mckee(raft::resources const& handle,
+                           const nnz_t* indptr,
+                           const value_idx* indices,
+                           value_idx n,
+                           value_idx* perm)
+{
+  if (n == 0) return;
+  auto stream = resource::get_cuda_stream(handle);
+  auto policy = resource::get_thrust_policy(handle);
+  auto mr     = resource::get_workspace_resource(handle);
+
+  rmm::device_uvector<value_idx> parent(n, stream, mr);
+  rmm::device_uvector<value_idx> by_degree(n, stream, mr);
+  rmm::device_uvector<value_idx> n_next(1, stream, mr);
+  thrust::fill(policy, parent.begin(), parent.end(), std::numeric_limits<value_idx>::max());
+  thrust::sequence(policy, by_degree.begin(), by_degree.end());
+  thrust::sort(policy,
+               by_degree.begin(),
+               by_degree.end(),
+               rcm_degree_less<value_idx, nnz_t>{indptr});
+
+  constexpr int TPB    = 256;
+  constexpr int kWarps = TPB / raft::WarpSize;
+  value_idx end        = 0;
+  value_idx cursor     = 0;
+  while (end < n) {
+    // the vertices before the cursor are all visited: the search for the next start is linear
+    auto start_it = thrust::find_if(policy,
+                                    by_degree.data() + cursor,
+                                    by_degree.data() + n,
+                                    rcm_unvisited_op<value_idx>{parent.data()});
+    cursor = static_cast<value_idx>(start_it - by_degree.data());
+    value_idx start;
+    raft::update_host(&start, by_degree.data() + cursor, 1, stream);
+    raft::copy(perm + end, by_degree.data() + cursor, 1, stream);
+    resource::sync_stream(handle, stream);
+    raft::update_device(parent.data() + start, &end, 1, stream);
+
+    value_idx begin = end++;
+    while (begin < end) {
+      RAFT_CUDA_TRY(cudaMemsetAsync(n_next.data(), 0, sizeof(value_idx), stream));
+      auto n_blocks = raft::ceildiv<value_idx>(end - begin, kWarps);
+      rcm_expand_level_kernel<TPB><<<n_blocks, TPB, 0, stream>>>(
+        indptr, indices, perm, begin, end, parent.data(), n_next.data());
+      RAFT_CUDA_TRY(cudaPeekAtLastError());
+      value_idx next;
+      raft::update_host(&next, n_next.data(), 1, stream);
+      resource::sync_stream(handle, stream);
+      if (next > 1) {
+        thrust::sort(policy,
+                     perm + end,
+                     perm + end + next,
+                     rcm_level_less<value_idx, nnz_t>{parent.data(), {indptr}});
+      }
+      begin = end;
+      end += next;
+    }
+  }
+  thrust::reverse(policy, perm, perm + n);
+}
+
+template <typename value_idx, typename nnz_t>
+struct permuted_row_length_op {
+  const nnz_t* indptr;
+  const value_idx* perm;
+
+  __device__ nnz_t operator()(value_idx r) const { return indptr[perm[r] + 1] - indptr[perm[r]]; }
+};
+
+/** Copies the rows of A in the new order, one warp per output row, relabeling the columns. */
+template <int TPB, typename value_idx, typename value_t, typename nnz_t>
+__global__ void csr_permute_rows_kernel(const nnz_t* indptr,
+                                        const value_idx* indices,
+                                        const value_t* data,
+                                        value_idx n,
+                                        const value_idx* perm,
+                                        const value_idx* iperm,
+                                        const nnz_t* out_indptr,
+                                        value_idx* out_indices,
+                                        value_t* out_data)
+{
+  const int lane = threadIdx.x % raft::WarpSize;
+  value_idx r    = blockIdx.x * (TPB / raft::WarpSize) + threadIdx.x / raft::WarpSize;
+  if (r >= n) return;
+
+  nnz_t in_start  = indptr[perm[r]];
+  nnz_t out_start = out_indptr[r];
+  nnz_t len       = out_indptr[r + 1] - out_start;
+  for (nnz_t i = lane; i < len; i += raft::WarpSize) {
+    out_indices[out_start + i] = iperm[indices[in_start + i]];
+    out_data[out_start + i]    = data[in_start + i];
+  }
+}
+
+/**
+ * Symmetric permutation B = P A P^T of a square CSR matrix, with B[i, j] = A[perm[i], perm[j]].
+ * The rows are gathered in the new order and the relabeled columns are sorted within every row.
+ * `out_indptr` must hold n + 1 elements and the other outputs the nnz of A.
+ */
+template <typename value_idx, typename value_t, typename nnz_t>
+void csr_symmetric_permute(raft::resources const& handle,
+                           const nnz_t* indptr,
+                           const value_idx* indices,
+                           const value_t* data,
+                           value_idx n,
+                           nnz_t nnz,
+                           const value_idx* perm,
+                           nnz_t* out_indptr,
+                           value_idx* out_indices,
+                           value_t* out_data)
+{
+  auto stream = resource::get_cuda_stream(handle);
+  auto policy = resource::get_thrust_policy(handle);
+  auto mr     = resource::get_workspace_resource(handle);
+
+  RAFT_CUDA_TRY(cudaMemsetAsync(out_indptr, 0, sizeof(nnz_t), stream));
+  if (n == 0) return;
+
+  rmm::device_uvector<value_idx> iperm(n, stream, mr);
+  thrust::scatter(policy,
+                  thrust::make_counting_iterator<value_idx>(0),
+                  thrust::make_counting_iterator<value_idx>(n),
+                  perm,
+                  iperm.data());
+  thrust::transform_inclusive_scan(policy,
+                                   thrust::make_counting_iterator<value_idx>(0),
+                                   thrust::make_counting_iterator<value_idx>(n),
+                                   out_indptr + 1,
+                                   permuted_row_length_op<value_idx, nnz_t>{indptr, perm},
+                                   thrust::plus<nnz_t>());
+  if (nnz == 0) return;
+
+  rmm::device_uvector<value_idx> unsorted_indices(nnz, stream, mr);
+  rmm::device_uvector<value_t> unsorted_data(nnz, stream, mr);
+  constexpr int TPB    = 256;
+  constexpr int kWarps = TPB / raft::WarpSize;
+  csr_permute_rows_kernel<TPB><<<raft::ceildiv<value_idx>(n, kWarps), TPB, 0, stream>>>(
+    indptr,
+    indices,
+    data,
+    n,
+    perm,
+    iperm.data(),
+    out_indptr,
+    unsorted_indices.data(),
+    unsorted_data.data());
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+  size_t workspace_size = 0;
+  RAFT_CUDA_TRY(cub::DeviceSegmentedRadixSort::SortPairs(nullptr,
+                                                         workspace_size,
+                                                         unsorted_indices.data(),
+                                                         out_indices,
+                                                         unsorted_data.data(),
+                                                         out_data,
+                                                         nnz,
+                                                         n,
+                                                         out_indptr,
+                                                         out_indptr + 1,
+                                                         0,
+                                                         sizeof(value_idx) * 8,
+                                                         stream));
+  rmm::device_uvector<char> workspace(workspace_size, stream, mr);
+  RAFT_CUDA_TRY(cub::DeviceSegmentedRadixSort::SortPairs(workspace.data(),
+                                                         workspace_size,
+                                                         unsorted_indices.data(),
+                                                         out_indices,
+                                                         unsorted_data.data(),
+                                                         out_data,
+                                                         nnz,
+                                                         n,
+                                                         out_indptr,
+                                                         out_indptr + 1,
+                                                         0,
+                                                         sizeof(value_idx) * 8,
+                                                         stream));
+}
+
+};  // namespace detail
+};  // namespace op
+};  // namespace sparse
+};  // namespace raft
@@ -19,19 +19,27 @@
 #include <cusparse_v2.h>
 
 #include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
 #include <raft/linalg/unary_op.cuh>
 #include <raft/sparse/detail/cusparse_wrappers.h>
 #include <raft/util/cuda_utils.cuh>
 #include <raft/util/cudart_utils.hpp>
 
+#include <rmm/device_uvector.hpp>
+
 #include <thrust/device_ptr.h>
+#include <thrust/iterator/counting_iterator.h>
 #include <thrust/scan.h>
+#include <thrust/transform.h>
 
 #include <cuda_runtime.h>
 #include <stdio.h>
 
 #include <algorithm>
 #include <iostream>
+#include <vector>
 
 #include <raft/sparse/detail/utils.h>
 
@@ -103,6 +111,99 @@ void csr_row_slice_populate(value_idx start_offset,
   raft::copy(data_out, data + start_offset, stop_offset - start_offset, stream);
 }
 
+template <typename value_idx>
+struct batch_boundary_offset_op {
+  const value_idx* indptr;
+  value_idx n_rows;
+  value_idx batch_size;
+
+  __device__ value_idx operator()(value_idx batch) const
+  {
+    value_idx row = batch * batch_size;
+    return indptr[row < n_rows ? row : n_rows];
+  }
+};
+
+/**
+ * The partition of the rows of a CSR matrix into consecutive batches, planned once from its
+ * indptr: the offsets of the boundaries of all the batches are read to the host with a single
+ * synchronization. The columns and the values of a batch are then plain offset views of the
+ * arrays of the matrix, and only its indptr has to be rebased, into a buffer of
+ * `max_batch_rows() + 1` elements which can be reused by all the batches.
+ */
+template <typename value_idx>
+class csr_row_batches {
+ public:
+  csr_row_batches(raft::resources const& handle,
+                  const value_idx* indptr,
+                  value_idx n_rows,
+                  value_idx batch_size)
+    : indptr_(indptr), n_rows_(n_rows), batch_size_(batch_size)
+  {
+    RAFT_EXPECTS(batch_size > 0, "batch_size should be positive");
+    auto stream       = resource::get_cuda_stream(handle);
+    value_idx n_bound = raft::ceildiv(n_rows, batch_size) + 1;
+    rmm::device_uvector<value_idx> offsets(n_bound, stream);
+    auto first = thrust::make_counting_iterator<value_idx>(0);
+    thrust::transform(resource::get_thrust_policy(handle),
+                      first,
+                      first + n_bound,
+                      offsets.data(),
+                      batch_boundary_offset_op<value_idx>{indptr, n_rows, batch_size});
+    offsets_.resize(n_bound);
+    raft::update_host(offsets_.data(), offsets.data(), n_bound, stream);
+    RAFT_CUDA_TRY(cudaStreamSynchronize(stream));
+  }
+
+  value_idx n_batches() const { return offsets_.size() - 1; }
+
+  value_idx batch_start(value_idx batch) const { return batch * batch_size_; }
+
+  value_idx batch_rows(value_idx batch) const
+  {
+    return std::min(batch_size_, n_rows_ - batch_start(batch));
+  }
+
+  value_idx max_batch_rows() const { return std::min(batch_size_, n_rows_); }
+
+  /** Offset of the first non-zero of the batch in the arrays of the matrix */
+  value_idx batch_offset(value_idx batch) const { return offsets_[batch]; }
+
+  value_idx batch_nnz(value_idx batch) const { return offsets_[batch + 1] - offsets_[batch]; }
+
+  value_idx max_batch_nnz() const
+  {
+    value_idx nnz = 0;
+    for (value_idx b = 0; b < n_batches(); b++) {
+      nnz = std::max(nnz, batch_nnz(b));
+    }
+    return nnz;
+  }
+
+  /** Write the indptr of the batch, relative to its first non-zero; no synchronization. */
+  void batch_indptr(value_idx batch, value_idx* indptr_out, cudaStream_t stream) const
+  {
+    raft::linalg::unaryOp<value_idx>(indptr_out,
+                                     indptr_ + batch_start(batch),
+                                     batch_rows(batch) + 1,
+                                     raft::sub_const_op<value_idx>(batch_offset(batch)),
+                                     stream);
+  }
+
+  /** View of the column indices (or the values) of the batch within the arrays of the matrix */
+  template <typename T>
+  T* batch_view(value_idx batch, T* arr) const
+  {
+    return arr + batch_offset(batch);
+  }
+
+ private:
+  const value_idx* indptr_;
+  value_idx n_rows_;
+  value_idx batch_size_;
+  std::vector<value_idx> offsets_;
+};
+
 };  // namespace detail
 };  // namespace op
 };  // end NAMESPACE sparse
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef __REORDER_H
+#define __REORDER_H
+
+#pragma once
+
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/sparse/op/detail/reorder.cuh>
+
+namespace raft {
+namespace sparse {
+namespace op {
+
+/**
+ * @brief Compute the reverse Cuthill-McKee (RCM) ordering of a sparse matrix.
+ *
+ * The ordering reduces the bandwidth of the matrix, which keeps the vectors read by a SpMV or a
+ * SpMM on the permuted matrix in cache. The matrix must be square and structurally symmetric
+ * (e.g. an undirected graph, or A + A^T); the values are not read. Each connected component is
+ * ordered by a breadth-first search from its vertex of minimum degree.
+ *
+ * The ordering is applied to the matrix with `csr_symmetric_permute`. A vector x is moved to the
+ * new ordering by gathering x[perm[i]] and a result y' is moved back by scattering y[perm[i]] =
+ * y'[i], e.g. with `thrust::gather` and `thrust::scatter`.
+ *
+ * @tparam value_t type of the values of the matrix
+ * @tparam value_idx integer type of the rows and columns
+ * @tparam nnz_t integer type of the number of non-zeros
+ * @param[in] handle raft::resources
+ * @param[in] A square, structurally symmetric CSR matrix
+ * @param[out] perm the ordering: perm[i] is the row of A placed at row i [n_rows]
+ */
+template <typename value_t, typename value_idx, typename nnz_t>
+void reverse_cuthill_mckee(
+  raft::resources const& handle,
+  raft::device_csr_matrix_view<const value_t, value_idx, value_idx, nnz_t> A,
+  raft::device_vector_view<value_idx, value_idx> perm)
+{
+  auto structure = A.structure_view();
+  RAFT_EXPECTS(structure.get_n_rows() == structure.get_n_cols(), "The matrix should be square");
+  RAFT_EXPECTS(perm.extent(0) == structure.get_n_rows(),
+               "The permutation should have one entry per row");
+  detail::reverse_cuthill_mckee(handle,
+                                structure.get_indptr().data(),
+                                structure.get_indices().data(),
+                                structure.get_n_rows(),
+                                perm.data_handle());
+}
+
+/**
+ * @brief Permute the rows and the columns of a square sparse matrix: B = P A P^T.
+ *
+ * B[i, j] = A[perm[i], perm[j]], and the columns of every row of B are sorted.
+ *
+ * @tparam value_t type of the values of the matrix
+ * @tparam value_idx integer type of the rows and columns
+ * @tparam nnz_t integer type of the number of non-zeros
+ * @param[in] handle raft::resources
+ * @param[in] A square CSR matrix
+ * @param[in] perm the ordering, e.g. from `reverse_cuthill_mckee` [n_rows]
+ * @param[out] out the permuted matrix, created with the shape of A; its sparsity is initialized
+ *   here
+ */
+template <typename value_t, typename value_idx, typename nnz_t>
+void csr_symmetric_permute(
+  raft::resources const& handle,
+  raft::device_csr_matrix_view<const value_t, value_idx, value_idx, nnz_t> A,
+  raft::device_vector_view<const value_idx, value_idx> perm,
+  raft::device_csr_matrix<value_t, value_idx, value_idx, nnz_t>& out)
+{
+  auto structure = A.structure_view();
+  RAFT_EXPECTS(structure.get_n_rows() == structure.get_n_cols(), "The matrix should be square");
+  RAFT_EXPECTS(perm.extent(0) == structure.get_n_rows(),
+               "The permutation should have one entry per row");
+  RAFT_EXPECTS(out.structure_view().get_n_rows() == structure.get_n_rows() &&
+                 out.structure_view().get_n_cols() == structure.get_n_cols(),
+               "The output should have the shape of the input");
+  out.initialize_sparsity(structure.get_nnz());
+  auto out_structure = out.structure_view();
+  detail::csr_symmetric_permute(handle,
+                                structure.get_indptr().data(),
+                                structure.get_indices().data(),
+                                A.get_elements().data(),
+                                structure.get_n_rows(),
+                                structure.get_nnz(),
+                                perm.data_handle(),
+                                out_structure.get_indptr().data(),
+                                out_structure.get_indices().data(),
+                                out.get_elements().data());
+}
+
+};  // end NAMESPACE op
+};  // end NAMESPACE sparse
+};  // end NAMESPACE raft
+
+#endif
@@ -74,6 +74,32 @@ void csr_row_slice_populate(value_idx start_offset,
     start_offset, stop_offset, indices, data, indices_out, data_out, stream);
 }
 
+/**
+ * @brief Plan of the slicing of the rows of a CSR matrix into consecutive batches.
+ *
+ * Unlike `csr_row_slice_indptr`, which synchronizes on every slice to read its offsets, the plan
+ * reads the offsets of all the batches up front with a single synchronization. The column
+ * indices and the values of a batch are zero-copy offset views of the input arrays, and its
+ * rebased indptr is written into a caller-owned workspace of `max_batch_rows() + 1` elements,
+ * which can be reused across the batches.
+ *
+ * Usage example:
+ * @code{.cpp}
+ *   raft::sparse::op::csr_row_batches<int> batches(handle, indptr, n_rows, batch_size);
+ *   rmm::device_uvector<int> batch_indptr(batches.max_batch_rows() + 1, stream);
+ *   for (int b = 0; b < batches.n_batches(); b++) {
+ *     batches.batch_indptr(b, batch_indptr.data(), stream);
+ *     const int* batch_indices  = batches.batch_view(b, indices);
+ *     const float* batch_values = batches.batch_view(b, data);
+ *     // batches.batch_rows(b) rows with batches.batch_nnz(b) non-zeros
+ *   }
+ * @endcode
+ *
+ * @tparam value_idx : data type of CSR index arrays
+ */
+template <typename value_idx>
+using csr_row_batches = detail::csr_row_batches<value_idx>;
+
 };  // namespace op
 };  // end NAMESPACE sparse
 };  // end NAMESPACE raft
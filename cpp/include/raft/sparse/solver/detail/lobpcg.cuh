@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/linalg/eig.cuh>
+#include <raft/linalg/gemm.cuh>
+#include <raft/linalg/multiply.cuh>
+#include <raft/linalg/norm.cuh>
+#include <raft/linalg/qr.cuh>
+#include <raft/random/rng.cuh>
+#include <raft/spectral/matrix_wrappers.hpp>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace raft::sparse::solver::detail {
+
+// the residual norms are copied to the host every few iterations only
+static constexpr int kLobpcgCheckInterval = 4;
+
+/** R = AX - X * diag(theta), for the column-major n x m blocks X and AX. */
+template <typename value_type_t>
+__global__ void lobpcg_residual_kernel(size_t n,
+                                       size_t len,
+                                       const value_type_t* __restrict__ X,
+                                       const value_type_t* __restrict__ AX,
+                                       const value_type_t* __restrict__ theta,
+                                       value_type_t* __restrict__ R)
+{
+  for (size_t i = threadIdx.x + static_cast<size_t>(blockIdx.x) * blockDim.x; i < len;
+       i += static_cast<size_t>(blockDim.x) * gridDim.x) {
+    R[i] = AX[i] - X[i] * theta[i / n];
+  }
+}
+
+/**
+ *  @brief  Compute the extreme eigenpairs of a symmetric matrix with the locally optimal block
+ *    preconditioned conjugate gradient method (LOBPCG), without preconditioner.
+ *
+ *    Each iteration applies the matrix to the whole block [X, R, P] (the current eigenvector
+ *    estimates, their residuals and the previous search directions) with one SpMM, and solves the
+ *    Rayleigh-Ritz problem of the 3*blockSize subspace on the GPU: the block is orthonormalized by
+ *    a QR decomposition and the small projected matrix is decomposed by eigDC. The host only reads
+ *    the residual norms every few iterations to test the convergence.
+ *
+ *  @tparam index_type_t the type of data used for indexing.
+ *  @tparam value_type_t the type of data used for weights, distances.
+ *  @param handle the raft handle.
+ *  @param A Matrix.
+ *  @param nEigVecs Number of eigenvectors to compute.
+ *  @param blockSize Number of vectors of the block, at least nEigVecs; the extra vectors speed up
+ *    the convergence of the last wanted eigenpairs. 3*blockSize must not exceed the matrix size.
+ *  @param maxIter Maximum number of iterations.
+ *  @param tol Convergence tolerance. The iteration terminates when the residual norm of every
+ *    wanted eigenpair is less than tol times the largest Ritz value of the subspace, in magnitude.
+ *  @param largest Whether to compute the largest (instead of the smallest) eigenpairs.
+ *  @param iter On exit, number of iterations performed.
+ *  @param eigVals_dev (Output, device memory, nEigVecs entries) Eigenvalues, sorted in ascending
+ *    order for the smallest eigenpairs and in descending order for the largest ones.
+ *  @param eigVecs_dev (Output, device memory, n*nEigVecs entries) Eigenvectors, stored as columns
+ *    of a column-major matrix with dimensions n x nEigVecs.
+ *  @param seed random seed of the initial block.
+ *  @return error flag.
+ */
+template <typename index_type_t, typename value_type_t>
+int lobpcgEigenvectors(raft::resources const& handle,
+                       spectral::matrix::sparse_matrix_t<index_type_t, value_type_t> const& A,
+                       index_type_t nEigVecs,
+                       index_type_t blockSize,
+                       index_type_t maxIter,
+                       value_type_t tol,
+                       bool largest,
+                       index_type_t& iter,
+                       value_type_t* __restrict__ eigVals_dev,
+                       value_type_t* __restrict__ eigVecs_dev,
+                       unsigned long long seed)
+{
+  index_type_t n = A.nrows_;
+  index_type_t m = std::max(blockSize, nEigVecs);
+  RAFT_EXPECTS(nEigVecs > 0 && nEigVecs <= n, "Invalid number of eigenvectors.");
+  RAFT_EXPECTS(3 * m <= n, "The block is too large for the size of the matrix.");
+  RAFT_EXPECTS(tol > 0, "Invalid tolerance.");
+  RAFT_EXPECTS(maxIter > 0, "Invalid maxIter.");
+
+  auto stream = resource::get_cuda_stream(handle);
+  size_t nm   = static_cast<size_t>(n) * m;
+  // the product with -A gives the largest eigenpairs of A from the smallest ones of -A
+  value_type_t sign = largest ? value_type_t(-1) : value_type_t(1);
+  value_type_t one  = 1;
+  value_type_t zero = 0;
+
+  // S = [X, R, P] and its orthonormal basis Q, column-major, n x 3m
+  rmm::device_uvector<value_type_t> S(3 * nm, stream);
+  rmm::device_uvector<value_type_t> Q(3 * nm, stream);
+  rmm::device_uvector<value_type_t> AQ(3 * nm, stream);
+  rmm::device_uvector<value_type_t> AX(nm, stream);
+  rmm::device_uvector<value_type_t> G(9 * m * m, stream);
+  rmm::device_uvector<value_type_t> C(9 * m * m, stream);
+  rmm::device_uvector<value_type_t> theta(3 * m, stream);
+  rmm::device_uvector<value_type_t> res_norms(m, stream);
+  std::vector<value_type_t> theta_h(3 * m), res_norms_h(m);
+
+  value_type_t* X = S.data();
+  value_type_t* R = S.data() + nm;
+  value_type_t* P = S.data() + 2 * nm;
+
+  raft::random::RngState rng(seed);
+  raft::random::normal(handle, rng, X, nm, value_type_t(0), value_type_t(1));
+
+  // the first Rayleigh-Ritz step works on X only, the second one on [X, R]
+  index_type_t w = m;
+  iter           = 0;
+  while (true) {
+    // Rayleigh-Ritz on the span of S
+    raft::linalg::qrGetQ(handle, S.data(), Q.data(), n, w, stream);
+    A.mm(sign, Q.data(), w, zero, AQ.data());
+    raft::linalg::gemm(
+      handle, true, false, w, w, n, &one, Q.data(), n, AQ.data(), n, &zero, G.data(), w, stream);
+    raft::linalg::eigDC(handle, G.data(), w, w, C.data(), theta.data(), stream);
+
+    // X = Q * C[:, :m], AX = AQ * C[:, :m], P = Q[:, m:] * C[m:, :m]
+    raft::linalg::gemm(
+      handle, false, false, n, m, w, &one, Q.data(), n, C.data(), w, &zero, X, n, stream);
+    raft::linalg::gemm(
+      handle, false, false, n, m, w, &one, AQ.data(), n, C.data(), w, &zero, AX.data(), n, stream);
+    if (w > m) {
+      raft::linalg::gemm(handle,
+                         false,
+                         false,
+                         n,
+                         m,
+                         w - m,
+                         &one,
+                         Q.data() + static_cast<size_t>(m) * n,
+                         n,
+                         C.data() + m,
+                         w,
+                         &zero,
+                         P,
+                         n,
+                         stream);
+    }
+
+    constexpr int TPB = 256;
+    auto n_blocks     = std::min<size_t>(raft::ceildiv<size_t>(nm, TPB), 65535);
+    lobpcg_residual_kernel<<<n_blocks, TPB, 0, stream>>>(
+      size_t(n), nm, X, AX.data(), theta.data(), R);
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+    bool last = iter + 1 >= maxIter;
+    if (w > m && (iter % kLobpcgCheckInterval == 0 || last)) {
+      raft::linalg::rowNorm(
+        res_norms.data(), R, n, m, raft::linalg::L2Norm, true, stream, raft::sqrt_op{});
+      raft::update_host(theta_h.data(), theta.data(), w, stream);
+      raft::update_host(res_norms_h.data(), res_norms.data(), m, stream);
+      resource::sync_stream(handle, stream);
+      value_type_t scale = 0;
+      for (index_type_t j = 0; j < w; ++j) {
+        scale = std::max(scale, std::abs(theta_h[j]));
+      }
+      bool converged = true;
+      for (index_type_t j = 0; j < nEigVecs; ++j) {
+        converged = converged && res_norms_h[j] <= tol * scale;
+      }
+      if (converged) { break; }
+    }
+    iter++;
+    if (iter >= maxIter) { break; }
+    w = w == m ? 2 * m : 3 * m;
+  }
+
+  // the first columns of X hold the wanted eigenvectors
+  raft::copy(eigVecs_dev, X, static_cast<size_t>(n) * nEigVecs, stream);
+  raft::linalg::multiplyScalar(eigVals_dev, theta.data(), sign, nEigVecs, stream);
+  return 0;
+}
+
+}  // namespace raft::sparse::solver::detail
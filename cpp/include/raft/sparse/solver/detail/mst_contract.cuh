@@ -0,0 +1,529 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/sparse/solver/mst_solver.cuh>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+#include <raft/util/device_atomics.cuh>
+
+#include <rmm/device_uvector.hpp>
+
+#include <thrust/copy.h>
+#include <thrust/count.h>
+#include <thrust/fill.h>
+#include <thrust/functional.h>
+#include <thrust/gather.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
+#include <thrust/remove.h>
+#include <thrust/scan.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
+#include <thrust/transform.h>
+#include <thrust/tuple.h>
+#include <thrust/unique.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace raft::sparse::solver::detail {
+
+static constexpr int kBoruvkaTPB = 256;
+
+template <typename idx_t>
+inline auto boruvka_blocks(idx_t n) -> idx_t
+{
+  return std::max<idx_t>(1, std::min<idx_t>(raft::ceildiv<idx_t>(n, kBoruvkaTPB), 65535));
+}
+
+/** Minimum weight of the edges incident to every supervertex. */
+template <typename vertex_t, typename edge_t, typename weight_t>
+__global__ void boruvka_min_weight_kernel(
+  const vertex_t* src, const vertex_t* dst, const weight_t* w, edge_t n_edges, weight_t* best_w)
+{
+  for (edge_t i = blockIdx.x * blockDim.x + threadIdx.x; i < n_edges; i += blockDim.x * gridDim.x) {
+    atomicMin(best_w + src[i], w[i]);
+    atomicMin(best_w + dst[i], w[i]);
+  }
+}
+
+/**
+ * Position of the lightest edge incident to every supervertex. The ties are broken by the position
+ * in the edge list, so that the edges are totally ordered and the chosen edges form no cycle
+ * longer than a pair of supervertices choosing the same edge.
+ */
+template <typename vertex_t, typename edge_t, typename weight_t>
+__global__ void boruvka_min_edge_kernel(const vertex_t* src,
+                                        const vertex_t* dst,
+                                        const weight_t* w,
+                                        edge_t n_edges,
+                                        const weight_t* best_w,
+                                        edge_t* best_e)
+{
+  for (edge_t i = blockIdx.x * blockDim.x + threadIdx.x; i < n_edges; i += blockDim.x * gridDim.x) {
+    if (w[i] == best_w[src[i]]) { atomicMin(best_e + src[i], i); }
+    if (w[i] == best_w[dst[i]]) { atomicMin(best_e + dst[i], i); }
+  }
+}
+
+/**
+ * Hook every supervertex to the other end of its lightest edge and flag the edge as part of the
+ * MST. Of two supervertices choosing the same edge, the smaller one becomes the root.
+ */
+template <typename vertex_t, typename edge_t>
+__global__ void boruvka_hook_kernel(const vertex_t* src,
+                                    const vertex_t* dst,
+                                    const edge_t* ids,
+                                    vertex_t n_vertices,
+                                    const edge_t* best_e,
+                                    vertex_t* parent,
+                                    bool* in_mst)
+{
+  for (vertex_t c = blockIdx.x * blockDim.x + threadIdx.x; c < n_vertices;
+       c += blockDim.x * gridDim.x) {
+    edge_t p = best_e[c];
+    if (p == std::numeric_limits<edge_t>::max()) {
+      parent[c] = c;
+      continue;
+    }
+    vertex_t other = src[p] == c ? dst[p] : src[p];
+    in_mst[ids[p]] = true;
+    parent[c]      = best_e[other] == p && c < other ? c : other;
+  }
+}
+
+/** Point every supervertex to the root of its tree. */
+template <typename vertex_t>
+__global__ void boruvka_jump_kernel(vertex_t* parent, vertex_t n_vertices)
+{
+  for (vertex_t c = blockIdx.x * blockDim.x + threadIdx.x; c < n_vertices;
+       c += blockDim.x * gridDim.x) {
+    vertex_t p  = parent[c];
+    vertex_t gp = parent[p];
+    while (p != gp) {
+      parent[c] = gp;
+      p         = gp;
+      gp        = parent[p];
+    }
+  }
+}
+
+template <typename vertex_t>
+struct boruvka_is_root_op {
+  const vertex_t* parent;
+
+  __device__ vertex_t operator()(vertex_t c) const { return parent[c] == c ? 1 : 0; }
+};
+
+/** Label of the supervertex which absorbs c: the rank of its root among the roots. */
+template <typename vertex_t>
+struct boruvka_relabel_op {
+  const vertex_t* parent;
+  const vertex_t* rank;
+
+  __device__ vertex_t operator()(vertex_t c) const { return rank[parent[c]] - 1; }
+};
+
+template <typename vertex_t>
+struct boruvka_label_op {
+  const vertex_t* label;
+
+  __device__ vertex_t operator()(vertex_t u) const { return label[u]; }
+};
+
+struct boruvka_self_loop_op {
+  template <typename tuple_t>
+  __device__ bool operator()(const tuple_t& t) const
+  {
+    return thrust::get<0>(t) == thrust::get<1>(t);
+  }
+};
+
+/**
+ * Boruvka's algorithm on an undirected edge list (every edge listed once), which physically
+ * contracts the graph at every round: the endpoints of the edges are relabeled with their new
+ * supervertex and the edges inside a supervertex are removed, so that each round only works on
+ * the remaining supervertices and the edges between them. Every round takes a single
+ * synchronization, to read the numbers of supervertices and of edges left.
+ *
+ * @param[in] handle raft resources
+ * @param[in] src first ends of the edges [n_edges]
+ * @param[in] dst second ends of the edges [n_edges]
+ * @param[in] w weights of the edges [n_edges]
+ * @param[in] n_edges number of edges
+ * @param[in] v number of vertices
+ * @param[inout] color the initial supervertex of every vertex, in [0, n_colors) [v]; on exit, the
+ *   connected component of every vertex, in [0, returned value)
+ * @param[in] n_colors number of initial supervertices
+ * @param[inout] in_mst set for the edges of the minimum spanning forest of the supervertices; the
+ *   other flags are left unchanged [n_edges]
+ * @return the number of connected components
+ */
+template <typename vertex_t, typename edge_t, typename weight_t>
+vertex_t boruvka_contract(raft::resources const& handle,
+                          const vertex_t* src,
+                          const vertex_t* dst,
+                          const weight_t* w,
+                          edge_t n_edges,
+                          vertex_t v,
+                          vertex_t* color,
+                          vertex_t n_colors,
+                          bool* in_mst)
+{
+  auto stream = resource::get_cuda_stream(handle);
+  auto policy = resource::get_thrust_policy(handle);
+  auto mr     = resource::get_workspace_resource(handle);
+
+  rmm::device_uvector<vertex_t> e_src(n_edges, stream, mr);
+  rmm::device_uvector<vertex_t> e_dst(n_edges, stream, mr);
+  rmm::device_uvector<weight_t> e_w(n_edges, stream, mr);
+  rmm::device_uvector<edge_t> e_id(n_edges, stream, mr);
+  thrust::transform(policy, src, src + n_edges, e_src.begin(), boruvka_label_op<vertex_t>{color});
+  thrust::transform(policy, dst, dst + n_edges, e_dst.begin(), boruvka_label_op<vertex_t>{color});
+  raft::copy(e_w.data(), w, n_edges, stream);
+  thrust::sequence(policy, e_id.begin(), e_id.end());
+
+  auto edges = thrust::make_zip_iterator(
+    thrust::make_tuple(e_src.begin(), e_dst.begin(), e_w.begin(), e_id.begin()));
+  auto n_live = static_cast<edge_t>(
+    thrust::remove_if(policy, edges, edges + n_edges, boruvka_self_loop_op{}) - edges);
+
+  rmm::device_uvector<weight_t> best_w(n_colors, stream, mr);
+  rmm::device_uvector<edge_t> best_e(n_colors, stream, mr);
+  rmm::device_uvector<vertex_t> parent(n_colors, stream, mr);
+  rmm::device_uvector<vertex_t> rank(n_colors, stream, mr);
+  vertex_t nv = n_colors;
+  while (n_live > 0) {
+    thrust::fill(policy, best_w.begin(), best_w.begin() + nv, std::numeric_limits<weight_t>::max());
+    thrust::fill(policy, best_e.begin(), best_e.begin() + nv, std::numeric_limits<edge_t>::max());
+    boruvka_min_weight_kernel<<<boruvka_blocks(n_live), kBoruvkaTPB, 0, stream>>>(
+      e_src.data(), e_dst.data(), e_w.data(), n_live, best_w.data());
+    boruvka_min_edge_kernel<<<boruvka_blocks(n_live), kBoruvkaTPB, 0, stream>>>(
+      e_src.data(), e_dst.data(), e_w.data(), n_live, best_w.data(), best_e.data());
+    boruvka_hook_kernel<<<boruvka_blocks(nv), kBoruvkaTPB, 0, stream>>>(
+      e_src.data(), e_dst.data(), e_id.data(), nv, best_e.data(), parent.data(), in_mst);
+    boruvka_jump_kernel<<<boruvka_blocks(nv), kBoruvkaTPB, 0, stream>>>(parent.data(), nv);
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+    // contract: the roots are renumbered, the vertices and the edges relabeled
+    thrust::transform_inclusive_scan(policy,
+                                     thrust::make_counting_iterator<vertex_t>(0),
+                                     thrust::make_counting_iterator<vertex_t>(nv),
+                                     rank.begin(),
+                                     boruvka_is_root_op<vertex_t>{parent.data()},
+                                     thrust::plus<vertex_t>());
+    boruvka_relabel_op<vertex_t> relabel{parent.data(), rank.data()};
+    thrust::transform(policy, color, color + v, color, relabel);
+    thrust::transform(policy, e_src.begin(), e_src.begin() + n_live, e_src.begin(), relabel);
+    thrust::transform(policy, e_dst.begin(), e_dst.begin() + n_live, e_dst.begin(), relabel);
+    raft::update_host(&nv, rank.data() + nv - 1, 1, stream);
+    n_live = static_cast<edge_t>(
+      thrust::remove_if(policy, edges, edges + n_live, boruvka_self_loop_op{}) - edges);
+    resource::sync_stream(handle, stream);
+  }
+  return nv;
+}
+
+/** Row of every non-zero of a CSR matrix. */
+template <typename vertex_t, typename edge_t>
+__global__ void csr_rows_kernel(const edge_t* offsets, vertex_t v, vertex_t* rows)
+{
+  for (vertex_t r = blockIdx.x * blockDim.x + threadIdx.x; r < v; r += blockDim.x * gridDim.x) {
+    for (edge_t p = offsets[r]; p < offsets[r + 1]; p++) {
+      rows[p] = r;
+    }
+  }
+}
+
+struct upper_triangle_op {
+  template <typename tuple_t>
+  __device__ bool operator()(const tuple_t& t) const
+  {
+    return thrust::get<0>(t) < thrust::get<1>(t);
+  }
+};
+
+/**
+ * The undirected edges of a symmetric CSR graph, i.e. its non-zeros (u, v) with u < v, and their
+ * positions in the CSR arrays. The self-loops are dropped.
+ * @return the number of edges
+ */
+template <typename vertex_t, typename edge_t>
+edge_t csr_undirected_edges(raft::resources const& handle,
+                            const edge_t* offsets,
+                            const vertex_t* indices,
+                            vertex_t v,
+                            edge_t e,
+                            vertex_t* src,
+                            vertex_t* dst,
+                            edge_t* pos)
+{
+  auto stream = resource::get_cuda_stream(handle);
+  rmm::device_uvector<vertex_t> rows(e, stream, resource::get_workspace_resource(handle));
+  csr_rows_kernel<<<boruvka_blocks(v), kBoruvkaTPB, 0, stream>>>(offsets, v, rows.data());
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+  auto in = thrust::make_zip_iterator(
+    thrust::make_tuple(rows.data(), indices, thrust::make_counting_iterator<edge_t>(0)));
+  auto out = thrust::make_zip_iterator(thrust::make_tuple(src, dst, pos));
+  return static_cast<edge_t>(
+    thrust::copy_if(resource::get_thrust_policy(handle), in, in + e, out, upper_triangle_op{}) -
+    out);
+}
+
+/**
+ * Gather the flagged edges into a new MST edge list, followed by their reverse edges when the
+ * output is symmetrized.
+ */
+template <typename vertex_t, typename edge_t, typename weight_t>
+Graph_COO<vertex_t, edge_t, weight_t> gather_mst_edges(raft::resources const& handle,
+                                                       const vertex_t* src,
+                                                       const vertex_t* dst,
+                                                       const weight_t* w,
+                                                       const bool* in_mst,
+                                                       edge_t n_edges,
+                                                       bool symmetrize_output)
+{
+  auto stream = resource::get_cuda_stream(handle);
+  auto policy = resource::get_thrust_policy(handle);
+  auto n_mst  = static_cast<edge_t>(thrust::count(policy, in_mst, in_mst + n_edges, true));
+  Graph_COO<vertex_t, edge_t, weight_t> mst(symmetrize_output ? 2 * n_mst : n_mst, stream);
+  mst.n_edges = symmetrize_output ? 2 * n_mst : n_mst;
+
+  auto in  = thrust::make_zip_iterator(thrust::make_tuple(src, dst, w));
+  auto out = thrust::make_zip_iterator(
+    thrust::make_tuple(mst.src.data(), mst.dst.data(), mst.weights.data()));
+  thrust::copy_if(policy, in, in + n_edges, in_mst, out, thrust::identity<bool>());
+  if (symmetrize_output) {
+    raft::copy(mst.src.data() + n_mst, mst.dst.data(), n_mst, stream);
+    raft::copy(mst.dst.data() + n_mst, mst.src.data(), n_mst, stream);
+    raft::copy(mst.weights.data() + n_mst, mst.weights.data(), n_mst, stream);
+  }
+  return mst;
+}
+
+/**
+ * Minimum spanning forest by contracted Boruvka.
+ * See raft::sparse::solver::mst_contracted for docs.
+ */
+template <typename vertex_t, typename edge_t, typename weight_t>
+Graph_COO<vertex_t, edge_t, weight_t> mst_contracted(raft::resources const& handle,
+                                                     const edge_t* offsets,
+                                                     const vertex_t* indices,
+                                                     const weight_t* weights,
+                                                     vertex_t v,
+                                                     edge_t e,
+                                                     vertex_t* color,
+                                                     bool symmetrize_output)
+{
+  RAFT_EXPECTS(v > 0, "0 vertices");
+  auto stream = resource::get_cuda_stream(handle);
+  auto policy = resource::get_thrust_policy(handle);
+  auto mr     = resource::get_workspace_resource(handle);
+
+  rmm::device_uvector<vertex_t> src(e, stream, mr);
+  rmm::device_uvector<vertex_t> dst(e, stream, mr);
+  rmm::device_uvector<edge_t> pos(e, stream, mr);
+  edge_t n_edges =
+    csr_undirected_edges(handle, offsets, indices, v, e, src.data(), dst.data(), pos.data());
+  rmm::device_uvector<weight_t> w(n_edges, stream, mr);
+  thrust::gather(policy, pos.begin(), pos.begin() + n_edges, weights, w.begin());
+
+  rmm::device_uvector<bool> in_mst(n_edges, stream, mr);
+  thrust::fill(policy, in_mst.begin(), in_mst.end(), false);
+  thrust::sequence(policy, color, color + v);
+  boruvka_contract(
+    handle, src.data(), dst.data(), w.data(), n_edges, v, color, v, in_mst.data());
+  return gather_mst_edges(
+    handle, src.data(), dst.data(), w.data(), in_mst.data(), n_edges, symmetrize_output);
+}
+
+/** Weights before and after the update of the edge (src, dst), read from the CSR row of src. */
+template <typename vertex_t, typename edge_t, typename weight_t>
+__global__ void mst_edge_update_kernel(const vertex_t* src,
+                                       const vertex_t* dst,
+                                       edge_t n_edges,
+                                       const edge_t* offsets,
+                                       const vertex_t* indices,
+                                       const weight_t* old_weights,
+                                       const weight_t* weights,
+                                       weight_t* new_w,
+                                       bool* kept)
+{
+  for (edge_t i = blockIdx.x * blockDim.x + threadIdx.x; i < n_edges; i += blockDim.x * gridDim.x) {
+    kept[i] = false;
+    for (edge_t p = offsets[src[i]]; p < offsets[src[i] + 1]; p++) {
+      if (indices[p] == dst[i]) {
+        new_w[i] = weights[p];
+        kept[i]  = !(weights[p] > old_weights[p]);
+        break;
+      }
+    }
+  }
+}
+
+template <typename weight_t>
+struct mst_increased_weight_op {
+  __device__ weight_t operator()(weight_t old_w, weight_t new_w) const
+  {
+    return old_w < new_w ? new_w : old_w;
+  }
+};
+
+struct mst_warm_start_candidate_op {
+  template <typename tuple_t>
+  __device__ bool operator()(const tuple_t& t) const
+  {
+    // the new MST edges are found among the MST edges after the increases and the decreased edges
+    return thrust::get<2>(t) || thrust::get<1>(t) < thrust::get<0>(t);
+  }
+};
+
+template <typename vertex_t>
+struct mst_canonical_edge_op {
+  __device__ thrust::tuple<vertex_t, vertex_t> operator()(vertex_t a, vertex_t b) const
+  {
+    return a < b ? thrust::make_tuple(a, b) : thrust::make_tuple(b, a);
+  }
+};
+
+/**
+ * Update of a minimum spanning forest after a change of the edge weights.
+ * See raft::sparse::solver::mst_warm_start for docs.
+ */
+template <typename vertex_t, typename edge_t, typename weight_t>
+Graph_COO<vertex_t, edge_t, weight_t> mst_warm_start(
+  raft::resources const& handle,
+  const edge_t* offsets,
+  const vertex_t* indices,
+  const weight_t* old_weights,
+  const weight_t* weights,
+  vertex_t v,
+  edge_t e,
+  const Graph_COO<vertex_t, edge_t, weight_t>& prev_mst,
+  vertex_t* color,
+  bool symmetrize_output)
+{
+  RAFT_EXPECTS(v > 0, "0 vertices");
+  auto stream = resource::get_cuda_stream(handle);
+  auto policy = resource::get_thrust_policy(handle);
+  auto mr     = resource::get_workspace_resource(handle);
+
+  // 1. The previous MST edges whose weight has not increased are still in the MST of the graph
+  // with the increases only: their components are found by contracting them.
+  edge_t n_tree = prev_mst.n_edges;
+  rmm::device_uvector<vertex_t> t_src(n_tree, stream, mr);
+  rmm::device_uvector<vertex_t> t_dst(n_tree, stream, mr);
+  auto tree = thrust::make_zip_iterator(thrust::make_tuple(t_src.begin(), t_dst.begin()));
+  thrust::transform(policy,
+                    prev_mst.src.begin(),
+                    prev_mst.src.begin() + n_tree,
+                    prev_mst.dst.begin(),
+                    tree,
+                    mst_canonical_edge_op<vertex_t>{});
+  thrust::sort(policy, tree, tree + n_tree);
+  n_tree = static_cast<edge_t>(thrust::unique(policy, tree, tree + n_tree) - tree);
+
+  rmm::device_uvector<weight_t> t_w(n_tree, stream, mr);
+  rmm::device_uvector<bool> t_kept(n_tree, stream, mr);
+  mst_edge_update_kernel<<<boruvka_blocks(n_tree), kBoruvkaTPB, 0, stream>>>(t_src.data(),
+                                                                             t_dst.data(),
+                                                                             n_tree,
+                                                                             offsets,
+                                                                             indices,
+                                                                             old_weights,
+                                                                             weights,
+                                                                             t_w.data(),
+                                                                             t_kept.data());
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+  auto tree_w =
+    thrust::make_zip_iterator(thrust::make_tuple(t_src.begin(), t_dst.begin(), t_w.begin()));
+  auto n_kept = static_cast<edge_t>(
+    thrust::remove_if(
+      policy, tree_w, tree_w + n_tree, t_kept.begin(), thrust::logical_not<bool>()) -
+    tree_w);
+
+  rmm::device_uvector<bool> t_in_mst(n_kept, stream, mr);
+  thrust::fill(policy, t_in_mst.begin(), t_in_mst.end(), false);
+  thrust::sequence(policy, color, color + v);
+  vertex_t n_components = boruvka_contract(
+    handle, t_src.data(), t_dst.data(), t_w.data(), n_kept, v, color, v, t_in_mst.data());
+
+  // 2. The MST of the graph with the increases only: the kept edges are completed by a Boruvka on
+  // the contracted graph, which starts with as many supervertices as increased MST edges (plus the
+  // components of the previous forest).
+  rmm::device_uvector<vertex_t> src(e, stream, mr);
+  rmm::device_uvector<vertex_t> dst(e, stream, mr);
+  rmm::device_uvector<edge_t> pos(e, stream, mr);
+  edge_t n_edges =
+    csr_undirected_edges(handle, offsets, indices, v, e, src.data(), dst.data(), pos.data());
+  rmm::device_uvector<weight_t> w_old(n_edges, stream, mr);
+  rmm::device_uvector<weight_t> w(n_edges, stream, mr);
+  thrust::gather(policy, pos.begin(), pos.begin() + n_edges, old_weights, w_old.begin());
+  thrust::gather(policy, pos.begin(), pos.begin() + n_edges, weights, w.begin());
+  rmm::device_uvector<weight_t> w_increased(n_edges, stream, mr);
+  thrust::transform(policy,
+                    w_old.begin(),
+                    w_old.begin() + n_edges,
+                    w.begin(),
+                    w_increased.begin(),
+                    mst_increased_weight_op<weight_t>{});
+  rmm::device_uvector<bool> in_mst(n_edges, stream, mr);
+  thrust::fill(policy, in_mst.begin(), in_mst.end(), false);
+  boruvka_contract(handle,
+                   src.data(),
+                   dst.data(),
+                   w_increased.data(),
+                   n_edges,
+                   v,
+                   color,
+                   n_components,
+                   in_mst.data());
+
+  // 3. The decreases: the new MST is made of the MST edges of step 2 and of the decreased edges.
+  edge_t n_cand = n_kept;
+  rmm::device_uvector<vertex_t> c_src(n_kept + n_edges, stream, mr);
+  rmm::device_uvector<vertex_t> c_dst(n_kept + n_edges, stream, mr);
+  rmm::device_uvector<weight_t> c_w(n_kept + n_edges, stream, mr);
+  raft::copy(c_src.data(), t_src.data(), n_kept, stream);
+  raft::copy(c_dst.data(), t_dst.data(), n_kept, stream);
+  raft::copy(c_w.data(), t_w.data(), n_kept, stream);
+  auto edges = thrust::make_zip_iterator(thrust::make_tuple(src.begin(), dst.begin(), w.begin()));
+  auto stencil =
+    thrust::make_zip_iterator(thrust::make_tuple(w_old.begin(), w.begin(), in_mst.begin()));
+  auto cand = thrust::make_zip_iterator(
+    thrust::make_tuple(c_src.begin() + n_kept, c_dst.begin() + n_kept, c_w.begin() + n_kept));
+  n_cand += static_cast<edge_t>(
+    thrust::copy_if(
+      policy, edges, edges + n_edges, stencil, cand, mst_warm_start_candidate_op{}) -
+    cand);
+
+  rmm::device_uvector<bool> c_in_mst(n_cand, stream, mr);
+  thrust::fill(policy, c_in_mst.begin(), c_in_mst.end(), false);
+  thrust::sequence(policy, color, color + v);
+  boruvka_contract(
+    handle, c_src.data(), c_dst.data(), c_w.data(), n_cand, v, color, v, c_in_mst.data());
+  return gather_mst_edges(
+    handle, c_src.data(), c_dst.data(), c_w.data(), c_in_mst.data(), n_cand, symmetrize_output);
+}
+
+}  // namespace raft::sparse::solver::detail
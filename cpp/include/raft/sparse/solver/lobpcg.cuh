@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/sparse/solver/detail/lobpcg.cuh>
+#include <raft/spectral/matrix_wrappers.hpp>
+
+namespace raft::sparse::solver {
+
+// =========================================================
+// Block eigensolver
+// =========================================================
+
+/**
+ *  @brief  Compute smallest eigenvectors of symmetric matrix with LOBPCG
+ *    Unlike the Lanczos solver, the whole block of eigenvectors is iterated
+ *    at once: the matrix is applied with a sparse matrix - dense matrix
+ *    product and the Rayleigh-Ritz steps are computed on the GPU, which
+ *    converges in much fewer matrix passes when many eigenpairs are wanted.
+ *  @tparam index_type_t the type of data used for indexing.
+ *  @tparam value_type_t the type of data used for weights, distances.
+ *  @param handle the raft handle.
+ *  @param A Matrix.
+ *  @param nEigVecs Number of eigenvectors to compute.
+ *  @param blockSize Number of vectors of the block (at least nEigVecs,
+ *    and at most a third of the matrix size).
+ *  @param maxIter Maximum number of iterations.
+ *  @param tol Convergence tolerance. The iteration terminates when the
+ *    residual norm of every wanted eigenpair is less than tol*theta,
+ *    where theta is the largest Ritz value of the search subspace in
+ *    magnitude.
+ *  @param iter On exit, number of iterations performed.
+ *  @param eigVals_dev (Output, device memory, nEigVecs entries)
+ *    Smallest eigenvalues of matrix, in ascending order.
+ *  @param eigVecs_dev (Output, device memory, n*nEigVecs entries)
+ *    Eigenvectors corresponding to smallest eigenvalues of
+ *    matrix. Vectors are stored as columns of a column-major matrix
+ *    with dimensions n x nEigVecs.
+ *  @param seed random seed.
+ *  @return error flag.
+ */
+template <typename index_type_t, typename value_type_t>
+int lobpcgSmallestEigenvectors(
+  raft::resources const& handle,
+  raft::spectral::matrix::sparse_matrix_t<index_type_t, value_type_t> const& A,
+  index_type_t nEigVecs,
+  index_type_t blockSize,
+  index_type_t maxIter,
+  value_type_t tol,
+  index_type_t& iter,
+  value_type_t* __restrict__ eigVals_dev,
+  value_type_t* __restrict__ eigVecs_dev,
+  unsigned long long seed = 1234567)
+{
+  return detail::lobpcgEigenvectors(handle,
+                                    A,
+                                    nEigVecs,
+                                    blockSize,
+                                    maxIter,
+                                    tol,
+                                    false,
+                                    iter,
+                                    eigVals_dev,
+                                    eigVecs_dev,
+                                    seed);
+}
+
+/**
+ *  @brief  Compute largest eigenvectors of symmetric matrix with LOBPCG
+ *    See lobpcgSmallestEigenvectors; the iteration is applied to -A.
+ *  @tparam index_type_t the type of data used for indexing.
+ *  @tparam value_type_t the type of data used for weights, distances.
+ *  @param handle the raft handle.
+ *  @param A Matrix.
+ *  @param nEigVecs Number of eigenvectors to compute.
+ *  @param blockSize Number of vectors of the block (at least nEigVecs,
+ *    and at most a third of the matrix size).
+ *  @param maxIter Maximum number of iterations.
+ *  @param tol Convergence tolerance, see lobpcgSmallestEigenvectors.
+ *  @param iter On exit, number of iterations performed.
+ *  @param eigVals_dev (Output, device memory, nEigVecs entries)
+ *    Largest eigenvalues of matrix, in descending order.
+ *  @param eigVecs_dev (Output, device memory, n*nEigVecs entries)
+ *    Eigenvectors corresponding to largest eigenvalues of
+ *    matrix. Vectors are stored as columns of a column-major matrix
+ *    with dimensions n x nEigVecs.
+ *  @param seed random seed.
+ *  @return error flag.
+ */
+template <typename index_type_t, typename value_type_t>
+int lobpcgLargestEigenvectors(
+  raft::resources const& handle,
+  raft::spectral::matrix::sparse_matrix_t<index_type_t, value_type_t> const& A,
+  index_type_t nEigVecs,
+  index_type_t blockSize,
+  index_type_t maxIter,
+  value_type_t tol,
+  index_type_t& iter,
+  value_type_t* __restrict__ eigVals_dev,
+  value_type_t* __restrict__ eigVecs_dev,
+  unsigned long long seed = 1234567)
+{
+  return detail::lobpcgEigenvectors(handle,
+                                    A,
+                                    nEigVecs,
+                                    blockSize,
+                                    maxIter,
+                                    tol,
+                                    true,
+                                    iter,
+                                    eigVals_dev,
+                                    eigVecs_dev,
+                                    seed);
+}
+
+}  // namespace raft::sparse::solver
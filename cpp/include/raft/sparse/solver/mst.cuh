@@ -16,6 +16,7 @@
  */
 #pragma once
 
+#include <raft/sparse/solver/detail/mst_contract.cuh>
 #include <raft/sparse/solver/mst_solver.cuh>
 
 namespace raft::sparse::solver {
@@ -70,4 +71,84 @@ Graph_COO<vertex_t, edge_t, weight_t> mst(raft::resources const& handle,
   return mst_solver.solve();
 }
 
+/**
+ * Compute the minimum spanning tree (MST) or minimum spanning forest (MSF) of an undirected graph
+ * with a Boruvka variant which contracts the graph at every round.
+ *
+ * At every round, each supervertex picks its lightest edge (the ties being broken by a total order
+ * of the edges, which needs no random alteration of the weights), the picked edges are contracted
+ * and the edge list is compacted to the edges between the new supervertices. The rounds thus work
+ * on a shrinking graph, and take a single host synchronization each.
+ *
+ * @tparam vertex_t integral type for precision of vertex indexing
+ * @tparam edge_t integral type for precision of edge indexing
+ * @tparam weight_t type of weights array
+ *
+ * @param handle raft resources
+ * @param offsets csr inptr array of row offsets (size v+1)
+ * @param indices csr array of column indices (size e); the graph should be symmetric, only the
+ *   entries above the diagonal are read
+ * @param weights csr array of weights (size e)
+ * @param v number of vertices in graph
+ * @param e number of edges in graph
+ * @param color array to store the connected component of every vertex, numbered from 0 (size v)
+ * @param symmetrize_output should the resulting output edge list should be symmetrized?
+ * @return the edges of the MSF
+ */
+template <typename vertex_t, typename edge_t, typename weight_t>
+Graph_COO<vertex_t, edge_t, weight_t> mst_contracted(raft::resources const& handle,
+                                                     edge_t const* offsets,
+                                                     vertex_t const* indices,
+                                                     weight_t const* weights,
+                                                     vertex_t const v,
+                                                     edge_t const e,
+                                                     vertex_t* color,
+                                                     bool symmetrize_output = true)
+{
+  return detail::mst_contracted(handle, offsets, indices, weights, v, e, color, symmetrize_output);
+}
+
+/**
+ * Update a minimum spanning forest after a change of the weights of the graph, e.g. for
+ * incremental HDBSCAN.
+ *
+ * The previous MST edges whose weight has not increased stay in the MST of the graph with only
+ * the increases applied; this MST is completed by a contracted Boruvka (see `mst_contracted`)
+ * which starts from their components rather than from the single vertices. The MST of the new
+ * graph is then computed from the edges of this MST and the edges whose weight has decreased only.
+ * When few weights change, both Boruvka runs are much cheaper than a new MST of the whole graph.
+ *
+ * @tparam vertex_t integral type for precision of vertex indexing
+ * @tparam edge_t integral type for precision of edge indexing
+ * @tparam weight_t type of weights array
+ *
+ * @param handle raft resources
+ * @param offsets csr inptr array of row offsets (size v+1)
+ * @param indices csr array of column indices (size e), symmetric
+ * @param old_weights csr array of the weights prev_mst was computed from (size e)
+ * @param weights csr array of the new weights (size e)
+ * @param v number of vertices in graph
+ * @param e number of edges in graph
+ * @param prev_mst a minimum spanning forest of the graph with the old weights, symmetrized or not
+ * @param color array to store the connected component of every vertex, numbered from 0 (size v)
+ * @param symmetrize_output should the resulting output edge list should be symmetrized?
+ * @return the edges of the MSF with the new weights
+ */
+template <typename vertex_t, typename edge_t, typename weight_t>
+Graph_COO<vertex_t, edge_t, weight_t> mst_warm_start(
+  raft::resources const& handle,
+  edge_t const* offsets,
+  vertex_t const* indices,
+  weight_t const* old_weights,
+  weight_t const* weights,
+  vertex_t const v,
+  edge_t const e,
+  Graph_COO<vertex_t, edge_t, weight_t> const& prev_mst,
+  vertex_t* color,
+  bool symmetrize_output = true)
+{
+  return detail::mst_warm_start(
+    handle, offsets, indices, old_weights, weights, v, e, prev_mst, color, symmetrize_output);
+}
+
 }  // end namespace raft::sparse::solver
@@ -16,8 +16,13 @@
 
 #pragma once
 
+#include <raft/core/device_mdspan.hpp>
 #include <raft/core/logger.hpp>
+#include <raft/core/memory_type.hpp>
+#include <raft/core/resources.hpp>
 #include <raft/distance/distance_types.hpp>
+#include <raft/linalg/map.cuh>
+#include <raft/linalg/normalize.cuh>
 #include <raft/util/cuda_utils.cuh>
 #include <raft/util/cudart_utils.hpp>
 #include <raft/util/integer_utils.hpp>
@@ -26,6 +31,7 @@
 #include <rmm/device_scalar.hpp>
 #include <rmm/device_uvector.hpp>
 
+#include <cstring>
 #include <memory>
 #include <optional>
 
@@ -45,6 +51,33 @@ enum class pointer_residency {
   device_only
 };
 
+/**
+ * Whether the current device reads the pageable host memory in place, through the host page tables
+ * (e.g. ATS on Grace-Hopper); the datasets in such memory are not staged in the device memory.
+ */
+inline auto current_device_reads_pageable_memory() -> bool
+{
+  int dev_id = 0;
+  RAFT_CUDA_TRY(cudaGetDevice(&dev_id));
+  return raft::device_reads_pageable_memory(dev_id);
+}
+
+/**
+ * The address at which the current device reads the data, or nullptr if the data must be copied to
+ * the device memory first.
+ */
+template <typename T>
+auto device_accessible_pointer(const T* ptr) -> const T*
+{
+  cudaPointerAttributes attr;
+  RAFT_CUDA_TRY(cudaPointerGetAttributes(&attr, ptr));
+  if (attr.devicePointer != nullptr) { return reinterpret_cast<const T*>(attr.devicePointer); }
+  if (attr.type == cudaMemoryTypeUnregistered && current_device_reads_pageable_memory()) {
+    return ptr;
+  }
+  return nullptr;
+}
+
 template <typename... Types>
 struct pointer_residency_count {};
 
@@ -61,7 +94,9 @@ struct pointer_residency_count<Type, Types...> {
     cudaPointerAttributes attr;
     RAFT_CUDA_TRY(cudaPointerGetAttributes(&attr, ptr));
     switch (attr.type) {
-      case cudaMemoryTypeUnregistered: return std::make_tuple(on_device, on_host + 1);
+      case cudaMemoryTypeUnregistered:
+        return std::make_tuple(on_device + int(current_device_reads_pageable_memory()),
+                               on_host + 1);
       case cudaMemoryTypeHost:
         return std::make_tuple(on_device + int(attr.devicePointer == ptr), on_host + 1);
       case cudaMemoryTypeDevice: return std::make_tuple(on_device + 1, on_host);
@@ -382,7 +417,9 @@ void copy_selected(IdxT n_rows,
  *
  *  1. if `source == nullptr`: then `batch.data() == nullptr`
  *  2. if `source` is accessible from the device, `batch.data()` points directly at the source at
- *     the proper offsets on each iteration.
+ *     the proper offsets on each iteration. This includes the pageable host memory on the systems
+ *     where the device reads it through the host page tables (`device_accessible_pointer`). The
+ *     managed memory is prefetched to the device one batch ahead.
  *  3. if `source` is not accessible from the device, `batch.data()` points to an intermediate
  *     buffer; the corresponding data is copied in the given `stream` on every iterator dereference
  *     (i.e. batches can be skipped). Dereferencing the same batch two times in a row does not force
@@ -392,6 +429,11 @@ void copy_selected(IdxT n_rows,
  *
  * The iterator can be reused. If the number of iterations is one, at most one copy will ever be
  * invoked (i.e. small datasets are not reloaded multiple times).
+ *
+ * In the third scenario, `enable_pipelining` makes the iterator stage the batches through a pair
+ * of pinned host buffers and a pair of device buffers: every dereference enqueues the copy of the
+ * next batch on a separate stream, so that the host->device transfer overlaps the work on the
+ * current batch in the main stream.
  */
 template <typename T>
 struct batch_load_iterator {
@@ -411,6 +453,52 @@ struct batch_load_iterator {
     [[nodiscard]] auto does_copy() const -> bool { return needs_copy_; }
 
    private:
+    /**
+     * The double-buffered staging of the copied batches: the batch `pos` goes through the slot
+     * `pos % 2`. A slot is refilled only after the main stream is done with its previous batch.
+     */
+    struct pipeline {
+      pipeline(rmm::cuda_stream_view copy_stream,
+               size_type slot_size,
+               T* first_buf,
+               rmm::cuda_stream_view stream,
+               rmm::mr::device_memory_resource* mr)
+        : copy_stream(copy_stream), second_buf(slot_size, stream, mr)
+      {
+        dev[0] = first_buf;
+        dev[1] = second_buf.data();
+        for (int i = 0; i < 2; i++) {
+          RAFT_CUDA_TRY(cudaMallocHost(&pinned[i], sizeof(T) * slot_size));
+          RAFT_CUDA_TRY(cudaEventCreateWithFlags(&copied[i], cudaEventDisableTiming));
+          RAFT_CUDA_TRY(cudaEventCreateWithFlags(&consumed[i], cudaEventDisableTiming));
+        }
+      }
+      ~pipeline() noexcept
+      {
+        for (int i = 0; i < 2; i++) {
+          // the pending copies must not touch the buffers after they are freed
+          RAFT_CUDA_TRY_NO_THROW(cudaEventSynchronize(copied[i]));
+          RAFT_CUDA_TRY_NO_THROW(cudaEventDestroy(copied[i]));
+          RAFT_CUDA_TRY_NO_THROW(cudaEventDestroy(consumed[i]));
+          RAFT_CUDA_TRY_NO_THROW(cudaFreeHost(pinned[i]));
+        }
+      }
+      pipeline(const pipeline&)                    = delete;
+      pipeline(pipeline&&)                         = delete;
+      auto operator=(const pipeline&) -> pipeline& = delete;
+      auto operator=(pipeline&&) -> pipeline&      = delete;
+
+      rmm::cuda_stream_view copy_stream;
+      rmm::device_uvector<T> second_buf;
+      T* dev[2];
+      T* pinned[2] = {nullptr, nullptr};
+      cudaEvent_t copied[2];
+      cudaEvent_t consumed[2];
+      /** The positions of the batches staged in the slots. */
+      std::optional<size_type> staged[2];
+    };
+
+
     batch(const T* source,
           size_type n_rows,
           size_type row_width,
@@ -431,11 +519,17 @@ struct batch_load_iterator {
       if (source_ == nullptr) { return; }
       cudaPointerAttributes attr;
       RAFT_CUDA_TRY(cudaPointerGetAttributes(&attr, source_));
-      dev_ptr_ = reinterpret_cast<T*>(attr.devicePointer);
+      dev_ptr_ = const_cast<T*>(device_accessible_pointer(source_));
       if (dev_ptr_ == nullptr) {
         buf_.resize(row_width_ * batch_size_, stream);
         dev_ptr_    = buf_.data();
         needs_copy_ = true;
+      } else if (attr.type == cudaMemoryTypeManaged) {
+        int concurrent_access = 0;
+        RAFT_CUDA_TRY(cudaGetDevice(&device_));
+        RAFT_CUDA_TRY(cudaDeviceGetAttribute(
+          &concurrent_access, cudaDevAttrConcurrentManagedAccess, device_));
+        prefetch_ = concurrent_access != 0;
       }
     }
     rmm::cuda_stream_view stream_;
@@ -446,6 +540,9 @@ struct batch_load_iterator {
     size_type batch_size_;
     size_type n_iters_;
     bool needs_copy_;
+    bool prefetch_ = false;
+    int device_    = 0;
+    std::shared_ptr<pipeline> pipeline_;
 
     std::optional<size_type> pos_;
     size_type batch_len_;
@@ -461,10 +558,22 @@ struct batch_load_iterator {
     {
       // No-op if the data is already loaded, or it's the end of the input.
       if (pos == pos_ || pos >= n_iters_) { return; }
+      const bool sequential = pos_.has_value() && *pos_ + 1 == pos;
+      // all the work on the previous batch is enqueued by now
+      if (pipeline_ && pos_.has_value()) {
+        RAFT_CUDA_TRY(cudaEventRecord(pipeline_->consumed[*pos_ % 2], stream_));
+      }
       pos_.emplace(pos);
       batch_len_ = std::min(batch_size_, n_rows_ - std::min(offset(), n_rows_));
       if (source_ == nullptr) { return; }
-      if (needs_copy_) {
+      if (pipeline_) {
+        const auto slot = pos % 2;
+        // The current batch is already staged when the batches are read in order.
+        if (pipeline_->staged[slot] != pos) { stage_batch(pos); }
+        RAFT_CUDA_TRY(cudaStreamWaitEvent(stream_, pipeline_->copied[slot]));
+        dev_ptr_ = pipeline_->dev[slot];
+        stage_batch(pos + 1);
+      } else if (needs_copy_) {
         if (size() > 0) {
           RAFT_LOG_DEBUG("batch_load_iterator::copy(offset = %zu, size = %zu, row_width = %zu)",
                          size_t(offset()),
@@ -474,6 +583,50 @@ struct batch_load_iterator {
         }
       } else {
         dev_ptr_ = const_cast<T*>(source_) + offset() * row_width();
+        if (prefetch_) {
+          // The current batch is already prefetched when the batches are read in order.
+          if (!sequential) { prefetch_batch(pos); }
+          prefetch_batch(pos + 1);
+        }
+      }
+    }
+
+    /**
+     * Copy the batch `pos` into the pinned buffer of its slot and enqueue its transfer to the
+     * device in the copy stream.
+     */
+    void stage_batch(const size_type& pos)
+    {
+      if (pos >= n_iters_) { return; }
+      const auto slot  = pos % 2;
+      size_type offset = pos * batch_size_;
+      size_type len    = std::min(batch_size_, n_rows_ - offset) * row_width_;
+      // the previous transfer from the pinned buffer is done
+      RAFT_CUDA_TRY(cudaEventSynchronize(pipeline_->copied[slot]));
+      std::memcpy(pipeline_->pinned[slot], source_ + offset * row_width_, sizeof(T) * len);
+      // the work on the previous batch in the device buffer is done
+      RAFT_CUDA_TRY(cudaStreamWaitEvent(pipeline_->copy_stream, pipeline_->consumed[slot]));
+      RAFT_LOG_DEBUG("batch_load_iterator::stage(offset = %zu, size = %zu, row_width = %zu)",
+                     size_t(offset),
+                     size_t(len / row_width_),
+                     size_t(row_width_));
+      copy(pipeline_->dev[slot], pipeline_->pinned[slot], len, pipeline_->copy_stream);
+      RAFT_CUDA_TRY(cudaEventRecord(pipeline_->copied[slot], pipeline_->copy_stream));
+      pipeline_->staged[slot].emplace(pos);
+    }
+
+    /** Hint the driver to migrate the batch `pos` of the managed source to the device. */
+    void prefetch_batch(const size_type& pos)
+    {
+      if (pos >= n_iters_) { return; }
+      size_type offset = pos * batch_size_;
+      size_type len    = std::min(batch_size_, n_rows_ - offset);
+      if (cudaMemPrefetchAsync(source_ + offset * row_width_,
+                               sizeof(T) * len * row_width_,
+                               device_,
+                               stream_) != cudaSuccess) {
+        // only a hint
+        cudaGetLastError();
       }
     }
   };
@@ -511,6 +664,26 @@ struct batch_load_iterator {
    * (i.e. the source is inaccessible from the device).
    */
   [[nodiscard]] auto does_copy() const -> bool { return cur_batch_->does_copy(); }
+  /**
+   * Stage the copied batches through the pinned buffers and transfer them in the `copy_stream`
+   * one batch ahead of the iteration. This doubles the device buffer and has no effect if the
+   * iterator does not copy the data. Must be called before the first dereference.
+   *
+   * @param copy_stream the stream for the host->device copies; the main stream of the iterator
+   *   synchronizes with it via events. Passing the main stream itself still overlaps the host-side
+   *   staging of the next batch with the device work.
+   * @param mr a custom memory resource for the second device buffer.
+   */
+  void enable_pipelining(
+    rmm::cuda_stream_view copy_stream,
+    rmm::mr::device_memory_resource* mr = rmm::mr::get_current_device_resource())
+  {
+    auto& b = *cur_batch_;
+    RAFT_EXPECTS(!b.pos_.has_value(), "The pipelining must be enabled before the first load.");
+    if (!b.needs_copy_ || b.n_rows_ == 0) { return; }
+    b.pipeline_ = std::make_shared<typename batch::pipeline>(
+      copy_stream, b.row_width_ * b.batch_size_, b.buf_.data(), b.stream_, mr);
+  }
   /** Reset the iterator position to `begin()` */
   void reset() { cur_pos_ = 0; }
   /** Reset the iterator position to `end()` */
@@ -573,4 +746,39 @@ struct batch_load_iterator {
   size_type cur_pos_;
 };
 
+/**
+ * The metric the IVF indexes evaluate internally for the given metric of the index.
+ *
+ * The `CosineExpanded` distance is computed as `1 - InnerProduct` of the normalized vectors: the
+ * trainset, the stored vectors and the queries are normalized on the fly, the user data is never
+ * copied as a whole.
+ */
+constexpr inline auto internal_metric(raft::distance::DistanceType metric)
+  -> raft::distance::DistanceType
+{
+  return metric == raft::distance::DistanceType::CosineExpanded
+           ? raft::distance::DistanceType::InnerProduct
+           : metric;
+}
+
+/** Normalize the rows of a row-major matrix [n_rows, dim] in-place; the zero rows stay zero. */
+template <typename IdxT>
+void normalize_rows(raft::resources const& res, float* data, IdxT n_rows, IdxT dim)
+{
+  raft::linalg::row_normalize(
+    res,
+    raft::make_device_matrix_view<const float, IdxT>(data, n_rows, dim),
+    raft::make_device_matrix_view<float, IdxT>(data, n_rows, dim),
+    raft::linalg::L2Norm);
+}
+
+/** Turn the inner products of the normalized vectors into the cosine distances in-place. */
+template <typename IdxT>
+void inner_product_to_cosine(raft::resources const& res, float* distances, IdxT n)
+{
+  auto view = raft::make_device_vector_view<float, IdxT>(distances, n);
+  raft::linalg::map(
+    res, view, [] __device__(float ip) { return 1.0f - ip; }, raft::make_const_mdspan(view));
+}
+
 }  // namespace raft::spatial::knn::detail::utils
@@ -22,6 +22,7 @@
 
 #include "../ball_cover_types.hpp"
 #include "ball_cover/common.cuh"
+#include "ball_cover/gemm.cuh"
 #include "ball_cover/registers.cuh"
 #include "haversine_distance.cuh"
 
@@ -29,23 +30,33 @@
 #include <limits.h>
 
 #include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+#include <raft/util/device_atomics.cuh>
 
 #include <raft/neighbors/detail/faiss_select/key_value_block_select.cuh>
 
+#include <raft/core/kvp.hpp>
+#include <raft/distance/fused_l2_nn.cuh>
+#include <raft/linalg/norm.cuh>
 #include <raft/matrix/copy.cuh>
 #include <raft/neighbors/brute_force.cuh>
 #include <raft/random/rng.cuh>
 #include <raft/sparse/convert/csr.cuh>
 
+#include <rmm/device_buffer.hpp>
 #include <rmm/device_uvector.hpp>
 #include <rmm/exec_policy.hpp>
 
+#include <cub/cub.cuh>
+#include <thrust/binary_search.h>
 #include <thrust/fill.h>
 #include <thrust/for_each.h>
 #include <thrust/functional.h>
 #include <thrust/iterator/counting_iterator.h>
 #include <thrust/iterator/zip_iterator.h>
 #include <thrust/reduce.h>
+#include <thrust/scan.h>
+#include <thrust/scatter.h>
 #include <thrust/sequence.h>
 #include <thrust/sort.h>
 #include <thrust/tuple.h>
@@ -114,6 +125,10 @@ void sample_landmarks(raft::resources const& handle,
 
 /**
  * Constructs a 1-nn index mapping each landmark to their closest points.
+ *
+ * The points are counted per landmark, the counts are scanned into the offsets of the balls and
+ * the points are scattered into their balls, which are then sorted by the distance to the
+ * landmark independently of each other.
  * @tparam value_idx
  * @tparam value_t
  * @param handle
@@ -129,39 +144,67 @@ void construct_landmark_1nn(raft::resources const& handle,
                             value_int k,
                             BallCoverIndex<value_idx, value_t, value_int>& index)
 {
-  rmm::device_uvector<value_idx> R_1nn_inds(index.m, resource::get_cuda_stream(handle));
+  auto stream = resource::get_cuda_stream(handle);
 
-  thrust::fill(resource::get_thrust_policy(handle),
-               R_1nn_inds.data(),
-               R_1nn_inds.data() + index.m,
-               std::numeric_limits<value_idx>::max());
+  rmm::device_uvector<value_idx> ball_sizes(index.n_landmarks + 1, stream);
+  rmm::device_uvector<value_idx> R_1nn_cols(index.m, stream);
+  rmm::device_uvector<value_t> R_1nn_dists(index.m, stream);
 
-  value_idx* R_1nn_inds_ptr = R_1nn_inds.data();
-  value_t* R_1nn_dists_ptr  = index.get_R_1nn_dists().data_handle();
+  value_idx* ball_sizes_ptr = ball_sizes.data();
+  value_idx* R_indptr_ptr   = index.get_R_indptr().data_handle();
+  value_idx* R_1nn_cols_ptr = R_1nn_cols.data();
+  value_t* R_1nn_dists_ptr  = R_1nn_dists.data();
+  auto idxs                 = thrust::make_counting_iterator<value_idx>(0);
 
-  auto idxs = thrust::make_counting_iterator<value_idx>(0);
+  // count the points of every ball
+  RAFT_CUDA_TRY(
+    cudaMemsetAsync(ball_sizes.data(), 0, ball_sizes.size() * sizeof(value_idx), stream));
+  thrust::for_each(
+    resource::get_thrust_policy(handle), idxs, idxs + index.m, [=] __device__(value_idx i) {
+      atomicAdd(ball_sizes_ptr + R_knn_inds_ptr[i * k], value_idx(1));
+    });
+
+  // the offsets of the balls; the last (empty) count makes the total
+  thrust::exclusive_scan(
+    resource::get_thrust_policy(handle), ball_sizes.begin(), ball_sizes.end(), R_indptr_ptr);
+
+  // scatter the points into their balls, reusing the counts as the insertion cursors
+  RAFT_CUDA_TRY(
+    cudaMemsetAsync(ball_sizes.data(), 0, ball_sizes.size() * sizeof(value_idx), stream));
   thrust::for_each(
     resource::get_thrust_policy(handle), idxs, idxs + index.m, [=] __device__(value_idx i) {
-      R_1nn_inds_ptr[i]  = R_knn_inds_ptr[i * k];
-      R_1nn_dists_ptr[i] = R_knn_dists_ptr[i * k];
+      value_idx landmark   = R_knn_inds_ptr[i * k];
+      value_idx offset     = atomicAdd(ball_sizes_ptr + landmark, value_idx(1));
+      value_idx pos        = R_indptr_ptr[landmark] + offset;
+      R_1nn_cols_ptr[pos]  = i;
+      R_1nn_dists_ptr[pos] = R_knn_dists_ptr[i * k];
     });
 
-  auto keys = thrust::make_zip_iterator(
-    thrust::make_tuple(R_1nn_inds.data(), index.get_R_1nn_dists().data_handle()));
-
-  // group neighborhoods for each reference landmark and sort each group by distance
-  thrust::sort_by_key(resource::get_thrust_policy(handle),
-                      keys,
-                      keys + index.m,
-                      index.get_R_1nn_cols().data_handle(),
-                      NNComp());
-
-  // convert to CSR for fast lookup
-  raft::sparse::convert::sorted_coo_to_csr(R_1nn_inds.data(),
-                                           index.m,
-                                           index.get_R_indptr().data_handle(),
-                                           index.n_landmarks + 1,
-                                           resource::get_cuda_stream(handle));
+  // sort every ball by distance
+  size_t temp_bytes = 0;
+  RAFT_CUDA_TRY(cub::DeviceSegmentedSort::SortPairs(nullptr,
+                                                    temp_bytes,
+                                                    R_1nn_dists.data(),
+                                                    index.get_R_1nn_dists().data_handle(),
+                                                    R_1nn_cols.data(),
+                                                    index.get_R_1nn_cols().data_handle(),
+                                                    index.m,
+                                                    index.n_landmarks,
+                                                    R_indptr_ptr,
+                                                    R_indptr_ptr + 1,
+                                                    stream));
+  rmm::device_buffer temp(temp_bytes, stream);
+  RAFT_CUDA_TRY(cub::DeviceSegmentedSort::SortPairs(temp.data(),
+                                                    temp_bytes,
+                                                    R_1nn_dists.data(),
+                                                    index.get_R_1nn_dists().data_handle(),
+                                                    R_1nn_cols.data(),
+                                                    index.get_R_1nn_cols().data_handle(),
+                                                    index.m,
+                                                    index.n_landmarks,
+                                                    R_indptr_ptr,
+                                                    R_indptr_ptr + 1,
+                                                    stream));
 }
 
 /**
@@ -197,6 +240,102 @@ void k_closest_landmarks(raft::resources const& handle,
     index.get_metric());
 }
 
+/**
+ * Computes the closest landmark of every one of a set of query points for the Euclidean balls.
+ *
+ * The landmarks are selected by the fused L2 1-NN, which avoids materializing the distances to all
+ * the landmarks; the distances to the selected landmarks are then recomputed directly, because the
+ * expanded form loses precision for the nearby points and the balls need the exact radii.
+ * @tparam value_idx
+ * @tparam value_t
+ * @tparam value_int
+ * @param handle
+ * @param index
+ * @param query_pts
+ * @param n_query_pts
+ * @param R_knn_inds
+ * @param R_knn_dists
+ */
+template <typename value_idx, typename value_t, typename value_int = std::uint32_t>
+void fused_l2_closest_landmarks(raft::resources const& handle,
+                                const BallCoverIndex<value_idx, value_t, value_int>& index,
+                                const value_t* query_pts,
+                                value_int n_query_pts,
+                                value_idx* R_knn_inds,
+                                value_t* R_knn_dists)
+{
+  auto stream = resource::get_cuda_stream(handle);
+  auto R      = index.get_R();
+
+  rmm::device_uvector<value_t> query_norms(n_query_pts, stream);
+  rmm::device_uvector<value_t> R_norms(index.n_landmarks, stream);
+  rmm::device_uvector<int> workspace(n_query_pts, stream);
+  rmm::device_uvector<raft::KeyValuePair<value_idx, value_t>> nn(n_query_pts, stream);
+
+  raft::linalg::rowNorm<value_t, value_idx>(
+    query_norms.data(), query_pts, index.n, n_query_pts, raft::linalg::L2Norm, true, stream);
+  raft::linalg::rowNorm<value_t, value_idx>(R_norms.data(),
+                                            R.data_handle(),
+                                            index.n,
+                                            index.n_landmarks,
+                                            raft::linalg::L2Norm,
+                                            true,
+                                            stream);
+  raft::distance::fusedL2NNMinReduce<value_t, raft::KeyValuePair<value_idx, value_t>, value_idx>(
+    nn.data(),
+    query_pts,
+    R.data_handle(),
+    query_norms.data(),
+    R_norms.data(),
+    n_query_pts,
+    index.n_landmarks,
+    index.n,
+    workspace.data(),
+    true,
+    true,
+    stream);
+
+  const raft::KeyValuePair<value_idx, value_t>* nn_ptr = nn.data();
+  const value_t* R_ptr                                  = R.data_handle();
+  const value_int n                                     = index.n;
+
+  auto idxs = thrust::make_counting_iterator<value_idx>(0);
+  thrust::for_each(
+    resource::get_thrust_policy(handle), idxs, idxs + n_query_pts, [=] __device__(value_idx i) {
+      value_idx landmark = nn_ptr[i].key;
+      value_t dist       = 0;
+      for (value_int j = 0; j < n; ++j) {
+        value_t diff = query_pts[i * n + j] - R_ptr[landmark * n + j];
+        dist += diff * diff;
+      }
+      R_knn_inds[i]  = landmark;
+      R_knn_dists[i] = raft::sqrt(dist);
+    });
+}
+
+/**
+ * Computes the closest landmark of every one of a set of query points in the metric space of the
+ * balls. The balls of all but the cosine and the Haversine distances are Euclidean.
+ */
+template <typename value_idx, typename value_t, typename value_int = std::uint32_t>
+void closest_landmarks(raft::resources const& handle,
+                       const BallCoverIndex<value_idx, value_t, value_int>& index,
+                       const value_t* query_pts,
+                       value_int n_query_pts,
+                       value_idx* R_knn_inds,
+                       value_t* R_knn_dists)
+{
+  auto metric = index.get_metric();
+  if (metric == raft::distance::DistanceType::Haversine) {
+    k_closest_landmarks(
+      handle, index, query_pts, n_query_pts, value_int(1), R_knn_inds, R_knn_dists);
+  } else if (metric == raft::distance::DistanceType::CosineExpanded) {
+    rbc_gemm_closest_landmarks(handle, index, query_pts, n_query_pts, R_knn_inds, R_knn_dists);
+  } else {
+    fused_l2_closest_landmarks(handle, index, query_pts, n_query_pts, R_knn_inds, R_knn_dists);
+  }
+}
+
 /**
  * Uses the sorted data points in the 1-nn landmark index to compute
  * an array of radii for each landmark.
@@ -218,8 +357,9 @@ void compute_landmark_radii(raft::resources const& handle,
                    entries,
                    entries + index.n_landmarks,
                    [=] __device__(value_idx input) {
-                     value_idx last_row_idx = R_indptr_ptr[input + 1] - 1;
-                     R_radius_ptr[input]    = R_1nn_dists_ptr[last_row_idx];
+                     value_idx start     = R_indptr_ptr[input];
+                     value_idx end       = R_indptr_ptr[input + 1];
+                     R_radius_ptr[input] = end > start ? R_1nn_dists_ptr[end - 1] : value_t(0);
                    });
 }
 
@@ -343,7 +483,8 @@ void rbc_build_index(raft::resources const& handle,
                      BallCoverIndex<value_idx, value_t, value_int>& index,
                      distance_func dfunc)
 {
-  ASSERT(index.n <= 3, "only 2d and 3d vectors are supported in current implementation");
+  ASSERT(index.n <= 3 || use_rbc_gemm(index),
+         "only 2d and 3d vectors are supported in current implementation");
   ASSERT(!index.is_index_trained(), "index cannot be previously trained");
 
   rmm::device_uvector<value_idx> R_knn_inds(index.m, resource::get_cuda_stream(handle));
@@ -364,25 +505,26 @@ void rbc_build_index(raft::resources const& handle,
   sample_landmarks<value_idx, value_t>(handle, index);
 
   /**
-   * 2. Perform knn = bfknn(X, R, k)
+   * 2. Assign every point to its closest landmark
    */
-  value_int k = 1;
-  k_closest_landmarks(handle,
-                      index,
-                      index.get_X().data_handle(),
-                      index.m,
-                      k,
-                      R_knn_inds.data(),
-                      index.get_R_closest_landmark_dists().data_handle());
+  closest_landmarks(handle,
+                    index,
+                    index.get_X().data_handle(),
+                    index.m,
+                    R_knn_inds.data(),
+                    index.get_R_closest_landmark_dists().data_handle());
 
   /**
    * 3. Create L_r = knn[:,0].T (CSR)
    *
-   * Slice closest neighboring R
-   * Secondary sort by (R_knn_inds, R_knn_dists)
+   * Count, scan and scatter the points into the balls of the landmarks
+   * and sort every ball by distance
    */
-  construct_landmark_1nn(
-    handle, R_knn_inds.data(), index.get_R_closest_landmark_dists().data_handle(), k, index);
+  construct_landmark_1nn(handle,
+                         R_knn_inds.data(),
+                         index.get_R_closest_landmark_dists().data_handle(),
+                         value_int(1),
+                         index);
 
   /**
    * Compute radius of each R for filtering: p(q, r) <= p(q, q_r) + radius(r)
@@ -391,6 +533,74 @@ void rbc_build_index(raft::resources const& handle,
   compute_landmark_radii(handle, index);
 }
 
+/**
+ * Extends a built index with new points without rebuilding it: the landmarks are kept, only the
+ * new points are assigned to their closest landmarks, and the balls and their radii are rebuilt
+ * from the assignment. The first index.m rows of X must be the points already in the index.
+ *
+ * The landmarks are not resampled, so the balls get unbalanced when the index grows by a large
+ * factor or the new points come from a different distribution; rebuild the index then.
+ */
+template <typename value_idx = std::int64_t, typename value_t, typename value_int = std::uint32_t>
+void rbc_extend_index(raft::resources const& handle,
+                      BallCoverIndex<value_idx, value_t, value_int>& index,
+                      const value_t* X,
+                      value_int n_rows)
+{
+  ASSERT(index.is_index_trained(), "index must be previously trained");
+  ASSERT(n_rows >= index.m, "the extended dataset must contain the points of the index");
+
+  auto stream           = resource::get_cuda_stream(handle);
+  const value_int m_old = index.m;
+
+  rmm::device_uvector<value_idx> R_knn_inds(n_rows, stream);
+  rmm::device_uvector<value_t> R_knn_dists(n_rows, stream);
+
+  /**
+   * 1. Recover the landmarks of the indexed points from the balls
+   */
+  {
+    rmm::device_uvector<value_idx> entry_landmarks(m_old, stream);
+    const value_idx* R_indptr_ptr = index.get_R_indptr().data_handle();
+    auto entries                  = thrust::make_counting_iterator<value_idx>(0);
+    thrust::upper_bound(resource::get_thrust_policy(handle),
+                        R_indptr_ptr + 1,
+                        R_indptr_ptr + 1 + index.n_landmarks,
+                        entries,
+                        entries + m_old,
+                        entry_landmarks.begin());
+    thrust::scatter(resource::get_thrust_policy(handle),
+                    entry_landmarks.begin(),
+                    entry_landmarks.end(),
+                    index.get_R_1nn_cols().data_handle(),
+                    R_knn_inds.begin());
+    thrust::scatter(resource::get_thrust_policy(handle),
+                    index.get_R_1nn_dists().data_handle(),
+                    index.get_R_1nn_dists().data_handle() + m_old,
+                    index.get_R_1nn_cols().data_handle(),
+                    R_knn_dists.begin());
+  }
+
+  /**
+   * 2. Assign the new points to their closest landmarks
+   */
+  closest_landmarks(handle,
+                    index,
+                    X + static_cast<size_t>(m_old) * index.n,
+                    n_rows - m_old,
+                    R_knn_inds.data() + m_old,
+                    R_knn_dists.data() + m_old);
+
+  /**
+   * 3. Rebuild the balls over all the points
+   */
+  index.reset_X(make_device_matrix_view<const value_t, std::uint32_t>(X, n_rows, index.n));
+  raft::copy(
+    index.get_R_closest_landmark_dists().data_handle(), R_knn_dists.data(), n_rows, stream);
+  construct_landmark_1nn(handle, R_knn_inds.data(), R_knn_dists.data(), value_int(1), index);
+  compute_landmark_radii(handle, index);
+}
+
 /**
  * Performs an all neighbors knn query (e.g. index == query)
  */
@@ -408,10 +618,25 @@ void rbc_all_knn_query(raft::resources const& handle,
                        bool perform_post_filtering = true,
                        float weight                = 1.0)
 {
-  ASSERT(index.n <= 3, "only 2d and 3d vectors are supported in current implementation");
+  ASSERT(index.n <= 3 || use_rbc_gemm(index),
+         "only 2d and 3d vectors are supported in current implementation");
   ASSERT(index.n_landmarks >= k, "number of landmark samples must be >= k");
   ASSERT(!index.is_index_trained(), "index cannot be previously trained");
 
+  if (use_rbc_gemm(index)) {
+    rbc_build_index(handle, index, dfunc);
+    rbc_gemm_knn_query(handle,
+                       index,
+                       k,
+                       index.get_X().data_handle(),
+                       index.m,
+                       inds,
+                       dists,
+                       perform_post_filtering,
+                       weight);
+    return;
+  }
+
   rmm::device_uvector<value_idx> R_knn_inds(k * index.m, resource::get_cuda_stream(handle));
   rmm::device_uvector<value_t> R_knn_dists(k * index.m, resource::get_cuda_stream(handle));
 
@@ -483,10 +708,17 @@ void rbc_knn_query(raft::resources const& handle,
                    bool perform_post_filtering = true,
                    float weight                = 1.0)
 {
-  ASSERT(index.n <= 3, "only 2d and 3d vectors are supported in current implementation");
+  ASSERT(index.n <= 3 || use_rbc_gemm(index),
+         "only 2d and 3d vectors are supported in current implementation");
   ASSERT(index.n_landmarks >= k, "number of landmark samples must be >= k");
   ASSERT(index.is_index_trained(), "index must be previously trained");
 
+  if (use_rbc_gemm(index)) {
+    rbc_gemm_knn_query(
+      handle, index, k, query, n_query_pts, inds, dists, perform_post_filtering, weight);
+    return;
+  }
+
   rmm::device_uvector<value_idx> R_knn_inds(k * n_query_pts, resource::get_cuda_stream(handle));
   rmm::device_uvector<value_t> R_knn_dists(k * n_query_pts, resource::get_cuda_stream(handle));
 
@@ -0,0 +1,693 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "../../ball_cover_types.hpp"
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/math.hpp>
+#include <raft/core/nvtx.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/linalg/gemm.cuh>
+#include <raft/linalg/map.cuh>
+#include <raft/linalg/norm.cuh>
+#include <raft/matrix/detail/select_k.cuh>
+#include <raft/matrix/gather.cuh>
+#include <raft/neighbors/brute_force.cuh>
+#include <raft/neighbors/detail/ivf_adaptive_probes.cuh>
+#include <raft/neighbors/detail/ivf_probe_inversion.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_buffer.hpp>
+#include <rmm/device_uvector.hpp>
+
+#include <cub/cub.cuh>
+#include <thrust/fill.h>
+#include <thrust/for_each.h>
+#include <thrust/functional.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/reduce.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace raft {
+namespace spatial {
+namespace knn {
+namespace detail {
+
+/*
+ * The GEMM-based random ball cover.
+ *
+ * The register-resident kernels (registers-inl.cuh) compute the distances point by point and are
+ * specialized for the 2D/3D Euclidean and Haversine distances. For higher dimensions, both the
+ * landmark assignment and the scan of the balls are done by the tiled GEMM followed by `select_k`:
+ * the (query, ball) pairs are grouped by the ball, so that each ball is read once per query batch
+ * and compared to all the queries probing it by a single GEMM.
+ *
+ * The balls are built in a metric space even when the index metric is not a metric:
+ *   - L2 distances (squared or not) and the inner product use the (non-squared) L2 distance;
+ *   - the cosine distance uses the chordal distance between the normalized vectors,
+ *     `sqrt(2 * (1 - cos(x, y)))`.
+ * A ball `l` with the landmark `r_l` and the radius `R_l` is pruned for a query `q` using the bound
+ * on the best index metric value achievable within the ball:
+ *   - L2/cosine (the lower bound on the distance): `d(q, r_l) - R_l`;
+ *   - inner product (Cauchy-Schwarz; the upper bound on the similarity): `<q, r_l> + |q| R_l`.
+ */
+
+/** The maximum number of elements in a distance tile of the ball scan. */
+constexpr static inline size_t kRbcGemmMaxTileSize = size_t{1} << 26;
+/** The maximum size of the temporary buffers of a query batch (bytes). */
+constexpr static inline size_t kRbcGemmMaxBatchBytes = size_t{1} << 30;
+
+/** Whether the metric is supported by the GEMM-based random ball cover. */
+inline bool is_rbc_gemm_metric(raft::distance::DistanceType metric)
+{
+  switch (metric) {
+    case raft::distance::DistanceType::L2Expanded:
+    case raft::distance::DistanceType::L2SqrtExpanded:
+    case raft::distance::DistanceType::L2Unexpanded:
+    case raft::distance::DistanceType::L2SqrtUnexpanded:
+    case raft::distance::DistanceType::CosineExpanded:
+    case raft::distance::DistanceType::InnerProduct: return true;
+    default: return false;
+  }
+}
+
+/**
+ * Whether the index is built and searched by the GEMM-based random ball cover rather than by the
+ * register-resident kernels (the 2D/3D Euclidean and the Haversine distances).
+ */
+template <typename value_idx, typename value_t, typename value_int = std::uint32_t>
+bool use_rbc_gemm(const BallCoverIndex<value_idx, value_t, value_int>& index)
+{
+  auto metric = index.get_metric();
+  if (metric == raft::distance::DistanceType::Haversine) { return false; }
+  return index.n > 3 || (metric != raft::distance::DistanceType::L2SqrtExpanded &&
+                         metric != raft::distance::DistanceType::L2SqrtUnexpanded);
+}
+
+/** Convert a value of the index metric to the metric space of the balls (see above). */
+template <typename value_t>
+__host__ __device__ inline value_t rbc_gemm_to_ball_metric(raft::distance::DistanceType metric,
+                                                          value_t d)
+{
+  switch (metric) {
+    case raft::distance::DistanceType::L2Expanded:
+    case raft::distance::DistanceType::L2Unexpanded: return raft::sqrt(raft::max(d, value_t(0)));
+    case raft::distance::DistanceType::CosineExpanded:
+      return raft::sqrt(raft::max(value_t(2) * d, value_t(0)));
+    default: return d;
+  }
+}
+
+/**
+ * Computes the closest landmark of every point in the metric space of the balls.
+ * @param[in] handle
+ * @param[in] index
+ * @param[in] query_pts the points [n_query_pts, index.n]
+ * @param[in] n_query_pts
+ * @param[out] R_knn_inds the closest landmarks [n_query_pts]
+ * @param[out] R_knn_dists the distances to the closest landmarks [n_query_pts]
+ */
+template <typename value_idx, typename value_t, typename value_int = std::uint32_t>
+void rbc_gemm_closest_landmarks(raft::resources const& handle,
+                                const BallCoverIndex<value_idx, value_t, value_int>& index,
+                                const value_t* query_pts,
+                                value_int n_query_pts,
+                                value_idx* R_knn_inds,
+                                value_t* R_knn_dists)
+{
+  RAFT_EXPECTS(is_rbc_gemm_metric(index.get_metric()),
+               "Metric %d is not supported by the random ball cover",
+               static_cast<int>(index.get_metric()));
+  const bool is_cosine = index.get_metric() == raft::distance::DistanceType::CosineExpanded;
+  const auto metric   = is_cosine ? raft::distance::DistanceType::CosineExpanded
+                                  : raft::distance::DistanceType::L2SqrtExpanded;
+
+  std::vector<raft::device_matrix_view<const value_t, value_int>> inputs = {index.get_R()};
+  raft::neighbors::brute_force::knn<value_idx, value_t, value_int>(
+    handle,
+    inputs,
+    make_device_matrix_view(query_pts, n_query_pts, index.n),
+    make_device_matrix_view(R_knn_inds, n_query_pts, value_int(1)),
+    make_device_matrix_view(R_knn_dists, n_query_pts, value_int(1)),
+    metric);
+
+  if (is_cosine) {
+    linalg::map(handle,
+                make_device_vector_view<value_t, value_int>(R_knn_dists, n_query_pts),
+                [metric] __device__(value_t d) { return rbc_gemm_to_ball_metric(metric, d); },
+                make_device_vector_view<const value_t, value_int>(R_knn_dists, n_query_pts));
+  }
+}
+
+/**
+ * Sorts every row of a row-major [n_rows, n_cols] matrix of keys together with the values.
+ */
+template <typename key_t, typename value_t>
+void rbc_gemm_sort_rows(raft::resources const& handle,
+                        const key_t* keys_in,
+                        const value_t* values_in,
+                        uint32_t n_rows,
+                        uint32_t n_cols,
+                        bool ascending,
+                        key_t* keys_out,
+                        value_t* values_out,
+                        rmm::mr::device_memory_resource* mr)
+{
+  auto stream = resource::get_cuda_stream(handle);
+  rmm::device_uvector<int> offsets(n_rows + 1, stream, mr);
+  linalg::map_offset(handle,
+                     make_device_vector_view<int, uint32_t>(offsets.data(), n_rows + 1),
+                     raft::mul_const_op<int>(n_cols));
+
+  const int n_items         = n_rows * n_cols;
+  size_t cub_workspace_size = 0;
+
+  // The first call (without the workspace) only computes the workspace size
+  auto sort = [&](void* workspace) {
+    if (ascending) {
+      RAFT_CUDA_TRY(cub::DeviceSegmentedRadixSort::SortPairs(workspace,
+                                                             cub_workspace_size,
+                                                             keys_in,
+                                                             keys_out,
+                                                             values_in,
+                                                             values_out,
+                                                             n_items,
+                                                             n_rows,
+                                                             offsets.data(),
+                                                             offsets.data() + 1,
+                                                             0,
+                                                             sizeof(key_t) * 8,
+                                                             stream));
+    } else {
+      RAFT_CUDA_TRY(cub::DeviceSegmentedRadixSort::SortPairsDescending(workspace,
+                                                                       cub_workspace_size,
+                                                                       keys_in,
+                                                                       keys_out,
+                                                                       values_in,
+                                                                       values_out,
+                                                                       n_items,
+                                                                       n_rows,
+                                                                       offsets.data(),
+                                                                       offsets.data() + 1,
+                                                                       0,
+                                                                       sizeof(key_t) * 8,
+                                                                       stream));
+    }
+  };
+  sort(nullptr);
+  rmm::device_buffer cub_workspace(cub_workspace_size, stream, mr);
+  sort(cub_workspace.data());
+}
+
+/**
+ * Scans the given balls for every query: computes the k best candidates in every probed ball.
+ *
+ * The results of the pair (query `i`, probe `j`) are written to
+ * `out_[dists|inds][i * ld_out + j * k : i * ld_out + (j + 1) * k]`; the slots of the skipped
+ * probes (`kSkippedProbe`) and of the balls smaller than k are left intact.
+ *
+ * @param[in] handle
+ * @param[in] index
+ * @param[in] R_indptr the ball offsets (host copy of `index.get_R_indptr()`)
+ * @param[in] queries [n_queries, index.n]
+ * @param n_queries
+ * @param[in] balls the probed balls [n_queries, n_probes]
+ * @param n_probes
+ * @param k
+ * @param ld_out the row stride of the output (in elements)
+ * @param[out] out_dists
+ * @param[out] out_inds
+ * @param mr the memory resource for the temporary buffers
+ */
+template <typename value_idx, typename value_t, typename value_int = std::uint32_t>
+void rbc_gemm_scan_balls(raft::resources const& handle,
+                         const BallCoverIndex<value_idx, value_t, value_int>& index,
+                         const std::vector<value_idx>& R_indptr,
+                         const value_t* queries,
+                         uint32_t n_queries,
+                         const uint32_t* balls,
+                         uint32_t n_probes,
+                         uint32_t k,
+                         size_t ld_out,
+                         value_t* out_dists,
+                         value_idx* out_inds,
+                         rmm::mr::device_memory_resource* mr)
+{
+  auto stream            = resource::get_cuda_stream(handle);
+  const uint32_t dim     = index.n;
+  const uint32_t n_balls = index.n_landmarks;
+  const auto metric      = index.get_metric();
+  const bool select_min  = metric != raft::distance::DistanceType::InnerProduct;
+  const bool need_norms  = metric != raft::distance::DistanceType::InnerProduct;
+  const value_t alpha    = 1;
+  const value_t beta     = 0;
+  const value_idx* R_1nn = index.get_R_1nn_cols().data_handle();
+  const value_t* X       = index.get_X().data_handle();
+
+  // Group the (query, probe) pairs by the probed ball
+  rmm::device_uvector<uint32_t> pair_rows(size_t(n_queries) * n_probes, stream, mr);
+  rmm::device_uvector<uint32_t> ball_offsets_dev(n_balls + 1, stream, mr);
+  raft::neighbors::ivf::detail::invert_probes(
+    handle, balls, n_queries, n_probes, n_balls, pair_rows.data(), ball_offsets_dev.data(), mr);
+  std::vector<uint32_t> ball_offsets(n_balls + 1);
+  raft::copy(ball_offsets.data(), ball_offsets_dev.data(), n_balls + 1, stream);
+  resource::sync_stream(handle);
+
+  uint32_t max_ball_size = 0;
+  for (uint32_t l = 0; l < n_balls; l++) {
+    if (ball_offsets[l + 1] > ball_offsets[l]) {
+      max_ball_size = std::max<uint32_t>(max_ball_size, R_indptr[l + 1] - R_indptr[l]);
+    }
+  }
+  rmm::device_uvector<value_t> ball_vectors(size_t(max_ball_size) * dim, stream, mr);
+  rmm::device_uvector<value_t> ball_norms(need_norms ? max_ball_size : 0, stream, mr);
+
+  for (uint32_t l = 0; l < n_balls; l++) {
+    const uint32_t n_ball_queries = ball_offsets[l + 1] - ball_offsets[l];
+    const uint32_t ball_size      = R_indptr[l + 1] - R_indptr[l];
+    if (n_ball_queries == 0 || ball_size == 0) { continue; }
+    const value_idx* ball_ids = R_1nn + R_indptr[l];
+    const uint32_t* ball_rows = pair_rows.data() + ball_offsets[l];
+
+    raft::matrix::gather(X, dim, index.m, ball_ids, ball_size, ball_vectors.data(), stream);
+    if (need_norms) {
+      raft::linalg::rowNorm(ball_norms.data(),
+                            ball_vectors.data(),
+                            dim,
+                            ball_size,
+                            raft::linalg::L2Norm,
+                            true,
+                            stream);
+    }
+
+    // Tile the queries to bound the size of the distance buffer
+    const uint32_t max_tile_rows = std::clamp<size_t>(
+      kRbcGemmMaxTileSize / ball_size, size_t{1}, size_t{n_ball_queries});
+    const uint32_t k_tile = std::min(k, ball_size);
+    rmm::device_uvector<value_t> tile_queries(size_t(max_tile_rows) * dim, stream, mr);
+    rmm::device_uvector<value_t> tile_norms(need_norms ? max_tile_rows : 0, stream, mr);
+    rmm::device_uvector<value_t> tile_dists(size_t(max_tile_rows) * ball_size, stream, mr);
+    rmm::device_uvector<value_t> tile_best_dists(size_t(max_tile_rows) * k_tile, stream, mr);
+    rmm::device_uvector<uint32_t> tile_best_positions(size_t(max_tile_rows) * k_tile, stream, mr);
+    for (uint32_t offset = 0; offset < n_ball_queries; offset += max_tile_rows) {
+      const uint32_t n_rows = std::min(max_tile_rows, n_ball_queries - offset);
+      raft::matrix::gather(queries,
+                           dim,
+                           n_queries,
+                           ball_rows + offset,
+                           n_rows,
+                           tile_queries.data(),
+                           raft::div_const_op<uint32_t>(n_probes),
+                           stream);
+      if (need_norms) {
+        raft::linalg::rowNorm(tile_norms.data(),
+                              tile_queries.data(),
+                              dim,
+                              n_rows,
+                              raft::linalg::L2Norm,
+                              true,
+                              stream);
+      }
+      linalg::gemm(handle,
+                   true,
+                   false,
+                   ball_size,
+                   n_rows,
+                   dim,
+                   &alpha,
+                   ball_vectors.data(),
+                   dim,
+                   tile_queries.data(),
+                   dim,
+                   &beta,
+                   tile_dists.data(),
+                   ball_size,
+                   stream);
+      if (need_norms) {
+        // Turn the dot products into the distances
+        const value_t* qn = tile_norms.data();
+        const value_t* xn = ball_norms.data();
+        value_t* dots     = tile_dists.data();
+        linalg::map_offset(
+          handle,
+          make_device_vector_view<value_t, size_t>(dots, size_t(n_rows) * ball_size),
+          [=] __device__(size_t i) {
+            const size_t row = i / ball_size;
+            const size_t col = i % ball_size;
+            if (metric == raft::distance::DistanceType::CosineExpanded) {
+              return value_t(1) - dots[i] / raft::sqrt(qn[row] * xn[col]);
+            }
+            // The expanded form of the L2 distance may go slightly below zero due to the rounding
+            value_t d = raft::max(qn[row] + xn[col] - value_t(2) * dots[i], value_t(0));
+            return metric == raft::distance::DistanceType::L2SqrtExpanded ||
+                       metric == raft::distance::DistanceType::L2SqrtUnexpanded
+                     ? raft::sqrt(d)
+                     : d;
+          });
+      }
+      matrix::detail::select_k<value_t, uint32_t>(tile_dists.data(),
+                                                  nullptr,
+                                                  n_rows,
+                                                  ball_size,
+                                                  k_tile,
+                                                  tile_best_dists.data(),
+                                                  tile_best_positions.data(),
+                                                  select_min,
+                                                  stream,
+                                                  mr);
+
+      const uint32_t* rows      = ball_rows + offset;
+      const value_t* best_dists = tile_best_dists.data();
+      const uint32_t* best_pos  = tile_best_positions.data();
+      auto entries              = thrust::make_counting_iterator<size_t>(0);
+      thrust::for_each(resource::get_thrust_policy(handle),
+                       entries,
+                       entries + size_t(n_rows) * k_tile,
+                       [=] __device__(size_t i) {
+                         const uint32_t row  = i / k_tile;
+                         const uint32_t j    = i % k_tile;
+                         const uint32_t pair = rows[row];
+                         const size_t out_ix =
+                           (pair / n_probes) * ld_out + (pair % n_probes) * size_t(k) + j;
+                         out_dists[out_ix] = best_dists[i];
+                         out_inds[out_ix]  = ball_ids[best_pos[i]];
+                       });
+    }
+  }
+}
+
+/**
+ * Performs an exact (when `perform_post_filtering` and `weight == 1`) knn query against a built
+ * index using the GEMM-based random ball cover.
+ *
+ * For every query, the balls are ordered by the bound on the best index metric value achievable
+ * within them (see above). The first `min(k, n_landmarks)` balls are scanned unconditionally
+ * (pass one); then the following balls are scanned in groups of the same size, for as long as
+ * their bound is better than the current k-th neighbor of the query (pass two).
+ */
+template <typename value_idx, typename value_t, typename value_int = std::uint32_t>
+void rbc_gemm_knn_query(raft::resources const& handle,
+                        const BallCoverIndex<value_idx, value_t, value_int>& index,
+                        value_int k,
+                        const value_t* query,
+                        value_int n_query_pts,
+                        value_idx* inds,
+                        value_t* dists,
+                        bool perform_post_filtering = true,
+                        float weight                = 1.0)
+{
+  common::nvtx::range<common::nvtx::domain::raft> fun_scope(
+    "ball_cover::rbc_gemm_knn_query(n_query_pts = %u, k = %u)",
+    uint32_t(n_query_pts),
+    uint32_t(k));
+  RAFT_EXPECTS(is_rbc_gemm_metric(index.get_metric()),
+               "Metric %d is not supported by the random ball cover",
+               static_cast<int>(index.get_metric()));
+
+  auto stream             = resource::get_cuda_stream(handle);
+  auto mr                 = resource::get_workspace_resource(handle);
+  const auto metric       = index.get_metric();
+  const bool select_min   = metric != raft::distance::DistanceType::InnerProduct;
+  const bool is_cosine    = metric == raft::distance::DistanceType::CosineExpanded;
+  const uint32_t dim      = index.n;
+  const uint32_t n_balls  = index.n_landmarks;
+  const uint32_t n_probes = std::min<uint32_t>(k, n_balls);
+
+  const value_idx dummy_ind = std::numeric_limits<value_idx>::max();
+  const value_t dummy_dist =
+    select_min ? std::numeric_limits<value_t>::max() : std::numeric_limits<value_t>::lowest();
+
+  const value_t* R        = index.get_R().data_handle();
+  const value_t* R_radius = index.get_R_radius().data_handle();
+  rmm::device_uvector<value_t> R_norms(n_balls, stream, mr);
+  raft::linalg::rowNorm(R_norms.data(), R, dim, n_balls, raft::linalg::L2Norm, true, stream);
+  std::vector<value_idx> R_indptr(n_balls + 1);
+  raft::copy(R_indptr.data(), index.get_R_indptr().data_handle(), n_balls + 1, stream);
+
+  const size_t bytes_per_query =
+    size_t(n_balls) * (2 * sizeof(value_t) + 2 * sizeof(uint32_t)) +
+    size_t(n_probes + 1) * k * 2 * (sizeof(value_t) + sizeof(value_idx));
+  const uint32_t max_batch_size =
+    std::clamp<size_t>(kRbcGemmMaxBatchBytes / bytes_per_query, 1, n_query_pts);
+
+  rmm::device_uvector<value_t> query_norms(max_batch_size, stream, mr);
+  rmm::device_uvector<value_t> bounds(size_t(max_batch_size) * n_balls, stream, mr);
+  rmm::device_uvector<value_t> sorted_bounds(size_t(max_batch_size) * n_balls, stream, mr);
+  rmm::device_uvector<uint32_t> ball_ids(size_t(max_batch_size) * n_balls, stream, mr);
+  rmm::device_uvector<uint32_t> sorted_balls(size_t(max_batch_size) * n_balls, stream, mr);
+  rmm::device_uvector<uint32_t> probes(size_t(max_batch_size) * n_probes, stream, mr);
+  rmm::device_uvector<uint32_t> n_passing(max_batch_size, stream, mr);
+  rmm::device_uvector<value_t> cand_dists(size_t(max_batch_size) * (n_probes + 1) * k, stream, mr);
+  rmm::device_uvector<value_idx> cand_inds(size_t(max_batch_size) * (n_probes + 1) * k, stream, mr);
+  rmm::device_uvector<value_t> best_dists(size_t(max_batch_size) * k, stream, mr);
+  rmm::device_uvector<value_idx> best_inds(size_t(max_batch_size) * k, stream, mr);
+
+  for (uint32_t offset = 0; offset < n_query_pts; offset += max_batch_size) {
+    const uint32_t batch_size = std::min<uint32_t>(max_batch_size, n_query_pts - offset);
+    const value_t* batch      = query + size_t(offset) * dim;
+
+    /**
+     * 1. Bound the best achievable value of the metric within every ball for every query and
+     *    order the balls by it.
+     */
+    raft::linalg::rowNorm(
+      query_norms.data(), batch, dim, batch_size, raft::linalg::L2Norm, true, stream);
+    const value_t bound_alpha = 1;
+    const value_t bound_beta  = 0;
+    linalg::gemm(handle,
+                 true,
+                 false,
+                 n_balls,
+                 batch_size,
+                 dim,
+                 &bound_alpha,
+                 R,
+                 dim,
+                 batch,
+                 dim,
+                 &bound_beta,
+                 bounds.data(),
+                 n_balls,
+                 stream);
+    {
+      const value_t* qn = query_norms.data();
+      const value_t* rn = R_norms.data();
+      value_t* dots     = bounds.data();
+      const value_t w   = weight;
+      linalg::map_offset(
+        handle,
+        make_device_vector_view<value_t, size_t>(dots, size_t(batch_size) * n_balls),
+        [=] __device__(size_t i) {
+          const size_t row = i / n_balls;
+          const size_t l   = i % n_balls;
+          if (!select_min) { return dots[i] + w * raft::sqrt(qn[row]) * R_radius[l]; }
+          value_t d;
+          if (is_cosine) {
+            d = raft::sqrt(raft::max(
+              value_t(2) - value_t(2) * dots[i] / raft::sqrt(qn[row] * rn[l]), value_t(0)));
+          } else {
+            d = raft::sqrt(raft::max(qn[row] + rn[l] - value_t(2) * dots[i], value_t(0)));
+          }
+          return d - w * R_radius[l];
+        });
+    }
+    linalg::map_offset(
+      handle,
+      make_device_vector_view<uint32_t, size_t>(ball_ids.data(), size_t(batch_size) * n_balls),
+      raft::mod_const_op<size_t>(n_balls));
+    rbc_gemm_sort_rows(handle,
+                       bounds.data(),
+                       ball_ids.data(),
+                       batch_size,
+                       n_balls,
+                       select_min,
+                       sorted_bounds.data(),
+                       sorted_balls.data(),
+                       mr);
+
+    /**
+     * 2. Scan the first n_probes balls of every query.
+     */
+    {
+      const uint32_t* sb = sorted_balls.data();
+      linalg::map_offset(
+        handle,
+        make_device_vector_view<uint32_t, size_t>(probes.data(), size_t(batch_size) * n_probes),
+        [=] __device__(size_t i) { return sb[(i / n_probes) * n_balls + i % n_probes]; });
+    }
+    thrust::fill_n(resource::get_thrust_policy(handle),
+                   cand_dists.data(),
+                   size_t(batch_size) * n_probes * k,
+                   dummy_dist);
+    thrust::fill_n(resource::get_thrust_policy(handle),
+                   cand_inds.data(),
+                   size_t(batch_size) * n_probes * k,
+                   dummy_ind);
+    rbc_gemm_scan_balls(handle,
+                        index,
+                        R_indptr,
+                        batch,
+                        batch_size,
+                        probes.data(),
+                        n_probes,
+                        k,
+                        size_t(n_probes) * k,
+                        cand_dists.data(),
+                        cand_inds.data(),
+                        mr);
+    matrix::detail::select_k<value_t, value_idx>(cand_dists.data(),
+                                                 cand_inds.data(),
+                                                 batch_size,
+                                                 size_t(n_probes) * k,
+                                                 k,
+                                                 best_dists.data(),
+                                                 best_inds.data(),
+                                                 select_min,
+                                                 stream,
+                                                 mr);
+
+    /**
+     * 3. Scan the following balls while their bounds are better than the current k-th neighbor.
+     */
+    for (uint32_t j0 = n_probes; perform_post_filtering && j0 < n_balls;) {
+      {
+        const value_t* bd = best_dists.data();
+        const value_t* sd = sorted_bounds.data();
+        linalg::map_offset(
+          handle,
+          make_device_vector_view<uint32_t, uint32_t>(n_passing.data(), batch_size),
+          [=] __device__(uint32_t row) {
+            // The current k-th neighbor (the candidates are not sorted)
+            value_t kth = bd[size_t(row) * k];
+            for (uint32_t j = 1; j < k; j++) {
+              const value_t d = bd[size_t(row) * k + j];
+              kth             = select_min ? raft::max(kth, d) : raft::min(kth, d);
+            }
+            if (kth == dummy_dist) { return n_balls - j0; }
+            kth = rbc_gemm_to_ball_metric(metric, kth);
+            // The bounds are sorted; find the first ball, which cannot improve the result
+            uint32_t lo = j0;
+            uint32_t hi = n_balls;
+            while (lo < hi) {
+              const uint32_t mid = (lo + hi) / 2;
+              const value_t b    = sd[size_t(row) * n_balls + mid];
+              if (select_min ? b < kth : b > kth) {
+                lo = mid + 1;
+              } else {
+                hi = mid;
+              }
+            }
+            return lo - j0;
+          });
+      }
+      const uint32_t max_passing = thrust::reduce(resource::get_thrust_policy(handle),
+                                                  n_passing.data(),
+                                                  n_passing.data() + batch_size,
+                                                  uint32_t(0),
+                                                  thrust::maximum<uint32_t>());
+      const uint32_t n_next      = std::min(max_passing, n_probes);
+      if (n_next == 0) { break; }
+
+      {
+        const uint32_t* sb = sorted_balls.data();
+        const uint32_t* np = n_passing.data();
+        linalg::map_offset(
+          handle,
+          make_device_vector_view<uint32_t, size_t>(probes.data(), size_t(batch_size) * n_next),
+          [=] __device__(size_t i) {
+            const size_t row = i / n_next;
+            const uint32_t j = i % n_next;
+            return j < np[row] ? sb[row * n_balls + j0 + j]
+                               : raft::neighbors::ivf::detail::kSkippedProbe;
+          });
+      }
+      // The candidates of a query: the current best k followed by the results of the new balls
+      const size_t ld_cand = size_t(n_next + 1) * k;
+      thrust::fill_n(
+        resource::get_thrust_policy(handle), cand_dists.data(), batch_size * ld_cand, dummy_dist);
+      thrust::fill_n(
+        resource::get_thrust_policy(handle), cand_inds.data(), batch_size * ld_cand, dummy_ind);
+      RAFT_CUDA_TRY(cudaMemcpy2DAsync(cand_dists.data(),
+                                      sizeof(value_t) * ld_cand,
+                                      best_dists.data(),
+                                      sizeof(value_t) * k,
+                                      sizeof(value_t) * k,
+                                      batch_size,
+                                      cudaMemcpyDefault,
+                                      stream));
+      RAFT_CUDA_TRY(cudaMemcpy2DAsync(cand_inds.data(),
+                                      sizeof(value_idx) * ld_cand,
+                                      best_inds.data(),
+                                      sizeof(value_idx) * k,
+                                      sizeof(value_idx) * k,
+                                      batch_size,
+                                      cudaMemcpyDefault,
+                                      stream));
+      rbc_gemm_scan_balls(handle,
+                          index,
+                          R_indptr,
+                          batch,
+                          batch_size,
+                          probes.data(),
+                          n_next,
+                          k,
+                          ld_cand,
+                          cand_dists.data() + k,
+                          cand_inds.data() + k,
+                          mr);
+      matrix::detail::select_k<value_t, value_idx>(cand_dists.data(),
+                                                   cand_inds.data(),
+                                                   batch_size,
+                                                   ld_cand,
+                                                   k,
+                                                   best_dists.data(),
+                                                   best_inds.data(),
+                                                   select_min,
+                                                   stream,
+                                                   mr);
+      j0 += n_next;
+    }
+
+    /**
+     * 4. Sort the neighbors of every query.
+     */
+    rbc_gemm_sort_rows(handle,
+                       best_dists.data(),
+                       best_inds.data(),
+                       batch_size,
+                       k,
+                       select_min,
+                       dists + size_t(offset) * k,
+                       inds + size_t(offset) * k,
+                       mr);
+  }
+}
+
+};  // namespace detail
+};  // namespace knn
+};  // namespace spatial
+};  // namespace raft
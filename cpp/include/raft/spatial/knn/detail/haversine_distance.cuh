@@ -20,9 +20,14 @@
 #include <raft/util/cudart_utils.hpp>
 #include <raft/util/pow2_utils.cuh>
 
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/distance/distance_types.hpp>
 #include <raft/neighbors/detail/faiss_select/Select.cuh>
+#include <raft/neighbors/detail/knn_brute_force_fused.cuh>
+
+#include <rmm/device_uvector.hpp>
 
 namespace raft {
 namespace spatial {
@@ -137,6 +142,123 @@ void haversine_knn(value_idx* out_inds,
     out_inds, out_dists, index, query, n_index_rows, k);
 }
 
+/** The number of values per row of the unit sphere embedding (padded for the vector loads). */
+constexpr int kHaversineEmbeddingDim = 4;
+
+/**
+ * Map the points (latitude, longitude) in radians onto the unit sphere in 3D.
+ *
+ * The chord distance between two embedded points `c` relates to the great circle distance as
+ * `2 * asin(c / 2)`, so the nearest neighbors by the two distances are the same.
+ */
+template <typename value_t>
+__global__ void haversine_embed_kernel(const value_t* in, size_t n_rows, value_t* out)
+{
+  const size_t i = size_t(blockIdx.x) * blockDim.x + threadIdx.x;
+  if (i >= n_rows) { return; }
+  const value_t lat   = in[i * 2];
+  const value_t lon   = in[i * 2 + 1];
+  const value_t cos_0 = raft::cos(lat);
+  value_t* out_ptr    = out + i * kHaversineEmbeddingDim;
+  out_ptr[0]          = cos_0 * raft::cos(lon);
+  out_ptr[1]          = cos_0 * raft::sin(lon);
+  out_ptr[2]          = raft::sin(lat);
+  out_ptr[3]          = 0;
+}
+
+/**
+ * Replace the distances of the selected neighbors (a thread per query row) with the haversine
+ * distances computed on the original coordinates, re-sorting the row.
+ *
+ * The embedding loses a few bits of precision for the very close points, so their order may
+ * change slightly; the rows are almost sorted, hence the insertion sort.
+ */
+template <typename value_idx, typename value_t>
+__global__ void haversine_rescore_kernel(value_idx* inds,
+                                         value_t* dists,
+                                         const value_t* index,
+                                         const value_t* query,
+                                         size_t n_query_rows,
+                                         int k)
+{
+  const size_t row = size_t(blockIdx.x) * blockDim.x + threadIdx.x;
+  if (row >= n_query_rows) { return; }
+  inds += row * k;
+  dists += row * k;
+  const value_t x1 = query[row * 2];
+  const value_t x2 = query[row * 2 + 1];
+  for (int j = 0; j < k; j++) {
+    const value_idx id     = inds[j];
+    const value_t* idx_ptr = index + size_t(id) * 2;
+    const value_t dist     = compute_haversine(x1, idx_ptr[0], x2, idx_ptr[1]);
+    int l                  = j;
+    for (; l > 0 && dists[l - 1] > dist; l--) {
+      dists[l] = dists[l - 1];
+      inds[l]  = inds[l - 1];
+    }
+    dists[l] = dist;
+    inds[l]  = id;
+  }
+}
+
+/**
+ * Compute the k-nearest neighbors using the Haversine distance, see `haversine_knn` above.
+ *
+ * The points are embedded onto the unit sphere, so that the neighbors are found by the fused L2
+ * kNN kernel; the haversine distances of the selected neighbors are computed afterwards. This
+ * falls back to the direct haversine kernel when `k` is too large for the fused kernel.
+ */
+template <typename value_idx, typename value_t>
+void haversine_knn(raft::resources const& handle,
+                   value_idx* out_inds,
+                   value_t* out_dists,
+                   const value_t* index,
+                   const value_t* query,
+                   size_t n_index_rows,
+                   size_t n_query_rows,
+                   int k)
+{
+  auto stream = resource::get_cuda_stream(handle);
+  if (!raft::neighbors::detail::is_fused_knn_supported(
+        raft::distance::DistanceType::L2Unexpanded, k, n_index_rows)) {
+    haversine_knn(out_inds, out_dists, index, query, n_index_rows, n_query_rows, k, stream);
+    return;
+  }
+  auto mr                 = resource::get_workspace_resource(handle);
+  constexpr int kBlockDim = 256;
+
+  auto embed = [&](const value_t* in, size_t n_rows, rmm::device_uvector<value_t>& out) {
+    out.resize(n_rows * kHaversineEmbeddingDim, stream);
+    haversine_embed_kernel<<<raft::ceildiv<size_t>(n_rows, kBlockDim), kBlockDim, 0, stream>>>(
+      in, n_rows, out.data());
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+  };
+  rmm::device_uvector<value_t> index_emb(0, stream, mr);
+  rmm::device_uvector<value_t> query_emb(0, stream, mr);
+  embed(index, n_index_rows, index_emb);
+  const value_t* query_emb_ptr = index_emb.data();
+  if (query != index || n_query_rows != n_index_rows) {
+    embed(query, n_query_rows, query_emb);
+    query_emb_ptr = query_emb.data();
+  }
+
+  raft::neighbors::detail::fused_knn<value_t, value_idx>(
+    handle,
+    query_emb_ptr,
+    index_emb.data(),
+    n_query_rows,
+    n_index_rows,
+    kHaversineEmbeddingDim,
+    k,
+    out_dists,
+    out_inds,
+    raft::distance::DistanceType::L2Unexpanded);
+  const auto n_blocks = raft::ceildiv<size_t>(n_query_rows, kBlockDim);
+  haversine_rescore_kernel<<<n_blocks, kBlockDim, 0, stream>>>(
+    out_inds, out_dists, index, query, n_query_rows, k);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
 }  // namespace detail
 }  // namespace knn
 }  // namespace spatial
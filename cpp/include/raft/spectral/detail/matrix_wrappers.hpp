@@ -22,6 +22,7 @@
 #include <raft/core/resources.hpp>
 #include <raft/linalg/detail/cublas_wrappers.hpp>
 #include <raft/sparse/detail/cusparse_wrappers.h>
+#include <raft/sparse/linalg/sparse_operator.hpp>
 #include <raft/util/cudart_utils.hpp>
 #include <rmm/device_uvector.hpp>
 
@@ -29,8 +30,10 @@
 #include <thrust/fill.h>
 #include <thrust/reduce.h>
 #include <thrust/system/cuda/execution_policy.h>
+#include <thrust/transform.h>
 
 #include <algorithm>
+#include <memory>
 
 // =========================================================
 // Useful macros
@@ -62,6 +65,57 @@ static __global__ void diagmv(IndexType_ n,
   }
 }
 
+// Apply diagonal matrix to a column-major block of k vectors:
+//
+template <typename IndexType_, typename ValueType_>
+static __global__ void diagmm(IndexType_ n,
+                              IndexType_ k,
+                              ValueType_ alpha,
+                              const ValueType_* __restrict__ D,
+                              const ValueType_* __restrict__ x,
+                              ValueType_* __restrict__ y)
+{
+  size_t i = threadIdx.x + static_cast<size_t>(blockIdx.x) * blockDim.x;
+  while (i < static_cast<size_t>(n) * k) {
+    y[i] += alpha * D[i % n] * x[i];
+    i += static_cast<size_t>(blockDim.x) * gridDim.x;
+  }
+}
+
+// Scale vector by diagonal matrix:
+//
+template <typename IndexType_, typename ValueType_>
+static __global__ void diagscale(IndexType_ n,
+                                 const ValueType_* __restrict__ D,
+                                 const ValueType_* __restrict__ x,
+                                 ValueType_* __restrict__ y)
+{
+  IndexType_ i = threadIdx.x + blockIdx.x * blockDim.x;
+  while (i < n) {
+    y[i] = D[i] * x[i];
+    i += blockDim.x * gridDim.x;
+  }
+}
+
+// y = alpha*(x - D*z) + beta*y; y is not read when beta is zero:
+//
+template <typename IndexType_, typename ValueType_>
+static __global__ void normalized_laplacian_mv_finalize(IndexType_ n,
+                                                        ValueType_ alpha,
+                                                        ValueType_ beta,
+                                                        const ValueType_* __restrict__ D,
+                                                        const ValueType_* __restrict__ x,
+                                                        const ValueType_* __restrict__ z,
+                                                        ValueType_* __restrict__ y)
+{
+  IndexType_ i = threadIdx.x + blockIdx.x * blockDim.x;
+  while (i < n) {
+    ValueType_ res = alpha * (x[i] - D[i] * z[i]);
+    y[i]           = beta == ValueType_{0} ? res : res + beta * y[i];
+    i += blockDim.x * gridDim.x;
+  }
+}
+
 // specifies type of algorithm used
 // for SpMv:
 //
@@ -199,65 +253,31 @@ struct sparse_matrix_t {
     RAFT_EXPECTS(x != nullptr, "Null x buffer.");
     RAFT_EXPECTS(y != nullptr, "Null y buffer.");
 
-    auto cusparse_h = resource::get_cusparse_handle(handle_);
-    auto stream     = resource::get_cuda_stream(handle_);
-
-    cusparseOperation_t trans = transpose ? CUSPARSE_OPERATION_TRANSPOSE :  // transpose
-                                  CUSPARSE_OPERATION_NON_TRANSPOSE;         // non-transpose
+    auto stream = resource::get_cuda_stream(handle_);
 
 #if not defined CUDA_ENFORCE_LOWER and CUDA_VER_10_1_UP
     auto size_x = transpose ? nrows_ : ncols_;
     auto size_y = transpose ? ncols_ : nrows_;
 
-    cusparseSpMVAlg_t spmv_alg = translate_algorithm(alg);
-
-    // create descriptors:
-    //(below casts are necessary, because
-    // cusparseCreateCsr(...) takes non-const
-    // void*; the casts should be harmless)
-    //
-    cusparseSpMatDescr_t matA;
-    RAFT_CUSPARSE_TRY(raft::sparse::detail::cusparsecreatecsr(&matA,
-                                                              nrows_,
-                                                              ncols_,
-                                                              nnz_,
-                                                              const_cast<index_type*>(row_offsets_),
-                                                              const_cast<index_type*>(col_indices_),
-                                                              const_cast<value_type*>(values_)));
-
-    cusparseDnVecDescr_t vecX;
-    RAFT_CUSPARSE_TRY(raft::sparse::detail::cusparsecreatednvec(&vecX, size_x, x));
-
     rmm::device_uvector<value_type> y_tmp(size_y, stream);
     raft::copy(y_tmp.data(), y, size_y, stream);
 
-    cusparseDnVecDescr_t vecY;
-    RAFT_CUSPARSE_TRY(raft::sparse::detail::cusparsecreatednvec(&vecY, size_y, y_tmp.data()));
-
-    // get (scratch) external device buffer size:
-    //
-    size_t bufferSize;
-    RAFT_CUSPARSE_TRY(raft::sparse::detail::cusparsespmv_buffersize(
-      cusparse_h, trans, &alpha, matA, vecX, &beta, vecY, spmv_alg, &bufferSize, stream));
-
-    // allocate external buffer:
-    //
-    vector_t<value_type> external_buffer(handle_, bufferSize);
-
-    // finally perform SpMV:
-    //
-    RAFT_CUSPARSE_TRY(raft::sparse::detail::cusparsespmv(
-      cusparse_h, trans, &alpha, matA, vecX, &beta, vecY, spmv_alg, external_buffer.raw(), stream));
+    // the descriptors and the external buffer are reused by the following products
+    get_operator().spmv(transpose,
+                        &alpha,
+                        raft::make_device_vector_view<const value_type, index_type>(x, size_x),
+                        &beta,
+                        raft::make_device_vector_view<value_type, index_type>(y_tmp.data(), size_y),
+                        translate_algorithm(alg));
 
     // FIXME: This is a workaround for a cusparse issue being encountered in CUDA 12
     raft::copy(y, y_tmp.data(), size_y, stream);
-    // free descriptors:
-    //(TODO: maybe wrap them in a RAII struct?)
-    //
-    RAFT_CUSPARSE_TRY(cusparseDestroyDnVec(vecY));
-    RAFT_CUSPARSE_TRY(cusparseDestroyDnVec(vecX));
-    RAFT_CUSPARSE_TRY(cusparseDestroySpMat(matA));
 #else
+    auto cusparse_h = resource::get_cusparse_handle(handle_);
+
+    cusparseOperation_t trans = transpose ? CUSPARSE_OPERATION_TRANSPOSE :  // transpose
+                                  CUSPARSE_OPERATION_NON_TRANSPOSE;         // non-transpose
+
     RAFT_CUSPARSE_TRY(
       raft::sparse::detail::cusparsesetpointermode(cusparse_h, CUSPARSE_POINTER_MODE_HOST, stream));
     cusparseMatDescr_t descr = 0;
@@ -286,6 +306,32 @@ struct sparse_matrix_t {
 #endif
   }
 
+  // Y = alpha*A*X + beta*Y, where X and Y are column-major blocks of k vectors
+  //
+  virtual void mm(value_type alpha,
+                  value_type* __restrict__ x,
+                  index_type k,
+                  value_type beta,
+                  value_type* __restrict__ y) const
+  {
+    RAFT_EXPECTS(x != nullptr, "Null x buffer.");
+    RAFT_EXPECTS(y != nullptr, "Null y buffer.");
+
+#if not defined CUDA_ENFORCE_LOWER and CUDA_VER_10_1_UP
+    get_operator().spmm(
+      false,
+      false,
+      &alpha,
+      raft::make_device_matrix_view<const value_type, index_type, raft::col_major>(x, ncols_, k),
+      &beta,
+      raft::make_device_matrix_view<value_type, index_type, raft::col_major>(y, nrows_, k));
+#else
+    for (index_type j = 0; j < k; ++j) {
+      sparse_matrix_t<index_type, value_type>::mv(alpha, x + j * ncols_, beta, y + j * nrows_);
+    }
+#endif
+  }
+
   resources const& get_handle(void) const { return handle_; }
 
 #if not defined CUDA_ENFORCE_LOWER and CUDA_VER_10_1_UP
@@ -297,6 +343,23 @@ struct sparse_matrix_t {
       default: return CUSPARSE_SPMV_ALG_DEFAULT;
     }
   }
+
+  using operator_type = raft::sparse::linalg::sparse_operator<value_type, index_type, index_type>;
+
+  // created on the first product; shared by the copies of the matrix, which all bind the same data
+  operator_type& get_operator(void) const
+  {
+    if (!operator_) {
+      auto indptr    = const_cast<index_type*>(row_offsets_);
+      auto indices   = const_cast<index_type*>(col_indices_);
+      auto structure = raft::make_device_compressed_structure_view(
+        indptr, indices, nrows_, ncols_, nnz_);
+
+      operator_ = std::make_shared<operator_type>(
+        handle_, raft::make_device_csr_matrix_view<const value_type>(values_, structure));
+    }
+    return *operator_;
+  }
 #endif
 
   // private: // maybe not, keep this ASAPBNS ("as simple as possible, but not simpler"); hence,
@@ -309,6 +372,9 @@ struct sparse_matrix_t {
   index_type const nrows_;
   index_type const ncols_;
   index_type const nnz_;
+#if not defined CUDA_ENFORCE_LOWER and CUDA_VER_10_1_UP
+  mutable std::shared_ptr<operator_type> operator_;
+#endif
 };
 
 template <typename index_type, typename value_type>
@@ -382,7 +448,166 @@ struct laplacian_matrix_t : sparse_matrix_t<index_type, value_type> {
     sparse_matrix_t<index_type, value_type>::mv(-alpha, x, 1, y, alg, transpose, symmetric);
   }
 
+  // Y = alpha*L*X + beta*Y, for a column-major block of k vectors
+  //
+  void mm(value_type alpha,
+          value_type* __restrict__ x,
+          index_type k,
+          value_type beta,
+          value_type* __restrict__ y) const override
+  {
+    constexpr int BLOCK_SIZE = 1024;
+    auto n                   = sparse_matrix_t<index_type, value_type>::nrows_;
+    auto handle              = sparse_matrix_t<index_type, value_type>::get_handle();
+    auto stream              = resource::get_cuda_stream(handle);
+
+    // Apply adjacency matrix
+    //
+    sparse_matrix_t<index_type, value_type>::mm(-alpha, x, k, beta, y);
+
+    // Apply diagonal matrix
+    //
+    dim3 gridDim{
+      std::min<unsigned int>((static_cast<size_t>(n) * k + BLOCK_SIZE - 1) / BLOCK_SIZE, 65535),
+      1,
+      1};
+    dim3 blockDim{BLOCK_SIZE, 1, 1};
+    diagmm<<<gridDim, blockDim, 0, stream>>>(n, k, alpha, diagonal_.raw(), x, y);
+    RAFT_CHECK_CUDA(stream);
+  }
+
+  vector_t<value_type> diagonal_;
+};
+
+// Symmetric normalized Laplacian I - D^{-1/2}*A*D^{-1/2}, applied without forming it:
+// only the inverse square root of the degrees and two work vectors are stored next to A.
+//
+template <typename index_type, typename value_type>
+struct normalized_laplacian_matrix_t : sparse_matrix_t<index_type, value_type> {
+  normalized_laplacian_matrix_t(resources const& raft_handle,
+                                index_type const* row_offsets,
+                                index_type const* col_indices,
+                                value_type const* values,
+                                index_type const nrows,
+                                index_type const nnz)
+    : sparse_matrix_t<index_type, value_type>(
+        raft_handle, row_offsets, col_indices, values, nrows, nnz),
+      diagonal_(raft_handle, nrows),
+      scaled_x_(raft_handle, nrows),
+      adj_x_(raft_handle, nrows)
+  {
+    compute_diagonal(raft_handle);
+  }
+
+  normalized_laplacian_matrix_t(resources const& raft_handle,
+                                sparse_matrix_t<index_type, value_type> const& csr_m)
+    : sparse_matrix_t<index_type, value_type>(raft_handle,
+                                              csr_m.row_offsets_,
+                                              csr_m.col_indices_,
+                                              csr_m.values_,
+                                              csr_m.nrows_,
+                                              csr_m.nnz_),
+      diagonal_(raft_handle, csr_m.nrows_),
+      scaled_x_(raft_handle, csr_m.nrows_),
+      adj_x_(raft_handle, csr_m.nrows_)
+  {
+    compute_diagonal(raft_handle);
+  }
+
+  // y = alpha*L*x + beta*y
+  //
+  void mv(value_type alpha,
+          value_type* __restrict__ x,
+          value_type beta,
+          value_type* __restrict__ y,
+          sparse_mv_alg_t alg = sparse_mv_alg_t::SPARSE_MV_ALG1,
+          bool transpose      = false,
+          bool symmetric      = false) const override
+  {
+    constexpr int BLOCK_SIZE = 1024;
+    auto n                   = sparse_matrix_t<index_type, value_type>::nrows_;
+
+    auto handle = sparse_matrix_t<index_type, value_type>::get_handle();
+    auto stream = resource::get_cuda_stream(handle);
+
+    dim3 gridDim{std::min<unsigned int>((n + BLOCK_SIZE - 1) / BLOCK_SIZE, 65535), 1, 1};
+    dim3 blockDim{BLOCK_SIZE, 1, 1};
+
+    // D^{-1/2}*x
+    //
+    diagscale<<<gridDim, blockDim, 0, stream>>>(n, diagonal_.raw(), x, scaled_x_.raw());
+    RAFT_CHECK_CUDA(stream);
+
+    // A*D^{-1/2}*x
+    //
+    sparse_matrix_t<index_type, value_type>::mv(
+      1, scaled_x_.raw(), 0, adj_x_.raw(), alg, transpose, symmetric);
+
+    normalized_laplacian_mv_finalize<<<gridDim, blockDim, 0, stream>>>(
+      n, alpha, beta, diagonal_.raw(), x, adj_x_.raw(), y);
+    RAFT_CHECK_CUDA(stream);
+  }
+
+  // Y = alpha*L*X + beta*Y, for a column-major block of k vectors
+  //
+  void mm(value_type alpha,
+          value_type* __restrict__ x,
+          index_type k,
+          value_type beta,
+          value_type* __restrict__ y) const override
+  {
+    constexpr int BLOCK_SIZE = 1024;
+    auto n                   = sparse_matrix_t<index_type, value_type>::nrows_;
+
+    auto handle = sparse_matrix_t<index_type, value_type>::get_handle();
+    auto stream = resource::get_cuda_stream(handle);
+
+    dim3 gridDim{std::min<unsigned int>((n + BLOCK_SIZE - 1) / BLOCK_SIZE, 65535), 1, 1};
+    dim3 blockDim{BLOCK_SIZE, 1, 1};
+
+    rmm::device_uvector<value_type> scaled_x(static_cast<size_t>(n) * k, stream);
+    rmm::device_uvector<value_type> adj_x(static_cast<size_t>(n) * k, stream);
+
+    // D^{-1/2}*X
+    //
+    for (index_type j = 0; j < k; ++j) {
+      size_t offset = static_cast<size_t>(j) * n;
+      diagscale<<<gridDim, blockDim, 0, stream>>>(
+        n, diagonal_.raw(), x + offset, scaled_x.data() + offset);
+    }
+    RAFT_CHECK_CUDA(stream);
+
+    // A*D^{-1/2}*X
+    //
+    sparse_matrix_t<index_type, value_type>::mm(1, scaled_x.data(), k, 0, adj_x.data());
+
+    for (index_type j = 0; j < k; ++j) {
+      size_t offset = static_cast<size_t>(j) * n;
+      normalized_laplacian_mv_finalize<<<gridDim, blockDim, 0, stream>>>(
+        n, alpha, beta, diagonal_.raw(), x + offset, adj_x.data() + offset, y + offset);
+    }
+    RAFT_CHECK_CUDA(stream);
+  }
+
+  // D^{-1/2}; zero for the isolated vertices
   vector_t<value_type> diagonal_;
+
+ private:
+  void compute_diagonal(resources const& raft_handle)
+  {
+    scaled_x_.fill(1.0);
+    sparse_matrix_t<index_type, value_type>::mv(1, scaled_x_.raw(), 0, diagonal_.raw());
+    thrust::transform(resource::get_thrust_policy(raft_handle),
+                      diagonal_.raw(),
+                      diagonal_.raw() + diagonal_.size(),
+                      diagonal_.raw(),
+                      [] __device__(value_type d) {
+                        return d > value_type{0} ? value_type{1} / sqrt(d) : value_type{0};
+                      });
+  }
+
+  mutable vector_t<value_type> scaled_x_;
+  mutable vector_t<value_type> adj_x_;
 };
 
 template <typename index_type, typename value_type>
@@ -456,6 +681,21 @@ struct modularity_matrix_t : laplacian_matrix_t<index_type, value_type> {
                                        stream));
   }
 
+  // Y = alpha*B*X + beta*Y, one vector at a time: the rank-one correction of the modularity
+  // matrix is applied to each vector by mv
+  //
+  void mm(value_type alpha,
+          value_type* __restrict__ x,
+          index_type k,
+          value_type beta,
+          value_type* __restrict__ y) const override
+  {
+    auto n = sparse_matrix_t<index_type, value_type>::nrows_;
+    for (index_type j = 0; j < k; ++j) {
+      mv(alpha, x + static_cast<size_t>(j) * n, beta, y + static_cast<size_t>(j) * n);
+    }
+  }
+
   value_type edge_sum_;
 };
 
@@ -17,6 +17,8 @@
 #pragma once
 
 #include <math.h>
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/device_mdspan.hpp>
 #include <raft/core/resource/cublas_handle.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <stdio.h>
@@ -34,6 +36,8 @@
 #include <raft/spectral/eigen_solvers.cuh>
 #include <raft/spectral/matrix_wrappers.hpp>
 
+#include <rmm/device_uvector.hpp>
+
 namespace raft {
 namespace spectral {
 namespace detail {
@@ -96,13 +100,11 @@ std::tuple<vertex_t, weight_t, vertex_t> modularity_maximization(
   // Compute eigenvectors corresponding to largest eigenvalues
   std::get<0>(stats) = eigen_solver.solve_largest_eigenvectors(handle, B, eigVals, eigVecs);
 
-  // Whiten eigenvector matrix
-  transform_eigen_matrix(handle, n, nEigVecs, eigVecs);
-
-  // notice that at this point the matrix has already been transposed, so we are scaling
-  // columns
-  scale_obs(nEigVecs, n, eigVecs);
-  RAFT_CHECK_CUDA(stream);
+  // Whiten eigenvector matrix, transpose it and scale its rows to unit norm, in place
+  raft::spectral::matrix::vector_t<weight_t> work(handle, nEigVecs * n);
+  whiten_eigenvectors(handle, n, nEigVecs, eigVecs, work.raw(), true);
+  RAFT_CUDA_TRY(cudaMemcpyAsync(
+    eigVecs, work.raw(), nEigVecs * n * sizeof(weight_t), cudaMemcpyDeviceToDevice, stream));
 
   // Find partition clustering
   auto pair_cluster = cluster_solver.solve(handle, n, nEigVecs, eigVecs, clusters);
@@ -112,6 +114,50 @@ std::tuple<vertex_t, weight_t, vertex_t> modularity_maximization(
 
   return stats;
 }
+template <typename vertex_t,
+          typename weight_t,
+          typename nnz_t,
+          typename EigenSolver,
+          typename ClusterSolver>
+std::tuple<vertex_t, weight_t, vertex_t> modularity_maximization(
+  raft::resources const& handle,
+  raft::device_csr_matrix_view<const weight_t, vertex_t, vertex_t, nnz_t> graph,
+  EigenSolver const& eigen_solver,
+  ClusterSolver const& cluster_solver,
+  raft::device_vector_view<vertex_t, vertex_t> clusters,
+  raft::device_vector_view<weight_t, vertex_t> eigVals,
+  raft::device_matrix_view<weight_t, vertex_t, raft::col_major> eigVecs)
+{
+  auto csr_m    = make_graph_matrix(handle, graph);
+  vertex_t n    = csr_m.nrows_;
+  auto nEigVecs = eigen_solver.get_config().n_eigVecs;
+  RAFT_EXPECTS(clusters.extent(0) == n, "clusters must hold one entry per vertex of the graph.");
+  RAFT_EXPECTS(eigVals.extent(0) == nEigVecs, "eigVals must hold n_eigVecs entries.");
+  RAFT_EXPECTS(eigVecs.extent(0) == n && eigVecs.extent(1) == nEigVecs,
+               "eigVecs must be of shape [n, n_eigVecs].");
+
+  std::tuple<vertex_t, weight_t, vertex_t>
+    stats;  // # iters eigen solver, cluster solver residual, # iters cluster solver
+
+  raft::spectral::matrix::modularity_matrix_t<vertex_t, weight_t> B{handle, csr_m};
+  std::get<0>(stats) = eigen_solver.solve_largest_eigenvectors(
+    handle, B, eigVals.data_handle(), eigVecs.data_handle());
+
+  // The eigenvectors are kept: the whitened, row-normalized embedding goes to its own row-major
+  // buffer
+  rmm::device_uvector<weight_t> embedding(static_cast<size_t>(n) * nEigVecs,
+                                          resource::get_cuda_stream(handle));
+  whiten_eigenvectors(handle, n, nEigVecs, eigVecs.data_handle(), embedding.data(), true);
+
+  auto pair_cluster =
+    cluster_solver.solve(handle, n, nEigVecs, embedding.data(), clusters.data_handle());
+
+  std::get<1>(stats) = pair_cluster.first;
+  std::get<2>(stats) = pair_cluster.second;
+
+  return stats;
+}
+
 //===================================================
 // Analysis of graph partition
 // =========================================================
@@ -166,6 +212,20 @@ void analyzeModularity(raft::resources const& handle,
   modularity = modularity / B.diagonal_.nrm1();
 }
 
+template <typename vertex_t, typename weight_t, typename nnz_t>
+void analyzeModularity(
+  raft::resources const& handle,
+  raft::device_csr_matrix_view<const weight_t, vertex_t, vertex_t, nnz_t> graph,
+  vertex_t nClusters,
+  raft::device_vector_view<const vertex_t, vertex_t> clusters,
+  weight_t& modularity)
+{
+  auto csr_m = make_graph_matrix(handle, graph);
+  RAFT_EXPECTS(clusters.extent(0) == csr_m.nrows_,
+               "clusters must hold one entry per vertex of the graph.");
+  analyzeModularity(handle, csr_m, nClusters, clusters.data_handle(), modularity);
+}
+
 }  // namespace detail
 }  // namespace spectral
 }  // namespace raft
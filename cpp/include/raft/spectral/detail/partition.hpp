@@ -16,6 +16,8 @@
 #pragma once
 
 #include <math.h>
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/device_mdspan.hpp>
 #include <raft/core/resource/cublas_handle.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <stdio.h>
@@ -33,6 +35,8 @@
 #include <raft/spectral/eigen_solvers.cuh>
 #include <raft/spectral/matrix_wrappers.hpp>
 
+#include <rmm/device_uvector.hpp>
+
 namespace raft {
 namespace spectral {
 namespace detail {
@@ -114,6 +118,49 @@ std::tuple<vertex_t, weight_t, vertex_t> partition(
   return stats;
 }
 
+template <typename vertex_t,
+          typename weight_t,
+          typename nnz_t,
+          typename EigenSolver,
+          typename ClusterSolver>
+std::tuple<vertex_t, weight_t, vertex_t> partition(
+  raft::resources const& handle,
+  raft::device_csr_matrix_view<const weight_t, vertex_t, vertex_t, nnz_t> graph,
+  EigenSolver const& eigen_solver,
+  ClusterSolver const& cluster_solver,
+  raft::device_vector_view<vertex_t, vertex_t> clusters,
+  raft::device_vector_view<weight_t, vertex_t> eigVals,
+  raft::device_matrix_view<weight_t, vertex_t, raft::col_major> eigVecs)
+{
+  auto csr_m    = make_graph_matrix(handle, graph);
+  vertex_t n    = csr_m.nrows_;
+  auto nEigVecs = eigen_solver.get_config().n_eigVecs;
+  RAFT_EXPECTS(clusters.extent(0) == n, "clusters must hold one entry per vertex of the graph.");
+  RAFT_EXPECTS(eigVals.extent(0) == nEigVecs, "eigVals must hold n_eigVecs entries.");
+  RAFT_EXPECTS(eigVecs.extent(0) == n && eigVecs.extent(1) == nEigVecs,
+               "eigVecs must be of shape [n, n_eigVecs].");
+
+  std::tuple<vertex_t, weight_t, vertex_t>
+    stats;  // # iters eigen solver, cluster solver residual, # iters cluster solver
+
+  spectral::matrix::laplacian_matrix_t<vertex_t, weight_t> L{handle, csr_m};
+  std::get<0>(stats) = eigen_solver.solve_smallest_eigenvectors(
+    handle, L, eigVals.data_handle(), eigVecs.data_handle());
+
+  // The eigenvectors are kept: the whitened embedding goes to its own row-major buffer
+  rmm::device_uvector<weight_t> embedding(static_cast<size_t>(n) * nEigVecs,
+                                          resource::get_cuda_stream(handle));
+  whiten_eigenvectors(handle, n, nEigVecs, eigVecs.data_handle(), embedding.data(), false);
+
+  auto pair_cluster =
+    cluster_solver.solve(handle, n, nEigVecs, embedding.data(), clusters.data_handle());
+
+  std::get<1>(stats) = pair_cluster.first;
+  std::get<2>(stats) = pair_cluster.second;
+
+  return stats;
+}
+
 // =========================================================
 // Analysis of graph partition
 // =========================================================
@@ -180,6 +227,20 @@ void analyzePartition(raft::resources const& handle,
   }
 }
 
+template <typename vertex_t, typename weight_t, typename nnz_t>
+void analyzePartition(raft::resources const& handle,
+                      raft::device_csr_matrix_view<const weight_t, vertex_t, vertex_t, nnz_t> graph,
+                      vertex_t nClusters,
+                      raft::device_vector_view<const vertex_t, vertex_t> clusters,
+                      weight_t& edgeCut,
+                      weight_t& cost)
+{
+  auto csr_m = make_graph_matrix(handle, graph);
+  RAFT_EXPECTS(clusters.extent(0) == csr_m.nrows_,
+               "clusters must hold one entry per vertex of the graph.");
+  analyzePartition(handle, csr_m, nClusters, clusters.data_handle(), edgeCut, cost);
+}
+
 }  // namespace detail
 }  // namespace spectral
 }  // namespace raft
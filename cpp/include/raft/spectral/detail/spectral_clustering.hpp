@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/linalg/map.cuh>
+#include <raft/spectral/cluster_solvers.cuh>
+#include <raft/spectral/detail/spectral_util.cuh>
+#include <raft/spectral/eigen_solvers.cuh>
+#include <raft/spectral/matrix_wrappers.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <tuple>
+
+namespace raft {
+namespace spectral {
+namespace detail {
+
+template <typename vertex_t, typename weight_t, typename nnz_t, typename params_t>
+std::tuple<vertex_t, weight_t, vertex_t> spectral_clustering(
+  raft::resources const& handle,
+  raft::device_csr_matrix_view<const weight_t, vertex_t, vertex_t, nnz_t> graph,
+  params_t const& params,
+  raft::device_vector_view<vertex_t, vertex_t> labels)
+{
+  auto structure = graph.structure_view();
+  vertex_t n     = structure.get_n_rows();
+  auto n_eig     = params.n_eigvecs > 0 ? params.n_eigvecs : params.n_clusters;
+
+  RAFT_EXPECTS(structure.get_n_cols() == n, "The graph must be a square adjacency matrix.");
+  RAFT_EXPECTS(labels.extent(0) == n, "labels must hold one entry per vertex of the graph.");
+  RAFT_EXPECTS(params.n_clusters > 0 && params.n_clusters <= n, "Invalid number of clusters.");
+  RAFT_EXPECTS(n_eig <= n, "Invalid number of eigenvectors.");
+
+  auto stream = resource::get_cuda_stream(handle);
+
+  std::tuple<vertex_t, weight_t, vertex_t>
+    stats;  // # iters eigen solver, cluster solver residual, # iters cluster solver
+
+  // The wrappers only reference the CSR arrays of the graph and the Laplacian is applied
+  // matrix-free, so neither the graph nor the Laplacian is ever copied.
+  auto A = make_graph_matrix(handle, graph);
+  matrix::normalized_laplacian_matrix_t<vertex_t, weight_t> L{handle, A};
+
+  auto restart_iter = params.restart_iter_lanczos > 0
+                        ? params.restart_iter_lanczos
+                        : std::min<vertex_t>(n, std::max<vertex_t>(2 * n_eig, n_eig + 16));
+  eigen_solver_config_t<vertex_t, weight_t> eig_cfg{n_eig,
+                                                    params.max_iter_lanczos,
+                                                    restart_iter,
+                                                    static_cast<weight_t>(params.tol_lanczos),
+                                                    params.reorthogonalize,
+                                                    params.seed};
+  lanczos_solver_t<vertex_t, weight_t> eig_solver{eig_cfg};
+
+  rmm::device_uvector<weight_t> eig_vals(n_eig, stream);
+  rmm::device_uvector<weight_t> eig_vecs(static_cast<size_t>(n) * n_eig, stream);
+  std::get<0>(stats) =
+    eig_solver.solve_smallest_eigenvectors(handle, L, eig_vals.data(), eig_vecs.data());
+
+  // Map the eigenvectors of the symmetric Laplacian back to the ones of the random walk
+  // Laplacian, D^{-1/2}*u, in place (column-major n x n_eig)
+  raft::linalg::map_offset(
+    handle,
+    raft::make_device_vector_view<weight_t, size_t>(eig_vecs.data(), eig_vecs.size()),
+    [vecs = eig_vecs.data(), d = L.diagonal_.raw(), n] __device__(size_t i) {
+      return vecs[i] * d[i % n];
+    });
+
+  // Whiten and transpose to the row-major embedding expected by the cluster solver
+  transform_eigen_matrix(handle, n, n_eig, eig_vecs.data());
+
+  cluster_solver_config_t<vertex_t, weight_t> clust_cfg{params.n_clusters,
+                                                        params.max_iter_kmeans,
+                                                        static_cast<weight_t>(params.tol_kmeans),
+                                                        params.seed};
+  kmeans_solver_t<vertex_t, weight_t> cluster_solver{clust_cfg};
+  auto pair_cluster = cluster_solver.solve(handle, n, n_eig, eig_vecs.data(), labels.data_handle());
+
+  std::get<1>(stats) = pair_cluster.first;
+  std::get<2>(stats) = pair_cluster.second;
+
+  return stats;
+}
+
+}  // namespace detail
+}  // namespace spectral
+}  // namespace raft
@@ -16,12 +16,15 @@
 
 #pragma once
 
+#include <raft/core/device_csr_matrix.hpp>
 #include <raft/core/resource/cublas_handle.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resource/thrust_policy.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/linalg/detail/cublas_wrappers.hpp>
 #include <raft/spectral/matrix_wrappers.hpp>
+#include <raft/stats/meanvar.cuh>
+#include <raft/util/cuda_utils.cuh>
 #include <raft/util/cudart_utils.hpp>
 
 #include <thrust/device_ptr.h>
@@ -35,6 +38,7 @@
 #include <thrust/tuple.h>
 
 #include <algorithm>
+#include <limits>
 
 namespace raft {
 namespace spectral {
@@ -118,78 +122,101 @@ cudaError_t scale_obs(index_type_t m, index_type_t n, value_type_t* obs)
   return cudaSuccess;
 }
 
+template <typename index_type_t, typename value_type_t>
+static __global__ void whiten_eigenvectors_kernel(index_type_t n,
+                                                  index_type_t nEigVecs,
+                                                  value_type_t const* __restrict__ eigVecs,
+                                                  value_type_t const* __restrict__ mean,
+                                                  value_type_t const* __restrict__ var,
+                                                  bool normalize_rows,
+                                                  value_type_t* __restrict__ embedding)
+{
+  index_type_t row = blockIdx.x * static_cast<index_type_t>(blockDim.x) + threadIdx.x;
+  if (row >= n) return;
+
+  // the threads of a warp read consecutive rows of a column: coalesced. A constant column (the
+  // trivial eigenvector) has no variance and is only centered.
+  auto whiten = [=](index_type_t j) {
+    value_type_t centered = eigVecs[IDX(row, j, n)] - mean[j];
+    return var[j] > 0 ? centered / raft::sqrt(var[j]) : centered;
+  };
+  value_type_t scale = 1;
+  if (normalize_rows) {
+    value_type_t norm = 0;
+    for (index_type_t j = 0; j < nEigVecs; ++j) {
+      value_type_t v = whiten(j);
+      norm += v * v;
+    }
+    if (norm > 0) { scale = 1 / raft::sqrt(norm); }
+  }
+  for (index_type_t j = 0; j < nEigVecs; ++j) {
+    embedding[static_cast<size_t>(row) * nEigVecs + j] = scale * whiten(j);
+  }
+}
+
+/**
+ * Whiten the columns of the eigenvectors (column-major n x nEigVecs) to zero mean and unit
+ * variance and write them as the row-major embedding (n x nEigVecs) of the vertices, optionally
+ * scaling every row of the embedding to unit norm: a single pass over the eigenvectors after their
+ * column statistics, instead of a whitening per column, a transposition and a copy.
+ */
+template <typename vertex_t, typename edge_t, typename weight_t>
+void whiten_eigenvectors(raft::resources const& handle,
+                         edge_t n,
+                         vertex_t nEigVecs,
+                         weight_t const* eigVecs,
+                         weight_t* embedding,
+                         bool normalize_rows)
+{
+  auto stream = resource::get_cuda_stream(handle);
+  raft::spectral::matrix::vector_t<weight_t> mean(handle, nEigVecs);
+  raft::spectral::matrix::vector_t<weight_t> var(handle, nEigVecs);
+  raft::stats::meanvar<weight_t, edge_t>(
+    mean.raw(), var.raw(), eigVecs, nEigVecs, n, false, false, stream);
+
+  constexpr int threads = 256;
+  auto blocks           = raft::ceildiv<edge_t>(n, threads);
+  whiten_eigenvectors_kernel<edge_t, weight_t><<<blocks, threads, 0, stream>>>(
+    n, nEigVecs, eigVecs, mean.raw(), var.raw(), normalize_rows, embedding);
+  RAFT_CHECK_CUDA(stream);
+}
+
+/**
+ * Wrap a square CSR graph into the sparse matrix of the spectral solvers; the wrapper only
+ * references the arrays of the graph.
+ */
+template <typename vertex_t, typename weight_t, typename nnz_t>
+matrix::sparse_matrix_t<vertex_t, weight_t> make_graph_matrix(
+  raft::resources const& handle,
+  raft::device_csr_matrix_view<const weight_t, vertex_t, vertex_t, nnz_t> graph)
+{
+  auto structure = graph.structure_view();
+  vertex_t n     = structure.get_n_rows();
+  auto nnz       = structure.get_nnz();
+  RAFT_EXPECTS(structure.get_n_cols() == n, "The graph must be a square adjacency matrix.");
+  RAFT_EXPECTS(static_cast<uint64_t>(nnz) <= std::numeric_limits<vertex_t>::max(),
+               "The number of edges must be representable by vertex_t.");
+  return matrix::sparse_matrix_t<vertex_t, weight_t>{handle,
+                                                     structure.get_indptr().data(),
+                                                     structure.get_indices().data(),
+                                                     graph.get_elements().data(),
+                                                     n,
+                                                     static_cast<vertex_t>(nnz)};
+}
+
 template <typename vertex_t, typename edge_t, typename weight_t>
 void transform_eigen_matrix(raft::resources const& handle,
                             edge_t n,
                             vertex_t nEigVecs,
                             weight_t* eigVecs)
 {
-  auto stream             = resource::get_cuda_stream(handle);
-  auto cublas_h           = resource::get_cublas_handle(handle);
-  auto thrust_exec_policy = resource::get_thrust_policy(handle);
-
-  const weight_t zero{0.0};
-  const weight_t one{1.0};
-
-  // Whiten eigenvector matrix
-  for (auto i = 0; i < nEigVecs; ++i) {
-    weight_t mean, std;
-
-    mean = thrust::reduce(thrust_exec_policy,
-                          thrust::device_pointer_cast(eigVecs + IDX(0, i, n)),
-                          thrust::device_pointer_cast(eigVecs + IDX(0, i + 1, n)));
-    RAFT_CHECK_CUDA(stream);
-    mean /= n;
-    thrust::transform(thrust_exec_policy,
-                      thrust::device_pointer_cast(eigVecs + IDX(0, i, n)),
-                      thrust::device_pointer_cast(eigVecs + IDX(0, i + 1, n)),
-                      thrust::make_constant_iterator(mean),
-                      thrust::device_pointer_cast(eigVecs + IDX(0, i, n)),
-                      thrust::minus<weight_t>());
-    RAFT_CHECK_CUDA(stream);
-
-    // TODO: Call from public API when ready
-    RAFT_CUBLAS_TRY(
-      raft::linalg::detail::cublasnrm2(cublas_h, n, eigVecs + IDX(0, i, n), 1, &std, stream));
-
-    std /= std::sqrt(static_cast<weight_t>(n));
-
-    thrust::transform(thrust_exec_policy,
-                      thrust::device_pointer_cast(eigVecs + IDX(0, i, n)),
-                      thrust::device_pointer_cast(eigVecs + IDX(0, i + 1, n)),
-                      thrust::make_constant_iterator(std),
-                      thrust::device_pointer_cast(eigVecs + IDX(0, i, n)),
-                      thrust::divides<weight_t>());
-    RAFT_CHECK_CUDA(stream);
-  }
+  auto stream = resource::get_cuda_stream(handle);
 
-  // Transpose eigenvector matrix
-  //   TODO: in-place transpose
-  {
-    raft::spectral::matrix::vector_t<weight_t> work(handle, nEigVecs * n);
-    // TODO: Call from public API when ready
-    RAFT_CUBLAS_TRY(
-      raft::linalg::detail::cublassetpointermode(cublas_h, CUBLAS_POINTER_MODE_HOST, stream));
-
-    // TODO: Call from public API when ready
-    RAFT_CUBLAS_TRY(raft::linalg::detail::cublasgeam(cublas_h,
-                                                     CUBLAS_OP_T,
-                                                     CUBLAS_OP_N,
-                                                     nEigVecs,
-                                                     n,
-                                                     &one,
-                                                     eigVecs,
-                                                     n,
-                                                     &zero,
-                                                     (weight_t*)NULL,
-                                                     nEigVecs,
-                                                     work.raw(),
-                                                     nEigVecs,
-                                                     stream));
-
-    RAFT_CUDA_TRY(cudaMemcpyAsync(
-      eigVecs, work.raw(), nEigVecs * n * sizeof(weight_t), cudaMemcpyDeviceToDevice, stream));
-  }
+  // Whiten and transpose the eigenvector matrix, in place
+  raft::spectral::matrix::vector_t<weight_t> work(handle, nEigVecs * n);
+  whiten_eigenvectors(handle, n, nEigVecs, eigVecs, work.raw(), false);
+  RAFT_CUDA_TRY(cudaMemcpyAsync(
+    eigVecs, work.raw(), nEigVecs * n * sizeof(weight_t), cudaMemcpyDeviceToDevice, stream));
 }
 
 namespace {
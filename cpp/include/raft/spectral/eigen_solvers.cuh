@@ -19,8 +19,11 @@
 #pragma once
 
 #include <raft/sparse/solver/lanczos.cuh>
+#include <raft/sparse/solver/lobpcg.cuh>
 #include <raft/spectral/matrix_wrappers.hpp>
 
+#include <algorithm>
+
 namespace raft {
 namespace spectral {
 
@@ -101,6 +104,69 @@ struct lanczos_solver_t {
   eigen_solver_config_t<index_type_t, value_type_t, size_type_t> config_;
 };
 
+// Block eigensolver with the interface of lanczos_solver_t; restartIter is unused and
+// block_size (at least n_eigVecs) sets the number of vectors iterated at once:
+//
+template <typename index_type_t, typename value_type_t, typename size_type_t = index_type_t>
+struct lobpcg_solver_t {
+  explicit lobpcg_solver_t(
+    eigen_solver_config_t<index_type_t, value_type_t, size_type_t> const& config,
+    size_type_t block_size = 0)
+    : config_(config), block_size_(std::max(block_size, config.n_eigVecs))
+  {
+  }
+
+  index_type_t solve_smallest_eigenvectors(
+    raft::resources const& handle,
+    matrix::sparse_matrix_t<index_type_t, value_type_t> const& A,
+    value_type_t* __restrict__ eigVals,
+    value_type_t* __restrict__ eigVecs) const
+  {
+    RAFT_EXPECTS(eigVals != nullptr, "Null eigVals buffer.");
+    RAFT_EXPECTS(eigVecs != nullptr, "Null eigVecs buffer.");
+    index_type_t iters{};
+    sparse::solver::lobpcgSmallestEigenvectors(handle,
+                                               A,
+                                               config_.n_eigVecs,
+                                               block_size_,
+                                               config_.maxIter,
+                                               config_.tol,
+                                               iters,
+                                               eigVals,
+                                               eigVecs,
+                                               config_.seed);
+    return iters;
+  }
+
+  index_type_t solve_largest_eigenvectors(
+    raft::resources const& handle,
+    matrix::sparse_matrix_t<index_type_t, value_type_t> const& A,
+    value_type_t* __restrict__ eigVals,
+    value_type_t* __restrict__ eigVecs) const
+  {
+    RAFT_EXPECTS(eigVals != nullptr, "Null eigVals buffer.");
+    RAFT_EXPECTS(eigVecs != nullptr, "Null eigVecs buffer.");
+    index_type_t iters{};
+    sparse::solver::lobpcgLargestEigenvectors(handle,
+                                              A,
+                                              config_.n_eigVecs,
+                                              block_size_,
+                                              config_.maxIter,
+                                              config_.tol,
+                                              iters,
+                                              eigVals,
+                                              eigVecs,
+                                              config_.seed);
+    return iters;
+  }
+
+  auto const& get_config(void) const { return config_; }
+
+ private:
+  eigen_solver_config_t<index_type_t, value_type_t, size_type_t> config_;
+  size_type_t block_size_;
+};
+
 }  // namespace spectral
 }  // namespace raft
 
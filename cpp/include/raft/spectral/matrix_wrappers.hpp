@@ -42,6 +42,8 @@ using detail::sparse_matrix_t;
 
 using detail::laplacian_matrix_t;
 
+using detail::normalized_laplacian_matrix_t;
+
 using detail::modularity_matrix_t;
 
 }  // namespace matrix
@@ -20,6 +20,8 @@
 
 #include <tuple>
 
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/device_mdspan.hpp>
 #include <raft/spectral/detail/modularity_maximization.hpp>
 
 namespace raft {
@@ -57,6 +59,40 @@ std::tuple<vertex_t, weight_t, vertex_t> modularity_maximization(
     modularity_maximization<vertex_t, weight_t, EigenSolver, ClusterSolver>(
       handle, csr_m, eigen_solver, cluster_solver, clusters, eigVals, eigVecs);
 }
+/** Compute partition for a weighted undirected graph given as a CSR matrix view, maximizing
+ *  its modularity.
+ *
+ *  The eigenvectors are left untouched: they are whitened, and the rows scaled to unit norm,
+ *  into a separate row-major embedding, in a single pass, for the cluster solver.
+ *
+ *  @param handle raft handle for managing expensive resources
+ *  @param graph Weighted graph, square CSR matrix [n, n]
+ *  @param eigen_solver Eigensolver implementation
+ *  @param cluster_solver Cluster solver implementation
+ *  @param clusters (Output) Cluster assignments [n]
+ *  @param eigVals (Output) Largest eigenvalues of the modularity matrix [n_eigVecs]
+ *  @param eigVecs (Output) Matching eigenvectors, column-major [n, n_eigVecs]
+ *  @return statistics: number of eigensolver iterations, cluster solver residual, number of
+ *    cluster solver iterations.
+ */
+template <typename vertex_t,
+          typename weight_t,
+          typename nnz_t,
+          typename EigenSolver,
+          typename ClusterSolver>
+std::tuple<vertex_t, weight_t, vertex_t> modularity_maximization(
+  raft::resources const& handle,
+  raft::device_csr_matrix_view<const weight_t, vertex_t, vertex_t, nnz_t> graph,
+  EigenSolver const& eigen_solver,
+  ClusterSolver const& cluster_solver,
+  raft::device_vector_view<vertex_t, vertex_t> clusters,
+  raft::device_vector_view<weight_t, vertex_t> eigVals,
+  raft::device_matrix_view<weight_t, vertex_t, raft::col_major> eigVecs)
+{
+  return raft::spectral::detail::modularity_maximization(
+    handle, graph, eigen_solver, cluster_solver, clusters, eigVals, eigVecs);
+}
+
 //===================================================
 // Analysis of graph partition
 // =========================================================
@@ -80,6 +116,25 @@ void analyzeModularity(raft::resources const& handle,
     handle, csr_m, nClusters, clusters, modularity);
 }
 
+/// Compute modularity
+/** Same as above, for a graph given as a CSR matrix view.
+ *  @param handle raft handle for managing expensive resources
+ *  @param graph Weighted graph, square CSR matrix [n, n]
+ *  @param nClusters Number of clusters.
+ *  @param clusters (Input) Cluster assignments [n]
+ *  @param modularity On exit, modularity
+ */
+template <typename vertex_t, typename weight_t, typename nnz_t>
+void analyzeModularity(
+  raft::resources const& handle,
+  raft::device_csr_matrix_view<const weight_t, vertex_t, vertex_t, nnz_t> graph,
+  vertex_t nClusters,
+  raft::device_vector_view<const vertex_t, vertex_t> clusters,
+  weight_t& modularity)
+{
+  raft::spectral::detail::analyzeModularity(handle, graph, nClusters, clusters, modularity);
+}
+
 }  // namespace spectral
 }  // namespace raft
 
@@ -21,6 +21,8 @@
 
 #include <tuple>
 
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/device_mdspan.hpp>
 #include <raft/spectral/detail/partition.hpp>
 
 namespace raft {
@@ -59,6 +61,42 @@ std::tuple<vertex_t, weight_t, vertex_t> partition(
     handle, csr_m, eigen_solver, cluster_solver, clusters, eigVals, eigVecs);
 }
 
+/// Compute spectral graph partition
+/** Compute partition for a weighted undirected graph given as a CSR matrix view. This
+ *  partition attempts to minimize the cost function:
+ *    Cost = \f$sum_i\f$ (Edges cut by ith partition)/(Vertices in ith partition)
+ *
+ *  The eigenvectors are left untouched: they are whitened into a separate row-major
+ *  embedding, in a single pass, for the cluster solver.
+ *
+ *  @param handle raft handle for managing expensive resources
+ *  @param graph Weighted graph, square CSR matrix [n, n]
+ *  @param eigen_solver Eigensolver implementation
+ *  @param cluster_solver Cluster solver implementation
+ *  @param clusters (Output) Partition assignments [n]
+ *  @param eigVals (Output) Smallest eigenvalues of the Laplacian [n_eigVecs]
+ *  @param eigVecs (Output) Matching eigenvectors, column-major [n, n_eigVecs]
+ *  @return statistics: number of eigensolver iterations, cluster solver residual, number of
+ *    cluster solver iterations.
+ */
+template <typename vertex_t,
+          typename weight_t,
+          typename nnz_t,
+          typename EigenSolver,
+          typename ClusterSolver>
+std::tuple<vertex_t, weight_t, vertex_t> partition(
+  raft::resources const& handle,
+  raft::device_csr_matrix_view<const weight_t, vertex_t, vertex_t, nnz_t> graph,
+  EigenSolver const& eigen_solver,
+  ClusterSolver const& cluster_solver,
+  raft::device_vector_view<vertex_t, vertex_t> clusters,
+  raft::device_vector_view<weight_t, vertex_t> eigVals,
+  raft::device_matrix_view<weight_t, vertex_t, raft::col_major> eigVecs)
+{
+  return raft::spectral::detail::partition(
+    handle, graph, eigen_solver, cluster_solver, clusters, eigVals, eigVecs);
+}
+
 // =========================================================
 // Analysis of graph partition
 // =========================================================
@@ -89,6 +127,27 @@ void analyzePartition(raft::resources const& handle,
     handle, csr_m, nClusters, clusters, edgeCut, cost);
 }
 
+/// Compute cost function for partition
+/** Same as above, for a graph given as a CSR matrix view.
+ *
+ *  @param handle raft handle for managing expensive resources
+ *  @param graph Weighted graph, square CSR matrix [n, n]
+ *  @param nClusters Number of partitions.
+ *  @param clusters (Input) Partition assignments [n]
+ *  @param edgeCut On exit, weight of edges cut by partition.
+ *  @param cost On exit, partition cost function.
+ */
+template <typename vertex_t, typename weight_t, typename nnz_t>
+void analyzePartition(raft::resources const& handle,
+                      raft::device_csr_matrix_view<const weight_t, vertex_t, vertex_t, nnz_t> graph,
+                      vertex_t nClusters,
+                      raft::device_vector_view<const vertex_t, vertex_t> clusters,
+                      weight_t& edgeCut,
+                      weight_t& cost)
+{
+  raft::spectral::detail::analyzePartition(handle, graph, nClusters, clusters, edgeCut, cost);
+}
+
 }  // namespace spectral
 }  // namespace raft
 
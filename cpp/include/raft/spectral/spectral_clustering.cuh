@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <tuple>
+
+#include <raft/spectral/detail/spectral_clustering.hpp>
+
+namespace raft {
+namespace spectral {
+
+/**
+ * @brief Control parameters of spectral_clustering.
+ */
+struct spectral_clustering_params {
+  /** Number of clusters. */
+  int n_clusters;
+  /** Number of eigenvectors of the embedding; zero uses n_clusters. */
+  int n_eigvecs = 0;
+  /** Maximum number of Lanczos iterations. */
+  int max_iter_lanczos = 4000;
+  /** Size of the Lanczos system before an implicit restart; zero picks one from n_eigvecs. */
+  int restart_iter_lanczos = 0;
+  /** Convergence tolerance of the Lanczos method. */
+  double tol_lanczos = 1e-3;
+  /** Whether to reorthogonalize the Lanczos vectors. */
+  bool reorthogonalize = false;
+  /** Maximum number of k-means iterations. */
+  int max_iter_kmeans = 300;
+  /** Convergence tolerance of k-means. */
+  double tol_kmeans = 1e-4;
+  /** Seed of both the Lanczos starting vector and the k-means initialization. */
+  unsigned long long seed = 1234567;
+};
+
+/**
+ * @brief Spectral clustering of a weighted undirected graph, such as a symmetrized kNN graph.
+ *
+ * The smallest eigenvectors of the normalized Laplacian I - D^{-1/2} A D^{-1/2} are computed
+ * with the implicitly restarted Lanczos method, mapped to the eigenvectors of the random walk
+ * Laplacian, whitened and clustered with k-means. The Laplacian is applied matrix-free from the
+ * CSR arrays of the graph, which are neither copied nor converted.
+ *
+ * @code{.cpp}
+ *   #include <raft/spectral/spectral_clustering.cuh>
+ *   ...
+ *   raft::spectral::spectral_clustering_params params;
+ *   params.n_clusters = 10;
+ *   auto labels = raft::make_device_vector<int, int>(handle, n_vertices);
+ *   raft::spectral::spectral_clustering(handle, knn_graph, params, labels.view());
+ * @endcode
+ *
+ * @tparam vertex_t the type of the vertex ids, used for the CSR offsets and indices
+ * @tparam weight_t the type of the edge weights (float or double)
+ * @tparam nnz_t the type of the number of edges
+ * @param[in] handle raft handle for managing expensive resources
+ * @param[in] graph symmetric adjacency matrix with non-negative weights [n_vertices x n_vertices]
+ * @param[in] params control parameters
+ * @param[out] labels cluster of each vertex [n_vertices]
+ * @return statistics: number of eigensolver iterations, k-means inertia, number of k-means
+ *   iterations
+ */
+template <typename vertex_t, typename weight_t, typename nnz_t>
+std::tuple<vertex_t, weight_t, vertex_t> spectral_clustering(
+  raft::resources const& handle,
+  raft::device_csr_matrix_view<const weight_t, vertex_t, vertex_t, nnz_t> graph,
+  spectral_clustering_params const& params,
+  raft::device_vector_view<vertex_t, vertex_t> labels)
+{
+  return detail::spectral_clustering<vertex_t, weight_t, nnz_t>(handle, graph, params, labels);
+}
+
+}  // namespace spectral
+}  // namespace raft
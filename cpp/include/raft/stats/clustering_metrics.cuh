@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2019-2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file clustering_metrics.cuh
+ * @brief All the pair-counting and information-theoretic clustering metrics (adjusted Rand index,
+ * Rand index, mutual information, homogeneity, completeness and v-measure) in a single pass.
+ */
+#ifndef __CLUSTERING_METRICS_H
+#define __CLUSTERING_METRICS_H
+
+#pragma once
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/stats/detail/clustering_metrics.cuh>
+#include <raft/stats/stats_types.hpp>
+
+namespace raft {
+namespace stats {
+
+/**
+ * @brief Function to calculate all the clustering metrics of `clustering_metrics_result` between
+ * two clusterings at once
+ *
+ * This builds the contingency matrix of the two clusterings once (a sparse one if the labels are
+ * too many for a dense matrix), instead of once per metric as the individual functions
+ * (`adjusted_rand_index`, `rand_index`, `mutual_info_score`, `homogeneity_score`,
+ * `completeness_score`, `v_measure`) do. The label ranges are found from the data.
+ *
+ * @param truthClusterArray: the array of truth classes of type T
+ * @param predClusterArray: the array of predicted classes of type T
+ * @param size: the size of the data points of type int
+ * @param stream: the cudaStream object
+ * @param beta: v_measure parameter
+ */
+template <typename T>
+clustering_metrics_result clustering_metrics(const T* truthClusterArray,
+                                             const T* predClusterArray,
+                                             int size,
+                                             cudaStream_t stream,
+                                             double beta = 1.0)
+{
+  return detail::clustering_metrics(truthClusterArray, predClusterArray, size, beta, stream);
+}
+
+/**
+ * @defgroup stats_clustering_metrics Clustering Metrics
+ * @{
+ */
+
+/**
+ * @brief Function to calculate all the clustering metrics of `clustering_metrics_result` between
+ * two clusterings at once, building their contingency matrix only once
+ *
+ * @code{.cpp}
+ *   auto m = raft::stats::clustering_metrics(handle, truth.view(), pred.view());
+ *   // m.adjusted_rand_index, m.rand_index, m.mutual_info, m.homogeneity, m.completeness,
+ *   // m.v_measure
+ * @endcode
+ *
+ * @tparam value_t the data type
+ * @tparam idx_t Integer type used to for addressing
+ * @param[in] handle the raft handle
+ * @param[in] truth_cluster_array: the array of truth classes of type value_t
+ * @param[in] pred_cluster_array: the array of predicted classes of type value_t
+ * @param[in] beta: v_measure parameter
+ * @return the clustering metrics between the two clusterings
+ */
+template <typename value_t, typename idx_t>
+clustering_metrics_result clustering_metrics(
+  raft::resources const& handle,
+  raft::device_vector_view<const value_t, idx_t> truth_cluster_array,
+  raft::device_vector_view<const value_t, idx_t> pred_cluster_array,
+  double beta = 1.0)
+{
+  RAFT_EXPECTS(truth_cluster_array.extent(0) == pred_cluster_array.extent(0),
+               "Size mismatch between truth_cluster_array and pred_cluster_array");
+  RAFT_EXPECTS(truth_cluster_array.is_exhaustive(), "truth_cluster_array must be contiguous");
+  RAFT_EXPECTS(pred_cluster_array.is_exhaustive(), "pred_cluster_array must be contiguous");
+
+  return detail::clustering_metrics(truth_cluster_array.data_handle(),
+                                    pred_cluster_array.data_handle(),
+                                    truth_cluster_array.extent(0),
+                                    beta,
+                                    resource::get_cuda_stream(handle));
+}
+
+/** @} */  // end group stats_clustering_metrics
+
+};  // end namespace stats
+};  // end namespace raft
+
+#endif
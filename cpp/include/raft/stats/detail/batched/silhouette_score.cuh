@@ -17,6 +17,7 @@
 #pragma once
 
 #include "../silhouette_score.cuh"
+#include "../silhouette_score_fused.cuh"
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resource/cuda_stream_pool.hpp>
 #include <raft/core/resource/thrust_policy.hpp>
@@ -185,6 +186,12 @@ value_t silhouette_score(
   ASSERT(n_labels >= 2 && n_labels <= (n_rows - 1),
          "silhouette Score not defined for the given number of labels!");
 
+  // the fused distance and per-label reduction needs no chunk of the distance matrix
+  if (raft::stats::detail::silhouette_fused_supported(metric)) {
+    return raft::stats::detail::silhouette_score_fused(
+      handle, X, int(n_rows), int(n_cols), y, int(n_labels), scores, metric, int(chunk));
+  }
+
   rmm::device_uvector<value_idx> cluster_counts = get_cluster_counts(handle, y, n_rows, n_labels);
 
   auto stream = resource::get_cuda_stream(handle);
@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * @file clustering_metrics.cuh
+ * @brief All the pair-counting and information-theoretic clustering metrics (adjusted Rand index,
+ * Rand index, mutual information, homogeneity, completeness and v-measure) from a single
+ * contingency matrix.
+ */
+
+#pragma once
+
+#include <raft/stats/histogram.cuh>
+#include <raft/stats/stats_types.hpp>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+#include <rmm/device_uvector.hpp>
+
+#include <thrust/device_ptr.h>
+#include <thrust/execution_policy.h>
+#include <thrust/extrema.h>
+#include <thrust/for_each.h>
+#include <thrust/iterator/constant_iterator.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/reduce.h>
+#include <thrust/sort.h>
+#include <thrust/transform.h>
+#include <thrust/transform_reduce.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace raft {
+namespace stats {
+namespace detail {
+
+/**
+ * The contingency matrix with up to this many cells (or as many as the data points, if more) is
+ * stored dense; larger ones are stored as the list of their non-zero cells.
+ */
+constexpr int64_t kMinDenseContingencyCells = 1 << 16;
+
+/** The sums reduced over the cells of the contingency matrix, or over its marginals. */
+struct count_sums {
+  /** sum of n * (n - 1) / 2 (the pairs of points sharing the cell) */
+  double pairs = 0;
+  /** sum of n * log(n) */
+  double n_log_n = 0;
+  /** the number of non-zero counts */
+  double non_zero = 0;
+
+  HDI count_sums operator+(const count_sums& other) const
+  {
+    return {pairs + other.pairs, n_log_n + other.n_log_n, non_zero + other.non_zero};
+  }
+};
+
+template <typename CountT>
+struct count_sums_op {
+  HDI count_sums operator()(CountT n) const
+  {
+    auto x = double(n);
+    if (n == 0) { return {}; }
+    return {x * (x - 1) / 2.0, x * log(x), 1.0};
+  }
+};
+
+template <typename CountT>
+count_sums reduce_counts(const CountT* counts, size_t len, cudaStream_t stream)
+{
+  auto ptr = thrust::device_pointer_cast(counts);
+  return thrust::transform_reduce(thrust::cuda::par.on(stream),
+                                  ptr,
+                                  ptr + len,
+                                  count_sums_op<CountT>{},
+                                  count_sums{},
+                                  thrust::plus<count_sums>{});
+}
+
+/**
+ * @brief Compute all the clustering metrics of `clustering_metrics_result`
+ *
+ * The contingency matrix is built once, dense (a histogram of the pairs of labels) when it has no
+ * more cells than the data points, sparse (the sorted and run-length encoded pairs of labels)
+ * otherwise, so that the cost and the memory stay linear in the number of the data points for any
+ * number of labels. Its marginals are reduced from its non-zero cells, and every metric follows
+ * from three fused reductions of the counts (over the cells and over both marginals):
+ * the sum of C(n, 2) gives the (adjusted) Rand index and the sum of n * log(n) the entropies and
+ * the mutual information.
+ *
+ * @tparam T data-type for the input label arrays
+ * @param truthClusterArray the array of truth classes [on device] [len = size]
+ * @param predClusterArray the array of predicted classes [on device] [len = size]
+ * @param size the number of data points
+ * @param beta the v-measure parameter
+ * @param stream cuda stream
+ */
+template <typename T>
+clustering_metrics_result clustering_metrics(const T* truthClusterArray,
+                                             const T* predClusterArray,
+                                             int size,
+                                             double beta,
+                                             cudaStream_t stream)
+{
+  ASSERT(size >= 2, "Clustering metrics for size less than 2 not defined!");
+  auto policy     = thrust::cuda::par.on(stream);
+  auto truthPtr   = thrust::device_pointer_cast(truthClusterArray);
+  auto predPtr    = thrust::device_pointer_cast(predClusterArray);
+  auto truthMM    = thrust::minmax_element(policy, truthPtr, truthPtr + size);
+  auto predMM     = thrust::minmax_element(policy, predPtr, predPtr + size);
+  T minTruth      = *truthMM.first;
+  T minPred       = *predMM.first;
+  auto nTruth     = int64_t(T(*truthMM.second) - minTruth) + 1;
+  auto nPred      = int64_t(T(*predMM.second) - minPred) + 1;
+  auto nCells     = nTruth * nPred;
+  bool denseCells = nCells <= std::max<int64_t>(size, kMinDenseContingencyCells);
+
+  // the contingency matrix: the counts of the cells and, if sparse, their row-major positions
+  rmm::device_uvector<int> counts(0, stream);
+  rmm::device_uvector<int64_t> cells(0, stream);
+  int64_t nnz = 0;
+  if (denseCells) {
+    nnz = nCells;
+    counts.resize(nCells, stream);
+    auto nPredCols = int(nPred);
+    raft::stats::histogram<T, int>(
+      raft::stats::HistTypeAuto,
+      counts.data(),
+      int(nCells),
+      truthClusterArray,
+      size,
+      1,
+      stream,
+      [=] __device__(T val, int row, int col) {
+        // the histogram calls the binner past the end of the data too (and ignores the result)
+        T pred = row < size ? predClusterArray[row] : minPred;
+        return int(val - minTruth) * nPredCols + int(pred - minPred);
+      });
+  } else {
+    rmm::device_uvector<int64_t> keys(size, stream);
+    thrust::transform(policy,
+                      truthPtr,
+                      truthPtr + size,
+                      predPtr,
+                      keys.data(),
+                      [=] __device__(T truth, T pred) {
+                        return int64_t(truth - minTruth) * nPred + int64_t(pred - minPred);
+                      });
+    thrust::sort(policy, keys.data(), keys.data() + size);
+    counts.resize(size, stream);
+    cells.resize(size, stream);
+    auto ends = thrust::reduce_by_key(policy,
+                                      keys.data(),
+                                      keys.data() + size,
+                                      thrust::make_constant_iterator(1),
+                                      cells.data(),
+                                      counts.data());
+    nnz       = ends.first - cells.data();
+  }
+
+  // the marginals: the sizes of the truth and of the predicted classes
+  rmm::device_uvector<int> truthSizes(nTruth, stream);
+  rmm::device_uvector<int> predSizes(nPred, stream);
+  RAFT_CUDA_TRY(cudaMemsetAsync(truthSizes.data(), 0, nTruth * sizeof(int), stream));
+  RAFT_CUDA_TRY(cudaMemsetAsync(predSizes.data(), 0, nPred * sizeof(int), stream));
+  {
+    const int* cellCounts  = counts.data();
+    const int64_t* cellIds = denseCells ? nullptr : cells.data();
+    int* truthSizesPtr     = truthSizes.data();
+    int* predSizesPtr      = predSizes.data();
+    thrust::for_each(policy,
+                     thrust::make_counting_iterator<int64_t>(0),
+                     thrust::make_counting_iterator<int64_t>(nnz),
+                     [=] __device__(int64_t i) {
+                       int n = cellCounts[i];
+                       if (n == 0) { return; }
+                       int64_t cell = cellIds == nullptr ? i : cellIds[i];
+                       raft::myAtomicAdd(truthSizesPtr + cell / nPred, n);
+                       raft::myAtomicAdd(predSizesPtr + cell % nPred, n);
+                     });
+  }
+
+  auto cellSums  = reduce_counts(counts.data(), nnz, stream);
+  auto truthSums = reduce_counts(truthSizes.data(), nTruth, stream);
+  auto predSums  = reduce_counts(predSizes.data(), nPred, stream);
+
+  clustering_metrics_result res;
+  auto n          = double(size);
+  auto nChooseTwo = n * (n - 1) / 2.0;
+
+  // adjusted Rand index (with the degenerate cases of compute_adjusted_rand_index)
+  if (truthSums.non_zero == predSums.non_zero &&
+      (truthSums.non_zero == 1 || truthSums.non_zero == n)) {
+    res.adjusted_rand_index = 1.0;
+  } else {
+    auto expectedIndex = truthSums.pairs * predSums.pairs / nChooseTwo;
+    auto maxIndex      = (truthSums.pairs + predSums.pairs) / 2.0;
+    res.adjusted_rand_index =
+      maxIndex - expectedIndex != 0 ? (cellSums.pairs - expectedIndex) / (maxIndex - expectedIndex)
+                                    : 0;
+  }
+
+  // Rand index: the pairs in the same class in both clusterings, plus those in different classes
+  // in both
+  auto differentInBoth = nChooseTwo - truthSums.pairs - predSums.pairs + cellSums.pairs;
+  res.rand_index       = (cellSums.pairs + differentInBoth) / nChooseTwo;
+
+  // sum_ij n_ij log(n n_ij / (a_i b_j)) / n, with sum_ij n_ij log(a_i) = sum_i a_i log(a_i)
+  auto logN         = std::log(n);
+  auto mutualInfo   = logN + (cellSums.n_log_n - truthSums.n_log_n - predSums.n_log_n) / n;
+  res.mutual_info   = std::max(0.0, mutualInfo);
+  auto truthEntropy = std::max(0.0, logN - truthSums.n_log_n / n);
+  auto predEntropy  = std::max(0.0, logN - predSums.n_log_n / n);
+  res.homogeneity   = truthEntropy > 0 ? res.mutual_info / truthEntropy : 1.0;
+  res.completeness  = predEntropy > 0 ? res.mutual_info / predEntropy : 1.0;
+  res.v_measure     = res.homogeneity + res.completeness == 0.0
+                        ? 0.0
+                        : (1 + beta) * res.homogeneity * res.completeness /
+                            (beta * res.homogeneity + res.completeness);
+  return res;
+}
+
+};  // end namespace detail
+};  // end namespace stats
+};  // end namespace raft
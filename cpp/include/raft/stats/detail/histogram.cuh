@@ -21,8 +21,14 @@
 #include <raft/util/cudart_utils.hpp>
 #include <raft/util/seive.hpp>
 #include <raft/util/vectorized.cuh>
+#include <rmm/device_uvector.hpp>
 #include <stdint.h>
 
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
 // This file is a shameless amalgamation of independent works done by
 // Lars Nyland and Andy Adinets
 
@@ -108,29 +114,34 @@ void gmemHist(int* bins,
     <<<blks, ThreadsPerBlock, 0, stream>>>(bins, data, nrows, nbins, binner);
 }
 
+/**
+ * The shared memory bins of a block: `nCopies` copies of `nbins` bins, the warp `w` of the block
+ * updating the copy `w % nCopies`.
+ */
 template <typename DataT, typename BinnerOp, typename IdxT, int VecLen, bool UseMatchAny>
 __global__ void smemHistKernel(
-  int* bins, const DataT* data, IdxT nrows, IdxT nbins, BinnerOp binner)
+  int* bins, const DataT* data, IdxT nrows, IdxT nbins, BinnerOp binner, int nCopies)
 {
   extern __shared__ unsigned sbins[];
-  for (auto i = threadIdx.x; i < nbins; i += blockDim.x) {
+  for (auto i = threadIdx.x; i < nbins * nCopies; i += blockDim.x) {
     sbins[i] = 0;
   }
   __syncthreads();
-  auto op = [=] __device__(int binId, IdxT row, IdxT col) {
+  unsigned* wbins = sbins + (threadIdx.x / raft::WarpSize) % nCopies * nbins;
+  auto op         = [=] __device__(int binId, IdxT row, IdxT col) {
     if (row >= nrows) return;
 #if __CUDA_ARCH__ < 700
-    raft::myAtomicAdd<unsigned int>(sbins + binId, 1);
+    raft::myAtomicAdd<unsigned int>(wbins + binId, 1);
 #else
     if (UseMatchAny) {
       auto amask  = __activemask();
       auto mask   = __match_any_sync(amask, binId);
       auto leader = __ffs(mask) - 1;
       if (raft::laneId() == leader) {
-        raft::myAtomicAdd<unsigned int>(sbins + binId, __popc(mask));
+        raft::myAtomicAdd<unsigned int>(wbins + binId, __popc(mask));
       }
     } else {
-      raft::myAtomicAdd<unsigned int>(sbins + binId, 1);
+      raft::myAtomicAdd<unsigned int>(wbins + binId, 1);
     }
 #endif  // __CUDA_ARCH__
   };
@@ -139,7 +150,10 @@ __global__ void smemHistKernel(
   __syncthreads();
   auto binOffset = col * nbins;
   for (auto i = threadIdx.x; i < nbins; i += blockDim.x) {
-    auto val = sbins[i];
+    unsigned val = 0;
+    for (int c = 0; c < nCopies; ++c) {
+      val += sbins[c * nbins + i];
+    }
     if (val > 0) { raft::myAtomicAdd<unsigned int>((unsigned int*)bins + binOffset + i, val); }
   }
 }
@@ -151,13 +165,24 @@ void smemHist(int* bins,
               IdxT nrows,
               IdxT ncols,
               BinnerOp binner,
-              cudaStream_t stream)
+              cudaStream_t stream,
+              int nCopies = 1)
 {
   auto blks = computeGridDim<IdxT, VecLen>(
     nrows, ncols, (const void*)smemHistKernel<DataT, BinnerOp, IdxT, VecLen, UseMatchAny>);
-  size_t smemSize = nbins * sizeof(unsigned);
+  size_t smemSize = nbins * nCopies * sizeof(unsigned);
   smemHistKernel<DataT, BinnerOp, IdxT, VecLen, UseMatchAny>
-    <<<blks, ThreadsPerBlock, smemSize, stream>>>(bins, data, nrows, nbins, binner);
+    <<<blks, ThreadsPerBlock, smemSize, stream>>>(bins, data, nrows, nbins, binner, nCopies);
+}
+
+/** The number of copies of the bins, one per warp of a block at most, fitting the shared memory. */
+template <typename IdxT>
+int perWarpCopies(IdxT nbins)
+{
+  size_t smem       = raft::getSharedMemPerBlock();
+  size_t copiesFit  = smem / std::max<size_t>(nbins * sizeof(unsigned), 1);
+  size_t warpsCount = ThreadsPerBlock / raft::WarpSize;
+  return static_cast<int>(std::max<size_t>(1, std::min(copiesFit, warpsCount)));
 }
 
 template <unsigned _BIN_BITS>
@@ -387,6 +412,10 @@ void histogramVecLen(HistType type,
       smemHist<DataT, BinnerOp, IdxT, VecLen, true>(
         bins, nbins, data, nrows, ncols, binner, stream);
       break;
+    case HistTypeSmemPerWarp:
+      smemHist<DataT, BinnerOp, IdxT, VecLen, true>(
+        bins, nbins, data, nrows, ncols, binner, stream, perWarpCopies(nbins));
+      break;
     case HistTypeSmemBits16:
       smemBitsHist<DataT, BinnerOp, IdxT, 16, VecLen>(
         bins, nbins, data, nrows, ncols, binner, stream);
@@ -459,6 +488,114 @@ HistType selectBestHistAlgo(IdxT nbins)
   return HistTypeGmem;
 }
 
+/** The statistics of a sample of the bin ids of the input, see `profileHistInput`. */
+struct HistProfile {
+  /** The number of the sampled elements */
+  int nSamples = 0;
+  /** The number of the distinct bins in the sample */
+  int nDistinct = 0;
+  /** The fraction of the sample falling into its most frequent bin */
+  float maxBinFraction = 0.f;
+  /** The average fraction of the elements of a warp-sized chunk repeating a bin of the chunk */
+  float warpRepeatFraction = 0.f;
+};
+
+/** Every block computes the bin ids of a chunk of `WarpSize` consecutive input elements. */
+template <typename DataT, typename BinnerOp, typename IdxT>
+__global__ void sampleBinsKernel(
+  int* sampleBins, const DataT* data, IdxT nrows, IdxT ncols, BinnerOp binner)
+{
+  size_t len    = size_t(nrows) * size_t(ncols);
+  size_t stride = len / gridDim.x;
+  size_t i      = stride * blockIdx.x + threadIdx.x;
+  int binId     = std::numeric_limits<int>::min();
+  if (i < len) {
+    auto row = IdxT(i % nrows);
+    auto col = IdxT(i / nrows);
+    binId    = binner(data[i], row, col);
+  }
+  sampleBins[blockIdx.x * blockDim.x + threadIdx.x] = binId;
+}
+
+/**
+ * Sample the bin ids of up to `nChunks` warp-sized chunks of consecutive elements, evenly spread
+ * over the input, and summarize them. This synchronizes the stream.
+ */
+template <typename DataT, typename BinnerOp, typename IdxT>
+HistProfile profileHistInput(
+  const DataT* data, IdxT nrows, IdxT ncols, cudaStream_t stream, BinnerOp binner, int nChunks = 64)
+{
+  size_t len = size_t(nrows) * size_t(ncols);
+  nChunks    = static_cast<int>(std::max<size_t>(1, std::min<size_t>(nChunks, len / WarpSize)));
+  rmm::device_uvector<int> sampleBins(size_t(nChunks) * WarpSize, stream);
+  sampleBinsKernel<DataT, BinnerOp, IdxT>
+    <<<nChunks, WarpSize, 0, stream>>>(sampleBins.data(), data, nrows, ncols, binner);
+  RAFT_CUDA_TRY(cudaGetLastError());
+  std::vector<int> hostBins(sampleBins.size());
+  raft::update_host(hostBins.data(), sampleBins.data(), sampleBins.size(), stream);
+  RAFT_CUDA_TRY(cudaStreamSynchronize(stream));
+
+  HistProfile profile;
+  std::unordered_map<int, int> counts;
+  int maxCount      = 0;
+  float repeatTotal = 0.f;
+  for (int c = 0; c < nChunks; ++c) {
+    std::unordered_map<int, int> chunkCounts;
+    int chunkSize = 0;
+    for (int j = 0; j < WarpSize; ++j) {
+      int binId = hostBins[c * WarpSize + j];
+      if (binId == std::numeric_limits<int>::min()) { continue; }
+      chunkSize++;
+      chunkCounts[binId]++;
+      maxCount = std::max(maxCount, ++counts[binId]);
+    }
+    if (chunkSize > 0) {
+      repeatTotal += float(chunkSize - int(chunkCounts.size())) / float(chunkSize);
+    }
+    profile.nSamples += chunkSize;
+  }
+  profile.nDistinct          = static_cast<int>(counts.size());
+  profile.maxBinFraction     = profile.nSamples > 0 ? float(maxCount) / profile.nSamples : 0.f;
+  profile.warpRepeatFraction = repeatTotal / nChunks;
+  return profile;
+}
+
+/**
+ * Choose the algo from the profile of the input:
+ *
+ *  - the bins fitting the shared memory are privatized per block; on top of that, the repetitions
+ *    within a warp are aggregated with `match_any`, and a very frequent bin is spread over the
+ *    per-warp copies of the bins;
+ *  - otherwise, a small active set of bins (few distinct bins in the sample) is hashed;
+ *  - otherwise, the bins are bit-packed in the shared memory, unless a very frequent bin would
+ *    overflow the narrow counters all the time;
+ *  - otherwise, the global memory atomics are used.
+ */
+template <typename IdxT>
+HistType selectProfiledHistAlgo(IdxT nbins, const HistProfile& profile)
+{
+  // a bin receiving this fraction of the input serializes the atomics of a block on it
+  constexpr float kHotBinFraction = 0.125f;
+  // this fraction of repetitions within a warp makes the aggregation worth the `match_any`
+  constexpr float kWarpRepeatFraction = 0.5f;
+  const bool hot                      = profile.maxBinFraction >= kHotBinFraction;
+  size_t smem                         = raft::getSharedMemPerBlock();
+  if (nbins * sizeof(unsigned) <= smem) {
+    if (hot && perWarpCopies(nbins) > 1) { return HistTypeSmemPerWarp; }
+    if (hot || profile.warpRepeatFraction >= kWarpRepeatFraction) { return HistTypeSmemMatchAny; }
+    return HistTypeSmem;
+  }
+  // The active bins fit the hash table with a low load factor, and the tail of the sample repeats
+  // them (otherwise the sample alone does not bound the active set).
+  const int hashSize = computeHashTableSize();
+  if (profile.nDistinct * 4 <= hashSize && profile.nDistinct * 4 <= profile.nSamples) {
+    return HistTypeSmemHash;
+  }
+  auto bitsType = selectBestHistAlgo(nbins);
+  if (bitsType != HistTypeGmem && hot && static_cast<int>(bitsType) < 8) { return HistTypeGmem; }
+  return bitsType;
+}
+
 /**
  * @brief Perform histogram on the input data. It chooses the right load size
  * based on the input data vector length. It also supports large-bin cases
@@ -489,6 +626,11 @@ void histogram(HistType type,
 {
   HistType computedType = type;
   if (type == HistTypeAuto) { computedType = selectBestHistAlgo(nbins); }
+  if (type == HistTypeAutoProfiled) {
+    if (nrows <= 0) { return; }
+    computedType =
+      selectProfiledHistAlgo(nbins, profileHistInput(data, nrows, ncols, stream, binner));
+  }
   histogramImpl<DataT, BinnerOp, IdxT>(
     computedType, bins, nbins, data, nrows, ncols, stream, binner);
 }
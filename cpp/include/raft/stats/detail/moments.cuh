@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/comms.hpp>
+#include <raft/core/resource/cublas_handle.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/linalg/detail/cublas_wrappers.hpp>
+#include <raft/linalg/eltwise.cuh>
+#include <raft/linalg/gemm.cuh>
+#include <raft/stats/detail/meanvar.cuh>
+#include <raft/stats/mean_center.cuh>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+#include <rmm/device_scalar.hpp>
+#include <rmm/device_uvector.hpp>
+
+#include <cstdint>
+
+namespace raft::stats::detail {
+
+/**
+ * The mean and the sum of the squared deviations (M2) of every column of a set `a`, merged with
+ * those of a set `b` (Chan et al.):
+ *   delta = mean_b - mean_a
+ *   M2    = M2_a + M2_b + w * delta^2
+ *   mean  = mean_a + frac_b * delta
+ * with `w = n_a * n_b / n` and `frac_b = n_b / n`. `m2_b` may be null (M2_b = 0).
+ */
+template <typename T, typename I>
+__global__ void merge_mean_m2_kernel(
+  T* mean, T* m2, const T* mean_b, const T* m2_b, T w, T frac_b, I D)
+{
+  I i = threadIdx.x + blockDim.x * I(blockIdx.x);
+  if (i >= D) return;
+  T delta = mean_b[i] - mean[i];
+  m2[i] += (m2_b == nullptr ? T(0) : m2_b[i]) + w * delta * delta;
+  mean[i] += frac_b * delta;
+}
+
+/**
+ * The co-moment matrix (the sum of the outer products of the deviations) of a set `a`, merged with
+ * that of a set `b`: C = C_a + C_b + w * delta * delta^T. `comoment_b` may be null (C_b = 0).
+ * This uses the means before their merge.
+ */
+template <typename T, typename I>
+__global__ void merge_comoment_kernel(
+  T* comoment, const T* comoment_b, const T* mean, const T* mean_b, T w, I D)
+{
+  int64_t idx = threadIdx.x + blockDim.x * int64_t(blockIdx.x);
+  if (idx >= int64_t(D) * D) return;
+  I row = idx / D;
+  I col = idx % D;
+  comoment[idx] += (comoment_b == nullptr ? T(0) : comoment_b[idx]) +
+                   w * (mean_b[row] - mean[row]) * (mean_b[col] - mean[col]);
+}
+
+/**
+ * @brief Merge the moments of a set `b` into those of a set `a`.
+ *
+ * @param[inout] mean the means of `a` [D]
+ * @param[inout] m2 the sums of the squared deviations of `a` [D]
+ * @param[inout] comoment the co-moment matrix of `a`, or null [D, D]
+ * @param[in] n the number of rows of `a`
+ * @param[in] mean_b the means of `b` [D]
+ * @param[in] m2_b the sums of the squared deviations of `b`, or null if zero [D]
+ * @param[in] comoment_b the co-moment matrix of `b`, or null if zero (or not tracked) [D, D]
+ * @param[in] n_b the number of rows of `b`
+ * @param[in] D the number of columns
+ * @param[in] stream cuda stream
+ */
+template <typename T, typename I>
+void merge_moments(T* mean,
+                   T* m2,
+                   T* comoment,
+                   int64_t n,
+                   const T* mean_b,
+                   const T* m2_b,
+                   const T* comoment_b,
+                   int64_t n_b,
+                   I D,
+                   cudaStream_t stream)
+{
+  if (n_b == 0) return;
+  constexpr int kBlockSize = 256;
+
+  auto n_total = double(n) + double(n_b);
+  T w          = T(double(n) * double(n_b) / n_total);
+  T frac_b     = T(double(n_b) / n_total);
+  if (comoment != nullptr) {
+    auto len = int64_t(D) * D;
+    merge_comoment_kernel<T, I><<<raft::ceildiv<int64_t>(len, kBlockSize), kBlockSize, 0, stream>>>(
+      comoment, comoment_b, mean, mean_b, w, D);
+  }
+  merge_mean_m2_kernel<T, I><<<raft::ceildiv<I>(D, kBlockSize), kBlockSize, 0, stream>>>(
+    mean, m2, mean_b, m2_b, w, frac_b, D);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+}
+
+/**
+ * @brief Merge the moments of a block of rows into the accumulated ones.
+ *
+ * The block is read by the single-sweep `meanvar` for its means and sums of squared deviations;
+ * if the co-moments are tracked, a copy of the block is centered by its own means before the GEMM,
+ * so that the data is never modified and no cancellation happens however far the data is from the
+ * origin.
+ */
+template <typename T, typename I>
+void update_moments(raft::resources const& handle,
+                    T* mean,
+                    T* m2,
+                    T* comoment,
+                    int64_t n,
+                    const T* data,
+                    I D,
+                    I N,
+                    bool rowMajor)
+{
+  if (N == 0) return;
+  auto stream = resource::get_cuda_stream(handle);
+  rmm::device_uvector<T> batch_mean(D, stream);
+  rmm::device_uvector<T> batch_m2(D, stream);
+  meanvar(batch_mean.data(), batch_m2.data(), data, D, N, false, rowMajor, stream);
+  raft::linalg::scalarMultiply(batch_m2.data(), batch_m2.data(), T(N), D, stream);
+
+  if (comoment != nullptr) {
+    // the batch co-moments are added by the GEMM, the cross term by `merge_moments`
+    rmm::device_uvector<T> centered(size_t(N) * D, stream);
+    raft::stats::meanCenter(centered.data(), data, batch_mean.data(), D, N, rowMajor, true, stream);
+    T alpha = T(1);
+    T beta  = T(1);
+    if (rowMajor) {
+      RAFT_CUBLAS_TRY(raft::linalg::detail::cublasgemm(resource::get_cublas_handle(handle),
+                                                       CUBLAS_OP_N,
+                                                       CUBLAS_OP_T,
+                                                       D,
+                                                       D,
+                                                       N,
+                                                       &alpha,
+                                                       centered.data(),
+                                                       D,
+                                                       centered.data(),
+                                                       D,
+                                                       &beta,
+                                                       comoment,
+                                                       D,
+                                                       stream));
+    } else {
+      raft::linalg::gemm(handle,
+                         centered.data(),
+                         N,
+                         D,
+                         centered.data(),
+                         comoment,
+                         D,
+                         D,
+                         CUBLAS_OP_T,
+                         CUBLAS_OP_N,
+                         alpha,
+                         beta,
+                         stream);
+    }
+  }
+  merge_moments(mean, m2, comoment, n, batch_mean.data(), batch_m2.data(), nullptr, N, D, stream);
+}
+
+/**
+ * @brief Merge the moments of all the ranks, in place on every rank; returns the total number of
+ * rows.
+ *
+ * The partial moments do not add up as they are, so the merge takes two allreduce collectives:
+ * the first sums the rows and `n_r * mean_r` for the global means, then every rank shifts its
+ * M2 and co-moments to the global means (M2_r + n_r * (mean_r - mean)^2) and the second sums them.
+ */
+template <typename T, typename I>
+int64_t allreduce_moments(const raft::comms::comms_t& comm,
+                          T* mean,
+                          T* m2,
+                          T* comoment,
+                          int64_t n,
+                          I D,
+                          cudaStream_t stream)
+{
+  rmm::device_scalar<int64_t> d_n_total(n, stream);
+  comm.allreduce(d_n_total.data(), d_n_total.data(), 1, raft::comms::op_t::SUM, stream);
+  rmm::device_uvector<T> global_mean(D, stream);
+  raft::linalg::scalarMultiply(global_mean.data(), mean, T(n), D, stream);
+  comm.allreduce(global_mean.data(), global_mean.data(), D, raft::comms::op_t::SUM, stream);
+  RAFT_EXPECTS(comm.sync_stream(stream) == raft::comms::status_t::SUCCESS,
+               "allreduce of the moments failed");
+  int64_t n_total = d_n_total.value(stream);
+  if (n_total == 0) return 0;
+  raft::linalg::scalarMultiply(
+    global_mean.data(), global_mean.data(), T(1.0 / double(n_total)), D, stream);
+
+  // shift the local moments to the global means: w = n_r, frac_b = 1
+  constexpr int kBlockSize = 256;
+  if (comoment != nullptr) {
+    auto len = int64_t(D) * D;
+    merge_comoment_kernel<T, I><<<raft::ceildiv<int64_t>(len, kBlockSize), kBlockSize, 0, stream>>>(
+      comoment, nullptr, mean, global_mean.data(), T(n), D);
+  }
+  merge_mean_m2_kernel<T, I><<<raft::ceildiv<I>(D, kBlockSize), kBlockSize, 0, stream>>>(
+    mean, m2, global_mean.data(), nullptr, T(n), T(1), D);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+
+  comm.allreduce(m2, m2, D, raft::comms::op_t::SUM, stream);
+  if (comoment != nullptr) {
+    comm.allreduce(comoment, comoment, size_t(D) * D, raft::comms::op_t::SUM, stream);
+  }
+  RAFT_EXPECTS(comm.sync_stream(stream) == raft::comms::status_t::SUCCESS,
+               "allreduce of the moments failed");
+  return n_total;
+}
+
+}  // namespace raft::stats::detail
@@ -0,0 +1,442 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "silhouette_score.cuh"
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/distance/detail/distance_ops/l1.cuh>
+#include <raft/distance/detail/distance_ops/l2_exp.cuh>
+#include <raft/distance/detail/distance_ops/l2_unexp.cuh>
+#include <raft/distance/detail/pairwise_distance_base.cuh>
+#include <raft/distance/distance_types.hpp>
+#include <raft/linalg/contractions.cuh>
+#include <raft/linalg/norm.cuh>
+#include <raft/matrix/gather.cuh>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+#include <raft/util/device_atomics.cuh>
+#include <rmm/device_uvector.hpp>
+
+#include <thrust/reduce.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+namespace raft {
+namespace stats {
+namespace detail {
+
+/** Whether `silhouette_score_fused` supports the metric. */
+inline bool silhouette_fused_supported(raft::distance::DistanceType metric)
+{
+  switch (metric) {
+    case raft::distance::DistanceType::L2Expanded:
+    case raft::distance::DistanceType::L2SqrtExpanded:
+    case raft::distance::DistanceType::L2Unexpanded:
+    case raft::distance::DistanceType::L2SqrtUnexpanded:
+    case raft::distance::DistanceType::L1: return true;
+    default: return false;
+  }
+}
+
+/**
+ * @brief The sums of the distances of the rows of x to the rows of y per label of y, computed tile
+ * by tile without writing the distances.
+ *
+ * The rows of y are sorted by their labels, so that the columns of a tile span few labels: every
+ * thread merges its consecutive columns of the same label in registers, and, when the labels of a
+ * tile span fewer than `Nblk` values, the threads sharing a row merge them in the shared memory
+ * before adding them to `sums`. The distance of a point to itself is skipped.
+ *
+ * @param[inout] sums the sums per row of x and label [m, n_labels]
+ * @param[in] x_ids the ids of the rows of x in the dataset [m]
+ * @param[in] y_ids the ids of the rows of y in the dataset [n]
+ * @param[in] y_labels the labels of the rows of y, sorted [n]
+ */
+template <typename DataT, typename IdxT, typename LabelT, typename P, typename OpT>
+__global__ __launch_bounds__(P::Nthreads, 2) void label_sums_kernel(DataT* sums,
+                                                                    const DataT* x,
+                                                                    const DataT* y,
+                                                                    const DataT* xn,
+                                                                    const DataT* yn,
+                                                                    IdxT m,
+                                                                    IdxT n,
+                                                                    IdxT k,
+                                                                    const IdxT* x_ids,
+                                                                    const IdxT* y_ids,
+                                                                    const LabelT* y_labels,
+                                                                    IdxT n_labels,
+                                                                    OpT distance_op)
+{
+  extern __shared__ char smem[];
+  // the sums of a tile per row and label (relative to the first label of the tile), after the
+  // shared memory of the distance tiles
+  auto* win = reinterpret_cast<DataT*>(smem + OpT::template shared_mem_size<P>());
+  for (int i = threadIdx.x; i < P::Mblk * P::Nblk; i += P::Nthreads) {
+    win[i] = 0;
+  }
+  __syncthreads();
+
+  auto epilog_lambda = [=] __device__(DataT acc[P::AccRowsPerTh][P::AccColsPerTh],
+                                      DataT * regxn,
+                                      DataT * regyn,
+                                      IdxT gridStrideX,
+                                      IdxT gridStrideY) {
+    const auto acccolid     = threadIdx.x % P::AccThCols;
+    const auto accrowid     = threadIdx.x / P::AccThCols;
+    const IdxT last_col     = min(gridStrideX + IdxT(P::Nblk), n) - 1;
+    const auto first_label  = y_labels[gridStrideX];
+    const auto n_win_labels = int64_t(y_labels[last_col]) - int64_t(first_label) + 1;
+    const bool use_win      = n_win_labels <= P::Nblk;
+
+    auto flush = [&](IdxT row, LabelT label, DataT sum) {
+      if (use_win) {
+        atomicAdd(win + (row - gridStrideY) * P::Nblk + (label - first_label), sum);
+      } else {
+        atomicAdd(sums + int64_t(row) * n_labels + label, sum);
+      }
+    };
+#pragma unroll
+    for (int i = 0; i < P::AccRowsPerTh; ++i) {
+      const IdxT row = accrowid + i * P::AccThRows + gridStrideY;
+      if (row >= m) { continue; }
+      const IdxT row_id = x_ids[row];
+      LabelT run_label  = 0;
+      DataT run_sum     = 0;
+      bool in_run       = false;
+#pragma unroll
+      for (int j = 0; j < P::AccColsPerTh; ++j) {
+        const IdxT col = acccolid + j * P::AccThCols + gridStrideX;
+        if (col >= n || y_ids[col] == row_id) { continue; }
+        const LabelT label = y_labels[col];
+        if (in_run && label != run_label) {
+          flush(row, run_label, run_sum);
+          run_sum = 0;
+        }
+        run_label = label;
+        run_sum += acc[i][j];
+        in_run = true;
+      }
+      if (in_run) { flush(row, run_label, run_sum); }
+    }
+    if (use_win) {
+      __syncthreads();
+      for (int t = threadIdx.x; t < P::Mblk * n_win_labels; t += P::Nthreads) {
+        const int r = t / n_win_labels;
+        const int l = t % n_win_labels;
+        DataT& v    = win[r * P::Nblk + l];
+        if (v != 0) {
+          atomicAdd(sums + int64_t(gridStrideY + r) * n_labels + first_label + l, v);
+          v = 0;
+        }
+      }
+      __syncthreads();
+    }
+  };
+
+  constexpr bool row_major = true;
+  constexpr bool write_out = false;
+  raft::distance::detail::PairwiseDistances<DataT,
+                                            DataT,  // OutT (unused in PairwiseDistances)
+                                            IdxT,
+                                            P,
+                                            OpT,
+                                            decltype(epilog_lambda),
+                                            raft::identity_op,
+                                            raft::void_op,
+                                            row_major,
+                                            write_out>
+    obj(x,
+        y,
+        m,
+        n,
+        k,
+        k,
+        k,
+        n,
+        xn,
+        yn,
+        nullptr,  // Output pointer
+        smem,
+        distance_op,
+        epilog_lambda,
+        raft::identity_op{},
+        raft::void_op{});
+  obj.run();
+}
+
+template <typename DataT, typename IdxT, typename LabelT, int VecLen, typename OpT>
+void label_distance_sums_veclen(DataT* sums,
+                                const DataT* x,
+                                const DataT* y,
+                                const DataT* xn,
+                                const DataT* yn,
+                                IdxT m,
+                                IdxT n,
+                                IdxT k,
+                                const IdxT* x_ids,
+                                const IdxT* y_ids,
+                                const LabelT* y_labels,
+                                IdxT n_labels,
+                                OpT distance_op,
+                                cudaStream_t stream)
+{
+  using P          = typename raft::linalg::Policy4x4<DataT, VecLen>::Policy;
+  auto kernel      = label_sums_kernel<DataT, IdxT, LabelT, P, OpT>;
+  size_t smem_size = OpT::template shared_mem_size<P>() + P::Mblk * P::Nblk * sizeof(DataT);
+  RAFT_CUDA_TRY(
+    cudaFuncSetAttribute(kernel, cudaFuncAttributeMaxDynamicSharedMemorySize, smem_size));
+  dim3 grid = raft::distance::detail::launchConfigGenerator<P>(m, n, smem_size, kernel);
+  kernel<<<grid, P::Nthreads, smem_size, stream>>>(
+    sums, x, y, xn, yn, m, n, k, x_ids, y_ids, y_labels, n_labels, distance_op);
+  RAFT_CUDA_TRY(cudaGetLastError());
+}
+
+template <typename DataT, typename IdxT, typename LabelT, typename OpT>
+void label_distance_sums(DataT* sums,
+                         const DataT* x,
+                         const DataT* y,
+                         const DataT* xn,
+                         const DataT* yn,
+                         IdxT m,
+                         IdxT n,
+                         IdxT k,
+                         const IdxT* x_ids,
+                         const IdxT* y_ids,
+                         const LabelT* y_labels,
+                         IdxT n_labels,
+                         OpT distance_op,
+                         cudaStream_t stream)
+{
+  constexpr int kMaxVecLen = 16 / sizeof(DataT);
+  bool aligned_ptrs = reinterpret_cast<uintptr_t>(x) % 16 == 0 &&
+                      reinterpret_cast<uintptr_t>(y) % 16 == 0;
+  if (aligned_ptrs && k % kMaxVecLen == 0) {
+    label_distance_sums_veclen<DataT, IdxT, LabelT, kMaxVecLen>(
+      sums, x, y, xn, yn, m, n, k, x_ids, y_ids, y_labels, n_labels, distance_op, stream);
+  } else {
+    label_distance_sums_veclen<DataT, IdxT, LabelT, 1>(
+      sums, x, y, xn, yn, m, n, k, x_ids, y_ids, y_labels, n_labels, distance_op, stream);
+  }
+}
+
+/**
+ * @brief The silhouette score of the rows from their sums of distances per label; one warp per
+ * row.
+ */
+template <typename DataT, typename IdxT, typename LabelT>
+__global__ void silhouette_from_sums_kernel(DataT* scores,
+                                            const DataT* sums,
+                                            const IdxT* x_ids,
+                                            const LabelT* labels,
+                                            const int* counts,
+                                            IdxT m,
+                                            IdxT n_labels)
+{
+  const int64_t row = (blockIdx.x * int64_t(blockDim.x) + threadIdx.x) / raft::WarpSize;
+  const int lane    = raft::laneId();
+  if (row >= m) { return; }
+  const DataT* row_sums = sums + row * n_labels;
+  const LabelT own      = labels[x_ids[row]];
+
+  DataT b = std::numeric_limits<DataT>::max();
+  for (IdxT l = lane; l < n_labels; l += raft::WarpSize) {
+    if (l != own && counts[l] > 0) { b = min(b, row_sums[l] / counts[l]); }
+  }
+#pragma unroll
+  for (int offset = raft::WarpSize / 2; offset > 0; offset >>= 1) {
+    b = min(b, raft::shfl_xor(b, offset));
+  }
+  if (lane == 0) {
+    // a = -1 marks a singleton cluster, whose score is zero
+    DataT a     = counts[own] > 1 ? row_sums[own] / (counts[own] - 1) : DataT(-1);
+    scores[row] = SilOp<DataT>()(a, b);
+  }
+}
+
+template <typename DataT, typename IdxT, typename LabelT>
+void silhouette_from_sums(DataT* scores,
+                          const DataT* sums,
+                          const IdxT* x_ids,
+                          const LabelT* labels,
+                          const int* counts,
+                          IdxT m,
+                          IdxT n_labels,
+                          cudaStream_t stream)
+{
+  constexpr int kThreads = 256;
+  auto n_blocks          = raft::ceildiv<int64_t>(int64_t(m) * raft::WarpSize, kThreads);
+  silhouette_from_sums_kernel<<<n_blocks, kThreads, 0, stream>>>(
+    scores, sums, x_ids, labels, counts, m, n_labels);
+  RAFT_CUDA_TRY(cudaGetLastError());
+}
+
+/**
+ * @brief The silhouette score with the fused distance and per-label reduction: no distance matrix
+ * (nor chunks of it) is stored, only the sums of the distances of a batch of rows per label.
+ *
+ * If `n_samples` is positive and smaller than `nRows`, this is the sampled estimator: the mean of
+ * the (exact) silhouette scores of `n_samples` rows drawn uniformly without replacement, at the
+ * cost of `n_samples * nRows` distances instead of `nRows * nRows`.
+ *
+ * @param handle raft handle
+ * @param X_in the data [nRows, nCols]
+ * @param labels the labels in [0, nLabels) [nRows]
+ * @param silhouette_scorePerSample optional, the scores of the rows [nRows]; only if not sampled
+ * @param metric one of the metrics of `silhouette_fused_supported`
+ * @param batch_rows the number of rows whose sums are kept at a time (0 for automatic)
+ * @param n_samples the number of sampled rows (0 for all)
+ * @param seed the seed of the sample
+ */
+template <typename DataT, typename LabelT>
+DataT silhouette_score_fused(raft::resources const& handle,
+                             const DataT* X_in,
+                             int nRows,
+                             int nCols,
+                             const LabelT* labels,
+                             int nLabels,
+                             DataT* silhouette_scorePerSample,
+                             raft::distance::DistanceType metric,
+                             int batch_rows = 0,
+                             int n_samples  = 0,
+                             uint64_t seed  = 0)
+{
+  ASSERT(nLabels >= 2 && nLabels <= (nRows - 1),
+         "silhouette Score not defined for the given number of labels!");
+  RAFT_EXPECTS(silhouette_fused_supported(metric),
+               "The metric is not supported by the fused silhouette score");
+  auto stream = resource::get_cuda_stream(handle);
+  auto policy = resource::get_thrust_policy(handle);
+
+  bool sampled = n_samples > 0 && n_samples < nRows;
+  RAFT_EXPECTS(!sampled || silhouette_scorePerSample == nullptr,
+               "The scores per sample are not available with the sampled estimator");
+  int n_queries = sampled ? n_samples : nRows;
+  if (batch_rows <= 0) { batch_rows = std::max(1, (1 << 24) / nLabels); }
+  batch_rows = std::min(batch_rows, n_queries);
+
+  // the sizes of the clusters
+  rmm::device_uvector<int> counts(nLabels, stream);
+  rmm::device_uvector<char> workspace(1, stream);
+  RAFT_CUDA_TRY(cudaMemsetAsync(counts.data(), 0, nLabels * sizeof(int), stream));
+  countLabels(labels, counts.data(), nRows, nLabels, workspace, stream);
+
+  // the columns: the points sorted by label
+  rmm::device_uvector<int> y_ids(nRows, stream);
+  rmm::device_uvector<LabelT> y_labels(nRows, stream);
+  rmm::device_uvector<DataT> y(size_t(nRows) * nCols, stream);
+  thrust::sequence(policy, y_ids.begin(), y_ids.end());
+  raft::copy(y_labels.data(), labels, nRows, stream);
+  thrust::stable_sort_by_key(policy, y_labels.begin(), y_labels.end(), y_ids.begin());
+  raft::matrix::gather(X_in, nCols, nRows, y_ids.data(), nRows, y.data(), stream);
+
+  // the rows: all the points, or the sampled ones
+  rmm::device_uvector<int> x_ids(n_queries, stream);
+  rmm::device_uvector<DataT> x_sampled(0, stream);
+  const DataT* x = X_in;
+  if (sampled) {
+    // Floyd's algorithm: n_samples distinct rows in O(n_samples)
+    std::mt19937_64 gen(seed);
+    std::unordered_set<int> picked;
+    std::vector<int> h_ids;
+    h_ids.reserve(n_samples);
+    for (int j = nRows - n_samples; j < nRows; j++) {
+      int t = std::uniform_int_distribution<int>(0, j)(gen);
+      if (!picked.insert(t).second) {
+        picked.insert(j);
+        t = j;
+      }
+      h_ids.push_back(t);
+    }
+    std::sort(h_ids.begin(), h_ids.end());
+    raft::update_device(x_ids.data(), h_ids.data(), n_samples, stream);
+    x_sampled.resize(size_t(n_samples) * nCols, stream);
+    raft::matrix::gather(X_in, nCols, nRows, x_ids.data(), n_samples, x_sampled.data(), stream);
+    x = x_sampled.data();
+  } else {
+    thrust::sequence(policy, x_ids.begin(), x_ids.end());
+  }
+
+  // the squared norms of the rows, for the expanded L2 metrics
+  bool expanded = metric == raft::distance::DistanceType::L2Expanded ||
+                  metric == raft::distance::DistanceType::L2SqrtExpanded;
+  bool use_sqrt = metric == raft::distance::DistanceType::L2SqrtExpanded ||
+                  metric == raft::distance::DistanceType::L2SqrtUnexpanded;
+  rmm::device_uvector<DataT> xn(expanded ? n_queries : 0, stream);
+  rmm::device_uvector<DataT> yn(expanded ? nRows : 0, stream);
+  if (expanded) {
+    raft::linalg::rowNorm(xn.data(), x, nCols, n_queries, raft::linalg::L2Norm, true, stream);
+    raft::linalg::rowNorm(yn.data(), y.data(), nCols, nRows, raft::linalg::L2Norm, true, stream);
+  }
+
+  rmm::device_uvector<DataT> scores(0, stream);
+  DataT* scores_ptr = silhouette_scorePerSample;
+  if (scores_ptr == nullptr) {
+    scores.resize(n_queries, stream);
+    scores_ptr = scores.data();
+  }
+
+  rmm::device_uvector<DataT> sums(size_t(batch_rows) * nLabels, stream);
+  for (int first = 0; first < n_queries; first += batch_rows) {
+    int m = std::min(batch_rows, n_queries - first);
+    RAFT_CUDA_TRY(cudaMemsetAsync(sums.data(), 0, size_t(m) * nLabels * sizeof(DataT), stream));
+    auto run = [&](auto distance_op) {
+      label_distance_sums<DataT, int, LabelT>(sums.data(),
+                                              x + size_t(first) * nCols,
+                                              y.data(),
+                                              expanded ? xn.data() + first : nullptr,
+                                              expanded ? yn.data() : nullptr,
+                                              m,
+                                              nRows,
+                                              nCols,
+                                              x_ids.data() + first,
+                                              y_ids.data(),
+                                              y_labels.data(),
+                                              nLabels,
+                                              distance_op,
+                                              stream);
+    };
+    if (expanded) {
+      run(raft::distance::detail::ops::l2_exp_distance_op<DataT, DataT, int>{use_sqrt});
+    } else if (metric == raft::distance::DistanceType::L1) {
+      run(raft::distance::detail::ops::l1_distance_op<DataT, DataT, int>{});
+    } else {
+      run(raft::distance::detail::ops::l2_unexp_distance_op<DataT, DataT, int>{use_sqrt});
+    }
+    silhouette_from_sums<DataT, int, LabelT>(scores_ptr + first,
+                                             sums.data(),
+                                             x_ids.data() + first,
+                                             labels,
+                                             counts.data(),
+                                             m,
+                                             nLabels,
+                                             stream);
+  }
+
+  return thrust::reduce(policy, scores_ptr, scores_ptr + n_queries, DataT(0)) / n_queries;
+}
+
+};  // namespace detail
+};  // namespace stats
+};  // namespace raft
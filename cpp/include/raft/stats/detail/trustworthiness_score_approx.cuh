@@ -0,0 +1,294 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/distance/distance.cuh>
+#include <raft/matrix/gather.cuh>
+#include <raft/neighbors/cagra.cuh>
+#include <raft/neighbors/ivf_flat.cuh>
+#include <raft/stats/detail/trustworthiness_score.cuh>
+#include <raft/stats/trustworthiness_types.hpp>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+#include <rmm/device_scalar.hpp>
+#include <rmm/device_uvector.hpp>
+
+#include <thrust/execution_policy.h>
+#include <thrust/transform.h>
+
+#include <algorithm>
+#include <optional>
+#include <vector>
+
+namespace raft {
+namespace stats {
+namespace detail {
+
+/** The ANN index of one space (original or embedded) of `trustworthiness_score_approx`. */
+template <typename math_t>
+class trustworthiness_ann_index {
+ public:
+  trustworthiness_ann_index(const raft::resources& h,
+                            const trustworthiness_approx_params& params,
+                            const math_t* data,
+                            int n,
+                            int dim)
+    : params_(params)
+  {
+    if (params.algo == trustworthiness_ann::CAGRA) {
+      auto index_params   = params.cagra_index_params;
+      index_params.metric = raft::distance::DistanceType::L2Expanded;
+      cagra_.emplace(raft::neighbors::experimental::cagra::build<math_t, uint32_t>(
+        h, index_params, raft::make_device_matrix_view<const math_t, uint32_t>(data, n, dim)));
+    } else {
+      auto index_params    = params.ivf_flat_index_params;
+      index_params.metric  = raft::distance::DistanceType::L2Expanded;
+      index_params.n_lists = std::min<uint32_t>(index_params.n_lists, n);
+      ivf_flat_.emplace(raft::neighbors::ivf_flat::build<math_t, int64_t>(
+        h, index_params, raft::make_device_matrix_view<const math_t, int64_t>(data, n, dim)));
+    }
+  }
+
+  /** Search the `k` nearest neighbors (squared L2) of a batch of the points of the space. */
+  void search(const raft::resources& h,
+              const math_t* queries,
+              int n_queries,
+              int k,
+              int64_t* neighbors,
+              float* distances) const
+  {
+    if (cagra_.has_value()) {
+      auto search_params       = params_.cagra_search_params;
+      search_params.itopk_size = std::max<size_t>(search_params.itopk_size, raft::alignTo(k, 32));
+      auto stream              = resource::get_cuda_stream(h);
+      rmm::device_uvector<uint32_t> neighbors_u32(size_t(n_queries) * k, stream);
+      raft::neighbors::experimental::cagra::search<math_t, uint32_t>(
+        h,
+        search_params,
+        *cagra_,
+        raft::make_device_matrix_view<const math_t, uint32_t>(queries, n_queries, cagra_->dim()),
+        raft::make_device_matrix_view<uint32_t, uint32_t>(neighbors_u32.data(), n_queries, k),
+        raft::make_device_matrix_view<float, uint32_t>(distances, n_queries, k));
+      thrust::transform(thrust::cuda::par.on(stream),
+                        neighbors_u32.begin(),
+                        neighbors_u32.end(),
+                        neighbors,
+                        [] __device__(uint32_t i) { return int64_t(i); });
+    } else {
+      raft::neighbors::ivf_flat::search<math_t, int64_t>(
+        h, params_.ivf_flat_search_params, *ivf_flat_, queries, n_queries, k, neighbors, distances);
+    }
+  }
+
+ private:
+  trustworthiness_approx_params params_;
+  std::optional<raft::neighbors::ivf_flat::index<math_t, int64_t>> ivf_flat_;
+  std::optional<raft::neighbors::experimental::cagra::index<math_t, uint32_t>> cagra_;
+};
+
+/**
+ * @brief Accumulate the trustworthiness penalties of a batch of points, max(0, r - n_neighbors)
+ * for the rank r in the original space of each of their embedded neighbors.
+ *
+ * The rank is the position of the neighbor among the `rank_k` original neighbors of the point, if
+ * it is one of them; otherwise it is at least `rank_k + 1` and is estimated from the fraction of
+ * the sampled points closer to the point than the neighbor. The searched neighbors of a point
+ * skip the point itself.
+ *
+ * @param[out] rank the sum of the penalties
+ * @param[in] emb_ind the embedded neighbors of the batch [batch, n_neighbors + 1]
+ * @param[in] orig_ind the original neighbors of the batch [batch, rank_k + 1]
+ * @param[in] X the original data [n, m]
+ * @param[in] sample_ids the sampled points [n_samples]
+ * @param[in] sample_dist the squared L2 distances of the batch to the samples [batch, n_samples]
+ * @param first_row the first point of the batch
+ * @param batch the number of the points of the batch
+ */
+template <typename math_t>
+__global__ void approx_rank_kernel(double* rank,
+                                   const int64_t* emb_ind,
+                                   const int64_t* orig_ind,
+                                   const math_t* X,
+                                   const int* sample_ids,
+                                   const math_t* sample_dist,
+                                   int64_t first_row,
+                                   int batch,
+                                   int n,
+                                   int m,
+                                   int n_neighbors,
+                                   int rank_k,
+                                   int n_samples)
+{
+  int64_t t = blockIdx.x * int64_t(blockDim.x) + threadIdx.x;
+  if (t >= int64_t(batch) * (n_neighbors + 1)) return;
+  int row   = t / (n_neighbors + 1);
+  int pos   = t % (n_neighbors + 1);
+  int64_t i = first_row + row;
+
+  const int64_t* emb_row = emb_ind + int64_t(row) * (n_neighbors + 1);
+  int64_t j              = emb_row[pos];
+  if (j == i || j < 0 || j >= n) return;
+  // only the first n_neighbors embedded neighbors other than the point itself count
+  int emb_pos = 0;
+  for (int p = 0; p < pos; p++) {
+    if (emb_row[p] != i) emb_pos++;
+  }
+  if (emb_pos >= n_neighbors) return;
+
+  const int64_t* orig_row = orig_ind + int64_t(row) * (rank_k + 1);
+  int64_t r               = 0;
+  bool found              = false;
+  for (int p = 0; p <= rank_k && !found; p++) {
+    int64_t o = orig_row[p];
+    if (o == i) continue;
+    r++;
+    found = o == j;
+  }
+  if (!found) {
+    float d = 0;
+    for (int k = 0; k < m; k++) {
+      float diff = float(X[i * m + k]) - float(X[j * m + k]);
+      d += diff * diff;
+    }
+    const math_t* dist_row = sample_dist + int64_t(row) * n_samples;
+    int n_closer           = 0;
+    int n_others           = 0;
+    for (int s = 0; s < n_samples; s++) {
+      if (sample_ids[s] == i) continue;
+      n_others++;
+      if (float(dist_row[s]) < d) n_closer++;
+    }
+    int64_t estimate = 1 + int64_t(double(n - 1) * n_closer / max(n_others, 1) + 0.5);
+    r                = max(int64_t(rank_k) + 1, estimate);
+  }
+  int64_t tmp = r - n_neighbors;
+  if (tmp > 0) raft::myAtomicAdd<double>(rank, double(tmp));
+}
+
+/**
+ * @brief Compute the trustworthiness score with the neighbor sets of an ANN index
+ *
+ * Both spaces are indexed once; then, per batch of points, their `n_neighbors + 1` embedded
+ * neighbors and their `rank_k + 1` original neighbors are searched and the ranks of the embedded
+ * neighbors are read off the original ones (estimated from a `n_rank_samples` sample of the points
+ * beyond `rank_k`). The memory beyond the indices is bounded by the batch size, independently of
+ * `n`.
+ *
+ * @param h Raft handle
+ * @param X[in]: Data in original dimension
+ * @param X_embedded[in]: Data in target dimension (embedding)
+ * @param n: Number of samples
+ * @param m: Number of features in high/original dimension
+ * @param d: Number of features in low/embedded dimension
+ * @param n_neighbors Number of neighbors considered by trustworthiness score
+ * @param params the ANN and the batching parameters
+ * @return Trustworthiness score
+ */
+template <typename math_t>
+double trustworthiness_score_approx(const raft::resources& h,
+                                    const math_t* X,
+                                    const math_t* X_embedded,
+                                    int n,
+                                    int m,
+                                    int d,
+                                    int n_neighbors,
+                                    const trustworthiness_approx_params& params)
+{
+  cudaStream_t stream = resource::get_cuda_stream(h);
+  RAFT_EXPECTS(n_neighbors > 0 && n_neighbors < n, "n_neighbors must be in [1, n)");
+  RAFT_EXPECTS(params.batch_size > 0, "batch_size must be positive");
+
+  const int rank_k    = std::min(params.rank_k > 0 ? params.rank_k : 4 * n_neighbors, n - 1);
+  const int n_samples = std::max(1, std::min(params.n_rank_samples, n));
+  RAFT_EXPECTS(rank_k >= n_neighbors, "rank_k must not be smaller than n_neighbors");
+
+  trustworthiness_ann_index<math_t> emb_index(h, params, X_embedded, n, d);
+  trustworthiness_ann_index<math_t> orig_index(h, params, X, n, m);
+
+  // a sample of the points spread evenly over the dataset
+  std::vector<int> h_sample_ids(n_samples);
+  for (int s = 0; s < n_samples; s++) {
+    h_sample_ids[s] = int(int64_t(s) * n / n_samples);
+  }
+  rmm::device_uvector<int> sample_ids(n_samples, stream);
+  rmm::device_uvector<math_t> samples(size_t(n_samples) * m, stream);
+  raft::update_device(sample_ids.data(), h_sample_ids.data(), n_samples, stream);
+  raft::matrix::gather(X, m, n, sample_ids.data(), n_samples, samples.data(), stream);
+
+  const int batch_size = std::min(params.batch_size, n);
+  rmm::device_uvector<int64_t> emb_ind(size_t(batch_size) * (n_neighbors + 1), stream);
+  rmm::device_uvector<float> emb_dist(size_t(batch_size) * (n_neighbors + 1), stream);
+  rmm::device_uvector<int64_t> orig_ind(size_t(batch_size) * (rank_k + 1), stream);
+  rmm::device_uvector<float> orig_dist(size_t(batch_size) * (rank_k + 1), stream);
+  rmm::device_uvector<math_t> sample_dist(size_t(batch_size) * n_samples, stream);
+
+  rmm::device_scalar<double> t_dbuf(stream);
+  RAFT_CUDA_TRY(cudaMemsetAsync(t_dbuf.data(), 0, sizeof(double), stream));
+
+  for (int first_row = 0; first_row < n; first_row += batch_size) {
+    int cur_batch_size = std::min(batch_size, n - first_row);
+
+    emb_index.search(h,
+                     X_embedded + int64_t(first_row) * d,
+                     cur_batch_size,
+                     n_neighbors + 1,
+                     emb_ind.data(),
+                     emb_dist.data());
+    orig_index.search(h,
+                      X + int64_t(first_row) * m,
+                      cur_batch_size,
+                      rank_k + 1,
+                      orig_ind.data(),
+                      orig_dist.data());
+    raft::distance::pairwise_distance(h,
+                                      X + int64_t(first_row) * m,
+                                      samples.data(),
+                                      sample_dist.data(),
+                                      cur_batch_size,
+                                      n_samples,
+                                      m,
+                                      raft::distance::DistanceType::L2Expanded);
+
+    int64_t work  = int64_t(cur_batch_size) * (n_neighbors + 1);
+    auto n_blocks = raft::ceildiv<int64_t>(work, N_THREADS);
+    approx_rank_kernel<<<n_blocks, N_THREADS, 0, stream>>>(t_dbuf.data(),
+                                                           emb_ind.data(),
+                                                           orig_ind.data(),
+                                                           X,
+                                                           sample_ids.data(),
+                                                           sample_dist.data(),
+                                                           first_row,
+                                                           cur_batch_size,
+                                                           n,
+                                                           m,
+                                                           n_neighbors,
+                                                           rank_k,
+                                                           n_samples);
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+  }
+
+  double t    = t_dbuf.value(stream);
+  double norm = double(n) * n_neighbors * ((2.0 * n) - (3.0 * n_neighbors) - 1.0);
+  return 1.0 - (2.0 / norm) * t;
+}
+
+}  // namespace detail
+}  // namespace stats
+}  // namespace raft
@@ -0,0 +1,244 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resource/comms.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/linalg/eltwise.cuh>
+#include <raft/stats/detail/moments.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+
+namespace raft::stats {
+
+/**
+ * @defgroup stats_moments Streaming Moments
+ * @{
+ */
+
+/**
+ * @brief Accumulator of the mean, the variance and optionally the covariance of the columns of
+ * a dataset seen one block of rows at a time.
+ *
+ * Every block is read once (see `update`) and merged into the accumulated moments with the
+ * pairwise formulas of Chan et al., which stay accurate however large the dataset and however far
+ * from the origin the data is. The moments of different accumulators, e.g. of the partitions of
+ * a dataset, are merged with `merge` on one device or with `allreduce` across the ranks of the
+ * communicator of the resources.
+ *
+ * @code{.cpp}
+ *   #include <raft/stats/moments.cuh>
+ *
+ *   raft::stats::moments<float> acc(handle, n_cols, true);
+ *   for (auto& batch : batches) {
+ *     acc.update(handle, batch);  // [n_batch_rows, n_cols] device view
+ *   }
+ *   acc.allreduce(handle);        // optional: the moments of all the ranks
+ *   acc.mean(handle, mean.view());
+ *   acc.cov(handle, cov.view(), true);
+ * @endcode
+ *
+ * @tparam value_t the data type
+ * @tparam idx_t integer type used for addressing
+ */
+template <typename value_t, typename idx_t = int64_t>
+class moments {
+ public:
+  /**
+   * @param[in] handle the raft handle
+   * @param[in] n_cols the number of columns of the data
+   * @param[in] with_covariance whether to accumulate the covariance matrix too
+   * ([n_cols, n_cols] of device memory)
+   */
+  moments(raft::resources const& handle, idx_t n_cols, bool with_covariance = false)
+    : n_cols_(n_cols),
+      mean_(raft::make_device_vector<value_t, idx_t>(handle, n_cols)),
+      m2_(raft::make_device_vector<value_t, idx_t>(handle, n_cols)),
+      comoment_(raft::make_device_vector<value_t, int64_t>(
+        handle, with_covariance ? int64_t(n_cols) * int64_t(n_cols) : 0))
+  {
+    auto stream = resource::get_cuda_stream(handle);
+    RAFT_CUDA_TRY(cudaMemsetAsync(mean_.data_handle(), 0, mean_.size() * sizeof(value_t), stream));
+    RAFT_CUDA_TRY(cudaMemsetAsync(m2_.data_handle(), 0, m2_.size() * sizeof(value_t), stream));
+    RAFT_CUDA_TRY(
+      cudaMemsetAsync(comoment_.data_handle(), 0, comoment_.size() * sizeof(value_t), stream));
+  }
+
+  /** The number of the accumulated rows. */
+  [[nodiscard]] auto n_rows() const noexcept -> int64_t { return n_rows_; }
+  /** The number of columns. */
+  [[nodiscard]] auto n_cols() const noexcept -> idx_t { return n_cols_; }
+  /** Whether the covariance is accumulated. */
+  [[nodiscard]] auto has_covariance() const noexcept -> bool { return comoment_.size() > 0; }
+
+  /**
+   * @brief Accumulate a block of rows.
+   *
+   * The block is not modified. If the covariance is accumulated, this needs a temporary copy of
+   * the block.
+   *
+   * @tparam layout_t layout of the block (row_major or col_major)
+   * @param[in] handle the raft handle
+   * @param[in] batch the block of rows [n_batch_rows, n_cols]
+   */
+  template <typename layout_t>
+  void update(raft::resources const& handle,
+              raft::device_matrix_view<const value_t, idx_t, layout_t> batch)
+  {
+    static_assert(
+      std::is_same_v<layout_t, raft::row_major> || std::is_same_v<layout_t, raft::col_major>,
+      "Data layout not supported");
+    RAFT_EXPECTS(batch.extent(1) == n_cols_, "Size mismatch between batch and moments");
+    RAFT_EXPECTS(batch.is_exhaustive(), "batch must be contiguous");
+    detail::update_moments(handle,
+                           mean_.data_handle(),
+                           m2_.data_handle(),
+                           comoment_ptr(),
+                           n_rows_,
+                           batch.data_handle(),
+                           n_cols_,
+                           batch.extent(0),
+                           std::is_same_v<layout_t, raft::row_major>);
+    n_rows_ += batch.extent(0);
+  }
+
+  /**
+   * @brief Merge the moments of another accumulator (e.g. of another partition of the data).
+   *
+   * @param[in] handle the raft handle
+   * @param[in] other the accumulator to merge; unchanged. If this accumulates the covariance, so
+   * must `other`.
+   */
+  void merge(raft::resources const& handle, const moments& other)
+  {
+    RAFT_EXPECTS(other.n_cols_ == n_cols_, "Size mismatch between the moments");
+    RAFT_EXPECTS(!has_covariance() || other.has_covariance(),
+                 "The other moments do not accumulate the covariance");
+    detail::merge_moments(mean_.data_handle(),
+                          m2_.data_handle(),
+                          comoment_ptr(),
+                          n_rows_,
+                          other.mean_.data_handle(),
+                          other.m2_.data_handle(),
+                          has_covariance() ? other.comoment_.data_handle() : nullptr,
+                          other.n_rows_,
+                          n_cols_,
+                          resource::get_cuda_stream(handle));
+    n_rows_ += other.n_rows_;
+  }
+
+  /**
+   * @brief Merge the moments of all the ranks of the communicator of the resources, in place on
+   * every rank.
+   *
+   * This is a collective call: every rank accumulates the same columns and the covariance on all
+   * or none of them. It costs two allreduce collectives of `n_cols` (or `n_cols * n_cols`, with
+   * the covariance) values and synchronizes the stream.
+   *
+   * @param[in] handle the raft handle, with an initialized communicator
+   */
+  void allreduce(raft::resources const& handle)
+  {
+    n_rows_ = detail::allreduce_moments(resource::get_comms(handle),
+                                        mean_.data_handle(),
+                                        m2_.data_handle(),
+                                        comoment_ptr(),
+                                        n_rows_,
+                                        n_cols_,
+                                        resource::get_cuda_stream(handle));
+  }
+
+  /**
+   * @brief The means of the columns.
+   *
+   * @param[in] handle the raft handle
+   * @param[out] mean the means [n_cols]
+   */
+  void mean(raft::resources const& handle, raft::device_vector_view<value_t, idx_t> mean) const
+  {
+    RAFT_EXPECTS(mean.extent(0) == n_cols_, "Size mismatch between mean and moments");
+    raft::copy(mean.data_handle(), mean_.data_handle(), n_cols_, resource::get_cuda_stream(handle));
+  }
+
+  /**
+   * @brief The variances of the columns.
+   *
+   * @param[in] handle the raft handle
+   * @param[out] var the variances [n_cols]
+   * @param[in] sample whether to evaluate sample variance or not. In other words, whether to
+   * normalize the variance using N-1 or N, for true or false respectively.
+   */
+  void var(raft::resources const& handle,
+           raft::device_vector_view<value_t, idx_t> var,
+           bool sample) const
+  {
+    RAFT_EXPECTS(var.extent(0) == n_cols_, "Size mismatch between var and moments");
+    raft::linalg::scalarMultiply(var.data_handle(),
+                                 m2_.data_handle(),
+                                 normalization(sample),
+                                 n_cols_,
+                                 resource::get_cuda_stream(handle));
+  }
+
+  /**
+   * @brief The covariance matrix of the columns (symmetric, so of either layout).
+   *
+   * @tparam layout_t layout of the output matrix
+   * @param[in] handle the raft handle
+   * @param[out] cov the covariance matrix [n_cols, n_cols]
+   * @param[in] sample whether to evaluate sample covariance or not. In other words, whether to
+   * normalize the output using N-1 or N, for true or false, respectively
+   */
+  template <typename layout_t>
+  void cov(raft::resources const& handle,
+           raft::device_matrix_view<value_t, idx_t, layout_t> cov,
+           bool sample) const
+  {
+    RAFT_EXPECTS(has_covariance(), "The moments do not accumulate the covariance");
+    RAFT_EXPECTS(cov.extent(0) == n_cols_ && cov.extent(1) == n_cols_,
+                 "Size mismatch between cov and moments");
+    RAFT_EXPECTS(cov.is_exhaustive(), "cov must be contiguous");
+    raft::linalg::scalarMultiply(cov.data_handle(),
+                                 comoment_.data_handle(),
+                                 normalization(sample),
+                                 comoment_.size(),
+                                 resource::get_cuda_stream(handle));
+  }
+
+ private:
+  idx_t n_cols_;
+  int64_t n_rows_ = 0;
+  raft::device_vector<value_t, idx_t> mean_;
+  raft::device_vector<value_t, idx_t> m2_;
+  raft::device_vector<value_t, int64_t> comoment_;
+
+  auto comoment_ptr() -> value_t* { return has_covariance() ? comoment_.data_handle() : nullptr; }
+
+  auto normalization(bool sample) const -> value_t
+  {
+    return value_t(1.0 / std::max<double>(1.0, sample ? double(n_rows_ - 1) : double(n_rows_)));
+  }
+};
+
+/** @} */  // end group stats_moments
+
+}  // namespace raft::stats
@@ -22,6 +22,7 @@
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/stats/detail/batched/silhouette_score.cuh>
 #include <raft/stats/detail/silhouette_score.cuh>
+#include <raft/stats/detail/silhouette_score_fused.cuh>
 
 namespace raft {
 namespace stats {
@@ -55,6 +56,10 @@ DataT silhouette_score(
   cudaStream_t stream,
   raft::distance::DistanceType metric = raft::distance::DistanceType::L2Unexpanded)
 {
+  if (detail::silhouette_fused_supported(metric)) {
+    return detail::silhouette_score_fused(
+      handle, X_in, nRows, nCols, labels, nLabels, silhouette_scorePerSample, metric);
+  }
   return detail::silhouette_score(
     handle, X_in, nRows, nCols, labels, nLabels, silhouette_scorePerSample, stream, metric);
 }
@@ -114,6 +119,16 @@ value_t silhouette_score(
     RAFT_EXPECTS(silhouette_score_per_sample.value().extent(0) == X_in.extent(0),
                  "Size mismatch between silhouette_score_per_sample and data");
   }
+  if (detail::silhouette_fused_supported(metric)) {
+    return detail::silhouette_score_fused(handle,
+                                          X_in.data_handle(),
+                                          int(X_in.extent(0)),
+                                          int(X_in.extent(1)),
+                                          labels.data_handle(),
+                                          int(n_unique_labels),
+                                          silhouette_score_per_sample_ptr,
+                                          metric);
+  }
   return detail::silhouette_score(handle,
                                   X_in.data_handle(),
                                   X_in.extent(0),
@@ -177,6 +192,55 @@ value_t silhouette_score_batched(
                                            metric);
 }
 
+/**
+ * @brief sampled estimator of the average silhouette score: the mean of the exact silhouette
+ * scores of `n_samples` data samples drawn uniformly without replacement
+ *
+ * This costs `n_samples * n_rows` distances instead of `n_rows * n_rows`, and the distances are
+ * reduced per cluster as they are computed, without storing any of them. The standard error of the
+ * estimate decreases as `1 / sqrt(n_samples)`.
+ *
+ * @tparam value_t: type of the data samples
+ * @tparam label_t: type of the labels
+ * @tparam idx_t index type
+ * @param[in]  handle: raft handle for managing expensive resources
+ * @param[in]  X: input matrix Data in row-major format (nRows x nCols)
+ * @param[in]  labels: the pointer to the array containing labels for every data sample (length:
+ * nRows)
+ * @param[in]  n_unique_labels: number of unique labels in the labels array
+ * @param[in]  n_samples: number of sampled samples; the exact score if not less than nRows
+ * @param[in]  seed: seed of the sample
+ * @param[in]  metric: the distance metric; one of L2Expanded, L2SqrtExpanded, L2Unexpanded,
+ * L2SqrtUnexpanded and L1
+ * @return: The estimate of the silhouette score.
+ */
+template <typename value_t, typename label_t, typename idx_t>
+value_t silhouette_score_sampled(
+  raft::resources const& handle,
+  raft::device_matrix_view<const value_t, idx_t, raft::row_major> X,
+  raft::device_vector_view<const label_t, idx_t> labels,
+  idx_t n_unique_labels,
+  idx_t n_samples,
+  uint64_t seed                       = 0,
+  raft::distance::DistanceType metric = raft::distance::DistanceType::L2Unexpanded)
+{
+  RAFT_EXPECTS(labels.extent(0) == X.extent(0), "Size mismatch between labels and data");
+  RAFT_EXPECTS(n_samples > 0, "n_samples must be positive");
+  RAFT_EXPECTS(detail::silhouette_fused_supported(metric),
+               "silhouette_score_sampled: unsupported distance metric");
+  return detail::silhouette_score_fused(handle,
+                                        X.data_handle(),
+                                        int(X.extent(0)),
+                                        int(X.extent(1)),
+                                        labels.data_handle(),
+                                        int(n_unique_labels),
+                                        static_cast<value_t*>(nullptr),
+                                        metric,
+                                        0,
+                                        int(n_samples),
+                                        seed);
+}
+
 /** @} */  // end group stats_silhouette_score
 
 /**
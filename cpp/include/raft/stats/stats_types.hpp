@@ -56,7 +56,19 @@ enum HistType {
   /** builds a hashmap of active bins in shared mem */
   HistTypeSmemHash,
   /** decide at runtime the best algo for the given inputs */
-  HistTypeAuto
+  HistTypeAuto,
+  /**
+   * like `HistTypeSmemMatchAny`, but every warp of a block updates its own copy of the bins in the
+   * shared memory (as many copies as fit), which spreads the atomics on the very frequent bins.
+   * @note This requires the bins to fit in the shared memory, same as `HistTypeSmem`.
+   */
+  HistTypeSmemPerWarp,
+  /**
+   * decide at runtime the best algo from a sample of the input: its bin cardinality, the frequency
+   * of its most frequent bin and the repetitions of the bins within a warp. Sampling costs a small
+   * kernel and a synchronization of the stream.
+   */
+  HistTypeAutoProfiled
 };
 
 /** @} */
@@ -73,4 +85,24 @@ enum IC_Type { AIC, AICc, BIC };
 
 /** @} */
 
+/**
+ * @ingroup stats_clustering_metrics
+ * @{
+ */
+
+/**
+ * @brief The clustering metrics computed together by `clustering_metrics`
+ */
+struct clustering_metrics_result {
+  double adjusted_rand_index = 0;
+  double rand_index          = 0;
+  /** The mutual information, in nats. */
+  double mutual_info  = 0;
+  double homogeneity  = 0;
+  double completeness = 0;
+  double v_measure    = 0;
+};
+
+/** @} */
+
 };  // end namespace raft::stats
@@ -21,6 +21,8 @@
 #include <raft/core/device_mdspan.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/stats/detail/trustworthiness_score.cuh>
+#include <raft/stats/detail/trustworthiness_score_approx.cuh>
+#include <raft/stats/trustworthiness_types.hpp>
 
 namespace raft {
 namespace stats {
@@ -93,6 +95,53 @@ double trustworthiness_score(
     batch_size);
 }
 
+/**
+ * @brief Compute the trustworthiness score (in the euclidean space) approximately, with the
+ * neighbor sets given by an ANN index, for the datasets too large for `trustworthiness_score`.
+ *
+ * Instead of ranking all the points of the original space for every point, this ranks the
+ * embedded neighbors of a point among its `params.rank_k` nearest neighbors in the original space;
+ * the ranks beyond are estimated from a sample of the original space. Both spaces are indexed with
+ * `params.algo` (IVF-Flat or CAGRA) and the points are processed in batches of `params.batch_size`,
+ * so that the memory beyond the indices is independent of the number of points.
+ *
+ * @code{.cpp}
+ *   raft::stats::trustworthiness_approx_params params;
+ *   params.algo = raft::stats::trustworthiness_ann::CAGRA;
+ *   double t    = raft::stats::trustworthiness_score_approx(handle, X, X_embedded, 15, params);
+ * @endcode
+ *
+ * @tparam value_t the data type
+ * @tparam idx_t Integer type used to for addressing
+ * @param[in] handle the raft handle
+ * @param[in] X: Data in original dimension
+ * @param[in] X_embedded: Data in target dimension (embedding)
+ * @param[in] n_neighbors Number of neighbors considered by trustworthiness score
+ * @param[in] params the ANN, ranking and batching parameters
+ * @return Trustworthiness score
+ */
+template <typename value_t, typename idx_t>
+double trustworthiness_score_approx(
+  raft::resources const& handle,
+  raft::device_matrix_view<const value_t, idx_t, raft::row_major> X,
+  raft::device_matrix_view<const value_t, idx_t, raft::row_major> X_embedded,
+  int n_neighbors,
+  const trustworthiness_approx_params& params = trustworthiness_approx_params{})
+{
+  RAFT_EXPECTS(X.extent(0) == X_embedded.extent(0), "Size mismatch between X and X_embedded");
+  RAFT_EXPECTS(std::is_integral_v<idx_t> && X.extent(0) <= std::numeric_limits<int>::max(),
+               "Index type not supported");
+
+  return detail::trustworthiness_score_approx<value_t>(handle,
+                                                       X.data_handle(),
+                                                       X_embedded.data_handle(),
+                                                       X.extent(0),
+                                                       X.extent(1),
+                                                       X_embedded.extent(1),
+                                                       n_neighbors,
+                                                       params);
+}
+
 /** @} */  // end group stats_trustworthiness
 
 }  // namespace stats
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/neighbors/cagra_types.hpp>
+#include <raft/neighbors/ivf_flat_types.hpp>
+
+#include <cstdint>
+
+namespace raft::stats {
+
+/**
+ * @ingroup stats_trustworthiness
+ * @{
+ */
+
+/** The ANN algorithm finding the neighbor sets of `trustworthiness_score_approx`. */
+enum class trustworthiness_ann {
+  IVF_FLAT = 0,
+  CAGRA    = 1,
+};
+
+/** The parameters of `trustworthiness_score_approx`. */
+struct trustworthiness_approx_params {
+  /** The ANN algorithm searching both the original and the embedded space. */
+  trustworthiness_ann algo = trustworthiness_ann::IVF_FLAT;
+  /**
+   * The number of the nearest neighbors of a point searched in the original space, which gives the
+   * ranks of its embedded neighbors up to this value (0 for `4 * n_neighbors`). The embedded
+   * neighbors farther in the original space get a rank estimated from `n_rank_samples` points.
+   */
+  int rank_k = 0;
+  /** The number of the points of the original space sampled to estimate the ranks over `rank_k`. */
+  int n_rank_samples = 1024;
+  /** The number of the points whose neighbors are searched and ranked at a time. */
+  int batch_size = 16384;
+  /** The IVF-Flat index parameters (the metric is set to L2Expanded, `n_lists` is clamped). */
+  raft::neighbors::ivf_flat::index_params ivf_flat_index_params;
+  raft::neighbors::ivf_flat::search_params ivf_flat_search_params;
+  /** The CAGRA index parameters (the metric is set to L2Expanded). */
+  raft::neighbors::experimental::cagra::index_params cagra_index_params;
+  /** The CAGRA search parameters (`itopk_size` is raised to the number of neighbors searched). */
+  raft::neighbors::experimental::cagra::search_params cagra_search_params;
+};
+
+/** @} */
+
+}  // namespace raft::stats
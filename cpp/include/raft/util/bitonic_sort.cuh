@@ -246,4 +246,156 @@ class bitonic {
   }
 };
 
+/**
+ * Warp-wide bitonic merge and sort of the data in the blocked layout.
+ *
+ * The same as `bitonic`, except that the data is contiguous per thread rather than strided:
+ * after `bitonic_blocked<Size>(ascending=true).sort(arr)`, `arr[i]` in the lane `j` of a subwarp
+ * holds the element of rank `j * Size + i` of the subwarp. This is the layout to use when the
+ * threads read/write their elements to contiguous locations (e.g. the CAGRA top-k buffers).
+ *
+ * Both layouts share one network: the compare-exchange of two elements of the same thread is a
+ * register swap, and of two lanes a shuffle; only the order of the strides differs (in the
+ * blocked layout, the cross-lane strides are the larger ones). Since the number of elements per
+ * thread is a power of two, the capacity of a warp is any power of two up to `Size * WarpSize`
+ * (e.g. 2048 for `Size = 64`).
+ *
+ * @tparam Size
+ *   number of elements processed in each thread;
+ *   i.e. the total data size is `Size * warp_width`.
+ *   Must be power-of-two.
+ */
+template <int Size = 1>
+class bitonic_blocked {
+  static_assert(isPo2(Size));
+
+ public:
+  /**
+   * Initialize bitonic sort config.
+   *
+   * @param ascending
+   *   the resulting order (true: ascending, false: descending).
+   * @param warp_width
+   *   the number of threads participating in the warp-level primitives;
+   *   the total size of the sorted data is `Size * warp_width`.
+   *   Must be power-of-two, not larger than the WarpSize.
+   */
+  _RAFT_DEVICE _RAFT_FORCEINLINE explicit bitonic_blocked(bool ascending, int warp_width = WarpSize)
+    : ascending_(ascending), warp_width_(warp_width)
+  {
+  }
+
+  bitonic_blocked(bitonic_blocked const&)                    = delete;
+  bitonic_blocked(bitonic_blocked&&)                         = delete;
+  auto operator=(bitonic_blocked const&) -> bitonic_blocked& = delete;
+  auto operator=(bitonic_blocked&&) -> bitonic_blocked&      = delete;
+
+  /**
+   * Sort any bitonic sequence, or, in other words, merge two halves of the input data assuming
+   * they're already sorted in opposite orders. See `bitonic::merge`.
+   *
+   * @param keys
+   *   is a device pointer to a contiguous array of keys, unique per thread; must be at least `Size`
+   *   elements long.
+   * @param payloads
+   *   are zero or more associated arrays of the same size as keys, which are sorted together with
+   *   the keys; must be at least `Size` elements long.
+   */
+  template <typename KeyT, typename... PayloadTs>
+  _RAFT_DEVICE _RAFT_FORCEINLINE void merge(KeyT* __restrict__ keys,
+                                            PayloadTs* __restrict__... payloads) const
+  {
+    return merge_impl(ascending_, warp_width_, keys, payloads...);
+  }
+
+  /**
+   * Sort the data. See `bitonic::sort`.
+   *
+   * @param keys
+   *   is a device pointer to a contiguous array of keys, unique per thread; must be at least `Size`
+   *   elements long.
+   * @param payloads
+   *   are zero or more associated arrays of the same size as keys, which are sorted together with
+   *   the keys; must be at least `Size` elements long.
+   */
+  template <typename KeyT, typename... PayloadTs>
+  _RAFT_DEVICE _RAFT_FORCEINLINE void sort(KeyT* __restrict__ keys,
+                                           PayloadTs* __restrict__... payloads) const
+  {
+    const int lane = laneId();
+    if (warp_width_ == 1) { return sort_in_thread(ascending_, keys, payloads...); }
+    // the runs of the pairs of lanes are sorted in opposite orders, then merged into runs of
+    // twice as many lanes, and so on
+    sort_in_thread(lane & 1, keys, payloads...);
+    for (int width = 2; width < warp_width_; width <<= 1) {
+      merge_impl(lane & width, width, keys, payloads...);
+    }
+    merge_impl(ascending_, warp_width_, keys, payloads...);
+  }
+
+ private:
+  const int warp_width_;
+  const bool ascending_;
+
+  template <typename KeyT, typename... PayloadTs>
+  static _RAFT_DEVICE _RAFT_FORCEINLINE void compare_exchange(
+    bool ascending, int i, int j, KeyT* __restrict__ keys, PayloadTs* __restrict__... payloads)
+  {
+    if (ascending ? keys[i] > keys[j] : keys[i] < keys[j]) {
+      swap(keys[i], keys[j]);
+      (swap(payloads[i], payloads[j]), ...);
+    }
+  }
+
+  /** Sort the elements of the thread; the order of the runs alternates for `Size > run > 1`. */
+  template <typename KeyT, typename... PayloadTs>
+  static _RAFT_DEVICE _RAFT_FORCEINLINE void sort_in_thread(bool ascending,
+                                                            KeyT* __restrict__ keys,
+                                                            PayloadTs* __restrict__... payloads)
+  {
+#pragma unroll
+    for (int run = 2; run <= Size; run <<= 1) {
+#pragma unroll
+      for (int stride = run >> 1; stride > 0; stride >>= 1) {
+#pragma unroll
+        for (int i = 0; i < Size; i++) {
+          const int j = i ^ stride;
+          if (j > i) { compare_exchange(((i & run) == 0) == ascending, i, j, keys, payloads...); }
+        }
+      }
+    }
+  }
+
+  template <typename KeyT, typename... PayloadTs>
+  static _RAFT_DEVICE _RAFT_FORCEINLINE void merge_impl(bool ascending,
+                                                        int warp_width,
+                                                        KeyT* __restrict__ keys,
+                                                        PayloadTs* __restrict__... payloads)
+  {
+    const int lane = laneId();
+    for (int stride = (warp_width >> 1); stride > 0; stride >>= 1) {
+      const bool is_second = lane & stride;
+#pragma unroll
+      for (int i = 0; i < Size; i++) {
+        KeyT& key            = keys[i];
+        const KeyT other     = shfl_xor(key, stride, warp_width);
+        const bool do_assign = (ascending != is_second) ? key > other : key < other;
+
+        conditional_assign(do_assign, key, other);
+        // NB: don't put shfl_xor in a conditional; it must be called by all threads in a warp.
+        (conditional_assign(do_assign, payloads[i], shfl_xor(payloads[i], stride, warp_width)),
+         ...);
+      }
+    }
+#pragma unroll
+    for (int stride = Size >> 1; stride > 0; stride >>= 1) {
+#pragma unroll
+      for (int i = 0; i < Size; i++) {
+        const int j = i ^ stride;
+        if (j > i) { compare_exchange(ascending, i, j, keys, payloads...); }
+      }
+    }
+  }
+};
+
 }  // namespace raft::util
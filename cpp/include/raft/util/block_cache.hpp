@@ -0,0 +1,285 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/error.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/util/cuda_rt_essentials.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+namespace raft::cache {
+
+/** The choice of the entry evicted from a full cache. */
+enum class replacement_policy {
+  /** The least recently used entry. */
+  LRU = 0,
+  /**
+   * The first entry not used since the clock hand passed it last (second chance); a cheaper
+   * approximation of LRU.
+   */
+  CLOCK = 1,
+};
+
+/** The counters of a cache, since its construction or the last `reset_stats()`. */
+struct cache_stats {
+  uint64_t hits      = 0;
+  uint64_t misses    = 0;
+  uint64_t evictions = 0;
+
+  /** The fraction of the lookups finding their key in the cache. */
+  [[nodiscard]] auto hit_rate() const noexcept -> double
+  {
+    const uint64_t n = hits + misses;
+    return n > 0 ? double(hits) / double(n) : 0.0;
+  }
+};
+
+/**
+ * @brief The host-side index of a cache of `capacity()` slots: which key occupies which slot, and
+ * which slot to evict on a miss.
+ *
+ * The slots themselves (e.g. device buffers) are managed by the user. The keys acquired since the
+ * last `begin_batch()` are never evicted, so that all the entries used by a batch of work stay
+ * resident together; a batch may acquire at most `capacity()` distinct keys.
+ *
+ * @tparam KeyT the type of the keys (e.g. a list label or a dataset row id)
+ */
+template <typename KeyT = uint32_t>
+class slot_map {
+ public:
+  /** The slot of a key not in the cache. */
+  static constexpr uint32_t kNoSlot = std::numeric_limits<uint32_t>::max();
+
+  /** The result of `acquire`. */
+  struct assignment {
+    /** The slot of the key. */
+    uint32_t slot;
+    /** Whether the key was already in the slot; otherwise the slot must be filled. */
+    bool hit;
+    /** Whether another key was evicted from the slot. */
+    bool evicted;
+    /** The evicted key (valid if `evicted`). */
+    KeyT evicted_key;
+  };
+
+  explicit slot_map(uint32_t capacity, replacement_policy policy = replacement_policy::LRU)
+    : policy_(policy),
+      key_of_(capacity),
+      occupied_(capacity, 0),
+      referenced_(capacity, 0),
+      epoch_of_(capacity, 0)
+  {
+    RAFT_EXPECTS(capacity > 0, "The cache must hold at least one entry");
+    slot_of_.reserve(capacity);
+    for (uint32_t slot = 0; slot < capacity; slot++) {
+      lru_pos_.push_back(lru_.insert(lru_.end(), slot));
+    }
+  }
+
+  /** The number of slots. */
+  [[nodiscard]] auto capacity() const noexcept -> uint32_t { return key_of_.size(); }
+  [[nodiscard]] auto policy() const noexcept -> replacement_policy { return policy_; }
+  /** The number of keys in the cache. */
+  [[nodiscard]] auto size() const noexcept -> uint32_t { return slot_of_.size(); }
+  [[nodiscard]] auto stats() const noexcept -> const cache_stats& { return stats_; }
+  void reset_stats() noexcept { stats_ = cache_stats{}; }
+
+  /** The slot of a key, or `kNoSlot` if it is not in the cache (not counted as a lookup). */
+  [[nodiscard]] auto slot_of(KeyT key) const -> uint32_t
+  {
+    auto it = slot_of_.find(key);
+    return it == slot_of_.end() ? kNoSlot : it->second;
+  }
+
+  /** Start a new batch: the keys acquired before may be evicted again. */
+  void begin_batch() noexcept { epoch_++; }
+
+  /**
+   * Look up a key, assigning it a slot on a miss (the slot of an evicted key, if the cache is
+   * full). The key is protected from eviction until the next `begin_batch()`.
+   */
+  auto acquire(KeyT key) -> assignment
+  {
+    auto it = slot_of_.find(key);
+    if (it != slot_of_.end()) {
+      stats_.hits++;
+      use(it->second);
+      return {it->second, true, false, KeyT{}};
+    }
+    stats_.misses++;
+    const uint32_t slot = victim();
+    assignment res{slot, false, occupied_[slot] != 0, key_of_[slot]};
+    if (res.evicted) {
+      stats_.evictions++;
+      slot_of_.erase(key_of_[slot]);
+    }
+    key_of_[slot]   = key;
+    occupied_[slot] = 1;
+    slot_of_.emplace(key, slot);
+    use(slot);
+    return res;
+  }
+
+ private:
+  replacement_policy policy_;
+  std::unordered_map<KeyT, uint32_t> slot_of_;
+  std::vector<KeyT> key_of_;
+  std::vector<uint8_t> occupied_;
+  std::vector<uint8_t> referenced_;  // CLOCK only
+  std::vector<uint64_t> epoch_of_;   // the batch which last used the slot
+  std::list<uint32_t> lru_;          // LRU only, most recently used first
+  std::vector<std::list<uint32_t>::iterator> lru_pos_;
+  uint32_t hand_  = 0;
+  uint64_t epoch_ = 1;
+  cache_stats stats_;
+
+  void use(uint32_t slot)
+  {
+    epoch_of_[slot] = epoch_;
+    if (policy_ == replacement_policy::LRU) {
+      lru_.splice(lru_.begin(), lru_, lru_pos_[slot]);
+    } else {
+      referenced_[slot] = 1;
+    }
+  }
+
+  [[nodiscard]] auto is_protected(uint32_t slot) const -> bool
+  {
+    return occupied_[slot] != 0 && epoch_of_[slot] == epoch_;
+  }
+
+  auto victim() -> uint32_t
+  {
+    if (policy_ == replacement_policy::LRU) {
+      // The empty slots and the least recently used ones are at the back.
+      for (auto it = lru_.rbegin(); it != lru_.rend(); ++it) {
+        if (!is_protected(*it)) { return *it; }
+      }
+    } else {
+      // Two sweeps clear all the reference bits, if there is any slot not protected.
+      for (uint32_t i = 0; i < 2 * capacity(); i++) {
+        const uint32_t slot = hand_;
+        hand_               = hand_ + 1 < capacity() ? hand_ + 1 : 0;
+        if (is_protected(slot)) { continue; }
+        if (occupied_[slot] == 0 || referenced_[slot] == 0) { return slot; }
+        referenced_[slot] = 0;
+      }
+    }
+    RAFT_FAIL("The batch uses more distinct keys than the cache holds (%u)", capacity());
+  }
+};
+
+/**
+ * @brief A device-resident cache of variable-size blocks of data, e.g. the inverted lists of an
+ * IVF index or the rows of a dataset kept in the host memory.
+ *
+ * Every slot holds a block of up to `block_capacity()` elements. A miss copies the block from its
+ * source (host or device memory) to the slot, in the stream of the handle; the blocks must be read
+ * in the same stream, so that a slot is not overwritten while it is still read.
+ *
+ * @code{.cpp}
+ *   raft::cache::block_cache<float> cache(res, 256, max_list_size, replacement_policy::CLOCK);
+ *   cache.begin_batch();
+ *   for (auto label : probed_lists) {
+ *     float* block = cache.fetch(res, label, host_lists[label], list_sizes[label]);
+ *     // ... launch the work reading `block` in the stream of res
+ *   }
+ *   RAFT_LOG_INFO("hit rate: %f", cache.stats().hit_rate());
+ * @endcode
+ *
+ * @tparam T the type of the elements of the blocks
+ * @tparam KeyT the type of the keys of the blocks
+ */
+template <typename T, typename KeyT = uint32_t>
+class block_cache {
+ public:
+  /**
+   * @param res raft resources
+   * @param capacity the number of blocks the cache holds
+   * @param block_capacity the maximum number of elements of a block
+   * @param policy the replacement policy
+   */
+  block_cache(raft::resources const& res,
+              uint32_t capacity,
+              size_t block_capacity,
+              replacement_policy policy = replacement_policy::LRU)
+    : map_(capacity, policy),
+      block_capacity_(block_capacity),
+      data_(make_device_vector<T, size_t>(res, size_t{capacity} * block_capacity))
+  {
+  }
+
+  /** The number of blocks the cache holds. */
+  [[nodiscard]] auto capacity() const noexcept -> uint32_t { return map_.capacity(); }
+  /** The maximum number of elements of a block. */
+  [[nodiscard]] auto block_capacity() const noexcept -> size_t { return block_capacity_; }
+  [[nodiscard]] auto stats() const noexcept -> const cache_stats& { return map_.stats(); }
+  void reset_stats() noexcept { map_.reset_stats(); }
+
+  /** @copydoc slot_map::begin_batch */
+  void begin_batch() noexcept { map_.begin_batch(); }
+
+  /** The cached block of a key, or nullptr if it is not in the cache (not counted as a lookup). */
+  [[nodiscard]] auto find(KeyT key) -> T*
+  {
+    const uint32_t slot = map_.slot_of(key);
+    return slot == slot_map<KeyT>::kNoSlot ? nullptr : block(slot);
+  }
+
+  /**
+   * The device copy of the block of a key, copied from `src` on a miss. The block stays in the
+   * cache at least until the next `begin_batch()`.
+   *
+   * @param res raft resources; the copy runs in its stream
+   * @param key the key of the block
+   * @param src the block (host or device memory), read on a miss only [size]
+   * @param size the number of elements of the block (at most `block_capacity()`)
+   */
+  auto fetch(raft::resources const& res, KeyT key, const T* src, size_t size) -> T*
+  {
+    RAFT_EXPECTS(size <= block_capacity_,
+                 "The block of %zu elements exceeds the block capacity (%zu)",
+                 size,
+                 block_capacity_);
+    const auto a = map_.acquire(key);
+    if (!a.hit && size > 0) {
+      RAFT_CUDA_TRY(cudaMemcpyAsync(block(a.slot),
+                                    src,
+                                    sizeof(T) * size,
+                                    cudaMemcpyDefault,
+                                    resource::get_cuda_stream(res)));
+    }
+    return block(a.slot);
+  }
+
+ private:
+  slot_map<KeyT> map_;
+  size_t block_capacity_;
+  device_vector<T, size_t> data_;
+
+  auto block(uint32_t slot) -> T* { return data_.data_handle() + slot * block_capacity_; }
+};
+
+}  // namespace raft::cache
@@ -23,10 +23,14 @@
  * Provides the overloads for arithmetic data types, where CUDA atomic operations are, `atomicAdd`,
  * `atomicMin`, `atomicMax`, and `atomicCAS`.
  * `atomicAnd`, `atomicOr`, `atomicXor` are also supported for integer data types.
+ * Also provides the warp aggregated `atomicAddWarp`, `atomicMinWarp`, `atomicMaxWarp`, and the
+ * lock-free key-value pair update `atomicMinKeyValue`.
  * Also provides `raft::genericAtomicOperation` which performs atomic operation with the given
  * binary operator.
  */
 
+#include <raft/util/cuda_dev_essentials.cuh>
+
 #include <cooperative_groups.h>
 #include <type_traits>
 
@@ -177,28 +181,37 @@ struct genericAtomicOperationImpl<T, Op, 4> {
   __forceinline__ __device__ T operator()(T* addr, T const& update_value, Op op)
   {
     using T_int = unsigned int;
-    T old_value = *addr;
-    T assumed{old_value};
-
-    if constexpr (std::is_same<T, float>{} && (std::is_same<Op, DeviceMin>{})) {
-      if (isnan(update_value)) { return old_value; }
+    // The native atomics, where available
+    constexpr bool is_native_int = std::is_same<T, int>{} || std::is_same<T, unsigned int>{};
+    if constexpr (std::is_same<Op, DeviceSum>{} && (is_native_int || std::is_same<T, float>{})) {
+      return ::atomicAdd(addr, update_value);
+    } else if constexpr (std::is_same<Op, DeviceMin>{} && is_native_int) {
+      return ::atomicMin(addr, update_value);
+    } else if constexpr (std::is_same<Op, DeviceMax>{} && is_native_int) {
+      return ::atomicMax(addr, update_value);
+    } else {
+      T old_value = *addr;
+      T assumed{old_value};
+
+      do {
+        assumed           = old_value;
+        const T new_value = op(old_value, update_value);
+
+        T_int ret = atomicCAS(reinterpret_cast<T_int*>(addr),
+                              type_reinterpret<T_int, T>(assumed),
+                              type_reinterpret<T_int, T>(new_value));
+        old_value = type_reinterpret<T, T_int>(ret);
+      } while (assumed != old_value);
+
+      return old_value;
     }
-
-    do {
-      assumed           = old_value;
-      const T new_value = op(old_value, update_value);
-
-      T_int ret = atomicCAS(reinterpret_cast<T_int*>(addr),
-                            type_reinterpret<T_int, T>(assumed),
-                            type_reinterpret<T_int, T>(new_value));
-      old_value = type_reinterpret<T, T_int>(ret);
-    } while (assumed != old_value);
-
-    return old_value;
   }
 };
 
 // 4 bytes fp32 atomic Max operation
+// The non-negative floats are ordered as their signed integer representations, the negative ones
+// in the reverse order of their unsigned integer representations. The sign bit (rather than the
+// comparison with zero) selects the order, so that -0.0 is handled as a negative number.
 template <>
 struct genericAtomicOperationImpl<float, DeviceMax, 4> {
   using T = float;
@@ -206,7 +219,7 @@ struct genericAtomicOperationImpl<float, DeviceMax, 4> {
   {
     if (isnan(update_value)) { return *addr; }
 
-    T old = (update_value >= 0)
+    T old = !signbit(update_value)
               ? __int_as_float(atomicMax((int*)addr, __float_as_int(update_value)))
               : __uint_as_float(atomicMin((unsigned int*)addr, __float_as_uint(update_value)));
 
@@ -214,6 +227,22 @@ struct genericAtomicOperationImpl<float, DeviceMax, 4> {
   }
 };
 
+// 4 bytes fp32 atomic Min operation
+template <>
+struct genericAtomicOperationImpl<float, DeviceMin, 4> {
+  using T = float;
+  __forceinline__ __device__ T operator()(T* addr, T const& update_value, DeviceMin op)
+  {
+    if (isnan(update_value)) { return *addr; }
+
+    T old = !signbit(update_value)
+              ? __int_as_float(atomicMin((int*)addr, __float_as_int(update_value)))
+              : __uint_as_float(atomicMax((unsigned int*)addr, __float_as_uint(update_value)));
+
+    return old;
+  }
+};
+
 // 8 bytes atomic operation
 template <typename T, typename Op>
 struct genericAtomicOperationImpl<T, Op, 8> {
@@ -240,6 +269,46 @@ struct genericAtomicOperationImpl<T, Op, 8> {
   }
 };
 
+// 8 bytes fp64 atomic Max operation (see the fp32 one)
+template <>
+struct genericAtomicOperationImpl<double, DeviceMax, 8> {
+  using T = double;
+  __forceinline__ __device__ T operator()(T* addr, T const& update_value, DeviceMax op)
+  {
+    using T_int  = long long int;
+    using T_uint = unsigned long long int;
+    if (isnan(update_value)) { return *addr; }
+
+    T old = !signbit(update_value)
+              ? type_reinterpret<T, T_int>(atomicMax(reinterpret_cast<T_int*>(addr),
+                                                     type_reinterpret<T_int, T>(update_value)))
+              : type_reinterpret<T, T_uint>(atomicMin(reinterpret_cast<T_uint*>(addr),
+                                                      type_reinterpret<T_uint, T>(update_value)));
+
+    return old;
+  }
+};
+
+// 8 bytes fp64 atomic Min operation (see the fp32 one)
+template <>
+struct genericAtomicOperationImpl<double, DeviceMin, 8> {
+  using T = double;
+  __forceinline__ __device__ T operator()(T* addr, T const& update_value, DeviceMin op)
+  {
+    using T_int  = long long int;
+    using T_uint = unsigned long long int;
+    if (isnan(update_value)) { return *addr; }
+
+    T old = !signbit(update_value)
+              ? type_reinterpret<T, T_int>(atomicMin(reinterpret_cast<T_int*>(addr),
+                                                     type_reinterpret<T_int, T>(update_value)))
+              : type_reinterpret<T, T_uint>(atomicMax(reinterpret_cast<T_uint*>(addr),
+                                                      type_reinterpret<T_uint, T>(update_value)));
+
+    return old;
+  }
+};
+
 // -------------------------------------------------------------------------------------------------
 // specialized functions for operators
 // `atomicAdd` supports int, unsigned int, unsigned long long int, float, double (long long int is
@@ -353,6 +422,34 @@ struct genericAtomicOperationImpl<T, DeviceXor, 8> {
   }
 };
 
+// -------------------------------------------------------------------------------------------------
+// the implementation of `genericAtomicOperationWarp`
+
+/**
+ * Reduce `val` over the lanes `peers` (including the calling lane) of the active lanes `mask` with
+ * `op`, in a tree of log2(popc(peers)) steps. The result is valid in the lowest lane of `peers`.
+ *
+ * Adapted from:
+ * https://developer.nvidia.com/blog/voting-and-shuffling-optimize-atomic-operations/
+ */
+template <typename T, typename BinaryOp>
+__forceinline__ __device__ T reducePeers(unsigned mask, unsigned peers, T val, BinaryOp op)
+{
+  const int lane = raft::laneId();
+  // the position of the lane among its peers
+  int rel_pos = __popc(peers & ((1u << lane) - 1u));
+  // the peers above the lane, which are yet to be reduced
+  peers &= 0xfffffffeu << lane;
+  while (__any_sync(mask, peers)) {
+    const int next = __ffs(peers);
+    const T other  = __shfl_sync(mask, val, next - 1);
+    if (next != 0 && (rel_pos & 1) == 0) { val = op(val, other); }
+    peers &= ~__ballot_sync(mask, rel_pos & 1);
+    rel_pos >>= 1;
+  }
+  return val;
+}
+
 // -------------------------------------------------------------------------------------------------
 // the implementation of `typesAtomicCASImpl`
 
@@ -488,6 +585,35 @@ __forceinline__ __device__ bool genericAtomicOperation(bool* address,
   return T(fun(address, update_value, op));
 }
 
+/**
+ * @brief compute atomic binary operation, aggregated over a warp
+ *
+ * The active threads of a warp updating the same address combine their values with `op` first;
+ * then, one of them updates the memory with `genericAtomicOperation`. This cuts the atomic traffic
+ * on the contended addresses (e.g. the sizes of a few clusters) by up to a factor of the warp
+ * size. The old value is not returned, because only one of the threads has it.
+ *
+ * Before Volta (no `__match_any_sync`), every thread updates the memory on its own.
+ *
+ * @param[in] address The address of old value in global or shared memory
+ * @param[in] update_value The value to be computed
+ * @param[in] op  The binary operator used for compute; associative and commutative
+ */
+template <typename T, typename BinaryOp>
+__forceinline__ __device__ void genericAtomicOperationWarp(T* address, T update_value, BinaryOp op)
+{
+#if __CUDA_ARCH__ >= 700
+  const unsigned mask  = __activemask();
+  const unsigned peers = __match_any_sync(mask, reinterpret_cast<unsigned long long>(address));
+  update_value         = raft::device_atomics::detail::reducePeers(mask, peers, update_value, op);
+  if (raft::laneId() == __ffs(peers) - 1) {
+    raft::genericAtomicOperation(address, update_value, op);
+  }
+#else
+  raft::genericAtomicOperation(address, update_value, op);
+#endif  // __CUDA_ARCH__
+}
+
 }  // namespace raft
 
 /**
@@ -666,3 +792,64 @@ __device__ T atomicIncWarp(T* ctr)
   if (g.thread_rank() == 0) { warp_res = atomicAdd(ctr, static_cast<T>(g.size())); }
   return g.shfl(warp_res, 0) + g.thread_rank();
 }
+
+/**
+ * @brief Warp aggregated overloads of `atomicAdd`, `atomicMin`, `atomicMax`
+ *
+ * See `raft::genericAtomicOperationWarp`: the values of the active threads of a warp updating the
+ * same address are combined before a single atomic update, and no old value is returned.
+ *
+ * @param[in] address The address of old value in global or shared memory
+ * @param[in] val The value to be computed
+ */
+template <typename T>
+__forceinline__ __device__ void atomicAddWarp(T* address, T val)
+{
+  raft::genericAtomicOperationWarp(address, val, raft::device_atomics::detail::DeviceSum{});
+}
+
+/** @copydoc atomicAddWarp */
+template <typename T>
+__forceinline__ __device__ void atomicMinWarp(T* address, T val)
+{
+  raft::genericAtomicOperationWarp(address, val, raft::device_atomics::detail::DeviceMin{});
+}
+
+/** @copydoc atomicAddWarp */
+template <typename T>
+__forceinline__ __device__ void atomicMaxWarp(T* address, T val)
+{
+  raft::genericAtomicOperationWarp(address, val, raft::device_atomics::detail::DeviceMax{});
+}
+
+/**
+ * @brief Atomic min of an 8-byte key-value pair by its value
+ *
+ * Replaces the pair at `address` with `val` if `val.value < address->value`, updating the key and
+ * the value together in a single 64-bit transaction, without a lock. Nothing is written when `val`
+ * does not improve the pair, which skips the atomics for most of the updates of a min-reduction.
+ *
+ * @tparam KVP a key-value pair of 8 bytes, e.g. `raft::KeyValuePair<int, float>`
+ *
+ * @param[in] address The 8-byte aligned address of the pair in global or shared memory
+ * @param[in] val The candidate pair
+ *
+ * @returns The old pair at `address`
+ */
+template <typename KVP>
+__forceinline__ __device__ KVP atomicMinKeyValue(KVP* address, KVP val)
+{
+  using T_int = unsigned long long int;
+  using raft::device_atomics::detail::type_reinterpret;
+  static_assert(sizeof(KVP) == sizeof(T_int), "atomicMinKeyValue requires an 8-byte pair");
+  auto* address_int = reinterpret_cast<T_int*>(address);
+  T_int old         = *reinterpret_cast<volatile T_int*>(address_int);
+  KVP current       = type_reinterpret<KVP, T_int>(old);
+  while (val.value < current.value) {
+    const T_int assumed = old;
+    old                 = atomicCAS(address_int, assumed, type_reinterpret<T_int, KVP>(val));
+    if (old == assumed) { break; }
+    current = type_reinterpret<KVP, T_int>(old);
+  }
+  return current;
+}
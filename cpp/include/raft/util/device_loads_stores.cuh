@@ -535,6 +535,37 @@ DI void ldg(int8_t (&x)[1], const int8_t* const& addr)
   x[0] = x_int;
 }
 
+/**
+ * @defgroup GlobalLoadsNoAllocate Global streaming load operations
+ * @{
+ * @brief Load read-only data from global memory through the non-coherent path, without
+ *        allocating it in L1 (`ld.global.nc.L1::no_allocate`): for the data read once, so that it
+ *        does not evict the data that is reused. Before Volta, this is a plain `ld.global.nc`.
+ * @param[out] x    data to be loaded from global memory
+ * @param[in]  addr address in global memory from where to load (aligned to the vector size)
+ */
+#if defined(__CUDA_ARCH__) && (__CUDA_ARCH__ >= 700)
+#define RAFT_LDG_NO_ALLOCATE "ld.global.nc.L1::no_allocate"
+#else
+#define RAFT_LDG_NO_ALLOCATE "ld.global.nc"
+#endif
+DI void ldg_no_allocate(uint32_t (&x)[4], const uint32_t* addr)
+{
+  asm volatile(RAFT_LDG_NO_ALLOCATE ".v4.u32 {%0, %1, %2, %3}, [%4];"
+               : "=r"(x[0]), "=r"(x[1]), "=r"(x[2]), "=r"(x[3])
+               : "l"(addr));
+}
+DI void ldg_no_allocate(uint32_t (&x)[2], const uint32_t* addr)
+{
+  asm volatile(RAFT_LDG_NO_ALLOCATE ".v2.u32 {%0, %1}, [%2];" : "=r"(x[0]), "=r"(x[1]) : "l"(addr));
+}
+DI void ldg_no_allocate(uint32_t (&x)[1], const uint32_t* addr)
+{
+  asm volatile(RAFT_LDG_NO_ALLOCATE ".u32 %0, [%1];" : "=r"(x[0]) : "l"(addr));
+}
+#undef RAFT_LDG_NO_ALLOCATE
+/** @} */
+
 /**
  * @brief Executes a 1D block strided copy
  * @param dst destination pointer
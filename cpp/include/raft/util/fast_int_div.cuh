@@ -19,13 +19,16 @@
 #include <raft/util/cuda_utils.cuh>
 #include <stdint.h>
 
+#include <type_traits>
+
 namespace raft::util {
 
 /**
  * @brief Perform fast integer division and modulo using a known divisor
  * From Hacker's Delight, Second Edition, Chapter 10
  *
- * @note This currently only supports 32b signed integers
+ * @note This currently only supports 32b signed integers; see `FastUIntDiv` for the unsigned 32b
+ *       and 64b integers.
  * @todo Extend support for signed divisors
  */
 struct FastIntDiv {
@@ -120,4 +123,100 @@ HDI int operator%(int n, const FastIntDiv& divisor)
   return remainder;
 }
 
+/**
+ * @brief Perform fast division and modulo of unsigned integers by a divisor known in advance,
+ *   e.g. a graph degree or a matrix dimension passed to a kernel.
+ *
+ * The quotient is computed by a high-word multiplication with a precomputed multiplier and two
+ * shifts (Granlund and Montgomery, "Division by Invariant Integers using Multiplication",
+ * Figure 4.1), exact for all the numerators and all the positive divisors. Unlike `FastIntDiv`,
+ * the divisor can also be constructed on the device, although it is cheaper to construct it
+ * once on the host and pass it to the kernel by value.
+ *
+ * @code{.cpp}
+ *   __global__ void kernel(raft::util::FastUIntDiv<uint32_t> n_cols, ...)
+ *   {
+ *     uint32_t row = i / n_cols;
+ *     uint32_t col = i - row * n_cols.d;
+ *   }
+ *   kernel<<<grid, block, 0, stream>>>(n_cols, ...);  // converted on the host
+ * @endcode
+ *
+ * @tparam T uint32_t or uint64_t
+ */
+template <typename T>
+struct FastUIntDiv {
+  static_assert(std::is_same_v<T, uint32_t> || std::is_same_v<T, uint64_t>,
+                "FastUIntDiv: only 32b and 64b unsigned integers are supported");
+  static constexpr uint32_t kBits = sizeof(T) * 8;
+
+  /** @param _d the divisor, must be positive */
+  HDI FastUIntDiv(T _d) : d(_d) { computeScalars(); }
+
+  /** divisor */
+  T d;
+  /** the multiplier (m' in the reference) */
+  T m;
+  /** the shifts (sh1 and sh2 in the reference) */
+  uint32_t s1, s2;
+
+  /** @brief The quotient `n / d`. */
+  HDI T div(T n) const
+  {
+    T t = mulhi(m, n);
+    return (t + ((n - t) >> s1)) >> s2;
+  }
+  /** @brief The remainder `n % d`. */
+  HDI T mod(T n) const { return n - div(n) * d; }
+
+  friend HDI T operator/(T n, const FastUIntDiv& divisor) { return divisor.div(n); }
+  friend HDI T operator%(T n, const FastUIntDiv& divisor) { return divisor.mod(n); }
+
+ private:
+  HDI static T mulhi(T a, T b)
+  {
+#ifdef __CUDA_ARCH__
+    if constexpr (sizeof(T) == 4) {
+      return __umulhi(a, b);
+    } else {
+      return __umul64hi(a, b);
+    }
+#else
+    if constexpr (sizeof(T) == 4) {
+      return T((uint64_t(a) * uint64_t(b)) >> 32);
+    } else {
+      return T((static_cast<unsigned __int128>(a) * b) >> 64);
+    }
+#endif
+  }
+
+  HDI void computeScalars()
+  {
+#ifndef __CUDA_ARCH__
+    ASSERT(d > 0, "FastUIntDiv: got division by zero!");
+#endif
+    // l = ceil(log2(d))
+    uint32_t l = 0;
+    for (T x = d - 1; x != 0; x >>= 1) {
+      l++;
+    }
+    // m = floor(2^kBits * (2^l - d) / d) + 1, by the long division of (2^l - d) << kBits by d
+    // (the remainder r < d is kept within kBits by the carry of the shift).
+    T r = (l == kBits ? T(0) : T(T(1) << l)) - d;
+    T q = 0;
+    for (uint32_t i = 0; i < kBits; i++) {
+      bool carry = (r >> (kBits - 1)) != 0;
+      r <<= 1;
+      q <<= 1;
+      if (carry || r >= d) {
+        r -= d;
+        q |= 1;
+      }
+    }
+    m  = q + 1;
+    s1 = l > 0 ? 1 : 0;
+    s2 = l > 0 ? l - 1 : 0;
+  }
+};  // struct FastUIntDiv
+
 };  // namespace raft::util
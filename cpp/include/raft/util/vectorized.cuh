@@ -18,6 +18,10 @@
 
 #include <cuda_fp16.h>
 #include <raft/util/cuda_utils.cuh>
+#include <raft/util/device_loads_stores.cuh>
+#include <raft/util/pow2_utils.cuh>
+
+#include <algorithm>
 
 namespace raft {
 
@@ -354,4 +358,114 @@ struct TxN_t<math_, 0> {
   }
 };
 
+/**
+ * @brief Copy the contiguous range `in[0, n)` to `out` by all the threads of the block, through
+ * the widest vector accesses the alignment of the two pointers allows.
+ *
+ * The range is split into an unaligned head and tail, copied element by element, and an aligned
+ * body copied in `VecBytes`-wide vectors. When `in` and `out` have different offsets from the
+ * `VecBytes` alignment, the vector width is halved until they match.
+ *
+ * @tparam VecBytes the widest vector access, in bytes (a power of two)
+ * @tparam T the element type
+ * @param out the destination, in global or shared memory
+ * @param in the source, in global or shared memory
+ * @param n the number of elements
+ */
+template <int VecBytes = 16, typename T>
+DI void copy_vectorized(T* out, const T* in, uint32_t n)
+{
+  constexpr int VecElems = VecBytes / sizeof(T);  // NOLINT
+  using align_bytes      = Pow2<(size_t)VecBytes>;
+  if constexpr (VecElems > 1) {
+    using align_elems = Pow2<VecElems>;
+    if (!align_bytes::areSameAlignOffsets(out, in)) {
+      return copy_vectorized<(VecBytes >> 1), T>(out, in, n);
+    }
+    {  // process unaligned head
+      uint32_t head = std::min<uint32_t>(align_bytes::roundUp(in) - in, n);
+      if (head > 0) {
+        copy_vectorized<sizeof(T), T>(out, in, head);
+        n -= head;
+        in += head;
+        out += head;
+      }
+    }
+    {  // process main part vectorized
+      using vec_t = typename IOType<T, VecElems>::Type;
+      copy_vectorized<sizeof(vec_t), vec_t>(
+        reinterpret_cast<vec_t*>(out), reinterpret_cast<const vec_t*>(in), align_elems::div(n));
+    }
+    {  // process unaligned tail
+      uint32_t tail = align_elems::mod(n);
+      if (tail > 0) {
+        n -= tail;
+        copy_vectorized<sizeof(T), T>(out + n, in + n, tail);
+      }
+    }
+  }
+  if constexpr (VecElems <= 1) {
+    for (int i = threadIdx.x; i < n; i += blockDim.x) {
+      out[i] = in[i];
+    }
+  }
+}
+
+/**
+ * @brief Read the contiguous range `in[0, n)` of global memory cooperatively, through 16-byte
+ * vector loads whatever the alignment of `in` and the length `n`.
+ *
+ * The thread `rank` (of `n_threads`) reads the unaligned head and tail element by element and
+ * its share of the 16-byte aligned body in vectors, and calls `f(i, in[i])` for each element `i`
+ * it reads. Rows which size or offset is not a multiple of 16 bytes (e.g. a `dim = 100` `uint8_t`
+ * row of a row-major dataset) are thus read at the bandwidth of the vector loads, rather than
+ * falling back to the scalar loads for the whole row.
+ *
+ * @tparam NoAllocate whether to read through `ld.global.nc.L1::no_allocate`, for the data that
+ *   is read once
+ * @tparam T the element type (of up to 16 bytes)
+ * @tparam IdxT the index type
+ * @tparam Func the visitor `void(IdxT i, T x)`
+ *
+ * @param in the range, in global memory; must be aligned to `sizeof(T)`
+ * @param n the number of elements
+ * @param f the visitor of every element
+ * @param rank the rank of the thread among the readers
+ * @param n_threads the number of the threads reading the range
+ */
+template <bool NoAllocate = false, typename T, typename IdxT, typename Func>
+DI void vectorized_for_each(const T* in, IdxT n, Func f, IdxT rank, IdxT n_threads)
+{
+  constexpr IdxT kVecElems = 16 / sizeof(T);
+  auto scalar              = [&](IdxT from, IdxT to) {
+    for (IdxT i = from + rank; i < to; i += n_threads) {
+      f(i, __ldg(in + i));
+    }
+  };
+  if constexpr (kVecElems <= 1) {
+    scalar(0, n);
+  } else {
+    using align_bytes = Pow2<16>;
+    IdxT head         = std::min<IdxT>(IdxT(align_bytes::roundUp(in) - in), n);
+    IdxT n_vecs       = (n - head) / kVecElems;
+    IdxT body_end     = head + n_vecs * kVecElems;
+    scalar(0, head);
+    const uint32_t* body = reinterpret_cast<const uint32_t*>(in + head);
+    for (IdxT v = rank; v < n_vecs; v += n_threads) {
+      alignas(16) T elems[kVecElems];
+      auto& words = *reinterpret_cast<uint32_t(*)[4]>(elems);
+      if constexpr (NoAllocate) {
+        ldg_no_allocate(words, body + 4 * v);
+      } else {
+        *reinterpret_cast<uint4*>(words) = __ldg(reinterpret_cast<const uint4*>(body) + v);
+      }
+#pragma unroll
+      for (IdxT j = 0; j < kVecElems; j++) {
+        f(head + v * kVecElems + j, elems[j]);
+      }
+    }
+    scalar(body_end, n);
+  }
+}
+
 }  // namespace raft
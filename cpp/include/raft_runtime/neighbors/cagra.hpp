@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/host_mdspan.hpp>
+#include <raft/neighbors/cagra_types.hpp>
+
+#include <string>
+
+namespace raft::runtime::neighbors::cagra {
+
+// We define overloads for build with void return type. This is used in the Cython wrappers, where
+// exception handling is not compatible with return type that has nontrivial constructor.
+#define RAFT_INST_CAGRA_FUNCS(T, IdxT)                                                    \
+  auto build(raft::resources const& handle,                                               \
+             const raft::neighbors::experimental::cagra::index_params& params,            \
+             raft::device_matrix_view<const T, IdxT, row_major> dataset)                  \
+    ->raft::neighbors::experimental::cagra::index<T, IdxT>;                               \
+                                                                                          \
+  void build_device(raft::resources const& handle,                                        \
+                    const raft::neighbors::experimental::cagra::index_params& params,     \
+                    raft::device_matrix_view<const T, IdxT, row_major> dataset,           \
+                    raft::neighbors::experimental::cagra::index<T, IdxT>& idx);           \
+                                                                                          \
+  void build_host(raft::resources const& handle,                                          \
+                  const raft::neighbors::experimental::cagra::index_params& params,       \
+                  raft::host_matrix_view<const T, IdxT, row_major> dataset,               \
+                  raft::neighbors::experimental::cagra::index<T, IdxT>& idx);             \
+                                                                                          \
+  void search(raft::resources const& handle,                                              \
+              raft::neighbors::experimental::cagra::search_params const& params,          \
+              const raft::neighbors::experimental::cagra::index<T, IdxT>& index,          \
+              raft::device_matrix_view<const T, IdxT, row_major> queries,                 \
+              raft::device_matrix_view<IdxT, IdxT, row_major> neighbors,                  \
+              raft::device_matrix_view<float, IdxT, row_major> distances);                \
+                                                                                          \
+  void serialize_file(raft::resources const& handle,                                      \
+                      const std::string& filename,                                        \
+                      const raft::neighbors::experimental::cagra::index<T, IdxT>& index); \
+                                                                                          \
+  void deserialize_file(raft::resources const& handle,                                    \
+                        const std::string& filename,                                      \
+                        raft::neighbors::experimental::cagra::index<T, IdxT>* index);     \
+  void serialize(raft::resources const& handle,                                           \
+                 std::string& str,                                                        \
+                 const raft::neighbors::experimental::cagra::index<T, IdxT>& index);      \
+                                                                                          \
+  void deserialize(raft::resources const& handle,                                         \
+                   const std::string& str,                                                \
+                   raft::neighbors::experimental::cagra::index<T, IdxT>* index);
+
+RAFT_INST_CAGRA_FUNCS(float, uint32_t);
+RAFT_INST_CAGRA_FUNCS(int8_t, uint32_t);
+RAFT_INST_CAGRA_FUNCS(uint8_t, uint32_t);
+
+#undef RAFT_INST_CAGRA_FUNCS
+
+}  // namespace raft::runtime::neighbors::cagra
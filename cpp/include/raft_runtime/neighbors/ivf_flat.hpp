@@ -17,6 +17,9 @@
 #pragma once
 
 #include <raft/neighbors/ivf_flat_types.hpp>
+
+#include <cuda_fp16.h>
+
 #include <string>
 
 namespace raft::runtime::neighbors::ivf_flat {
@@ -63,6 +66,7 @@ namespace raft::runtime::neighbors::ivf_flat {
 RAFT_INST_BUILD_EXTEND(float, int64_t)
 RAFT_INST_BUILD_EXTEND(int8_t, int64_t)
 RAFT_INST_BUILD_EXTEND(uint8_t, int64_t)
+RAFT_INST_BUILD_EXTEND(half, int64_t)
 
 #undef RAFT_INST_BUILD_EXTEND
 
@@ -77,6 +81,7 @@ RAFT_INST_BUILD_EXTEND(uint8_t, int64_t)
 RAFT_INST_SEARCH(float, int64_t);
 RAFT_INST_SEARCH(int8_t, int64_t);
 RAFT_INST_SEARCH(uint8_t, int64_t);
+RAFT_INST_SEARCH(half, int64_t);
 
 #undef RAFT_INST_SEARCH
 
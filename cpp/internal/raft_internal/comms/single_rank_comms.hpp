@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <raft/core/comms.hpp>
+#include <raft/core/error.hpp>
+#include <raft/core/resource/comms.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/util/cuda_rt_essentials.hpp>
+
+#include <cuda_runtime_api.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace raft::comms {
+
+/**
+ * A communicator of a single rank, for testing the multi-GPU algorithms without NCCL or UCX.
+ *
+ * With one rank, every collective reduces to copying the send buffer to the receive buffer in the
+ * stream, and the device point-to-point operations are sends to self. The host point-to-point
+ * operations are not supported.
+ */
+class single_rank_comms : public comms_iface {
+ public:
+  int get_size() const override { return 1; }
+  int get_rank() const override { return 0; }
+
+  std::unique_ptr<comms_iface> comm_split(int color, int key) const override
+  {
+    return std::make_unique<single_rank_comms>();
+  }
+
+  void barrier() const override {}
+
+  status_t sync_stream(cudaStream_t stream) const override
+  {
+    RAFT_CUDA_TRY(cudaStreamSynchronize(stream));
+    return status_t::SUCCESS;
+  }
+
+  void isend(const void*, size_t, int, int, request_t*) const override
+  {
+    RAFT_FAIL("single_rank_comms does not support the host point-to-point operations");
+  }
+  void irecv(void*, size_t, int, int, request_t*) const override
+  {
+    RAFT_FAIL("single_rank_comms does not support the host point-to-point operations");
+  }
+  void waitall(int count, request_t[]) const override
+  {
+    RAFT_EXPECTS(count == 0,
+                 "single_rank_comms does not support the host point-to-point operations");
+  }
+
+  void allreduce(const void* sendbuff,
+                 void* recvbuff,
+                 size_t count,
+                 datatype_t datatype,
+                 op_t,
+                 cudaStream_t stream) const override
+  {
+    copy(recvbuff, sendbuff, count * datatype_size(datatype), stream);
+  }
+
+  void bcast(void*, size_t, datatype_t, int root, cudaStream_t) const override { check_rank(root); }
+
+  void bcast(const void* sendbuff,
+             void* recvbuff,
+             size_t count,
+             datatype_t datatype,
+             int root,
+             cudaStream_t stream) const override
+  {
+    check_rank(root);
+    copy(recvbuff, sendbuff, count * datatype_size(datatype), stream);
+  }
+
+  void reduce(const void* sendbuff,
+              void* recvbuff,
+              size_t count,
+              datatype_t datatype,
+              op_t,
+              int root,
+              cudaStream_t stream) const override
+  {
+    check_rank(root);
+    copy(recvbuff, sendbuff, count * datatype_size(datatype), stream);
+  }
+
+  void allgather(const void* sendbuff,
+                 void* recvbuff,
+                 size_t sendcount,
+                 datatype_t datatype,
+                 cudaStream_t stream) const override
+  {
+    copy(recvbuff, sendbuff, sendcount * datatype_size(datatype), stream);
+  }
+
+  void allgatherv(const void* sendbuf,
+                  void* recvbuf,
+                  const size_t* recvcounts,
+                  const size_t* displs,
+                  datatype_t datatype,
+                  cudaStream_t stream) const override
+  {
+    const size_t dtype_size = datatype_size(datatype);
+    copy(static_cast<char*>(recvbuf) + displs[0] * dtype_size,
+         sendbuf,
+         recvcounts[0] * dtype_size,
+         stream);
+  }
+
+  void gather(const void* sendbuff,
+              void* recvbuff,
+              size_t sendcount,
+              datatype_t datatype,
+              int root,
+              cudaStream_t stream) const override
+  {
+    check_rank(root);
+    copy(recvbuff, sendbuff, sendcount * datatype_size(datatype), stream);
+  }
+
+  void gatherv(const void* sendbuf,
+               void* recvbuf,
+               size_t sendcount,
+               const size_t*,
+               const size_t* displs,
+               datatype_t datatype,
+               int root,
+               cudaStream_t stream) const override
+  {
+    check_rank(root);
+    const size_t dtype_size = datatype_size(datatype);
+    copy(static_cast<char*>(recvbuf) + displs[0] * dtype_size,
+         sendbuf,
+         sendcount * dtype_size,
+         stream);
+  }
+
+  void reducescatter(const void* sendbuff,
+                     void* recvbuff,
+                     size_t recvcount,
+                     datatype_t datatype,
+                     op_t,
+                     cudaStream_t stream) const override
+  {
+    copy(recvbuff, sendbuff, recvcount * datatype_size(datatype), stream);
+  }
+
+  void device_send(const void*, size_t, int dest, cudaStream_t) const override
+  {
+    RAFT_FAIL("single_rank_comms: an unpaired send to self (rank %d) would never complete", dest);
+  }
+
+  void device_recv(void*, size_t, int source, cudaStream_t) const override
+  {
+    RAFT_FAIL("single_rank_comms: an unpaired receive from self (rank %d) would never complete",
+              source);
+  }
+
+  void device_sendrecv(const void* sendbuf,
+                       size_t sendsize,
+                       int dest,
+                       void* recvbuf,
+                       size_t recvsize,
+                       int source,
+                       cudaStream_t stream) const override
+  {
+    check_rank(dest);
+    check_rank(source);
+    RAFT_EXPECTS(sendsize == recvsize, "The send and receive sizes to self must match");
+    copy(recvbuf, sendbuf, sendsize, stream);
+  }
+
+  void device_multicast_sendrecv(const void* sendbuf,
+                                 std::vector<size_t> const& sendsizes,
+                                 std::vector<size_t> const& sendoffsets,
+                                 std::vector<int> const& dests,
+                                 void* recvbuf,
+                                 std::vector<size_t> const& recvsizes,
+                                 std::vector<size_t> const& recvoffsets,
+                                 std::vector<int> const& sources,
+                                 cudaStream_t stream) const override
+  {
+    RAFT_EXPECTS(sendsizes.size() == recvsizes.size(),
+                 "Every send to self must have a matching receive");
+    for (size_t i = 0; i < sendsizes.size(); i++) {
+      check_rank(dests[i]);
+      check_rank(sources[i]);
+      RAFT_EXPECTS(sendsizes[i] == recvsizes[i], "The send and receive sizes to self must match");
+      copy(static_cast<char*>(recvbuf) + recvoffsets[i],
+           static_cast<const char*>(sendbuf) + sendoffsets[i],
+           sendsizes[i],
+           stream);
+    }
+  }
+
+  void group_start() const override {}
+  void group_end() const override {}
+
+ private:
+  static void check_rank(int rank)
+  {
+    RAFT_EXPECTS(rank == 0, "Rank %d does not exist in a single-rank communicator", rank);
+  }
+
+  static void copy(void* dst, const void* src, size_t bytes, cudaStream_t stream)
+  {
+    if (dst == src || bytes == 0) { return; }
+    RAFT_CUDA_TRY(cudaMemcpyAsync(dst, src, bytes, cudaMemcpyDefault, stream));
+  }
+
+  static auto datatype_size(datatype_t datatype) -> size_t
+  {
+    switch (datatype) {
+      case datatype_t::CHAR: return sizeof(char);
+      case datatype_t::UINT8: return sizeof(uint8_t);
+      case datatype_t::INT32: return sizeof(int32_t);
+      case datatype_t::UINT32: return sizeof(uint32_t);
+      case datatype_t::INT64: return sizeof(int64_t);
+      case datatype_t::UINT64: return sizeof(uint64_t);
+      case datatype_t::FLOAT32: return sizeof(float);
+      case datatype_t::FLOAT64: return sizeof(double);
+      default: RAFT_FAIL("Unsupported datatype");
+    }
+  }
+};
+
+/** Inject a single-rank communicator into the handle. */
+inline void initialize_single_rank_comms(raft::resources* handle)
+{
+  resource::set_comms(*handle, std::make_shared<comms_t>(std::make_unique<single_rank_comms>()));
+}
+
+}  // namespace raft::comms
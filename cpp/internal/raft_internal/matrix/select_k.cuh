@@ -18,6 +18,7 @@
 
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resources.hpp>
+#include <raft/matrix/detail/select_packed.cuh>
 #include <raft/matrix/detail/select_radix.cuh>
 #include <raft/matrix/detail/select_warpsort.cuh>
 #include <raft/matrix/select_k.cuh>
@@ -56,7 +57,9 @@ enum class Algo {
   kWarpFiltered,
   kWarpDistributed,
   kWarpDistributedShm,
-  kFaissBlockSelect
+  kFaissBlockSelect,
+  kRadixLargeK,
+  kWarpPacked
 };
 
 inline auto operator<<(std::ostream& os, const Algo& algo) -> std::ostream&
@@ -72,6 +75,8 @@ inline auto operator<<(std::ostream& os, const Algo& algo) -> std::ostream&
     case Algo::kWarpDistributed: return os << "kWarpDistributed";
     case Algo::kWarpDistributedShm: return os << "kWarpDistributedShm";
     case Algo::kFaissBlockSelect: return os << "kFaissBlockSelect";
+    case Algo::kRadixLargeK: return os << "kRadixLargeK";
+    case Algo::kWarpPacked: return os << "kWarpPacked";
     default: return os << "unknown enum value";
   }
 }
@@ -159,9 +164,27 @@ void select_k_impl(const resources& handle,
       return detail::select::warpsort::
         select_k_impl<T, IdxT, detail::select::warpsort::warp_sort_distributed_ext>(
           in, in_idx, batch_size, len, k, out, out_idx, select_min, stream);
+    case Algo::kWarpPacked:
+      if constexpr (detail::select::packed::kPackableKey<T>) {
+        return detail::select::packed::select_k<T, IdxT>(
+          in, in_idx, batch_size, len, k, out, out_idx, select_min, stream);
+      } else {
+        RAFT_FAIL("The packed select_k does not support keys wider than 32 bits");
+      }
     case Algo::kFaissBlockSelect:
       return neighbors::detail::select_k(
         in, in_idx, batch_size, len, out, out_idx, select_min, k, stream);
+    case Algo::kRadixLargeK:
+      return detail::select::radix::select_large_k<T, IdxT, 11, 512>(in,
+                                                                     in_idx,
+                                                                     batch_size,
+                                                                     len,
+                                                                     k,
+                                                                     out,
+                                                                     out_idx,
+                                                                     select_min,
+                                                                     false,  // sorted
+                                                                     stream);
   }
 }
 }  // namespace raft::matrix::select
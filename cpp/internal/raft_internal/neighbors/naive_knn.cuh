@@ -40,7 +40,9 @@ __global__ void naive_distance_kernel(EvalT* dist,
   if (midx >= m) return;
   IdxT grid_size = IdxT(blockDim.y) * IdxT(gridDim.y);
   for (IdxT nidx = threadIdx.y + blockIdx.y * blockDim.y; nidx < n; nidx += grid_size) {
-    EvalT acc = EvalT(0);
+    EvalT acc    = EvalT(0);
+    EvalT x_norm = EvalT(0);
+    EvalT y_norm = EvalT(0);
     for (IdxT i = 0; i < k; ++i) {
       IdxT xidx = i + midx * k;
       IdxT yidx = i + nidx * k;
@@ -50,6 +52,11 @@ __global__ void naive_distance_kernel(EvalT* dist,
         case raft::distance::DistanceType::InnerProduct: {
           acc += xv * yv;
         } break;
+        case raft::distance::DistanceType::CosineExpanded: {
+          acc += xv * yv;
+          x_norm += xv * xv;
+          y_norm += yv * yv;
+        } break;
         case raft::distance::DistanceType::L2SqrtExpanded:
         case raft::distance::DistanceType::L2SqrtUnexpanded:
         case raft::distance::DistanceType::L2Expanded:
@@ -65,6 +72,10 @@ __global__ void naive_distance_kernel(EvalT* dist,
       case raft::distance::DistanceType::L2SqrtUnexpanded: {
         acc = raft::sqrt(acc);
       } break;
+      case raft::distance::DistanceType::CosineExpanded: {
+        auto norms = raft::sqrt(x_norm) * raft::sqrt(y_norm);
+        acc        = norms > EvalT(0) ? EvalT(1) - acc / norms : EvalT(1);
+      } break;
       default: break;
     }
     dist[midx * n + nidx] = acc;
@@ -0,0 +1,149 @@
+#!/usr/bin/env python3
+# Copyright (c) 2023, NVIDIA CORPORATION.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Compare two runs of the RAFT prims benchmarks (the JSON output of Google Benchmark).
+
+The benchmarks are matched by name. For each of them, the change of the metric (the real time by
+default) from the baseline to the contender is reported. A change counts as a regression or an
+improvement only if
+
+  - it is larger than the relative `--threshold`, and
+  - it is larger than `--noise` times the combined standard deviation of the two runs, when the
+    runs have repetitions (`--benchmark_repetitions=N`).
+
+Example:
+
+    MATRIX_BENCH --benchmark_filter=SelectK --benchmark_repetitions=5 --benchmark_out=old.json
+    # ... upgrade RAFT ...
+    MATRIX_BENCH --benchmark_filter=SelectK --benchmark_repetitions=5 --benchmark_out=new.json
+    compare_benchmarks.py old.json new.json
+
+The exit code is 1 if there are regressions, so that the script can gate an upgrade.
+"""
+
+import argparse
+import json
+import math
+import re
+import statistics
+import sys
+
+TIME_UNITS = {"ns": 1e-9, "us": 1e-6, "ms": 1e-3, "s": 1.0}
+
+
+def load(path, metric, name_filter):
+    """Read the samples of the metric of every benchmark, and the context of the run."""
+    with open(path) as f:
+        data = json.load(f)
+    samples = {}
+    for b in data.get("benchmarks", []):
+        # the aggregates (mean, median, stddev...) are recomputed from the repetitions
+        if b.get("run_type", "iteration") != "iteration" or b.get("error_occurred", False):
+            continue
+        name = b.get("run_name", b["name"])
+        if name_filter is not None and not name_filter.search(name):
+            continue
+        if metric in ("real_time", "cpu_time"):
+            value = b[metric] * TIME_UNITS[b.get("time_unit", "ns")]
+        elif metric in b:
+            value = b[metric]
+        else:
+            continue
+        samples.setdefault(name, []).append(float(value))
+    return data.get("context", {}), samples
+
+
+def compare(old, new, threshold, noise, higher_is_better):
+    rows = []
+    for name in sorted(old.keys() & new.keys()):
+        a, b = old[name], new[name]
+        mean_a, mean_b = statistics.fmean(a), statistics.fmean(b)
+        if mean_a == 0:
+            continue
+        change = (mean_b - mean_a) / mean_a
+        sd = 0.0
+        if len(a) > 1 and len(b) > 1:
+            sd = math.sqrt(statistics.variance(a) / len(a) + statistics.variance(b) / len(b))
+        significant = abs(change) > threshold and abs(mean_b - mean_a) > noise * sd
+        worse = change < 0 if higher_is_better else change > 0
+        verdict = ("REGRESSION" if worse else "improvement") if significant else ""
+        rows.append((name, mean_a, mean_b, change, sd / abs(mean_a), verdict))
+    return rows
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter
+    )
+    parser.add_argument("baseline", help="JSON results of the baseline run")
+    parser.add_argument("contender", help="JSON results of the run to check")
+    parser.add_argument(
+        "--metric",
+        default="real_time",
+        help="real_time, cpu_time, or the name of a counter (default: real_time)",
+    )
+    parser.add_argument(
+        "--higher-is-better",
+        action="store_true",
+        help="the metric is a throughput (e.g. a bandwidth counter) rather than a time",
+    )
+    parser.add_argument(
+        "--threshold",
+        type=float,
+        default=0.05,
+        help="the minimal relative change to report (default: 0.05)",
+    )
+    parser.add_argument(
+        "--noise",
+        type=float,
+        default=3.0,
+        help="the minimal change in the standard deviations of the means (default: 3)",
+    )
+    parser.add_argument("--filter", help="only compare the benchmarks matching this regex")
+    parser.add_argument(
+        "--all", action="store_true", help="list all the benchmarks, not only the changed ones"
+    )
+    args = parser.parse_args()
+
+    name_filter = re.compile(args.filter) if args.filter else None
+    old_context, old = load(args.baseline, args.metric, name_filter)
+    new_context, new = load(args.contender, args.metric, name_filter)
+
+    for key in ("raft_version", "gpu_name", "cuda_driver_version", "cuda_runtime_version"):
+        a, b = old_context.get(key, "?"), new_context.get(key, "?")
+        print(f"{key}: {a}" if a == b else f"{key}: {a} -> {b}")
+    if old_context.get("gpu_name") != new_context.get("gpu_name"):
+        print("warning: the runs are on different devices", file=sys.stderr)
+    for name in sorted(old.keys() ^ new.keys()):
+        print(f"only in {'baseline' if name in old else 'contender'}: {name}")
+
+    rows = compare(old, new, args.threshold, args.noise, args.higher_is_better)
+    shown = [r for r in rows if args.all or r[5]]
+    if shown:
+        width = max(len("benchmark"), *(len(r[0]) for r in shown))
+        print(f"{'benchmark':<{width}}  {'baseline':>12}  {'contender':>12}  {'change':>8}  "
+              f"{'noise':>7}")
+        for name, a, b, change, rel_sd, verdict in sorted(shown, key=lambda r: -abs(r[3])):
+            print(f"{name:<{width}}  {a:>12.6g}  {b:>12.6g}  {change:>+8.1%}  {rel_sd:>7.1%}  "
+                  f"{verdict}")
+    regressions = sum(1 for r in rows if r[5] == "REGRESSION")
+    improvements = sum(1 for r in rows if r[5] == "improvement")
+    print(f"compared {len(rows)} benchmarks: {regressions} regressions, "
+          f"{improvements} improvements")
+    return 1 if regressions > 0 else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
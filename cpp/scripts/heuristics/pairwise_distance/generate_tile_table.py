@@ -0,0 +1,155 @@
+# Copyright (c) 2023, NVIDIA CORPORATION.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+"""Generates the per-architecture pairwise distance tile tables
+
+The benchmark times are produced on every target GPU by running:
+
+    ./cpp/build/TUNE_DISTANCE --benchmark_filter=shape_bench \\
+        --benchmark_out_format=json \\
+        --benchmark_out=tune_distance.json
+
+Then the tables are embedded at build time by regenerating the header:
+
+    python generate_tile_table.py \\
+        --output cpp/include/raft/distance/detail/pairwise_matrix/tile_config_tables.hpp \\
+        70=tune_distance_v100.json 80=tune_distance_a100.json
+
+The architecture is given as `10 * major + minor` of the compute capability of the GPU the
+benchmarks were run on.
+"""
+import argparse
+import datetime
+import json
+from collections import Counter, defaultdict
+
+# The values of `raft::distance::detail::tile_config`, in the order of the enum
+TILE_CONFIGS = ["kPolicy4x4", "kPolicy4x4Skinny"]
+
+# sizeof(DataT) of the tuning kernel (see cpp/bench/prims/distance/tune_pairwise/kernel.cuh)
+DTYPE_SIZE = 4
+
+
+def get_table(filename):
+    """Returns the list of (m, n, k, tile): the fastest tile configuration per shape
+
+    The times of the repetitions of a shape and tile configuration are summed up.
+    """
+    benchmarks = json.load(open(filename))["benchmarks"]
+    times = defaultdict(float)
+    for b in benchmarks:
+        if not b["name"].startswith("shape_bench"):
+            continue
+        if b.get("run_type", "iteration") != "iteration":
+            continue
+        shape = (int(b["m"]), int(b["n"]), int(b["k"]))
+        times[shape, TILE_CONFIGS[int(b["tile"])]] += b["real_time"]
+
+    best = {}
+    for (shape, tile), time in times.items():
+        if shape not in best or time < best[shape][1]:
+            best[shape] = (tile, time)
+    return [(m, n, k, tile) for (m, n, k), (tile, _) in sorted(best.items())]
+
+
+CPP_HEADER = """/*
+ * Copyright (c) {year}, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * NOTE: this file is generated by cpp/scripts/heuristics/pairwise_distance/generate_tile_table.py
+ *
+ * Do not edit manually; regenerate it from the benchmark results instead:
+ *
+ *   python generate_tile_table.py \\
+ *     --output cpp/include/raft/distance/detail/pairwise_matrix/tile_config_tables.hpp \\
+ *     70=tune_distance_v100.json 80=tune_distance_a100.json
+ */
+
+#pragma once
+
+#include <raft/distance/detail/pairwise_matrix/tile_config_types.hpp>  // tile_entry
+
+#include <utility>  // std::pair
+#include <vector>   // std::vector
+
+namespace raft::distance::detail {{
+
+/**
+ * The tile tables embedded at build time: pairs of the GPU architecture
+ * (`10 * major + minor` of the compute capability) and the measured entries.
+ */
+inline auto embedded_tile_tables() -> std::vector<std::pair<int, std::vector<tile_entry>>>
+{{
+  return {{{tables}}};
+}}
+
+}}  // namespace raft::distance::detail
+"""
+
+
+def write_cpp(tables, output):
+    arch_tables = []
+    for arch, table in tables:
+        entries = ",\n".join(
+            f"      {{{DTYPE_SIZE}, {m}, {n}, {k}, tile_config::{tile}}}"
+            for m, n, k, tile in table
+        )
+        arch_tables.append(f"\n    {{{arch},\n     {{\n{entries}}}}}")
+    with open(output, "w") as f:
+        f.write(
+            CPP_HEADER.format(
+                year=datetime.date.today().year, tables=",".join(arch_tables)
+            )
+        )
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Generate the per-architecture pairwise distance tile tables"
+    )
+    parser.add_argument(
+        "inputs",
+        nargs="+",
+        metavar="ARCH=FILE",
+        help="the architecture (e.g. 80 for sm_80) and the benchmark json file",
+    )
+    parser.add_argument("--output", required=True)
+    args = parser.parse_args()
+
+    tables = []
+    for arg in args.inputs:
+        arch, filename = arg.split("=", 1)
+        table = get_table(filename)
+        tiles = dict(Counter(t[3] for t in table))
+        print(f"sm_{arch}: {len(table)} entries, {tiles}")
+        tables.append((int(arch), table))
+
+    write_cpp(tables, args.output)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,185 @@
+# Copyright (c) 2023, NVIDIA CORPORATION.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+"""Generates the per-architecture select_k dispatch tables
+
+The benchmark times are produced on every target GPU by running:
+
+    ./cpp/build/MATRIX_BENCH --benchmark_filter=SelectKDataset \
+        --benchmark_out_format=json \
+        --benchmark_out=select_k_times.json \
+        --select_k_dispatch
+
+(or `--select_k_dataset` for the full, much slower, dataset). Then the tables are either
+written to a CSV file to be loaded at runtime (via the RAFT_SELECT_K_DISPATCH_TABLE
+environment variable or `select_k_dispatch::load_table()`):
+
+    python generate_dispatch_table.py --format csv --output select_k_dispatch.csv \
+        89=select_k_times_l4.json 90=select_k_times_h100.json
+
+or embedded at build time by regenerating the header:
+
+    python generate_dispatch_table.py --format cpp \
+        --output cpp/include/raft/matrix/detail/select_k_dispatch_tables.hpp \
+        89=select_k_times_l4.json 90=select_k_times_h100.json
+
+The architecture is given as `10 * major + minor` of the compute capability of the GPU the
+benchmarks were run on.
+"""
+import argparse
+import datetime
+from collections import Counter
+
+from select_k_dataset import load_dataframe
+
+# The algorithms `choose_select_k_algorithm` can dispatch to
+# (`raft::matrix::detail::Algo`)
+DISPATCH_ALGOS = [
+    "kRadix11bits",
+    "kWarpDistributedShm",
+    "kFaissBlockSelect",
+    "kRadixLargeK",
+    "kWarpPacked",
+]
+
+
+def is_pow2(x):
+    return x > 0 and (x & (x - 1)) == 0
+
+
+def get_table(filename):
+    """Returns the list of (rows, cols, k, algo): the fastest algorithm per problem size
+
+    Only the power-of-two problem sizes are used (the table is a grid in the log-space).
+    The times are summed up over the key/index types and the other benchmark options, so
+    that the chosen algorithm is the fastest on average.
+    """
+    df = load_dataframe(filename)
+    df = df[df.algo.isin(DISPATCH_ALGOS)]
+    df = df[df.row.apply(is_pow2) & df.col.apply(is_pow2) & df.k.apply(is_pow2)]
+
+    # only compare the algorithms on the inputs all of them have been run on
+    # (e.g. the warp-sort doesn't run for k > 256)
+    times = df.groupby(["row", "col", "k", "algo"]).time.agg(["sum", "count"])
+    times = times.reset_index()
+    table = []
+    for (row, col, k), group in times.groupby(["row", "col", "k"]):
+        group = group[group["count"] == group["count"].max()]
+        best = group.loc[group["sum"].idxmin()]
+        table.append((int(row), int(col), int(k), best.algo))
+    return table
+
+
+def write_csv(tables, output):
+    with open(output, "w") as f:
+        f.write("arch,rows,cols,k,algo\n")
+        for arch, table in tables:
+            for row, col, k, algo in table:
+                f.write(f"{arch},{row},{col},{k},{algo}\n")
+
+
+CPP_HEADER = """/*
+ * Copyright (c) {year}, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * NOTE: this file is generated by cpp/scripts/heuristics/select_k/generate_dispatch_table.py
+ *
+ * Do not edit manually; regenerate it from the benchmark results instead:
+ *
+ *   python generate_dispatch_table.py --format cpp \\
+ *     --output cpp/include/raft/matrix/detail/select_k_dispatch_tables.hpp \\
+ *     89=select_k_times_l4.json 90=select_k_times_h100.json
+ */
+
+#pragma once
+
+#include "select_k_dispatch_types.hpp"
+
+#include <utility>
+#include <vector>
+
+namespace raft::matrix::detail::select_k_dispatch {{
+
+/**
+ * The dispatch tables embedded at build time: pairs of the GPU architecture
+ * (`10 * major + minor` of the compute capability) and the measured entries.
+ */
+inline auto embedded_tables() -> std::vector<std::pair<int, std::vector<entry>>>
+{{
+  return {{{tables}}};
+}}
+
+}}  // namespace raft::matrix::detail::select_k_dispatch
+"""
+
+
+def write_cpp(tables, output):
+    arch_tables = []
+    for arch, table in tables:
+        entries = ",\n".join(
+            f"      {{{row}, {col}, {k}, Algo::{algo}}}"
+            for row, col, k, algo in table
+        )
+        arch_tables.append(f"\n    {{{arch},\n     {{\n{entries}}}}}")
+    with open(output, "w") as f:
+        f.write(
+            CPP_HEADER.format(
+                year=datetime.date.today().year, tables=",".join(arch_tables)
+            )
+        )
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Generate the per-architecture select_k dispatch tables"
+    )
+    parser.add_argument(
+        "inputs",
+        nargs="+",
+        metavar="ARCH=FILE",
+        help="the architecture (e.g. 89 for sm_89) and the benchmark json file",
+    )
+    parser.add_argument("--format", choices=["csv", "cpp"], default="csv")
+    parser.add_argument("--output", required=True)
+    args = parser.parse_args()
+
+    tables = []
+    for arg in args.inputs:
+        arch, filename = arg.split("=", 1)
+        table = get_table(filename)
+        algos = dict(Counter(t[3] for t in table))
+        print(f"sm_{arch}: {len(table)} entries, {algos}")
+        tables.append((int(arch), table))
+
+    if args.format == "csv":
+        write_csv(tables, args.output)
+    else:
+        write_cpp(tables, args.output)
+
+
+if __name__ == "__main__":
+    main()
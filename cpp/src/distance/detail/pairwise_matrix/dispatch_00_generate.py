@@ -108,12 +108,17 @@ op_instances = [
     # inner product is handled by cublas.
     dict(
         path_prefix="jensen_shannon",
+        OpT="raft::distance::detail::ops::jensen_shannon_exp_distance_op",
+        archs = [60],
+    ),
+    dict(
+        path_prefix="jensen_shannon_unexpanded",
         OpT="raft::distance::detail::ops::jensen_shannon_distance_op",
         archs = [60],
     ),
     dict(
         path_prefix="kl_divergence",
-        OpT="raft::distance::detail::ops::kl_divergence_op",
+        OpT="raft::distance::detail::ops::kl_divergence_exp_op",
         archs = [60],
     ),
     dict(
@@ -45,7 +45,7 @@
       bool is_row_major)
 
 instantiate_raft_distance_detail_pairwise_matrix_dispatch(
-  raft::distance::detail::ops::jensen_shannon_distance_op,
+  raft::distance::detail::ops::jensen_shannon_exp_distance_op,
   double,
   double,
   double,
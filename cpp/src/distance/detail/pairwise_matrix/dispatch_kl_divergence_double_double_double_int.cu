@@ -45,6 +45,11 @@
       bool is_row_major)
 
 instantiate_raft_distance_detail_pairwise_matrix_dispatch(
-  raft::distance::detail::ops::kl_divergence_op, double, double, double, raft::identity_op, int);
+  raft::distance::detail::ops::kl_divergence_exp_op,
+  double,
+  double,
+  double,
+  raft::identity_op,
+  int);
 
 #undef instantiate_raft_distance_detail_pairwise_matrix_dispatch
@@ -45,6 +45,6 @@
       bool is_row_major)
 
 instantiate_raft_distance_detail_pairwise_matrix_dispatch(
-  raft::distance::detail::ops::kl_divergence_op, float, float, float, raft::identity_op, int);
+  raft::distance::detail::ops::kl_divergence_exp_op, float, float, float, raft::identity_op, int);
 
 #undef instantiate_raft_distance_detail_pairwise_matrix_dispatch
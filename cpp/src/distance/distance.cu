@@ -932,3 +932,17 @@ instantiate_raft_distance_pairwise_distance(double, raft::layout_c_contiguous, i
 instantiate_raft_distance_pairwise_distance(double, raft::layout_f_contiguous, int);
 
 #undef instantiate_raft_distance_pairwise_distance
+
+#define instantiate_raft_distance_pairwise_distance_half(DataT, IdxT)     \
+  template void raft::distance::pairwise_distance(                        \
+    raft::resources const& handle,                                        \
+    raft::device_matrix_view<const DataT, IdxT, raft::row_major> const x, \
+    raft::device_matrix_view<const DataT, IdxT, raft::row_major> const y, \
+    raft::device_matrix_view<float, IdxT, raft::row_major> dist,          \
+    raft::distance::DistanceType metric,                                  \
+    float metric_arg)
+
+instantiate_raft_distance_pairwise_distance_half(half, int);
+instantiate_raft_distance_pairwise_distance_half(nv_bfloat16, int);
+
+#undef instantiate_raft_distance_pairwise_distance_half
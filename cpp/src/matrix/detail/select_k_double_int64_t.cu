@@ -16,17 +16,29 @@
 
 #include <raft/matrix/detail/select_k-inl.cuh>
 
-#define instantiate_raft_matrix_detail_select_k(T, IdxT)                     \
-  template void raft::matrix::detail::select_k(const T* in_val,              \
-                                               const IdxT* in_idx,           \
-                                               size_t batch_size,            \
-                                               size_t len,                   \
-                                               int k,                        \
-                                               T* out_val,                   \
-                                               IdxT* out_idx,                \
-                                               bool select_min,              \
-                                               rmm::cuda_stream_view stream, \
-                                               rmm::mr::device_memory_resource* mr)
+#define instantiate_raft_matrix_detail_select_k(T, IdxT)                             \
+  template void raft::matrix::detail::select_k(const T* in_val,                      \
+                                               const IdxT* in_idx,                   \
+                                               size_t batch_size,                    \
+                                               size_t len,                           \
+                                               int k,                                \
+                                               T* out_val,                           \
+                                               IdxT* out_idx,                        \
+                                               bool select_min,                      \
+                                               rmm::cuda_stream_view stream,         \
+                                               rmm::mr::device_memory_resource* mr); \
+  template void raft::matrix::detail::select_k_segmented(                            \
+    const T* in_val,                                                                 \
+    const IdxT* in_idx,                                                              \
+    const IdxT* row_offsets,                                                         \
+    size_t batch_size,                                                               \
+    size_t max_len,                                                                  \
+    int k,                                                                           \
+    T* out_val,                                                                      \
+    IdxT* out_idx,                                                                   \
+    bool select_min,                                                                 \
+    rmm::cuda_stream_view stream,                                                    \
+    rmm::mr::device_memory_resource* mr)
 
 instantiate_raft_matrix_detail_select_k(double, int64_t);
 
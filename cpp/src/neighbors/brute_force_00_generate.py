@@ -77,10 +77,47 @@ knn_types = dict(
     uint32_t_float_uint32_t=("uint32_t","float","uint32_t"),
 )
 
+build_search_macro = """
+#define instantiate_raft_neighbors_brute_force_build_search(T, IdxT) \\
+    template auto raft::neighbors::brute_force::build<T>(       \\
+        raft::resources const& res,                              \\
+        raft::device_matrix_view<const T, int64_t, row_major> dataset, \\
+        raft::distance::DistanceType metric,                    \\
+        T metric_arg)                                            \\
+        -> raft::neighbors::brute_force::index<T>;               \\
+                                                                 \\
+    template void raft::neighbors::brute_force::search<T, IdxT>( \\
+        raft::resources const& res,                              \\
+        const raft::neighbors::brute_force::index<T>& idx,       \\
+        raft::device_matrix_view<const T, int64_t, row_major> queries, \\
+        raft::device_matrix_view<IdxT, int64_t, row_major> neighbors, \\
+        raft::device_matrix_view<T, int64_t, row_major> distances); \\
+                                                                 \\
+    template void raft::neighbors::brute_force::search_with_filtering<T, IdxT>( \\
+        raft::resources const& res,                              \\
+        const raft::neighbors::brute_force::index<T>& idx,       \\
+        raft::device_matrix_view<const T, int64_t, row_major> queries, \\
+        raft::device_matrix_view<IdxT, int64_t, row_major> neighbors, \\
+        raft::device_matrix_view<T, int64_t, row_major> distances, \\
+        raft::device_vector_view<const uint32_t, int64_t> filter_bitset); \\
+                                                                 \\
+    template void raft::neighbors::brute_force::range_search<T, IdxT>( \\
+        raft::resources const& res,                              \\
+        const raft::neighbors::brute_force::index<T>& idx,       \\
+        raft::device_matrix_view<const T, int64_t, row_major> queries, \\
+        T radius,                                                \\
+        raft::device_csr_matrix<T, int64_t, IdxT, int64_t>& out);
+
+"""
+
 fused_l2_knn_types = dict(
     float_int64_t=("float", "int64_t"),
 )
 
+build_search_types = dict(
+    float_int64_t=("float", "int64_t"),
+)
+
 # knn
 for type_path, (idx_t, value_t, matrix_idx) in knn_types.items():
     path = f"brute_force_knn_{type_path}.cu"
@@ -104,3 +141,15 @@ for type_path, (value_t, idx_t) in fused_l2_knn_types.items():
 
     # For pasting into CMakeLists.txt
     print(f"src/neighbors/{path}")
+
+# build & search
+for type_path, (T, IdxT) in build_search_types.items():
+    path = f"brute_force_build_search_{type_path}.cu"
+    with open(path, "w") as f:
+        f.write(header)
+        f.write(build_search_macro)
+        f.write(f"instantiate_raft_neighbors_brute_force_build_search({T},{IdxT});\n\n")
+        f.write("#undef instantiate_raft_neighbors_brute_force_build_search\n")
+
+    # For pasting into CMakeLists.txt
+    print(f"src/neighbors/{path}")
@@ -0,0 +1,62 @@
+
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * NOTE: this file is generated by brute_force_00_generate.py
+ *
+ * Make changes there and run in this directory:
+ *
+ * > python brute_force_00_generate.py
+ *
+ */
+
+#include <cstdint>
+#include <raft/neighbors/brute_force-inl.cuh>
+
+#define instantiate_raft_neighbors_brute_force_build_search(T, IdxT)          \
+  template auto raft::neighbors::brute_force::build<T>(                       \
+    raft::resources const& res,                                               \
+    raft::device_matrix_view<const T, int64_t, row_major> dataset,            \
+    raft::distance::DistanceType metric,                                      \
+    T metric_arg)                                                             \
+    ->raft::neighbors::brute_force::index<T>;                                 \
+                                                                              \
+  template void raft::neighbors::brute_force::search<T, IdxT>(                \
+    raft::resources const& res,                                               \
+    const raft::neighbors::brute_force::index<T>& idx,                        \
+    raft::device_matrix_view<const T, int64_t, row_major> queries,            \
+    raft::device_matrix_view<IdxT, int64_t, row_major> neighbors,             \
+    raft::device_matrix_view<T, int64_t, row_major> distances);               \
+                                                                              \
+  template void raft::neighbors::brute_force::search_with_filtering<T, IdxT>( \
+    raft::resources const& res,                                               \
+    const raft::neighbors::brute_force::index<T>& idx,                        \
+    raft::device_matrix_view<const T, int64_t, row_major> queries,            \
+    raft::device_matrix_view<IdxT, int64_t, row_major> neighbors,             \
+    raft::device_matrix_view<T, int64_t, row_major> distances,                \
+    raft::device_vector_view<const uint32_t, int64_t> filter_bitset);         \
+                                                                              \
+  template void raft::neighbors::brute_force::range_search<T, IdxT>(          \
+    raft::resources const& res,                                               \
+    const raft::neighbors::brute_force::index<T>& idx,                        \
+    raft::device_matrix_view<const T, int64_t, row_major> queries,            \
+    T radius,                                                                 \
+    raft::device_csr_matrix<T, int64_t, IdxT, int64_t>& out);
+
+instantiate_raft_neighbors_brute_force_build_search(float, int64_t);
+
+#undef instantiate_raft_neighbors_brute_force_build_search
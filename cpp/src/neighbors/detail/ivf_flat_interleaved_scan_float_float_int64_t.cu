@@ -40,3 +40,24 @@ instantiate_raft_neighbors_ivf_flat_detail_ivfflat_interleaved_scan(
   float, float, int64_t, raft::neighbors::filtering::none_ivf_sample_filter);
 
 #undef instantiate_raft_neighbors_ivf_flat_detail_ivfflat_interleaved_scan
+
+#define instantiate_raft_neighbors_ivf_flat_detail_ivfflat_interleaved_range_scan(T, AccT, IdxT) \
+  template void                                                                                  \
+  raft::neighbors::ivf_flat::detail::ivfflat_interleaved_range_scan<T, AccT, IdxT>(              \
+    const raft::neighbors::ivf_flat::index<T, IdxT>& index,                                      \
+    const T* queries,                                                                            \
+    const uint32_t* coarse_query_results,                                                        \
+    const uint32_t n_queries,                                                                    \
+    const raft::distance::DistanceType metric,                                                   \
+    const uint32_t n_probes,                                                                     \
+    const float radius,                                                                          \
+    const bool select_min,                                                                       \
+    const bool count_only,                                                                       \
+    int64_t* row_counters,                                                                       \
+    IdxT* out_indices,                                                                           \
+    float* out_distances,                                                                        \
+    rmm::cuda_stream_view stream)
+
+instantiate_raft_neighbors_ivf_flat_detail_ivfflat_interleaved_range_scan(float, float, int64_t);
+
+#undef instantiate_raft_neighbors_ivf_flat_detail_ivfflat_interleaved_range_scan
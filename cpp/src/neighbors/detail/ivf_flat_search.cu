@@ -36,5 +36,25 @@ instantiate_raft_neighbors_ivf_flat_detail_search(
   int8_t, int64_t, raft::neighbors::filtering::none_ivf_sample_filter);
 instantiate_raft_neighbors_ivf_flat_detail_search(
   uint8_t, int64_t, raft::neighbors::filtering::none_ivf_sample_filter);
+instantiate_raft_neighbors_ivf_flat_detail_search(
+  half, int64_t, raft::neighbors::filtering::none_ivf_sample_filter);
 
 #undef instantiate_raft_neighbors_ivf_flat_detail_search
+
+#define instantiate_raft_neighbors_ivf_flat_detail_range_search(T, IdxT)  \
+  template void raft::neighbors::ivf_flat::detail::range_search<T, IdxT>( \
+    raft::resources const& handle,                                        \
+    const search_params& params,                                          \
+    const raft::neighbors::ivf_flat::index<T, IdxT>& index,               \
+    const T* queries,                                                     \
+    uint32_t n_queries,                                                   \
+    float radius,                                                         \
+    raft::device_csr_matrix<float, int64_t, IdxT, int64_t>& out,          \
+    rmm::mr::device_memory_resource* mr)
+
+instantiate_raft_neighbors_ivf_flat_detail_range_search(float, int64_t);
+instantiate_raft_neighbors_ivf_flat_detail_range_search(int8_t, int64_t);
+instantiate_raft_neighbors_ivf_flat_detail_range_search(uint8_t, int64_t);
+instantiate_raft_neighbors_ivf_flat_detail_range_search(half, int64_t);
+
+#undef instantiate_raft_neighbors_ivf_flat_detail_range_search
@@ -25,25 +25,41 @@
 
 #include <raft/neighbors/ivf_flat-inl.cuh>
 
-#define instantiate_raft_neighbors_ivf_flat_search(T, IdxT)     \
-  template void raft::neighbors::ivf_flat::search<T, IdxT>(     \
-    raft::resources const& handle,                              \
-    const raft::neighbors::ivf_flat::search_params& params,     \
-    const raft::neighbors::ivf_flat::index<T, IdxT>& index,     \
-    const T* queries,                                           \
-    uint32_t n_queries,                                         \
-    uint32_t k,                                                 \
-    IdxT* neighbors,                                            \
-    float* distances,                                           \
-    rmm::mr::device_memory_resource* mr);                       \
-                                                                \
-  template void raft::neighbors::ivf_flat::search<T, IdxT>(     \
-    raft::resources const& handle,                              \
-    const raft::neighbors::ivf_flat::search_params& params,     \
-    const raft::neighbors::ivf_flat::index<T, IdxT>& index,     \
-    raft::device_matrix_view<const T, IdxT, row_major> queries, \
-    raft::device_matrix_view<IdxT, IdxT, row_major> neighbors,  \
-    raft::device_matrix_view<float, IdxT, row_major> distances);
+#define instantiate_raft_neighbors_ivf_flat_search(T, IdxT)       \
+  template void raft::neighbors::ivf_flat::search<T, IdxT>(       \
+    raft::resources const& handle,                                \
+    const raft::neighbors::ivf_flat::search_params& params,       \
+    const raft::neighbors::ivf_flat::index<T, IdxT>& index,       \
+    const T* queries,                                             \
+    uint32_t n_queries,                                           \
+    uint32_t k,                                                   \
+    IdxT* neighbors,                                              \
+    float* distances,                                             \
+    rmm::mr::device_memory_resource* mr);                         \
+                                                                  \
+  template void raft::neighbors::ivf_flat::search<T, IdxT>(       \
+    raft::resources const& handle,                                \
+    const raft::neighbors::ivf_flat::search_params& params,       \
+    const raft::neighbors::ivf_flat::index<T, IdxT>& index,       \
+    raft::device_matrix_view<const T, IdxT, row_major> queries,   \
+    raft::device_matrix_view<IdxT, IdxT, row_major> neighbors,    \
+    raft::device_matrix_view<float, IdxT, row_major> distances);  \
+                                                                  \
+  template void raft::neighbors::ivf_flat::range_search<T, IdxT>( \
+    raft::resources const& handle,                                \
+    const raft::neighbors::ivf_flat::search_params& params,       \
+    const raft::neighbors::ivf_flat::index<T, IdxT>& index,       \
+    raft::device_matrix_view<const T, IdxT, row_major> queries,   \
+    float radius,                                                 \
+    raft::device_csr_matrix<float, int64_t, IdxT, int64_t>& out); \
+                                                                  \
+  template void raft::neighbors::ivf_flat::search<T, IdxT>(       \
+    raft::resources const& handle,                                \
+    const raft::neighbors::ivf_flat::search_params& params,       \
+    const raft::neighbors::ivf_flat::index<T, IdxT>& index,       \
+    raft::device_matrix_view<const T, IdxT, row_major> queries,   \
+    raft::host_vector_view<const uint32_t, IdxT> k,               \
+    raft::device_csr_matrix<float, int64_t, IdxT, int64_t>& out);
 instantiate_raft_neighbors_ivf_flat_search(float, int64_t);
 
 #undef instantiate_raft_neighbors_ivf_flat_search
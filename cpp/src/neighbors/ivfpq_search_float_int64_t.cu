@@ -35,7 +35,15 @@
     uint32_t k,                                                      \
     IdxT* neighbors,                                                 \
     float* distances,                                                \
-    rmm::mr::device_memory_resource* mr)
+    rmm::mr::device_memory_resource* mr);                            \
+                                                                     \
+  template void raft::neighbors::ivf_pq::search<T, IdxT>(            \
+    raft::resources const& handle,                                   \
+    const raft::neighbors::ivf_pq::search_params& params,            \
+    const raft::neighbors::ivf_pq::index<IdxT>& idx,                 \
+    raft::device_matrix_view<const T, uint32_t, row_major> queries,  \
+    raft::host_vector_view<const uint32_t, uint32_t> k,              \
+    raft::device_csr_matrix<float, int64_t, IdxT, int64_t>& out);
 
 instantiate_raft_neighbors_ivf_pq_search(float, int64_t);
 
@@ -43,6 +43,15 @@
     raft::host_matrix_view<const idx_t, matrix_idx, row_major> neighbor_candidates,   \
     raft::host_matrix_view<idx_t, matrix_idx, row_major> indices,                     \
     raft::host_matrix_view<distance_t, matrix_idx, row_major> distances,              \
+    raft::distance::DistanceType metric);                                             \
+                                                                                      \
+  template void raft::neighbors::refine<idx_t, data_t, distance_t, matrix_idx>(       \
+    raft::resources const& handle,                                                    \
+    raft::host_matrix_view<const data_t, matrix_idx, row_major> dataset,              \
+    raft::device_matrix_view<const data_t, matrix_idx, row_major> queries,            \
+    raft::device_matrix_view<const idx_t, matrix_idx, row_major> neighbor_candidates, \
+    raft::device_matrix_view<idx_t, matrix_idx, row_major> indices,                   \
+    raft::device_matrix_view<distance_t, matrix_idx, row_major> distances,            \
     raft::distance::DistanceType metric);
 
 instantiate_raft_neighbors_refine(int64_t, uint8_t, float, int64_t);
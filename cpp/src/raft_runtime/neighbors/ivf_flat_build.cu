@@ -56,6 +56,7 @@ namespace raft::runtime::neighbors::ivf_flat {
 RAFT_INST_BUILD_EXTEND(float, int64_t);
 RAFT_INST_BUILD_EXTEND(int8_t, int64_t);
 RAFT_INST_BUILD_EXTEND(uint8_t, int64_t);
+RAFT_INST_BUILD_EXTEND(half, int64_t);
 
 #undef RAFT_INST_BUILD_EXTEND
 
@@ -34,6 +34,7 @@ namespace raft::runtime::neighbors::ivf_flat {
 RAFT_INST_SEARCH(float, int64_t);
 RAFT_INST_SEARCH(int8_t, int64_t);
 RAFT_INST_SEARCH(uint8_t, int64_t);
+RAFT_INST_SEARCH(half, int64_t);
 
 #undef RAFT_INST_SEARCH
 
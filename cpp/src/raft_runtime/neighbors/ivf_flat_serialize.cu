@@ -60,6 +60,7 @@ namespace raft::runtime::neighbors::ivf_flat {
 RAFT_IVF_FLAT_SERIALIZE_INST(float);
 RAFT_IVF_FLAT_SERIALIZE_INST(int8_t);
 RAFT_IVF_FLAT_SERIALIZE_INST(uint8_t);
+RAFT_IVF_FLAT_SERIALIZE_INST(half);
 
 #undef RAFT_IVF_FLAT_SERIALIZE_INST
 }  // namespace raft::runtime::neighbors::ivf_flat
@@ -21,8 +21,18 @@
 #include <raft/core/resource/device_id.hpp>
 #include <raft/core/resources.hpp>
 
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/device_mdarray.hpp>
 #include <raft/spectral/cluster_solvers.cuh>
 #include <raft/spectral/modularity_maximization.cuh>
+#include <raft/spectral/partition.cuh>
+#include <raft/spectral/spectral_clustering.cuh>
+#include <raft/stats/adjusted_rand_index.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include "../test_utils.cuh"
+
+#include <vector>
 
 namespace raft {
 namespace spectral {
@@ -99,5 +109,157 @@ TEST(Raft, ModularitySolvers)
   EXPECT_ANY_THROW(spectral::analyzeModularity(h, sm, k, clusters, modularity));
 }
 
+
+// k cliques of m vertices, consecutive cliques joined by a single weak edge
+template <typename index_type, typename value_type>
+struct clique_graph {
+  clique_graph(raft::resources const& h, index_type k, index_type m)
+    : n(k * m),
+      d_offsets(0, resource::get_cuda_stream(h)),
+      d_indices(0, resource::get_cuda_stream(h)),
+      d_weights(0, resource::get_cuda_stream(h)),
+      d_labels_ref(0, resource::get_cuda_stream(h))
+  {
+    auto stream = resource::get_cuda_stream(h);
+    std::vector<index_type> offsets{0};
+    std::vector<index_type> indices;
+    std::vector<value_type> weights;
+    std::vector<index_type> labels_ref(n);
+    for (index_type i = 0; i < n; ++i) {
+      index_type c  = i / m;
+      labels_ref[i] = c;
+      for (index_type j = c * m; j < (c + 1) * m; ++j) {
+        if (j == i) { continue; }
+        indices.push_back(j);
+        weights.push_back(1);
+      }
+      if (i % m == 0) {
+        indices.push_back((i + n - 1) % n);
+        weights.push_back(0.01);
+      }
+      if (i % m == m - 1) {
+        indices.push_back((i + 1) % n);
+        weights.push_back(0.01);
+      }
+      offsets.push_back(indices.size());
+    }
+    nnz = indices.size();
+
+    d_offsets.resize(n + 1, stream);
+    d_indices.resize(nnz, stream);
+    d_weights.resize(nnz, stream);
+    d_labels_ref.resize(n, stream);
+    raft::update_device(d_offsets.data(), offsets.data(), n + 1, stream);
+    raft::update_device(d_indices.data(), indices.data(), nnz, stream);
+    raft::update_device(d_weights.data(), weights.data(), nnz, stream);
+    raft::update_device(d_labels_ref.data(), labels_ref.data(), n, stream);
+  }
+
+  auto view()
+  {
+    auto structure =
+      raft::make_device_compressed_structure_view<index_type, index_type, index_type>(
+        d_offsets.data(), d_indices.data(), n, n, nnz);
+    return raft::make_device_csr_matrix_view<const value_type>(d_weights.data(), structure);
+  }
+
+  index_type n;
+  index_type nnz;
+  rmm::device_uvector<index_type> d_offsets;
+  rmm::device_uvector<index_type> d_indices;
+  rmm::device_uvector<value_type> d_weights;
+  rmm::device_uvector<index_type> d_labels_ref;
+};
+
+TEST(Raft, SpectralClustering)
+{
+  using index_type = int;
+  using value_type = float;
+
+  raft::resources h;
+  auto stream = resource::get_cuda_stream(h);
+
+  index_type k{4};
+  clique_graph<index_type, value_type> g(h, k, 25);
+  auto labels = raft::make_device_vector<index_type, index_type>(h, g.n);
+
+  spectral_clustering_params params;
+  params.n_clusters = k;
+  spectral_clustering(h, g.view(), params, labels.view());
+
+  auto score =
+    raft::stats::adjusted_rand_index(g.d_labels_ref.data(), labels.data_handle(), g.n, stream);
+  ASSERT_EQ(score, 1.0);
+}
+
+TEST(Raft, ModularityMaximizationGraph)
+{
+  using namespace matrix;
+  using index_type = int;
+  using value_type = double;
+
+  raft::resources h;
+  auto stream = resource::get_cuda_stream(h);
+
+  index_type k{4};
+  clique_graph<index_type, value_type> g(h, k, 25);
+  sparse_matrix_t<index_type, value_type> sm{
+    h, g.d_offsets.data(), g.d_indices.data(), g.d_weights.data(), g.n, g.nnz};
+
+  unsigned long long seed{100110021003};
+  eigen_solver_config_t<index_type, value_type> eig_cfg{k, 1000, 50, 1.0e-8, true, seed};
+  lanczos_solver_t<index_type, value_type> eig_solver{eig_cfg};
+  cluster_solver_config_t<index_type, value_type> clust_cfg{k, 100, 1.0e-8, seed};
+  kmeans_solver_t<index_type, value_type> cluster_solver{clust_cfg};
+
+  // the legacy path, which overwrites the eigenvectors with the embedding
+  rmm::device_uvector<index_type> clusters_ref(g.n, stream);
+  rmm::device_uvector<value_type> eigvals_ref(k, stream);
+  rmm::device_uvector<value_type> eigvecs_ref(g.n * k, stream);
+  modularity_maximization(h,
+                          sm,
+                          eig_solver,
+                          cluster_solver,
+                          clusters_ref.data(),
+                          eigvals_ref.data(),
+                          eigvecs_ref.data());
+
+  auto clusters = raft::make_device_vector<index_type, index_type>(h, g.n);
+  auto eigvals  = raft::make_device_vector<value_type, index_type>(h, k);
+  auto eigvecs  = raft::make_device_matrix<value_type, index_type, raft::col_major>(h, g.n, k);
+  modularity_maximization(
+    h, g.view(), eig_solver, cluster_solver, clusters.view(), eigvals.view(), eigvecs.view());
+
+  ASSERT_TRUE(raft::devArrMatch(
+    eigvals_ref.data(), eigvals.data_handle(), k, raft::CompareApprox<value_type>(1e-6), stream));
+  auto score =
+    raft::stats::adjusted_rand_index(clusters_ref.data(), clusters.data_handle(), g.n, stream);
+  ASSERT_EQ(score, 1.0);
+
+  value_type modularity_ref{0};
+  value_type modularity{0};
+  analyzeModularity(h, sm, k, clusters_ref.data(), modularity_ref);
+  analyzeModularity(h, g.view(), k, raft::make_const_mdspan(clusters.view()), modularity);
+  ASSERT_NEAR(modularity, modularity_ref, 1e-6);
+  ASSERT_GT(modularity, 0.5);
+
+  // the cliques are the partition of the least cut
+  auto partition_labels = raft::make_device_vector<index_type, index_type>(h, g.n);
+  eigen_solver_config_t<index_type, value_type> part_eig_cfg{k, 1000, 50, 1.0e-8, true, seed};
+  lanczos_solver_t<index_type, value_type> part_eig_solver{part_eig_cfg};
+  partition(h,
+            g.view(),
+            part_eig_solver,
+            cluster_solver,
+            partition_labels.view(),
+            eigvals.view(),
+            eigvecs.view());
+  value_type edge_cut{0};
+  value_type cost{0};
+  analyzePartition(
+    h, g.view(), k, raft::make_const_mdspan(partition_labels.view()), edge_cut, cost);
+  ASSERT_NEAR(edge_cut, k * 0.01, 1e-6);
+}
+
 }  // namespace spectral
 }  // namespace raft
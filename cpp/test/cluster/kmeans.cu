@@ -22,6 +22,8 @@
 
 #include <raft/cluster/kmeans.cuh>
 #include <raft/core/cudart_utils.hpp>
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/host_mdarray.hpp>
 #include <raft/core/operators.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/random/make_blobs.cuh>
@@ -356,4 +358,463 @@ INSTANTIATE_TEST_CASE_P(KmeansTests, KmeansTestF, ::testing::ValuesIn(inputsf2))
 
 INSTANTIATE_TEST_CASE_P(KmeansTests, KmeansTestD, ::testing::ValuesIn(inputsd2));
 
+// the same fit as KmeansTest, seeded with the batched k-means++
+template <typename T>
+class KmeansBatchedInitTest : public KmeansTest<T> {
+ protected:
+  void SetUp() override
+  {
+    this->params.init_batch_size = 8;
+    this->basicTest();
+  }
+};
+
+typedef KmeansBatchedInitTest<float> KmeansBatchedInitTestF;
+TEST_P(KmeansBatchedInitTestF, Result) { ASSERT_TRUE(this->score == 1.0); }
+
+INSTANTIATE_TEST_CASE_P(KmeansTests, KmeansBatchedInitTestF, ::testing::ValuesIn(inputsf2));
+
+template <typename T>
+class KmeansBoundsTest : public ::testing::TestWithParam<KmeansInputs<T>> {
+ protected:
+  void SetUp() override
+  {
+    auto testparams = ::testing::TestWithParam<KmeansInputs<T>>::GetParam();
+    auto stream     = resource::get_cuda_stream(handle);
+    int n_samples   = testparams.n_row;
+    int n_features  = testparams.n_col;
+
+    raft::cluster::KMeansParams params;
+    params.n_clusters     = testparams.n_clusters;
+    params.tol            = testparams.tol;
+    params.init           = raft::cluster::KMeansParams::InitMethod::Random;
+    params.rng_state.seed = 1;
+
+    auto X      = raft::make_device_matrix<T, int>(handle, n_samples, n_features);
+    auto labels = raft::make_device_vector<int, int>(handle, n_samples);
+    raft::random::make_blobs<T, int>(X.data_handle(),
+                                     labels.data_handle(),
+                                     n_samples,
+                                     n_features,
+                                     params.n_clusters,
+                                     stream,
+                                     true,
+                                     nullptr,
+                                     nullptr,
+                                     T(1.0),
+                                     false,
+                                     (T)-10.0f,
+                                     (T)10.0f,
+                                     (uint64_t)1234);
+
+    auto centroids_ref = raft::make_device_matrix<T, int>(handle, params.n_clusters, n_features);
+    auto centroids     = raft::make_device_matrix<T, int>(handle, params.n_clusters, n_features);
+    T inertia_ref      = 0;
+    T inertia          = 0;
+    int n_iter         = 0;
+    auto X_view        = raft::make_const_mdspan(X.view());
+
+    raft::cluster::kmeans::fit<T, int>(handle,
+                                       params,
+                                       X_view,
+                                       std::nullopt,
+                                       centroids_ref.view(),
+                                       raft::make_host_scalar_view<T>(&inertia_ref),
+                                       raft::make_host_scalar_view<int>(&n_iter));
+    // the pruning skips only the distances that do not change the assignments
+    params.bound_pruning = true;
+    raft::cluster::kmeans::fit<T, int>(handle,
+                                       params,
+                                       X_view,
+                                       std::nullopt,
+                                       centroids.view(),
+                                       raft::make_host_scalar_view<T>(&inertia),
+                                       raft::make_host_scalar_view<int>(&n_iter));
+    resource::sync_stream(handle, stream);
+
+    centroids_match = raft::devArrMatch(centroids_ref.data_handle(),
+                                        centroids.data_handle(),
+                                        centroids.size(),
+                                        raft::CompareApprox<T>(1e-3),
+                                        stream);
+    inertia_match   = raft::match(inertia_ref, inertia, raft::CompareApprox<T>(1e-3));
+  }
+
+ protected:
+  raft::resources handle;
+  testing::AssertionResult centroids_match = testing::AssertionSuccess();
+  testing::AssertionResult inertia_match   = testing::AssertionSuccess();
+};
+
+const std::vector<KmeansInputs<float>> inputs_bounds = {{1000, 32, 5, 0.0001f, false},
+                                                        {10000, 32, 10, 0.0001f, false},
+                                                        {10000, 100, 50, 0.0001f, false},
+                                                        {10000, 16, 500, 0.0001f, false}};
+
+typedef KmeansBoundsTest<float> KmeansBoundsTestF;
+TEST_P(KmeansBoundsTestF, Result)
+{
+  ASSERT_TRUE(centroids_match);
+  ASSERT_TRUE(inertia_match);
+}
+
+INSTANTIATE_TEST_CASE_P(KmeansTests, KmeansBoundsTestF, ::testing::ValuesIn(inputs_bounds));
+
+struct KmeansPredictorInputs {
+  int n_row;
+  int n_col;
+  int n_clusters;
+  int batch_size;
+  raft::distance::DistanceType metric;
+  bool use_cuda_graph;
+};
+
+template <typename T>
+class KmeansPredictorTest : public ::testing::TestWithParam<KmeansPredictorInputs> {
+ protected:
+  void SetUp() override
+  {
+    auto testparams = ::testing::TestWithParam<KmeansPredictorInputs>::GetParam();
+    auto stream     = resource::get_cuda_stream(handle);
+    int n_samples   = testparams.n_row;
+    int n_features  = testparams.n_col;
+
+    raft::cluster::KMeansParams params;
+    params.n_clusters     = testparams.n_clusters;
+    params.metric         = testparams.metric;
+    params.rng_state.seed = 1;
+
+    auto X      = raft::make_device_matrix<T, int>(handle, n_samples, n_features);
+    auto labels = raft::make_device_vector<int, int>(handle, n_samples);
+    raft::random::make_blobs<T, int>(X.data_handle(),
+                                     labels.data_handle(),
+                                     n_samples,
+                                     n_features,
+                                     params.n_clusters,
+                                     stream,
+                                     true,
+                                     nullptr,
+                                     nullptr,
+                                     T(1.0),
+                                     false,
+                                     (T)-10.0f,
+                                     (T)10.0f,
+                                     (uint64_t)1234);
+
+    // any set of centroids will do, take the first samples
+    auto centroids = raft::make_device_matrix_view<const T, int>(
+      X.data_handle(), params.n_clusters, n_features);
+    auto labels_ref = raft::make_device_vector<int, int>(handle, n_samples);
+    T inertia       = 0;
+    raft::cluster::kmeans::predict<T, int>(handle,
+                                           params,
+                                           raft::make_const_mdspan(X.view()),
+                                           std::nullopt,
+                                           centroids,
+                                           labels_ref.view(),
+                                           false,
+                                           raft::make_host_scalar_view<T>(&inertia));
+
+    raft::cluster::kmeans::predictor<T, int> pred(
+      handle, params, centroids, testparams.batch_size, testparams.use_cuda_graph);
+    // the same batch buffers are reused to exercise the replays of the graph
+    auto batch        = raft::make_device_matrix<T, int>(handle, testparams.batch_size, n_features);
+    auto batch_labels = raft::make_device_vector<int, int>(handle, testparams.batch_size);
+    for (int offset = 0; offset < n_samples; offset += testparams.batch_size) {
+      int n_batch = std::min(testparams.batch_size, n_samples - offset);
+      raft::copy(batch.data_handle(),
+                 X.data_handle() + size_t(offset) * n_features,
+                 size_t(n_batch) * n_features,
+                 stream);
+      pred.predict(
+        handle,
+        raft::make_device_matrix_view<const T, int>(batch.data_handle(), n_batch, n_features),
+        raft::make_device_vector_view<int, int>(batch_labels.data_handle(), n_batch));
+      raft::copy(labels.data_handle() + offset, batch_labels.data_handle(), n_batch, stream);
+    }
+    resource::sync_stream(handle, stream);
+
+    labels_match = raft::devArrMatch(labels_ref.data_handle(),
+                                     labels.data_handle(),
+                                     n_samples,
+                                     raft::Compare<int>(),
+                                     stream);
+  }
+
+ protected:
+  raft::resources handle;
+  testing::AssertionResult labels_match = testing::AssertionSuccess();
+};
+
+const std::vector<KmeansPredictorInputs> inputs_predictor = {
+  {1000, 32, 5, 256, raft::distance::DistanceType::L2Expanded, false},
+  {1000, 32, 5, 256, raft::distance::DistanceType::L2Expanded, true},
+  {10000, 100, 50, 1024, raft::distance::DistanceType::L2SqrtExpanded, true},
+  {10000, 16, 500, 3000, raft::distance::DistanceType::L2Expanded, true},
+  {10000, 32, 10, 1024, raft::distance::DistanceType::L1, false}};
+
+typedef KmeansPredictorTest<float> KmeansPredictorTestF;
+TEST_P(KmeansPredictorTestF, Result) { ASSERT_TRUE(labels_match); }
+
+INSTANTIATE_TEST_CASE_P(KmeansTests, KmeansPredictorTestF, ::testing::ValuesIn(inputs_predictor));
+
+struct KmeansMiniBatchInputs {
+  int n_row;
+  int n_col;
+  int n_clusters;
+  int64_t minibatch_size;
+};
+
+template <typename T>
+class KmeansMiniBatchTest : public ::testing::TestWithParam<KmeansMiniBatchInputs> {
+ protected:
+  void SetUp() override
+  {
+    auto testparams = ::testing::TestWithParam<KmeansMiniBatchInputs>::GetParam();
+    auto stream     = resource::get_cuda_stream(handle);
+    int n_samples   = testparams.n_row;
+    int n_features  = testparams.n_col;
+
+    raft::cluster::KMeansMiniBatchParams params;
+    params.n_clusters          = testparams.n_clusters;
+    params.minibatch_size      = testparams.minibatch_size;
+    params.max_iter            = 20;
+    params.tol                 = 1e-4;
+    params.rng_state.seed      = 1;
+    params.oversampling_factor = 0;
+
+    auto X         = raft::make_device_matrix<T, int>(handle, n_samples, n_features);
+    auto labels    = raft::make_device_vector<int, int>(handle, n_samples);
+    auto pred      = raft::make_device_vector<int, int>(handle, n_samples);
+    auto centroids = raft::make_device_matrix<T, int>(handle, params.n_clusters, n_features);
+    auto X_host    = raft::make_host_matrix<T, int>(n_samples, n_features);
+
+    raft::random::make_blobs<T, int>(X.data_handle(),
+                                     labels.data_handle(),
+                                     n_samples,
+                                     n_features,
+                                     params.n_clusters,
+                                     stream,
+                                     true,
+                                     nullptr,
+                                     nullptr,
+                                     T(1.0),
+                                     true,
+                                     (T)-10.0f,
+                                     (T)10.0f,
+                                     (uint64_t)1234);
+    raft::copy(X_host.data_handle(), X.data_handle(), X.size(), stream);
+    resource::sync_stream(handle, stream);
+
+    T inertia  = 0;
+    int n_iter = 0;
+    raft::cluster::kmeans::fit_minibatch<T, int>(handle,
+                                                 params,
+                                                 raft::make_const_mdspan(X_host.view()),
+                                                 centroids.view(),
+                                                 raft::make_host_scalar_view<T>(&inertia),
+                                                 raft::make_host_scalar_view<int>(&n_iter));
+    ASSERT_GT(n_iter, 0);
+    ASSERT_LE(n_iter, params.max_iter);
+
+    T predict_inertia = 0;
+    raft::cluster::kmeans::predict<T, int>(handle,
+                                           params,
+                                           raft::make_const_mdspan(X.view()),
+                                           std::nullopt,
+                                           raft::make_const_mdspan(centroids.view()),
+                                           pred.view(),
+                                           false,
+                                           raft::make_host_scalar_view<T>(&predict_inertia));
+    // the inertia of the fit is the one of the final centroids
+    ASSERT_TRUE(raft::match(predict_inertia, inertia, raft::CompareApprox<T>(1e-2)));
+
+    score = raft::stats::adjusted_rand_index(
+      labels.data_handle(), pred.data_handle(), n_samples, stream);
+  }
+
+ protected:
+  raft::resources handle;
+  double score;
+};
+
+const std::vector<KmeansMiniBatchInputs> inputs_minibatch = {{10000, 32, 5, 2500},
+                                                             {10000, 32, 10, 1000},
+                                                             {10000, 100, 20, 10000},
+                                                             {100000, 16, 20, 16384}};
+
+typedef KmeansMiniBatchTest<float> KmeansMiniBatchTestF;
+TEST_P(KmeansMiniBatchTestF, Result) { ASSERT_GT(score, 0.9); }
+
+INSTANTIATE_TEST_CASE_P(KmeansTests,
+                        KmeansMiniBatchTestF,
+                        ::testing::ValuesIn(inputs_minibatch));
+
+struct KmeansSparseInputs {
+  int n_row;
+  int n_col;
+  int n_clusters;
+  int batch_samples;
+  raft::cluster::KMeansParams::InitMethod init;
+};
+
+template <typename T>
+class KmeansSparseTest : public ::testing::TestWithParam<KmeansSparseInputs> {
+ protected:
+  void SetUp() override
+  {
+    auto testparams = ::testing::TestWithParam<KmeansSparseInputs>::GetParam();
+    auto stream     = resource::get_cuda_stream(handle);
+    int n_samples   = testparams.n_row;
+    int n_features  = testparams.n_col;
+
+    raft::cluster::KMeansParams params;
+    params.n_clusters          = testparams.n_clusters;
+    params.batch_samples       = testparams.batch_samples;
+    params.init                = testparams.init;
+    params.max_iter            = 50;
+    params.tol                 = 1e-4;
+    params.rng_state.seed      = 1;
+    params.oversampling_factor = 0;
+
+    auto X         = raft::make_device_matrix<T, int>(handle, n_samples, n_features);
+    auto labels    = raft::make_device_vector<int, int>(handle, n_samples);
+    auto pred      = raft::make_device_vector<int, int>(handle, n_samples);
+    auto pred_ref  = raft::make_device_vector<int, int>(handle, n_samples);
+    auto centroids = raft::make_device_matrix<T, int>(handle, params.n_clusters, n_features);
+
+    raft::random::make_blobs<T, int>(X.data_handle(),
+                                     labels.data_handle(),
+                                     n_samples,
+                                     n_features,
+                                     params.n_clusters,
+                                     stream,
+                                     true,
+                                     nullptr,
+                                     nullptr,
+                                     T(1.0),
+                                     true,
+                                     (T)-10.0f,
+                                     (T)10.0f,
+                                     (uint64_t)1234);
+
+    // Drop the negative coordinates to make the data sparse (about half of the entries)
+    std::vector<T> X_host(X.size());
+    raft::update_host(X_host.data(), X.data_handle(), X.size(), stream);
+    resource::sync_stream(handle, stream);
+    std::vector<int> indptr{0};
+    std::vector<int> indices;
+    std::vector<T> values;
+    for (int i = 0; i < n_samples; i++) {
+      for (int j = 0; j < n_features; j++) {
+        T& x = X_host[size_t(i) * n_features + j];
+        if (x > T(0)) {
+          indices.push_back(j);
+          values.push_back(x);
+        } else {
+          x = T(0);
+        }
+      }
+      indptr.push_back(indices.size());
+    }
+    const int nnz = values.size();
+    rmm::device_uvector<int> d_indptr(indptr.size(), stream);
+    rmm::device_uvector<int> d_indices(nnz, stream);
+    rmm::device_uvector<T> d_values(nnz, stream);
+    raft::update_device(d_indptr.data(), indptr.data(), indptr.size(), stream);
+    raft::update_device(d_indices.data(), indices.data(), nnz, stream);
+    raft::update_device(d_values.data(), values.data(), nnz, stream);
+    raft::update_device(X.data_handle(), X_host.data(), X.size(), stream);
+    auto X_csr = raft::make_device_csr_matrix_view<const T, int, int, int>(
+      d_values.data(),
+      raft::make_device_compressed_structure_view<int, int, int>(
+        d_indptr.data(), d_indices.data(), n_samples, n_features, nnz));
+
+    if (params.init == raft::cluster::KMeansParams::InitMethod::Array) {
+      raft::copy(centroids.data_handle(), X.data_handle(), centroids.size(), stream);
+    }
+
+    T inertia  = 0;
+    int n_iter = 0;
+    raft::cluster::kmeans::fit<T, int, int>(handle,
+                                            params,
+                                            X_csr,
+                                            std::nullopt,
+                                            centroids.view(),
+                                            raft::make_host_scalar_view<T>(&inertia),
+                                            raft::make_host_scalar_view<int>(&n_iter));
+    ASSERT_GT(n_iter, 0);
+    ASSERT_LE(n_iter, params.max_iter);
+
+    T predict_inertia = 0;
+    raft::cluster::kmeans::predict<T, int, int>(handle,
+                                                params,
+                                                X_csr,
+                                                std::nullopt,
+                                                raft::make_const_mdspan(centroids.view()),
+                                                pred.view(),
+                                                false,
+                                                raft::make_host_scalar_view<T>(&predict_inertia));
+    ASSERT_TRUE(raft::match(predict_inertia, inertia, raft::CompareApprox<T>(1e-3)));
+
+    // The dense predict on the densified data agrees with the sparse one
+    T ref_inertia = 0;
+    raft::cluster::kmeans::predict<T, int>(handle,
+                                           params,
+                                           raft::make_const_mdspan(X.view()),
+                                           std::nullopt,
+                                           raft::make_const_mdspan(centroids.view()),
+                                           pred_ref.view(),
+                                           false,
+                                           raft::make_host_scalar_view<T>(&ref_inertia));
+    ASSERT_TRUE(raft::match(ref_inertia, inertia, raft::CompareApprox<T>(1e-2)));
+    ref_score = raft::stats::adjusted_rand_index(
+      pred_ref.data_handle(), pred.data_handle(), n_samples, stream);
+
+    score = raft::stats::adjusted_rand_index(
+      labels.data_handle(), pred.data_handle(), n_samples, stream);
+  }
+
+ protected:
+  raft::resources handle;
+  double score;
+  double ref_score;
+};
+
+const std::vector<KmeansSparseInputs> inputs_sparse = {
+  {1000, 20, 5, 1 << 15, raft::cluster::KMeansParams::InitMethod::KMeansPlusPlus},
+  {10000, 64, 10, 1 << 15, raft::cluster::KMeansParams::InitMethod::KMeansPlusPlus},
+  {10000, 64, 10, 999, raft::cluster::KMeansParams::InitMethod::KMeansPlusPlus},
+  {10000, 100, 20, 4096, raft::cluster::KMeansParams::InitMethod::Random},
+  {5000, 32, 8, 1000, raft::cluster::KMeansParams::InitMethod::Array}};
+
+typedef KmeansSparseTest<float> KmeansSparseTestF;
+TEST_P(KmeansSparseTestF, Result)
+{
+  ASSERT_GT(ref_score, 0.99);
+  // the initialization from the first rows may merge a pair of the clusters
+  ASSERT_GT(score, 0.8);
+}
+
+INSTANTIATE_TEST_CASE_P(KmeansTests, KmeansSparseTestF, ::testing::ValuesIn(inputs_sparse));
+
+TEST(KmeansEstimate, FitMemory)
+{
+  raft::cluster::KMeansParams params;
+  params.n_clusters = 100;
+  auto small        = raft::cluster::kmeans::estimate_fit_memory<float, int>(params, 10000, 32);
+  auto large        = raft::cluster::kmeans::estimate_fit_memory<float, int>(params, 100000, 32);
+  // the weights, the norms and the nearest centroids of all the samples are kept on the device
+  ASSERT_GE(small.device_workspace,
+            size_t(10000) * (2 * sizeof(float) + sizeof(raft::KeyValuePair<int, float>)));
+  ASSERT_GT(large.device_workspace, small.device_workspace);
+  ASSERT_EQ(large.device_result, 0);
+  ASSERT_EQ(large.host_peak(), 0);
+
+  // the bounds of the pruning are extra buffers of the iterations
+  params.bound_pruning = true;
+  auto pruned          = raft::cluster::kmeans::estimate_fit_memory<float, int>(params, 100000, 32);
+  ASSERT_GT(pruned.device_workspace, large.device_workspace);
+}
+
 }  // namespace raft
@@ -31,6 +31,8 @@
 #include <rmm/device_uvector.hpp>
 #include <thrust/fill.h>
 
+#include <cuda_fp16.h>
+
 /* This test takes advantage of the fact that make_blobs generates balanced clusters.
  * It doesn't currently test whether the algorithm can make balanced clusters with an imbalanced
  * dataset.
@@ -100,7 +102,10 @@ class KmeansBalancedTest : public ::testing::TestWithParam<KmeansBalancedInputs<
                                           (uint64_t)1234);
 
     // Convert blobs dataset to DataT if necessary
-    if constexpr (!std::is_same_v<DataT, MathT>) {
+    if constexpr (std::is_same_v<DataT, half>) {
+      raft::linalg::unaryOp(
+        X.data_handle(), blobs.data(), p.n_rows * p.n_cols, raft::cast_op<half>(), stream);
+    } else if constexpr (!std::is_same_v<DataT, MathT>) {
       raft::linalg::unaryOp(
         X.data_handle(), blobs.data(), p.n_rows * p.n_cols, op.reverse_op, stream);
     }
@@ -168,6 +173,16 @@ std::vector<KmeansBalancedInputs<MathT, IdxT>> get_kmeans_balanced_inputs()
     p.n_clusters = static_cast<IdxT>(std::get<2>(rck));
     out.push_back(p);
   }
+  // deeper hierarchies with a capped per-cluster trainset
+  p.kb_params.hierarchy_depth              = 3;
+  p.kb_params.max_train_points_per_cluster = 256;
+  for (auto& rck : std::vector<std::tuple<size_t, size_t, size_t>>{{10000, 32, 27},
+                                                                   {10000, 100, 64}}) {
+    p.n_rows     = static_cast<IdxT>(std::get<0>(rck));
+    p.n_cols     = static_cast<IdxT>(std::get<1>(rck));
+    p.n_clusters = static_cast<IdxT>(std::get<2>(rck));
+    out.push_back(p);
+  }
   return out;
 }
 
@@ -233,4 +248,15 @@ KB_TEST((KmeansBalancedTest<int8_t, double, uint32_t, int, i2f_scaler<int8_t, do
         KmeansBalancedTestDI8U32I32,
         inputsd_i32);
 
+/*
+ * Third set of tests: fp16 dataset with fp32 centers (assigned with the fp16 GEMM)
+ */
+
+KB_TEST((KmeansBalancedTest<half, float, uint32_t, int, raft::cast_op<float>>),
+        KmeansBalancedTestFHU32I32,
+        inputsf_i32);
+KB_TEST((KmeansBalancedTest<half, float, uint32_t, int64_t, raft::cast_op<float>>),
+        KmeansBalancedTestFHU32I64,
+        inputsf_i64);
+
 }  // namespace raft
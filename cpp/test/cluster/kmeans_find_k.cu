@@ -18,6 +18,7 @@
 #include <gtest/gtest.h>
 #include <optional>
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/cuda_stream_pool.hpp>
 #include <vector>
 
 #include <raft/cluster/kmeans.cuh>
@@ -133,8 +134,27 @@ TEST_P(KmeansFindKTestD, Result)
   ASSERT_TRUE(best_k.view()[0] == testparams.n_clusters);
 }
 
+template <typename T>
+class KmeansFindKPoolTest : public KmeansFindKTest<T> {
+ protected:
+  void SetUp() override
+  {
+    // the candidates are fitted concurrently on the streams of the pool
+    resource::set_cuda_stream_pool(this->handle, std::make_shared<rmm::cuda_stream_pool>(4));
+    this->basicTest();
+  }
+};
+
+typedef KmeansFindKPoolTest<float> KmeansFindKPoolTestF;
+TEST_P(KmeansFindKPoolTestF, Result)
+{
+  ASSERT_TRUE(this->best_k.view()[0] == this->testparams.n_clusters);
+}
+
 INSTANTIATE_TEST_CASE_P(KmeansFindKTests, KmeansFindKTestF, ::testing::ValuesIn(inputsf2));
 
+INSTANTIATE_TEST_CASE_P(KmeansFindKTests, KmeansFindKPoolTestF, ::testing::ValuesIn(inputsf2));
+
 INSTANTIATE_TEST_CASE_P(KmeansFindKTests, KmeansFindKTestD, ::testing::ValuesIn(inputsd2));
 
 }  // namespace raft
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+
+#include <raft_internal/comms/single_rank_comms.hpp>
+
+#include <raft/cluster/kmeans.cuh>
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/random/make_blobs.cuh>
+#include <raft/stats/adjusted_rand_index.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <optional>
+#include <vector>
+
+namespace raft {
+
+struct KmeansMgInputs {
+  int n_row;
+  int n_col;
+  int n_clusters;
+  bool weighted;
+};
+
+inline auto operator<<(std::ostream& os, const KmeansMgInputs& p) -> std::ostream&
+{
+  os << "{n_row=" << p.n_row << ", n_col=" << p.n_col << ", n_clusters=" << p.n_clusters
+     << (p.weighted ? ", weighted" : "") << "}";
+  return os;
+}
+
+/**
+ * kmeans::fit_mg over a single-rank communicator: seeded with the same centroids, it must find the
+ * centroids and the inertia of kmeans::fit; seeded with the distributed k-means++, it must recover
+ * the blobs.
+ */
+template <typename T>
+class KmeansMgTest : public ::testing::TestWithParam<KmeansMgInputs> {
+ protected:
+  KmeansMgTest()
+    : ps(::testing::TestWithParam<KmeansMgInputs>::GetParam()),
+      stream(resource::get_cuda_stream(handle)),
+      X(raft::make_device_matrix<T, int>(handle, ps.n_row, ps.n_col)),
+      labels_ref(raft::make_device_vector<int, int>(handle, ps.n_row)),
+      weights(raft::make_device_vector<T, int>(handle, ps.weighted ? ps.n_row : 0))
+  {
+    comms::initialize_single_rank_comms(&handle);
+    raft::random::make_blobs<T, int>(X.data_handle(),
+                                     labels_ref.data_handle(),
+                                     ps.n_row,
+                                     ps.n_col,
+                                     ps.n_clusters,
+                                     stream,
+                                     true,
+                                     nullptr,
+                                     nullptr,
+                                     T(1.0),
+                                     false,
+                                     T(-10.0),
+                                     T(10.0),
+                                     uint64_t(1234));
+    if (ps.weighted) {
+      // The weights 1, 2, 3, 1, 2, 3, ...
+      std::vector<T> weights_h(ps.n_row);
+      for (int i = 0; i < ps.n_row; i++) {
+        weights_h[i] = T(1 + i % 3);
+      }
+      raft::update_device(weights.data_handle(), weights_h.data(), ps.n_row, stream);
+      resource::sync_stream(handle, stream);
+    }
+  }
+
+  auto sample_weight() -> std::optional<raft::device_vector_view<const T, int>>
+  {
+    if (!ps.weighted) { return std::nullopt; }
+    return raft::make_const_mdspan(weights.view());
+  }
+
+  void testSameInit()
+  {
+    cluster::KMeansParams params;
+    params.n_clusters = ps.n_clusters;
+    params.init       = cluster::KMeansParams::InitMethod::Array;
+    params.n_init     = 1;
+    params.tol        = 1e-6;
+    params.max_iter   = 100;
+
+    // Seed both with the first rows of the dataset
+    auto centroids    = raft::make_device_matrix<T, int>(handle, ps.n_clusters, ps.n_col);
+    auto centroids_mg = raft::make_device_matrix<T, int>(handle, ps.n_clusters, ps.n_col);
+    raft::copy(centroids.data_handle(), X.data_handle(), centroids.size(), stream);
+    raft::copy(centroids_mg.data_handle(), X.data_handle(), centroids_mg.size(), stream);
+
+    T inertia     = 0;
+    T inertia_mg  = 0;
+    int n_iter    = 0;
+    int n_iter_mg = 0;
+    cluster::kmeans::fit<T, int>(handle,
+                                 params,
+                                 raft::make_const_mdspan(X.view()),
+                                 sample_weight(),
+                                 centroids.view(),
+                                 raft::make_host_scalar_view(&inertia),
+                                 raft::make_host_scalar_view(&n_iter));
+    cluster::kmeans::fit_mg<T, int>(handle,
+                                    params,
+                                    raft::make_const_mdspan(X.view()),
+                                    sample_weight(),
+                                    centroids_mg.view(),
+                                    raft::make_host_scalar_view(&inertia_mg),
+                                    raft::make_host_scalar_view(&n_iter_mg));
+    resource::sync_stream(handle, stream);
+
+    ASSERT_TRUE(devArrMatch(centroids.data_handle(),
+                            centroids_mg.data_handle(),
+                            centroids.size(),
+                            CompareApprox<T>(1e-3),
+                            stream));
+    ASSERT_NEAR(inertia_mg, inertia, 1e-3 * std::abs(inertia));
+  }
+
+  void testKMeansPlusPlus()
+  {
+    cluster::KMeansParams params;
+    params.n_clusters     = ps.n_clusters;
+    params.init           = cluster::KMeansParams::InitMethod::KMeansPlusPlus;
+    params.n_init         = 5;
+    params.tol            = 1e-4;
+    params.rng_state.seed = 1;
+
+    auto centroids = raft::make_device_matrix<T, int>(handle, ps.n_clusters, ps.n_col);
+    auto labels    = raft::make_device_vector<int, int>(handle, ps.n_row);
+    T inertia      = 0;
+    int n_iter     = 0;
+    cluster::kmeans::fit_mg<T, int>(handle,
+                                    params,
+                                    raft::make_const_mdspan(X.view()),
+                                    sample_weight(),
+                                    centroids.view(),
+                                    raft::make_host_scalar_view(&inertia),
+                                    raft::make_host_scalar_view(&n_iter));
+    cluster::kmeans::predict<T, int>(handle,
+                                     params,
+                                     raft::make_const_mdspan(X.view()),
+                                     sample_weight(),
+                                     raft::make_const_mdspan(centroids.view()),
+                                     labels.view(),
+                                     false,
+                                     raft::make_host_scalar_view(&inertia));
+    const double score = raft::stats::adjusted_rand_index(
+      labels_ref.data_handle(), labels.data_handle(), ps.n_row, stream);
+    ASSERT_EQ(score, 1.0) << "n_iter = " << n_iter;
+  }
+
+  raft::resources handle;
+  KmeansMgInputs ps;
+  cudaStream_t stream;
+  raft::device_matrix<T, int> X;
+  raft::device_vector<int, int> labels_ref;
+  raft::device_vector<T, int> weights;
+};
+
+const std::vector<KmeansMgInputs> kmeans_mg_inputs = {
+  {1000, 32, 5, false}, {1000, 100, 20, true}, {10000, 32, 10, false}, {10000, 100, 50, true}};
+
+using KmeansMgTestF = KmeansMgTest<float>;
+TEST_P(KmeansMgTestF, SameInit) { testSameInit(); }
+TEST_P(KmeansMgTestF, KMeansPlusPlus) { testKMeansPlusPlus(); }
+INSTANTIATE_TEST_CASE_P(KmeansMgTests, KmeansMgTestF, ::testing::ValuesIn(kmeans_mg_inputs));
+
+using KmeansMgTestD = KmeansMgTest<double>;
+TEST_P(KmeansMgTestD, SameInit) { testSameInit(); }
+TEST_P(KmeansMgTestD, KMeansPlusPlus) { testKMeansPlusPlus(); }
+INSTANTIATE_TEST_CASE_P(KmeansMgTests, KmeansMgTestD, ::testing::ValuesIn(kmeans_mg_inputs));
+
+}  // namespace raft
@@ -30,6 +30,7 @@
 #include <raft/linalg/transpose.cuh>
 #include <raft/sparse/coo.hpp>
 
+#include <raft/cluster/detail/agglomerative.cuh>
 #include <raft/core/device_mdspan.hpp>
 #include <raft/sparse/hierarchy/single_linkage.cuh>
 #include <raft/util/cudart_utils.hpp>
@@ -38,6 +39,9 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <numeric>
+#include <random>
 #include <vector>
 
 namespace raft {
@@ -672,4 +676,89 @@ typedef LinkageTest<float, int> LinkageTestF_Int;
 TEST_P(LinkageTestF_Int, Result) { EXPECT_TRUE(score == 1.0); }
 
 INSTANTIATE_TEST_CASE_P(LinkageTest, LinkageTestF_Int, ::testing::ValuesIn(linkage_inputsf2));
+
+struct DendrogramInputs {
+  int n_leaves;
+  // a path with increasing weights, merged by the sequential fallback
+  bool chain;
+  uint64_t seed;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const DendrogramInputs& p)
+{
+  os << "{ " << p.n_leaves << ", " << p.chain << ", " << p.seed << " }";
+  return os;
+}
+
+/** The device dendrogram must match the host one on a sorted random spanning tree. */
+class DendrogramTest : public ::testing::TestWithParam<DendrogramInputs> {
+ protected:
+  void basicTest()
+  {
+    auto p      = ::testing::TestWithParam<DendrogramInputs>::GetParam();
+    auto stream = resource::get_cuda_stream(handle);
+    int n_edges = p.n_leaves - 1;
+
+    std::mt19937 gen(p.seed);
+    std::vector<int> order(n_edges);
+    std::iota(order.begin(), order.end(), 0);
+    if (!p.chain) { std::shuffle(order.begin(), order.end(), gen); }
+    std::vector<int> rows_h(n_edges);
+    std::vector<int> cols_h(n_edges);
+    std::vector<float> data_h(n_edges);
+    for (int i = 0; i < n_edges; i++) {
+      // edge `order[i]` attaches the vertex i + 1 to the tree
+      int parent       = p.chain ? i : std::uniform_int_distribution<int>(0, i)(gen);
+      rows_h[order[i]] = parent;
+      cols_h[order[i]] = i + 1;
+      data_h[order[i]] = static_cast<float>(order[i]);
+    }
+
+    rmm::device_uvector<int> rows(n_edges, stream);
+    rmm::device_uvector<int> cols(n_edges, stream);
+    rmm::device_uvector<float> data(n_edges, stream);
+    raft::update_device(rows.data(), rows_h.data(), n_edges, stream);
+    raft::update_device(cols.data(), cols_h.data(), n_edges, stream);
+    raft::update_device(data.data(), data_h.data(), n_edges, stream);
+
+    rmm::device_uvector<int> children_ref(n_edges * 2, stream);
+    rmm::device_uvector<float> delta_ref(n_edges, stream);
+    rmm::device_uvector<int> size_ref(n_edges, stream);
+    raft::cluster::detail::build_dendrogram_host(handle,
+                                                 rows.data(),
+                                                 cols.data(),
+                                                 data.data(),
+                                                 n_edges,
+                                                 children_ref.data(),
+                                                 delta_ref.data(),
+                                                 size_ref.data());
+
+    rmm::device_uvector<int> children(n_edges * 2, stream);
+    rmm::device_uvector<float> delta(n_edges, stream);
+    rmm::device_uvector<int> size(n_edges, stream);
+    raft::cluster::detail::build_dendrogram_device(handle,
+                                                   rows.data(),
+                                                   cols.data(),
+                                                   data.data(),
+                                                   n_edges,
+                                                   children.data(),
+                                                   delta.data(),
+                                                   size.data());
+
+    ASSERT_TRUE(devArrMatch(
+      children_ref.data(), children.data(), n_edges * 2, raft::Compare<int>(), stream));
+    ASSERT_TRUE(devArrMatch(size_ref.data(), size.data(), n_edges, raft::Compare<int>(), stream));
+    ASSERT_TRUE(
+      devArrMatch(delta_ref.data(), delta.data(), n_edges, raft::Compare<float>(), stream));
+  }
+
+  raft::resources handle;
+};
+
+const std::vector<DendrogramInputs> dendrogram_inputs = {
+  {2, false, 1}, {100, false, 2}, {10000, false, 3}, {100000, false, 4}, {1000, true, 5}};
+
+TEST_P(DendrogramTest, Result) { basicTest(); }
+
+INSTANTIATE_TEST_CASE_P(DendrogramTest, DendrogramTest, ::testing::ValuesIn(dendrogram_inputs));
 }  // end namespace raft
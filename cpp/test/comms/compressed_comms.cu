@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <raft_internal/comms/single_rank_comms.hpp>
+
+#include <raft/comms/compressed_comms.cuh>
+#include <raft/core/resource/comms.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <cuda_bf16.h>
+#include <cuda_fp16.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace raft::comms {
+
+inline auto operator<<(std::ostream& os, const compression_t& c) -> std::ostream&
+{
+  switch (c) {
+    case compression_t::FP16: return os << "FP16";
+    case compression_t::BF16: return os << "BF16";
+    default: return os << "NONE";
+  }
+}
+
+/**
+ * The compressed collectives over a single-rank communicator still encode and decode the values,
+ * which must then be the values rounded to the encoding, within its relative precision.
+ */
+class CompressedCommsTest : public ::testing::TestWithParam<compression_t> {
+ protected:
+  static constexpr size_t kCount = 10000;
+
+  CompressedCommsTest()
+    : compression(GetParam()), stream(resource::get_cuda_stream(handle)), values(kCount)
+  {
+    initialize_single_rank_comms(&handle);
+    // values of all the magnitudes the fp16 encoding holds, subnormals included
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> exponent(-20.0f, 15.0f);
+    std::uniform_real_distribution<float> mantissa(-1.0f, 1.0f);
+    for (auto& v : values) {
+      v = mantissa(rng) * std::exp2(exponent(rng));
+    }
+  }
+
+  /** The value on the host after the round trip through the encoding. */
+  auto round_trip(float x) const -> float
+  {
+    switch (compression) {
+      case compression_t::FP16: return __half2float(__float2half_rn(x));
+      case compression_t::BF16: return __bfloat162float(__float2bfloat16_rn(x));
+      default: return x;
+    }
+  }
+
+  /** `x` received as `y`: the encoding rounds to the nearest. */
+  void check(const std::vector<float>& x, const std::vector<float>& y) const
+  {
+    ASSERT_EQ(x.size(), y.size());
+    // half an ulp of the mantissa, and of the smallest subnormal of fp16
+    float rel_error = 0;
+    float abs_error = 0;
+    switch (compression) {
+      case compression_t::FP16:
+        rel_error = std::exp2(-11.0f);
+        abs_error = std::exp2(-25.0f);
+        break;
+      case compression_t::BF16: rel_error = std::exp2(-8.0f); break;
+      default: break;
+    }
+    for (size_t i = 0; i < x.size(); i++) {
+      ASSERT_EQ(y[i], round_trip(x[i])) << "at " << i;
+      ASSERT_LE(std::abs(y[i] - x[i]), std::abs(x[i]) * rel_error + abs_error) << "at " << i;
+    }
+  }
+
+  raft::resources handle;
+  compression_t compression;
+  cudaStream_t stream;
+  std::vector<float> values;
+};
+
+TEST_P(CompressedCommsTest, Bcast)
+{
+  rmm::device_uvector<float> buff(kCount, stream);
+  raft::update_device(buff.data(), values.data(), kCount, stream);
+  bcast(resource::get_comms(handle), buff.data(), kCount, 0, compression, stream);
+  std::vector<float> received(kCount);
+  raft::update_host(received.data(), buff.data(), kCount, stream);
+  resource::sync_stream(handle, stream);
+  check(values, received);
+}
+
+TEST_P(CompressedCommsTest, Allgather)
+{
+  rmm::device_uvector<float> sendbuff(kCount, stream);
+  rmm::device_uvector<float> recvbuff(kCount, stream);
+  raft::update_device(sendbuff.data(), values.data(), kCount, stream);
+  allgather(
+    resource::get_comms(handle), sendbuff.data(), recvbuff.data(), kCount, compression, stream);
+  std::vector<float> received(kCount);
+  raft::update_host(received.data(), recvbuff.data(), kCount, stream);
+  resource::sync_stream(handle, stream);
+  check(values, received);
+}
+
+TEST_P(CompressedCommsTest, Allgatherv)
+{
+  // the values of the rank land at an offset of the receive buffer
+  size_t const displ = 7;
+  rmm::device_uvector<float> sendbuf(kCount, stream);
+  rmm::device_uvector<float> recvbuf(displ + kCount, stream);
+  raft::update_device(sendbuf.data(), values.data(), kCount, stream);
+  size_t recvcounts[] = {kCount};
+  size_t displs[]     = {displ};
+  allgatherv(resource::get_comms(handle),
+             sendbuf.data(),
+             recvbuf.data(),
+             recvcounts,
+             displs,
+             compression,
+             stream);
+  std::vector<float> received(kCount);
+  raft::update_host(received.data(), recvbuf.data() + displ, kCount, stream);
+  resource::sync_stream(handle, stream);
+  check(values, received);
+}
+
+INSTANTIATE_TEST_CASE_P(CompressedComms,
+                        CompressedCommsTest,
+                        ::testing::Values(compression_t::NONE,
+                                          compression_t::FP16,
+                                          compression_t::BF16));
+
+/**
+ * The delta encoding is lossless: with the differences on 32 bits, and with the fallback to the
+ * plain allgatherv when one of them does not fit.
+ */
+TEST(CompressedComms, AllgathervDelta)
+{
+  raft::resources handle;
+  initialize_single_rank_comms(&handle);
+  auto stream = resource::get_cuda_stream(handle);
+
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int64_t> step(-1000, 100000);
+  for (int64_t gap : {int64_t{0}, int64_t{std::numeric_limits<int32_t>::max()} + 1}) {
+    size_t const count = 5000;
+    size_t const displ = 3;
+    std::vector<int64_t> indices(count);
+    indices[0] = int64_t{1} << 40;
+    for (size_t i = 1; i < count; i++) {
+      indices[i] = indices[i - 1] + step(rng) + (i == count / 2 ? gap : 0);
+    }
+    rmm::device_uvector<int64_t> sendbuf(count, stream);
+    rmm::device_uvector<int64_t> recvbuf(displ + count, stream);
+    raft::update_device(sendbuf.data(), indices.data(), count, stream);
+    size_t recvcounts[] = {count};
+    size_t displs[]     = {displ};
+    allgatherv_delta(
+      resource::get_comms(handle), sendbuf.data(), recvbuf.data(), recvcounts, displs, stream);
+    std::vector<int64_t> received(count);
+    raft::update_host(received.data(), recvbuf.data() + displ, count, stream);
+    resource::sync_stream(handle, stream);
+    ASSERT_EQ(received, indices) << "gap = " << gap;
+  }
+}
+
+}  // namespace raft::comms
@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <raft_internal/comms/single_rank_comms.hpp>
+
+#include <raft/comms/detail/test.cuh>
+#include <raft/comms/hierarchical_comms.cuh>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+
+#include <gtest/gtest.h>
+
+namespace raft::comms {
+
+/**
+ * On a single rank, the hierarchical collectives fall back to the flat communicator, whichever way
+ * the ranks are grouped.
+ */
+TEST(HierarchicalComms, SingleRank)
+{
+  raft::resources handle;
+  initialize_single_rank_comms(&handle);
+
+  hierarchical_comms h_comm(resource::get_comms(handle), resource::get_cuda_stream(handle));
+  ASSERT_FALSE(h_comm.is_hierarchical());
+  ASSERT_EQ(h_comm.get_n_nodes(), 1);
+  ASSERT_EQ(h_comm.get_local_size(), 1);
+  ASSERT_EQ(h_comm.get_local_rank(), 0);
+  ASSERT_EQ(h_comm.get_node_rank(), 0);
+  ASSERT_THROW(h_comm.intra(), raft::logic_error);
+
+  ASSERT_TRUE(detail::test_hierarchical_comms(handle, 0));
+  ASSERT_TRUE(detail::test_hierarchical_comms(handle, 1));
+}
+
+}  // namespace raft::comms
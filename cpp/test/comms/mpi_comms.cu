@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <raft/comms/mpi_comms.hpp>
+#include <raft/core/error.hpp>
+
+#include <rmm/cuda_stream.hpp>
+
+#include <gtest/gtest.h>
+
+#include <mpi.h>
+
+#include <numeric>
+#include <vector>
+
+namespace raft::comms {
+
+/** Initializes MPI once for all the tests, which run on MPI_COMM_WORLD of a single process. */
+class MpiEnvironment : public ::testing::Environment {
+ public:
+  void SetUp() override
+  {
+    int provided = 0;
+    RAFT_MPI_TRY(MPI_Init_thread(nullptr, nullptr, MPI_THREAD_SINGLE, &provided));
+  }
+
+  void TearDown() override { RAFT_MPI_TRY(MPI_Finalize()); }
+};
+
+static auto* const mpi_environment = ::testing::AddGlobalTestEnvironment(new MpiEnvironment);
+
+/**
+ * The requests reach the MPI library directly, so these use host buffers and do not require a
+ * CUDA-aware MPI.
+ */
+class MpiCommsTest : public ::testing::Test {
+ protected:
+  MpiCommsTest() : comm(MPI_COMM_WORLD, false, stream.view())
+  {
+    int size = 0;
+    RAFT_MPI_TRY(MPI_Comm_size(MPI_COMM_WORLD, &size));
+    EXPECT_EQ(size, 1) << "the test runs on a single process";
+  }
+
+  rmm::cuda_stream stream;
+  mpi_comms comm;
+};
+
+TEST_F(MpiCommsTest, PersistentRequests)
+{
+  int const n_iters = 10;
+  int const count   = 100;
+  std::vector<int> sendbuf(count);
+  std::vector<int> recvbuf(count);
+
+  // a send to self and its receive, set up once and started at every iteration
+  request_t requests[2];
+  comm.send_init(sendbuf.data(), count * sizeof(int), 0, 7, &requests[0]);
+  comm.recv_init(recvbuf.data(), count * sizeof(int), 0, 7, &requests[1]);
+  for (int iter = 0; iter < n_iters; iter++) {
+    std::iota(sendbuf.begin(), sendbuf.end(), iter * count);
+    comm.start(2, requests);
+    // an active request cannot be started again nor freed
+    ASSERT_THROW(comm.start(1, requests), raft::logic_error);
+    ASSERT_THROW(comm.request_free(1, requests), raft::logic_error);
+    comm.waitall(2, requests);
+    for (int i = 0; i < count; i++) {
+      ASSERT_EQ(recvbuf[i], iter * count + i) << "iteration " << iter;
+    }
+  }
+  comm.request_free(2, requests);
+  // the ids are recycled, and freed requests are no longer valid
+  ASSERT_THROW(comm.start(2, requests), raft::logic_error);
+
+  // the regular requests reuse the freed slots, and cannot be started
+  comm.irecv(recvbuf.data(), sizeof(int), 0, 8, &requests[1]);
+  comm.isend(sendbuf.data(), sizeof(int), 0, 8, &requests[0]);
+  ASSERT_THROW(comm.start(1, requests), raft::logic_error);
+  comm.waitall(2, requests);
+  ASSERT_EQ(recvbuf[0], sendbuf[0]);
+}
+
+TEST_F(MpiCommsTest, Iallreduce)
+{
+  int const count = 1000;
+  std::vector<float> sendbuf(count);
+  std::vector<float> recvbuf(count, -1.0f);
+  std::iota(sendbuf.begin(), sendbuf.end(), 0.0f);
+
+  request_t requests[2];
+  comm.iallreduce(sendbuf.data(),
+                  recvbuf.data(),
+                  count,
+                  datatype_t::FLOAT32,
+                  op_t::SUM,
+                  &requests[0],
+                  stream.value());
+  // in place, along with the other one
+  std::vector<int> inplace(count, 3);
+  comm.iallreduce(inplace.data(),
+                  inplace.data(),
+                  count,
+                  datatype_t::INT32,
+                  op_t::MAX,
+                  &requests[1],
+                  stream.value());
+  comm.waitall(2, requests);
+  for (int i = 0; i < count; i++) {
+    ASSERT_EQ(recvbuf[i], sendbuf[i]);
+    ASSERT_EQ(inplace[i], 3);
+  }
+  // a completed request is released
+  ASSERT_THROW(comm.waitall(1, requests), raft::logic_error);
+}
+
+}  // namespace raft::comms
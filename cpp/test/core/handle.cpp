@@ -25,6 +25,9 @@
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resource/cuda_stream_pool.hpp>
 #include <raft/core/resource/device_memory_resource.hpp>
+#include <raft/core/resource/library_handle_pool.hpp>
+#include <raft/core/workspace_arena_resource.hpp>
+#include <rmm/cuda_stream.hpp>
 #include <rmm/mr/device/device_memory_resource.hpp>
 #include <rmm/mr/device/pool_memory_resource.hpp>
 #include <unordered_map>
@@ -309,6 +312,45 @@ TEST(Raft, WorkspaceResourceCopy)
                 resource::get_workspace_resource(copied_handle)) != nullptr);
 }
 
+TEST(Raft, WorkspaceArena)
+{
+  raft::handle_t handle;
+  auto stream = resource::get_cuda_stream(handle);
+  resource::set_workspace_to_arena_resource(handle, 1 << 20);
+
+  auto* arena =
+    dynamic_cast<raft::workspace_arena_resource*>(resource::get_workspace_resource(handle));
+  ASSERT_TRUE(arena != nullptr);
+  ASSERT_EQ(resource::get_workspace_total_bytes(handle), size_t(1 << 20));
+  ASSERT_EQ(resource::get_workspace_free_bytes(handle), size_t(1 << 20));
+
+  auto* mr = resource::get_workspace_resource(handle);
+  void* a  = mr->allocate(1000, stream);
+  void* b  = mr->allocate(4096, stream);
+  // the allocations are aligned and stacked
+  ASSERT_EQ(static_cast<char*>(b) - static_cast<char*>(a), 1024);
+  ASSERT_EQ(resource::get_workspace_free_bytes(handle), size_t((1 << 20) - 1024 - 4096));
+
+  // an allocation above the capacity fails instead of growing the footprint
+  ASSERT_THROW(mr->allocate(1 << 20, stream), rmm::out_of_memory);
+
+  // freed out of order: the memory is reclaimed once the top is freed
+  mr->deallocate(a, 1000, stream);
+  ASSERT_EQ(resource::get_workspace_free_bytes(handle), size_t((1 << 20) - 1024 - 4096));
+  mr->deallocate(b, 4096, stream);
+  ASSERT_EQ(resource::get_workspace_free_bytes(handle), size_t(1 << 20));
+  ASSERT_EQ(arena->peak_bytes(), size_t(1024 + 4096));
+
+  // the reclaimed memory is reused
+  void* c = mr->allocate(16, stream);
+  ASSERT_EQ(c, a);
+  mr->deallocate(c, 16, stream);
+
+  // the copies of the handle share the arena
+  raft::handle_t copied_handle(handle);
+  ASSERT_EQ(resource::get_workspace_resource(copied_handle), mr);
+}
+
 TEST(Raft, HandleCopy)
 {
   auto stream_pool = std::make_shared<rmm::cuda_stream_pool>(10);
@@ -329,4 +371,39 @@ TEST(Raft, HandleAssign)
   assert_handles_equal(handle, copied_handle);
 }
 
+TEST(Raft, LibraryHandlePool)
+{
+  raft::resource::warm_up_library_handles(0, 2);
+  ASSERT_TRUE(raft::resource::is_library_handle_pool_enabled());
+
+  cublasHandle_t first;
+  {
+    rmm::cuda_stream stream;
+    handle_t handle(stream.view());
+    first = handle.get_cublas_handle();
+    ASSERT_NE(first, nullptr);
+    handle.get_cusolver_dn_handle();
+    handle.get_cusparse_handle();
+
+    // concurrent handles lease distinct library handles
+    handle_t other;
+    ASSERT_NE(other.get_cublas_handle(), first);
+
+    cudaStream_t set_stream;
+    RAFT_CUBLAS_TRY(cublasGetStream(first, &set_stream));
+    ASSERT_EQ(set_stream, stream.value());
+  }
+
+  // the library handles of a destroyed handle are reused
+  handle_t handle;
+  auto reused = handle.get_cublas_handle();
+  cudaStream_t set_stream;
+  RAFT_CUBLAS_TRY(cublasGetStream(reused, &set_stream));
+  ASSERT_EQ(set_stream, handle.get_stream().value());
+  ASSERT_EQ(handle.get_device_properties().major,
+            resource::get_device_properties(handle_t{}).major);
+
+  raft::resource::enable_library_handle_pool(false);
+}
+
 }  // namespace raft
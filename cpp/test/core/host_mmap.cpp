@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+#include <raft/core/host_mmap_container_policy.hpp>
+#include <raft/core/resources.hpp>
+
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+namespace raft {
+
+namespace {
+
+/** A temporary file holding an 8-byte header followed by `n` floats 0, 1, 2... */
+class mmap_file {
+ public:
+  explicit mmap_file(size_t n) : values_(n)
+  {
+    char name[] = "/tmp/raft_mmap_XXXXXX";
+    int fd      = mkstemp(name);
+    EXPECT_GE(fd, 0);
+    close(fd);
+    path_ = name;
+    std::iota(values_.begin(), values_.end(), 0.0f);
+    std::ofstream of(path_, std::ios::out | std::ios::binary);
+    const std::int32_t header[2] = {7, 7};
+    of.write(reinterpret_cast<const char*>(header), sizeof(header));
+    of.write(reinterpret_cast<const char*>(values_.data()), values_.size() * sizeof(float));
+  }
+  ~mmap_file() { unlink(path_.c_str()); }
+
+  [[nodiscard]] auto path() const -> const std::string& { return path_; }
+  [[nodiscard]] auto values() const -> const std::vector<float>& { return values_; }
+
+ private:
+  std::string path_;
+  std::vector<float> values_;
+};
+
+}  // namespace
+
+TEST(HostMmapMatrix, ReadOnly)
+{
+  raft::resources res;
+  mmap_file file(12 * 5);
+  auto m    = make_host_mmap_matrix<float, int>(res, file.path(), 12, 5, 8);
+  auto view = m.view();
+  ASSERT_EQ(view.extent(0), 12);
+  ASSERT_EQ(view.extent(1), 5);
+  for (int i = 0; i < 12; i++) {
+    for (int j = 0; j < 5; j++) {
+      EXPECT_EQ(view(i, j), file.values()[i * 5 + j]);
+    }
+  }
+  host_matrix_view<float, int> as_plain_view = view;
+  EXPECT_EQ(as_plain_view.data_handle(), m.data_handle());
+}
+
+TEST(HostMmapMatrix, CopyOnWrite)
+{
+  raft::resources res;
+  mmap_file file(4 * 4);
+  mmap_params params;
+  params.mode     = mmap_mode::copy_on_write;
+  params.populate = true;
+  {
+    auto m = make_host_mmap_matrix<float, int>(res, file.path(), 4, 4, 8, params);
+    m(1, 2) = -1.0f;
+    EXPECT_EQ(m(1, 2), -1.0f);
+  }
+  // the file is not changed
+  auto m = make_host_mmap_matrix<float, int>(res, file.path(), 4, 4, 8);
+  EXPECT_EQ(m(1, 2), file.values()[1 * 4 + 2]);
+}
+
+TEST(HostMmapMatrix, TooSmall)
+{
+  raft::resources res;
+  mmap_file file(4);
+  EXPECT_THROW((make_host_mmap_matrix<float, int>(res, file.path(), 2, 4, 8)), raft::logic_error);
+  EXPECT_THROW((make_host_mmap_matrix<float, int>(res, "/nonexistent/raft_mmap", 1, 1)),
+               raft::logic_error);
+}
+
+}  // namespace raft
@@ -14,12 +14,14 @@
  * limitations under the License.
  */
 
+#include <chrono>
 #include <cstddef>
 #include <gtest/gtest.h>
 #include <iostream>
 #include <memory>
 #include <omp.h>
 #include <raft/common/nvtx.hpp>
+#include <raft/core/deadline.hpp>
 #include <raft/core/interruptible.hpp>
 #include <rmm/cuda_stream.hpp>
 #include <thread>
@@ -141,4 +143,35 @@ TEST(Raft, InterruptibleOpenMP)
   ASSERT_EQ(n_finished, n_expected_succeed);
   ASSERT_EQ(n_cancelled, n_threads - n_expected_succeed);
 }
+
+TEST(Raft, InterruptibleDeadline)
+{
+  raft::deadline none;
+  ASSERT_FALSE(none.is_set());
+  ASSERT_FALSE(none.expired());
+  ASSERT_EQ(none.device_flag(), nullptr);
+
+  auto budget = raft::deadline::after(std::chrono::hours(1));
+  ASSERT_TRUE(budget.is_set());
+  ASSERT_FALSE(budget.expired());
+  ASSERT_NE(budget.device_flag(), nullptr);
+  ASSERT_EQ(budget.device_flag()[0], 0u);
+
+  rmm::cuda_stream stream;
+  gpu_wait<<<1, 1, 0, stream.value()>>>(1);
+  ASSERT_TRUE(interruptible::synchronize(stream, budget));
+
+  // the copies share the state
+  auto copy = budget;
+  copy.expire();
+  ASSERT_TRUE(budget.expired());
+  ASSERT_NE(budget.device_flag()[0], 0u);
+
+  auto passed = raft::deadline::after(std::chrono::milliseconds(1));
+  gpu_wait<<<1, 1, 0, stream.value()>>>(50);
+  ASSERT_FALSE(interruptible::synchronize(stream, passed));
+  ASSERT_TRUE(passed.expired());
+  // the work is complete anyway
+  ASSERT_EQ(cudaStreamQuery(stream.value()), cudaSuccess);
+}
 }  // namespace raft
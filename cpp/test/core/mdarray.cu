@@ -22,6 +22,8 @@
 #include <raft/core/device_mdarray.hpp>
 #include <raft/core/host_container_policy.hpp>
 #include <raft/core/host_mdarray.hpp>
+#include <raft/core/managed_mdarray.hpp>
+#include <raft/core/pinned_mdarray.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/util/cuda_utils.cuh>
@@ -960,4 +962,59 @@ void test_mdarray_unravel()
 
 TEST(MDArray, Unravel) { test_mdarray_unravel(); }
 
+namespace {
+void test_pinned_managed_mdarray()
+{
+  raft::resources handle;
+  auto stream = resource::get_cuda_stream(handle);
+  {
+    auto pinned = make_pinned_matrix<float, int>(handle, 4, 8);
+    static_assert(decltype(pinned.view())::accessor_type::is_host_accessible);
+    static_assert(!decltype(pinned.view())::accessor_type::is_device_accessible);
+    ASSERT_EQ(pinned.extent(0), 4);
+    ASSERT_EQ(pinned.extent(1), 8);
+    for (int i = 0; i < pinned.size(); i++) {
+      pinned.data_handle()[i] = static_cast<float>(i);
+    }
+
+    cudaPointerAttributes attr;
+    RAFT_CUDA_TRY(cudaPointerGetAttributes(&attr, pinned.data_handle()));
+    ASSERT_EQ(attr.type, cudaMemoryTypeHost);
+
+    // copy round trip through the device
+    auto dev = make_device_matrix<float, int>(handle, 4, 8);
+    raft::copy(dev.data_handle(), pinned.data_handle(), pinned.size(), stream);
+    auto back = make_pinned_vector<float, int>(handle, pinned.size());
+    raft::copy(back.data_handle(), dev.data_handle(), pinned.size(), stream);
+    resource::sync_stream(handle);
+    for (int i = 0; i < back.size(); i++) {
+      ASSERT_EQ(back(i), static_cast<float>(i));
+    }
+
+    // deep copy
+    auto copied = pinned;
+    ASSERT_NE(copied.data_handle(), pinned.data_handle());
+    ASSERT_EQ(copied(3, 7), pinned(3, 7));
+  }
+  {
+    auto managed = make_managed_vector<int, int>(handle, 16);
+    static_assert(decltype(managed.view())::accessor_type::is_managed_accessible);
+    thrust::sequence(resource::get_thrust_policy(handle),
+                     managed.data_handle(),
+                     managed.data_handle() + managed.size());
+    resource::sync_stream(handle);
+    // read directly from the host
+    for (int i = 0; i < managed.size(); i++) {
+      ASSERT_EQ(managed.data_handle()[i], i);
+    }
+
+    cudaPointerAttributes attr;
+    RAFT_CUDA_TRY(cudaPointerGetAttributes(&attr, managed.data_handle()));
+    ASSERT_EQ(attr.type, cudaMemoryTypeManaged);
+  }
+}
+}  // anonymous namespace
+
+TEST(MDArray, PinnedManaged) { test_pinned_managed_mdarray(); }
+
 }  // namespace raft
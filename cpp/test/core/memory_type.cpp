@@ -40,4 +40,22 @@ TEST(MemoryType, IsHostDeviceAccessible)
   static_assert(is_host_device_accessible(memory_type::managed));
   static_assert(!is_host_device_accessible(memory_type::pinned));
 }
+
+TEST(MemoryType, FromPointer)
+{
+  int host_value = 0;
+  ASSERT_EQ(memory_type_from_pointer(&host_value), memory_type::host);
+  ASSERT_EQ(memory_type_from_pointer(static_cast<int*>(nullptr)), memory_type::host);
+
+  int* ptr = nullptr;
+  ASSERT_EQ(cudaMalloc(&ptr, sizeof(int)), cudaSuccess);
+  ASSERT_EQ(memory_type_from_pointer(ptr), memory_type::device);
+  ASSERT_EQ(cudaFree(ptr), cudaSuccess);
+  ASSERT_EQ(cudaMallocManaged(&ptr, sizeof(int)), cudaSuccess);
+  ASSERT_EQ(memory_type_from_pointer(ptr), memory_type::managed);
+  ASSERT_EQ(cudaFree(ptr), cudaSuccess);
+  ASSERT_EQ(cudaMallocHost(&ptr, sizeof(int)), cudaSuccess);
+  ASSERT_EQ(memory_type_from_pointer(ptr), memory_type::pinned);
+  ASSERT_EQ(cudaFreeHost(ptr), cudaSuccess);
+}
 }  // namespace raft
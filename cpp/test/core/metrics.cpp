@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <raft/core/metrics.hpp>
+#include <raft/core/nvtx.hpp>
+
+#include <rmm/cuda_stream.hpp>
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace raft {
+
+namespace {
+
+int callback_count = 0;
+void example_callback(const char*, metrics::metric_kind, double) { ++callback_count; }
+
+std::vector<std::string> phase_events;
+void phase_callback(const char* name, bool begin)
+{
+  phase_events.push_back(std::string(begin ? "+" : "-") + name);
+}
+
+auto find_summary(const std::string& name) -> metrics::metric_summary
+{
+  for (auto& s : metrics::snapshot()) {
+    if (s.name == name) { return s; }
+  }
+  return {};
+}
+
+}  // namespace
+
+class metricsTest : public ::testing::Test {
+ protected:
+  void SetUp() override
+  {
+    metrics::reset();
+    metrics::set_callback(nullptr);
+    callback_count = 0;
+    phase_events.clear();
+  }
+  void TearDown() override
+  {
+    metrics::set_enabled(false);
+    metrics::set_callback(nullptr);
+    metrics::set_phase_callback(nullptr);
+    metrics::reset();
+  }
+};
+
+TEST_F(metricsTest, DisabledByDefault)
+{
+  metrics::record("test::count", metrics::metric_kind::count, 1);
+  EXPECT_EQ(find_summary("test::count").count, 0u);
+}
+
+TEST_F(metricsTest, Aggregate)
+{
+  metrics::set_enabled(true);
+  metrics::set_callback(example_callback);
+  metrics::record("test::count", metrics::metric_kind::count, 4);
+  metrics::record("test::count", metrics::metric_kind::count, 2);
+  auto s = find_summary("test::count");
+  EXPECT_EQ(s.kind, metrics::metric_kind::count);
+  EXPECT_EQ(s.count, 2u);
+  EXPECT_DOUBLE_EQ(s.sum, 6);
+  EXPECT_DOUBLE_EQ(s.min, 2);
+  EXPECT_DOUBLE_EQ(s.max, 4);
+  EXPECT_DOUBLE_EQ(s.mean(), 3);
+  EXPECT_EQ(callback_count, 2);
+
+  metrics::reset();
+  EXPECT_EQ(find_summary("test::count").count, 0u);
+}
+
+TEST_F(metricsTest, Timers)
+{
+  metrics::set_enabled(true);
+  {
+    common::nvtx::range<common::nvtx::domain::raft> fun_scope("test::range(%d)", 1);
+  }
+  rmm::cuda_stream stream;
+  for (int i = 0; i < 3; i++) {
+    metrics::stream_timer timer("test::stream", stream.view());
+  }
+  auto host = find_summary("test::range(%d)");
+  EXPECT_EQ(host.kind, metrics::metric_kind::host_time);
+  EXPECT_EQ(host.count, 1u);
+  EXPECT_GE(host.min, 0.0);
+  // snapshot() waits for the pending device timings
+  auto device = find_summary("test::stream");
+  EXPECT_EQ(device.kind, metrics::metric_kind::device_time);
+  EXPECT_EQ(device.count, 3u);
+  EXPECT_GE(device.min, 0.0);
+}
+
+TEST_F(metricsTest, Phases)
+{
+  rmm::cuda_stream stream;
+  metrics::set_phase_callback(phase_callback);
+  {
+    metrics::phase disabled("test::disabled", stream.view());
+  }
+  EXPECT_TRUE(phase_events.empty());
+
+  metrics::set_enabled(true);
+  {
+    std::optional<metrics::phase> outer;
+    outer.emplace("test::a", stream.view());
+    outer.emplace("test::b", stream.view());
+    metrics::phase inner("test::c", stream.view());
+  }
+  std::vector<std::string> expected{
+    "+test::a", "-test::a", "+test::b", "+test::c", "-test::c", "-test::b"};
+  EXPECT_EQ(phase_events, expected);
+  auto device = find_summary("test::b");
+  EXPECT_EQ(device.kind, metrics::metric_kind::device_time);
+  EXPECT_EQ(device.count, 1u);
+}
+
+}  // namespace raft
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <raft/core/error.hpp>
+#include <raft/core/multi_device_resources.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/cuda_stream_pool.hpp>
+#include <raft/core/resource/device_id.hpp>
+#include <raft/core/resource/device_memory_resource.hpp>
+
+#include <cuda_runtime.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+namespace raft {
+
+TEST(MultiDeviceResources, AllDevices)
+{
+  int n_devices = 0;
+  RAFT_CUDA_TRY(cudaGetDeviceCount(&n_devices));
+  multi_device_resources mres({}, 2, size_t{1} << 20);
+  ASSERT_EQ(mres.size(), size_t(n_devices));
+  ASSERT_EQ(mres.handles().size(), mres.size());
+  for (size_t i = 0; i < mres.size(); i++) {
+    EXPECT_EQ(mres.device_id(i), int(i));
+    EXPECT_EQ(resource::get_device_id(mres[i]), int(i));
+    EXPECT_TRUE(resource::is_stream_pool_initialized(mres[i]));
+    EXPECT_EQ(resource::get_stream_pool_size(mres[i]), size_t(2));
+    EXPECT_EQ(resource::get_workspace_total_bytes(mres[i]), size_t{1} << 20);
+    EXPECT_TRUE(mres.can_access_peer(i, i));
+  }
+}
+
+TEST(MultiDeviceResources, ForEachDevice)
+{
+  multi_device_resources mres({0});
+  ASSERT_EQ(mres.size(), size_t(1));
+  EXPECT_FALSE(resource::is_stream_pool_initialized(mres[0]));
+
+  std::atomic<int> n_calls{0};
+  mres.for_each_device([&](size_t i, raft::resources const& res) {
+    int device = -1;
+    RAFT_CUDA_TRY(cudaGetDevice(&device));
+    EXPECT_EQ(device, mres.device_id(i));
+    EXPECT_EQ(&res, &mres[i]);
+    resource::sync_stream(res);
+    n_calls++;
+  });
+  EXPECT_EQ(n_calls.load(), 1);
+  mres.sync();
+
+  EXPECT_THROW(mres.for_each_device(
+                 [](size_t, raft::resources const&) { throw std::runtime_error("failed"); }),
+               std::runtime_error);
+}
+
+TEST(MultiDeviceResources, RepeatedDevice)
+{
+  EXPECT_THROW(multi_device_resources({0, 0}), raft::logic_error);
+}
+
+}  // namespace raft
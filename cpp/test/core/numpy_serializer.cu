@@ -22,6 +22,7 @@
 
 #include <thrust/device_vector.h>
 #include <thrust/host_vector.h>
+#include <thrust/sequence.h>
 #include <thrust/universal_vector.h>
 
 #include <complex>
@@ -117,6 +118,18 @@ TEST(NumPySerializerMDSpan, ManagedMDSpan)
   test_mdspan_roundtrip<managed_mdspan_matrix2d_c_layout>(handle, vec, 2, 2, 2);
 }
 
+TEST(NumPySerializerMDSpan, ChunkedDeviceMDSpan)
+{
+  // Larger than two staging buffers, and not a multiple of their size
+  raft::resources handle{};
+  const size_t n = 2 * detail::kStagingBufferSize / sizeof(std::int32_t) + 7;
+  thrust::device_vector<std::int32_t> d_vec(n);
+  thrust::sequence(d_vec.begin(), d_vec.end());
+  using device_mdspan_vector =
+    raft::device_mdspan<std::int32_t, dextents<std::size_t, 1>, raft::layout_c_contiguous>;
+  test_mdspan_roundtrip<device_mdspan_vector>(handle, d_vec, n);
+}
+
 TEST(NumPySerializerMDSpan, Tuple2String)
 {
   {
@@ -16,12 +16,14 @@
 
 #include "../test_utils.cuh"
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/device_id.hpp>
 
 #include <raft/core/host_mdarray.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/core/temporary_device_buffer.hpp>
 
 #include <rmm/device_uvector.hpp>
+#include <rmm/mr/device/managed_memory_resource.hpp>
 
 #include <gtest/gtest.h>
 
@@ -84,4 +86,39 @@ TEST(TemporaryDeviceBuffer, HostPointerWithWriteBack)
                                     resource::get_cuda_stream(handle)));
 }
 
+TEST(TemporaryDeviceBuffer, ManagedPointer)
+{
+  raft::resources handle;
+  auto stream = resource::get_cuda_stream(handle);
+  auto exts   = raft::make_extents<int>(1 << 20);
+  rmm::mr::managed_memory_resource managed_mr;
+  rmm::device_uvector<int> managed(exts.extent(0), stream, &managed_mr);
+
+  {
+    // the managed memory is used in place; large inputs are prefetched to the device
+    auto d_buf = raft::make_writeback_temporary_device_buffer(handle, managed.data(), exts);
+    ASSERT_FALSE(d_buf.is_copy());
+    ASSERT_EQ(managed.data(), d_buf.view().data_handle());
+    thrust::fill(rmm::exec_policy(stream),
+                 d_buf.view().data_handle(),
+                 d_buf.view().data_handle() + exts.extent(0),
+                 7);
+  }
+  resource::sync_stream(handle);
+  ASSERT_EQ(managed.element(exts.extent(0) - 1, stream), 7);
+}
+
+TEST(TemporaryDeviceBuffer, HostPointerCopy)
+{
+  raft::resources handle;
+  auto exts  = raft::make_extents<int>(5);
+  auto array = raft::make_host_mdarray<int, int>(exts);
+
+  auto d_buf = raft::make_readonly_temporary_device_buffer(handle, array.data_handle(), exts);
+  // copied unless the device reads the host memory through the host page tables
+  ASSERT_EQ(d_buf.is_copy(),
+            !raft::device_reads_pageable_memory(resource::get_device_id(handle)));
+  ASSERT_EQ(d_buf.is_copy(), d_buf.view().data_handle() != array.data_handle());
+}
+
 }  // namespace raft
@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+#include <gtest/gtest.h>
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/distance/binary_distance.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace raft {
+namespace distance {
+
+struct BinaryDistanceInputs {
+  raft::distance::DistanceType metric;
+  int m, n, n_bits;
+  // the probability of a bit being set: the Jaccard distance of sparse codes has more spread
+  double density;
+  unsigned long long int seed;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const BinaryDistanceInputs& p)
+{
+  os << "metric: " << int(p.metric) << ", m: " << p.m << ", n: " << p.n << ", n_bits: " << p.n_bits
+     << ", density: " << p.density;
+  return os;
+}
+
+template <typename BitsT>
+class BinaryDistanceTest : public ::testing::TestWithParam<BinaryDistanceInputs> {
+  static constexpr int kWordBits = 8 * sizeof(BitsT);
+
+ public:
+  BinaryDistanceTest()
+    : params(::testing::TestWithParam<BinaryDistanceInputs>::GetParam()),
+      stream(resource::get_cuda_stream(handle)),
+      n_words(raft::ceildiv(params.n_bits, kWordBits)),
+      x(params.m * n_words, stream),
+      y(params.n * n_words, stream)
+  {
+  }
+
+ protected:
+  // Random codes of n_bits bits, the unused bits of the last word are zero
+  std::vector<BitsT> random_codes(std::mt19937_64& gen, int rows)
+  {
+    std::bernoulli_distribution bit(params.density);
+    std::vector<BitsT> codes(size_t(rows) * n_words, 0);
+    for (int i = 0; i < rows; i++) {
+      for (int b = 0; b < params.n_bits; b++) {
+        if (bit(gen)) { codes[size_t(i) * n_words + b / kWordBits] |= BitsT(1) << (b % kWordBits); }
+      }
+    }
+    return codes;
+  }
+
+  void SetUp() override
+  {
+    std::mt19937_64 gen(params.seed);
+    h_x = random_codes(gen, params.m);
+    h_y = random_codes(gen, params.n);
+    raft::update_device(x.data(), h_x.data(), h_x.size(), stream);
+    raft::update_device(y.data(), h_y.data(), h_y.size(), stream);
+
+    dist_ref.resize(size_t(params.m) * params.n);
+    for (int i = 0; i < params.m; i++) {
+      for (int j = 0; j < params.n; j++) {
+        int n_xor = 0, n_and = 0, n_or = 0;
+        for (int w = 0; w < n_words; w++) {
+          uint64_t a = h_x[size_t(i) * n_words + w];
+          uint64_t b = h_y[size_t(j) * n_words + w];
+          n_xor += __builtin_popcountll(a ^ b);
+          n_and += __builtin_popcountll(a & b);
+          n_or += __builtin_popcountll(a | b);
+        }
+        dist_ref[size_t(i) * params.n + j] =
+          params.metric == raft::distance::DistanceType::HammingUnexpanded
+            ? float(n_xor) / params.n_bits
+            : (n_or == 0 ? 0.0f : 1.0f - float(n_and) / n_or);
+      }
+    }
+  }
+
+  void runTest()
+  {
+    auto dist = raft::make_device_matrix<float, int>(handle, params.m, params.n);
+    binary_pairwise_distance(
+      handle,
+      raft::make_device_matrix_view<const BitsT, int>(x.data(), params.m, n_words),
+      raft::make_device_matrix_view<const BitsT, int>(y.data(), params.n, n_words),
+      dist.view(),
+      params.metric,
+      params.n_bits);
+    ASSERT_TRUE(raft::devArrMatchHost(dist_ref.data(),
+                                      dist.data_handle(),
+                                      dist_ref.size(),
+                                      raft::CompareApprox<float>(1e-5f),
+                                      stream));
+  }
+
+  raft::resources handle;
+  BinaryDistanceInputs params;
+  cudaStream_t stream;
+  int n_words;
+  rmm::device_uvector<BitsT> x, y;
+  std::vector<BitsT> h_x, h_y;
+  std::vector<float> dist_ref;
+};
+
+const std::vector<BinaryDistanceInputs> inputs = {
+  {raft::distance::DistanceType::HammingUnexpanded, 1024, 1024, 64, 0.5, 1234ULL},
+  {raft::distance::DistanceType::HammingUnexpanded, 100, 2000, 1024, 0.5, 1234ULL},
+  {raft::distance::DistanceType::HammingUnexpanded, 1031, 517, 250, 0.3, 1234ULL},
+  {raft::distance::DistanceType::HammingUnexpanded, 1, 1000, 96, 0.5, 1234ULL},
+  {raft::distance::DistanceType::JaccardExpanded, 1024, 1024, 64, 0.5, 1234ULL},
+  {raft::distance::DistanceType::JaccardExpanded, 517, 1031, 1024, 0.1, 1234ULL},
+  {raft::distance::DistanceType::JaccardExpanded, 1000, 37, 250, 0.02, 1234ULL},
+};
+
+typedef BinaryDistanceTest<uint32_t> BinaryDistanceTestU32;
+TEST_P(BinaryDistanceTestU32, Result) { runTest(); }
+INSTANTIATE_TEST_CASE_P(DistanceTests, BinaryDistanceTestU32, ::testing::ValuesIn(inputs));
+
+typedef BinaryDistanceTest<uint64_t> BinaryDistanceTestU64;
+TEST_P(BinaryDistanceTestU64, Result) { runTest(); }
+INSTANTIATE_TEST_CASE_P(DistanceTests, BinaryDistanceTestU64, ::testing::ValuesIn(inputs));
+
+}  // end namespace distance
+}  // end namespace raft
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+#include "distance_base.cuh"
+
+#include <raft/linalg/map.cuh>
+
+#include <cuda_bf16.h>
+#include <cuda_fp16.h>
+
+namespace raft {
+namespace distance {
+
+struct DistanceHalfInputs {
+  raft::distance::DistanceType metric;
+  float tolerance;
+  int m, n, k;
+  unsigned long long int seed;
+  float metric_arg = 2.0f;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const DistanceHalfInputs& p)
+{
+  os << "metric: " << int(p.metric) << ", m: " << p.m << ", n: " << p.n << ", k: " << p.k;
+  return os;
+}
+
+/** Rounds `src` to `DataT` into `dst` and `src` in place. */
+template <typename DataT>
+void round_inputs(raft::resources const& handle, float* src, DataT* dst, int len)
+{
+  raft::linalg::map(handle,
+                    raft::make_device_vector_view<DataT, int>(dst, len),
+                    [] __device__(float v) { return DataT(v); },
+                    raft::make_device_vector_view<const float, int>(src, len));
+  raft::linalg::map(handle,
+                    raft::make_device_vector_view<float, int>(src, len),
+                    [] __device__(DataT v) { return float(v); },
+                    raft::make_device_vector_view<const DataT, int>(dst, len));
+}
+
+/**
+ * Compares the half-precision pairwise distance against the fp32 one on the same (rounded)
+ * inputs.
+ */
+template <typename DataT>
+class DistanceHalfTest : public ::testing::TestWithParam<DistanceHalfInputs> {
+ public:
+  DistanceHalfTest()
+    : params(::testing::TestWithParam<DistanceHalfInputs>::GetParam()),
+      stream(resource::get_cuda_stream(handle)),
+      x(params.m * params.k, stream),
+      y(params.n * params.k, stream),
+      x_half(params.m * params.k, stream),
+      y_half(params.n * params.k, stream),
+      dist_ref(params.m * params.n, stream),
+      dist(params.m * params.n, stream)
+  {
+  }
+
+  void SetUp() override
+  {
+    int m = params.m;
+    int n = params.n;
+    int k = params.k;
+    raft::random::RngState r(params.seed);
+    // positive inputs, as required by the hellinger, jensen-shannon and kl-divergence distances
+    uniform(handle, r, x.data(), m * k, 0.0f, 1.0f);
+    uniform(handle, r, y.data(), n * k, 0.0f, 1.0f);
+    if (params.metric == raft::distance::DistanceType::RusselRaoExpanded) {
+      bernoulli(handle, r, x.data(), m * k, 0.5f);
+      bernoulli(handle, r, y.data(), n * k, 0.5f);
+    }
+
+    // round the inputs, so that the fp32 reference sees the same values
+    round_inputs(handle, x.data(), x_half.data(), m * k);
+    round_inputs(handle, y.data(), y_half.data(), n * k);
+
+    naiveDistance(
+      dist_ref.data(), x.data(), y.data(), m, n, k, params.metric, true, params.metric_arg, stream);
+    pairwise_distance(handle,
+                      make_device_matrix_view<const DataT, int>(x_half.data(), m, k),
+                      make_device_matrix_view<const DataT, int>(y_half.data(), n, k),
+                      make_device_matrix_view<float, int>(dist.data(), m, n),
+                      params.metric,
+                      params.metric_arg);
+    resource::sync_stream(handle, stream);
+  }
+
+ protected:
+  raft::resources handle;
+  DistanceHalfInputs params;
+  cudaStream_t stream;
+  rmm::device_uvector<float> x, y;
+  rmm::device_uvector<DataT> x_half, y_half;
+  rmm::device_uvector<float> dist_ref, dist;
+};
+
+const std::vector<DistanceHalfInputs> inputs = {
+  {raft::distance::DistanceType::L2Expanded, 0.001f, 1024, 1024, 32, 1234ULL},
+  {raft::distance::DistanceType::L2Expanded, 0.001f, 100, 37, 1000, 1234ULL},
+  {raft::distance::DistanceType::L2SqrtExpanded, 0.001f, 1024, 32, 1024, 1234ULL},
+  {raft::distance::DistanceType::CosineExpanded, 0.001f, 32, 1024, 1024, 1234ULL},
+  {raft::distance::DistanceType::InnerProduct, 0.001f, 1024, 1024, 32, 1234ULL},
+  {raft::distance::DistanceType::CorrelationExpanded, 0.003f, 1024, 1024, 128, 1234ULL},
+  {raft::distance::DistanceType::L1, 0.001f, 1024, 1024, 32, 1234ULL},
+  {raft::distance::DistanceType::L1, 0.001f, 100, 37, 1000, 1234ULL},
+  {raft::distance::DistanceType::L2Unexpanded, 0.001f, 1024, 32, 1024, 1234ULL},
+  {raft::distance::DistanceType::L2SqrtUnexpanded, 0.001f, 33, 65, 17, 1234ULL},
+  {raft::distance::DistanceType::Linf, 0.001f, 1024, 1024, 32, 1234ULL},
+  {raft::distance::DistanceType::Canberra, 0.001f, 1024, 1024, 32, 1234ULL},
+  {raft::distance::DistanceType::LpUnexpanded, 0.001f, 1024, 1024, 32, 1234ULL, 3.0f},
+  {raft::distance::DistanceType::HellingerExpanded, 0.001f, 1024, 1024, 32, 1234ULL},
+  {raft::distance::DistanceType::JensenShannon, 0.001f, 1024, 1024, 32, 1234ULL},
+  {raft::distance::DistanceType::RusselRaoExpanded, 0.001f, 1024, 1024, 32, 1234ULL},
+  {raft::distance::DistanceType::KLDivergence, 0.001f, 1024, 1024, 32, 1234ULL},
+};
+
+typedef DistanceHalfTest<half> DistanceHalfTestF16;
+TEST_P(DistanceHalfTestF16, Result)
+{
+  ASSERT_TRUE(raft::devArrMatch(dist_ref.data(),
+                                dist.data(),
+                                params.m,
+                                params.n,
+                                raft::CompareApprox<float>(params.tolerance),
+                                stream));
+}
+INSTANTIATE_TEST_CASE_P(DistanceTests, DistanceHalfTestF16, ::testing::ValuesIn(inputs));
+
+typedef DistanceHalfTest<nv_bfloat16> DistanceHalfTestBF16;
+TEST_P(DistanceHalfTestBF16, Result)
+{
+  ASSERT_TRUE(raft::devArrMatch(dist_ref.data(),
+                                dist.data(),
+                                params.m,
+                                params.n,
+                                raft::CompareApprox<float>(params.tolerance),
+                                stream));
+}
+INSTANTIATE_TEST_CASE_P(DistanceTests, DistanceHalfTestBF16, ::testing::ValuesIn(inputs));
+
+}  // end namespace distance
+}  // end namespace raft
@@ -24,6 +24,10 @@ template <typename DataType>
 class DistanceJensenShannon
   : public DistanceTest<raft::distance::DistanceType::JensenShannon, DataType> {};
 
+template <typename DataType>
+class DistanceJensenShannonXequalY
+  : public DistanceTestSameBuffer<raft::distance::DistanceType::JensenShannon, DataType> {};
+
 const std::vector<DistanceInputs<float>> inputsf = {
   {0.001f, 1024, 1024, 32, true, 1234ULL},
   {0.001f, 1024, 32, 1024, true, 1234ULL},
@@ -44,6 +48,36 @@ TEST_P(DistanceJensenShannonF, Result)
 }
 INSTANTIATE_TEST_CASE_P(DistanceTests, DistanceJensenShannonF, ::testing::ValuesIn(inputsf));
 
+const std::vector<DistanceInputs<float>> inputsXeqYf = {
+  {0.001f, 1024, 1024, 32, true, 1234ULL},
+  {0.001f, 1024, 32, 1024, true, 1234ULL},
+  {0.003f, 1024, 1024, 1024, true, 1234ULL},
+  {0.001f, 1024, 1024, 32, false, 1234ULL},
+  {0.001f, 1024, 32, 1024, false, 1234ULL},
+  {0.003f, 1024, 1024, 1024, false, 1234ULL},
+};
+typedef DistanceJensenShannonXequalY<float> DistanceJensenShannonXequalYF;
+TEST_P(DistanceJensenShannonXequalYF, Result)
+{
+  int m = params.m;
+  ASSERT_TRUE(raft::devArrMatch(dist_ref[0].data(),
+                                dist[0].data(),
+                                m,
+                                m,
+                                raft::CompareApprox<float>(params.tolerance),
+                                stream));
+  ASSERT_TRUE(raft::devArrMatch(dist_ref[1].data(),
+                                dist[1].data(),
+                                m / 2,
+                                m,
+                                raft::CompareApprox<float>(params.tolerance),
+                                stream));
+  ASSERT_TRUE(diagonalIsZero(dist[0].data(), m, 0.0f, stream));
+}
+INSTANTIATE_TEST_CASE_P(DistanceTests,
+                        DistanceJensenShannonXequalYF,
+                        ::testing::ValuesIn(inputsXeqYf));
+
 const std::vector<DistanceInputs<double>> inputsd = {
   {0.001, 1024, 1024, 32, true, 1234ULL},
   {0.001, 1024, 32, 1024, true, 1234ULL},
@@ -64,6 +98,36 @@ TEST_P(DistanceJensenShannonD, Result)
 }
 INSTANTIATE_TEST_CASE_P(DistanceTests, DistanceJensenShannonD, ::testing::ValuesIn(inputsd));
 
+const std::vector<DistanceInputs<double>> inputsXeqYd = {
+  {0.001, 1024, 1024, 32, true, 1234ULL},
+  {0.001, 1024, 32, 1024, true, 1234ULL},
+  {0.003, 1024, 1024, 1024, true, 1234ULL},
+  {0.001, 1024, 1024, 32, false, 1234ULL},
+  {0.001, 1024, 32, 1024, false, 1234ULL},
+  {0.003, 1024, 1024, 1024, false, 1234ULL},
+};
+typedef DistanceJensenShannonXequalY<double> DistanceJensenShannonXequalYD;
+TEST_P(DistanceJensenShannonXequalYD, Result)
+{
+  int m = params.m;
+  ASSERT_TRUE(raft::devArrMatch(dist_ref[0].data(),
+                                dist[0].data(),
+                                m,
+                                m,
+                                raft::CompareApprox<double>(params.tolerance),
+                                stream));
+  ASSERT_TRUE(raft::devArrMatch(dist_ref[1].data(),
+                                dist[1].data(),
+                                m / 2,
+                                m,
+                                raft::CompareApprox<double>(params.tolerance),
+                                stream));
+  ASSERT_TRUE(diagonalIsZero(dist[0].data(), m, 0.0, stream));
+}
+INSTANTIATE_TEST_CASE_P(DistanceTests,
+                        DistanceJensenShannonXequalYD,
+                        ::testing::ValuesIn(inputsXeqYd));
+
 class BigMatrixJensenShannon
   : public BigMatrixDistanceTest<raft::distance::DistanceType::JensenShannon> {};
 TEST_F(BigMatrixJensenShannon, Result) {}
@@ -24,6 +24,10 @@ template <typename DataType>
 class DistanceKLDivergence
   : public DistanceTest<raft::distance::DistanceType::KLDivergence, DataType> {};
 
+template <typename DataType>
+class DistanceKLDivergenceXequalY
+  : public DistanceTestSameBuffer<raft::distance::DistanceType::KLDivergence, DataType> {};
+
 const std::vector<DistanceInputs<float>> inputsf = {
   {0.001f, 1024, 1024, 32, true, 1234ULL},
   {0.001f, 1024, 32, 1024, true, 1234ULL},
@@ -44,6 +48,36 @@ TEST_P(DistanceKLDivergenceF, Result)
 }
 INSTANTIATE_TEST_CASE_P(DistanceTests, DistanceKLDivergenceF, ::testing::ValuesIn(inputsf));
 
+const std::vector<DistanceInputs<float>> inputsXeqYf = {
+  {0.001f, 1024, 1024, 32, true, 1234ULL},
+  {0.001f, 1024, 32, 1024, true, 1234ULL},
+  {0.003f, 1024, 1024, 1024, true, 1234ULL},
+  {0.001f, 1024, 1024, 32, false, 1234ULL},
+  {0.001f, 1024, 32, 1024, false, 1234ULL},
+  {0.003f, 1024, 1024, 1024, false, 1234ULL},
+};
+typedef DistanceKLDivergenceXequalY<float> DistanceKLDivergenceXequalYF;
+TEST_P(DistanceKLDivergenceXequalYF, Result)
+{
+  int m = params.m;
+  ASSERT_TRUE(raft::devArrMatch(dist_ref[0].data(),
+                                dist[0].data(),
+                                m,
+                                m,
+                                raft::CompareApprox<float>(params.tolerance),
+                                stream));
+  ASSERT_TRUE(raft::devArrMatch(dist_ref[1].data(),
+                                dist[1].data(),
+                                m / 2,
+                                m,
+                                raft::CompareApprox<float>(params.tolerance),
+                                stream));
+  ASSERT_TRUE(diagonalIsZero(dist[0].data(), m, params.tolerance, stream));
+}
+INSTANTIATE_TEST_CASE_P(DistanceTests,
+                        DistanceKLDivergenceXequalYF,
+                        ::testing::ValuesIn(inputsXeqYf));
+
 const std::vector<DistanceInputs<double>> inputsd = {
   {0.001, 1024, 1024, 32, true, 1234ULL},
   {0.001, 1024, 32, 1024, true, 1234ULL},
@@ -64,6 +98,36 @@ TEST_P(DistanceKLDivergenceD, Result)
 }
 INSTANTIATE_TEST_CASE_P(DistanceTests, DistanceKLDivergenceD, ::testing::ValuesIn(inputsd));
 
+const std::vector<DistanceInputs<double>> inputsXeqYd = {
+  {0.001, 1024, 1024, 32, true, 1234ULL},
+  {0.001, 1024, 32, 1024, true, 1234ULL},
+  {0.003, 1024, 1024, 1024, true, 1234ULL},
+  {0.001, 1024, 1024, 32, false, 1234ULL},
+  {0.001, 1024, 32, 1024, false, 1234ULL},
+  {0.003, 1024, 1024, 1024, false, 1234ULL},
+};
+typedef DistanceKLDivergenceXequalY<double> DistanceKLDivergenceXequalYD;
+TEST_P(DistanceKLDivergenceXequalYD, Result)
+{
+  int m = params.m;
+  ASSERT_TRUE(raft::devArrMatch(dist_ref[0].data(),
+                                dist[0].data(),
+                                m,
+                                m,
+                                raft::CompareApprox<double>(params.tolerance),
+                                stream));
+  ASSERT_TRUE(raft::devArrMatch(dist_ref[1].data(),
+                                dist[1].data(),
+                                m / 2,
+                                m,
+                                raft::CompareApprox<double>(params.tolerance),
+                                stream));
+  ASSERT_TRUE(diagonalIsZero(dist[0].data(), m, params.tolerance, stream));
+}
+INSTANTIATE_TEST_CASE_P(DistanceTests,
+                        DistanceKLDivergenceXequalYD,
+                        ::testing::ValuesIn(inputsXeqYd));
+
 class BigMatrixKLDivergence
   : public BigMatrixDistanceTest<raft::distance::DistanceType::KLDivergence> {};
 TEST_F(BigMatrixKLDivergence, Result) {}
@@ -17,6 +17,8 @@
 #include "../test_utils.cuh"
 #include "distance_base.cuh"
 
+#include <raft/distance/detail/pairwise_matrix/tile_config.hpp>
+
 namespace raft {
 namespace distance {
 
@@ -40,6 +42,12 @@ const std::vector<DistanceInputs<float>> inputsf = {
   {0.001f, 32, 1024, 1024, false, 1234ULL},
   {0.003f, 1024, 1024, 1024, false, 1234ULL},
   {0.003f, 1021, 1021, 1021, false, 1234ULL},
+  // skinny shapes, dispatched to the skinny tile configuration
+  {0.001f, 1, 10000, 128, true, 1234ULL},
+  {0.001f, 16, 4096, 3, true, 1234ULL},
+  {0.001f, 1024, 1024, 16, true, 1234ULL},
+  {0.001f, 1, 10000, 128, false, 1234ULL},
+  {0.001f, 1024, 1024, 2, false, 1234ULL},
 };
 
 const std::vector<DistanceInputs<float>> inputsXeqYf = {
@@ -109,5 +117,24 @@ INSTANTIATE_TEST_CASE_P(DistanceTests, DistanceEucExpTestD, ::testing::ValuesIn(
 
 class BigMatrixEucExp : public BigMatrixDistanceTest<raft::distance::DistanceType::L2Expanded> {};
 TEST_F(BigMatrixEucExp, Result) {}
+TEST(DistanceTileConfig, Lookup)
+{
+  using raft::distance::detail::lookup_tile_config;
+  using raft::distance::detail::tile_config;
+  using raft::distance::detail::tile_entry;
+
+  const std::vector<tile_entry> table = {{4, 1, 65536, 128, tile_config::kPolicy4x4},
+                                         {4, 4096, 4096, 4, tile_config::kPolicy4x4},
+                                         {4, 4096, 4096, 512, tile_config::kPolicy4x4Skinny}};
+  // the nearest entry in the log-space
+  ASSERT_EQ(lookup_tile_config(table, 4, 2, 100000, 100), tile_config::kPolicy4x4);
+  ASSERT_EQ(lookup_tile_config(table, 4, 2048, 8192, 2), tile_config::kPolicy4x4);
+  ASSERT_EQ(lookup_tile_config(table, 4, 100000, 100000, 1000), tile_config::kPolicy4x4Skinny);
+  // no entries of the data type: the default
+  ASSERT_EQ(lookup_tile_config(table, 8, 1, 65536, 128), tile_config::kPolicy4x4Skinny);
+  ASSERT_EQ(lookup_tile_config(table, 8, 4096, 4096, 512), tile_config::kPolicy4x4);
+  ASSERT_EQ(lookup_tile_config({}, 4, 4096, 4096, 16), tile_config::kPolicy4x4Skinny);
+}
+
 }  // end namespace distance
 }  // end namespace raft
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+#include "distance_base.cuh"
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/distance/distance_operand.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <vector>
+
+namespace raft {
+namespace distance {
+
+struct DistanceOperandInputs {
+  raft::distance::DistanceType metric;
+  int m, n, k;
+  unsigned long long int seed;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const DistanceOperandInputs& p)
+{
+  os << "metric: " << int(p.metric) << ", m: " << p.m << ", n: " << p.n << ", k: " << p.k;
+  return os;
+}
+
+class DistanceOperandTest : public ::testing::TestWithParam<DistanceOperandInputs> {
+ public:
+  DistanceOperandTest()
+    : params(::testing::TestWithParam<DistanceOperandInputs>::GetParam()),
+      stream(resource::get_cuda_stream(handle)),
+      x(params.m * params.k, stream),
+      y(params.n * params.k, stream),
+      dist_ref(params.m * params.n, stream)
+  {
+  }
+
+ protected:
+  void SetUp() override
+  {
+    raft::random::RngState r(params.seed);
+    uniform(handle, r, x.data(), params.m * params.k, -1.0f, 1.0f);
+    uniform(handle, r, y.data(), params.n * params.k, -1.0f, 1.0f);
+    naiveDistance(dist_ref.data(),
+                  x.data(),
+                  y.data(),
+                  params.m,
+                  params.n,
+                  params.k,
+                  params.metric,
+                  true,
+                  2.0f,
+                  stream);
+  }
+
+  void runTest()
+  {
+    auto x_v  = make_device_matrix_view<const float, int>(x.data(), params.m, params.k);
+    auto y_v  = make_device_matrix_view<const float, int>(y.data(), params.n, params.k);
+    auto dist = raft::make_device_matrix<float, int>(handle, params.m, params.n);
+
+    distance_operand<float, int> x_op(handle, x_v, params.metric);
+    distance_operand<float, int> y_op(handle, y_v, params.metric);
+    // the same operands serve repeated calls
+    for (int i = 0; i < 2; i++) {
+      RAFT_CUDA_TRY(cudaMemsetAsync(dist.data_handle(), 0, dist.size() * sizeof(float), stream));
+      pairwise_distance(handle, x_op, y_op, dist.view(), params.metric);
+      ASSERT_TRUE(raft::devArrMatch(dist_ref.data(),
+                                    dist.data_handle(),
+                                    params.m * params.n,
+                                    raft::CompareApprox<float>(1e-3f),
+                                    stream));
+    }
+
+    if (params.metric == raft::distance::DistanceType::CorrelationExpanded) { return; }
+    RAFT_CUDA_TRY(cudaMemsetAsync(dist.data_handle(), 0, dist.size() * sizeof(float), stream));
+    pairwise_distance(handle, x_v, y_v, dist.view(), x_op.norms(), y_op.norms(), params.metric);
+    ASSERT_TRUE(raft::devArrMatch(dist_ref.data(),
+                                  dist.data_handle(),
+                                  params.m * params.n,
+                                  raft::CompareApprox<float>(1e-3f),
+                                  stream));
+  }
+
+ protected:
+  raft::resources handle;
+  DistanceOperandInputs params;
+  cudaStream_t stream;
+  rmm::device_uvector<float> x, y, dist_ref;
+};
+
+const std::vector<DistanceOperandInputs> inputs = {
+  {raft::distance::DistanceType::L2Expanded, 1024, 1024, 32, 1234ULL},
+  {raft::distance::DistanceType::L2Expanded, 1000, 37, 129, 1234ULL},
+  {raft::distance::DistanceType::L2SqrtExpanded, 100, 2000, 33, 1234ULL},
+  {raft::distance::DistanceType::CosineExpanded, 517, 1031, 64, 1234ULL},
+  {raft::distance::DistanceType::CosineExpanded, 37, 1000, 17, 1234ULL},
+  {raft::distance::DistanceType::CorrelationExpanded, 1031, 517, 64, 1234ULL},
+};
+
+TEST_P(DistanceOperandTest, Result) { runTest(); }
+INSTANTIATE_TEST_CASE_P(DistanceTests, DistanceOperandTest, ::testing::ValuesIn(inputs));
+
+}  // end namespace distance
+}  // end namespace raft
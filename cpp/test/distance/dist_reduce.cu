@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+#include "distance_base.cuh"
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/distance/pairwise_distance_reduce.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace raft {
+namespace distance {
+
+struct DistanceReduceInputs {
+  raft::distance::DistanceType metric;
+  int m, n, k;
+  bool along_rows;
+  unsigned long long int seed;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const DistanceReduceInputs& p)
+{
+  os << "metric: " << int(p.metric) << ", m: " << p.m << ", n: " << p.n << ", k: " << p.k
+     << ", along_rows: " << p.along_rows;
+  return os;
+}
+
+/** 1 when the distance is within the radius, 0 otherwise. */
+struct within_radius_op {
+  float eps;
+  template <typename IdxT>
+  HDI int operator()(float d, IdxT, IdxT) const
+  {
+    return d <= eps;
+  }
+};
+
+/** The distance itself. */
+struct distance_map_op {
+  template <typename IdxT>
+  HDI float operator()(float d, IdxT, IdxT) const
+  {
+    return d;
+  }
+};
+
+class DistanceReduceTest : public ::testing::TestWithParam<DistanceReduceInputs> {
+ public:
+  DistanceReduceTest()
+    : params(::testing::TestWithParam<DistanceReduceInputs>::GetParam()),
+      stream(resource::get_cuda_stream(handle)),
+      x(params.m * params.k, stream),
+      y(params.n * params.k, stream),
+      dist_ref(params.m * params.n, stream)
+  {
+  }
+
+ protected:
+  void SetUp() override
+  {
+    raft::random::RngState r(params.seed);
+    uniform(handle, r, x.data(), params.m * params.k, 0.0f, 1.0f);
+    uniform(handle, r, y.data(), params.n * params.k, 0.0f, 1.0f);
+    naiveDistance(dist_ref.data(),
+                  x.data(),
+                  y.data(),
+                  params.m,
+                  params.n,
+                  params.k,
+                  params.metric,
+                  true,
+                  2.0f,
+                  stream);
+    std::vector<float> h_dist(params.m * params.n);
+    raft::update_host(h_dist.data(), dist_ref.data(), h_dist.size(), stream);
+    resource::sync_stream(handle, stream);
+
+    // The reductions on the host; the radius is the median distance
+    std::vector<float> sorted(h_dist);
+    std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+    eps           = sorted[sorted.size() / 2];
+    const int len = params.along_rows ? params.m : params.n;
+    count_ref.assign(len, 0);
+    sum_ref.assign(len, 0.0f);
+    min_ref.assign(len, std::numeric_limits<float>::max());
+    for (int i = 0; i < params.m; i++) {
+      for (int j = 0; j < params.n; j++) {
+        const float d = h_dist[i * params.n + j];
+        const int o   = params.along_rows ? i : j;
+        count_ref[o] += d <= eps;
+        sum_ref[o] += d;
+        min_ref[o] = std::min(min_ref[o], d);
+      }
+    }
+  }
+
+  void runTest()
+  {
+    const int len = params.along_rows ? params.m : params.n;
+    auto x_v      = make_device_matrix_view<const float, int>(x.data(), params.m, params.k);
+    auto y_v      = make_device_matrix_view<const float, int>(y.data(), params.n, params.k);
+    auto count    = raft::make_device_vector<int, int>(handle, len);
+    auto sum      = raft::make_device_vector<float, int>(handle, len);
+    auto min      = raft::make_device_vector<float, int>(handle, len);
+
+    pairwise_distance_reduce(handle,
+                             x_v,
+                             y_v,
+                             count.view(),
+                             params.metric,
+                             0,
+                             within_radius_op{eps},
+                             raft::add_op{},
+                             params.along_rows);
+    pairwise_distance_reduce(handle,
+                             x_v,
+                             y_v,
+                             sum.view(),
+                             params.metric,
+                             0.0f,
+                             distance_map_op{},
+                             raft::add_op{},
+                             params.along_rows);
+    pairwise_distance_reduce(handle,
+                             x_v,
+                             y_v,
+                             min.view(),
+                             params.metric,
+                             std::numeric_limits<float>::max(),
+                             distance_map_op{},
+                             raft::min_op{},
+                             params.along_rows);
+
+    // The distances close to the radius may fall on either side of it, allow for a few of them.
+    ASSERT_TRUE(raft::devArrMatchHost(
+      count_ref.data(), count.data_handle(), len, raft::CompareApproxNoScaling<int>(2), stream));
+    ASSERT_TRUE(raft::devArrMatchHost(
+      sum_ref.data(), sum.data_handle(), len, raft::CompareApprox<float>(1e-3f), stream));
+    ASSERT_TRUE(raft::devArrMatchHost(
+      min_ref.data(), min.data_handle(), len, raft::CompareApprox<float>(1e-3f), stream));
+  }
+
+ protected:
+  raft::resources handle;
+  DistanceReduceInputs params;
+  cudaStream_t stream;
+  rmm::device_uvector<float> x, y, dist_ref;
+  float eps;
+  std::vector<int> count_ref;
+  std::vector<float> sum_ref, min_ref;
+};
+
+const std::vector<DistanceReduceInputs> inputs = {
+  {raft::distance::DistanceType::L2Expanded, 1024, 1024, 32, true, 1234ULL},
+  {raft::distance::DistanceType::L2Expanded, 1024, 1024, 32, false, 1234ULL},
+  {raft::distance::DistanceType::L2SqrtExpanded, 100, 2000, 33, true, 1234ULL},
+  {raft::distance::DistanceType::L2SqrtExpanded, 100, 2000, 33, false, 1234ULL},
+  {raft::distance::DistanceType::CosineExpanded, 517, 1031, 64, true, 1234ULL},
+  {raft::distance::DistanceType::L2Unexpanded, 1031, 517, 17, false, 1234ULL},
+  {raft::distance::DistanceType::L1, 1024, 32, 1024, true, 1234ULL},
+  {raft::distance::DistanceType::L1, 32, 1024, 1024, false, 1234ULL},
+  {raft::distance::DistanceType::Linf, 1024, 1024, 32, true, 1234ULL},
+  {raft::distance::DistanceType::Canberra, 1024, 1024, 32, true, 1234ULL},
+  {raft::distance::DistanceType::JensenShannon, 1024, 1024, 32, false, 1234ULL},
+};
+
+TEST_P(DistanceReduceTest, Result) { runTest(); }
+INSTANTIATE_TEST_CASE_P(DistanceTests, DistanceReduceTest, ::testing::ValuesIn(inputs));
+
+}  // end namespace distance
+}  // end namespace raft
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+#include "distance_base.cuh"
+
+#include <raft/core/host_mdarray.hpp>
+#include <raft/distance/pairwise_distance_tiled.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <vector>
+
+namespace raft {
+namespace distance {
+
+struct DistanceTiledInputs {
+  raft::distance::DistanceType metric;
+  int m, n, k;
+  // the bound of the tile size: small enough to split the distance matrix into many tiles
+  size_t max_tile_bytes;
+  unsigned long long int seed;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const DistanceTiledInputs& p)
+{
+  os << "metric: " << int(p.metric) << ", m: " << p.m << ", n: " << p.n << ", k: " << p.k
+     << ", max_tile_bytes: " << p.max_tile_bytes;
+  return os;
+}
+
+class DistanceTiledTest : public ::testing::TestWithParam<DistanceTiledInputs> {
+ public:
+  DistanceTiledTest()
+    : params(::testing::TestWithParam<DistanceTiledInputs>::GetParam()),
+      stream(resource::get_cuda_stream(handle)),
+      x(params.m * params.k, stream),
+      y(params.n * params.k, stream),
+      dist_ref(params.m * params.n, stream),
+      dist(params.m * params.n, stream)
+  {
+  }
+
+ protected:
+  void SetUp() override
+  {
+    raft::random::RngState r(params.seed);
+    uniform(handle, r, x.data(), params.m * params.k, 0.0f, 1.0f);
+    uniform(handle, r, y.data(), params.n * params.k, 0.0f, 1.0f);
+    naiveDistance(dist_ref.data(),
+                  x.data(),
+                  y.data(),
+                  params.m,
+                  params.n,
+                  params.k,
+                  params.metric,
+                  true,
+                  2.0f,
+                  stream);
+  }
+
+  void runTest()
+  {
+    auto x_v = make_device_matrix_view<const float, int>(x.data(), params.m, params.k);
+    auto y_v = make_device_matrix_view<const float, int>(y.data(), params.n, params.k);
+
+    // Assemble the distance matrix from the tiles in the stream
+    int n_tiles = 0;
+    pairwise_distance_tiled(
+      handle,
+      x_v,
+      y_v,
+      params.metric,
+      [&](raft::device_matrix_view<const float, int> tile, int row, int col) {
+        RAFT_CUDA_TRY(cudaMemcpy2DAsync(dist.data() + size_t(row) * params.n + col,
+                                        params.n * sizeof(float),
+                                        tile.data_handle(),
+                                        tile.extent(1) * sizeof(float),
+                                        tile.extent(1) * sizeof(float),
+                                        tile.extent(0),
+                                        cudaMemcpyDeviceToDevice,
+                                        stream));
+        n_tiles++;
+      },
+      params.max_tile_bytes);
+    ASSERT_GT(n_tiles, 1);
+    ASSERT_TRUE(raft::devArrMatch(dist_ref.data(),
+                                  dist.data(),
+                                  params.m * params.n,
+                                  raft::CompareApprox<float>(1e-3f),
+                                  stream));
+
+    auto h_dist = raft::make_host_matrix<float, int>(params.m, params.n);
+    pairwise_distance_tiled(handle, x_v, y_v, h_dist.view(), params.metric, params.max_tile_bytes);
+    ASSERT_TRUE(raft::devArrMatchHost(h_dist.data_handle(),
+                                      dist_ref.data(),
+                                      params.m * params.n,
+                                      raft::CompareApprox<float>(1e-3f),
+                                      stream));
+  }
+
+ protected:
+  raft::resources handle;
+  DistanceTiledInputs params;
+  cudaStream_t stream;
+  rmm::device_uvector<float> x, y, dist_ref, dist;
+};
+
+const std::vector<DistanceTiledInputs> inputs = {
+  // tiles of whole rows
+  {raft::distance::DistanceType::L2Expanded, 1024, 1024, 32, 64 * 1024 * sizeof(float), 1234ULL},
+  {raft::distance::DistanceType::L2SqrtExpanded, 1000, 517, 33, 100000, 1234ULL},
+  {raft::distance::DistanceType::CosineExpanded, 517, 1031, 64, 65536, 1234ULL},
+  {raft::distance::DistanceType::L1, 100, 2000, 17, 16 * 2000 * sizeof(float), 1234ULL},
+  // tiles of parts of a row
+  {raft::distance::DistanceType::L2Unexpanded, 37, 5000, 16, 1000 * sizeof(float), 1234ULL},
+  {raft::distance::DistanceType::Linf, 3, 10007, 8, 4096, 1234ULL},
+};
+
+TEST_P(DistanceTiledTest, Result) { runTest(); }
+INSTANTIATE_TEST_CASE_P(DistanceTests, DistanceTiledTest, ::testing::ValuesIn(inputs));
+
+}  // end namespace distance
+}  // end namespace raft
@@ -27,6 +27,9 @@
 #include <raft/random/rng.cuh>
 #include <rmm/device_uvector.hpp>            // rmm::device_uvector
 
+#include <cmath>   // std::abs
+#include <vector>  // std::vector
+
 namespace raft {
 namespace distance {
 
@@ -634,6 +637,28 @@ class DistanceTestSameBuffer : public ::testing::TestWithParam<DistanceInputs<Da
   std::array<dev_vector, N> dist_ref, dist, dist2;
 };
 
+/**
+ * Check that the diagonal of the m x m distance matrix of a dataset to itself is zero up to the
+ * tolerance. The diagonal is at the same offsets in both layouts.
+ */
+template <typename DataType>
+::testing::AssertionResult diagonalIsZero(const DataType* dist,
+                                          int m,
+                                          DataType tolerance,
+                                          cudaStream_t stream)
+{
+  std::vector<DataType> dist_h(size_t(m) * size_t(m));
+  raft::update_host(dist_h.data(), dist, dist_h.size(), stream);
+  RAFT_CUDA_TRY(cudaStreamSynchronize(stream));
+  for (int i = 0; i < m; i++) {
+    auto d = dist_h[size_t(i) * size_t(m) + size_t(i)];
+    if (!(std::abs(d) <= tolerance)) {
+      return ::testing::AssertionFailure() << "dist=" << d << " != 0 @" << i << "," << i;
+    }
+  }
+  return ::testing::AssertionSuccess();
+}
+
 template <raft::distance::DistanceType distanceType>
 class BigMatrixDistanceTest : public ::testing::Test {
  public:
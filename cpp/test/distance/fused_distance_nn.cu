@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+#include <gtest/gtest.h>
+#include <raft/core/kvp.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/distance/fused_distance_nn.cuh>
+#include <raft/linalg/norm.cuh>
+#include <raft/random/rng.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace raft {
+namespace distance {
+
+struct FusedDistanceNNInputs {
+  raft::distance::DistanceType metric;
+  float tolerance;
+  int m, n, k;
+  unsigned long long int seed;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const FusedDistanceNNInputs& p)
+{
+  return os << "metric: " << int(p.metric) << ", m: " << p.m << ", n: " << p.n << ", k: " << p.k;
+}
+
+class FusedDistanceNNTest : public ::testing::TestWithParam<FusedDistanceNNInputs> {
+ public:
+  FusedDistanceNNTest()
+    : params(::testing::TestWithParam<FusedDistanceNNInputs>::GetParam()),
+      stream(resource::get_cuda_stream(handle)),
+      x(params.m * params.k, stream),
+      y(params.n * params.k, stream),
+      xn(params.m, stream),
+      yn(params.n, stream),
+      min(params.m, stream),
+      workspace(params.m * sizeof(int), stream)
+  {
+  }
+
+ protected:
+  void SetUp() override
+  {
+    raft::random::RngState r(params.seed);
+    uniform(handle, r, x.data(), params.m * params.k, -1.0f, 1.0f);
+    uniform(handle, r, y.data(), params.n * params.k, -1.0f, 1.0f);
+    if (params.metric == raft::distance::DistanceType::CosineExpanded) {
+      raft::linalg::rowNorm(xn.data(),
+                            x.data(),
+                            params.k,
+                            params.m,
+                            raft::linalg::L2Norm,
+                            true,
+                            stream,
+                            raft::sqrt_op{});
+      raft::linalg::rowNorm(yn.data(),
+                            y.data(),
+                            params.k,
+                            params.n,
+                            raft::linalg::L2Norm,
+                            true,
+                            stream,
+                            raft::sqrt_op{});
+    }
+  }
+
+  // The distances of all pairs on the host, as minimized by the fused kernel.
+  std::vector<float> host_distances()
+  {
+    std::vector<float> h_x(x.size()), h_y(y.size());
+    raft::update_host(h_x.data(), x.data(), x.size(), stream);
+    raft::update_host(h_y.data(), y.data(), y.size(), stream);
+    resource::sync_stream(handle, stream);
+    std::vector<float> dist(size_t(params.m) * params.n);
+    for (int i = 0; i < params.m; i++) {
+      for (int j = 0; j < params.n; j++) {
+        double ip = 0, nx = 0, ny = 0;
+        for (int l = 0; l < params.k; l++) {
+          double a = h_x[i * params.k + l];
+          double b = h_y[j * params.k + l];
+          ip += a * b;
+          nx += a * a;
+          ny += b * b;
+        }
+        dist[size_t(i) * params.n + j] =
+          params.metric == raft::distance::DistanceType::InnerProduct
+            ? -ip
+            : 1.0 - ip / std::sqrt(nx * ny);
+      }
+    }
+    return dist;
+  }
+
+  void runTest()
+  {
+    const bool is_ip = params.metric == raft::distance::DistanceType::InnerProduct;
+    fusedDistanceNNMinReduce<float, raft::KeyValuePair<int, float>, int>(
+      min.data(),
+      x.data(),
+      y.data(),
+      is_ip ? nullptr : xn.data(),
+      is_ip ? nullptr : yn.data(),
+      params.m,
+      params.n,
+      params.k,
+      (void*)workspace.data(),
+      params.metric,
+      true,
+      stream);
+    std::vector<raft::KeyValuePair<int, float>> h_min(params.m);
+    raft::update_host(h_min.data(), min.data(), params.m, stream);
+    auto dist = host_distances();
+
+    // Ties may resolve to any of the neighbors: compare the distances of the selected keys.
+    auto eq = raft::CompareApprox<float>(params.tolerance);
+    for (int i = 0; i < params.m; i++) {
+      float ref = std::numeric_limits<float>::max();
+      for (int j = 0; j < params.n; j++) {
+        ref = std::min(ref, dist[size_t(i) * params.n + j]);
+      }
+      ASSERT_TRUE(h_min[i].key >= 0 && h_min[i].key < params.n) << "row " << i;
+      ASSERT_TRUE(eq(ref, h_min[i].value))
+        << "row " << i << ": " << h_min[i].value << " != " << ref;
+      ASSERT_TRUE(eq(ref, dist[size_t(i) * params.n + h_min[i].key])) << "row " << i;
+    }
+  }
+
+  raft::resources handle;
+  FusedDistanceNNInputs params;
+  cudaStream_t stream;
+  rmm::device_uvector<float> x, y, xn, yn;
+  rmm::device_uvector<raft::KeyValuePair<int, float>> min;
+  rmm::device_uvector<char> workspace;
+};
+
+const std::vector<FusedDistanceNNInputs> inputs = {
+  {raft::distance::DistanceType::InnerProduct, 0.001f, 256, 256, 64, 1234ULL},
+  {raft::distance::DistanceType::InnerProduct, 0.001f, 1000, 37, 17, 1234ULL},
+  {raft::distance::DistanceType::InnerProduct, 0.001f, 37, 1000, 129, 1234ULL},
+  {raft::distance::DistanceType::CosineExpanded, 0.001f, 256, 256, 64, 1234ULL},
+  {raft::distance::DistanceType::CosineExpanded, 0.001f, 1000, 37, 17, 1234ULL},
+  {raft::distance::DistanceType::CosineExpanded, 0.001f, 37, 1000, 129, 1234ULL},
+};
+
+TEST_P(FusedDistanceNNTest, Result) { runTest(); }
+INSTANTIATE_TEST_CASE_P(FusedDistanceNNTests, FusedDistanceNNTest, ::testing::ValuesIn(inputs));
+
+}  // end namespace distance
+}  // end namespace raft
@@ -161,4 +161,103 @@ typedef GramMatrixTest<double> GramMatrixTestDouble;
 TEST_P(GramMatrixTestFloat, Gram) { runTest(); }
 
 INSTANTIATE_TEST_SUITE_P(GramMatrixTests, GramMatrixTestFloat, ::testing::ValuesIn(inputs));
+
+struct BatchedGramMatrixInputs {
+  int batch;
+  int n1;
+  int n2;
+  int n_cols;
+  KernelParams kernel;
+};
+
+std::ostream& operator<<(std::ostream& os, const BatchedGramMatrixInputs& p)
+{
+  std::vector<std::string> kernel_names{"linear", "poly", "rbf", "tanh"};
+  os << "/" << p.batch << "x" << p.n1 << "x" << p.n2 << "x" << p.n_cols << "/"
+     << kernel_names[p.kernel.kernel];
+  return os;
+}
+
+const std::vector<BatchedGramMatrixInputs> inputs_batched = {
+  {1, 42, 137, 2, {KernelType::LINEAR}},
+  {17, 64, 64, 8, {KernelType::LINEAR}},
+  {17, 64, 64, 8, {KernelType::POLYNOMIAL, 2, 0.5, 2.4}},
+  {5, 137, 42, 3, {KernelType::POLYNOMIAL, 3, 0.5, 1.0}},
+  {17, 64, 64, 8, {KernelType::TANH, 0, 0.5, 2.4}},
+  {17, 64, 64, 8, {KernelType::RBF, 0, 0.5}},
+  {3, 129, 200, 16, {KernelType::RBF, 0, 0.1}},
+};
+
+template <typename math_t>
+class BatchedGramMatrixTest : public ::testing::TestWithParam<BatchedGramMatrixInputs> {
+ protected:
+  BatchedGramMatrixTest()
+    : params(GetParam()),
+      stream(resource::get_cuda_stream(handle)),
+      x1(size_t(params.batch) * params.n1 * params.n_cols, stream),
+      x2(size_t(params.batch) * params.n2 * params.n_cols, stream),
+      gram(size_t(params.batch) * params.n1 * params.n2, stream)
+  {
+    raft::random::Rng r(42137ULL);
+    r.uniform(x1.data(), x1.size(), math_t(0), math_t(1), stream);
+    r.uniform(x2.data(), x2.size(), math_t(0), math_t(1), stream);
+  }
+
+  void runTest()
+  {
+    batched_gram_matrix<math_t>(
+      handle,
+      params.kernel,
+      batched_matrix_view<const math_t>(x1.data(), params.batch, params.n1, params.n_cols),
+      batched_matrix_view<const math_t>(x2.data(), params.batch, params.n2, params.n_cols),
+      batched_matrix_view<math_t>(gram.data(), params.batch, params.n1, params.n2));
+
+    // Every matrix of the batch against the single-matrix reference
+    const size_t x1_len   = size_t(params.n1) * params.n_cols;
+    const size_t x2_len   = size_t(params.n2) * params.n_cols;
+    const size_t gram_len = size_t(params.n1) * params.n2;
+    rmm::device_uvector<math_t> x1_b(x1_len, stream);
+    rmm::device_uvector<math_t> x2_b(x2_len, stream);
+    std::vector<math_t> gram_host(gram_len);
+    for (int b = 0; b < params.batch; b++) {
+      raft::copy(x1_b.data(), x1.data() + b * x1_len, x1_len, stream);
+      raft::copy(x2_b.data(), x2.data() + b * x2_len, x2_len, stream);
+      naiveGramMatrixKernel(params.n1,
+                            params.n2,
+                            params.n_cols,
+                            x1_b,
+                            x2_b,
+                            gram_host.data(),
+                            params.n_cols,
+                            params.n_cols,
+                            params.n2,
+                            true,
+                            params.kernel,
+                            stream,
+                            handle);
+      ASSERT_TRUE(raft::devArrMatchHost(gram_host.data(),
+                                        gram.data() + b * gram_len,
+                                        gram_len,
+                                        raft::CompareApprox<math_t>(1e-5f),
+                                        stream))
+        << "batch " << b;
+    }
+  }
+
+  raft::resources handle;
+  BatchedGramMatrixInputs params;
+  cudaStream_t stream;
+
+  rmm::device_uvector<math_t> x1;
+  rmm::device_uvector<math_t> x2;
+  rmm::device_uvector<math_t> gram;
+};
+
+typedef BatchedGramMatrixTest<float> BatchedGramMatrixTestFloat;
+
+TEST_P(BatchedGramMatrixTestFloat, Gram) { runTest(); }
+
+INSTANTIATE_TEST_SUITE_P(GramMatrixTests,
+                         BatchedGramMatrixTestFloat,
+                         ::testing::ValuesIn(inputs_batched));
 };  // end namespace raft::distance::kernels
@@ -22,7 +22,10 @@
 #include <raft/util/cuda_utils.cuh>
 #include <raft/util/cudart_utils.hpp>
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
+#include <random>
 #include <vector>
 
 namespace raft {
@@ -63,6 +66,52 @@ TEST_F(MakeMonotonicTest, Result)
   delete expected_h;
 }
 
+template <typename T>
+void check_make_monotonic(const std::vector<T>& data_h, bool zero_based, cudaStream_t stream)
+{
+  size_t m = data_h.size();
+  std::vector<T> sorted(data_h);
+  std::sort(sorted.begin(), sorted.end());
+  sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+  std::vector<T> expected_h(m);
+  for (size_t i = 0; i < m; i++) {
+    expected_h[i] =
+      T(std::lower_bound(sorted.begin(), sorted.end(), data_h[i]) - sorted.begin()) + !zero_based;
+  }
+
+  rmm::device_uvector<T> data(m, stream);
+  raft::update_device(data.data(), data_h.data(), m, stream);
+  rmm::device_uvector<T> unique(0, stream);
+  int n_unique = getUniquelabels(unique, data.data(), m, stream);
+  ASSERT_EQ(n_unique, int(sorted.size()));
+  ASSERT_TRUE(devArrMatchHost(sorted.data(), unique.data(), n_unique, raft::Compare<T>(), stream));
+
+  // in place
+  make_monotonic(data.data(), data.data(), m, stream, zero_based);
+  ASSERT_TRUE(devArrMatchHost(expected_h.data(), data.data(), m, raft::Compare<T>(), stream));
+}
+
+TEST_F(MakeMonotonicTest, Integral)
+{
+  cudaStream_t stream;
+  RAFT_CUDA_TRY(cudaStreamCreate(&stream));
+
+  constexpr int max32 = std::numeric_limits<int>::max();
+  check_make_monotonic<int>({5, -3, 5, max32, 0, -3, 17, max32}, false, stream);
+  check_make_monotonic<int>({5, -3, 5, max32, 0, -3, 17, max32}, true, stream);
+
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int64_t> dist(-1000000000000LL, 1000000000000LL);
+  std::vector<int64_t> data_h(100000);
+  for (size_t i = 0; i < data_h.size(); i++) {
+    // repeated labels
+    data_h[i] = i % 3 == 0 ? dist(gen) : data_h[i - 1];
+  }
+  data_h.push_back(std::numeric_limits<int64_t>::max());
+  check_make_monotonic<int64_t>(data_h, true, stream);
+  RAFT_CUDA_TRY(cudaStreamDestroy(stream));
+}
+
 TEST(labelTest, Classlabels)
 {
   cudaStream_t stream;
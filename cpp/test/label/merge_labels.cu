@@ -123,7 +123,30 @@ const std::vector<MergeLabelsInputs<int64_t>> merge_inputs_64 = {
    {1, 1, 1, 1, 1, 7, 7, 7}},
 };
 
+// A chain of equivalences through many labels, which the union-find merge resolves in a single
+// pass: labels_a[i] = i + 1 and labels_b[i] = i + 2 for the masked points, so the consecutive
+// masked points merge their groups.
+template <typename Index_>
+MergeLabelsInputs<Index_> chain_inputs(Index_ N, Index_ break_every)
+{
+  MergeLabelsInputs<Index_> p{N, {}, {}, {}, {}};
+  Index_ root = 1;
+  for (Index_ i = 0; i < N; i++) {
+    bool linked = i + 1 < N && (i + 1) % break_every != 0;
+    p.labels_a.push_back(i + 1);
+    p.labels_b.push_back(linked ? i + 2 : i + 1);
+    p.mask.push_back(1);
+    p.expected.push_back(root);
+    if (!linked) { root = i + 2; }
+  }
+  return p;
+}
+
 INSTANTIATE_TEST_CASE_P(MergeLabelsTests, MergeLabelsTestI, ::testing::ValuesIn(merge_inputs_32));
+INSTANTIATE_TEST_CASE_P(MergeLabelsChainTests,
+                        MergeLabelsTestI,
+                        ::testing::Values(chain_inputs<int>(100000, 1000),
+                                          chain_inputs<int>(65536, 65536)));
 INSTANTIATE_TEST_CASE_P(MergeLabelsTests, MergeLabelsTestL, ::testing::ValuesIn(merge_inputs_64));
 
 }  // namespace label
@@ -31,6 +31,7 @@
 #include <omp.h>
 #include <raft/solver/linear_assignment.cuh>
 #include <random>
+#include <vector>
 
 #define PROBLEMSIZE  1000  // Number of rows/columns
 #define BATCHSIZE    10    // Number of problems in the batch
@@ -148,4 +149,72 @@ TEST(Raft, HungarianLongLong)
   hungarian_test<long, long>(PROBLEMSIZE, COSTRANGE, PROBLEMCOUNT, REPETITIONS, BATCHSIZE, long{0});
 }
 
+
+// Solves a batch of small problems and checks the optimality of every one of them: the
+// assignment is a permutation, the duals are feasible and complementary slackness holds.
+template <typename vertex_t, typename weight_t>
+void hungarian_small_test(int problemsize, int costrange, int batchsize, weight_t epsilon)
+{
+  raft::resources handle;
+  auto stream = resource::get_cuda_stream(handle);
+
+  std::vector<weight_t> h_cost(batchsize * problemsize * problemsize);
+  generateProblem(h_cost.data(), batchsize, problemsize, costrange);
+
+  rmm::device_uvector<weight_t> elements_v(h_cost.size(), stream);
+  rmm::device_uvector<vertex_t> row_assignment_v(batchsize * problemsize, stream);
+  rmm::device_uvector<vertex_t> col_assignment_v(batchsize * problemsize, stream);
+  raft::update_device(elements_v.data(), h_cost.data(), h_cost.size(), stream);
+
+  raft::solver::LinearAssignmentProblem<vertex_t, weight_t> lpx(
+    handle, problemsize, batchsize, epsilon);
+  lpx.solve(elements_v.data(), row_assignment_v.data(), col_assignment_v.data());
+
+  std::vector<vertex_t> row_assignment(batchsize * problemsize);
+  std::vector<vertex_t> col_assignment(batchsize * problemsize);
+  std::vector<weight_t> row_duals(problemsize), col_duals(problemsize);
+  raft::update_host(row_assignment.data(), row_assignment_v.data(), row_assignment.size(), stream);
+  raft::update_host(col_assignment.data(), col_assignment_v.data(), col_assignment.size(), stream);
+
+  for (int k = 0; k < batchsize; k++) {
+    raft::update_host(row_duals.data(), lpx.getRowDualVector(k).first, problemsize, stream);
+    raft::update_host(col_duals.data(), lpx.getColDualVector(k).first, problemsize, stream);
+    resource::sync_stream(handle, stream);
+
+    const weight_t* cost = h_cost.data() + size_t(k) * problemsize * problemsize;
+    double primal        = 0;
+    for (int i = 0; i < problemsize; i++) {
+      vertex_t j = row_assignment[k * problemsize + i];
+      ASSERT_TRUE(j >= 0 && j < problemsize) << "problem: " << k << "; row: " << i;
+      ASSERT_EQ(col_assignment[k * problemsize + j], i) << "problem: " << k << "; row: " << i;
+      ASSERT_NEAR(row_duals[i] + col_duals[j], cost[i * problemsize + j], 1e-3);
+      primal += cost[i * problemsize + j];
+      for (int c = 0; c < problemsize; c++) {
+        ASSERT_LE(row_duals[i] + col_duals[c], cost[i * problemsize + c] + 1e-3)
+          << "problem: " << k << "; row: " << i << "; col: " << c;
+      }
+    }
+    ASSERT_NEAR(lpx.getPrimalObjectiveValue(k), primal, 1e-3);
+    ASSERT_NEAR(lpx.getDualObjectiveValue(k), primal, 1e-3 * problemsize);
+  }
+}
+
+TEST(Raft, HungarianSmallIntFloat)
+{
+  hungarian_small_test<int, float>(32, COSTRANGE, 1000, float{1e-6});
+  hungarian_small_test<int, float>(1, COSTRANGE, 10, float{1e-6});
+  hungarian_small_test<int, float>(100, COSTRANGE, 20, float{1e-6});
+}
+
+TEST(Raft, HungarianSmallIntDouble)
+{
+  hungarian_small_test<int, double>(7, COSTRANGE, 1000, double{1e-6});
+}
+
+TEST(Raft, HungarianSmallLongLong)
+{
+  hungarian_small_test<long, long>(32, COSTRANGE, 100, long{0});
+  hungarian_small_test<long, long>(65, 10, 20, long{0});
+}
+
 }  // namespace raft
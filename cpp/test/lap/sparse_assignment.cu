@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/solver/sparse_assignment.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace raft::solver {
+
+struct SparseAssignmentInputs {
+  int n_rows;
+  int n_cols;
+  double density;
+  int cost_range;
+  unsigned long long int seed;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const SparseAssignmentInputs& p)
+{
+  return os << "rows: " << p.n_rows << "; cols: " << p.n_cols << "; density: " << p.density;
+}
+
+// The optimal cost of the dense [n_rows, n_cols] problem, n_rows <= n_cols, by the shortest
+// augmenting path Hungarian algorithm.
+double reference_assignment_cost(const std::vector<double>& cost, int n, int m)
+{
+  const double inf = std::numeric_limits<double>::max();
+  std::vector<double> u(n + 1, 0), v(m + 1, 0);
+  std::vector<int> p(m + 1, 0), way(m + 1, 0);
+  for (int i = 1; i <= n; i++) {
+    p[0]   = i;
+    int j0 = 0;
+    std::vector<double> minv(m + 1, inf);
+    std::vector<bool> used(m + 1, false);
+    do {
+      used[j0]     = true;
+      int i0       = p[j0];
+      int j1       = 0;
+      double delta = inf;
+      for (int j = 1; j <= m; j++) {
+        if (used[j]) continue;
+        double cur = cost[(i0 - 1) * m + (j - 1)] - u[i0] - v[j];
+        if (cur < minv[j]) {
+          minv[j] = cur;
+          way[j]  = j0;
+        }
+        if (minv[j] < delta) {
+          delta = minv[j];
+          j1    = j;
+        }
+      }
+      for (int j = 0; j <= m; j++) {
+        if (used[j]) {
+          u[p[j]] += delta;
+          v[j] -= delta;
+        } else {
+          minv[j] -= delta;
+        }
+      }
+      j0 = j1;
+    } while (p[j0] != 0);
+    do {
+      int j1 = way[j0];
+      p[j0]  = p[j1];
+      j0     = j1;
+    } while (j0 != 0);
+  }
+  double total = 0;
+  for (int j = 1; j <= m; j++) {
+    if (p[j] != 0) total += cost[(p[j] - 1) * m + (j - 1)];
+  }
+  return total;
+}
+
+template <typename T>
+class SparseAssignmentTest : public ::testing::TestWithParam<SparseAssignmentInputs> {
+ public:
+  SparseAssignmentTest()
+    : params(::testing::TestWithParam<SparseAssignmentInputs>::GetParam()),
+      stream(resource::get_cuda_stream(handle)),
+      indptr(params.n_rows + 1, stream),
+      indices(0, stream),
+      values(0, stream)
+  {
+    // random edges, plus those of a random matching of all the rows so that there is one
+    int n = params.n_rows, m = params.n_cols;
+    std::mt19937 gen(params.seed);
+    std::uniform_real_distribution<double> coin(0.0, 1.0);
+    std::uniform_int_distribution<int> costs(0, params.cost_range);
+    std::vector<int> matching(m);
+    std::iota(matching.begin(), matching.end(), 0);
+    std::shuffle(matching.begin(), matching.end(), gen);
+
+    h_indptr.push_back(0);
+    for (int i = 0; i < n; i++) {
+      for (int j = 0; j < m; j++) {
+        if (j == matching[i] || coin(gen) < params.density) {
+          h_indices.push_back(j);
+          h_values.push_back(T(costs(gen)));
+        }
+      }
+      h_indptr.push_back(int(h_indices.size()));
+    }
+    indices.resize(h_indices.size(), stream);
+    values.resize(h_values.size(), stream);
+    raft::update_device(indptr.data(), h_indptr.data(), h_indptr.size(), stream);
+    raft::update_device(indices.data(), h_indices.data(), h_indices.size(), stream);
+    raft::update_device(values.data(), h_values.data(), h_values.size(), stream);
+  }
+
+ protected:
+  void run()
+  {
+    int n = params.n_rows, m = params.n_cols;
+    auto row_assignment = raft::make_device_vector<int, int>(handle, n);
+    auto col_assignment = raft::make_device_vector<int, int>(handle, m);
+    int unassigned      = sparse_linear_assignment(
+      handle, costs_view(), row_assignment.view(), std::make_optional(col_assignment.view()));
+    ASSERT_EQ(unassigned, 0);
+
+    std::vector<int> rows(n), cols(m);
+    raft::update_host(rows.data(), row_assignment.data_handle(), n, stream);
+    raft::update_host(cols.data(), col_assignment.data_handle(), m, stream);
+    resource::sync_stream(handle, stream);
+
+    // a matching over the edges, of the optimal cost
+    const double missing = double(params.cost_range + 1) * (n + 1);
+    std::vector<double> dense(size_t(n) * m, missing);
+    for (int i = 0; i < n; i++) {
+      for (int k = h_indptr[i]; k < h_indptr[i + 1]; k++) {
+        dense[size_t(i) * m + h_indices[k]] = h_values[k];
+      }
+    }
+    double total = 0;
+    for (int i = 0; i < n; i++) {
+      ASSERT_TRUE(rows[i] >= 0 && rows[i] < m) << "row: " << i;
+      ASSERT_EQ(cols[rows[i]], i) << "row: " << i;
+      ASSERT_LT(dense[size_t(i) * m + rows[i]], missing) << "row: " << i;
+      total += dense[size_t(i) * m + rows[i]];
+    }
+    ASSERT_EQ(std::count(cols.begin(), cols.end(), -1), m - n);
+    ASSERT_NEAR(total, reference_assignment_cost(dense, n, m), 1e-6);
+  }
+
+  auto costs_view()
+  {
+    auto structure = raft::make_device_compressed_structure_view<int, int, int>(
+      indptr.data(), indices.data(), params.n_rows, params.n_cols, int(values.size()));
+    return raft::make_device_csr_matrix_view<const T, int, int, int>(values.data(), structure);
+  }
+
+  raft::resources handle;
+  SparseAssignmentInputs params;
+  cudaStream_t stream;
+  std::vector<int> h_indptr, h_indices;
+  std::vector<T> h_values;
+  rmm::device_uvector<int> indptr, indices;
+  rmm::device_uvector<T> values;
+};
+
+using SparseAssignmentTestF = SparseAssignmentTest<float>;
+using SparseAssignmentTestD = SparseAssignmentTest<double>;
+
+TEST_P(SparseAssignmentTestF, Result) { run(); }
+TEST_P(SparseAssignmentTestD, Result) { run(); }
+
+TEST(SparseAssignment, Unassignable)
+{
+  raft::resources handle;
+  auto stream = resource::get_cuda_stream(handle);
+  // the rows 0 and 1 only have the column 0
+  std::vector<int> h_indptr   = {0, 1, 2, 4};
+  std::vector<int> h_indices  = {0, 0, 1, 2};
+  std::vector<float> h_values = {1, 2, 3, 4};
+  rmm::device_uvector<int> indptr(h_indptr.size(), stream), indices(h_indices.size(), stream);
+  rmm::device_uvector<float> values(h_values.size(), stream);
+  raft::update_device(indptr.data(), h_indptr.data(), h_indptr.size(), stream);
+  raft::update_device(indices.data(), h_indices.data(), h_indices.size(), stream);
+  raft::update_device(values.data(), h_values.data(), h_values.size(), stream);
+
+  auto structure = raft::make_device_compressed_structure_view<int, int, int>(
+    indptr.data(), indices.data(), 3, 3, 4);
+  auto costs =
+    raft::make_device_csr_matrix_view<const float, int, int, int>(values.data(), structure);
+  auto row_assignment = raft::make_device_vector<int, int>(handle, 3);
+  auction_params params;
+  params.max_rounds = 1000;
+  std::optional<raft::device_vector_view<int, int>> col_assignment;
+  ASSERT_EQ(sparse_linear_assignment(handle, costs, row_assignment.view(), col_assignment, params),
+            1);
+}
+
+const std::vector<SparseAssignmentInputs> inputs = {{50, 80, 0.2, 100, 1234ULL},
+                                                    {100, 100, 0.1, 1000, 42ULL},
+                                                    {200, 1000, 0.02, 1000, 7ULL},
+                                                    {32, 32, 1.0, 10, 3ULL},
+                                                    {1, 5, 0.5, 10, 11ULL}};
+
+INSTANTIATE_TEST_CASE_P(SparseAssignmentTests,
+                        SparseAssignmentTestF,
+                        ::testing::ValuesIn(inputs));
+INSTANTIATE_TEST_CASE_P(SparseAssignmentTests,
+                        SparseAssignmentTestD,
+                        ::testing::ValuesIn(inputs));
+
+}  // namespace raft::solver
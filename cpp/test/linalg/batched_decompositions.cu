@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+#include <gtest/gtest.h>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/linalg/cholesky.cuh>
+#include <raft/linalg/eig.cuh>
+#include <raft/linalg/svd.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace raft {
+namespace linalg {
+
+struct BatchedDecompositionInputs {
+  double tolerance;
+  int batch_size;
+  int n_rows;
+  int n_cols;
+  unsigned long long int seed;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const BatchedDecompositionInputs& p)
+{
+  os << "{batch_size: " << p.batch_size << ", n_rows: " << p.n_rows << ", n_cols: " << p.n_cols
+     << "}";
+  return os;
+}
+
+/**
+ * Every decomposition is checked by recomputing the input matrices on the host from the factors.
+ */
+template <typename T>
+class BatchedDecompositionTest : public ::testing::TestWithParam<BatchedDecompositionInputs> {
+ public:
+  BatchedDecompositionTest()
+    : params(::testing::TestWithParam<BatchedDecompositionInputs>::GetParam()),
+      stream(resource::get_cuda_stream(handle))
+  {
+  }
+
+ protected:
+  void SetUp() override
+  {
+    std::mt19937 gen(params.seed);
+    std::uniform_real_distribution<T> dist(-1, 1);
+    int b = params.batch_size, m = params.n_rows, n = params.n_cols;
+
+    general_h.resize(size_t(b) * m * n);
+    for (auto& v : general_h) {
+      v = dist(gen);
+    }
+    // symmetric positive definite matrices: G_i^T * G_i + n * I
+    spd_h.assign(size_t(b) * n * n, T(0));
+    for (int i = 0; i < b; i++) {
+      for (int r = 0; r < n; r++) {
+        for (int c = 0; c < n; c++) {
+          T s = r == c ? T(n) : T(0);
+          for (int k = 0; k < m; k++) {
+            s += general_h[(size_t(i) * m + k) * n + r] * general_h[(size_t(i) * m + k) * n + c];
+          }
+          spd_h[(size_t(i) * n + r) * n + c] = s;
+        }
+      }
+    }
+  }
+
+  void testEig()
+  {
+    int b = params.batch_size, n = params.n_cols;
+    rmm::device_uvector<T> in(spd_h.size(), stream);
+    rmm::device_uvector<T> vecs(spd_h.size(), stream);
+    rmm::device_uvector<T> vals(size_t(b) * n, stream);
+    raft::update_device(in.data(), spd_h.data(), spd_h.size(), stream);
+
+    eig_jacobi_batched(handle,
+                       device_batch_matrix_view<const T, int>(in.data(), b, n, n),
+                       device_batch_matrix_view<T, int>(vecs.data(), b, n, n),
+                       raft::make_device_matrix_view<T, int>(vals.data(), b, n),
+                       T(1e-7),
+                       100);
+
+    std::vector<T> vecs_h(vecs.size()), vals_h(vals.size());
+    raft::update_host(vecs_h.data(), vecs.data(), vecs.size(), stream);
+    raft::update_host(vals_h.data(), vals.data(), vals.size(), stream);
+    resource::sync_stream(handle, stream);
+
+    // A = sum_k lambda_k v_k v_k^T, where v_k is the k-th row of the eigenvectors
+    std::vector<T> rec(spd_h.size(), T(0));
+    for (int i = 0; i < b; i++) {
+      for (int k = 0; k < n; k++) {
+        const T* v = vecs_h.data() + (size_t(i) * n + k) * n;
+        T lambda   = vals_h[size_t(i) * n + k];
+        if (k > 0) { ASSERT_LE(vals_h[size_t(i) * n + k - 1], lambda); }
+        for (int r = 0; r < n; r++) {
+          for (int c = 0; c < n; c++) {
+            rec[(size_t(i) * n + r) * n + c] += lambda * v[r] * v[c];
+          }
+        }
+      }
+    }
+    ASSERT_TRUE(hostVecMatch(spd_h, rec, raft::CompareApproxAbs<T>(params.tolerance)));
+  }
+
+  void testSvd()
+  {
+    int b = params.batch_size, m = params.n_rows, n = params.n_cols, k = std::min(m, n);
+    rmm::device_uvector<T> in(general_h.size(), stream);
+    rmm::device_uvector<T> s(size_t(b) * k, stream);
+    rmm::device_uvector<T> u(size_t(b) * m * m, stream);
+    rmm::device_uvector<T> v(size_t(b) * n * n, stream);
+    raft::update_device(in.data(), general_h.data(), general_h.size(), stream);
+
+    svd_jacobi_batched(handle,
+                       device_batch_matrix_view<const T, int>(in.data(), b, m, n),
+                       raft::make_device_matrix_view<T, int>(s.data(), b, k),
+                       device_batch_matrix_view<T, int>(u.data(), b, m, m),
+                       device_batch_matrix_view<T, int>(v.data(), b, n, n),
+                       T(1e-7),
+                       100);
+
+    std::vector<T> s_h(s.size()), u_h(u.size()), v_h(v.size());
+    raft::update_host(s_h.data(), s.data(), s.size(), stream);
+    raft::update_host(u_h.data(), u.data(), u.size(), stream);
+    raft::update_host(v_h.data(), v.data(), v.size(), stream);
+    resource::sync_stream(handle, stream);
+
+    // A = sum_l sigma_l u_l v_l^T, where u_l and v_l are the l-th rows of U and V
+    std::vector<T> rec(general_h.size(), T(0));
+    for (int i = 0; i < b; i++) {
+      for (int l = 0; l < k; l++) {
+        const T* ul = u_h.data() + (size_t(i) * m + l) * m;
+        const T* vl = v_h.data() + (size_t(i) * n + l) * n;
+        T sigma     = s_h[size_t(i) * k + l];
+        if (l > 0) { ASSERT_GE(s_h[size_t(i) * k + l - 1], sigma); }
+        for (int r = 0; r < m; r++) {
+          for (int c = 0; c < n; c++) {
+            rec[(size_t(i) * m + r) * n + c] += sigma * ul[r] * vl[c];
+          }
+        }
+      }
+    }
+    ASSERT_TRUE(hostVecMatch(general_h, rec, raft::CompareApproxAbs<T>(params.tolerance)));
+  }
+
+  void testCholesky()
+  {
+    int b = params.batch_size, n = params.n_cols;
+    rmm::device_uvector<T> a(spd_h.size(), stream);
+    rmm::device_uvector<int> info(b, stream);
+    raft::update_device(a.data(), spd_h.data(), spd_h.size(), stream);
+
+    cholesky_batched(handle,
+                     device_batch_matrix_view<T, int>(a.data(), b, n, n),
+                     std::make_optional(raft::make_device_vector_view<int, int>(info.data(), b)));
+
+    std::vector<T> a_h(a.size());
+    std::vector<int> info_h(b);
+    raft::update_host(a_h.data(), a.data(), a.size(), stream);
+    raft::update_host(info_h.data(), info.data(), b, stream);
+    resource::sync_stream(handle, stream);
+
+    // A = U^T * U, with U the upper triangle of the row-major result
+    std::vector<T> rec(spd_h.size(), T(0));
+    for (int i = 0; i < b; i++) {
+      ASSERT_EQ(info_h[i], 0);
+      const T* u = a_h.data() + size_t(i) * n * n;
+      for (int r = 0; r < n; r++) {
+        for (int c = 0; c < n; c++) {
+          T acc = 0;
+          for (int k = 0; k <= std::min(r, c); k++) {
+            acc += u[k * n + r] * u[k * n + c];
+          }
+          rec[(size_t(i) * n + r) * n + c] = acc;
+        }
+      }
+    }
+    ASSERT_TRUE(hostVecMatch(spd_h, rec, raft::CompareApproxAbs<T>(params.tolerance)));
+  }
+
+ protected:
+  raft::resources handle;
+  BatchedDecompositionInputs params;
+  cudaStream_t stream;
+
+  std::vector<T> general_h, spd_h;
+};
+
+// the sizes above 32 exercise the fallback to one cuSOLVER call per matrix
+const std::vector<BatchedDecompositionInputs> inputsf = {{2e-3, 100, 8, 8, 1234ULL},
+                                                         {2e-3, 64, 20, 12, 1234ULL},
+                                                         {2e-3, 33, 32, 32, 1234ULL},
+                                                         {5e-3, 5, 40, 36, 1234ULL}};
+
+const std::vector<BatchedDecompositionInputs> inputsd = {{1e-6, 100, 8, 8, 1234ULL},
+                                                         {1e-6, 64, 20, 12, 1234ULL},
+                                                         {1e-6, 33, 32, 32, 1234ULL},
+                                                         {1e-6, 5, 40, 36, 1234ULL}};
+
+typedef BatchedDecompositionTest<float> BatchedDecompositionTestF;
+TEST_P(BatchedDecompositionTestF, Eig) { testEig(); }
+TEST_P(BatchedDecompositionTestF, Svd) { testSvd(); }
+TEST_P(BatchedDecompositionTestF, Cholesky) { testCholesky(); }
+
+typedef BatchedDecompositionTest<double> BatchedDecompositionTestD;
+TEST_P(BatchedDecompositionTestD, Eig) { testEig(); }
+TEST_P(BatchedDecompositionTestD, Svd) { testSvd(); }
+TEST_P(BatchedDecompositionTestD, Cholesky) { testCholesky(); }
+
+INSTANTIATE_TEST_SUITE_P(BatchedDecompositionTests,
+                         BatchedDecompositionTestF,
+                         ::testing::ValuesIn(inputsf));
+
+INSTANTIATE_TEST_SUITE_P(BatchedDecompositionTests,
+                         BatchedDecompositionTestD,
+                         ::testing::ValuesIn(inputsd));
+
+}  // end namespace linalg
+}  // end namespace raft
@@ -15,17 +15,23 @@
  */
 
 #include <raft/core/nvtx.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resource/device_id.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/spectral/eigen_solvers.cuh>
 #include <raft/spectral/partition.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
 
 #include <gtest/gtest.h>
 
+#include <cmath>
 #include <cstddef>
 #include <iostream>
 #include <memory>
 #include <type_traits>
+#include <vector>
 
 namespace raft {
 namespace spectral {
@@ -115,5 +121,58 @@ TEST(Raft, SpectralSolvers)
   EXPECT_ANY_THROW(spectral::analyzePartition(h, sm, k, clusters, edgeCut, cost));
 }
 
+TEST(Raft, LobpcgSolver)
+{
+  common::nvtx::range fun_scope("test::LobpcgSolver");
+  using namespace matrix;
+  using index_type = int;
+  using value_type = double;
+
+  raft::resources h;
+  auto stream = resource::get_cuda_stream(h);
+
+  // Laplacian of the path graph, whose eigenvalues are 2 - 2 cos(pi k / n)
+  index_type n{90};
+  std::vector<index_type> ro_h{0}, ci_h;
+  std::vector<value_type> vs_h;
+  for (index_type i = 0; i < n; ++i) {
+    if (i > 0) { ci_h.push_back(i - 1); }
+    if (i < n - 1) { ci_h.push_back(i + 1); }
+    ro_h.push_back(ci_h.size());
+  }
+  vs_h.assign(ci_h.size(), value_type(1));
+  index_type nnz = ci_h.size();
+
+  rmm::device_uvector<index_type> ro(ro_h.size(), stream);
+  rmm::device_uvector<index_type> ci(nnz, stream);
+  rmm::device_uvector<value_type> vs(nnz, stream);
+  raft::update_device(ro.data(), ro_h.data(), ro_h.size(), stream);
+  raft::update_device(ci.data(), ci_h.data(), nnz, stream);
+  raft::update_device(vs.data(), vs_h.data(), nnz, stream);
+  laplacian_matrix_t<index_type, value_type> L{h, ro.data(), ci.data(), vs.data(), n, nnz};
+
+  index_type neigvs{4};
+  eigen_solver_config_t<index_type, value_type> cfg{neigvs, 500, 0, 1.0e-8, false, 1234ULL};
+  lobpcg_solver_t<index_type, value_type> eig_solver{cfg, 8};
+
+  rmm::device_uvector<value_type> eigvals(neigvs, stream);
+  rmm::device_uvector<value_type> eigvecs(size_t(n) * neigvs, stream);
+  std::vector<value_type> eigvals_h(neigvs);
+
+  eig_solver.solve_smallest_eigenvectors(h, L, eigvals.data(), eigvecs.data());
+  raft::update_host(eigvals_h.data(), eigvals.data(), neigvs, stream);
+  resource::sync_stream(h, stream);
+  for (index_type k = 0; k < neigvs; ++k) {
+    EXPECT_NEAR(eigvals_h[k], 2 - 2 * std::cos(M_PI * k / n), 1.0e-5);
+  }
+
+  eig_solver.solve_largest_eigenvectors(h, L, eigvals.data(), eigvecs.data());
+  raft::update_host(eigvals_h.data(), eigvals.data(), neigvs, stream);
+  resource::sync_stream(h, stream);
+  for (index_type k = 0; k < neigvs; ++k) {
+    EXPECT_NEAR(eigvals_h[k], 2 - 2 * std::cos(M_PI * (n - 1 - k) / n), 1.0e-5);
+  }
+}
+
 }  // namespace spectral
 }  // namespace raft
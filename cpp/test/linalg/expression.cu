@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+#include <gtest/gtest.h>
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/operators.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/linalg/expression.cuh>
+#include <raft/random/rng.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <vector>
+
+namespace raft {
+namespace linalg {
+
+template <typename T>
+struct ExpressionInputs {
+  T tolerance;
+  int rows, cols;
+  unsigned long long int seed;
+};
+
+template <typename T>
+::std::ostream& operator<<(::std::ostream& os, const ExpressionInputs<T>& p)
+{
+  os << "{" << p.tolerance << ", " << p.rows << ", " << p.cols << ", " << p.seed << "}";
+  return os;
+}
+
+// y = ((x - mu[j]) / sigma[j]) * w(i, j), the rows of y squared and summed, the columns summed
+template <typename T>
+class ExpressionTest : public ::testing::TestWithParam<ExpressionInputs<T>> {
+ public:
+  ExpressionTest()
+    : params(::testing::TestWithParam<ExpressionInputs<T>>::GetParam()),
+      stream(resource::get_cuda_stream(handle)),
+      x(raft::make_device_matrix<T, int>(handle, params.rows, params.cols)),
+      w(raft::make_device_matrix<T, int>(handle, params.rows, params.cols)),
+      y(raft::make_device_matrix<T, int>(handle, params.rows, params.cols)),
+      mu(raft::make_device_vector<T, int>(handle, params.cols)),
+      sigma(raft::make_device_vector<T, int>(handle, params.cols)),
+      row_sums(raft::make_device_vector<T, int>(handle, params.rows)),
+      col_sums(raft::make_device_vector<T, int>(handle, params.cols)),
+      y_ref(params.rows * params.cols),
+      row_sums_ref(params.rows),
+      col_sums_ref(params.cols)
+  {
+  }
+
+ protected:
+  void SetUp() override
+  {
+    raft::random::RngState r(params.seed);
+    int rows = params.rows, cols = params.cols;
+    size_t len = size_t(rows) * cols;
+    uniform(handle, r, x.data_handle(), len, T(-1.0), T(1.0));
+    uniform(handle, r, w.data_handle(), len, T(-1.0), T(1.0));
+    uniform(handle, r, mu.data_handle(), cols, T(-1.0), T(1.0));
+    uniform(handle, r, sigma.data_handle(), cols, T(0.5), T(2.0));
+
+    std::vector<T> h_x(len), h_w(len), h_mu(cols), h_sigma(cols);
+    raft::update_host(h_x.data(), x.data_handle(), len, stream);
+    raft::update_host(h_w.data(), w.data_handle(), len, stream);
+    raft::update_host(h_mu.data(), mu.data_handle(), cols, stream);
+    raft::update_host(h_sigma.data(), sigma.data_handle(), cols, stream);
+    RAFT_CUDA_TRY(cudaStreamSynchronize(stream));
+    for (int i = 0; i < rows; i++) {
+      row_sums_ref[i] = 0;
+      for (int j = 0; j < cols; j++) {
+        size_t idx = size_t(i) * cols + j;
+        y_ref[idx] = (h_x[idx] - h_mu[j]) / h_sigma[j] * h_w[idx];
+        row_sums_ref[i] += y_ref[idx] * y_ref[idx];
+        col_sums_ref[j] = (i == 0 ? T(0) : col_sums_ref[j]) + y_ref[idx];
+      }
+    }
+
+    auto expr = make_expression(raft::make_const_mdspan(x.view()))
+                  .map_cols(raft::sub_op{}, raft::make_const_mdspan(mu.view()))
+                  .map_cols(raft::div_op{}, raft::make_const_mdspan(sigma.view()))
+                  .zip(raft::mul_op{}, raft::make_const_mdspan(w.view()));
+    evaluate(handle, expr, y.view());
+    evaluate_reduce(handle, expr.map(raft::sq_op{}), row_sums.view(), T(0), Apply::ALONG_ROWS);
+    evaluate_reduce(handle, expr, col_sums.view(), T(0), Apply::ALONG_COLUMNS);
+    RAFT_CUDA_TRY(cudaStreamSynchronize(stream));
+  }
+
+ protected:
+  raft::resources handle;
+  cudaStream_t stream;
+
+  ExpressionInputs<T> params;
+  raft::device_matrix<T, int> x, w, y;
+  raft::device_vector<T, int> mu, sigma, row_sums, col_sums;
+  std::vector<T> y_ref, row_sums_ref, col_sums_ref;
+};
+
+const std::vector<ExpressionInputs<float>> inputsf = {{0.0001f, 1024, 32, 1234ULL},
+                                                      {0.0001f, 1024, 33, 1234ULL},
+                                                      {0.0001f, 7, 1000, 1234ULL},
+                                                      {0.01f, 20000, 17, 1234ULL},
+                                                      {0.001f, 100, 4096, 1234ULL}};
+
+const std::vector<ExpressionInputs<double>> inputsd = {{0.000001, 1024, 32, 1234ULL},
+                                                       {0.000001, 1024, 33, 1234ULL},
+                                                       {0.000001, 20000, 17, 1234ULL}};
+
+typedef ExpressionTest<float> ExpressionTestF;
+TEST_P(ExpressionTestF, Result)
+{
+  ASSERT_TRUE(raft::devArrMatchHost(y_ref.data(),
+                                    y.data_handle(),
+                                    y_ref.size(),
+                                    raft::CompareApprox<float>(params.tolerance),
+                                    stream));
+  ASSERT_TRUE(raft::devArrMatchHost(row_sums_ref.data(),
+                                    row_sums.data_handle(),
+                                    params.rows,
+                                    raft::CompareApprox<float>(params.tolerance),
+                                    stream));
+  ASSERT_TRUE(raft::devArrMatchHost(col_sums_ref.data(),
+                                    col_sums.data_handle(),
+                                    params.cols,
+                                    raft::CompareApprox<float>(params.tolerance),
+                                    stream));
+}
+
+typedef ExpressionTest<double> ExpressionTestD;
+TEST_P(ExpressionTestD, Result)
+{
+  ASSERT_TRUE(raft::devArrMatchHost(y_ref.data(),
+                                    y.data_handle(),
+                                    y_ref.size(),
+                                    raft::CompareApprox<double>(params.tolerance),
+                                    stream));
+  ASSERT_TRUE(raft::devArrMatchHost(row_sums_ref.data(),
+                                    row_sums.data_handle(),
+                                    params.rows,
+                                    raft::CompareApprox<double>(params.tolerance),
+                                    stream));
+  ASSERT_TRUE(raft::devArrMatchHost(col_sums_ref.data(),
+                                    col_sums.data_handle(),
+                                    params.cols,
+                                    raft::CompareApprox<double>(params.tolerance),
+                                    stream));
+}
+
+INSTANTIATE_TEST_SUITE_P(ExpressionTests, ExpressionTestF, ::testing::ValuesIn(inputsf));
+INSTANTIATE_TEST_SUITE_P(ExpressionTests, ExpressionTestD, ::testing::ValuesIn(inputsd));
+
+}  // end namespace linalg
+}  // end namespace raft
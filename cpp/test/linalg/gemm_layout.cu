@@ -16,10 +16,18 @@
 
 #include "../test_utils.cuh"
 #include <gtest/gtest.h>
+#include <raft/core/device_mdarray.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/linalg/gemm.cuh>
 #include <raft/random/rng.cuh>
 #include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <cuda_fp16.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
 
 namespace raft {
 namespace linalg {
@@ -175,5 +183,83 @@ INSTANTIATE_TEST_SUITE_P(GemmLayoutTests, GemmLayoutTestF, ::testing::ValuesIn(i
 
 INSTANTIATE_TEST_SUITE_P(GemmLayoutTests, GemmLayoutTestD, ::testing::ValuesIn(inputsd));
 
+namespace {
+/**
+ * Z = relu(alpha . X * Y + row_add + col_add) through the mixed-precision gemm, compared to a
+ * host reference computed from the inputs rounded to InT.
+ */
+template <typename InT, typename OutT, typename LayoutPolicyZ>
+void test_gemm_mixed(int M, int N, int K, GemmCompute compute, double tolerance)
+{
+  raft::resources handle;
+  cudaStream_t stream = resource::get_cuda_stream(handle);
+
+  std::mt19937 gen(1234);
+  std::uniform_real_distribution<float> dist(-1, 1);
+  std::vector<InT> x_h(M * K), y_h(K * N);
+  std::vector<OutT> row_add_h(M), col_add_h(N);
+  for (auto& v : x_h) {
+    v = InT(dist(gen));
+  }
+  for (auto& v : y_h) {
+    v = InT(dist(gen));
+  }
+  for (auto& v : row_add_h) {
+    v = OutT(dist(gen));
+  }
+  for (auto& v : col_add_h) {
+    v = OutT(dist(gen));
+  }
+
+  auto x       = raft::make_device_matrix<InT, int, raft::row_major>(handle, M, K);
+  auto y       = raft::make_device_matrix<InT, int, raft::row_major>(handle, K, N);
+  auto z       = raft::make_device_matrix<OutT, int, LayoutPolicyZ>(handle, M, N);
+  auto row_add = raft::make_device_vector<OutT, int>(handle, M);
+  auto col_add = raft::make_device_vector<OutT, int>(handle, N);
+  raft::update_device(x.data_handle(), x_h.data(), x_h.size(), stream);
+  raft::update_device(y.data_handle(), y_h.data(), y_h.size(), stream);
+  raft::update_device(row_add.data_handle(), row_add_h.data(), M, stream);
+  raft::update_device(col_add.data_handle(), col_add_h.data(), N, stream);
+
+  gemm_epilogue<OutT, int> epilogue;
+  epilogue.row_add = raft::make_const_mdspan(row_add.view());
+  epilogue.col_add = raft::make_const_mdspan(col_add.view());
+  epilogue.relu    = true;
+  gemm(handle,
+       raft::make_const_mdspan(x.view()),
+       raft::make_const_mdspan(y.view()),
+       z.view(),
+       compute,
+       0.5,
+       0.0,
+       epilogue);
+
+  std::vector<OutT> z_h(M * N);
+  raft::update_host(z_h.data(), z.data_handle(), z_h.size(), stream);
+  resource::sync_stream(handle, stream);
+  constexpr bool kZColMajor = std::is_same_v<LayoutPolicyZ, raft::col_major>;
+  for (int i = 0; i < M; i++) {
+    for (int j = 0; j < N; j++) {
+      double ref = 0;
+      for (int k = 0; k < K; k++) {
+        ref += double(float(x_h[i * K + k])) * double(float(y_h[k * N + j]));
+      }
+      ref = std::max(0.5 * ref + double(float(row_add_h[i])) + double(float(col_add_h[j])), 0.0);
+      double act = float(z_h[kZColMajor ? j * M + i : i * N + j]);
+      ASSERT_NEAR(ref, act, tolerance) << "at (" << i << ", " << j << ")";
+    }
+  }
+}
+}  // namespace
+
+TEST(GemmMixedPrecision, Result)
+{
+  test_gemm_mixed<half, float, raft::row_major>(70, 90, 64, GemmCompute::DEFAULT, 1e-4);
+  test_gemm_mixed<half, float, raft::col_major>(70, 90, 64, GemmCompute::DEFAULT, 1e-4);
+  test_gemm_mixed<half, half, raft::row_major>(33, 40, 32, GemmCompute::FP16, 5e-2);
+  test_gemm_mixed<float, float, raft::row_major>(64, 129, 100, GemmCompute::TF32, 5e-2);
+  test_gemm_mixed<double, double, raft::col_major>(20, 30, 40, GemmCompute::DEFAULT, 1e-10);
+}
+
 }  // end namespace linalg
 }  // end namespace raft
@@ -16,7 +16,9 @@
 
 #include "../test_utils.cuh"
 #include <gtest/gtest.h>
+#include <raft/core/device_mdarray.hpp>
 #include <raft/core/device_resources.hpp>
+#include <raft/core/host_mdarray.hpp>
 #include <raft/linalg/rsvd.cuh>
 #include <raft/linalg/svd.cuh>
 #include <raft/matrix/diagonal.cuh>
@@ -24,6 +26,9 @@
 #include <raft/util/cuda_utils.cuh>
 #include <raft/util/cudart_utils.hpp>
 
+#include <random>
+#include <vector>
+
 namespace raft {
 namespace linalg {
 
@@ -242,5 +247,88 @@ TEST_P(randomized_svdTestD, Result)
 
 INSTANTIATE_TEST_SUITE_P(randomized_svdTests1, randomized_svdTestF, ::testing::ValuesIn(inputsf1));
 INSTANTIATE_TEST_SUITE_P(randomized_svdTests1, randomized_svdTestD, ::testing::ValuesIn(inputsd1));
+/**
+ * The streaming rSVD of an exactly low-rank host matrix, read by blocks that do not divide its
+ * number of rows, must reconstruct the matrix.
+ */
+template <typename T>
+void streaming_randomized_svd_test(T tolerance)
+{
+  raft::device_resources handle;
+  auto stream    = handle.get_stream();
+  int n_rows     = 2000;
+  int n_cols     = 64;
+  int rank       = 5;
+  int batch_rows = 300;
+
+  std::mt19937 gen(1234);
+  std::uniform_real_distribution<T> dist(-1, 1);
+  std::vector<T> x(n_rows * rank), y(n_cols * rank);
+  for (auto& v : x) {
+    v = dist(gen);
+  }
+  for (auto& v : y) {
+    v = dist(gen);
+  }
+  auto data = raft::make_host_matrix<T, int, raft::row_major>(n_rows, n_cols);
+  for (int i = 0; i < n_rows; i++) {
+    for (int j = 0; j < n_cols; j++) {
+      T s = 0;
+      for (int r = 0; r < rank; r++) {
+        s += x[i * rank + r] * y[j * rank + r];
+      }
+      data(i, j) = s;
+    }
+  }
+
+  auto S = raft::make_device_vector<T, int>(handle, rank);
+  auto U = raft::make_host_matrix<T, int, raft::row_major>(n_rows, rank);
+  auto V = raft::make_device_matrix<T, int, raft::row_major>(handle, rank, n_cols);
+  randomized_svd_streaming(handle,
+                           raft::make_const_mdspan(data.view()),
+                           S.view(),
+                           std::make_optional(U.view()),
+                           std::make_optional(V.view()),
+                           rank,
+                           2,
+                           batch_rows);
+
+  std::vector<T> s_h(rank), v_h(rank * n_cols);
+  raft::update_host(s_h.data(), S.data_handle(), rank, stream);
+  raft::update_host(v_h.data(), V.data_handle(), v_h.size(), stream);
+  handle.sync_stream(stream);
+
+  for (int r = 1; r < rank; r++) {
+    ASSERT_GE(s_h[r - 1], s_h[r]);
+  }
+  for (int i = 0; i < n_rows; i++) {
+    for (int j = 0; j < n_cols; j++) {
+      T s = 0;
+      for (int r = 0; r < rank; r++) {
+        s += U(i, r) * s_h[r] * v_h[r * n_cols + j];
+      }
+      ASSERT_NEAR(data(i, j), s, tolerance) << "at (" << i << ", " << j << ")";
+    }
+  }
+
+  // without the singular vectors
+  randomized_svd_streaming(handle,
+                           raft::make_const_mdspan(data.view()),
+                           S.view(),
+                           std::nullopt,
+                           std::nullopt,
+                           rank,
+                           2,
+                           batch_rows);
+  std::vector<T> s2_h(rank);
+  raft::update_host(s2_h.data(), S.data_handle(), rank, stream);
+  handle.sync_stream(stream);
+  for (int r = 0; r < rank; r++) {
+    ASSERT_NEAR(s_h[r], s2_h[r], tolerance * s_h[0]);
+  }
+}
+
+TEST(randomized_svdTest, StreamingF) { streaming_randomized_svd_test<float>(5e-3f); }
+TEST(randomized_svdTest, StreamingD) { streaming_randomized_svd_test<double>(1e-6); }
 }  // end namespace linalg
 }  // end namespace raft
@@ -76,6 +76,7 @@ struct ReduceRowsInputs {
   unsigned long long int seed;
   bool weighted;
   T max_weight;
+  ReduceRowsByKeyAlgo algo = ReduceRowsByKeyAlgo::AUTO;
 };
 
 template <typename T>
@@ -139,8 +140,15 @@ class ReduceRowTest : public ::testing::TestWithParam<ReduceRowsInputs<T>> {
       weights_view.emplace(weight.data(), static_cast<uint32_t>(params.nobs));
     }
 
-    reduce_rows_by_key(
-      handle, input_view, keys_view, output_view, params.nkeys, scratch_buf_view, weights_view);
+    reduce_rows_by_key(handle,
+                       input_view,
+                       keys_view,
+                       output_view,
+                       params.nkeys,
+                       scratch_buf_view,
+                       weights_view,
+                       true,
+                       params.algo);
     resource::sync_stream(handle, stream);
   }
 
@@ -258,5 +266,25 @@ INSTANTIATE_TEST_CASE_P(ReduceRowTests,
                         ReduceRowTestManyClusters,
                         ::testing::ValuesIn(inputsf_many_cluster));
 
+// ReduceRowTestAlgos
+// Every strategy, up to 20000 clusters
+const std::vector<ReduceRowsInputs<float>> inputsf_algos = {
+  {0.00001f, 100000, 37, 32, 1234ULL, false, 1.0, ReduceRowsByKeyAlgo::ATOMIC},
+  {0.00001f, 100000, 37, 32, 1234ULL, true, 4.0, ReduceRowsByKeyAlgo::SHARED_BINS},
+  {0.00001f, 100000, 37, 32, 1234ULL, true, 4.0, ReduceRowsByKeyAlgo::SORTED},
+  {0.00001f, 100000, 37, 2048, 1234ULL, true, 16.0, ReduceRowsByKeyAlgo::SORTED},
+  {0.00001f, 100000, 5, 300, 1234ULL, true, 16.0, ReduceRowsByKeyAlgo::SHARED_BINS},
+  {0.00001f, 100000, 40, 20000, 1234ULL, false, 1.0, ReduceRowsByKeyAlgo::AUTO},
+  {0.00001f, 100000, 40, 20000, 1234ULL, true, 8.0, ReduceRowsByKeyAlgo::SORTED}};
+typedef ReduceRowTest<float> ReduceRowTestAlgos;
+TEST_P(ReduceRowTestAlgos, Result)
+{
+  ASSERT_TRUE(raft::devArrMatch(out_ref.data(),
+                                out.data(),
+                                params.cols * params.nkeys,
+                                raft::CompareApprox<float>(params.tolerance)));
+}
+INSTANTIATE_TEST_CASE_P(ReduceRowTests, ReduceRowTestAlgos, ::testing::ValuesIn(inputsf_algos));
+
 }  // end namespace linalg
 }  // end namespace raft
@@ -27,6 +27,11 @@
 
 #include <rmm/device_uvector.hpp>
 
+#include <cuda_fp16.h>
+
+#include <cstdint>
+#include <vector>
+
 namespace raft {
 namespace linalg {
 
@@ -261,5 +266,84 @@ TEST(TransposeTest, SubMatrix)
   test_transpose_submatrix<float, layout_f_contiguous>();
   test_transpose_submatrix<double, layout_f_contiguous>();
 }
+namespace {
+/** Offset of the element (i, j) of a contiguous [n_rows x n_cols] matrix. */
+template <typename LayoutPolicy>
+size_t offset_of(size_t i, size_t j, size_t n_rows, size_t n_cols)
+{
+  return std::is_same_v<LayoutPolicy, layout_c_contiguous> ? i * n_cols + j : j * n_rows + i;
+}
+
+template <typename InT, typename OutT, typename LayoutPolicy>
+void test_transpose_convert(int n_rows, int n_cols)
+{
+  raft::resources handle;
+  auto stream = resource::get_cuda_stream(handle);
+  std::vector<InT> in_h(size_t(n_rows) * n_cols);
+  for (size_t k = 0; k < in_h.size(); ++k) {
+    in_h[k] = static_cast<InT>(k % 251);
+  }
+  auto in  = make_device_matrix<InT, int, LayoutPolicy>(handle, n_rows, n_cols);
+  auto out = make_device_matrix<OutT, int, LayoutPolicy>(handle, n_cols, n_rows);
+  raft::update_device(in.data_handle(), in_h.data(), in_h.size(), stream);
+
+  ::raft::linalg::transpose(handle, raft::make_const_mdspan(in.view()), out.view());
+
+  std::vector<OutT> out_h(in_h.size());
+  raft::update_host(out_h.data(), out.data_handle(), out_h.size(), stream);
+  resource::sync_stream(handle, stream);
+  for (int i = 0; i < n_rows; ++i) {
+    for (int j = 0; j < n_cols; ++j) {
+      ASSERT_EQ(static_cast<float>(out_h[offset_of<LayoutPolicy>(j, i, n_cols, n_rows)]),
+                static_cast<float>(in_h[offset_of<LayoutPolicy>(i, j, n_rows, n_cols)]));
+    }
+  }
+}
+
+template <typename T, typename LayoutPolicy>
+void test_transpose_inplace(int n_rows, int n_cols)
+{
+  raft::resources handle;
+  auto stream = resource::get_cuda_stream(handle);
+  std::vector<T> in_h(size_t(n_rows) * n_cols);
+  for (size_t k = 0; k < in_h.size(); ++k) {
+    in_h[k] = static_cast<T>(k);
+  }
+  auto m = make_device_matrix<T, int, LayoutPolicy>(handle, n_rows, n_cols);
+  raft::update_device(m.data_handle(), in_h.data(), in_h.size(), stream);
+
+  auto out = transpose_inplace(handle, m.view());
+  ASSERT_EQ(out.extent(0), n_cols);
+  ASSERT_EQ(out.extent(1), n_rows);
+
+  std::vector<T> out_h(in_h.size());
+  raft::update_host(out_h.data(), out.data_handle(), out_h.size(), stream);
+  resource::sync_stream(handle, stream);
+  for (int i = 0; i < n_rows; ++i) {
+    for (int j = 0; j < n_cols; ++j) {
+      ASSERT_EQ(out_h[offset_of<LayoutPolicy>(j, i, n_cols, n_rows)],
+                in_h[offset_of<LayoutPolicy>(i, j, n_rows, n_cols)]);
+    }
+  }
+}
+}  // namespace
+
+TEST(TransposeTest, Convert)
+{
+  test_transpose_convert<float, half, layout_c_contiguous>(67, 129);
+  test_transpose_convert<float, half, layout_f_contiguous>(67, 129);
+  test_transpose_convert<uint8_t, float, layout_c_contiguous>(300, 5);
+  test_transpose_convert<uint8_t, float, layout_f_contiguous>(300, 5);
+  test_transpose_convert<int, int, layout_c_contiguous>(33, 1000);
+}
+
+TEST(TransposeTest, InPlace)
+{
+  test_transpose_inplace<float, layout_c_contiguous>(70, 70);
+  test_transpose_inplace<float, layout_c_contiguous>(37, 100);
+  test_transpose_inplace<float, layout_f_contiguous>(37, 100);
+  test_transpose_inplace<double, layout_c_contiguous>(1, 64);
+  test_transpose_inplace<int, layout_f_contiguous>(129, 31);
+}
 }  // end namespace linalg
 }  // end namespace raft
@@ -23,6 +23,7 @@
 #include <raft/core/resources.hpp>
 #include <raft/matrix/col_wise_sort.cuh>
 #include <raft/util/cudart_utils.hpp>
+#include <random>
 #include <rmm/device_uvector.hpp>
 
 namespace raft {
@@ -150,5 +151,80 @@ TEST_P(ColumnSortF, Result)
 
 INSTANTIATE_TEST_CASE_P(ColumnSortTests, ColumnSortF, ::testing::ValuesIn(inputsf1));
 
+/**
+ * Every row holds a permutation of 0..n_col-1 (exact in half precision), with the column indices
+ * as values, so the sorted keys are known and the values must point to them.
+ */
+template <typename KeyT>
+void column_sort_kv_test(int n_row, int n_col, int top, bool ascending, size_t max_workspace)
+{
+  raft::resources handle;
+  auto stream = resource::get_cuda_stream(handle);
+  std::mt19937 gen(1234);
+
+  std::vector<KeyT> h_keys(size_t(n_row) * n_col);
+  std::vector<float> h_perm(n_col);
+  std::vector<uint32_t> h_vals(h_keys.size());
+  for (int i = 0; i < n_row; i++) {
+    std::iota(h_perm.begin(), h_perm.end(), 0.0f);
+    std::shuffle(h_perm.begin(), h_perm.end(), gen);
+    for (int j = 0; j < n_col; j++) {
+      h_keys[size_t(i) * n_col + j] = KeyT(h_perm[j]);
+      h_vals[size_t(i) * n_col + j] = j;
+    }
+  }
+  rmm::device_uvector<KeyT> keys(h_keys.size(), stream);
+  rmm::device_uvector<uint32_t> vals(h_vals.size(), stream);
+  raft::update_device(keys.data(), h_keys.data(), h_keys.size(), stream);
+  raft::update_device(vals.data(), h_vals.data(), h_vals.size(), stream);
+
+  int m_out = top > 0 ? top : n_col;
+  rmm::device_uvector<KeyT> out_keys(size_t(n_row) * m_out, stream);
+  rmm::device_uvector<uint32_t> out_vals(size_t(n_row) * m_out, stream);
+  if (top > 0) {
+    sort_cols_per_row_top<KeyT, uint32_t>(
+      handle,
+      raft::make_device_matrix_view<const KeyT, int64_t>(keys.data(), n_row, n_col),
+      raft::make_device_matrix_view<const uint32_t, int64_t>(vals.data(), n_row, n_col),
+      raft::make_device_matrix_view<KeyT, int64_t>(out_keys.data(), n_row, m_out),
+      raft::make_device_matrix_view<uint32_t, int64_t>(out_vals.data(), n_row, m_out),
+      ascending);
+  } else {
+    sort_cols_per_row_inplace(
+      handle,
+      raft::make_device_matrix_view<KeyT, int>(keys.data(), n_row, n_col),
+      raft::make_device_matrix_view<uint32_t, int>(vals.data(), n_row, n_col),
+      ascending,
+      max_workspace);
+    raft::copy(out_keys.data(), keys.data(), keys.size(), stream);
+    raft::copy(out_vals.data(), vals.data(), vals.size(), stream);
+  }
+
+  std::vector<KeyT> res_keys(out_keys.size());
+  std::vector<uint32_t> res_vals(out_vals.size());
+  raft::update_host(res_keys.data(), out_keys.data(), out_keys.size(), stream);
+  raft::update_host(res_vals.data(), out_vals.data(), out_vals.size(), stream);
+  resource::sync_stream(handle, stream);
+
+  for (int i = 0; i < n_row; i++) {
+    for (int j = 0; j < m_out; j++) {
+      float expected = ascending ? float(j) : float(n_col - 1 - j);
+      size_t o       = size_t(i) * m_out + j;
+      ASSERT_EQ(float(res_keys[o]), expected) << "row " << i << ", column " << j;
+      ASSERT_EQ(float(h_keys[size_t(i) * n_col + res_vals[o]]), expected);
+    }
+  }
+}
+
+TEST(ColumnSortKV, InplaceFloat) { column_sort_kv_test<float>(37, 1000, 0, true, size_t(1) << 28); }
+TEST(ColumnSortKV, InplaceBatched)
+{
+  // one batch holds 5 rows
+  column_sort_kv_test<float>(37, 1000, 0, false, 5 * 1000 * 8 + 10);
+}
+TEST(ColumnSortKV, InplaceHalf) { column_sort_kv_test<half>(20, 2000, 0, true, size_t(1) << 28); }
+TEST(ColumnSortKV, TopFloat) { column_sort_kv_test<float>(50, 10000, 64, true, 0); }
+TEST(ColumnSortKV, TopHalf) { column_sort_kv_test<half>(50, 2048, 100, false, 0); }
+
 }  // end namespace matrix
 }  // end namespace raft
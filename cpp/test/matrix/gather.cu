@@ -208,4 +208,65 @@ GATHER_TEST((GatherTest<true, true, float, int64_t, int64_t>),
             GatherIfTransformTestFI64I64,
             inputs_i64);
 
-}  // end namespace raft
\ No newline at end of file
+template <typename InT, typename IdxT>
+void gather_fused_test(IdxT n_rows, IdxT n_cols, IdxT map_length, IdxT n_centers)
+{
+  raft::resources handle;
+  auto stream = resource::get_cuda_stream(handle);
+
+  std::vector<InT> h_in(n_rows * n_cols);
+  std::vector<uint32_t> h_map(map_length), h_labels(map_length);
+  std::vector<float> h_centers(n_centers * n_cols);
+  for (IdxT i = 0; i < n_rows * n_cols; i++) {
+    h_in[i] = static_cast<InT>((i * 7) % 251);
+  }
+  for (IdxT i = 0; i < map_length; i++) {
+    h_map[i]    = (i * 13) % n_rows;
+    h_labels[i] = (i * 5) % n_centers;
+  }
+  for (IdxT i = 0; i < n_centers * n_cols; i++) {
+    h_centers[i] = 0.5f * (i % 17);
+  }
+
+  // reference: out = float(in[map[i]]) - centers[labels[i]], norms = |out_i|^2
+  std::vector<float> h_out(map_length * n_cols), h_norms(map_length, 0.0f);
+  for (IdxT i = 0; i < map_length; i++) {
+    for (IdxT j = 0; j < n_cols; j++) {
+      float v =
+        static_cast<float>(h_in[h_map[i] * n_cols + j]) - h_centers[h_labels[i] * n_cols + j];
+      h_out[i * n_cols + j] = v;
+      h_norms[i] += v * v;
+    }
+  }
+
+  rmm::device_uvector<InT> d_in(h_in.size(), stream);
+  rmm::device_uvector<uint32_t> d_map(map_length, stream), d_labels(map_length, stream);
+  rmm::device_uvector<float> d_centers(h_centers.size(), stream);
+  rmm::device_uvector<float> d_out(h_out.size(), stream), d_norms(map_length, stream);
+  raft::update_device(d_in.data(), h_in.data(), h_in.size(), stream);
+  raft::update_device(d_map.data(), h_map.data(), map_length, stream);
+  raft::update_device(d_labels.data(), h_labels.data(), map_length, stream);
+  raft::update_device(d_centers.data(), h_centers.data(), h_centers.size(), stream);
+
+  raft::matrix::gather_fused(
+    handle,
+    raft::make_device_matrix_view<const InT, IdxT>(d_in.data(), n_rows, n_cols),
+    raft::make_device_vector_view<const uint32_t, IdxT>(d_map.data(), map_length),
+    raft::make_device_matrix_view<float, IdxT>(d_out.data(), map_length, n_cols),
+    std::make_optional(raft::make_device_vector_view<float, IdxT>(d_norms.data(), map_length)),
+    std::make_optional(
+      raft::make_device_matrix_view<const float, IdxT>(d_centers.data(), n_centers, n_cols)),
+    std::make_optional(
+      raft::make_device_vector_view<const uint32_t, IdxT>(d_labels.data(), map_length)));
+
+  ASSERT_TRUE(
+    devArrMatchHost(h_out.data(), d_out.data(), h_out.size(), raft::Compare<float>(), stream));
+  ASSERT_TRUE(devArrMatchHost(
+    h_norms.data(), d_norms.data(), map_length, raft::CompareApprox<float>(1e-5), stream));
+}
+
+TEST(GatherFusedTest, Uint8) { gather_fused_test<uint8_t, int>(100, 64, 333, 7); }
+TEST(GatherFusedTest, Uint8Unaligned) { gather_fused_test<uint8_t, int>(100, 37, 333, 7); }
+TEST(GatherFusedTest, Float) { gather_fused_test<float, int64_t>(500, 96, 1000, 3); }
+
+}  // end namespace raft
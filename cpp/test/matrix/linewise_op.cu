@@ -137,7 +137,7 @@ struct LinewiseTest : public ::testing::TestWithParam<typename ParamsReader::Par
       I m = I(floor(y));
       if (n > 0 && m > 0) out.push_back(std::make_tuple(n, m));
     };
-    std::vector<double> sizes = {15, 16, 17, 256, 257, 263, 1024};
+    std::vector<double> sizes = {2, 8, 15, 16, 17, 256, 257, 263, 1024, 36864};
     addIfMakesSense(squareN, squareN);
     for (I k : sizes) {
       addIfMakesSense(solveForN(k), k);
@@ -20,6 +20,7 @@
 #include <raft_internal/matrix/select_k.cuh>
 
 #include <raft/core/resources.hpp>
+#include <raft/matrix/detail/select_k_dispatch.hpp>
 #include <raft/random/rng.cuh>
 #include <raft/sparse/detail/utils.h>
 #include <raft/util/cudart_utils.hpp>
@@ -31,6 +32,8 @@
 
 #include <algorithm>
 #include <numeric>
+#include <random>
+#include <sstream>
 
 namespace raft::matrix {
 
@@ -100,6 +103,14 @@ struct io_computed {
           return;
         }
       } break;
+      case select::Algo::kWarpPacked: {
+        if (spec.k > raft::matrix::detail::select::warpsort::kMaxCapacity ||
+            !raft::matrix::detail::select::packed::is_supported<KeyT, IdxT>(
+              in_ids_.data(), spec.len)) {
+          not_supported = true;
+          return;
+        }
+      } break;
       default: break;
     }
 
@@ -333,7 +344,8 @@ INSTANTIATE_TEST_CASE_P(                // NOLINT
                                    select::Algo::kRadix11bitsExtraPass,
                                    select::Algo::kWarpImmediate,
                                    select::Algo::kWarpFiltered,
-                                   select::Algo::kWarpDistributed)));
+                                   select::Algo::kWarpDistributed,
+                                   select::Algo::kWarpPacked)));
 
 template <select::Algo RefAlgo>
 struct with_ref {
@@ -414,7 +426,11 @@ auto inputs_random_largek = testing::Values(select::params{100, 100000, 1000, tr
                                             select::params{100, 100000, 2000, true},
                                             select::params{100, 100000, 100000, true, false},
                                             select::params{100, 100000, 2048, false},
-                                            select::params{100, 100000, 1237, true});
+                                            select::params{100, 100000, 1237, true},
+                                            select::params{100, 100000, 4096, true, false},
+                                            select::params{100, 100000, 50000, false},
+                                            select::params{3, 2000000, 10000, true},
+                                            select::params{3, 2000000, 10000, false, false});
 
 using ReferencedRandomFloatInt =
   SelectK<float, uint32_t, with_ref<select::Algo::kPublicApi>::params_random>;
@@ -429,7 +445,8 @@ INSTANTIATE_TEST_CASE_P(                          // NOLINT
                                    select::Algo::kWarpImmediate,
                                    select::Algo::kWarpFiltered,
                                    select::Algo::kWarpDistributed,
-                                   select::Algo::kWarpDistributedShm)));
+                                   select::Algo::kWarpDistributedShm,
+                                   select::Algo::kWarpPacked)));
 
 using ReferencedRandomDoubleSizeT =
   SelectK<double, int64_t, with_ref<select::Algo::kPublicApi>::params_random>;
@@ -464,7 +481,252 @@ TEST_P(ReferencedRandomFloatSizeT, LargeK) { run(); }  // NOLINT
 INSTANTIATE_TEST_CASE_P(SelectK,                       // NOLINT
                         ReferencedRandomFloatSizeT,
                         testing::Combine(inputs_random_largek,
-                                         testing::Values(select::Algo::kRadix11bits,
-                                                         select::Algo::kRadix11bitsExtraPass)));
+                                         testing::Values(select::Algo::kPublicApi,
+                                                         select::Algo::kRadix11bits,
+                                                         select::Algo::kRadix11bitsExtraPass,
+                                                         select::Algo::kRadixLargeK)));
+
+
+struct segmented_params {
+  uint32_t batch_size;
+  uint32_t max_len;
+  uint32_t k;
+  bool select_min;
+  bool use_index_input = true;
+};
+
+enum class SegmentedAlgo { kPublicApi, kRadix11bits, kRadix11bitsExtraPass, kWarpAuto };
+
+inline auto operator<<(std::ostream& os, const SegmentedAlgo& algo) -> std::ostream&
+{
+  switch (algo) {
+    case SegmentedAlgo::kPublicApi: return os << "kPublicApi";
+    case SegmentedAlgo::kRadix11bits: return os << "kRadix11bits";
+    case SegmentedAlgo::kRadix11bitsExtraPass: return os << "kRadix11bitsExtraPass";
+    case SegmentedAlgo::kWarpAuto: return os << "kWarpAuto";
+    default: return os << "unknown enum value";
+  }
+}
+
+inline auto operator<<(std::ostream& os, const segmented_params& ss) -> std::ostream&
+{
+  os << "params{batch_size: " << ss.batch_size << ", max_len: " << ss.max_len << ", k: " << ss.k
+     << (ss.select_min ? ", asc" : ", dsc") << (ss.use_index_input ? "" : ", no-input-index")
+     << "}";
+  return os;
+}
+
+/**
+ * Select k values from the rows of variable length and check them against a host reference.
+ * Some rows are shorter than k (down to the empty ones), the output of such rows is padded with
+ * +/-infinity.
+ */
+template <typename KeyT, typename IdxT>
+struct SelectKSegmented  // NOLINT
+  : public testing::TestWithParam<std::tuple<segmented_params, SegmentedAlgo>> {
+  const segmented_params spec;
+  const SegmentedAlgo algo;
+
+  SelectKSegmented()
+    : spec(std::get<0>(GetParam())), algo(std::get<1>(GetParam()))  // NOLINT
+  {
+  }
+
+  void run()
+  {
+    if (algo == SegmentedAlgo::kWarpAuto &&
+        spec.k > raft::matrix::detail::select::warpsort::kMaxCapacity) {
+      GTEST_SKIP();
+    }
+    resources handle{};
+    auto stream = resource::get_cuda_stream(handle);
+
+    // random row lengths, at least one of the rows has the maximum length
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<uint32_t> len_dist(0, spec.max_len);
+    std::vector<IdxT> row_offsets(spec.batch_size + 1, 0);
+    for (uint32_t i = 0; i < spec.batch_size; i++) {
+      auto row_len       = i == spec.batch_size / 2 ? spec.max_len : len_dist(gen);
+      row_offsets[i + 1] = row_offsets[i] + IdxT(row_len);
+    }
+    const auto total_len = size_t(row_offsets[spec.batch_size]);
+
+    rmm::device_uvector<KeyT> in_dists_d(total_len, stream);
+    rmm::device_uvector<IdxT> in_ids_d(total_len, stream);
+    rmm::device_uvector<IdxT> row_offsets_d(row_offsets.size(), stream);
+    rmm::device_uvector<KeyT> out_dists_d(size_t(spec.batch_size) * spec.k, stream);
+    rmm::device_uvector<IdxT> out_ids_d(size_t(spec.batch_size) * spec.k, stream);
+
+    raft::random::RngState r(42);
+    normal(handle, r, in_dists_d.data(), in_dists_d.size(), KeyT(10.0), KeyT(100.0));
+    // the global positions of the elements as their indices
+    std::vector<IdxT> in_ids(total_len);
+    std::iota(in_ids.begin(), in_ids.end(), IdxT(0));
+    update_device(in_ids_d.data(), in_ids.data(), in_ids.size(), stream);
+    update_device(row_offsets_d.data(), row_offsets.data(), row_offsets.size(), stream);
+
+    const IdxT* in_ids_ptr = spec.use_index_input ? in_ids_d.data() : nullptr;
+    switch (algo) {
+      case SegmentedAlgo::kPublicApi: {
+        auto in_ids_view = spec.use_index_input
+                             ? std::make_optional(make_device_vector_view<const IdxT, int64_t>(
+                                 in_ids_d.data(), total_len))
+                             : std::nullopt;
+        matrix::select_k_segmented<KeyT, IdxT>(
+          handle,
+          make_device_vector_view<const KeyT, int64_t>(in_dists_d.data(), total_len),
+          in_ids_view,
+          make_device_vector_view<const IdxT, int64_t>(row_offsets_d.data(), row_offsets.size()),
+          spec.max_len,
+          make_device_matrix_view<KeyT, int64_t>(out_dists_d.data(), spec.batch_size, spec.k),
+          make_device_matrix_view<IdxT, int64_t>(out_ids_d.data(), spec.batch_size, spec.k),
+          spec.select_min);
+      } break;
+      case SegmentedAlgo::kRadix11bits:
+      case SegmentedAlgo::kRadix11bitsExtraPass:
+        matrix::detail::select::radix::select_k_segmented<KeyT, IdxT, 11, 512>(
+          in_dists_d.data(),
+          in_ids_ptr,
+          row_offsets_d.data(),
+          spec.batch_size,
+          IdxT(spec.max_len),
+          IdxT(spec.k),
+          out_dists_d.data(),
+          out_ids_d.data(),
+          spec.select_min,
+          algo == SegmentedAlgo::kRadix11bits,
+          stream);
+        break;
+      case SegmentedAlgo::kWarpAuto:
+        matrix::detail::select::warpsort::select_k_segmented<KeyT, IdxT>(in_dists_d.data(),
+                                                                         in_ids_ptr,
+                                                                         row_offsets_d.data(),
+                                                                         spec.batch_size,
+                                                                         spec.max_len,
+                                                                         spec.k,
+                                                                         out_dists_d.data(),
+                                                                         out_ids_d.data(),
+                                                                         spec.select_min,
+                                                                         stream);
+        break;
+    }
+
+    std::vector<KeyT> in_dists(total_len);
+    std::vector<KeyT> out_dists(out_dists_d.size());
+    std::vector<IdxT> out_ids(out_ids_d.size());
+    update_host(in_dists.data(), in_dists_d.data(), in_dists.size(), stream);
+    update_host(out_dists.data(), out_dists_d.data(), out_dists.size(), stream);
+    update_host(out_ids.data(), out_ids_d.data(), out_ids.size(), stream);
+    interruptible::synchronize(stream);
+
+    const KeyT dummy = spec.select_min ? std::numeric_limits<KeyT>::infinity()
+                                       : -std::numeric_limits<KeyT>::infinity();
+    auto cmp         = [select_min = spec.select_min](KeyT a, KeyT b) {
+      return select_min ? a < b : a > b;
+    };
+    for (uint32_t i = 0; i < spec.batch_size; i++) {
+      const auto row_start = size_t(row_offsets[i]);
+      const auto row_len   = size_t(row_offsets[i + 1]) - row_start;
+      const auto n_valid   = std::min<size_t>(row_len, spec.k);
+
+      std::vector<KeyT> expected(in_dists.begin() + row_start,
+                                 in_dists.begin() + row_start + row_len);
+      std::sort(expected.begin(), expected.end(), cmp);
+      expected.resize(n_valid);
+
+      std::vector<KeyT> actual;
+      for (size_t j = 0; j < spec.k; j++) {
+        auto val = out_dists[size_t(i) * spec.k + j];
+        if (val == dummy) { continue; }
+        actual.push_back(val);
+        // the selected index must point to the selected value
+        auto id  = size_t(out_ids[size_t(i) * spec.k + j]);
+        auto pos = spec.use_index_input ? id : row_start + id;
+        ASSERT_TRUE(pos >= row_start && pos < row_start + row_len)
+          << "row " << i << ": index " << id << " is out of the row";
+        ASSERT_EQ(in_dists[pos], val) << "row " << i << ": index " << id;
+      }
+      ASSERT_EQ(actual.size(), n_valid) << "row " << i;
+      std::sort(actual.begin(), actual.end(), cmp);
+      ASSERT_TRUE(hostVecMatch(expected, actual, Compare<KeyT>())) << "row " << i;
+    }
+  }
+};
+
+auto inputs_segmented = testing::Values(segmented_params{1, 1, 1, true},
+                                        segmented_params{10, 20, 5, true},
+                                        segmented_params{10, 20, 5, false, false},
+                                        segmented_params{100, 300, 32, true},
+                                        segmented_params{100, 300, 64, false, false},
+                                        segmented_params{100, 1700, 255, true},
+                                        segmented_params{100, 1700, 512, false},
+                                        segmented_params{1000, 200, 100, true, false},
+                                        segmented_params{20, 100000, 1, true},
+                                        segmented_params{20, 100000, 16, false},
+                                        segmented_params{20, 100000, 256, true, false},
+                                        segmented_params{20, 100000, 2048, false});
+
+using SegmentedFloatInt = SelectKSegmented<float, uint32_t>;
+TEST_P(SegmentedFloatInt, Run) { run(); }  // NOLINT
+INSTANTIATE_TEST_CASE_P(                   // NOLINT
+  SelectK,
+  SegmentedFloatInt,
+  testing::Combine(inputs_segmented,
+                   testing::Values(SegmentedAlgo::kPublicApi,
+                                   SegmentedAlgo::kRadix11bits,
+                                   SegmentedAlgo::kRadix11bitsExtraPass,
+                                   SegmentedAlgo::kWarpAuto)));
+
+using SegmentedDoubleSizeT = SelectKSegmented<double, int64_t>;
+TEST_P(SegmentedDoubleSizeT, Run) { run(); }  // NOLINT
+INSTANTIATE_TEST_CASE_P(                      // NOLINT
+  SelectK,
+  SegmentedDoubleSizeT,
+  testing::Combine(inputs_segmented,
+                   testing::Values(SegmentedAlgo::kRadix11bits,
+                                   SegmentedAlgo::kRadix11bitsExtraPass,
+                                   SegmentedAlgo::kWarpAuto)));
+
+
+TEST(SelectK, DispatchTable)  // NOLINT
+{
+  namespace dispatch = raft::matrix::detail::select_k_dispatch;
+  using raft::matrix::detail::Algo;
+
+  std::istringstream csv(
+    "arch,rows,cols,k,algo\n"
+    "# a comment\n"
+    "89,1,1024,1,kFaissBlockSelect\n"
+    "89,1,1024,2,kWarpDistributedShm\n"
+    "89,1024,1048576,256,kWarpDistributedShm\n"
+    "89,1024,1048576,512,kRadix11bits\n"
+    "90,1,1024,1,kRadixLargeK\n");
+  auto tables = dispatch::parse_csv(csv);
+  ASSERT_EQ(tables.size(), size_t{2});
+  ASSERT_EQ(tables[89].size(), size_t{4});
+  ASSERT_EQ(tables[90].size(), size_t{1});
+
+  dispatch::table t(tables[89]);
+  ASSERT_EQ(t.size(), size_t{4});
+  // exact grid points
+  EXPECT_EQ(t.lookup(1, 1024, 1), Algo::kFaissBlockSelect);
+  EXPECT_EQ(t.lookup(1024, 1048576, 512), Algo::kRadix11bits);
+  // k is rounded up, rows and cols - to the nearest power of two
+  EXPECT_EQ(t.lookup(1, 1000, 2), Algo::kWarpDistributedShm);
+  EXPECT_EQ(t.lookup(900, 1100000, 200), Algo::kWarpDistributedShm);
+  EXPECT_EQ(t.lookup(900, 1100000, 257), Algo::kRadix11bits);
+  // rows and cols are clamped to the range of the table, k is not
+  EXPECT_EQ(t.lookup(100000, 1LLU << 30, 300), Algo::kRadix11bits);
+  EXPECT_EQ(t.lookup(1024, 1048576, 513), std::nullopt);
+  // the cells not covered by the table
+  EXPECT_EQ(t.lookup(1, 1048576, 1), std::nullopt);
+
+  // the registry serves the table of the current architecture
+  auto arch = dispatch::current_arch();
+  dispatch::set_table(arch, tables[89]);
+  EXPECT_EQ(dispatch::lookup(1, 1024, 1), Algo::kFaissBlockSelect);
+  dispatch::set_table(arch, {});
+  EXPECT_EQ(dispatch::lookup(1, 1024, 1), std::nullopt);
+}
 
 }  // namespace raft::matrix
@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/matrix/topk_accumulator.cuh>
+#include <raft/random/rng.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <gtest/gtest.h>
+
+#include <rmm/device_uvector.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <vector>
+
+namespace raft::matrix {
+
+struct topk_accumulator_params {
+  int64_t n_rows;
+  int64_t len;
+  int64_t tile_len;
+  int k;
+  bool select_min;
+  bool use_index_input = true;
+};
+
+inline auto operator<<(std::ostream& os, const topk_accumulator_params& ss) -> std::ostream&
+{
+  os << "params{n_rows: " << ss.n_rows << ", len: " << ss.len << ", tile_len: " << ss.tile_len
+     << ", k: " << ss.k << (ss.select_min ? ", asc" : ", dsc")
+     << (ss.use_index_input ? "" : ", no-input-index") << "}";
+  return os;
+}
+
+/**
+ * Feed the rows to the accumulator tile by tile (and every tile in two parts by rows) and check
+ * the result against a host reference.
+ */
+template <typename KeyT, typename IdxT>
+struct TopkAccumulator : public testing::TestWithParam<topk_accumulator_params> {
+  const topk_accumulator_params spec;
+
+  TopkAccumulator() : spec(GetParam()) {}
+
+  void run()
+  {
+    resources handle{};
+    auto stream = resource::get_cuda_stream(handle);
+
+    const auto n_rows = spec.n_rows;
+    const auto len    = spec.len;
+    rmm::device_uvector<KeyT> in_dists_d(n_rows * len, stream);
+    raft::random::RngState r(42);
+    normal(handle, r, in_dists_d.data(), in_dists_d.size(), KeyT(10.0), KeyT(100.0));
+
+    topk_accumulator<KeyT, IdxT> acc(handle, n_rows, spec.k, spec.select_min);
+    const int64_t half = n_rows / 2;
+    for (int64_t j = 0; j < len; j += spec.tile_len) {
+      const auto tile_len = std::min(spec.tile_len, len - j);
+      // copy the tile out to make it contiguous
+      rmm::device_uvector<KeyT> tile_d(n_rows * tile_len, stream);
+      RAFT_CUDA_TRY(cudaMemcpy2DAsync(tile_d.data(),
+                                      tile_len * sizeof(KeyT),
+                                      in_dists_d.data() + j,
+                                      len * sizeof(KeyT),
+                                      tile_len * sizeof(KeyT),
+                                      n_rows,
+                                      cudaMemcpyDefault,
+                                      stream));
+      // the global column ids as the input indices
+      std::vector<IdxT> tile_ids(n_rows * tile_len);
+      for (int64_t i = 0; i < n_rows * tile_len; i++) {
+        tile_ids[i] = IdxT(j + i % tile_len);
+      }
+      rmm::device_uvector<IdxT> tile_ids_d(tile_ids.size(), stream);
+      update_device(tile_ids_d.data(), tile_ids.data(), tile_ids.size(), stream);
+
+      for (auto [row_offset, rows] : {std::make_pair(int64_t(0), half),
+                                      std::make_pair(half, n_rows - half)}) {
+        if (rows == 0) { continue; }
+        auto tile_view = make_device_matrix_view<const KeyT, int64_t>(
+          tile_d.data() + row_offset * tile_len, rows, tile_len);
+        if (spec.use_index_input) {
+          acc.add(handle,
+                  tile_view,
+                  make_device_matrix_view<const IdxT, int64_t>(
+                    tile_ids_d.data() + row_offset * tile_len, rows, tile_len),
+                  IdxT(0),
+                  row_offset);
+        } else {
+          acc.add(handle, tile_view, std::nullopt, IdxT(j), row_offset);
+        }
+      }
+      // keep the tiles alive until the merge is done
+      interruptible::synchronize(stream);
+    }
+
+    std::vector<KeyT> in_dists(in_dists_d.size());
+    std::vector<KeyT> out_dists(n_rows * spec.k);
+    std::vector<IdxT> out_ids(n_rows * spec.k);
+    update_host(in_dists.data(), in_dists_d.data(), in_dists.size(), stream);
+    update_host(out_dists.data(), acc.values().data_handle(), out_dists.size(), stream);
+    update_host(out_ids.data(), acc.indices().data_handle(), out_ids.size(), stream);
+    interruptible::synchronize(stream);
+
+    const KeyT dummy = spec.select_min ? std::numeric_limits<KeyT>::infinity()
+                                       : -std::numeric_limits<KeyT>::infinity();
+    auto cmp         = [select_min = spec.select_min](KeyT a, KeyT b) {
+      return select_min ? a < b : a > b;
+    };
+    const auto n_valid = std::min<int64_t>(len, spec.k);
+    for (int64_t i = 0; i < n_rows; i++) {
+      std::vector<KeyT> expected(in_dists.begin() + i * len, in_dists.begin() + (i + 1) * len);
+      std::sort(expected.begin(), expected.end(), cmp);
+      expected.resize(n_valid);
+
+      std::vector<KeyT> actual;
+      for (int j = 0; j < spec.k; j++) {
+        auto val = out_dists[i * spec.k + j];
+        if (val == dummy) { continue; }
+        actual.push_back(val);
+        // the selected index must point to the selected value
+        auto id = int64_t(out_ids[i * spec.k + j]);
+        ASSERT_TRUE(id >= 0 && id < len) << "row " << i << ": index " << id << " is out of bounds";
+        ASSERT_EQ(in_dists[i * len + id], val) << "row " << i << ": index " << id;
+      }
+      ASSERT_EQ(int64_t(actual.size()), n_valid) << "row " << i;
+      std::sort(actual.begin(), actual.end(), cmp);
+      ASSERT_TRUE(hostVecMatch(expected, actual, Compare<KeyT>())) << "row " << i;
+    }
+  }
+};
+
+auto inputs_topk_accumulator =
+  testing::Values(topk_accumulator_params{1, 1, 1, 1, true},
+                  topk_accumulator_params{10, 100, 7, 10, true},
+                  topk_accumulator_params{10, 100, 7, 10, false, false},
+                  // fewer candidates than k
+                  topk_accumulator_params{10, 20, 3, 32, true},
+                  // rows enough for the fused single pass
+                  topk_accumulator_params{3000, 1000, 300, 64, true},
+                  topk_accumulator_params{3000, 1000, 300, 256, false, false},
+                  // few long rows: select the tile top-k first
+                  topk_accumulator_params{3, 200000, 50000, 100, true},
+                  topk_accumulator_params{3, 200000, 50000, 200, false, false},
+                  // k beyond the warp-sort capacity
+                  topk_accumulator_params{20, 10000, 3000, 1000, true},
+                  topk_accumulator_params{20, 10000, 3000, 1000, false, false},
+                  topk_accumulator_params{20, 10000, 700, 1000, true});
+
+using TopkAccumulatorFloatInt64 = TopkAccumulator<float, int64_t>;
+TEST_P(TopkAccumulatorFloatInt64, Run) { run(); }  // NOLINT
+INSTANTIATE_TEST_CASE_P(TopkAccumulator,           // NOLINT
+                        TopkAccumulatorFloatInt64,
+                        inputs_topk_accumulator);
+
+using TopkAccumulatorDoubleUint32 = TopkAccumulator<double, uint32_t>;
+TEST_P(TopkAccumulatorDoubleUint32, Run) { run(); }  // NOLINT
+INSTANTIATE_TEST_CASE_P(TopkAccumulator,             // NOLINT
+                        TopkAccumulatorDoubleUint32,
+                        inputs_topk_accumulator);
+
+}  // namespace raft::matrix
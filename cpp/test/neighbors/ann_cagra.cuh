@@ -18,11 +18,15 @@
 #include "../test_utils.cuh"
 #include "ann_utils.cuh"
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/cuda_stream_pool.hpp>
+#include <raft/core/resource/device_id.hpp>
 
 #include <raft_internal/neighbors/naive_knn.cuh>
 
+#include <raft/core/device_csr_matrix.hpp>
 #include <raft/core/device_mdspan.hpp>
 #include <raft/core/device_resources.hpp>
+#include <raft/core/host_mdarray.hpp>
 #include <raft/core/logger.hpp>
 #include <raft/distance/distance_types.hpp>
 #include <raft/neighbors/cagra.cuh>
@@ -36,8 +40,10 @@
 
 #include <thrust/sequence.h>
 
+#include <algorithm>
 #include <cstddef>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -123,6 +129,19 @@ void GenerateRoundingErrorFreeDataset(float* const ptr,
   GenerateRoundingErrorFreeDataset_kernel<<<grid_size, block_size, 0, cuda_stream>>>(
     ptr, size, resolution);
 }
+
+// Greenlights only the samples with an index equal to or larger than the offset
+struct test_cagra_sample_filter {
+  uint32_t offset;
+  inline _RAFT_HOST_DEVICE bool operator()(
+    // query index
+    const uint32_t query_ix,
+    // the index of the current sample
+    const uint32_t sample_ix) const
+  {
+    return sample_ix >= offset;
+  }
+};
 }  // namespace
 
 struct AnnCagraInputs {
@@ -139,6 +158,29 @@ struct AnnCagraInputs {
   bool host_dataset;
   // std::optional<double>
   double min_recall;  // = std::nullopt;
+  int n_shards = 1;
+  // build the index on a part of the dataset and add the rest using cagra::extend
+  bool extend = false;
+  // filter out the first tenth of the dataset during the search
+  bool filter = false;
+  // search a compressed copy of the dataset
+  dataset_compression compression = dataset_compression::NONE;
+  // number of the candidates re-ranked using the exact distances (compressed datasets only)
+  int refine_topk = 0;
+  // use the persistent single-CTA kernel
+  bool persistent = false;
+  // build a sharded index with this many handles, assigned to the devices round-robin
+  int n_gpu_shards = 1;
+  // save the dataset with the index; otherwise it is attached after loading the index
+  bool include_dataset = true;
+  // search with the parameters tuned for min_recall
+  bool tune = false;
+  // size of the stream pool the batches are distributed over (0: no pool)
+  int n_streams = 0;
+  // the algorithm building the intermediate knn-graph
+  graph_build_algo build_algo = graph_build_algo::IVF_PQ;
+  // number of the entry points selected by k-means (0: random seeds)
+  int n_entry_points = 0;
 };
 
 inline ::std::ostream& operator<<(::std::ostream& os, const AnnCagraInputs& p)
@@ -147,8 +189,14 @@ inline ::std::ostream& operator<<(::std::ostream& os, const AnnCagraInputs& p)
   os << "{n_queries=" << p.n_queries << ", dataset shape=" << p.n_rows << "x" << p.dim
      << ", k=" << p.k << ", " << algo.at((int)p.algo) << ", max_queries=" << p.max_queries
      << ", itopk_size=" << p.itopk_size << ", num_parents=" << p.num_parents
-     << ", metric=" << static_cast<int>(p.metric) << (p.host_dataset ? ", host" : ", device") << '}'
-     << std::endl;
+     << ", metric=" << static_cast<int>(p.metric) << (p.host_dataset ? ", host" : ", device")
+     << ", n_shards=" << p.n_shards << (p.extend ? ", extend" : "")
+     << (p.filter ? ", filter" : "") << ", compression=" << static_cast<int>(p.compression)
+     << ", refine_topk=" << p.refine_topk << (p.persistent ? ", persistent" : "")
+     << ", n_gpu_shards=" << p.n_gpu_shards << (p.include_dataset ? "" : ", no dataset")
+     << (p.tune ? ", tune" : "") << ", n_streams=" << p.n_streams
+     << (p.build_algo == graph_build_algo::NN_DESCENT ? ", nn-descent" : "")
+     << ", n_entry_points=" << p.n_entry_points << '}' << std::endl;
   return os;
 }
 
@@ -169,11 +217,16 @@ class AnnCagraTest : public ::testing::TestWithParam<AnnCagraInputs> {
     if (ps.algo == search_algo::MULTI_CTA && ps.max_queries > 1) {
       GTEST_SKIP() << "Skipping test due to issue #1575";
     }
+    if (ps.compression != dataset_compression::NONE && !std::is_same_v<DataT, float>) {
+      GTEST_SKIP() << "Only float datasets can be compressed";
+    }
     size_t queries_size = ps.n_queries * ps.k;
     std::vector<IdxT> indices_Cagra(queries_size);
     std::vector<IdxT> indices_naive(queries_size);
     std::vector<DistanceT> distances_Cagra(queries_size);
     std::vector<DistanceT> distances_naive(queries_size);
+    // the samples below this index are rejected by the filter
+    const IdxT filter_offset = ps.filter ? ps.n_rows / 10 : 0;
 
     {
       rmm::device_uvector<DistanceT> distances_naive_dev(queries_size, stream_);
@@ -181,9 +234,9 @@ class AnnCagraTest : public ::testing::TestWithParam<AnnCagraInputs> {
       naive_knn<DistanceT, DataT, IdxT>(distances_naive_dev.data(),
                                         indices_naive_dev.data(),
                                         search_queries.data(),
-                                        database.data(),
+                                        database.data() + size_t(filter_offset) * ps.dim,
                                         ps.n_queries,
-                                        ps.n_rows,
+                                        ps.n_rows - filter_offset,
                                         ps.dim,
                                         ps.k,
                                         ps.metric,
@@ -191,6 +244,9 @@ class AnnCagraTest : public ::testing::TestWithParam<AnnCagraInputs> {
       update_host(distances_naive.data(), distances_naive_dev.data(), queries_size, stream_);
       update_host(indices_naive.data(), indices_naive_dev.data(), queries_size, stream_);
       resource::sync_stream(handle_);
+      for (auto& ix : indices_naive) {
+        ix += filter_offset;
+      }
     }
 
     {
@@ -201,42 +257,106 @@ class AnnCagraTest : public ::testing::TestWithParam<AnnCagraInputs> {
         cagra::index_params index_params;
         index_params.metric = ps.metric;  // Note: currently ony the cagra::index_params metric is
                                           // not used for knn_graph building.
+        index_params.n_shards       = ps.n_shards;
+        index_params.compression    = ps.compression;
+        index_params.build_algo     = ps.build_algo;
+        index_params.n_entry_points = ps.n_entry_points;
         cagra::search_params search_params;
         search_params.algo        = ps.algo;
         search_params.max_queries = ps.max_queries;
         search_params.team_size   = ps.team_size;
+        search_params.refine_topk = ps.refine_topk;
+        search_params.persistent  = ps.persistent;
 
         auto database_view = raft::make_device_matrix_view<const DataT, IdxT>(
           (const DataT*)database.data(), ps.n_rows, ps.dim);
 
-        {
-          cagra::index<DataT, IdxT> index(handle_);
-          if (ps.host_dataset) {
-            auto database_host = raft::make_host_matrix<DataT, IdxT>(ps.n_rows, ps.dim);
-            raft::copy(database_host.data_handle(), database.data(), database.size(), stream_);
-            auto database_host_view = raft::make_host_matrix_view<const DataT, IdxT>(
-              (const DataT*)database_host.data_handle(), ps.n_rows, ps.dim);
-            index = cagra::build<DataT, IdxT>(handle_, index_params, database_host_view);
+        if (ps.n_gpu_shards > 1) {
+          search_sharded_index(
+            index_params, search_params, indices_dev.data(), distances_dev.data());
+        } else {
+          {
+            cagra::index<DataT, IdxT> index(handle_);
+            if (ps.extend) {
+              const IdxT n_build = ps.n_rows * 4 / 5;
+              auto build_view    = raft::make_device_matrix_view<const DataT, IdxT>(
+                (const DataT*)database.data(), n_build, ps.dim);
+              auto extend_view   = raft::make_device_matrix_view<const DataT, IdxT>(
+                (const DataT*)database.data() + size_t(n_build) * ps.dim,
+                ps.n_rows - n_build,
+                ps.dim);
+              index = cagra::build<DataT, IdxT>(handle_, index_params, build_view);
+              cagra::extend<DataT, IdxT>(handle_, cagra::extend_params{}, extend_view, index);
+              ASSERT_EQ(index.size(), IdxT(ps.n_rows));
+            } else if (ps.host_dataset) {
+              auto database_host = raft::make_host_matrix<DataT, IdxT>(ps.n_rows, ps.dim);
+              raft::copy(database_host.data_handle(), database.data(), database.size(), stream_);
+              auto database_host_view = raft::make_host_matrix_view<const DataT, IdxT>(
+                (const DataT*)database_host.data_handle(), ps.n_rows, ps.dim);
+              index = cagra::build<DataT, IdxT>(handle_, index_params, database_host_view);
+            } else {
+              index = cagra::build<DataT, IdxT>(handle_, index_params, database_view);
+            };
+            cagra::serialize(handle_, "cagra_index", index, ps.include_dataset);
+          }
+          auto index = cagra::deserialize<DataT, IdxT>(handle_, "cagra_index");
+          if (!ps.include_dataset) { index.update_dataset(handle_, database_view); }
+          if (ps.n_entry_points > 0) {
+            ASSERT_GT(index.entry_points().extent(0), IdxT(0));
+            ASSERT_LE(index.entry_points().extent(0), IdxT(ps.n_entry_points));
+          }
+
+          auto search_queries_view = raft::make_device_matrix_view<const DataT, IdxT>(
+            search_queries.data(), ps.n_queries, ps.dim);
+          auto indices_out_view =
+            raft::make_device_matrix_view<IdxT, IdxT>(indices_dev.data(), ps.n_queries, ps.k);
+          auto dists_out_view = raft::make_device_matrix_view<DistanceT, IdxT>(
+            distances_dev.data(), ps.n_queries, ps.k);
+
+          if (ps.n_streams > 0) {
+            resource::set_cuda_stream_pool(handle_,
+                                           std::make_shared<rmm::cuda_stream_pool>(ps.n_streams));
+          }
+          if (ps.tune) {
+            rmm::device_uvector<IdxT> ground_truth(queries_size, stream_);
+            update_device(ground_truth.data(), indices_naive.data(), queries_size, stream_);
+            search_params = cagra::tune_search_params(
+              handle_,
+              index,
+              search_queries_view,
+              raft::make_device_matrix_view<const IdxT, IdxT>(
+                ground_truth.data(), ps.n_queries, ps.k),
+              static_cast<float>(ps.min_recall),
+              search_params);
+            // The tuned parameters survive a round trip through a stream
+            std::stringstream ss;
+            cagra::serialize_search_params(handle_, ss, search_params);
+            search_params = cagra::deserialize_search_params(handle_, ss);
+          }
+
+          if (ps.filter) {
+            cagra::search_with_filtering(handle_,
+                                         search_params,
+                                         index,
+                                         search_queries_view,
+                                         indices_out_view,
+                                         dists_out_view,
+                                         test_cagra_sample_filter{uint32_t(filter_offset)});
           } else {
-            index = cagra::build<DataT, IdxT>(handle_, index_params, database_view);
-          };
-          cagra::serialize(handle_, "cagra_index", index);
+            cagra::search(
+              handle_, search_params, index, search_queries_view, indices_out_view, dists_out_view);
+          }
+          if (!ps.filter && ps.compression == dataset_compression::NONE && !ps.persistent) {
+            check_ragged_search(index, search_params, search_queries_view);
+          }
         }
-        auto index = cagra::deserialize<DataT, IdxT>(handle_, "cagra_index");
-
-        auto search_queries_view = raft::make_device_matrix_view<const DataT, IdxT>(
-          search_queries.data(), ps.n_queries, ps.dim);
-        auto indices_out_view =
-          raft::make_device_matrix_view<IdxT, IdxT>(indices_dev.data(), ps.n_queries, ps.k);
-        auto dists_out_view =
-          raft::make_device_matrix_view<DistanceT, IdxT>(distances_dev.data(), ps.n_queries, ps.k);
-
-        cagra::search(
-          handle_, search_params, index, search_queries_view, indices_out_view, dists_out_view);
         update_host(distances_Cagra.data(), distances_dev.data(), queries_size, stream_);
         update_host(indices_Cagra.data(), indices_dev.data(), queries_size, stream_);
         resource::sync_stream(handle_);
       }
+      for (auto ix : indices_Cagra) {
+        ASSERT_GE(ix, filter_offset);
+      }
       // for (int i = 0; i < min(ps.n_queries, 10); i++) {
       //   //  std::cout << "query " << i << std::end;
       //   print_vector("T", indices_naive.data() + i * ps.k, ps.k, std::cout);
@@ -267,6 +387,96 @@ class AnnCagraTest : public ::testing::TestWithParam<AnnCagraInputs> {
     }
   }
 
+  /**
+   * Search with a different k per query, up to above the itopk_size (which the buckets of the
+   * large k raise to it): the neighbors of every query must be about the nearest ones of the
+   * regular search with the largest k.
+   */
+  void check_ragged_search(const cagra::index<DataT, IdxT>& index,
+                           const cagra::search_params& search_params,
+                           raft::device_matrix_view<const DataT, IdxT, row_major> queries)
+  {
+    const uint32_t k_max =
+      std::min<uint32_t>(ps.k + search_params.itopk_size, static_cast<uint32_t>(index.size()));
+    auto ks = raft::make_host_vector<uint32_t, IdxT>(ps.n_queries);
+    for (IdxT i = 0; i < IdxT(ps.n_queries); i++) {
+      ks(i) = 1 + (i * 37) % k_max;
+    }
+    ks(ps.n_queries - 1) = k_max;
+    auto out             = raft::make_device_csr_matrix<float, int64_t, IdxT, int64_t>(
+      handle_, ps.n_queries, index.size());
+    cagra::search(handle_, search_params, index, queries, raft::make_const_mdspan(ks.view()), out);
+
+    // the regular search of the largest k needs an itopk_size of at least k
+    auto regular_params       = search_params;
+    regular_params.itopk_size = std::max<size_t>(search_params.itopk_size, k_max);
+    const size_t regular_size = size_t(ps.n_queries) * k_max;
+    rmm::device_uvector<IdxT> indices_dev(regular_size, stream_);
+    rmm::device_uvector<float> distances_dev(regular_size, stream_);
+    cagra::search(
+      handle_,
+      regular_params,
+      index,
+      queries,
+      raft::make_device_matrix_view<IdxT, IdxT>(indices_dev.data(), ps.n_queries, k_max),
+      raft::make_device_matrix_view<float, IdxT>(distances_dev.data(), ps.n_queries, k_max));
+
+    auto structure = out.structure_view();
+    std::vector<int64_t> indptr(ps.n_queries + 1);
+    std::vector<float> distances_ragged(structure.get_nnz());
+    std::vector<float> distances_regular(regular_size);
+    update_host(indptr.data(), structure.get_indptr().data(), indptr.size(), stream_);
+    update_host(
+      distances_ragged.data(), out.get_elements().data(), distances_ragged.size(), stream_);
+    update_host(distances_regular.data(), distances_dev.data(), regular_size, stream_);
+    resource::sync_stream(handle_);
+
+    // a neighbor is found if it is not farther than the k-th one of the regular search
+    size_t n_found = 0;
+    for (IdxT i = 0; i < IdxT(ps.n_queries); i++) {
+      ASSERT_EQ(indptr[i + 1] - indptr[i], int64_t(ks(i))) << "query " << i;
+      const float kth = distances_regular[size_t(i) * k_max + ks(i) - 1];
+      for (uint32_t j = 0; j < ks(i); j++) {
+        const float d = distances_ragged[indptr[i] + j];
+        if (j > 0) { ASSERT_LE(distances_ragged[indptr[i] + j - 1], d) << "query " << i; }
+        n_found += d <= kth + 0.001 * std::max(1.0f, std::abs(kth));
+      }
+    }
+    EXPECT_GE(double(n_found), ps.min_recall * double(structure.get_nnz())) << ps;
+  }
+
+  void search_sharded_index(const cagra::index_params& index_params,
+                            const cagra::search_params& search_params,
+                            IdxT* indices,
+                            DistanceT* distances)
+  {
+    int n_devices;
+    RAFT_CUDA_TRY(cudaGetDeviceCount(&n_devices));
+    const int dev0 = resource::get_device_id(handle_);
+    std::vector<raft::resources> shard_res{handle_};
+    for (int i = 1; i < ps.n_gpu_shards; i++) {
+      RAFT_CUDA_TRY(cudaSetDevice((dev0 + i) % n_devices));
+      shard_res.emplace_back(raft::device_resources{});
+      resource::get_device_id(shard_res.back());
+    }
+    RAFT_CUDA_TRY(cudaSetDevice(dev0));
+
+    auto database_host = raft::make_host_matrix<DataT, IdxT>(ps.n_rows, ps.dim);
+    raft::copy(database_host.data_handle(), database.data(), database.size(), stream_);
+    resource::sync_stream(handle_);
+    auto index = cagra::build_sharded<DataT, IdxT>(
+      shard_res, index_params, raft::make_const_mdspan(database_host.view()));
+    ASSERT_EQ(index.size(), IdxT(ps.n_rows));
+
+    cagra::search_sharded(
+      shard_res,
+      search_params,
+      index,
+      raft::make_device_matrix_view<const DataT, IdxT>(search_queries.data(), ps.n_queries, ps.dim),
+      raft::make_device_matrix_view<IdxT, IdxT>(indices, ps.n_queries, ps.k),
+      raft::make_device_matrix_view<DistanceT, IdxT>(distances, ps.n_queries, ps.k));
+  }
+
   void SetUp() override
   {
     std::cout << "Resizing database: " << ps.n_rows * ps.dim << std::endl;
@@ -369,6 +579,73 @@ class AnnCagraSortTest : public ::testing::TestWithParam<AnnCagraInputs> {
   rmm::device_uvector<DataT> database;
 };
 
+/**
+ * The graph optimization keeps the pruned and reverse graphs on the device when they fit there,
+ * and otherwise processes them in chunks through the host buffers: capping the rows held in the
+ * device memory forces the latter, which must give the same graph.
+ */
+template <typename DataT, typename IdxT>
+class AnnCagraPruneTest : public ::testing::TestWithParam<AnnCagraInputs> {
+ public:
+  AnnCagraPruneTest()
+    : ps(::testing::TestWithParam<AnnCagraInputs>::GetParam()), database(0, handle_.get_stream())
+  {
+  }
+
+ protected:
+  void testCagraPrune()
+  {
+    auto database_view = raft::make_device_matrix_view<const DataT, IdxT>(
+      (const DataT*)database.data(), ps.n_rows, ps.dim);
+
+    cagra::index_params index_params;
+    auto knn_graph =
+      raft::make_host_matrix<IdxT, IdxT>(ps.n_rows, index_params.intermediate_graph_degree);
+    cagra::build_knn_graph<DataT, IdxT>(handle_, database_view, knn_graph.view());
+    handle_.sync_stream();
+
+    auto graph_on_device = raft::make_host_matrix<IdxT, IdxT>(ps.n_rows, index_params.graph_degree);
+    auto knn_graph_copy =
+      raft::make_host_matrix<IdxT, IdxT>(ps.n_rows, index_params.intermediate_graph_degree);
+    std::copy(knn_graph.data_handle(),
+              knn_graph.data_handle() + knn_graph.size(),
+              knn_graph_copy.data_handle());
+    detail::graph::prune(handle_, knn_graph_copy.view(), graph_on_device.view());
+
+    // in three chunks, the last one partial
+    auto graph_chunked = raft::make_host_matrix<IdxT, IdxT>(ps.n_rows, index_params.graph_degree);
+    detail::graph::prune(handle_, knn_graph.view(), graph_chunked.view(), ps.n_rows / 3 + 1);
+
+    for (size_t i = 0; i < graph_on_device.size(); i++) {
+      ASSERT_EQ(graph_on_device.data_handle()[i], graph_chunked.data_handle()[i])
+        << "node " << i / index_params.graph_degree;
+    }
+  }
+
+  void SetUp() override
+  {
+    database.resize(((size_t)ps.n_rows) * ps.dim, handle_.get_stream());
+    raft::random::Rng r(1234ULL);
+    if constexpr (std::is_same<DataT, float>{}) {
+      r.normal(database.data(), ps.n_rows * ps.dim, DataT(0.1), DataT(2.0), handle_.get_stream());
+    } else {
+      r.uniformInt(database.data(), ps.n_rows * ps.dim, DataT(1), DataT(20), handle_.get_stream());
+    }
+    handle_.sync_stream();
+  }
+
+  void TearDown() override
+  {
+    handle_.sync_stream();
+    database.resize(0, handle_.get_stream());
+  }
+
+ private:
+  raft::device_resources handle_;
+  AnnCagraInputs ps;
+  rmm::device_uvector<DataT> database;
+};
+
 inline std::vector<AnnCagraInputs> generate_inputs()
 {
   // Todo(tfeher): MULTI_CTA tests a bug, consider disabling that mode.
@@ -461,6 +738,256 @@ inline std::vector<AnnCagraInputs> generate_inputs()
                                                    {0.995});
   inputs.insert(inputs.end(), inputs2.begin(), inputs2.end());
 
+  // sharded (out-of-core) graph build of the device and host datasets
+  inputs2 =
+    raft::util::itertools::product<AnnCagraInputs>({100},
+                                                   {20000},
+                                                   {32},
+                                                   {10},
+                                                   {search_algo::AUTO},
+                                                   {10},
+                                                   {0},  // team_size
+                                                   {64},
+                                                   {1},
+                                                   {raft::distance::DistanceType::L2Expanded},
+                                                   {false, true},
+                                                   {0.99},
+                                                   {4});  // n_shards
+  inputs.insert(inputs.end(), inputs2.begin(), inputs2.end());
+
+  // extend
+  inputs2 =
+    raft::util::itertools::product<AnnCagraInputs>({100},
+                                                   {10000},
+                                                   {32},
+                                                   {10},
+                                                   {search_algo::AUTO},
+                                                   {10},
+                                                   {0},  // team_size
+                                                   {64},
+                                                   {1},
+                                                   {raft::distance::DistanceType::L2Expanded},
+                                                   {false},
+                                                   {0.98},
+                                                   {1},
+                                                   {true});  // extend
+  inputs.insert(inputs.end(), inputs2.begin(), inputs2.end());
+
+  // filtered search
+  inputs2 = raft::util::itertools::product<AnnCagraInputs>(
+    {100},
+    {10000},
+    {32},
+    {10},
+    {search_algo::SINGLE_CTA, search_algo::MULTI_CTA, search_algo::MULTI_KERNEL},
+    {1},
+    {0},  // team_size
+    {64},
+    {1},
+    {raft::distance::DistanceType::L2Expanded},
+    {false},
+    {0.98},
+    {1},
+    {false},
+    {true});  // filter
+  inputs.insert(inputs.end(), inputs2.begin(), inputs2.end());
+
+  // compressed dataset, with and without re-ranking
+  inputs2 = raft::util::itertools::product<AnnCagraInputs>(
+    {100},
+    {10000},
+    {32},
+    {10},
+    {search_algo::SINGLE_CTA, search_algo::MULTI_CTA, search_algo::MULTI_KERNEL},
+    {1},
+    {0},  // team_size
+    {64},
+    {1},
+    {raft::distance::DistanceType::L2Expanded},
+    {false},
+    {0.9},
+    {1},
+    {false},
+    {false},
+    {dataset_compression::FP16, dataset_compression::INT8},
+    {0, 40});  // refine_topk
+  inputs.insert(inputs.end(), inputs2.begin(), inputs2.end());
+
+  // persistent kernel
+  inputs2 = raft::util::itertools::product<AnnCagraInputs>(
+    {1, 100},
+    {10000},
+    {32},
+    {10},
+    {search_algo::SINGLE_CTA, search_algo::AUTO},
+    {1, 8},
+    {0},  // team_size
+    {64},
+    {1},
+    {raft::distance::DistanceType::L2Expanded},
+    {false},
+    {0.98},
+    {1},
+    {false},
+    {false, true},
+    {dataset_compression::NONE},
+    {0},
+    {true});  // persistent
+  inputs.insert(inputs.end(), inputs2.begin(), inputs2.end());
+
+  // sharded across devices
+  inputs2 = raft::util::itertools::product<AnnCagraInputs>(
+    {100},
+    {10000},
+    {32},
+    {10},
+    {search_algo::AUTO},
+    {10},
+    {0},  // team_size
+    {64},
+    {1},
+    {raft::distance::DistanceType::L2Expanded},
+    {true},
+    {0.98},
+    {1},
+    {false},
+    {false},
+    {dataset_compression::NONE},
+    {0},
+    {false},
+    {2, 4});  // n_gpu_shards
+  inputs.insert(inputs.end(), inputs2.begin(), inputs2.end());
+
+  // index saved without the dataset
+  inputs2 = raft::util::itertools::product<AnnCagraInputs>(
+    {100},
+    {10000},
+    {32},
+    {10},
+    {search_algo::AUTO},
+    {10},
+    {0},  // team_size
+    {64},
+    {1},
+    {raft::distance::DistanceType::L2Expanded},
+    {false, true},
+    {0.98},
+    {1},
+    {false, true},
+    {false},
+    {dataset_compression::NONE},
+    {0},
+    {false},
+    {1},
+    {false});  // include_dataset
+  inputs.insert(inputs.end(), inputs2.begin(), inputs2.end());
+
+  // tuned search parameters
+  inputs2 = raft::util::itertools::product<AnnCagraInputs>(
+    {100},
+    {10000},
+    {32},
+    {10},
+    {search_algo::AUTO},
+    {1, 100},
+    {0},  // team_size
+    {64},
+    {1},
+    {raft::distance::DistanceType::L2Expanded},
+    {false},
+    {0.9, 0.99},
+    {1},
+    {false},
+    {false},
+    {dataset_compression::NONE},
+    {0},
+    {false},
+    {1},
+    {true},
+    {true});  // tune
+  inputs.insert(inputs.end(), inputs2.begin(), inputs2.end());
+
+  // batches distributed over a stream pool
+  inputs2 = raft::util::itertools::product<AnnCagraInputs>(
+    {1000},
+    {10000},
+    {32},
+    {10},
+    {search_algo::SINGLE_CTA, search_algo::MULTI_CTA, search_algo::MULTI_KERNEL},
+    {1, 100},
+    {0},  // team_size
+    {64},
+    {1},
+    {raft::distance::DistanceType::L2Expanded},
+    {false},
+    {0.98},
+    {1},
+    {false},
+    {false, true},
+    {dataset_compression::NONE},
+    {0},
+    {false},
+    {1},
+    {true},
+    {false},
+    {2, 4});  // n_streams
+  inputs.insert(inputs.end(), inputs2.begin(), inputs2.end());
+
+  // knn-graph built with nn-descent
+  inputs2 = raft::util::itertools::product<AnnCagraInputs>(
+    {100},
+    {10000},
+    {8, 32, 137},
+    {10},
+    {search_algo::SINGLE_CTA, search_algo::MULTI_CTA},
+    {1, 100},
+    {0},  // team_size
+    {64},
+    {1},
+    {raft::distance::DistanceType::L2Expanded},
+    {false, true},
+    {0.98},
+    {1},
+    {false},
+    {false},
+    {dataset_compression::NONE},
+    {0},
+    {false},
+    {1},
+    {true},
+    {false},
+    {0},
+    {graph_build_algo::NN_DESCENT});
+  inputs.insert(inputs.end(), inputs2.begin(), inputs2.end());
+
+  // searches seeded with the entry points of the index
+  inputs2 = raft::util::itertools::product<AnnCagraInputs>(
+    {100},
+    {10000},
+    {32},
+    {10},
+    {search_algo::SINGLE_CTA, search_algo::MULTI_CTA, search_algo::MULTI_KERNEL},
+    {1, 100},
+    {0},  // team_size
+    {32, 64},
+    {1},
+    {raft::distance::DistanceType::L2Expanded},
+    {false},
+    {0.95},
+    {1},
+    {false, true},
+    {false},
+    {dataset_compression::NONE, dataset_compression::FP16},
+    {0},
+    {false},
+    {1},
+    {true},
+    {false},
+    {0},
+    {graph_build_algo::IVF_PQ},
+    {16, 128});  // n_entry_points
+  inputs.insert(inputs.end(), inputs2.begin(), inputs2.end());
+
   return inputs;
 }
 
@@ -26,7 +26,11 @@ TEST_P(AnnCagraTestF_U32, AnnCagra) { this->testCagra(); }
 typedef AnnCagraSortTest<float, float, std::uint32_t> AnnCagraSortTestF_U32;
 TEST_P(AnnCagraSortTestF_U32, AnnCagraSort) { this->testCagraSort(); }
 
+typedef AnnCagraPruneTest<float, std::uint32_t> AnnCagraPruneTestF_U32;
+TEST_P(AnnCagraPruneTestF_U32, AnnCagraPrune) { this->testCagraPrune(); }
+
 INSTANTIATE_TEST_CASE_P(AnnCagraTest, AnnCagraTestF_U32, ::testing::ValuesIn(inputs));
 INSTANTIATE_TEST_CASE_P(AnnCagraSortTest, AnnCagraSortTestF_U32, ::testing::ValuesIn(inputs));
+INSTANTIATE_TEST_CASE_P(AnnCagraPruneTest, AnnCagraPruneTestF_U32, ::testing::ValuesIn(inputs));
 
 }  // namespace raft::neighbors::experimental::cagra
@@ -22,10 +22,14 @@
 
 #include <raft_internal/neighbors/naive_knn.cuh>
 
+#include <raft/core/device_csr_matrix.hpp>
 #include <raft/core/device_mdspan.hpp>
+#include <raft/core/host_mdarray.hpp>
 #include <raft/core/logger.hpp>
 #include <raft/distance/distance_types.hpp>
 #include <raft/neighbors/ivf_flat.cuh>
+#include <raft/neighbors/ivf_flat_helpers.cuh>
+#include <raft/neighbors/ivf_versioned_index.hpp>
 #include <raft/random/rng.cuh>
 #include <raft/spatial/knn/ann.cuh>
 #include <raft/spatial/knn/knn.cuh>
@@ -54,6 +58,9 @@ struct AnnIvfFlatInputs {
   IdxT nlist;
   raft::distance::DistanceType metric;
   bool adaptive_centers;
+  uint32_t max_candidates      = 0;
+  float probe_distance_ratio   = 0.0f;
+  size_t list_arena_chunk_size = 0;
 };
 
 template <typename IdxT>
@@ -61,7 +68,8 @@ template <typename IdxT>
 {
   os << "{ " << p.num_queries << ", " << p.num_db_vecs << ", " << p.dim << ", " << p.k << ", "
      << p.nprobe << ", " << p.nlist << ", " << static_cast<int>(p.metric) << ", "
-     << p.adaptive_centers << '}' << std::endl;
+     << p.adaptive_centers << ", " << p.max_candidates << ", " << p.probe_distance_ratio << ", "
+     << p.list_arena_chunk_size << '}' << std::endl;
   return os;
 }
 
@@ -152,10 +160,13 @@ class AnnIVFFlatTest : public ::testing::TestWithParam<AnnIvfFlatInputs<IdxT>> {
       {
         ivf_flat::index_params index_params;
         ivf_flat::search_params search_params;
-        index_params.n_lists          = ps.nlist;
-        index_params.metric           = ps.metric;
-        index_params.adaptive_centers = ps.adaptive_centers;
-        search_params.n_probes        = ps.nprobe;
+        index_params.n_lists               = ps.nlist;
+        index_params.metric                = ps.metric;
+        index_params.adaptive_centers      = ps.adaptive_centers;
+        index_params.list_arena_chunk_size = ps.list_arena_chunk_size;
+        search_params.n_probes             = ps.nprobe;
+        search_params.max_candidates       = ps.max_candidates;
+        search_params.probe_distance_ratio = ps.probe_distance_ratio;
 
         index_params.add_data_on_build        = false;
         index_params.kmeans_trainset_fraction = 0.5;
@@ -192,6 +203,64 @@ class AnnIVFFlatTest : public ::testing::TestWithParam<AnnIvfFlatInputs<IdxT>> {
                            new_half_of_data_indices_view),
                          &index_2);
 
+        if (!index_2.adaptive_centers()) {
+          // Add the first half of the data once more under new indices and remove it again;
+          // the search results must not change.
+          rmm::device_uvector<IdxT> extra_indices(half_of_data, stream_);
+          thrust::sequence(resource::get_thrust_policy(handle_),
+                           thrust::device_pointer_cast(extra_indices.data()),
+                           thrust::device_pointer_cast(extra_indices.data() + half_of_data),
+                           IdxT(ps.num_db_vecs));
+          auto extra_indices_view =
+            raft::make_device_vector_view<const IdxT, IdxT>(extra_indices.data(), half_of_data);
+          ivf_flat::extend(handle_,
+                           half_of_data_view,
+                           std::make_optional<raft::device_vector_view<const IdxT, IdxT>>(
+                             extra_indices_view),
+                           &index_2);
+          ASSERT_EQ(index_2.size(), IdxT(ps.num_db_vecs) + half_of_data);
+          ASSERT_EQ(ivf_flat::helpers::remove(handle_, extra_indices_view, &index_2), half_of_data);
+          ASSERT_EQ(index_2.size(), IdxT(ps.num_db_vecs));
+
+          // The same, ingesting the data in small batches in-place (some lists overflow).
+          ivf_flat::helpers::reserve(handle_, &index_2, 16);
+          constexpr IdxT kBatchSize = 1000;
+          for (IdxT offset = 0; offset < half_of_data; offset += kBatchSize) {
+            auto batch_size    = std::min(kBatchSize, half_of_data - offset);
+            auto batch_vectors = raft::make_device_matrix_view<const DataT, IdxT>(
+              database.data() + offset * ps.dim, batch_size, ps.dim);
+            auto batch_indices = raft::make_device_vector_view<const IdxT, IdxT>(
+              extra_indices.data() + offset, batch_size);
+            ivf_flat::helpers::extend_inplace(
+              handle_,
+              batch_vectors,
+              std::make_optional<raft::device_vector_view<const IdxT, IdxT>>(batch_indices),
+              &index_2);
+          }
+          ASSERT_EQ(index_2.size(), IdxT(ps.num_db_vecs) + half_of_data);
+          ASSERT_EQ(ivf_flat::helpers::remove(handle_, extra_indices_view, &index_2), half_of_data);
+          ASSERT_EQ(index_2.size(), IdxT(ps.num_db_vecs));
+
+          // A pinned snapshot of a versioned index is not affected by the updates.
+          ivf::versioned_index<index<DataT, IdxT>> vindex(
+            ivf_flat::detail::clone(handle_, index_2));
+          auto snapshot = vindex.snapshot();
+          vindex.update(handle_, [&](const index<DataT, IdxT>& current) {
+            return ivf_flat::extend(
+              handle_,
+              half_of_data_view,
+              std::make_optional<raft::device_vector_view<const IdxT, IdxT>>(extra_indices_view),
+              current);
+          });
+          ASSERT_EQ(vindex.version(), uint64_t(1));
+          ASSERT_EQ(snapshot->size(), IdxT(ps.num_db_vecs));
+          ASSERT_EQ(vindex.snapshot()->size(), IdxT(ps.num_db_vecs) + half_of_data);
+
+          // Shrinking the lists does not change the content of the index.
+          ivf_flat::helpers::compact(handle_, &index_2);
+          ASSERT_EQ(index_2.size(), IdxT(ps.num_db_vecs));
+        }
+
         auto search_queries_view = raft::make_device_matrix_view<const DataT, IdxT>(
           search_queries.data(), ps.num_queries, ps.dim);
         auto indices_out_view = raft::make_device_matrix_view<IdxT, IdxT>(
@@ -214,6 +283,74 @@ class AnnIVFFlatTest : public ::testing::TestWithParam<AnnIvfFlatInputs<IdxT>> {
         update_host(indices_ivfflat.data(), indices_ivfflat_dev.data(), queries_size, stream_);
         resource::sync_stream(handle_);
 
+        // Keep about a half of the lists on the device and the rest on the host
+        // (the host scan is slow, hence only the small batches).
+        if (ps.num_queries <= 1000) {
+          auto probe_counts =
+            ivf_flat::profile_probes(handle_, search_params, index_loaded, search_queries_view);
+          ivf_flat::hybrid_params hybrid_params;
+          hybrid_params.device_memory_limit = size_t(ps.num_db_vecs) * ps.dim * sizeof(DataT) / 2;
+          ivf_flat::host_lists<DataT, IdxT> lists(
+            handle_, hybrid_params, index_loaded, raft::make_const_mdspan(probe_counts.view()));
+          ASSERT_GT(lists.n_host_lists(), 0u);
+          ivf_flat::search(handle_,
+                           search_params,
+                           index_loaded,
+                           lists,
+                           search_queries_view,
+                           indices_out_view,
+                           dists_out_view);
+          std::vector<IdxT> indices_hybrid(queries_size);
+          std::vector<T> distances_hybrid(queries_size);
+          update_host(distances_hybrid.data(), distances_ivfflat_dev.data(), queries_size, stream_);
+          update_host(indices_hybrid.data(), indices_ivfflat_dev.data(), queries_size, stream_);
+          resource::sync_stream(handle_);
+          ASSERT_TRUE(eval_neighbours(indices_naive,
+                                      indices_hybrid,
+                                      distances_naive,
+                                      distances_hybrid,
+                                      ps.num_queries,
+                                      ps.k,
+                                      0.001,
+                                      min_recall));
+        }
+
+        // Search with a different k per query: the neighbors of every query are the nearest
+        // ones of the regular search.
+        {
+          auto ks = raft::make_host_vector<uint32_t, IdxT>(ps.num_queries);
+          for (IdxT i = 0; i < IdxT(ps.num_queries); i++) {
+            ks(i) = 1 + (i * 37) % ps.k;
+          }
+          auto out = raft::make_device_csr_matrix<float, int64_t, IdxT, int64_t>(
+            handle_, ps.num_queries, index_loaded.size());
+          ivf_flat::search(handle_,
+                           search_params,
+                           index_loaded,
+                           search_queries_view,
+                           raft::make_const_mdspan(ks.view()),
+                           out);
+          auto structure = out.structure_view();
+          std::vector<int64_t> indptr(ps.num_queries + 1);
+          std::vector<float> distances_ragged(structure.get_nnz());
+          update_host(indptr.data(), structure.get_indptr().data(), indptr.size(), stream_);
+          update_host(distances_ragged.data(),
+                      out.get_elements().data(),
+                      distances_ragged.size(),
+                      stream_);
+          resource::sync_stream(handle_);
+          for (IdxT i = 0; i < IdxT(ps.num_queries); i++) {
+            ASSERT_EQ(indptr[i + 1] - indptr[i], int64_t(ks(i)));
+            for (uint32_t j = 0; j < ks(i); j++) {
+              const float expected = distances_ivfflat[size_t(i) * ps.k + j];
+              ASSERT_NEAR(distances_ragged[indptr[i] + j],
+                          expected,
+                          0.001 * std::max(1.0f, std::abs(expected)))
+                << "query " << i << ", neighbor " << j;
+            }
+          }
+        }
+
         // Test the centroid invariants
         if (index_2.adaptive_centers()) {
           // The centers must be up-to-date with the corresponding data
@@ -355,6 +492,30 @@ const std::vector<AnnIvfFlatInputs<int64_t>> inputs = {
    raft::matrix::detail::select::warpsort::kMaxCapacity * 4,
    raft::matrix::detail::select::warpsort::kMaxCapacity * 4,
    raft::distance::DistanceType::InnerProduct,
-   false}};
+   false},
+
+  // test the grouped (GEMM-based) scan of the large batches
+  {20000, 10000, 3, 16, 40, 128, raft::distance::DistanceType::L2Expanded, false},
+  {20000, 10000, 32, 16, 40, 128, raft::distance::DistanceType::L2SqrtExpanded, true},
+  {20000, 10000, 33, 16, 40, 128, raft::distance::DistanceType::InnerProduct, false},
+  {20000, 10000, 32, 16, 40, 128, raft::distance::DistanceType::L2Expanded, true, 400},
+
+  // test the adaptive probing
+  {1000, 10000, 16, 10, 80, 1024, raft::distance::DistanceType::L2Expanded, false, 400},
+  {1000, 10000, 16, 10, 80, 1024, raft::distance::DistanceType::InnerProduct, false, 400},
+  {1000, 10000, 16, 10, 80, 1024, raft::distance::DistanceType::L2Expanded, false, 0, 2.0f},
+  {1000, 10000, 16, 10, 1024, 1024, raft::distance::DistanceType::L2Expanded, true, 600, 2.0f},
+
+  // test the lists placed in an arena
+  {1000, 10000, 4, 10, 40, 1024, raft::distance::DistanceType::L2Expanded, false, 0, 0.0f, 1 << 20},
+  {1000, 10000, 8, 16, 40, 128, raft::distance::DistanceType::InnerProduct, false, 0, 0.0f, 4096}};
+
+// The cosine distance supports only the floating-point data and the fixed centers
+const std::vector<AnnIvfFlatInputs<int64_t>> cosine_inputs = {
+  {1000, 10000, 5, 16, 40, 1024, raft::distance::DistanceType::CosineExpanded, false},
+  {1000, 10000, 16, 10, 40, 1024, raft::distance::DistanceType::CosineExpanded, false},
+  {100, 10000, 128, 10, 20, 512, raft::distance::DistanceType::CosineExpanded, false},
+  {1000, 10000, 2051, 16, 40, 1024, raft::distance::DistanceType::CosineExpanded, false},
+  {20000, 10000, 32, 16, 40, 128, raft::distance::DistanceType::CosineExpanded, false}};
 
 }  // namespace raft::neighbors::ivf_flat
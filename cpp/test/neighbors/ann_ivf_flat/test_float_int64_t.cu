@@ -24,5 +24,8 @@ typedef AnnIVFFlatTest<float, float, std::int64_t> AnnIVFFlatTestF;
 TEST_P(AnnIVFFlatTestF, AnnIVFFlat) { this->testIVFFlat(); }
 
 INSTANTIATE_TEST_CASE_P(AnnIVFFlatTest, AnnIVFFlatTestF, ::testing::ValuesIn(inputs));
+INSTANTIATE_TEST_CASE_P(AnnIVFFlatCosineTest,
+                        AnnIVFFlatTestF,
+                        ::testing::ValuesIn(cosine_inputs));
 
 }  // namespace raft::neighbors::ivf_flat
@@ -18,9 +18,13 @@
 #include "../test_utils.cuh"
 #include "ann_utils.cuh"
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/cuda_stream_pool.hpp>
 
+#include <raft_internal/comms/single_rank_comms.hpp>
 #include <raft_internal/neighbors/naive_knn.cuh>
 
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/host_mdarray.hpp>
 #include <raft/core/logger.hpp>
 #include <raft/distance/distance_types.hpp>
 #include <raft/linalg/map.cuh>
@@ -31,6 +35,7 @@
 #include <raft/neighbors/ivf_pq_serialize.cuh>
 #include <raft/random/rng.cuh>
 
+#include <rmm/cuda_stream_pool.hpp>
 #include <rmm/cuda_stream_view.hpp>
 #include <rmm/device_buffer.hpp>
 #include <rmm/device_vector.hpp>
@@ -40,9 +45,14 @@
 
 #include <cub/cub.cuh>
 
+#include <unistd.h>
+
 #include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <iostream>
+#include <memory>
+#include <numeric>
 #include <optional>
 #include <vector>
 
@@ -54,6 +64,8 @@ struct ivf_pq_inputs {
   uint32_t dim                     = 64;
   uint32_t k                       = 32;
   std::optional<double> min_recall = std::nullopt;
+  // The size of the stream pool set on the handle before the search (zero means no pool).
+  uint32_t n_streams = 0;
 
   ivf_pq::index_params index_params;
   ivf_pq::search_params search_params;
@@ -96,6 +108,7 @@ inline auto operator<<(std::ostream& os, const ivf_pq_inputs& p) -> std::ostream
   PRINT_DIFF(.dim);
   PRINT_DIFF(.k);
   PRINT_DIFF_V(.min_recall, p.min_recall.value_or(0));
+  PRINT_DIFF(.n_streams);
   PRINT_DIFF_V(.index_params.metric, print_metric{p.index_params.metric});
   PRINT_DIFF(.index_params.metric_arg);
   PRINT_DIFF(.index_params.add_data_on_build);
@@ -106,7 +119,11 @@ inline auto operator<<(std::ostream& os, const ivf_pq_inputs& p) -> std::ostream
   PRINT_DIFF(.index_params.pq_dim);
   PRINT_DIFF(.index_params.codebook_kind);
   PRINT_DIFF(.index_params.force_random_rotation);
+  PRINT_DIFF(.index_params.residual_pq_bits);
   PRINT_DIFF(.search_params.n_probes);
+  PRINT_DIFF(.search_params.max_candidates);
+  PRINT_DIFF(.search_params.probe_distance_ratio);
+  PRINT_DIFF(.search_params.residual_rerank_ratio);
   PRINT_DIFF_V(.search_params.lut_dtype, print_dtype{p.search_params.lut_dtype});
   PRINT_DIFF_V(.search_params.internal_distance_dtype,
                print_dtype{p.search_params.internal_distance_dtype});
@@ -213,6 +230,21 @@ class ivf_pq_test : public ::testing::TestWithParam<ivf_pq_inputs> {
     return ivf_pq::build<DataT, IdxT>(handle_, ipams, index_view);
   }
 
+  auto build_mg_only()
+  {
+    // The distributed build over a single rank must give an index of the same quality.
+    comms::initialize_single_rank_comms(&handle_);
+    auto ipams              = ps.index_params;
+    ipams.add_data_on_build = true;
+
+    auto index_view =
+      raft::make_device_matrix_view<const DataT, IdxT>(database.data(), ps.num_db_vecs, ps.dim);
+    auto idx = ivf_pq::build_mg<DataT, IdxT>(handle_, ipams, index_view);
+    EXPECT_EQ(idx.size(), IdxT(ps.num_db_vecs));
+    EXPECT_EQ(idx.n_lists(), ps.index_params.n_lists);
+    return idx;
+  }
+
   auto build_2_extends()
   {
     auto db_indices = make_device_vector<IdxT>(handle_, ps.num_db_vecs);
@@ -243,6 +275,134 @@ class ivf_pq_test : public ::testing::TestWithParam<ivf_pq_inputs> {
     return idx;
   }
 
+  auto build_host_extends()
+  {
+    // Extend from the host memory in two parts, so that the data goes through the pinned staging
+    auto size_1 = IdxT(ps.num_db_vecs) / 2;
+    auto size_2 = IdxT(ps.num_db_vecs) - size_1;
+    std::vector<DataT> host_vecs(size_t(ps.num_db_vecs) * size_t(ps.dim));
+    std::vector<IdxT> host_inds(ps.num_db_vecs);
+    std::iota(host_inds.begin(), host_inds.end(), IdxT(0));
+    update_host(host_vecs.data(), database.data(), host_vecs.size(), stream_);
+    resource::sync_stream(handle_);
+
+    auto ipams              = ps.index_params;
+    ipams.add_data_on_build = false;
+
+    auto database_view =
+      raft::make_device_matrix_view<DataT, IdxT>(database.data(), ps.num_db_vecs, ps.dim);
+    auto idx = ivf_pq::build<DataT, IdxT>(handle_, ipams, database_view);
+
+    ivf_pq::extend<DataT, IdxT>(handle_,
+                                &idx,
+                                host_vecs.data() + size_t(size_1) * size_t(ps.dim),
+                                host_inds.data() + size_1,
+                                size_2);
+    ivf_pq::extend<DataT, IdxT>(handle_, &idx, host_vecs.data(), host_inds.data(), size_1);
+    EXPECT_EQ(idx.size(), IdxT(ps.num_db_vecs));
+    return idx;
+  }
+
+  auto build_managed_extends()
+  {
+    // Extend from the managed memory in two parts: the batches point into the source, which is
+    // prefetched to the device one batch ahead
+    auto size_1 = IdxT(ps.num_db_vecs) / 2;
+    auto size_2 = IdxT(ps.num_db_vecs) - size_1;
+    rmm::mr::managed_memory_resource managed_memory;
+    rmm::device_uvector<DataT> managed_vecs(database.size(), stream_, &managed_memory);
+    rmm::device_uvector<IdxT> managed_inds(ps.num_db_vecs, stream_, &managed_memory);
+    raft::copy(managed_vecs.data(), database.data(), database.size(), stream_);
+    linalg::map_offset(
+      handle_,
+      raft::make_device_vector_view<IdxT, IdxT>(managed_inds.data(), IdxT(ps.num_db_vecs)),
+      identity_op{});
+    check_managed_batches(managed_vecs.data());
+
+    auto ipams              = ps.index_params;
+    ipams.add_data_on_build = false;
+
+    auto database_view =
+      raft::make_device_matrix_view<DataT, IdxT>(database.data(), ps.num_db_vecs, ps.dim);
+    auto idx = ivf_pq::build<DataT, IdxT>(handle_, ipams, database_view);
+
+    ivf_pq::extend<DataT, IdxT>(handle_,
+                                &idx,
+                                managed_vecs.data() + size_t(size_1) * size_t(ps.dim),
+                                managed_inds.data() + size_1,
+                                size_2);
+    ivf_pq::extend<DataT, IdxT>(handle_, &idx, managed_vecs.data(), managed_inds.data(), size_1);
+    EXPECT_EQ(idx.size(), IdxT(ps.num_db_vecs));
+    return idx;
+  }
+
+  /**
+   * Read a managed copy of the database with the batch_load_iterator, in order and then out of
+   * order (which prefetches the requested batch as well): the batches must point into the source
+   * and hold the data of their offsets.
+   */
+  void check_managed_batches(const DataT* managed_vecs)
+  {
+    const size_t batch_size = raft::div_rounding_up_safe<size_t>(ps.num_db_vecs, 5);
+    spatial::knn::detail::utils::batch_load_iterator<DataT> vec_batches(
+      managed_vecs, ps.num_db_vecs, ps.dim, batch_size, stream_);
+    ASSERT_FALSE(vec_batches.does_copy());
+    auto check_batch = [&](const auto& batch) {
+      ASSERT_EQ(batch.data(), managed_vecs + batch.offset() * ps.dim);
+      ASSERT_TRUE(devArrMatch(database.data() + batch.offset() * ps.dim,
+                              batch.data(),
+                              batch.size() * ps.dim,
+                              raft::Compare<DataT>(),
+                              stream_));
+    };
+    size_t n_batches = 0;
+    for (const auto& batch : vec_batches) {
+      check_batch(batch);
+      n_batches++;
+    }
+    // backwards, then every other batch
+    auto it = vec_batches.end();
+    while (it != vec_batches.begin()) {
+      check_batch(*(--it));
+    }
+    for (size_t i = 0; i < n_batches; i += 2) {
+      auto jt = vec_batches.begin();
+      for (size_t j = 0; j < i; j++) {
+        ++jt;
+      }
+      check_batch(*jt);
+    }
+  }
+
+  auto build_extend_remove()
+  {
+    // Add the first half of the data once more under new indices and remove it again
+    auto idx        = build_only();
+    auto n_extra    = IdxT(ps.num_db_vecs) / 2;
+    auto extra_inds = make_device_vector<IdxT, IdxT>(handle_, n_extra);
+    linalg::map_offset(handle_, extra_inds.view(), add_const_op<IdxT>{IdxT(ps.num_db_vecs)});
+    auto extra_vecs =
+      raft::make_device_matrix_view<const DataT, IdxT>(database.data(), n_extra, ps.dim);
+    ivf_pq::extend<DataT, IdxT>(handle_, extra_vecs, make_const_mdspan(extra_inds.view()), &idx);
+    EXPECT_EQ(idx.size(), IdxT(ps.num_db_vecs) + n_extra);
+    auto n_removed = ivf_pq::helpers::remove(handle_, make_const_mdspan(extra_inds.view()), &idx);
+    EXPECT_EQ(n_removed, n_extra);
+    EXPECT_EQ(idx.size(), IdxT(ps.num_db_vecs));
+    return idx;
+  }
+
+  auto build_extend_rebalance()
+  {
+    auto idx  = build_2_extends();
+    auto size = idx.size();
+    ivf_pq::helpers::compact(handle_, &idx);
+    EXPECT_EQ(idx.size(), size);
+    ivf_pq::helpers::rebalance(handle_, &idx, 1.25);
+    EXPECT_EQ(idx.size(), size);
+    EXPECT_GE(idx.n_lists(), ps.index_params.n_lists);
+    return idx;
+  }
+
   auto build_serialize()
   {
     ivf_pq::serialize<IdxT>(handle_, "ivf_pq_index", build_only());
@@ -371,6 +531,45 @@ class ivf_pq_test : public ::testing::TestWithParam<ivf_pq_inputs> {
                             Compare<uint8_t>{}));
   }
 
+  /**
+   * Search with a different k per query: the neighbors of every query are the nearest ones of the
+   * regular search, whose distances are `distances_ref` [num_queries, k]. The bucket searches may
+   * take another path of the top-k selection, hence the tolerance of the compressed distances.
+   */
+  void check_ragged_search(const index<IdxT>& index,
+                           raft::device_matrix_view<const DataT, uint32_t> queries,
+                           const std::vector<EvalT>& distances_ref,
+                           double compression_ratio)
+  {
+    auto ks = raft::make_host_vector<uint32_t, uint32_t>(ps.num_queries);
+    for (uint32_t i = 0; i < ps.num_queries; i++) {
+      ks(i) = 1 + (i * 37) % ps.k;
+    }
+    auto out = raft::make_device_csr_matrix<float, int64_t, IdxT, int64_t>(
+      handle_, ps.num_queries, index.size());
+    ivf_pq::search<DataT, IdxT>(
+      handle_, ps.search_params, index, queries, raft::make_const_mdspan(ks.view()), out);
+    auto structure = out.structure_view();
+    std::vector<int64_t> indptr(ps.num_queries + 1);
+    std::vector<float> distances_ragged(structure.get_nnz());
+    update_host(indptr.data(), structure.get_indptr().data(), indptr.size(), stream_);
+    update_host(
+      distances_ragged.data(), out.get_elements().data(), distances_ragged.size(), stream_);
+    resource::sync_stream(handle_);
+    for (uint32_t i = 0; i < ps.num_queries; i++) {
+      ASSERT_EQ(indptr[i + 1] - indptr[i], int64_t(ks(i))) << ps;
+      for (uint32_t j = 0; j < ks(i); j++) {
+        const float expected = distances_ref[size_t(i) * ps.k + j];
+        // the records out of bounds of the small probes have no meaningful distance
+        if (!std::isfinite(expected)) { continue; }
+        ASSERT_NEAR(distances_ragged[indptr[i] + j],
+                    expected,
+                    0.001 * compression_ratio * std::max(1.0f, std::abs(expected)))
+          << ps << ", query " << i << ", neighbor " << j;
+      }
+    }
+  }
+
   template <typename BuildIndex>
   void run(BuildIndex build_index)
   {
@@ -386,8 +585,13 @@ class ivf_pq_test : public ::testing::TestWithParam<ivf_pq_inputs> {
           check_reconstruct_extend(&index, compression_ratio, label);
         } break;
         case 1: {
-          // Dump and re-write codes for one label
-          check_packing(&index, label);
+          // Dump and re-write codes for one label (the codes of the residual layer cannot be
+          // written this way)
+          if (index.residual_pq_bits() == 0) {
+            check_packing(&index, label);
+          } else {
+            check_reconstruction(index, compression_ratio, label, 100, 7);
+          }
         } break;
         default: {
           // check a small subset of data in a randomly chosen cluster to see if the data
@@ -411,6 +615,10 @@ class ivf_pq_test : public ::testing::TestWithParam<ivf_pq_inputs> {
     auto dists_view = raft::make_device_matrix_view<EvalT, uint32_t>(
       distances_ivf_pq_dev.data(), ps.num_queries, ps.k);
 
+    if (ps.n_streams > 0) {
+      resource::set_cuda_stream_pool(handle_,
+                                     std::make_shared<rmm::cuda_stream_pool>(ps.n_streams));
+    }
     ivf_pq::search<DataT, IdxT>(
       handle_, ps.search_params, index, query_view, inds_view, dists_view);
 
@@ -418,6 +626,9 @@ class ivf_pq_test : public ::testing::TestWithParam<ivf_pq_inputs> {
     update_host(indices_ivf_pq.data(), indices_ivf_pq_dev.data(), queries_size, stream_);
     resource::sync_stream(handle_);
 
+    check_ragged_search(
+      index, raft::make_const_mdspan(query_view), distances_ivf_pq, compression_ratio);
+
     // A very conservative lower bound on recall
     double min_recall =
       static_cast<double>(ps.search_params.n_probes) / static_cast<double>(ps.index_params.n_lists);
@@ -471,6 +682,73 @@ class ivf_pq_test : public ::testing::TestWithParam<ivf_pq_inputs> {
     }
   }
 
+  /**
+   * Search the index with the lists offloaded to a list cache and compare the results to the
+   * search of the device-resident lists. The small cache cannot hold all the lists probed by the
+   * queries, so the lists are evicted and copied again between the batches.
+   */
+  void run_offloaded(list_storage storage, bool small_cache)
+  {
+    constexpr uint32_t kSmallCacheLists = 32;
+    index<IdxT> index                   = build_only();
+
+    const uint32_t cache_lists =
+      small_cache ? std::max(kSmallCacheLists, ps.search_params.n_probes) : index.n_lists();
+
+    size_t queries_size = ps.num_queries * ps.k;
+    rmm::device_uvector<EvalT> distances_dev(queries_size, stream_);
+    rmm::device_uvector<IdxT> indices_dev(queries_size, stream_);
+    auto query_view = raft::make_device_matrix_view<const DataT, uint32_t>(
+      search_queries.data(), ps.num_queries, ps.dim);
+    auto inds_view =
+      raft::make_device_matrix_view<IdxT, uint32_t>(indices_dev.data(), ps.num_queries, ps.k);
+    auto dists_view =
+      raft::make_device_matrix_view<EvalT, uint32_t>(distances_dev.data(), ps.num_queries, ps.k);
+
+    std::vector<IdxT> indices_device(queries_size);
+    std::vector<EvalT> distances_device(queries_size);
+    ivf_pq::search<DataT, IdxT>(
+      handle_, ps.search_params, index, query_view, inds_view, dists_view);
+    update_host(distances_device.data(), distances_dev.data(), queries_size, stream_);
+    update_host(indices_device.data(), indices_dev.data(), queries_size, stream_);
+    resource::sync_stream(handle_);
+
+    char path[] = "/tmp/raft_ivf_pq_lists_XXXXXX";
+    if (storage == list_storage::MAPPED_FILE) {
+      int fd = mkstemp(path);
+      ASSERT_GE(fd, 0);
+      close(fd);
+    }
+    std::vector<IdxT> indices_offloaded(queries_size);
+    std::vector<EvalT> distances_offloaded(queries_size);
+    {
+      ivf_pq::offload_params offload;
+      offload.storage     = storage;
+      offload.file_path   = storage == list_storage::MAPPED_FILE ? path : "";
+      offload.cache_lists = cache_lists;
+      ivf_pq::list_cache<IdxT> cache(handle_, offload, index);
+      ASSERT_EQ(cache.capacity(), std::min(cache_lists, index.n_lists()));
+      ivf_pq::search<DataT, IdxT>(
+        handle_, ps.search_params, index, cache, query_view, inds_view, dists_view);
+      update_host(distances_offloaded.data(), distances_dev.data(), queries_size, stream_);
+      update_host(indices_offloaded.data(), indices_dev.data(), queries_size, stream_);
+      resource::sync_stream(handle_);
+      // The lists probed by all the batches do not fit in a small cache: some are evicted.
+      if (cache.capacity() < index.n_lists()) { ASSERT_GT(cache.stats().evictions, 0u); }
+    }
+    if (storage == list_storage::MAPPED_FILE) { unlink(path); }
+
+    ASSERT_TRUE(eval_neighbours(indices_device,
+                                indices_offloaded,
+                                distances_device,
+                                distances_offloaded,
+                                ps.num_queries,
+                                ps.k,
+                                0.0001,
+                                0.99))
+      << ps;
+  }
+
   void SetUp() override  // NOLINT
   {
     gen_data();
@@ -632,6 +910,42 @@ inline auto enum_variety() -> test_cases_t
     x.index_params.force_random_rotation = false;
     x.min_recall                         = 0.86;
   });
+  ADD_CASE({
+    x.index_params.opq_n_iters = 5;
+    x.min_recall               = 0.86;
+  });
+  ADD_CASE({
+    x.index_params.force_random_rotation = true;
+    x.index_params.opq_n_iters           = 5;
+    x.index_params.pq_bits               = 4;
+    x.min_recall                         = 0.79;
+  });
+
+  ADD_CASE({
+    x.index_params.residual_pq_bits = 8;
+    x.min_recall                    = 0.9;
+  });
+  ADD_CASE({
+    x.index_params.pq_bits                = 4;
+    x.index_params.residual_pq_bits       = 4;
+    x.search_params.residual_rerank_ratio = 4;
+    x.min_recall                          = 0.86;
+  });
+
+  ADD_CASE({
+    x.index_params.list_arena_chunk_size = size_t{1} << 20;
+    x.min_recall                         = 0.86;
+  });
+
+  ADD_CASE({
+    x.search_params.n_probes       = 32;
+    x.search_params.max_candidates = 2560;
+    x.min_recall                   = 0.84;
+  });
+  ADD_CASE({
+    x.search_params.probe_distance_ratio = 2.0;
+    x.min_recall                         = 0.84;
+  });
 
   ADD_CASE({
     x.search_params.lut_dtype = CUDA_R_32F;
@@ -646,6 +960,12 @@ inline auto enum_variety() -> test_cases_t
     x.min_recall              = 0.84;
   });
 
+  ADD_CASE({
+    x.index_params.pq_bits    = 4;
+    x.search_params.lut_dtype = CUDA_R_8U;
+    x.min_recall              = 0.77;
+  });
+
   ADD_CASE({
     x.search_params.internal_distance_dtype = CUDA_R_32F;
     x.min_recall                            = 0.86;
@@ -697,6 +1017,19 @@ inline auto enum_variety_l2sqrt() -> test_cases_t
   });
 }
 
+inline auto enum_variety_cosine() -> test_cases_t
+{
+  return map<ivf_pq_inputs>(enum_variety(), [](const ivf_pq_inputs& x) {
+    ivf_pq_inputs y(x);
+    if (y.min_recall.has_value()) {
+      // Same as for the InnerProduct: the normalized scores are signed
+      y.min_recall = y.min_recall.value() * (y.search_params.lut_dtype == CUDA_R_8U ? 0.90 : 0.94);
+    }
+    y.index_params.metric = distance::DistanceType::CosineExpanded;
+    return y;
+  });
+}
+
 /**
  * Try different number of n_probes, some of which may trigger the non-fused version of the search
  * kernel.
@@ -746,6 +1079,53 @@ inline auto var_k() -> test_cases_t
     });
 }
 
+/**
+ * Tiny batches of queries, which are searched by the small-batch kernel (one block per query);
+ * see ivf_pq::detail::kSmallBatchMaxQueries.
+ *
+ * The recall is evaluated on very few queries here, hence the looser bounds.
+ */
+inline auto small_batch() -> test_cases_t
+{
+  auto var_k_cases = map<ivf_pq_inputs, uint32_t>({1, 10, 32, 100, 128}, [](uint32_t k) {
+    ivf_pq_inputs x;
+    x.k                      = k;
+    x.search_params.n_probes = max(x.search_params.n_probes, min(x.index_params.n_lists, k));
+    return x;
+  });
+  auto xs = enum_variety_l2() + enum_variety_ip() + var_k_cases;
+  const std::vector<uint32_t> batch_sizes{1, 3, 8};
+  for (size_t i = 0; i < xs.size(); i++) {
+    xs[i].num_queries = batch_sizes[i % batch_sizes.size()];
+    if (xs[i].min_recall.has_value()) { xs[i].min_recall = xs[i].min_recall.value() * 0.9; }
+  }
+  return xs;
+}
+
+/** Many queries searched in several batches pipelined over a stream pool. */
+inline auto pipelined() -> test_cases_t
+{
+  return map<ivf_pq_inputs>(enum_variety_l2(), [](const ivf_pq_inputs& x) {
+    ivf_pq_inputs y(x);
+    y.num_queries = 10000;
+    y.n_streams   = 2;
+    return y;
+  });
+}
+
+/** Searches with the lists offloaded to a list cache (see `run_offloaded`). */
+inline auto offload() -> test_cases_t
+{
+  return map<ivf_pq_inputs, uint32_t>({1, 8, 16}, [](uint32_t n_probes) {
+    ivf_pq_inputs x;
+    x.num_db_vecs            = 20000;
+    x.k                      = 10;
+    x.index_params.n_lists   = 128;
+    x.search_params.n_probes = n_probes;
+    return x;
+  });
+}
+
 /**
  * Cases brought up from downstream projects.
  */
@@ -806,18 +1186,62 @@ inline auto special_cases() -> test_cases_t
     this->run([this]() { return this->build_only(); }); \
   }
 
+#define TEST_BUILD_MG_SEARCH(type)                         \
+  TEST_P(type, build_mg_search) /* NOLINT */               \
+  {                                                        \
+    this->run([this]() { return this->build_mg_only(); }); \
+  }
+
 #define TEST_BUILD_EXTEND_SEARCH(type)                       \
   TEST_P(type, build_extend_search) /* NOLINT */             \
   {                                                          \
     this->run([this]() { return this->build_2_extends(); }); \
   }
 
+#define TEST_BUILD_HOST_EXTEND_SEARCH(type)                     \
+  TEST_P(type, build_host_extend_search) /* NOLINT */           \
+  {                                                             \
+    this->run([this]() { return this->build_host_extends(); }); \
+  }
+
+#define TEST_BUILD_MANAGED_EXTEND_SEARCH(type)                     \
+  TEST_P(type, build_managed_extend_search) /* NOLINT */           \
+  {                                                                \
+    this->run([this]() { return this->build_managed_extends(); }); \
+  }
+
+#define TEST_BUILD_EXTEND_REMOVE_SEARCH(type)                    \
+  TEST_P(type, build_extend_remove_search) /* NOLINT */          \
+  {                                                              \
+    this->run([this]() { return this->build_extend_remove(); }); \
+  }
+
+#define TEST_BUILD_EXTEND_REBALANCE_SEARCH(type)                    \
+  TEST_P(type, build_extend_rebalance_search) /* NOLINT */          \
+  {                                                                 \
+    this->run([this]() { return this->build_extend_rebalance(); }); \
+  }
+
 #define TEST_BUILD_SERIALIZE_SEARCH(type)                    \
   TEST_P(type, build_serialize_search) /* NOLINT */          \
   {                                                          \
     this->run([this]() { return this->build_serialize(); }); \
   }
 
+#define TEST_BUILD_OFFLOAD_SEARCH(type)                        \
+  TEST_P(type, build_offload_pinned_search) /* NOLINT */       \
+  {                                                            \
+    this->run_offloaded(list_storage::PINNED_HOST, false);     \
+  }                                                            \
+  TEST_P(type, build_offload_pinned_evict_search) /* NOLINT */ \
+  {                                                            \
+    this->run_offloaded(list_storage::PINNED_HOST, true);      \
+  }                                                            \
+  TEST_P(type, build_offload_mapped_evict_search) /* NOLINT */ \
+  {                                                            \
+    this->run_offloaded(list_storage::MAPPED_FILE, true);      \
+  }
+
 #define INSTANTIATE(type, vals) \
   INSTANTIATE_TEST_SUITE_P(IvfPq, type, ::testing::ValuesIn(vals)); /* NOLINT */
 
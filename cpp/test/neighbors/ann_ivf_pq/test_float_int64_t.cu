@@ -20,8 +20,20 @@ namespace raft::neighbors::ivf_pq {
 
 using f32_f32_i64 = ivf_pq_test<float, float, int64_t>;
 
+TEST_BUILD_MG_SEARCH(f32_f32_i64)
 TEST_BUILD_EXTEND_SEARCH(f32_f32_i64)
+TEST_BUILD_HOST_EXTEND_SEARCH(f32_f32_i64)
+TEST_BUILD_MANAGED_EXTEND_SEARCH(f32_f32_i64)
+TEST_BUILD_EXTEND_REMOVE_SEARCH(f32_f32_i64)
+TEST_BUILD_EXTEND_REBALANCE_SEARCH(f32_f32_i64)
 TEST_BUILD_SERIALIZE_SEARCH(f32_f32_i64)
-INSTANTIATE(f32_f32_i64, defaults() + small_dims() + big_dims_moderate_lut());
+INSTANTIATE(f32_f32_i64,
+            defaults() + small_dims() + big_dims_moderate_lut() + small_batch() + pipelined() +
+              enum_variety_cosine());
+
+using f32_f32_i64_offload = ivf_pq_test<float, float, int64_t>;
+
+TEST_BUILD_OFFLOAD_SEARCH(f32_f32_i64_offload)
+INSTANTIATE(f32_f32_i64_offload, offload());
 
 }  // namespace raft::neighbors::ivf_pq
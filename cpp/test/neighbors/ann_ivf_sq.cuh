@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "../test_utils.cuh"
+#include "ann_utils.cuh"
+#include <raft/core/resource/cuda_stream.hpp>
+
+#include <raft_internal/neighbors/naive_knn.cuh>
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/neighbors/ivf_sq.cuh>
+#include <raft/random/rng.cuh>
+#include <raft/util/itertools.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <iostream>
+#include <optional>
+#include <vector>
+
+namespace raft::neighbors::ivf_sq {
+
+struct AnnIvfSqInputs {
+  int num_queries;
+  int num_db_vecs;
+  int dim;
+  int k;
+  int n_probes;
+  int n_lists;
+  raft::distance::DistanceType metric;
+  // build the lists in two steps: the trained empty index is extended with two halves of the data
+  bool split_extend;
+  double min_recall;
+};
+
+inline ::std::ostream& operator<<(::std::ostream& os, const AnnIvfSqInputs& p)
+{
+  os << "{ " << p.num_queries << ", " << p.num_db_vecs << ", " << p.dim << ", " << p.k << ", "
+     << p.n_probes << ", " << p.n_lists << ", " << static_cast<int>(p.metric) << ", "
+     << p.split_extend << '}' << std::endl;
+  return os;
+}
+
+template <typename CodeT, typename IdxT>
+class AnnIvfSqTest : public ::testing::TestWithParam<AnnIvfSqInputs> {
+ public:
+  AnnIvfSqTest()
+    : stream_(resource::get_cuda_stream(handle_)),
+      ps(::testing::TestWithParam<AnnIvfSqInputs>::GetParam()),
+      database(0, stream_),
+      search_queries(0, stream_)
+  {
+  }
+
+  void testIvfSq()
+  {
+    const size_t queries_size = size_t(ps.num_queries) * ps.k;
+    std::vector<IdxT> indices_naive(queries_size);
+    std::vector<float> distances_naive(queries_size);
+    std::vector<IdxT> indices_ivf_sq(queries_size);
+    std::vector<float> distances_ivf_sq(queries_size);
+
+    {
+      rmm::device_uvector<float> distances_naive_dev(queries_size, stream_);
+      rmm::device_uvector<IdxT> indices_naive_dev(queries_size, stream_);
+      naive_knn<float, float, IdxT>(distances_naive_dev.data(),
+                                    indices_naive_dev.data(),
+                                    search_queries.data(),
+                                    database.data(),
+                                    ps.num_queries,
+                                    ps.num_db_vecs,
+                                    ps.dim,
+                                    ps.k,
+                                    ps.metric,
+                                    stream_);
+      update_host(distances_naive.data(), distances_naive_dev.data(), queries_size, stream_);
+      update_host(indices_naive.data(), indices_naive_dev.data(), queries_size, stream_);
+      resource::sync_stream(handle_);
+    }
+
+    {
+      index_params index_params;
+      index_params.n_lists                  = ps.n_lists;
+      index_params.metric                   = ps.metric;
+      index_params.kmeans_trainset_fraction = 0.5;
+      index_params.add_data_on_build        = !ps.split_extend;
+
+      auto database_view = raft::make_device_matrix_view<const float, IdxT>(
+        database.data(), IdxT(ps.num_db_vecs), IdxT(ps.dim));
+      auto index = ivf_sq::build<CodeT>(handle_, index_params, database_view);
+      if (ps.split_extend) {
+        // the first half gets the implicit ids, the second half is labeled explicitly
+        const IdxT half_rows = ps.num_db_vecs / 2;
+        const IdxT rest_rows = ps.num_db_vecs - half_rows;
+        const std::optional<raft::device_vector_view<const IdxT, IdxT>> no_opt = std::nullopt;
+        auto first_half = raft::make_device_matrix_view<const float, IdxT>(
+          database.data(), half_rows, IdxT(ps.dim));
+        ivf_sq::extend(handle_, first_half, no_opt, &index);
+
+        std::vector<IdxT> second_ids_h(rest_rows);
+        for (IdxT i = 0; i < rest_rows; i++) {
+          second_ids_h[i] = half_rows + i;
+        }
+        rmm::device_uvector<IdxT> second_ids(rest_rows, stream_);
+        update_device(second_ids.data(), second_ids_h.data(), rest_rows, stream_);
+        auto second_half = raft::make_device_matrix_view<const float, IdxT>(
+          database.data() + size_t(half_rows) * ps.dim, rest_rows, IdxT(ps.dim));
+        ivf_sq::extend(handle_,
+                       second_half,
+                       std::make_optional<raft::device_vector_view<const IdxT, IdxT>>(
+                         raft::make_device_vector_view<const IdxT, IdxT>(second_ids.data(),
+                                                                         rest_rows)),
+                       &index);
+      }
+      ASSERT_EQ(index.size(), IdxT(ps.num_db_vecs));
+
+      rmm::device_uvector<float> distances_dev(queries_size, stream_);
+      rmm::device_uvector<IdxT> indices_dev(queries_size, stream_);
+      search_params search_params;
+      search_params.n_probes = ps.n_probes;
+      auto queries_view      = raft::make_device_matrix_view<const float, IdxT>(
+        search_queries.data(), IdxT(ps.num_queries), IdxT(ps.dim));
+      auto indices_view = raft::make_device_matrix_view<IdxT, IdxT>(
+        indices_dev.data(), IdxT(ps.num_queries), IdxT(ps.k));
+      auto distances_view = raft::make_device_matrix_view<float, IdxT>(
+        distances_dev.data(), IdxT(ps.num_queries), IdxT(ps.k));
+      ivf_sq::search(handle_, search_params, index, queries_view, indices_view, distances_view);
+      update_host(distances_ivf_sq.data(), distances_dev.data(), queries_size, stream_);
+      update_host(indices_ivf_sq.data(), indices_dev.data(), queries_size, stream_);
+      resource::sync_stream(handle_);
+    }
+
+    // The distances to the dequantized codes are close, but not equal to the exact ones
+    ASSERT_TRUE(eval_neighbours(indices_naive,
+                                indices_ivf_sq,
+                                distances_naive,
+                                distances_ivf_sq,
+                                ps.num_queries,
+                                ps.k,
+                                std::is_same_v<CodeT, half> ? 0.01 : 0.05,
+                                ps.min_recall));
+  }
+
+  void SetUp() override
+  {
+    database.resize(size_t(ps.num_db_vecs) * ps.dim, stream_);
+    search_queries.resize(size_t(ps.num_queries) * ps.dim, stream_);
+    raft::random::RngState r(1234ULL);
+    raft::random::uniform(
+      handle_, r, database.data(), ps.num_db_vecs * ps.dim, float(-1.0), float(1.0));
+    raft::random::uniform(
+      handle_, r, search_queries.data(), ps.num_queries * ps.dim, float(-1.0), float(1.0));
+    resource::sync_stream(handle_);
+  }
+
+  void TearDown() override
+  {
+    resource::sync_stream(handle_);
+    database.resize(0, stream_);
+    search_queries.resize(0, stream_);
+  }
+
+ private:
+  raft::resources handle_;
+  rmm::cuda_stream_view stream_;
+  AnnIvfSqInputs ps;
+  rmm::device_uvector<float> database;
+  rmm::device_uvector<float> search_queries;
+};
+
+const std::vector<AnnIvfSqInputs> inputs = {
+  // varying dim: the vectorized and the scalar interleaving
+  {1000, 10000, 16, 10, 40, 64, raft::distance::DistanceType::L2Expanded, false, 0.8},
+  {1000, 10000, 7, 10, 40, 64, raft::distance::DistanceType::L2Expanded, false, 0.8},
+  {1000, 10000, 64, 10, 40, 64, raft::distance::DistanceType::L2SqrtExpanded, false, 0.8},
+  {1000, 10000, 24, 10, 40, 64, raft::distance::DistanceType::InnerProduct, false, 0.8},
+  // all the lists are probed
+  {100, 5000, 32, 32, 64, 64, raft::distance::DistanceType::L2Expanded, false, 0.9},
+  {100, 5000, 32, 32, 64, 64, raft::distance::DistanceType::InnerProduct, false, 0.9},
+  // large k
+  {100, 10000, 32, 256, 64, 64, raft::distance::DistanceType::L2Expanded, false, 0.8},
+  // the query terms do not fit into the shared memory
+  {20, 2000, 2050, 10, 16, 16, raft::distance::DistanceType::L2Expanded, false, 0.8},
+  {20, 2000, 4100, 10, 16, 16, raft::distance::DistanceType::InnerProduct, false, 0.8},
+  // the index is filled by extend
+  {1000, 10000, 16, 10, 40, 64, raft::distance::DistanceType::L2Expanded, true, 0.8},
+  // more queries than the grid y limit
+  {40000, 5000, 8, 5, 8, 32, raft::distance::DistanceType::L2Expanded, false, 0.8}};
+
+}  // namespace raft::neighbors::ivf_sq
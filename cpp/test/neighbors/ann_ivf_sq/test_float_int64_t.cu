@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "../ann_ivf_sq.cuh"
+
+namespace raft::neighbors::ivf_sq {
+
+typedef AnnIvfSqTest<int8_t, std::int64_t> AnnIvfSqTestI8_I64;
+TEST_P(AnnIvfSqTestI8_I64, AnnIvfSq) { this->testIvfSq(); }
+
+INSTANTIATE_TEST_CASE_P(AnnIvfSqTest, AnnIvfSqTestI8_I64, ::testing::ValuesIn(inputs));
+
+typedef AnnIvfSqTest<half, std::int64_t> AnnIvfSqTestF16_I64;
+TEST_P(AnnIvfSqTestF16_I64, AnnIvfSq) { this->testIvfSq(); }
+
+INSTANTIATE_TEST_CASE_P(AnnIvfSqTest, AnnIvfSqTestF16_I64, ::testing::ValuesIn(inputs));
+
+}  // namespace raft::neighbors::ivf_sq
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "../test_utils.cuh"
+#include "ann_utils.cuh"
+#include <raft/core/resource/cuda_stream.hpp>
+
+#include <raft_internal/neighbors/naive_knn.cuh>
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/host_mdarray.hpp>
+#include <raft/core/logger.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/neighbors/nn_descent.cuh>
+#include <raft/random/rng.cuh>
+#include <raft/util/itertools.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace raft::neighbors::experimental::nn_descent {
+
+struct AnnNNDescentInputs {
+  int n_rows;
+  int dim;
+  int graph_degree;
+  raft::distance::DistanceType metric;
+  bool host_dataset;
+  double min_recall;
+};
+
+inline ::std::ostream& operator<<(::std::ostream& os, const AnnNNDescentInputs& p)
+{
+  os << "dataset shape=" << p.n_rows << "x" << p.dim << ", graph_degree=" << p.graph_degree
+     << ", metric=" << static_cast<int>(p.metric) << (p.host_dataset ? ", host" : ", device")
+     << std::endl;
+  return os;
+}
+
+template <typename DistanceT, typename DataT, typename IdxT>
+class AnnNNDescentTest : public ::testing::TestWithParam<AnnNNDescentInputs> {
+ public:
+  AnnNNDescentTest()
+    : stream_(resource::get_cuda_stream(handle_)),
+      ps(::testing::TestWithParam<AnnNNDescentInputs>::GetParam()),
+      database(0, stream_)
+  {
+  }
+
+ protected:
+  void testNNDescent()
+  {
+    // the nearest neighbor of every vector is itself, it's dropped from the expected graph
+    const size_t gt_degree = ps.graph_degree + 1;
+    std::vector<IdxT> indices_naive(size_t(ps.n_rows) * gt_degree);
+    std::vector<IdxT> indices_nn_descent(size_t(ps.n_rows) * ps.graph_degree);
+
+    {
+      rmm::device_uvector<DistanceT> distances_naive_dev(indices_naive.size(), stream_);
+      rmm::device_uvector<IdxT> indices_naive_dev(indices_naive.size(), stream_);
+      naive_knn<DistanceT, DataT, IdxT>(distances_naive_dev.data(),
+                                        indices_naive_dev.data(),
+                                        database.data(),
+                                        database.data(),
+                                        ps.n_rows,
+                                        ps.n_rows,
+                                        ps.dim,
+                                        gt_degree,
+                                        ps.metric,
+                                        stream_);
+      update_host(indices_naive.data(), indices_naive_dev.data(), indices_naive.size(), stream_);
+      resource::sync_stream(handle_);
+    }
+
+    {
+      nn_descent::index_params index_params;
+      index_params.metric                    = ps.metric;
+      index_params.graph_degree              = ps.graph_degree;
+      index_params.intermediate_graph_degree = 2 * ps.graph_degree;
+
+      auto database_view = raft::make_device_matrix_view<const DataT, int64_t>(
+        (const DataT*)database.data(), ps.n_rows, ps.dim);
+
+      auto graph = raft::make_host_matrix<IdxT, int64_t>(ps.n_rows, ps.graph_degree);
+      nn_descent::index<IdxT> index{handle_, graph.view()};
+      if (ps.host_dataset) {
+        auto database_host = raft::make_host_matrix<DataT, int64_t>(ps.n_rows, ps.dim);
+        raft::copy(database_host.data_handle(), database.data(), database.size(), stream_);
+        resource::sync_stream(handle_);
+        auto database_host_view = raft::make_host_matrix_view<const DataT, int64_t>(
+          (const DataT*)database_host.data_handle(), ps.n_rows, ps.dim);
+        nn_descent::build<DataT, IdxT>(handle_, index_params, database_host_view, index);
+      } else {
+        nn_descent::build<DataT, IdxT>(handle_, index_params, database_view, index);
+      }
+      std::copy_n(graph.data_handle(), graph.size(), indices_nn_descent.begin());
+      resource::sync_stream(handle_);
+    }
+
+    size_t match_count = 0;
+    for (int i = 0; i < ps.n_rows; i++) {
+      std::unordered_set<IdxT> expected;
+      for (size_t j = 0; j < gt_degree && expected.size() < size_t(ps.graph_degree); j++) {
+        auto id = indices_naive[i * gt_degree + j];
+        if (id != IdxT(i)) { expected.insert(id); }
+      }
+      for (int j = 0; j < ps.graph_degree; j++) {
+        auto id = indices_nn_descent[size_t(i) * ps.graph_degree + j];
+        ASSERT_NE(id, IdxT(i)) << "row " << i << " is its own neighbor";
+        if (expected.count(id) > 0) { match_count++; }
+      }
+    }
+    const double recall = double(match_count) / (double(ps.n_rows) * ps.graph_degree);
+    RAFT_LOG_INFO(
+      "Recall = %f (%zu/%zu)", recall, match_count, size_t(ps.n_rows) * ps.graph_degree);
+    ASSERT_GE(recall, ps.min_recall);
+  }
+
+  void SetUp() override
+  {
+    database.resize(((size_t)ps.n_rows) * ps.dim, stream_);
+    raft::random::Rng r(1234ULL);
+    if constexpr (std::is_same<DataT, float>{}) {
+      r.normal(database.data(), ps.n_rows * ps.dim, DataT(0.1), DataT(2.0), stream_);
+    } else {
+      r.uniformInt(database.data(), ps.n_rows * ps.dim, DataT(1), DataT(20), stream_);
+    }
+    resource::sync_stream(handle_);
+  }
+
+  void TearDown() override
+  {
+    resource::sync_stream(handle_);
+    database.resize(0, stream_);
+  }
+
+ private:
+  raft::resources handle_;
+  rmm::cuda_stream_view stream_;
+  AnnNNDescentInputs ps;
+  rmm::device_uvector<DataT> database;
+};
+
+const std::vector<AnnNNDescentInputs> inputs = raft::util::itertools::product<AnnNNDescentInputs>(
+  {1000, 2000},             // n_rows
+  {3, 5, 8, 17, 64, 137},  // dim
+  {32, 64},                // graph_degree
+  {raft::distance::L2Expanded},
+  {false, true},
+  {0.90});
+
+}  // namespace raft::neighbors::experimental::nn_descent
@@ -17,6 +17,7 @@
 #include "../test_utils.cuh"
 #include "spatial_data.h"
 #include <raft/core/device_mdspan.hpp>
+#include <raft/core/operators.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resource/thrust_policy.hpp>
 #include <raft/distance/distance_types.hpp>
@@ -126,6 +127,20 @@ struct ToRadians {
   __device__ __host__ float operator()(float a) { return a * (CUDART_PI_F / 180.0); }
 };
 
+/**
+ * The inner products and the squared L2 distances of the blobs are large enough for the rounding
+ * errors of the GEMM to exceed the absolute tolerance of the comparison; scale the data down.
+ */
+template <typename value_t>
+void scale_down(const raft::resources& handle, value_t* data, size_t size)
+{
+  thrust::transform(resource::get_thrust_policy(handle),
+                    data,
+                    data + size,
+                    data,
+                    raft::mul_const_op<value_t>(value_t(0.1)));
+}
+
 template <typename value_int = std::uint32_t>
 struct BallCoverInputs {
   value_int k;
@@ -139,7 +154,10 @@ struct BallCoverInputs {
 template <typename value_idx, typename value_t, typename value_int = std::uint32_t>
 class BallCoverKNNQueryTest : public ::testing::TestWithParam<BallCoverInputs<value_int>> {
  protected:
-  void basicTest()
+  /**
+   * @param extend build the index on the first half of the points and insert the rest into it
+   */
+  void basicTest(bool extend = false)
   {
     params = ::testing::TestWithParam<BallCoverInputs<value_int>>::GetParam();
     raft::resources handle;
@@ -172,6 +190,12 @@ class BallCoverKNNQueryTest : public ::testing::TestWithParam<BallCoverInputs<va
                              n_centers,
                              resource::get_cuda_stream(handle));
 
+    if (metric == raft::distance::DistanceType::InnerProduct ||
+        metric == raft::distance::DistanceType::L2Expanded) {
+      scale_down(handle, X.data(), X.size());
+      scale_down(handle, X2.data(), X2.size());
+    }
+
     rmm::device_uvector<value_idx> d_ref_I(params.n_query * k, resource::get_cuda_stream(handle));
     rmm::device_uvector<value_t> d_ref_D(params.n_query * k, resource::get_cuda_stream(handle));
 
@@ -212,9 +236,18 @@ class BallCoverKNNQueryTest : public ::testing::TestWithParam<BallCoverInputs<va
     auto d_pred_D_view =
       raft::make_device_matrix_view<value_t, value_int>(d_pred_D.data(), params.n_query, k);
 
-    BallCoverIndex<value_idx, value_t, value_int, value_int> index(handle, X_view, metric);
+    auto X_build_view = raft::make_device_matrix_view<value_t, value_int>(
+      X.data(), extend ? params.n_rows / 2 : params.n_rows, params.n_cols);
+    BallCoverIndex<value_idx, value_t, value_int, value_int> index(handle, X_build_view, metric);
 
     build_index(handle, index);
+    if (extend) {
+      ball_cover::extend(handle,
+                         index,
+                         raft::make_device_matrix_view<const value_t, value_int>(
+                           X_view.data_handle(), params.n_rows, params.n_cols));
+      ASSERT_EQ(index.m, params.n_rows);
+    }
     knn_query(handle, index, X2_view, d_pred_I_view, d_pred_D_view, k, true);
 
     resource::sync_stream(handle);
@@ -273,6 +306,11 @@ class BallCoverAllKNNTest : public ::testing::TestWithParam<BallCoverInputs<valu
                              n_centers,
                              resource::get_cuda_stream(handle));
 
+    if (metric == raft::distance::DistanceType::InnerProduct ||
+        metric == raft::distance::DistanceType::L2Expanded) {
+      scale_down(handle, X.data(), X.size());
+    }
+
     rmm::device_uvector<value_idx> d_ref_I(params.n_rows * k, resource::get_cuda_stream(handle));
     rmm::device_uvector<value_t> d_ref_D(params.n_rows * k, resource::get_cuda_stream(handle));
 
@@ -359,14 +397,30 @@ const std::vector<BallCoverInputs<std::uint32_t>> ballcover_inputs = {
   {11, 6000, 3, 1.0, 10000, raft::distance::DistanceType::L2SqrtUnexpanded},
   {25, 10000, 3, 1.0, 5000, raft::distance::DistanceType::L2SqrtUnexpanded}};
 
+// Served by the tiled GEMM and top-k selection
+const std::vector<BallCoverInputs<std::uint32_t>> ballcover_gemm_inputs = {
+  {10, 10000, 32, 1.0, 5000, raft::distance::DistanceType::L2SqrtExpanded},
+  {25, 8000, 64, 1.0, 5000, raft::distance::DistanceType::L2Expanded},
+  {11, 10000, 32, 1.0, 5000, raft::distance::DistanceType::CosineExpanded},
+  {25, 6000, 256, 1.0, 2000, raft::distance::DistanceType::CosineExpanded},
+  {5, 6000, 128, 1.0, 5000, raft::distance::DistanceType::InnerProduct},
+  {2, 5000, 3, 1.0, 5000, raft::distance::DistanceType::InnerProduct}};
+
 INSTANTIATE_TEST_CASE_P(BallCoverAllKNNTest,
                         BallCoverAllKNNTestF,
                         ::testing::ValuesIn(ballcover_inputs));
 INSTANTIATE_TEST_CASE_P(BallCoverKNNQueryTest,
                         BallCoverKNNQueryTestF,
                         ::testing::ValuesIn(ballcover_inputs));
+INSTANTIATE_TEST_CASE_P(BallCoverGemmAllKNNTest,
+                        BallCoverAllKNNTestF,
+                        ::testing::ValuesIn(ballcover_gemm_inputs));
+INSTANTIATE_TEST_CASE_P(BallCoverGemmKNNQueryTest,
+                        BallCoverKNNQueryTestF,
+                        ::testing::ValuesIn(ballcover_gemm_inputs));
 
 TEST_P(BallCoverAllKNNTestF, Fit) { basicTest(); }
 TEST_P(BallCoverKNNQueryTestF, Fit) { basicTest(); }
+TEST_P(BallCoverKNNQueryTestF, Extend) { basicTest(true); }
 
 }  // namespace raft::neighbors::ball_cover
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+#include "./ann_utils.cuh"
+#include "./knn_utils.cuh"
+
+#include <raft_internal/comms/single_rank_comms.hpp>
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/neighbors/brute_force.cuh>
+#include <raft/random/rng.cuh>
+
+#include <rmm/device_uvector.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+namespace raft::neighbors::brute_force {
+
+struct SearchMgInputs {
+  int num_queries;
+  int num_db_vecs;
+  int dim;
+  int k;
+  // the number of queries per batch of the gathered candidates (0: a single batch)
+  int batch_queries;
+  raft::distance::DistanceType metric;
+};
+
+std::ostream& operator<<(std::ostream& os, const SearchMgInputs& input)
+{
+  return os << "num_queries:" << input.num_queries << " num_vecs:" << input.num_db_vecs
+            << " dim:" << input.dim << " k:" << input.k
+            << " batch_queries:" << input.batch_queries
+            << " metric:" << print_metric{input.metric};
+}
+
+/**
+ * search_mg over a single-rank communicator must find the neighbors of brute_force::search: this
+ * checks the merge of the gathered candidates (including the sign flip of the similarities) and
+ * the output offsets of the query batches.
+ */
+template <typename T>
+class SearchMgTest : public ::testing::TestWithParam<SearchMgInputs> {
+ public:
+  SearchMgTest()
+    : stream_(resource::get_cuda_stream(handle_)),
+      params_(::testing::TestWithParam<SearchMgInputs>::GetParam()),
+      database_(params_.num_db_vecs * params_.dim, stream_),
+      queries_(params_.num_queries * params_.dim, stream_),
+      indices_(params_.num_queries * params_.k, stream_),
+      distances_(params_.num_queries * params_.k, stream_),
+      ref_indices_(params_.num_queries * params_.k, stream_),
+      ref_distances_(params_.num_queries * params_.k, stream_)
+  {
+  }
+
+ protected:
+  void SetUp() override
+  {
+    raft::random::RngState r(1234ULL);
+    uniform(handle_, r, database_.data(), database_.size(), T(-1.0), T(1.0));
+    uniform(handle_, r, queries_.data(), queries_.size(), T(-1.0), T(1.0));
+    comms::initialize_single_rank_comms(&handle_);
+  }
+
+  void testSearchMg()
+  {
+    const int m = params_.num_queries;
+    const int n = params_.num_db_vecs;
+    const int k = params_.k;
+
+    auto idx = brute_force::build(
+      handle_,
+      raft::make_device_matrix_view<const T, int64_t>(database_.data(), n, params_.dim),
+      params_.metric);
+    auto queries_view =
+      raft::make_device_matrix_view<const T, int64_t>(queries_.data(), m, params_.dim);
+    brute_force::search<T, int64_t>(
+      handle_,
+      idx,
+      queries_view,
+      raft::make_device_matrix_view<int64_t, int64_t>(ref_indices_.data(), m, k),
+      raft::make_device_matrix_view<T, int64_t>(ref_distances_.data(), m, k));
+
+    const size_t max_gathered_bytes =
+      params_.batch_queries > 0 ? size_t(params_.batch_queries) * k * (sizeof(T) + sizeof(int64_t))
+                                : size_t(1) << 30;
+    detail::brute_force_search_mg<T, int64_t>(
+      handle_,
+      idx,
+      queries_view,
+      raft::make_device_matrix_view<int64_t, int64_t>(indices_.data(), m, k),
+      raft::make_device_matrix_view<T, int64_t>(distances_.data(), m, k),
+      max_gathered_bytes);
+
+    ASSERT_TRUE(raft::spatial::knn::devArrMatchKnnPair(ref_indices_.data(),
+                                                       indices_.data(),
+                                                       ref_distances_.data(),
+                                                       distances_.data(),
+                                                       m,
+                                                       k,
+                                                       T(0.001),
+                                                       stream_,
+                                                       true));
+  }
+
+ private:
+  raft::resources handle_;
+  cudaStream_t stream_ = 0;
+  SearchMgInputs params_;
+  rmm::device_uvector<T> database_;
+  rmm::device_uvector<T> queries_;
+  rmm::device_uvector<int64_t> indices_;
+  rmm::device_uvector<T> distances_;
+  rmm::device_uvector<int64_t> ref_indices_;
+  rmm::device_uvector<T> ref_distances_;
+};
+
+const std::vector<SearchMgInputs> search_mg_inputs = {
+  // a single batch
+  {100, 5000, 32, 10, 0, raft::distance::DistanceType::L2Expanded},
+  {100, 5000, 32, 10, 0, raft::distance::DistanceType::InnerProduct},
+  // several batches, the last one partial
+  {100, 5000, 32, 10, 7, raft::distance::DistanceType::L2Expanded},
+  {100, 5000, 32, 64, 7, raft::distance::DistanceType::InnerProduct},
+  {1000, 2000, 16, 100, 128, raft::distance::DistanceType::L2SqrtExpanded},
+  {1000, 2000, 16, 100, 128, raft::distance::DistanceType::InnerProduct},
+  // a query per batch
+  {20, 1000, 8, 5, 1, raft::distance::DistanceType::InnerProduct}};
+
+typedef SearchMgTest<float> SearchMgTestF;
+TEST_P(SearchMgTestF, SingleRank) { this->testSearchMg(); }
+
+INSTANTIATE_TEST_CASE_P(SearchMgTest, SearchMgTestF, ::testing::ValuesIn(search_mg_inputs));
+
+}  // namespace raft::neighbors::brute_force
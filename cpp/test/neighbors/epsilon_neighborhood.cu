@@ -17,12 +17,15 @@
 #include "../test_utils.cuh"
 #include <gtest/gtest.h>
 #include <memory>
+#include <raft/core/device_csr_matrix.hpp>
 #include <raft/core/device_mdspan.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
+#include <raft/neighbors/epsilon_neighborhood.cuh>
 #include <raft/random/make_blobs.cuh>
 #include <raft/spatial/knn/epsilon_neighborhood.cuh>
 #include <raft/util/cudart_utils.hpp>
 #include <rmm/device_uvector.hpp>
+#include <vector>
 
 namespace raft {
 namespace spatial {
@@ -116,6 +119,77 @@ TEST_P(EpsNeighTestFI, Result)
 }
 INSTANTIATE_TEST_CASE_P(EpsNeighTests, EpsNeighTestFI, ::testing::ValuesIn(inputsfi));
 
+template <typename T, typename IdxT>
+struct EpsCsrInputs {
+  IdxT n_row, n_col, n_centers;
+  T eps;
+  raft::distance::DistanceType metric;
+};
+
+template <typename T, typename IdxT>
+::std::ostream& operator<<(::std::ostream& os, const EpsCsrInputs<T, IdxT>& p)
+{
+  return os;
+}
+
+template <typename T, typename IdxT>
+class EpsNeighCsrTest : public ::testing::TestWithParam<EpsCsrInputs<T, IdxT>> {
+ protected:
+  void run()
+  {
+    auto stream = resource::get_cuda_stream(handle);
+    auto p      = ::testing::TestWithParam<EpsCsrInputs<T, IdxT>>::GetParam();
+    rmm::device_uvector<T> data(p.n_row * p.n_col, stream);
+    rmm::device_uvector<IdxT> labels(p.n_row, stream);
+    random::make_blobs<T, IdxT>(data.data(),
+                                labels.data(),
+                                p.n_row,
+                                p.n_col,
+                                p.n_centers,
+                                stream,
+                                true,
+                                nullptr,
+                                nullptr,
+                                T(0.01),
+                                false);
+    auto x_view = make_device_matrix_view<const T, IdxT>(data.data(), p.n_row, p.n_col);
+
+    auto adj = raft::make_device_csr_matrix<T, IdxT, IdxT, int64_t>(handle, p.n_row, p.n_row);
+    raft::neighbors::epsilon_neighborhood::eps_neighbors(
+      handle, x_view, x_view, adj, p.eps, p.metric);
+
+    // The blobs are tight and far apart: the neighbors of a point are exactly its blob.
+    auto structure = adj.structure_view();
+    ASSERT_EQ(structure.get_nnz(), int64_t(p.n_row) * (p.n_row / p.n_centers));
+    std::vector<IdxT> indptr(p.n_row + 1);
+    std::vector<IdxT> indices(structure.get_nnz());
+    std::vector<IdxT> labels_h(p.n_row);
+    raft::update_host(indptr.data(), structure.get_indptr().data(), indptr.size(), stream);
+    raft::update_host(indices.data(), structure.get_indices().data(), indices.size(), stream);
+    raft::update_host(labels_h.data(), labels.data(), labels_h.size(), stream);
+    resource::sync_stream(handle);
+    for (IdxT i = 0; i < p.n_row; i++) {
+      ASSERT_EQ(indptr[i + 1] - indptr[i], p.n_row / p.n_centers) << "row " << i;
+      for (IdxT j = indptr[i]; j < indptr[i + 1]; j++) {
+        ASSERT_EQ(labels_h[indices[j]], labels_h[i]) << "row " << i;
+        if (j > indptr[i]) { ASSERT_LT(indices[j - 1], indices[j]) << "row " << i; }
+      }
+    }
+  }
+
+  const raft::resources handle;
+};  // class EpsNeighCsrTest
+
+const std::vector<EpsCsrInputs<float, int>> inputs_csr_fi = {
+  {3000, 16, 5, 4.f, raft::distance::DistanceType::L2Unexpanded},
+  {3000, 17, 5, 2.f, raft::distance::DistanceType::L2SqrtUnexpanded},
+  {3000, 32, 5, 2.f, raft::distance::DistanceType::L1},
+  {4000, 18, 4, 2.f, raft::distance::DistanceType::Linf},
+};
+typedef EpsNeighCsrTest<float, int> EpsNeighCsrTestFI;
+TEST_P(EpsNeighCsrTestFI, Result) { run(); }
+INSTANTIATE_TEST_CASE_P(EpsNeighTests, EpsNeighCsrTestFI, ::testing::ValuesIn(inputs_csr_fi));
+
 };  // namespace knn
 };  // namespace spatial
 };  // namespace raft
@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+#include "./ann_utils.cuh"
+#include "./knn_utils.cuh"
+#include <raft/core/resource/cuda_stream.hpp>
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/distance/distance.cuh>  // raft::distance::pairwise_distance
+#include <raft/distance/distance_types.hpp>
+#include <raft/neighbors/brute_force.cuh>
+#include <raft/random/rng.cuh>
+
+#include <rmm/device_uvector.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace raft::neighbors::brute_force {
+struct FilteredKNNInputs {
+  int num_queries;
+  int num_db_vecs;
+  int dim;
+  int k;
+  double allowed_fraction;
+  raft::distance::DistanceType metric;
+};
+
+std::ostream& operator<<(std::ostream& os, const FilteredKNNInputs& input)
+{
+  return os << "num_queries:" << input.num_queries << " num_vecs:" << input.num_db_vecs
+            << " dim:" << input.dim << " k:" << input.k
+            << " allowed_fraction:" << input.allowed_fraction
+            << " metric:" << print_metric{input.metric};
+}
+
+template <typename T>
+class FilteredKNNTest : public ::testing::TestWithParam<FilteredKNNInputs> {
+ public:
+  FilteredKNNTest()
+    : stream_(resource::get_cuda_stream(handle_)),
+      params_(::testing::TestWithParam<FilteredKNNInputs>::GetParam()),
+      n_words_(raft::ceildiv(params_.num_db_vecs, 32)),
+      database_(params_.num_db_vecs * params_.dim, stream_),
+      queries_(params_.num_queries * params_.dim, stream_),
+      bitset_(n_words_, stream_),
+      indices_(params_.num_queries * params_.k, stream_),
+      distances_(params_.num_queries * params_.k, stream_),
+      ref_indices_(params_.num_queries * params_.k, stream_),
+      ref_distances_(params_.num_queries * params_.k, stream_)
+  {
+  }
+
+ protected:
+  void SetUp() override
+  {
+    raft::random::RngState r(1234ULL);
+    uniform(handle_, r, database_.data(), database_.size(), T(-1.0), T(1.0));
+    uniform(handle_, r, queries_.data(), queries_.size(), T(-1.0), T(1.0));
+
+    // the filter sets random bits; the bits past the end of the dataset are set too, they must be
+    // ignored
+    std::mt19937 gen(42);
+    std::bernoulli_distribution allowed(params_.allowed_fraction);
+    allowed_.resize(params_.num_db_vecs);
+    std::vector<uint32_t> bitset_h(n_words_, 0u);
+    for (int i = 0; i < n_words_ * 32; i++) {
+      bool pass = i >= params_.num_db_vecs || allowed(gen);
+      if (i < params_.num_db_vecs) { allowed_[i] = pass; }
+      if (pass) { bitset_h[i / 32] |= 1u << (i % 32); }
+    }
+    raft::update_device(bitset_.data(), bitset_h.data(), n_words_, stream_);
+  }
+
+  void testFiltered()
+  {
+    const int m = params_.num_queries;
+    const int n = params_.num_db_vecs;
+    const int k = params_.k;
+
+    // the naive filtered knn: the full pairwise distances, then the top-k of the allowed rows
+    rmm::device_uvector<T> all_distances(size_t(m) * n, stream_);
+    rmm::device_uvector<char> workspace(0, stream_);
+    distance::pairwise_distance(handle_,
+                                queries_.data(),
+                                database_.data(),
+                                all_distances.data(),
+                                m,
+                                n,
+                                params_.dim,
+                                workspace,
+                                params_.metric,
+                                true,
+                                0.0f);
+    std::vector<T> all_distances_h(size_t(m) * n);
+    raft::update_host(all_distances_h.data(), all_distances.data(), all_distances.size(), stream_);
+    resource::sync_stream(handle_);
+
+    const bool select_min = raft::distance::is_min_close(params_.metric);
+    const T worst         = select_min ? upper_bound<T>() : lower_bound<T>();
+    std::vector<int64_t> ref_indices_h(size_t(m) * k, -1);
+    std::vector<T> ref_distances_h(size_t(m) * k, worst);
+    for (int i = 0; i < m; i++) {
+      std::vector<std::pair<T, int64_t>> candidates;
+      for (int j = 0; j < n; j++) {
+        if (!allowed_[j]) { continue; }
+        T dist = all_distances_h[size_t(i) * n + j];
+        candidates.emplace_back(select_min ? dist : -dist, j);
+      }
+      auto n_found = std::min<size_t>(k, candidates.size());
+      std::partial_sort(candidates.begin(), candidates.begin() + n_found, candidates.end());
+      for (size_t j = 0; j < n_found; j++) {
+        auto [dist, id]                    = candidates[j];
+        ref_indices_h[size_t(i) * k + j]   = id;
+        ref_distances_h[size_t(i) * k + j] = select_min ? dist : -dist;
+      }
+    }
+    raft::update_device(ref_indices_.data(), ref_indices_h.data(), ref_indices_h.size(), stream_);
+    raft::update_device(
+      ref_distances_.data(), ref_distances_h.data(), ref_distances_h.size(), stream_);
+
+    auto idx = brute_force::build(
+      handle_,
+      raft::make_device_matrix_view<const T, int64_t>(database_.data(), n, params_.dim),
+      params_.metric);
+    brute_force::search_with_filtering(
+      handle_,
+      idx,
+      raft::make_device_matrix_view<const T, int64_t>(queries_.data(), m, params_.dim),
+      raft::make_device_matrix_view<int64_t, int64_t>(indices_.data(), m, k),
+      raft::make_device_matrix_view<T, int64_t>(distances_.data(), m, k),
+      raft::make_device_vector_view<const uint32_t, int64_t>(bitset_.data(), n_words_));
+
+    ASSERT_TRUE(raft::spatial::knn::devArrMatchKnnPair(ref_indices_.data(),
+                                                       indices_.data(),
+                                                       ref_distances_.data(),
+                                                       distances_.data(),
+                                                       m,
+                                                       k,
+                                                       T(0.001),
+                                                       stream_,
+                                                       true));
+  }
+
+ private:
+  raft::resources handle_;
+  cudaStream_t stream_ = 0;
+  FilteredKNNInputs params_;
+  int n_words_;
+  std::vector<bool> allowed_;
+  rmm::device_uvector<T> database_;
+  rmm::device_uvector<T> queries_;
+  rmm::device_uvector<uint32_t> bitset_;
+  rmm::device_uvector<int64_t> indices_;
+  rmm::device_uvector<T> distances_;
+  rmm::device_uvector<int64_t> ref_indices_;
+  rmm::device_uvector<T> ref_distances_;
+};
+
+const std::vector<FilteredKNNInputs> filtered_inputs = {
+  // most rows pass: the distances to the others are masked
+  {100, 5000, 32, 10, 0.9, raft::distance::DistanceType::L2Expanded},
+  {100, 5000, 32, 100, 0.5, raft::distance::DistanceType::InnerProduct},
+  {10, 70000, 16, 20, 0.3, raft::distance::DistanceType::L1},
+  // fewer rows pass than k
+  {100, 100, 16, 64, 0.5, raft::distance::DistanceType::L2Unexpanded},
+  // few rows pass: their ids are compacted
+  {100, 5000, 32, 10, 0.05, raft::distance::DistanceType::L2Expanded},
+  {100, 5000, 32, 100, 0.1, raft::distance::DistanceType::CosineExpanded},
+  {100, 5000, 32, 64, 0.01, raft::distance::DistanceType::L2SqrtExpanded},
+  // no row passes
+  {100, 5000, 32, 10, 0.0, raft::distance::DistanceType::L2Expanded}};
+
+typedef FilteredKNNTest<float> FilteredKNNTestF;
+TEST_P(FilteredKNNTestF, BruteForce) { this->testFiltered(); }
+
+INSTANTIATE_TEST_CASE_P(FilteredKNNTest, FilteredKNNTestF, ::testing::ValuesIn(filtered_inputs));
+}  // namespace raft::neighbors::brute_force
@@ -36,7 +36,9 @@ class HaversineKNNTest : public ::testing::Test {
       d_ref_I(0, stream),
       d_ref_D(0, stream),
       d_pred_I(0, stream),
-      d_pred_D(0, stream)
+      d_pred_D(0, stream),
+      d_fused_I(0, stream),
+      d_fused_D(0, stream)
   {
   }
 
@@ -53,6 +55,8 @@ class HaversineKNNTest : public ::testing::Test {
     // Allocate predicted arrays
     d_pred_I.resize(n * n, stream);
     d_pred_D.resize(n * n, stream);
+    d_fused_I.resize(n * n, stream);
+    d_fused_D.resize(n * n, stream);
 
     // make testdata on host
     std::vector<value_t> h_train_inputs = {0.71113885,
@@ -95,6 +99,16 @@ class HaversineKNNTest : public ::testing::Test {
                                               k,
                                               stream);
 
+    // the unit sphere embedding through the fused L2 kNN
+    raft::spatial::knn::detail::haversine_knn(handle,
+                                              d_fused_I.data(),
+                                              d_fused_D.data(),
+                                              d_train_inputs.data(),
+                                              d_train_inputs.data(),
+                                              n,
+                                              n,
+                                              k);
+
     resource::sync_stream(handle, stream);
   }
 
@@ -114,6 +128,9 @@ class HaversineKNNTest : public ::testing::Test {
   rmm::device_uvector<value_idx> d_pred_I;
   rmm::device_uvector<value_t> d_pred_D;
 
+  rmm::device_uvector<value_idx> d_fused_I;
+  rmm::device_uvector<value_t> d_fused_D;
+
   rmm::device_uvector<value_idx> d_ref_I;
   rmm::device_uvector<value_t> d_ref_D;
 };
@@ -128,6 +145,14 @@ TEST_F(HaversineKNNTestF, Fit)
     raft::devArrMatch(d_ref_I.data(), d_pred_I.data(), n * n, raft::Compare<int>(), stream));
 }
 
+TEST_F(HaversineKNNTestF, FitEmbedded)
+{
+  ASSERT_TRUE(raft::devArrMatch(
+    d_ref_D.data(), d_fused_D.data(), n * n, raft::CompareApprox<float>(1e-3), stream));
+  ASSERT_TRUE(
+    raft::devArrMatch(d_ref_I.data(), d_fused_I.data(), n * n, raft::Compare<int>(), stream));
+}
+
 }  // namespace knn
 }  // namespace spatial
 }  // namespace raft
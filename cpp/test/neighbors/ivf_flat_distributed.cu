@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+#include "./ann_utils.cuh"
+
+#include <raft_internal/comms/single_rank_comms.hpp>
+#include <raft_internal/neighbors/naive_knn.cuh>
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resource/thrust_policy.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/neighbors/ivf_flat.cuh>
+#include <raft/neighbors/ivf_flat_distributed.cuh>
+#include <raft/random/rng.cuh>
+
+#include <rmm/device_uvector.hpp>
+
+#include <thrust/sequence.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+namespace raft::neighbors::ivf_flat {
+
+struct DistributedInputs {
+  uint32_t num_queries;
+  int64_t num_db_vecs;
+  uint32_t dim;
+  uint32_t k;
+  uint32_t n_lists;
+  uint32_t n_probes;
+  raft::distance::DistanceType metric;
+};
+
+std::ostream& operator<<(std::ostream& os, const DistributedInputs& p)
+{
+  return os << "num_queries:" << p.num_queries << " num_vecs:" << p.num_db_vecs
+            << " dim:" << p.dim << " k:" << p.k << " n_lists:" << p.n_lists
+            << " n_probes:" << p.n_probes << " metric:" << print_metric{p.metric};
+}
+
+/**
+ * A distributed index over a single-rank communicator owns all the lists and routes all the
+ * queries to itself: its search must find the neighbors of ivf_flat::search on the local index,
+ * and, when probing all the lists, those of the exact search. Half of the dataset is added by
+ * distributed::build and the other half by distributed::extend.
+ */
+template <typename T>
+class DistributedTest : public ::testing::TestWithParam<DistributedInputs> {
+ public:
+  DistributedTest()
+    : stream_(resource::get_cuda_stream(handle_)),
+      ps_(::testing::TestWithParam<DistributedInputs>::GetParam()),
+      database_(0, stream_),
+      queries_(0, stream_)
+  {
+  }
+
+ protected:
+  void SetUp() override
+  {
+    database_.resize(size_t(ps_.num_db_vecs) * ps_.dim, stream_);
+    queries_.resize(size_t(ps_.num_queries) * ps_.dim, stream_);
+    raft::random::RngState r(1234ULL);
+    uniform(handle_, r, database_.data(), database_.size(), T(-1.0), T(1.0));
+    uniform(handle_, r, queries_.data(), queries_.size(), T(-1.0), T(1.0));
+    comms::initialize_single_rank_comms(&handle_);
+    resource::sync_stream(handle_);
+  }
+
+  /** Search with `n_probes` and copy the results to the host. */
+  void search_distributed(const distributed::index<T, int64_t>& dindex,
+                          uint32_t n_probes,
+                          std::vector<int64_t>& indices,
+                          std::vector<float>& distances)
+  {
+    size_t queries_size = size_t(ps_.num_queries) * ps_.k;
+    rmm::device_uvector<int64_t> indices_dev(queries_size, stream_);
+    rmm::device_uvector<float> distances_dev(queries_size, stream_);
+    search_params search_params;
+    search_params.n_probes = n_probes;
+    distributed::search(
+      handle_,
+      search_params,
+      dindex,
+      raft::make_device_matrix_view<const T, int64_t>(queries_.data(), ps_.num_queries, ps_.dim),
+      raft::make_device_matrix_view<int64_t, int64_t>(indices_dev.data(), ps_.num_queries, ps_.k),
+      raft::make_device_matrix_view<float, int64_t>(distances_dev.data(), ps_.num_queries, ps_.k));
+    indices.resize(queries_size);
+    distances.resize(queries_size);
+    update_host(indices.data(), indices_dev.data(), queries_size, stream_);
+    update_host(distances.data(), distances_dev.data(), queries_size, stream_);
+    resource::sync_stream(handle_);
+  }
+
+  void testDistributed()
+  {
+    const int64_t n_build = ps_.num_db_vecs / 2;
+    const int64_t n_add   = ps_.num_db_vecs - n_build;
+
+    index_params index_params;
+    index_params.n_lists                  = ps_.n_lists;
+    index_params.metric                   = ps_.metric;
+    index_params.adaptive_centers         = false;
+    index_params.kmeans_trainset_fraction = 0.5;
+
+    auto dindex = distributed::build(
+      handle_,
+      index_params,
+      raft::make_device_matrix_view<const T, int64_t>(database_.data(), n_build, ps_.dim));
+    ASSERT_EQ(dindex.n_ranks(), 1);
+    ASSERT_EQ(dindex.local().size(), n_build);
+
+    rmm::device_uvector<int64_t> new_ids(n_add, stream_);
+    thrust::sequence(
+      resource::get_thrust_policy(handle_), new_ids.begin(), new_ids.end(), n_build);
+    distributed::extend(
+      handle_,
+      raft::make_device_matrix_view<const T, int64_t>(
+        database_.data() + size_t(n_build) * ps_.dim, n_add, ps_.dim),
+      raft::make_device_vector_view<const int64_t, int64_t>(new_ids.data(), n_add),
+      &dindex);
+    ASSERT_EQ(dindex.local().size(), ps_.num_db_vecs);
+
+    size_t queries_size = size_t(ps_.num_queries) * ps_.k;
+
+    // The reference: the regular search of the local index, which holds all the lists
+    {
+      rmm::device_uvector<int64_t> indices_dev(queries_size, stream_);
+      rmm::device_uvector<float> distances_dev(queries_size, stream_);
+      search_params search_params;
+      search_params.n_probes = ps_.n_probes;
+      ivf_flat::search(
+        handle_,
+        search_params,
+        dindex.local(),
+        raft::make_device_matrix_view<const T, int64_t>(queries_.data(), ps_.num_queries, ps_.dim),
+        raft::make_device_matrix_view<int64_t, int64_t>(indices_dev.data(), ps_.num_queries, ps_.k),
+        raft::make_device_matrix_view<float, int64_t>(
+          distances_dev.data(), ps_.num_queries, ps_.k));
+      std::vector<int64_t> indices_ref(queries_size);
+      std::vector<float> distances_ref(queries_size);
+      update_host(indices_ref.data(), indices_dev.data(), queries_size, stream_);
+      update_host(distances_ref.data(), distances_dev.data(), queries_size, stream_);
+      resource::sync_stream(handle_);
+
+      std::vector<int64_t> indices;
+      std::vector<float> distances;
+      search_distributed(dindex, ps_.n_probes, indices, distances);
+      ASSERT_TRUE(eval_neighbours(indices_ref,
+                                  indices,
+                                  distances_ref,
+                                  distances,
+                                  ps_.num_queries,
+                                  ps_.k,
+                                  0.0001,
+                                  0.999))
+        << ps_;
+    }
+
+    // Probing all the lists is the exact search
+    {
+      rmm::device_uvector<int64_t> indices_dev(queries_size, stream_);
+      rmm::device_uvector<float> distances_dev(queries_size, stream_);
+      naive_knn<float, T, int64_t>(distances_dev.data(),
+                                   indices_dev.data(),
+                                   queries_.data(),
+                                   database_.data(),
+                                   ps_.num_queries,
+                                   ps_.num_db_vecs,
+                                   ps_.dim,
+                                   ps_.k,
+                                   ps_.metric,
+                                   stream_);
+      std::vector<int64_t> indices_naive(queries_size);
+      std::vector<float> distances_naive(queries_size);
+      update_host(indices_naive.data(), indices_dev.data(), queries_size, stream_);
+      update_host(distances_naive.data(), distances_dev.data(), queries_size, stream_);
+      resource::sync_stream(handle_);
+
+      std::vector<int64_t> indices;
+      std::vector<float> distances;
+      search_distributed(dindex, ps_.n_lists, indices, distances);
+      ASSERT_TRUE(eval_neighbours(indices_naive,
+                                  indices,
+                                  distances_naive,
+                                  distances,
+                                  ps_.num_queries,
+                                  ps_.k,
+                                  0.001,
+                                  0.99))
+        << ps_;
+    }
+  }
+
+ private:
+  raft::resources handle_;
+  rmm::cuda_stream_view stream_;
+  DistributedInputs ps_;
+  rmm::device_uvector<T> database_;
+  rmm::device_uvector<T> queries_;
+};
+
+const std::vector<DistributedInputs> distributed_inputs = {
+  {100, 5000, 32, 10, 64, 8, raft::distance::DistanceType::L2Expanded},
+  {100, 5000, 32, 10, 64, 8, raft::distance::DistanceType::InnerProduct},
+  {100, 5000, 16, 64, 32, 16, raft::distance::DistanceType::L2SqrtExpanded},
+  // more probes than k and a single query
+  {1, 2000, 8, 5, 16, 16, raft::distance::DistanceType::L2Expanded},
+  {500, 3000, 64, 32, 128, 20, raft::distance::DistanceType::InnerProduct}};
+
+typedef DistributedTest<float> DistributedTestF;
+TEST_P(DistributedTestF, SingleRank) { this->testDistributed(); }
+
+INSTANTIATE_TEST_CASE_P(IvfFlatDistributed,
+                        DistributedTestF,
+                        ::testing::ValuesIn(distributed_inputs));
+
+}  // namespace raft::neighbors::ivf_flat
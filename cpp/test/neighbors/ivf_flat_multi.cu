@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+#include "./ann_utils.cuh"
+#include <raft/core/resource/cuda_stream.hpp>
+
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/host_mdspan.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/neighbors/ivf_flat.cuh>
+#include <raft/neighbors/ivf_flat_multi.cuh>
+#include <raft/random/rng.cuh>
+
+#include <rmm/device_uvector.hpp>
+
+#include <gtest/gtest.h>
+
+#include <iostream>
+#include <vector>
+
+namespace raft::neighbors::ivf_flat {
+
+struct MultiSearchInputs {
+  // the number of the indices, the i-th of them has (i % 3 + 1) * rows_per_index rows
+  uint32_t n_indices;
+  uint32_t rows_per_index;
+  // the i-th index has (i % 4) * queries_per_index queries (none for some of the indices)
+  uint32_t queries_per_index;
+  uint32_t dim;
+  uint32_t k;
+  uint32_t n_lists;
+  uint32_t n_probes;
+  raft::distance::DistanceType metric;
+};
+
+std::ostream& operator<<(std::ostream& os, const MultiSearchInputs& p)
+{
+  return os << "n_indices:" << p.n_indices << " rows_per_index:" << p.rows_per_index
+            << " queries_per_index:" << p.queries_per_index << " dim:" << p.dim << " k:" << p.k
+            << " n_lists:" << p.n_lists << " n_probes:" << p.n_probes
+            << " metric:" << print_metric{p.metric};
+}
+
+template <typename T>
+class MultiSearchTest : public ::testing::TestWithParam<MultiSearchInputs> {
+ public:
+  MultiSearchTest()
+    : stream_(resource::get_cuda_stream(handle_)),
+      ps_(::testing::TestWithParam<MultiSearchInputs>::GetParam())
+  {
+  }
+
+ protected:
+  void testMultiSearch()
+  {
+    raft::random::RngState r(1234ULL);
+    std::vector<index<T, int64_t>> indices;
+    std::vector<uint32_t> n_queries(ps_.n_indices);
+    uint32_t total_queries = 0;
+    for (uint32_t i = 0; i < ps_.n_indices; i++) {
+      const uint32_t n_rows = (i % 3 + 1) * ps_.rows_per_index;
+      rmm::device_uvector<T> dataset(size_t(n_rows) * ps_.dim, stream_);
+      uniform(handle_, r, dataset.data(), dataset.size(), T(-1.0), T(1.0));
+      index_params index_params;
+      index_params.n_lists                  = ps_.n_lists + i % 2;
+      index_params.metric                   = ps_.metric;
+      index_params.kmeans_trainset_fraction = 1.0;
+      indices.push_back(build(handle_,
+                              index_params,
+                              raft::make_device_matrix_view<const T, int64_t>(
+                                dataset.data(), int64_t(n_rows), int64_t(ps_.dim))));
+      n_queries[i] = (i % 4) * ps_.queries_per_index;
+      total_queries += n_queries[i];
+    }
+    rmm::device_uvector<T> queries(size_t(total_queries) * ps_.dim, stream_);
+    uniform(handle_, r, queries.data(), queries.size(), T(-1.0), T(1.0));
+
+    std::vector<const index<T, int64_t>*> members;
+    for (auto& idx : indices) {
+      members.push_back(&idx);
+    }
+    auto group = multi::make_group(handle_, members);
+    ASSERT_EQ(group.size(), ps_.n_indices);
+
+    search_params search_params;
+    search_params.n_probes = ps_.n_probes;
+    const size_t out_size  = size_t(total_queries) * ps_.k;
+    rmm::device_uvector<int64_t> neighbors_multi(out_size, stream_);
+    rmm::device_uvector<float> distances_multi(out_size, stream_);
+    multi::search(
+      handle_,
+      search_params,
+      group,
+      raft::make_device_matrix_view<const T, int64_t>(
+        queries.data(), int64_t(total_queries), int64_t(ps_.dim)),
+      raft::make_host_vector_view<const uint32_t, uint32_t>(n_queries.data(), ps_.n_indices),
+      raft::make_device_matrix_view<int64_t, int64_t>(
+        neighbors_multi.data(), int64_t(total_queries), int64_t(ps_.k)),
+      raft::make_device_matrix_view<float, int64_t>(
+        distances_multi.data(), int64_t(total_queries), int64_t(ps_.k)));
+
+    // The reference: every index searched separately
+    rmm::device_uvector<int64_t> neighbors_ref(out_size, stream_);
+    rmm::device_uvector<float> distances_ref(out_size, stream_);
+    uint32_t offset_q = 0;
+    for (uint32_t i = 0; i < ps_.n_indices; i++) {
+      if (n_queries[i] == 0) { continue; }
+      search(handle_,
+             search_params,
+             indices[i],
+             raft::make_device_matrix_view<const T, int64_t>(
+               queries.data() + size_t(offset_q) * ps_.dim, int64_t(n_queries[i]), ps_.dim),
+             raft::make_device_matrix_view<int64_t, int64_t>(
+               neighbors_ref.data() + size_t(offset_q) * ps_.k, int64_t(n_queries[i]), ps_.k),
+             raft::make_device_matrix_view<float, int64_t>(
+               distances_ref.data() + size_t(offset_q) * ps_.k, int64_t(n_queries[i]), ps_.k));
+      offset_q += n_queries[i];
+    }
+
+    std::vector<int64_t> neighbors_multi_h(out_size);
+    std::vector<int64_t> neighbors_ref_h(out_size);
+    std::vector<float> distances_multi_h(out_size);
+    std::vector<float> distances_ref_h(out_size);
+    update_host(neighbors_multi_h.data(), neighbors_multi.data(), out_size, stream_);
+    update_host(neighbors_ref_h.data(), neighbors_ref.data(), out_size, stream_);
+    update_host(distances_multi_h.data(), distances_multi.data(), out_size, stream_);
+    update_host(distances_ref_h.data(), distances_ref.data(), out_size, stream_);
+    resource::sync_stream(handle_);
+    // Probing all the lists gives the same results; otherwise the centers on the border of the
+    // coarse search may be selected differently.
+    const double min_recall = ps_.n_probes >= ps_.n_lists + 1 ? 1.0 : 0.95;
+    ASSERT_TRUE(eval_neighbours(neighbors_ref_h,
+                                neighbors_multi_h,
+                                distances_ref_h,
+                                distances_multi_h,
+                                total_queries,
+                                ps_.k,
+                                0.001,
+                                min_recall));
+  }
+
+ private:
+  raft::resources handle_;
+  rmm::cuda_stream_view stream_;
+  MultiSearchInputs ps_;
+};
+
+const std::vector<MultiSearchInputs> inputs = {
+  // all the lists are probed
+  {10, 2000, 20, 16, 10, 16, 32, raft::distance::DistanceType::L2Expanded},
+  {10, 2000, 20, 16, 10, 16, 32, raft::distance::DistanceType::InnerProduct},
+  {7, 1000, 10, 5, 32, 8, 16, raft::distance::DistanceType::L2SqrtExpanded},
+  // some lists are probed
+  {50, 1000, 10, 32, 10, 32, 8, raft::distance::DistanceType::L2Expanded},
+  {50, 1000, 10, 32, 10, 32, 8, raft::distance::DistanceType::InnerProduct},
+  // many small indices, many queries (several batches)
+  {500, 200, 12, 8, 5, 4, 2, raft::distance::DistanceType::L2Expanded}};
+
+typedef MultiSearchTest<float> MultiSearchTestF;
+TEST_P(MultiSearchTestF, MultiSearch) { this->testMultiSearch(); }
+INSTANTIATE_TEST_CASE_P(MultiSearchTest, MultiSearchTestF, ::testing::ValuesIn(inputs));
+
+}  // namespace raft::neighbors::ivf_flat
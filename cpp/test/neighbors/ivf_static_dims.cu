@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// The search instances specialized on the dimensions are not compiled in libraft.so (unless it is
+// built with RAFT_ANN_STATIC_DIMS). So we allow instantiating the templates here.
+#undef RAFT_EXPLICIT_INSTANTIATE_ONLY
+
+#include "../test_utils.cuh"
+#include "./ann_utils.cuh"
+
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/distance/distance_types.hpp>
+#include <raft/neighbors/detail/ivf_static_dims.hpp>
+#include <raft/neighbors/ivf_flat.cuh>
+#include <raft/neighbors/ivf_pq.cuh>
+#include <raft/random/rng.cuh>
+
+#include <rmm/device_uvector.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+namespace raft::neighbors::ivf {
+
+using detail::static_dims_t;
+
+TEST(IvfStaticDims, Dispatch)
+{
+  auto lift = [](auto static_dim) { return decltype(static_dim)::value; };
+  ASSERT_EQ(detail::dispatch_static_dim(static_dims_t<8, 16, 96>{}, 8, lift), 8u);
+  ASSERT_EQ(detail::dispatch_static_dim(static_dims_t<8, 16, 96>{}, 96, lift), 96u);
+  ASSERT_EQ(detail::dispatch_static_dim(static_dims_t<8, 16, 96>{}, 17, lift), 0u);
+  ASSERT_EQ(detail::dispatch_static_dim(static_dims_t<>{}, 8, lift), 0u);
+}
+
+struct StaticDimsInputs {
+  uint32_t num_queries;
+  int64_t num_db_vecs;
+  uint32_t k;
+  uint32_t n_probes;
+  uint32_t n_lists;
+  raft::distance::DistanceType metric;
+};
+
+inline ::std::ostream& operator<<(::std::ostream& os, const StaticDimsInputs& p)
+{
+  os << "{ " << p.num_queries << ", " << p.num_db_vecs << ", " << p.k << ", " << p.n_probes << ", "
+     << p.n_lists << ", " << static_cast<int>(p.metric) << '}' << std::endl;
+  return os;
+}
+
+/**
+ * Search the same index with the kernels specialized on the dimension and with the generic ones,
+ * and compare the results.
+ */
+class StaticDimsTest : public ::testing::TestWithParam<StaticDimsInputs> {
+ public:
+  // The data dimension the IVF-Flat scan is specialized for, and the number of PQ subspaces the
+  // IVF-PQ similarity kernel is specialized for.
+  static constexpr uint32_t kDim   = 64;
+  static constexpr uint32_t kPqDim = 16;
+
+  StaticDimsTest()
+    : stream_(resource::get_cuda_stream(handle_)),
+      ps(::testing::TestWithParam<StaticDimsInputs>::GetParam()),
+      database(0, stream_),
+      search_queries(0, stream_)
+  {
+  }
+
+ protected:
+  void SetUp() override
+  {
+    database.resize(size_t(ps.num_db_vecs) * kDim, stream_);
+    search_queries.resize(size_t(ps.num_queries) * kDim, stream_);
+    raft::random::RngState r(1234ULL);
+    raft::random::uniform(handle_, r, database.data(), database.size(), float(-1.0), float(1.0));
+    raft::random::uniform(
+      handle_, r, search_queries.data(), search_queries.size(), float(-1.0), float(1.0));
+    resource::sync_stream(handle_);
+  }
+
+  void TearDown() override
+  {
+    resource::sync_stream(handle_);
+    database.resize(0, stream_);
+    search_queries.resize(0, stream_);
+  }
+
+  /** Copy the results to the host and compare them. */
+  void compare(const rmm::device_uvector<int64_t>& indices_generic,
+               const rmm::device_uvector<int64_t>& indices_static,
+               const rmm::device_uvector<float>& distances_generic,
+               const rmm::device_uvector<float>& distances_static)
+  {
+    size_t queries_size = size_t(ps.num_queries) * ps.k;
+    std::vector<int64_t> indices_generic_h(queries_size);
+    std::vector<int64_t> indices_static_h(queries_size);
+    std::vector<float> distances_generic_h(queries_size);
+    std::vector<float> distances_static_h(queries_size);
+    update_host(indices_generic_h.data(), indices_generic.data(), queries_size, stream_);
+    update_host(indices_static_h.data(), indices_static.data(), queries_size, stream_);
+    update_host(distances_generic_h.data(), distances_generic.data(), queries_size, stream_);
+    update_host(distances_static_h.data(), distances_static.data(), queries_size, stream_);
+    resource::sync_stream(handle_);
+
+    // Unrolling the loops does not change the order of the accumulation, so any difference is
+    // down to the contraction of the floating-point operations.
+    ASSERT_TRUE(eval_neighbours(indices_generic_h,
+                                indices_static_h,
+                                distances_generic_h,
+                                distances_static_h,
+                                ps.num_queries,
+                                ps.k,
+                                0.0001,
+                                0.999))
+      << ps;
+  }
+
+  void testIvfFlat()
+  {
+    ivf_flat::index_params index_params;
+    index_params.n_lists                  = ps.n_lists;
+    index_params.metric                   = ps.metric;
+    index_params.kmeans_trainset_fraction = 0.5;
+    auto index = ivf_flat::build(handle_, index_params, database.data(), ps.num_db_vecs, kDim);
+
+    ivf_flat::search_params search_params;
+    search_params.n_probes = ps.n_probes;
+
+    size_t queries_size = size_t(ps.num_queries) * ps.k;
+    rmm::device_uvector<int64_t> indices_generic(queries_size, stream_);
+    rmm::device_uvector<int64_t> indices_static(queries_size, stream_);
+    rmm::device_uvector<float> distances_generic(queries_size, stream_);
+    rmm::device_uvector<float> distances_static(queries_size, stream_);
+
+    ivf_flat::detail::search<float,
+                             int64_t,
+                             raft::neighbors::filtering::none_ivf_sample_filter,
+                             static_dims_t<>>(handle_,
+                                              search_params,
+                                              index,
+                                              search_queries.data(),
+                                              ps.num_queries,
+                                              ps.k,
+                                              indices_generic.data(),
+                                              distances_generic.data());
+    ivf_flat::detail::search<float,
+                             int64_t,
+                             raft::neighbors::filtering::none_ivf_sample_filter,
+                             static_dims_t<32, kDim>>(handle_,
+                                                      search_params,
+                                                      index,
+                                                      search_queries.data(),
+                                                      ps.num_queries,
+                                                      ps.k,
+                                                      indices_static.data(),
+                                                      distances_static.data());
+    compare(indices_generic, indices_static, distances_generic, distances_static);
+  }
+
+  void testIvfPq()
+  {
+    ivf_pq::index_params index_params;
+    index_params.n_lists                  = ps.n_lists;
+    index_params.metric                   = ps.metric;
+    index_params.pq_dim                   = kPqDim;
+    index_params.kmeans_trainset_fraction = 0.5;
+    auto index = ivf_pq::build(handle_, index_params, database.data(), ps.num_db_vecs, kDim);
+    ASSERT_EQ(index.pq_dim(), kPqDim);
+
+    ivf_pq::search_params search_params;
+    search_params.n_probes = ps.n_probes;
+
+    size_t queries_size = size_t(ps.num_queries) * ps.k;
+    rmm::device_uvector<int64_t> indices_generic(queries_size, stream_);
+    rmm::device_uvector<int64_t> indices_static(queries_size, stream_);
+    rmm::device_uvector<float> distances_generic(queries_size, stream_);
+    rmm::device_uvector<float> distances_static(queries_size, stream_);
+
+    ivf_pq::detail::search<float,
+                           int64_t,
+                           raft::neighbors::filtering::none_ivf_sample_filter,
+                           static_dims_t<>>(handle_,
+                                            search_params,
+                                            index,
+                                            search_queries.data(),
+                                            ps.num_queries,
+                                            ps.k,
+                                            indices_generic.data(),
+                                            distances_generic.data());
+    ivf_pq::detail::search<float,
+                           int64_t,
+                           raft::neighbors::filtering::none_ivf_sample_filter,
+                           static_dims_t<8, kPqDim>>(handle_,
+                                                     search_params,
+                                                     index,
+                                                     search_queries.data(),
+                                                     ps.num_queries,
+                                                     ps.k,
+                                                     indices_static.data(),
+                                                     distances_static.data());
+    compare(indices_generic, indices_static, distances_generic, distances_static);
+  }
+
+ private:
+  raft::resources handle_;
+  rmm::cuda_stream_view stream_;
+  StaticDimsInputs ps;
+  rmm::device_uvector<float> database;
+  rmm::device_uvector<float> search_queries;
+};
+
+const std::vector<StaticDimsInputs> inputs = {
+  {100, 5000, 10, 8, 64, raft::distance::DistanceType::L2Expanded},
+  {100, 5000, 10, 8, 64, raft::distance::DistanceType::InnerProduct},
+  {100, 5000, 64, 32, 64, raft::distance::DistanceType::L2Expanded},
+  {7, 5000, 1, 1, 64, raft::distance::DistanceType::L2Expanded},
+  {1, 5000, 128, 16, 64, raft::distance::DistanceType::InnerProduct},
+};
+
+TEST_P(StaticDimsTest, IvfFlat) { this->testIvfFlat(); }
+TEST_P(StaticDimsTest, IvfPq) { this->testIvfPq(); }
+
+INSTANTIATE_TEST_CASE_P(IvfStaticDims, StaticDimsTest, ::testing::ValuesIn(inputs));
+
+}  // namespace raft::neighbors::ivf
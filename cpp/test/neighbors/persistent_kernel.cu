@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/neighbors/detail/persistent_kernel.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <numeric>
+#include <tuple>
+#include <vector>
+
+namespace raft::neighbors::detail::persistent {
+
+struct scale_job {
+  const float* in;  // [num_items, dim]
+  float* out;       // [num_items, dim]
+  float scale;
+};
+
+using scale_queue = work_queue<scale_job>;
+
+// Every thread block counts the items it has served in its scratch memory.
+__global__ void scale_kernel(scale_queue* queue,
+                             std::uint64_t* next_ticket,
+                             uint32_t* num_served,
+                             uint32_t dim)
+{
+  serve(queue, next_ticket, [&](const scale_job& job, uint32_t item_id) {
+    for (uint32_t i = threadIdx.x; i < dim; i += blockDim.x) {
+      job.out[size_t(item_id) * dim + i] = job.in[size_t(item_id) * dim + i] * job.scale;
+    }
+    if (threadIdx.x == 0) { num_served[blockIdx.x]++; }
+  });
+}
+
+TEST(PersistentKernel, Serve)
+{
+  using key_type    = std::tuple<uint32_t>;
+  using runner_type = runner<scale_job, key_type>;
+
+  raft::resources handle;
+  auto stream             = resource::get_cuda_stream(handle);
+  constexpr uint32_t kDim = 100;
+  uint32_t* num_served    = nullptr;
+
+  auto launch = [&](scale_queue* queue,
+                    std::uint64_t* next_ticket,
+                    void* scratch,
+                    uint32_t num_blocks,
+                    cudaStream_t runner_stream) {
+    num_served = static_cast<uint32_t*>(scratch);
+    RAFT_CUDA_TRY(cudaMemsetAsync(num_served, 0, sizeof(uint32_t) * num_blocks, runner_stream));
+    scale_kernel<<<num_blocks, 64, 0, runner_stream>>>(queue, next_ticket, num_served, kDim);
+  };
+  auto r = get_runner<runner_type>(key_type{kDim},
+                                   reinterpret_cast<const void*>(scale_kernel),
+                                   64,
+                                   0,
+                                   0.5f,
+                                   sizeof(uint32_t),
+                                   launch);
+  ASSERT_GT(r->num_blocks(), 0u);
+
+  uint32_t total_items = 0;
+  for (uint32_t num_items : {1u, 3u, 1000u, 0u, 7u}) {
+    std::vector<float> h_in(size_t(num_items) * kDim), h_out(h_in.size());
+    std::iota(h_in.begin(), h_in.end(), 0.0f);
+    rmm::device_uvector<float> in(h_in.size(), stream), out(h_in.size(), stream);
+    raft::update_device(in.data(), h_in.data(), h_in.size(), stream);
+    resource::sync_stream(handle, stream);
+    r->submit(scale_job{in.data(), out.data(), 2.0f}, num_items);
+    raft::update_host(h_out.data(), out.data(), h_out.size(), stream);
+    resource::sync_stream(handle, stream);
+    for (size_t i = 0; i < h_in.size(); i++) {
+      ASSERT_EQ(h_out[i], 2.0f * h_in[i]) << "items: " << num_items << ", i: " << i;
+    }
+    total_items += num_items;
+  }
+
+  // The same parameters: the running kernel is reused.
+  ASSERT_EQ(get_runner<runner_type>(key_type{kDim}, nullptr, 64, 0, 0.5f, 0, launch), r);
+  std::vector<uint32_t> h_num_served(r->num_blocks());
+  raft::update_host(h_num_served.data(), num_served, h_num_served.size(), stream);
+  resource::sync_stream(handle, stream);
+  ASSERT_EQ(std::accumulate(h_num_served.begin(), h_num_served.end(), 0u), total_items);
+}
+
+}  // namespace raft::neighbors::detail::persistent
@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+#include "./ann_utils.cuh"
+#include <raft/core/resource/cuda_stream.hpp>
+
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/distance/distance.cuh>  // raft::distance::pairwise_distance
+#include <raft/distance/distance_types.hpp>
+#include <raft/neighbors/brute_force.cuh>
+#include <raft/neighbors/ivf_flat.cuh>
+#include <raft/random/rng.cuh>
+
+#include <rmm/device_uvector.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+namespace raft::neighbors {
+
+struct RangeSearchInputs {
+  int num_queries;
+  int num_db_vecs;
+  int dim;
+  // the fraction of the (query, row) pairs within the radius
+  double fraction;
+  raft::distance::DistanceType metric;
+  // ivf-flat only
+  uint32_t n_lists;
+  uint32_t n_probes;
+};
+
+std::ostream& operator<<(std::ostream& os, const RangeSearchInputs& input)
+{
+  return os << "num_queries:" << input.num_queries << " num_vecs:" << input.num_db_vecs
+            << " dim:" << input.dim << " fraction:" << input.fraction
+            << " metric:" << print_metric{input.metric} << " n_lists:" << input.n_lists
+            << " n_probes:" << input.n_probes;
+}
+
+template <typename T>
+class RangeSearchTest : public ::testing::TestWithParam<RangeSearchInputs> {
+ public:
+  RangeSearchTest()
+    : stream_(resource::get_cuda_stream(handle_)),
+      params_(::testing::TestWithParam<RangeSearchInputs>::GetParam()),
+      database_(params_.num_db_vecs * params_.dim, stream_),
+      queries_(params_.num_queries * params_.dim, stream_)
+  {
+  }
+
+ protected:
+  void SetUp() override
+  {
+    raft::random::RngState r(1234ULL);
+    uniform(handle_, r, database_.data(), database_.size(), T(-1.0), T(1.0));
+    uniform(handle_, r, queries_.data(), queries_.size(), T(-1.0), T(1.0));
+
+    // the reference distances, the radius is their quantile
+    const int m = params_.num_queries;
+    const int n = params_.num_db_vecs;
+    rmm::device_uvector<T> all_distances(size_t(m) * n, stream_);
+    rmm::device_uvector<char> workspace(0, stream_);
+    distance::pairwise_distance(handle_,
+                                queries_.data(),
+                                database_.data(),
+                                all_distances.data(),
+                                m,
+                                n,
+                                params_.dim,
+                                workspace,
+                                params_.metric,
+                                true,
+                                0.0f);
+    ref_distances_.resize(size_t(m) * n);
+    raft::update_host(ref_distances_.data(), all_distances.data(), all_distances.size(), stream_);
+    resource::sync_stream(handle_);
+
+    select_min_ = raft::distance::is_min_close(params_.metric);
+    std::vector<T> sorted(ref_distances_);
+    if (!select_min_) {
+      for (auto& x : sorted) {
+        x = -x;
+      }
+    }
+    auto pos = std::min<size_t>(sorted.size() - 1, params_.fraction * sorted.size());
+    std::nth_element(sorted.begin(), sorted.begin() + pos, sorted.end());
+    radius_ = select_min_ ? sorted[pos] : -sorted[pos];
+    if (params_.fraction == 0) { radius_ = select_min_ ? T(-1) : upper_bound<T>(); }
+  }
+
+  /**
+   * Every neighbor found must be within the radius, with the right distance. With `exact`, all the
+   * rows clearly within the radius must be found; the rows on the border may or may not be found.
+   */
+  void check(raft::device_csr_matrix<T, int64_t, int64_t, int64_t>& out, bool exact)
+  {
+    const int m    = params_.num_queries;
+    const int n    = params_.num_db_vecs;
+    auto structure = out.structure_view();
+    const auto nnz = structure.get_nnz();
+    ASSERT_EQ(structure.get_n_rows(), m);
+    ASSERT_EQ(structure.get_n_cols(), n);
+
+    std::vector<int64_t> indptr(m + 1);
+    std::vector<int64_t> indices(nnz);
+    std::vector<T> distances(nnz);
+    raft::update_host(indptr.data(), structure.get_indptr().data(), m + 1, stream_);
+    if (nnz > 0) {
+      raft::update_host(indices.data(), structure.get_indices().data(), nnz, stream_);
+      raft::update_host(distances.data(), out.get_elements().data(), nnz, stream_);
+    }
+    resource::sync_stream(handle_);
+
+    const T eps = T(0.001) * std::max<T>(T(1), std::abs(radius_));
+    ASSERT_EQ(indptr[0], 0);
+    ASSERT_EQ(indptr[m], nnz);
+    for (int i = 0; i < m; i++) {
+      ASSERT_LE(indptr[i], indptr[i + 1]);
+      std::vector<bool> found(n, false);
+      for (int64_t p = indptr[i]; p < indptr[i + 1]; p++) {
+        auto j = indices[p];
+        ASSERT_TRUE(j >= 0 && j < n) << "query " << i << ": invalid index " << j;
+        ASSERT_FALSE(found[j]) << "query " << i << ": duplicate index " << j;
+        found[j]  = true;
+        T ref     = ref_distances_[size_t(i) * n + j];
+        T abs_tol = T(0.001) * std::max<T>(T(1), std::abs(ref));
+        ASSERT_NEAR(distances[p], ref, abs_tol) << "query " << i << ", index " << j;
+        ASSERT_TRUE(select_min_ ? ref <= radius_ + eps : ref >= radius_ - eps)
+          << "query " << i << ", index " << j << ": " << ref << " is out of radius " << radius_;
+      }
+      if (!exact) { continue; }
+      for (int j = 0; j < n; j++) {
+        T ref = ref_distances_[size_t(i) * n + j];
+        if (select_min_ ? ref < radius_ - eps : ref > radius_ + eps) {
+          ASSERT_TRUE(found[j]) << "query " << i << ": missing index " << j << " at " << ref;
+        }
+      }
+    }
+  }
+
+  void testBruteForce()
+  {
+    auto idx = brute_force::build(
+      handle_,
+      raft::make_device_matrix_view<const T, int64_t>(
+        database_.data(), params_.num_db_vecs, params_.dim),
+      params_.metric);
+    auto out = raft::make_device_csr_matrix<T, int64_t, int64_t, int64_t>(
+      handle_, int64_t(params_.num_queries), int64_t(params_.num_db_vecs));
+    brute_force::range_search(
+      handle_,
+      idx,
+      raft::make_device_matrix_view<const T, int64_t>(
+        queries_.data(), params_.num_queries, params_.dim),
+      radius_,
+      out);
+    check(out, true);
+  }
+
+  void testIvfFlat()
+  {
+    ivf_flat::index_params index_params;
+    index_params.n_lists                  = params_.n_lists;
+    index_params.metric                   = params_.metric;
+    index_params.kmeans_trainset_fraction = 1.0;
+    auto idx                              = ivf_flat::build(
+      handle_,
+      index_params,
+      raft::make_device_matrix_view<const T, int64_t>(
+        database_.data(), params_.num_db_vecs, params_.dim));
+
+    ivf_flat::search_params search_params;
+    search_params.n_probes = params_.n_probes;
+    auto out               = raft::make_device_csr_matrix<T, int64_t, int64_t, int64_t>(
+      handle_, int64_t(params_.num_queries), int64_t(params_.num_db_vecs));
+    ivf_flat::range_search(handle_,
+                           search_params,
+                           idx,
+                           raft::make_device_matrix_view<const T, int64_t>(
+                             queries_.data(), params_.num_queries, params_.dim),
+                           float(radius_),
+                           out);
+    // probing all the lists finds all the neighbors
+    check(out, params_.n_probes >= params_.n_lists);
+  }
+
+ private:
+  raft::resources handle_;
+  cudaStream_t stream_ = 0;
+  RangeSearchInputs params_;
+  rmm::device_uvector<T> database_;
+  rmm::device_uvector<T> queries_;
+  std::vector<T> ref_distances_;
+  bool select_min_;
+  T radius_;
+};
+
+const std::vector<RangeSearchInputs> brute_force_inputs = {
+  {100, 5000, 32, 0.01, raft::distance::DistanceType::L2Expanded, 0, 0},
+  {100, 5000, 32, 0.05, raft::distance::DistanceType::L2SqrtExpanded, 0, 0},
+  {100, 5000, 16, 0.01, raft::distance::DistanceType::InnerProduct, 0, 0},
+  {100, 5000, 16, 0.02, raft::distance::DistanceType::CosineExpanded, 0, 0},
+  {10, 70000, 8, 0.001, raft::distance::DistanceType::L1, 0, 0},
+  // every pair is within the radius
+  {20, 1000, 8, 1.0, raft::distance::DistanceType::L2Unexpanded, 0, 0},
+  // no pair is within the radius
+  {100, 5000, 32, 0.0, raft::distance::DistanceType::L2Expanded, 0, 0}};
+
+const std::vector<RangeSearchInputs> ivf_flat_inputs = {
+  // all the lists are probed
+  {100, 5000, 32, 0.01, raft::distance::DistanceType::L2Expanded, 32, 32},
+  {100, 5000, 7, 0.01, raft::distance::DistanceType::L2SqrtExpanded, 32, 32},
+  {100, 5000, 16, 0.02, raft::distance::DistanceType::InnerProduct, 32, 32},
+  // the query does not fit into the shared memory
+  {20, 1000, 4500, 0.05, raft::distance::DistanceType::L2Expanded, 8, 8},
+  // some lists are probed
+  {100, 5000, 32, 0.01, raft::distance::DistanceType::L2Expanded, 64, 8},
+  // no pair is within the radius
+  {100, 5000, 32, 0.0, raft::distance::DistanceType::L2Expanded, 32, 32}};
+
+typedef RangeSearchTest<float> RangeSearchTestF_BruteForce;
+TEST_P(RangeSearchTestF_BruteForce, RangeSearch) { this->testBruteForce(); }
+INSTANTIATE_TEST_CASE_P(RangeSearchTest,
+                        RangeSearchTestF_BruteForce,
+                        ::testing::ValuesIn(brute_force_inputs));
+
+typedef RangeSearchTest<float> RangeSearchTestF_IvfFlat;
+TEST_P(RangeSearchTestF_IvfFlat, RangeSearch) { this->testIvfFlat(); }
+INSTANTIATE_TEST_CASE_P(RangeSearchTest,
+                        RangeSearchTestF_IvfFlat,
+                        ::testing::ValuesIn(ivf_flat_inputs));
+
+}  // namespace raft::neighbors
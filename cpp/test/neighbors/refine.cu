@@ -96,6 +96,33 @@ class RefineTest : public ::testing::TestWithParam<RefineInputs<IdxT>> {
                                                  data.p.k,
                                                  0.001,
                                                  min_recall));
+
+    if (data.p.host_data) {
+      // The same with only the dataset on the host.
+      raft::neighbors::refine<IdxT, DataT, DistanceT, IdxT>(handle_,
+                                                            data.dataset_host.view(),
+                                                            data.queries.view(),
+                                                            data.candidates.view(),
+                                                            data.refined_indices.view(),
+                                                            data.refined_distances.view(),
+                                                            data.p.metric);
+      update_host(distances.data(),
+                  data.refined_distances.data_handle(),
+                  data.refined_distances.size(),
+                  stream_);
+      update_host(
+        indices.data(), data.refined_indices.data_handle(), data.refined_indices.size(), stream_);
+      resource::sync_stream(handle_);
+
+      ASSERT_TRUE(raft::neighbors::eval_neighbours(data.true_refined_indices_host,
+                                                   indices,
+                                                   data.true_refined_distances_host,
+                                                   distances,
+                                                   data.p.n_queries,
+                                                   data.p.k,
+                                                   0.001,
+                                                   min_recall));
+    }
   }
 
  public:
@@ -108,7 +135,7 @@ const std::vector<RefineInputs<int64_t>> inputs =
   raft::util::itertools::product<RefineInputs<int64_t>>(
     {static_cast<int64_t>(137)},
     {static_cast<int64_t>(1000)},
-    {static_cast<int64_t>(16)},
+    {static_cast<int64_t>(16), static_cast<int64_t>(17)},
     {static_cast<int64_t>(1), static_cast<int64_t>(10), static_cast<int64_t>(33)},
     {static_cast<int64_t>(33)},
     {raft::distance::DistanceType::L2Expanded, raft::distance::DistanceType::InnerProduct},
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/neighbors/ivf_flat.cuh>
+#include <raft/neighbors/ivf_pq.cuh>
+#include <raft/neighbors/search_graph.cuh>
+#include <raft/random/rng.cuh>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+namespace raft::neighbors {
+
+namespace {
+
+constexpr int64_t kRows    = 4096;
+constexpr int64_t kDim     = 32;
+constexpr int64_t kQueries = 37;
+constexpr int64_t kK       = 10;
+
+template <typename IdxT, typename SearchF>
+void check_replays(raft::resources const& handle,
+                   search_graph<float, IdxT>& graph,
+                   raft::device_matrix_view<const float, int64_t> queries,
+                   SearchF search)
+{
+  auto stream        = resource::get_cuda_stream(handle);
+  auto neighbors     = make_device_matrix<IdxT, int64_t>(handle, queries.extent(0), kK);
+  auto distances     = make_device_matrix<float, int64_t>(handle, queries.extent(0), kK);
+  auto ref_neighbors = make_device_matrix<IdxT, int64_t>(handle, queries.extent(0), kK);
+  auto ref_distances = make_device_matrix<float, int64_t>(handle, queries.extent(0), kK);
+  search(queries, ref_neighbors.view(), ref_distances.view());
+  // replay a few times, also with a partial batch of queries
+  for (int64_t n_rows : {queries.extent(0), queries.extent(0), queries.extent(0) / 2}) {
+    auto q = make_device_matrix_view<const float, int64_t>(queries.data_handle(), n_rows, kDim);
+    graph.run(handle,
+              q,
+              make_device_matrix_view<IdxT, int64_t>(neighbors.data_handle(), n_rows, kK),
+              make_device_matrix_view<float, int64_t>(distances.data_handle(), n_rows, kK));
+    ASSERT_TRUE(devArrMatch(ref_neighbors.data_handle(),
+                            neighbors.data_handle(),
+                            n_rows * kK,
+                            raft::Compare<IdxT>(),
+                            stream));
+    ASSERT_TRUE(devArrMatch(ref_distances.data_handle(),
+                            distances.data_handle(),
+                            n_rows * kK,
+                            raft::CompareApprox<float>(1e-5f),
+                            stream));
+  }
+}
+
+}  // namespace
+
+TEST(SearchGraph, IvfFlat)
+{
+  raft::resources handle;
+  auto dataset = make_device_matrix<float, int64_t>(handle, kRows, kDim);
+  auto queries = make_device_matrix<float, int64_t>(handle, kQueries, kDim);
+  raft::random::RngState rng(1234ULL);
+  raft::random::uniform(handle, rng, dataset.data_handle(), dataset.size(), 0.1f, 2.0f);
+  raft::random::uniform(handle, rng, queries.data_handle(), queries.size(), 0.1f, 2.0f);
+
+  ivf_flat::index_params index_params;
+  index_params.n_lists = 64;
+  auto index = ivf_flat::build(handle, index_params, raft::make_const_mdspan(dataset.view()));
+  ivf_flat::search_params search_params;
+  search_params.n_probes = 8;
+
+  auto graph =
+    ivf_flat::make_search_graph<float, int64_t>(handle, search_params, index, kQueries, kK);
+  EXPECT_EQ(graph.n_queries(), kQueries);
+  EXPECT_EQ(graph.k(), kK);
+  EXPECT_GT(graph.workspace_size(), size_t{0});
+  check_replays<int64_t>(
+    handle, graph, raft::make_const_mdspan(queries.view()), [&](auto q, auto n, auto d) {
+      ivf_flat::search(handle, search_params, index, q, n, d);
+    });
+}
+
+TEST(SearchGraph, IvfPq)
+{
+  raft::resources handle;
+  auto dataset = make_device_matrix<float, int64_t>(handle, kRows, kDim);
+  auto queries = make_device_matrix<float, int64_t>(handle, kQueries, kDim);
+  raft::random::RngState rng(1234ULL);
+  raft::random::uniform(handle, rng, dataset.data_handle(), dataset.size(), 0.1f, 2.0f);
+  raft::random::uniform(handle, rng, queries.data_handle(), queries.size(), 0.1f, 2.0f);
+
+  ivf_pq::index_params index_params;
+  index_params.n_lists = 64;
+  auto index = ivf_pq::build(handle, index_params, raft::make_const_mdspan(dataset.view()));
+  ivf_pq::search_params search_params;
+  search_params.n_probes = 8;
+
+  auto graph =
+    ivf_pq::make_search_graph<float, int64_t>(handle, search_params, index, kQueries, kK);
+  check_replays<int64_t>(
+    handle, graph, raft::make_const_mdspan(queries.view()), [&](auto q, auto n, auto d) {
+      ivf_pq::search(handle,
+                     search_params,
+                     index,
+                     make_device_matrix_view<const float, uint32_t>(
+                       q.data_handle(), q.extent(0), q.extent(1)),
+                     make_device_matrix_view<int64_t, uint32_t>(
+                       n.data_handle(), n.extent(0), n.extent(1)),
+                     make_device_matrix_view<float, uint32_t>(
+                       d.data_handle(), d.extent(0), d.extent(1)));
+    });
+}
+
+}  // namespace raft::neighbors
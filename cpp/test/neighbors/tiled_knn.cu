@@ -180,6 +180,31 @@ class TiledKNNTest : public ::testing::TestWithParam<TiledKNNInputs> {
                                                        float(0.001),
                                                        stream_,
                                                        true));
+
+    if (params_.row_major) {
+      // the same search through the prebuilt index (with the cached dataset norms)
+      auto idx = brute_force::build(
+        handle_,
+        raft::make_device_matrix_view<const T, int64_t>(database.data(), num_db_vecs, dim),
+        metric,
+        T(metric_arg));
+      brute_force::search(
+        handle_,
+        idx,
+        raft::make_device_matrix_view<const T, int64_t>(search_queries.data(), num_queries, dim),
+        raft::make_device_matrix_view<int, int64_t>(raft_indices_.data(), num_queries, k_),
+        raft::make_device_matrix_view<T, int64_t>(raft_distances_.data(), num_queries, k_));
+
+      ASSERT_TRUE(raft::spatial::knn::devArrMatchKnnPair(ref_indices_.data(),
+                                                         raft_indices_.data(),
+                                                         ref_distances_.data(),
+                                                         raft_distances_.data(),
+                                                         num_queries,
+                                                         k_,
+                                                         float(0.001),
+                                                         stream_,
+                                                         true));
+    }
   }
 
   void SetUp() override
@@ -245,7 +270,14 @@ const std::vector<TiledKNNInputs> random_inputs = {
   {1000, 500000, 128, 128, 0, 0, raft::distance::DistanceType::L2Expanded, false},
   {1000, 5000, 128, 128, 0, 0, raft::distance::DistanceType::LpUnexpanded, true},
   {1000, 5000, 128, 128, 0, 0, raft::distance::DistanceType::L2SqrtExpanded, false},
-  {1000, 5000, 128, 128, 0, 0, raft::distance::DistanceType::InnerProduct, false}};
+  {1000, 5000, 128, 128, 0, 0, raft::distance::DistanceType::InnerProduct, false},
+  // k > 64 and the inner product / cosine metrics use the fused distance + top-k kernel
+  {1000, 5000, 64, 200, 0, 0, raft::distance::DistanceType::InnerProduct, true},
+  {1000, 5000, 64, 256, 0, 0, raft::distance::DistanceType::CosineExpanded, true},
+  {1000, 5000, 64, 100, 0, 0, raft::distance::DistanceType::L2SqrtExpanded, true},
+  {10, 100000, 32, 128, 0, 0, raft::distance::DistanceType::L2Unexpanded, true},
+  {37, 257, 17, 32, 0, 0, raft::distance::DistanceType::InnerProduct, true},
+  {37, 257, 17, 257, 0, 0, raft::distance::DistanceType::CosineExpanded, true}};
 
 typedef TiledKNNTest<float> TiledKNNTestF;
 TEST_P(TiledKNNTestF, BruteForce) { this->testBruteForce(); }
@@ -25,6 +25,13 @@
 #include <raft/util/cuda_utils.cuh>
 #include <raft/util/cudart_utils.hpp>
 
+#include <unistd.h>
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
 namespace raft {
 namespace random {
 
@@ -215,5 +222,193 @@ INSTANTIATE_TEST_CASE_P(MakeBlobsTests, MakeBlobsTestD_RowMajor, ::testing::Valu
 TEST_P(MakeBlobsTestD_ColMajor, Result) { check(); }
 INSTANTIATE_TEST_CASE_P(MakeBlobsTests, MakeBlobsTestD_ColMajor, ::testing::ValuesIn(inputsd_t));
 
+// The shards generated independently are the rows of the dataset generated at once
+template <typename T, typename layout>
+class MakeBlobsShardTest : public ::testing::TestWithParam<MakeBlobsInputs<T>> {
+ public:
+  MakeBlobsShardTest()
+    : params(::testing::TestWithParam<MakeBlobsInputs<T>>::GetParam()),
+      stream(resource::get_cuda_stream(handle))
+  {
+  }
+
+ protected:
+  void check()
+  {
+    int n_rows = params.rows, n_cols = params.cols;
+    bool row_major = std::is_same<layout, raft::layout_c_contiguous>::value;
+    auto centers   = make_device_matrix<T, int, layout>(handle, params.n_clusters, n_cols);
+    raft::random::RngState r(params.seed, params.gtype);
+    uniform(handle, r, centers.data_handle(), centers.size(), T(-10.0), T(10.0));
+    auto centers_view = std::make_optional(raft::make_const_mdspan(centers.view()));
+
+    auto data   = make_device_matrix<T, int, layout>(handle, n_rows, n_cols);
+    auto labels = make_device_vector<int, int>(handle, n_rows);
+    make_blobs_shard<T, int, layout>(handle,
+                                     data.view(),
+                                     labels.view(),
+                                     0,
+                                     params.n_clusters,
+                                     centers_view,
+                                     std::nullopt,
+                                     params.std,
+                                     params.shuffle,
+                                     T(-10.0),
+                                     T(10.0),
+                                     params.seed);
+    std::vector<T> h_data(data.size());
+    std::vector<int> h_labels(n_rows);
+    update_host(h_data.data(), data.data_handle(), data.size(), stream);
+    update_host(h_labels.data(), labels.data_handle(), n_rows, stream);
+    resource::sync_stream(handle, stream);
+
+    const int n_ranks = 3;
+    for (int rank = 0; rank < n_ranks; rank++) {
+      int first   = shard_offset(n_rows, rank, n_ranks);
+      int rows    = shard_size(n_rows, rank, n_ranks);
+      auto shard  = make_device_matrix<T, int, layout>(handle, rows, n_cols);
+      auto slabel = make_device_vector<int, int>(handle, rows);
+      make_blobs_shard<T, int, layout>(handle,
+                                       shard.view(),
+                                       slabel.view(),
+                                       first,
+                                       params.n_clusters,
+                                       centers_view,
+                                       std::nullopt,
+                                       params.std,
+                                       params.shuffle,
+                                       T(-10.0),
+                                       T(10.0),
+                                       params.seed);
+      std::vector<T> h_shard(shard.size());
+      std::vector<int> h_slabel(rows);
+      update_host(h_shard.data(), shard.data_handle(), shard.size(), stream);
+      update_host(h_slabel.data(), slabel.data_handle(), rows, stream);
+      resource::sync_stream(handle, stream);
+      for (int i = 0; i < rows; i++) {
+        ASSERT_EQ(h_slabel[i], h_labels[first + i]);
+        ASSERT_TRUE(0 <= h_slabel[i] && h_slabel[i] < params.n_clusters);
+        for (int j = 0; j < n_cols; j++) {
+          auto shard_val = row_major ? h_shard[i * n_cols + j] : h_shard[i + j * rows];
+          auto val =
+            row_major ? h_data[(first + i) * n_cols + j] : h_data[(first + i) + j * n_rows];
+          ASSERT_EQ(shard_val, val) << "row: " << first + i << "; col: " << j;
+        }
+      }
+    }
+
+    // the clusters have the given centers and deviation
+    auto stats    = make_device_vector<T, int>(handle, 2 * params.n_clusters * n_cols);
+    auto lens     = make_device_vector<int, int>(handle, params.n_clusters);
+    auto mean_var = make_device_vector<T, int>(handle, 2 * params.n_clusters * n_cols);
+    RAFT_CUDA_TRY(cudaMemsetAsync(stats.data_handle(), 0, stats.extent(0) * sizeof(T), stream));
+    RAFT_CUDA_TRY(cudaMemsetAsync(lens.data_handle(), 0, lens.extent(0) * sizeof(int), stream));
+    static const int threads = 128;
+    int len                  = n_rows * n_cols;
+    meanKernel<T><<<raft::ceildiv(len, threads), threads, 0, stream>>>(stats.data_handle(),
+                                                                       lens.data_handle(),
+                                                                       data.data_handle(),
+                                                                       labels.data_handle(),
+                                                                       n_rows,
+                                                                       n_cols,
+                                                                       params.n_clusters,
+                                                                       row_major);
+    int len1 = params.n_clusters * n_cols;
+    compute_mean_var<T>
+      <<<raft::ceildiv(len1, threads), threads, 0, stream>>>(mean_var.data_handle(),
+                                                             stats.data_handle(),
+                                                             lens.data_handle(),
+                                                             params.n_clusters,
+                                                             n_cols,
+                                                             row_major);
+    auto compare = raft::CompareApprox<T>(50 * params.tolerance);
+    ASSERT_TRUE(raft::devArrMatch(centers.data_handle(), mean_var.data_handle(), len1, compare));
+    ASSERT_TRUE(raft::devArrMatch(params.std, mean_var.data_handle() + len1, len1, compare));
+  }
+
+  raft::resources handle;
+  MakeBlobsInputs<T> params;
+  cudaStream_t stream = 0;
+};
+
+typedef MakeBlobsShardTest<float, raft::layout_c_contiguous> MakeBlobsShardTestF_RowMajor;
+typedef MakeBlobsShardTest<float, raft::layout_f_contiguous> MakeBlobsShardTestF_ColMajor;
+
+TEST_P(MakeBlobsShardTestF_RowMajor, Result) { check(); }
+INSTANTIATE_TEST_CASE_P(MakeBlobsTests,
+                        MakeBlobsShardTestF_RowMajor,
+                        ::testing::ValuesIn(inputsf_t));
+
+TEST_P(MakeBlobsShardTestF_ColMajor, Result) { check(); }
+INSTANTIATE_TEST_CASE_P(MakeBlobsTests,
+                        MakeBlobsShardTestF_ColMajor,
+                        ::testing::ValuesIn(inputsf_t));
+
+// Two ranks streaming a dataset to the same file, in small batches
+template <typename OutT>
+void check_make_blobs_file(float box_min, float box_max)
+{
+  raft::resources handle;
+  auto stream         = resource::get_cuda_stream(handle);
+  const int n_rows    = 1001;
+  const int n_cols    = 24;
+  const int n_blobs   = 7;
+  const uint64_t seed = 42ULL;
+  char path[]         = "/tmp/raft_blobs_XXXXXX";
+  int fd              = mkstemp(path);
+  ASSERT_GE(fd, 0);
+  close(fd);
+  for (int rank = 1; rank >= 0; rank--) {
+    make_blobs_file<OutT, int>(handle,
+                               std::string(path),
+                               n_rows,
+                               n_cols,
+                               n_blobs,
+                               4.f,
+                               true,
+                               box_min,
+                               box_max,
+                               seed,
+                               rank,
+                               2,
+                               50);
+  }
+  std::vector<uint32_t> header(2);
+  std::vector<OutT> h_file(n_rows * n_cols);
+  FILE* fp = fopen(path, "rb");
+  ASSERT_NE(fp, nullptr);
+  ASSERT_EQ(fread(header.data(), sizeof(uint32_t), 2, fp), 2u);
+  ASSERT_EQ(fread(h_file.data(), sizeof(OutT), h_file.size(), fp), h_file.size());
+  fclose(fp);
+  std::remove(path);
+  ASSERT_EQ(header[0], uint32_t(n_rows));
+  ASSERT_EQ(header[1], uint32_t(n_cols));
+
+  auto data   = make_device_matrix<float, int>(handle, n_rows, n_cols);
+  auto labels = make_device_vector<int, int>(handle, n_rows);
+  make_blobs_shard<float, int, raft::layout_c_contiguous>(handle,
+                                                          data.view(),
+                                                          labels.view(),
+                                                          0,
+                                                          n_blobs,
+                                                          std::nullopt,
+                                                          std::nullopt,
+                                                          4.f,
+                                                          true,
+                                                          box_min,
+                                                          box_max,
+                                                          seed);
+  std::vector<float> h_data(data.size());
+  update_host(h_data.data(), data.data_handle(), data.size(), stream);
+  resource::sync_stream(handle, stream);
+  for (int i = 0; i < n_rows * n_cols; i++) {
+    ASSERT_EQ(h_file[i], detail::blobs_output_value<OutT>(h_data[i])) << "element: " << i;
+  }
+}
+
+TEST(MakeBlobsFileTest, Float) { check_make_blobs_file<float>(-10.f, 10.f); }
+
+TEST(MakeBlobsFileTest, Uint8) { check_make_blobs_file<uint8_t>(0.f, 255.f); }
+
 }  // end namespace random
 }  // end namespace raft
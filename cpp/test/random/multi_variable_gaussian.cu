@@ -22,7 +22,9 @@
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resource/cusolver_dn_handle.hpp>
 #include <raft/core/resources.hpp>
+#include <raft/core/device_mdarray.hpp>
 #include <raft/random/multi_variable_gaussian.cuh>
+#include <raft/random/rng.cuh>
 #include <raft/util/cudart_utils.hpp>
 
 #include <random>
@@ -502,4 +504,138 @@ INSTANTIATE_TEST_CASE_P(MVGTests, MVGTestD, ::testing::ValuesIn(inputsd));
 INSTANTIATE_TEST_CASE_P(MVGMdspanTests, MVGMdspanTestF, ::testing::ValuesIn(inputsf));
 INSTANTIATE_TEST_CASE_P(MVGMdspanTests, MVGMdspanTestD, ::testing::ValuesIn(inputsd));
 
+
+struct FactorizedMVGInputs {
+  multi_variable_gaussian_decomposition_method method;
+  int batch, dim, n_points;
+  unsigned long long int seed;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const FactorizedMVGInputs& p)
+{
+  return os << "batch: " << p.batch << "; dim: " << p.dim << "; points: " << p.n_points;
+}
+
+template <typename T>
+class FactorizedMVGTest : public ::testing::TestWithParam<FactorizedMVGInputs> {
+ public:
+  FactorizedMVGTest()
+    : params(::testing::TestWithParam<FactorizedMVGInputs>::GetParam()),
+      stream(resource::get_cuda_stream(handle)),
+      h_covs(size_t(params.batch) * params.dim * params.dim),
+      h_means(size_t(params.batch) * params.dim)
+  {
+    // covariances A * A^T + I, well conditioned for every decomposition
+    int d = params.dim;
+    std::mt19937 gen(params.seed);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    for (int b = 0; b < params.batch; b++) {
+      std::vector<double> a(size_t(d) * d);
+      for (auto& v : a) {
+        v = dist(gen);
+      }
+      for (int i = 0; i < d; i++) {
+        h_means[size_t(b) * d + i] = T(5 * dist(gen));
+        for (int j = 0; j < d; j++) {
+          double c = i == j ? 1.0 : 0.0;
+          for (int k = 0; k < d; k++) {
+            c += a[i * d + k] * a[j * d + k];
+          }
+          h_covs[(size_t(b) * d + j) * d + i] = T(c);
+        }
+      }
+    }
+  }
+
+ protected:
+  void check_moments(const std::vector<T>& h_x, int b)
+  {
+    int d = params.dim, n = params.n_points;
+
+    const T* x = h_x.data() + size_t(b) * n * d;
+    std::vector<double> mean(d, 0.0);
+    for (int j = 0; j < n; j++) {
+      for (int i = 0; i < d; i++) {
+        mean[i] += double(x[j * d + i]) / n;
+      }
+    }
+    for (int i = 0; i < d; i++) {
+      double var = h_covs[(size_t(b) * d + i) * d + i];
+      ASSERT_NEAR(mean[i], h_means[size_t(b) * d + i], 6 * std::sqrt(var / n))
+        << "batch: " << b << "; coordinate: " << i;
+      for (int k = 0; k <= i; k++) {
+        double cov = 0;
+        for (int j = 0; j < n; j++) {
+          cov += (x[j * d + i] - mean[i]) * (x[j * d + k] - mean[k]) / (n - 1);
+        }
+        double expected = h_covs[(size_t(b) * d + k) * d + i];
+        double scale    = std::sqrt(var * h_covs[(size_t(b) * d + k) * d + k]);
+        ASSERT_NEAR(cov, expected, 8 * scale / std::sqrt(double(n)))
+          << "batch: " << b << "; element: (" << i << ", " << k << ")";
+      }
+    }
+  }
+
+  raft::resources handle;
+  FactorizedMVGInputs params;
+  cudaStream_t stream;
+  std::vector<T> h_covs, h_means;
+};
+
+using FactorizedMVGTestF = FactorizedMVGTest<float>;
+
+TEST_P(FactorizedMVGTestF, Result)
+{
+  int batch = params.batch, d = params.dim, n = params.n_points;
+
+  auto covs  = raft::make_device_mdarray<float>(handle, raft::make_extents<int>(batch, d, d));
+  auto means = raft::make_device_matrix<float, int>(handle, batch, d);
+  auto x     = raft::make_device_mdarray<float>(handle, raft::make_extents<int>(batch, n, d));
+  raft::update_device(covs.data_handle(), h_covs.data(), covs.size(), stream);
+  raft::update_device(means.data_handle(), h_means.data(), means.size(), stream);
+
+  factorized_gaussian<float> mvg(handle,
+                                 raft::make_const_mdspan(covs.view()),
+                                 std::make_optional(raft::make_const_mdspan(means.view())),
+                                 params.method);
+  ASSERT_EQ(mvg.batch_size(), batch);
+  ASSERT_EQ(mvg.dim(), d);
+  RngState rng(params.seed);
+  RngState first = rng;
+  mvg.sample(handle, rng, x.view());
+  ASSERT_EQ(rng.base_subsequence, first.base_subsequence + 1);
+  std::vector<float> h_x(x.size());
+  raft::update_host(h_x.data(), x.data_handle(), x.size(), stream);
+  resource::sync_stream(handle, stream);
+  for (int b = 0; b < batch; b++) {
+    check_moments(h_x, b);
+  }
+
+  // a single distribution samples the points of the first one of the batch
+  factorized_gaussian<float> single(
+    handle,
+    raft::make_device_matrix_view<const float, int, raft::col_major>(covs.data_handle(), d, d),
+    std::make_optional(raft::make_device_vector_view<const float, int>(means.data_handle(), d)),
+    params.method);
+  auto x_single = raft::make_device_matrix<float, int, raft::col_major>(handle, d, n);
+  single.sample(handle, first, x_single.view());
+  ASSERT_TRUE(devArrMatch(x.data_handle(),
+                          x_single.data_handle(),
+                          size_t(n) * d,
+                          CompareApprox<float>(1e-4f),
+                          stream));
+}
+
+const std::vector<FactorizedMVGInputs> factorized_inputs = {
+  {multi_variable_gaussian_decomposition_method::CHOLESKY, 50, 4, 20000, 1234ULL},
+  {multi_variable_gaussian_decomposition_method::JACOBI, 50, 4, 20000, 1234ULL},
+  {multi_variable_gaussian_decomposition_method::QR, 50, 4, 20000, 1234ULL},
+  {multi_variable_gaussian_decomposition_method::CHOLESKY, 3, 40, 5000, 42ULL},
+  {multi_variable_gaussian_decomposition_method::JACOBI, 3, 40, 5000, 42ULL},
+  {multi_variable_gaussian_decomposition_method::CHOLESKY, 2, 100, 3000, 7ULL}};
+
+INSTANTIATE_TEST_CASE_P(FactorizedMVGTests,
+                        FactorizedMVGTestF,
+                        ::testing::ValuesIn(factorized_inputs));
+
 };  // end of namespace raft::random
@@ -16,6 +16,8 @@
 
 #include "../test_utils.cuh"
 #include <algorithm>
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/host_mdarray.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/random/permute.cuh>
@@ -23,6 +25,7 @@
 
 #include <raft/util/cuda_utils.cuh>
 #include <raft/util/cudart_utils.hpp>
+#include <numeric>
 #include <vector>
 
 namespace raft {
@@ -348,5 +351,75 @@ TEST_P(PermMdspanTestD, Result)
 }
 INSTANTIATE_TEST_CASE_P(PermMdspanTests, PermMdspanTestD, ::testing::ValuesIn(inputsd));
 
+struct PermInplaceInputs {
+  int N, D;
+  // zero for the exact permutation
+  size_t block_rows;
+  bool host;
+  unsigned long long int seed;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const PermInplaceInputs& p)
+{
+  return os << "{N=" << p.N << ", D=" << p.D << ", block_rows=" << p.block_rows
+            << (p.host ? ", host" : ", device") << "}";
+}
+
+class PermInplaceTest : public ::testing::TestWithParam<PermInplaceInputs> {
+ protected:
+  void testPermInplace()
+  {
+    auto params = ::testing::TestWithParam<PermInplaceInputs>::GetParam();
+    auto stream = resource::get_cuda_stream(handle);
+    // Every element of the row i is i
+    auto data = raft::make_host_matrix<float, int>(params.N, params.D);
+    for (int i = 0; i < params.N; i++) {
+      for (int j = 0; j < params.D; j++) {
+        data(i, j) = i;
+      }
+    }
+    RngState rng(params.seed);
+    if (params.host) {
+      permute_inplace(handle, rng, data.view(), params.block_rows);
+    } else {
+      auto data_dev = raft::make_device_matrix<float, int>(handle, params.N, params.D);
+      raft::copy(data_dev.data_handle(), data.data_handle(), data.size(), stream);
+      permute_inplace(handle, rng, data_dev.view(), params.block_rows);
+      raft::copy(data.data_handle(), data_dev.data_handle(), data.size(), stream);
+      resource::sync_stream(handle);
+    }
+
+    std::vector<int> rows(params.N);
+    int n_moved = 0;
+    for (int i = 0; i < params.N; i++) {
+      rows[i] = static_cast<int>(data(i, 0));
+      for (int j = 1; j < params.D; j++) {
+        ASSERT_EQ(data(i, j), data(i, 0)) << "row " << i << " is torn";
+      }
+      n_moved += rows[i] != i;
+    }
+    ASSERT_GT(n_moved, params.N / 2);
+    std::sort(rows.begin(), rows.end());
+    std::vector<int> expected(params.N);
+    std::iota(expected.begin(), expected.end(), 0);
+    ASSERT_EQ(rows, expected);
+  }
+
+  raft::resources handle;
+};
+
+TEST_P(PermInplaceTest, Result) { testPermInplace(); }
+
+const std::vector<PermInplaceInputs> inputs_inplace = {
+  {1000, 7, 0, false, 1234ULL},
+  {1000, 7, 0, true, 1234ULL},
+  {10000, 32, 64, false, 1234ULL},
+  {10000, 32, 64, true, 1234ULL},
+  {10007, 5, 100, false, 1234567890ULL},
+  {10007, 5, 100, true, 1234567890ULL},
+  {4096, 16, 4096, false, 42ULL},
+};
+INSTANTIATE_TEST_CASE_P(PermInplaceTests, PermInplaceTest, ::testing::ValuesIn(inputs_inplace));
+
 }  // end namespace random
 }  // end namespace raft
@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+#include <gtest/gtest.h>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/random/device/philox.cuh>
+#include <raft/random/rng_device.cuh>
+#include <raft/util/cuda_utils.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <cmath>
+#include <vector>
+
+namespace raft {
+namespace random {
+
+// the reference: every thread draws its subsequence in order
+__global__ void philox_sequential_kernel(
+  uint32_t* u32_out, float* float_out, uint64_t seed, int n_subs, int len)
+{
+  int sub = threadIdx.x + blockIdx.x * blockDim.x;
+  if (sub >= n_subs) return;
+  PhiloxGenerator gen_u32(seed, sub, 0);
+  PhiloxGenerator gen_float(seed, sub, 0);
+  for (int j = 0; j < len; j++) {
+    u32_out[sub * len + j]   = gen_u32.next_u32();
+    float_out[sub * len + j] = gen_float.next_float();
+  }
+}
+
+// every element on its own, in an arbitrary order
+__global__ void philox_counter_kernel(
+  uint32_t* u32_out, float* float_out, uint64_t seed, int n_subs, int len)
+{
+  int tid = threadIdx.x + blockIdx.x * blockDim.x;
+  if (tid >= n_subs * len) return;
+  int idx = n_subs * len - 1 - tid;
+  int sub = idx / len;
+  int j   = idx % len;
+  device::counter_rng rng(seed, sub);
+  u32_out[idx]   = rng.u32(j);
+  float_out[idx] = rng.uniform<float>(j);
+}
+
+__global__ void philox_normal_kernel(double* out, uint64_t seed, int len)
+{
+  int i = threadIdx.x + blockIdx.x * blockDim.x;
+  if (i < len) { out[i] = device::counter_rng(seed, 7).normal<double>(i, 1.0, 2.0); }
+}
+
+struct PhiloxInputs {
+  uint64_t seed;
+  int n_subs;
+  int len;
+};
+
+class PhiloxTest : public ::testing::TestWithParam<PhiloxInputs> {
+ public:
+  PhiloxTest()
+    : params(::testing::TestWithParam<PhiloxInputs>::GetParam()),
+      stream(resource::get_cuda_stream(handle)),
+      ref_u32(params.n_subs * params.len, stream),
+      act_u32(params.n_subs * params.len, stream),
+      ref_float(params.n_subs * params.len, stream),
+      act_float(params.n_subs * params.len, stream)
+  {
+  }
+
+ protected:
+  void SetUp() override
+  {
+    int n = params.n_subs * params.len;
+    philox_sequential_kernel<<<raft::ceildiv(params.n_subs, 64), 64, 0, stream>>>(
+      ref_u32.data(), ref_float.data(), params.seed, params.n_subs, params.len);
+    philox_counter_kernel<<<raft::ceildiv(n, 256), 256, 0, stream>>>(
+      act_u32.data(), act_float.data(), params.seed, params.n_subs, params.len);
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+  }
+
+  raft::resources handle;
+  PhiloxInputs params;
+  cudaStream_t stream;
+  rmm::device_uvector<uint32_t> ref_u32, act_u32;
+  rmm::device_uvector<float> ref_float, act_float;
+};
+
+TEST_P(PhiloxTest, MatchesPhiloxGenerator)
+{
+  int n = params.n_subs * params.len;
+  ASSERT_TRUE(devArrMatch(ref_u32.data(), act_u32.data(), n, raft::Compare<uint32_t>(), stream));
+  ASSERT_TRUE(devArrMatch(ref_float.data(), act_float.data(), n, raft::Compare<float>(), stream));
+
+  // the same values on the host
+  std::vector<uint32_t> h_ref(n);
+  raft::update_host(h_ref.data(), ref_u32.data(), n, stream);
+  resource::sync_stream(handle, stream);
+  for (int sub = 0; sub < params.n_subs; sub++) {
+    device::counter_rng rng(params.seed, sub);
+    for (int j = 0; j < params.len; j++) {
+      ASSERT_EQ(rng.u32(j), h_ref[sub * params.len + j]) << "sub: " << sub << "; j: " << j;
+    }
+  }
+}
+
+TEST_P(PhiloxTest, Normal)
+{
+  int n = params.n_subs * params.len;
+  rmm::device_uvector<double> out(n, stream);
+  philox_normal_kernel<<<raft::ceildiv(n, 256), 256, 0, stream>>>(out.data(), params.seed, n);
+  std::vector<double> h_out(n);
+  raft::update_host(h_out.data(), out.data(), n, stream);
+  resource::sync_stream(handle, stream);
+  double mean = 0, var = 0;
+  for (auto x : h_out) {
+    mean += x / n;
+  }
+  for (auto x : h_out) {
+    var += (x - mean) * (x - mean) / n;
+  }
+  double tol = 6.0 * 2.0 / std::sqrt(double(n));
+  ASSERT_NEAR(mean, 1.0, tol);
+  ASSERT_NEAR(std::sqrt(var), 2.0, tol);
+}
+
+const std::vector<PhiloxInputs> inputs = {
+  {1234ULL, 1, 1000}, {42ULL, 37, 129}, {0xdeadbeefcafeULL, 256, 1024}};
+
+INSTANTIATE_TEST_CASE_P(PhiloxTests, PhiloxTest, ::testing::ValuesIn(inputs));
+
+}  // namespace random
+}  // namespace raft
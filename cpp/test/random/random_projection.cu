@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+#include <gtest/gtest.h>
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/random/random_projection.cuh>
+#include <raft/random/rng.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <cmath>
+#include <vector>
+
+namespace raft {
+namespace random {
+
+struct RandomProjectionInputs {
+  int n_rows;
+  int n_features;
+  int n_components;
+  double density;
+  unsigned long long int seed;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const RandomProjectionInputs& p)
+{
+  return os << "rows: " << p.n_rows << "; features: " << p.n_features
+            << "; components: " << p.n_components;
+}
+
+template <typename T>
+class RandomProjectionTest : public ::testing::TestWithParam<RandomProjectionInputs> {
+ public:
+  RandomProjectionTest()
+    : params(::testing::TestWithParam<RandomProjectionInputs>::GetParam()),
+      stream(resource::get_cuda_stream(handle)),
+      state(params.seed),
+      x(raft::make_device_matrix<T, int>(handle, params.n_rows, params.n_features)),
+      y(raft::make_device_matrix<T, int>(handle, params.n_rows, params.n_components)),
+      h_x(size_t(params.n_rows) * params.n_features)
+  {
+    RngState data_state(params.seed + 1);
+    uniform(handle, data_state, x.data_handle(), x.size(), T(-1), T(1));
+    raft::update_host(h_x.data(), x.data_handle(), x.size(), stream);
+    resource::sync_stream(handle, stream);
+  }
+
+ protected:
+  auto fetch_y() -> std::vector<T>
+  {
+    std::vector<T> h_y(y.size());
+    raft::update_host(h_y.data(), y.data_handle(), y.size(), stream);
+    resource::sync_stream(handle, stream);
+    return h_y;
+  }
+
+  void check_product(const std::vector<T>& h_y, const std::vector<double>& r)
+  {
+    int n = params.n_rows, d = params.n_features, k = params.n_components;
+    for (int i = 0; i < n; i++) {
+      for (int c = 0; c < k; c++) {
+        double expected = 0;
+        for (int j = 0; j < d; j++) {
+          expected += double(h_x[i * d + j]) * r[j * k + c];
+        }
+        ASSERT_NEAR(h_y[i * k + c], expected, 1e-3 * std::sqrt(double(d)))
+          << "row: " << i << "; component: " << c;
+      }
+    }
+  }
+
+  raft::resources handle;
+  RandomProjectionInputs params;
+  cudaStream_t stream;
+  RngState state;
+  raft::device_matrix<T, int> x, y;
+  std::vector<T> h_x;
+};
+
+using RandomProjectionTestF = RandomProjectionTest<float>;
+
+TEST_P(RandomProjectionTestF, Gaussian)
+{
+  gaussian_random_projection(handle, state, raft::make_const_mdspan(x.view()), y.view());
+  auto h_y = fetch_y();
+
+  int d = params.n_features, k = params.n_components;
+  device::counter_rng rng(state, detail::kProjectionMatrixStream);
+  std::vector<double> r(size_t(d) * k);
+  for (int j = 0; j < d; j++) {
+    for (int c = 0; c < k; c++) {
+      r[j * k + c] = detail::gaussian_projection_element<float>(rng, j, c, k) / std::sqrt(k);
+    }
+  }
+  check_product(h_y, r);
+
+  // the same state gives the same projection, a batch of rows at a time
+  auto y_batch = raft::make_device_matrix<float, int>(handle, 1, k);
+  gaussian_random_projection(
+    handle,
+    state,
+    raft::make_device_matrix_view<const float, int>(
+      x.data_handle() + size_t(params.n_rows - 1) * d, 1, d),
+    y_batch.view());
+  ASSERT_TRUE(devArrMatch(y.data_handle() + size_t(params.n_rows - 1) * k,
+                          y_batch.data_handle(),
+                          k,
+                          CompareApprox<float>(1e-5f),
+                          stream));
+}
+
+TEST_P(RandomProjectionTestF, Sparse)
+{
+  int d = params.n_features, k = params.n_components;
+  auto components = make_sparse_random_projection<float>(handle, state, d, k, params.density);
+  auto structure  = components.structure_view();
+  int nnz         = structure.get_nnz();
+  sparse_random_projection(handle,
+                           raft::make_device_csr_matrix_view<const float, int, int, int>(
+                             components.get_elements().data(), structure),
+                           raft::make_const_mdspan(x.view()),
+                           y.view());
+  auto h_y = fetch_y();
+
+  std::vector<int> indptr(k + 1), indices(nnz);
+  std::vector<float> values(nnz);
+  raft::update_host(indptr.data(), structure.get_indptr().data(), k + 1, stream);
+  raft::update_host(indices.data(), structure.get_indices().data(), nnz, stream);
+  raft::update_host(values.data(), components.get_elements().data(), nnz, stream);
+  resource::sync_stream(handle, stream);
+
+  double density = params.density > 0 ? params.density : 1.0 / std::sqrt(double(d));
+  double value   = 1.0 / std::sqrt(density * k);
+  std::vector<double> r(size_t(d) * k, 0.0);
+  for (int c = 0; c < k; c++) {
+    for (int p = indptr[c]; p < indptr[c + 1]; p++) {
+      if (p > indptr[c]) { ASSERT_LT(indices[p - 1], indices[p]); }
+      ASSERT_NEAR(std::abs(values[p]), value, 1e-5 * value);
+      r[indices[p] * k + c] = values[p];
+    }
+  }
+  double expected_nnz = density * d * k;
+  ASSERT_NEAR(nnz, expected_nnz, 6 * std::sqrt(expected_nnz) + 1);
+  check_product(h_y, r);
+}
+
+TEST_P(RandomProjectionTestF, Srht)
+{
+  int n = params.n_rows, d = params.n_features, k = params.n_components;
+  int d_pad = 1;
+  while (d_pad < d) {
+    d_pad *= 2;
+  }
+  if (k > d_pad) { GTEST_SKIP(); }
+  srht_random_projection(handle, state, raft::make_const_mdspan(x.view()), y.view());
+  auto h_y = fetch_y();
+
+  // with all the coordinates, the transform is orthonormal
+  auto y_full = raft::make_device_matrix<float, int>(handle, n, d_pad);
+  srht_random_projection(handle, state, raft::make_const_mdspan(x.view()), y_full.view());
+  std::vector<float> h_full(y_full.size());
+  raft::update_host(h_full.data(), y_full.data_handle(), y_full.size(), stream);
+  resource::sync_stream(handle, stream);
+
+  device::counter_rng signs(state, detail::kProjectionMatrixStream);
+  double ratio = 0;
+  for (int i = 0; i < n; i++) {
+    std::vector<double> z(d_pad, 0.0);
+    double norm_x = 0, norm_y = 0;
+    for (int j = 0; j < d; j++) {
+      z[j] = (signs.u32(j) & 1u) ? -h_x[i * d + j] : h_x[i * d + j];
+      norm_x += z[j] * z[j];
+    }
+    for (int h = 1; h < d_pad; h *= 2) {
+      for (int j = 0; j < d_pad; j += 2 * h) {
+        for (int l = j; l < j + h; l++) {
+          double a = z[l], b = z[l + h];
+          z[l]     = a + b;
+          z[l + h] = a - b;
+        }
+      }
+    }
+    for (int j = 0; j < d_pad; j++) {
+      ASSERT_NEAR(h_full[i * d_pad + j], z[j] / std::sqrt(d_pad), 1e-4) << "row: " << i;
+    }
+    for (int c = 0; c < k; c++) {
+      norm_y += double(h_y[i * k + c]) * h_y[i * k + c];
+    }
+    ratio += norm_y / norm_x / n;
+  }
+  // the squared norms are preserved in expectation
+  ASSERT_NEAR(ratio, 1.0, 0.1);
+}
+
+const std::vector<RandomProjectionInputs> inputs = {{300, 100, 32, 0, 1234ULL},
+                                                    {257, 64, 30, 1.0 / 3.0, 42ULL},
+                                                    {50, 1000, 128, 0, 7ULL},
+                                                    {129, 17, 5, 0.5, 3ULL}};
+
+INSTANTIATE_TEST_CASE_P(RandomProjectionTests,
+                        RandomProjectionTestF,
+                        ::testing::ValuesIn(inputs));
+
+}  // namespace random
+}  // namespace raft
@@ -18,8 +18,12 @@
 #include <gtest/gtest.h>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <sys/timeb.h>
+#include <unistd.h>
 #include <vector>
 
+#include <cstdio>
+#include <string>
+
 #include "../test_utils.cuh"
 
 #include <raft/core/resources.hpp>
@@ -398,5 +402,81 @@ INSTANTIATE_TEST_SUITE_P(RmatGenTests, RmatGenTest, ::testing::ValuesIn(inputs))
 TEST_P(RmatGenMdspanTest, Result) { validate(); }
 INSTANTIATE_TEST_SUITE_P(RmatGenMdspanTests, RmatGenMdspanTest, ::testing::ValuesIn(inputs));
 
+// The shards of a graph, generated independently, are the edges of the graph generated at once
+TEST(RmatGenShardTest, MatchesWholeGraph)
+{
+  raft::resources handle;
+  auto stream           = resource::get_cuda_stream(handle);
+  const int64_t n_edges = 100003;
+  const int64_t r_scale = 16;
+  const int64_t c_scale = 18;
+  const float a         = 0.57f;
+  const float b         = 0.19f;
+  const float c         = 0.19f;
+  const uint64_t seed   = 123456ULL;
+  rmm::device_uvector<int64_t> src(n_edges, stream), dst(n_edges, stream);
+  rmm::device_uvector<int64_t> shard_src(n_edges, stream), shard_dst(n_edges, stream);
+
+  RngState r(seed, GeneratorType::GenPC);
+  rmat_rectangular_gen(handle,
+                       r,
+                       raft::make_device_vector_view(src.data(), n_edges),
+                       raft::make_device_vector_view(dst.data(), n_edges),
+                       a,
+                       b,
+                       c,
+                       r_scale,
+                       c_scale);
+
+  const int n_ranks = 3;
+  RngState r_shard(seed, GeneratorType::GenPC);
+  for (int rank = 0; rank < n_ranks; rank++) {
+    auto first = shard_offset(n_edges, rank, n_ranks);
+    auto n     = shard_size(n_edges, rank, n_ranks);
+    rmat_rectangular_gen_shard(handle,
+                               r_shard,
+                               raft::make_device_vector_view(shard_src.data() + first, n),
+                               raft::make_device_vector_view(shard_dst.data() + first, n),
+                               a,
+                               b,
+                               c,
+                               r_scale,
+                               c_scale,
+                               first);
+  }
+  ASSERT_TRUE(devArrMatch(src.data(), shard_src.data(), n_edges, Compare<int64_t>(), stream));
+  ASSERT_TRUE(devArrMatch(dst.data(), shard_dst.data(), n_edges, Compare<int64_t>(), stream));
+
+  // two ranks streaming their edges to the same file, in small batches
+  char path[] = "/tmp/raft_rmat_XXXXXX";
+  int fd      = mkstemp(path);
+  ASSERT_GE(fd, 0);
+  close(fd);
+  for (int rank = 1; rank >= 0; rank--) {
+    RngState r_file(seed, GeneratorType::GenPC);
+    rmat_rectangular_gen_file(
+      handle, r_file, std::string(path), n_edges, a, b, c, r_scale, c_scale, rank, 2, int64_t(777));
+    ASSERT_EQ(r_file.base_subsequence, r.base_subsequence);
+  }
+  std::vector<uint32_t> header(2);
+  std::vector<int64_t> edges(2 * n_edges);
+  FILE* fp = fopen(path, "rb");
+  ASSERT_NE(fp, nullptr);
+  ASSERT_EQ(fread(header.data(), sizeof(uint32_t), 2, fp), 2u);
+  ASSERT_EQ(fread(edges.data(), sizeof(int64_t), edges.size(), fp), edges.size());
+  fclose(fp);
+  std::remove(path);
+  ASSERT_EQ(header[0], uint32_t(n_edges));
+  ASSERT_EQ(header[1], 2u);
+  std::vector<int64_t> h_src(n_edges), h_dst(n_edges);
+  raft::update_host(h_src.data(), src.data(), n_edges, stream);
+  raft::update_host(h_dst.data(), dst.data(), n_edges, stream);
+  resource::sync_stream(handle, stream);
+  for (int64_t i = 0; i < n_edges; i++) {
+    ASSERT_EQ(edges[2 * i], h_src[i]) << "edge: " << i;
+    ASSERT_EQ(edges[2 * i + 1], h_dst[i]) << "edge: " << i;
+  }
+}
+
 }  // namespace random
 }  // namespace raft
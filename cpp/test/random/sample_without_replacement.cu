@@ -16,12 +16,15 @@
 
 #include "../test_utils.cuh"
 #include <gtest/gtest.h>
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/host_mdspan.hpp>
 #include <raft/core/resource/cuda_stream.hpp>
 #include <raft/core/resources.hpp>
 #include <raft/random/rng.cuh>
 #include <raft/random/sample_without_replacement.cuh>
 #include <raft/util/cuda_utils.cuh>
 #include <raft/util/cudart_utils.hpp>
+#include <algorithm>
 #include <set>
 #include <vector>
 
@@ -279,5 +282,161 @@ using SWoRMdspanTestD = SWoRMdspanTest<double>;
 TEST_P(SWoRMdspanTestD, Result) { _RAFT_SWOR_TEST_CONTENTS(); }
 INSTANTIATE_TEST_SUITE_P(SWoRTests2, SWoRMdspanTestD, ::testing::ValuesIn(inputsd));
 
+struct SWoRScaleInputs {
+  int len, sampledLen, n_batches;
+  GeneratorType gtype;
+  unsigned long long int seed;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const SWoRScaleInputs& p)
+{
+  return os << "len: " << p.len << "; sampledLen: " << p.sampledLen;
+}
+
+// The selection of the smallest keys, the batched samples and the reservoir
+class SWoRScaleTest : public ::testing::TestWithParam<SWoRScaleInputs> {
+ public:
+  SWoRScaleTest()
+    : params(::testing::TestWithParam<SWoRScaleInputs>::GetParam()),
+      stream(resource::get_cuda_stream(handle)),
+      in(params.len, stream),
+      wts(params.len, stream),
+      h_wts(params.len)
+  {
+    RngState r(params.seed + 1);
+    uniform(handle, r, in.data(), params.len, -1.0f, 1.0f);
+    uniform(handle, r, wts.data(), params.len, 1.0f, 2.0f);
+    // a third of the elements can't be sampled
+    update_host(h_wts.data(), wts.data(), params.len, stream);
+    resource::sync_stream(handle, stream);
+    for (int i = 0; i < params.len; i += 3) {
+      h_wts[i] = 0.f;
+    }
+    update_device(wts.data(), h_wts.data(), params.len, stream);
+  }
+
+ protected:
+  auto fetch(const int* ptr, size_t n) -> std::vector<int>
+  {
+    std::vector<int> h(n);
+    update_host(h.data(), ptr, n, stream);
+    resource::sync_stream(handle, stream);
+    return h;
+  }
+
+  void check_sample(const std::vector<int>& idx)
+  {
+    std::set<int> occurrence;
+    for (auto val : idx) {
+      ASSERT_TRUE(0 <= val && val < params.len) << "out-of-range index " << val;
+      ASSERT_NE(val % 3, 0) << "zero-weight index " << val;
+      ASSERT_TRUE(occurrence.insert(val).second) << "repeated index " << val;
+    }
+  }
+
+  raft::resources handle;
+  SWoRScaleInputs params;
+  cudaStream_t stream;
+  rmm::device_uvector<float> in, wts;
+  std::vector<float> h_wts;
+};
+
+TEST_P(SWoRScaleTest, SelectMatchesSort)
+{
+  rmm::device_uvector<float> out(params.sampledLen, stream), ref(params.sampledLen, stream);
+  rmm::device_uvector<int> outIdx(params.sampledLen, stream), refIdx(params.sampledLen, stream);
+  RngState r(params.seed, params.gtype);
+  RngState r_ref(params.seed, params.gtype);
+  sample_without_replacement(handle,
+                             r,
+                             raft::make_device_vector_view<const float, int>(in.data(), params.len),
+                             std::make_optional(raft::make_device_vector_view<const float, int>(
+                               wts.data(), params.len)),
+                             raft::make_device_vector_view<float, int>(out.data(), out.size()),
+                             std::make_optional(raft::make_device_vector_view<int, int>(
+                               outIdx.data(), outIdx.size())));
+  detail::sampleWithoutReplacement(r_ref,
+                                   ref.data(),
+                                   refIdx.data(),
+                                   in.data(),
+                                   wts.data(),
+                                   params.sampledLen,
+                                   params.len,
+                                   stream);
+  ASSERT_EQ(r.base_subsequence, r_ref.base_subsequence);
+  ASSERT_TRUE(devArrMatch(
+    refIdx.data(), outIdx.data(), params.sampledLen, raft::Compare<int>(), stream));
+  ASSERT_TRUE(
+    devArrMatch(ref.data(), out.data(), params.sampledLen, raft::Compare<float>(), stream));
+  check_sample(fetch(outIdx.data(), params.sampledLen));
+}
+
+TEST_P(SWoRScaleTest, BatchedAndReservoir)
+{
+  int k    = params.sampledLen;
+  auto out = raft::make_device_matrix<float, int>(handle, params.n_batches, k);
+  auto idx = raft::make_device_matrix<int, int>(handle, params.n_batches, k);
+  RngState r(params.seed, params.gtype);
+  RngState r_reservoir = r;
+  sample_without_replacement_batched(
+    handle,
+    r,
+    raft::make_device_vector_view<const float, int>(in.data(), params.len),
+    std::make_optional(raft::make_device_vector_view<const float, int>(wts.data(), params.len)),
+    out.view(),
+    std::make_optional(idx.view()));
+  ASSERT_EQ(r.base_subsequence, r_reservoir.base_subsequence + params.n_batches);
+
+  auto h_idx = fetch(idx.data_handle(), idx.size());
+  std::vector<float> h_in(params.len), h_out(out.size());
+  update_host(h_in.data(), in.data(), params.len, stream);
+  update_host(h_out.data(), out.data_handle(), out.size(), stream);
+  resource::sync_stream(handle, stream);
+  for (int b = 0; b < params.n_batches; b++) {
+    std::vector<int> row(h_idx.begin() + b * k, h_idx.begin() + (b + 1) * k);
+    check_sample(row);
+    for (int j = 0; j < k; j++) {
+      ASSERT_EQ(h_out[b * k + j], h_in[row[j]]);
+    }
+  }
+  if (params.n_batches > 1) {
+    ASSERT_FALSE(std::equal(h_idx.begin(), h_idx.begin() + k, h_idx.begin() + k));
+  }
+
+  // the reservoir of the host weights in uneven blocks is the first sample
+  sample_reservoir<float, int> reservoir(handle, r_reservoir, k);
+  int first = params.len / 7, second = params.len / 2;
+  reservoir.update(handle, raft::make_host_vector_view<const float, int>(h_wts.data(), first));
+  reservoir.update(
+    handle, raft::make_device_vector_view<const float, int>(wts.data() + first, second - first));
+  reservoir.update(handle,
+                   raft::make_host_vector_view<const float, int>(h_wts.data() + second,
+                                                                 params.len - second));
+  ASSERT_EQ(reservoir.n_rows(), params.len);
+  ASSERT_EQ(reservoir.size(), k);
+  auto h_reservoir = fetch(reservoir.indices().data_handle(), k);
+  std::vector<int> expected(h_idx.begin(), h_idx.begin() + k);
+  std::sort(h_reservoir.begin(), h_reservoir.end());
+  std::sort(expected.begin(), expected.end());
+  ASSERT_EQ(h_reservoir, expected);
+
+  // uniform elements
+  sample_reservoir<float, int> uniform_reservoir(handle, r_reservoir, k);
+  uniform_reservoir.update(handle, k / 2);
+  ASSERT_EQ(uniform_reservoir.size(), k / 2);
+  uniform_reservoir.update(handle, params.len - k / 2);
+  auto h_uniform = fetch(uniform_reservoir.indices().data_handle(), k);
+  std::set<int> occurrence(h_uniform.begin(), h_uniform.end());
+  ASSERT_EQ(int(occurrence.size()), k);
+  ASSERT_TRUE(*occurrence.begin() >= 0 && *occurrence.rbegin() < params.len);
+}
+
+const std::vector<SWoRScaleInputs> inputs_scale = {{100000, 100, 4, GenPhilox, 1234ULL},
+                                                   {100000, 1000, 3, GenPC, 1234ULL},
+                                                   {30000, 2048, 17, GenPC, 42ULL},
+                                                   {5000, 1, 1, GenPhilox, 7ULL}};
+
+INSTANTIATE_TEST_SUITE_P(SWoRTests, SWoRScaleTest, ::testing::ValuesIn(inputs_scale));
+
 }  // namespace random
 }  // namespace raft
@@ -186,5 +186,48 @@ typedef CSRRowSliceTest<int, float> CSRRowSliceTestF;
 TEST_P(CSRRowSliceTestF, Result) { compare(); }
 INSTANTIATE_TEST_CASE_P(CSRRowSliceTest, CSRRowSliceTestF, ::testing::ValuesIn(inputs_i32_f));
 
+/** Every batch of the plan should match the slice of the same rows. */
+class CSRRowBatchesTest : public ::testing::TestWithParam<int> {
+ protected:
+  raft::resources handle;
+};
+
+TEST_P(CSRRowBatchesTest, Result)
+{
+  auto stream                = resource::get_cuda_stream(handle);
+  int batch_size             = GetParam();
+  std::vector<int> indptr_h  = {0, 2, 2, 5, 6, 6, 9, 10};
+  std::vector<int> indices_h = {0, 1, 0, 1, 2, 2, 0, 1, 2, 1};
+  std::vector<float> data_h  = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+  int n_rows                 = indptr_h.size() - 1;
+  rmm::device_uvector<int> indptr(indptr_h.size(), stream), indices(indices_h.size(), stream);
+  rmm::device_uvector<float> data(data_h.size(), stream);
+  update_device(indptr.data(), indptr_h.data(), indptr_h.size(), stream);
+  update_device(indices.data(), indices_h.data(), indices_h.size(), stream);
+  update_device(data.data(), data_h.data(), data_h.size(), stream);
+
+  raft::sparse::op::csr_row_batches<int> batches(handle, indptr.data(), n_rows, batch_size);
+  ASSERT_EQ(batches.n_batches(), raft::ceildiv(n_rows, batch_size));
+  rmm::device_uvector<int> batch_indptr(batches.max_batch_rows() + 1, stream);
+  rmm::device_uvector<int> ref_indptr(batches.max_batch_rows() + 1, stream);
+  for (int b = 0; b < batches.n_batches(); b++) {
+    int start_row = batches.batch_start(b);
+    int stop_row  = start_row + batches.batch_rows(b) - 1;
+    int start_offset, stop_offset;
+    raft::sparse::op::csr_row_slice_indptr(
+      start_row, stop_row, indptr.data(), ref_indptr.data(), &start_offset, &stop_offset, stream);
+    batches.batch_indptr(b, batch_indptr.data(), stream);
+
+    ASSERT_EQ(batches.batch_offset(b), start_offset);
+    ASSERT_EQ(batches.batch_nnz(b), stop_offset - start_offset);
+    ASSERT_EQ(batches.batch_view(b, indices.data()), indices.data() + start_offset);
+    ASSERT_EQ(batches.batch_view(b, data.data()), data.data() + start_offset);
+    ASSERT_TRUE(devArrMatch(
+      batch_indptr.data(), ref_indptr.data(), batches.batch_rows(b) + 1, Compare<int>(), stream));
+  }
+}
+
+INSTANTIATE_TEST_CASE_P(CSRRowSliceTest, CSRRowBatchesTest, ::testing::Values(1, 3, 7, 100));
+
 };  // end namespace sparse
 };  // end namespace raft
@@ -57,12 +57,16 @@ struct InputConfiguration {
 using dense_smem_strategy_t = detail::dense_smem_strategy<int, float, 1024>;
 using hash_strategy_t       = detail::hash_strategy<int, float, 1024>;
 
+// rows with at most 2 non-zeros are small, so all the bins are used on the test inputs
+using adaptive_strategy_t = detail::adaptive_strategy<int, float, 1024, 2>;
+
 template <typename value_idx, typename value_t, typename strategy_t>
 struct SparseDistanceCOOSPMVInputs {
   InputConfiguration<value_idx, value_t> input_configuration;
 
   float capacity_threshold = 0.5;
   int map_size             = detail::hash_strategy<value_idx, value_t, 1024>::get_map_size();
+  size_t max_buffer_bytes  = size_t(1) << 28;
 };
 
 template <typename value_idx, typename value_t, typename strategy_t>
@@ -92,6 +96,13 @@ class SparseDistanceCOOSPMVTest
     return strategy_t(dist_config, params.capacity_threshold, params.map_size);
   }
 
+  template <typename U, std::enable_if_t<std::is_same_v<U, adaptive_strategy_t>>* = nullptr>
+  U make_strategy()
+  {
+    return strategy_t(
+      dist_config, params.capacity_threshold, params.map_size, params.max_buffer_bytes);
+  }
+
   template <typename U, std::enable_if_t<std::is_same_v<U, dense_smem_strategy_t>>* = nullptr>
   U make_strategy()
   {
@@ -692,6 +703,23 @@ INSTANTIATE_TEST_CASE_P(SparseDistanceCOOSPMVTests,
                         SparseDistanceCOOSPMVTestHashStrategyF,
                         ::testing::ValuesIn(inputs_hash_strategy));
 
+// test the per-row selection of the small, hash and dense global strategies
+const std::vector<SparseDistanceCOOSPMVInputs<int, float, adaptive_strategy_t>>
+  inputs_adaptive_strategy = {{input_inner_product},
+                              {input_inner_product, 0.5, 8},
+                              {input_l2_unexpanded, 0.5, 8},
+                              {input_canberra, 0.5, 8, 1},
+                              {input_lp_unexpanded, 0.5, 6},
+                              {input_linf, 0.5, 8, 1},
+                              {input_l1, 0.5, 8}};
+
+typedef SparseDistanceCOOSPMVTest<int, float, adaptive_strategy_t>
+  SparseDistanceCOOSPMVTestAdaptiveStrategyF;
+TEST_P(SparseDistanceCOOSPMVTestAdaptiveStrategyF, Result) { compare(); }
+INSTANTIATE_TEST_CASE_P(SparseDistanceCOOSPMVTests,
+                        SparseDistanceCOOSPMVTestAdaptiveStrategyF,
+                        ::testing::ValuesIn(inputs_adaptive_strategy));
+
 };  // namespace distance
 };  // end namespace sparse
 };  // end namespace raft
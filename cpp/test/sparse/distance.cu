@@ -27,6 +27,9 @@
 
 #include "../test_utils.cuh"
 
+#include <algorithm>
+#include <set>
+
 namespace raft {
 namespace sparse {
 namespace distance {
@@ -104,6 +107,76 @@ class SparseDistanceTest
                             CompareApprox<value_t>(1e-3)));
   }
 
+  /**
+   * The sparse output only stores the pairs of rows sharing a column; the other pairs are
+   * filled on the host from the row norms before comparing with the dense reference.
+   */
+  void compare_sparse_output()
+  {
+    if (!detail::spgemm_distance_supported(params.metric)) { GTEST_SKIP(); }
+    auto stream = resource::get_cuda_stream(handle);
+    value_idx n = dist_config.a_nrows;
+    auto sparse =
+      raft::make_device_csr_matrix<value_t, value_idx, value_idx, value_idx>(handle, n, n);
+    pairwiseDistanceSparseOutput(sparse, dist_config, params.metric);
+
+    auto structure = sparse.structure_view();
+    value_idx nnz  = structure.get_nnz();
+    std::vector<value_idx> c_indptr(n + 1), c_indices(nnz);
+    std::vector<value_t> c_data(nnz);
+    update_host(c_indptr.data(), structure.get_indptr().data(), n + 1, stream);
+    update_host(c_indices.data(), structure.get_indices().data(), nnz, stream);
+    update_host(c_data.data(), sparse.get_elements().data(), nnz, stream);
+    resource::sync_stream(handle, stream);
+
+    std::vector<value_t> dense(size_t(n) * n);
+    std::vector<value_t> sq_norms = host_sq_norms();
+    for (value_idx i = 0; i < n; i++) {
+      for (value_idx j = 0; j < n; j++) {
+        dense[size_t(i) * n + j] = absent_distance(sq_norms[i], sq_norms[j]);
+      }
+      for (value_idx p = c_indptr[i]; p < c_indptr[i + 1]; p++) {
+        ASSERT_TRUE(share_a_column(i, c_indices[p]));
+        dense[size_t(i) * n + c_indices[p]] = c_data[p];
+      }
+    }
+    ASSERT_TRUE(hostVecMatch(params.out_dists_ref_h, dense, CompareApprox<value_t>(1e-3)));
+  }
+
+  /** The neighbors are the best candidates among the rows sharing a column, in order. */
+  void compare_topk()
+  {
+    if (!detail::spgemm_distance_supported(params.metric)) { GTEST_SKIP(); }
+    auto stream = resource::get_cuda_stream(handle);
+    value_idx n = dist_config.a_nrows;
+    int k       = std::min<int>(2, n);
+    rmm::device_uvector<value_idx> out_idx(size_t(n) * k, stream);
+    rmm::device_uvector<value_t> out_val(size_t(n) * k, stream);
+    pairwiseDistanceTopK(out_idx.data(), out_val.data(), dist_config, params.metric, k);
+
+    std::vector<value_idx> idx_h(out_idx.size());
+    std::vector<value_t> val_h(out_val.size());
+    update_host(idx_h.data(), out_idx.data(), idx_h.size(), stream);
+    update_host(val_h.data(), out_val.data(), val_h.size(), stream);
+    resource::sync_stream(handle, stream);
+
+    bool select_min = params.metric != raft::distance::DistanceType::InnerProduct;
+    for (value_idx i = 0; i < n; i++) {
+      std::vector<value_t> candidates;
+      for (value_idx j = 0; j < n; j++) {
+        if (share_a_column(i, j)) {
+          candidates.push_back(params.out_dists_ref_h[size_t(i) * n + j]);
+        }
+      }
+      std::sort(candidates.begin(), candidates.end());
+      if (!select_min) { std::reverse(candidates.begin(), candidates.end()); }
+      for (int l = 0; l < std::min<int>(k, candidates.size()); l++) {
+        ASSERT_TRUE(share_a_column(i, idx_h[size_t(i) * k + l]));
+        ASSERT_TRUE(match(candidates[l], val_h[size_t(i) * k + l], CompareApprox<value_t>(1e-3)));
+      }
+    }
+  }
+
  protected:
   void make_data()
   {
@@ -130,6 +203,38 @@ class SparseDistanceTest
                   resource::get_cuda_stream(dist_config.handle));
   }
 
+  bool share_a_column(value_idx i, value_idx j) const
+  {
+    auto& indptr_h  = params.indptr_h;
+    auto& indices_h = params.indices_h;
+    std::set<value_idx> cols(indices_h.begin() + indptr_h[i], indices_h.begin() + indptr_h[i + 1]);
+    for (value_idx p = indptr_h[j]; p < indptr_h[j + 1]; p++) {
+      if (cols.count(indices_h[p]) > 0) { return true; }
+    }
+    return false;
+  }
+
+  std::vector<value_t> host_sq_norms() const
+  {
+    std::vector<value_t> sq_norms(params.indptr_h.size() - 1, value_t(0));
+    for (size_t i = 0; i + 1 < params.indptr_h.size(); i++) {
+      for (value_idx p = params.indptr_h[i]; p < params.indptr_h[i + 1]; p++) {
+        sq_norms[i] += params.data_h[p] * params.data_h[p];
+      }
+    }
+    return sq_norms;
+  }
+
+  /** The distance of two rows whose dot product is 0. */
+  value_t absent_distance(value_t q_norm, value_t r_norm) const
+  {
+    switch (params.metric) {
+      case raft::distance::DistanceType::L2Expanded: return q_norm + r_norm;
+      case raft::distance::DistanceType::CosineExpanded: return q_norm == 0 && r_norm == 0 ? 0 : 1;
+      default: return 0;
+    }
+  }
+
   raft::resources handle;
 
   // input data
@@ -845,6 +950,8 @@ const std::vector<SparseDistanceInputs<int, float>> inputs_i32_f = {
 
 typedef SparseDistanceTest<int, float> SparseDistanceTestF;
 TEST_P(SparseDistanceTestF, Result) { compare(); }
+TEST_P(SparseDistanceTestF, SparseOutput) { compare_sparse_output(); }
+TEST_P(SparseDistanceTestF, TopK) { compare_topk(); }
 INSTANTIATE_TEST_CASE_P(SparseDistanceTests,
                         SparseDistanceTestF,
                         ::testing::ValuesIn(inputs_i32_f));
@@ -120,6 +120,32 @@ const std::vector<GramMatrixInputs> inputs_ld_csr =
     {155},
     {0});
 
+// (ld_out) and RBF are supported by the fused CSR kernels
+const std::vector<GramMatrixInputs> inputs_ld_out_csr =
+  raft::util::itertools::product<GramMatrixInputs>(
+    {42},
+    {137},
+    {2},
+    {true, false},
+    {SparseType::CSR, SparseType::MIX},
+    {KernelParams{KernelType::LINEAR},
+     KernelParams{KernelType::POLYNOMIAL, 2, 0.5, 2.4},
+     KernelParams{KernelType::TANH, 0, 0.5, 2.4},
+     KernelParams{KernelType::RBF, 0, 0.5}},
+    {0},
+    {0},
+    {150});
+
+// more nonzeros per row than threads per block of the fused CSR kernels; the small gain keeps
+// the rounding errors of the long inner products within the tolerance
+const std::vector<GramMatrixInputs> inputs_wide_csr =
+  raft::util::itertools::product<GramMatrixInputs>({42},
+                                                   {137},
+                                                   {300},
+                                                   {true, false},
+                                                   {SparseType::CSR, SparseType::MIX},
+                                                   {KernelParams{KernelType::TANH, 0, 0.01, 0.1}});
+
 template <typename math_t>
 class GramMatrixTest : public ::testing::TestWithParam<GramMatrixInputs> {
  protected:
@@ -315,14 +341,24 @@ class GramMatrixTest : public ::testing::TestWithParam<GramMatrixInputs> {
 typedef GramMatrixTest<float> GramMatrixTestFloatStandard;
 typedef GramMatrixTest<float> GramMatrixTestFloatLd;
 typedef GramMatrixTest<float> GramMatrixTestFloatLdCsr;
+typedef GramMatrixTest<float> GramMatrixTestFloatLdOutCsr;
+typedef GramMatrixTest<float> GramMatrixTestFloatWideCsr;
 
 TEST_P(GramMatrixTestFloatStandard, Gram) { runTest(); }
 TEST_P(GramMatrixTestFloatLd, Gram) { runTest(); }
 TEST_P(GramMatrixTestFloatLdCsr, Gram) { runTest(); }
+TEST_P(GramMatrixTestFloatLdOutCsr, Gram) { runTest(); }
+TEST_P(GramMatrixTestFloatWideCsr, Gram) { runTest(); }
 
 INSTANTIATE_TEST_SUITE_P(GramMatrixTests, GramMatrixTestFloatStandard, ::testing::ValuesIn(inputs));
 INSTANTIATE_TEST_SUITE_P(GramMatrixTests, GramMatrixTestFloatLd, ::testing::ValuesIn(inputs_ld));
 INSTANTIATE_TEST_SUITE_P(GramMatrixTests,
                          GramMatrixTestFloatLdCsr,
                          ::testing::ValuesIn(inputs_ld_csr));
+INSTANTIATE_TEST_SUITE_P(GramMatrixTests,
+                         GramMatrixTestFloatLdOutCsr,
+                         ::testing::ValuesIn(inputs_ld_out_csr));
+INSTANTIATE_TEST_SUITE_P(GramMatrixTests,
+                         GramMatrixTestFloatWideCsr,
+                         ::testing::ValuesIn(inputs_wide_csr));
 };  // end namespace raft::distance::kernels
@@ -25,6 +25,7 @@
 
 #include <raft/core/resources.hpp>
 #include <raft/sparse/mst/mst.cuh>
+#include <raft/sparse/solver/mst.cuh>
 #include <raft/util/cudart_utils.hpp>
 
 #include <rmm/device_buffer.hpp>
@@ -384,6 +385,65 @@ TEST_P(MSTTestSequential, Sequential)
   ASSERT_TRUE(raft::match(prims_result, non_symmetric_sum, raft::CompareApprox<float>(0.1)));
 }
 
+// the change of the weight of the undirected edge (a, b), a < b, for the warm-start tests
+inline float warm_start_delta(int a, int b) { return ((a * 7 + b * 3) % 5 - 2) * 0.75f; }
+
+TEST_P(MSTTestSequential, Contracted)
+{
+  auto stream    = resource::get_cuda_stream(handle);
+  auto& csr_h    = mst_input.csr_h;
+  int* offsets   = static_cast<int*>(csr_d.offsets.data());
+  int* indices   = static_cast<int*>(csr_d.indices.data());
+  float* weights = static_cast<float*>(csr_d.weights.data());
+  v              = csr_h.offsets.size() - 1;
+  e              = csr_h.indices.size();
+  rmm::device_uvector<int> color(v, stream);
+
+  auto symmetric_result = raft::sparse::solver::mst_contracted(
+    handle, offsets, indices, weights, v, e, color.data(), true);
+  auto non_symmetric_result = raft::sparse::solver::mst_contracted(
+    handle, offsets, indices, weights, v, e, color.data(), false);
+  ASSERT_EQ(non_symmetric_result.n_edges, v - 1);
+  ASSERT_EQ(symmetric_result.n_edges, 2 * v - 2);
+
+  auto prims_result  = prims(csr_h);
+  auto symmetric_sum = thrust::reduce(thrust::device,
+                                      symmetric_result.weights.data(),
+                                      symmetric_result.weights.data() + symmetric_result.n_edges);
+  auto non_symmetric_sum =
+    thrust::reduce(thrust::device,
+                   non_symmetric_result.weights.data(),
+                   non_symmetric_result.weights.data() + non_symmetric_result.n_edges);
+  ASSERT_TRUE(raft::match(2 * prims_result, symmetric_sum, raft::CompareApprox<float>(0.1)));
+  ASSERT_TRUE(raft::match(prims_result, non_symmetric_sum, raft::CompareApprox<float>(0.1)));
+
+  // some weights increase and some decrease, including the ones of MST edges
+  auto new_csr_h = csr_h;
+  for (int r = 0; r < v; r++) {
+    for (int p = csr_h.offsets[r]; p < csr_h.offsets[r + 1]; p++) {
+      new_csr_h.weights[p] += warm_start_delta(std::min(r, csr_h.indices[p]),
+                                               std::max(r, csr_h.indices[p]));
+    }
+  }
+  rmm::device_uvector<float> new_weights(e, stream);
+  raft::update_device(new_weights.data(), new_csr_h.weights.data(), e, stream);
+  auto updated_result = raft::sparse::solver::mst_warm_start(handle,
+                                                             offsets,
+                                                             indices,
+                                                             weights,
+                                                             new_weights.data(),
+                                                             v,
+                                                             e,
+                                                             non_symmetric_result,
+                                                             color.data(),
+                                                             true);
+  ASSERT_EQ(updated_result.n_edges, 2 * v - 2);
+  auto updated_sum = thrust::reduce(thrust::device,
+                                    updated_result.weights.data(),
+                                    updated_result.weights.data() + updated_result.n_edges);
+  ASSERT_TRUE(raft::match(2 * prims(new_csr_h), updated_sum, raft::CompareApprox<float>(0.1)));
+}
+
 INSTANTIATE_TEST_SUITE_P(MSTTests, MSTTestSequential, ::testing::ValuesIn(csr_in_h));
 
 }  // namespace mst
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <raft/core/resource/cuda_stream.hpp>
+
+#include "../../test_utils.cuh"
+#include <raft/sparse/neighbors/inverted_index.cuh>
+
+#include <raft/util/cudart_utils.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <vector>
+
+namespace raft {
+namespace sparse {
+namespace selection {
+
+struct InvertedIndexInputs {
+  int n_rows;
+  int n_queries;
+  int n_cols;
+  int nnz_per_row;
+  int k;
+  size_t batch_size_query;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const InvertedIndexInputs& p)
+{
+  os << "{n_rows: " << p.n_rows << ", n_queries: " << p.n_queries << ", n_cols: " << p.n_cols
+     << ", nnz_per_row: " << p.nnz_per_row << ", k: " << p.k
+     << ", batch_size_query: " << p.batch_size_query << "}";
+  return os;
+}
+
+/** Random CSR matrix with `nnz_per_row` distinct columns per row and positive values. */
+void make_csr(std::mt19937& gen,
+              int n_rows,
+              int n_cols,
+              int nnz_per_row,
+              std::vector<int>& indptr,
+              std::vector<int>& indices,
+              std::vector<float>& data)
+{
+  std::uniform_int_distribution<int> col_dist(0, n_cols - 1);
+  std::uniform_real_distribution<float> val_dist(0.1f, 1.0f);
+  indptr = {0};
+  indices.clear();
+  data.clear();
+  for (int i = 0; i < n_rows; i++) {
+    std::vector<int> cols;
+    while (int(cols.size()) < nnz_per_row) {
+      int c = col_dist(gen);
+      if (std::find(cols.begin(), cols.end(), c) == cols.end()) { cols.push_back(c); }
+    }
+    std::sort(cols.begin(), cols.end());
+    for (int c : cols) {
+      indices.push_back(c);
+      data.push_back(val_dist(gen));
+    }
+    indptr.push_back(indices.size());
+  }
+}
+
+class InvertedIndexTest : public ::testing::TestWithParam<InvertedIndexInputs> {
+ public:
+  InvertedIndexTest() : params(::testing::TestWithParam<InvertedIndexInputs>::GetParam()) {}
+
+ protected:
+  void run()
+  {
+    auto stream = resource::get_cuda_stream(handle);
+    std::mt19937 gen(42);
+    std::vector<int> indptr_h, indices_h, q_indptr_h, q_indices_h;
+    std::vector<float> data_h, q_data_h;
+    make_csr(gen, params.n_rows, params.n_cols, params.nnz_per_row, indptr_h, indices_h, data_h);
+    make_csr(
+      gen, params.n_queries, params.n_cols, params.nnz_per_row, q_indptr_h, q_indices_h, q_data_h);
+
+    auto to_device = [stream](const auto& h) {
+      rmm::device_uvector<typename std::decay_t<decltype(h)>::value_type> d(h.size(), stream);
+      update_device(d.data(), h.data(), h.size(), stream);
+      return d;
+    };
+    auto indptr    = to_device(indptr_h);
+    auto indices   = to_device(indices_h);
+    auto data      = to_device(data_h);
+    auto q_indptr  = to_device(q_indptr_h);
+    auto q_indices = to_device(q_indices_h);
+    auto q_data    = to_device(q_data_h);
+
+    int k = params.k;
+    rmm::device_uvector<int> out_indices(size_t(params.n_queries) * k, stream);
+    rmm::device_uvector<float> out_dists(size_t(params.n_queries) * k, stream);
+
+    auto idx = raft::sparse::neighbors::inverted_index::build(handle,
+                                                               indptr.data(),
+                                                               indices.data(),
+                                                               data.data(),
+                                                               int(indices_h.size()),
+                                                               params.n_rows,
+                                                               params.n_cols);
+    raft::sparse::neighbors::inverted_index::search(handle,
+                                                    idx,
+                                                    q_indptr.data(),
+                                                    q_indices.data(),
+                                                    q_data.data(),
+                                                    params.n_queries,
+                                                    out_indices.data(),
+                                                    out_dists.data(),
+                                                    k,
+                                                    params.batch_size_query);
+
+    std::vector<int> out_indices_h(out_indices.size());
+    std::vector<float> out_dists_h(out_dists.size());
+    update_host(out_indices_h.data(), out_indices.data(), out_indices.size(), stream);
+    update_host(out_dists_h.data(), out_dists.data(), out_dists.size(), stream);
+    resource::sync_stream(handle, stream);
+
+    // dense host reference of the inner products
+    std::vector<float> dense(size_t(params.n_rows) * params.n_cols, 0.0f);
+    for (int i = 0; i < params.n_rows; i++) {
+      for (int j = indptr_h[i]; j < indptr_h[i + 1]; j++) {
+        dense[size_t(i) * params.n_cols + indices_h[j]] = data_h[j];
+      }
+    }
+    for (int q = 0; q < params.n_queries; q++) {
+      std::vector<float> scores(params.n_rows, 0.0f);
+      for (int i = 0; i < params.n_rows; i++) {
+        for (int j = q_indptr_h[q]; j < q_indptr_h[q + 1]; j++) {
+          scores[i] += q_data_h[j] * dense[size_t(i) * params.n_cols + q_indices_h[j]];
+        }
+      }
+      std::vector<float> sorted = scores;
+      std::sort(sorted.begin(), sorted.end(), std::greater<float>());
+      for (int l = 0; l < k; l++) {
+        // ties make the indices ambiguous: check the scores of the returned rows instead
+        float d = out_dists_h[size_t(q) * k + l];
+        ASSERT_NEAR(d, sorted[l], 1e-4) << "query " << q << ", neighbor " << l;
+        ASSERT_NEAR(scores[out_indices_h[size_t(q) * k + l]], d, 1e-4);
+      }
+    }
+  }
+
+  raft::resources handle;
+  InvertedIndexInputs params;
+};
+
+const std::vector<InvertedIndexInputs> inputs = {{1000, 100, 300, 10, 10, 0},
+                                                 {1000, 100, 300, 10, 10, 16},
+                                                 {500, 37, 2000, 30, 32, 7},
+                                                 {64, 10, 50, 5, 64, 0}};
+
+TEST_P(InvertedIndexTest, Result) { run(); }
+INSTANTIATE_TEST_CASE_P(InvertedIndexTest, InvertedIndexTest, ::testing::ValuesIn(inputs));
+
+};  // end namespace selection
+};  // end namespace sparse
+};  // end namespace raft
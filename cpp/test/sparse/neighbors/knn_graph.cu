@@ -23,8 +23,12 @@
 
 #include <raft/sparse/coo.hpp>
 #include <raft/sparse/neighbors/knn_graph.cuh>
+#include <raft/sparse/neighbors/knn_graph_batched.cuh>
 
+#include <algorithm>
 #include <iostream>
+#include <random>
+#include <vector>
 
 namespace raft {
 namespace sparse {
@@ -123,5 +127,85 @@ INSTANTIATE_TEST_CASE_P(KNNGraphTest,
                         KNNGraphTestF_int,
                         ::testing::ValuesIn(knn_graph_inputs_fint));
 
+struct KNNGraphBatchedInputs {
+  int64_t m;
+  int64_t dim;
+  int k;
+  int64_t batch_size;
+  unsigned long long seed;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const KNNGraphBatchedInputs& p)
+{
+  os << "{m: " << p.m << ", dim: " << p.dim << ", k: " << p.k << ", batch_size: " << p.batch_size
+     << "}";
+  return os;
+}
+
+class KNNGraphBatchedTest : public ::testing::TestWithParam<KNNGraphBatchedInputs> {
+ protected:
+  raft::resources handle;
+};
+
+// every neighbor of the host graph is checked against the distances recomputed on the host
+TEST_P(KNNGraphBatchedTest, Result)
+{
+  auto p      = GetParam();
+  auto stream = resource::get_cuda_stream(handle);
+  std::mt19937 gen(p.seed);
+  std::uniform_real_distribution<float> dist(-1, 1);
+  std::vector<float> X_h(p.m * p.dim);
+  for (auto& v : X_h) {
+    v = dist(gen);
+  }
+  rmm::device_uvector<float> X(X_h.size(), stream);
+  raft::update_device(X.data(), X_h.data(), X_h.size(), stream);
+
+  auto index = raft::neighbors::brute_force::build(
+    handle, raft::make_device_matrix_view<const float, int64_t>(X.data(), p.m, p.dim));
+
+  std::vector<int64_t> indptr(p.m + 1);
+  std::vector<int> indices(p.m * p.k);
+  std::vector<float> distances(p.m * p.k);
+  auto structure = raft::make_host_compressed_structure_view<int64_t, int, int64_t>(
+    indptr.data(), indices.data(), p.m, int(p.m), p.m * p.k);
+  raft::sparse::neighbors::knn_graph_batched(
+    handle,
+    raft::make_host_matrix_view<const float, int64_t>(X_h.data(), p.m, p.dim),
+    p.k,
+    raft::sparse::neighbors::brute_force_neighbors<float>{index},
+    raft::make_host_csr_matrix_view(distances.data(), structure),
+    p.batch_size);
+
+  for (int64_t i = 0; i < p.m; i++) {
+    ASSERT_EQ(indptr[i], i * p.k);
+    std::vector<float> all(p.m);
+    for (int64_t j = 0; j < p.m; j++) {
+      float d = 0;
+      for (int64_t c = 0; c < p.dim; c++) {
+        float diff = X_h[i * p.dim + c] - X_h[j * p.dim + c];
+        d += diff * diff;
+      }
+      all[j] = d;
+    }
+    std::vector<float> sorted(all);
+    std::sort(sorted.begin(), sorted.end());
+    for (int l = 0; l < p.k; l++) {
+      int j = indices[i * p.k + l];
+      ASSERT_TRUE(j >= 0 && j < p.m);
+      ASSERT_NEAR(distances[i * p.k + l], all[j], 1e-4);
+      ASSERT_NEAR(distances[i * p.k + l], sorted[l], 1e-4);
+    }
+  }
+  ASSERT_EQ(indptr[p.m], p.m * p.k);
+}
+
+const std::vector<KNNGraphBatchedInputs> knn_graph_batched_inputs = {
+  {300, 8, 5, 64, 1234ULL}, {300, 8, 5, 1000, 1234ULL}, {129, 3, 16, 1, 1234ULL}};
+
+INSTANTIATE_TEST_CASE_P(KNNGraphBatchedTest,
+                        KNNGraphBatchedTest,
+                        ::testing::ValuesIn(knn_graph_batched_inputs));
+
 }  // namespace sparse
 }  // namespace raft
@@ -24,8 +24,12 @@
 #include <raft/sparse/linalg/norm.cuh>
 #include <raft/util/cudart_utils.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <limits>
+#include <random>
+#include <vector>
 
 namespace raft {
 namespace sparse {
@@ -117,5 +121,133 @@ const std::vector<CSRRowNormInputs<double, int>> csrnorm_inputs_d = {
 INSTANTIATE_TEST_CASE_P(SparseNormTest, CSRRowNormTestF, ::testing::ValuesIn(csrnorm_inputs_f));
 INSTANTIATE_TEST_CASE_P(SparseNormTest, CSRRowNormTestD, ::testing::ValuesIn(csrnorm_inputs_d));
 
+struct CSRRowScaleInputs {
+  int n_rows;
+  int n_cols;
+  // the length of the row i is max_row_len / (i + 1), with a few rows longer than a warp can take
+  int max_row_len;
+  unsigned long long seed;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const CSRRowScaleInputs& p)
+{
+  os << "{" << p.n_rows << "x" << p.n_cols << ", max_row_len: " << p.max_row_len << "}";
+  return os;
+}
+
+/** The TF-IDF transform of a matrix of counts with power-law row lengths, and its row stats. */
+class CSRRowScaleTest : public ::testing::TestWithParam<CSRRowScaleInputs> {
+ protected:
+  void SetUp() override
+  {
+    p = GetParam();
+    std::mt19937 gen(p.seed);
+    std::uniform_int_distribution<int> count(0, 4);
+    std::vector<int> cols(p.n_cols);
+    for (int i = 0; i < p.n_cols; i++) {
+      cols[i] = i;
+    }
+    for (int i = 0; i < p.n_rows; i++) {
+      indptr_h.push_back(indices_h.size());
+      int len = std::min(p.n_cols, p.max_row_len / (i + 1));
+      std::shuffle(cols.begin(), cols.end(), gen);
+      std::sort(cols.begin(), cols.begin() + len);
+      for (int q = 0; q < len; q++) {
+        indices_h.push_back(cols[q]);
+        // some explicit zeros, and a negative value to tell the norms apart
+        data_h.push_back(q == 0 ? -2.0f : float(count(gen)));
+      }
+    }
+  }
+
+  raft::resources handle;
+  CSRRowScaleInputs p;
+  std::vector<int> indptr_h, indices_h;
+  std::vector<float> data_h;
+};
+
+TEST_P(CSRRowScaleTest, Result)
+{
+  auto stream = resource::get_cuda_stream(handle);
+  int n       = p.n_rows;
+  int nnz     = indices_h.size();
+  rmm::device_uvector<int> indptr(n, stream), indices(nnz, stream), row_nnz(n, stream);
+  rmm::device_uvector<float> data(nnz, stream), idf(p.n_cols, stream), tfidf(nnz, stream);
+  rmm::device_uvector<float> sum(n, stream), l1(n, stream), l2(n, stream), linf(n, stream);
+  raft::update_device(indptr.data(), indptr_h.data(), n, stream);
+  raft::update_device(indices.data(), indices_h.data(), nnz, stream);
+  raft::update_device(data.data(), data_h.data(), nnz, stream);
+
+  linalg::csr_row_stats(handle,
+                        indptr.data(),
+                        data.data(),
+                        nnz,
+                        n,
+                        row_nnz.data(),
+                        sum.data(),
+                        l1.data(),
+                        l2.data(),
+                        linf.data());
+  linalg::csr_idf(handle, indices.data(), nnz, n, p.n_cols, idf.data());
+  linalg::csr_row_scale(handle,
+                        indptr.data(),
+                        indices.data(),
+                        data.data(),
+                        nnz,
+                        n,
+                        idf.data(),
+                        raft::linalg::NormType::L2Norm,
+                        tfidf.data());
+
+  // host reference
+  std::vector<int> row_nnz_ref(n);
+  std::vector<float> sum_ref(n), l1_ref(n), l2_ref(n), linf_ref(n), tfidf_ref(nnz);
+  std::vector<int> df(p.n_cols, 0);
+  for (int c : indices_h) {
+    df[c]++;
+  }
+  std::vector<float> idf_ref(p.n_cols);
+  for (int j = 0; j < p.n_cols; j++) {
+    idf_ref[j] = std::log(float(1 + n) / float(1 + df[j])) + 1.0f;
+  }
+  for (int i = 0; i < n; i++) {
+    int start = indptr_h[i];
+    int stop  = i + 1 < n ? indptr_h[i + 1] : nnz;
+
+    double s = 0, a = 0, sq = 0, mx = 0, wsq = 0;
+    for (int q = start; q < stop; q++) {
+      double v = data_h[q];
+      s += v;
+      a += std::abs(v);
+      sq += v * v;
+      mx = std::max(mx, std::abs(v));
+      double w = v * idf_ref[indices_h[q]];
+      wsq += w * w;
+    }
+    row_nnz_ref[i] = stop - start;
+    sum_ref[i]     = s;
+    l1_ref[i]      = a;
+    l2_ref[i]      = std::sqrt(sq);
+    linf_ref[i]    = mx;
+    for (int q = start; q < stop; q++) {
+      tfidf_ref[q] = wsq > 0 ? data_h[q] * idf_ref[indices_h[q]] / std::sqrt(wsq) : 0.0;
+    }
+  }
+
+  auto within = raft::CompareApprox<float>(1e-4);
+  ASSERT_TRUE(devArrMatchHost(row_nnz_ref.data(), row_nnz.data(), n, raft::Compare<int>(), stream));
+  ASSERT_TRUE(devArrMatchHost(sum_ref.data(), sum.data(), n, within, stream));
+  ASSERT_TRUE(devArrMatchHost(l1_ref.data(), l1.data(), n, within, stream));
+  ASSERT_TRUE(devArrMatchHost(l2_ref.data(), l2.data(), n, within, stream));
+  ASSERT_TRUE(devArrMatchHost(linf_ref.data(), linf.data(), n, within, stream));
+  ASSERT_TRUE(devArrMatchHost(idf_ref.data(), idf.data(), p.n_cols, within, stream));
+  ASSERT_TRUE(devArrMatchHost(tfidf_ref.data(), tfidf.data(), nnz, within, stream));
+}
+
+const std::vector<CSRRowScaleInputs> csr_row_scale_inputs = {
+  {1, 10, 5, 1234ULL}, {50, 100, 100, 1234ULL}, {300, 5000, 4000, 1234ULL}};
+
+INSTANTIATE_TEST_CASE_P(SparseNormTest, CSRRowScaleTest, ::testing::ValuesIn(csr_row_scale_inputs));
+
 }  // namespace sparse
 }  // namespace raft
@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/sparse/op/reorder.cuh>
+#include <raft/util/cudart_utils.hpp>
+#include <rmm/device_uvector.hpp>
+
+#include "../test_utils.cuh"
+
+#include <algorithm>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace raft {
+namespace sparse {
+
+struct ReorderInputs {
+  int grid_rows;
+  int grid_cols;
+  int n_isolated;
+  unsigned long long seed;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const ReorderInputs& p)
+{
+  os << "{grid: " << p.grid_rows << "x" << p.grid_cols << ", isolated: " << p.n_isolated << "}";
+  return os;
+}
+
+/**
+ * The matrix is the adjacency matrix of a 2D grid, with a few isolated vertices, whose vertices
+ * are shuffled: the RCM ordering should bring its bandwidth back to the order of the grid width.
+ */
+class ReorderTest : public ::testing::TestWithParam<ReorderInputs> {
+ protected:
+  void SetUp() override
+  {
+    p     = GetParam();
+    n     = p.grid_rows * p.grid_cols + p.n_isolated;
+    label = std::vector<int>(n);
+    std::iota(label.begin(), label.end(), 0);
+    std::shuffle(label.begin(), label.end(), std::mt19937(p.seed));
+
+    std::vector<std::vector<int>> adj(n);
+    for (int r = 0; r < p.grid_rows; r++) {
+      for (int c = 0; c < p.grid_cols; c++) {
+        int v = label[r * p.grid_cols + c];
+        if (r > 0) { adj[v].push_back(label[(r - 1) * p.grid_cols + c]); }
+        if (r + 1 < p.grid_rows) { adj[v].push_back(label[(r + 1) * p.grid_cols + c]); }
+        if (c > 0) { adj[v].push_back(label[r * p.grid_cols + c - 1]); }
+        if (c + 1 < p.grid_cols) { adj[v].push_back(label[r * p.grid_cols + c + 1]); }
+      }
+    }
+    indptr_h.assign(1, 0);
+    for (auto& row : adj) {
+      std::sort(row.begin(), row.end());
+      for (int j : row) {
+        indices_h.push_back(j);
+        data_h.push_back(float(j + 1) / indptr_h.size());
+      }
+      indptr_h.push_back(indices_h.size());
+    }
+  }
+
+  int bandwidth(const std::vector<int>& iperm) const
+  {
+    int b = 0;
+    for (int i = 0; i < n; i++) {
+      for (int q = indptr_h[i]; q < indptr_h[i + 1]; q++) {
+        b = std::max(b, std::abs(iperm[i] - iperm[indices_h[q]]));
+      }
+    }
+    return b;
+  }
+
+  raft::resources handle;
+  ReorderInputs p;
+  int n;
+  std::vector<int> label, indptr_h, indices_h;
+  std::vector<float> data_h;
+};
+
+TEST_P(ReorderTest, Result)
+{
+  auto stream = resource::get_cuda_stream(handle);
+  int nnz     = indices_h.size();
+  rmm::device_uvector<int> indptr(n + 1, stream);
+  rmm::device_uvector<int> indices(nnz, stream);
+  rmm::device_uvector<float> data(nnz, stream);
+  rmm::device_uvector<int> perm(n, stream);
+  raft::update_device(indptr.data(), indptr_h.data(), n + 1, stream);
+  raft::update_device(indices.data(), indices_h.data(), nnz, stream);
+  raft::update_device(data.data(), data_h.data(), nnz, stream);
+
+  auto structure =
+    raft::make_device_compressed_structure_view(indptr.data(), indices.data(), n, n, nnz);
+  auto A = raft::make_device_csr_matrix_view<const float>(data.data(), structure);
+  raft::sparse::op::reverse_cuthill_mckee(
+    handle, A, raft::make_device_vector_view<int, int>(perm.data(), n));
+
+  auto out = raft::make_device_csr_matrix<float, int, int, int>(handle, n, n);
+  raft::sparse::op::csr_symmetric_permute(
+    handle, A, raft::make_device_vector_view<const int, int>(perm.data(), n), out);
+
+  std::vector<int> perm_h(n), out_indptr_h(n + 1), out_indices_h(nnz);
+  std::vector<float> out_data_h(nnz);
+  auto out_structure = out.structure_view();
+  ASSERT_EQ(out_structure.get_nnz(), nnz);
+  raft::update_host(perm_h.data(), perm.data(), n, stream);
+  raft::update_host(out_indptr_h.data(), out_structure.get_indptr().data(), n + 1, stream);
+  raft::update_host(out_indices_h.data(), out_structure.get_indices().data(), nnz, stream);
+  raft::update_host(out_data_h.data(), out.get_elements().data(), nnz, stream);
+  resource::sync_stream(handle, stream);
+
+  // perm is a permutation
+  std::vector<int> iperm(n, -1);
+  for (int i = 0; i < n; i++) {
+    ASSERT_TRUE(perm_h[i] >= 0 && perm_h[i] < n);
+    ASSERT_EQ(iperm[perm_h[i]], -1);
+    iperm[perm_h[i]] = i;
+  }
+
+  // RCM orders the grid by anti-diagonals, whose length is bounded by the grid width
+  std::vector<int> shuffled(n);
+  std::iota(shuffled.begin(), shuffled.end(), 0);
+  int width = std::min(p.grid_rows, p.grid_cols);
+  ASSERT_LE(bandwidth(iperm), 2 * width);
+  if (p.grid_rows * p.grid_cols > 4 * width) { ASSERT_LT(bandwidth(iperm), bandwidth(shuffled)); }
+
+  // B[i, j] = A[perm[i], perm[j]], with sorted columns
+  for (int i = 0; i < n; i++) {
+    int src = perm_h[i];
+    ASSERT_EQ(out_indptr_h[i + 1] - out_indptr_h[i], indptr_h[src + 1] - indptr_h[src]);
+    for (int q = out_indptr_h[i]; q < out_indptr_h[i + 1]; q++) {
+      if (q > out_indptr_h[i]) { ASSERT_LT(out_indices_h[q - 1], out_indices_h[q]); }
+      int col = perm_h[out_indices_h[q]];
+      auto it = std::lower_bound(
+        indices_h.begin() + indptr_h[src], indices_h.begin() + indptr_h[src + 1], col);
+      ASSERT_TRUE(it != indices_h.begin() + indptr_h[src + 1] && *it == col);
+      ASSERT_EQ(out_data_h[q], data_h[it - indices_h.begin()]);
+    }
+  }
+}
+
+const std::vector<ReorderInputs> reorder_inputs = {
+  {1, 1, 0, 1234ULL}, {1, 50, 3, 1234ULL}, {8, 40, 0, 1234ULL}, {30, 30, 10, 1234ULL}};
+
+INSTANTIATE_TEST_CASE_P(ReorderTests, ReorderTest, ::testing::ValuesIn(reorder_inputs));
+
+}  // namespace sparse
+}  // namespace raft
@@ -21,7 +21,13 @@
 #include <raft/core/resource/device_id.hpp>
 #include <raft/core/resources.hpp>
 
+#include <raft/sparse/linalg/sparse_operator.hpp>
 #include <raft/spectral/matrix_wrappers.hpp>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <vector>
 
 namespace raft {
 namespace spectral {
@@ -78,6 +84,66 @@ TEST(Raft, SpectralMatrices)
   EXPECT_ANY_THROW(cnstr_mm2());  // because of nullptr ptr args
 }
 
+// the cached cuSPARSE state must follow the data pointers of every product
+TEST(Raft, SparseOperatorReuse)
+{
+  using index_type = int;
+  using value_type = float;
+
+  raft::resources h;
+  auto stream = resource::get_cuda_stream(h);
+
+  // 3 x 3 matrix [[1, 0, 2], [0, 3, 0], [4, 0, 5]]
+  std::vector<index_type> ro_h{0, 2, 3, 5};
+  std::vector<index_type> ci_h{0, 2, 1, 0, 2};
+  std::vector<value_type> vs_h{1, 2, 3, 4, 5};
+  std::vector<value_type> x_h{1, 2, 3, 4, 5, 6};
+  std::vector<value_type> ref_h{7, 6, 19, 16, 15, 46};
+  index_type n   = 3;
+  index_type nnz = vs_h.size();
+
+  rmm::device_uvector<index_type> ro(ro_h.size(), stream);
+  rmm::device_uvector<index_type> ci(ci_h.size(), stream);
+  rmm::device_uvector<value_type> vs(vs_h.size(), stream);
+  rmm::device_uvector<value_type> x(x_h.size(), stream);
+  rmm::device_uvector<value_type> y(x_h.size(), stream);
+  raft::update_device(ro.data(), ro_h.data(), ro_h.size(), stream);
+  raft::update_device(ci.data(), ci_h.data(), ci_h.size(), stream);
+  raft::update_device(vs.data(), vs_h.data(), vs_h.size(), stream);
+  raft::update_device(x.data(), x_h.data(), x_h.size(), stream);
+
+  sparse_matrix_t<index_type, value_type> sm{h, ro.data(), ci.data(), vs.data(), n, nnz};
+  // the same shape twice, with other vectors: only the dense pointers change
+  for (index_type j = 0; j < 2; j++) {
+    sm.mv(1, x.data() + j * n, 0, y.data() + j * n);
+  }
+  std::vector<value_type> y_h(y.size());
+  raft::update_host(y_h.data(), y.data(), y.size(), stream);
+  resource::sync_stream(h, stream);
+  EXPECT_EQ(ref_h, y_h);
+
+  auto structure = raft::make_device_compressed_structure_view(ro.data(), ci.data(), n, n, nnz);
+  auto csr       = raft::make_device_csr_matrix_view<const value_type>(vs.data(), structure);
+  raft::sparse::linalg::sparse_operator<value_type, index_type, index_type> op(h, csr, true);
+  value_type alpha = 1;
+  value_type beta  = 0;
+  for (index_type k = 1; k <= 2; k++) {
+    RAFT_CUDA_TRY(cudaMemsetAsync(y.data(), 0, y.size() * sizeof(value_type), stream));
+    op.spmm(false,
+            false,
+            &alpha,
+            raft::make_device_matrix_view<const value_type, index_type, raft::col_major>(
+              x.data(), n, k),
+            &beta,
+            raft::make_device_matrix_view<value_type, index_type, raft::col_major>(y.data(), n, k));
+    raft::update_host(y_h.data(), y.data(), y.size(), stream);
+    resource::sync_stream(h, stream);
+    for (index_type i = 0; i < n * k; i++) {
+      EXPECT_EQ(ref_h[i], y_h[i]);
+    }
+  }
+}
+
 }  // namespace matrix
 }  // namespace spectral
 }  // namespace raft
@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "../test_utils.cuh"
+
+#include <raft/core/device_csr_matrix.hpp>
+#include <raft/core/device_mdspan.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/sparse/linalg/sparse_operator.hpp>
+#include <raft/sparse/linalg/spmm.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <rmm/device_uvector.hpp>
+
+#include <cuda_fp16.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace raft {
+namespace sparse {
+
+struct SpmmMixedInputs {
+  int n_rows;
+  int n_cols;
+  int n_dense_cols;
+  float density;
+  bool row_major;
+};
+
+template <typename T>
+T from_int(int v)
+{
+  if constexpr (std::is_same_v<T, half>) {
+    return __float2half(static_cast<float>(v));
+  } else {
+    return static_cast<T>(v);
+  }
+}
+
+/**
+ * The half and int8 products with fp32 (int32) accumulation; the small integer values are exact
+ * in every type, so the products must match the reference exactly.
+ */
+template <typename ValueT, typename OutT>
+class SpmmMixedTest : public ::testing::TestWithParam<SpmmMixedInputs> {
+ public:
+  using compute_t = raft::sparse::detail::spmm_compute_t<ValueT, OutT>;
+
+  SpmmMixedTest()
+    : params(::testing::TestWithParam<SpmmMixedInputs>::GetParam()),
+      stream(resource::get_cuda_stream(handle))
+  {
+  }
+
+ protected:
+  void Run()
+  {
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> keep(0, 1);
+    std::uniform_int_distribution<int> value(-3, 3);
+
+    std::vector<int> indptr_h{0};
+    std::vector<int> indices_h;
+    std::vector<int> x_h;
+    for (int i = 0; i < params.n_rows; i++) {
+      for (int j = 0; j < params.n_cols; j++) {
+        if (keep(gen) < params.density) {
+          indices_h.push_back(j);
+          x_h.push_back(value(gen));
+        }
+      }
+      indptr_h.push_back(indices_h.size());
+    }
+    const int nnz = indices_h.size();
+    std::vector<int> y_h(params.n_cols * params.n_dense_cols);
+    for (auto& v : y_h) {
+      v = value(gen);
+    }
+
+    // Reference Z = X * Y, with Y and Z in the layout of the test
+    auto at = [this](int r, int c, int n_r, int n_c) {
+      return params.row_major ? r * n_c + c : c * n_r + r;
+    };
+    std::vector<compute_t> z_ref(params.n_rows * params.n_dense_cols, 0);
+    for (int i = 0; i < params.n_rows; i++) {
+      for (int p = indptr_h[i]; p < indptr_h[i + 1]; p++) {
+        for (int c = 0; c < params.n_dense_cols; c++) {
+          z_ref[at(i, c, params.n_rows, params.n_dense_cols)] +=
+            x_h[p] * y_h[at(indices_h[p], c, params.n_cols, params.n_dense_cols)];
+        }
+      }
+    }
+
+    std::vector<ValueT> x_vals(nnz);
+    std::vector<ValueT> y_vals(y_h.size());
+    for (int p = 0; p < nnz; p++) {
+      x_vals[p] = from_int<ValueT>(x_h[p]);
+    }
+    for (size_t p = 0; p < y_h.size(); p++) {
+      y_vals[p] = from_int<ValueT>(y_h[p]);
+    }
+
+    rmm::device_uvector<int> indptr(indptr_h.size(), stream);
+    rmm::device_uvector<int> indices(nnz, stream);
+    rmm::device_uvector<ValueT> x(nnz, stream);
+    rmm::device_uvector<ValueT> y(y_vals.size(), stream);
+    rmm::device_uvector<OutT> z(z_ref.size(), stream);
+    raft::update_device(indptr.data(), indptr_h.data(), indptr_h.size(), stream);
+    raft::update_device(indices.data(), indices_h.data(), nnz, stream);
+    raft::update_device(x.data(), x_vals.data(), nnz, stream);
+    raft::update_device(y.data(), y_vals.data(), y_vals.size(), stream);
+    RAFT_CUDA_TRY(cudaMemsetAsync(z.data(), 0, z.size() * sizeof(OutT), stream));
+
+    auto structure  = raft::make_device_compressed_structure_view(
+      indptr.data(), indices.data(), params.n_rows, params.n_cols, nnz);
+    auto x_view     = raft::make_device_csr_matrix_view<const ValueT>(x.data(), structure);
+    compute_t alpha = 1;
+    compute_t beta  = 0;
+    if (params.row_major) {
+      raft::sparse::linalg::spmm(
+        handle,
+        false,
+        false,
+        &alpha,
+        x_view,
+        raft::make_device_matrix_view<const ValueT, int, raft::row_major>(
+          y.data(), params.n_cols, params.n_dense_cols),
+        &beta,
+        raft::make_device_matrix_view<OutT, int, raft::row_major>(
+          z.data(), params.n_rows, params.n_dense_cols));
+    } else {
+      raft::sparse::linalg::spmm(
+        handle,
+        false,
+        false,
+        &alpha,
+        x_view,
+        raft::make_device_matrix_view<const ValueT, int, raft::col_major>(
+          y.data(), params.n_cols, params.n_dense_cols),
+        &beta,
+        raft::make_device_matrix_view<OutT, int, raft::col_major>(
+          z.data(), params.n_rows, params.n_dense_cols));
+    }
+    check(z, z_ref);
+
+    // The first column of the column-major Y through the bound operator
+    if (params.row_major) { return; }
+    raft::sparse::linalg::sparse_operator<ValueT, int, int, OutT> op(handle, x_view);
+    rmm::device_uvector<OutT> z_col(params.n_rows, stream);
+    RAFT_CUDA_TRY(cudaMemsetAsync(z_col.data(), 0, z_col.size() * sizeof(OutT), stream));
+    op.spmv(false,
+            &alpha,
+            raft::make_device_vector_view<const ValueT, int>(y.data(), params.n_cols),
+            &beta,
+            raft::make_device_vector_view<OutT, int>(z_col.data(), params.n_rows));
+    check(z_col, std::vector<compute_t>(z_ref.begin(), z_ref.begin() + params.n_rows));
+  }
+
+  void check(const rmm::device_uvector<OutT>& z, const std::vector<compute_t>& z_ref)
+  {
+    std::vector<OutT> z_h(z.size());
+    raft::update_host(z_h.data(), z.data(), z.size(), stream);
+    resource::sync_stream(handle, stream);
+    for (size_t i = 0; i < z_h.size(); i++) {
+      compute_t actual;
+      if constexpr (std::is_same_v<OutT, half>) {
+        actual = __half2float(z_h[i]);
+      } else {
+        actual = z_h[i];
+      }
+      ASSERT_EQ(z_ref[i], actual) << "at " << i;
+    }
+  }
+
+  raft::resources handle;
+  cudaStream_t stream;
+  SpmmMixedInputs params;
+};
+
+const std::vector<SpmmMixedInputs> spmm_mixed_inputs = {{64, 48, 8, 0.2f, true},
+                                                        {64, 48, 8, 0.2f, false},
+                                                        {100, 300, 17, 0.05f, true},
+                                                        {100, 300, 17, 0.05f, false}};
+
+using SpmmMixedTestHalfHalf = SpmmMixedTest<half, half>;
+TEST_P(SpmmMixedTestHalfHalf, Result) { Run(); }
+INSTANTIATE_TEST_CASE_P(SparseSpmm, SpmmMixedTestHalfHalf, ::testing::ValuesIn(spmm_mixed_inputs));
+
+using SpmmMixedTestHalfFloat = SpmmMixedTest<half, float>;
+TEST_P(SpmmMixedTestHalfFloat, Result) { Run(); }
+INSTANTIATE_TEST_CASE_P(SparseSpmm,
+                        SpmmMixedTestHalfFloat,
+                        ::testing::ValuesIn(spmm_mixed_inputs));
+
+using SpmmMixedTestInt8Float = SpmmMixedTest<int8_t, float>;
+TEST_P(SpmmMixedTestInt8Float, Result) { Run(); }
+INSTANTIATE_TEST_CASE_P(SparseSpmm,
+                        SpmmMixedTestInt8Float,
+                        ::testing::ValuesIn(spmm_mixed_inputs));
+
+}  // namespace sparse
+}  // namespace raft
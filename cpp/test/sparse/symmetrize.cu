@@ -25,7 +25,11 @@
 
 #include "../test_utils.cuh"
 
+#include <algorithm>
 #include <iostream>
+#include <map>
+#include <numeric>
+#include <random>
 
 namespace raft {
 namespace sparse {
@@ -216,5 +220,89 @@ INSTANTIATE_TEST_CASE_P(SparseSymmetrizeTest,
                         SparseSymmetrizeTestF_int,
                         ::testing::ValuesIn(symm_inputs_fint));
 
+struct KNNSymmetrizeCSRInputs {
+  int n;
+  int k;
+  unsigned long long seed;
+};
+
+::std::ostream& operator<<(::std::ostream& os, const KNNSymmetrizeCSRInputs& p)
+{
+  os << "{n: " << p.n << ", k: " << p.k << "}";
+  return os;
+}
+
+class KNNSymmetrizeCSRTest : public ::testing::TestWithParam<KNNSymmetrizeCSRInputs> {
+ protected:
+  raft::resources handle;
+};
+
+// compares the rows of the CSR output with a host symmetrization of the same kNN graph
+TEST_P(KNNSymmetrizeCSRTest, Result)
+{
+  auto p      = GetParam();
+  auto stream = resource::get_cuda_stream(handle);
+  std::mt19937 gen(p.seed);
+  std::uniform_real_distribution<float> dist(0, 1);
+
+  std::vector<int> knn_indices_h(size_t(p.n) * p.k);
+  std::vector<float> knn_dists_h(knn_indices_h.size());
+  std::vector<int> perm(p.n);
+  std::map<std::pair<int, int>, float> ref;
+  for (int i = 0; i < p.n; i++) {
+    std::iota(perm.begin(), perm.end(), 0);
+    std::shuffle(perm.begin(), perm.end(), gen);
+    for (int l = 0; l < p.k; l++) {
+      int j   = perm[l];
+      float w = dist(gen);
+
+      knn_indices_h[size_t(i) * p.k + l] = j;
+      knn_dists_h[size_t(i) * p.k + l]   = w;
+      for (auto e : {std::make_pair(i, j), std::make_pair(j, i)}) {
+        auto it = ref.find(e);
+        ref[e]  = it == ref.end() ? w : std::max(it->second, w);
+      }
+    }
+  }
+
+  rmm::device_uvector<int> knn_indices(knn_indices_h.size(), stream);
+  rmm::device_uvector<float> knn_dists(knn_dists_h.size(), stream);
+  raft::update_device(knn_indices.data(), knn_indices_h.data(), knn_indices_h.size(), stream);
+  raft::update_device(knn_dists.data(), knn_dists_h.data(), knn_dists_h.size(), stream);
+
+  auto out = raft::make_device_csr_matrix<float, int, int, int>(handle, p.n, p.n);
+  raft::sparse::linalg::from_knn_symmetrize_csr(
+    handle, knn_indices.data(), knn_dists.data(), p.n, p.k, out);
+
+  auto structure = out.structure_view();
+  int nnz        = structure.get_nnz();
+  ASSERT_EQ(size_t(nnz), ref.size());
+  std::vector<int> indptr_h(p.n + 1), indices_h(nnz);
+  std::vector<float> data_h(nnz);
+  raft::update_host(indptr_h.data(), structure.get_indptr().data(), p.n + 1, stream);
+  raft::update_host(indices_h.data(), structure.get_indices().data(), nnz, stream);
+  raft::update_host(data_h.data(), out.get_elements().data(), nnz, stream);
+  resource::sync_stream(handle, stream);
+
+  for (int i = 0; i < p.n; i++) {
+    for (int q = indptr_h[i]; q < indptr_h[i + 1]; q++) {
+      auto it = ref.find(std::make_pair(i, indices_h[q]));
+      ASSERT_TRUE(it != ref.end());
+      ASSERT_EQ(it->second, data_h[q]);
+    }
+    // no duplicated column in a row
+    std::vector<int> row(indices_h.begin() + indptr_h[i], indices_h.begin() + indptr_h[i + 1]);
+    std::sort(row.begin(), row.end());
+    ASSERT_TRUE(std::adjacent_find(row.begin(), row.end()) == row.end());
+  }
+}
+
+const std::vector<KNNSymmetrizeCSRInputs> knn_symm_csr_inputs = {
+  {1, 1, 1234ULL}, {50, 5, 1234ULL}, {200, 40, 1234ULL}, {100, 100, 1234ULL}};
+
+INSTANTIATE_TEST_CASE_P(KNNSymmetrizeCSRTests,
+                        KNNSymmetrizeCSRTest,
+                        ::testing::ValuesIn(knn_symm_csr_inputs));
+
 }  // namespace sparse
 }  // namespace raft
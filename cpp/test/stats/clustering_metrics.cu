@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2019-2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/stats/adjusted_rand_index.cuh>
+#include <raft/stats/clustering_metrics.cuh>
+#include <raft/stats/completeness_score.cuh>
+#include <raft/stats/homogeneity_score.cuh>
+#include <raft/stats/mutual_info_score.cuh>
+#include <raft/stats/rand_index.cuh>
+#include <raft/stats/v_measure.cuh>
+#include <raft/util/cudart_utils.hpp>
+#include <random>
+
+namespace raft {
+namespace stats {
+
+// parameter structure definition
+struct clusteringMetricsParam {
+  int nElements;
+  int lowerLabelRange;
+  int upperLabelRange;
+  double beta;
+  bool sameArrays;
+  double tolerance;
+};
+
+// test fixture class
+template <typename T>
+class clusteringMetricsTest : public ::testing::TestWithParam<clusteringMetricsParam> {
+ protected:
+  void SetUp() override
+  {
+    params = ::testing::TestWithParam<clusteringMetricsParam>::GetParam();
+
+    int nElements = params.nElements;
+    T lower       = params.lowerLabelRange;
+    T upper       = params.upperLabelRange;
+
+    // generating random value test input
+    std::vector<T> arr1(nElements, 0);
+    std::vector<T> arr2(nElements, 0);
+    std::random_device rd;
+    std::default_random_engine dre(rd());
+    std::uniform_int_distribution<T> intGenerator(lower, upper);
+    std::generate(arr1.begin(), arr1.end(), [&]() { return intGenerator(dre); });
+    if (params.sameArrays) {
+      arr2 = arr1;
+    } else {
+      std::generate(arr2.begin(), arr2.end(), [&]() { return intGenerator(dre); });
+    }
+    // the individual metrics need the label range to be the actual one
+    arr1[0]             = lower;
+    arr2[nElements - 1] = upper;
+
+    stream = resource::get_cuda_stream(handle);
+    rmm::device_uvector<T> truth(nElements, stream);
+    rmm::device_uvector<T> pred(nElements, stream);
+    raft::update_device(truth.data(), arr1.data(), nElements, stream);
+    raft::update_device(pred.data(), arr2.data(), nElements, stream);
+
+    // the golden output: the metrics computed one by one
+    expected.adjusted_rand_index =
+      adjusted_rand_index<T, int>(truth.data(), pred.data(), nElements, stream);
+    expected.rand_index = rand_index(truth.data(), pred.data(), uint64_t(nElements), stream);
+    expected.mutual_info =
+      mutual_info_score(truth.data(), pred.data(), nElements, lower, upper, stream);
+    expected.homogeneity =
+      homogeneity_score(truth.data(), pred.data(), nElements, lower, upper, stream);
+    expected.completeness =
+      completeness_score(truth.data(), pred.data(), nElements, lower, upper, stream);
+    expected.v_measure =
+      v_measure(truth.data(), pred.data(), nElements, lower, upper, stream, params.beta);
+
+    computed = clustering_metrics(handle,
+                                  raft::make_device_vector_view<const T>(truth.data(), nElements),
+                                  raft::make_device_vector_view<const T>(pred.data(), nElements),
+                                  params.beta);
+  }
+
+  raft::resources handle;
+  clusteringMetricsParam params;
+  clustering_metrics_result expected;
+  clustering_metrics_result computed;
+  cudaStream_t stream = 0;
+};
+
+// setting test parameter values; the label ranges of the last ones are too large for a dense
+// contingency matrix
+const std::vector<clusteringMetricsParam> inputs = {{199, 1, 10, 1.0, false, 0.000001},
+                                                    {200, 15, 100, 1.0, false, 0.000001},
+                                                    {100, 1, 20, 0.5, false, 0.000001},
+                                                    {10, 1, 10, 1.0, false, 0.000001},
+                                                    {3000, 1, 100, 2.0, false, 0.000001},
+                                                    {199, 1, 10, 1.0, true, 0.000001},
+                                                    {300, 3, 99, 1.0, true, 0.000001},
+                                                    {2000, 1, 2000, 1.0, false, 0.000001},
+                                                    {2000, 10, 3000, 1.0, true, 0.000001}};
+
+// writing the test suite
+typedef clusteringMetricsTest<int> clusteringMetricsTestClass;
+TEST_P(clusteringMetricsTestClass, Result)
+{
+  ASSERT_NEAR(computed.adjusted_rand_index, expected.adjusted_rand_index, params.tolerance);
+  ASSERT_NEAR(computed.rand_index, expected.rand_index, params.tolerance);
+  ASSERT_NEAR(computed.mutual_info, expected.mutual_info, params.tolerance);
+  ASSERT_NEAR(computed.homogeneity, expected.homogeneity, params.tolerance);
+  ASSERT_NEAR(computed.completeness, expected.completeness, params.tolerance);
+  ASSERT_NEAR(computed.v_measure, expected.v_measure, params.tolerance);
+}
+INSTANTIATE_TEST_CASE_P(clusteringMetrics, clusteringMetricsTestClass, ::testing::ValuesIn(inputs));
+
+}  // end namespace stats
+}  // end namespace raft
@@ -298,6 +298,23 @@ const std::vector<HistInputs> inputs = {
   {oneM + 1, 21, 2 * oneK, true, HistTypeAuto, 1000, 50, 1234ULL},
   {oneM + 2, 21, 2 * oneK, false, HistTypeAuto, 0, 2 * oneK, 1234ULL},
   {oneM + 2, 21, 2 * oneK, true, HistTypeAuto, 1000, 50, 1234ULL},
+
+  {oneM, 1, 2 * oneK, false, HistTypeSmemPerWarp, 0, 2 * oneK, 1234ULL},
+  {oneM, 1, 2 * oneK, true, HistTypeSmemPerWarp, 1000, 2, 1234ULL},
+  {oneM + 1, 1, 2 * oneK, false, HistTypeSmemPerWarp, 0, 2 * oneK, 1234ULL},
+  {oneM + 1, 1, 2 * oneK, true, HistTypeSmemPerWarp, 1000, 50, 1234ULL},
+  {oneM + 2, 21, 2 * oneK, false, HistTypeSmemPerWarp, 0, 2 * oneK, 1234ULL},
+  {oneM + 2, 21, 2 * oneK, true, HistTypeSmemPerWarp, 1000, 2, 1234ULL},
+
+  {oneM, 1, 2 * oneM, false, HistTypeAutoProfiled, 0, 2 * oneM, 1234ULL},
+  {oneM, 1, 2 * oneM, true, HistTypeAutoProfiled, 1000, 50, 1234ULL},
+  {oneM + 1, 1, 2 * oneM, true, HistTypeAutoProfiled, 1000, 2, 1234ULL},
+  {oneM, 1, 2 * oneK, false, HistTypeAutoProfiled, 0, 2 * oneK, 1234ULL},
+  {oneM, 1, 2 * oneK, true, HistTypeAutoProfiled, 1000, 2, 1234ULL},
+  {oneM + 1, 21, 2 * oneM, false, HistTypeAutoProfiled, 0, 2 * oneM, 1234ULL},
+  {oneM + 2, 21, 2 * oneM, true, HistTypeAutoProfiled, 1000, 50, 1234ULL},
+  {oneM + 1, 21, 2 * oneK, false, HistTypeAutoProfiled, 0, 2 * oneK, 1234ULL},
+  {oneM + 2, 21, 2 * oneK, true, HistTypeAutoProfiled, 1000, 2, 1234ULL},
 };
 
 TEST_P(HistTest, Result)
@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+#include <gtest/gtest.h>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/random/rng.cuh>
+#include <raft/stats/moments.cuh>
+#include <raft/util/cudart_utils.hpp>
+
+#include <vector>
+
+namespace raft {
+namespace stats {
+
+template <typename T>
+struct MomentsInputs {
+  T mean, stddev;
+  int rows, cols;
+  int n_batches;
+  bool with_covariance;
+  bool sample;
+  unsigned long long int seed;
+  T tolerance;
+};
+
+template <typename T>
+::std::ostream& operator<<(::std::ostream& os, const MomentsInputs<T>& ps)
+{
+  return os << "rows: " << ps.rows << "; cols: " << ps.cols << "; batches: " << ps.n_batches
+            << "; covariance: " << ps.with_covariance;
+}
+
+template <typename T>
+class MomentsTest : public ::testing::TestWithParam<MomentsInputs<T>> {
+ public:
+  MomentsTest()
+    : params(::testing::TestWithParam<MomentsInputs<T>>::GetParam()),
+      stream(resource::get_cuda_stream(handle)),
+      data(params.rows * params.cols, stream),
+      mean_act(params.cols, stream),
+      vars_act(params.cols, stream),
+      cov_act(params.with_covariance ? params.cols * params.cols : 0, stream),
+      mean_merged(params.cols, stream),
+      vars_merged(params.cols, stream)
+  {
+  }
+
+ protected:
+  void SetUp() override
+  {
+    random::RngState r(params.seed);
+    normal(handle, r, data.data(), params.cols * params.rows, params.mean, params.stddev);
+
+    // the reference moments, in double precision
+    std::vector<T> h_data(data.size());
+    raft::update_host(h_data.data(), data.data(), data.size(), stream);
+    RAFT_CUDA_TRY(cudaStreamSynchronize(stream));
+    double denom = params.sample ? params.rows - 1 : params.rows;
+    mean_ref.assign(params.cols, 0);
+    vars_ref.assign(params.cols, 0);
+    cov_ref.assign(params.with_covariance ? params.cols * params.cols : 0, 0);
+    for (int i = 0; i < params.rows; i++) {
+      for (int j = 0; j < params.cols; j++) {
+        mean_ref[j] += double(h_data[i * params.cols + j]) / params.rows;
+      }
+    }
+    for (int i = 0; i < params.rows; i++) {
+      for (int j = 0; j < params.cols; j++) {
+        double dj = h_data[i * params.cols + j] - mean_ref[j];
+        vars_ref[j] += dj * dj / denom;
+        if (!params.with_covariance) { continue; }
+        for (int l = 0; l < params.cols; l++) {
+          cov_ref[j * params.cols + l] += dj * (h_data[i * params.cols + l] - mean_ref[l]) / denom;
+        }
+      }
+    }
+
+    // the data in uneven blocks of rows, then merged from two accumulators
+    moments<T, int> acc(handle, params.cols, params.with_covariance);
+    moments<T, int> acc_a(handle, params.cols, params.with_covariance);
+    moments<T, int> acc_b(handle, params.cols, params.with_covariance);
+    int first = 0;
+    for (int b = 0; b < params.n_batches; b++) {
+      int last = b + 1 == params.n_batches ? params.rows : first + params.rows / (b + 2);
+      auto batch = raft::make_device_matrix_view<const T, int>(
+        data.data() + first * params.cols, last - first, params.cols);
+      acc.update(handle, batch);
+      (b % 2 == 0 ? acc_a : acc_b).update(handle, batch);
+      first = last;
+    }
+    acc_a.merge(handle, acc_b);
+    ASSERT_EQ(acc.n_rows(), params.rows);
+    ASSERT_EQ(acc_a.n_rows(), params.rows);
+
+    acc.mean(handle, raft::make_device_vector_view<T, int>(mean_act.data(), params.cols));
+    acc.var(
+      handle, raft::make_device_vector_view<T, int>(vars_act.data(), params.cols), params.sample);
+    acc_a.mean(handle, raft::make_device_vector_view<T, int>(mean_merged.data(), params.cols));
+    acc_a.var(handle,
+              raft::make_device_vector_view<T, int>(vars_merged.data(), params.cols),
+              params.sample);
+    if (params.with_covariance) {
+      acc.cov(handle,
+              raft::make_device_matrix_view<T, int>(cov_act.data(), params.cols, params.cols),
+              params.sample);
+    }
+    RAFT_CUDA_TRY(cudaStreamSynchronize(stream));
+  }
+
+  void check(const std::vector<double>& expected, const T* actual, size_t len)
+  {
+    std::vector<T> h_expected(expected.begin(), expected.end());
+    ASSERT_TRUE(devArrMatchHost(
+      h_expected.data(), actual, len, CompareApprox<T>(params.tolerance), stream));
+  }
+
+ protected:
+  raft::resources handle;
+  cudaStream_t stream;
+
+  MomentsInputs<T> params;
+  rmm::device_uvector<T> data, mean_act, vars_act, cov_act, mean_merged, vars_merged;
+  std::vector<double> mean_ref, vars_ref, cov_ref;
+};
+
+// mostly far from the origin, where the naive sums of squares lose their precision in float
+const std::vector<MomentsInputs<float>> inputsf = {
+  {1000.f, 1.f, 1024, 32, 3, true, true, 1234ULL, 1e-3f},
+  {-1.f, 2.f, 5000, 17, 5, true, false, 1234ULL, 1e-3f},
+  {1000.f, 1.f, 20000, 64, 4, false, true, 1234ULL, 1e-3f},
+  {0.f, 1.f, 100, 8, 1, true, true, 1234ULL, 1e-4f}};
+
+const std::vector<MomentsInputs<double>> inputsd = {
+  {1000.0, 1.0, 1024, 32, 3, true, true, 1234ULL, 1e-8},
+  {-1.0, 2.0, 5000, 17, 5, true, false, 1234ULL, 1e-8},
+  {10000.0, 0.5, 20000, 64, 4, false, true, 1234ULL, 1e-8}};
+
+typedef MomentsTest<float> MomentsTestF;
+TEST_P(MomentsTestF, Result)
+{
+  check(mean_ref, mean_act.data(), params.cols);
+  check(vars_ref, vars_act.data(), params.cols);
+  check(mean_ref, mean_merged.data(), params.cols);
+  check(vars_ref, vars_merged.data(), params.cols);
+  if (params.with_covariance) { check(cov_ref, cov_act.data(), cov_ref.size()); }
+}
+
+typedef MomentsTest<double> MomentsTestD;
+TEST_P(MomentsTestD, Result)
+{
+  check(mean_ref, mean_act.data(), params.cols);
+  check(vars_ref, vars_act.data(), params.cols);
+  check(mean_ref, mean_merged.data(), params.cols);
+  check(vars_ref, vars_merged.data(), params.cols);
+  if (params.with_covariance) { check(cov_ref, cov_act.data(), cov_ref.size()); }
+}
+
+INSTANTIATE_TEST_SUITE_P(MomentsTests, MomentsTestF, ::testing::ValuesIn(inputsf));
+
+INSTANTIATE_TEST_SUITE_P(MomentsTests, MomentsTestD, ::testing::ValuesIn(inputsd));
+
+}  // end namespace stats
+}  // end namespace raft
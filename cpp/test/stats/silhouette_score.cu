@@ -71,7 +71,7 @@ class silhouetteScoreTest : public ::testing::TestWithParam<silhouetteScoreParam
     sampleSilScore.resize(nElements, stream);
 
     raft::update_device(d_X.data(), &h_X[0], (int)nElements, stream);
-    raft::update_device(d_labels.data(), &h_labels[0], (int)nElements, stream);
+    raft::update_device(d_labels.data(), &h_labels[0], (int)nRows, stream);
 
     // finding the distance matrix
 
@@ -186,6 +186,20 @@ class silhouetteScoreTest : public ::testing::TestWithParam<silhouetteScoreParam
       nLabels,
       chunk,
       params.metric);
+
+    // the sampled estimator is exact when all the samples are drawn
+    if (detail::silhouette_fused_supported(params.metric)) {
+      sampledSilhouetteScore = raft::stats::silhouette_score_sampled(
+        handle,
+        raft::make_device_matrix_view<const DataT>(d_X.data(), nRows, nCols),
+        raft::make_device_vector_view<const LabelT>(d_labels.data(), nRows),
+        nLabels,
+        nRows,
+        uint64_t(42),
+        params.metric);
+    } else {
+      sampledSilhouetteScore = truthSilhouetteScore;
+    }
   }
 
   // declaring the data values
@@ -201,6 +215,7 @@ class silhouetteScoreTest : public ::testing::TestWithParam<silhouetteScoreParam
   double truthSilhouetteScore    = 0;
   double computedSilhouetteScore = 0;
   double batchedSilhouetteScore  = 0;
+  double sampledSilhouetteScore  = 0;
   int chunk;
 };
 
@@ -212,7 +227,9 @@ const std::vector<silhouetteScoreParam> inputs = {
   {11, 2, 5, raft::distance::DistanceType::L2Expanded, 3, 0.00001},
   {40, 2, 8, raft::distance::DistanceType::L2Expanded, 10, 0.00001},
   {12, 7, 3, raft::distance::DistanceType::CosineExpanded, 8, 0.00001},
-  {7, 5, 5, raft::distance::DistanceType::L1, 2, 0.00001}};
+  {7, 5, 5, raft::distance::DistanceType::L1, 2, 0.00001},
+  {300, 16, 90, raft::distance::DistanceType::L2SqrtExpanded, 64, 0.00001},
+  {200, 9, 7, raft::distance::DistanceType::L1, 50, 0.00001}};
 
 // writing the test suite
 typedef silhouetteScoreTest<int, double> silhouetteScoreTestClass;
@@ -220,6 +237,7 @@ TEST_P(silhouetteScoreTestClass, Result)
 {
   ASSERT_NEAR(computedSilhouetteScore, truthSilhouetteScore, params.tolerance);
   ASSERT_NEAR(batchedSilhouetteScore, truthSilhouetteScore, params.tolerance);
+  ASSERT_NEAR(sampledSilhouetteScore, truthSilhouetteScore, params.tolerance);
 }
 INSTANTIATE_TEST_CASE_P(silhouetteScore, silhouetteScoreTestClass, ::testing::ValuesIn(inputs));
 
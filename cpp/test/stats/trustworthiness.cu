@@ -331,6 +331,31 @@ class TrustworthinessScoreTest : public ::testing::Test {
       raft::make_device_matrix_view<const float>(
         d_X_embedded.data(), n_sample, n_features_embedded),
       5);
+
+    // approximate: all the original neighbors are searched, so the ranks are exact
+    trustworthiness_approx_params params;
+    params.ivf_flat_index_params.n_lists   = 1;
+    params.ivf_flat_search_params.n_probes = 1;
+    params.rank_k                          = n_sample - 1;
+    params.batch_size                      = 16;
+    score_approx                           = trustworthiness_score_approx(
+      handle,
+      raft::make_device_matrix_view<const float>(d_X.data(), n_sample, n_features_origin),
+      raft::make_device_matrix_view<const float>(
+        d_X_embedded.data(), n_sample, n_features_embedded),
+      5,
+      params);
+
+    // approximate: the ranks beyond rank_k are estimated from the sampled points
+    params.rank_k         = 10;
+    params.n_rank_samples = 25;
+    score_sampled         = trustworthiness_score_approx(
+      handle,
+      raft::make_device_matrix_view<const float>(d_X.data(), n_sample, n_features_origin),
+      raft::make_device_matrix_view<const float>(
+        d_X_embedded.data(), n_sample, n_features_embedded),
+      5,
+      params);
   }
 
   void SetUp() override { basicTest(); }
@@ -344,9 +369,16 @@ class TrustworthinessScoreTest : public ::testing::Test {
   rmm::device_uvector<float> d_X_embedded;
 
   double score;
+  double score_approx;
+  double score_sampled;
 };
 
 typedef TrustworthinessScoreTest TrustworthinessScoreTestF;
 TEST_F(TrustworthinessScoreTestF, Result) { ASSERT_TRUE(0.9375 < score && score < 0.9379); }
+TEST_F(TrustworthinessScoreTestF, Approx)
+{
+  ASSERT_NEAR(score_approx, score, 1e-6);
+  ASSERT_NEAR(score_sampled, score, 0.02);
+}
 };  // namespace stats
 };  // namespace raft
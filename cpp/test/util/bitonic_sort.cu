@@ -35,6 +35,7 @@ struct test_spec {
   int warp_width;
   int capacity;
   bool ascending;
+  bool blocked = false;
 
   [[nodiscard]] auto len() const -> int { return n_inputs * warp_width * capacity; }
 };
@@ -43,7 +44,7 @@ auto operator<<(std::ostream& os, const test_spec& ss) -> std::ostream&
 {
   os << "spec{n_inputs: " << ss.n_inputs << ", input_len: " << (ss.warp_width * ss.capacity) << " ("
      << ss.warp_width << " * " << ss.capacity << ")";
-  os << (ss.ascending ? "; asc}" : "; dsc}");
+  os << (ss.ascending ? "; asc" : "; dsc") << (ss.blocked ? "; blocked}" : "}");
   return os;
 }
 
@@ -75,6 +76,33 @@ __global__ void bitonic_kernel(T* arr, bool ascending, int warp_width, int n_inp
   }
 }
 
+template <int Capacity, typename T>
+__global__ void bitonic_blocked_kernel(T* arr, bool ascending, int warp_width, int n_inputs)
+{
+  const int tid          = blockDim.x * blockIdx.x + threadIdx.x;
+  const int subwarp_id   = tid / warp_width;
+  const int subwarp_lane = tid % warp_width;
+  T local_arr[Capacity];  // NOLINT
+  // The same chunks, each thread pointing to its contiguous part of the chunk.
+  T* per_thread_arr = arr + (subwarp_id * warp_width + subwarp_lane) * Capacity;
+
+  if (subwarp_id < n_inputs) {
+#pragma unroll
+    for (int i = 0; i < Capacity; i++) {
+      local_arr[i] = per_thread_arr[i];
+    }
+  }
+
+  bitonic_blocked<Capacity>(ascending, warp_width).sort(local_arr);
+
+  if (subwarp_id < n_inputs) {
+#pragma unroll
+    for (int i = 0; i < Capacity; i++) {
+      per_thread_arr[i] = local_arr[i];
+    }
+  }
+}
+
 template <int Capacity>
 struct bitonic_launch {
   template <typename T>
@@ -88,16 +116,17 @@ struct bitonic_launch {
         return bitonic_launch<std::max(1, Capacity / 2)>::run(spec, arr, stream);
       }
     }
+    auto kernel = spec.blocked ? bitonic_blocked_kernel<Capacity, T> : bitonic_kernel<Capacity, T>;
     int max_block_size, min_grid_size;
     RAFT_CUDA_TRY(cudaOccupancyMaxPotentialBlockSize(
-      &min_grid_size, &max_block_size, bitonic_kernel<Capacity, T>, 0, kMaxBlockSize));
+      &min_grid_size, &max_block_size, kernel, 0, kMaxBlockSize));
     const int n_warps =
       ceildiv(std::min(spec.n_inputs * spec.warp_width, max_block_size), WarpSize);
     const int block_dim  = n_warps * WarpSize;
     const int n_subwarps = block_dim / spec.warp_width;
     const int grid_dim   = ceildiv(spec.n_inputs, n_subwarps);
-    bitonic_kernel<Capacity, T>
-      <<<grid_dim, block_dim, 0, stream>>>(arr, spec.ascending, spec.warp_width, spec.n_inputs);
+    kernel<<<grid_dim, block_dim, 0, stream>>>(
+      arr, spec.ascending, spec.warp_width, spec.n_inputs);
     RAFT_CUDA_TRY(cudaPeekAtLastError());
   }
 };
@@ -182,7 +211,17 @@ auto inputs = ::testing::Values(test_spec{1, 1, 1, true},
                                 test_spec{7, 8, 2, true},
                                 test_spec{70, 4, 32, true},
                                 test_spec{70, 1, 64, true},
-                                test_spec{70, 2, 128, false});
+                                test_spec{70, 2, 128, false},
+                                test_spec{1, 1, 8, true, true},
+                                test_spec{1, 2, 1, false, true},
+                                test_spec{1, 32, 1, true, true},
+                                test_spec{1, 32, 4, false, true},
+                                test_spec{5, 32, 8, true, true},
+                                test_spec{7, 16, 4, true, true},
+                                test_spec{7, 8, 2, false, true},
+                                test_spec{3, 32, 64, true, true},
+                                test_spec{70, 4, 32, true, true},
+                                test_spec{70, 2, 128, false, true});
 
 using Floats = BitonicTest<float>;                      // NOLINT
 TEST_P(Floats, Run) { run(); }                          // NOLINT
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/util/block_cache.hpp>
+#include <raft/util/cudart_utils.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace raft::cache {
+
+TEST(SlotMap, Lru)
+{
+  slot_map<uint32_t> map(3, replacement_policy::LRU);
+  for (uint32_t key : {10u, 11u, 12u}) {
+    map.begin_batch();
+    auto a = map.acquire(key);
+    EXPECT_FALSE(a.hit);
+    EXPECT_FALSE(a.evicted);
+  }
+  map.begin_batch();
+  EXPECT_TRUE(map.acquire(10).hit);
+  // 11 is the least recently used
+  auto a = map.acquire(13);
+  EXPECT_FALSE(a.hit);
+  ASSERT_TRUE(a.evicted);
+  EXPECT_EQ(a.evicted_key, 11u);
+  EXPECT_EQ(map.slot_of(11), slot_map<uint32_t>::kNoSlot);
+  EXPECT_EQ(map.slot_of(13), a.slot);
+  // 12 is the only key not used by the current batch
+  EXPECT_EQ(map.acquire(14).evicted_key, 12u);
+  EXPECT_THROW(map.acquire(15), raft::logic_error);
+
+  EXPECT_EQ(map.size(), 3u);
+  EXPECT_EQ(map.stats().hits, 1u);
+  EXPECT_EQ(map.stats().evictions, 2u);
+  map.reset_stats();
+  EXPECT_EQ(map.stats().hit_rate(), 0.0);
+}
+
+TEST(SlotMap, Clock)
+{
+  slot_map<uint64_t> map(2, replacement_policy::CLOCK);
+  map.begin_batch();
+  map.acquire(1);
+  map.acquire(2);
+  map.begin_batch();
+  // both referenced: the first sweep clears the bits, the second one evicts the first slot
+  EXPECT_EQ(map.acquire(3).evicted_key, 1u);
+  map.begin_batch();
+  EXPECT_TRUE(map.acquire(2).hit);
+  map.begin_batch();
+  // 3 and 2 are referenced; the hand points at the slot of 2
+  EXPECT_EQ(map.acquire(4).evicted_key, 2u);
+  EXPECT_EQ(map.stats().misses, 4u);
+  EXPECT_DOUBLE_EQ(map.stats().hit_rate(), 0.2);
+}
+
+TEST(BlockCache, Fetch)
+{
+  raft::resources handle;
+  auto stream = resource::get_cuda_stream(handle);
+  std::vector<std::vector<int>> blocks{{1, 2, 3}, {4}, {5, 6}, {}};
+
+  block_cache<int> cache(handle, 2, 3, replacement_policy::CLOCK);
+  EXPECT_EQ(cache.capacity(), 2u);
+  EXPECT_EQ(cache.block_capacity(), 3u);
+  for (int round = 0; round < 2; round++) {
+    for (uint32_t key = 0; key < blocks.size(); key++) {
+      cache.begin_batch();
+      int* block = cache.fetch(handle, key, blocks[key].data(), blocks[key].size());
+      EXPECT_EQ(cache.find(key), block);
+      ASSERT_TRUE(devArrMatchHost(
+        blocks[key].data(), block, blocks[key].size(), raft::Compare<int>(), stream));
+    }
+  }
+  EXPECT_EQ(cache.stats().misses, 8u);
+  EXPECT_THROW(cache.fetch(handle, 7, nullptr, 4), raft::logic_error);
+}
+
+}  // namespace raft::cache
@@ -19,13 +19,16 @@
 #include <cstddef>
 #include <gtest/gtest.h>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <numeric>
+#include <raft/core/kvp.hpp>
 #include <raft/util/cudart_utils.hpp>
 #include <raft/util/device_atomics.cuh>
 #include <rmm/cuda_stream_pool.hpp>
 #include <rmm/device_scalar.hpp>
 #include <rmm/device_uvector.hpp>
+#include <vector>
 
 namespace raft {
 
@@ -67,4 +70,126 @@ TEST(Raft, AtomicIncWarp)
   }
 }
 
+template <typename T>
+__global__ void test_atomic_min_max_kernel(T* out_min, T* out_max, const T* values, int n)
+{
+  int i = blockDim.x * blockIdx.x + threadIdx.x;
+  if (i >= n) { return; }
+  atomicMin(out_min + i % 4, values[i]);
+  atomicMax(out_max + i % 4, values[i]);
+  atomicMinWarp(out_min + 4 + i % 4, values[i]);
+  atomicMaxWarp(out_max + 4 + i % 4, values[i]);
+}
+
+template <typename T>
+void test_atomic_min_max()
+{
+  rmm::cuda_stream_pool pool{1};
+  auto s = pool.get_stream();
+
+  // all the negative values, including -0.0, and the positive ones
+  std::vector<T> values;
+  for (int i = 0; i < 4000; i++) {
+    values.push_back(T((i * 7919) % 1000 - 500) / T(3));
+  }
+  values.push_back(T(-0.0));
+  values.push_back(T(-1234.5));
+  values.push_back(T(1234.5));
+  const int n = values.size();
+  std::vector<T> expected_min(4, std::numeric_limits<T>::max());
+  std::vector<T> expected_max(4, std::numeric_limits<T>::lowest());
+  for (int i = 0; i < n; i++) {
+    expected_min[i % 4] = std::min(expected_min[i % 4], values[i]);
+    expected_max[i % 4] = std::max(expected_max[i % 4], values[i]);
+  }
+  std::vector<T> out_min(8, std::numeric_limits<T>::max());
+  std::vector<T> out_max(8, std::numeric_limits<T>::lowest());
+  rmm::device_uvector<T> d_values(n, s), d_min(8, s), d_max(8, s);
+  raft::update_device(d_values.data(), values.data(), n, s);
+  raft::update_device(d_min.data(), out_min.data(), 8, s);
+  raft::update_device(d_max.data(), out_max.data(), 8, s);
+  test_atomic_min_max_kernel<<<raft::ceildiv(n, 256), 256, 0, s>>>(
+    d_min.data(), d_max.data(), d_values.data(), n);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+  raft::update_host(out_min.data(), d_min.data(), 8, s);
+  raft::update_host(out_max.data(), d_max.data(), 8, s);
+  s.synchronize();
+  for (int j = 0; j < 8; j++) {
+    ASSERT_EQ(out_min[j], expected_min[j % 4]) << "j = " << j;
+    ASSERT_EQ(out_max[j], expected_max[j % 4]) << "j = " << j;
+  }
+}
+
+TEST(Raft, AtomicMinMaxFloat) { test_atomic_min_max<float>(); }
+TEST(Raft, AtomicMinMaxDouble) { test_atomic_min_max<double>(); }
+
+__global__ void test_atomic_add_warp_kernel(int* counts, int n)
+{
+  int i = blockDim.x * blockIdx.x + threadIdx.x;
+  if (i >= n) { return; }
+  // a few hot counters, and a sparse one updated by part of the warp
+  atomicAddWarp(counts + i % 3, 1);
+  if (i % 5 == 0) { atomicAddWarp(counts + 3, i % 7); }
+}
+
+TEST(Raft, AtomicAddWarp)
+{
+  rmm::cuda_stream_pool pool{1};
+  auto s = pool.get_stream();
+
+  const int n = 100000;
+  std::vector<int> expected(4, 0), counts(4);
+  for (int i = 0; i < n; i++) {
+    expected[i % 3]++;
+    if (i % 5 == 0) { expected[3] += i % 7; }
+  }
+  rmm::device_uvector<int> d_counts(4, s);
+  RAFT_CUDA_TRY(cudaMemsetAsync(d_counts.data(), 0, 4 * sizeof(int), s));
+  test_atomic_add_warp_kernel<<<raft::ceildiv(n, 256), 256, 0, s>>>(d_counts.data(), n);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+  raft::update_host(counts.data(), d_counts.data(), 4, s);
+  s.synchronize();
+  ASSERT_EQ(counts, expected);
+}
+
+__global__ void test_atomic_min_key_value_kernel(raft::KeyValuePair<int, float>* out,
+                                                 const float* values,
+                                                 int n)
+{
+  int i = blockDim.x * blockIdx.x + threadIdx.x;
+  if (i >= n) { return; }
+  atomicMinKeyValue(out + i % 2, raft::KeyValuePair<int, float>{i, values[i]});
+}
+
+TEST(Raft, AtomicMinKeyValue)
+{
+  using kvp_t = raft::KeyValuePair<int, float>;
+  rmm::cuda_stream_pool pool{1};
+  auto s = pool.get_stream();
+
+  const int n = 10000;
+  std::vector<float> values(n);
+  for (int i = 0; i < n; i++) {
+    values[i] = float((i * 7919) % n) - 100.0f;
+  }
+  std::vector<kvp_t> expected(2, kvp_t{-1, std::numeric_limits<float>::max()});
+  for (int i = 0; i < n; i++) {
+    if (values[i] < expected[i % 2].value) { expected[i % 2] = kvp_t{i, values[i]}; }
+  }
+  std::vector<kvp_t> out(expected.size(), kvp_t{-1, std::numeric_limits<float>::max()});
+  rmm::device_uvector<float> d_values(n, s);
+  rmm::device_uvector<kvp_t> d_out(out.size(), s);
+  raft::update_device(d_values.data(), values.data(), n, s);
+  raft::update_device(d_out.data(), out.data(), out.size(), s);
+  test_atomic_min_key_value_kernel<<<raft::ceildiv(n, 256), 256, 0, s>>>(
+    d_out.data(), d_values.data(), n);
+  RAFT_CUDA_TRY(cudaPeekAtLastError());
+  raft::update_host(out.data(), d_out.data(), out.size(), s);
+  s.synchronize();
+  for (size_t j = 0; j < out.size(); j++) {
+    ASSERT_EQ(out[j].key, expected[j].key) << "j = " << j;
+    ASSERT_EQ(out[j].value, expected[j].value) << "j = " << j;
+  }
+}
+
 }  // namespace raft
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/util/cudart_utils.hpp>
+#include <raft/util/fast_int_div.cuh>
+
+#include <rmm/device_uvector.hpp>
+
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace raft::util {
+
+template <typename T>
+__global__ void fast_uint_div_kernel(
+  T* quotients, T* remainders, const T* numerators, int n, FastUIntDiv<T> divisor)
+{
+  int i = threadIdx.x + blockIdx.x * blockDim.x;
+  if (i >= n) { return; }
+  quotients[i]  = numerators[i] / divisor;
+  remainders[i] = numerators[i] % divisor;
+}
+
+template <typename T>
+class FastUIntDivTest : public ::testing::Test {
+ protected:
+  void SetUp() override
+  {
+    constexpr T kMax = std::numeric_limits<T>::max();
+    std::mt19937_64 gen(42ULL);
+    std::uniform_int_distribution<T> any(1, kMax);
+    std::uniform_int_distribution<T> small(1, 1000);
+    divisors = {1, 2, 3, 7, 10, 32, 96, 100, 127, 1000, kMax / 2, kMax / 2 + 1, kMax - 1, kMax};
+    for (int i = 0; i < 32; i++) {
+      divisors.push_back(any(gen));
+      divisors.push_back(small(gen));
+    }
+    numerators = {0, 1, 2, 31, 32, 33, 1000, kMax / 2, kMax / 2 + 1, kMax - 1, kMax};
+    for (int i = 0; i < 256; i++) {
+      numerators.push_back(any(gen));
+      numerators.push_back(small(gen));
+    }
+  }
+
+  void host()
+  {
+    for (auto d : divisors) {
+      FastUIntDiv<T> divisor(d);
+      for (auto n : numerators) {
+        ASSERT_EQ(n / divisor, n / d) << "n = " << n << ", d = " << d;
+        ASSERT_EQ(n % divisor, n % d) << "n = " << n << ", d = " << d;
+      }
+    }
+  }
+
+  void device()
+  {
+    raft::resources handle;
+    auto stream = resource::get_cuda_stream(handle);
+    int n       = int(numerators.size());
+    rmm::device_uvector<T> d_numerators(n, stream), quotients(n, stream), remainders(n, stream);
+    raft::update_device(d_numerators.data(), numerators.data(), n, stream);
+    std::vector<T> h_quotients(n), h_remainders(n);
+    for (auto d : divisors) {
+      fast_uint_div_kernel<T><<<raft::ceildiv(n, 128), 128, 0, stream>>>(
+        quotients.data(), remainders.data(), d_numerators.data(), n, d);
+      RAFT_CUDA_TRY(cudaPeekAtLastError());
+      raft::update_host(h_quotients.data(), quotients.data(), n, stream);
+      raft::update_host(h_remainders.data(), remainders.data(), n, stream);
+      resource::sync_stream(handle, stream);
+      for (int i = 0; i < n; i++) {
+        ASSERT_EQ(h_quotients[i], numerators[i] / d) << "n = " << numerators[i] << ", d = " << d;
+        ASSERT_EQ(h_remainders[i], numerators[i] % d) << "n = " << numerators[i] << ", d = " << d;
+      }
+    }
+  }
+
+  std::vector<T> divisors, numerators;
+};
+
+using FastUIntDiv32 = FastUIntDivTest<uint32_t>;
+using FastUIntDiv64 = FastUIntDivTest<uint64_t>;
+
+TEST_F(FastUIntDiv32, Host) { host(); }
+TEST_F(FastUIntDiv32, Device) { device(); }
+TEST_F(FastUIntDiv64, Host) { host(); }
+TEST_F(FastUIntDiv64, Device) { device(); }
+
+}  // namespace raft::util
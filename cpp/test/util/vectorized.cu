@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_utils.cuh"
+
+#include <raft/core/resource/cuda_stream.hpp>
+#include <raft/core/resources.hpp>
+#include <raft/util/cudart_utils.hpp>
+#include <raft/util/vectorized.cuh>
+
+#include <rmm/device_uvector.hpp>
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace raft {
+
+struct vectorized_inputs {
+  int offset;
+  int n;
+  bool no_allocate;
+};
+
+auto operator<<(std::ostream& os, const vectorized_inputs& p) -> std::ostream&
+{
+  return os << "offset: " << p.offset << "; n: " << p.n << "; no_allocate: " << p.no_allocate;
+}
+
+// Every element is visited exactly once, with its value, by the threads of a block
+template <bool NoAllocate, typename T>
+__global__ void vectorized_for_each_kernel(const T* in, int n, T* out, int* visits)
+{
+  vectorized_for_each<NoAllocate>(
+    in,
+    n,
+    [out, visits](int i, T x) {
+      out[i] = x;
+      atomicAdd(visits + i, 1);
+    },
+    int(threadIdx.x),
+    int(blockDim.x));
+}
+
+template <typename T>
+__global__ void copy_vectorized_kernel(T* out, const T* in, int n)
+{
+  copy_vectorized(out, in, uint32_t(n));
+}
+
+template <typename T>
+class VectorizedTest : public ::testing::TestWithParam<vectorized_inputs> {
+ public:
+  VectorizedTest()
+    : params(::testing::TestWithParam<vectorized_inputs>::GetParam()),
+      stream(resource::get_cuda_stream(handle)),
+      in(params.offset + params.n, stream),
+      out(params.offset + params.n, stream),
+      visits(params.n, stream)
+  {
+  }
+
+  void run()
+  {
+    int n = params.n;
+    std::vector<T> in_h(params.offset + n);
+    for (size_t i = 0; i < in_h.size(); i++) {
+      in_h[i] = T(i % 97);
+    }
+    raft::update_device(in.data(), in_h.data(), in_h.size(), stream);
+    RAFT_CUDA_TRY(cudaMemsetAsync(visits.data(), 0, n * sizeof(int), stream));
+    RAFT_CUDA_TRY(cudaMemsetAsync(out.data(), 0, out.size() * sizeof(T), stream));
+
+    const T* src = in.data() + params.offset;
+    if (params.no_allocate) {
+      vectorized_for_each_kernel<true><<<1, 64, 0, stream>>>(src, n, out.data(), visits.data());
+    } else {
+      vectorized_for_each_kernel<false><<<1, 64, 0, stream>>>(src, n, out.data(), visits.data());
+    }
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+    std::vector<int> ones(n, 1);
+    ASSERT_TRUE(devArrMatchHost(ones.data(), visits.data(), n, raft::Compare<int>(), stream));
+    ASSERT_TRUE(
+      devArrMatchHost(in_h.data() + params.offset, out.data(), n, raft::Compare<T>(), stream));
+
+    // the offsets of the source and of the destination differ
+    copy_vectorized_kernel<<<1, 64, 0, stream>>>(out.data(), src, n);
+    RAFT_CUDA_TRY(cudaPeekAtLastError());
+    ASSERT_TRUE(
+      devArrMatchHost(in_h.data() + params.offset, out.data(), n, raft::Compare<T>(), stream));
+  }
+
+ protected:
+  raft::resources handle;
+  vectorized_inputs params;
+  cudaStream_t stream;
+  rmm::device_uvector<T> in, out;
+  rmm::device_uvector<int> visits;
+};
+
+const std::vector<vectorized_inputs> inputs = {{0, 0, false},
+                                               {0, 1, false},
+                                               {3, 5, true},
+                                               {0, 100, false},
+                                               {1, 100, true},
+                                               {5, 100, false},
+                                               {0, 1024, true},
+                                               {7, 1000, false},
+                                               {13, 4099, true}};
+
+using VectorizedTestU8 = VectorizedTest<uint8_t>;
+TEST_P(VectorizedTestU8, Result) { run(); }
+INSTANTIATE_TEST_CASE_P(VectorizedTests, VectorizedTestU8, ::testing::ValuesIn(inputs));
+
+using VectorizedTestF = VectorizedTest<float>;
+TEST_P(VectorizedTestF, Result) { run(); }
+INSTANTIATE_TEST_CASE_P(VectorizedTests, VectorizedTestF, ::testing::ValuesIn(inputs));
+
+using VectorizedTestD = VectorizedTest<double>;
+TEST_P(VectorizedTestD, Result) { run(); }
+INSTANTIATE_TEST_CASE_P(VectorizedTests, VectorizedTestD, ::testing::ValuesIn(inputs));
+
+}  // namespace raft
@@ -15,9 +15,9 @@
 
 from .ai_wrapper import ai_wrapper
 from .cai_wrapper import cai_wrapper
-from .cuda import Stream
+from .cuda import Stream, pinned_empty
 from .device_ndarray import device_ndarray
 from .handle import DeviceResources, Handle
 from .outputs import auto_convert_output
 
-__all__ = ["DeviceResources", "Handle", "Stream"]
+__all__ = ["DeviceResources", "Handle", "Stream", "pinned_empty"]
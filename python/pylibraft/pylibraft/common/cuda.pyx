@@ -19,11 +19,15 @@
 # cython: embedsignature = True
 # cython: language_level = 3
 
+import numpy as np
+
 from cuda.ccudart cimport (
     cudaError_t,
+    cudaFreeHost,
     cudaGetErrorName,
     cudaGetErrorString,
     cudaGetLastError,
+    cudaMallocHost,
     cudaStream_t,
     cudaStreamCreate,
     cudaStreamDestroy,
@@ -87,3 +91,63 @@ cdef class Stream:
         Return the uintptr_t pointer of the underlying cudaStream_t handle
         """
         return <uintptr_t>self.s
+
+
+cdef class _PinnedBuffer:
+    """
+    Page-locked host memory, exposed as a byte array through the
+    `__array_interface__`.
+    """
+    cdef void* ptr
+    cdef readonly size_t nbytes
+
+    def __cinit__(self, size_t nbytes):
+        self.ptr = NULL
+        self.nbytes = nbytes
+        cdef cudaError_t e = cudaMallocHost(&self.ptr, max(nbytes, 1))
+        if e != cudaSuccess:
+            raise CudaRuntimeError("Pinned host allocation")
+
+    def __dealloc__(self):
+        if self.ptr != NULL:
+            cudaFreeHost(self.ptr)
+
+    @property
+    def __array_interface__(self):
+        return {
+            "shape": (self.nbytes,),
+            "typestr": "|u1",
+            "data": (<uintptr_t>self.ptr, False),
+            "version": 3,
+        }
+
+
+def pinned_empty(shape, dtype=np.float32):
+    """
+    Return a new numpy.ndarray of given shape and type in page-locked
+    (pinned) host memory, without initializing entries.
+
+    The copies between the device and pinned host memory are asynchronous,
+    e.g. the search functions of `pylibraft.neighbors` accept pinned arrays
+    as outputs and copy the results to them without blocking the host.
+
+    Parameters
+    ----------
+    shape : int or tuple of int
+            Shape of the empty array, e.g., (2, 3) or 2.
+    dtype : data-type, optional
+            Desired output data-type for the array, e.g, numpy.int8.
+            Default is numpy.float32.
+
+    Examples
+    --------
+
+    >>> from pylibraft.common import pinned_empty
+    >>> neighbors = pinned_empty((100, 10), dtype="int64")
+    """
+    dtype = np.dtype(dtype)
+    shape = tuple(shape) if np.iterable(shape) else (shape,)
+    nbytes = int(np.prod(shape, dtype=np.int64)) * dtype.itemsize
+    # The array keeps the buffer alive through its base.
+    data = np.asarray(_PinnedBuffer(nbytes))
+    return data.view(dtype).reshape(shape)
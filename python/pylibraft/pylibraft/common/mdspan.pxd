@@ -27,9 +27,17 @@ from pylibraft.common.handle cimport device_resources
 from pylibraft.common.optional cimport make_optional, optional
 
 
+cdef extern from "cuda_fp16.h" nogil:
+    ctypedef struct half:
+        pass
+
+
 cdef device_matrix_view[float, int64_t, row_major] get_dmv_float(
     array, check_shape) except *
 
+cdef device_matrix_view[half, int64_t, row_major] get_dmv_float16(
+    array, check_shape) except *
+
 cdef device_matrix_view[uint8_t, int64_t, row_major] get_dmv_uint8(
     array, check_shape) except *
 
@@ -26,18 +26,14 @@ from libcpp.vector cimport vector
 
 from pylibraft.distance.distance_type cimport DistanceType
 
-from pylibraft.common import (
-    DeviceResources,
-    auto_convert_output,
-    cai_wrapper,
-    device_ndarray,
-)
+from pylibraft.common import DeviceResources, auto_convert_output, cai_wrapper
+from pylibraft.common.cai_wrapper import wrap_array
 
 from libc.stdint cimport int64_t, uintptr_t
 
 from pylibraft.common.cpp.optional cimport optional
 from pylibraft.common.handle cimport device_resources
-from pylibraft.common.mdspan cimport get_dmv_float, get_dmv_int64
+from pylibraft.common.mdspan cimport get_dmv_float
 
 from pylibraft.common.handle import auto_sync_handle
 from pylibraft.common.interruptible import cuda_interruptible
@@ -47,7 +43,7 @@ from pylibraft.distance.distance_type cimport DistanceType
 # TODO: Centralize this
 
 from pylibraft.distance.pairwise_distance import DISTANCE_TYPES
-from pylibraft.neighbors.common import _check_input_array
+from pylibraft.neighbors.common import _check_input_array, _SearchOutput
 
 from pylibraft.common.cpp.mdspan cimport (
     device_matrix_view,
@@ -88,13 +84,18 @@ def knn(dataset, queries, k=None, indices=None, distances=None,
         Number of neighbors to search (k <= 2048). Optional if indices or
         distances arrays are given (in which case their second dimension
         is k).
-    indices :  Optional array interface compliant matrix shape
-                (n_queries, k), dtype int64_t. If supplied, neighbor
-                indices will be written here in-place. (default None)
-        Supported dtype uint64
-    distances :  Optional array interface compliant matrix shape
-                (n_queries, k), dtype float. If supplied, neighbor
-                indices will be written here in-place. (default None)
+    indices :  Optional CUDA array interface or array interface compliant
+                matrix shape (n_rows, k), n_rows >= n_queries, dtype int64_t.
+                If supplied, neighbor indices will be written to its first
+                n_queries rows. A host array (preferably pinned, see
+                `pylibraft.common.pinned_empty`) is filled with an
+                asynchronous copy in the stream of the handle.
+                (default None)
+    distances :  Optional CUDA array interface or array interface compliant
+                matrix shape (n_rows, k), n_rows >= n_queries, dtype float.
+                If supplied, the distances to the neighbors will be written
+                to its first n_queries rows, like the indices.
+                (default None)
 
     {handle_docstring}
 
@@ -137,9 +138,9 @@ def knn(dataset, queries, k=None, indices=None, distances=None,
 
     if k is None:
         if indices is not None:
-            k = cai_wrapper(indices).shape[1]
+            k = wrap_array(indices).shape[1]
         elif distances is not None:
-            k = cai_wrapper(distances).shape[1]
+            k = wrap_array(distances).shape[1]
         else:
             raise ValueError("Argument k must be specified if both indices "
                              "and distances arg is None")
@@ -149,19 +150,20 @@ def knn(dataset, queries, k=None, indices=None, distances=None,
     _check_input_array(queries_cai, [np.dtype("float32")],
                        exp_cols=dataset_cai.shape[1])
 
-    n_queries = queries_cai.shape[0]
-
-    if indices is None:
-        indices = device_ndarray.empty((n_queries, k), dtype='int64')
+    cdef int64_t n_queries = queries_cai.shape[0]
 
-    if distances is None:
-        distances = device_ndarray.empty((n_queries, k), dtype='float32')
+    indices_out = _SearchOutput(indices, n_queries, k, 'int64', handle)
+    distances_out = _SearchOutput(distances, n_queries, k, 'float32', handle)
+    cdef int64_t c_k = k
+    cdef device_matrix_view[int64_t, int64_t, row_major] indices_view = \
+        make_device_matrix_view[int64_t, int64_t, row_major](
+            <int64_t*><uintptr_t>indices_out.device_ptr, n_queries, c_k)
+    cdef device_matrix_view[float, int64_t, row_major] distances_view = \
+        make_device_matrix_view[float, int64_t, row_major](
+            <float*><uintptr_t>distances_out.device_ptr, n_queries, c_k)
 
     cdef DistanceType c_metric = DISTANCE_TYPES[metric]
 
-    distances_cai = cai_wrapper(distances)
-    indices_cai = cai_wrapper(indices)
-
     cdef optional[float] c_metric_arg = <float>metric_arg
     cdef optional[int64_t] c_global_offset = <int64_t>global_id_offset
 
@@ -173,12 +175,14 @@ def knn(dataset, queries, k=None, indices=None, distances=None,
             c_knn(deref(handle_),
                   get_dmv_float(dataset_cai, check_shape=True),
                   get_dmv_float(queries_cai, check_shape=True),
-                  get_dmv_int64(indices_cai, check_shape=True),
-                  get_dmv_float(distances_cai, check_shape=True),
+                  indices_view,
+                  distances_view,
                   c_metric,
                   c_metric_arg,
                   c_global_offset)
     else:
         raise TypeError("dtype %s not supported" % dataset_cai.dtype)
 
-    return (distances, indices)
+    indices_out.copy_to_host(handle)
+    distances_out.copy_to_host(handle)
+    return (distances_out.array, indices_out.array)
@@ -0,0 +1,858 @@
+#
+# Copyright (c) 2023, NVIDIA CORPORATION.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# cython: profile=False
+# distutils: language = c++
+# cython: embedsignature = True
+# cython: language_level = 3
+
+
+import numpy as np
+
+from cython.operator cimport dereference as deref
+from libc.stdint cimport int8_t, uint8_t, uint32_t, uintptr_t
+from libcpp cimport bool
+from libcpp.string cimport string
+
+cimport pylibraft.neighbors.cagra.cpp.c_cagra as c_cagra
+
+from pylibraft.common import (
+    DeviceResources,
+    ai_wrapper,
+    auto_convert_output,
+    cai_wrapper,
+)
+
+from pylibraft.common.cpp.mdspan cimport (
+    device_matrix_view,
+    make_device_matrix_view,
+    make_host_matrix_view,
+    row_major,
+)
+
+from pylibraft.common.interruptible import cuda_interruptible
+
+from pylibraft.common.handle cimport device_resources
+
+from pylibraft.common.handle import auto_sync_handle
+
+from pylibraft.neighbors.common import (
+    _check_input_array,
+    _get_metric,
+    _SearchOutput,
+)
+
+from pylibraft.neighbors.common cimport _get_metric_string
+
+
+_BUILD_ALGOS = {"ivf_pq": c_cagra.graph_build_algo.IVF_PQ,
+                "nn_descent": c_cagra.graph_build_algo.NN_DESCENT}
+
+_SEARCH_ALGOS = {"single_cta": c_cagra.search_algo.SINGLE_CTA,
+                 "multi_cta": c_cagra.search_algo.MULTI_CTA,
+                 "multi_kernel": c_cagra.search_algo.MULTI_KERNEL,
+                 "auto": c_cagra.search_algo.AUTO}
+
+_HASH_MODES = {"hash": c_cagra.hash_mode.HASH,
+               "small": c_cagra.hash_mode.SMALL,
+               "auto": c_cagra.hash_mode.AUTO_HASH}
+
+
+def _get_key(mapping, value):
+    return {v: k for k, v in mapping.items()}[value]
+
+
+cdef class IndexParams:
+    cdef c_cagra.index_params params
+
+    def __init__(self, *,
+                 metric="sqeuclidean",
+                 intermediate_graph_degree=128,
+                 graph_degree=64,
+                 build_algo="ivf_pq",
+                 nn_descent_niter=20):
+        """
+        Parameters to build index for CAGRA nearest neighbor search
+
+        Parameters
+        ----------
+        metric : string denoting the metric type, default="sqeuclidean"
+            Valid values for metric: ["sqeuclidean"], where
+            - sqeuclidean is the euclidean distance without the square root
+              operation, i.e.: distance(a,b) = \\sum_i (a_i - b_i)^2
+        intermediate_graph_degree : int, default = 128
+            The degree of the knn-graph that is pruned to the final graph.
+        graph_degree : int, default = 64
+            The degree of the final graph, which is searched.
+        build_algo : string denoting the graph building algorithm,
+                     default = "ivf_pq"
+            Valid values: ["ivf_pq", "nn_descent"]; nn_descent is
+            experimental.
+        nn_descent_niter : int, default = 20
+            The number of nn-descent iterations, used only if
+            build_algo == "nn_descent".
+        """
+        self.params.metric = _get_metric(metric)
+        self.params.metric_arg = 0
+        self.params.intermediate_graph_degree = intermediate_graph_degree
+        self.params.graph_degree = graph_degree
+        if build_algo not in _BUILD_ALGOS:
+            raise ValueError("build_algo %s is not supported" % build_algo)
+        self.params.build_algo = _BUILD_ALGOS[build_algo]
+        self.params.nn_descent_niter = nn_descent_niter
+
+    @property
+    def metric(self):
+        return self.params.metric
+
+    @property
+    def intermediate_graph_degree(self):
+        return self.params.intermediate_graph_degree
+
+    @property
+    def graph_degree(self):
+        return self.params.graph_degree
+
+    @property
+    def build_algo(self):
+        return _get_key(_BUILD_ALGOS, self.params.build_algo)
+
+    @property
+    def nn_descent_niter(self):
+        return self.params.nn_descent_niter
+
+
+cdef class Index:
+    cdef readonly bool trained
+    cdef str active_index_type
+
+    def __cinit__(self):
+        self.trained = False
+        self.active_index_type = None
+
+    def __repr__(self):
+        m_str = "metric=" + _get_metric_string(self.metric)
+        attr_str = [
+            attr + "=" + str(getattr(self, attr))
+            for attr in ["size", "dim", "graph_degree"]
+        ]
+        attr_str = [m_str] + attr_str
+        return "Index(type=CAGRA, " + (", ".join(attr_str)) + ")"
+
+
+cdef class IndexFloat(Index):
+    cdef c_cagra.index[float, uint32_t] * index
+
+    def __cinit__(self, handle=None):
+        if handle is None:
+            handle = DeviceResources()
+        cdef device_resources* handle_ = \
+            <device_resources*><size_t>handle.getHandle()
+        # An empty placeholder, replaced with the built or loaded index.
+        self.index = new c_cagra.index[float, uint32_t](deref(handle_))
+
+    def __dealloc__(self):
+        del self.index
+
+    @property
+    def dim(self):
+        return self.index[0].dim()
+
+    @property
+    def size(self):
+        return self.index[0].size()
+
+    @property
+    def graph_degree(self):
+        return self.index[0].graph_degree()
+
+    @property
+    def metric(self):
+        return self.index[0].metric()
+
+
+cdef class IndexInt8(Index):
+    cdef c_cagra.index[int8_t, uint32_t] * index
+
+    def __cinit__(self, handle=None):
+        if handle is None:
+            handle = DeviceResources()
+        cdef device_resources* handle_ = \
+            <device_resources*><size_t>handle.getHandle()
+        # An empty placeholder, replaced with the built or loaded index.
+        self.index = new c_cagra.index[int8_t, uint32_t](deref(handle_))
+
+    def __dealloc__(self):
+        del self.index
+
+    @property
+    def dim(self):
+        return self.index[0].dim()
+
+    @property
+    def size(self):
+        return self.index[0].size()
+
+    @property
+    def graph_degree(self):
+        return self.index[0].graph_degree()
+
+    @property
+    def metric(self):
+        return self.index[0].metric()
+
+
+cdef class IndexUint8(Index):
+    cdef c_cagra.index[uint8_t, uint32_t] * index
+
+    def __cinit__(self, handle=None):
+        if handle is None:
+            handle = DeviceResources()
+        cdef device_resources* handle_ = \
+            <device_resources*><size_t>handle.getHandle()
+        # An empty placeholder, replaced with the built or loaded index.
+        self.index = new c_cagra.index[uint8_t, uint32_t](deref(handle_))
+
+    def __dealloc__(self):
+        del self.index
+
+    @property
+    def dim(self):
+        return self.index[0].dim()
+
+    @property
+    def size(self):
+        return self.index[0].size()
+
+    @property
+    def graph_degree(self):
+        return self.index[0].graph_degree()
+
+    @property
+    def metric(self):
+        return self.index[0].metric()
+
+
+@auto_sync_handle
+@auto_convert_output
+def build(IndexParams index_params, dataset, handle=None):
+    """
+    Builds a CAGRA index that can be used for nearest neighbor search.
+
+    The dataset is copied into the index, so it can be released after the
+    call. The GIL is released while the index is built.
+
+    Parameters
+    ----------
+    index_params : IndexParams object
+    dataset : CUDA array interface compliant matrix shape (n_samples, dim)
+        or array interface compliant (host) matrix.
+        Supported dtype [float, int8, uint8]
+    {handle_docstring}
+
+    Returns
+    -------
+    index: cagra.Index
+
+    Examples
+    --------
+
+    >>> import cupy as cp
+
+    >>> from pylibraft.common import DeviceResources
+    >>> from pylibraft.neighbors import cagra
+
+    >>> n_samples = 50000
+    >>> n_features = 50
+    >>> n_queries = 1000
+
+    >>> dataset = cp.random.random_sample((n_samples, n_features),
+    ...                                   dtype=cp.float32)
+    >>> handle = DeviceResources()
+    >>> index_params = cagra.IndexParams(
+    ...     intermediate_graph_degree=128,
+    ...     graph_degree=64)
+
+    >>> index = cagra.build(index_params, dataset, handle=handle)
+
+    >>> # Search using the built index
+    >>> queries = cp.random.random_sample((n_queries, n_features),
+    ...                                   dtype=cp.float32)
+    >>> k = 10
+    >>> distances, neighbors = cagra.search(cagra.SearchParams(), index,
+    ...                                     queries, k, handle=handle)
+
+    >>> # pylibraft functions are often asynchronous so the
+    >>> # handle needs to be explicitly synchronized
+    >>> handle.sync()
+
+    >>> distances = cp.asarray(distances)
+    >>> neighbors = cp.asarray(neighbors)
+    """
+    cdef bool on_device = hasattr(dataset, "__cuda_array_interface__")
+    dataset_ai = cai_wrapper(dataset) if on_device else ai_wrapper(dataset)
+    dataset_dt = dataset_ai.dtype
+    _check_input_array(dataset_ai, [np.dtype('float32'), np.dtype('byte'),
+                                    np.dtype('ubyte')])
+    if len(dataset_ai.shape) != 2:
+        raise ValueError("Expected a 2D array, got %d D"
+                         % len(dataset_ai.shape))
+
+    cdef uint32_t n_rows = dataset_ai.shape[0]
+    cdef uint32_t dim = dataset_ai.shape[1]
+    cdef uintptr_t data_ptr = dataset_ai.data
+
+    if handle is None:
+        handle = DeviceResources()
+    cdef device_resources* handle_ = \
+        <device_resources*><size_t>handle.getHandle()
+
+    cdef c_cagra.index_params params = index_params.params
+    cdef IndexFloat idx_float
+    cdef IndexInt8 idx_int8
+    cdef IndexUint8 idx_uint8
+
+    if dataset_dt == np.float32:
+        idx_float = IndexFloat(handle)
+        idx_float.active_index_type = "float32"
+        with cuda_interruptible():
+            with nogil:
+                if on_device:
+                    c_cagra.build_device(
+                        deref(handle_), params,
+                        make_device_matrix_view[float, uint32_t, row_major](
+                            <float*>data_ptr, n_rows, dim),
+                        deref(idx_float.index))
+                else:
+                    c_cagra.build_host(
+                        deref(handle_), params,
+                        make_host_matrix_view[float, uint32_t, row_major](
+                            <float*>data_ptr, n_rows, dim),
+                        deref(idx_float.index))
+        idx_float.trained = True
+        return idx_float
+    elif dataset_dt == np.byte:
+        idx_int8 = IndexInt8(handle)
+        idx_int8.active_index_type = "byte"
+        with cuda_interruptible():
+            with nogil:
+                if on_device:
+                    c_cagra.build_device(
+                        deref(handle_), params,
+                        make_device_matrix_view[int8_t, uint32_t, row_major](
+                            <int8_t*>data_ptr, n_rows, dim),
+                        deref(idx_int8.index))
+                else:
+                    c_cagra.build_host(
+                        deref(handle_), params,
+                        make_host_matrix_view[int8_t, uint32_t, row_major](
+                            <int8_t*>data_ptr, n_rows, dim),
+                        deref(idx_int8.index))
+        idx_int8.trained = True
+        return idx_int8
+    elif dataset_dt == np.ubyte:
+        idx_uint8 = IndexUint8(handle)
+        idx_uint8.active_index_type = "ubyte"
+        with cuda_interruptible():
+            with nogil:
+                if on_device:
+                    c_cagra.build_device(
+                        deref(handle_), params,
+                        make_device_matrix_view[uint8_t, uint32_t, row_major](
+                            <uint8_t*>data_ptr, n_rows, dim),
+                        deref(idx_uint8.index))
+                else:
+                    c_cagra.build_host(
+                        deref(handle_), params,
+                        make_host_matrix_view[uint8_t, uint32_t, row_major](
+                            <uint8_t*>data_ptr, n_rows, dim),
+                        deref(idx_uint8.index))
+        idx_uint8.trained = True
+        return idx_uint8
+    else:
+        raise TypeError("dtype %s not supported" % dataset_dt)
+
+
+cdef class SearchParams:
+    cdef c_cagra.search_params params
+
+    def __init__(self, *,
+                 max_queries=0,
+                 itopk_size=64,
+                 max_iterations=0,
+                 algo="auto",
+                 team_size=0,
+                 search_width=1,
+                 min_iterations=0,
+                 thread_block_size=0,
+                 hashmap_mode="auto",
+                 hashmap_min_bitlen=0,
+                 hashmap_max_fill_rate=0.5,
+                 num_random_samplings=1,
+                 rand_xor_mask=0x128394):
+        """
+        CAGRA search parameters
+
+        Parameters
+        ----------
+        max_queries: int, default = 0
+            Maximum number of queries to search at the same time (batch
+            size). All the queries of a call are searched at once when 0.
+        itopk_size: int, default = 64
+            Number of intermediate search results retained during the
+            search. This is the main knob to adjust the trade-off between
+            accuracy and search speed. Higher values improve the accuracy.
+        max_iterations: int, default = 0
+            Upper limit of search iterations. Auto select when 0.
+        algo: string denoting the search algorithm, default = "auto"
+            Valid values: ["auto", "single_cta", "multi_cta",
+            "multi_kernel"]. single_cta is better for large batches,
+            multi_cta for small batches.
+        team_size: int, default = 0
+            Number of threads used to calculate a single distance. 4, 8, 16,
+            or 32. Auto select when 0.
+        search_width: int, default = 1
+            Number of graph nodes to select as the starting point for the
+            search in each iteration.
+        min_iterations: int, default = 0
+            Lower limit of search iterations.
+        thread_block_size: int, default = 0
+            Thread block size. 0, 64, 128, 256, 512, 1024. Auto select when
+            0.
+        hashmap_mode: string denoting the type of the hash map,
+                      default = "auto"
+            Valid values: ["auto", "hash", "small"].
+        hashmap_min_bitlen: int, default = 0
+            Lower limit of the hash map bit length. More than 8.
+        hashmap_max_fill_rate: float, default = 0.5
+            Upper limit of the hash map fill rate. More than 0.1, less than
+            0.9.
+        num_random_samplings: int, default = 1
+            Number of iterations of the initial random seed node selection.
+            1 or more.
+        rand_xor_mask: int, default = 0x128394
+            Bit mask used for the initial random seed node selection.
+        """
+        self.params.max_queries = max_queries
+        self.params.itopk_size = itopk_size
+        self.params.max_iterations = max_iterations
+        if algo not in _SEARCH_ALGOS:
+            raise ValueError("algo %s is not supported" % algo)
+        self.params.algo = _SEARCH_ALGOS[algo]
+        self.params.team_size = team_size
+        self.params.num_parents = search_width
+        self.params.min_iterations = min_iterations
+        self.params.thread_block_size = thread_block_size
+        if hashmap_mode not in _HASH_MODES:
+            raise ValueError("hashmap_mode %s is not supported" % hashmap_mode)
+        self.params.hashmap_mode = _HASH_MODES[hashmap_mode]
+        self.params.hashmap_min_bitlen = hashmap_min_bitlen
+        self.params.hashmap_max_fill_rate = hashmap_max_fill_rate
+        self.params.num_random_samplings = num_random_samplings
+        self.params.rand_xor_mask = rand_xor_mask
+
+    def __repr__(self):
+        attr_str = [attr + "=" + str(getattr(self, attr))
+                    for attr in ["max_queries", "itopk_size", "max_iterations",
+                                 "algo", "team_size", "search_width",
+                                 "min_iterations", "thread_block_size",
+                                 "hashmap_mode", "hashmap_min_bitlen",
+                                 "hashmap_max_fill_rate",
+                                 "num_random_samplings", "rand_xor_mask"]]
+        return "SearchParams(type=CAGRA, " + (", ".join(attr_str)) + ")"
+
+    @property
+    def max_queries(self):
+        return self.params.max_queries
+
+    @property
+    def itopk_size(self):
+        return self.params.itopk_size
+
+    @property
+    def max_iterations(self):
+        return self.params.max_iterations
+
+    @property
+    def algo(self):
+        return _get_key(_SEARCH_ALGOS, self.params.algo)
+
+    @property
+    def team_size(self):
+        return self.params.team_size
+
+    @property
+    def search_width(self):
+        return self.params.num_parents
+
+    @property
+    def min_iterations(self):
+        return self.params.min_iterations
+
+    @property
+    def thread_block_size(self):
+        return self.params.thread_block_size
+
+    @property
+    def hashmap_mode(self):
+        return _get_key(_HASH_MODES, self.params.hashmap_mode)
+
+    @property
+    def hashmap_min_bitlen(self):
+        return self.params.hashmap_min_bitlen
+
+    @property
+    def hashmap_max_fill_rate(self):
+        return self.params.hashmap_max_fill_rate
+
+    @property
+    def num_random_samplings(self):
+        return self.params.num_random_samplings
+
+    @property
+    def rand_xor_mask(self):
+        return self.params.rand_xor_mask
+
+
+@auto_sync_handle
+@auto_convert_output
+def search(SearchParams search_params,
+           Index index,
+           queries,
+           k,
+           neighbors=None,
+           distances=None,
+           handle=None):
+    """
+    Find the k nearest neighbors for each query.
+
+    The search is asynchronous with respect to the host when a handle is
+    supplied: the work is enqueued on the stream of the handle and the
+    function returns without synchronizing it. The GIL is released while the
+    search is enqueued, so that several Python threads, each with its own
+    handle (stream), can search the same index concurrently. The queries and
+    the output arrays must not be modified or released before the handle is
+    synchronized.
+
+    Parameters
+    ----------
+    search_params : SearchParams
+    index : Index
+        Trained CAGRA index.
+    queries : CUDA array interface compliant matrix shape (n_samples, dim)
+        Supported dtype [float, int8, uint8]
+    k : int
+        The number of neighbors.
+    neighbors : Optional CUDA array interface or array interface compliant
+                matrix shape (n_rows, k), n_rows >= n_queries, dtype
+                uint32_t. If supplied, neighbor indices will be written to
+                its first n_queries rows. A host array (preferably pinned,
+                see `pylibraft.common.pinned_empty`) is filled with an
+                asynchronous copy in the stream of the handle.
+                (default None)
+    distances : Optional CUDA array interface or array interface compliant
+                matrix shape (n_rows, k), n_rows >= n_queries, dtype float.
+                If supplied, the distances to the neighbors will be written
+                to its first n_queries rows, like the neighbors.
+                (default None)
+    {handle_docstring}
+
+    Examples
+    --------
+    >>> import cupy as cp
+
+    >>> from pylibraft.common import DeviceResources
+    >>> from pylibraft.neighbors import cagra
+
+    >>> n_samples = 50000
+    >>> n_features = 50
+    >>> n_queries = 1000
+    >>> dataset = cp.random.random_sample((n_samples, n_features),
+    ...                                   dtype=cp.float32)
+
+    >>> # Build index
+    >>> handle = DeviceResources()
+    >>> index = cagra.build(cagra.IndexParams(), dataset, handle=handle)
+
+    >>> # Search using the built index
+    >>> queries = cp.random.random_sample((n_queries, n_features),
+    ...                                   dtype=cp.float32)
+    >>> k = 10
+    >>> search_params = cagra.SearchParams(
+    ...     max_queries=100,
+    ...     itopk_size=64
+    ... )
+
+    >>> distances, neighbors = cagra.search(search_params, index, queries,
+    ...                                     k, handle=handle)
+
+    >>> # The search is asynchronous, the handle needs to be explicitly
+    >>> # synchronized before reading the results
+    >>> handle.sync()
+
+    >>> neighbors = cp.asarray(neighbors)
+    >>> distances = cp.asarray(distances)
+    """
+
+    if not index.trained:
+        raise ValueError("Index need to be built before calling search.")
+
+    if handle is None:
+        handle = DeviceResources()
+    cdef device_resources* handle_ = \
+        <device_resources*><size_t>handle.getHandle()
+
+    queries_cai = cai_wrapper(queries)
+    queries_dt = queries_cai.dtype
+    cdef uint32_t n_queries = queries_cai.shape[0]
+
+    _check_input_array(queries_cai, [np.dtype(index.active_index_type)],
+                       exp_cols=index.dim)
+
+    neighbors_out = _SearchOutput(neighbors, n_queries, k, 'uint32', handle)
+    distances_out = _SearchOutput(distances, n_queries, k, 'float32', handle)
+
+    cdef c_cagra.search_params params = search_params.params
+    if params.max_queries == 0:
+        params.max_queries = max(n_queries, 1)
+
+    cdef uint32_t dim = index.dim
+    cdef uint32_t c_k = k
+    cdef uintptr_t queries_ptr = queries_cai.data
+    cdef device_matrix_view[uint32_t, uint32_t, row_major] neighbors_view = \
+        make_device_matrix_view[uint32_t, uint32_t, row_major](
+            <uint32_t*><uintptr_t>neighbors_out.device_ptr, n_queries, c_k)
+    cdef device_matrix_view[float, uint32_t, row_major] distances_view = \
+        make_device_matrix_view[float, uint32_t, row_major](
+            <float*><uintptr_t>distances_out.device_ptr, n_queries, c_k)
+
+    cdef IndexFloat idx_float
+    cdef IndexInt8 idx_int8
+    cdef IndexUint8 idx_uint8
+
+    if queries_dt == np.float32:
+        idx_float = index
+        with cuda_interruptible():
+            with nogil:
+                c_cagra.search(
+                    deref(handle_),
+                    params,
+                    deref(idx_float.index),
+                    make_device_matrix_view[float, uint32_t, row_major](
+                        <float*>queries_ptr, n_queries, dim),
+                    neighbors_view,
+                    distances_view)
+    elif queries_dt == np.byte:
+        idx_int8 = index
+        with cuda_interruptible():
+            with nogil:
+                c_cagra.search(
+                    deref(handle_),
+                    params,
+                    deref(idx_int8.index),
+                    make_device_matrix_view[int8_t, uint32_t, row_major](
+                        <int8_t*>queries_ptr, n_queries, dim),
+                    neighbors_view,
+                    distances_view)
+    elif queries_dt == np.ubyte:
+        idx_uint8 = index
+        with cuda_interruptible():
+            with nogil:
+                c_cagra.search(
+                    deref(handle_),
+                    params,
+                    deref(idx_uint8.index),
+                    make_device_matrix_view[uint8_t, uint32_t, row_major](
+                        <uint8_t*>queries_ptr, n_queries, dim),
+                    neighbors_view,
+                    distances_view)
+    else:
+        raise ValueError("query dtype %s not supported" % queries_dt)
+
+    neighbors_out.copy_to_host(handle)
+    distances_out.copy_to_host(handle)
+    return (distances_out.array, neighbors_out.array)
+
+
+@auto_sync_handle
+def save(filename, Index index, handle=None):
+    """
+    Saves the index to file.
+
+    Saving / loading the index is experimental. The serialization format is
+    subject to change.
+
+    Parameters
+    ----------
+    filename : string
+        Name of the file.
+    index : Index
+        Trained CAGRA index.
+    {handle_docstring}
+
+    Examples
+    --------
+    >>> import cupy as cp
+
+    >>> from pylibraft.common import DeviceResources
+    >>> from pylibraft.neighbors import cagra
+
+    >>> n_samples = 50000
+    >>> n_features = 50
+    >>> dataset = cp.random.random_sample((n_samples, n_features),
+    ...                                   dtype=cp.float32)
+
+    >>> # Build index
+    >>> handle = DeviceResources()
+    >>> index = cagra.build(cagra.IndexParams(), dataset, handle=handle)
+    >>> cagra.save("my_index.bin", index, handle=handle)
+    """
+    if not index.trained:
+        raise ValueError("Index need to be built before saving it.")
+
+    if handle is None:
+        handle = DeviceResources()
+    cdef device_resources* handle_ = \
+        <device_resources*><size_t>handle.getHandle()
+
+    cdef string c_filename = filename.encode('utf-8')
+
+    cdef IndexFloat idx_float
+    cdef IndexInt8 idx_int8
+    cdef IndexUint8 idx_uint8
+
+    if index.active_index_type == "float32":
+        idx_float = index
+        with nogil:
+            c_cagra.serialize_file(
+                deref(handle_), c_filename, deref(idx_float.index))
+    elif index.active_index_type == "byte":
+        idx_int8 = index
+        with nogil:
+            c_cagra.serialize_file(
+                deref(handle_), c_filename, deref(idx_int8.index))
+    elif index.active_index_type == "ubyte":
+        idx_uint8 = index
+        with nogil:
+            c_cagra.serialize_file(
+                deref(handle_), c_filename, deref(idx_uint8.index))
+    else:
+        raise ValueError(
+            "Index dtype %s not supported" % index.active_index_type)
+
+
+def _read_index_dtype(filename):
+    """
+    Read the dtype of the dataset of a saved index.
+
+    The index starts with the scalars of its header (version, size, dim,
+    graph degree, metric, compression and whether the dataset is included),
+    followed by the dataset, all in the NumPy format.
+    """
+    with open(filename, 'rb') as f:
+        for _ in range(6):
+            np.lib.format.read_array(f)
+        if not np.lib.format.read_array(f):
+            raise ValueError("The index %s was saved without its dataset"
+                             % filename)
+        np.lib.format.read_magic(f)
+        _, _, dtype = np.lib.format.read_array_header_1_0(f)
+    return dtype
+
+
+@auto_sync_handle
+def load(filename, handle=None):
+    """
+    Loads index from file.
+
+    Saving / loading the index is experimental. The serialization format is
+    subject to change, therefore loading an index saved with a previous
+    version of raft is not guaranteed to work.
+
+    Parameters
+    ----------
+    filename : string
+        Name of the file.
+    {handle_docstring}
+
+    Returns
+    -------
+    index : Index
+
+    Examples
+    --------
+    >>> import cupy as cp
+
+    >>> from pylibraft.common import DeviceResources
+    >>> from pylibraft.neighbors import cagra
+
+    >>> n_samples = 50000
+    >>> n_features = 50
+    >>> dataset = cp.random.random_sample((n_samples, n_features),
+    ...                                   dtype=cp.float32)
+
+    >>> # Build and save index
+    >>> handle = DeviceResources()
+    >>> index = cagra.build(cagra.IndexParams(), dataset, handle=handle)
+    >>> cagra.save("my_index.bin", index, handle=handle)
+    >>> del index
+
+    >>> n_queries = 100
+    >>> queries = cp.random.random_sample((n_queries, n_features),
+    ...                                   dtype=cp.float32)
+    >>> handle = DeviceResources()
+    >>> index = cagra.load("my_index.bin", handle=handle)
+
+    >>> distances, neighbors = cagra.search(cagra.SearchParams(), index,
+    ...                                     queries, k=10, handle=handle)
+    """
+    if handle is None:
+        handle = DeviceResources()
+    cdef device_resources* handle_ = \
+        <device_resources*><size_t>handle.getHandle()
+
+    cdef string c_filename = filename.encode('utf-8')
+    cdef IndexFloat idx_float
+    cdef IndexInt8 idx_int8
+    cdef IndexUint8 idx_uint8
+
+    dataset_dt = _read_index_dtype(filename)
+
+    if dataset_dt == np.float32:
+        idx_float = IndexFloat(handle)
+        with nogil:
+            c_cagra.deserialize_file(
+                deref(handle_), c_filename, idx_float.index)
+        idx_float.trained = True
+        idx_float.active_index_type = 'float32'
+        return idx_float
+    elif dataset_dt == np.byte:
+        idx_int8 = IndexInt8(handle)
+        with nogil:
+            c_cagra.deserialize_file(
+                deref(handle_), c_filename, idx_int8.index)
+        idx_int8.trained = True
+        idx_int8.active_index_type = 'byte'
+        return idx_int8
+    elif dataset_dt == np.ubyte:
+        idx_uint8 = IndexUint8(handle)
+        with nogil:
+            c_cagra.deserialize_file(
+                deref(handle_), c_filename, idx_uint8.index)
+        idx_uint8.trained = True
+        idx_uint8.active_index_type = 'ubyte'
+        return idx_uint8
+    else:
+        raise ValueError("Index dtype %s not supported" % dataset_dt)
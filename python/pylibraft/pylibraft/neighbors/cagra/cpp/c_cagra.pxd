@@ -0,0 +1,197 @@
+#
+# Copyright (c) 2023, NVIDIA CORPORATION.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# cython: profile=False
+# distutils: language = c++
+# cython: embedsignature = True
+# cython: language_level = 3
+
+from libc.stdint cimport int8_t, uint8_t, uint32_t, uint64_t
+from libcpp cimport bool
+from libcpp.string cimport string
+
+from pylibraft.common.cpp.mdspan cimport (
+    device_matrix_view,
+    host_matrix_view,
+    row_major,
+)
+from pylibraft.common.handle cimport device_resources
+from pylibraft.distance.distance_type cimport DistanceType
+from pylibraft.neighbors.ivf_pq.cpp.c_ivf_pq cimport (
+    ann_index,
+    ann_index_params,
+    ann_search_params,
+)
+
+
+cdef extern from "raft/neighbors/cagra_types.hpp" \
+        namespace "raft::neighbors::experimental::cagra" nogil:
+
+    ctypedef enum graph_build_algo:
+        IVF_PQ "raft::neighbors::experimental::cagra::graph_build_algo::IVF_PQ",  # noqa: E501
+        NN_DESCENT "raft::neighbors::experimental::cagra::graph_build_algo::NN_DESCENT"  # noqa: E501
+
+    ctypedef enum search_algo:
+        SINGLE_CTA "raft::neighbors::experimental::cagra::search_algo::SINGLE_CTA",  # noqa: E501
+        MULTI_CTA "raft::neighbors::experimental::cagra::search_algo::MULTI_CTA",  # noqa: E501
+        MULTI_KERNEL "raft::neighbors::experimental::cagra::search_algo::MULTI_KERNEL",  # noqa: E501
+        AUTO "raft::neighbors::experimental::cagra::search_algo::AUTO"
+
+    ctypedef enum hash_mode:
+        HASH "raft::neighbors::experimental::cagra::hash_mode::HASH",
+        SMALL "raft::neighbors::experimental::cagra::hash_mode::SMALL",
+        AUTO_HASH "raft::neighbors::experimental::cagra::hash_mode::AUTO"
+
+    cpdef cppclass index_params(ann_index_params):
+        size_t intermediate_graph_degree
+        size_t graph_degree
+        graph_build_algo build_algo
+        size_t nn_descent_niter
+
+    cpdef cppclass search_params(ann_search_params):
+        size_t max_queries
+        size_t itopk_size
+        size_t max_iterations
+        search_algo algo
+        size_t team_size
+        size_t num_parents
+        size_t min_iterations
+        size_t thread_block_size
+        hash_mode hashmap_mode
+        size_t hashmap_min_bitlen
+        float hashmap_max_fill_rate
+        uint32_t num_random_samplings
+        uint64_t rand_xor_mask
+        bool persistent
+        float persistent_device_usage
+
+    cdef cppclass index[T, IdxT](ann_index):
+        index(const device_resources&)
+        IdxT size()
+        uint32_t dim()
+        uint32_t graph_degree()
+        DistanceType metric()
+
+
+cdef extern from "raft_runtime/neighbors/cagra.hpp" \
+        namespace "raft::runtime::neighbors::cagra" nogil:
+
+    cdef void build_device(
+        const device_resources& handle,
+        const index_params& params,
+        device_matrix_view[float, uint32_t, row_major] dataset,
+        index[float, uint32_t]& index) except +
+
+    cdef void build_device(
+        const device_resources& handle,
+        const index_params& params,
+        device_matrix_view[int8_t, uint32_t, row_major] dataset,
+        index[int8_t, uint32_t]& index) except +
+
+    cdef void build_device(
+        const device_resources& handle,
+        const index_params& params,
+        device_matrix_view[uint8_t, uint32_t, row_major] dataset,
+        index[uint8_t, uint32_t]& index) except +
+
+    cdef void build_host(
+        const device_resources& handle,
+        const index_params& params,
+        host_matrix_view[float, uint32_t, row_major] dataset,
+        index[float, uint32_t]& index) except +
+
+    cdef void build_host(
+        const device_resources& handle,
+        const index_params& params,
+        host_matrix_view[int8_t, uint32_t, row_major] dataset,
+        index[int8_t, uint32_t]& index) except +
+
+    cdef void build_host(
+        const device_resources& handle,
+        const index_params& params,
+        host_matrix_view[uint8_t, uint32_t, row_major] dataset,
+        index[uint8_t, uint32_t]& index) except +
+
+    cdef void search(
+        const device_resources& handle,
+        const search_params& params,
+        const index[float, uint32_t]& index,
+        device_matrix_view[float, uint32_t, row_major] queries,
+        device_matrix_view[uint32_t, uint32_t, row_major] neighbors,
+        device_matrix_view[float, uint32_t, row_major] distances) except +
+
+    cdef void search(
+        const device_resources& handle,
+        const search_params& params,
+        const index[int8_t, uint32_t]& index,
+        device_matrix_view[int8_t, uint32_t, row_major] queries,
+        device_matrix_view[uint32_t, uint32_t, row_major] neighbors,
+        device_matrix_view[float, uint32_t, row_major] distances) except +
+
+    cdef void search(
+        const device_resources& handle,
+        const search_params& params,
+        const index[uint8_t, uint32_t]& index,
+        device_matrix_view[uint8_t, uint32_t, row_major] queries,
+        device_matrix_view[uint32_t, uint32_t, row_major] neighbors,
+        device_matrix_view[float, uint32_t, row_major] distances) except +
+
+    cdef void serialize(const device_resources& handle,
+                        string& str,
+                        const index[float, uint32_t]& index) except +
+
+    cdef void deserialize(const device_resources& handle,
+                          const string& str,
+                          index[float, uint32_t]* index) except +
+
+    cdef void serialize(const device_resources& handle,
+                        string& str,
+                        const index[int8_t, uint32_t]& index) except +
+
+    cdef void deserialize(const device_resources& handle,
+                          const string& str,
+                          index[int8_t, uint32_t]* index) except +
+
+    cdef void serialize(const device_resources& handle,
+                        string& str,
+                        const index[uint8_t, uint32_t]& index) except +
+
+    cdef void deserialize(const device_resources& handle,
+                          const string& str,
+                          index[uint8_t, uint32_t]* index) except +
+
+    cdef void serialize_file(const device_resources& handle,
+                             const string& filename,
+                             const index[float, uint32_t]& index) except +
+
+    cdef void deserialize_file(const device_resources& handle,
+                               const string& filename,
+                               index[float, uint32_t]* index) except +
+
+    cdef void serialize_file(const device_resources& handle,
+                             const string& filename,
+                             const index[int8_t, uint32_t]& index) except +
+
+    cdef void deserialize_file(const device_resources& handle,
+                               const string& filename,
+                               index[int8_t, uint32_t]* index) except +
+
+    cdef void serialize_file(const device_resources& handle,
+                             const string& filename,
+                             const index[uint8_t, uint32_t]& index) except +
+
+    cdef void deserialize_file(const device_resources& handle,
+                               const string& filename,
+                               index[uint8_t, uint32_t]* index) except +
@@ -20,8 +20,26 @@
 
 import warnings
 
+import numpy as np
+
+from cuda.ccudart cimport (
+    cudaError_t,
+    cudaMemcpyAsync,
+    cudaMemcpyDeviceToHost,
+    cudaStream_t,
+    cudaSuccess,
+)
+from libc.stdint cimport uintptr_t
+from libcpp.memory cimport unique_ptr
+
+from rmm._lib.device_buffer cimport device_buffer
+
+from pylibraft.common.handle cimport device_resources
 from pylibraft.distance.distance_type cimport DistanceType
 
+from pylibraft.common import ai_wrapper, cai_wrapper, device_ndarray
+from pylibraft.common.cuda import CudaRuntimeError
+
 SUPPORTED_DISTANCES = {
     "sqeuclidean": DistanceType.L2Expanded,
     "euclidean": DistanceType.L2SqrtExpanded,
@@ -61,3 +79,78 @@ def _check_input_array(cai, exp_dt, exp_rows=None, exp_cols=None):
     if exp_rows is not None and cai.shape[0] != exp_rows:
         raise ValueError("Incorrect number of rows, expected {} , got {}"
                          .format(exp_rows, cai.shape[0]))
+
+
+def _check_output_array(ai, exp_dt, exp_rows, exp_cols):
+    if ai.dtype != exp_dt:
+        raise TypeError("dtype %s not supported" % ai.dtype)
+
+    if not ai.c_contiguous:
+        raise ValueError("Row major output is expected")
+
+    if len(ai.shape) != 2 or ai.shape[1] != exp_cols:
+        raise ValueError("Incorrect shape of the output, expected {} columns"
+                         " got {}".format(exp_cols, ai.shape))
+
+    if ai.shape[0] < exp_rows:
+        raise ValueError("Incorrect number of rows, expected at least {},"
+                         " got {}".format(exp_rows, ai.shape[0]))
+
+
+cdef class _SearchOutput:
+    """
+    An output matrix of a search, shape (n_rows, n_cols).
+
+    - If `array` is None, a new device array is allocated.
+    - If `array` is a device array, the results are written to its first
+      n_rows rows in place, so that one buffer can be reused for all the
+      batches up to its size.
+    - If `array` is a host array (preferably pinned, see
+      `pylibraft.common.pinned_empty`), the results are written to a
+      temporary device buffer and copied to the host array asynchronously on
+      the stream of the handle by `copy_to_host`. The temporary buffer is
+      released in stream order, so the copy does not need to be synchronized.
+    """
+    cdef readonly object array
+    cdef readonly uintptr_t device_ptr
+    cdef uintptr_t host_ptr
+    cdef size_t nbytes
+    cdef unique_ptr[device_buffer] staging
+
+    def __init__(self, array, n_rows, n_cols, dtype, handle):
+        dtype = np.dtype(dtype)
+        cdef device_resources* handle_ = \
+            <device_resources*><size_t>handle.getHandle()
+        self.nbytes = n_rows * n_cols * dtype.itemsize
+        self.host_ptr = 0
+        if array is None:
+            array = device_ndarray.empty((n_rows, n_cols), dtype=dtype)
+        if hasattr(array, "__cuda_array_interface__"):
+            array_ai = cai_wrapper(array)
+            _check_output_array(array_ai, dtype, n_rows, n_cols)
+            self.device_ptr = array_ai.data
+        else:
+            array_ai = ai_wrapper(array)
+            _check_output_array(array_ai, dtype, n_rows, n_cols)
+            self.host_ptr = array_ai.data
+            self.staging.reset(
+                new device_buffer(self.nbytes, handle_.get_stream()))
+            self.device_ptr = <uintptr_t>self.staging.get().data()
+        self.array = array
+
+    def copy_to_host(self, handle):
+        """Enqueue the copy of the results to the host array, if any."""
+        if self.host_ptr == 0:
+            return
+        cdef device_resources* handle_ = \
+            <device_resources*><size_t>handle.getHandle()
+        cdef cudaStream_t stream = handle_.get_stream().value()
+        cdef cudaError_t e
+        with nogil:
+            e = cudaMemcpyAsync(<void*>self.host_ptr,
+                                <const void*>self.device_ptr,
+                                self.nbytes,
+                                cudaMemcpyDeviceToHost,
+                                stream)
+        if e != cudaSuccess:
+            raise CudaRuntimeError("Copy of the search results to the host")
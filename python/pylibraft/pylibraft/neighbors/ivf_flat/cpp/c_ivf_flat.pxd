@@ -39,6 +39,7 @@ from pylibraft.common.cpp.mdspan cimport (
 )
 from pylibraft.common.cpp.optional cimport optional
 from pylibraft.common.handle cimport device_resources
+from pylibraft.common.mdspan cimport half
 from pylibraft.distance.distance_type cimport DistanceType
 from pylibraft.neighbors.ivf_pq.cpp.c_ivf_pq cimport (
     ann_index,
@@ -82,6 +83,11 @@ cdef extern from "raft_runtime/neighbors/ivf_flat.hpp" \
                     device_matrix_view[float, int64_t, row_major] dataset,
                     index[float, int64_t]& index) except +
 
+    cdef void build(const device_resources& handle,
+                    const index_params& params,
+                    device_matrix_view[half, int64_t, row_major] dataset,
+                    index[half, int64_t]& index) except +
+
     cdef void build(const device_resources& handle,
                     const index_params& params,
                     device_matrix_view[int8_t, int64_t, row_major] dataset,
@@ -98,6 +104,12 @@ cdef extern from "raft_runtime/neighbors/ivf_flat.hpp" \
         optional[device_vector_view[int64_t, int64_t]] new_indices,
         index[float, int64_t]* index) except +
 
+    cdef void extend(
+        const device_resources& handle,
+        device_matrix_view[half, int64_t, row_major] new_vectors,
+        optional[device_vector_view[int64_t, int64_t]] new_indices,
+        index[half, int64_t]* index) except +
+
     cdef void extend(
         const device_resources& handle,
         device_matrix_view[int8_t, int64_t, row_major] new_vectors,
@@ -118,6 +130,14 @@ cdef extern from "raft_runtime/neighbors/ivf_flat.hpp" \
         device_matrix_view[int64_t, int64_t, row_major] neighbors,
         device_matrix_view[float, int64_t, row_major] distances) except +
 
+    cdef void search(
+        const device_resources& handle,
+        const search_params& params,
+        const index[half, int64_t]& index,
+        device_matrix_view[half, int64_t, row_major] queries,
+        device_matrix_view[int64_t, int64_t, row_major] neighbors,
+        device_matrix_view[float, int64_t, row_major] distances) except +
+
     cdef void search(
         const device_resources& handle,
         const search_params& params,
@@ -142,6 +162,14 @@ cdef extern from "raft_runtime/neighbors/ivf_flat.hpp" \
                           const string& str,
                           index[float, int64_t]* index) except +
 
+    cdef void serialize(const device_resources& handle,
+                        string& str,
+                        const index[half, int64_t]& index) except +
+
+    cdef void deserialize(const device_resources& handle,
+                          const string& str,
+                          index[half, int64_t]* index) except +
+
     cdef void serialize(const device_resources& handle,
                         string& str,
                         const index[uint8_t, int64_t]& index) except +
@@ -166,6 +194,14 @@ cdef extern from "raft_runtime/neighbors/ivf_flat.hpp" \
                                const string& filename,
                                index[float, int64_t]* index) except +
 
+    cdef void serialize_file(const device_resources& handle,
+                             const string& filename,
+                             const index[half, int64_t]& index) except +
+
+    cdef void deserialize_file(const device_resources& handle,
+                               const string& filename,
+                               index[half, int64_t]* index) except +
+
     cdef void serialize_file(const device_resources& handle,
                              const string& filename,
                              const index[uint8_t, int64_t]& index) except +
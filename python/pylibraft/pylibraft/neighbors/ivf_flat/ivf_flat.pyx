@@ -33,7 +33,6 @@ from pylibraft.common import (
     DeviceResources,
     ai_wrapper,
     auto_convert_output,
-    device_ndarray,
 )
 from pylibraft.common.cai_wrapper import cai_wrapper
 
@@ -59,13 +58,18 @@ from rmm._lib.memory_resource cimport (
 cimport pylibraft.neighbors.ivf_flat.cpp.c_ivf_flat as c_ivf_flat
 from pylibraft.common.cpp.optional cimport optional
 
-from pylibraft.neighbors.common import _check_input_array, _get_metric
+from pylibraft.neighbors.common import (
+    _check_input_array,
+    _get_metric,
+    _SearchOutput,
+)
 
 from pylibraft.common.mdspan cimport (
     get_dmv_float,
+    get_dmv_float16,
     get_dmv_int8,
-    get_dmv_int64,
     get_dmv_uint8,
+    half,
 )
 from pylibraft.neighbors.common cimport _get_metric_string
 from pylibraft.neighbors.ivf_flat.cpp.c_ivf_flat cimport (
@@ -214,6 +218,55 @@ cdef class IndexFloat(Index):
         return self.index[0].adaptive_centers()
 
 
+cdef class IndexFloat16(Index):
+    cdef c_ivf_flat.index[half, int64_t] * index
+
+    def __cinit__(self, handle=None):
+        if handle is None:
+            handle = DeviceResources()
+        cdef device_resources* handle_ = \
+            <device_resources*><size_t>handle.getHandle()
+
+        # this is to keep track of which index type is being used
+        # We create a placeholder object. The actual parameter values do
+        # not matter, it will be replaced with a built index object later.
+        self.index = new c_ivf_flat.index[half, int64_t](
+            deref(handle_), _get_metric("sqeuclidean"),
+            <uint32_t>1,
+            <bool>False,
+            <bool>False,
+            <uint32_t>4)
+
+    def __repr__(self):
+        m_str = "metric=" + _get_metric_string(self.index.metric())
+        attr_str = [
+            attr + "=" + str(getattr(self, attr))
+            for attr in ["size", "dim", "n_lists", "adaptive_centers"]
+        ]
+        attr_str = [m_str] + attr_str
+        return "Index(type=IVF-FLAT, " + (", ".join(attr_str)) + ")"
+
+    @property
+    def dim(self):
+        return self.index[0].dim()
+
+    @property
+    def size(self):
+        return self.index[0].size()
+
+    @property
+    def metric(self):
+        return self.index[0].metric()
+
+    @property
+    def n_lists(self):
+        return self.index[0].n_lists()
+
+    @property
+    def adaptive_centers(self):
+        return self.index[0].adaptive_centers()
+
+
 cdef class IndexInt8(Index):
     cdef c_ivf_flat.index[int8_t, int64_t] * index
 
@@ -322,7 +375,7 @@ def build(IndexParams index_params, dataset, handle=None):
     ----------
     index_params : IndexParams object
     dataset : CUDA array interface compliant matrix shape (n_samples, dim)
-        Supported dtype [float, int8, uint8]
+        Supported dtype [float, float16, int8, uint8]
     {handle_docstring}
 
     Returns
@@ -366,8 +419,8 @@ def build(IndexParams index_params, dataset, handle=None):
     """
     dataset_cai = cai_wrapper(dataset)
     dataset_dt = dataset_cai.dtype
-    _check_input_array(dataset_cai, [np.dtype('float32'), np.dtype('byte'),
-                                     np.dtype('ubyte')])
+    _check_input_array(dataset_cai, [np.dtype('float32'), np.dtype('float16'),
+                                     np.dtype('byte'), np.dtype('ubyte')])
 
     cdef int64_t n_rows = dataset_cai.shape[0]
     cdef uint32_t dim = dataset_cai.shape[1]
@@ -378,6 +431,7 @@ def build(IndexParams index_params, dataset, handle=None):
         <device_resources*><size_t>handle.getHandle()
 
     cdef IndexFloat idx_float
+    cdef IndexFloat16 idx_float16
     cdef IndexInt8 idx_int8
     cdef IndexUint8 idx_uint8
 
@@ -391,6 +445,16 @@ def build(IndexParams index_params, dataset, handle=None):
                              deref(idx_float.index))
         idx_float.trained = True
         return idx_float
+    elif dataset_dt == np.float16:
+        idx_float16 = IndexFloat16(handle)
+        idx_float16.active_index_type = "float16"
+        with cuda_interruptible():
+            c_ivf_flat.build(deref(handle_),
+                             index_params.params,
+                             get_dmv_float16(dataset_cai, check_shape=True),
+                             deref(idx_float16.index))
+        idx_float16.trained = True
+        return idx_float16
     elif dataset_dt == np.byte:
         idx_int8 = IndexInt8(handle)
         idx_int8.active_index_type = "byte"
@@ -426,7 +490,7 @@ def extend(Index index, new_vectors, new_indices, handle=None):
     index : ivf_flat.Index
         Trained ivf_flat object.
     new_vectors : CUDA array interface compliant matrix shape (n_samples, dim)
-        Supported dtype [float, int8, uint8]
+        Supported dtype [float, float16, int8, uint8]
     new_indices : CUDA array interface compliant vector shape (n_samples)
         Supported dtype [int64]
     {handle_docstring}
@@ -497,6 +561,7 @@ def extend(Index index, new_vectors, new_indices, handle=None):
     cdef optional[device_vector_view[int64_t, int64_t]] new_indices_opt
 
     cdef IndexFloat idx_float
+    cdef IndexFloat16 idx_float16
     cdef IndexInt8 idx_int8
     cdef IndexUint8 idx_uint8
 
@@ -511,6 +576,17 @@ def extend(Index index, new_vectors, new_indices, handle=None):
                               get_dmv_float(vecs_cai, check_shape=True),
                               new_indices_opt,
                               idx_float.index)
+    elif vecs_dt == np.float16:
+        idx_float16 = index
+        if idx_float16.index[0].size() > 0:
+            new_indices_opt = make_device_vector_view(
+                <int64_t *><uintptr_t>idx_cai.data,
+                <int64_t>idx_cai.shape[0])
+        with cuda_interruptible():
+            c_ivf_flat.extend(deref(handle_),
+                              get_dmv_float16(vecs_cai, check_shape=True),
+                              new_indices_opt,
+                              idx_float16.index)
     elif vecs_dt == np.int8:
         idx_int8 = index
         if idx_int8.index[0].size() > 0:
@@ -581,15 +657,21 @@ def search(SearchParams search_params,
     index : Index
         Trained IVF-FLAT index.
     queries : CUDA array interface compliant matrix shape (n_samples, dim)
-        Supported dtype [float, int8, uint8]
+        Supported dtype [float, float16, int8, uint8]
     k : int
         The number of neighbors.
-    neighbors : Optional CUDA array interface compliant matrix shape
-                (n_queries, k), dtype int64_t. If supplied, neighbor
-                indices will be written here in-place. (default None)
-    distances : Optional CUDA array interface compliant matrix shape
-                (n_queries, k) If supplied, the distances to the
-                neighbors will be written here in-place. (default None)
+    neighbors : Optional CUDA array interface or array interface compliant
+                matrix shape (n_rows, k), n_rows >= n_queries, dtype int64_t.
+                If supplied, neighbor indices will be written to its first
+                n_queries rows. A host array (preferably pinned, see
+                `pylibraft.common.pinned_empty`) is filled with an
+                asynchronous copy in the stream of the handle.
+                (default None)
+    distances : Optional CUDA array interface or array interface compliant
+                matrix shape (n_rows, k), n_rows >= n_queries, dtype float.
+                If supplied, the distances to the neighbors will be written
+                to its first n_queries rows, like the neighbors.
+                (default None)
     {handle_docstring}
 
     Examples
@@ -658,22 +740,19 @@ def search(SearchParams search_params,
     _check_input_array(queries_cai, [np.dtype(index.active_index_type)],
                        exp_cols=index.dim)
 
-    if neighbors is None:
-        neighbors = device_ndarray.empty((n_queries, k), dtype='int64')
-
-    neighbors_cai = cai_wrapper(neighbors)
-    _check_input_array(neighbors_cai, [np.dtype('int64')],
-                       exp_rows=n_queries, exp_cols=k)
-
-    if distances is None:
-        distances = device_ndarray.empty((n_queries, k), dtype='float32')
-
-    distances_cai = cai_wrapper(distances)
-    _check_input_array(distances_cai, [np.dtype('float32')],
-                       exp_rows=n_queries, exp_cols=k)
+    neighbors_out = _SearchOutput(neighbors, n_queries, k, 'int64', handle)
+    distances_out = _SearchOutput(distances, n_queries, k, 'float32', handle)
+    cdef int64_t c_k = k
+    cdef device_matrix_view[int64_t, int64_t, row_major] neighbors_view = \
+        make_device_matrix_view[int64_t, int64_t, row_major](
+            <int64_t*><uintptr_t>neighbors_out.device_ptr, n_queries, c_k)
+    cdef device_matrix_view[float, int64_t, row_major] distances_view = \
+        make_device_matrix_view[float, int64_t, row_major](
+            <float*><uintptr_t>distances_out.device_ptr, n_queries, c_k)
 
     cdef c_ivf_flat.search_params params = search_params.params
     cdef IndexFloat idx_float
+    cdef IndexFloat16 idx_float16
     cdef IndexInt8 idx_int8
     cdef IndexUint8 idx_uint8
 
@@ -684,8 +763,17 @@ def search(SearchParams search_params,
                               params,
                               deref(idx_float.index),
                               get_dmv_float(queries_cai, check_shape=True),
-                              get_dmv_int64(neighbors_cai, check_shape=True),
-                              get_dmv_float(distances_cai, check_shape=True))
+                              neighbors_view,
+                              distances_view)
+    elif queries_dt == np.float16:
+        idx_float16 = index
+        with cuda_interruptible():
+            c_ivf_flat.search(deref(handle_),
+                              params,
+                              deref(idx_float16.index),
+                              get_dmv_float16(queries_cai, check_shape=True),
+                              neighbors_view,
+                              distances_view)
     elif queries_dt == np.byte:
         idx_int8 = index
         with cuda_interruptible():
@@ -693,8 +781,8 @@ def search(SearchParams search_params,
                               params,
                               deref(idx_int8.index),
                               get_dmv_int8(queries_cai, check_shape=True),
-                              get_dmv_int64(neighbors_cai, check_shape=True),
-                              get_dmv_float(distances_cai, check_shape=True))
+                              neighbors_view,
+                              distances_view)
     elif queries_dt == np.ubyte:
         idx_uint8 = index
         with cuda_interruptible():
@@ -702,12 +790,14 @@ def search(SearchParams search_params,
                               params,
                               deref(idx_uint8.index),
                               get_dmv_uint8(queries_cai, check_shape=True),
-                              get_dmv_int64(neighbors_cai, check_shape=True),
-                              get_dmv_float(distances_cai, check_shape=True))
+                              neighbors_view,
+                              distances_view)
     else:
         raise ValueError("query dtype %s not supported" % queries_dt)
 
-    return (distances, neighbors)
+    neighbors_out.copy_to_host(handle)
+    distances_out.copy_to_host(handle)
+    return (distances_out.array, neighbors_out.array)
 
 
 @auto_sync_handle
@@ -754,6 +844,7 @@ def save(filename, Index index, handle=None):
     cdef string c_filename = filename.encode('utf-8')
 
     cdef IndexFloat idx_float
+    cdef IndexFloat16 idx_float16
     cdef IndexInt8 idx_int8
     cdef IndexUint8 idx_uint8
 
@@ -761,6 +852,10 @@ def save(filename, Index index, handle=None):
         idx_float = index
         c_ivf_flat.serialize_file(
             deref(handle_), c_filename, deref(idx_float.index))
+    elif index.active_index_type == "float16":
+        idx_float16 = index
+        c_ivf_flat.serialize_file(
+            deref(handle_), c_filename, deref(idx_float16.index))
     elif index.active_index_type == "byte":
         idx_int8 = index
         c_ivf_flat.serialize_file(
@@ -827,6 +922,7 @@ def load(filename, handle=None):
 
     cdef string c_filename = filename.encode('utf-8')
     cdef IndexFloat idx_float
+    cdef IndexFloat16 idx_float16
     cdef IndexInt8 idx_int8
     cdef IndexUint8 idx_uint8
 
@@ -842,6 +938,13 @@ def load(filename, handle=None):
         idx_float.trained = True
         idx_float.active_index_type = 'float32'
         return idx_float
+    elif dataset_dt == np.float16:
+        idx_float16 = IndexFloat16(handle)
+        c_ivf_flat.deserialize_file(
+            deref(handle_), c_filename, idx_float16.index)
+        idx_float16.trained = True
+        idx_float16.active_index_type = 'float16'
+        return idx_float16
     elif dataset_dt == np.byte:
         idx_int8 = IndexInt8(handle)
         c_ivf_flat.deserialize_file(
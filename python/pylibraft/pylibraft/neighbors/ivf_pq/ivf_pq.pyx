@@ -34,7 +34,6 @@ from pylibraft.common import (
     ai_wrapper,
     auto_convert_output,
     cai_wrapper,
-    device_ndarray,
 )
 from pylibraft.common.cai_wrapper import wrap_array
 from pylibraft.common.interruptible import cuda_interruptible
@@ -53,18 +52,22 @@ cimport pylibraft.neighbors.ivf_flat.cpp.c_ivf_flat as c_ivf_flat
 cimport pylibraft.neighbors.ivf_pq.cpp.c_ivf_pq as c_ivf_pq
 from pylibraft.common.optional cimport make_optional, optional
 
-from pylibraft.neighbors.common import _check_input_array, _get_metric
+from pylibraft.neighbors.common import (
+    _check_input_array,
+    _get_metric,
+    _SearchOutput,
+)
 
 from pylibraft.common.cpp.mdspan cimport (
     device_matrix_view,
     device_vector_view,
+    make_device_matrix_view,
     make_device_vector_view,
     row_major,
 )
 from pylibraft.common.mdspan cimport (
     get_dmv_float,
     get_dmv_int8,
-    get_dmv_int64,
     get_dmv_uint8,
     make_optional_view_int64,
 )
@@ -597,12 +600,18 @@ def search(SearchParams search_params,
         Supported dtype [float, int8, uint8]
     k : int
         The number of neighbors.
-    neighbors : Optional CUDA array interface compliant matrix shape
-                (n_queries, k), dtype int64_t. If supplied, neighbor
-                indices will be written here in-place. (default None)
-    distances : Optional CUDA array interface compliant matrix shape
-                (n_queries, k) If supplied, the distances to the
-                neighbors will be written here in-place. (default None)
+    neighbors : Optional CUDA array interface or array interface compliant
+                matrix shape (n_rows, k), n_rows >= n_queries, dtype int64_t.
+                If supplied, neighbor indices will be written to its first
+                n_queries rows. A host array (preferably pinned, see
+                `pylibraft.common.pinned_empty`) is filled with an
+                asynchronous copy in the stream of the handle.
+                (default None)
+    distances : Optional CUDA array interface or array interface compliant
+                matrix shape (n_rows, k), n_rows >= n_queries, dtype float.
+                If supplied, the distances to the neighbors will be written
+                to its first n_queries rows, like the neighbors.
+                (default None)
     memory_resource : RMM DeviceMemoryResource object, optional
         This can be used to explicitly manage the temporary memory
         allocation during search. Passing a pooling allocator can reduce
@@ -674,24 +683,18 @@ def search(SearchParams search_params,
                                      np.dtype('ubyte')],
                        exp_cols=index.dim)
 
-    if neighbors is None:
-        neighbors = device_ndarray.empty((n_queries, k), dtype='int64')
-
-    neighbors_cai = cai_wrapper(neighbors)
-    _check_input_array(neighbors_cai, [np.dtype('int64')],
-                       exp_rows=n_queries, exp_cols=k)
-
-    if distances is None:
-        distances = device_ndarray.empty((n_queries, k), dtype='float32')
-
-    distances_cai = cai_wrapper(distances)
-    _check_input_array(distances_cai, [np.dtype('float32')],
-                       exp_rows=n_queries, exp_cols=k)
+    neighbors_out = _SearchOutput(neighbors, n_queries, k, 'int64', handle)
+    distances_out = _SearchOutput(distances, n_queries, k, 'float32', handle)
+    cdef int64_t c_k = k
+    cdef device_matrix_view[int64_t, int64_t, row_major] neighbors_view = \
+        make_device_matrix_view[int64_t, int64_t, row_major](
+            <int64_t*><uintptr_t>neighbors_out.device_ptr, n_queries, c_k)
+    cdef device_matrix_view[float, int64_t, row_major] distances_view = \
+        make_device_matrix_view[float, int64_t, row_major](
+            <float*><uintptr_t>distances_out.device_ptr, n_queries, c_k)
 
     cdef c_ivf_pq.search_params params = search_params.params
 
-    cdef uintptr_t neighbors_ptr = neighbors_cai.data
-    cdef uintptr_t distances_ptr = distances_cai.data
     # TODO(tfeher) pass mr_ptr arg
     cdef device_memory_resource* mr_ptr = <device_memory_resource*> nullptr
     if memory_resource is not None:
@@ -703,28 +706,30 @@ def search(SearchParams search_params,
                             params,
                             deref(index.index),
                             get_dmv_float(queries_cai, check_shape=True),
-                            get_dmv_int64(neighbors_cai, check_shape=True),
-                            get_dmv_float(distances_cai, check_shape=True))
+                            neighbors_view,
+                            distances_view)
     elif queries_dt == np.byte:
         with cuda_interruptible():
             c_ivf_pq.search(deref(handle_),
                             params,
                             deref(index.index),
                             get_dmv_int8(queries_cai, check_shape=True),
-                            get_dmv_int64(neighbors_cai, check_shape=True),
-                            get_dmv_float(distances_cai, check_shape=True))
+                            neighbors_view,
+                            distances_view)
     elif queries_dt == np.ubyte:
         with cuda_interruptible():
             c_ivf_pq.search(deref(handle_),
                             params,
                             deref(index.index),
                             get_dmv_uint8(queries_cai, check_shape=True),
-                            get_dmv_int64(neighbors_cai, check_shape=True),
-                            get_dmv_float(distances_cai, check_shape=True))
+                            neighbors_view,
+                            distances_view)
     else:
         raise ValueError("query dtype %s not supported" % queries_dt)
 
-    return (distances, neighbors)
+    neighbors_out.copy_to_host(handle)
+    distances_out.copy_to_host(handle)
+    return (distances_out.array, neighbors_out.array)
 
 
 @auto_sync_handle
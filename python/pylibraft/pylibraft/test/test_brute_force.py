@@ -17,7 +17,12 @@ import numpy as np
 import pytest
 from scipy.spatial.distance import cdist
 
-from pylibraft.common import DeviceResources, Stream, device_ndarray
+from pylibraft.common import (
+    DeviceResources,
+    Stream,
+    device_ndarray,
+    pinned_empty,
+)
 from pylibraft.neighbors.brute_force import knn
 
 
@@ -109,3 +114,86 @@ def test_knn_check_col_major_inputs():
 
     # shouldn't throw an exception with c-contiguous inputs
     knn(index, queries, k=4)
+
+
+@pytest.mark.parametrize("output", ["device", "host", "pinned"])
+def test_knn_reused_outputs(output):
+    n_index_rows, n_cols, k = 1000, 16, 8
+    max_queries = 100
+    index = np.random.random_sample((n_index_rows, n_cols)).astype("float32")
+    index_device = device_ndarray(index)
+
+    # one buffer, larger than any batch, for all the searches
+    if output == "device":
+        indices = device_ndarray.empty((max_queries, k), dtype="int64")
+        distances = device_ndarray.empty((max_queries, k), dtype="float32")
+    elif output == "host":
+        indices = np.zeros((max_queries, k), dtype="int64")
+        distances = np.zeros((max_queries, k), dtype="float32")
+    else:
+        indices = pinned_empty((max_queries, k), dtype="int64")
+        distances = pinned_empty((max_queries, k), dtype="float32")
+
+    handle = DeviceResources(stream=Stream())
+    for n_queries in [max_queries, 10, 37]:
+        queries = np.random.random_sample((n_queries, n_cols)).astype(
+            "float32"
+        )
+        ret_distances, ret_indices = knn(
+            index_device,
+            device_ndarray(queries),
+            k,
+            indices=indices,
+            distances=distances,
+            handle=handle,
+        )
+        assert ret_indices is indices
+        assert ret_distances is distances
+        handle.sync()
+
+        if output == "device":
+            actual_indices = indices.copy_to_host()[:n_queries]
+            actual_distances = distances.copy_to_host()[:n_queries]
+        else:
+            actual_indices = indices[:n_queries]
+            actual_distances = distances[:n_queries]
+
+        pw_dists = cdist(queries, index, metric="sqeuclidean")
+        expected_indices = np.argsort(pw_dists, axis=1)[:, :k]
+        np.testing.assert_allclose(
+            np.take_along_axis(pw_dists, expected_indices, axis=1),
+            actual_distances,
+            atol=1e-4,
+            rtol=1e-4,
+        )
+        np.testing.assert_allclose(
+            np.take_along_axis(pw_dists, actual_indices, axis=1),
+            actual_distances,
+            atol=1e-4,
+            rtol=1e-4,
+        )
+
+    # a buffer with fewer rows than the queries is rejected
+    with pytest.raises(ValueError):
+        knn(
+            index_device,
+            device_ndarray(
+                np.random.random_sample((max_queries + 1, n_cols)).astype(
+                    "float32"
+                )
+            ),
+            k,
+            indices=indices,
+            distances=distances,
+        )
+
+
+def test_pinned_empty():
+    a = pinned_empty((3, 4), dtype="int64")
+    assert isinstance(a, np.ndarray)
+    assert a.shape == (3, 4)
+    assert a.dtype == np.int64
+    assert a.flags.c_contiguous
+    a[:] = 7
+    assert np.all(a == 7)
+    assert pinned_empty(5).shape == (5,)
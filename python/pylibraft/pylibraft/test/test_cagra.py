@@ -0,0 +1,288 @@
+# Copyright (c) 2023, NVIDIA CORPORATION.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     h ttp://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+import threading
+
+import numpy as np
+import pytest
+from sklearn.neighbors import NearestNeighbors
+
+from pylibraft.common import DeviceResources, Stream, device_ndarray
+from pylibraft.neighbors import cagra
+
+
+def generate_data(shape, dtype):
+    if dtype == np.byte:
+        x = np.random.randint(-127, 128, size=shape, dtype=np.byte)
+    elif dtype == np.ubyte:
+        x = np.random.randint(0, 255, size=shape, dtype=np.ubyte)
+    else:
+        x = np.random.random_sample(shape).astype(dtype)
+
+    return x
+
+
+def calc_recall(ann_idx, true_nn_idx):
+    assert ann_idx.shape == true_nn_idx.shape
+    n = 0
+    for i in range(ann_idx.shape[0]):
+        n += np.intersect1d(ann_idx[i, :], true_nn_idx[i, :]).size
+    recall = n / ann_idx.size
+    return recall
+
+
+def brute_force_knn(dataset, queries, k):
+    nn_skl = NearestNeighbors(
+        n_neighbors=k, algorithm="brute", metric="sqeuclidean"
+    )
+    nn_skl.fit(dataset)
+    return nn_skl.kneighbors(queries, return_distance=False)
+
+
+def run_cagra_build_search_test(
+    n_rows=10000,
+    n_cols=10,
+    n_queries=100,
+    k=10,
+    dtype=np.float32,
+    intermediate_graph_degree=128,
+    graph_degree=64,
+    build_algo="ivf_pq",
+    search_params=None,
+    inplace=True,
+    array_type="device",
+):
+    dataset = generate_data((n_rows, n_cols), dtype)
+    dataset_device = device_ndarray(dataset)
+
+    build_params = cagra.IndexParams(
+        intermediate_graph_degree=intermediate_graph_degree,
+        graph_degree=graph_degree,
+        build_algo=build_algo,
+    )
+
+    if array_type == "device":
+        index = cagra.build(build_params, dataset_device)
+    else:
+        index = cagra.build(build_params, dataset)
+
+    assert index.trained
+    assert index.size == n_rows
+    assert index.dim == n_cols
+    assert index.graph_degree == graph_degree
+
+    queries = generate_data((n_queries, n_cols), dtype)
+    out_idx = np.zeros((n_queries, k), dtype=np.uint32)
+    out_dist = np.zeros((n_queries, k), dtype=np.float32)
+
+    queries_device = device_ndarray(queries)
+    out_idx_device = device_ndarray(out_idx) if inplace else None
+    out_dist_device = device_ndarray(out_dist) if inplace else None
+
+    if search_params is None:
+        search_params = cagra.SearchParams()
+
+    ret_output = cagra.search(
+        search_params,
+        index,
+        queries_device,
+        k,
+        neighbors=out_idx_device,
+        distances=out_dist_device,
+    )
+
+    if not inplace:
+        out_dist_device, out_idx_device = ret_output
+
+    out_idx = out_idx_device.copy_to_host()
+    out_dist = out_dist_device.copy_to_host()
+
+    skl_idx = brute_force_knn(dataset, queries, k)
+    recall = calc_recall(out_idx, skl_idx)
+    assert recall > 0.7
+
+    # the distances are the squared euclidean distances to the neighbors
+    ref_dist = (
+        (
+            queries[:, np.newaxis, :].astype(np.float32)
+            - dataset[out_idx.astype(np.int64), :].astype(np.float32)
+        )
+        ** 2
+    ).sum(axis=2)
+    assert np.allclose(out_dist, ref_dist, rtol=1e-3, atol=1e-3)
+
+
+@pytest.mark.parametrize("inplace", [True, False])
+@pytest.mark.parametrize("dtype", [np.float32, np.int8, np.uint8])
+@pytest.mark.parametrize("array_type", ["device", "host"])
+def test_cagra_dtypes(inplace, dtype, array_type):
+    run_cagra_build_search_test(
+        dtype=dtype, inplace=inplace, array_type=array_type
+    )
+
+
+@pytest.mark.parametrize(
+    "params",
+    [
+        {"intermediate_graph_degree": 64, "graph_degree": 32},
+        {"intermediate_graph_degree": 32, "graph_degree": 16},
+        {"build_algo": "nn_descent"},
+    ],
+)
+def test_cagra_index_params(params):
+    run_cagra_build_search_test(**params)
+
+
+@pytest.mark.parametrize(
+    "params",
+    [
+        {"algo": "single_cta"},
+        {"algo": "multi_cta"},
+        {"algo": "multi_kernel"},
+        {"max_queries": 16, "itopk_size": 128},
+        {"search_width": 2, "hashmap_mode": "hash"},
+    ],
+)
+def test_cagra_search_params(params):
+    search_params = cagra.SearchParams(**params)
+    for key, value in params.items():
+        assert getattr(search_params, key) == value
+    run_cagra_build_search_test(search_params=search_params)
+
+
+def test_params_assertions():
+    with pytest.raises(ValueError):
+        cagra.IndexParams(build_algo="brute_force")
+    with pytest.raises(ValueError):
+        cagra.SearchParams(algo="single_thread")
+    with pytest.raises(ValueError):
+        cagra.SearchParams(hashmap_mode="dense")
+
+
+def test_search_inputs():
+    n_rows = 1000
+    n_cols = 10
+    k = 10
+    dataset = device_ndarray(generate_data((n_rows, n_cols), np.float32))
+    index = cagra.build(cagra.IndexParams(), dataset)
+
+    # wrong number of columns
+    queries = device_ndarray(generate_data((10, n_cols + 1), np.float32))
+    with pytest.raises(ValueError):
+        cagra.search(cagra.SearchParams(), index, queries, k)
+
+    # wrong dtype of the queries
+    queries = device_ndarray(generate_data((10, n_cols), np.uint8))
+    with pytest.raises(TypeError):
+        cagra.search(cagra.SearchParams(), index, queries, k)
+
+    # wrong dtype of the neighbors
+    queries = device_ndarray(generate_data((10, n_cols), np.float32))
+    neighbors = device_ndarray(np.zeros((10, k), dtype=np.int64))
+    with pytest.raises(TypeError):
+        cagra.search(
+            cagra.SearchParams(), index, queries, k, neighbors=neighbors
+        )
+
+
+def test_search_async_threads():
+    n_rows = 10000
+    n_cols = 10
+    n_queries = 100
+    k = 10
+    n_threads = 4
+
+    dataset = generate_data((n_rows, n_cols), np.float32)
+    index = cagra.build(cagra.IndexParams(), device_ndarray(dataset))
+    queries = [
+        generate_data((n_queries, n_cols), np.float32)
+        for _ in range(n_threads)
+    ]
+    results = [None] * n_threads
+
+    def search(i):
+        # every thread searches on its own stream, without synchronizing
+        # until all of its queries are enqueued
+        handle = DeviceResources(stream=Stream())
+        queries_device = device_ndarray(queries[i])
+        outputs = [
+            cagra.search(
+                cagra.SearchParams(), index, queries_device, k, handle=handle
+            )
+            for _ in range(3)
+        ]
+        handle.sync()
+        results[i] = [n.copy_to_host() for _, n in outputs]
+
+    threads = [
+        threading.Thread(target=search, args=(i,)) for i in range(n_threads)
+    ]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+
+    for i in range(n_threads):
+        skl_idx = brute_force_knn(dataset, queries[i], k)
+        for neighbors in results[i]:
+            assert calc_recall(neighbors, skl_idx) > 0.7
+            assert np.all(neighbors == results[i][0])
+
+
+@pytest.mark.parametrize("dtype", [np.float32, np.int8, np.ubyte])
+def test_save_load(dtype):
+    n_rows = 10000
+    n_cols = 50
+    n_queries = 1000
+
+    dataset = generate_data((n_rows, n_cols), dtype)
+    dataset_device = device_ndarray(dataset)
+
+    build_params = cagra.IndexParams()
+    index = cagra.build(build_params, dataset_device)
+
+    assert index.trained
+    filename = "my_index.bin"
+    cagra.save(filename, index)
+    loaded_index = cagra.load(filename)
+
+    assert index.metric == loaded_index.metric
+    assert index.size == loaded_index.size
+    assert index.dim == loaded_index.dim
+    assert index.graph_degree == loaded_index.graph_degree
+
+    queries = generate_data((n_queries, n_cols), dtype)
+
+    queries_device = device_ndarray(queries)
+    search_params = cagra.SearchParams()
+    k = 10
+
+    distance_dev, neighbors_dev = cagra.search(
+        search_params, index, queries_device, k
+    )
+
+    neighbors = neighbors_dev.copy_to_host()
+    dist = distance_dev.copy_to_host()
+    del index
+
+    distance_dev, neighbors_dev = cagra.search(
+        search_params, loaded_index, queries_device, k
+    )
+
+    neighbors2 = neighbors_dev.copy_to_host()
+    dist2 = distance_dev.copy_to_host()
+
+    assert np.all(neighbors == neighbors2)
+    assert np.allclose(dist, dist2, rtol=1e-6)
@@ -182,7 +182,7 @@ def run_ivf_flat_build_search_test(
 @pytest.mark.parametrize("n_cols", [10])
 @pytest.mark.parametrize("n_queries", [100])
 @pytest.mark.parametrize("n_lists", [100])
-@pytest.mark.parametrize("dtype", [np.float32, np.int8, np.uint8])
+@pytest.mark.parametrize("dtype", [np.float32, np.float16, np.int8, np.uint8])
 @pytest.mark.parametrize("array_type", ["device"])
 def test_ivf_pq_dtypes(
     n_rows, n_cols, n_queries, n_lists, dtype, inplace, array_type
@@ -312,7 +312,7 @@ def test_ivf_pq_search_params(params):
     )
 
 
-@pytest.mark.parametrize("dtype", [np.float32, np.int8, np.uint8])
+@pytest.mark.parametrize("dtype", [np.float32, np.float16, np.int8, np.uint8])
 @pytest.mark.parametrize("array_type", ["device"])
 def test_extend(dtype, array_type):
     run_ivf_flat_build_search_test(
@@ -29,5 +29,8 @@ from .comms_utils import (
     perform_test_comms_reduce,
     perform_test_comms_reducescatter,
     perform_test_comms_send_recv,
+    perform_test_comms_stream_send_recv,
+    perform_test_hierarchical_comms,
+    perform_test_topk_allreduce,
 )
 from .ucx import UCX
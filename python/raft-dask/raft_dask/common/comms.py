@@ -13,15 +13,18 @@
 # limitations under the License.
 #
 
+import asyncio
 import logging
 import os
+import threading
 import time
 import uuid
 import warnings
 from collections import Counter, OrderedDict
 
-from dask.distributed import default_client
+from dask.distributed import default_client, get_worker
 from dask_cuda.utils import nvml_device_index
+from distributed.utils import sync
 
 from pylibraft.common.handle import Handle
 
@@ -79,10 +82,17 @@ class Comms:
         comms.destroy()
         client.close()
         cluster.close()
+
+    Sessions are costly to create on large clusters: jobs that run one
+    after the other on the same workers can share a session with
+    `Comms.get()`, which only initializes a new one the first time.
     """
 
     valid_nccl_placements = ("client", "worker", "scheduler")
 
+    # Sessions shared through `Comms.get()`, by client and configuration
+    _shared_sessions = {}
+
     def __init__(
         self,
         comms_p2p=False,
@@ -90,6 +100,7 @@ class Comms:
         verbose=False,
         streams_per_handle=0,
         nccl_root_location="scheduler",
+        lazy_endpoints=False,
     ):
         """
         Construct a new CommsContext instance
@@ -105,6 +116,11 @@ class Comms:
         nccl_root_location : string
                   Indicates where the NCCL's root node should be located.
                   ['client', 'worker', 'scheduler' (default)]
+        lazy_endpoints : bool
+                  Only with `comms_p2p`: connect the UCX endpoints of a
+                  worker when `local_handle()` is first called on it rather
+                  than in `init()`. Workers that never ask for their handle
+                  never connect to their peers.
 
         """
         self.client = client if client is not None else default_client()
@@ -119,6 +135,7 @@ class Comms:
             )
 
         self.streams_per_handle = streams_per_handle
+        self.lazy_endpoints = lazy_endpoints
 
         self.sessionId = uuid.uuid4().bytes
 
@@ -134,6 +151,52 @@ class Comms:
         if self.nccl_initialized or self.ucx_initialized:
             self.destroy()
 
+    @classmethod
+    def get(cls, client=None, workers=None, **kwargs):
+        """
+        Returns an initialized session over the workers, reusing the session
+        created by a previous call with the same client, workers and
+        arguments while all of its workers are alive.
+
+        Parameters
+        ----------
+        client : dask.distributed.Client [optional]
+                 Dask client to use
+        workers : Sequence
+                  Unique collection of workers for initializing comms.
+                  (default: all the workers of the client)
+        kwargs : the other arguments of the `Comms` constructor
+
+        Returns
+        -------
+        comms : Comms
+                The session must not be destroyed while other jobs may still
+                share it; `destroy()` removes it from the shared sessions.
+        """
+        client = client if client is not None else default_client()
+        if workers is None:
+            workers = client.scheduler_info()["workers"].keys()
+        workers = tuple(OrderedDict.fromkeys(workers))
+        key = (id(client), workers, tuple(sorted(kwargs.items())))
+
+        comms = cls._shared_sessions.get(key)
+        if comms is not None:
+            alive = client.run(
+                _func_has_session, comms.sessionId, workers=list(workers)
+            )
+            if len(alive) == len(workers) and all(alive.values()):
+                return comms
+            cls._shared_sessions.pop(key)
+            try:
+                comms.destroy()
+            except Exception as e:
+                logger.warning(f"Could not destroy a stale session: {e}")
+
+        comms = cls(client=client, **kwargs)
+        comms.init(workers=list(workers))
+        cls._shared_sessions[key] = comms
+        return comms
+
     def create_nccl_uniqueid(self):
         if self.nccl_root_location == "client":
             self.uniqueId = nccl.get_unique_id()
@@ -205,6 +268,7 @@ class Comms:
             worker_info,
             self.verbose,
             self.streams_per_handle,
+            self.lazy_endpoints,
             workers=self.worker_addresses,
             wait=True,
         )
@@ -223,6 +287,10 @@ class Comms:
         be called automatically by the Comms destructor, but may be called
         earlier to save resources.
         """
+        for key, comms in list(Comms._shared_sessions.items()):
+            if comms is self:
+                del Comms._shared_sessions[key]
+
         self.client.run(
             _func_destroy_all,
             self.sessionId,
@@ -247,7 +315,9 @@ class Comms:
 def local_handle(sessionId, dask_worker=None):
     """
     Simple helper function for retrieving the local handle_t instance
-    for a comms session on a worker.
+    for a comms session on a worker. With `lazy_endpoints`, the first call
+    on a worker connects its UCX endpoints and builds the handle; it must
+    be made from a task rather than from the event loop of the worker.
 
     Parameters
     ----------
@@ -261,7 +331,10 @@ def local_handle(sessionId, dask_worker=None):
     -------
     handle : raft.Handle or None
     """
+    dask_worker = dask_worker if dask_worker is not None else get_worker()
     state = get_raft_comm_state(sessionId, dask_worker)
+    if "handle" not in state and "lazy_p2p" in state:
+        _func_build_handle_lazy(sessionId, dask_worker)
     return state["handle"] if "handle" in state else None
 
 
@@ -430,6 +503,7 @@ async def _func_init_all(
     worker_info,
     verbose,
     streams_per_handle,
+    lazy_endpoints=False,
     dask_worker=None,
 ):
     raft_comm_state = get_raft_comm_state(
@@ -451,7 +525,16 @@ async def _func_init_all(
             topic="info", msg=f"NCCL Initialization took: {elapsed} seconds."
         )
 
-    if comms_p2p:
+    if comms_p2p and lazy_endpoints:
+        # The listener must be up for the peers, the endpoints can wait.
+        raft_comm_state["lazy_p2p"] = {
+            "worker_info": worker_info,
+            "streams_per_handle": streams_per_handle,
+            "verbose": verbose,
+            "lock": threading.Lock(),
+        }
+
+    elif comms_p2p:
         if verbose:
             dask_worker.log_event(
                 topic="info", msg="Initializing UCX Endpoints"
@@ -597,6 +680,43 @@ def _func_build_handle(
     raft_comm_state["handle"] = handle
 
 
+def _func_build_handle_lazy(sessionId, dask_worker):
+    """
+    Connects the UCX endpoints of a session created with `lazy_endpoints`
+    and builds its handle_t, once per worker.
+
+    Parameters
+    ----------
+    sessionId : str id to reference state for current comms instance.
+    dask_worker : dask_worker object
+    """
+    raft_comm_state = get_raft_comm_state(
+        sessionId=sessionId, state_object=dask_worker
+    )
+    lazy_p2p = raft_comm_state["lazy_p2p"]
+    with lazy_p2p["lock"]:
+        if "handle" in raft_comm_state:
+            return
+        sync(
+            dask_worker.loop,
+            _func_ucp_create_endpoints,
+            sessionId,
+            lazy_p2p["worker_info"],
+            dask_worker,
+        )
+        _func_build_handle_p2p(
+            sessionId,
+            lazy_p2p["streams_per_handle"],
+            lazy_p2p["verbose"],
+            dask_worker=dask_worker,
+        )
+
+
+def _func_has_session(sessionId, dask_worker=None):
+    state = getattr(dask_worker, "_raft_comm_state", {})
+    return sessionId in state and "nccl" in state[sessionId]
+
+
 def _func_store_initial_state(
     nworkers, sessionId, uniqueId, wid, dask_worker=None
 ):
@@ -622,18 +742,16 @@ async def _func_ucp_create_endpoints(sessionId, worker_info, dask_worker):
                   (Note: if called by client.run(), this is supplied by Dask
                    and not the client)
     """
-    eps = [None] * len(worker_info)
-    count = 1
-
-    for k in worker_info:
-        ip, port = parse_host_port(k)
-
-        ep = await get_ucx(dask_worker=dask_worker).get_endpoint(
-            ip, worker_info[k]["port"]
-        )
+    ucx = get_ucx(dask_worker=dask_worker)
 
+    # Connect to all the peers concurrently rather than one after the other.
+    eps = [None] * len(worker_info)
+    connections = [
+        ucx.get_endpoint(parse_host_port(k)[0], worker_info[k]["port"])
+        for k in worker_info
+    ]
+    for k, ep in zip(worker_info, await asyncio.gather(*connections)):
         eps[worker_info[k]["rank"]] = ep
-        count += 1
 
     raft_comm_state = get_raft_comm_state(
         sessionId=sessionId, state_object=dask_worker
@@ -673,9 +791,11 @@ async def _func_destroy_all(
             msg=f"Destroying CUDA handle for sessionId, '{sessionId}.'",
         )
 
+    # A lazy session has no handle until it is used
+    lazy = raft_comm_state.pop("lazy_p2p", None) is not None
     if "handle" in raft_comm_state:
         del raft_comm_state["handle"]
-    else:
+    elif not lazy:
         if verbose:
             dask_worker.log_event(
                 topic="warning",
@@ -66,6 +66,8 @@ cdef extern from "raft/comms/comms_test.hpp" namespace "raft::comms":
         except +
     bool test_pointToPoint_simple_send_recv(const device_resources &h,
                                             int numTrials) except +
+    bool test_pointToPoint_stream_send_recv(const device_resources &h,
+                                            int numTrials) except +
     bool test_pointToPoint_device_send_or_recv(const device_resources &h,
                                                int numTrials) except +
     bool test_pointToPoint_device_sendrecv(const device_resources &h,
@@ -73,6 +75,10 @@ cdef extern from "raft/comms/comms_test.hpp" namespace "raft::comms":
     bool test_pointToPoint_device_multicast_sendrecv(const device_resources &h,
                                                      int numTrials) except +
     bool test_commsplit(const device_resources &h, int n_colors) except +
+    bool test_hierarchical_comms(const device_resources &h,
+                                 int ranks_per_node) except +
+    bool test_topk_allreduce(const device_resources &h, int n_ranks,
+                             bool ties) except +
 
 
 def perform_test_comms_allreduce(handle, root):
@@ -193,6 +199,22 @@ def perform_test_comms_send_recv(handle, n_trials):
     return test_pointToPoint_simple_send_recv(deref(h), <int>n_trials)
 
 
+def perform_test_comms_stream_send_recv(handle, n_trials):
+    """
+    Performs a stream-ordered p2p send/recv on the current worker
+
+    Parameters
+    ----------
+    handle : raft.common.Handle
+             handle containing comms_t to use
+    n_trials : int
+               Number of test trials
+    """
+    cdef const device_resources *h = \
+        <device_resources*><size_t>handle.getHandle()
+    return test_pointToPoint_stream_send_recv(deref(h), <int>n_trials)
+
+
 def perform_test_comms_device_send_or_recv(handle, n_trials):
     """
     Performs a p2p device send or recv on the current worker
@@ -255,6 +277,44 @@ def perform_test_comm_split(handle, n_colors):
     return test_commsplit(deref(h), < int > n_colors)
 
 
+def perform_test_hierarchical_comms(handle, ranks_per_node):
+    """
+    Performs the hierarchical allreduce, allgather and allgather_topk on
+    the current worker
+
+    Parameters
+    ----------
+    handle : raft.common.Handle
+             handle containing comms_t to use
+    ranks_per_node : int
+                     If positive, the number of consecutive ranks grouped in
+                     a node instead of by host name
+    """
+    cdef const device_resources *h = \
+        <device_resources*><size_t>handle.getHandle()
+    return test_hierarchical_comms(deref(h), <int>ranks_per_node)
+
+
+def perform_test_topk_allreduce(handle, n_ranks, ties):
+    """
+    Performs a top-k allreduce on the current worker and compares it with
+    a select_k over the gathered lists
+
+    Parameters
+    ----------
+    handle : raft.common.Handle
+             handle containing comms_t to use
+    n_ranks : int
+              If positive and less than the number of workers, the check
+              runs on a communicator split from the n_ranks first workers
+    ties : bool
+           Whether the candidates share their distances
+    """
+    cdef const device_resources *h = \
+        <device_resources*><size_t>handle.getHandle()
+    return test_topk_allreduce(deref(h), <int>n_ranks, <bool>ties)
+
+
 def inject_comms_on_handle_coll_only(handle, nccl_inst, size, rank, verbose):
     """
     Given a handle and initialized nccl comm, creates a comms_t
@@ -13,6 +13,8 @@
 # limitations under the License.
 #
 
+import asyncio
+
 import ucp
 
 
@@ -35,6 +37,7 @@ class UCX:
 
         self._create_listener()
         self._endpoints = {}
+        self._pending_endpoints = {}
         self._server_endpoints = []
 
         assert UCX.__instance is None
@@ -65,12 +68,18 @@ class UCX:
         self._server_endpoints.append(ep)
 
     async def get_endpoint(self, ip, port):
-        if (ip, port) not in self._endpoints:
-            ep = await self._create_endpoint(ip, port)
-        else:
-            ep = self._endpoints[(ip, port)]
-
-        return ep
+        if (ip, port) in self._endpoints:
+            return self._endpoints[(ip, port)]
+
+        # Concurrent requests for the same peer share a single connection.
+        if (ip, port) not in self._pending_endpoints:
+            self._pending_endpoints[(ip, port)] = asyncio.ensure_future(
+                self._create_endpoint(ip, port)
+            )
+        try:
+            return await asyncio.shield(self._pending_endpoints[(ip, port)])
+        finally:
+            self._pending_endpoints.pop((ip, port), None)
 
     async def close_endpoints(self):
         for k, ep in self._endpoints.items():
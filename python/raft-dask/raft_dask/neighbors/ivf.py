@@ -0,0 +1,339 @@
+# Copyright (c) 2023, NVIDIA CORPORATION.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+import uuid
+from collections import OrderedDict
+
+import numpy as np
+
+from dask.distributed import futures_of, get_worker, wait
+
+from pylibraft.common import device_ndarray
+from pylibraft.neighbors import ivf_flat, ivf_pq
+
+from raft_dask.common.utils import get_client
+
+_algos = {"ivf_flat": ivf_flat, "ivf_pq": ivf_pq}
+
+
+class DistributedIndex:
+    """
+    An IVF-Flat or IVF-PQ index sharded across the workers of a Dask
+    cluster. Each worker holds a local index over the partitions of the
+    dataset it stores; the global ids of the vectors are their row numbers
+    in the dataset.
+
+    Instances are created by :func:`build`. The local indices stay in the
+    memory of the workers until `destroy()` is called.
+    """
+
+    def __init__(self, client, index_id, algo, metric, workers, size, dim):
+        self.client = client
+        self.index_id = index_id
+        self.algo = algo
+        self.metric = metric
+        self.workers = workers
+        self.size = size
+        self.dim = dim
+
+    def __repr__(self):
+        return (
+            f"DistributedIndex(algo={self.algo}, metric={self.metric}, "
+            f"size={self.size}, dim={self.dim}, "
+            f"n_workers={len(self.workers)})"
+        )
+
+    def shard_sizes(self):
+        """
+        Returns a dictionary { worker_address : number of vectors }
+        """
+        return self.client.run(
+            _func_shard_size, self.index_id, workers=self.workers, wait=True
+        )
+
+    def destroy(self):
+        """
+        Frees the local indices on the workers.
+        """
+        self.client.run(
+            _func_destroy, self.index_id, workers=self.workers, wait=True
+        )
+        self.workers = []
+
+
+def build(dataset, algo="ivf_pq", index_params=None, client=None):
+    """
+    Builds a distributed IVF index over a Dask array.
+
+    The index is sharded by the partitions of the dataset: every worker
+    builds an index with pylibraft over the partitions it already holds, so
+    the dataset is never moved between the workers. A search broadcasts the
+    queries to all the shards and merges their top-k results (see
+    :func:`search`).
+
+    Parameters
+    ----------
+    dataset : dask.array.Array shape (n_samples, dim)
+        Partitioned by rows, backed by CuPy or NumPy arrays. Supported dtype
+        [float, int8, uint8] (and float16 for IVF-Flat).
+    algo : string, "ivf_pq" (default) or "ivf_flat"
+    index_params : dict
+        Keyword arguments of the `IndexParams` of the pylibraft algorithm,
+        e.g. `{"n_lists": 1024, "pq_dim": 64}`. The number of lists is per
+        shard.
+    client : dask.distributed.Client [optional]
+        Dask client to use
+
+    Returns
+    -------
+    index : DistributedIndex
+
+    Examples
+    --------
+    .. code-block:: python
+
+        import cupy as cp
+        import dask.array as da
+
+        from dask_cuda import LocalCUDACluster
+        from dask.distributed import Client
+
+        from raft_dask.neighbors import ivf
+
+        cluster = LocalCUDACluster()
+        client = Client(cluster)
+
+        dataset = da.random.random((1000000, 128), chunks=(100000, 128))
+        dataset = dataset.map_blocks(cp.asarray).astype(cp.float32)
+        queries = cp.random.random_sample((1000, 128), dtype=cp.float32)
+
+        index = ivf.build(dataset, "ivf_pq", {"n_lists": 256})
+        distances, neighbors = ivf.search(
+            index, queries, k=10, search_params={"n_probes": 20}
+        )
+        index.destroy()
+    """
+    client = get_client(client)
+    if algo not in _algos:
+        raise ValueError(
+            f"algo must be one of {tuple(_algos.keys())}, got {algo}"
+        )
+    if not hasattr(dataset, "chunks") or dataset.ndim != 2:
+        raise TypeError("dataset must be a 2D dask array")
+    index_params = {} if index_params is None else dict(index_params)
+    metric = index_params.get("metric", "sqeuclidean")
+
+    # Every block must hold whole rows for the row offsets to be the ids.
+    if len(dataset.chunks[1]) > 1:
+        dataset = dataset.rechunk({1: -1})
+    dataset = client.persist(dataset)
+    wait(dataset)
+
+    offsets = np.cumsum((0,) + dataset.chunks[0])
+    keys = [key for (key,) in dataset.__dask_keys__()]
+    futures = {f.key: f for f in futures_of(dataset)}
+    who_has = client.who_has(list(futures.values()))
+
+    parts = OrderedDict()
+    for i, key in enumerate(keys):
+        holders = who_has[key] if key in who_has else who_has[str(key)]
+        parts.setdefault(holders[0], []).append(
+            (int(offsets[i]), futures[key])
+        )
+
+    index_id = uuid.uuid4().hex
+    builds = [
+        client.submit(
+            _func_build,
+            index_id,
+            algo,
+            index_params,
+            [offset for offset, _ in worker_parts],
+            *[part for _, part in worker_parts],
+            workers=[w],
+            pure=False,
+        )
+        for w, worker_parts in parts.items()
+    ]
+    wait(builds)
+    # Raise the errors of the workers, if any.
+    client.gather(builds)
+
+    return DistributedIndex(
+        client,
+        index_id,
+        algo,
+        metric,
+        list(parts.keys()),
+        int(offsets[-1]),
+        dataset.shape[1],
+    )
+
+
+def search(index, queries, k, search_params=None):
+    """
+    Finds the k nearest neighbors of the queries in a distributed index.
+
+    The queries are broadcast to all the workers of the index, every worker
+    searches its local index and the top-k candidates of the shards are
+    merged into the global top-k.
+
+    Parameters
+    ----------
+    index : DistributedIndex
+    queries : CUDA array interface or array interface compliant matrix shape
+        (n_queries, dim). Same dtype as the dataset.
+    k : int
+        The number of neighbors.
+    search_params : dict
+        Keyword arguments of the `SearchParams` of the pylibraft algorithm,
+        e.g. `{"n_probes": 20}`.
+
+    Returns
+    -------
+    distances : numpy.ndarray shape (n_queries, k), dtype float
+    neighbors : numpy.ndarray shape (n_queries, k), dtype int64
+        The global ids (row numbers in the dataset) of the neighbors.
+    """
+    if not index.workers:
+        raise ValueError("The index has been destroyed")
+    if queries.shape[1] != index.dim:
+        raise ValueError(
+            f"Queries have dim {queries.shape[1]}, the index has dim "
+            f"{index.dim}"
+        )
+    if k > index.size:
+        raise ValueError(f"k ({k}) is larger than the index ({index.size})")
+    client = index.client
+    search_params = {} if search_params is None else dict(search_params)
+
+    queries = client.scatter(queries, broadcast=True, workers=index.workers)
+    results = [
+        client.submit(
+            _func_search,
+            index.index_id,
+            queries,
+            k,
+            search_params,
+            workers=[w],
+            pure=False,
+        )
+        for w in index.workers
+    ]
+    merged = client.submit(
+        _merge_topk,
+        k,
+        index.metric != "inner_product",
+        *results,
+        pure=False,
+    )
+    return merged.result()
+
+
+def _get_ann_state(index_id, dask_worker):
+    if not hasattr(dask_worker, "_raft_ann_state"):
+        dask_worker._raft_ann_state = {}
+    return dask_worker._raft_ann_state.setdefault(index_id, {})
+
+
+def _to_device(part):
+    if hasattr(part, "__cuda_array_interface__"):
+        return part
+    return device_ndarray(np.ascontiguousarray(part))
+
+
+def _func_build(index_id, algo, index_params, offsets, *parts):
+    """
+    Builds the local index over the partitions stored on this worker
+    """
+    if len(parts) == 1:
+        data = parts[0]
+    elif all(hasattr(p, "__cuda_array_interface__") for p in parts):
+        import cupy as cp
+
+        data = cp.concatenate(parts)
+    else:
+        data = np.concatenate([np.asarray(p) for p in parts])
+
+    ids = np.concatenate(
+        [
+            np.arange(offset, offset + p.shape[0], dtype=np.int64)
+            for offset, p in zip(offsets, parts)
+        ]
+    )
+
+    module = _algos[algo]
+    local_index = module.build(
+        module.IndexParams(**index_params), _to_device(data)
+    )
+
+    state = _get_ann_state(index_id, get_worker())
+    state["algo"] = algo
+    state["index"] = local_index
+    state["ids"] = ids
+    return data.shape[0]
+
+
+def _func_search(index_id, queries, k, search_params):
+    """
+    Searches the local index and returns the candidates with global ids
+    """
+    state = _get_ann_state(index_id, get_worker())
+    module = _algos[state["algo"]]
+    ids = state["ids"]
+    n_queries = queries.shape[0]
+    k_local = min(k, ids.shape[0])
+
+    # The outputs are copied into host arrays by the search.
+    distances = np.empty((n_queries, k_local), dtype=np.float32)
+    neighbors = np.empty((n_queries, k_local), dtype=np.int64)
+    module.search(
+        module.SearchParams(**search_params),
+        state["index"],
+        _to_device(queries),
+        k_local,
+        neighbors=neighbors,
+        distances=distances,
+    )
+
+    valid = (neighbors >= 0) & (neighbors < ids.shape[0])
+    neighbors = np.where(valid, ids[np.where(valid, neighbors, 0)], -1)
+    return distances, neighbors
+
+
+def _merge_topk(k, select_min, *results):
+    """
+    Merges the top-k candidates of the shards
+    """
+    distances = np.concatenate([d for d, _ in results], axis=1)
+    neighbors = np.concatenate([n for _, n in results], axis=1)
+    keys = distances if select_min else -distances
+    # The invalid candidates (padding of the shards) come last.
+    keys = np.where(neighbors < 0, np.inf, keys)
+    order = np.argsort(keys, axis=1, kind="stable")[:, :k]
+    return (
+        np.take_along_axis(distances, order, axis=1),
+        np.take_along_axis(neighbors, order, axis=1),
+    )
+
+
+def _func_shard_size(index_id, dask_worker=None):
+    state = _get_ann_state(index_id, dask_worker)
+    return int(state["ids"].shape[0]) if "ids" in state else 0
+
+
+def _func_destroy(index_id, dask_worker=None):
+    if hasattr(dask_worker, "_raft_ann_state"):
+        dask_worker._raft_ann_state.pop(index_id, None)
@@ -35,6 +35,9 @@ try:
         perform_test_comms_reduce,
         perform_test_comms_reducescatter,
         perform_test_comms_send_recv,
+        perform_test_comms_stream_send_recv,
+        perform_test_hierarchical_comms,
+        perform_test_topk_allreduce,
     )
 
     pytestmark = pytest.mark.mg
@@ -69,6 +72,11 @@ def func_test_send_recv(sessionId, n_trials):
     return perform_test_comms_send_recv(handle, n_trials)
 
 
+def func_test_stream_send_recv(sessionId, n_trials):
+    handle = local_handle(sessionId, dask_worker=get_worker())
+    return perform_test_comms_stream_send_recv(handle, n_trials)
+
+
 def func_test_device_send_or_recv(sessionId, n_trials):
     handle = local_handle(sessionId, dask_worker=get_worker())
     return perform_test_comms_device_send_or_recv(handle, n_trials)
@@ -89,6 +97,16 @@ def func_test_comm_split(sessionId, n_trials):
     return perform_test_comm_split(handle, n_trials)
 
 
+def func_test_hierarchical_comms(sessionId, ranks_per_node):
+    handle = local_handle(sessionId, dask_worker=get_worker())
+    return perform_test_hierarchical_comms(handle, ranks_per_node)
+
+
+def func_test_topk_allreduce(sessionId, n_ranks, ties):
+    handle = local_handle(sessionId, dask_worker=get_worker())
+    return perform_test_topk_allreduce(handle, n_ranks, ties)
+
+
 def func_check_uid(sessionId, uniqueId, state_object):
     if not hasattr(state_object, "_raft_comm_state"):
         return 1
@@ -243,8 +261,71 @@ def test_comm_split(client):
     assert all([x.result() for x in dfs])
 
 
+# 3 ranks exercise the fold-in and fold-back of the ranks beyond the largest
+# power of two; 0 runs over all the workers
+@pytest.mark.nccl
+@pytest.mark.parametrize("n_ranks", [0, 3])
+@pytest.mark.parametrize("ties", [False, True])
+def test_topk_allreduce(n_ranks, ties, client):
+
+    cb = Comms(comms_p2p=True, verbose=True)
+    cb.init()
+
+    try:
+        if len(cb.worker_addresses) < n_ranks:
+            pytest.skip("Not enough workers")
+
+        dfs = [
+            client.submit(
+                func_test_topk_allreduce,
+                cb.sessionId,
+                n_ranks,
+                ties,
+                pure=False,
+                workers=[w],
+            )
+            for w in cb.worker_addresses
+        ]
+
+        wait(dfs, timeout=60)
+
+        assert all([x.result() for x in dfs])
+    finally:
+        cb.destroy()
+
+
+# 0 groups the workers by their host name (a single node, so the collectives
+# fall back to the flat communicator), 1 makes every worker a node of its own,
+# 2 splits the workers in nodes of two (which is not uniform for an odd number
+# of workers)
+@pytest.mark.nccl
+@pytest.mark.parametrize("ranks_per_node", [0, 1, 2])
+def test_hierarchical_comms(ranks_per_node, client):
+
+    cb = Comms(comms_p2p=True, verbose=True)
+    cb.init()
+
+    try:
+        dfs = [
+            client.submit(
+                func_test_hierarchical_comms,
+                cb.sessionId,
+                ranks_per_node,
+                pure=False,
+                workers=[w],
+            )
+            for w in cb.worker_addresses
+        ]
+
+        wait(dfs, timeout=60)
+
+        assert all([x.result() for x in dfs])
+    finally:
+        cb.destroy()
+
+
 @pytest.mark.ucx
-@pytest.mark.parametrize("n_trials", [1, 5])
+@pytest.mark.parametrize("n_trials", [1, 5, 100])
 def test_send_recv(n_trials, client):
 
     cb = Comms(comms_p2p=True, verbose=True)
@@ -261,9 +342,35 @@ def test_send_recv(n_trials, client):
         for w in cb.worker_addresses
     ]
 
-    wait(dfs, timeout=5)
+    wait(dfs, timeout=60)
 
-    assert list(map(lambda x: x.result(), dfs))
+    assert all([x.result() for x in dfs])
+
+
+@pytest.mark.ucx
+@pytest.mark.parametrize("n_trials", [1, 5])
+def test_stream_send_recv(n_trials, client):
+
+    cb = Comms(comms_p2p=True, verbose=True)
+    cb.init()
+
+    try:
+        dfs = [
+            client.submit(
+                func_test_stream_send_recv,
+                cb.sessionId,
+                n_trials,
+                pure=False,
+                workers=[w],
+            )
+            for w in cb.worker_addresses
+        ]
+
+        wait(dfs, timeout=5)
+
+        assert all([x.result() for x in dfs])
+    finally:
+        cb.destroy()
 
 
 @pytest.mark.nccl
@@ -333,3 +440,53 @@ def test_device_multicast_sendrecv(n_trials, client):
     wait(dfs, timeout=5)
 
     assert list(map(lambda x: x.result(), dfs))
+
+
+@pytest.mark.ucx
+@pytest.mark.parametrize("n_trials", [1, 5])
+def test_send_recv_lazy_endpoints(n_trials, client):
+
+    cb = Comms(comms_p2p=True, lazy_endpoints=True, verbose=True)
+    cb.init()
+
+    try:
+        # No endpoints and no handles before the first local_handle()
+        assert not any(
+            client.run(
+                lambda dask_worker: "handle"
+                in dask_worker._raft_comm_state[cb.sessionId]
+            ).values()
+        )
+
+        dfs = [
+            client.submit(
+                func_test_send_recv,
+                cb.sessionId,
+                n_trials,
+                pure=False,
+                workers=[w],
+            )
+            for w in cb.worker_addresses
+        ]
+
+        wait(dfs, timeout=5)
+
+        assert list(map(lambda x: x.result(), dfs))
+    finally:
+        cb.destroy()
+
+
+def test_shared_session(client):
+
+    cb = Comms.get(client=client)
+    try:
+        assert cb.nccl_initialized is True
+        assert Comms.get(client=client) is cb
+        assert Comms.get(client=client, streams_per_handle=2) is not cb
+    finally:
+        for comms in list(Comms._shared_sessions.values()):
+            comms.destroy()
+
+    assert Comms.get(client=client) is not cb
+    for comms in list(Comms._shared_sessions.values()):
+        comms.destroy()
@@ -0,0 +1,107 @@
+# Copyright (c) 2023, NVIDIA CORPORATION.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+import numpy as np
+import pytest
+
+from dask.distributed import Client
+
+try:
+    import dask.array as da
+
+    from pylibraft.neighbors.brute_force import knn
+
+    from raft_dask.neighbors import ivf
+
+    pytestmark = pytest.mark.mg
+except ImportError:
+    pytestmark = pytest.mark.skip
+
+
+def _recall(found, expected):
+    hits = sum(
+        len(np.intersect1d(f, e, assume_unique=True))
+        for f, e in zip(found, expected)
+    )
+    return hits / expected.size
+
+
+@pytest.mark.parametrize(
+    "algo,index_params,search_params,min_recall",
+    [
+        ("ivf_flat", {"n_lists": 16}, {"n_probes": 16}, 0.99),
+        ("ivf_pq", {"n_lists": 16, "pq_dim": 16}, {"n_probes": 16}, 0.7),
+    ],
+)
+@pytest.mark.parametrize("metric", ["sqeuclidean", "inner_product"])
+def test_ivf_sharded(
+    cluster, algo, index_params, search_params, min_recall, metric
+):
+    cp = pytest.importorskip("cupy")
+    client = Client(cluster)
+
+    n_rows, dim, n_queries, k = 20000, 32, 100, 10
+    rng = np.random.default_rng(42)
+    dataset = rng.random((n_rows, dim), dtype=np.float32)
+    queries = rng.random((n_queries, dim), dtype=np.float32)
+
+    _, expected = knn(
+        cp.asarray(dataset), cp.asarray(queries), k, metric=metric
+    )
+    expected = cp.asarray(expected).get()
+
+    index = None
+    try:
+        chunks = da.from_array(dataset, chunks=(2500, dim))
+        index = ivf.build(
+            chunks.map_blocks(cp.asarray),
+            algo,
+            dict(index_params, metric=metric),
+        )
+        assert index.size == n_rows
+        assert sum(index.shard_sizes().values()) == n_rows
+
+        distances, neighbors = ivf.search(
+            index, queries, k, search_params=search_params
+        )
+        assert distances.shape == (n_queries, k)
+        assert neighbors.shape == (n_queries, k)
+        assert _recall(neighbors, expected) >= min_recall
+
+        # The merged candidates are ordered, and the ids are global
+        order = np.diff(distances, axis=1)
+        if metric == "inner_product":
+            assert np.all(order <= 0)
+        else:
+            assert np.all(order >= 0)
+        assert neighbors.min() >= 0 and neighbors.max() < n_rows
+
+    finally:
+        if index is not None:
+            index.destroy()
+        client.close()
+
+
+def test_ivf_invalid(cluster):
+    client = Client(cluster)
+
+    try:
+        dataset = da.zeros((100, 8), chunks=(50, 8), dtype=np.float32)
+        with pytest.raises(ValueError):
+            ivf.build(dataset, "cagra", client=client)
+        with pytest.raises(TypeError):
+            ivf.build(np.zeros((100, 8), np.float32), client=client)
+    finally:
+        client.close()